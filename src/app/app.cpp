@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -41,6 +41,7 @@
 #include "app/resource_finder.h"
 #include "app/send_crash.h"
 #include "app/site.h"
+#include "app/task_scheduler.h"
 #include "app/tools/active_tool.h"
 #include "app/tools/tool_box.h"
 #include "app/ui/backup_indicator.h"
@@ -49,6 +50,7 @@
 #include "app/ui/editor/editor.h"
 #include "app/ui/editor/editor_view.h"
 #include "app/ui/input_chain.h"
+#include "app/ui/input_recorder.h"
 #include "app/ui/keyboard_shortcuts.h"
 #include "app/ui/main_window.h"
 #include "app/ui/status_bar.h"
@@ -56,6 +58,8 @@
 #include "app/ui/workspace.h"
 #include "app/ui_context.h"
 #include "app/util/clipboard.h"
+#include "app/util/memory_usage.h"
+#include "base/chrono.h"
 #include "base/exception.h"
 #include "base/fs.h"
 #include "base/platform.h"
@@ -68,6 +72,8 @@
 #include "os/system.h"
 #include "os/window.h"
 #include "render/render.h"
+#include "tracing/metrics.h"
+#include "tracing/tracing.h"
 #include "ui/intern.h"
 #include "ui/ui.h"
 #include "updater/user_agent.h"
@@ -98,6 +104,8 @@
 
 #include <memory>
 #include <optional>
+#include <utility>
+#include <vector>
 
 namespace app {
 
@@ -121,6 +129,45 @@ private:
 
 #endif // ENABLER_SCRIPTING
 
+namespace {
+
+// Time spent in each step of App::initialize() (--startup-profile).
+class StartupProfile {
+public:
+  StartupProfile(const bool enabled) : m_enabled(enabled) {}
+
+  void step(const char* name)
+  {
+    if (!m_enabled)
+      return;
+
+    const double t = m_chrono.elapsed();
+    m_steps.emplace_back(name, t - m_last);
+    m_last = t;
+  }
+
+  // Printed in stderr so it doesn't mix with the output of CLI
+  // options like --list-tags or --data.
+  void print() const
+  {
+    if (!m_enabled)
+      return;
+
+    std::fprintf(stderr, "Startup profile:\n");
+    for (const auto& step : m_steps)
+      std::fprintf(stderr, "  %-20s %8.2f ms\n", step.first, step.second * 1000.0);
+    std::fprintf(stderr, "  %-20s %8.2f ms\n", "total", m_last * 1000.0);
+  }
+
+private:
+  bool m_enabled;
+  base::Chrono m_chrono;
+  double m_last = 0.0;
+  std::vector<std::pair<const char*, double>> m_steps;
+};
+
+} // anonymous namespace
+
 class App::CoreModules {
 public:
   ConfigModule m_configModule;
@@ -249,6 +296,7 @@ App::App(AppMod* mod)
 
 int App::initialize(const AppOptions& options)
 {
+  StartupProfile profile(options.programOptions().enabled(options.startupProfile()));
   const os::SystemRef system = os::System::instance();
 
   // Without Skia backend we don't have GUI.
@@ -273,9 +321,16 @@ int App::initialize(const AppOptions& options)
 #endif
 
   m_isShell = options.startShell();
+
+  // Start the threads of the task scheduler (doc/render libraries
+  // split their work in its workers from now on)
+  TaskScheduler::instance();
+
   m_coreModules = std::make_unique<CoreModules>();
+  profile.step("config");
 
   auto& pref = preferences();
+  apply_image_buffers_cache_limit();
 
   os::TabletOptions tabletOptions;
 
@@ -321,7 +376,22 @@ int App::initialize(const AppOptions& options)
       break;
   }
 
+  // Record the timing of UI/rendering events (--trace-events)
+  if (options.programOptions().enabled(options.traceEvents())) {
+    tracing::start(options.programOptions().value_of(options.traceEvents()));
+    tracing::set_thread_name("UI");
+  }
+
+  // Save the performance counters on exit (--perf-counters)
+  if (options.programOptions().enabled(options.perfCounters()))
+    m_perfCountersFilename = options.programOptions().value_of(options.perfCounters());
+
+  // Record the user input when the GUI starts (--record-input)
+  if (options.programOptions().enabled(options.recordInput()))
+    m_recordInputFilename = options.programOptions().value_of(options.recordInput());
+
   initialize_color_spaces(pref);
+  profile.step("system");
 
 #ifdef ENABLE_DRM
   LOG("APP: Initializing DRM...\n");
@@ -336,8 +406,14 @@ int App::initialize(const AppOptions& options)
 
   // Load modules
   m_modules = std::make_unique<Modules>(createLogInDesktop, pref);
+  profile.step("modules");
   m_legacy = std::make_unique<LegacyModules>(isGui() ? REQUIRE_INTERFACE : 0);
-  m_appMenus = std::make_unique<AppMenus>(recentFiles());
+  profile.step("legacy modules");
+
+  // Menus (and the keyboard shortcuts loaded with them) are only
+  // needed in GUI mode.
+  if (isGui())
+    m_appMenus = std::make_unique<AppMenus>(recentFiles());
   m_brushes = std::make_unique<AppBrushes>();
 
   // Data recovery is enabled only in GUI mode
@@ -350,6 +426,7 @@ int App::initialize(const AppOptions& options)
   // Load or create the default palette, or migrate the default
   // palette from an old format palette to the new one, etc.
   load_default_palette();
+  profile.step("default palette");
 
   // Initialize GUI interface
   if (isGui()) {
@@ -400,14 +477,18 @@ int App::initialize(const AppOptions& options)
     const bool gpu = Preferences::instance().general.gpuAcceleration();
     manager->updateAllDisplays(scale, gpu);
 #endif
+    profile.step("main window");
   }
 
 #ifdef ENABLE_SCRIPTING
   // Call the init() function from all plugins
   LOG("APP: Initializing scripts...\n");
   extensions().executeInitActions();
+  profile.step("plugins");
 #endif
 
+  profile.print();
+
   // Process options
   LOG("APP: Processing options...\n");
   int code;
@@ -562,6 +643,10 @@ void App::run(const bool runGuiManager)
 
     // Run the GUI main message loop
     if (runGuiManager) {
+      std::unique_ptr<InputRecorder> inputRecorder;
+      if (!m_recordInputFilename.empty())
+        inputRecorder = std::make_unique<InputRecorder>(context(), m_recordInputFilename);
+
       try {
         manager->run();
         set_app_state(AppState::kClosing);
@@ -659,6 +744,12 @@ App::~App()
     // Destroy the loaded gui.xml data.
     KeyboardShortcuts::destroyInstance();
     GuiXml::destroyInstance();
+
+    if (tracing::is_enabled() && !tracing::stop())
+      LOG(ERROR, "APP: Error saving trace events file\n");
+
+    if (!m_perfCountersFilename.empty() && !tracing::save_metrics(m_perfCountersFilename))
+      LOG(ERROR, "APP: Error saving performance counters file\n");
   }
   catch (const std::exception& e) {
     LOG(ERROR, "APP: Error: %s\n", e.what());
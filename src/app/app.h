@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2024  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -149,6 +149,8 @@ private:
   base::paths m_files;
   std::unique_ptr<AppBrushes> m_brushes;
   std::unique_ptr<BackupIndicator> m_backupIndicator;
+  std::string m_recordInputFilename;
+  std::string m_perfCountersFilename;
 #ifdef ENABLE_SCRIPTING
   std::unique_ptr<script::Engine> m_engine;
 #endif
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -439,6 +439,7 @@ void AppMenus::reload()
   XMLElement* xmlKey = handle.FirstChildElement("gui").FirstChildElement("keyboard").ToElement();
 
   // From a fresh start, load the default keys
+  m_loadingKeys = true;
   KeyboardShortcuts::instance()->clear();
   KeyboardShortcuts::instance()->importFile(xmlKey, KeySource::Original);
 
@@ -459,6 +460,11 @@ void AppMenus::reload()
     if (base::is_file(fn))
       KeyboardShortcuts::instance()->importFile(fn, KeySource::UserDefined);
   }
+  m_loadingKeys = false;
+
+  // Show the shortcuts in the menu items iterating the menus just
+  // one time (instead of one time for each imported key)
+  applyShortcutsToMenuitems();
 
   // Create native menus after the default + user defined keyboard
   // shortcuts are loaded correctly.
@@ -810,6 +816,9 @@ void AppMenus::applyShortcutToMenuitemsWithCommand(Command* command,
                                                    const Params& params,
                                                    const KeyPtr& key)
 {
+  if (m_loadingKeys)
+    return;
+
   updateMenusList();
   for (Menu* menu : m_menus)
     if (menu)
@@ -841,6 +850,46 @@ void AppMenus::applyShortcutToMenuitemsWithCommand(Menu* menu,
   }
 }
 
+void AppMenus::applyShortcutsToMenuitems()
+{
+  KeysByCommand keys;
+  for (const KeyPtr& key : *KeyboardShortcuts::instance()) {
+    if (key->type() == KeyType::Command && key->command() && !key->shortcuts().empty())
+      keys[base::string_to_lower(key->command()->id())].push_back(key);
+  }
+
+  updateMenusList();
+  for (Menu* menu : m_menus)
+    if (menu)
+      applyShortcutsToMenuitems(menu, keys);
+}
+
+void AppMenus::applyShortcutsToMenuitems(Menu* menu, const KeysByCommand& keys)
+{
+  for (auto child : menu->children()) {
+    if (child->type() == kMenuItemWidget) {
+      AppMenuItem* menuitem = dynamic_cast<AppMenuItem*>(child);
+      if (!menuitem)
+        continue;
+
+      if (!menuitem->getCommandId().empty()) {
+        auto it = keys.find(base::string_to_lower(menuitem->getCommandId()));
+        if (it != keys.end()) {
+          for (const KeyPtr& key : it->second) {
+            if (key->params() == menuitem->getParams()) {
+              menuitem->setKey(key);
+              break;
+            }
+          }
+        }
+      }
+
+      if (Menu* submenu = menuitem->getSubmenu())
+        applyShortcutsToMenuitems(submenu, keys);
+    }
+  }
+}
+
 void AppMenus::syncNativeMenuItemKeyShortcuts()
 {
   syncNativeMenuItemKeyShortcuts(m_rootMenu.get());
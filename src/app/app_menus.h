@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -19,6 +19,9 @@
 #include "ui/menu.h"
 
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace tinyxml2 {
 class XMLElement;
@@ -88,6 +91,12 @@ private:
                                            const Params& params,
                                            const KeyPtr& key);
   void syncNativeMenuItemKeyShortcuts(Menu* menu);
+
+  // Keys with shortcuts for each command ID (in lower case).
+  using KeysByCommand = std::unordered_map<std::string, std::vector<KeyPtr>>;
+  void applyShortcutsToMenuitems();
+  void applyShortcutsToMenuitems(Menu* menu, const KeysByCommand& keys);
+
   void updateMenusList();
   void createNativeMenus();
   void createNativeSubmenus(os::Menu* osMenu, const ui::Menu* uiMenu);
@@ -127,6 +136,9 @@ private:
   // support native menus)
   os::MenuRef m_osMenu;
   XmlTranslator m_xmlTranslator;
+  // True while reload() imports the keyboard shortcuts (the menu
+  // items are updated once at the end).
+  bool m_loadingKeys = false;
 
   static AppMenus* s_instance;
 };
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2024  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2017  David Capello
 //
 // This program is distributed under the terms of
@@ -13,7 +13,10 @@
 
 #include "base/fs.h"
 
+#include <algorithm>
+#include <cstdlib>
 #include <iostream>
+#include <thread>
 
 namespace app {
 
@@ -25,15 +28,32 @@ AppOptions::AppOptions(int argc, const char* argv[])
   , m_showHelp(false)
   , m_showVersion(false)
   , m_verboseLevel(kNoVerbose)
+  , m_numJobs(1)
 #ifdef ENABLE_SCRIPTING
   , m_shell(m_po.add("shell").description("Start an interactive console to execute scripts"))
 #endif
   , m_batch(m_po.add("batch").mnemonic('b').description("Do not start the UI"))
   , m_preview(m_po.add("preview").mnemonic('p').description(
       "Do not execute actions, just print what will be\ndone"))
+  , m_jobs(m_po.add("jobs")
+             .requiresValue("<n>")
+             .description("Load up to n files in parallel in batch mode\n(0 = number of CPU cores)"))
+  , m_cacheDir(m_po.add("cache-dir")
+                 .requiresValue("<dir>")
+                 .description(
+                   "Reuse the files generated by a previous call\nwith the same arguments and input files"))
+  , m_watch(m_po.add("watch").description("Keep running in batch mode and process the\n"
+                                           "files again each time they are modified\n"
+                                           "(until it is interrupted with Ctrl+C)"))
   , m_saveAs(m_po.add("save-as")
                .requiresValue("<filename>")
-               .description("Save the last given sprite with other format"))
+               .description(
+                 "Save the last given sprite with other format\n(- or -.<ext> to write it in stdout)"))
+  , m_compression(
+      m_po.add("compression")
+        .requiresValue("<profile>")
+        .description(
+          "Compression used in the next saved\n.aseprite files:\n  fastest\n  default\n  smallest"))
   , m_palette(m_po.add("palette")
                 .requiresValue("<filename>")
                 .description("Change the palette of the last given sprite"))
@@ -50,6 +70,12 @@ AppOptions::AppOptions(int argc, const char* argv[])
         .requiresValue("<id>")
         .description(
           "Matrix used in ordered dithering algorithm\n  bayer2x2\n  bayer4x4\n  bayer8x8\n  filename.png"))
+  , m_ditheringRows(
+      m_po.add("dithering-rows")
+        .requiresValue("<order>")
+        .description("Order of rows in error-diffusion dithering\n"
+                     "  serpentine (default)\n"
+                     "  left-to-right (faster for big images)"))
   , m_colorMode(
       m_po.add("color-mode")
         .requiresValue("<mode>")
@@ -73,6 +99,11 @@ AppOptions::AppOptions(int argc, const char* argv[])
         .description(
           "Algorithm to create the sprite sheet:\n  horizontal\n  vertical\n  rows\n  columns\n  packed"))
   , m_sheetPack(m_po.add("sheet-pack").description("Same as -sheet-type packed"))
+  , m_sheetPackAlgorithm(
+      m_po.add("sheet-pack-algorithm")
+        .requiresValue("<algorithm>")
+        .description("Algorithm to pack sprites in -sheet-type packed:\n  best-fit (default)\n  "
+                     "max-rects (faster for big sheets)"))
   , m_sheetWidth(
       m_po.add("sheet-width").requiresValue("<pixels>").description("Sprite sheet width"))
   , m_sheetHeight(
@@ -109,6 +140,9 @@ AppOptions::AppOptions(int argc, const char* argv[])
                    .requiresValue("from,to")
                    .description("Only export frames in the [from,to] range"))
   , m_ignoreEmpty(m_po.add("ignore-empty").description("Do not export empty frames/cels"))
+  , m_incremental(m_po.add("incremental")
+                    .description("Save only the frames of a --save-as sequence\n"
+                                 "that changed since the last export"))
   , m_mergeDuplicates(m_po.add("merge-duplicates")
                         .description("Merge all duplicate frames into one in the sprite sheet"))
   , m_borderPadding(m_po.add("border-padding")
@@ -163,8 +197,25 @@ AppOptions::AppOptions(int argc, const char* argv[])
   , m_oneFrame(m_po.add("oneframe").description("Load just the first frame"))
   , m_exportTileset(
       m_po.add("export-tileset").description("Export only tilesets from visible tilemap layers"))
+  , m_diff(m_po.add("diff")
+             .requiresValue("<filename>")
+             .description("Print the frames, layers, and cels of the last\n"
+                          "given sprite that are different in <filename>"))
   , m_verbose(m_po.add("verbose").mnemonic('v').description("Explain what is being done"))
   , m_debug(m_po.add("debug").description("Extreme verbose mode and\ncopy log to desktop"))
+  , m_traceEvents(m_po.add("trace-events")
+                    .requiresValue("<filename.json>")
+                    .description("Save the timing of UI/rendering events\nin Chrome trace format"))
+  , m_perfCounters(m_po.add("perf-counters")
+                     .requiresValue("<filename.json>")
+                     .description("Save the performance counters (cache\n"
+                                  "hits, render times, etc.) on exit"))
+  , m_startupProfile(
+      m_po.add("startup-profile").description("Print the time spent initializing\neach module"))
+  , m_recordInput(m_po.add("record-input")
+                    .requiresValue("<filename>")
+                    .description("Save the mouse/keyboard input and the\n"
+                                 "active sprite to replay them later"))
 #ifdef ENABLE_STEAM
   , m_noInApp(m_po.add("noinapp").description(
       "Disable \"in game\" visibility on Steam\nDoesn't count playtime"))
@@ -187,10 +238,17 @@ AppOptions::AppOptions(int argc, const char* argv[])
     m_startShell = m_po.enabled(m_shell);
 #endif
     m_previewCLI = m_po.enabled(m_preview);
+
+    if (m_po.enabled(m_jobs)) {
+      m_numJobs = std::strtol(m_po.value_of(m_jobs).c_str(), nullptr, 10);
+      if (m_numJobs <= 0)
+        m_numJobs = int(std::max(1u, std::thread::hardware_concurrency()));
+    }
     m_showHelp = m_po.enabled(m_help);
     m_showVersion = m_po.enabled(m_version);
 
-    if (m_startShell || m_showHelp || m_showVersion || m_po.enabled(m_batch)) {
+    if (m_startShell || m_showHelp || m_showVersion || m_po.enabled(m_batch) ||
+        m_po.enabled(m_watch)) {
       m_startUI = false;
     }
   }
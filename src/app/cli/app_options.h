@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2024  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2017  David Capello
 //
 // This program is distributed under the terms of
@@ -40,15 +40,21 @@ public:
   bool showHelp() const { return m_showHelp; }
   bool showVersion() const { return m_showVersion; }
   VerboseLevel verboseLevel() const { return m_verboseLevel; }
+  int jobs() const { return m_numJobs; }
+  bool hasJobs() const { return m_po.enabled(m_jobs); }
 
   const ValueList& values() const { return m_po.values(); }
+  const Option& cacheDir() const { return m_cacheDir; }
+  bool watch() const { return m_po.enabled(m_watch); }
 
   // Export options
   const Option& saveAs() const { return m_saveAs; }
+  const Option& compression() const { return m_compression; }
   const Option& palette() const { return m_palette; }
   const Option& scale() const { return m_scale; }
   const Option& ditheringAlgorithm() const { return m_ditheringAlgorithm; }
   const Option& ditheringMatrix() const { return m_ditheringMatrix; }
+  const Option& ditheringRows() const { return m_ditheringRows; }
   const Option& colorMode() const { return m_colorMode; }
   const Option& shrinkTo() const { return m_shrinkTo; }
   const Option& data() const { return m_data; }
@@ -56,6 +62,7 @@ public:
   const Option& sheet() const { return m_sheet; }
   const Option& sheetType() const { return m_sheetType; }
   const Option& sheetPack() const { return m_sheetPack; }
+  const Option& sheetPackAlgorithm() const { return m_sheetPackAlgorithm; }
   const Option& sheetWidth() const { return m_sheetWidth; }
   const Option& sheetHeight() const { return m_sheetHeight; }
   const Option& sheetColumns() const { return m_sheetColumns; }
@@ -71,6 +78,7 @@ public:
   const Option& playSubtags() const { return m_playSubtags; }
   const Option& frameRange() const { return m_frameRange; }
   const Option& ignoreEmpty() const { return m_ignoreEmpty; }
+  const Option& incremental() const { return m_incremental; }
   const Option& mergeDuplicates() const { return m_mergeDuplicates; }
   const Option& borderPadding() const { return m_borderPadding; }
   const Option& shapePadding() const { return m_shapePadding; }
@@ -93,6 +101,11 @@ public:
   const Option& listSlices() const { return m_listSlices; }
   const Option& oneFrame() const { return m_oneFrame; }
   const Option& exportTileset() const { return m_exportTileset; }
+  const Option& diff() const { return m_diff; }
+  const Option& traceEvents() const { return m_traceEvents; }
+  const Option& perfCounters() const { return m_perfCounters; }
+  const Option& startupProfile() const { return m_startupProfile; }
+  const Option& recordInput() const { return m_recordInput; }
 
   bool hasExporterParams() const;
 #ifdef ENABLE_STEAM
@@ -113,17 +126,23 @@ private:
   bool m_showHelp;
   bool m_showVersion;
   VerboseLevel m_verboseLevel;
+  int m_numJobs;
 
 #ifdef ENABLE_SCRIPTING
   Option& m_shell;
 #endif
   Option& m_batch;
   Option& m_preview;
+  Option& m_jobs;
+  Option& m_cacheDir;
+  Option& m_watch;
   Option& m_saveAs;
+  Option& m_compression;
   Option& m_palette;
   Option& m_scale;
   Option& m_ditheringAlgorithm;
   Option& m_ditheringMatrix;
+  Option& m_ditheringRows;
   Option& m_colorMode;
   Option& m_shrinkTo;
   Option& m_data;
@@ -131,6 +150,7 @@ private:
   Option& m_sheet;
   Option& m_sheetType;
   Option& m_sheetPack;
+  Option& m_sheetPackAlgorithm;
   Option& m_sheetWidth;
   Option& m_sheetHeight;
   Option& m_sheetColumns;
@@ -146,6 +166,7 @@ private:
   Option& m_playSubtags;
   Option& m_frameRange;
   Option& m_ignoreEmpty;
+  Option& m_incremental;
   Option& m_mergeDuplicates;
   Option& m_borderPadding;
   Option& m_shapePadding;
@@ -168,9 +189,14 @@ private:
   Option& m_listSlices;
   Option& m_oneFrame;
   Option& m_exportTileset;
+  Option& m_diff;
 
   Option& m_verbose;
   Option& m_debug;
+  Option& m_traceEvents;
+  Option& m_perfCounters;
+  Option& m_startupProfile;
+  Option& m_recordInput;
 #ifdef ENABLE_STEAM
   Option& m_noInApp;
 #endif
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2022  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2016-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -9,15 +9,18 @@
 #define APP_CLI_CLI_DELEGATE_H_INCLUDED
 #pragma once
 
+#include "app/cli/cli_open_file.h"
+
 #include <string>
+#include <vector>
 
 namespace app {
 
 class AppOptions;
 class Context;
+class Doc;
 class DocExporter;
 class Params;
-struct CliOpenFile;
 
 class CliDelegate {
 public:
@@ -30,7 +33,17 @@ public:
   virtual void beforeOpenFile(const CliOpenFile& cof) {}
   virtual void afterOpenFile(const CliOpenFile& cof) {}
   virtual void saveFile(Context* ctx, const CliOpenFile& cof) {}
+  // Saves several files of the same document (e.g. --split-tags or
+  // --split-slices), the document is not modified between them so
+  // they can be saved at the same time.
+  virtual void saveFiles(Context* ctx, const std::vector<CliOpenFile>& cofs)
+  {
+    for (const auto& cof : cofs)
+      saveFile(ctx, cof);
+  }
   virtual void loadPalette(Context* ctx, const std::string& filename) {}
+  // Returns true if the given file is different from the doc.
+  virtual bool diffFile(Context* ctx, Doc* doc, const std::string& filename) { return false; }
   virtual void exportFiles(Context* ctx, DocExporter& exporter) {}
 #ifdef ENABLE_SCRIPTING
   virtual int execScript(const std::string& filename, const Params& params) { return 0; }
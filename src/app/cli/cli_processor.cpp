@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2024  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -13,31 +13,40 @@
 
 #include "app/cli/app_options.h"
 #include "app/cli/cli_delegate.h"
+#include "app/cli/export_cache.h"
+#include "app/cli/file_preloader.h"
+#include "app/cli/file_watcher.h"
 #include "app/commands/commands.h"
 #include "app/commands/params.h"
 #include "app/console.h"
 #include "app/doc.h"
+#include "app/doc_diff.h"
 #include "app/doc_exporter.h"
 #include "app/doc_undo.h"
 #include "app/file/file.h"
 #include "app/filename_formatter.h"
+#include "app/pref/preferences.h"
 #include "app/restore_visible_layers.h"
 #include "app/ui_context.h"
 #include "app/util/layer_utils.h"
 #include "base/convert_to.h"
 #include "base/fs.h"
 #include "base/split_string.h"
+#include "base/string.h"
+#include "base/time.h"
 #include "doc/layer.h"
 #include "doc/selected_frames.h"
 #include "doc/selected_layers.h"
 #include "doc/slice.h"
 #include "doc/tag.h"
 #include "doc/tags.h"
+#include "fmt/format.h"
 #include "os/system.h"
 #include "render/dithering_algorithm.h"
 
 #include <algorithm>
 #include <queue>
+#include <thread>
 #include <vector>
 
 namespace app {
@@ -123,6 +132,48 @@ std::string convert_filter_to_layer_path_if_possible(const Sprite* sprite,
     return filter;
 }
 
+// FILE_LOAD_* flags used by OpenFileCommand to open files from the
+// CLI (the sequence flags are ignored because only formats without
+// sequences are preloaded).
+int cli_load_flags(const bool oneFrame)
+{
+  return FILE_LOAD_DATA_FILE | FILE_LOAD_CREATE_PALETTE | FILE_LOAD_SEQUENCE_NONE |
+         (oneFrame ? FILE_LOAD_ONE_FRAME : 0);
+}
+
+// Returns a string that changes when the given file is modified (or
+// an empty string if the file doesn't exist)
+std::string file_stamp(const std::string& filename)
+{
+  if (!base::is_file(filename))
+    return std::string();
+
+  const base::Time t = base::get_modification_time(filename);
+  return fmt::format("{} {:04}{:02}{:02}{:02}{:02}{:02}",
+                     base::file_size(filename),
+                     t.year,
+                     t.month,
+                     t.day,
+                     t.hour,
+                     t.minute,
+                     t.second);
+}
+
+// Parses the "x,y,width,height" value of --crop
+bool parse_crop(const std::string& value, gfx::Rect& crop)
+{
+  std::vector<std::string> parts;
+  base::split_string(value, parts, ",");
+  if (parts.size() < 4)
+    return false;
+
+  crop.x = base::convert_to<int>(parts[0]);
+  crop.y = base::convert_to<int>(parts[1]);
+  crop.w = base::convert_to<int>(parts[2]);
+  crop.h = base::convert_to<int>(parts[3]);
+  return true;
+}
+
 } // anonymous namespace
 
 // static
@@ -161,8 +212,58 @@ CliProcessor::CliProcessor(CliDelegate* delegate, const AppOptions& options)
     m_exporter.reset(new DocExporter);
 }
 
+CliProcessor::~CliProcessor() = default;
+
 int CliProcessor::process(Context* ctx)
 {
+  int exitCode = processOptions(ctx);
+
+  // --watch: export again when an input file is modified, until
+  // the process is interrupted (Ctrl+C)
+  if (m_options.watch() && ctx && !ctx->isUIAvailable() && !m_watchedFiles.empty()) {
+    m_watcher = std::make_unique<FileWatcher>();
+    while (waitForModifiedFiles()) {
+      closeAllDocs(ctx);
+      exitCode = processOptions(ctx);
+    }
+    m_watcher.reset();
+  }
+
+  // Running mode
+  if (m_options.startUI()) {
+    m_delegate->uiMode();
+  }
+  else if (m_options.startShell()) {
+    m_delegate->shellMode();
+  }
+  else {
+    m_delegate->batchMode();
+  }
+  return exitCode;
+}
+
+int CliProcessor::processOptions(Context* ctx)
+{
+  // Exit code (1 if --diff finds differences)
+  int exitCode = 0;
+
+  // Start from scratch in each --watch iteration
+  m_usedFiles.clear();
+  if (m_exporter) {
+    m_exporter->reset();
+
+    // Keep the renders of the sprite sheet samples to render only
+    // the modified frames in the next --watch iteration (scripts can
+    // modify the sprites in any way, so we cannot keep them)
+    if (m_options.watch()) {
+      const auto& values = m_options.values();
+      m_exporter->setKeepRenders(
+        std::none_of(values.begin(), values.end(), [this](const auto& value) {
+          return (value.option() == &m_options.script());
+        }));
+    }
+  }
+
   // --help
   if (m_options.showHelp()) {
     m_delegate->showHelp(m_options);
@@ -171,8 +272,9 @@ int CliProcessor::process(Context* ctx)
   else if (m_options.showVersion()) {
     m_delegate->showVersion();
   }
-  // Process other options and file names
-  else if (!m_options.values().empty()) {
+  // Process other options and file names (if the generated files
+  // cannot be restored from --cache-dir)
+  else if (!m_options.values().empty() && !restoreFromExportCache(ctx)) {
 #ifdef ENABLE_SCRIPTING
     Params scriptParams;
 #endif
@@ -182,6 +284,16 @@ int CliProcessor::process(Context* ctx)
     Doc* lastDoc = nullptr;
     render::DitheringAlgorithm ditheringAlgorithm = render::DitheringAlgorithm::None;
     std::string ditheringMatrix;
+    bool ditheringSerpentine = true;
+
+    findPartialLoadFiles();
+
+    // --jobs N
+    if (ctx && !ctx->isUIAvailable()) {
+      const int jobs = preloadJobs();
+      if (jobs > 1)
+        preloadFiles(jobs);
+    }
 
     for (const auto& value : m_options.values()) {
       const AppOptions::Option* opt = value.option();
@@ -248,6 +360,19 @@ int CliProcessor::process(Context* ctx)
         else if (opt == &m_options.sheetPack()) {
           sheetType = SpriteSheetType::Packed;
         }
+        // --sheet-pack-algorithm <algorithm>
+        else if (opt == &m_options.sheetPackAlgorithm()) {
+          if (m_exporter) {
+            SpriteSheetPackAlgorithm algorithm = SpriteSheetPackAlgorithm::Default;
+
+            if (value.value() == "best-fit")
+              algorithm = SpriteSheetPackAlgorithm::BestFit;
+            else if (value.value() == "max-rects")
+              algorithm = SpriteSheetPackAlgorithm::MaxRects;
+
+            m_exporter->setPackAlgorithm(algorithm);
+          }
+        }
         // --split-layers
         else if (opt == &m_options.splitLayers()) {
           cof.splitLayers = true;
@@ -306,6 +431,10 @@ int CliProcessor::process(Context* ctx)
           if (m_exporter)
             m_exporter->setIgnoreEmptyCels(true);
         }
+        // --incremental
+        else if (opt == &m_options.incremental()) {
+          cof.incremental = true;
+        }
         // --merge-duplicates
         else if (opt == &m_options.mergeDuplicates()) {
           if (m_exporter)
@@ -353,17 +482,10 @@ int CliProcessor::process(Context* ctx)
         }
         // --crop x,y,width,height
         else if (opt == &m_options.crop()) {
-          std::vector<std::string> parts;
-          base::split_string(value.value(), parts, ",");
-          if (parts.size() < 4)
+          if (!parse_crop(value.value(), cof.crop))
             throw std::runtime_error("--crop needs four parameters separated by comma (,)\n"
                                      "Usage: --crop x,y,width,height\n"
                                      "E.g. --crop 0,0,32,32");
-
-          cof.crop.x = base::convert_to<int>(parts[0]);
-          cof.crop.y = base::convert_to<int>(parts[1]);
-          cof.crop.w = base::convert_to<int>(parts[2]);
-          cof.crop.h = base::convert_to<int>(parts[3]);
         }
         // --slice <slice>
         else if (opt == &m_options.slice()) {
@@ -381,11 +503,40 @@ int CliProcessor::process(Context* ctx)
           if (m_exporter)
             m_exporter->setTagnameFormat(cof.tagnameFormat);
         }
+        // --compression <profile>
+        else if (opt == &m_options.compression()) {
+          // Preferences aren't saved in batch mode, so this doesn't
+          // change the profile used in the UI.
+          auto& pref = Preferences::instance();
+          if (value.value() == "fastest")
+            pref.asepriteFormat.compression(gen::CompressionProfile::FASTEST);
+          else if (value.value() == "default")
+            pref.asepriteFormat.compression(gen::CompressionProfile::DEFAULT);
+          else if (value.value() == "smallest")
+            pref.asepriteFormat.compression(gen::CompressionProfile::SMALLEST);
+          else
+            throw std::runtime_error("--compression needs a valid profile\n"
+                                     "Usage: --compression <profile>\n"
+                                     "Where <profile> can be fastest, default, or smallest");
+        }
+        // --diff <filename>
+        else if (opt == &m_options.diff()) {
+          if (!lastDoc)
+            throw std::runtime_error("--diff needs a previous sprite to compare\n"
+                                     "Usage: sprite.aseprite --diff <filename>");
+          if (m_delegate->diffFile(ctx, lastDoc, base::normalize_path(value.value())))
+            exitCode = 1;
+        }
         // --save-as <filename>
         else if (opt == &m_options.saveAs()) {
           if (lastDoc) {
             std::string fn = value.value();
 
+            // Don't write the unchanged frames of a sequence again in
+            // each --watch iteration
+            if (m_options.watch())
+              cof.incremental = true;
+
             // Automatic --filename-format
             // in case the output filename already contains template elements.
             if (is_template_in_filename(fn)) {
@@ -465,6 +616,17 @@ int CliProcessor::process(Context* ctx)
         else if (opt == &m_options.ditheringMatrix()) {
           ditheringMatrix = value.value();
         }
+        // --dithering-rows <order>
+        else if (opt == &m_options.ditheringRows()) {
+          if (value.value() == "serpentine")
+            ditheringSerpentine = true;
+          else if (value.value() == "left-to-right")
+            ditheringSerpentine = false;
+          else
+            throw std::runtime_error("--dithering-rows needs a valid order\n"
+                                     "Usage: --dithering-rows <order>\n"
+                                     "Where <order> can be serpentine or left-to-right");
+        }
         // --color-mode <mode>
         else if (opt == &m_options.colorMode()) {
           Command* command = Commands::instance()->byId(CommandId::ChangePixelFormat());
@@ -490,6 +652,10 @@ int CliProcessor::process(Context* ctx)
                 !ditheringMatrix.empty()) {
               params.set("dithering-matrix", ditheringMatrix.c_str());
             }
+            if (ditheringAlgorithm == render::DitheringAlgorithm::ErrorDiffusion &&
+                !ditheringSerpentine) {
+              params.set("dithering-serpentine", "false");
+            }
           }
           else {
             throw std::runtime_error("--color-mode needs a valid color mode for conversion\n"
@@ -595,11 +761,17 @@ int CliProcessor::process(Context* ctx)
         cof.document = nullptr;
         cof.filename = base::normalize_path(value.value());
 
+        // Load only the cropped region/frames/layers if it's possible
+        const FileOpROI* roi = nullptr;
+        auto it = m_partialLoadFiles.find(&value - m_options.values().data());
+        if (it != m_partialLoadFiles.end())
+          roi = &it->second;
+
         if ( // Check that the filename wasn't used loading a sequence
              // of images as one sprite
           m_usedFiles.find(cof.filename) == m_usedFiles.end() &&
           // Open sprite
-          openFile(ctx, cof)) {
+          openFile(ctx, cof, roi)) {
           lastDoc = cof.document;
         }
       }
@@ -612,34 +784,264 @@ int CliProcessor::process(Context* ctx)
       m_exporter->setSpriteSheetType(sheetType);
 
       m_delegate->exportFiles(ctx, *m_exporter.get());
-      m_exporter.reset(nullptr);
+      if (m_cache) {
+        m_cache->addOutput(m_exporter->textureFilename());
+        m_cache->addOutput(m_exporter->dataFilename());
+      }
+      // The exporter is re-used in the next --watch iteration
+      if (!m_options.watch())
+        m_exporter.reset(nullptr);
+    }
+
+    // Discard files that were preloaded but weren't opened
+    m_preloader.reset();
+
+    // --cache-dir
+    if (m_cache) {
+      for (const auto& fn : m_usedFiles)
+        m_cache->addInput(fn);
+      for (const auto& value : m_options.values()) {
+        if (value.option() == &m_options.palette())
+          m_cache->addInput(base::normalize_path(value.value()));
+      }
+      m_cache->store();
+      m_cache.reset();
+    }
+
+    // --watch
+    if (m_options.watch()) {
+      m_watchedFiles.clear();
+      for (const auto& fn : m_usedFiles)
+        m_watchedFiles[fn] = file_stamp(fn);
+      for (const auto& value : m_options.values()) {
+        if (value.option() == &m_options.palette()) {
+          const std::string fn = base::normalize_path(value.value());
+          m_watchedFiles[fn] = file_stamp(fn);
+        }
+      }
     }
   }
+  return exitCode;
+}
 
-  // Running mode
-  if (m_options.startUI()) {
-    m_delegate->uiMode();
+bool CliProcessor::canUseExportCache(Context* ctx) const
+{
+  if (!m_options.programOptions().enabled(m_options.cacheDir()) || !ctx ||
+      ctx->isUIAvailable() || m_options.previewCLI() || m_options.startShell())
+    return false;
+
+  for (const auto& value : m_options.values()) {
+    const AppOptions::Option* opt = value.option();
+#ifdef ENABLE_SCRIPTING
+    // Scripts can generate any file
+    if (opt == &m_options.script())
+      return false;
+#endif
+    // The output of --list-* without --data/--sheet goes to stdout
+    if (!m_exporter &&
+        (opt == &m_options.listLayers() || opt == &m_options.listLayerHierarchy() ||
+         opt == &m_options.listTags() || opt == &m_options.listSlices()))
+      return false;
+    // The output of --diff goes to stdout
+    if (opt == &m_options.diff())
+      return false;
+    // The output of --save-as - goes to stdout
+    if (opt == &m_options.saveAs() && !value.value().empty() && value.value()[0] == '-')
+      return false;
   }
-  else if (m_options.startShell()) {
-    m_delegate->shellMode();
+
+  // Without --data the JSON data goes to stdout
+  if (m_exporter && !m_options.programOptions().enabled(m_options.data()))
+    return false;
+
+  return true;
+}
+
+bool CliProcessor::restoreFromExportCache(Context* ctx)
+{
+  if (!canUseExportCache(ctx))
+    return false;
+
+  // The key includes the current path because the arguments can
+  // contain relative paths.
+  std::string description = base::get_current_path() + "\n";
+  for (const auto& value : m_options.values()) {
+    if (value.option())
+      description += "--" + value.option()->name() + "=";
+    description += value.value() + "\n";
   }
-  else {
-    m_delegate->batchMode();
+
+  m_cache = std::make_unique<ExportCache>(
+    m_options.programOptions().value_of(m_options.cacheDir()),
+    ExportCache::makeKey(description));
+
+  if (m_cache->restore()) {
+    m_cache.reset();
+    return true;
+  }
+  return false;
+}
+
+// Finds the files that are only cropped, filtered, and saved, i.e.
+// "--crop x,y,w,h --tag name --frame-range a,b --layer name file
+// --save-as output", so we can load just the cropped region and the
+// cels of the given frames/layers from them. We cannot do this when
+// other options use pixels or frames outside that region (e.g. --trim
+// or --slice) or when the file is modified after it's opened
+// (--script, --palette, etc.).
+void CliProcessor::findPartialLoadFiles()
+{
+  m_partialLoadFiles.clear();
+  if (m_exporter)
+    return;
+
+  const AppOptions::ValueList& values = m_options.values();
+  gfx::Rect crop;
+  std::string tag;
+  doc::SelectedFrames frames;
+  std::vector<std::string> layers;
+  bool plainLayerNames = true;
+  bool splitOptions = false;
+  bool otherOptions = false;
+
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    const AppOptions::Option* opt = values[i].option();
+    if (opt == &m_options.crop()) {
+      if (!parse_crop(values[i].value(), crop))
+        crop = gfx::Rect();
+    }
+    else if (opt == &m_options.tag()) {
+      tag = values[i].value();
+    }
+    else if (opt == &m_options.frameRange()) {
+      std::vector<std::string> splitRange;
+      base::split_string(values[i].value(), splitRange, ",");
+      frames.clear();
+      if (splitRange.size() >= 2) {
+        const frame_t fromFrame = base::convert_to<frame_t>(splitRange[0]);
+        const frame_t toFrame = base::convert_to<frame_t>(splitRange[1]);
+        if (fromFrame >= 0 && toFrame >= 0)
+          frames.insert(fromFrame, toFrame);
+      }
+    }
+    else if (opt == &m_options.layer()) {
+      // Layer paths and wildcards are matched only after loading the
+      // whole sprite
+      const std::string& name = values[i].value();
+      if (name.find_first_of("/*,") != std::string::npos)
+        plainLayerNames = false;
+      layers.push_back(name);
+    }
+    else if (opt == &m_options.splitLayers() || opt == &m_options.splitTags()) {
+      splitOptions = true;
+    }
+    else if (opt == &m_options.trim() || opt == &m_options.trimSprite() ||
+             opt == &m_options.trimByGrid() || opt == &m_options.slice() ||
+             opt == &m_options.splitSlices() || opt == &m_options.splitGrid()) {
+      otherOptions = true;
+    }
+    else if (!opt && !otherOptions) {
+      // Only --save-as options (without templates, as they could save
+      // other documents too) until the next file
+      bool asepriteOutput = false;
+      std::size_t j = i + 1;
+      for (; j < values.size() && values[j].option() == &m_options.saveAs() &&
+             !is_template_in_filename(values[j].value());
+           ++j) {
+        const std::string ext = base::string_to_lower(base::get_file_extension(values[j].value()));
+        if (ext == "ase" || ext == "aseprite")
+          asepriteOutput = true;
+      }
+      if (j == i + 1 || (j < values.size() && values[j].option()))
+        continue;
+
+      // --split-layers/tags need all layers and frames, and .aseprite
+      // files keep hidden layers (so we need all their cels)
+      FileOpROI roi(nullptr,
+                    crop,
+                    std::string(),
+                    (splitOptions ? std::string() : tag),
+                    (splitOptions ? doc::FramesSequence() : doc::FramesSequence(frames)),
+                    true);
+      if (!splitOptions && !asepriteOutput && plainLayerNames)
+        roi.setLayersToLoad(layers);
+
+      if (!roi.bounds().isEmpty() || !roi.tagName().empty() || !roi.framesSequence().empty() ||
+          !roi.layersToLoad().empty()) {
+        m_partialLoadFiles[i] = roi;
+      }
+    }
   }
-  return 0;
 }
 
-bool CliProcessor::openFile(Context* ctx, CliOpenFile& cof)
+int CliProcessor::preloadJobs() const
+{
+  if (m_options.hasJobs() || !m_exporter)
+    return m_options.jobs();
+
+  // The input files of a sprite sheet are loaded in parallel by
+  // default (all of them must be loaded before creating the sheet).
+  // The preloader keeps only a few decoded files waiting in memory.
+  const auto& values = m_options.values();
+  const auto files = std::count_if(values.begin(), values.end(), [](const auto& value) {
+    return (value.option() == nullptr);
+  });
+  if (files > 1)
+    return int(std::max(1u, std::thread::hardware_concurrency()));
+  return m_options.jobs();
+}
+
+void CliProcessor::preloadFiles(const int jobs)
+{
+  m_preloader = std::make_unique<FilePreloader>(jobs);
+
+  // Same order and flags used by the main loop in process() to open
+  // each file (see openFile()).
+  // Files that are loaded partially are loaded later with their
+  // region of interest.
+  const AppOptions::ValueList& values = m_options.values();
+  bool oneFrame = false;
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    const AppOptions::Option* opt = values[i].option();
+    if (opt == &m_options.oneFrame()) {
+      oneFrame = true;
+    }
+    else if (!opt && m_partialLoadFiles.find(i) == m_partialLoadFiles.end()) {
+      const std::string fn = base::normalize_path(values[i].value());
+      // Unmodified files are duplicated from their --watch copy
+      if (!oneFrame && isWatchedCopyValid(fn))
+        continue;
+      if (FilePreloader::canPreload(fn))
+        m_preloader->add(fn, cli_load_flags(oneFrame));
+    }
+  }
+
+  m_preloader->start();
+}
+
+bool CliProcessor::openFile(Context* ctx, CliOpenFile& cof, const FileOpROI* roi)
 {
   m_delegate->beforeOpenFile(cof);
 
   Doc* oldDoc = ctx->activeDocument();
 
-  m_batch.open(ctx, cof.filename, cof.oneFrame);
+  base::paths usedFiles;
+  const bool fromWatchedCopy = (!roi && !cof.oneFrame && openWatchedFile(ctx, cof.filename));
+  if (fromWatchedCopy) {
+    usedFiles.push_back(cof.filename);
+  }
+  else if (!roi && m_preloader &&
+           m_preloader->open(ctx, cof.filename, cli_load_flags(cof.oneFrame))) {
+    usedFiles.push_back(cof.filename);
+  }
+  else {
+    m_batch.open(ctx, cof.filename, cof.oneFrame, roi);
+    usedFiles = m_batch.usedFiles();
+  }
 
   // Mark used file names as "already processed" so we don't try to
   // open then again
-  for (const auto& usedFn : m_batch.usedFiles()) {
+  for (const auto& usedFn : usedFiles) {
     auto fn = base::normalize_path(usedFn);
     m_usedFiles.insert(fn);
 
@@ -654,6 +1056,20 @@ bool CliProcessor::openFile(Context* ctx, CliOpenFile& cof)
 
   cof.document = doc;
 
+  // Don't cache the result if some file cannot be opened
+  if (!doc)
+    m_cache.reset();
+
+  // Keep a copy of the original document (before it's modified by
+  // other options) to re-use it in the next --watch iteration
+  if (doc && !fromWatchedCopy && m_options.watch()) {
+    if (!roi && !cof.oneFrame && usedFiles.size() == 1)
+      keepWatchedFile(base::normalize_path(usedFiles[0]), doc);
+    // We cannot know which frames of this document were modified
+    else if (m_exporter)
+      m_exporter->invalidateRenders(doc->filename());
+  }
+
   if (doc) {
     // Show all layers
     if (cof.allLayers) {
@@ -705,6 +1121,112 @@ bool CliProcessor::openFile(Context* ctx, CliOpenFile& cof)
   return (doc ? true : false);
 }
 
+bool CliProcessor::openWatchedFile(Context* ctx, const std::string& filename)
+{
+  if (!isWatchedCopyValid(filename))
+    return false;
+
+  auto it = m_watchedDocs.find(base::normalize_path(filename));
+  Doc* doc = it->second.doc->duplicate(DuplicateExactCopy);
+  doc->setFilename(it->second.doc->filename());
+  doc->setContext(ctx);
+  return true;
+}
+
+void CliProcessor::keepWatchedFile(const std::string& filename, const Doc* doc)
+{
+  WatchedDoc& watched = m_watchedDocs[filename];
+  const std::string stamp = file_stamp(filename);
+  if (watched.doc && watched.stamp == stamp)
+    return;
+
+  // Discard the sprite sheet renders of the modified frames only
+  // (or of all frames if something global was modified)
+  if (m_exporter) {
+    if (watched.doc) {
+      const DocDiffDetails details = diff_docs(watched.doc.get(), doc);
+      const DocDiff& diff = details.diff;
+      if (diff.canvas || diff.palettes || diff.tilesets || diff.layers || diff.colorProfiles ||
+          diff.gridBounds)
+        m_exporter->invalidateRenders(doc->filename());
+      else if (diff.anything)
+        m_exporter->invalidateRenders(doc->filename(), details.frames);
+    }
+    else
+      m_exporter->invalidateRenders(doc->filename());
+  }
+
+  watched.stamp = stamp;
+  watched.doc.reset(doc->duplicate(DuplicateExactCopy));
+  watched.doc->setFilename(doc->filename());
+}
+
+bool CliProcessor::isWatchedCopyValid(const std::string& filename) const
+{
+  auto it = m_watchedDocs.find(base::normalize_path(filename));
+  return (it != m_watchedDocs.end() && it->second.stamp == file_stamp(it->first));
+}
+
+// Returns false if the --watch mode was interrupted
+bool CliProcessor::waitForModifiedFiles()
+{
+  std::set<std::string> filenames;
+  for (const auto& [fn, stamp] : m_watchedFiles)
+    filenames.insert(fn);
+  m_watcher->watch(filenames);
+
+  // The files are checked before waiting for the first notification
+  // because they could be modified before we started watching them
+  while (!updateWatchedStamps()) {
+    if (m_watcher->wait() == FileWatcher::Result::Stopped)
+      return false;
+  }
+
+  // Wait until the files are completely written (there are no more
+  // changes in 250 ms)
+  for (;;) {
+    const FileWatcher::Result result = m_watcher->wait(0.25);
+    if (result == FileWatcher::Result::Stopped)
+      return false;
+    if (!updateWatchedStamps() && result == FileWatcher::Result::Timeout)
+      return true;
+  }
+}
+
+// Returns true if some watched file was modified
+bool CliProcessor::updateWatchedStamps()
+{
+  bool modified = false;
+  for (auto& [fn, stamp] : m_watchedFiles) {
+    const std::string newStamp = file_stamp(fn);
+    if (newStamp == stamp)
+      continue;
+
+    stamp = newStamp;
+    modified = true;
+
+    // A --palette file modifies all the exported sprites
+    if (m_exporter && m_watchedDocs.find(fn) == m_watchedDocs.end()) {
+      for (const auto& value : m_options.values()) {
+        if (value.option() == &m_options.palette() && base::normalize_path(value.value()) == fn) {
+          m_exporter->invalidateRenders();
+          break;
+        }
+      }
+    }
+  }
+  return modified;
+}
+
+void CliProcessor::closeAllDocs(Context* ctx)
+{
+  const std::vector<Doc*> docs(ctx->documents().begin(), ctx->documents().end());
+  for (Doc* doc : docs) {
+    doc->close();
+    delete doc;
+  }
+}
+
 void CliProcessor::saveFile(Context* ctx, const CliOpenFile& cof)
 {
   ctx->setActiveDocument(cof.document);
@@ -787,6 +1309,16 @@ void CliProcessor::saveFile(Context* ctx, const CliOpenFile& cof)
   bool layerInFormat = is_layer_in_filename_format(fn);
   bool groupInFormat = is_group_in_filename_format(fn);
 
+  // If the document is not modified between items (--trim and
+  // --split-layers modify the sprite or the layers visibility for
+  // each item), all items can be saved at the same time by the
+  // delegate (e.g. in parallel for --split-tags/--split-slices).
+  const bool saveInBatch = (!cof.splitLayers && !cof.trim);
+  std::vector<CliOpenFile> batch;
+  RestoreVisibleLayers batchVisibility;
+  if (saveInBatch && !filteredLayers.empty())
+    batchVisibility.showSelectedLayers(doc->sprite(), filteredLayers);
+
   for (doc::Slice* slice : slices) {
     for (doc::Tag* tag : tags) {
       // For each layer, hide other ones and save the sprite.
@@ -803,7 +1335,7 @@ void CliProcessor::saveFile(Context* ctx, const CliOpenFile& cof)
           // Make this layer ("show") the only one visible.
           layersVisibility.showLayer(layer);
         }
-        else if (!filteredLayers.empty())
+        else if (!filteredLayers.empty() && !saveInBatch)
           layersVisibility.showSelectedLayers(doc->sprite(), filteredLayers);
 
         if (layer) {
@@ -850,8 +1382,26 @@ void CliProcessor::saveFile(Context* ctx, const CliOpenFile& cof)
         itemCof.filename = filename_formatter(filenameFormat, fnInfo);
         itemCof.filenameFormat = filename_formatter(filenameFormat, fnInfo, false);
 
+        // Files that will be generated (e.g. one file per frame)
+        if (m_cache) {
+          std::unique_ptr<FileOp> fop(FileOp::createSaveDocumentOperation(ctx,
+                                                                         itemCof.roi(),
+                                                                         itemCof.filename,
+                                                                         itemCof.filenameFormat,
+                                                                         itemCof.ignoreEmpty));
+          if (fop) {
+            base::paths filenames;
+            fop->getFilenameList(filenames);
+            for (const auto& fn : filenames)
+              m_cache->addOutput(fn);
+          }
+        }
+
         // Call delegate
-        m_delegate->saveFile(ctx, itemCof);
+        if (saveInBatch)
+          batch.push_back(itemCof);
+        else
+          m_delegate->saveFile(ctx, itemCof);
 
         if (cof.trim) {
           ctx->executeCommand(undoCommand);
@@ -861,6 +1411,9 @@ void CliProcessor::saveFile(Context* ctx, const CliOpenFile& cof)
     }
   }
 
+  if (!batch.empty())
+    m_delegate->saveFiles(ctx, batch);
+
   // Undo crop
   if (!cof.crop.isEmpty()) {
     ctx->executeCommand(undoCommand);
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2020  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2016-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -15,6 +15,7 @@
 #include "app/util/open_batch.h"
 #include "doc/selected_layers.h"
 
+#include <map>
 #include <memory>
 #include <set>
 #include <string>
@@ -29,10 +30,14 @@ namespace app {
 class AppOptions;
 class Context;
 class DocExporter;
+class ExportCache;
+class FilePreloader;
+class FileWatcher;
 
 class CliProcessor {
 public:
   CliProcessor(CliDelegate* delegate, const AppOptions& options);
+  ~CliProcessor();
   int process(Context* ctx);
 
   // Public so it can be tested
@@ -43,7 +48,19 @@ public:
                            doc::SelectedLayers& filteredLayers);
 
 private:
-  bool openFile(Context* ctx, CliOpenFile& cof);
+  int processOptions(Context* ctx);
+  void findPartialLoadFiles();
+  int preloadJobs() const;
+  void preloadFiles(int jobs);
+  bool canUseExportCache(Context* ctx) const;
+  bool restoreFromExportCache(Context* ctx);
+  bool openFile(Context* ctx, CliOpenFile& cof, const FileOpROI* roi);
+  bool openWatchedFile(Context* ctx, const std::string& filename);
+  void keepWatchedFile(const std::string& filename, const Doc* doc);
+  bool isWatchedCopyValid(const std::string& filename) const;
+  bool waitForModifiedFiles();
+  bool updateWatchedStamps();
+  void closeAllDocs(Context* ctx);
   void saveFile(Context* ctx, const CliOpenFile& cof);
 
   void filterLayers(const doc::Sprite* sprite,
@@ -61,6 +78,28 @@ private:
   // load a sequence of files) so we don't ask for them again.
   std::set<std::string> m_usedFiles;
   OpenBatchOfFiles m_batch;
+
+  // Loads the next files in background threads (--jobs N)
+  std::unique_ptr<FilePreloader> m_preloader;
+
+  // Index (in the list of values) of the files that are only saved
+  // with a region of interest -> part (cropped region, frames,
+  // layers) that must be loaded from each file
+  std::map<std::size_t, FileOpROI> m_partialLoadFiles;
+
+  // Files generated by this call to be saved in --cache-dir
+  std::unique_ptr<ExportCache> m_cache;
+
+  // --watch mode: a copy of each document loaded from an input file
+  // (to duplicate it if the file is not modified), and the stamp
+  // (size/modification time) of each input file.
+  struct WatchedDoc {
+    std::string stamp;
+    std::unique_ptr<Doc> doc;
+  };
+  std::map<std::string, WatchedDoc> m_watchedDocs;
+  std::map<std::string, std::string> m_watchedFiles;
+  std::unique_ptr<FileWatcher> m_watcher;
 };
 
 } // namespace app
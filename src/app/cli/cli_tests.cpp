@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2019  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2016-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -92,3 +92,10 @@ TEST(Cli, Version)
   p.process(nullptr);
   EXPECT_TRUE(d.versionWasShown());
 }
+
+TEST(Cli, Jobs)
+{
+  EXPECT_EQ(1, args({ "--batch" })->jobs());
+  EXPECT_EQ(4, args({ "--batch", "--jobs", "4" })->jobs());
+  EXPECT_LE(1, args({ "--batch", "--jobs", "0" })->jobs());
+}
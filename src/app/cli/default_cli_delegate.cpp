@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2024  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2016-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -17,15 +17,23 @@
 #include "app/commands/params.h"
 #include "app/console.h"
 #include "app/doc.h"
+#include "app/doc_diff.h"
 #include "app/doc_exporter.h"
+#include "app/file/file.h"
+#include "app/file/file_format.h"
+#include "app/file/file_formats_manager.h"
+#include "app/file/frame_render_cache.h"
 #include "app/file/palette_file.h"
 #include "app/ui_context.h"
 #include "base/convert_to.h"
+#include "base/fs.h"
+#include "dio/detect_format.h"
 #include "doc/layer.h"
 #include "doc/palette.h"
 #include "doc/slice.h"
 #include "doc/sprite.h"
 #include "doc/tag.h"
+#include "doc/task_group.h"
 #include "ver/info.h"
 
 #ifdef ENABLE_SCRIPTING
@@ -35,8 +43,17 @@
   #include "app/ui/input_chain.h"
 #endif
 
+#ifdef _WIN32
+  #include <fcntl.h>
+  #include <io.h>
+#endif
+
+#include <algorithm>
+#include <cstdio>
 #include <iostream>
 #include <memory>
+#include <stdexcept>
+#include <vector>
 
 namespace app {
 
@@ -80,8 +97,126 @@ void DefaultCliDelegate::afterOpenFile(const CliOpenFile& cof)
   }
 }
 
+// Saves the file in the standard output for --save-as - (using the
+// format of the document) or --save-as -.<extension>.
+static void save_file_in_stdout(Context* ctx, const CliOpenFile& cof)
+{
+  std::string fn = cof.filename;
+  if (fn == "-")
+    fn += "." + base::get_file_extension(cof.document->filename());
+
+  doc::FramesSequence framesSeq;
+  if (cof.hasFrameRange())
+    framesSeq.insert(cof.fromFrame, cof.toFrame);
+
+  FileOpROI roi(cof.document,
+                cof.document->sprite()->bounds(),
+                cof.slice,
+                cof.tag,
+                framesSeq,
+                cof.hasFrameRange());
+
+  std::vector<uint8_t> data;
+  if (save_document_in_memory(ctx, roi, fn, data) == 0) {
+#ifdef _WIN32
+    _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    std::fwrite(data.data(), 1, data.size(), stdout);
+    std::fflush(stdout);
+  }
+}
+
+static bool can_save_in_parallel(const CliOpenFile& cof)
+{
+  if (cof.filename.empty() || base::get_file_title(cof.filename) == "-" || cof.playSubtags)
+    return false;
+
+  FileFormat* format = FileFormatsManager::instance()->getFileFormat(
+    dio::detect_format_by_file_extension(cof.filename));
+  return (format && format->support(FILE_SUPPORT_SAVE) &&
+          format->support(FILE_SUPPORT_SEQUENCES));
+}
+
+// Saves the files of the same document in parallel (like the
+// SaveFileCopyAs command would do for each one), sharing the
+// rendered frames between them.
+static void save_files_in_parallel(Context* ctx, const std::vector<const CliOpenFile*>& cofs)
+{
+  const Doc* doc = cofs.front()->document;
+  std::unique_ptr<FrameRenderCache> renderCache;
+  std::vector<std::unique_ptr<FileOp>> fops;
+
+  for (const CliOpenFile* cof : cofs) {
+    const FileOpROI roi = cof->roi();
+    std::unique_ptr<FileOp> fop(FileOp::createSaveDocumentOperation(ctx,
+                                                                    roi,
+                                                                    cof->filename,
+                                                                    cof->filenameFormat,
+                                                                    cof->ignoreEmpty));
+    if (!fop)
+      continue;
+    if (fop->hasError()) {
+      Console().printf(fop->error().c_str());
+      continue;
+    }
+
+    if (FileOp::checkIfFormatSupportResizeOnTheFly(cof->filename))
+      fop->setOnTheFlyScale(gfx::PointF(1.0, 1.0));
+    fop->setIncremental(cof->incremental);
+
+    if (!renderCache)
+      renderCache = std::make_unique<FrameRenderCache>(doc->sprite(), fop->newBlend());
+    fop->setRenderCache(renderCache.get());
+    for (const doc::frame_t frame : roi.framesSequence())
+      renderCache->addUse(frame);
+
+    // Output directories are created in this thread (so two FileOps
+    // don't try to create the same directory at the same time)
+    base::paths filenames;
+    fop->getFilenameList(filenames);
+    for (const auto& fn : filenames) {
+      const std::string dir = base::get_file_path(fn);
+      try {
+        if (!dir.empty() && !base::is_directory(dir))
+          base::make_all_directories(dir);
+      }
+      catch (const std::exception&) {
+        // Ignore errors, the FileOp will report them
+      }
+    }
+
+    fops.push_back(std::move(fop));
+  }
+
+  doc::TaskGroup tasks;
+  for (auto& fop : fops) {
+    tasks.run([fop = fop.get()] {
+      try {
+        fop->operate();
+      }
+      catch (const std::exception& e) {
+        fop->setError("Error saving file:\n%s", e.what());
+      }
+      fop->done();
+    });
+  }
+  tasks.wait();
+
+  // Errors are reported in the same order as the files
+  for (const auto& fop : fops) {
+    if (fop->hasError())
+      Console().printf(fop->error().c_str());
+  }
+}
+
 void DefaultCliDelegate::saveFile(Context* ctx, const CliOpenFile& cof)
 {
+  if (cof.filename == "-" || (base::get_file_title(cof.filename) == "-" &&
+                              base::get_file_path(cof.filename).empty())) {
+    save_file_in_stdout(ctx, cof);
+    return;
+  }
+
   Command* saveAsCommand = Commands::instance()->byId(CommandId::SaveFileCopyAs());
   Params params;
   params.set("filename", cof.filename.c_str());
@@ -103,10 +238,31 @@ void DefaultCliDelegate::saveFile(Context* ctx, const CliOpenFile& cof)
 
   if (cof.ignoreEmpty)
     params.set("ignoreEmpty", "true");
+  if (cof.incremental)
+    params.set("incremental", "true");
 
   ctx->executeCommand(saveAsCommand, params);
 }
 
+void DefaultCliDelegate::saveFiles(Context* ctx, const std::vector<CliOpenFile>& cofs)
+{
+  // Only formats that are saved as sequences of images (which read
+  // the document without modifying it) are saved in parallel, the
+  // rest of files are saved one after the other.
+  std::vector<const CliOpenFile*> parallelCofs;
+  for (const auto& cof : cofs) {
+    if (can_save_in_parallel(cof))
+      parallelCofs.push_back(&cof);
+    else
+      saveFile(ctx, cof);
+  }
+
+  if (parallelCofs.size() == 1)
+    saveFile(ctx, *parallelCofs.front());
+  else if (!parallelCofs.empty())
+    save_files_in_parallel(ctx, parallelCofs);
+}
+
 void DefaultCliDelegate::loadPalette(Context* ctx, const std::string& filename)
 {
   std::unique_ptr<doc::Palette> palette(load_palette(filename.c_str()));
@@ -122,6 +278,53 @@ void DefaultCliDelegate::loadPalette(Context* ctx, const std::string& filename)
   }
 }
 
+bool DefaultCliDelegate::diffFile(Context* ctx, Doc* doc, const std::string& filename)
+{
+  std::unique_ptr<Doc> other(load_document(ctx, filename));
+  if (!other)
+    throw std::runtime_error("Error loading file " + filename);
+
+  const DocDiffDetails details = diff_docs(doc, other.get());
+  const DocDiff& diff = details.diff;
+  if (diff.anything) {
+    // Properties of the sprite
+    if (diff.canvas)
+      std::cout << "canvas\n";
+    if (diff.totalFrames)
+      std::cout << "total-frames\n";
+    if (diff.tags)
+      std::cout << "tags\n";
+    if (diff.palettes)
+      std::cout << "palettes\n";
+    if (diff.tilesets)
+      std::cout << "tilesets\n";
+    if (diff.colorProfiles)
+      std::cout << "color-profile\n";
+    if (diff.gridBounds)
+      std::cout << "grid\n";
+
+    // Layer names from the doc that contains the layer
+    const LayerList aLayers = doc->sprite()->allLayers();
+    const LayerList bLayers = other->sprite()->allLayers();
+    auto layerName = [&aLayers, &bLayers](const int i) -> const std::string& {
+      return (i < int(aLayers.size()) ? aLayers[i] : bLayers[i])->name();
+    };
+
+    for (const doc::frame_t frame : details.frames)
+      std::cout << "frame " << frame << "\n";
+    for (const int layer : details.layers)
+      std::cout << "layer " << layer << " \"" << layerName(layer) << "\"\n";
+    for (const auto& cel : details.cels) {
+      std::cout << "cel " << cel.layer << " \"" << layerName(cel.layer) << "\" " << cel.frame
+                << " " << cel.bounds.x << "," << cel.bounds.y << "," << cel.bounds.w << ","
+                << cel.bounds.h << "\n";
+    }
+  }
+
+  other->close();
+  return diff.anything;
+}
+
 void DefaultCliDelegate::exportFiles(Context* ctx, DocExporter& exporter)
 {
   LOG("APP: Exporting sheet...\n");
@@ -0,0 +1,161 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/cli/export_cache.h"
+
+#include "base/convert_to.h"
+#include "base/fs.h"
+#include "base/fstream_path.h"
+#include "base/sha1.h"
+#include "ver/info.h"
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+namespace app {
+
+namespace {
+
+// First line of the manifest file (change the version number if the
+// format of the manifest changes).
+const char* kManifestHeader = "aseprite-export-cache 1";
+
+std::string file_hash(const std::string& filename)
+{
+  return base::convert_to<std::string>(base::Sha1::calculateFromFile(filename));
+}
+
+void copy_file_content(const std::string& src, const std::string& dst)
+{
+  const std::string dir = base::get_file_path(dst);
+  if (!dir.empty() && !base::is_directory(dir))
+    base::make_all_directories(dir);
+
+  const auto buf = base::read_file_content(src);
+  base::write_file_content(dst, buf.data(), buf.size());
+}
+
+} // anonymous namespace
+
+ExportCache::ExportCache(const std::string& cacheDir, const std::string& key)
+  : m_dir(base::join_path(cacheDir, key))
+{
+}
+
+// static
+std::string ExportCache::makeKey(const std::string& description)
+{
+  return base::convert_to<std::string>(
+    base::Sha1::calculateFromString(std::string(get_app_version()) + "\n" + description));
+}
+
+void ExportCache::addInput(const std::string& filename)
+{
+  if (!filename.empty() &&
+      std::find(m_inputs.begin(), m_inputs.end(), filename) == m_inputs.end())
+    m_inputs.push_back(filename);
+}
+
+void ExportCache::addOutput(const std::string& filename)
+{
+  if (!filename.empty() &&
+      std::find(m_outputs.begin(), m_outputs.end(), filename) == m_outputs.end())
+    m_outputs.push_back(filename);
+}
+
+// The manifest contains lines with "input <sha1> <filename>" and
+// "output <id> <filename>", where the "id" is the name of the file
+// inside the entry directory with the content of the output file.
+bool ExportCache::restore()
+{
+  std::ifstream f(FSTREAM_PATH(manifestFilename()));
+  std::string line;
+  if (!f || !std::getline(f, line) || line != kManifestHeader)
+    return false;
+
+  // Pairs of cached file -> output filename
+  std::vector<std::pair<std::string, std::string>> outputs;
+
+  while (std::getline(f, line)) {
+    const auto i = line.find(' ');
+    const auto j = (i != std::string::npos ? line.find(' ', i + 1) : std::string::npos);
+    if (j == std::string::npos)
+      return false;
+
+    const std::string type = line.substr(0, i);
+    const std::string id = line.substr(i + 1, j - i - 1);
+    const std::string filename = line.substr(j + 1);
+
+    if (type == "input") {
+      if (!base::is_file(filename) || file_hash(filename) != id)
+        return false;
+    }
+    else if (type == "output") {
+      const std::string cachedFn = base::join_path(m_dir, id);
+      if (!base::is_file(cachedFn))
+        return false;
+      outputs.push_back(std::make_pair(cachedFn, filename));
+    }
+    else
+      return false;
+  }
+
+  if (outputs.empty())
+    return false;
+
+  for (const auto& output : outputs)
+    copy_file_content(output.first, output.second);
+  return true;
+}
+
+void ExportCache::store()
+{
+  if (!base::is_directory(m_dir))
+    base::make_all_directories(m_dir);
+
+  // Remove the old manifest first so an interrupted store() cannot
+  // leave a manifest pointing to other files.
+  const std::string manifestFn = manifestFilename();
+  if (base::is_file(manifestFn))
+    base::delete_file(manifestFn);
+
+  std::string manifest = kManifestHeader;
+  manifest.push_back('\n');
+
+  for (const auto& fn : m_inputs) {
+    if (!base::is_file(fn))
+      return;
+    manifest += "input " + file_hash(fn) + " " + fn + "\n";
+  }
+
+  int id = 0;
+  for (const auto& fn : m_outputs) {
+    if (!base::is_file(fn))
+      continue;
+
+    const std::string idStr = base::convert_to<std::string>(id++);
+    copy_file_content(fn, base::join_path(m_dir, idStr));
+    manifest += "output " + idStr + " " + fn + "\n";
+  }
+
+  // Nothing to cache
+  if (id == 0)
+    return;
+
+  base::write_file_content(manifestFn, (const uint8_t*)manifest.c_str(), manifest.size());
+}
+
+std::string ExportCache::manifestFilename() const
+{
+  return base::join_path(m_dir, "manifest");
+}
+
+} // namespace app
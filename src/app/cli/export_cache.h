@@ -0,0 +1,57 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_CLI_EXPORT_CACHE_H_INCLUDED
+#define APP_CLI_EXPORT_CACHE_H_INCLUDED
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace app {
+
+// Persistent cache of the files generated by the CLI (--cache-dir).
+// Each entry is a directory named with the key of the export (a
+// hash of the program version and the export options), and contains
+// a copy of the generated files and the hashes of all the input
+// files. An entry can be restored only if all its input files are
+// unchanged.
+class ExportCache {
+public:
+  ExportCache(const std::string& cacheDir, const std::string& key);
+
+  // Returns the key for an export described by the given text (e.g.
+  // all the CLI arguments). The key depends on the program version
+  // too.
+  static std::string makeKey(const std::string& description);
+
+  // Input files that were used to generate the output.
+  void addInput(const std::string& filename);
+
+  // Output file generated by the export (it's ignored if it doesn't
+  // exist when store() is called).
+  void addOutput(const std::string& filename);
+
+  // Copies the output files of a previous export with the same key.
+  // Returns false if there is no entry for this key or if some input
+  // file has changed.
+  bool restore();
+
+  // Saves a copy of the output files and the hashes of the input
+  // files (replacing the previous entry with the same key).
+  void store();
+
+private:
+  std::string manifestFilename() const;
+
+  std::string m_dir;
+  std::vector<std::string> m_inputs;
+  std::vector<std::string> m_outputs;
+};
+
+} // namespace app
+
+#endif
@@ -0,0 +1,120 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#include "tests/app_test.h"
+
+#include "app/cli/export_cache.h"
+#include "base/fs.h"
+
+#include <string>
+
+using namespace app;
+
+namespace {
+
+class ExportCacheTest : public ::testing::Test {
+protected:
+  void SetUp() override
+  {
+    m_dir = base::join_path(base::get_temp_path(), "aseprite-export-cache-tests");
+    if (base::is_directory(m_dir))
+      removeAll(m_dir);
+    base::make_all_directories(m_dir);
+    m_cacheDir = base::join_path(m_dir, "cache");
+  }
+
+  void TearDown() override { removeAll(m_dir); }
+
+  std::string path(const std::string& fn) const { return base::join_path(m_dir, fn); }
+
+  void write(const std::string& fn, const std::string& content)
+  {
+    base::write_file_content(path(fn), (const uint8_t*)content.c_str(), content.size());
+  }
+
+  std::string read(const std::string& fn)
+  {
+    const auto buf = base::read_file_content(path(fn));
+    return std::string(buf.begin(), buf.end());
+  }
+
+  // Stores in the cache an export of "input.ase" to "output.png"
+  void storeExport(const std::string& key)
+  {
+    ExportCache cache(m_cacheDir, key);
+    cache.addInput(path("input.ase"));
+    cache.addOutput(path("output.png"));
+    cache.store();
+  }
+
+  static void removeAll(const std::string& dir)
+  {
+    for (const auto& fn : base::list_files(dir)) {
+      const std::string full = base::join_path(dir, fn);
+      if (base::is_directory(full))
+        removeAll(full);
+      else
+        base::delete_file(full);
+    }
+    base::remove_directory(dir);
+  }
+
+  std::string m_dir;
+  std::string m_cacheDir;
+};
+
+} // anonymous namespace
+
+TEST_F(ExportCacheTest, MakeKey)
+{
+  EXPECT_EQ(ExportCache::makeKey("a"), ExportCache::makeKey("a"));
+  EXPECT_NE(ExportCache::makeKey("a"), ExportCache::makeKey("b"));
+}
+
+TEST_F(ExportCacheTest, RestoreOutputs)
+{
+  const std::string key = ExportCache::makeKey("input.ase --save-as output.png");
+  write("input.ase", "sprite");
+  write("output.png", "image");
+  storeExport(key);
+
+  base::delete_file(path("output.png"));
+  ExportCache cache(m_cacheDir, key);
+  EXPECT_TRUE(cache.restore());
+  EXPECT_EQ("image", read("output.png"));
+}
+
+TEST_F(ExportCacheTest, ChangedInput)
+{
+  const std::string key = ExportCache::makeKey("input.ase --save-as output.png");
+  write("input.ase", "sprite");
+  write("output.png", "image");
+  storeExport(key);
+
+  write("input.ase", "modified sprite");
+  ExportCache cache(m_cacheDir, key);
+  EXPECT_FALSE(cache.restore());
+}
+
+TEST_F(ExportCacheTest, MissingEntry)
+{
+  write("input.ase", "sprite");
+  write("output.png", "image");
+  storeExport(ExportCache::makeKey("input.ase --save-as output.png"));
+
+  ExportCache cache(m_cacheDir, ExportCache::makeKey("input.ase --save-as other.png"));
+  EXPECT_FALSE(cache.restore());
+}
+
+TEST_F(ExportCacheTest, NothingToStore)
+{
+  const std::string key = ExportCache::makeKey("input.ase --save-as output.png");
+  write("input.ase", "sprite");
+  storeExport(key); // output.png doesn't exist
+
+  ExportCache cache(m_cacheDir, key);
+  EXPECT_FALSE(cache.restore());
+}
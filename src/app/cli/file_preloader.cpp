@@ -0,0 +1,171 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/cli/file_preloader.h"
+
+#include "app/console.h"
+#include "app/context.h"
+#include "app/doc.h"
+#include "app/file/file.h"
+#include "app/file/file_format.h"
+#include "app/file/file_formats_manager.h"
+#include "dio/detect_format.h"
+
+#include <algorithm>
+
+namespace app {
+
+struct FilePreloader::Item {
+  std::string filename;
+  int flags;
+  // Each file is loaded with its own context (the document is moved
+  // to the CliProcessor context when it's opened).
+  std::unique_ptr<Context> ctx;
+  std::unique_ptr<FileOp> fop;
+  bool started = false;
+  bool done = false;
+};
+
+FilePreloader::FilePreloader(int jobs)
+  : m_jobs(std::max(1, jobs))
+  , m_tasks(TaskKind::Blocking, m_jobs)
+{
+}
+
+FilePreloader::~FilePreloader()
+{
+  for (auto& item : m_items)
+    discardItem(item.get());
+}
+
+// static
+bool FilePreloader::canPreload(const std::string& filename)
+{
+  FileFormat* format = FileFormatsManager::instance()->getFileFormat(dio::detect_format(filename));
+  return (format && format->support(FILE_SUPPORT_LOAD) &&
+          !format->support(FILE_SUPPORT_SEQUENCES));
+}
+
+void FilePreloader::add(const std::string& filename, int flags)
+{
+  auto item = std::make_unique<Item>();
+  item->filename = filename;
+  item->flags = flags;
+  m_items.push_back(std::move(item));
+}
+
+void FilePreloader::start()
+{
+  startNextItems();
+}
+
+bool FilePreloader::open(Context* ctx, const std::string& filename, int flags)
+{
+  auto it = std::find_if(m_items.begin(), m_items.end(), [&filename](const auto& item) {
+    return item->filename == filename;
+  });
+  if (it == m_items.end())
+    return false;
+
+  // Discard previous files that weren't opened (e.g. they were
+  // loaded as part of a sequence).
+  for (auto jt = m_items.begin(); jt != it; ++jt)
+    discardItem(jt->get());
+
+  std::unique_ptr<Item> item = std::move(*it);
+  m_items.erase(m_items.begin(), it + 1);
+
+  if (!item->fop || item->flags != flags) {
+    discardItem(item.get());
+    startNextItems();
+    return false;
+  }
+
+  waitItem(item.get());
+  startNextItems();
+
+  // Same post-load process as OpenFileCommand (without the UI parts)
+  FileOp* fop = item->fop.get();
+  fop->postLoad();
+
+  if (fop->hasError() && !fop->isStop())
+    Console().printf(fop->error().c_str());
+
+  if (Doc* doc = fop->releaseDocument())
+    doc->setContext(ctx);
+  return true;
+}
+
+void FilePreloader::startNextItems()
+{
+  // Keep twice the number of jobs loading/loaded so the threads
+  // don't wait for the CliProcessor (and we don't keep too many
+  // decoded files in memory).
+  const int n = std::min<int>(2 * m_jobs, m_items.size());
+
+  for (int i = 0; i < n; ++i) {
+    Item* item = m_items[i].get();
+    if (item->started)
+      continue;
+
+    // The FileOp is created in the main thread because it reads the
+    // preferences.
+    item->started = true;
+    item->ctx = std::make_unique<Context>();
+    item->fop.reset(
+      FileOp::createLoadDocumentOperation(item->ctx.get(), item->filename, item->flags));
+
+    // Files with errors are opened as usual (to show the same errors).
+    if (!item->fop || item->fop->hasError()) {
+      item->fop.reset();
+      item->done = true;
+      continue;
+    }
+
+    m_tasks.run([this, item] {
+      FileOp* fop = item->fop.get();
+      try {
+        fop->operate(nullptr);
+      }
+      catch (const std::exception& e) {
+        fop->setError("Error loading file:\n%s", e.what());
+      }
+
+      if (fop->isStop() && fop->document())
+        delete fop->releaseDocument();
+
+      fop->done();
+
+      const std::lock_guard lock(m_mutex);
+      item->done = true;
+      m_cv.notify_all();
+    });
+  }
+}
+
+void FilePreloader::waitItem(Item* item)
+{
+  std::unique_lock lock(m_mutex);
+  m_cv.wait(lock, [item] { return item->done; });
+}
+
+void FilePreloader::discardItem(Item* item)
+{
+  if (!item->fop)
+    return;
+
+  item->fop->stop();
+  waitItem(item);
+
+  delete item->fop->releaseDocument();
+  item->fop.reset();
+}
+
+} // namespace app
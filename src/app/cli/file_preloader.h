@@ -0,0 +1,73 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_CLI_FILE_PRELOADER_H_INCLUDED
+#define APP_CLI_FILE_PRELOADER_H_INCLUDED
+#pragma once
+
+#include "app/task_scheduler.h"
+#include "base/disable_copying.h"
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace app {
+
+class Context;
+
+// Loads the input files of the CLI in background threads (--jobs N)
+// so the CliProcessor finds them already decoded when it reaches
+// them. Each file is decoded with its own Context, but
+// FileOp::postLoad() and all the rest of the processing (saving
+// files, --data, --list-*, etc.) are still done by the CliProcessor
+// in the main thread, in the same order as the command line.
+class FilePreloader {
+public:
+  explicit FilePreloader(int jobs);
+  ~FilePreloader();
+
+  // Returns true if the given file can be preloaded. Files of
+  // formats that can be loaded as a sequence of images cannot be
+  // preloaded, because the sequence depends on other files given in
+  // the command line.
+  static bool canPreload(const std::string& filename);
+
+  // Adds a file to be preloaded with the given FILE_LOAD_* flags.
+  // Files must be added in the same order they will be opened.
+  void add(const std::string& filename, int flags);
+
+  // Starts loading the first files in background.
+  void start();
+
+  // Adds the preloaded document of the given file to the context
+  // (waiting until it's completely loaded), as OpenFileCommand does.
+  // Returns false if the file wasn't preloaded with the same flags
+  // (so it must be opened as usual). The files added before this
+  // one weren't requested, so they are discarded.
+  bool open(Context* ctx, const std::string& filename, int flags);
+
+private:
+  struct Item;
+
+  void startNextItems();
+  void waitItem(Item* item);
+  void discardItem(Item* item);
+
+  int m_jobs;
+  SerialTaskGroup m_tasks;
+  std::deque<std::unique_ptr<Item>> m_items;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+
+  DISABLE_COPYING(FilePreloader);
+};
+
+} // namespace app
+
+#endif
@@ -0,0 +1,255 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/cli/file_watcher.h"
+
+#include "base/fs.h"
+#include "base/string.h"
+#include "base/thread.h"
+#include "base/time.h"
+
+#if LAF_WINDOWS
+  #include <windows.h>
+#elif LAF_LINUX
+  #include <poll.h>
+  #include <sys/inotify.h>
+  #include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <map>
+#include <vector>
+
+namespace app {
+
+namespace {
+
+// Set from the signal handler to stop the --watch loop
+std::atomic<bool> g_stop(false);
+
+using SignalHandler = void (*)(int);
+SignalHandler g_oldSigint = SIG_DFL;
+SignalHandler g_oldSigterm = SIG_DFL;
+
+void on_stop_signal(int sig)
+{
+  g_stop = true;
+
+  // A second signal terminates the process (e.g. if it's stuck in a
+  // long export)
+  std::signal(sig, SIG_DFL);
+}
+
+std::string file_dir(const std::string& filename)
+{
+  std::string dir = base::get_file_path(filename);
+  if (dir.empty())
+    dir = ".";
+  return dir;
+}
+
+} // anonymous namespace
+
+#if LAF_WINDOWS
+
+class FileWatcher::Impl {
+public:
+  ~Impl() { close(); }
+
+  bool isWatching() const { return !m_handles.empty(); }
+
+  void watch(const std::set<std::string>& filenames)
+  {
+    close();
+
+    std::set<std::string> dirs;
+    for (const auto& fn : filenames)
+      dirs.insert(file_dir(fn));
+    if (dirs.size() > MAXIMUM_WAIT_OBJECTS)
+      return;
+
+    for (const auto& dir : dirs) {
+      HANDLE handle = FindFirstChangeNotificationW(base::from_utf8(dir).c_str(),
+                                                   FALSE,
+                                                   FILE_NOTIFY_CHANGE_FILE_NAME |
+                                                     FILE_NOTIFY_CHANGE_SIZE |
+                                                     FILE_NOTIFY_CHANGE_LAST_WRITE);
+      if (handle == INVALID_HANDLE_VALUE) {
+        close();
+        return;
+      }
+      m_handles.push_back(handle);
+    }
+  }
+
+  bool waitForChange(const int msecs)
+  {
+    const DWORD n = DWORD(m_handles.size());
+    const DWORD i = WaitForMultipleObjects(n, m_handles.data(), FALSE, msecs);
+    if (i >= WAIT_OBJECT_0 && i < WAIT_OBJECT_0 + n) {
+      FindNextChangeNotification(m_handles[i - WAIT_OBJECT_0]);
+      return true;
+    }
+    return false;
+  }
+
+private:
+  void close()
+  {
+    for (HANDLE handle : m_handles)
+      FindCloseChangeNotification(handle);
+    m_handles.clear();
+  }
+
+  std::vector<HANDLE> m_handles;
+};
+
+#elif LAF_LINUX
+
+class FileWatcher::Impl {
+public:
+  ~Impl() { close(); }
+
+  bool isWatching() const { return m_fd >= 0; }
+
+  void watch(const std::set<std::string>& filenames)
+  {
+    close();
+
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0)
+      return;
+
+    // Directories are watched instead of files because editors
+    // usually replace the whole file when it's saved.
+    for (const auto& fn : filenames) {
+      const int wd = inotify_add_watch(m_fd,
+                                       file_dir(fn).c_str(),
+                                       IN_CLOSE_WRITE | IN_MODIFY | IN_ATTRIB | IN_CREATE |
+                                         IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+      if (wd < 0) {
+        close();
+        return;
+      }
+      m_names[wd].insert(base::get_file_name(fn));
+    }
+  }
+
+  bool waitForChange(const int msecs)
+  {
+    pollfd pfd = { m_fd, POLLIN, 0 };
+    // Returns -1 with EINTR if a signal is received
+    if (poll(&pfd, 1, msecs) <= 0)
+      return false;
+
+    bool changed = false;
+    alignas(inotify_event) char buf[4096];
+    ssize_t n;
+    while ((n = read(m_fd, buf, sizeof(buf))) > 0) {
+      for (const char* p = buf; p < buf + n;) {
+        const auto* event = (const inotify_event*)p;
+        if (event->mask & (IN_Q_OVERFLOW | IN_IGNORED)) {
+          changed = true;
+        }
+        else if (event->len > 0) {
+          auto it = m_names.find(event->wd);
+          if (it != m_names.end() && it->second.count(event->name))
+            changed = true;
+        }
+        p += sizeof(inotify_event) + event->len;
+      }
+    }
+    return changed;
+  }
+
+private:
+  void close()
+  {
+    if (m_fd >= 0) {
+      ::close(m_fd);
+      m_fd = -1;
+    }
+    m_names.clear();
+  }
+
+  int m_fd = -1;
+  // Watched file names in each directory (watch descriptor)
+  std::map<int, std::set<std::string>> m_names;
+};
+
+#else
+
+// Without change notifications the files are checked periodically
+class FileWatcher::Impl {
+public:
+  bool isWatching() const { return false; }
+  void watch(const std::set<std::string>&) {}
+  bool waitForChange(int) { return false; }
+};
+
+#endif
+
+FileWatcher::FileWatcher() : m_impl(std::make_unique<Impl>())
+{
+  g_stop = false;
+  g_oldSigint = std::signal(SIGINT, on_stop_signal);
+  g_oldSigterm = std::signal(SIGTERM, on_stop_signal);
+}
+
+FileWatcher::~FileWatcher()
+{
+  std::signal(SIGINT, g_oldSigint);
+  std::signal(SIGTERM, g_oldSigterm);
+}
+
+void FileWatcher::watch(const std::set<std::string>& filenames)
+{
+  m_impl->watch(filenames);
+}
+
+FileWatcher::Result FileWatcher::wait(const double timeout)
+{
+  // Maximum time blocked without checking the stop flag (the signal
+  // can arrive just before a blocking call, or in other thread on
+  // Windows)
+  constexpr int kMaxBlockMsecs = 500;
+
+  const base::tick_t start = base::current_tick();
+  for (;;) {
+    if (g_stop)
+      return Result::Stopped;
+
+    int msecs = kMaxBlockMsecs;
+    if (timeout >= 0.0) {
+      const int remaining = int(timeout * 1000.0) - int(base::current_tick() - start);
+      if (remaining <= 0)
+        return Result::Timeout;
+      msecs = std::min(msecs, remaining);
+    }
+
+    if (!m_impl->isWatching()) {
+      base::this_thread::sleep_for(msecs / 1000.0);
+      // The caller must check the files
+      if (timeout < 0.0)
+        return Result::Changed;
+    }
+    else if (m_impl->waitForChange(msecs))
+      return Result::Changed;
+  }
+}
+
+bool FileWatcher::stopped() const
+{
+  return g_stop;
+}
+
+} // namespace app
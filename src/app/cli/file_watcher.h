@@ -0,0 +1,51 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_CLI_FILE_WATCHER_H_INCLUDED
+#define APP_CLI_FILE_WATCHER_H_INCLUDED
+#pragma once
+
+#include <memory>
+#include <set>
+#include <string>
+
+namespace app {
+
+// Waits for changes in a set of files (--watch). It uses the change
+// notifications of the OS for the directories of the files (Linux
+// and Windows), or checks the files periodically on other platforms.
+// While a FileWatcher exists, Ctrl+C (SIGINT) or SIGTERM stop the
+// waiting instead of killing the process (a second signal kills it).
+class FileWatcher {
+public:
+  enum class Result {
+    Changed,  // Some watched file (or its directory) was modified
+    Timeout,  // Nothing changed in the given time
+    Stopped,  // The process was interrupted
+  };
+
+  FileWatcher();
+  ~FileWatcher();
+
+  // Replaces the set of watched files.
+  void watch(const std::set<std::string>& filenames);
+
+  // Waits until some watched file changes, the process is
+  // interrupted, or the timeout (in seconds, < 0 means forever)
+  // expires. It can return Changed for modifications of other files
+  // in the same directories, so the caller must check the files.
+  Result wait(double timeout = -1.0);
+
+  bool stopped() const;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> m_impl;
+};
+
+} // namespace app
+
+#endif
@@ -0,0 +1,61 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#include "tests/app_test.h"
+
+#include "app/cli/file_watcher.h"
+#include "base/fs.h"
+
+#include <string>
+
+using namespace app;
+
+namespace {
+
+class FileWatcherTest : public ::testing::Test {
+protected:
+  void SetUp() override
+  {
+    m_dir = base::join_path(base::get_temp_path(), "aseprite-file-watcher-tests");
+    if (!base::is_directory(m_dir))
+      base::make_all_directories(m_dir);
+    m_file = base::join_path(m_dir, "input.ase");
+    write("a");
+  }
+
+  void TearDown() override
+  {
+    if (base::is_file(m_file))
+      base::delete_file(m_file);
+    base::remove_directory(m_dir);
+  }
+
+  void write(const std::string& content)
+  {
+    base::write_file_content(m_file, (const uint8_t*)content.c_str(), content.size());
+  }
+
+  std::string m_dir;
+  std::string m_file;
+};
+
+} // anonymous namespace
+
+TEST_F(FileWatcherTest, Timeout)
+{
+  FileWatcher watcher;
+  watcher.watch({ m_file });
+  EXPECT_EQ(FileWatcher::Result::Timeout, watcher.wait(0.1));
+  EXPECT_FALSE(watcher.stopped());
+}
+
+TEST_F(FileWatcherTest, Changed)
+{
+  FileWatcher watcher;
+  watcher.watch({ m_file });
+  write("b");
+  EXPECT_EQ(FileWatcher::Result::Changed, watcher.wait());
+}
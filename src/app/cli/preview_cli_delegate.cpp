@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2022  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2016-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -109,6 +109,10 @@ void PreviewCliDelegate::saveFile(Context* ctx, const CliOpenFile& cof)
     std::cout << "  - Ignore empty frames\n";
   }
 
+  if (cof.incremental) {
+    std::cout << "  - Incremental\n";
+  }
+
   std::cout << "  - Size: " << cof.document->sprite()->width() << "x"
             << cof.document->sprite()->height() << "\n";
 
@@ -172,6 +176,14 @@ void PreviewCliDelegate::loadPalette(Context* ctx, const std::string& filename)
             << "  - Palette: '" << filename << "'\n";
 }
 
+bool PreviewCliDelegate::diffFile(Context* ctx, Doc* doc, const std::string& filename)
+{
+  std::cout << "- Compare with file:\n"
+            << "  - Sprite: '" << doc->filename() << "'\n"
+            << "  - File: '" << filename << "'\n";
+  return false;
+}
+
 void PreviewCliDelegate::exportFiles(Context* ctx, DocExporter& exporter)
 {
   std::string type = "None";
@@ -188,6 +200,13 @@ void PreviewCliDelegate::exportFiles(Context* ctx, DocExporter& exporter)
             << "  - Type: " << type << "\n"
             << "  - Size: " << size.w << "x" << size.h << "\n";
 
+  if (exporter.spriteSheetType() == SpriteSheetType::Packed) {
+    std::cout << "  - Pack algorithm: "
+              << (exporter.packAlgorithm() == SpriteSheetPackAlgorithm::MaxRects ? "MaxRects" :
+                                                                                   "Best Fit")
+              << "\n";
+  }
+
   if (!exporter.textureFilename().empty()) {
     std::cout << "  - Save texture file: '" << exporter.textureFilename() << "'\n";
   }
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2023  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -9,9 +9,16 @@
 #endif
 
 #include "app/closed_docs.h"
+#include "app/crash/read_document.h"
+#include "app/crash/write_document.h"
 #include "app/doc.h"
 #include "app/pref/preferences.h"
+#include "base/convert_to.h"
+#include "base/fs.h"
+#include "base/log.h"
+#include "base/process.h"
 #include "base/thread.h"
+#include "doc/cancel_io.h"
 
 #include <algorithm>
 #include <limits>
@@ -20,7 +27,39 @@
 
 namespace app {
 
-ClosedDocs::ClosedDocs(const Preferences& pref) : m_done(false)
+namespace {
+
+// Cancels the compaction of a doc when the app is closed or when the
+// doc is being reopened.
+class CancelCompaction : public doc::CancelIO {
+public:
+  CancelCompaction(const std::atomic<bool>& done, const std::atomic<bool>& cancel)
+    : m_done(done)
+    , m_cancel(cancel)
+  {
+  }
+
+  bool isCanceled() override { return m_done || m_cancel; }
+
+private:
+  const std::atomic<bool>& m_done;
+  const std::atomic<bool>& m_cancel;
+};
+
+std::string compacted_doc_dir(const Doc* doc)
+{
+  return base::join_path(base::get_temp_path(),
+                         "aseprite-closed-" +
+                           base::convert_to<std::string>(int(base::get_current_process_id())) +
+                           "-" + base::convert_to<std::string>(int(doc->id())));
+}
+
+} // anonymous namespace
+
+ClosedDocs::ClosedDocs(const Preferences& pref)
+  : m_done(false)
+  , m_compactingDoc(nullptr)
+  , m_cancelCompaction(false)
 {
   if (pref.general.dataRecovery())
     m_dataRecoveryPeriodMSecs = int(1000.0 * 60.0 * pref.general.dataRecoveryPeriod());
@@ -32,11 +71,22 @@ ClosedDocs::ClosedDocs(const Preferences& pref) : m_done(false)
   else
     m_keepClosedDocAliveForMSecs = 0;
 
+  // Compacting docs is useful only if they are kept in memory for
+  // more time than the compaction period
+  m_compactClosedDocAfterMSecs = 0;
+  if (pref.general.compactClosedSprite()) {
+    base::tick_t msecs = base::tick_t(1000.0 * 60.0 * pref.general.compactClosedSpriteAfter());
+    if (msecs < m_keepClosedDocAliveForMSecs)
+      m_compactClosedDocAfterMSecs = std::max<base::tick_t>(1, msecs);
+  }
+
   CLOSEDOC_TRACE("CLOSEDOC: Init",
                  "dataRecoveryPeriod",
                  m_dataRecoveryPeriodMSecs,
                  "keepClosedDocs",
-                 m_keepClosedDocAliveForMSecs);
+                 m_keepClosedDocAliveForMSecs,
+                 "compactClosedDocs",
+                 m_compactClosedDocAfterMSecs);
 }
 
 ClosedDocs::~ClosedDocs()
@@ -74,13 +124,13 @@ void ClosedDocs::addClosedDoc(Doc* doc)
   ASSERT(doc != nullptr);
   ASSERT(doc->context() == nullptr);
 
-  ClosedDoc closedDoc = { doc, base::current_tick() };
+  ClosedDoc closedDoc = { doc, std::string(), doc->isModified(), true, base::current_tick() };
 
   std::unique_lock<std::mutex> lock(m_mutex);
   m_docs.insert(m_docs.begin(), std::move(closedDoc));
 
   if (!m_thread.joinable())
-    m_thread = std::thread([this] { backgroundThread(); });
+    m_thread = BlockingTask([this] { backgroundThread(); });
   else
     m_cv.notify_one();
 }
@@ -88,14 +138,24 @@ void ClosedDocs::addClosedDoc(Doc* doc)
 Doc* ClosedDocs::reopenLastClosedDoc()
 {
   Doc* doc = nullptr;
+  std::string dir;
+  bool modified = false;
   {
     std::unique_lock<std::mutex> lock(m_mutex);
+    waitCompaction(lock);
     if (!m_docs.empty()) {
       doc = m_docs.front().doc;
+      dir = m_docs.front().dir;
+      modified = m_docs.front().modified;
       m_docs.erase(m_docs.begin());
     }
-    CLOSEDOC_TRACE(" -> ", doc);
+    CLOSEDOC_TRACE(" -> ", doc, dir);
   }
+
+  // Read the compacted doc without locking the list of closed docs
+  if (!doc && !dir.empty())
+    doc = restoreCompactedDoc(dir, modified);
+
   CLOSEDOC_TRACE("CLOSEDOC: Reopen last closed doc", doc);
   return doc;
 }
@@ -106,10 +166,15 @@ std::vector<Doc*> ClosedDocs::getAndRemoveAllClosedDocs()
   {
     std::unique_lock<std::mutex> lock(m_mutex);
     CLOSEDOC_TRACE("CLOSEDOC: Get and remove all closed", m_docs.size(), "docs");
-    for (const ClosedDoc& closedDoc : m_docs)
-      docs.push_back(closedDoc.doc);
-    m_docs.clear();
     m_done = true;
+    waitCompaction(lock);
+    for (const ClosedDoc& closedDoc : m_docs) {
+      if (closedDoc.doc)
+        docs.push_back(closedDoc.doc);
+      else
+        deleteCompactedDoc(closedDoc.dir);
+    }
+    m_docs.clear();
     m_cv.notify_one();
   }
   return docs;
@@ -125,6 +190,7 @@ void ClosedDocs::backgroundThread()
   while (!m_done) {
     base::tick_t now = base::current_tick();
     base::tick_t waitForMSecs = std::numeric_limits<base::tick_t>::max();
+    Doc* docToCompact = nullptr;
 
     for (auto it = m_docs.begin(); it != m_docs.end();) {
       const ClosedDoc& closedDoc = *it;
@@ -132,12 +198,12 @@ void ClosedDocs::backgroundThread()
 
       base::tick_t diff = now - closedDoc.timestamp;
       if (diff >= m_keepClosedDocAliveForMSecs) {
-        if ( // If we backup process is disabled
-          m_dataRecoveryPeriodMSecs == 0 ||
-          // Or this document doesn't need a backup (e.g. an unmodified document)
-          !doc->needsBackup() ||
-          // Or the document already has the backup done
-          doc->isFullyBackedUp()) {
+        if (!doc) {
+          CLOSEDOC_TRACE("CLOSEDOC: [BG] Delete compacted doc", closedDoc.dir);
+          deleteCompactedDoc(closedDoc.dir);
+          it = m_docs.erase(it);
+        }
+        else if (canDeleteDoc(doc)) {
           // Finally delete the document (this is the place where we
           // delete all documents created/loaded by the user)
           CLOSEDOC_TRACE("CLOSEDOC: [BG] Delete doc", doc);
@@ -150,11 +216,27 @@ void ClosedDocs::backgroundThread()
         }
       }
       else {
+        if (doc && closedDoc.canCompact && m_compactClosedDocAfterMSecs > 0) {
+          if (diff < m_compactClosedDocAfterMSecs)
+            waitForMSecs = std::min(waitForMSecs, m_compactClosedDocAfterMSecs - diff);
+          else if (!canDeleteDoc(doc))
+            waitForMSecs = std::min(waitForMSecs, m_dataRecoveryPeriodMSecs);
+          else if (!docToCompact)
+            docToCompact = doc;
+        }
+
         waitForMSecs = std::min(waitForMSecs, m_keepClosedDocAliveForMSecs - diff);
         ++it;
       }
     }
 
+    // Compact one doc at a time (the lock is released meanwhile) and
+    // check the list again
+    if (docToCompact) {
+      compactDoc(lock, docToCompact);
+      continue;
+    }
+
     if (waitForMSecs < std::numeric_limits<base::tick_t>::max()) {
       CLOSEDOC_TRACE("CLOSEDOC: [BG] Wait for", waitForMSecs, "milliseconds");
 
@@ -172,4 +254,106 @@ void ClosedDocs::backgroundThread()
   CLOSEDOC_TRACE("CLOSEDOC: [BG] Background thread end");
 }
 
+bool ClosedDocs::canDeleteDoc(const Doc* doc) const
+{
+  return ( // If we backup process is disabled
+    m_dataRecoveryPeriodMSecs == 0 ||
+    // Or this document doesn't need a backup (e.g. an unmodified document)
+    !doc->needsBackup() ||
+    // Or the document already has the backup done
+    doc->isFullyBackedUp());
+}
+
+// Executed from the backgroundThread() with the lock acquired (it's
+// released while the doc is written).
+void ClosedDocs::compactDoc(std::unique_lock<std::mutex>& lock, Doc* doc)
+{
+  CLOSEDOC_TRACE("CLOSEDOC: [BG] Compact doc", doc);
+
+  const std::string dir = compacted_doc_dir(doc);
+  m_compactingDoc = doc;
+  m_cancelCompaction = false;
+  lock.unlock();
+
+  bool ok = false;
+  try {
+    deleteCompactedDoc(dir);
+    base::make_directory(dir);
+
+    CancelCompaction cancel(m_done, m_cancelCompaction);
+    ok = crash::write_document_snapshot(dir, doc, &cancel);
+  }
+  catch (const std::exception& ex) {
+    LOG(ERROR, "CLOSEDOC: Error compacting document: %s\n", ex.what());
+  }
+  if (!ok)
+    deleteCompactedDoc(dir);
+
+  lock.lock();
+  m_compactingDoc = nullptr;
+
+  // The doc must be in the list as nobody can reopen it while it's
+  // being compacted
+  auto it = std::find_if(m_docs.begin(), m_docs.end(), [doc](const ClosedDoc& closedDoc) {
+    return closedDoc.doc == doc;
+  });
+  ASSERT(it != m_docs.end());
+  if (it != m_docs.end()) {
+    if (ok) {
+      it->doc = nullptr;
+      it->dir = dir;
+      delete doc;
+    }
+    // Don't try again if it was an error (we don't need to try
+    // again if it was canceled because the doc is being reopened or
+    // the app is being closed)
+    else
+      it->canCompact = false;
+  }
+  m_cv.notify_all();
+}
+
+// Waits the background thread to finish the compaction of a doc (the
+// compaction is canceled).
+void ClosedDocs::waitCompaction(std::unique_lock<std::mutex>& lock)
+{
+  if (m_compactingDoc) {
+    m_cancelCompaction = true;
+    m_cv.wait(lock, [this] { return m_compactingDoc == nullptr; });
+  }
+}
+
+// static
+Doc* ClosedDocs::restoreCompactedDoc(const std::string& dir, const bool modified)
+{
+  Doc* doc = nullptr;
+  try {
+    doc = crash::read_document(dir, nullptr);
+    // read_document() always returns a modified doc
+    if (doc && !modified)
+      doc->markAsSaved();
+  }
+  catch (const std::exception& ex) {
+    LOG(ERROR, "CLOSEDOC: Error reading compacted document: %s\n", ex.what());
+  }
+  deleteCompactedDoc(dir);
+  return doc;
+}
+
+// static
+void ClosedDocs::deleteCompactedDoc(const std::string& dir)
+{
+  try {
+    if (!base::is_directory(dir))
+      return;
+
+    for (const auto& fn : base::list_files(dir))
+      base::delete_file(base::join_path(dir, fn));
+    base::remove_directory(dir);
+  }
+  catch (const std::exception& ex) {
+    LOG(ERROR, "CLOSEDOC: Error deleting compacted document: %s\n", ex.what());
+  }
+}
+
 } // namespace app
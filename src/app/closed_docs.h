@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2020  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -8,12 +8,13 @@
 #define APP_CLOSED_DOCS_H_INCLUDED
 #pragma once
 
+#include "app/task_scheduler.h"
 #include "base/time.h"
 
 #include <atomic>
 #include <condition_variable>
 #include <mutex>
-#include <thread>
+#include <string>
 #include <vector>
 
 namespace app {
@@ -29,6 +30,11 @@ class Preferences;
 //   garbage collector).
 // * If the document was not restore, we delete it from memory, if
 //   the document was restore, we remove it from the m_docs.
+// * After a shorter period of time, the document is compacted: it's
+//   written in a temporary directory (with the same format used by
+//   the data recovery) and deleted from memory. Reopening a
+//   compacted document reads it from that directory (the undo
+//   history is lost in this case).
 class ClosedDocs {
 public:
   ClosedDocs(const Preferences& pref);
@@ -43,20 +49,39 @@ public:
   std::vector<Doc*> getAndRemoveAllClosedDocs();
 
 private:
-  void backgroundThread();
-
   struct ClosedDoc {
     Doc* doc;
+    // Directory where the doc was written if it was compacted (in
+    // this case "doc" is nullptr).
+    std::string dir;
+    // True if the doc was modified when it was compacted (a doc read
+    // from the directory is always a modified doc).
+    bool modified;
+    // False if we couldn't compact the doc (so we don't try again).
+    bool canCompact;
     base::tick_t timestamp;
   };
 
+  void backgroundThread();
+  bool canDeleteDoc(const Doc* doc) const;
+  void compactDoc(std::unique_lock<std::mutex>& lock, Doc* doc);
+  void waitCompaction(std::unique_lock<std::mutex>& lock);
+  static Doc* restoreCompactedDoc(const std::string& dir, const bool modified);
+  static void deleteCompactedDoc(const std::string& dir);
+
   std::atomic<bool> m_done;
   base::tick_t m_dataRecoveryPeriodMSecs;
   base::tick_t m_keepClosedDocAliveForMSecs;
+  base::tick_t m_compactClosedDocAfterMSecs;
   std::vector<ClosedDoc> m_docs;
   std::mutex m_mutex;
   std::condition_variable m_cv;
-  std::thread m_thread;
+  BlockingTask m_thread;
+
+  // Doc being compacted in the background thread (it's still in
+  // m_docs and it cannot be reopened until the compaction finishes).
+  Doc* m_compactingDoc;
+  std::atomic<bool> m_cancelCompaction;
 };
 
 } // namespace app
@@ -1,4 +1,5 @@
 // Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
 // Copyright (C) 2001-2017  David Capello
 //
 // This program is distributed under the terms of
@@ -89,6 +90,11 @@ size_t Cmd::memSize() const
   return onMemSize();
 }
 
+size_t Cmd::spillToDisk()
+{
+  return onSpillToDisk();
+}
+
 void Cmd::onExecute()
 {
   // Do nothing
@@ -120,4 +126,10 @@ size_t Cmd::onMemSize() const
   return sizeof(*this);
 }
 
+size_t Cmd::onSpillToDisk()
+{
+  // By default commands don't have data to move to disk
+  return 0;
+}
+
 } // namespace app
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2023  Igara Studio SA
+// Copyright (C) 2023-2026  Igara Studio SA
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -33,6 +33,12 @@ public:
   std::string label() const;
   size_t memSize() const;
 
+  // Moves the undo data of this command to disk (in a background
+  // thread) to release memory, it's restored when it's needed again
+  // (e.g. to undo the command). Returns the number of bytes that will
+  // be released.
+  size_t spillToDisk();
+
   Context* context() const { return m_ctx; }
 
 protected:
@@ -42,6 +48,7 @@ protected:
   virtual void onFireNotifications();
   virtual std::string onLabel() const;
   virtual size_t onMemSize() const;
+  virtual size_t onSpillToDisk();
 
 private:
   // TODO I think we could just remove this field (but we'll need to
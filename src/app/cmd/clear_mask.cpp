@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -96,12 +96,14 @@ void ClearMask::clear()
   Doc* doc = static_cast<Doc*>(cel->document());
   Mask* mask = doc->mask();
 
+  Image* image = cel->image();
   Grid grid = cel->grid();
-  doc::algorithm::fill_selection(cel->image(),
+  doc::algorithm::fill_selection(image,
                                  cel->bounds(),
                                  mask,
                                  m_bgcolor,
-                                 (cel->image()->isTilemap() ? &grid : nullptr));
+                                 (image->isTilemap() ? &grid : nullptr));
+  image->incrementVersion();
 }
 
 void ClearMask::restore()
@@ -109,8 +111,9 @@ void ClearMask::restore()
   if (!m_copy)
     return;
 
-  Cel* cel = this->cel();
-  copy_image(cel->image(), m_copy.get(), m_cropPos.x, m_cropPos.y);
+  Image* image = this->cel()->image();
+  copy_image(image, m_copy.get(), m_cropPos.x, m_cropPos.y);
+  image->incrementVersion();
 }
 
 }} // namespace app::cmd
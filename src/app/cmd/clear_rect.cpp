@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2025  Igara Studio S.A.
+// Copyright (C) 2025-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -79,17 +79,21 @@ void ClearRect::onRedo()
 
 void ClearRect::clear()
 {
-  fill_rect(m_dstImage->image(),
+  Image* image = m_dstImage->image();
+  fill_rect(image,
             m_offsetX,
             m_offsetY,
             m_offsetX + m_copy->width() - 1,
             m_offsetY + m_copy->height() - 1,
             m_bgcolor);
+  image->incrementVersion();
 }
 
 void ClearRect::restore()
 {
-  copy_image(m_dstImage->image(), m_copy.get(), m_offsetX, m_offsetY);
+  Image* image = m_dstImage->image();
+  copy_image(image, m_copy.get(), m_offsetX, m_offsetY);
+  image->incrementVersion();
 }
 
 }} // namespace app::cmd
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2024  Igara Studio S.A.
+// Copyright (C) 2024-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -121,12 +121,14 @@ void ClearSlices::clear()
         });
     }
     else {
+      Image* image = sc.cel()->image();
       Grid grid = sc.cel()->grid();
-      doc::algorithm::fill_selection(sc.cel()->image(),
+      doc::algorithm::fill_selection(image,
                                      sc.cel()->bounds(),
                                      &sc.mask,
                                      sc.bgcolor,
-                                     (sc.cel()->image()->isTilemap() ? &grid : nullptr));
+                                     (image->isTilemap() ? &grid : nullptr));
+      image->incrementVersion();
     }
   }
 }
@@ -137,7 +139,9 @@ void ClearSlices::restore()
     if (!sc.copy)
       continue;
 
-    copy_image(sc.cel()->image(), sc.copy.get(), sc.cropPos.x, sc.cropPos.y);
+    Image* image = sc.cel()->image();
+    copy_image(image, sc.copy.get(), sc.cropPos.x, sc.cropPos.y);
+    image->incrementVersion();
   }
 }
 
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2020  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2016  David Capello
 //
 // This program is distributed under the terms of
@@ -36,9 +36,13 @@ CopyRegion::CopyRegion(Image* dst,
     m_region = region;
     m_region.offset(dstPos);
     m_region &= gfx::Region(clip.dstBounds());
+
+    // We don't need to save/swap the pixels that are equal in both
+    // images (e.g. around a thin stroke)
+    m_region = get_different_image_region(m_region, dst, src, dstPos);
   }
 
-  save_image_region_in_buffer(m_region, src, dstPos, m_buffer);
+  save_image_region_in_rle_buffer(m_region, src, dstPos, m_buffer.data());
 }
 
 CopyTileRegion::CopyTileRegion(Image* dst,
@@ -75,7 +79,7 @@ void CopyRegion::swap()
   Image* image = this->image();
   ASSERT(image);
 
-  swap_image_region_with_buffer(m_region, image, m_buffer);
+  swap_image_region_with_rle_buffer(m_region, image, m_buffer.data());
   image->incrementVersion();
 
   rehash();
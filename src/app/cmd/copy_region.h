@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2020  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2016  David Capello
 //
 // This program is distributed under the terms of
@@ -11,7 +11,7 @@
 
 #include "app/cmd.h"
 #include "app/cmd/with_image.h"
-#include "base/buffer.h"
+#include "app/util/undo_buffer.h"
 #include "doc/tile.h"
 #include "gfx/point.h"
 #include "gfx/region.h"
@@ -40,7 +40,8 @@ protected:
   void onExecute() override;
   void onUndo() override;
   void onRedo() override;
-  size_t onMemSize() const override { return sizeof(*this) + m_buffer.size(); }
+  size_t onMemSize() const override { return sizeof(*this) + m_buffer.memSize(); }
+  size_t onSpillToDisk() override { return m_buffer.spillToDisk(); }
 
 private:
   void swap();
@@ -48,7 +49,7 @@ private:
 
   bool m_alreadyCopied;
   gfx::Region m_region;
-  base::buffer m_buffer;
+  UndoBuffer m_buffer;
 };
 
 class CopyTileRegion : public CopyRegion {
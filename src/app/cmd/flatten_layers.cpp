@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -26,6 +26,7 @@
 #include "app/cmd/set_layer_opacity.h"
 #include "app/cmd/unlink_cel.h"
 #include "app/doc.h"
+#include "app/flatten.h"
 #include "app/i18n/strings.h"
 #include "app/restore_visible_layers.h"
 #include "doc/algorithm/shrink_bounds.h"
@@ -36,6 +37,7 @@
 #include "render/render.h"
 
 #include <algorithm>
+#include <vector>
 
 namespace app { namespace cmd {
 
@@ -92,9 +94,6 @@ void FlattenLayers::onExecute()
     area.setSize(spec.size());
   }
 
-  // Create a temporary image.
-  ImageRef image(Image::create(spec));
-
   LayerImage* flatLayer; // The layer onto which everything will be flattened.
   color_t bgcolor;       // The background color to use for flatLayer.
   bool newFlatLayer = false;
@@ -119,10 +118,6 @@ void FlattenLayers::onExecute()
     bgcolor = sprite->transparentColor();
   }
 
-  render::Render render;
-  render.setNewBlend(m_options.newBlendMethod);
-  render.setBgOptions(render::BgOptions::MakeNone());
-
   {
     // Show only the layers to be flattened so other layers are hidden
     // temporarily.
@@ -134,8 +129,18 @@ void FlattenLayers::onExecute()
     // Map draw area to image coords
     const gfx::ClipF area_to_image(0, 0, area);
 
-    // Copy all frames to the background.
-    for (frame_t frame(0); frame < sprite->totalFrames(); ++frame) {
+    // Result of rendering one frame.
+    struct FlatFrame {
+      bool skip = true;  // Keep the existing cel in the flatLayer
+      ImageRef image;    // Shrunk image (nullptr if it's fully transparent)
+      gfx::Rect bounds;  // Bounds of the shrunk image in the rendered area
+      uint64_t hash = 0; // Hash of the shrunk image
+    };
+    std::vector<FlatFrame> flatFrames(sprite->totalFrames());
+
+    // Render all frames in parallel as each frame is independent, the
+    // sprite is modified later from this thread.
+    for_each_frame_in_parallel(0, sprite->lastFrame(), [&](const frame_t frame) {
       // If the flatLayer is the only cel in this frame, we can skip
       // this frame to keep existing links in the flatLayer.
       const bool anotherCelExists = std::any_of(visibleLayers.begin(),
@@ -144,10 +149,18 @@ void FlattenLayers::onExecute()
                                                   return (flatLayer != other && other->cel(frame));
                                                 });
       if (!anotherCelExists)
-        continue;
+        return;
+
+      FlatFrame& flatFrame = flatFrames[frame];
+      flatFrame.skip = false;
 
       // Clear the image and render this frame.
+      ImageRef image(Image::create(spec));
       clear_image(image.get(), bgcolor);
+
+      render::Render render;
+      render.setNewBlend(m_options.newBlendMethod);
+      render.setBgOptions(render::BgOptions::MakeNone());
       render.renderSprite(image.get(), sprite, frame, area_to_image);
 
       // Get exact bounds for rendered frame
@@ -157,23 +170,57 @@ void FlattenLayers::onExecute()
                                                         nullptr,
                                                         image->bounds(),
                                                         bounds);
+      // Fully transparent
+      if (!shrink)
+        return;
+
+      // Apply shrunk bounds to new image
+      flatFrame.image.reset(doc::crop_image(image.get(), bounds, image->maskColor()));
+      flatFrame.bounds = bounds;
+      flatFrame.hash = calculate_image_hash64(flatFrame.image.get(),
+                                              flatFrame.image->bounds());
+    });
+
+    // Cels of the flatLayer that were modified/added, to link frames
+    // with the same result.
+    FlattenedCels flatCels;
+
+    // Copy all frames to the background.
+    for (frame_t frame(0); frame < sprite->totalFrames(); ++frame) {
+      FlatFrame& flatFrame = flatFrames[frame];
+      if (flatFrame.skip)
+        continue;
 
       // Skip when fully transparent
       Cel* cel = flatLayer->cel(frame);
-      if (!shrink) {
+      if (!flatFrame.image) {
         if (!newFlatLayer && cel)
           executeAndAdd(new cmd::RemoveCel(cel));
 
         continue;
       }
 
-      // Apply shrunk bounds to new image
-      const ImageRef new_image(doc::crop_image(image.get(), bounds, image->maskColor()));
+      const ImageRef new_image = flatFrame.image;
+      const gfx::Rect& bounds = flatFrame.bounds;
+      flatFrame.image.reset();
+
+      // Link this frame with a previous one with the same result
+      if (Cel* link = flatCels.find(new_image.get(),
+                                    gfx::Point(area.x + bounds.x, area.y + bounds.y),
+                                    flatFrame.hash)) {
+        if (cel)
+          executeAndAdd(new cmd::RemoveCel(cel));
+
+        cel = Cel::MakeLink(frame, link);
+        if (newFlatLayer)
+          flatLayer->addCel(cel);
+        else
+          executeAndAdd(new cmd::AddCel(flatLayer, cel));
+        continue;
+      }
 
       // Replace image on existing cel
       if (cel) {
-        // TODO Keep cel links when possible
-
         if (cel->links())
           executeAndAdd(new cmd::UnlinkCel(cel));
 
@@ -209,6 +256,7 @@ void FlattenLayers::onExecute()
           executeAndAdd(new cmd::AddCel(flatLayer, cel));
         }
       }
+      flatCels.add(cel, flatFrame.hash);
     }
   }
 
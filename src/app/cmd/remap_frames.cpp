@@ -0,0 +1,71 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/cmd/remap_frames.h"
+
+#include "app/doc.h"
+#include "doc/layer.h"
+#include "doc/sprite.h"
+
+namespace app { namespace cmd {
+
+RemapFrames::RemapFrames(Sprite* sprite, const std::vector<frame_t>& newFrames)
+  : WithSprite(sprite)
+  , m_newFrames(newFrames)
+  , m_oldFrames(newFrames.size())
+{
+  for (frame_t i = 0; i < frame_t(m_newFrames.size()); ++i)
+    m_oldFrames[m_newFrames[i]] = i;
+}
+
+RemapFrames::RemapFrames(Sprite* sprite,
+                         const LayerList& layers,
+                         const std::vector<frame_t>& newFrames)
+  : RemapFrames(sprite, newFrames)
+{
+  for (const Layer* layer : layers) {
+    if (layer->isImage())
+      m_layerIds.push_back(layer->id());
+  }
+}
+
+void RemapFrames::onExecute()
+{
+  remap(m_newFrames);
+}
+
+void RemapFrames::onUndo()
+{
+  remap(m_oldFrames);
+}
+
+void RemapFrames::remap(const std::vector<frame_t>& newFrames)
+{
+  Sprite* spr = sprite();
+  if (m_layerIds.empty()) {
+    spr->remapFrames(newFrames);
+  }
+  else {
+    for (const ObjectId layerId : m_layerIds) {
+      if (auto* layer = doc::get<LayerImage>(layerId))
+        layer->remapFrames(newFrames);
+    }
+  }
+  spr->incrementVersion();
+}
+
+void RemapFrames::onFireNotifications()
+{
+  // Just one notification for all the moved cels and frames
+  Doc* doc = static_cast<Doc*>(sprite()->document());
+  doc->notifyGeneralUpdate();
+}
+
+}} // namespace app::cmd
@@ -0,0 +1,54 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_CMD_REMAP_FRAMES_H_INCLUDED
+#define APP_CMD_REMAP_FRAMES_H_INCLUDED
+#pragma once
+
+#include "app/cmd.h"
+#include "app/cmd/with_sprite.h"
+#include "doc/frame.h"
+#include "doc/layer_list.h"
+#include "doc/object_id.h"
+
+#include <vector>
+
+namespace app { namespace cmd {
+using namespace doc;
+
+// Moves several frames (durations and cels) at the same time, the
+// frame "i" is moved to "newFrames[i]". Only the permutation is
+// stored to undo/redo the command.
+class RemapFrames : public Cmd,
+                    public WithSprite {
+public:
+  RemapFrames(Sprite* sprite, const std::vector<frame_t>& newFrames);
+
+  // Moves only the cels of the given image layers (frame durations
+  // are not modified).
+  RemapFrames(Sprite* sprite, const LayerList& layers, const std::vector<frame_t>& newFrames);
+
+protected:
+  void onExecute() override;
+  void onUndo() override;
+  void onFireNotifications() override;
+  size_t onMemSize() const override
+  {
+    return sizeof(*this) + sizeof(frame_t) * (m_newFrames.size() + m_oldFrames.size()) +
+           sizeof(ObjectId) * m_layerIds.size();
+  }
+
+private:
+  void remap(const std::vector<frame_t>& newFrames);
+
+  std::vector<ObjectId> m_layerIds; // Empty to move whole frames
+  std::vector<frame_t> m_newFrames;
+  std::vector<frame_t> m_oldFrames; // Inverse of m_newFrames
+};
+
+}} // namespace app::cmd
+
+#endif
@@ -44,7 +44,7 @@ void SetCelOpacity::onFireNotifications()
   DocEvent ev(doc);
   ev.sprite(cel->sprite());
   ev.cel(cel);
-  doc->notify_observers<DocEvent&>(&DocObserver::onCelOpacityChange, ev);
+  doc->notifyPropertyChange(&DocObserver::onCelOpacityChange, ev);
 }
 
 }} // namespace app::cmd
@@ -46,7 +46,7 @@ void SetCelPosition::onFireNotifications()
   DocEvent ev(doc);
   ev.sprite(cel->sprite());
   ev.cel(cel);
-  doc->notify_observers<DocEvent&>(&DocObserver::onCelPositionChanged, ev);
+  doc->notifyPropertyChange(&DocObserver::onCelPositionChanged, ev);
 }
 
 }} // namespace app::cmd
@@ -44,7 +44,7 @@ void SetCelZIndex::onFireNotifications()
   DocEvent ev(doc);
   ev.sprite(cel->sprite());
   ev.cel(cel);
-  doc->notify_observers<DocEvent&>(&DocObserver::onCelZIndexChange, ev);
+  doc->notifyPropertyChange(&DocObserver::onCelZIndexChange, ev);
 }
 
 }} // namespace app::cmd
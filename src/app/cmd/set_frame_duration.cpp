@@ -43,7 +43,7 @@ void SetFrameDuration::onFireNotifications()
   DocEvent ev(doc);
   ev.sprite(sprite);
   ev.frame(m_frame);
-  doc->notify_observers<DocEvent&>(&DocObserver::onFrameDurationChanged, ev);
+  doc->notifyPropertyChange(&DocObserver::onFrameDurationChanged, ev);
 }
 
 }} // namespace app::cmd
@@ -43,7 +43,7 @@ void SetLayerBlendMode::onFireNotifications()
   DocEvent ev(doc);
   ev.sprite(layer->sprite());
   ev.layer(layer);
-  doc->notify_observers<DocEvent&>(&DocObserver::onLayerBlendModeChange, ev);
+  doc->notifyPropertyChange(&DocObserver::onLayerBlendModeChange, ev);
 }
 
 }} // namespace app::cmd
@@ -43,7 +43,7 @@ void SetLayerName::onFireNotifications()
   DocEvent ev(doc);
   ev.sprite(layer->sprite());
   ev.layer(layer);
-  doc->notify_observers<DocEvent&>(&DocObserver::onLayerNameChange, ev);
+  doc->notifyPropertyChange(&DocObserver::onLayerNameChange, ev);
 }
 
 }} // namespace app::cmd
@@ -43,7 +43,7 @@ void SetLayerOpacity::onFireNotifications()
   DocEvent ev(doc);
   ev.sprite(layer->sprite());
   ev.layer(layer);
-  doc->notify_observers<DocEvent&>(&DocObserver::onLayerOpacityChange, ev);
+  doc->notifyPropertyChange(&DocObserver::onLayerOpacityChange, ev);
 }
 
 }} // namespace app::cmd
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -18,6 +18,7 @@
 #include "app/cmd/set_transparent_color.h"
 #include "app/doc.h"
 #include "app/doc_event.h"
+#include "app/task_scheduler.h"
 #include "doc/cel.h"
 #include "doc/cels_range.h"
 #include "doc/document.h"
@@ -25,10 +26,15 @@
 #include "doc/palette.h"
 #include "doc/rgbmap.h"
 #include "doc/sprite.h"
+#include "doc/task_group.h"
 #include "doc/tilesets.h"
 #include "render/quantization.h"
 #include "render/task_delegate.h"
 
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
 namespace app { namespace cmd {
 
 using namespace doc;
@@ -66,6 +72,51 @@ private:
   TaskDelegate* m_delegate;
 };
 
+// Delegate used to convert several images at the same time. The
+// progress is reported each time an image is converted, and the
+// original delegate is called from one thread at a time.
+class ParallelDelegate : public render::TaskDelegate {
+public:
+  ParallelDelegate(int nimages, render::TaskDelegate* delegate)
+    : m_nimages(nimages)
+    , m_delegate(delegate)
+  {
+  }
+
+  void notifyTaskProgress(double progress) override {}
+
+  bool continueTask() override { return !m_canceled; }
+
+  void imageDone()
+  {
+    const std::lock_guard lock(m_mutex);
+    ++m_doneImages;
+    if (m_delegate) {
+      m_delegate->notifyTaskProgress(double(m_doneImages) / m_nimages);
+      if (!m_delegate->continueTask())
+        m_canceled = true;
+    }
+  }
+
+private:
+  int m_nimages;
+  int m_doneImages = 0;
+  TaskDelegate* m_delegate;
+  std::mutex m_mutex;
+  std::atomic<bool> m_canceled = false;
+};
+
+// Calls f(i) for each i in [0, n) in parallel tasks, and waits all
+// calls to finish.
+template<typename F>
+void parallel_for(const int n, F&& f)
+{
+  doc::TaskGroup tasks;
+  for (int i = 0; i < n; ++i)
+    tasks.run([&f, i] { f(i); });
+  tasks.wait();
+}
+
 } // anonymous namespace
 
 SetPixelFormat::SetPixelFormat(Sprite* sprite,
@@ -82,65 +133,36 @@ SetPixelFormat::SetPixelFormat(Sprite* sprite,
   if (sprite->pixelFormat() == newFormat)
     return;
 
-  // Calculate the number of images to convert just to show a proper
-  // progress bar.
-  tile_index nimages = 0;
-  for (Cel* cel : sprite->uniqueCels())
-    if (!cel->layer()->isTilemap())
-      ++nimages;
-  if (sprite->hasTilesets()) {
-    for (Tileset* tileset : *sprite->tilesets()) {
-      if (tileset)
-        nimages += tileset->size();
-    }
-  }
-
-  SuperDelegate superDel(nimages, delegate);
-
-  // Convert cel images
+  // Collect all the images to convert (cels and tiles)
+  std::vector<Item> items;
   for (Cel* cel : sprite->uniqueCels()) {
-    if (cel->layer()->isTilemap())
-      continue;
-
-    ImageRef oldImage = cel->imageRef();
-    convertImage(sprite,
-                 dithering,
-                 oldImage,
-                 cel->frame(),
-                 cel->layer()->isBackground(),
-                 mapAlgorithm,
-                 toGray,
-                 &superDel,
-                 fitCriteria);
-
-    superDel.nextImage();
+    if (!cel->layer()->isTilemap())
+      items.push_back(Item{ cel->imageRef(), cel->frame(), cel->layer()->isBackground() });
   }
-
-  // Convert tileset images
   if (sprite->hasTilesets()) {
     for (Tileset* tileset : *sprite->tilesets()) {
       if (!tileset)
         continue;
 
       for (tile_index i = 0; i < tileset->size(); ++i) {
-        ImageRef oldImage = tileset->get(i);
-        if (oldImage) {
-          convertImage(sprite,
-                       dithering,
-                       oldImage,
-                       0,     // TODO select a frame or generate other tilesets?
-                       false, // TODO is background? it depends of the layer where this tileset is
-                              // used
-                       mapAlgorithm,
-                       toGray,
-                       &superDel,
-                       fitCriteria);
+        if (ImageRef oldImage = tileset->get(i)) {
+          items.push_back(Item{
+            oldImage,
+            0,     // TODO select a frame or generate other tilesets?
+            false, // TODO is background? it depends of the layer where this tileset is used
+          });
         }
-        superDel.nextImage();
       }
     }
   }
 
+  convertImages(sprite, items, dithering, mapAlgorithm, toGray, delegate, fitCriteria);
+
+  for (const Item& item : items) {
+    if (item.newImage)
+      m_pre.add(new cmd::ReplaceImage(sprite, item.oldImage, item.newImage));
+  }
+
   // By default, when converting to RGB or grayscale, the mask color
   // is always 0.
   int newMaskIndex = 0;
@@ -228,45 +250,103 @@ void SetPixelFormat::setFormat(PixelFormat format)
   doc->notify_observers<DocEvent&>(&DocObserver::onPixelFormatChanged, ev);
 }
 
-void SetPixelFormat::convertImage(doc::Sprite* sprite,
-                                  const render::Dithering& dithering,
-                                  const doc::ImageRef& oldImage,
-                                  const doc::frame_t frame,
-                                  const bool isBackground,
-                                  const doc::RgbMapAlgorithm mapAlgorithm,
-                                  doc::rgba_to_graya_func toGray,
-                                  render::TaskDelegate* delegate,
-                                  const doc::FitCriteria fitCriteria)
+void SetPixelFormat::convertImages(doc::Sprite* sprite,
+                                   std::vector<Item>& items,
+                                   const render::Dithering& dithering,
+                                   const doc::RgbMapAlgorithm mapAlgorithm,
+                                   doc::rgba_to_graya_func toGray,
+                                   render::TaskDelegate* delegate,
+                                   const doc::FitCriteria fitCriteria)
 {
-  ASSERT(oldImage);
-  ASSERT(oldImage->pixelFormat() != IMAGE_TILEMAP);
+  const int nimages = int(items.size());
+  const bool toIndexed = (m_newFormat == IMAGE_INDEXED);
+
+  // Converting to indexed needs the RgbMap of the palette of each
+  // frame, and as the sprite has only one RgbMap, we convert the
+  // images of each palette together (so the RgbMap isn't regenerated
+  // for each image).
+  std::vector<int> order(nimages);
+  for (int i = 0; i < nimages; ++i)
+    order[i] = i;
+  if (toIndexed) {
+    std::stable_sort(order.begin(), order.end(), [sprite, &items](const int a, const int b) {
+      return sprite->palette(items[a].frame)->frame() < sprite->palette(items[b].frame)->frame();
+    });
+  }
 
-  // Making the RGBMap for Image->INDEXDED conversion.
-  // TODO: this is needed only when newImage
-  RgbMap* rgbmap;
-  int newMaskIndex = (isBackground ? -1 : 0);
+  const bool canUseThreads = (nimages > 1 && TaskScheduler::instance()->threads() > 1);
+  SuperDelegate superDel(nimages, delegate);
+  ParallelDelegate parallelDel(nimages, delegate);
+
+  for (int begin = 0; begin < nimages;) {
+    const Palette* palette = sprite->palette(items[order[begin]].frame);
+    int end = begin + 1;
+    while (end < nimages &&
+           (!toIndexed || sprite->palette(items[order[end]].frame) == palette))
+      ++end;
+
+    // Making the RGBMap for Image->INDEXDED conversion.
+    RgbMap* rgbmap = nullptr;
+    if (toIndexed)
+      rgbmap = sprite->rgbMap(items[order[begin]].frame,
+                              sprite->rgbMapForSprite(),
+                              mapAlgorithm,
+                              fitCriteria);
+
+    // Images are converted in parallel only if the RgbMap can be used
+    // from several threads (e.g. the error diffusion is serial inside
+    // each image, but several images can be dithered at the same time)
+    if (canUseThreads && (!rgbmap || rgbmap->isThreadSafe())) {
+      parallel_for(end - begin, [&, begin, rgbmap](const int i) {
+        if (!parallelDel.continueTask())
+          return;
+
+        Item& item = items[order[begin + i]];
+        item.newImage = convertImage(sprite, dithering, item, rgbmap, toGray, &parallelDel);
+        parallelDel.imageDone();
+      });
+    }
+    else {
+      for (int i = begin; i < end; ++i) {
+        Item& item = items[order[i]];
+        item.newImage = convertImage(sprite, dithering, item, rgbmap, toGray, &superDel);
+        superDel.nextImage();
+      }
+    }
+
+    begin = end;
+  }
+}
+
+doc::ImageRef SetPixelFormat::convertImage(doc::Sprite* sprite,
+                                           const render::Dithering& dithering,
+                                           const Item& item,
+                                           const doc::RgbMap* rgbmap,
+                                           doc::rgba_to_graya_func toGray,
+                                           render::TaskDelegate* delegate)
+{
+  ASSERT(item.oldImage);
+  ASSERT(item.oldImage->pixelFormat() != IMAGE_TILEMAP);
+
+  int newMaskIndex = (item.isBackground ? -1 : 0);
   if (m_newFormat == IMAGE_INDEXED) {
-    rgbmap = sprite->rgbMap(frame, sprite->rgbMapForSprite(), mapAlgorithm, fitCriteria);
+    ASSERT(rgbmap);
     if (m_oldFormat == IMAGE_INDEXED)
       newMaskIndex = sprite->transparentColor();
     else
       newMaskIndex = rgbmap->maskIndex();
   }
-  else {
-    rgbmap = nullptr;
-  }
-  ImageRef newImage(render::convert_pixel_format(oldImage.get(),
-                                                 nullptr,
-                                                 m_newFormat,
-                                                 dithering,
-                                                 rgbmap,
-                                                 sprite->palette(frame),
-                                                 isBackground,
-                                                 newMaskIndex,
-                                                 toGray,
-                                                 delegate));
-
-  m_pre.add(new cmd::ReplaceImage(sprite, oldImage, newImage));
+
+  return ImageRef(render::convert_pixel_format(item.oldImage.get(),
+                                               nullptr,
+                                               m_newFormat,
+                                               dithering,
+                                               rgbmap,
+                                               sprite->palette(item.frame),
+                                               item.isBackground,
+                                               newMaskIndex,
+                                               toGray,
+                                               delegate));
 }
 
 }} // namespace app::cmd
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2017  David Capello
 //
 // This program is distributed under the terms of
@@ -18,9 +18,12 @@
 #include "doc/pixel_format.h"
 #include "doc/rgbmap_algorithm.h"
 
+#include <vector>
+
 namespace doc {
+class RgbMap;
 class Sprite;
-}
+} // namespace doc
 
 namespace render {
 class Dithering;
@@ -47,16 +50,28 @@ protected:
   size_t onMemSize() const override { return sizeof(*this) + m_pre.memSize() + m_post.memSize(); }
 
 private:
+  // Image of a cel or tile to be converted
+  struct Item {
+    doc::ImageRef oldImage;
+    doc::frame_t frame;
+    bool isBackground;
+    doc::ImageRef newImage;
+  };
+
   void setFormat(doc::PixelFormat format);
-  void convertImage(doc::Sprite* sprite,
-                    const render::Dithering& dithering,
-                    const doc::ImageRef& oldImage,
-                    const doc::frame_t frame,
-                    const bool isBackground,
-                    const doc::RgbMapAlgorithm mapAlgorithm,
-                    doc::rgba_to_graya_func toGray,
-                    render::TaskDelegate* delegate,
-                    const doc::FitCriteria fitCriteria = doc::FitCriteria::DEFAULT);
+  void convertImages(doc::Sprite* sprite,
+                     std::vector<Item>& items,
+                     const render::Dithering& dithering,
+                     const doc::RgbMapAlgorithm mapAlgorithm,
+                     doc::rgba_to_graya_func toGray,
+                     render::TaskDelegate* delegate,
+                     const doc::FitCriteria fitCriteria);
+  doc::ImageRef convertImage(doc::Sprite* sprite,
+                             const render::Dithering& dithering,
+                             const Item& item,
+                             const doc::RgbMap* rgbmap,
+                             doc::rgba_to_graya_func toGray,
+                             render::TaskDelegate* delegate);
 
   doc::PixelFormat m_oldFormat;
   doc::PixelFormat m_newFormat;
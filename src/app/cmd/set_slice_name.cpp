@@ -48,7 +48,7 @@ void SetSliceName::onFireNotifications()
   DocEvent ev(doc);
   ev.sprite(sprite);
   ev.slice(slice);
-  doc->notify_observers<DocEvent&>(&DocObserver::onSliceNameChange, ev);
+  doc->notifyPropertyChange(&DocObserver::onSliceNameChange, ev);
 }
 
 }} // namespace app::cmd
@@ -46,7 +46,7 @@ void SetTagName::onFireNotifications()
   DocEvent ev(doc);
   ev.sprite(sprite);
   ev.tag(tag);
-  doc->notify_observers<DocEvent&>(&DocObserver::onTagRename, ev);
+  doc->notifyPropertyChange(&DocObserver::onTagRename, ev);
 }
 
 }} // namespace app::cmd
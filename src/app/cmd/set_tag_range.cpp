@@ -48,7 +48,7 @@ void SetTagRange::onFireNotifications()
   DocEvent ev(doc);
   ev.sprite(sprite);
   ev.tag(tag);
-  doc->notify_observers<DocEvent&>(&DocObserver::onTagChange, ev);
+  doc->notifyPropertyChange(&DocObserver::onTagChange, ev);
 }
 
 }} // namespace app::cmd
@@ -46,7 +46,7 @@ void SetUserData::onFireNotifications()
   app::Doc* doc = document();
   DocEvent ev(doc);
   ev.withUserData(obj);
-  doc->notify_observers<DocEvent&>(&DocObserver::onUserDataChange, ev);
+  doc->notifyPropertyChange(&DocObserver::onUserDataChange, ev);
 }
 
 }} // namespace app::cmd
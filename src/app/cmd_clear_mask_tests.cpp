@@ -0,0 +1,107 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#include "tests/app_test.h"
+
+#include "app/cmd/clear_mask.h"
+#include "app/context.h"
+#include "app/doc.h"
+#include "app/doc_undo.h"
+#include "app/test_context.h"
+#include "app/tx.h"
+#include "doc/cel.h"
+#include "doc/image.h"
+#include "doc/layer.h"
+#include "doc/mask.h"
+#include "doc/primitives.h"
+#include "doc/sprite_snapshot.h"
+#include "render/mipmap_cache.h"
+
+using namespace app;
+using namespace doc;
+
+// Deleting the selection (and undoing it) modifies the cel image in
+// place, so the version of the image must change to update the
+// caches that depend on it (e.g. mip levels to render zoomed out).
+TEST(ClearMask, UpdatesMipmaps)
+{
+  TestContextT<Context> ctx;
+  std::unique_ptr<Doc> doc(ctx.documents().add(8, 8));
+  Sprite* sprite = doc->sprite();
+  Cel* cel = sprite->root()->firstLayer()->cel(0);
+  ASSERT_TRUE(cel);
+  Image* image = cel->image();
+  clear_image(image, rgba(255, 0, 0, 255));
+
+  Mask mask;
+  mask.replace(gfx::Rect(0, 0, 4, 4));
+  doc->setMask(&mask);
+  doc->setMaskVisible(true);
+
+  render::MipmapCache cache;
+  const ObjectVersion version = image->version();
+  ImageRef level = cache.getLevel(image, 3);
+  ASSERT_TRUE(level);
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(level.get(), 0, 0));
+
+  {
+    Tx tx(sprite, "Clear");
+    tx(new cmd::ClearMask(cel));
+    tx.commit();
+  }
+  EXPECT_NE(version, image->version());
+  EXPECT_EQ(rgba(0, 0, 0, 0), get_pixel(image, 0, 0));
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(image, 4, 4));
+
+  // 3/4 of the pixels are red now
+  level = cache.getLevel(image, 3);
+  ASSERT_TRUE(level);
+  EXPECT_EQ(rgba(255, 0, 0, 191), get_pixel(level.get(), 0, 0));
+
+  doc->undoHistory()->undo();
+  level = cache.getLevel(image, 3);
+  ASSERT_TRUE(level);
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(level.get(), 0, 0));
+
+  doc->close();
+}
+
+// Snapshots reuse copies of images with the same version.
+TEST(ClearMask, UpdatesSnapshots)
+{
+  TestContextT<Context> ctx;
+  std::unique_ptr<Doc> doc(ctx.documents().add(8, 8));
+  Sprite* sprite = doc->sprite();
+  Cel* cel = sprite->root()->firstLayer()->cel(0);
+  ASSERT_TRUE(cel);
+  clear_image(cel->image(), rgba(255, 0, 0, 255));
+
+  Mask mask;
+  mask.replace(gfx::Rect(0, 0, 4, 4));
+  doc->setMask(&mask);
+  doc->setMaskVisible(true);
+
+  auto pixelInSnapshot = [](const SpriteSnapshotRef& snapshot) {
+    return get_pixel(snapshot->sprite()->root()->firstLayer()->cel(0)->image(), 0, 0);
+  };
+
+  SpriteSnapshotRef snapshot = SpriteSnapshot::Make(sprite);
+  EXPECT_EQ(rgba(255, 0, 0, 255), pixelInSnapshot(snapshot));
+
+  {
+    Tx tx(sprite, "Clear");
+    tx(new cmd::ClearMask(cel));
+    tx.commit();
+  }
+  snapshot = SpriteSnapshot::Make(sprite, snapshot);
+  EXPECT_EQ(rgba(0, 0, 0, 0), pixelInSnapshot(snapshot));
+
+  doc->undoHistory()->undo();
+  snapshot = SpriteSnapshot::Make(sprite, snapshot);
+  EXPECT_EQ(rgba(255, 0, 0, 255), pixelInSnapshot(snapshot));
+
+  doc->close();
+}
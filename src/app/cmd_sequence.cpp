@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2023  Igara Studio S.A.
+// Copyright (C) 2023-2026  Igara Studio S.A.
 // Copyright (C) 2001-2015  David Capello
 //
 // This program is distributed under the terms of
@@ -80,6 +80,14 @@ size_t CmdSequence::onMemSize() const
   return size;
 }
 
+size_t CmdSequence::onSpillToDisk()
+{
+  size_t size = 0;
+  for (Cmd* cmd : m_cmds)
+    size += cmd->spillToDisk();
+  return size;
+}
+
 void CmdSequence::executeAndAdd(Cmd* cmd)
 {
   addAndExecute(context(), cmd);
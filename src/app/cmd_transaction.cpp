@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2023  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -18,8 +18,7 @@
 namespace app {
 
 CmdTransaction::CmdTransaction(const std::string& label, bool changeSavedState)
-  : m_ranges(nullptr)
-  , m_label(label)
+  : m_label(label)
   , m_changeSavedState(changeSavedState)
 {
 }
@@ -29,60 +28,45 @@ CmdTransaction* CmdTransaction::moveToEmptyCopy()
   CmdTransaction* copy = new CmdTransaction(m_label, m_changeSavedState);
   copy->m_spritePositionBefore = m_spritePositionBefore;
   copy->m_spritePositionAfter = m_spritePositionAfter;
-  if (m_ranges) {
-    copy->m_ranges.reset(new Ranges);
-    copy->m_ranges->m_before = std::move(m_ranges->m_before);
-    copy->m_ranges->m_after = std::move(m_ranges->m_after);
-  }
+  copy->m_rangeBefore = std::move(m_rangeBefore);
+  copy->m_rangeAfter = std::move(m_rangeAfter);
   return copy;
 }
 
 void CmdTransaction::setNewDocRange(const view::RealRange& range)
 {
-  if (m_ranges)
-    range.write(m_ranges->m_after);
+  if (m_rangeBefore.saved())
+    range.save(m_rangeAfter);
 }
 
 void CmdTransaction::updateSpritePositionAfter()
 {
   m_spritePositionAfter = calcSpritePosition();
 
-  // We cannot capture m_ranges->m_after from the Timeline here
+  // We cannot capture m_rangeAfter from the Timeline here
   // because the document range in the Timeline is updated after the
   // commit/command (on Timeline::onAfterCommandExecution).
   //
-  // So m_ranges->m_after is captured explicitly in
+  // So m_rangeAfter is captured explicitly in
   // setNewDocRange().
 }
 
-std::istream* CmdTransaction::documentRangeBeforeExecute() const
+const view::RangeSnapshot* CmdTransaction::documentRangeBeforeExecute() const
 {
-  if (m_ranges && m_ranges->m_before.tellp() > 0) {
-    m_ranges->m_before.seekg(0);
-    return &m_ranges->m_before;
-  }
-  else
-    return nullptr;
+  return (m_rangeBefore.saved() ? &m_rangeBefore : nullptr);
 }
 
-std::istream* CmdTransaction::documentRangeAfterExecute() const
+const view::RangeSnapshot* CmdTransaction::documentRangeAfterExecute() const
 {
-  if (m_ranges && m_ranges->m_after.tellp() > 0) {
-    m_ranges->m_after.seekg(0);
-    return &m_ranges->m_after;
-  }
-  else
-    return nullptr;
+  return (m_rangeAfter.saved() ? &m_rangeAfter : nullptr);
 }
 
 void CmdTransaction::onExecute()
 {
   // Save the current site and doc range
   m_spritePositionBefore = calcSpritePosition();
-  if (isDocRangeEnabled()) {
-    m_ranges.reset(new Ranges);
-    calcDocRange().write(m_ranges->m_before);
-  }
+  if (isDocRangeEnabled())
+    calcDocRange().save(m_rangeBefore);
 
   // Execute the sequence of "cmds"
   CmdSequence::onExecute();
@@ -105,11 +89,7 @@ std::string CmdTransaction::onLabel() const
 
 size_t CmdTransaction::onMemSize() const
 {
-  size_t size = CmdSequence::onMemSize();
-  if (m_ranges) {
-    size += (m_ranges->m_before.tellp() + m_ranges->m_after.tellp());
-  }
-  return size;
+  return CmdSequence::onMemSize() + m_rangeBefore.memSize() + m_rangeAfter.memSize();
 }
 
 SpritePosition CmdTransaction::calcSpritePosition() const
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2023  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -13,8 +13,7 @@
 #include "app/sprite_position.h"
 #include "view/range.h"
 
-#include <memory>
-#include <sstream>
+#include <string>
 
 namespace app {
 
@@ -37,8 +36,8 @@ public:
   SpritePosition spritePositionBeforeExecute() const { return m_spritePositionBefore; }
   SpritePosition spritePositionAfterExecute() const { return m_spritePositionAfter; }
 
-  std::istream* documentRangeBeforeExecute() const;
-  std::istream* documentRangeAfterExecute() const;
+  const view::RangeSnapshot* documentRangeBeforeExecute() const;
+  const view::RangeSnapshot* documentRangeAfterExecute() const;
 
 protected:
   void onExecute() override;
@@ -52,14 +51,10 @@ private:
   bool isDocRangeEnabled() const;
   view::RealRange calcDocRange() const;
 
-  struct Ranges {
-    std::stringstream m_before;
-    std::stringstream m_after;
-  };
-
   SpritePosition m_spritePositionBefore;
   SpritePosition m_spritePositionAfter;
-  std::unique_ptr<Ranges> m_ranges;
+  view::RangeSnapshot m_rangeBefore;
+  view::RangeSnapshot m_rangeAfter;
   std::string m_label;
   bool m_changeSavedState;
 };
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -22,6 +22,7 @@
 #include "app/load_matrix.h"
 #include "app/modules/gui.h"
 #include "app/sprite_job.h"
+#include "app/task.h"
 #include "app/ui/best_fit_criteria_selector.h"
 #include "app/ui/dithering_selector.h"
 #include "app/ui/editor/editor.h"
@@ -44,7 +45,6 @@
 #include "color_mode.xml.h"
 
 #include <string>
-#include <thread>
 
 namespace app {
 
@@ -77,22 +77,18 @@ public:
     , m_running(true)
     , m_stopFlag(false)
     , m_progress(0.0)
-    , m_thread([this,
-                sprite,
-                frame,
-                colorMode,
-                dithering,
-                toGray,
-                newBlend]() { // Copy the matrix
-      run(sprite, frame, colorMode, dithering, toGray, newBlend);
-    })
+    , m_task(doc::TaskPriority::Interactive)
   {
+    m_task.run([this, sprite, frame, colorMode, dithering, toGray, newBlend](
+                 base::task_token&) { // Copy the matrix
+      run(sprite, frame, colorMode, dithering, toGray, newBlend);
+    });
   }
 
   void stop()
   {
     m_stopFlag = true;
-    m_thread.join();
+    m_task.wait();
   }
 
   bool isRunning() const { return m_running; }
@@ -141,7 +137,7 @@ private:
   bool m_running;
   bool m_stopFlag;
   double m_progress;
-  std::thread m_thread;
+  app::Task m_task;
 };
 
 class ConversionItem : public ListItem {
@@ -232,6 +228,7 @@ public:
       m_mapAlgorithmSelector->Change.connect([this] { onIndexParamChange(); });
       m_bestFitCriteriaSelector->Change.connect([this] { onIndexParamChange(); });
       factor()->Change.connect([this] { onIndexParamChange(); });
+      serpentine()->Click.connect([this] { onIndexParamChange(); });
 
       advancedCheck()->Click.connect([this]() {
         advanced()->setVisible(advancedCheck()->isSelected());
@@ -256,8 +253,9 @@ public:
 
     progress()->setReadOnly(true);
 
-    // Default dithering factor
+    // Default dithering factor and row order
     factor()->setValue(pref.quantization.ditheringFactor());
+    serpentine()->setSelected(pref.quantization.ditheringSerpentine());
 
     // Select first option
     colorMode()->selectIndex(0);
@@ -279,6 +277,7 @@ public:
       d.matrix(m_ditheringSelector->ditheringMatrix());
     }
     d.factor(double(factor()->getValue()) / 100.0);
+    d.serpentine(serpentine()->isSelected());
     return d;
   }
 
@@ -321,6 +320,7 @@ public:
         if (m_ditheringSelector->ditheringAlgorithm() ==
             render::DitheringAlgorithm::ErrorDiffusion) {
           pref.quantization.ditheringFactor(factor()->getValue());
+          pref.quantization.ditheringSerpentine(serpentine()->isSelected());
         }
       }
     }
@@ -483,6 +483,11 @@ struct ChangePixelFormatParams : public NewParams {
     1.0,
     { "ditheringFactor", "dithering-factor" }
   };
+  Param<bool> serpentine{
+    this,
+    true,
+    { "ditheringSerpentine", "dithering-serpentine" }
+  };
   Param<doc::RgbMapAlgorithm> rgbmap{ this, RgbMapAlgorithm::DEFAULT, "rgbmap" };
   Param<gen::ToGrayAlgorithm> toGray{ this, gen::ToGrayAlgorithm::DEFAULT, "toGray" };
   Param<doc::FitCriteria> fitCriteria{ this, doc::FitCriteria::DEFAULT, "fitCriteria" };
@@ -568,6 +573,7 @@ void ChangePixelFormatCommand::onExecute(Context* ctx)
     params().dithering(window.dithering().algorithm());
     matrix = window.dithering().matrix();
     params().factor(window.dithering().factor());
+    params().serpentine(window.dithering().serpentine());
     params().rgbmap(window.rgbMapAlgorithm());
     params().fitCriteria(window.fitCriteria());
     params().toGray(window.toGray());
@@ -613,7 +619,10 @@ void ChangePixelFormatCommand::onExecute(Context* ctx)
     job.startJobWithCallback([this, &job, sprite, &matrix](Tx& tx) {
       tx(new cmd::SetPixelFormat(sprite,
                                  (PixelFormat)params().colorMode(),
-                                 render::Dithering(params().dithering(), matrix, params().factor()),
+                                 render::Dithering(params().dithering(),
+                                                   matrix,
+                                                   params().factor(),
+                                                   params().serpentine()),
                                  params().rgbmap(),
                                  get_gray_func(params().toGray()),
                                  &job, // SpriteJob is a render::TaskDelegate
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -162,6 +162,7 @@ Doc* generate_sprite_sheet_from_params(DocExporter& exporter,
                                        base::task_token& token)
 {
   const app::SpriteSheetType type = params.type();
+  const app::SpriteSheetPackAlgorithm packAlgorithm = params.packAlgorithm();
   const int columns = params.columns();
   const int rows = params.rows();
   const int width = params.width();
@@ -259,6 +260,7 @@ Doc* generate_sprite_sheet_from_params(DocExporter& exporter,
   exporter.setTextureColumns(columns);
   exporter.setTextureRows(rows);
   exporter.setSpriteSheetType(type);
+  exporter.setPackAlgorithm(packAlgorithm);
   exporter.setBorderPadding(borderPadding);
   exporter.setShapePadding(shapePadding);
   exporter.setInnerPadding(innerPadding);
@@ -325,6 +327,7 @@ public:
     , m_executionID(0)
     , m_filenameFormat(params.filenameFormat())
     , m_tagnameFormat(params.tagnameFormat())
+    , m_packAlgorithm(params.packAlgorithm())
   {
     sectionTabs()->ItemChange.connect([this] { onChangeSection(); });
     expandSections()->Click.connect([this] { onExpandSections(); });
@@ -531,6 +534,7 @@ public:
   void updateParams(ExportSpriteSheetParams& params)
   {
     params.type(spriteSheetTypeValue());
+    params.packAlgorithm(m_packAlgorithm);
     params.columns(columnsValue());
     params.rows(rowsValue());
     params.width(widthValue());
@@ -1135,6 +1139,9 @@ private:
   std::string m_filenameFormatDefault;
   std::string m_tagnameFormat;
   std::string m_tagnameFormatDefault;
+  // The pack algorithm isn't available in the dialog, we keep the
+  // one specified in params/preferences.
+  app::SpriteSheetPackAlgorithm m_packAlgorithm;
 };
 
 class ExportSpriteSheetJob : public Job {
@@ -1213,6 +1220,8 @@ void ExportSpriteSheetCommand::onExecute(Context* context)
                                                      Preferences::instance().document(nullptr));
     if (!params.type.isSet()) {
       params.type(defPref.spriteSheet.type());
+      if (!params.packAlgorithm.isSet())
+        params.packAlgorithm(defPref.spriteSheet.packAlgorithm());
       if (!params.columns.isSet())
         params.columns(defPref.spriteSheet.columns());
       if (!params.rows.isSet())
@@ -1290,6 +1299,7 @@ void ExportSpriteSheetCommand::onExecute(Context* context)
     window.updateParams(params);
     docPref.spriteSheet.defined(true);
     docPref.spriteSheet.type(params.type());
+    docPref.spriteSheet.packAlgorithm(params.packAlgorithm());
     docPref.spriteSheet.columns(params.columns());
     docPref.spriteSheet.rows(params.rows());
     docPref.spriteSheet.width(params.width());
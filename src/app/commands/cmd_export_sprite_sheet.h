@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2022-2024  Igara Studio S.A.
+// Copyright (C) 2022-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -10,6 +10,7 @@
 
 #include "app/commands/new_params.h"
 #include "app/sprite_sheet_data_format.h"
+#include "app/sprite_sheet_pack_algorithm.h"
 #include "app/sprite_sheet_type.h"
 
 #include <limits>
@@ -26,6 +27,9 @@ struct ExportSpriteSheetParams : public NewParams {
     { "askOverwrite", "ask-overwrite" }
   };
   Param<app::SpriteSheetType> type{ this, app::SpriteSheetType::None, "type" };
+  Param<app::SpriteSheetPackAlgorithm> packAlgorithm{ this,
+                                                      app::SpriteSheetPackAlgorithm::Default,
+                                                      "packAlgorithm" };
   Param<int> columns{ this, 0, "columns" };
   Param<int> rows{ this, 0, "rows" };
   Param<int> width{ this, 0, "width" };
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -19,25 +19,149 @@
 #include "app/doc_access.h"
 #include "app/doc_api.h"
 #include "app/i18n/strings.h"
+#include "app/job.h"
 #include "app/modules/gui.h"
 #include "app/pref/preferences.h"
 #include "app/tx.h"
 #include "app/ui/editor/editor.h"
 #include "app/ui/editor/select_box_state.h"
 #include "app/ui/workspace.h"
+#include "base/task.h"
 #include "doc/cel.h"
 #include "doc/image.h"
+#include "doc/images_map.h"
 #include "doc/layer.h"
 #include "doc/sprite.h"
+#include "doc/task_group.h"
 #include "render/render.h"
 #include "ui/ui.h"
 
 #include "import_sprite_sheet.xml.h"
 
+#include <algorithm>
+#include <mutex>
+
 namespace app {
 
 using namespace ui;
 
+namespace {
+
+// Number of tiles rendered by each task
+constexpr int kTilesPerTask = 16;
+
+// Renders each rectangle of the sheet in a new image (in several
+// threads), and then looks for tiles with the same pixels so they
+// can be added as linked cels. "links[i]" is the index of the first
+// tile with the same content as the tile "i" (or "i" itself). Returns
+// false if the token was canceled.
+bool slice_sprite_sheet(const Sprite* sprite,
+                        const frame_t frame,
+                        const bool newBlend,
+                        const std::vector<gfx::Rect>& tileRects,
+                        std::vector<ImageRef>& images,
+                        std::vector<std::size_t>& links,
+                        base::task_token& token)
+{
+  const std::size_t n = tileRects.size();
+  images.resize(n);
+  links.resize(n);
+
+  std::mutex mutex;
+  std::size_t rendered = 0;
+
+  doc::TaskGroup tasks(doc::TaskPriority::Interactive, &token);
+  for (std::size_t i = 0; i < n; i += kTilesPerTask) {
+    const std::size_t end = std::min(n, i + kTilesPerTask);
+    tasks.run([&, i, end] {
+      render::Render render;
+      render.setNewBlend(newBlend);
+
+      for (std::size_t j = i; j < end && !token.canceled(); ++j) {
+        const gfx::Rect& tileRect = tileRects[j];
+        ImageRef resultImage(Image::create(sprite->pixelFormat(), tileRect.w, tileRect.h));
+
+        // Render the portion of sheet.
+        render.renderSprite(resultImage.get(), sprite, frame, gfx::Clip(0, 0, tileRect));
+
+        // Calculate the hash in this thread to compare the tiles later
+        resultImage->contentHash();
+        images[j] = resultImage;
+      }
+
+      const std::lock_guard lock(mutex);
+      rendered += end - i;
+      token.set_progress(float(rendered) / float(n));
+    });
+  }
+  tasks.wait();
+
+  if (token.canceled())
+    return false;
+
+  ImagesMap map;
+  for (std::size_t i = 0; i < n; ++i) {
+    auto it = map.find(images[i]);
+    if (it != map.end()) {
+      links[i] = it->second;
+      images[i] = images[links[i]];
+    }
+    else {
+      map[images[i]] = uint32_t(i);
+      links[i] = i;
+    }
+  }
+  return true;
+}
+
+class ImportSpriteSheetJob : public Job {
+public:
+  ImportSpriteSheetJob(const Sprite* sprite,
+                       const frame_t frame,
+                       const bool newBlend,
+                       const std::vector<gfx::Rect>& tileRects,
+                       std::vector<ImageRef>& images,
+                       std::vector<std::size_t>& links)
+    : Job(Strings::import_sprite_sheet_title(), true)
+    , m_sprite(sprite)
+    , m_frame(frame)
+    , m_newBlend(newBlend)
+    , m_tileRects(tileRects)
+    , m_images(images)
+    , m_links(links)
+  {
+  }
+
+  bool ok() const { return m_ok; }
+
+private:
+  void onJob() override
+  {
+    m_ok =
+      slice_sprite_sheet(m_sprite, m_frame, m_newBlend, m_tileRects, m_images, m_links, m_token);
+  }
+
+  void onMonitoringTick() override
+  {
+    Job::onMonitoringTick();
+    if (isCanceled())
+      m_token.cancel();
+    else
+      jobProgress(m_token.progress());
+  }
+
+  base::task_token m_token;
+  const Sprite* m_sprite;
+  const frame_t m_frame;
+  const bool m_newBlend;
+  const std::vector<gfx::Rect>& m_tileRects;
+  std::vector<ImageRef>& m_images;
+  std::vector<std::size_t>& m_links;
+  bool m_ok = false;
+};
+
+} // anonymous namespace
+
 gfx::Size calcFrameSize(gfx::Size availSize,
                         int cols,
                         int rows,
@@ -567,16 +691,17 @@ void ImportSpriteSheetCommand::onExecute(Context* context)
     }
   }
 
-  // The list of frames imported from the sheet
+  // The list of frames imported from the sheet, and the index of the
+  // frame to link each cel
   std::vector<ImageRef> animation;
+  std::vector<std::size_t> links;
 
   try {
     Sprite* sprite = document->sprite();
     frame_t currentFrame = context->activeSite().frame();
     gfx::Rect frameBounds = params.frameBounds();
     const gfx::Size padding = params.padding();
-    render::Render render;
-    render.setNewBlend(Preferences::instance().experimental.newBlend());
+    const bool newBlend = Preferences::instance().experimental.newBlend();
 
     if (frameBounds.isEmpty())
       frameBounds = sprite->bounds();
@@ -623,21 +748,26 @@ void ImportSpriteSheetCommand::onExecute(Context* context)
         break;
     }
 
-    // As first step, we cut each tile and add them into "animation" list.
-    for (const auto& tileRect : tileRects) {
-      ImageRef resultImage(Image::create(sprite->pixelFormat(), tileRect.w, tileRect.h));
-
-      // Render the portion of sheet.
-      render.renderSprite(resultImage.get(), sprite, currentFrame, gfx::Clip(0, 0, tileRect));
-
-      animation.push_back(resultImage);
-    }
-
-    if (animation.size() == 0) {
+    if (tileRects.empty()) {
       Alert::show(Strings::alerts_empty_rect_importing_sprite_sheet());
       return;
     }
 
+    // As first step, we cut each tile and add them into "animation"
+    // list. This is done in a background job (which can be canceled)
+    // when the UI is available.
+    if (context->isUIAvailable() && params.ui()) {
+      ImportSpriteSheetJob job(sprite, currentFrame, newBlend, tileRects, animation, links);
+      job.startJob();
+      job.waitJob();
+      if (!job.ok())
+        return;
+    }
+    else {
+      base::task_token token;
+      slice_sprite_sheet(sprite, currentFrame, newBlend, tileRects, animation, links, token);
+    }
+
     // The following steps modify the sprite, so we wrap all
     // operations in a undo-transaction.
     ContextWriter writer(context);
@@ -648,10 +778,15 @@ void ImportSpriteSheetCommand::onExecute(Context* context)
     LayerImage* resultLayer = api.newLayer(sprite->root(),
                                            Strings::import_sprite_sheet_layer_name());
 
-    // Add all frames+cels to the new layer
+    // Add all frames+cels to the new layer (tiles with the same
+    // pixels are added as linked cels)
     for (size_t i = 0; i < animation.size(); ++i) {
       // Create the cel.
-      std::unique_ptr<Cel> resultCel(new Cel(frame_t(i), animation[i]));
+      std::unique_ptr<Cel> resultCel;
+      if (links[i] != i)
+        resultCel.reset(Cel::MakeLink(frame_t(i), resultLayer->cel(frame_t(links[i]))));
+      else
+        resultCel.reset(new Cel(frame_t(i), animation[i]));
 
       // Add the cel in the layer.
       api.addCel(resultLayer, resultCel.get());
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2015-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -15,6 +15,7 @@
 #include "app/context_access.h"
 #include "app/doc.h"
 #include "app/i18n/strings.h"
+#include "app/job.h"
 #include "app/modules/gui.h"
 #include "app/pref/preferences.h"
 #include "app/tx.h"
@@ -31,6 +32,44 @@ typedef doc::algorithm::SelectionModifier Modifier;
 
 class ModifySelectionWindow : public app::gen::ModifySelection {};
 
+// Modifies the selection in a background thread (big radius or
+// selections can take some time) showing a progress bar.
+class ModifySelectionJob : public Job,
+                           public doc::algorithm::ModifySelectionDelegate {
+public:
+  ModifySelectionJob(const std::string& jobName,
+                     const Modifier modifier,
+                     const Mask* srcMask,
+                     Mask* dstMask,
+                     const int radius,
+                     const doc::BrushType brush,
+                     const bool showProgress)
+    : Job(jobName, showProgress)
+    , m_modifier(modifier)
+    , m_srcMask(srcMask)
+    , m_dstMask(dstMask)
+    , m_radius(radius)
+    , m_brush(brush)
+  {
+  }
+
+private:
+  void onJob() override
+  {
+    doc::algorithm::modify_selection(m_modifier, m_srcMask, m_dstMask, m_radius, m_brush, this);
+  }
+
+  // doc::algorithm::ModifySelectionDelegate impl
+  void notifyProgress(double progress) override { jobProgress(progress); }
+  bool continueTask() override { return !isCanceled(); }
+
+  Modifier m_modifier;
+  const Mask* m_srcMask;
+  Mask* m_dstMask;
+  int m_radius;
+  doc::BrushType m_brush;
+};
+
 class ModifySelectionCommand : public Command {
 public:
   ModifySelectionCommand();
@@ -136,8 +175,20 @@ void ModifySelectionCommand::onExecute(Context* context)
   {
     mask->reserve(sprite->bounds());
     mask->freeze();
-    doc::algorithm::modify_selection(m_modifier, document->mask(), mask.get(), quantity, brush);
+
+    ModifySelectionJob job(friendlyName(),
+                           m_modifier,
+                           document->mask(),
+                           mask.get(),
+                           quantity,
+                           brush,
+                           m_ui && context->isUIAvailable());
+    job.startJob();
+    job.waitJob();
+
     mask->unfreeze();
+    if (job.isCanceled())
+      return;
   }
 
   // Set the new mask
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -24,7 +24,9 @@
 #include "app/ui/status_bar.h"
 #include "app/ui_context.h"
 #include "app/util/open_file_job.h"
+#include "base/convert_to.h"
 #include "base/fs.h"
+#include "base/split_string.h"
 #include "doc/sprite.h"
 #include "ui/ui.h"
 
@@ -54,6 +56,36 @@ void OpenFileCommand::onLoadParams(const Params& params)
   m_repeatCheckbox = params.get_as<bool>("repeat_checkbox");
   m_oneFrame = params.get_as<bool>("oneframe");
 
+  // Region of interest to load in "x,y,w,h" format (only the file
+  // formats that support it decode less pixels)
+  m_roiBounds = gfx::Rect();
+  if (params.has_param("roi")) {
+    std::vector<std::string> parts;
+    base::split_string(params.get("roi"), parts, ",");
+    if (parts.size() == 4) {
+      m_roiBounds.x = base::convert_to<int>(parts[0]);
+      m_roiBounds.y = base::convert_to<int>(parts[1]);
+      m_roiBounds.w = base::convert_to<int>(parts[2]);
+      m_roiBounds.h = base::convert_to<int>(parts[3]);
+    }
+  }
+
+  // Tag, frames ("from,to", relative to the tag), and layers
+  // (separated by comma) to load (only the file formats that support
+  // it skip the other cels)
+  m_roiTag = params.get("roi_tag");
+  m_roiFrames.clear();
+  if (params.has_param("roi_frames")) {
+    std::vector<std::string> parts;
+    base::split_string(params.get("roi_frames"), parts, ",");
+    if (parts.size() == 2)
+      m_roiFrames.insert(base::convert_to<doc::frame_t>(parts[0]),
+                         base::convert_to<doc::frame_t>(parts[1]));
+  }
+  m_roiLayers.clear();
+  if (params.has_param("roi_layers"))
+    base::split_string(params.get("roi_layers"), m_roiLayers, ",");
+
   std::string sequence = params.get("sequence");
   if (m_oneFrame || sequence == "skip" || sequence == "no") {
     m_seqDecision = gen::SequenceDecision::NO;
@@ -139,6 +171,18 @@ void OpenFileCommand::onExecute(Context* context)
     if (!fop)
       return;
 
+    if (!m_roiBounds.isEmpty() || !m_roiTag.empty() || !m_roiFrames.empty() ||
+        !m_roiLayers.empty()) {
+      FileOpROI roi(nullptr,
+                    m_roiBounds,
+                    std::string(),
+                    m_roiTag,
+                    doc::FramesSequence(m_roiFrames),
+                    true);
+      roi.setLayersToLoad(m_roiLayers);
+      fop->setLoadROI(roi);
+    }
+
     if (fop->hasError()) {
       console.printf(fop->error().c_str());
       unrecent = true;
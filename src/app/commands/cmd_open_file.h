@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2024  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2016-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -13,8 +13,11 @@
 #include "app/commands/params.h"
 #include "app/pref/preferences.h"
 #include "base/paths.h"
+#include "doc/selected_frames.h"
+#include "gfx/rect.h"
 
 #include <string>
+#include <vector>
 
 namespace app {
 
@@ -37,6 +40,10 @@ private:
   bool m_ui;
   bool m_repeatCheckbox;
   bool m_oneFrame;
+  gfx::Rect m_roiBounds;
+  std::string m_roiTag;
+  doc::SelectedFrames m_roiFrames;
+  std::vector<std::string> m_roiLayers;
   base::paths m_usedFiles;
   gen::SequenceDecision m_seqDecision;
 };
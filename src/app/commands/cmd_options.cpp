@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -734,6 +734,7 @@ public:
 
     // Aseprite format preferences
     celFormat()->setSelectedItemIndex(int(m_pref.asepriteFormat.celFormat()));
+    compressionProfile()->setSelectedItemIndex(int(m_pref.asepriteFormat.compression()));
     onCelFormatChange();
   }
 
@@ -919,6 +920,8 @@ public:
 
     // Aseprite format preferences
     m_pref.asepriteFormat.celFormat(gen::CelContentFormat(celFormat()->getSelectedItemIndex()));
+    m_pref.asepriteFormat.compression(
+      gen::CompressionProfile(compressionProfile()->getSelectedItemIndex()));
 
     // Experimental features
     m_pref.experimental.useSelectionToolLoop(useSelectionToolLoop()->isSelected());
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -222,6 +222,8 @@ void SaveFileBaseCommand::saveDocumentInBackground(const Context* context,
   if (resizeOnTheFly == ResizeOnTheFly::On)
     fop->setOnTheFlyScale(scale);
 
+  fop->setIncremental(params().incremental());
+
   SaveFileJob job(fop.get(), params().ui());
   job.showProgressWindow();
 
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2021-2024  Igara Studio S.A.
+// Copyright (C) 2021-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -56,6 +56,7 @@ struct SaveFileParams : public NewParams {
     { "toFrame", "to-frame" }
   };
   Param<bool> ignoreEmpty{ this, false, "ignoreEmpty" };
+  Param<bool> incremental{ this, false, "incremental" };
   Param<double> scale{ this, 1.0, "scale" };
   Param<gfx::Rect> bounds{ this, gfx::Rect(), "bounds" };
   Param<bool> playSubtags{ this, false, "playSubtags" };
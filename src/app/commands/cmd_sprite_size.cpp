@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -21,6 +21,7 @@
 #include "app/modules/gui.h"
 #include "app/modules/palettes.h"
 #include "app/sprite_job.h"
+#include "app/task_scheduler.h"
 #include "app/util/resize_image.h"
 #include "base/convert_to.h"
 #include "doc/algorithm/resize_image.h"
@@ -33,12 +34,14 @@
 #include "doc/primitives.h"
 #include "doc/slice.h"
 #include "doc/sprite.h"
+#include "doc/task_group.h"
 #include "doc/tilesets.h"
 #include "ui/ui.h"
 
 #include "sprite_size.xml.h"
 
 #include <algorithm>
+#include <vector>
 
 #define PERC_FORMAT "%.4g"
 
@@ -47,6 +50,15 @@ namespace app {
 using namespace ui;
 using doc::algorithm::ResizeMethod;
 
+namespace {
+
+int sprite_size_threads()
+{
+  return TaskScheduler::instance()->threads();
+}
+
+} // anonymous namespace
+
 struct SpriteSizeParams : public NewParams {
   Param<bool> ui{
     this,
@@ -91,6 +103,30 @@ class SpriteSizeJob : public SpriteJob {
     return gfx::RectT<T>(x1, y1, scale_x(rc.x2()) - x1, scale_y(rc.y2()) - y1);
   }
 
+  // Indexed images resized with the bilinear method use the RgbMap
+  // of the sprite, which cannot be used from several threads.
+  bool canResizeCelsInParallel() const
+  {
+    return (sprite_size_threads() > 1 &&
+            (sprite()->pixelFormat() != IMAGE_INDEXED ||
+             m_resize_method != doc::algorithm::RESIZE_METHOD_BILINEAR));
+  }
+
+  // [working thread]
+  void resizeCelImagesInParallel(const std::vector<Cel*>& cels,
+                                 const gfx::SizeF& scale,
+                                 std::vector<ImageRef>& images)
+  {
+    doc::TaskGroup tasks;
+    for (int i = 0; i < int(cels.size()); ++i) {
+      tasks.run([this, i, &cels, &scale, &images] {
+        if (!cels[i]->layer()->isTilemap())
+          images[i] = create_resized_cel_image(cels[i], scale, m_resize_method);
+      });
+    }
+    tasks.wait();
+  }
+
 public:
   SpriteSizeJob(Context* ctx,
                 Doc* doc,
@@ -172,29 +208,49 @@ protected:
       }
     }
 
-    // For each cel...
-    for (Cel* cel : sprite()->uniqueCels()) {
-      // We need to adjust only the origin/position of tilemap cels
-      // (because tiles are resized automatically when we resize the
-      // tileset).
-      if (cel->layer()->isTilemap()) {
-        Tileset* tileset = static_cast<LayerTilemap*>(cel->layer())->tileset();
-        gfx::Size canvasSize = tileset->grid().tilemapSizeToCanvas(
-          gfx::Size(cel->image()->width(), cel->image()->height()));
-        gfx::Rect newBounds(cel->x() * scale.w, cel->y() * scale.h, canvasSize.w, canvasSize.h);
-        tx(new cmd::SetCelBoundsF(cel, newBounds));
-      }
-      else {
-        resize_cel_image(tx,
-                         cel,
-                         scale,
-                         m_resize_method,
-                         cel->layer()->isReference() ? -cel->boundsF().origin() :
-                                                       gfx::PointF(-cel->bounds().origin()));
-      }
+    // Resize the images of the cels in groups (one cel for each
+    // thread), and then add the commands of each group to the
+    // transaction in the same order of the cels.
+    std::vector<Cel*> cels;
+    for (Cel* cel : sprite()->uniqueCels())
+      cels.push_back(cel);
+
+    const int nthreads = (canResizeCelsInParallel() ? sprite_size_threads() : 1);
+    for (auto it = cels.begin(); it != cels.end();) {
+      std::vector<Cel*> group;
+      for (; it != cels.end() && int(group.size()) < nthreads; ++it)
+        group.push_back(*it);
+
+      std::vector<ImageRef> images(group.size());
+      if (group.size() > 1)
+        resizeCelImagesInParallel(group, scale, images);
+
+      for (int i = 0; i < int(group.size()); ++i) {
+        Cel* cel = group[i];
+
+        // We need to adjust only the origin/position of tilemap cels
+        // (because tiles are resized automatically when we resize the
+        // tileset).
+        if (cel->layer()->isTilemap()) {
+          Tileset* tileset = static_cast<LayerTilemap*>(cel->layer())->tileset();
+          gfx::Size canvasSize = tileset->grid().tilemapSizeToCanvas(
+            gfx::Size(cel->image()->width(), cel->image()->height()));
+          gfx::Rect newBounds(cel->x() * scale.w, cel->y() * scale.h, canvasSize.w, canvasSize.h);
+          tx(new cmd::SetCelBoundsF(cel, newBounds));
+        }
+        else {
+          resize_cel_image(tx,
+                           cel,
+                           scale,
+                           m_resize_method,
+                           cel->layer()->isReference() ? -cel->boundsF().origin() :
+                                                         gfx::PointF(-cel->bounds().origin()),
+                           images[i]);
+        }
 
-      jobProgress((float)progress / img_count);
-      ++progress;
+        jobProgress((float)progress / img_count);
+        ++progress;
+      }
 
       // Cancel all the operation?
       if (isCanceled())
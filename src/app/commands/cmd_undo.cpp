@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2025  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -87,14 +87,14 @@ void UndoCommand::onExecute(Context* context)
     }
   }
 
-  // Get the stream to deserialize the document range after executing
-  // the undo/redo action. We cannot yet deserialize the document
-  // range because there could be inexistent layers.
-  std::istream* docRangeStream;
+  // Get the snapshot to restore the document range after executing
+  // the undo/redo action. We cannot yet restore the document range
+  // because there could be inexistent layers.
+  const view::RangeSnapshot* docRangeSnapshot;
   if (m_type == Undo)
-    docRangeStream = undo->nextUndoDocRange();
+    docRangeSnapshot = undo->nextUndoDocRange();
   else
-    docRangeStream = undo->nextRedoDocRange();
+    docRangeSnapshot = undo->nextRedoDocRange();
 
   StatusBar* statusbar = StatusBar::instance();
   if (statusbar) {
@@ -130,12 +130,12 @@ void UndoCommand::onExecute(Context* context)
     }
   }
 
-  // Update timeline range. We've to deserialize the DocRange at
-  // this point when objects (possible layers) are re-created after
-  // the undo and we can deserialize them.
-  if (docRangeStream) {
+  // Update timeline range. We've to restore the DocRange at this
+  // point when objects (possible layers) are re-created after the
+  // undo and we can find them.
+  if (docRangeSnapshot) {
     view::Range docRange;
-    if (docRange.read(*docRangeStream))
+    if (docRange.restore(*docRangeSnapshot))
       context->setRange(docRange);
   }
 
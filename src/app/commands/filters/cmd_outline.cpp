@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -33,6 +33,8 @@
 
 #include "outline.xml.h"
 
+#include <algorithm>
+
 namespace app {
 
 using namespace app::skin;
@@ -44,6 +46,7 @@ struct OutlineParams : public NewParams {
   Param<filters::Target> channels{ this, 0, "channels" };
   Param<filters::OutlineFilter::Place> place{ this, OutlineFilter::Place::Outside, "place" };
   Param<filters::OutlineFilter::Matrix> matrix{ this, OutlineFilter::Matrix::Circle, "matrix" };
+  Param<int> thickness{ this, 1, "thickness" };
   Param<app::Color> color{ this, app::Color(), "color" };
   Param<app::Color> bgColor{ this, app::Color(), "bgColor" };
   Param<filters::TiledMode> tiledMode{ this, filters::TiledMode::NONE, "tiledMode" };
@@ -95,6 +98,7 @@ public:
     m_panel.color()->setColor(m_filter.color());
     m_panel.bgColor()->setColor(m_filter.bgColor());
     m_panel.place()->setSelectedItem((int)m_filter.place());
+    m_panel.thickness()->setValue(m_filter.thickness());
     updateButtonsFromMatrix();
 
     m_panel.color()->Change.connect(&OutlineWindow::onColorChange, this);
@@ -106,6 +110,7 @@ public:
     m_panel.place()->ItemChange.connect([this](ButtonSet::Item*) {
       onPlaceChange((OutlineFilter::Place)m_panel.place()->selectedItem());
     });
+    m_panel.thickness()->Change.connect([this] { onThicknessChange(); });
   }
 
 private:
@@ -153,6 +158,13 @@ private:
     restartPreview();
   }
 
+  void onThicknessChange()
+  {
+    stopPreview();
+    m_filter.thickness(m_panel.thickness()->getValue());
+    restartPreview();
+  }
+
   void onMatrixTypeChange()
   {
     stopPreview();
@@ -228,6 +240,7 @@ void OutlineCommand::onExecute(Context* context)
     filter.matrix((OutlineFilter::Matrix)get_config_int(ConfigSection,
                                                         "Matrix",
                                                         int(OutlineFilter::Matrix::Circle)));
+    filter.thickness(get_config_int(ConfigSection, "Thickness", 1));
     filter.color(ColorBar::instance()->getFgColor());
 
     DocumentPreferences& docPref = Preferences::instance().document(site.document());
@@ -238,6 +251,8 @@ void OutlineCommand::onExecute(Context* context)
     filter.place(params().place());
   if (params().matrix.isSet())
     filter.matrix(params().matrix());
+  if (params().thickness.isSet())
+    filter.thickness(std::max(1, params().thickness()));
   if (params().color.isSet())
     filter.color(params().color());
   if (params().bgColor.isSet())
@@ -259,6 +274,7 @@ void OutlineCommand::onExecute(Context* context)
     if (window.doModal()) {
       set_config_int(ConfigSection, "Place", int(filter.place()));
       set_config_int(ConfigSection, "Matrix", int(filter.matrix()));
+      set_config_int(ConfigSection, "Thickness", filter.thickness());
     }
   }
   else {
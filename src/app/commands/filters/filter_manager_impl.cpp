@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -12,6 +12,7 @@
 #include "app/commands/filters/filter_manager_impl.h"
 
 #include "app/app.h"
+#include "app/commands/filters/filter_shader.h"
 #include "app/cmd/copy_region.h"
 #include "app/cmd/patch_cel.h"
 #include "app/cmd/set_palette.h"
@@ -20,7 +21,9 @@
 #include "app/doc.h"
 #include "app/ini_file.h"
 #include "app/modules/palettes.h"
+#include "app/pref/preferences.h"
 #include "app/site.h"
+#include "app/task_scheduler.h"
 #include "app/transaction.h"
 #include "app/ui/color_bar.h"
 #include "app/ui/editor/editor.h"
@@ -32,18 +35,26 @@
 #include "doc/cel.h"
 #include "doc/cels_range.h"
 #include "doc/image.h"
+#include "doc/image_buffer_pool.h"
 #include "doc/layer.h"
 #include "doc/mask.h"
 #include "doc/palette.h"
+#include "doc/rgbmap.h"
 #include "doc/sprite.h"
+#include "doc/task_group.h"
 #include "filters/filter.h"
 #include "ui/manager.h"
 #include "ui/view.h"
 #include "ui/widget.h"
 #include "view/cels.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdlib>
 #include <cstring>
+#include <mutex>
 #include <set>
 
 namespace app {
@@ -51,6 +62,189 @@ namespace app {
 using namespace std;
 using namespace ui;
 
+namespace {
+
+// Number of consecutive rows filtered by each task of
+// applyRowsInParallel(). Filters like the median or convolution
+// matrices reuse information from the previous row, so we don't want
+// to split the rows in too small pieces.
+const int kRowsPerTask = 32;
+
+int filters_threads()
+{
+  return TaskScheduler::instance()->threads();
+}
+
+// Maximum number of unique colors in an image to filter its colors
+// instead of its pixels. It must be the half of the hash table size
+// (so there are always empty slots).
+const int kUniqueColorsBits = 11;
+const int kMaxUniqueColors = (1 << (kUniqueColorsBits - 1));
+
+// Minimum number of pixels for each unique color to use the unique
+// colors (if there are too many colors for the number of pixels, it's
+// faster to filter each pixel).
+const int kPixelsPerUniqueColor = 16;
+
+// Hash table (with open addressing) to collect the different colors
+// of an image and find the index of each one.
+class UniqueColors {
+public:
+  explicit UniqueColors(const int maxColors)
+    : m_maxColors(maxColors)
+    , m_slots(1 << kUniqueColorsBits, -1)
+  {
+    ASSERT(maxColors <= kMaxUniqueColors);
+    m_colors.reserve(maxColors);
+  }
+
+  const std::vector<color_t>& colors() const { return m_colors; }
+
+  // Adds the color to the table, returns false if there are too many
+  // colors.
+  bool insert(const color_t color)
+  {
+    int& index = m_slots[slot(color)];
+    if (index < 0) {
+      if (int(m_colors.size()) == m_maxColors)
+        return false;
+      index = int(m_colors.size());
+      m_colors.push_back(color);
+    }
+    return true;
+  }
+
+  // Returns the index in colors() of a color previously inserted.
+  int find(const color_t color) const { return m_slots[slot(color)]; }
+
+private:
+  int slot(const color_t color) const
+  {
+    const int mask = (1 << kUniqueColorsBits) - 1;
+    int i = int((color * 2654435761u) >> (32 - kUniqueColorsBits));
+    while (m_slots[i] >= 0 && m_colors[m_slots[i]] != color)
+      i = (i + 1) & mask;
+    return i;
+  }
+
+  int m_maxColors;
+  std::vector<int> m_slots;
+  std::vector<color_t> m_colors;
+};
+
+} // anonymous namespace
+
+// FilterManager used to apply the filter to a range of rows from a
+// thread of the pool. Each worker has its own current row and mask
+// iterator, the rest of the information is taken from the
+// FilterManagerImpl.
+class FilterManagerImpl::RowsWorker : public FilterManager {
+public:
+  RowsWorker(FilterManagerImpl* mgr, const CelImages& images, const int firstRow)
+    : m_mgr(mgr)
+    , m_images(images)
+    , m_firstRow(firstRow)
+    , m_row(firstRow)
+  {
+  }
+
+  // Applies the filter to rows [firstRow, endRow), "doneRows" is
+  // incremented after each row (if it's not nullptr).
+  void apply(Filter* filter, const int endRow, std::atomic<int>* doneRows = nullptr)
+  {
+    for (; m_row < endRow && !taskToken().canceled(); ++m_row) {
+      if (!m_mgr->lockMaskRow(m_row, m_maskBits, m_maskIterator))
+        break;
+
+      switch (pixelFormat()) {
+        case IMAGE_RGB:       filter->applyToRgba(this); break;
+        case IMAGE_GRAYSCALE: filter->applyToGrayscale(this); break;
+        case IMAGE_INDEXED:   filter->applyToIndexed(this); break;
+      }
+
+      if (doneRows)
+        ++(*doneRows);
+    }
+  }
+
+  // FilterManager implementation
+  doc::PixelFormat pixelFormat() const override { return m_mgr->pixelFormat(); }
+  const void* getSourceAddress() override
+  {
+    return m_images.src->getPixelAddress(m_mgr->m_bounds.x, m_mgr->m_bounds.y + m_row);
+  }
+  void* getDestinationAddress() override
+  {
+    return m_images.dst->getPixelAddress(m_mgr->m_bounds.x, m_mgr->m_bounds.y + m_row);
+  }
+  int getWidth() override { return m_mgr->m_bounds.w; }
+  Target getTarget() override { return m_images.target; }
+  FilterIndexedData* getIndexedData() override { return m_mgr; }
+  bool skipPixel() override
+  {
+    bool skip = false;
+
+    if ((m_mgr->m_mask) && (m_mgr->m_mask->bitmap())) {
+      if (!*m_maskIterator)
+        skip = true;
+
+      ++m_maskIterator;
+    }
+
+    return skip;
+  }
+  const doc::Image* getSourceImage() override { return m_images.src.get(); }
+  int x() const override { return m_mgr->m_bounds.x; }
+  int y() const override { return m_mgr->m_bounds.y + m_row; }
+  bool isFirstRow() const override { return m_row == m_firstRow; }
+  bool isMaskActive() const override { return m_mgr->isMaskActive(); }
+  base::task_token& taskToken() const override { return m_mgr->taskToken(); }
+
+private:
+  FilterManagerImpl* m_mgr;
+  const CelImages& m_images;
+  int m_firstRow;
+  int m_row;
+  doc::ImageBits<doc::BitmapTraits> m_maskBits;
+  doc::ImageBits<doc::BitmapTraits>::iterator m_maskIterator;
+};
+
+// FilterManager used to apply the filter to one row with the unique
+// colors of an image (see FilterManagerImpl::applyToUniqueColors()).
+class FilterManagerImpl::ColorsWorker : public FilterManager {
+public:
+  ColorsWorker(FilterManagerImpl* mgr, Image* src, Image* dst, const Target target)
+    : m_mgr(mgr)
+    , m_src(src)
+    , m_dst(dst)
+    , m_target(target)
+  {
+  }
+
+  void apply(Filter* filter) { filter->applyToRgba(this); }
+
+  // FilterManager implementation
+  doc::PixelFormat pixelFormat() const override { return IMAGE_RGB; }
+  const void* getSourceAddress() override { return m_src->getPixelAddress(0, 0); }
+  void* getDestinationAddress() override { return m_dst->getPixelAddress(0, 0); }
+  int getWidth() override { return m_src->width(); }
+  Target getTarget() override { return m_target; }
+  FilterIndexedData* getIndexedData() override { return m_mgr; }
+  bool skipPixel() override { return false; }
+  const doc::Image* getSourceImage() override { return m_src; }
+  int x() const override { return 0; }
+  int y() const override { return 0; }
+  bool isFirstRow() const override { return true; }
+  bool isMaskActive() const override { return m_mgr->isMaskActive(); }
+  base::task_token& taskToken() const override { return m_mgr->taskToken(); }
+
+private:
+  FilterManagerImpl* m_mgr;
+  Image* m_src;
+  Image* m_dst;
+  Target m_target;
+};
+
 FilterManagerImpl::FilterManagerImpl(Context* context, Filter* filter)
   : m_reader(context)
   , m_site(const_cast<Site&>(m_reader.site()))
@@ -67,6 +261,7 @@ FilterManagerImpl::FilterManagerImpl(Context* context, Filter* filter)
   , m_oldPalette(nullptr)
   , m_taskToken(&m_noToken)
   , m_progressDelegate(nullptr)
+  , m_useShaders(Preferences::instance().experimental.useShadersForFilters())
 {
   int x, y;
   Image* image = m_site.image(&x, &y);
@@ -120,7 +315,9 @@ void FilterManagerImpl::begin()
 
   m_row = 0;
   m_mask = (document->isMaskVisible() ? document->mask() : nullptr);
+  m_previewMask.reset(nullptr);
   m_taskToken = &m_noToken; // Don't use the preview token (which can be canceled)
+  m_threadFilters.clear();
   updateBounds(m_mask);
 }
 
@@ -128,39 +325,74 @@ void FilterManagerImpl::beginForPreview()
 {
   Doc* document = m_site.document();
 
-  if (document->isMaskVisible())
-    m_previewMask.reset(new Mask(*document->mask()));
-  else {
-    m_previewMask.reset(new Mask());
-    m_previewMask->replace(m_site.sprite()->bounds());
-  }
-
-  m_row = m_nextRowToFlush = 0;
-  m_mask = m_previewMask.get();
+  // The filter settings could be different from the last preview
+  m_threadFilters.clear();
 
-  // If we have a tiled mode enabled, we'll apply the filter to the whole areaes
+  // We start filtering the visible area of the sprite in all editors,
+  // and then the preview area is expanded progressively (see
+  // expandPreviewArea()). If we have a tiled mode enabled, we'll
+  // apply the filter to the whole area.
+  gfx::Rect area = m_site.sprite()->bounds();
   Editor* activeEditor = UIContext::instance()->activeEditor();
   if (activeEditor->docPref().tiled.mode() == filters::TiledMode::NONE) {
     gfx::Rect vp;
     for (Editor* editor : UIContext::instance()->getAllEditorsIncludingPreview(document)) {
       vp |= editor->screenToEditor(View::getView(editor)->viewportBounds());
     }
-    vp &= m_site.sprite()->bounds();
-    if (vp.isEmpty()) {
-      m_previewMask.reset(nullptr);
-      m_row = -1;
-      return;
-    }
-    m_previewMask->intersect(vp);
+    area &= vp;
   }
 
-  if (!updateBounds(m_mask)) {
+  m_previewArea = gfx::Rect();
+  if (area.isEmpty() || (!beginPreviewArea(area) && !expandPreviewArea())) {
     m_previewMask.reset(nullptr);
     m_row = -1;
-    return;
   }
 }
 
+bool FilterManagerImpl::beginPreviewArea(const gfx::Rect& area)
+{
+  Doc* document = m_site.document();
+
+  if (document->isMaskVisible())
+    m_previewMask.reset(new Mask(*document->mask()));
+  else {
+    m_previewMask.reset(new Mask());
+    m_previewMask->replace(m_site.sprite()->bounds());
+  }
+
+  // Filter only the pixels that weren't filtered in previous areas
+  m_previewMask->intersect(area);
+  if (!m_previewArea.isEmpty())
+    m_previewMask->subtract(m_previewArea);
+  m_previewArea = area;
+
+  m_row = m_nextRowToFlush = 0;
+  m_mask = m_previewMask.get();
+
+  return (!m_previewMask->isEmpty() && !m_previewMask->bounds().isEmpty() &&
+          updateBounds(m_mask));
+}
+
+bool FilterManagerImpl::expandPreviewArea()
+{
+  const gfx::Rect spriteBounds = m_site.sprite()->bounds();
+
+  // Each new area doubles the size of the previous one (until it
+  // covers the whole sprite), skipping areas without selected pixels
+  while ((m_previewArea & spriteBounds) != spriteBounds) {
+    const int dx = std::max(1, m_previewArea.w / 2);
+    const int dy = std::max(1, m_previewArea.h / 2);
+    const gfx::Rect area = gfx::Rect(m_previewArea.x - dx,
+                                     m_previewArea.y - dy,
+                                     m_previewArea.w + 2 * dx,
+                                     m_previewArea.h + 2 * dy) &
+                           spriteBounds;
+    if (beginPreviewArea(area))
+      return true;
+  }
+  return false;
+}
+
 void FilterManagerImpl::end()
 {
   m_maskBits.unlock();
@@ -168,23 +400,56 @@ void FilterManagerImpl::end()
 
 bool FilterManagerImpl::applyStep()
 {
-  if (m_row < 0 || m_row >= m_bounds.h)
+  if (m_row < 0)
     return false;
 
-  if (m_mask && m_mask->bitmap()) {
-    int x = m_bounds.x - m_mask->bounds().x;
-    int y = m_bounds.y - m_mask->bounds().y + m_row;
-    if ((x >= m_bounds.w) || (y >= m_bounds.h))
+  if (m_row >= m_bounds.h) {
+    if (!m_previewMask)
       return false;
 
-    m_maskBits = m_mask->bitmap()->lockBits<BitmapTraits>(
-      Image::ReadLock,
-      gfx::Rect(x, y, m_bounds.w - x, m_bounds.h - y));
+    // Wait until the last rows are flushed to the screen before we
+    // continue with the next area of the preview
+    if (m_nextRowToFlush <= m_row)
+      return true;
 
-    m_maskIterator = m_maskBits.begin();
+    if (!expandPreviewArea())
+      return false;
   }
 
-  if (m_row == 0) {
+  // Apply the filter to all rows in one step if we can filter the
+  // unique colors of the image
+  if (m_row == 0 && m_filter->isPointwise()) {
+    applyToPaletteIfNeeded();
+
+    const CelImages images = { m_cel, m_src, m_dst, m_target };
+    if (applyToUniqueColors(m_filter, images)) {
+      m_row = m_bounds.h;
+      return true;
+    }
+  }
+
+  // Apply the filter to the whole image with a shader
+  if (m_row == 0 && m_useShaders && applyWithShader()) {
+    m_row = m_bounds.h;
+    return true;
+  }
+
+  // Apply the filter to several rows in each step (one set of rows
+  // for each thread)
+  if (canApplyInParallel()) {
+    if (m_row == 0 && !m_filter->isPointwise())
+      applyToPaletteIfNeeded();
+
+    const int rows = std::min(m_bounds.h - m_row, filters_threads() * kRowsPerTask);
+    applyRowsInParallel(m_row, rows);
+    m_row += rows;
+    return true;
+  }
+
+  if (!lockMaskRow(m_row, m_maskBits, m_maskIterator))
+    return false;
+
+  if (m_row == 0 && !m_filter->isPointwise()) {
     applyToPaletteIfNeeded();
   }
 
@@ -216,33 +481,7 @@ void FilterManagerImpl::apply()
   }
 
   if (!cancelled) {
-    gfx::Rect output;
-    if (algorithm::shrink_bounds2(m_src.get(), m_dst.get(), m_bounds, output)) {
-      if (m_cel->layer()->isTilemap()) {
-        modify_tilemap_cel_region(*m_tx,
-                                  m_cel,
-                                  nullptr,
-                                  gfx::Region(output),
-                                  m_site.tilesetMode(),
-                                  [this](const doc::ImageRef& origTile,
-                                         const gfx::Rect& tileBoundsInCanvas) -> doc::ImageRef {
-                                    return ImageRef(crop_image(m_dst.get(),
-                                                               tileBoundsInCanvas.x,
-                                                               tileBoundsInCanvas.y,
-                                                               tileBoundsInCanvas.w,
-                                                               tileBoundsInCanvas.h,
-                                                               m_dst->maskColor()));
-                                  });
-      }
-      else if (m_cel->layer()->isBackground()) {
-        (*m_tx)(new cmd::CopyRegion(m_cel->image(), m_dst.get(), gfx::Region(output), position()));
-      }
-      else {
-        // Patch "m_cel"
-        (*m_tx)(new cmd::PatchCel(m_cel, m_dst.get(), gfx::Region(output), position()));
-      }
-    }
-
+    patchCel(m_cel, m_src.get(), m_dst.get());
     result = CommandResult(CommandResult::kOk);
   }
   else {
@@ -258,6 +497,36 @@ void FilterManagerImpl::apply()
     init(m_site.cel());
 }
 
+void FilterManagerImpl::patchCel(Cel* cel, const Image* src, const Image* dst)
+{
+  gfx::Rect output;
+  if (algorithm::shrink_bounds2(src, dst, m_bounds, output)) {
+    if (cel->layer()->isTilemap()) {
+      modify_tilemap_cel_region(*m_tx,
+                                cel,
+                                nullptr,
+                                gfx::Region(output),
+                                m_site.tilesetMode(),
+                                [dst](const doc::ImageRef& origTile,
+                                      const gfx::Rect& tileBoundsInCanvas) -> doc::ImageRef {
+                                  return ImageRef(crop_image(dst,
+                                                             tileBoundsInCanvas.x,
+                                                             tileBoundsInCanvas.y,
+                                                             tileBoundsInCanvas.w,
+                                                             tileBoundsInCanvas.h,
+                                                             dst->maskColor()));
+                                });
+    }
+    else if (cel->layer()->isBackground()) {
+      (*m_tx)(new cmd::CopyRegion(cel->image(), dst, gfx::Region(output), position()));
+    }
+    else {
+      // Patch "cel"
+      (*m_tx)(new cmd::PatchCel(cel, dst, gfx::Region(output), position()));
+    }
+  }
+}
+
 void FilterManagerImpl::applyToTarget()
 {
   applyToPaletteIfNeeded();
@@ -300,6 +569,21 @@ void FilterManagerImpl::applyToTarget()
     (*m_tx)(new cmd::SetPalette(m_site.sprite(), m_site.frame(), &newPalette));
   }
 
+  // Filter several cels at the same time
+  if (canApplyToCelsInParallel(cels)) {
+    CelList uniqueCels;
+    for (Cel* cel : cels) {
+      // Linked cels share the same image, so we filter it only once
+      if (visited.insert(cel->image()->id()).second)
+        uniqueCels.push_back(cel);
+    }
+    applyToCelsInParallel(uniqueCels);
+
+    // Reset m_oldPalette to avoid restoring the color palette
+    m_oldPalette.reset(nullptr);
+    return;
+  }
+
   // For each target image
   for (auto it = cels.begin(); it != cels.end() && !cancelled; ++it) {
     Image* image = (*it)->image();
@@ -454,7 +738,8 @@ void FilterManagerImpl::init(Cel* cel)
 
   m_cel = cel;
   m_src = crop_cel_image(cel, 0);
-  m_dst.reset(Image::createCopy(m_src.get()));
+  m_dst.reset(
+    Image::createCopy(m_src.get(), ImageBufferPool::instance()->get(m_src->spec())));
 
   m_row = -1;
   m_mask = nullptr;
@@ -473,6 +758,284 @@ void FilterManagerImpl::applyToCel(Cel* cel)
   apply();
 }
 
+bool FilterManagerImpl::canApplyInParallel() const
+{
+  if (filters_threads() < 2 || m_bounds.h < 2 * kRowsPerTask)
+    return false;
+
+  // Some RgbMap implementations (e.g. OctreeMap or RgbMapRGB5A3)
+  // calculate their entries lazily in mapColor(), so they cannot be
+  // used from several threads at the same time.
+  if (pixelFormat() == IMAGE_INDEXED &&
+      getRgbMap()->rgbmapAlgorithm() != RgbMapAlgorithm::PRECOMPUTED)
+    return false;
+
+  return true;
+}
+
+bool FilterManagerImpl::canApplyToCelsInParallel(const CelList& cels) const
+{
+  if (filters_threads() < 2 || cels.size() < 2)
+    return false;
+
+  // See canApplyInParallel()
+  if (pixelFormat() == IMAGE_INDEXED &&
+      getRgbMap()->rgbmapAlgorithm() != RgbMapAlgorithm::PRECOMPUTED)
+    return false;
+
+  // Tilemaps can share tiles, so the filtered tiles of one cel are
+  // used in the source image of the next tilemap cels.
+  for (const Cel* cel : cels) {
+    if (cel->layer()->isTilemap())
+      return false;
+  }
+  return true;
+}
+
+// Filters each cel in a different task. We filter the
+// cels in groups (one cel for each thread) to limit the memory used
+// by the source/destination images, and the commands of each group
+// are added to the transaction in the same order of the cels.
+void FilterManagerImpl::applyToCelsInParallel(const CelList& cels)
+{
+  CommandResult result(CommandResult::kOk);
+  const int nthreads = filters_threads();
+
+  // Initialize the bounds and mask to filter
+  begin();
+
+  while (int(m_threadFilters.size()) < nthreads)
+    m_threadFilters.push_back(m_threadFilters.empty() ? nullptr : m_filter->createThreadCopy());
+
+  // Token used to cancel the tasks of the group when the user cancels
+  // the process.
+  base::task_token token;
+  m_taskToken = &token;
+
+  m_progressWidth = 1.0f / cels.size();
+
+  for (auto it = cels.begin(); it != cels.end();) {
+    std::vector<CelImages> group;
+    for (; it != cels.end() && int(group.size()) < nthreads; ++it) {
+      Cel* cel = *it;
+      CelImages images;
+      images.cel = cel;
+      images.src = crop_cel_image(cel, 0);
+      images.dst.reset(Image::createCopy(images.src.get(),
+                                         ImageBufferPool::instance()->get(images.src->spec())));
+      images.target = m_targetOrig;
+      // The alpha channel of the background layer can't be modified
+      if (cel->layer()->isBackground())
+        images.target &= ~TARGET_ALPHA_CHANNEL;
+      group.push_back(std::move(images));
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::atomic<int> doneRows(0);
+    int pending = int(group.size());
+
+    doc::TaskGroup tasks(doc::TaskPriority::Interactive, &token);
+    for (int i = 0; i < int(group.size()); ++i) {
+      tasks.run([this, i, &group, &doneRows, &mutex, &cv, &pending] {
+        Filter* filter = (m_threadFilters[i] ? m_threadFilters[i].get() : m_filter);
+
+        if (applyToUniqueColors(filter, group[i]))
+          doneRows += m_bounds.h;
+        else
+          RowsWorker(this, group[i], 0).apply(filter, m_bounds.h, &doneRows);
+
+        const std::lock_guard lock(mutex);
+        if (--pending == 0)
+          cv.notify_one();
+      });
+    }
+
+    // Report the progress from this thread meanwhile the cels are
+    // filtered by the workers (canceled tasks are not executed, so we
+    // don't wait them)
+    {
+      std::unique_lock lock(mutex);
+      while (!cv.wait_for(lock, std::chrono::milliseconds(50), [&pending, &token] {
+        return pending == 0 || token.canceled();
+      })) {
+        if (m_progressDelegate) {
+          m_progressDelegate->reportProgress(m_progressBase +
+                                             m_progressWidth * doneRows / m_bounds.h);
+
+          if (m_progressDelegate->isCancelled())
+            token.cancel();
+        }
+      }
+    }
+    tasks.wait();
+
+    if (token.canceled() || (m_progressDelegate && m_progressDelegate->isCancelled())) {
+      result = CommandResult(CommandResult::kCanceled);
+
+      // Rollback transaction
+      m_tx.reset();
+      break;
+    }
+
+    for (const CelImages& images : group)
+      patchCel(images.cel, images.src.get(), images.dst.get());
+
+    m_progressBase += m_progressWidth * group.size();
+  }
+
+  m_taskToken = &m_noToken;
+
+  ASSERT(m_reader.context());
+  m_reader.context()->setCommandResult(result);
+  if (m_site.cel())
+    init(m_site.cel());
+}
+
+void FilterManagerImpl::applyRowsInParallel(const int row, const int rows)
+{
+  const int ntasks = (rows + kRowsPerTask - 1) / kRowsPerTask;
+
+  // The first task uses m_filter and the others a copy of it (if the
+  // filter needs one)
+  while (int(m_threadFilters.size()) < ntasks)
+    m_threadFilters.push_back(m_threadFilters.empty() ? nullptr : m_filter->createThreadCopy());
+
+  const CelImages images = { m_cel, m_src, m_dst, m_target };
+  doc::TaskGroup tasks;
+  for (int i = 0; i < ntasks; ++i) {
+    tasks.run([this, i, row, rows, &images] {
+      const int firstRow = row + i * kRowsPerTask;
+      Filter* filter = (m_threadFilters[i] ? m_threadFilters[i].get() : m_filter);
+
+      RowsWorker(this, images, firstRow)
+        .apply(filter, std::min(firstRow + kRowsPerTask, row + rows));
+    });
+  }
+  tasks.wait();
+}
+
+bool FilterManagerImpl::applyToUniqueColors(Filter* filter, const CelImages& images)
+{
+  if (!filter->isPointwise() || images.src->pixelFormat() != IMAGE_RGB)
+    return false;
+
+  const int maxColors = std::min(kMaxUniqueColors, m_bounds.w * m_bounds.h / kPixelsPerUniqueColor);
+  if (maxColors < 1)
+    return false;
+
+  UniqueColors unique(maxColors);
+  for (int y = 0; y < m_bounds.h; ++y) {
+    auto src = (const color_t*)images.src->getPixelAddress(m_bounds.x, m_bounds.y + y);
+    for (int x = 0; x < m_bounds.w; ++x, ++src) {
+      if (!unique.insert(*src))
+        return false;
+    }
+  }
+
+  // Apply the filter to one row with all the different colors
+  const std::vector<color_t>& colors = unique.colors();
+  ImageRef colorsSrc(Image::create(IMAGE_RGB, int(colors.size()), 1));
+  ImageRef colorsDst(Image::create(IMAGE_RGB, int(colors.size()), 1));
+  std::copy(colors.begin(), colors.end(), (color_t*)colorsSrc->getPixelAddress(0, 0));
+  std::copy(colors.begin(), colors.end(), (color_t*)colorsDst->getPixelAddress(0, 0));
+  ColorsWorker(this, colorsSrc.get(), colorsDst.get(), images.target).apply(filter);
+
+  // Replace the pixels inside the mask with the filtered colors
+  const auto filtered = (const color_t*)colorsDst->getPixelAddress(0, 0);
+  const bool useMask = (m_mask && m_mask->bitmap());
+  doc::ImageBits<doc::BitmapTraits> maskBits;
+  doc::ImageBits<doc::BitmapTraits>::iterator maskIterator;
+
+  for (int y = 0; y < m_bounds.h && !taskToken().canceled(); ++y) {
+    if (!lockMaskRow(y, maskBits, maskIterator))
+      break;
+
+    auto src = (const color_t*)images.src->getPixelAddress(m_bounds.x, m_bounds.y + y);
+    auto dst = (color_t*)images.dst->getPixelAddress(m_bounds.x, m_bounds.y + y);
+    for (int x = 0; x < m_bounds.w; ++x, ++src, ++dst) {
+      if (useMask) {
+        const bool skip = !*maskIterator;
+        ++maskIterator;
+        if (skip)
+          continue;
+      }
+      *dst = filtered[unique.find(*src)];
+    }
+  }
+  return true;
+}
+
+bool FilterManagerImpl::applyWithShader()
+{
+#if LAF_SKIA && SK_ENABLE_SKSL
+  // Only pointwise filters have a shader implementation (and at this
+  // point they were already applied to the palette, so we know if
+  // they must use the palette entries, which is not supported by
+  // shaders)
+  if (!m_filter->isPointwise() || m_src->pixelFormat() != IMAGE_RGB)
+    return false;
+
+  if (!m_mask || !m_mask->bitmap()) {
+    return apply_filter_with_shader(m_filter,
+                                    m_target,
+                                    m_src.get(),
+                                    m_bounds,
+                                    m_dst.get(),
+                                    m_bounds.origin());
+  }
+
+  // With a selection the filter is applied to a temporary image, and
+  // then we copy only the selected pixels (the other pixels of m_dst
+  // can contain filtered pixels of a previous preview area)
+  ImageRef tmp(Image::create(IMAGE_RGB, m_bounds.w, m_bounds.h));
+  if (!apply_filter_with_shader(m_filter,
+                                m_target,
+                                m_src.get(),
+                                m_bounds,
+                                tmp.get(),
+                                gfx::Point(0, 0)))
+    return false;
+
+  doc::ImageBits<doc::BitmapTraits> maskBits;
+  doc::ImageBits<doc::BitmapTraits>::iterator maskIterator;
+
+  for (int y = 0; y < m_bounds.h; ++y) {
+    if (!lockMaskRow(y, maskBits, maskIterator))
+      break;
+
+    auto src = (const color_t*)tmp->getPixelAddress(0, y);
+    auto dst = (color_t*)m_dst->getPixelAddress(m_bounds.x, m_bounds.y + y);
+    for (int x = 0; x < m_bounds.w; ++x, ++src, ++dst, ++maskIterator) {
+      if (*maskIterator)
+        *dst = *src;
+    }
+  }
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool FilterManagerImpl::lockMaskRow(const int row,
+                                    doc::ImageBits<doc::BitmapTraits>& maskBits,
+                                    doc::ImageBits<doc::BitmapTraits>::iterator& maskIterator) const
+{
+  if (m_mask && m_mask->bitmap()) {
+    int x = m_bounds.x - m_mask->bounds().x;
+    int y = m_bounds.y - m_mask->bounds().y + row;
+    if ((x >= m_bounds.w) || (y >= m_bounds.h))
+      return false;
+
+    maskBits = m_mask->bitmap()->lockBits<BitmapTraits>(
+      Image::ReadLock,
+      gfx::Rect(x, y, m_bounds.w - x, m_bounds.h - y));
+
+    maskIterator = maskBits.begin();
+  }
+  return true;
+}
+
 bool FilterManagerImpl::updateBounds(doc::Mask* mask)
 {
   gfx::Rect bounds;
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -15,6 +15,7 @@
 #include "app/tx.h"
 #include "base/exception.h"
 #include "base/task.h"
+#include "doc/cel_list.h"
 #include "doc/image.h"
 #include "doc/image_ref.h"
 #include "doc/pixel_format.h"
@@ -134,11 +135,63 @@ public:
   void startWorker(bool ui);
 
 private:
+  class RowsWorker;
+  class ColorsWorker;
+
+  // Source and destination images to filter a cel.
+  struct CelImages {
+    doc::Cel* cel = nullptr;
+    doc::ImageRef src;
+    doc::ImageRef dst;
+    Target target = TARGET_ALL_CHANNELS;
+  };
+
   void init(doc::Cel* cel);
   void apply();
   void applyToCel(doc::Cel* cel);
   bool updateBounds(doc::Mask* mask);
 
+  // Prepares m_previewMask to filter the pixels of the given area
+  // that weren't filtered in the previous preview area. Returns false
+  // if there is nothing to filter in the area.
+  bool beginPreviewArea(const gfx::Rect& area);
+
+  // Expands the preview area to filter pixels around the area that
+  // was already filtered. Returns false if the whole sprite was
+  // already filtered.
+  bool expandPreviewArea();
+
+  // Adds the commands to the transaction to replace the pixels of
+  // the cel with the modified pixels of the "dst" image.
+  void patchCel(doc::Cel* cel, const doc::Image* src, const doc::Image* dst);
+
+  // Returns true if several rows can be filtered at the same time
+  // from different threads.
+  bool canApplyInParallel() const;
+  void applyRowsInParallel(int row, int rows);
+
+  // Returns true if the given cels can be filtered at the same time
+  // from different threads.
+  bool canApplyToCelsInParallel(const doc::CelList& cels) const;
+  void applyToCelsInParallel(const doc::CelList& cels);
+
+  // Applies a pointwise filter to each different color of an RGB
+  // image only once (when the image has a few colors), and replaces
+  // the pixels with the filtered colors. Returns false if the filter
+  // must be applied to each row.
+  bool applyToUniqueColors(Filter* filter, const CelImages& images);
+
+  // Applies the filter to the whole m_src image using a shader (when
+  // the experimental option is enabled). Returns false if the filter
+  // must be applied to each row.
+  bool applyWithShader();
+
+  // Prepares the mask iterator to call skipPixel() in the given row.
+  // Returns false if the row is outside the mask.
+  bool lockMaskRow(int row,
+                   doc::ImageBits<doc::BitmapTraits>& maskBits,
+                   doc::ImageBits<doc::BitmapTraits>::iterator& maskIterator) const;
+
   // Returns true if the palette was changed (true when the filter
   // modifies the palette).
   bool paletteHasChanged();
@@ -159,6 +212,7 @@ private:
   gfx::Rect m_bounds;
   doc::Mask* m_mask;
   std::unique_ptr<doc::Mask> m_previewMask;
+  gfx::Rect m_previewArea;
   doc::ImageBits<doc::BitmapTraits> m_maskBits;
   doc::ImageBits<doc::BitmapTraits>::iterator m_maskIterator;
   Target m_targetOrig; // Original targets
@@ -169,10 +223,18 @@ private:
   base::task_token m_noToken;
   base::task_token* m_taskToken;
 
+  // Copies of m_filter used by each task of applyRowsInParallel()
+  // (nullptr if the task can use m_filter).
+  std::vector<std::unique_ptr<Filter>> m_threadFilters;
+
   // Hooks
   float m_progressBase;
   float m_progressWidth;
   IProgressDelegate* m_progressDelegate;
+
+  // True if we can use shaders to apply the filter (experimental
+  // option).
+  bool m_useShaders;
 };
 
 } // namespace app
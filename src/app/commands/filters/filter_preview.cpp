@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -31,6 +31,7 @@ FilterPreview::FilterPreview(FilterManagerImpl* filterMgr)
   , m_filterMgr(filterMgr)
   , m_timer(1, this)
   , m_restartPreviewTimer(10)
+  , m_filterTask(doc::TaskPriority::Interactive)
 {
   setVisible(false);
 
@@ -0,0 +1,230 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/commands/filters/filter_shader.h"
+
+#if LAF_SKIA && SK_ENABLE_SKSL
+
+  #include "app/util/shader_helpers.h"
+  #include "doc/image.h"
+  #include "filters/brightness_contrast_filter.h"
+  #include "filters/color_curve_filter.h"
+  #include "filters/hue_saturation_filter.h"
+  #include "filters/invert_color_filter.h"
+
+  #include "include/core/SkBitmap.h"
+  #include "include/core/SkCanvas.h"
+  #include "include/effects/SkRuntimeEffect.h"
+
+  #include <string>
+  #include <vector>
+
+namespace app {
+
+using namespace filters;
+
+namespace {
+
+// All shaders receive the source image (with unpremultiplied colors)
+// in "iImg", and the channels to modify in "iTarget" (1 for modified
+// channels, 0 for the others). The result is premultiplied as Skia
+// expects it.
+
+const char* kInvertShaderCode = R"(
+uniform shader iImg;
+uniform half4 iTarget;
+
+half4 main(vec2 fragcoord) {
+ half4 c = iImg.eval(fragcoord);
+ c = mix(c, 1.0 - c, iTarget);
+ return half4(c.rgb * c.a, c.a);
+}
+)";
+
+// Used by filters that convert each channel with a table of 256
+// values (given in the alpha channel of the "iTable" image).
+const char* kTableShaderCode = R"(
+uniform shader iImg;
+uniform shader iTable;
+uniform half4 iTarget;
+
+float lookup(float v) {
+ return iTable.eval(float2(floor(v * 255.0 + 0.5) + 0.5, 0.5)).a;
+}
+
+half4 main(vec2 fragcoord) {
+ half4 c = iImg.eval(fragcoord);
+ half4 d = half4(lookup(c.r), lookup(c.g), lookup(c.b), lookup(c.a));
+ c = mix(c, d, iTarget);
+ return half4(c.rgb * c.a, c.a);
+}
+)";
+
+// Same logic as HueSaturationFilter::applyFilterToRgbT() where
+// iHsla contains the hue (in turns), saturation, lightness, and
+// alpha adjustments, iMode.x is 1 to multiply (or 0 to add) the
+// saturation/lightness, and iMode.y is 1 for HSL (or 0 for HSV).
+const char* kHueSaturationShaderCode = R"(
+uniform shader iImg;
+uniform half4 iTarget;
+uniform float4 iHsla;
+uniform float2 iMode;
+
+half4 main(vec2 fragcoord) {
+ half4 c = iImg.eval(fragcoord);
+ if (c.a == 0.0)
+  return half4(0);
+
+ half3 hsv = rgb_to_hsv(c.rgb);
+ float s = hsv.y;
+ float l = hsv.z;
+ if (iMode.y != 0.0) {
+  l = hsv.z * (1.0 - hsv.y / 2.0);
+  float m = min(l, 1.0 - l);
+  s = (m > 0.0 ? (hsv.z - l) / m: 0.0);
+ }
+
+ float h = fract(hsv.x + iHsla.x);
+ if (iMode.x != 0.0) {
+  s *= 1.0 + iHsla.y;
+  l *= 1.0 + iHsla.z;
+ }
+ else {
+  s += iHsla.y;
+  l += iHsla.z;
+ }
+ s = clamp(s, 0.0, 1.0);
+ l = clamp(l, 0.0, 1.0);
+
+ if (iMode.y != 0.0) {
+  float v = l + s * min(l, 1.0 - l);
+  s = (v > 0.0 ? 2.0 * (1.0 - l / v): 0.0);
+  l = v;
+ }
+
+ half4 d = half4(hsv_to_rgb(half3(h, s, l)), clamp(c.a * (1.0 + iHsla.w), 0.0, 1.0));
+ c = mix(c, d, iTarget);
+ if (c.a == 0.0)
+  return half4(0);
+ return half4(c.rgb * c.a, c.a);
+}
+)";
+
+SkV4 target_to_SkV4(const Target target)
+{
+  return SkV4{ (target & TARGET_RED_CHANNEL ? 1.0f : 0.0f),
+               (target & TARGET_GREEN_CHANNEL ? 1.0f : 0.0f),
+               (target & TARGET_BLUE_CHANNEL ? 1.0f : 0.0f),
+               (target & TARGET_ALPHA_CHANNEL ? 1.0f : 0.0f) };
+}
+
+sk_sp<SkShader> make_table_shader(const std::vector<int>& table)
+{
+  SkBitmap bitmap;
+  bitmap.allocPixels(SkImageInfo::MakeA8(256, 1));
+  uint8_t* p = bitmap.getAddr8(0, 0);
+  for (int i = 0; i < 256; ++i)
+    p[i] = uint8_t(table[i]);
+  bitmap.setImmutable();
+  return bitmap.asImage()->makeRawShader(SkSamplingOptions(SkFilterMode::kNearest));
+}
+
+sk_sp<SkShader> make_filter_shader(Filter* filter, const Target target, sk_sp<SkShader> img)
+{
+  if (dynamic_cast<InvertColorFilter*>(filter)) {
+    static const sk_sp<SkRuntimeEffect> effect = make_shader(kInvertShaderCode);
+
+    SkRuntimeShaderBuilder builder(effect);
+    builder.child("iImg") = img;
+    builder.uniform("iTarget") = target_to_SkV4(target);
+    return builder.makeShader();
+  }
+
+  const std::vector<int>* table = nullptr;
+  if (auto* curve = dynamic_cast<ColorCurveFilter*>(filter))
+    table = &curve->getColorMap();
+  else if (auto* bc = dynamic_cast<BrightnessContrastFilter*>(filter)) {
+    if (!bc->usePaletteOnRGB())
+      table = &bc->colorMap();
+  }
+  if (table) {
+    static const sk_sp<SkRuntimeEffect> effect = make_shader(kTableShaderCode);
+
+    SkRuntimeShaderBuilder builder(effect);
+    builder.child("iImg") = img;
+    builder.child("iTable") = make_table_shader(*table);
+    builder.uniform("iTarget") = target_to_SkV4(target);
+    return builder.makeShader();
+  }
+
+  if (auto* hs = dynamic_cast<HueSaturationFilter*>(filter)) {
+    if (hs->usePaletteOnRGB())
+      return nullptr;
+
+    static const sk_sp<SkRuntimeEffect> effect = make_shader(
+      (std::string(kRGB_to_HSV_sksl) + kHSV_to_RGB_sksl + kHueSaturationShaderCode).c_str());
+
+    const HueSaturationFilter::Mode mode = hs->mode();
+    const bool multiply = (mode == HueSaturationFilter::Mode::HSV_MUL ||
+                           mode == HueSaturationFilter::Mode::HSL_MUL);
+    const bool hsl = (mode == HueSaturationFilter::Mode::HSL_MUL ||
+                      mode == HueSaturationFilter::Mode::HSL_ADD);
+
+    SkRuntimeShaderBuilder builder(effect);
+    builder.child("iImg") = img;
+    builder.uniform("iTarget") = target_to_SkV4(target);
+    builder.uniform("iHsla") = SkV4{ float(hs->hue() / 360.0),
+                                     float(hs->saturation()),
+                                     float(hs->lightness()),
+                                     float(hs->alpha()) };
+    builder.uniform("iMode") = SkV2{ (multiply ? 1.0f : 0.0f), (hsl ? 1.0f : 0.0f) };
+    return builder.makeShader();
+  }
+
+  return nullptr;
+}
+
+} // anonymous namespace
+
+bool apply_filter_with_shader(Filter* filter,
+                              const Target target,
+                              const doc::Image* src,
+                              const gfx::Rect& bounds,
+                              doc::Image* dst,
+                              const gfx::Point& dstPos)
+{
+  ASSERT(src->pixelFormat() == doc::IMAGE_RGB);
+  ASSERT(dst->pixelFormat() == doc::IMAGE_RGB);
+
+  sk_sp<SkImage> skSrc = make_skimage_for_docimage(src);
+  if (!skSrc)
+    return false;
+
+  sk_sp<SkShader> shader =
+    make_filter_shader(filter,
+                       target,
+                       skSrc->makeRawShader(SkSamplingOptions(SkFilterMode::kNearest)));
+  if (!shader)
+    return false;
+
+  std::unique_ptr<SkCanvas> canvas = make_skcanvas_for_docimage(dst);
+  canvas->translate(dstPos.x - bounds.x, dstPos.y - bounds.y);
+
+  SkPaint p;
+  p.setStyle(SkPaint::kFill_Style);
+  p.setBlendMode(SkBlendMode::kSrc);
+  p.setShader(shader);
+  canvas->drawRect(SkRect::MakeXYWH(bounds.x, bounds.y, bounds.w, bounds.h), p);
+  return true;
+}
+
+} // namespace app
+
+#endif // LAF_SKIA && SK_ENABLE_SKSL
@@ -0,0 +1,46 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_COMMANDS_FILTERS_FILTER_SHADER_H_INCLUDED
+#define APP_COMMANDS_FILTERS_FILTER_SHADER_H_INCLUDED
+#pragma once
+
+#if LAF_SKIA && SK_ENABLE_SKSL
+
+  #include "filters/target.h"
+  #include "gfx/point.h"
+  #include "gfx/rect.h"
+
+namespace doc {
+class Image;
+}
+
+namespace filters {
+class Filter;
+}
+
+namespace app {
+
+// Applies the filter to the "bounds" of the RGB "src" image with a
+// SkSL runtime shader, and saves the result in "dst" at "dstPos".
+// Returns false if the filter (or its current settings) cannot be
+// applied with a shader, in that case the filter must be applied row
+// by row.
+//
+// Supported filters: Invert Color, Color Curve, Brightness/Contrast,
+// and Hue/Saturation (when they are not applied to palette entries).
+bool apply_filter_with_shader(filters::Filter* filter,
+                              filters::Target target,
+                              const doc::Image* src,
+                              const gfx::Rect& bounds,
+                              doc::Image* dst,
+                              const gfx::Point& dstPos);
+
+} // namespace app
+
+#endif // LAF_SKIA && SK_ENABLE_SKSL
+
+#endif
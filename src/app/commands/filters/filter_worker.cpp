@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -15,6 +15,7 @@
 #include "app/i18n/strings.h"
 #include "app/ini_file.h"
 #include "app/modules/gui.h"
+#include "app/task_scheduler.h"
 #include "app/ui/editor/editor.h"
 #include "app/ui/status_bar.h"
 #include "base/thread.h"
@@ -25,7 +26,6 @@
 #include <cstring>
 #include <functional>
 #include <mutex>
-#include <thread>
 
 namespace app {
 
@@ -127,11 +127,11 @@ void FilterWorker::run()
   // applyFilterInBackground() with the worker thread ID.
   m_filterMgr->initTransaction();
 
-  std::thread thread;
+  BlockingTask thread;
   // Open the alert window in foreground (this is modal, locks the main thread)
   if (m_alert) {
     // Launch the thread to apply the effect in background
-    thread = std::thread([this] { applyFilterInBackground(); });
+    thread = BlockingTask([this] { applyFilterInBackground(); });
     m_alert->openAndWait();
   }
   else {
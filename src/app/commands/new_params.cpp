@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -16,6 +16,7 @@
 #include "app/doc_exporter.h"
 #include "app/load_matrix.h"
 #include "app/pref/preferences.h"
+#include "app/sprite_sheet_pack_algorithm.h"
 #include "app/sprite_sheet_type.h"
 #include "app/tools/ink_type.h"
 #include "base/convert_to.h"
@@ -126,6 +127,17 @@ void Param<app::SpriteSheetType>::fromString(const std::string& value)
     setValue(app::SpriteSheetType::None);
 }
 
+template<>
+void Param<app::SpriteSheetPackAlgorithm>::fromString(const std::string& value)
+{
+  // MaxRects, max-rects, max_rects, etc.
+  if (base::utf8_icmp(value, "MaxRects") == 0 || base::utf8_icmp(value, "max-rects") == 0 ||
+      base::utf8_icmp(value, "max_rects") == 0)
+    setValue(app::SpriteSheetPackAlgorithm::MaxRects);
+  else
+    setValue(app::SpriteSheetPackAlgorithm::BestFit);
+}
+
 template<>
 void Param<app::SpriteSheetDataFormat>::fromString(const std::string& value)
 {
@@ -238,6 +250,8 @@ void Param<doc::RgbMapAlgorithm>::fromString(const std::string& value)
     setValue(doc::RgbMapAlgorithm::OCTREE);
   else if (base::utf8_icmp(value, "rgb5a3") == 0)
     setValue(doc::RgbMapAlgorithm::RGB5A3);
+  else if (base::utf8_icmp(value, "precomputed") == 0)
+    setValue(doc::RgbMapAlgorithm::PRECOMPUTED);
   else
     setValue(doc::RgbMapAlgorithm::DEFAULT);
 }
@@ -361,6 +375,15 @@ void Param<app::SpriteSheetType>::fromLua(lua_State* L, int index)
     setValue((app::SpriteSheetType)lua_tointeger(L, index));
 }
 
+template<>
+void Param<app::SpriteSheetPackAlgorithm>::fromLua(lua_State* L, int index)
+{
+  if (lua_type(L, index) == LUA_TSTRING)
+    fromString(lua_tostring(L, index));
+  else
+    setValue((app::SpriteSheetPackAlgorithm)lua_tointeger(L, index));
+}
+
 template<>
 void Param<app::SpriteSheetDataFormat>::fromLua(lua_State* L, int index)
 {
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2023  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -173,6 +173,7 @@ void Context::executeCommand(Command* command, const Params& params)
 
   m_result.reset();
 
+  base::ScopedValue executing(m_executingCommand, command);
   Console console;
   LOG(VERBOSE, "CTXT: Executing command %s\n", command->id().c_str());
   try {
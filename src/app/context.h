@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2023  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -154,6 +154,9 @@ public:
   void setCommandResult(const CommandResult& result);
   const CommandResult& commandResult() { return m_result; }
 
+  // Returns the command that is being executed (or nullptr).
+  Command* executingCommand() const { return m_executingCommand; }
+
   virtual DocView* getFirstDocView(Doc* document) const { return nullptr; }
 
   obs::signal<void(CommandExecutionEvent&)> BeforeCommandExecution;
@@ -193,6 +196,9 @@ private:
   // Result of the execution of a command.
   CommandResult m_result;
 
+  // Innermost command in executeCommand().
+  Command* m_executingCommand = nullptr;
+
   DISABLE_COPYING(Context);
 };
 
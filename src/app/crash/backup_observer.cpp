@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2023  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -26,8 +26,11 @@
 #include "app/doc.h"
 #include "app/doc_access.h"
 #include "app/doc_diff.h"
+#include "app/doc_undo.h"
+#include "app/cmd.h"
 #include "app/pref/preferences.h"
 #include "base/chrono.h"
+#include "base/mem_utils.h"
 #include "base/remove_from_container.h"
 #include "base/thread.h"
 #include "ui/app_state.h"
@@ -37,6 +40,18 @@ namespace app { namespace crash {
 
 namespace {
 
+// Do a backup before the regular period if this amount of undo
+// information was added since the last backup (but not more
+// frequently than each kChangedMinPeriodSeconds).
+const size_t kChangedBytesLimit = 32 * 1024 * 1024; // 32 MB
+const int kChangedMinPeriodSeconds = 5;
+
+// Do a backup before the regular period if the user didn't modify
+// the documents in the last kIdleSeconds (but not more frequently
+// than each kIdleMinPeriodSeconds).
+const int kIdleSeconds = 5;
+const int kIdleMinPeriodSeconds = 30;
+
 class SwitchBackupIcon {
 public:
   SwitchBackupIcon()
@@ -62,6 +77,8 @@ BackupObserver::BackupObserver(RecoveryConfig* config, Session* session, Context
   , m_session(session)
   , m_ctx(ctx)
   , m_done(false)
+  , m_changedBytes(0)
+  , m_lastChange(0)
   , m_thread([this] { backgroundThread(); })
 {
   m_ctx->add_observer(this);
@@ -71,6 +88,8 @@ BackupObserver::BackupObserver(RecoveryConfig* config, Session* session, Context
 BackupObserver::~BackupObserver()
 {
   m_thread.join();
+  for (Doc* doc : m_documents)
+    doc->undoHistory()->remove_observer(this);
   m_ctx->documents().remove_observer(this);
   m_ctx->remove_observer(this);
 }
@@ -85,6 +104,8 @@ void BackupObserver::onAddDocument(Doc* document)
 {
   RECO_TRACE("RECO: Observe document %p\n", document);
 
+  document->undoHistory()->add_observer(this);
+
   std::unique_lock<std::mutex> lock(m_mutex);
   m_documents.push_back(document);
 }
@@ -92,6 +113,7 @@ void BackupObserver::onAddDocument(Doc* document)
 void BackupObserver::onRemoveDocument(Doc* doc)
 {
   RECO_TRACE("RECO: Remove document %p\n", doc);
+  doc->undoHistory()->remove_observer(this);
   {
     std::unique_lock<std::mutex> lock(m_mutex);
     base::remove_from_container(m_documents, doc);
@@ -125,6 +147,14 @@ void BackupObserver::onRemoveDocument(Doc* doc)
   }
 }
 
+// Executed from the UI thread each time a document is modified
+void BackupObserver::onAddUndoState(DocUndo* history)
+{
+  if (const Cmd* cmd = history->lastExecutedCmd())
+    m_changedBytes += cmd->memSize();
+  m_lastChange = base::current_tick();
+}
+
 void BackupObserver::backgroundThread()
 {
   std::unique_lock<std::mutex> lock(m_mutex);
@@ -138,12 +168,22 @@ void BackupObserver::backgroundThread()
 #endif
 
   int waitFor = normalPeriod;
+  base::tick_t lastBackup = base::current_tick();
 
   while (!m_done) {
-    m_wakeup.wait_for(lock, std::chrono::seconds(waitFor));
+    // Check each second if we have to do the backup (the period
+    // expired, a lot of data was modified, or the user is idle). A
+    // last backup is done when the thread is stopped.
+    m_wakeup.wait_for(lock, std::chrono::seconds(1));
+    if (!m_done && !shouldBackup(lastBackup, waitFor))
+      continue;
 
-    RECO_TRACE("RECO: Start backup process for %d documents\n",
-               m_documents.size() + m_closedDocs.size());
+    RECO_TRACE("RECO: Start backup process for %d documents (%s modified)\n",
+               m_documents.size() + m_closedDocs.size(),
+               base::get_pretty_memory_size(m_changedBytes).c_str());
+
+    // Bytes modified from now on will be counted for the next backup
+    const size_t changedBytes = m_changedBytes;
 
     SwitchBackupIcon icon;
     base::Chrono chrono;
@@ -174,11 +214,35 @@ void BackupObserver::backgroundThread()
     }
 
     waitFor = (somethingLocked ? lockedPeriod : normalPeriod);
+    lastBackup = base::current_tick();
+    if (!somethingLocked)
+      m_changedBytes -= changedBytes;
 
     RECO_TRACE("RECO: Backup process done (%.16g)\n", chrono.elapsed());
   }
 }
 
+bool BackupObserver::shouldBackup(const base::tick_t lastBackup, const int waitFor) const
+{
+  const base::tick_t now = base::current_tick();
+  const base::tick_t elapsed = now - lastBackup;
+  if (elapsed >= base::tick_t(waitFor) * 1000)
+    return true;
+
+  const size_t changedBytes = m_changedBytes;
+  if (changedBytes == 0)
+    return false;
+
+  // A lot of modifications since the last backup
+  if (changedBytes >= kChangedBytesLimit &&
+      elapsed >= base::tick_t(kChangedMinPeriodSeconds) * 1000)
+    return true;
+
+  // Use the idle time to do the backup
+  return (elapsed >= base::tick_t(kIdleMinPeriodSeconds) * 1000 &&
+          now - m_lastChange >= base::tick_t(kIdleSeconds) * 1000);
+}
+
 // Executed from the backgroundThread() (non-UI thread)
 bool BackupObserver::saveDocData(Doc* doc)
 {
@@ -189,6 +253,9 @@ bool BackupObserver::saveDocData(Doc* doc)
     if (doc->inhibitBackup()) {
       RECO_TRACE("RECO: Document '%d' backup is temporarily inhibited\n", doc->id());
     }
+    else if (doc->deferBackup()) {
+      RECO_TRACE("RECO: Document '%d' is being modified, backup deferred\n", doc->id());
+    }
     else if (!m_session->saveDocumentChanges(doc)) {
       RECO_TRACE("RECO: Document '%d' backup was canceled by UI\n", doc->id());
     }
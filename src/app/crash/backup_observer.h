@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2020  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -11,7 +11,9 @@
 
 #include "app/context_observer.h"
 #include "app/doc_observer.h"
+#include "app/doc_undo_observer.h"
 #include "app/docs_observer.h"
+#include "base/time.h"
 
 #include <atomic>
 #include <condition_variable>
@@ -26,9 +28,15 @@ namespace crash {
 struct RecoveryConfig;
 class Session;
 
+// Creates backups of the modified documents in a background thread.
+// The backup is done each RecoveryConfig::dataRecoveryPeriod, or
+// before that if a lot of data was modified (undo states) or if the
+// user stops editing for a while. Documents that are being modified
+// (Doc::deferBackup()) are saved later.
 class BackupObserver : public ContextObserver,
                        public DocsObserver,
-                       public DocObserver {
+                       public DocObserver,
+                       public DocUndoObserver {
 public:
   BackupObserver(RecoveryConfig* config, Session* session, Context* ctx);
   ~BackupObserver();
@@ -38,8 +46,12 @@ public:
   void onAddDocument(Doc* document) override;
   void onRemoveDocument(Doc* document) override;
 
+  // DocUndoObserver impl
+  void onAddUndoState(DocUndo* history) override;
+
 private:
   void backgroundThread();
+  bool shouldBackup(const base::tick_t lastBackup, const int waitFor) const;
   bool saveDocData(Doc* doc);
 
   RecoveryConfig* m_config;
@@ -49,6 +61,11 @@ private:
   std::vector<Doc*> m_closedDocs;
   std::atomic<bool> m_done;
 
+  // Bytes of undo information added since the last backup, and the
+  // time of the last added undo state.
+  std::atomic<size_t> m_changedBytes;
+  std::atomic<base::tick_t> m_lastChange;
+
   std::mutex m_mutex;
 
   // Used to wakeup the backgroundThread() when we have to stop the
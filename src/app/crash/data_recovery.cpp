@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -19,11 +19,13 @@
 #include "base/fs.h"
 #include "base/thread.h"
 #include "base/time.h"
+#include "doc/task_group.h"
 #include "fmt/format.h"
 #include "ui/system.h"
 
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
 #include <thread>
 
 namespace app { namespace crash {
@@ -148,29 +150,58 @@ bool DataRecovery::isRunningSession(const SessionPtr& session) const
 
 void DataRecovery::searchForSessions()
 {
-  Sessions sessions;
+  Sessions candidates;
 
   // Existent sessions
   RECO_TRACE("RECO: Listing sessions from '%s'\n", m_sessionsDir.c_str());
   for (const auto& itemname : base::list_files(m_sessionsDir, base::ItemType::Directories)) {
     const auto& itempath = base::join_path(m_sessionsDir, itemname);
-    RECO_TRACE("RECO: Session '%s' ", itempath.c_str());
 
     SessionPtr session(new Session(&m_config, itempath));
-    if (!isRunningSession(session)) {
-      if ((session->isEmpty()) || (!session->isCrashedSession() && session->isOldSession())) {
-        RECO_TRACE("to be deleted (%s)\n",
-                   session->isEmpty() ? "is empty" :
-                                        (session->isOldSession() ? "is old" : "unknown reason"));
-        session->removeFromDisk();
-      }
-      else {
-        RECO_TRACE("to be loaded\n");
-        sessions.push_back(session);
-      }
-    }
+    if (!isRunningSession(session))
+      candidates.push_back(session);
     else
-      RECO_TRACE("is running\n");
+      RECO_TRACE("RECO: Session '%s' is running\n", itempath.c_str());
+  }
+
+  // Check the sessions in parallel, each one has to read its pid/ver
+  // files and list its backups, which is slow when there are
+  // hundreds of old sessions. The description of each backup is not
+  // read here, it's loaded on demand by the DataRecoveryView.
+  enum class State : uint8_t { Load, Empty, Old };
+  std::vector<State> states(candidates.size(), State::Load);
+  {
+    doc::TaskGroup tasks(doc::TaskPriority::Background);
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+      tasks.run([&candidates, &states, i] {
+        Session* session = candidates[i].get();
+        if (session->isEmpty())
+          states[i] = State::Empty;
+        else if (!session->isCrashedSession() && session->isOldSession())
+          states[i] = State::Old;
+
+        if (states[i] != State::Load)
+          session->removeFromDisk();
+        else {
+          // Cache the information that the DataRecoveryView will
+          // show from the UI thread.
+          session->version();
+          session->backups();
+        }
+      });
+    }
+    tasks.wait();
+  }
+
+  Sessions sessions;
+  for (std::size_t i = 0; i < candidates.size(); ++i) {
+    RECO_TRACE("RECO: Session '%s' %s\n",
+               candidates[i]->path().c_str(),
+               states[i] == State::Empty ? "deleted (is empty)" :
+               states[i] == State::Old   ? "deleted (is old)" :
+                                           "to be loaded");
+    if (states[i] == State::Load)
+      sessions.push_back(candidates[i]);
   }
 
   // Sort sessions from the most recent one to the oldest one
@@ -0,0 +1,100 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/crash/objects_log.h"
+
+#include "app/crash/internals.h"
+#include "base/convert_to.h"
+#include "base/fs.h"
+#include "base/fstream_path.h"
+#include "base/serialization.h"
+#include "doc/string_io.h"
+
+#include <fstream>
+
+namespace app { namespace crash {
+
+using namespace base::serialization;
+using namespace base::serialization::little_endian;
+
+static const char* kLogPrefix = "log.";
+
+std::string log_filename(const std::string& dir, const int generation)
+{
+  return base::join_path(dir, kLogPrefix + base::convert_to<std::string>(generation));
+}
+
+bool is_log_filename(const std::string& fn, int* generation)
+{
+  if (fn.compare(0, 4, kLogPrefix) != 0 || fn.size() == 4)
+    return false;
+
+  for (std::size_t i = 4; i < fn.size(); ++i)
+    if (fn[i] < '0' || fn[i] > '9')
+      return false;
+
+  if (generation)
+    *generation = base::convert_to<int>(fn.substr(4));
+  return true;
+}
+
+uint64_t write_log_record(std::ostream& os,
+                          const std::string& prefix,
+                          const doc::ObjectId id,
+                          const doc::ObjectVersion version,
+                          const std::string& data)
+{
+  const auto start = os.tellp();
+  write32(os, RECORD_MAGIC_NUMBER);
+  doc::write_string(os, prefix);
+  write32(os, id);
+  write32(os, version);
+  write32(os, data.size());
+  os.write(data.data(), data.size());
+  write32(os, MAGIC_NUMBER);
+  return uint64_t(os.tellp() - start);
+}
+
+std::vector<LogRecord> read_log_records(const std::string& fn)
+{
+  std::vector<LogRecord> records;
+  std::ifstream s(FSTREAM_PATH(fn), std::ifstream::binary);
+  if (!s)
+    return records;
+
+  s.seekg(0, std::ios::end);
+  const uint64_t fileSize = s.tellg();
+  s.seekg(0);
+
+  while (s) {
+    LogRecord rec;
+    rec.offset = s.tellg();
+    if (read32(s) != RECORD_MAGIC_NUMBER || !s)
+      break;
+
+    rec.prefix = doc::read_string(s);
+    rec.id = read32(s);
+    rec.version = read32(s);
+    const uint32_t dataSize = read32(s);
+    rec.dataOffset = s.tellg();
+    if (!s || rec.dataOffset + dataSize + 4 > fileSize)
+      break; // Truncated record
+
+    s.seekg(dataSize, std::ios::cur);
+    rec.size = rec.dataOffset + dataSize + 4 - rec.offset;
+
+    // Ignore records that weren't fully written
+    if (read32(s) == MAGIC_NUMBER && s && rec.id && rec.version)
+      records.push_back(rec);
+  }
+  return records;
+}
+
+}} // namespace app::crash
@@ -0,0 +1,63 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_CRASH_OBJECTS_LOG_H_INCLUDED
+#define APP_CRASH_OBJECTS_LOG_H_INCLUDED
+#pragma once
+
+#include "doc/object_id.h"
+#include "doc/object_version.h"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace app { namespace crash {
+
+// Objects of a document can be saved in log files ("log.N" where N
+// is the generation of the log), where each new version of an object
+// is appended as a record:
+//
+//   RECORD_MAGIC_NUMBER
+//   prefix (string, e.g. "img", "cel", etc.)
+//   object ID (uint32)
+//   object version (uint32)
+//   data size (uint32)
+//   data (same content as the "prefix-ID.version" files)
+//   MAGIC_NUMBER (to know that the record was fully written)
+//
+// Older generations of the log are deleted when the log is compacted.
+
+const uint32_t RECORD_MAGIC_NUMBER = 0x524A424F; // 'OBJR' in ASCII
+
+struct LogRecord {
+  std::string prefix;
+  doc::ObjectId id = 0;
+  doc::ObjectVersion version = 0;
+  uint64_t offset = 0;     // Position of the whole record in the log file
+  uint64_t size = 0;       // Size of the whole record
+  uint64_t dataOffset = 0; // Position of the object data in the log file
+};
+
+std::string log_filename(const std::string& dir, const int generation);
+
+// Returns true if the given filename (without path) is a log file.
+bool is_log_filename(const std::string& fn, int* generation);
+
+// Appends a new record to the log, returns the size of the record.
+uint64_t write_log_record(std::ostream& os,
+                          const std::string& prefix,
+                          const doc::ObjectId id,
+                          const doc::ObjectVersion version,
+                          const std::string& data);
+
+// Returns all the fully written records in the given log file.
+std::vector<LogRecord> read_log_records(const std::string& fn);
+
+}} // namespace app::crash
+
+#endif
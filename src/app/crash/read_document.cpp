@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -14,6 +14,7 @@
 #include "app/console.h"
 #include "app/crash/internals.h"
 #include "app/crash/log.h"
+#include "app/crash/objects_log.h"
 #include "app/doc.h"
 #include "base/convert_to.h"
 #include "base/exception.h"
@@ -37,6 +38,7 @@
 #include "doc/sprite.h"
 #include "doc/string_io.h"
 #include "doc/subobjects_io.h"
+#include "doc/task_group.h"
 #include "doc/tag.h"
 #include "doc/tag_io.h"
 #include "doc/tileset.h"
@@ -47,8 +49,13 @@
 #include "doc/uuid_io.h"
 #include "fixmath/fixmath.h"
 
+#include <algorithm>
 #include <fstream>
 #include <map>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
 
 namespace app { namespace crash {
 
@@ -78,6 +85,12 @@ public:
     , m_taskToken(t)
   {
     for (const auto& fn : base::list_files(dir, base::ItemType::Files)) {
+      int generation;
+      if (is_log_filename(fn, &generation)) {
+        addLogRecords(base::join_path(m_dir, fn));
+        continue;
+      }
+
       auto i = fn.find('-');
       if (i == std::string::npos)
         continue; // Has no ID
@@ -100,18 +113,10 @@ public:
         continue;
       }
 
-      ObjVersions& versions = m_objVersions[id];
-      versions.add(ver);
-
-      if (fn.compare(0, 3, "doc") == 0) {
-        if (!m_docId)
-          m_docId = id;
-        else {
-          ASSERT(m_docId == id);
-        }
+      if (fn.compare(0, 3, "img") == 0)
+        m_imageIds.insert(id);
 
-        m_docVersions = &versions;
-      }
+      addVersion(fn.substr(0, 3) == "doc", id, ver);
     }
   }
 
@@ -132,6 +137,33 @@ public:
   }
 
 private:
+  void addVersion(const bool isDoc, const ObjectId id, const ObjectVersion ver)
+  {
+    ObjVersions& versions = m_objVersions[id];
+    versions.add(ver);
+
+    if (isDoc) {
+      if (!m_docId)
+        m_docId = id;
+      else {
+        ASSERT(m_docId == id);
+      }
+
+      m_docVersions = &versions;
+    }
+  }
+
+  void addLogRecords(const std::string& logfn)
+  {
+    for (const LogRecord& rec : read_log_records(logfn)) {
+      if (rec.prefix == "img")
+        m_imageIds.insert(rec.id);
+
+      addVersion(rec.prefix == "doc", rec.id, rec.version);
+      m_logRecords[std::make_pair(rec.id, rec.version)] = LogObject{ logfn, rec.dataOffset };
+    }
+  }
+
   const ObjectVersion docId() const { return m_docId; }
 
   const ObjVersions* docVersions() const { return m_docVersions; }
@@ -162,8 +194,29 @@ private:
   template<typename T>
   T loadObject(const char* prefix, ObjectId id, T (Reader::*readMember)(std::ifstream&))
   {
-    const ObjVersions& versions = m_objVersions[id];
+    T obj = tryLoadObject(prefix, id, readMember);
+    if (obj)
+      return obj;
+
+    // Show error only if we've failed to load all versions
+    if (!m_loadInfo)
+      Console().printf("Error loading object %s #%d\n", prefix, id);
 
+    return nullptr;
+  }
+
+  // Same as loadObject() but without reporting errors in the console
+  // and without modifying the Reader state, so it can be called from
+  // worker threads for objects that are read without accessing the
+  // Reader (e.g. images).
+  template<typename T>
+  T tryLoadObject(const char* prefix, ObjectId id, T (Reader::*readMember)(std::ifstream&))
+  {
+    auto versionsIt = m_objVersions.find(id);
+    if (versionsIt == m_objVersions.end())
+      return nullptr;
+
+    const ObjVersions& versions = versionsIt->second;
     for (size_t i = 0; i < versions.size(); ++i) {
       ObjectVersion ver = versions[i];
       if (!ver)
@@ -177,10 +230,18 @@ private:
       fn.push_back('.');
       fn += base::convert_to<std::string>(ver);
 
-      std::ifstream s(FSTREAM_PATH(base::join_path(m_dir, fn)), std::ifstream::binary);
       T obj = nullptr;
-      if (read32(s) == MAGIC_NUMBER)
+      auto it = m_logRecords.find(std::make_pair(id, ver));
+      if (it != m_logRecords.end()) {
+        std::ifstream s(FSTREAM_PATH(it->second.logfn), std::ifstream::binary);
+        s.seekg(it->second.offset);
         obj = (this->*readMember)(s);
+      }
+      else {
+        std::ifstream s(FSTREAM_PATH(base::join_path(m_dir, fn)), std::ifstream::binary);
+        if (read32(s) == MAGIC_NUMBER)
+          obj = (this->*readMember)(s);
+      }
 
       if (obj) {
         RECO_TRACE("RECO: %s #%d v%d restored successfully\n", prefix, id, ver);
@@ -190,12 +251,51 @@ private:
         RECO_TRACE("RECO: %s #%d v%d was not restored\n", prefix, id, ver);
       }
     }
+    return nullptr;
+  }
 
-    // Show error only if we've failed to load all versions
-    if (!m_loadInfo)
-      Console().printf("Error loading object %s #%d\n", prefix, id);
+  // Decodes all images in parallel, so then reading the cels only
+  // links the already decoded images (see getImageRef()). Images
+  // that cannot be decoded here are loaded again from the cels to
+  // report the errors.
+  void loadImagesInParallel()
+  {
+    std::vector<ObjectId> ids;
+    for (ObjectId id : m_imageIds) {
+      if (m_images.find(id) == m_images.end())
+        ids.push_back(id);
+    }
+    if (ids.empty())
+      return;
+
+    std::vector<ImageRef> images(ids.size());
+    std::mutex mutex;
+    std::size_t done = 0;
+
+    doc::TaskGroup tasks;
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+      tasks.run([this, i, &ids, &images, &mutex, &done] {
+        if (!canceled()) {
+          try {
+            images[i].reset(tryLoadObject<Image*>("img", ids[i], &Reader::readImage));
+          }
+          catch (const std::exception&) {
+            images[i].reset();
+          }
+        }
 
-    return nullptr;
+        const std::lock_guard lock(mutex);
+        ++done;
+        if (m_taskToken)
+          m_taskToken->set_progress(0.5f * float(done) / float(ids.size()));
+      });
+    }
+    tasks.wait();
+
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+      if (images[i])
+        m_images[ids[i]] = images[i];
+    }
   }
 
   Doc* readDocument(std::ifstream& s)
@@ -318,7 +418,11 @@ private:
       Console().printf("Invalid number of layers #%d\n", nlayers);
     }
 
-    // Read all cels
+    // Read all cels (decoding their images in parallel first)
+    loadImagesInParallel();
+    if (canceled())
+      return nullptr;
+
     for (size_t i = 0; i < m_celsToLoad.size(); ++i) {
       if (canceled())
         return nullptr;
@@ -340,7 +444,7 @@ private:
       }
 
       if (m_taskToken) {
-        m_taskToken->set_progress(float(i) / float(m_celsToLoad.size()));
+        m_taskToken->set_progress(0.5f + 0.5f * float(i) / float(m_celsToLoad.size()));
       }
     }
 
@@ -585,12 +689,21 @@ private:
   SerialFormat m_serial;
   Sprite* m_sprite; // Used to pass the sprite in LayerImage() ctor
   std::string m_dir;
+
+  // Objects saved in logs, (ID, version) -> position in the log
+  struct LogObject {
+    std::string logfn;
+    uint64_t offset;
+  };
+  std::map<std::pair<ObjectId, ObjectVersion>, LogObject> m_logRecords;
   ObjectVersion m_docId;
   ObjVersionsMap m_objVersions;
   ObjVersions* m_docVersions;
   DocumentInfo* m_loadInfo;
   std::vector<std::pair<ObjectId, ObjectId>> m_celsToLoad;
   std::map<ObjectId, ImageRef> m_images;
+  // IDs of all images found in the backup (decoded in parallel)
+  std::set<ObjectId> m_imageIds;
   std::map<ObjectId, CelDataRef> m_celdatas;
   // Each ObjectId is a tileset ID that didn't contain the empty tile
   // as the first tile (this was an old format used in internal betas)
@@ -639,27 +752,41 @@ Doc* read_document_with_raw_images(const std::string& dir, RawImagesAs as, base:
     if (t)
       t->set_progress((i++) / fns.size());
 
-    if (fn.compare(0, 3, "img") != 0)
-      continue;
-
-    std::ifstream s(FSTREAM_PATH(base::join_path(dir, fn)), std::ifstream::binary);
-    if (!s)
-      continue;
-
-    ImageRef img;
-    if (read32(s) == MAGIC_NUMBER)
-      img.reset(read_image(s, false));
+    std::vector<ImageRef> imgs;
+    if (is_log_filename(fn, nullptr)) {
+      const std::string logfn = base::join_path(dir, fn);
+      std::ifstream s(FSTREAM_PATH(logfn), std::ifstream::binary);
+      for (const LogRecord& rec : read_log_records(logfn)) {
+        if (rec.prefix != "img")
+          continue;
+        s.clear();
+        s.seekg(rec.dataOffset);
+        imgs.push_back(ImageRef(read_image(s, false)));
+      }
+    }
+    else if (fn.compare(0, 3, "img") == 0) {
+      std::ifstream s(FSTREAM_PATH(base::join_path(dir, fn)), std::ifstream::binary);
+      if (!s)
+        continue;
 
-    if (img) {
-      lay->addCel(new Cel(frame, img));
+      if (read32(s) == MAGIC_NUMBER)
+        imgs.push_back(ImageRef(read_image(s, false)));
+      else
+        imgs.push_back(nullptr);
     }
 
-    switch (as) {
-      case RawImagesAs::kFrames: ++frame; break;
-      case RawImagesAs::kLayers:
-        lay = new LayerImage(spr);
-        spr->root()->addLayer(lay);
-        break;
+    for (const ImageRef& img : imgs) {
+      if (img) {
+        lay->addCel(new Cel(frame, img));
+      }
+
+      switch (as) {
+        case RawImagesAs::kFrames: ++frame; break;
+        case RawImagesAs::kLayers:
+          lay = new LayerImage(spr);
+          spr->root()->addLayer(lay);
+          break;
+      }
     }
   }
   if (as == RawImagesAs::kFrames) {
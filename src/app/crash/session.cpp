@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -46,24 +46,40 @@ Session::Backup::Backup(const std::string& dir) : m_dir(dir)
 {
 }
 
+bool Session::Backup::hasDescription() const
+{
+  const std::lock_guard lock(m_mutex);
+  return !m_desc.empty();
+}
+
+void Session::Backup::loadDescription() const
+{
+  if (hasDescription())
+    return;
+
+  DocumentInfo info;
+  read_document_info(m_dir, info);
+
+  const std::lock_guard lock(m_mutex);
+  m_fn = info.filename;
+  m_desc = fmt::format("{} Sprite {}x{}, {} {}",
+                       info.mode == ColorMode::RGB       ? "RGB" :
+                       info.mode == ColorMode::GRAYSCALE ? "Grayscale" :
+                       info.mode == ColorMode::INDEXED   ? "Indexed" :
+                       info.mode == ColorMode::BITMAP    ? "Bitmap" :
+                                                           "Unknown",
+                       info.width,
+                       info.height,
+                       info.frames,
+                       info.frames == 1 ? "frame" : "frames");
+}
+
 std::string Session::Backup::description(const bool withFullPath) const
 {
   // Lazy initialize description and filename.
-  if (m_desc.empty()) {
-    DocumentInfo info;
-    read_document_info(m_dir, info);
-    m_fn = info.filename;
-    m_desc = fmt::format("{} Sprite {}x{}, {} {}",
-                         info.mode == ColorMode::RGB       ? "RGB" :
-                         info.mode == ColorMode::GRAYSCALE ? "Grayscale" :
-                         info.mode == ColorMode::INDEXED   ? "Indexed" :
-                         info.mode == ColorMode::BITMAP    ? "Bitmap" :
-                                                             "Unknown",
-                         info.width,
-                         info.height,
-                         info.frames,
-                         info.frames == 1 ? "frame" : "frames");
-  }
+  loadDescription();
+
+  const std::lock_guard lock(m_mutex);
   return fmt::format("{}: {}", m_desc, withFullPath ? m_fn : base::get_file_name(m_fn));
 }
 
@@ -239,13 +255,22 @@ public:
 };
 
 bool Session::saveDocumentChanges(Doc* doc)
+{
+  std::string dir = base::join_path(m_path, base::convert_to<std::string>(doc->id()));
+  if (!writeDocumentChanges(dir, doc))
+    return false;
+
+  // Compact the log without locking the document
+  return compact_document_log(dir, doc->id());
+}
+
+bool Session::writeDocumentChanges(const std::string& dir, Doc* doc)
 {
   CustomWeakDocReader reader(doc);
   if (!reader.isLocked())
     return false;
 
   app::Context ctx;
-  std::string dir = base::join_path(m_path, base::convert_to<std::string>(doc->id()));
   RECO_TRACE("RECO: Saving document '%s'...\n", dir.c_str());
 
   // Create directory for document
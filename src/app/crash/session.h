@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -17,6 +17,7 @@
 
 #include <fstream>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -32,10 +33,20 @@ public:
   public:
     Backup(const std::string& dir);
     const std::string& dir() const { return m_dir; }
+
+    // Returns true if the document information was already read, so
+    // description() doesn't need to access the disk.
+    bool hasDescription() const;
+
+    // Reads the document information (it can be called from a worker
+    // thread to avoid blocking the UI).
+    void loadDescription() const;
+
     std::string description(const bool withFullPath) const;
 
   private:
     std::string m_dir;
+    mutable std::mutex m_mutex;
     mutable std::string m_desc;
     mutable std::string m_fn;
   };
@@ -68,6 +79,7 @@ public:
   void deleteBackup(const BackupPtr& backup);
 
 private:
+  bool writeDocumentChanges(const std::string& dir, Doc* doc);
   Doc* restoreBackupDoc(const std::string& backupDir, base::task_token* t);
   void loadPid();
   std::string pidFilename() const;
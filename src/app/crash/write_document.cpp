@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -13,6 +13,7 @@
 
 #include "app/crash/internals.h"
 #include "app/crash/log.h"
+#include "app/crash/objects_log.h"
 #include "app/doc.h"
 #include "base/convert_to.h"
 #include "base/fs.h"
@@ -43,9 +44,16 @@
 #include "doc/user_data_io.h"
 #include "doc/uuid_io.h"
 #include "fixmath/fixmath.h"
+#include "zlib.h"
 
+#include <algorithm>
 #include <fstream>
 #include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <vector>
 
 namespace app { namespace crash {
 
@@ -55,21 +63,106 @@ using namespace doc;
 
 namespace {
 
-static std::map<ObjectId, ObjVersionsMap> g_docVersions;
-static std::map<ObjectId, base::paths> g_deleteFiles;
+// Backups are written often (and in the background), so we prefer
+// the fastest compression over the size of the files.
+const int kBackupCompressionLevel = Z_BEST_SPEED;
+
+// Information about the objects log of each document
+struct DocLog {
+  // Current log file is "log.<generation>"
+  int generation = 0;
+  uint64_t size = 0;
+
+  // Latest record of each object that is still in the document
+  std::map<ObjectId, LogRecord> live;
+  uint64_t liveSize = 0;
+
+  // True if we couldn't write a record completely in the current log
+  bool broken = false;
+
+  bool needsCompaction() const
+  {
+    return broken || (size > kMinSizeToCompact && size > 2 * liveSize);
+  }
+
+  static constexpr uint64_t kMinSizeToCompact = 4 * 1024 * 1024;
+};
+
+// Backup information of each document
+struct DocBackup {
+  ObjVersionsMap versions;
+  DocLog log;
+};
+
+// The backup thread writes documents while the UI thread can remove
+// them from the session (when they are closed), so the map is guarded
+// with a mutex. The information of each document is used only from
+// the backup thread, and it's kept alive by the shared pointer while
+// it's being used even if the document is removed from the map.
+static std::mutex g_docLogsMutex;
+static std::map<ObjectId, std::shared_ptr<DocBackup>> g_docLogs;
+
+std::shared_ptr<DocBackup> get_doc_backup(const ObjectId docId, const bool create)
+{
+  const std::lock_guard lock(g_docLogsMutex);
+  auto it = g_docLogs.find(docId);
+  if (it != g_docLogs.end())
+    return it->second;
+  if (!create)
+    return nullptr;
+  auto backup = std::make_shared<DocBackup>();
+  g_docLogs[docId] = backup;
+  return backup;
+}
 
 class Writer {
 public:
-  Writer(const std::string& dir, Doc* doc, doc::CancelIO* cancel)
+  Writer(const std::string& dir,
+         Doc* doc,
+         ObjVersionsMap& objVersions,
+         DocLog& log,
+         const int compressionLevel,
+         doc::CancelIO* cancel)
     : m_dir(dir)
     , m_doc(doc)
-    , m_objVersions(g_docVersions[doc->id()])
-    , m_deleteFiles(g_deleteFiles[doc->id()])
+    , m_objVersions(objVersions)
+    , m_log(log)
+    , m_compressionLevel(compressionLevel)
     , m_cancel(cancel)
   {
   }
 
   bool saveDocument()
+  {
+    if (m_log.broken)
+      return false;
+
+    m_logFile.open(FSTREAM_PATH(log_filename(m_dir, m_log.generation)),
+                   std::ofstream::binary | std::ofstream::app);
+    if (!m_logFile)
+      return false;
+    m_logFile.seekp(0, std::ios::end);
+    m_log.size = m_logFile.tellp();
+
+    if (!saveObjects())
+      return false;
+
+    // Objects that are not in the document anymore are not needed in
+    // the next generation of the log
+    for (auto it = m_log.live.begin(); it != m_log.live.end();) {
+      if (m_savedObjects.find(it->first) == m_savedObjects.end()) {
+        m_log.liveSize -= it->second.size;
+        m_objVersions.erase(it->first);
+        it = m_log.live.erase(it);
+      }
+      else
+        ++it;
+    }
+    return true;
+  }
+
+private:
+  bool saveObjects()
   {
     Sprite* spr = m_doc->sprite();
 
@@ -140,15 +233,12 @@ public:
     if (!saveObject("doc", m_doc, &Writer::writeDocumentFile))
       return false;
 
-    // Delete old files after all files are correctly saved.
-    deleteOldVersions();
     return true;
   }
 
-private:
   bool isCanceled() const { return (m_cancel && m_cancel->isCanceled()); }
 
-  bool writeDocumentFile(std::ofstream& s, Doc* doc)
+  bool writeDocumentFile(std::ostream& s, Doc* doc)
   {
     write32(s, doc->sprite()->id());
     write_string(s, doc->filename());
@@ -156,7 +246,7 @@ private:
     return true;
   }
 
-  bool writeSprite(std::ofstream& s, Sprite* spr)
+  bool writeSprite(std::ostream& s, Sprite* spr)
   {
     // Header
     write8(s, int(spr->colorMode()));
@@ -211,7 +301,7 @@ private:
     return true;
   }
 
-  bool writeGridBounds(std::ofstream& s, const gfx::Rect& grid)
+  bool writeGridBounds(std::ostream& s, const gfx::Rect& grid)
   {
     write16(s, (int16_t)grid.x);
     write16(s, (int16_t)grid.y);
@@ -220,7 +310,7 @@ private:
     return true;
   }
 
-  bool writeColorSpace(std::ofstream& s, const gfx::ColorSpaceRef& colorSpace)
+  bool writeColorSpace(std::ostream& s, const gfx::ColorSpaceRef& colorSpace)
   {
     write16(s, colorSpace->type());
     write16(s, colorSpace->flags());
@@ -235,7 +325,7 @@ private:
     return true;
   }
 
-  void writeAllLayersID(std::ofstream& s, ObjectId parentId, const LayerGroup* group)
+  void writeAllLayersID(std::ostream& s, ObjectId parentId, const LayerGroup* group)
   {
     for (const Layer* lay : group->layers()) {
       write32(s, lay->id());
@@ -246,7 +336,7 @@ private:
     }
   }
 
-  bool writeLayerStructure(std::ofstream& s, Layer* lay)
+  bool writeLayerStructure(std::ostream& s, Layer* lay)
   {
     write32(s, static_cast<int>(lay->flags())); // Flags
     write16(s, static_cast<int>(lay->type()));  // Type
@@ -288,46 +378,49 @@ private:
     return true;
   }
 
-  bool writeCel(std::ofstream& s, Cel* cel)
+  bool writeCel(std::ostream& s, Cel* cel)
   {
     write_cel(s, cel);
     return true;
   }
 
-  bool writeCelData(std::ofstream& s, CelData* celdata)
+  bool writeCelData(std::ostream& s, CelData* celdata)
   {
     write_celdata(s, celdata);
     return true;
   }
 
-  bool writeImage(std::ofstream& s, Image* img) { return write_image(s, img, m_cancel); }
+  bool writeImage(std::ostream& s, Image* img)
+  {
+    return write_image(s, img, m_cancel, m_compressionLevel);
+  }
 
-  bool writePalette(std::ofstream& s, Palette* pal)
+  bool writePalette(std::ostream& s, Palette* pal)
   {
     write_palette(s, pal);
     return true;
   }
 
-  bool writeTileset(std::ofstream& s, Tileset* tileset)
+  bool writeTileset(std::ostream& s, Tileset* tileset)
   {
-    write_tileset(s, tileset);
+    write_tileset(s, tileset, nullptr, m_compressionLevel);
     return true;
   }
 
-  bool writeFrameTag(std::ofstream& s, Tag* frameTag)
+  bool writeFrameTag(std::ostream& s, Tag* frameTag)
   {
     write_tag(s, frameTag);
     return true;
   }
 
-  bool writeSlice(std::ofstream& s, Slice* slice)
+  bool writeSlice(std::ostream& s, Slice* slice)
   {
     write_slice(s, slice);
     return true;
   }
 
   template<typename T>
-  bool saveObject(const char* prefix, T* obj, bool (Writer::*writeMember)(std::ofstream&, T*))
+  bool saveObject(const char* prefix, T* obj, bool (Writer::*writeMember)(std::ostream&, T*))
   {
     if (isCanceled())
       return false;
@@ -335,34 +428,35 @@ private:
     if (!obj->version())
       obj->incrementVersion();
 
+    m_savedObjects.insert(obj->id());
+
     ObjVersions& versions = m_objVersions[obj->id()];
     if (versions.newer() == obj->version())
       return true;
 
-    std::string fn = prefix;
-    fn.push_back('-');
-    fn += base::convert_to<std::string>(obj->id());
-
-    std::string fullfn = base::join_path(m_dir, fn);
-    std::string oldfn = fullfn + "." + base::convert_to<std::string>(versions.older());
-    fullfn += "." + base::convert_to<std::string>(obj->version());
-
-    std::ofstream s(FSTREAM_PATH(fullfn), std::ofstream::binary);
-    write32(s, 0);                     // Leave a room for the magic number
-    if (!(this->*writeMember)(s, obj)) // Write the object
+    // Serialize the object in memory first, so a canceled operation
+    // doesn't leave a partial record in the log.
+    std::ostringstream data(std::ios::binary);
+    if (!(this->*writeMember)(data, obj)) // Write the object
       return false;
 
-    // Flush all data. In this way we ensure that the magic number is
-    // the last thing being written in the file.
-    s.flush();
-
-    // Write the magic number
-    s.seekp(0);
-    write32(s, MAGIC_NUMBER);
+    LogRecord rec;
+    rec.prefix = prefix;
+    rec.id = obj->id();
+    rec.version = obj->version();
+    rec.offset = m_log.size;
+    rec.size = write_log_record(m_logFile, rec.prefix, rec.id, rec.version, data.str());
+    m_logFile.flush();
+    if (!m_logFile) {
+      // The next backup will start a new log
+      m_log.broken = true;
+      return false;
+    }
+    m_log.size += rec.size;
 
-    // Remove the older version
-    if (versions.older() && base::is_file(oldfn))
-      m_deleteFiles.push_back(oldfn);
+    auto& live = m_log.live[rec.id];
+    m_log.liveSize += rec.size - live.size;
+    live = rec;
 
     // Rotate versions and add the latest one
     versions.rotateRevisions(obj->version());
@@ -371,26 +465,13 @@ private:
     return true;
   }
 
-  void deleteOldVersions()
-  {
-    while (!m_deleteFiles.empty() && !isCanceled()) {
-      std::string file = m_deleteFiles.back();
-      m_deleteFiles.erase(m_deleteFiles.end() - 1);
-
-      try {
-        RECO_TRACE(" - Deleting <%s>\n", file.c_str());
-        base::delete_file(file);
-      }
-      catch (const std::exception&) {
-        RECO_TRACE(" - Cannot delete <%s>\n", file.c_str());
-      }
-    }
-  }
-
   std::string m_dir;
   Doc* m_doc;
   ObjVersionsMap& m_objVersions;
-  base::paths& m_deleteFiles;
+  DocLog& m_log;
+  std::ofstream m_logFile;
+  std::set<ObjectId> m_savedObjects;
+  int m_compressionLevel;
   doc::CancelIO* m_cancel;
 };
 
@@ -401,26 +482,95 @@ private:
 
 bool write_document(const std::string& dir, Doc* doc, doc::CancelIO* cancel)
 {
-  Writer writer(dir, doc, cancel);
+  const std::shared_ptr<DocBackup> backup = get_doc_backup(doc->id(), true);
+  Writer writer(dir, doc, backup->versions, backup->log, kBackupCompressionLevel, cancel);
   return writer.saveDocument();
 }
 
-void delete_document_internals(Doc* doc)
+bool write_document_snapshot(const std::string& dir, Doc* doc, doc::CancelIO* cancel)
 {
-  ASSERT(doc);
+  // Independent information from the backups of the document, so
+  // all objects are written in the log
+  ObjVersionsMap objVersions;
+  DocLog log;
+  Writer writer(dir, doc, objVersions, log, Z_DEFAULT_COMPRESSION, cancel);
+  return writer.saveDocument();
+}
+
+bool compact_document_log(const std::string& dir, const doc::ObjectId docId)
+{
+  const std::shared_ptr<DocBackup> backup = get_doc_backup(docId, false);
+  if (!backup || !backup->log.needsCompaction())
+    return true;
+
+  DocLog& log = backup->log;
+  const std::string oldfn = log_filename(dir, log.generation);
+  const std::string newfn = log_filename(dir, log.generation + 1);
+
+  RECO_TRACE("RECO: Compacting log %s (%d/%d live bytes)\n",
+             oldfn.c_str(),
+             int(log.liveSize),
+             int(log.size));
+
+  // Sort records by offset to read the old log sequentially
+  std::vector<LogRecord*> records;
+  for (auto& kv : log.live)
+    records.push_back(&kv.second);
+  std::sort(records.begin(), records.end(), [](const LogRecord* a, const LogRecord* b) {
+    return a->offset < b->offset;
+  });
 
-  // The document could not be inside g_documentObjects in case it was
-  // never saved by the backup process.
   {
-    auto it = g_docVersions.find(doc->id());
-    if (it != g_docVersions.end())
-      g_docVersions.erase(it);
+    std::ifstream src(FSTREAM_PATH(oldfn), std::ifstream::binary);
+    std::ofstream dst(FSTREAM_PATH(newfn), std::ofstream::binary | std::ofstream::trunc);
+    if (!src || !dst)
+      return false;
+
+    std::vector<char> buf;
+    uint64_t size = 0;
+    for (LogRecord* rec : records) {
+      buf.resize(rec->size);
+      src.seekg(rec->offset);
+      src.read(buf.data(), buf.size());
+      dst.write(buf.data(), buf.size());
+      if (!src || !dst) {
+        dst.close();
+        base::delete_file(newfn);
+        return false;
+      }
+      rec->offset = size;
+      size += rec->size;
+    }
+    dst.flush();
+    if (!dst) {
+      dst.close();
+      base::delete_file(newfn);
+      return false;
+    }
+    log.size = log.liveSize = size;
   }
-  {
-    auto it = g_deleteFiles.find(doc->id());
-    if (it != g_deleteFiles.end())
-      g_deleteFiles.erase(it);
+
+  // Now the new log contains all the information, so we can delete
+  // the old one.
+  ++log.generation;
+  log.broken = false;
+  try {
+    base::delete_file(oldfn);
+  }
+  catch (const std::exception&) {
+    RECO_TRACE(" - Cannot delete <%s>\n", oldfn.c_str());
   }
+  return true;
+}
+
+void delete_document_internals(Doc* doc)
+{
+  ASSERT(doc);
+
+  // The document could not be inside g_docLogs in case it was never
+  // saved by the backup process.
+  const std::lock_guard lock(g_docLogsMutex);
+  g_docLogs.erase(doc->id());
 }
 
 }} // namespace app::crash
@@ -1,4 +1,5 @@
 // Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
 // Copyright (C) 2001-2016  David Capello
 //
 // This program is distributed under the terms of
@@ -8,6 +9,8 @@
 #define APP_CRASH_WRITE_DOCUMENT_H_INCLUDED
 #pragma once
 
+#include "doc/object_id.h"
+
 #include <string>
 
 namespace doc {
@@ -19,7 +22,21 @@ class Doc;
 
 namespace crash {
 
+// Appends the objects of the document that were modified since the
+// last call to the log of the document.
 bool write_document(const std::string& dir, Doc* doc, doc::CancelIO* cancel);
+
+// Writes all the objects of the document in a new log in the given
+// (empty) directory, which can be loaded later with
+// read_document(). It doesn't use/modify the information of the
+// backups written with write_document(), so it can be used from any
+// thread for any document that is not being modified.
+bool write_document_snapshot(const std::string& dir, Doc* doc, doc::CancelIO* cancel);
+
+// Rewrites the log of the document with the latest version of each
+// object if it contains too many old versions. This function doesn't
+// need to lock the document.
+bool compact_document_log(const std::string& dir, const doc::ObjectId docId);
 void delete_document_internals(Doc* doc);
 
 } // namespace crash
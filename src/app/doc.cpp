@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -39,8 +39,10 @@
 #include "os/window.h"
 #include "ui/system.h"
 
+#include <algorithm>
 #include <limits>
 #include <map>
+#include <vector>
 
 #define DOC_TRACE(...) // TRACEARGS(__VA_ARGS__)
 
@@ -49,6 +51,39 @@ namespace app {
 using namespace base;
 using namespace doc;
 
+namespace {
+
+// Number of alive DeferDocNotifications objects in this thread, and
+// documents with pending notifications.
+thread_local int g_deferNotifications = 0;
+thread_local std::vector<ObjectId> g_pendingDocs;
+
+} // anonymous namespace
+
+// Notifications collected by a document while they are deferred.
+// Objects are referenced by ID because they can be deleted before
+// the notifications are sent.
+struct Doc::DeferredNotifications {
+  struct Property {
+    PropertyNotification notification;
+    ObjectId spriteId;
+    ObjectId objectId; // Layer, cel, tag, slice, or object with user data
+    bool withUserData; // True if objectId is the DocEvent::withUserData()
+    frame_t frame;
+
+    bool operator==(const Property& o) const
+    {
+      return notification == o.notification && spriteId == o.spriteId &&
+             objectId == o.objectId && withUserData == o.withUserData && frame == o.frame;
+    }
+  };
+
+  std::vector<Property> properties;
+  std::map<std::pair<ObjectId, frame_t>, gfx::Region> modifiedPixels;
+  std::map<ObjectId, gfx::Region> exposedPixels;
+  bool generalUpdate = false;
+};
+
 Doc::Doc(Sprite* sprite)
   : m_ctx(nullptr)
   , m_flags(kMaskVisible)
@@ -217,6 +252,11 @@ void Doc::setLayerEditableWithNotifications(Layer* layer, const bool editable)
 
 void Doc::notifyGeneralUpdate()
 {
+  if (auto deferred = deferredNotifications()) {
+    deferred->generalUpdate = true;
+    return;
+  }
+
   DocEvent ev(this);
   notify_observers<DocEvent&>(&DocObserver::onGeneralUpdate, ev);
 }
@@ -239,6 +279,11 @@ void Doc::notifyPaletteChanged()
 
 void Doc::notifySpritePixelsModified(Sprite* sprite, const gfx::Region& region, frame_t frame)
 {
+  if (auto deferred = deferredNotifications()) {
+    deferred->modifiedPixels[std::make_pair(sprite->id(), frame)] |= region;
+    return;
+  }
+
   DocEvent ev(this);
   ev.sprite(sprite);
   ev.region(region);
@@ -248,6 +293,11 @@ void Doc::notifySpritePixelsModified(Sprite* sprite, const gfx::Region& region,
 
 void Doc::notifyExposeSpritePixels(Sprite* sprite, const gfx::Region& region)
 {
+  if (auto deferred = deferredNotifications()) {
+    deferred->exposedPixels[sprite->id()] |= region;
+    return;
+  }
+
   DocEvent ev(this);
   ev.sprite(sprite);
   ev.region(region);
@@ -356,6 +406,101 @@ void Doc::notifySliceDuplicated(Slice* slice)
   notify_observers<DocEvent&>(&DocObserver::onSliceDuplicated, ev);
 }
 
+void Doc::notifyPropertyChange(PropertyNotification notification, DocEvent& ev)
+{
+  if (auto deferred = deferredNotifications()) {
+    ObjectId objectId = NullId;
+    if (ev.withUserData())
+      objectId = ev.withUserData()->id();
+    else if (ev.cel())
+      objectId = ev.cel()->id();
+    else if (ev.layer())
+      objectId = ev.layer()->id();
+    else if (ev.tag())
+      objectId = ev.tag()->id();
+    else if (ev.slice())
+      objectId = ev.slice()->id();
+
+    const DeferredNotifications::Property property = {
+      notification,
+      (ev.sprite() ? ev.sprite()->id() : NullId),
+      objectId,
+      (ev.withUserData() != nullptr),
+      ev.frame()
+    };
+    auto& properties = deferred->properties;
+    if (std::find(properties.begin(), properties.end(), property) == properties.end())
+      properties.push_back(property);
+    return;
+  }
+
+  notify_observers<DocEvent&>(notification, ev);
+}
+
+Doc::DeferredNotifications* Doc::deferredNotifications()
+{
+  if (!DeferDocNotifications::isDeferring())
+    return nullptr;
+
+  if (!m_deferred) {
+    m_deferred = std::make_unique<DeferredNotifications>();
+    DeferDocNotifications::addPendingDoc(this);
+  }
+  return m_deferred.get();
+}
+
+void Doc::flushDeferredNotifications()
+{
+  std::unique_ptr<DeferredNotifications> deferred(std::move(m_deferred));
+  if (!deferred)
+    return;
+
+  for (const auto& property : deferred->properties) {
+    DocEvent ev(this);
+    if (property.spriteId) {
+      auto sprite = doc::get<Sprite>(property.spriteId);
+      if (!sprite)
+        continue;
+      ev.sprite(sprite);
+    }
+    if (property.objectId) {
+      auto object = doc::get<Object>(property.objectId);
+      if (!object)
+        continue;
+
+      if (property.withUserData) {
+        ev.withUserData(static_cast<WithUserData*>(object));
+      }
+      else {
+        switch (object->type()) {
+          case ObjectType::Cel:          ev.cel(static_cast<Cel*>(object)); break;
+          case ObjectType::LayerImage:
+          case ObjectType::LayerGroup:
+          case ObjectType::LayerTilemap: ev.layer(static_cast<Layer*>(object)); break;
+          case ObjectType::Tag:          ev.tag(static_cast<Tag*>(object)); break;
+          case ObjectType::Slice:        ev.slice(static_cast<Slice*>(object)); break;
+          default:                       break;
+        }
+      }
+    }
+    ev.frame(property.frame);
+    notify_observers<DocEvent&>(property.notification, ev);
+  }
+
+  for (const auto& [key, region] : deferred->modifiedPixels) {
+    if (auto sprite = doc::get<Sprite>(key.first))
+      notifySpritePixelsModified(sprite, region, key.second);
+  }
+
+  for (const auto& [spriteId, region] : deferred->exposedPixels) {
+    if (auto sprite = doc::get<Sprite>(spriteId))
+      notifyExposeSpritePixels(sprite, region);
+  }
+
+  if (deferred->generalUpdate)
+    notifyGeneralUpdate();
+}
+
 bool Doc::isModified() const
 {
   return !m_undo->isInSavedStateOrSimilar();
@@ -397,6 +542,19 @@ void Doc::setInhibitBackup(const bool inhibitBackup)
     m_flags &= ~kInhibitBackup;
 }
 
+bool Doc::deferBackup() const
+{
+  return (m_flags & kDeferBackup) == kDeferBackup;
+}
+
+void Doc::setDeferBackup(const bool deferBackup)
+{
+  if (deferBackup)
+    m_flags |= kDeferBackup;
+  else
+    m_flags &= ~kDeferBackup;
+}
+
 void Doc::markAsBackedUp()
 {
   DOC_TRACE("DOC: Mark as fully backed up", this);
@@ -447,22 +605,21 @@ void Doc::destroyMaskBoundaries()
 
 void Doc::generateMaskBoundaries(const Mask* mask)
 {
-  m_maskBoundaries.reset();
-
   // No mask specified? Use the current one in the document
   if (!mask) {
-    if (!isMaskVisible()) // The mask is hidden
-      return;             // Done, without boundaries
+    if (!isMaskVisible()) { // The mask is hidden
+      m_maskBoundaries.reset();
+      return; // Done, without boundaries
+    }
     else
       mask = this->mask(); // Use the document mask
   }
 
   ASSERT(mask);
 
-  if (!mask->isEmpty()) {
-    m_maskBoundaries.regen(mask->bitmap());
-    m_maskBoundaries.offset(mask->bounds().x, mask->bounds().y);
-  }
+  // Only the bands of rows that changed from the previous boundaries
+  // are generated again (or everything is reset for an empty mask).
+  m_maskBoundaries.regen(mask);
 
   notifySelectionBoundariesChanged();
 }
@@ -752,4 +909,41 @@ gfx::Point Doc::NoLastDrawingPoint()
   return gfx::Point(std::numeric_limits<int>::min(), std::numeric_limits<int>::min());
 }
 
+//////////////////////////////////////////////////////////////////////
+// DeferDocNotifications
+
+DeferDocNotifications::DeferDocNotifications()
+{
+  ++g_deferNotifications;
+}
+
+DeferDocNotifications::~DeferDocNotifications()
+{
+  ASSERT(g_deferNotifications > 0);
+  if (--g_deferNotifications > 0)
+    return;
+
+  // Documents can be deleted while notifications are deferred, so
+  // we get them by ID. New pending documents cannot be added while
+  // we flush (deferring is disabled at this point).
+  const std::vector<ObjectId> pendingDocs = std::move(g_pendingDocs);
+  g_pendingDocs.clear();
+  for (const ObjectId docId : pendingDocs) {
+    if (auto doc = doc::get<Doc>(docId))
+      doc->flushDeferredNotifications();
+  }
+}
+
+// static
+bool DeferDocNotifications::isDeferring()
+{
+  return (g_deferNotifications > 0);
+}
+
+// static
+void DeferDocNotifications::addPendingDoc(Doc* doc)
+{
+  g_pendingDocs.push_back(doc->id());
+}
+
 } // namespace app
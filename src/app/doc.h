@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -66,6 +66,7 @@ class Doc : public doc::Document,
     kInhibitBackup = 4,    // Inhibit the backup process
     kFullyBackedUp = 8,    // Full backup was done
     kReadOnly = 16,        // This document is read-only
+    kDeferBackup = 32,     // Wait to backup the document
   };
 
 public:
@@ -145,6 +146,13 @@ public:
   void notifyBeforeSlicesDuplication();
   void notifySliceDuplicated(Slice* slice);
 
+  // Notifies a change in a property of an object (a layer name, a
+  // cel position, etc.). If notifications are deferred (see
+  // DeferDocNotifications), several changes of the same property of
+  // the same object are notified just once at the end.
+  using PropertyNotification = void (DocObserver::*)(DocEvent&);
+  void notifyPropertyChange(PropertyNotification notification, DocEvent& ev);
+
   //////////////////////////////////////////////////////////////////////
   // File related properties
 
@@ -169,6 +177,12 @@ public:
   bool inhibitBackup() const;
   void setInhibitBackup(const bool inhibitBackup);
 
+  // Used to delay the backup while the document is being modified
+  // (e.g. in the middle of a stroke), so the backup process doesn't
+  // stall the UI thread.
+  bool deferBackup() const;
+  void setDeferBackup(const bool deferBackup);
+
   void markAsBackedUp();
   bool isFullyBackedUp() const;
 
@@ -257,8 +271,13 @@ protected:
   virtual void onContextChanged();
 
 private:
+  struct DeferredNotifications;
+  friend class DeferDocNotifications;
+
   void removeFromContext();
   void updateOSColorSpace(bool appWideSignal);
+  DeferredNotifications* deferredNotifications();
+  void flushDeferredNotifications();
 
   // The document is in the collection of documents of this context.
   Context* m_ctx;
@@ -296,9 +315,35 @@ private:
   // Last used color space to render a sprite.
   os::ColorSpaceRef m_osColorSpace;
 
+  // Notifications collected while they are deferred.
+  std::unique_ptr<DeferredNotifications> m_deferred;
+
   DISABLE_COPYING(Doc);
 };
 
+// Defers the general updates, sprite pixels modifications, and
+// property changes notified by all documents (from the current
+// thread) while this object is alive. These notifications are
+// collapsed and sent when the last DeferDocNotifications is
+// destroyed, e.g. so scripts can modify thousands of cels redrawing
+// the editor and the timeline only once.
+//
+// Structural changes (add/remove layers/cels/frames, etc.) are
+// always notified immediately.
+class DeferDocNotifications {
+public:
+  DeferDocNotifications();
+  ~DeferDocNotifications();
+
+  static bool isDeferring();
+
+private:
+  static void addPendingDoc(Doc* doc);
+
+  friend class Doc;
+  DISABLE_COPYING(DeferDocNotifications);
+};
+
 } // namespace app
 
 #endif
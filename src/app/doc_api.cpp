@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -22,6 +22,7 @@
 #include "app/cmd/flip_image.h"
 #include "app/cmd/move_cel.h"
 #include "app/cmd/move_layer.h"
+#include "app/cmd/remap_frames.h"
 #include "app/cmd/remove_cel.h"
 #include "app/cmd/remove_frame.h"
 #include "app/cmd/remove_layer.h"
@@ -399,20 +400,32 @@ void DocApi::moveFrame(Sprite* sprite,
   if (frame >= 0 && frame <= sprite->lastFrame() && beforeFrame >= 0 &&
       beforeFrame <= sprite->lastFrame() + 1 &&
       ((frame != beforeFrame) || (!sprite->tags().empty() && tagsHandling != kDontAdjustTags))) {
-    // Change the frame-lengths.
-    int frlen_aux = sprite->frameDuration(frame);
-
-    // Moving the frame to the future.
-    if (frame < beforeFrame) {
-      for (frame_t c = frame; c < beforeFrame - 1; ++c)
-        setFrameDuration(sprite, c, sprite->frameDuration(c + 1));
-      setFrameDuration(sprite, beforeFrame - 1, frlen_aux);
+    const bool batch = (m_movedFramesSprite == sprite);
+
+    // Just update the final order of frames (see endMoveFrames()).
+    if (batch) {
+      const frame_t origFrame = m_movedFrames[frame];
+      m_movedFrames.erase(m_movedFrames.begin() + frame);
+      m_movedFrames.insert(
+        m_movedFrames.begin() + (frame < beforeFrame ? beforeFrame - 1 : beforeFrame),
+        origFrame);
     }
-    // Moving the frame to the past.
-    else if (beforeFrame < frame) {
-      for (frame_t c = frame; c > beforeFrame; --c)
-        setFrameDuration(sprite, c, sprite->frameDuration(c - 1));
-      setFrameDuration(sprite, beforeFrame, frlen_aux);
+    else {
+      // Change the frame-lengths.
+      int frlen_aux = sprite->frameDuration(frame);
+
+      // Moving the frame to the future.
+      if (frame < beforeFrame) {
+        for (frame_t c = frame; c < beforeFrame - 1; ++c)
+          setFrameDuration(sprite, c, sprite->frameDuration(c + 1));
+        setFrameDuration(sprite, beforeFrame - 1, frlen_aux);
+      }
+      // Moving the frame to the past.
+      else if (beforeFrame < frame) {
+        for (frame_t c = frame; c > beforeFrame; --c)
+          setFrameDuration(sprite, c, sprite->frameDuration(c - 1));
+        setFrameDuration(sprite, beforeFrame, frlen_aux);
+      }
     }
 
     if (tagsHandling != kDontAdjustTags) {
@@ -423,11 +436,61 @@ void DocApi::moveFrame(Sprite* sprite,
     }
 
     // Change cel positions.
-    if (frame != beforeFrame)
+    if (frame != beforeFrame && !batch)
       moveFrameLayer(sprite->root(), frame, beforeFrame);
   }
 }
 
+void DocApi::beginMoveFrames(Sprite* sprite)
+{
+  ASSERT(sprite);
+  ASSERT(!m_movedFramesSprite);
+
+  m_movedFramesSprite = sprite;
+  m_movedFrames.resize(sprite->totalFrames());
+  for (frame_t i = 0; i < sprite->totalFrames(); ++i)
+    m_movedFrames[i] = i;
+}
+
+void DocApi::endMoveFrames()
+{
+  ASSERT(m_movedFramesSprite);
+  Sprite* sprite = m_movedFramesSprite;
+  m_movedFramesSprite = nullptr;
+
+  std::vector<frame_t> newFrames(m_movedFrames.size());
+  for (frame_t i = 0; i < frame_t(m_movedFrames.size()); ++i)
+    newFrames[m_movedFrames[i]] = i;
+  m_movedFrames.clear();
+
+  remapFrames(sprite, newFrames);
+}
+
+static bool is_identity(const std::vector<frame_t>& newFrames)
+{
+  for (frame_t i = 0; i < frame_t(newFrames.size()); ++i) {
+    if (newFrames[i] != i)
+      return false;
+  }
+  return true;
+}
+
+void DocApi::remapFrames(Sprite* sprite, const std::vector<frame_t>& newFrames)
+{
+  ASSERT(frame_t(newFrames.size()) == sprite->totalFrames());
+  if (!is_identity(newFrames))
+    m_transaction.execute(new cmd::RemapFrames(sprite, newFrames));
+}
+
+void DocApi::remapCels(Sprite* sprite,
+                       const LayerList& layers,
+                       const std::vector<frame_t>& newFrames)
+{
+  ASSERT(frame_t(newFrames.size()) == sprite->totalFrames());
+  if (!layers.empty() && !is_identity(newFrames))
+    m_transaction.execute(new cmd::RemapFrames(sprite, layers, newFrames));
+}
+
 void DocApi::moveFrameLayer(Layer* layer, frame_t frame, frame_t beforeFrame)
 {
   ASSERT(layer);
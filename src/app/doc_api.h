@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -16,10 +16,12 @@
 #include "doc/color.h"
 #include "doc/frame.h"
 #include "doc/image_ref.h"
+#include "doc/layer_list.h"
 #include "doc/tile.h"
 #include "gfx/rect.h"
 
 #include <map>
+#include <vector>
 
 namespace doc {
 class Cel;
@@ -90,6 +92,19 @@ public:
                  const DropFramePlace dropFramePlace,
                  const TagsHandling tagsHandling);
 
+  // All moveFrame() calls between beginMoveFrames() and
+  // endMoveFrames() move the frame durations and cels with just one
+  // command (and one notification) at the end. Tags are adjusted
+  // from each moveFrame() call as usual.
+  void beginMoveFrames(Sprite* sprite);
+  void endMoveFrames();
+
+  // Moves frames (or only the cels of the given layers) with one
+  // command, the frame "i" is moved to "newFrames[i]" (it must be a
+  // permutation of all the frames of the sprite).
+  void remapFrames(Sprite* sprite, const std::vector<frame_t>& newFrames);
+  void remapCels(Sprite* sprite, const LayerList& layers, const std::vector<frame_t>& newFrames);
+
   // Cels API
   void addCel(LayerImage* layer, Cel* cel);
   Cel* addCel(LayerImage* layer, frame_t frameNumber, const ImageRef& image);
@@ -190,6 +205,11 @@ private:
   // cels from the src layers when we copy a block of cels.
   // map: ObjectId of CelData -> Cel*
   std::map<doc::ObjectId, doc::Cel*> m_linkedCels;
+
+  // Frames moved between beginMoveFrames() and endMoveFrames(),
+  // "m_movedFrames[i]" is the original frame that is now in "i".
+  doc::Sprite* m_movedFramesSprite = nullptr;
+  std::vector<doc::frame_t> m_movedFrames;
 };
 
 } // namespace app
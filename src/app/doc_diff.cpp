@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2018  David Capello
 //
 // This program is distributed under the terms of
@@ -13,16 +13,27 @@
 
 #include "app/doc.h"
 #include "doc/cel.h"
+#include "doc/grid.h"
 #include "doc/image.h"
 #include "doc/layer.h"
 #include "doc/layer_tilemap.h"
 #include "doc/palette.h"
 #include "doc/primitives.h"
+#include "doc/primitives_fast.h"
 #include "doc/sprite.h"
 #include "doc/tag.h"
 #include "doc/tileset.h"
 #include "doc/tilesets.h"
 #include "doc/user_data.h"
+#include "doc/user_data_io.h"
+
+#include <city.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
 
 #ifdef _DEBUG
 namespace doc {
@@ -46,10 +57,9 @@ namespace app {
   #define TRACEDIFF(a, b)
 #endif
 
-DocDiff compare_docs(const Doc* a, const Doc* b)
+// Compares everything but layers and cels.
+static void compare_sprites(const Doc* a, const Doc* b, DocDiff& diff)
 {
-  DocDiff diff;
-
   // Don't compare filenames
   // if (a->filename() != b->filename())...
 
@@ -172,6 +182,19 @@ DocDiff compare_docs(const Doc* a, const Doc* b)
   done:;
   }
 
+  // Compare color spaces
+  if (!a->sprite()->colorSpace()->nearlyEqual(*b->sprite()->colorSpace())) {
+    diff.anything = diff.colorProfiles = true;
+  }
+
+  // Compare grid bounds
+  if (a->sprite()->gridBounds() != b->sprite()->gridBounds()) {
+    diff.anything = diff.gridBounds = true;
+  }
+}
+
+static void compare_layers(const Doc* a, const Doc* b, DocDiff& diff)
+{
   // Compare layers
   if (a->sprite()->allLayersCount() != b->sprite()->allLayersCount()) {
     diff.anything = diff.layers = true;
@@ -231,18 +254,355 @@ DocDiff compare_docs(const Doc* a, const Doc* b)
       }
     }
   }
+}
 
-  // Compare color spaces
-  if (!a->sprite()->colorSpace()->nearlyEqual(*b->sprite()->colorSpace())) {
-    diff.anything = diff.colorProfiles = true;
+DocDiff compare_docs(const Doc* a, const Doc* b)
+{
+  DocDiff diff;
+  compare_sprites(a, b, diff);
+  compare_layers(a, b, diff);
+  return diff;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Tree of hashes used in diff_docs()
+
+namespace {
+
+// Number of rows in each band of an image (the minimum area that is
+// compared pixel by pixel when two images have different hashes).
+constexpr int kHashBandRows = 16;
+
+// Maximum number of images in the cache of hashes (the whole cache
+// is cleared when it's full).
+constexpr std::size_t kMaxCachedImages = 4096;
+
+struct ImageHashes {
+  uint64_t hash = 0;           // Hash of the whole image
+  std::vector<uint64_t> bands; // Hash of each band of kHashBandRows rows
+};
+
+using ImageHashesPtr = std::shared_ptr<const ImageHashes>;
+
+struct CachedImageHashes {
+  ObjectVersion version;
+  ImageHashesPtr hashes;
+};
+
+struct CelHashes {
+  uint64_t hash = 0; // Properties and image of the cel (0 if there is no cel)
+  ImageHashesPtr image;
+};
+
+struct LayerHashes {
+  uint64_t properties = 0;
+  uint64_t hash = 0;            // Properties and all cels of the layer
+  std::vector<CelHashes> cels;  // Indexed by frame
+};
+
+std::mutex g_imageHashesMutex;
+std::unordered_map<ObjectId, CachedImageHashes> g_imageHashes;
+
+uint64_t hash_combine(const uint64_t seed, const uint64_t value)
+{
+  return CityHash64WithSeed((const char*)&value, sizeof(value), seed);
+}
+
+uint64_t hash_string(const uint64_t seed, const std::string& str)
+{
+  return CityHash64WithSeed(str.c_str(), str.size(), seed);
+}
+
+uint64_t hash_user_data(const uint64_t seed, const UserData& userData)
+{
+  std::ostringstream os(std::ios::binary);
+  write_user_data(os, userData);
+  return hash_string(seed, os.str());
+}
+
+template<typename ImageTraits>
+ImageHashesPtr calculate_image_hashes_templ(const Image* image)
+{
+  auto hashes = std::make_shared<ImageHashes>();
+  const int widthBytes = ImageTraits::width_bytes(image->width());
+  const int h = image->height();
+
+  uint64_t hash = hash_combine(hash_combine(image->pixelFormat(), image->width()), h);
+  hashes->bands.reserve((h + kHashBandRows - 1) / kHashBandRows);
+  for (int y = 0; y < h; y += kHashBandRows) {
+    const int y2 = std::min(h, y + kHashBandRows);
+    uint64_t band = 0;
+    for (int v = y; v < y2; ++v)
+      band = CityHash64WithSeed((const char*)image->getPixelAddress(0, v), widthBytes, band);
+    hashes->bands.push_back(band);
+    hash = hash_combine(hash, band);
   }
+  hashes->hash = hash;
+  return hashes;
+}
 
-  // Compare grid bounds
-  if (a->sprite()->gridBounds() != b->sprite()->gridBounds()) {
-    diff.anything = diff.gridBounds = true;
+ImageHashesPtr calculate_image_hashes(const Image* image)
+{
+  switch (image->pixelFormat()) {
+    case IMAGE_RGB:       return calculate_image_hashes_templ<RgbTraits>(image);
+    case IMAGE_GRAYSCALE: return calculate_image_hashes_templ<GrayscaleTraits>(image);
+    case IMAGE_INDEXED:   return calculate_image_hashes_templ<IndexedTraits>(image);
+    case IMAGE_BITMAP:    return calculate_image_hashes_templ<BitmapTraits>(image);
+    case IMAGE_TILEMAP:   return calculate_image_hashes_templ<TilemapTraits>(image);
   }
+  ASSERT(false);
+  return std::make_shared<ImageHashes>();
+}
 
-  return diff;
+// Returns the hashes of the given image from the cache, or
+// calculates them if the image was modified.
+ImageHashesPtr image_hashes(const Image* image)
+{
+  // Objects without version (e.g. images of a document that was just
+  // loaded) can be modified without incrementing their version, so
+  // we cannot cache their hashes.
+  const ObjectVersion version = image->version();
+  if (version) {
+    const std::lock_guard lock(g_imageHashesMutex);
+    auto it = g_imageHashes.find(image->id());
+    if (it != g_imageHashes.end() && it->second.version == version)
+      return it->second.hashes;
+  }
+
+  ImageHashesPtr hashes = calculate_image_hashes(image);
+  if (version) {
+    const std::lock_guard lock(g_imageHashesMutex);
+    if (g_imageHashes.size() >= kMaxCachedImages)
+      g_imageHashes.clear();
+    g_imageHashes[image->id()] = CachedImageHashes{ version, hashes };
+  }
+  return hashes;
+}
+
+uint64_t layer_properties_hash(const Layer* layer)
+{
+  uint64_t hash = hash_combine(int(layer->type()),
+                               int(layer->flags()) & int(LayerFlags::StructuralFlagsMask));
+  hash = hash_string(hash, layer->name());
+  if (layer->isImage()) {
+    const auto* layerImage = static_cast<const LayerImage*>(layer);
+    hash = hash_combine(hash, layerImage->opacity());
+    hash = hash_combine(hash, int(layerImage->blendMode()));
+  }
+  if (layer->isTilemap())
+    hash = hash_combine(hash, static_cast<const LayerTilemap*>(layer)->tilesetIndex());
+  return hash_user_data(hash, layer->userData());
+}
+
+uint64_t cel_properties_hash(const Cel* cel)
+{
+  const gfx::Rect& bounds = cel->bounds();
+  uint64_t hash = hash_combine(bounds.x, bounds.y);
+  hash = hash_combine(hash, bounds.w);
+  hash = hash_combine(hash, bounds.h);
+  hash = hash_combine(hash, cel->opacity());
+  hash = hash_combine(hash, cel->zIndex());
+  return hash_user_data(hash, cel->data()->userData());
+}
+
+LayerHashes layer_hashes(const Layer* layer, const frame_t nframes)
+{
+  LayerHashes hashes;
+  hashes.properties = hashes.hash = layer_properties_hash(layer);
+  if (!layer->isImage())
+    return hashes;
+
+  hashes.cels.resize(nframes);
+  const auto* layerImage = static_cast<const LayerImage*>(layer);
+  for (auto it = layerImage->getCelBegin(), end = layerImage->getCelEnd(); it != end; ++it) {
+    const Cel* cel = *it;
+    CelHashes& celHashes = hashes.cels[cel->frame()];
+    celHashes.hash = cel_properties_hash(cel);
+    if (cel->image()) {
+      celHashes.image = image_hashes(cel->image());
+      celHashes.hash = hash_combine(celHashes.hash, celHashes.image->hash);
+    }
+    hashes.hash = hash_combine(hashes.hash, hash_combine(cel->frame(), celHashes.hash));
+  }
+  return hashes;
+}
+
+// Adds to "bounds" the pixels that are different in the rows [y1, y2).
+template<typename ImageTraits>
+void add_different_pixels_templ(const Image* a,
+                                const Image* b,
+                                const int y1,
+                                const int y2,
+                                gfx::Rect& bounds)
+{
+  const int w = a->width();
+  auto same = [a, b](const int x, const int y) {
+    return ImageTraits::same_color(get_pixel_fast<ImageTraits>(a, x, y),
+                                   get_pixel_fast<ImageTraits>(b, x, y));
+  };
+  for (int y = y1; y < y2; ++y) {
+    int x1 = 0;
+    while (x1 < w && same(x1, y))
+      ++x1;
+    if (x1 == w)
+      continue;
+
+    int x2 = w - 1;
+    while (x2 > x1 && same(x2, y))
+      --x2;
+    bounds |= gfx::Rect(x1, y, x2 - x1 + 1, 1);
+  }
+}
+
+// Returns the bounds of the different pixels of two images of the
+// same size and pixel format, comparing only the bands of rows with
+// different hashes.
+gfx::Rect different_pixels_bounds(const Image* a,
+                                  const ImageHashes& aHashes,
+                                  const Image* b,
+                                  const ImageHashes& bHashes)
+{
+  ASSERT(a->pixelFormat() == b->pixelFormat());
+  ASSERT(a->size() == b->size());
+  ASSERT(aHashes.bands.size() == bHashes.bands.size());
+
+  gfx::Rect bounds;
+  for (std::size_t i = 0; i < aHashes.bands.size(); ++i) {
+    if (aHashes.bands[i] == bHashes.bands[i])
+      continue;
+
+    const int y1 = int(i) * kHashBandRows;
+    const int y2 = std::min(a->height(), y1 + kHashBandRows);
+    switch (a->pixelFormat()) {
+      case IMAGE_RGB:       add_different_pixels_templ<RgbTraits>(a, b, y1, y2, bounds); break;
+      case IMAGE_GRAYSCALE: add_different_pixels_templ<GrayscaleTraits>(a, b, y1, y2, bounds); break;
+      case IMAGE_INDEXED:   add_different_pixels_templ<IndexedTraits>(a, b, y1, y2, bounds); break;
+      case IMAGE_BITMAP:    add_different_pixels_templ<BitmapTraits>(a, b, y1, y2, bounds); break;
+      case IMAGE_TILEMAP:   add_different_pixels_templ<TilemapTraits>(a, b, y1, y2, bounds); break;
+    }
+  }
+  return bounds;
+}
+
+// Returns the canvas area that is different between two cels (in
+// the same layer and frame) with different hashes. Any of the cels
+// can be nullptr.
+gfx::Rect different_cel_bounds(const Cel* aCel,
+                               const CelHashes& aHashes,
+                               const Cel* bCel,
+                               const CelHashes& bHashes,
+                               DocDiff& diff)
+{
+  if (!aCel || !bCel) {
+    diff.anything = diff.cels = true;
+    return (aCel ? aCel : bCel)->bounds();
+  }
+
+  const Image* aImg = aCel->image();
+  const Image* bImg = bCel->image();
+  if (aCel->bounds() != bCel->bounds() || aCel->opacity() != bCel->opacity() ||
+      aCel->zIndex() != bCel->zIndex() ||
+      aCel->data()->userData() != bCel->data()->userData() || !aImg || !bImg ||
+      aImg->pixelFormat() != bImg->pixelFormat() || aImg->size() != bImg->size()) {
+    diff.anything = diff.cels = true;
+    return aCel->bounds() | bCel->bounds();
+  }
+
+  // Only pixels (or tiles) are different
+  gfx::Rect bounds = different_pixels_bounds(aImg, *aHashes.image, bImg, *bHashes.image);
+  if (bounds.isEmpty())
+    return bounds;
+
+  diff.anything = diff.images = true;
+  if (aImg->pixelFormat() == IMAGE_TILEMAP)
+    return aCel->grid().tileToCanvas(bounds);
+
+  bounds.offset(aCel->position());
+  return bounds;
+}
+
+} // anonymous namespace
+
+DocDiffDetails diff_docs(const Doc* a, const Doc* b)
+{
+  DocDiffDetails details;
+  DocDiff& diff = details.diff;
+
+  // Everything but layers and cels can be compared directly (it
+  // doesn't depend on the number of pixels)
+  compare_sprites(a, b, diff);
+
+  const Sprite* aSpr = a->sprite();
+  const Sprite* bSpr = b->sprite();
+  const frame_t aFrames = aSpr->totalFrames();
+  const frame_t bFrames = bSpr->totalFrames();
+  const frame_t nframes = std::max(aFrames, bFrames);
+  for (frame_t f = 0; f < nframes; ++f) {
+    if (f >= aFrames || f >= bFrames || aSpr->frameDuration(f) != bSpr->frameDuration(f))
+      details.frames.push_back(f);
+  }
+
+  const LayerList aLayers = aSpr->allLayers();
+  const LayerList bLayers = bSpr->allLayers();
+  const int nlayers = int(std::max(aLayers.size(), bLayers.size()));
+  for (int i = 0; i < nlayers; ++i) {
+    const Layer* aLay = (i < int(aLayers.size()) ? aLayers[i] : nullptr);
+    const Layer* bLay = (i < int(bLayers.size()) ? bLayers[i] : nullptr);
+
+    // A layer that exists only in one document
+    if (!aLay || !bLay) {
+      const Layer* lay = (aLay ? aLay : bLay);
+      diff.anything = diff.layers = true;
+      details.layers.push_back(i);
+      if (lay->isImage()) {
+        const auto* layerImage = static_cast<const LayerImage*>(lay);
+        for (auto it = layerImage->getCelBegin(), end = layerImage->getCelEnd(); it != end;
+             ++it) {
+          const Cel* cel = *it;
+          details.cels.push_back({ i, cel->frame(), cel->bounds() });
+          details.frames.push_back(cel->frame());
+        }
+      }
+      continue;
+    }
+
+    // Skip the whole layer if its properties and cels are the same
+    const LayerHashes aHashes = layer_hashes(aLay, nframes);
+    const LayerHashes bHashes = layer_hashes(bLay, nframes);
+    if (aHashes.hash == bHashes.hash)
+      continue;
+
+    bool changed = false;
+    if (aHashes.properties != bHashes.properties) {
+      diff.anything = diff.layers = true;
+      changed = true;
+    }
+
+    static const CelHashes kNoCel;
+    for (frame_t f = 0; f < nframes; ++f) {
+      const CelHashes& aCelHashes = (f < int(aHashes.cels.size()) ? aHashes.cels[f] : kNoCel);
+      const CelHashes& bCelHashes = (f < int(bHashes.cels.size()) ? bHashes.cels[f] : kNoCel);
+      if (aCelHashes.hash == bCelHashes.hash)
+        continue;
+
+      const Cel* aCel = (aCelHashes.hash ? aLay->cel(f) : nullptr);
+      const Cel* bCel = (bCelHashes.hash ? bLay->cel(f) : nullptr);
+      const gfx::Rect bounds = different_cel_bounds(aCel, aCelHashes, bCel, bCelHashes, diff);
+      if (!bounds.isEmpty()) {
+        details.cels.push_back({ i, f, bounds });
+        details.frames.push_back(f);
+        changed = true;
+      }
+    }
+
+    if (changed)
+      details.layers.push_back(i);
+  }
+
+  std::sort(details.frames.begin(), details.frames.end());
+  details.frames.erase(std::unique(details.frames.begin(), details.frames.end()),
+                       details.frames.end());
+  return details;
 }
 
 } // namespace app
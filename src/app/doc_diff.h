@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2020  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2018  David Capello
 //
 // This program is distributed under the terms of
@@ -9,6 +9,11 @@
 #define APP_DOC_DIFF_H_INCLUDED
 #pragma once
 
+#include "doc/frame.h"
+#include "gfx/rect.h"
+
+#include <vector>
+
 namespace app {
 class Doc;
 
@@ -47,6 +52,30 @@ struct DocDiff {
 // some kind of operation) are equivalent.
 DocDiff compare_docs(const Doc* a, const Doc* b);
 
+// Detailed differences between two documents.
+struct DocDiffDetails {
+  struct CelDiff {
+    int layer;         // Index of the layer in Sprite::allLayers()
+    doc::frame_t frame;
+    gfx::Rect bounds;  // Canvas area that contains the differences
+  };
+
+  DocDiff diff;
+  std::vector<doc::frame_t> frames; // Frames with different duration or cels
+  std::vector<int> layers;          // Indexes of layers with different properties or cels
+  std::vector<CelDiff> cels;
+};
+
+// Like compare_docs() but returns where the documents are different
+// (frames, layers, cels, and the area of each cel with different
+// pixels). It compares a tree of hashes (tags, layers, cels, and
+// bands of rows of each image), so unchanged layers are skipped
+// without comparing their cels, and only the bands of rows with
+// different hashes are compared pixel by pixel. The hashes of each
+// image are cached by object version, so comparing a document
+// several times only hashes the modified images.
+DocDiffDetails diff_docs(const Doc* a, const Doc* b);
+
 } // namespace app
 
 #endif
@@ -0,0 +1,70 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#include "tests/app_test.h"
+
+#include "app/context.h"
+#include "app/doc.h"
+#include "app/doc_diff.h"
+#include "app/test_context.h"
+#include "doc/cel.h"
+#include "doc/image.h"
+#include "doc/layer.h"
+#include "doc/primitives.h"
+#include "doc/sprite.h"
+
+using namespace app;
+using namespace doc;
+
+typedef std::unique_ptr<Doc> DocPtr;
+
+TEST(DocDiff, DiffDocs)
+{
+  TestContextT<Context> ctx;
+  DocPtr a(ctx.documents().add(64, 64));
+  DocPtr b(ctx.documents().add(64, 64));
+
+  DocDiffDetails details = diff_docs(a.get(), b.get());
+  EXPECT_FALSE(details.diff.anything);
+  EXPECT_TRUE(details.frames.empty());
+  EXPECT_TRUE(details.layers.empty());
+  EXPECT_TRUE(details.cels.empty());
+
+  // Modify some pixels
+  Cel* cel = b->sprite()->firstLayer()->cel(0);
+  put_pixel(cel->image(), 3, 40, rgba(255, 0, 0, 255));
+  put_pixel(cel->image(), 10, 42, rgba(0, 255, 0, 255));
+  cel->image()->incrementVersion();
+
+  details = diff_docs(a.get(), b.get());
+  EXPECT_TRUE(details.diff.anything);
+  EXPECT_TRUE(details.diff.images);
+  EXPECT_FALSE(details.diff.layers);
+  ASSERT_EQ(1u, details.frames.size());
+  EXPECT_EQ(0, details.frames[0]);
+  ASSERT_EQ(1u, details.layers.size());
+  EXPECT_EQ(0, details.layers[0]);
+  ASSERT_EQ(1u, details.cels.size());
+  EXPECT_EQ(0, details.cels[0].layer);
+  EXPECT_EQ(0, details.cels[0].frame);
+  EXPECT_EQ(gfx::Rect(3, 40, 8, 3), details.cels[0].bounds);
+
+  // compare_docs() returns the same result
+  EXPECT_TRUE(compare_docs(a.get(), b.get()).images);
+
+  // Modify a layer and move the cel
+  b->sprite()->firstLayer()->setName("Other");
+  cel->setPosition(2, 0);
+
+  details = diff_docs(a.get(), b.get());
+  EXPECT_TRUE(details.diff.layers);
+  EXPECT_TRUE(details.diff.cels);
+  ASSERT_EQ(1u, details.cels.size());
+  EXPECT_EQ(gfx::Rect(0, 0, 66, 64), details.cels[0].bounds);
+
+  a->close();
+  b->close();
+}
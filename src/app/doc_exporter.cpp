@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -18,18 +18,17 @@
 #include "app/doc.h"
 #include "app/file/file.h"
 #include "app/filename_formatter.h"
+#include "app/max_rects_packer.h"
 #include "app/restore_visible_layers.h"
 #include "app/snap_to_grid.h"
 #include "app/util/autocrop.h"
 #include "base/convert_to.h"
 #include "base/fs.h"
 #include "base/fstream_path.h"
-#include "base/replace_string.h"
 #include "base/string.h"
 #include "doc/algorithm/shrink_bounds.h"
 #include "doc/cel.h"
 #include "doc/image.h"
-#include "doc/images_map.h"
 #include "doc/layer.h"
 #include "doc/palette.h"
 #include "doc/primitives.h"
@@ -38,6 +37,7 @@
 #include "doc/slice.h"
 #include "doc/sprite.h"
 #include "doc/tag.h"
+#include "doc/task_group.h"
 #include "gfx/packing_rects.h"
 #include "gfx/rect_io.h"
 #include "gfx/size.h"
@@ -49,11 +49,15 @@
 
 #include <algorithm>
 #include <cstdio>
+#include <exception>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <set>
+#include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #define DX_TRACE(...) // TRACEARGS
@@ -62,12 +66,28 @@ using namespace doc;
 
 namespace {
 
-std::string escape_for_json(const std::string& path)
+// Writes a string escaped for JSON directly in the output stream,
+// without creating a temporary copy of it (there are thousands of
+// strings in the data file of big sprite sheets).
+struct json_string {
+  const std::string& str;
+  explicit json_string(const std::string& str) : str(str) {}
+};
+
+std::ostream& operator<<(std::ostream& os, const json_string& s)
 {
-  std::string res = path;
-  base::replace_string(res, "\\", "\\\\");
-  base::replace_string(res, "\"", "\\\"");
-  return res;
+  const char* p = s.str.data();
+  const char* end = p + s.str.size();
+  const char* run = p;
+  for (; p != end; ++p) {
+    if (*p == '\\' || *p == '"') {
+      os.write(run, p - run);
+      os.put('\\');
+      run = p;
+    }
+  }
+  os.write(run, end - run);
+  return os;
 }
 
 // Forward declaration
@@ -104,7 +124,7 @@ void serialize_variant(const doc::UserData::Variant& value, std::ostream& os)
     case USER_DATA_PROPERTY_TYPE_FLOAT:  os << get_value<float>(value); break;
     case USER_DATA_PROPERTY_TYPE_DOUBLE: os << get_value<double>(value); break;
     case USER_DATA_PROPERTY_TYPE_STRING:
-      os << "\"" << escape_for_json(get_value<std::string>(value)) << "\"";
+      os << "\"" << json_string(get_value<std::string>(value)) << "\"";
       break;
     case USER_DATA_PROPERTY_TYPE_PROPERTIES:
       serialize_properties(get_value<Properties>(value), os);
@@ -122,7 +142,7 @@ void serialize_properties(const doc::UserData::Properties& props, std::ostream&
     if (!first)
       os << ", ";
     first = false;
-    os << "\"" << escape_for_json(key) << "\": ";
+    os << "\"" << json_string(key) << "\": ";
     serialize_variant(value, os);
   }
   os << "}";
@@ -153,13 +173,13 @@ void serialize_userdata_properties(const doc::UserData& data, std::ostream& os)
             if (!firstKey)
               os << ", ";
             firstKey = false;
-            os << "\"" << escape_for_json(key) << "\": ";
+            os << "\"" << json_string(key) << "\": ";
             serialize_variant(value, os);
           }
         }
         else {
           // Named group: nest under its group name
-          os << "\"" << escape_for_json(group) << "\": ";
+          os << "\"" << json_string(group) << "\": ";
           serialize_properties(props, os);
         }
       }
@@ -178,7 +198,7 @@ std::ostream& operator<<(std::ostream& os, const doc::UserData& data)
        << "\"";
   }
   if (!data.text().empty())
-    os << ", \"data\": \"" << escape_for_json(data.text()) << "\"";
+    os << ", \"data\": \"" << json_string(data.text()) << "\"";
 
   serialize_userdata_properties(data, os);
 
@@ -191,6 +211,185 @@ namespace app {
 
 typedef std::shared_ptr<gfx::Rect> SharedRectPtr;
 
+namespace {
+
+// Number of samples rendered in parallel before updating the
+// progress and checking if the task was canceled.
+const int kSamplesPerBatch = 64;
+
+// Calls func(i) for each i in [0, n) in parallel tasks and waits
+// all of them. The first exception thrown by func() is re-thrown in
+// the calling thread.
+template<typename Func>
+void parallel_for(const int n, base::task_token& token, Func&& func)
+{
+  if (n == 1) {
+    func(0);
+    return;
+  }
+
+  doc::TaskGroup tasks(doc::TaskPriority::Interactive, &token);
+  for (int i = 0; i < n; ++i)
+    tasks.run([i, &func] { func(i); });
+  tasks.wait();
+}
+
+// Renders the given frame of the sprite with its original size in
+// a new image (the selected layers must be already visible).
+ImageRef render_frame(Sprite* sprite,
+                      const frame_t frame,
+                      const gfx::Size& size,
+                      const bool parallelRender)
+{
+  ImageRef image(Image::create(sprite->pixelFormat(), size.w, size.h));
+  image->setMaskColor(sprite->transparentColor());
+  clear_image(image.get(), sprite->transparentColor());
+
+  render::Render render;
+  render.setParallelRender(parallelRender);
+  render.renderSprite(image.get(), sprite, frame, gfx::Clip(0, 0, gfx::Rect(size)));
+  return image;
+}
+
+// Result of trimming one frame of a sample
+struct FrameTrim {
+  bool computed = false;
+  bool empty = false;      // The whole frame is transparent
+  gfx::Rect bounds;        // Trimmed bounds of the frame
+  gfx::Rect renderBounds;  // Bounds of the "render" image
+  ImageRef render;         // Image of the final bounds of the sample
+};
+
+} // anonymous namespace
+
+// Trims and renders of the samples kept between exports (see
+// DocExporter::setKeepRenders()). The documents are loaded again
+// for each export, so the renders are identified by the filename of
+// the document, the indexes of the selected layers, and the frame.
+class DocExporter::RendersCache {
+public:
+  struct Key {
+    std::string filename;
+    std::string layers;
+    frame_t frame;
+
+    bool operator<(const Key& other) const
+    {
+      return std::tie(filename, layers, frame) <
+             std::tie(other.filename, other.layers, other.frame);
+    }
+  };
+
+  static Key key(const Doc* doc, const SelectedLayers* selLayers, const frame_t frame)
+  {
+    Key key{ doc->filename(), std::string(), frame };
+    if (selLayers) {
+      const LayerGroup* root = doc->sprite()->root();
+      std::vector<layer_t> indexes;
+      for (const Layer* layer : *selLayers)
+        indexes.push_back(root->getLayerIndex(layer));
+      std::sort(indexes.begin(), indexes.end());
+      for (const layer_t i : indexes)
+        key.layers += base::convert_to<std::string>(i) + ",";
+    }
+    return key;
+  }
+
+  // The trims are valid only for the same trim options
+  void setTrimOptions(const int options)
+  {
+    if (m_trimOptions != options) {
+      m_trimOptions = options;
+      m_trims.clear();
+    }
+  }
+
+  const FrameTrim* trim(const Key& key,
+                        const gfx::Size& sampleSize,
+                        const gfx::Rect& spriteBounds) const
+  {
+    auto it = m_trims.find(key);
+    if (it != m_trims.end() && it->second.sampleSize == sampleSize &&
+        it->second.spriteBounds == spriteBounds)
+      return &it->second.trim;
+    return nullptr;
+  }
+
+  void setTrim(const Key& key,
+               const gfx::Size& sampleSize,
+               const gfx::Rect& spriteBounds,
+               const FrameTrim& trim)
+  {
+    m_trims[key] = TrimEntry{ sampleSize, spriteBounds, trim };
+  }
+
+  ImageRef render(const Key& key, const gfx::Rect& bounds) const
+  {
+    auto it = m_renders.find(key);
+    if (it != m_renders.end()) {
+      for (const auto& [renderBounds, render] : it->second) {
+        if (renderBounds == bounds)
+          return render;
+      }
+    }
+    return nullptr;
+  }
+
+  void setRender(const Key& key, const gfx::Rect& bounds, const ImageRef& render)
+  {
+    auto& renders = m_renders[key];
+    for (auto& [renderBounds, oldRender] : renders) {
+      if (renderBounds == bounds) {
+        oldRender = render;
+        return;
+      }
+    }
+    renders.push_back(std::make_pair(bounds, render));
+  }
+
+  void invalidate()
+  {
+    m_trims.clear();
+    m_renders.clear();
+  }
+
+  // Invalidates the given frames (sorted) of the given document, or
+  // all its frames if frames == nullptr.
+  void invalidate(const std::string& filename, const std::vector<frame_t>* frames)
+  {
+    auto match = [&](const Key& key) {
+      return (key.filename == filename &&
+              (!frames || std::binary_search(frames->begin(), frames->end(), key.frame)));
+    };
+    erase_if(m_trims, match);
+    erase_if(m_renders, match);
+  }
+
+private:
+  template<typename Map, typename Pred>
+  static void erase_if(Map& map, Pred&& pred)
+  {
+    for (auto it = map.begin(); it != map.end();) {
+      if (pred(it->first))
+        it = map.erase(it);
+      else
+        ++it;
+    }
+  }
+
+  struct TrimEntry {
+    gfx::Size sampleSize;
+    gfx::Rect spriteBounds;
+    FrameTrim trim;
+  };
+
+  int m_trimOptions = -1;
+  std::map<Key, TrimEntry> m_trims;
+  // Renders of each frame with the trimmed bounds of its samples
+  // (several samples when the sprite is split by grid)
+  std::map<Key, std::vector<std::pair<gfx::Rect, ImageRef>>> m_renders;
+};
+
 DocExporter::Item::Item(Doc* doc,
                         const doc::Tag* tag,
                         const doc::SelectedLayers* selLayers,
@@ -279,7 +478,7 @@ public:
   const Tag* tag() const { return m_tag; }
   SelectedLayers* selectedLayers() const { return m_selLayers; }
   frame_t frame() const { return m_frame; }
-  std::string filename() const { return m_filename; }
+  const std::string& filename() const { return m_filename; }
   const gfx::Size& originalSize() const { return m_originalSize; }
   const gfx::Rect& trimmedBounds() const { return m_trimmedBounds; }
   const gfx::Rect& inTextureBounds() const { return *m_inTextureBounds; }
@@ -307,6 +506,11 @@ public:
     // TODO we cannot assign an empty rectangle (samples that are
     // completely trimmed out should be included as a sample of size 1x1)
     ASSERT(!bounds.isEmpty());
+
+    // The cached render is for the previous bounds
+    if (m_render && bounds != m_trimmedBounds)
+      m_render.reset();
+
     m_trimmedBounds = bounds;
   }
 
@@ -331,30 +535,93 @@ public:
   void setLinked() { m_isLinked = true; }
   void setDuplicated() { m_isDuplicated = true; }
 
-  ImageRef createRender(ImageBufferPtr& imageBuf)
+  // Returns the image of this sample (with its trimmed bounds). The
+  // first call renders the sample, then the same image is re-used to
+  // find duplicates and to blit the sample into the texture.
+  //
+  // From a worker thread "fromWorker" must be true, and the caller
+  // is responsible of showing the selected layers of the sprite.
+  const ImageRef& render(const bool fromWorker = false)
   {
-    ASSERT(m_sprite);
+    if (!m_image && !m_render) {
+      ImageRef render(
+        Image::create(m_sprite->pixelFormat(), m_trimmedBounds.w, m_trimmedBounds.h));
+      render->setMaskColor(m_sprite->transparentColor());
+      clear_image(render.get(), m_sprite->transparentColor());
+      if (fromWorker)
+        drawSample(render.get(), 0, 0, false, false);
+      else
+        renderSample(render.get(), 0, 0, false);
+      m_render = render;
+    }
+    return (m_image ? m_image : m_render);
+  }
 
-    // We use the m_image as it is, it doesn't require a special
-    // render.
-    if (m_image)
-      return m_image;
+  bool hasRender() const { return m_image || m_render; }
+  bool hasImage() const { return m_image != nullptr; }
 
-    ImageRef render(
-      Image::create(m_sprite->pixelFormat(), m_trimmedBounds.w, m_trimmedBounds.h, imageBuf));
-    render->setMaskColor(m_sprite->transparentColor());
-    clear_image(render.get(), m_sprite->transparentColor());
-    renderSample(render.get(), 0, 0, false);
-    return render;
+  // Returns true if this sample is rendered exactly as the given one
+  // (same area of the same sprite/layers, and the same cels in both
+  // frames, e.g. held frames with linked cels).
+  bool hasSameRender(const Sample& other) const
+  {
+    return (!m_image && !other.m_image && m_sprite == other.m_sprite &&
+            m_selLayers == other.m_selLayers && m_trimmedBounds == other.m_trimmedBounds &&
+            m_sprite->hasSameCels(m_frame, other.m_frame));
   }
 
+  // The hash is cached in the image itself, so samples of linked
+  // cels (which share the same image) are hashed only once.
+  uint64_t renderHash() { return render()->contentHash(); }
+
+  // Sets the image of the trimmed bounds of the sample (e.g. rendered
+  // in a worker thread to trim the sample), so we don't need to
+  // render this sample again.
+  void setRender(const ImageRef& render)
+  {
+    ASSERT(!m_image);
+    ASSERT(render->size() == m_trimmedBounds.size());
+    m_render = render;
+  }
+
+  // Releases the cached render when it's not needed anymore (e.g.
+  // when it was already copied to the texture).
+  void releaseRender() { m_render.reset(); }
+
   void renderSample(doc::Image* dst, int x, int y, bool extrude) const
   {
     RestoreVisibleLayers layersVisibility;
-    if (m_selLayers)
+    if (m_selLayers && !canBlitRender(dst))
       layersVisibility.showSelectedLayers(m_sprite, *m_selLayers);
 
+    drawSample(dst, x, y, extrude, true);
+  }
+
+  // Same as renderSample() but without changing the visible layers
+  // of the sprite (so it can be called from worker threads).
+  void drawSample(doc::Image* dst, int x, int y, bool extrude, bool parallelRender) const
+  {
+    // Blit the cached render if it's compatible with the destination
+    // (i.e. rendering the sample again would give the same pixels).
+    const Image* srcImage = m_image.get();
+    gfx::Point srcOffset(0, 0);
+    if (canBlitRender(dst)) {
+      srcImage = m_render.get();
+      srcOffset = gfx::Point(-m_trimmedBounds.x, -m_trimmedBounds.y);
+    }
+
     render::Render render;
+    render.setParallelRender(parallelRender);
+
+    auto blit = [&](gfx::Clip clip) {
+      if (srcImage) {
+        clip.src += srcOffset;
+        dst->copy(srcImage, clip);
+      }
+      else {
+        render.renderSprite(dst, m_sprite, m_frame, clip);
+      }
+    };
 
     // 1) We cannot use the Preferences because this is called from a non-UI thread
     // 2) We should use the new blend mode always when we're saving files
@@ -381,24 +648,12 @@ public:
       // side.
       for (int j = 0; j < 3; ++j) {
         for (int i = 0; i < 3; ++i) {
-          gfx::Clip clip(x + dx[i], y + dy[j], gfx::RectT<int>(srcx[i], srcy[j], szx[i], szy[j]));
-          if (m_image) {
-            dst->copy(m_image.get(), clip);
-          }
-          else {
-            render.renderSprite(dst, m_sprite, m_frame, clip);
-          }
+          blit(gfx::Clip(x + dx[i], y + dy[j], gfx::RectT<int>(srcx[i], srcy[j], szx[i], szy[j])));
         }
       }
     }
     else {
-      gfx::Clip clip(x, y, m_trimmedBounds);
-      if (m_image) {
-        dst->copy(m_image.get(), clip);
-      }
-      else {
-        render.renderSprite(dst, m_sprite, m_frame, clip);
-      }
+      blit(gfx::Clip(x, y, m_trimmedBounds));
     }
   }
 
@@ -432,6 +687,12 @@ public:
   }
 
 private:
+  bool canBlitRender(const doc::Image* dst) const
+  {
+    return (!m_image && m_render && m_render->pixelFormat() == dst->pixelFormat() &&
+            m_render->maskColor() == dst->maskColor());
+  }
+
   Doc* m_document;
   Sprite* m_sprite;
   // In case that this Sample references just one image to export
@@ -448,6 +709,8 @@ private:
   gfx::Size m_originalSize;
   gfx::Rect m_trimmedBounds;
   SharedRectPtr m_inTextureBounds;
+  // Cached render of the trimmed bounds of the sample
+  ImageRef m_render;
 };
 
 class DocExporter::Samples {
@@ -461,6 +724,7 @@ public:
 
   void addSample(const Sample& sample) { m_samples.push_back(sample); }
 
+  Sample& operator[](const size_t i) { return m_samples[i]; }
   const Sample& operator[](const size_t i) const { return m_samples[i]; }
 
   iterator begin() { return m_samples.begin(); }
@@ -468,10 +732,69 @@ public:
   const_iterator begin() const { return m_samples.begin(); }
   const_iterator end() const { return m_samples.end(); }
 
+  // Calls func(i) for each sample index in "indexes" from the samples
+  // thread pool. As RestoreVisibleLayers modifies the sprite, the
+  // selected layers are shown from this thread for each batch of
+  // consecutive samples that share the same sprite and layers.
+  // progress(n) is called after each batch with the number of
+  // processed samples.
+  template<typename Func, typename Progress>
+  void parallelForEach(const std::vector<int>& indexes,
+                       base::task_token& token,
+                       Func&& func,
+                       Progress&& progress) const
+  {
+    const int n = int(indexes.size());
+    for (int i = 0; i < n && !token.canceled();) {
+      const Sample& first = m_samples[indexes[i]];
+      int j = i + 1;
+      while (j < n && j - i < kSamplesPerBatch &&
+             m_samples[indexes[j]].sprite() == first.sprite() &&
+             m_samples[indexes[j]].selectedLayers() == first.selectedLayers()) {
+        ++j;
+      }
+
+      {
+        RestoreVisibleLayers layersVisibility;
+        if (first.sprite() && first.selectedLayers())
+          layersVisibility.showSelectedLayers(first.sprite(), *first.selectedLayers());
+
+        parallel_for(j - i, token, [i, &indexes, &func](const int k) { func(indexes[i + k]); });
+      }
+
+      i = j;
+      progress(i);
+    }
+  }
+
 private:
   List m_samples;
 };
 
+// Finds samples with the same rendered image using the content hash
+// of each rendered image.
+class DocExporter::DuplicatedSamples {
+public:
+  // Returns the index of a previous sample with the same image than
+  // the i-th sample, or -1 if there is no one (and the i-th sample is
+  // added to the index).
+  int findOrAdd(Samples& samples, const int i)
+  {
+    Sample& sample = samples[i];
+    const uint64_t hash = sample.renderHash();
+    const auto range = m_map.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+      if (is_same_image(samples[it->second].render().get(), sample.render().get()))
+        return it->second;
+    }
+    m_map.emplace(hash, i);
+    return -1;
+  }
+
+private:
+  std::unordered_multimap<uint64_t, int> m_map;
+};
+
 class DocExporter::LayoutSamples {
 public:
   virtual ~LayoutSamples() {}
@@ -515,7 +838,7 @@ public:
     const Layer* oldLayer = nullptr;
     const Tag* oldTag = nullptr;
 
-    doc::ImagesMap duplicates;
+    DuplicatedSamples duplicates;
     gfx::Point framePt(borderPadding, borderPadding);
     gfx::Size rowSize(0, 0);
 
@@ -541,20 +864,13 @@ public:
       }
 
       if (m_mergeDups || sample.isLinked()) {
-        doc::ImageBufferPtr sampleBuf = std::make_shared<doc::ImageBuffer>();
-        doc::ImageRef sampleRender(sample.createRender(sampleBuf));
-        auto it = duplicates.find(sampleRender);
-        if (it != duplicates.end()) {
-          const uint32_t j = it->second;
-
+        const int j = duplicates.findOrAdd(samples, i);
+        if (j >= 0) {
           sample.setDuplicated();
           sample.setSharedBounds(samples[j].sharedBounds());
           ++i;
           continue;
         }
-        else {
-          duplicates[sampleRender] = i;
-        }
       }
 
       const Sprite* sprite = sample.sprite();
@@ -646,6 +962,8 @@ private:
 
 class DocExporter::BestFitLayoutSamples : public DocExporter::LayoutSamples {
 public:
+  BestFitLayoutSamples(SpriteSheetPackAlgorithm algorithm) : m_algorithm(algorithm) {}
+
   void layoutSamples(Samples& samples,
                      int borderPadding,
                      int shapePadding,
@@ -653,10 +971,34 @@ public:
                      int& height,
                      base::task_token& token) override
   {
-    gfx::PackingRects pr(borderPadding, shapePadding);
-    doc::ImagesMap duplicates;
+    switch (m_algorithm) {
+      case SpriteSheetPackAlgorithm::MaxRects: {
+        MaxRectsPacker pr(borderPadding, shapePadding);
+        layoutSamplesWithPacker(pr, samples, width, height, token);
+        break;
+      }
+      case SpriteSheetPackAlgorithm::BestFit:
+      default: {
+        gfx::PackingRects pr(borderPadding, shapePadding);
+        layoutSamplesWithPacker(pr, samples, width, height, token);
+        break;
+      }
+    }
+  }
 
-    uint32_t i = 0;
+private:
+  // Packer is gfx::PackingRects or app::MaxRectsPacker (both have
+  // the same interface).
+  template<typename Packer>
+  void layoutSamplesWithPacker(Packer& pr,
+                               Samples& samples,
+                               int& width,
+                               int& height,
+                               base::task_token& token)
+  {
+    DuplicatedSamples duplicates;
+
+    int i = 0;
     for (auto& sample : samples) {
       if (token.canceled())
         return;
@@ -668,19 +1010,12 @@ public:
         continue;
       }
 
-      // We have to use one ImageBuffer for each image because we're
-      // going to store all images in the "duplicates" map.
-      doc::ImageBufferPtr sampleBuf = std::make_shared<doc::ImageBuffer>();
-      doc::ImageRef sampleRender(sample.createRender(sampleBuf));
-      auto it = duplicates.find(sampleRender);
-      if (it != duplicates.end()) {
-        const uint32_t j = it->second;
-
+      const int j = duplicates.findOrAdd(samples, i);
+      if (j >= 0) {
         sample.setDuplicated();
         sample.setSharedBounds(samples[j].sharedBounds());
       }
       else {
-        duplicates[sampleRender] = i;
         pr.add(sample.requiredSize());
       }
       ++i;
@@ -706,19 +1041,23 @@ public:
       sample.setInTextureBounds(*(it++));
     }
   }
+
+  SpriteSheetPackAlgorithm m_algorithm;
 };
 
 DocExporter::DocExporter()
   : m_docBuf(std::make_shared<doc::ImageBuffer>())
-  , m_sampleBuf(std::make_shared<doc::ImageBuffer>())
 {
   m_cache.spriteId = doc::NullId;
   reset();
 }
 
+DocExporter::~DocExporter() = default;
+
 void DocExporter::reset()
 {
   m_sheetType = SpriteSheetType::None;
+  m_packAlgorithm = SpriteSheetPackAlgorithm::Default;
   m_dataFormat = SpriteSheetDataFormat::Default;
   m_dataFilename.clear();
   m_textureFilename.clear();
@@ -746,6 +1085,33 @@ void DocExporter::reset()
   m_documents.clear();
 }
 
+void DocExporter::setKeepRenders(const bool keep)
+{
+  if (!keep)
+    m_renders.reset();
+  else if (!m_renders)
+    m_renders = std::make_unique<RendersCache>();
+}
+
+void DocExporter::invalidateRenders()
+{
+  if (m_renders)
+    m_renders->invalidate();
+}
+
+void DocExporter::invalidateRenders(const std::string& filename)
+{
+  if (m_renders)
+    m_renders->invalidate(filename, nullptr);
+}
+
+void DocExporter::invalidateRenders(const std::string& filename,
+                                    const std::vector<doc::frame_t>& frames)
+{
+  if (m_renders)
+    m_renders->invalidate(filename, &frames);
+}
+
 void DocExporter::setDocImageBuffer(const doc::ImageBufferPtr& docBuf)
 {
   m_docBuf = docBuf;
@@ -754,6 +1120,7 @@ void DocExporter::setDocImageBuffer(const doc::ImageBufferPtr& docBuf)
 Doc* DocExporter::exportSheet(Context* ctx, base::task_token& token)
 {
   // We output the metadata to std::cout if the user didn't specify a file.
+  std::vector<char> fosBuffer;
   std::ofstream fos;
   std::streambuf* osbuf = nullptr;
   if (m_dataFilename.empty()) {
@@ -775,6 +1142,10 @@ Doc* DocExporter::exportSheet(Context* ctx, base::task_token& token)
       }
     }
 
+    // Use a big buffer to write the data file, it can be several
+    // megabytes for sheets with a lot of frames/slices.
+    fosBuffer.resize(256 * 1024);
+    fos.rdbuf()->pubsetbuf(fosBuffer.data(), fosBuffer.size());
     fos.open(FSTREAM_PATH(m_dataFilename), std::ios::out);
     osbuf = fos.rdbuf();
   }
@@ -995,6 +1366,37 @@ void DocExporter::captureSamples(Samples& samples, base::task_token& token)
 {
   DX_TRACE("DX: Capture samples");
 
+  if (m_renders) {
+    m_renders->setTrimOptions((m_trimCels ? 1 : 0) | (m_trimSprite ? 2 : 0) |
+                              (m_trimByGrid ? 4 : 0) | (m_ignoreEmptyCels ? 8 : 0));
+  }
+
+  // Tile images (e.g. from addTilesetsSamples()) are copied directly
+  // to the texture without a render step, so here we just check (in
+  // parallel) which ones are empty, and calculate their hashes to find
+  // duplicates in the layout step (the hash is cached in the image).
+  std::vector<uint8_t> emptyImages(m_documents.size(), 0);
+  {
+    std::vector<int> imageItems;
+    for (int i = 0; i < int(m_documents.size()); ++i) {
+      if (m_documents[i].isOneImageOnly())
+        imageItems.push_back(i);
+    }
+    const bool calcHashes = (m_sheetType == SpriteSheetType::Packed || m_mergeDuplicates);
+    if (!imageItems.empty() && (m_ignoreEmptyCels || calcHashes)) {
+      parallel_for(int(imageItems.size()), token, [&](const int k) {
+        const int i = imageItems[k];
+        const Image* image = m_documents[i].image.get();
+        if (m_ignoreEmptyCels)
+          emptyImages[i] = is_empty_image(image);
+        if (calcHashes)
+          image->contentHash();
+      });
+      if (token.canceled())
+        return;
+    }
+  }
+
   for (auto& item : m_documents) {
     if (token.canceled())
       return;
@@ -1053,11 +1455,176 @@ void DocExporter::captureSamples(Samples& samples, base::task_token& token)
       }
     }
 
+    const gfx::Size sampleSize = (item.image     ? item.image->size() :
+                                  item.splitGrid ? sprite->gridBounds().size() :
+                                                   sprite->size());
+
+    // Calculates the trimmed bounds of the given frame rendering it
+    // (the selected layers must be visible). It can be called from
+    // worker threads.
+    auto trimFrame = [&](const frame_t frame, FrameTrim& trim, const bool fromWorker) {
+      // Empty cels of a transparent image layer will be ignored, so we
+      // can use the cached bounds of the cel image instead of a render.
+      if (m_ignoreEmptyCels && layer && layer->isImage() && !layer->isTilemap() &&
+          !layer->isReference() && !layer->isBackground()) {
+        const Cel* cel = layer->cel(frame);
+        gfx::Rect celBounds;
+        if (cel && !cel->image()->opaqueBounds(celBounds)) {
+          trim.empty = true;
+          trim.bounds = gfx::Rect(0, 0, 1, 1);
+          trim.computed = true;
+          return;
+        }
+      }
+
+      ImageRef sampleRender = render_frame(sprite, frame, sampleSize, !fromWorker);
+
+      gfx::Rect frameBounds;
+      doc::color_t refColor = 0;
+
+      if (m_trimCels) {
+        if ((layer && layer->isBackground()) ||
+            (!layer && sprite->backgroundLayer() && sprite->backgroundLayer()->isVisible())) {
+          refColor = get_pixel(sampleRender.get(), 0, 0);
+        }
+        else {
+          refColor = sprite->transparentColor();
+        }
+      }
+      else if (m_ignoreEmptyCels)
+        refColor = sprite->transparentColor();
+
+      if (!algorithm::shrink_bounds(sampleRender.get(),
+                                    refColor,
+                                    nullptr,        // layer
+                                    spriteBounds,   // startBounds
+                                    frameBounds)) { // output bounds
+        // If shrink_bounds() returns false, it's because the whole
+        // image is transparent (equal to the mask color).
+        trim.empty = true;
+
+        // Create an entry with Size(1, 1) for this completely
+        // trimmed frame anyway so we conserve the frame information
+        // (position and duration of the frame in the JSON data, and
+        // the relative position of the frame in frame tags).
+        frameBounds = gfx::Rect(0, 0, 1, 1);
+      }
+
+      // TODO merge this code with the code in DocApi::trimSprite()
+      if (m_trimCels && m_trimByGrid) {
+        const gfx::Rect& gridBounds = sprite->gridBounds();
+        gfx::Point posTopLeft =
+          snap_to_grid(gridBounds, frameBounds.origin(), PreferSnapTo::FloorGrid);
+        gfx::Point posBottomRight =
+          snap_to_grid(gridBounds, frameBounds.point2(), PreferSnapTo::CeilGrid);
+        frameBounds = gfx::Rect(posTopLeft, posBottomRight);
+      }
+      trim.bounds = frameBounds;
+      trim.computed = true;
+
+      // Keep the final area of the render to avoid rendering the
+      // sample again to find duplicates or to fill the texture.
+      if (item.splitGrid || (trim.empty && m_ignoreEmptyCels))
+        return;
+
+      trim.renderBounds = (m_trimCels   ? frameBounds :
+                           m_trimSprite ? spriteBounds :
+                                          gfx::Rect(sampleSize));
+      trim.render.reset(
+        crop_image(sampleRender.get(), trim.renderBounds, sprite->transparentColor()));
+      trim.render->setMaskColor(sprite->transparentColor());
+      // Calculate the hash from this worker thread (it's cached in
+      // the image for DuplicatedSamples)
+      trim.render->contentHash();
+    };
+
+    // Frames that must be rendered to be trimmed or ignored (e.g. empty
+    // cels of the layer and linked cels don't need a render)
+    const bool needsTrim = ((m_ignoreEmptyCels || m_trimCels) && !item.isOneImageOnly());
+    auto frameNeedsTrim = [&](const frame_t frame) {
+      if (!needsTrim)
+        return false;
+      if (layer && layer->isImage()) {
+        const Cel* cel = layer->cel(frame);
+        if (!cel)
+          return !m_ignoreEmptyCels;
+        if (cel->link() && m_mergeDuplicates)
+          return false;
+      }
+      return true;
+    };
+
+    const SelectedFrames selFrames = item.getSelectedFrames();
+    const std::vector<frame_t> frameList(selFrames.begin(), selFrames.end());
+    std::vector<FrameTrim> trims;
+
     frame_t outputFrame = 0;
-    for (frame_t frame : item.getSelectedFrames()) {
+    for (int frameIndex = 0; frameIndex < int(frameList.size()); ++frameIndex) {
       if (token.canceled())
         return;
 
+      const frame_t frame = frameList[frameIndex];
+
+      // Render and trim the next batch of frames in parallel
+      if (needsTrim && (frameIndex % kSamplesPerBatch) == 0) {
+        const int n = std::min<int>(kSamplesPerBatch, frameList.size() - frameIndex);
+        std::vector<int> batch;
+        // Frames with the same cels as the previous one (held frames)
+        // re-use its trim/render
+        std::vector<int> heldFrames;
+        trims.clear();
+        trims.resize(n);
+        int prevK = -1;
+        for (int k = 0; k < n; ++k) {
+          if (!frameNeedsTrim(frameList[frameIndex + k]))
+            continue;
+          if (prevK == k - 1 &&
+              sprite->hasSameCels(frameList[frameIndex + k - 1], frameList[frameIndex + k]))
+            heldFrames.push_back(k);
+          else
+            batch.push_back(k);
+          prevK = k;
+        }
+
+        // Re-use the trims of the previous export
+        auto renderKey = [&](const int k) {
+          return RendersCache::key(doc, item.selLayers.get(), frameList[frameIndex + k]);
+        };
+        if (m_renders) {
+          batch.erase(std::remove_if(batch.begin(),
+                                     batch.end(),
+                                     [&](const int k) {
+                                       const FrameTrim* cached =
+                                         m_renders->trim(renderKey(k), sampleSize, spriteBounds);
+                                       if (!cached)
+                                         return false;
+                                       trims[k] = *cached;
+                                       return true;
+                                     }),
+                      batch.end());
+        }
+
+        if (!batch.empty()) {
+          RestoreVisibleLayers layersVisibility;
+          if (item.selLayers)
+            layersVisibility.showSelectedLayers(sprite, *item.selLayers);
+
+          parallel_for(int(batch.size()), token, [&](const int k) {
+            trimFrame(frameList[frameIndex + batch[k]], trims[batch[k]], true);
+          });
+          if (token.canceled())
+            return;
+
+          if (m_renders) {
+            for (const int k : batch)
+              m_renders->setTrim(renderKey(k), sampleSize, spriteBounds, trims[k]);
+          }
+        }
+
+        for (const int k : heldFrames)
+          trims[k] = trims[k - 1];
+      }
+
       const Tag* innerTag = (tag ? tag : sprite->tags().innerTag(frame));
       const Tag* outerTag = sprite->tags().outerTag(frame);
       FilenameInfo fnInfo;
@@ -1073,9 +1640,7 @@ void DocExporter::captureSamples(Samples& samples, base::task_token& token)
 
       std::string filename = filename_formatter(format, fnInfo);
 
-      Sample sample((item.image     ? item.image->size() :
-                     item.splitGrid ? sprite->gridBounds().size() :
-                                      sprite->size()),
+      Sample sample(sampleSize,
                     doc,
                     sprite,
                     item.image,
@@ -1097,6 +1662,7 @@ void DocExporter::captureSamples(Samples& samples, base::task_token& token)
 
       // Re-use linked samples
       bool alreadyTrimmed = false;
+      FrameTrim* trim = nullptr;
       if (link && m_mergeDuplicates && !item.isOneImageOnly()) {
         for (const Sample& other : samples) {
           if (token.canceled())
@@ -1124,61 +1690,30 @@ void DocExporter::captureSamples(Samples& samples, base::task_token& token)
         if (layer && layer->isImage() && !cel && m_ignoreEmptyCels)
           continue;
 
-        ImageRef sampleRender(sample.createRender(m_sampleBuf));
-
-        gfx::Rect frameBounds;
-        doc::color_t refColor = 0;
-
-        if (m_trimCels) {
-          if ((layer && layer->isBackground()) ||
-              (!layer && sprite->backgroundLayer() && sprite->backgroundLayer()->isVisible())) {
-            refColor = get_pixel(sampleRender.get(), 0, 0);
-          }
-          else {
-            refColor = sprite->transparentColor();
-          }
+        trim = &trims[frameIndex % kSamplesPerBatch];
+        if (!trim->computed) {
+          // Linked cel that wasn't trimmed in the batch (e.g. the first
+          // linked cel is outside the exported tag range)
+          RestoreVisibleLayers layersVisibility;
+          if (item.selLayers)
+            layersVisibility.showSelectedLayers(sprite, *item.selLayers);
+          trimFrame(frame, *trim, false);
         }
-        else if (m_ignoreEmptyCels)
-          refColor = sprite->transparentColor();
-
-        if (!algorithm::shrink_bounds(sampleRender.get(),
-                                      refColor,
-                                      nullptr,        // layer
-                                      spriteBounds,   // startBounds
-                                      frameBounds)) { // output bounds
-          // If shrink_bounds() returns false, it's because the whole
-          // image is transparent (equal to the mask color).
-
-          // Should we ignore this empty frame? (i.e. don't include
-          // the frame in the sprite sheet)
-          if (m_ignoreEmptyCels)
-            continue;
 
-          // Create an entry with Size(1, 1) for this completely
-          // trimmed frame anyway so we conserve the frame information
-          // (position and duration of the frame in the JSON data, and
-          // the relative position of the frame in frame tags).
-          sample.setTrimmedBounds(frameBounds = gfx::Rect(0, 0, 1, 1));
-        }
+        // Should we ignore this empty frame? (i.e. don't include the
+        // frame in the sprite sheet)
+        if (trim->empty && m_ignoreEmptyCels)
+          continue;
 
         if (m_trimCels) {
-          // TODO merge this code with the code in DocApi::trimSprite()
-          if (m_trimByGrid) {
-            const gfx::Rect& gridBounds = doc->sprite()->gridBounds();
-            gfx::Point posTopLeft =
-              snap_to_grid(gridBounds, frameBounds.origin(), PreferSnapTo::FloorGrid);
-            gfx::Point posBottomRight =
-              snap_to_grid(gridBounds, frameBounds.point2(), PreferSnapTo::CeilGrid);
-            frameBounds = gfx::Rect(posTopLeft, posBottomRight);
-          }
-          sample.setTrimmedBounds(frameBounds);
+          sample.setTrimmedBounds(trim->bounds);
           alreadyTrimmed = true;
         }
       }
       // If "Ignore Empty" is checked and the item is a tile...
       else if (m_ignoreEmptyCels && item.isOneImageOnly()) {
         // Skip empty tile
-        if (is_empty_image(item.image.get()))
+        if (emptyImages[&item - m_documents.data()])
           continue;
       }
 
@@ -1200,6 +1735,8 @@ void DocExporter::captureSamples(Samples& samples, base::task_token& token)
         }
       }
       else {
+        if (trim && trim->render && trim->renderBounds == sample.trimmedBounds())
+          sample.setRender(trim->render);
         samples.addSample(sample);
       }
 
@@ -1213,6 +1750,80 @@ void DocExporter::captureSamples(Samples& samples, base::task_token& token)
                sample.inTextureBounds());
     }
   }
+
+  renderSamples(samples, token);
+}
+
+// Renders (in parallel) the samples that the layout will compare to
+// find duplicates and weren't already rendered to be trimmed.
+void DocExporter::renderSamples(Samples& samples, base::task_token& token)
+{
+  // All samples are rendered to keep their renders for the next
+  // export
+  const bool renderAll =
+    (m_sheetType == SpriteSheetType::Packed || m_mergeDuplicates || m_renders);
+  std::vector<int> indexes;
+
+  // Re-use the renders of the previous export
+  if (m_renders) {
+    for (Sample& sample : samples) {
+      if (sample.isEmpty() || sample.hasRender())
+        continue;
+
+      ImageRef render = m_renders->render(
+        RendersCache::key(sample.document(), sample.selectedLayers(), sample.frame()),
+        sample.trimmedBounds());
+      if (render)
+        sample.setRender(render);
+    }
+  }
+
+  // Samples that are rendered as the previous sample (e.g. held
+  // frames with linked cels) share its render: pairs of sample ->
+  // sample with the render.
+  std::vector<std::pair<int, int>> sharedRenders;
+  int prev = -1;
+
+  for (int i = 0; i < samples.size(); ++i) {
+    const Sample& sample = samples[i];
+    if (sample.isEmpty())
+      continue;
+
+    if (prev >= 0 && !sample.hasRender() && sample.hasSameRender(samples[prev])) {
+      sharedRenders.push_back(std::make_pair(i, prev));
+      if (!samples[prev].hasRender() && (indexes.empty() || indexes.back() != prev))
+        indexes.push_back(prev);
+      continue;
+    }
+
+    prev = i;
+    if (!sample.hasRender() && (renderAll || sample.isLinked()))
+      indexes.push_back(i);
+  }
+
+  if (!indexes.empty()) {
+    samples.parallelForEach(
+      indexes,
+      token,
+      [&samples](const int i) { samples[i].render(true); },
+      [&token, &indexes](const int n) { token.set_progress(0.2f * n / indexes.size()); });
+    if (token.canceled())
+      return;
+  }
+
+  for (const auto& [i, src] : sharedRenders)
+    samples[i].setRender(samples[src].render(true));
+
+  if (m_renders) {
+    for (Sample& sample : samples) {
+      if (!sample.isEmpty() && sample.hasRender() && !sample.hasImage()) {
+        m_renders->setRender(
+          RendersCache::key(sample.document(), sample.selectedLayers(), sample.frame()),
+          sample.trimmedBounds(),
+          sample.render());
+      }
+    }
+  }
 }
 
 void DocExporter::layoutSamples(Samples& samples, base::task_token& token)
@@ -1222,7 +1833,7 @@ void DocExporter::layoutSamples(Samples& samples, base::task_token& token)
 
   switch (m_sheetType) {
     case SpriteSheetType::Packed: {
-      BestFitLayoutSamples layout;
+      BestFitLayoutSamples layout(m_packAlgorithm);
       layout.layoutSamples(samples, m_borderPadding, m_shapePadding, width, height, token);
       break;
     }
@@ -1363,28 +1974,40 @@ Doc* DocExporter::createEmptyTexture(const Samples& samples, base::task_token& t
 }
 
 void DocExporter::renderTexture(Context* ctx,
-                                const Samples& samples,
+                                Samples& samples,
                                 Image* textureImage,
                                 base::task_token& token) const
 {
   textureImage->clear(textureImage->maskColor());
 
-  int i = 0;
-  for (const auto& sample : samples) {
-    if (token.canceled())
-      return;
-    token.set_progress(0.6f + 0.2f * i / int(samples.size()));
+  // The cached renders of the samples are released as soon as they
+  // are not needed, so we don't keep the images of all samples and
+  // the whole texture in memory at the same time (e.g. for sheets of
+  // hundreds of files).
+  std::vector<int> indexes;
+  for (int i = 0; i < samples.size(); ++i) {
+    Sample& sample = samples[i];
+    if (!sample.isLinked() && !sample.isDuplicated() && !sample.isEmpty())
+      indexes.push_back(i);
+    else
+      sample.releaseRender();
+  }
 
-    if (sample.isLinked() || sample.isDuplicated() || sample.isEmpty()) {
-      ++i;
-      continue;
-    }
-    sample.renderSample(textureImage,
+  // Each sample is drawn in its own area of the texture, so they can
+  // be drawn in any order/in parallel and the result is the same.
+  samples.parallelForEach(
+    indexes,
+    token,
+    [this, &samples, textureImage](const int i) {
+      Sample& sample = samples[i];
+      sample.drawSample(textureImage,
                         sample.inTextureBounds().x + m_innerPadding,
                         sample.inTextureBounds().y + m_innerPadding,
-                        m_extrude);
-    ++i;
-  }
+                        m_extrude,
+                        false);
+      sample.releaseRender();
+    },
+    [&token, &indexes](const int n) { token.set_progress(0.6f + 0.2f * n / indexes.size()); });
 }
 
 void DocExporter::trimTexture(const Samples& samples, doc::Sprite* texture) const
@@ -1416,6 +2039,15 @@ void DocExporter::trimTexture(const Samples& samples, doc::Sprite* texture) cons
 
   texture->setSize(m_textureWidth > 0 ? m_textureWidth : size.w,
                    m_textureHeight > 0 ? m_textureHeight : size.h);
+
+  // Crop the texture image too, so it can be encoded directly
+  // without rendering a copy of it when it's saved.
+  Cel* cel = texture->root()->firstLayer()->cel(frame_t(0));
+  if (cel->image()->size() != texture->size()) {
+    ImageRef croppedImage(
+      crop_image(cel->image(), gfx::Rect(texture->size()), cel->image()->maskColor()));
+    cel->data()->setImage(croppedImage, cel->layer());
+  }
 }
 
 void DocExporter::createDataFile(const Samples& samples, std::ostream& os, doc::Sprite* texture)
@@ -1459,10 +2091,10 @@ void DocExporter::createDataFile(const Samples& samples, std::ostream& os, doc::
     gfx::Rect frameBounds = sample.inTextureBounds();
 
     if (filename_as_key)
-      os << "   \"" << escape_for_json(sample.filename()) << "\": {\n";
+      os << "   \"" << json_string(sample.filename()) << "\": {\n";
     else if (filename_as_attr)
       os << "   {\n"
-         << "    \"filename\": \"" << escape_for_json(sample.filename()) << "\",\n";
+         << "    \"filename\": \"" << json_string(sample.filename()) << "\",\n";
 
     os << "    \"frame\": { "
        << "\"x\": " << frameBounds.x + nonExtrudedPosition << ", "
@@ -1496,8 +2128,7 @@ void DocExporter::createDataFile(const Samples& samples, std::ostream& os, doc::
      << "  \"version\": \"" << get_app_version() << "\",\n";
 
   if (!m_textureFilename.empty())
-    os << "  \"image\": \"" << escape_for_json(base::get_file_name(m_textureFilename)).c_str()
-       << "\",\n";
+    os << "  \"image\": \"" << json_string(base::get_file_name(m_textureFilename)) << "\",\n";
 
   os << "  \"format\": \"" << (texture->pixelFormat() == IMAGE_RGB ? "RGBA8888" : "I8") << "\",\n"
      << "  \"size\": { "
@@ -1542,12 +2173,12 @@ void DocExporter::createDataFile(const Samples& samples, std::ostream& os, doc::
         FilenameInfo fnInfo;
         fnInfo.filename(doc->filename()).innerTagName(tag->name());
         std::string tagname = filename_formatter(format, fnInfo);
-        os << "\n   { \"name\": \"" << escape_for_json(tagname) << "\","
+        os << "\n   { \"name\": \"" << json_string(tagname) << "\","
            << " \"from\": " << (tag->fromFrame()) << ","
            << " \"to\": " << (tag->toFrame())
            << ","
               " \"direction\": \""
-           << escape_for_json(convert_anidir_to_string(tag->aniDir())) << "\"";
+           << json_string(convert_anidir_to_string(tag->aniDir())) << "\"";
         if (tag->repeat() > 0) {
           os << ", \"repeat\": \"" << tag->repeat() << "\"";
         }
@@ -1604,10 +2235,10 @@ void DocExporter::createDataFile(const Samples& samples, std::ostream& os, doc::
         firstLayer = false;
       else
         os << ",";
-      os << "\n   { \"name\": \"" << escape_for_json(layer->name()) << "\"";
+      os << "\n   { \"name\": \"" << json_string(layer->name()) << "\"";
 
       if (layer->parent() != layer->sprite()->root())
-        os << ", \"group\": \"" << escape_for_json(layer->parent()->name()) << "\"";
+        os << ", \"group\": \"" << json_string(layer->parent()->name()) << "\"";
 
       if (LayerImage* layerImg = dynamic_cast<LayerImage*>(layer)) {
         os << ", \"opacity\": " << layerImg->opacity() << ", \"blendMode\": \""
@@ -1688,7 +2319,7 @@ void DocExporter::createDataFile(const Samples& samples, std::ostream& os, doc::
           firstSlice = false;
         else
           os << ",";
-        os << "\n   { \"name\": \"" << escape_for_json(slice->name()) << "\"" << slice->userData();
+        os << "\n   { \"name\": \"" << json_string(slice->name()) << "\"" << slice->userData();
 
         // Keys
         if (!slice->empty()) {
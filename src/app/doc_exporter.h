@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2022  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "app/sprite_sheet_data_format.h"
+#include "app/sprite_sheet_pack_algorithm.h"
 #include "app/sprite_sheet_type.h"
 #include "base/disable_copying.h"
 #include "base/task.h"
@@ -43,6 +44,7 @@ class Doc;
 class DocExporter {
 public:
   DocExporter();
+  ~DocExporter();
 
   void reset();
   void setDocImageBuffer(const doc::ImageBufferPtr& docBuf);
@@ -51,6 +53,7 @@ public:
   const std::string& dataFilename() { return m_dataFilename; }
   const std::string& textureFilename() { return m_textureFilename; }
   SpriteSheetType spriteSheetType() { return m_sheetType; }
+  SpriteSheetPackAlgorithm packAlgorithm() const { return m_packAlgorithm; }
   const std::string& filenameFormat() const { return m_filenameFormat; }
   const std::string& tagnameFormat() const { return m_tagnameFormat; }
 
@@ -62,6 +65,7 @@ public:
   void setTextureColumns(int columns) { m_textureColumns = columns; }
   void setTextureRows(int rows) { m_textureRows = rows; }
   void setSpriteSheetType(SpriteSheetType type) { m_sheetType = type; }
+  void setPackAlgorithm(SpriteSheetPackAlgorithm algorithm) { m_packAlgorithm = algorithm; }
   void setIgnoreEmptyCels(bool ignore) { m_ignoreEmptyCels = ignore; }
   void setMergeDuplicates(bool merge) { m_mergeDuplicates = merge; }
   void setBorderPadding(int padding) { m_borderPadding = padding; }
@@ -95,12 +99,27 @@ public:
   Doc* exportSheet(Context* ctx, base::task_token& token);
   gfx::Size calculateSheetSize();
 
+  // Keeps the renders of the samples between calls to exportSheet()
+  // (e.g. in the --watch mode of the CLI, where the same documents
+  // are exported again and again), so only the frames invalidated
+  // with invalidateRenders() are rendered in the next export. The
+  // kept renders are not cleared with reset().
+  void setKeepRenders(const bool keep);
+
+  // Discards the kept renders of all documents, of all frames of the
+  // document with the given filename, or of specific frames of it.
+  void invalidateRenders();
+  void invalidateRenders(const std::string& filename);
+  void invalidateRenders(const std::string& filename, const std::vector<doc::frame_t>& frames);
+
 private:
   class Sample;
   class Samples;
+  class DuplicatedSamples;
   class LayoutSamples;
   class SimpleLayoutSamples;
   class BestFitLayoutSamples;
+  class RendersCache;
 
   void addDocument(Doc* doc,
                    const doc::Tag* tag,
@@ -108,11 +127,12 @@ private:
                    const doc::SelectedFrames* selFrames,
                    const bool splitGrid);
   void captureSamples(Samples& samples, base::task_token& token);
+  void renderSamples(Samples& samples, base::task_token& token);
   void layoutSamples(Samples& samples, base::task_token& token);
   gfx::Size calculateSheetSize(const Samples& samples, base::task_token& token) const;
   Doc* createEmptyTexture(const Samples& samples, base::task_token& token) const;
   void renderTexture(Context* ctx,
-                     const Samples& samples,
+                     Samples& samples,
                      doc::Image* textureImage,
                      base::task_token& token) const;
   void trimTexture(const Samples& samples, doc::Sprite* texture) const;
@@ -148,6 +168,7 @@ private:
   typedef std::vector<Item> Items;
 
   SpriteSheetType m_sheetType;
+  SpriteSheetPackAlgorithm m_packAlgorithm;
   SpriteSheetDataFormat m_dataFormat;
   std::string m_dataFilename;
   std::string m_textureFilename;
@@ -176,7 +197,6 @@ private:
 
   // Buffers used
   doc::ImageBufferPtr m_docBuf;
-  doc::ImageBufferPtr m_sampleBuf;
 
   // Trimmed bounds of a specific sprite (to avoid recalculating
   // this)
@@ -187,6 +207,9 @@ private:
     bool trimmedByGrid;
   } m_cache;
 
+  // Renders kept between exports (setKeepRenders())
+  std::unique_ptr<RendersCache> m_renders;
+
   DISABLE_COPYING(DocExporter);
 };
 
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -24,6 +24,7 @@
 #include "doc/sprite.h"
 
 #include <stdexcept>
+#include <vector>
 
 #ifdef TRACE_RANGE_OPS
   #include <iostream>
@@ -104,6 +105,10 @@ static DocRange move_or_copy_frames(DocApi& api,
   frame_t firstCopiedBlock = 0;
   frame_t dstBeforeFrame = (place == kDocRangeBefore ? dstFrame : dstFrame + 1);
 
+  // Move all cels and frame durations with just one command
+  if (op == Move)
+    api.beginMoveFrames(sprite);
+
   for (; srcFrame != srcFrameEnd; ++srcFrame) {
     frame_t fromFrame = (*srcFrame) + srcDelta;
 
@@ -178,6 +183,9 @@ static DocRange move_or_copy_frames(DocApi& api,
 #endif
   }
 
+  if (op == Move)
+    api.endMoveFrames();
+
   DocRange result;
   if (!srcRange.selectedLayers().empty())
     result.selectLayers(srcRange.selectedLayers());
@@ -491,28 +499,20 @@ void reverse_frames(Doc* doc, const DocRange& range)
       break;
   }
 
-  if (moveFrames) {
-    for (frame_t frameRev = frameEnd + 1; frameRev > frameBegin; --frameRev) {
-      api.moveFrame(sprite, frameBegin, frameRev, kDropBeforeFrame, kDontAdjustTags);
-    }
-  }
-  else if (swapCels) {
-    for (Layer* layer : layers) {
-      if (!layer->isImage())
-        continue;
-
-      for (frame_t frame = frameBegin, frameRev = frameEnd;
-           frame != (frameBegin + frameEnd) / 2 + 1;
-           ++frame, --frameRev) {
-        if (frame == frameRev)
-          continue;
-
-        LayerImage* imageLayer = static_cast<LayerImage*>(layer);
-        api.swapCel(imageLayer, frame, frameRev);
-      }
-    }
+  // Reverse the frames/cels with just one permutation
+  std::vector<frame_t> newFrames(sprite->totalFrames());
+  for (frame_t frame = 0; frame < sprite->totalFrames(); ++frame) {
+    if (frame >= frameBegin && frame <= frameEnd)
+      newFrames[frame] = frameBegin + frameEnd - frame;
+    else
+      newFrames[frame] = frame;
   }
 
+  if (moveFrames)
+    api.remapFrames(sprite, newFrames);
+  else if (swapCels)
+    api.remapCels(sprite, layers, newFrames);
+
   tx.setNewDocRange(range);
   tx.commit();
 }
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2023  Igara Studio S.A.
+// Copyright (C) 2023-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -1035,7 +1035,21 @@ TEST_F(DocRangeOps, ReverseFrames)
 
 TEST_F(DocRangeOps, ReverseCels)
 {
-  // TODO
+  reverse_frames(doc.get(), cels_range(0, 1, 1, 3));
+  EXPECT_CEL(0, 1, 0, 3);
+  EXPECT_CEL(0, 2, 0, 2);
+  EXPECT_CEL(0, 3, 0, 1);
+  EXPECT_CEL(1, 1, 1, 3);
+  EXPECT_CEL(1, 3, 1, 1);
+  EXPECT_CEL(2, 1, 2, 1);
+  EXPECT_CEL(2, 3, 2, 3);
+  EXPECT_FRAME_ORDER6(0, 1, 2, 3, 4, 5);
+
+  doc->undoHistory()->undo();
+  EXPECT_CEL(0, 1, 0, 1);
+  EXPECT_CEL(0, 3, 0, 3);
+  EXPECT_CEL(1, 1, 1, 1);
+  EXPECT_CEL(1, 3, 1, 3);
 }
 
 TEST(DocRangeOps2, DropInsideBugs)
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2022-2023  Igara Studio S.A.
+// Copyright (C) 2022-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -18,11 +18,14 @@
 #include "app/context.h"
 #include "app/doc_undo_observer.h"
 #include "app/pref/preferences.h"
+#include "app/util/undo_buffer.h"
 #include "base/mem_utils.h"
 #include "base/scoped_value.h"
+#include "tracing/metrics.h"
 #include "undo/undo_history.h"
 #include "undo/undo_state.h"
 
+#include <algorithm>
 #include <cassert>
 #include <stdexcept>
 
@@ -31,6 +34,10 @@
 
 namespace app {
 
+static tracing::Histogram g_stateBytes("undo.state_bytes");
+static tracing::Histogram g_undoTime("undo.undo_us");
+static tracing::Histogram g_redoTime("undo.redo_us");
+
 DocUndo::DocUndo() : m_undoHistory(this)
 {
 }
@@ -61,6 +68,8 @@ void DocUndo::add(CmdTransaction* cmd)
 
   m_undoHistory.add(cmd);
   m_totalUndoSize += cmd->memSize();
+  g_stateBytes.add(int64_t(cmd->memSize()));
+  packUndoBuffers();
 
   notify_observers(&DocUndoObserver::onAddUndoState, this);
   notify_observers(&DocUndoObserver::onTotalUndoSizeChange, this);
@@ -70,7 +79,20 @@ void DocUndo::add(CmdTransaction* cmd)
 
     // If undo limit is 0, it means "no limit", so we ignore the
     // complete logic to discard undo states.
-    if (undoLimitSize > 0 && m_totalUndoSize > undoLimitSize) {
+    bool overLimit = (undoLimitSize > 0 && m_totalUndoSize > undoLimitSize);
+    if (overLimit) {
+      // Undo buffers could be compressed or moved to disk since they
+      // were added, so we recalculate the real size.
+      recalculateTotalUndoSize();
+      overLimit = (m_totalUndoSize > undoLimitSize);
+    }
+    // Move the data of the oldest states to disk before discarding
+    // them (the data is restored if they are undone)
+    if (overLimit && App::instance()->preferences().undo.spillToDisk()) {
+      UNDO_TRACE("UNDO: Moving old undo states to disk\n");
+      overLimit = (spillOldestStates(undoLimitSize) > undoLimitSize);
+    }
+    if (overLimit) {
       UNDO_TRACE("UNDO: Reducing undo history from %s to %s\n",
                  base::get_pretty_memory_size(m_totalUndoSize).c_str(),
                  base::get_pretty_memory_size(undoLimitSize).c_str());
@@ -101,6 +123,7 @@ void DocUndo::undo()
   base::ScopedValue undoing(m_undoing, true);
   const size_t oldSize = m_totalUndoSize;
   {
+    const tracing::Histogram::Timer timer(g_undoTime);
     const undo::UndoState* state = nextUndo();
     ASSERT(state);
     const Cmd* cmd = STATE_CMD(state);
@@ -108,6 +131,7 @@ void DocUndo::undo()
     m_undoHistory.undo();
     m_totalUndoSize += cmd->memSize();
   }
+  packUndoBuffers();
   // This notification could execute a script that modifies the sprite
   // again (e.g. a script that is listening the "change" event, check
   // the SpriteEvents class). If the sprite is modified, the "cmd" is
@@ -123,6 +147,7 @@ void DocUndo::redo()
   base::ScopedValue undoing(m_undoing, true);
   const size_t oldSize = m_totalUndoSize;
   {
+    const tracing::Histogram::Timer timer(g_redoTime);
     const undo::UndoState* state = nextRedo();
     ASSERT(state);
     const Cmd* cmd = STATE_CMD(state);
@@ -130,6 +155,7 @@ void DocUndo::redo()
     m_undoHistory.redo();
     m_totalUndoSize += cmd->memSize();
   }
+  packUndoBuffers();
   notify_observers(&DocUndoObserver::onCurrentUndoStateChange, this);
   if (m_totalUndoSize != oldSize)
     notify_observers(&DocUndoObserver::onTotalUndoSizeChange, this);
@@ -242,7 +268,7 @@ SpritePosition DocUndo::nextRedoSpritePosition() const
     return SpritePosition();
 }
 
-std::istream* DocUndo::nextUndoDocRange() const
+const view::RangeSnapshot* DocUndo::nextUndoDocRange() const
 {
   const undo::UndoState* state = nextUndo();
   if (state)
@@ -251,7 +277,7 @@ std::istream* DocUndo::nextUndoDocRange() const
     return nullptr;
 }
 
-std::istream* DocUndo::nextRedoDocRange() const
+const view::RangeSnapshot* DocUndo::nextRedoDocRange() const
 {
   const undo::UndoState* state = nextRedo();
   if (state)
@@ -281,16 +307,49 @@ void DocUndo::moveToState(const undo::UndoState* state)
   // sprite on its "change" event.
   notify_observers(&DocUndoObserver::onCurrentUndoStateChange, this);
 
+  packUndoBuffers();
+
   // Recalculate the total undo size
   size_t oldSize = m_totalUndoSize;
+  recalculateTotalUndoSize();
+  if (m_totalUndoSize != oldSize)
+    notify_observers(&DocUndoObserver::onTotalUndoSizeChange, this);
+}
+
+void DocUndo::recalculateTotalUndoSize()
+{
   m_totalUndoSize = 0;
   const undo::UndoState* s = m_undoHistory.firstState();
   while (s) {
     m_totalUndoSize += STATE_CMD(s)->memSize();
     s = s->next();
   }
-  if (m_totalUndoSize != oldSize)
-    notify_observers(&DocUndoObserver::onTotalUndoSizeChange, this);
+}
+
+// Moves the data of the oldest states (which are not the next state
+// to undo) to disk in a background thread, until the history size in
+// memory is below the given limit. Returns the estimated size of the
+// history in memory when all the data is moved.
+size_t DocUndo::spillOldestStates(const size_t limit)
+{
+  size_t size = m_totalUndoSize;
+  const undo::UndoState* current = m_undoHistory.currentState();
+  for (const undo::UndoState* s = m_undoHistory.firstState(); s && s != current && size > limit;
+       s = s->next()) {
+    size -= std::min(size, STATE_CMD(s)->spillToDisk());
+  }
+  return size;
+}
+
+void DocUndo::packUndoBuffers()
+{
+  UndoBuffer::Options options;
+  if (App::instance()) {
+    auto& pref = App::instance()->preferences();
+    options.compress = pref.undo.compressHistory();
+    options.maxMemory = std::size_t(std::max(0, pref.undo.memoryBeforeDisk())) * 1024 * 1024;
+  }
+  UndoBuffer::packPendingBuffers(options);
 }
 
 const undo::UndoState* DocUndo::nextUndo() const
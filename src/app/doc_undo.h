@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2022-2023  Igara Studio S.A.
+// Copyright (C) 2022-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -16,7 +16,6 @@
 #include "obs/observable.h"
 #include "undo/undo_history.h"
 
-#include <iosfwd>
 #include <string>
 
 namespace app {
@@ -87,8 +86,8 @@ public:
 
   SpritePosition nextUndoSpritePosition() const;
   SpritePosition nextRedoSpritePosition() const;
-  std::istream* nextUndoDocRange() const;
-  std::istream* nextRedoDocRange() const;
+  const view::RangeSnapshot* nextUndoDocRange() const;
+  const view::RangeSnapshot* nextRedoDocRange() const;
 
   Cmd* lastExecutedCmd() const;
 
@@ -102,6 +101,13 @@ public:
 
 private:
   const undo::UndoState* nextUndo() const;
+  void recalculateTotalUndoSize();
+  size_t spillOldestStates(size_t limit);
+
+  // Compresses (in a background thread) the undo information of the
+  // commands that were executed/undone/redone.
+  void packUndoBuffers();
+
   const undo::UndoState* nextRedo() const;
 
   // undo::UndoHistoryDelegate impl
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2022-2024  Igara Studio S.A.
+// Copyright (C) 2022-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -10,11 +10,33 @@
 
 #include "app/app.h"
 #include "app/cli/app_options.h"
+#include "app/commands/commands.h"
+#include "app/context.h"
 #include "app/doc.h"
+#include "app/file/file.h"
+#include "app/pref/preferences.h"
+#include "app/tools/active_tool.h"
+#include "app/tools/ink_type.h"
+#include "app/tools/pointer.h"
+#include "app/tools/tool_box.h"
+#include "app/tools/tool_loop.h"
+#include "app/tools/tool_loop_manager.h"
+#include "app/ui/color_bar.h"
+#include "app/ui/context_bar.h"
 #include "app/ui/editor/editor.h"
+#include "app/ui/editor/tool_loop_impl.h"
+#include "app/ui/input_recorder.h"
 #include "app/ui/main_window.h"
 #include "app/ui_context.h"
+#include "base/chrono.h"
+#include "base/pi.h"
+#include "doc/cel.h"
+#include "doc/image.h"
+#include "doc/layer.h"
+#include "doc/mask.h"
+#include "doc/primitives.h"
 #include "doc/sprite.h"
+#include "fmt/format.h"
 #include "os/system.h"
 #include "ui/manager.h"
 #include "ui/system.h"
@@ -22,9 +44,195 @@
 
 #include <benchmark/benchmark.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
 using namespace app;
 using namespace doc;
 
+namespace {
+
+// Number of mouse positions of each stroke/lasso in the benchmarks.
+constexpr int kStrokePoints = 32;
+
+// Tools used in BM_FreehandStroke (the index is the benchmark arg).
+const char* kStrokeTools[] = { "pencil", "eraser", "spray", "blur" };
+
+// Creates a document with the given number of layers/frames, each
+// cel with a different pattern of opaque and transparent areas (so
+// inks, flood fill, and the render have real work to do).
+std::unique_ptr<Doc> create_doc(const int w, const int h, const int nlayers, const int nframes)
+{
+  auto spr = new Sprite(ImageSpec(ColorMode::RGB, w, h), 256);
+  spr->setTotalFrames(nframes);
+
+  for (int l = 0; l < nlayers; ++l) {
+    auto layer = new LayerImage(spr);
+    layer->setName(fmt::format("Layer {}", l + 1));
+    spr->root()->addLayer(layer);
+
+    for (frame_t f = 0; f < nframes; ++f) {
+      ImageRef image(Image::create(IMAGE_RGB, w, h));
+      clear_image(image.get(), 0);
+      for (int y = 0; y < h; y += 16) {
+        for (int x = 0; x < w; x += 16) {
+          if ((x / 16 + y / 16 + l + f) % 3 == 0) {
+            fill_rect(image.get(),
+                      x,
+                      y,
+                      x + 11,
+                      y + 11,
+                      rgba(40 * l, 255 - 8 * f, (x + y) & 255, 128 + 127 * (l & 1)));
+          }
+        }
+      }
+      layer->addCel(new Cel(f, image));
+    }
+  }
+
+  auto doc = std::make_unique<Doc>(spr);
+  doc->setContext(UIContext::instance());
+  return doc;
+}
+
+// Generates/dispatches all UI messages, i.e. repaints the editor as
+// it would be done in each frame of the UI loop.
+void update_ui()
+{
+  auto mgr = ui::Manager::getDefault();
+  mgr->generateMessages();
+  mgr->dispatchMessages();
+}
+
+void undo()
+{
+  Command* cmd = Commands::instance()->byId(CommandId::Undo());
+  UIContext::instance()->executeCommand(cmd);
+}
+
+// Selects the given tool with some specific preferences for a
+// benchmark, restoring the original preferences/tool at the end
+// (they are saved when the app is closed).
+class ScopedTool {
+public:
+  explicit ScopedTool(const char* toolId)
+    : m_oldTool(App::instance()->activeTool())
+    , m_tool(App::instance()->toolBox()->getToolById(toolId))
+    , m_pref(Preferences::instance().tool(m_tool))
+    , m_ink(m_pref.ink())
+    , m_brushType(m_pref.brush.type())
+    , m_brushSize(m_pref.brush.size())
+    , m_contiguous(m_pref.contiguous())
+    , m_fgColor(Preferences::instance().colorBar.fgColor())
+  {
+    App::instance()->activeToolManager()->setSelectedTool(m_tool);
+  }
+
+  ~ScopedTool()
+  {
+    m_pref.ink(m_ink);
+    m_pref.brush.type(m_brushType);
+    m_pref.brush.size(m_brushSize);
+    m_pref.contiguous(m_contiguous);
+    ColorBar::instance()->setFgColor(m_fgColor);
+    App::instance()->activeToolManager()->setSelectedTool(m_oldTool);
+    updateBrush();
+  }
+
+  ToolPreferences& pref() { return m_pref; }
+
+  // Must be called after changing the brush preferences.
+  void updateBrush()
+  {
+    App::instance()->contextBar()->setActiveBrush(ContextBar::createBrushFromPreferences());
+  }
+
+private:
+  tools::Tool* m_oldTool;
+  tools::Tool* m_tool;
+  ToolPreferences& m_pref;
+  tools::InkType m_ink;
+  gen::BrushType m_brushType;
+  int m_brushSize;
+  bool m_contiguous;
+  app::Color m_fgColor;
+};
+
+// Uses the active tool in the active editor as if the user were
+// dragging the mouse through the given points, repainting the UI
+// after each mouse movement.
+void use_active_tool(Editor* editor, const std::vector<gfx::Point>& points)
+{
+  std::unique_ptr<tools::ToolLoop> loop(
+    create_tool_loop(editor, UIContext::instance(), tools::Pointer::Left, false, false));
+  if (!loop)
+    return;
+
+  tools::ToolLoopManager manager(loop.get());
+  tools::Pointer pointer;
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    pointer = tools::Pointer(points[i],
+                             tools::Vec2(0.0f, 0.0f),
+                             tools::Pointer::Left,
+                             tools::Pointer::Type::Mouse,
+                             0.0f);
+    if (i == 0) {
+      manager.prepareLoop(pointer);
+      manager.pressButton(pointer);
+    }
+    else {
+      manager.movement(pointer);
+    }
+    update_ui();
+  }
+  manager.releaseButton(pointer);
+  manager.end();
+  loop.reset();
+  update_ui();
+}
+
+// Zig-zag stroke through the whole sprite.
+std::vector<gfx::Point> stroke_points(const int w, const int h)
+{
+  std::vector<gfx::Point> points;
+  for (int i = 0; i < kStrokePoints; ++i) {
+    points.push_back(gfx::Point(w / 8 + i * (w * 3 / 4) / (kStrokePoints - 1),
+                                (i & 1) ? h / 4 : h * 3 / 4));
+  }
+  return points;
+}
+
+// Polygon around the center of the sprite.
+std::vector<gfx::Point> lasso_points(const int w, const int h)
+{
+  std::vector<gfx::Point> points;
+  for (int i = 0; i < kStrokePoints; ++i) {
+    const double a = 2.0 * PI * i / kStrokePoints;
+    const double r = ((i & 1) ? 0.4 : 0.25);
+    points.push_back(
+      gfx::Point(int(w / 2 + w * r * std::cos(a)), int(h / 2 + h * r * std::sin(a))));
+  }
+  return points;
+}
+
+Editor* prepare_editor(Doc* doc)
+{
+  Editor* editor = UIContext::instance()->activeEditor();
+  editor->setLayer(doc->sprite()->root()->lastLayer());
+  editor->setFrame(0);
+  editor->setZoom(render::Zoom(1, 1));
+  editor->setScrollToCenter();
+  ui::Manager::getDefault()->dontWaitEvents();
+  update_ui();
+  return editor;
+}
+
+} // anonymous namespace
+
 void BM_ScrollEditor(benchmark::State& state)
 {
   const int w = state.range(0);
@@ -99,6 +307,204 @@ void BM_ZoomEditor(benchmark::State& state)
   }
 }
 
+void BM_FreehandStroke(benchmark::State& state)
+{
+  const int w = state.range(0);
+  const int h = state.range(1);
+  const int nlayers = state.range(2);
+  const char* toolId = kStrokeTools[state.range(3)];
+  const auto inkType = tools::InkType(state.range(4));
+  const int brushType = state.range(5);
+  const int brushSize = state.range(6);
+
+  std::unique_ptr<Doc> doc = create_doc(w, h, nlayers, 1);
+  Editor* editor = prepare_editor(doc.get());
+
+  ScopedTool tool(toolId);
+  tool.pref().ink(inkType);
+  tool.pref().brush.type(gen::BrushType(brushType));
+  tool.pref().brush.size(brushSize);
+  tool.updateBrush();
+  ColorBar::instance()->setFgColor(app::Color::fromRgb(255, 64, 32, 160));
+
+  const std::vector<gfx::Point> points = stroke_points(w, h);
+  for (auto _ : state) {
+    use_active_tool(editor, points);
+
+    state.PauseTiming();
+    undo();
+    state.ResumeTiming();
+  }
+}
+
+void BM_FloodFill(benchmark::State& state)
+{
+  const int w = state.range(0);
+  const int h = state.range(1);
+  const int nlayers = state.range(2);
+  const bool contiguous = (state.range(3) != 0);
+
+  std::unique_ptr<Doc> doc = create_doc(w, h, nlayers, 1);
+  Editor* editor = prepare_editor(doc.get());
+
+  ScopedTool tool("paint_bucket");
+  tool.pref().ink(tools::InkType::SIMPLE);
+  tool.pref().contiguous(contiguous);
+  ColorBar::instance()->setFgColor(app::Color::fromRgb(255, 64, 32));
+
+  // Transparent pixel connected with the whole background
+  const std::vector<gfx::Point> points = { gfx::Point(13, 13) };
+  for (auto _ : state) {
+    use_active_tool(editor, points);
+
+    state.PauseTiming();
+    undo();
+    state.ResumeTiming();
+  }
+}
+
+void BM_LassoSelection(benchmark::State& state)
+{
+  const int w = state.range(0);
+  const int h = state.range(1);
+  const int nlayers = state.range(2);
+
+  std::unique_ptr<Doc> doc = create_doc(w, h, nlayers, 1);
+  Editor* editor = prepare_editor(doc.get());
+
+  ScopedTool tool(tools::WellKnownTools::Lasso);
+
+  const std::vector<gfx::Point> points = lasso_points(w, h);
+  for (auto _ : state) {
+    use_active_tool(editor, points);
+
+    state.PauseTiming();
+    undo();
+    state.ResumeTiming();
+  }
+}
+
+void BM_MovePixels(benchmark::State& state)
+{
+  const int w = state.range(0);
+  const int h = state.range(1);
+  const int nlayers = state.range(2);
+
+  std::unique_ptr<Doc> doc = create_doc(w, h, nlayers, 1);
+  Editor* editor = prepare_editor(doc.get());
+
+  Mask mask;
+  mask.replace(gfx::Rect(w / 4, h / 4, w / 2, h / 2));
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    doc->setMask(&mask);
+    doc->generateMaskBoundaries();
+    update_ui();
+    state.ResumeTiming();
+
+    // Move the selected pixels as with the arrow keys
+    for (int i = 0; i < 8; ++i) {
+      editor->startSelectionTransformation(gfx::Point(i < 4 ? 1 : 0, i < 4 ? 0 : 1), 0.0);
+      update_ui();
+    }
+    editor->dropMovingPixels();
+    update_ui();
+
+    state.PauseTiming();
+    undo();
+    state.ResumeTiming();
+  }
+
+  doc->setMaskVisible(false);
+}
+
+void BM_PlayAnimation(benchmark::State& state)
+{
+  const int w = state.range(0);
+  const int h = state.range(1);
+  const int nlayers = state.range(2);
+  const int nframes = state.range(3);
+
+  std::unique_ptr<Doc> doc = create_doc(w, h, nlayers, nframes);
+  // Long frames so the playback timer doesn't change frames (each
+  // frame is shown explicitly below).
+  doc->sprite()->setDurationForAllFrames(60000);
+  Editor* editor = prepare_editor(doc.get());
+
+  editor->play(false, false, false);
+  for (auto _ : state) {
+    for (frame_t f = 0; f < nframes; ++f) {
+      editor->setFrame(f);
+      update_ui();
+    }
+  }
+  editor->stop();
+}
+
+// Replays a session recorded with --record-input at maximum speed,
+// reporting the time to process/paint each input event (i.e. each
+// frame of the UI loop). Sessions that open modal dialogs cannot be
+// replayed (the dialog would wait for more input).
+void BM_ReplayInput(benchmark::State& state, const std::string& filename)
+{
+  InputRecording recording;
+  try {
+    recording.load(filename);
+  }
+  catch (const std::exception& ex) {
+    state.SkipWithError(ex.what());
+    return;
+  }
+
+  auto ctx = UIContext::instance();
+  auto mgr = ui::Manager::getDefault();
+  mgr->dontWaitEvents();
+  if (!recording.windowSize.isEmpty())
+    App::instance()->mainWindow()->expandWindow(recording.windowSize);
+
+  std::vector<double> frameTimes;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::unique_ptr<Doc> doc;
+    if (!recording.docFilename.empty()) {
+      doc.reset(load_document(ctx, recording.docFilename));
+      if (!doc) {
+        state.SkipWithError("Cannot load the recorded sprite");
+        break;
+      }
+    }
+    update_ui();
+    state.ResumeTiming();
+
+    for (const InputEvent& ev : recording.events) {
+      base::Chrono chrono;
+      queue_input_event(ev);
+      update_ui();
+      frameTimes.push_back(chrono.elapsed());
+    }
+
+    // Close the modified document (without asking to save it)
+    state.PauseTiming();
+    doc.reset();
+    update_ui();
+    state.ResumeTiming();
+  }
+
+  if (frameTimes.empty())
+    return;
+
+  std::sort(frameTimes.begin(), frameTimes.end());
+  double total = 0.0;
+  for (const double t : frameTimes)
+    total += t;
+  state.counters["frames"] = double(recording.events.size());
+  state.counters["frame_avg_ms"] = 1000.0 * total / frameTimes.size();
+  state.counters["frame_p95_ms"] = 1000.0 * frameTimes[frameTimes.size() * 95 / 100];
+  state.counters["frame_max_ms"] = 1000.0 * frameTimes.back();
+}
+
 BENCHMARK(BM_ScrollEditor)
   // Normal zoom
   ->Args({ 32, 32, 1, 1 })
@@ -132,6 +538,57 @@ BENCHMARK(BM_ZoomEditor)
   ->Args({ 4096, 4096 })
   ->Unit(benchmark::kMicrosecond);
 
+BENCHMARK(BM_FreehandStroke)
+  ->ArgNames({ "w", "h", "layers", "tool", "ink", "brush", "size" })
+  // Pencil with different inks
+  ->Args({ 256, 256, 1, 0, int(tools::InkType::SIMPLE), 0, 1 })
+  ->Args({ 256, 256, 1, 0, int(tools::InkType::ALPHA_COMPOSITING), 0, 1 })
+  ->Args({ 1024, 1024, 8, 0, int(tools::InkType::SIMPLE), 0, 1 })
+  ->Args({ 1024, 1024, 8, 0, int(tools::InkType::ALPHA_COMPOSITING), 0, 1 })
+  ->Args({ 1024, 1024, 8, 0, int(tools::InkType::COPY_COLOR), 0, 1 })
+  ->Args({ 1024, 1024, 8, 0, int(tools::InkType::LOCK_ALPHA), 0, 1 })
+  // Different brushes
+  ->Args({ 1024, 1024, 8, 0, int(tools::InkType::ALPHA_COMPOSITING), 0, 16 })
+  ->Args({ 1024, 1024, 8, 0, int(tools::InkType::ALPHA_COMPOSITING), 0, 64 })
+  ->Args({ 1024, 1024, 8, 0, int(tools::InkType::ALPHA_COMPOSITING), 1, 64 })
+  ->Args({ 1024, 1024, 8, 0, int(tools::InkType::ALPHA_COMPOSITING), 2, 64 })
+  // Eraser, spray, and blur
+  ->Args({ 1024, 1024, 8, 1, int(tools::InkType::SIMPLE), 0, 16 })
+  ->Args({ 1024, 1024, 8, 2, int(tools::InkType::ALPHA_COMPOSITING), 0, 1 })
+  ->Args({ 1024, 1024, 8, 3, int(tools::InkType::SIMPLE), 0, 16 })
+  ->Args({ 4096, 4096, 1, 0, int(tools::InkType::ALPHA_COMPOSITING), 0, 64 })
+  ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_FloodFill)
+  ->ArgNames({ "w", "h", "layers", "contiguous" })
+  ->Args({ 256, 256, 1, 1 })
+  ->Args({ 1024, 1024, 8, 1 })
+  ->Args({ 1024, 1024, 8, 0 })
+  ->Args({ 4096, 4096, 1, 1 })
+  ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_LassoSelection)
+  ->ArgNames({ "w", "h", "layers" })
+  ->Args({ 256, 256, 1 })
+  ->Args({ 1024, 1024, 8 })
+  ->Args({ 4096, 4096, 1 })
+  ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_MovePixels)
+  ->ArgNames({ "w", "h", "layers" })
+  ->Args({ 256, 256, 1 })
+  ->Args({ 1024, 1024, 8 })
+  ->Args({ 4096, 4096, 1 })
+  ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_PlayAnimation)
+  ->ArgNames({ "w", "h", "layers", "frames" })
+  ->Args({ 256, 256, 1, 16 })
+  ->Args({ 256, 256, 16, 16 })
+  ->Args({ 1024, 1024, 8, 16 })
+  ->Args({ 4096, 4096, 1, 4 })
+  ->Unit(benchmark::kMicrosecond);
+
 int app_main(int argc, char* argv[])
 {
   os::SystemRef system = os::System::make();
@@ -140,6 +597,24 @@ int app_main(int argc, char* argv[])
   app.initialize(AppOptions(1, argv2));
   app.mainWindow()->expandWindow(gfx::Size(400, 300));
 
+  // Sessions recorded with --record-input to be replayed as
+  // benchmarks (--replay=<filename> arguments)
+  std::vector<char*> args;
+  for (int i = 0; i < argc; ++i) {
+    constexpr const char* kReplayArg = "--replay=";
+    if (i > 0 && std::strncmp(argv[i], kReplayArg, std::strlen(kReplayArg)) == 0) {
+      const std::string filename = argv[i] + std::strlen(kReplayArg);
+      benchmark::RegisterBenchmark(("BM_ReplayInput/" + filename).c_str(),
+                                   BM_ReplayInput,
+                                   filename)
+        ->Unit(benchmark::kMillisecond);
+    }
+    else
+      args.push_back(argv[i]);
+  }
+  argc = int(args.size());
+  argv = args.data();
+
   benchmark::Initialize(&argc, argv);
   benchmark::RunSpecifiedBenchmarks();
   benchmark::Shutdown();
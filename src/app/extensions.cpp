@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2025  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2017-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -20,11 +20,13 @@
 #include "app/load_matrix.h"
 #include "app/pref/preferences.h"
 #include "app/resource_finder.h"
+#include "app/task_scheduler.h"
 #include "base/exception.h"
 #include "base/file_content.h"
 #include "base/file_handle.h"
 #include "base/fs.h"
 #include "base/fstream_path.h"
+#include "fmt/format.h"
 #include "render/dithering_matrix.h"
 #include "ui/widget.h"
 
@@ -42,6 +44,7 @@
 #include "archive_entry.h"
 #include "json11.hpp"
 
+#include <algorithm>
 #include <cctype>
 #include <fstream>
 #include <queue>
@@ -199,6 +202,22 @@ void read_json_file(const std::string& path, json11::Json& json)
     throw base::Exception("Error parsing JSON file: %s\n", err.c_str());
 }
 
+// Like read_json_file() but it can be called from a background
+// thread (errors are returned in "error" instead of logged/thrown).
+void read_package_json(const std::string& path, json11::Json& json, std::string& error)
+{
+  if (!base::is_file(path)) {
+    error = fmt::format("File '{}' not found", path);
+    return;
+  }
+  try {
+    read_json_file(path, json);
+  }
+  catch (const std::exception& ex) {
+    error = fmt::format("Error loading JSON file: {}", ex.what());
+  }
+}
+
 void write_json_file(const std::string& path, const json11::Json& json)
 {
   std::string text;
@@ -759,7 +778,8 @@ void Extension::exitScripts()
         ASSERT(cmd);
         if (cmd) {
           // TODO use a signal
-          AppMenus::instance()->removeMenuItemFromGroup(cmd);
+          if (auto* appMenus = AppMenus::instance())
+            appMenus->removeMenuItemFromGroup(cmd);
 
           cmds->remove(cmd);
 
@@ -775,7 +795,8 @@ void Extension::exitScripts()
         ASSERT(item.widget->parent());
         if (item.widget && item.widget->parent()) {
           // TODO use a signal
-          AppMenus::instance()->removeMenuItemFromGroup(item.widget);
+          if (auto* appMenus = AppMenus::instance())
+            appMenus->removeMenuItemFromGroup(item.widget);
           ASSERT(!item.widget->parent());
           item.widget = nullptr;
         }
@@ -783,7 +804,8 @@ void Extension::exitScripts()
 
       case PluginItem::MenuGroup:
         // TODO use a signal
-        AppMenus::instance()->removeMenuGroup(item.id);
+        if (auto* appMenus = AppMenus::instance())
+          appMenus->removeMenuGroup(item.id);
         break;
     }
   }
@@ -816,6 +838,16 @@ Extensions::Extensions()
     LOG("EXT: User extensions path '%s'\n", m_userExtensionsPath.c_str());
   }
 
+  // Package to load in the extensions directories
+  struct Package {
+    std::string dir;
+    std::string fullFn;
+    bool isBuiltinExtension;
+    json11::Json json;
+    std::string error;
+  };
+  std::vector<Package> packages;
+
   ResourceFinder rf;
   rf.includeUserDir("extensions");
   rf.includeDataDir("extensions");
@@ -836,18 +868,34 @@ Extensions::Extensions()
       fullFn = base::normalize_path(fullFn);
 
       LOG("EXT: Loading extension '%s'...\n", fullFn.c_str());
-      if (!base::is_file(fullFn)) {
-        LOG("EXT: File '%s' not found\n", fullFn.c_str());
-        continue;
-      }
+      packages.push_back(Package{ dir, fullFn, isBuiltinExtension });
+    }
+  }
 
-      try {
-        loadExtension(dir, fullFn, isBuiltinExtension);
-      }
-      catch (const std::exception& ex) {
-        LOG("EXT: Error loading JSON file: %s\n", ex.what());
-      }
+  // Read and parse all package.json files in parallel (the slow part
+  // with several extensions installed, mostly reading files), each
+  // task only touches its own Package.
+  const int nthreads = std::min<int>(packages.size(), TaskScheduler::instance()->threads());
+  if (nthreads > 1) {
+    SerialTaskGroup tasks(TaskKind::Blocking, nthreads);
+    for (auto& package : packages)
+      tasks.run([&package] { read_package_json(package.fullFn, package.json, package.error); });
+    tasks.wait();
+  }
+  else {
+    for (auto& package : packages)
+      read_package_json(package.fullFn, package.json, package.error);
+  }
+
+  // Create the extensions in the same order they were found (so
+  // extensions in the user folder still have priority over the
+  // built-in ones).
+  for (const auto& package : packages) {
+    if (!package.error.empty()) {
+      LOG("EXT: %s\n", package.error.c_str());
+      continue;
     }
+    createExtension(package.dir, package.json, package.isBuiltinExtension);
   }
 }
 
@@ -1112,6 +1160,13 @@ Extension* Extensions::loadExtension(const std::string& path,
 {
   json11::Json json;
   read_json_file(fullPackageFilename, json);
+  return createExtension(path, json, isBuiltinExtension);
+}
+
+Extension* Extensions::createExtension(const std::string& path,
+                                       const json11::Json& json,
+                                       const bool isBuiltinExtension)
+{
   const auto& name = json["name"].string_value();
   const auto& version = json["version"].string_value();
   const auto& displayName = json["displayName"].string_value();
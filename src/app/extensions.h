@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2024  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2017-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -17,6 +17,10 @@
 #include <string>
 #include <vector>
 
+namespace json11 {
+class Json;
+}
+
 namespace ui {
 class Widget;
 }
@@ -230,6 +234,9 @@ private:
   Extension* loadExtension(const std::string& path,
                            const std::string& fullPackageFilename,
                            const bool isBuiltinExtension);
+  Extension* createExtension(const std::string& path,
+                             const json11::Json& json,
+                             const bool isBuiltinExtension);
   void generateExtensionSignals(Extension* extension);
 
   List m_extensions;
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -25,16 +25,24 @@
 #include "dio/aseprite_decoder.h"
 #include "dio/decode_delegate.h"
 #include "dio/file_interface.h"
+#include "dio/mapped_file.h"
 #include "doc/doc.h"
+#include "doc/task_group.h"
 #include "fixmath/fixmath.h"
 #include "fmt/format.h"
+#include "render/render.h"
+#include "tracing/tracing.h"
 #include "ui/alert.h"
 #include "ver/info.h"
 #include "zlib.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <deque>
+#include <map>
+#include <set>
 #include <variant>
+#include <vector>
 
 #define ASEFILE_TRACE(...) // TRACE(__VA_ARGS__)
 
@@ -62,6 +70,57 @@ public:
 
   bool decodeOneFrame() override { return m_fop->isOneFrame(); }
 
+  doc::frame_t decodeLastFrame() override
+  {
+    // Frames of a tag are known only when the tags chunk is read
+    if (!m_fop->roi().tagName().empty())
+      return -1;
+
+    // Frames of the ROI can be in any order (e.g. reversed ranges)
+    doc::frame_t lastFrame = -1;
+    for (doc::frame_t frame : m_fop->roi().framesSequence())
+      lastFrame = std::max(lastFrame, frame);
+    return lastFrame;
+  }
+
+  gfx::Rect decodeBounds() override { return m_fop->roi().bounds(); }
+
+  bool decodeCelsInLayer(const doc::Layer* layer) override
+  {
+    const FileOpROI& roi = m_fop->roi();
+    if (roi.layersToLoad().empty())
+      return true;
+
+    // If there is no layer with the given names, all layers are
+    // loaded (as the CLI exports all layers in that case)
+    if (m_anyLayerToLoad < 0) {
+      m_anyLayerToLoad = 0;
+      for (const doc::Layer* other : layer->sprite()->allLayers()) {
+        if (roi.isLayerToLoad(other)) {
+          m_anyLayerToLoad = 1;
+          break;
+        }
+      }
+    }
+    return (m_anyLayerToLoad == 0 || roi.isLayerToLoad(layer));
+  }
+
+  bool decodeCelsInFrame(const doc::Sprite* sprite, const doc::frame_t frame) override
+  {
+    const FileOpROI& roi = m_fop->roi();
+    if (roi.tagName().empty() && roi.framesSequence().empty())
+      return true;
+
+    if (m_framesToLoad.empty()) {
+      m_framesToLoad.resize(sprite->totalFrames(), false);
+      for (doc::frame_t f : roi.framesToLoad(sprite)) {
+        if (f >= 0 && f < doc::frame_t(m_framesToLoad.size()))
+          m_framesToLoad[f] = true;
+      }
+    }
+    return (frame >= 0 && frame < doc::frame_t(m_framesToLoad.size()) && m_framesToLoad[frame]);
+  }
+
   doc::color_t defaultSliceColor() override
   {
     auto color = m_fop->config().defaultSliceColor;
@@ -70,13 +129,51 @@ public:
 
   void onSprite(doc::Sprite* sprite) override { m_sprite = sprite; }
 
+  bool decodePreview() override { return m_fop->isPreview(); }
+
+  // Creates a sprite with just one layer/cel with the preview image
+  void onPreview(const doc::ImageRef& image) override
+  {
+    auto sprite = new doc::Sprite(image->spec(), 256);
+    auto layer = new doc::LayerImage(sprite);
+    sprite->root()->addLayer(layer);
+    layer->addCel(new doc::Cel(0, image));
+    m_sprite = sprite;
+  }
+
   doc::Sprite* sprite() { return m_sprite; }
 
   bool cacheCompressedTilesets() const override { return m_fop->config().cacheCompressedTilesets; }
 
+  dio::MappedFileRef lazyImagesFile() override
+  {
+    if (!m_fop->config().lazyLoadImages || m_fop->isOneFrame() || m_fop->isMemory())
+      return nullptr;
+    if (m_mappedFile)
+      return m_mappedFile;
+    try {
+      return std::make_shared<dio::MappedFile>(m_fop->filename());
+    }
+    catch (const std::exception&) {
+      // Just decode all images as usual
+      return nullptr;
+    }
+  }
+
+  std::size_t lazyImagesCacheSize() const override { return m_fop->config().lazyImagesCacheSize; }
+
+  // The file is already mapped to decode it, so it can be re-used for
+  // lazy images.
+  void setMappedFile(const dio::MappedFileRef& file) { m_mappedFile = file; }
+
 private:
   FileOp* m_fop;
   doc::Sprite* m_sprite;
+  dio::MappedFileRef m_mappedFile;
+
+  // Frames of the ROI to load (calculated when they are needed)
+  std::vector<bool> m_framesToLoad;
+  int m_anyLayerToLoad = -1;
 };
 
 class ScanlinesGen {
@@ -126,6 +223,8 @@ public:
   }
 };
 
+class ParallelCelsCompressor;
+
 } // anonymous namespace
 
 static void ase_file_prepare_header(FILE* f,
@@ -154,7 +253,8 @@ static layer_t ase_file_write_cels(FILE* f,
                                    const Sprite* sprite,
                                    const Layer* layer,
                                    layer_t layer_index,
-                                   const frame_t frame);
+                                   const frame_t frame,
+                                   const ParallelCelsCompressor* compressor);
 
 static void ase_file_write_padding(FILE* f, int bytes);
 static void ase_file_write_string(FILE* f, const std::string& string);
@@ -192,6 +292,12 @@ static void ase_file_write_cel_extra_chunk(FILE* f,
 static void ase_file_write_color_profile(FILE* f,
                                          dio::AsepriteFrameHeader* frame_header,
                                          const doc::Sprite* sprite);
+static void ase_file_write_preview_chunk(FILE* f,
+                                         FileOp* fop,
+                                         dio::AsepriteFrameHeader* frame_header,
+                                         const Sprite* sprite,
+                                         const frame_t frame,
+                                         const int maxSize);
 #if 0
 static void ase_file_write_mask_chunk(FILE* f, dio::AsepriteFrameHeader* frame_header, Mask* mask);
 #endif
@@ -237,7 +343,7 @@ static void ase_file_write_properties_maps(FILE* f,
                                            FileOp* fop,
                                            const dio::AsepriteExternalFiles& ext_files,
                                            size_t nmaps,
-                                           const doc::UserData::PropertiesMaps& propertiesMaps);
+                                           const doc::UserData* userData);
 static bool ase_has_groups(LayerGroup* group);
 static void ase_ungroup_all(LayerGroup* group);
 
@@ -262,6 +368,9 @@ public:
     AsepriteOptions() : celType(ASE_FILE_COMPRESSED_CEL) {}
 
     int celType;
+
+    // Compression used for the compressed cels and tilesets.
+    app::gen::CompressionProfile compression = app::gen::CompressionProfile::DEFAULT;
   };
 
 private:
@@ -281,7 +390,7 @@ private:
            FILE_SUPPORT_GRAY | FILE_SUPPORT_GRAYA | FILE_SUPPORT_INDEXED | FILE_SUPPORT_LAYERS |
            FILE_SUPPORT_FRAMES | FILE_SUPPORT_PALETTES | FILE_SUPPORT_TAGS |
            FILE_SUPPORT_BIG_PALETTES | FILE_SUPPORT_PALETTE_WITH_ALPHA |
-           FILE_SUPPORT_GET_FORMAT_OPTIONS;
+           FILE_SUPPORT_GET_FORMAT_OPTIONS | FILE_SUPPORT_MEMORY;
   }
 
   bool onLoad(FileOp* fop) override;
@@ -299,14 +408,35 @@ FileFormat* CreateAseFormat()
 
 bool AseFormat::onLoad(FileOp* fop)
 {
-  FileHandle handle(open_file_with_exception(fop->filename(), "rb"));
-  dio::StdioFileInterface fileInterface(handle.get());
-
   DecodeDelegate delegate(fop);
   dio::AsepriteDecoder decoder;
-  decoder.initialize(&delegate, &fileInterface);
-  if (!decoder.decode())
-    return false;
+
+  // Regular files are mapped in memory to avoid stdio calls for each
+  // field of the file
+  dio::MappedFileRef mappedFile;
+  if (!fop->isMemory()) {
+    try {
+      mappedFile = std::make_shared<dio::MappedFile>(fop->filename());
+    }
+    catch (const std::exception&) {
+      // Use stdio
+    }
+  }
+
+  if (mappedFile) {
+    dio::MappedFileInterface fileInterface(mappedFile);
+    delegate.setMappedFile(mappedFile);
+    decoder.initialize(&delegate, &fileInterface);
+    if (!decoder.decode())
+      return false;
+  }
+  else {
+    FileHandle handle(fop->openFileForReading());
+    dio::StdioFileInterface fileInterface(handle.get());
+    decoder.initialize(&delegate, &fileInterface);
+    if (!decoder.decode())
+      return false;
+  }
 
   Sprite* sprite = delegate.sprite();
 
@@ -373,7 +503,21 @@ bool AseFormat::onPostLoad(FileOp* fop)
 bool AseFormat::onSave(FileOp* fop)
 {
   const Sprite* sprite = fop->document()->sprite();
-  FileHandle handle(open_file_with_exception_sync_on_close(fop->filename(), "wb"));
+
+  // Lazy images can be decoded from the same file that we are going
+  // to overwrite, so we have to keep them in memory from now on. The
+  // whole cache is pinned because other documents (e.g. duplicated
+  // sprites) can have clones of these images. Pinned images release
+  // the mapped file, so it's closed before we open it for writing.
+  std::set<doc::LazyImagesCache*> pinnedCaches;
+  for (const Cel* cel : sprite->uniqueCels()) {
+    if (const doc::LazyImageRef& lazyImage = cel->data()->lazyImage()) {
+      if (pinnedCaches.insert(lazyImage->cache().get()).second)
+        lazyImage->cache()->pinAll();
+    }
+  }
+
+  FileHandle handle(fop->openFileForWriting());
   FILE* f = handle.get();
 
   // Write the header
@@ -394,10 +538,23 @@ bool AseFormat::onSave(FileOp* fop)
     }
   }
 
+  std::vector<frame_t> frames;
+  for (frame_t frame : fop->roi().framesSequence())
+    frames.push_back(frame);
+
   // Write frames
   int outputFrame = 0;
   dio::AsepriteExternalFiles ext_files;
-  for (frame_t frame : fop->roi().framesSequence()) {
+  FramePalettes framePalettes(sprite);
+  ParallelCelsCompressor compressor(fop, sprite);
+  for (frame_t frame : frames) {
+    // Compress the cels of the next batch of frames
+    if ((outputFrame % ParallelCelsCompressor::kFramesPerBatch) == 0) {
+      compressor.compressFrames(
+        &frames[outputFrame],
+        std::min<int>(ParallelCelsCompressor::kFramesPerBatch, frames.size() - outputFrame));
+    }
+
     // Prepare the frame header
     dio::AsepriteFrameHeader frame_header;
     ase_file_prepare_frame_header(f, &frame_header);
@@ -412,15 +569,28 @@ bool AseFormat::onSave(FileOp* fop)
       // Save color profile in first frame
       if (fop->preserveColorProfile())
         ase_file_write_color_profile(f, &frame_header, sprite);
+
+      // Preview of the first frame for thumbnails (it's the first
+      // chunk with pixels, so it can be read without decoding the
+      // rest of the file)
+      if (fop->config().asepritePreviewSize > 0)
+        ase_file_write_preview_chunk(f,
+                                     fop,
+                                     &frame_header,
+                                     sprite,
+                                     frame,
+                                     fop->config().asepritePreviewSize);
     }
 
     // is the first frame or did the palette change?
-    Palette* pal = sprite->palette(frame);
+    Palette* pal = framePalettes.palette(frame);
     int palFrom = 0, palTo = pal->size() - 1;
+    const Palette* prevPal = (frame > 0 ? sprite->palette(frame - 1) : nullptr);
     if ( // First frame or..
       (frame == fop->roi().fromFrame() ||
        // This palette is different from the previous frame palette
-       sprite->palette(frame - 1)->countDiff(pal, &palFrom, &palTo) > 0)) {
+       // (the same palette object cannot be different)
+       !prevPal || (prevPal != pal && prevPal->countDiff(pal, &palFrom, &palTo) > 0))) {
       // Write new palette chunk
       if (require_new_palette_chunk) {
         ase_file_write_palette_chunk(f, &frame_header, pal, palFrom, palTo);
@@ -473,7 +643,15 @@ bool AseFormat::onSave(FileOp* fop)
     }
 
     // Write cel chunks
-    ase_file_write_cels(f, fop, &frame_header, ext_files, sprite, sprite->root(), 0, frame);
+    ase_file_write_cels(f,
+                        fop,
+                        &frame_header,
+                        ext_files,
+                        sprite,
+                        sprite->root(),
+                        0,
+                        frame,
+                        &compressor);
 
     // Write the frame header
     ase_file_write_frame_header(f, &frame_header);
@@ -504,6 +682,7 @@ bool AseFormat::onSave(FileOp* fop)
 FormatOptionsPtr AseFormat::onAskUserForFormatOptions(FileOp* fop)
 {
   auto opts = fop->formatOptionsOfDocument<AsepriteOptions>();
+  opts->compression = fop->config().asepriteCompression;
   if (fop->context() && fop->context()->isUIAvailable()) {
     try {
       auto& pref = Preferences::instance();
@@ -656,7 +835,8 @@ static layer_t ase_file_write_cels(FILE* f,
                                    const Sprite* sprite,
                                    const Layer* layer,
                                    layer_t layer_index,
-                                   const frame_t frame)
+                                   const frame_t frame,
+                                   const ParallelCelsCompressor* compressor)
 {
   if (layer->isImage()) {
     const Cel* cel = layer->cel(frame);
@@ -668,7 +848,8 @@ static layer_t ase_file_write_cels(FILE* f,
                                static_cast<const LayerImage*>(layer),
                                layer_index,
                                sprite,
-                               fop->roi().fromFrame());
+                               fop->roi().fromFrame(),
+                               compressor);
 
       if (layer->isReference())
         ase_file_write_cel_extra_chunk(f, frame_header, cel);
@@ -684,8 +865,15 @@ static layer_t ase_file_write_cels(FILE* f,
 
   if (layer->isGroup()) {
     for (const Layer* child : static_cast<const LayerGroup*>(layer)->layers()) {
-      layer_index =
-        ase_file_write_cels(f, fop, frame_header, ext_files, sprite, child, layer_index, frame);
+      layer_index = ase_file_write_cels(f,
+                                        fop,
+                                        frame_header,
+                                        ext_files,
+                                        sprite,
+                                        child,
+                                        layer_index,
+                                        frame,
+                                        compressor);
     }
   }
 
@@ -961,7 +1149,9 @@ static void write_raw_image(FILE* f, ScanlinesGen* gen, PixelFormat pixelFormat)
 //////////////////////////////////////////////////////////////////////
 
 template<typename ImageTraits>
-static void write_compressed_image_templ(FILE* f, ScanlinesGen* gen, base::buffer* compressedOutput)
+static void compress_image_templ(const ScanlinesGen* gen,
+                                 const int compressionLevel,
+                                 base::buffer& output)
 {
   PixelIO<ImageTraits> pixel_io;
   z_stream zstream;
@@ -970,7 +1160,7 @@ static void write_compressed_image_templ(FILE* f, ScanlinesGen* gen, base::buffe
   zstream.zalloc = (alloc_func)0;
   zstream.zfree = (free_func)0;
   zstream.opaque = (voidpf)0;
-  err = deflateInit(&zstream, Z_DEFAULT_COMPRESSION);
+  err = deflateInit(&zstream, compressionLevel);
   if (err != Z_OK)
     throw base::Exception("ZLib error %d in deflateInit().", err);
 
@@ -994,25 +1184,14 @@ static void write_compressed_image_templ(FILE* f, ScanlinesGen* gen, base::buffe
 
       // Compress
       err = deflate(&zstream, flush);
-      if (err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR)
+      if (err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR) {
+        deflateEnd(&zstream);
         throw base::Exception("ZLib error %d in deflate().", err);
+      }
 
       int output_bytes = compressed.size() - zstream.avail_out;
-      if (output_bytes > 0) {
-        if ((fwrite(&compressed[0], 1, output_bytes, f) != (size_t)output_bytes) || ferror(f))
-          throw base::Exception("Error writing compressed image pixels.\n");
-
-        // Save the whole compressed buffer to re-use in following
-        // save options (so we don't have to re-compress the whole
-        // tileset)
-        if (compressedOutput) {
-          std::size_t n = compressedOutput->size();
-          compressedOutput->resize(n + output_bytes);
-          std::copy(compressed.begin(),
-                    compressed.begin() + output_bytes,
-                    compressedOutput->begin() + n);
-        }
-      }
+      if (output_bytes > 0)
+        output.insert(output.end(), compressed.begin(), compressed.begin() + output_bytes);
     } while (zstream.avail_out == 0);
   }
 
@@ -1021,28 +1200,155 @@ static void write_compressed_image_templ(FILE* f, ScanlinesGen* gen, base::buffe
     throw base::Exception("ZLib error %d in deflateEnd().", err);
 }
 
-static void write_compressed_image(FILE* f,
-                                   ScanlinesGen* gen,
-                                   PixelFormat pixelFormat,
-                                   base::buffer* compressedOutput = nullptr)
+// Appends the zlib compressed pixels of the given scanlines to the
+// output buffer. This function can be called from any thread.
+static void compress_image(const ScanlinesGen* gen,
+                           PixelFormat pixelFormat,
+                           const int compressionLevel,
+                           base::buffer& output)
 {
   switch (pixelFormat) {
-    case IMAGE_RGB: write_compressed_image_templ<RgbTraits>(f, gen, compressedOutput); break;
-
+    case IMAGE_RGB:
+      compress_image_templ<RgbTraits>(gen, compressionLevel, output);
+      break;
     case IMAGE_GRAYSCALE:
-      write_compressed_image_templ<GrayscaleTraits>(f, gen, compressedOutput);
+      compress_image_templ<GrayscaleTraits>(gen, compressionLevel, output);
       break;
-
     case IMAGE_INDEXED:
-      write_compressed_image_templ<IndexedTraits>(f, gen, compressedOutput);
+      compress_image_templ<IndexedTraits>(gen, compressionLevel, output);
       break;
-
     case IMAGE_TILEMAP:
-      write_compressed_image_templ<TilemapTraits>(f, gen, compressedOutput);
+      compress_image_templ<TilemapTraits>(gen, compressionLevel, output);
       break;
   }
 }
 
+static void write_compressed_data(FILE* f, const base::buffer& data)
+{
+  if (!data.empty() && ((fwrite(&data[0], 1, data.size(), f) != data.size()) || ferror(f)))
+    throw base::Exception("Error writing compressed image pixels.\n");
+}
+
+static void write_compressed_image(FILE* f,
+                                   ScanlinesGen* gen,
+                                   PixelFormat pixelFormat,
+                                   const int compressionLevel,
+                                   base::buffer* compressedOutput = nullptr)
+{
+  base::buffer data;
+  compress_image(gen, pixelFormat, compressionLevel, data);
+  write_compressed_data(f, data);
+
+  // Save the whole compressed buffer to re-use in following save
+  // options (so we don't have to re-compress the whole tileset)
+  if (compressedOutput)
+    compressedOutput->insert(compressedOutput->end(), data.begin(), data.end());
+}
+
+// Returns the zlib compression level for the compressed cels and
+// tilesets. All levels generate regular zlib streams, so the file
+// can be read by any version of the program.
+static int compression_level(FileOp* fop)
+{
+  app::gen::CompressionProfile profile = fop->config().asepriteCompression;
+  if (const auto aseOptions = std::static_pointer_cast<AseFormat::AsepriteOptions>(
+        fop->formatOptions()))
+    profile = aseOptions->compression;
+
+  switch (profile) {
+    case app::gen::CompressionProfile::FASTEST:  return Z_BEST_SPEED;
+    case app::gen::CompressionProfile::SMALLEST: return Z_BEST_COMPRESSION;
+    default:                                return Z_DEFAULT_COMPRESSION;
+  }
+}
+
+namespace {
+
+// Compresses the cel images of a group of frames in parallel before
+// they are written. The compressed data is the same as the one
+// generated by write_compressed_image(), and the cel chunks are still
+// written in order, so the file is byte-compatible.
+class ParallelCelsCompressor {
+public:
+  // Number of frames compressed in each batch (to limit the memory
+  // used by the compressed data that is waiting to be written).
+  static constexpr int kFramesPerBatch = 32;
+
+  ParallelCelsCompressor(FileOp* fop, const Sprite* sprite) : m_sprite(sprite)
+  {
+    const auto aseOptions = std::static_pointer_cast<AseFormat::AsepriteOptions>(
+      fop->formatOptions());
+    m_compressCels = (!aseOptions || aseOptions->celType == ASE_FILE_COMPRESSED_CEL);
+    m_compressionLevel = compression_level(fop);
+  }
+
+  void compressFrames(const frame_t* frames, const int n)
+  {
+    m_data.clear();
+
+    std::vector<const Image*> images;
+    for (int i = 0; i < n; ++i)
+      collectImages(m_sprite->root(), frames[i], images);
+    if (images.size() < 2)
+      return;
+
+    doc::TaskGroup tasks;
+    for (const Image* image : images) {
+      base::buffer& data = m_data[image];
+      tasks.run([this, image, &data] {
+        try {
+          TRACING_SCOPE("compress_image task");
+          ImageScanlines scan(image);
+          compress_image(&scan, image->pixelFormat(), m_compressionLevel, data);
+        }
+        catch (const std::exception&) {
+          // The image will be compressed again in the main thread
+          // (reporting the error in that case).
+          data.clear();
+        }
+      });
+    }
+    tasks.wait();
+  }
+
+  // Returns the compressed data for the given image, or nullptr if
+  // it wasn't compressed in parallel.
+  const base::buffer* compressedImage(const Image* image) const
+  {
+    auto it = m_data.find(image);
+    if (it != m_data.end() && !it->second.empty())
+      return &it->second;
+    return nullptr;
+  }
+
+private:
+  void collectImages(const Layer* layer, const frame_t frame, std::vector<const Image*>& images)
+  {
+    if (layer->isImage()) {
+      const Cel* cel = layer->cel(frame);
+      if (cel && cel->image() && (m_compressCels || layer->isTilemap()) &&
+          m_data.find(cel->image()) == m_data.end()) {
+        // Linked cels share the same image, so it's compressed just
+        // one time (and maybe not even used if the cel is saved as a
+        // link).
+        m_data[cel->image()];
+        images.push_back(cel->image());
+      }
+    }
+    else if (layer->isGroup()) {
+      for (const Layer* child : static_cast<const LayerGroup*>(layer)->layers())
+        collectImages(child, frame, images);
+    }
+  }
+
+  const Sprite* m_sprite;
+  bool m_compressCels;
+  int m_compressionLevel;
+  std::map<const Image*, base::buffer> m_data;
+};
+
+} // anonymous namespace
+
 //////////////////////////////////////////////////////////////////////
 // Cel Chunk
 //////////////////////////////////////////////////////////////////////
@@ -1054,7 +1360,8 @@ static void ase_file_write_cel_chunk(FILE* f,
                                      const LayerImage* layer,
                                      const layer_t layer_index,
                                      const Sprite* sprite,
-                                     const frame_t firstFrame)
+                                     const frame_t firstFrame,
+                                     const ParallelCelsCompressor* compressor)
 {
   const auto aseOptions = std::static_pointer_cast<AseFormat::AsepriteOptions>(
     fop->formatOptions());
@@ -1123,8 +1430,13 @@ static void ase_file_write_cel_chunk(FILE* f,
         fputw(image->width(), f);
         fputw(image->height(), f);
 
-        ImageScanlines scan(image);
-        write_compressed_image(f, &scan, image->pixelFormat());
+        if (const base::buffer* data = (compressor ? compressor->compressedImage(image) : nullptr)) {
+          write_compressed_data(f, *data);
+        }
+        else {
+          ImageScanlines scan(image);
+          write_compressed_image(f, &scan, image->pixelFormat(), compression_level(fop));
+        }
       }
       else {
         // Width and height
@@ -1148,8 +1460,13 @@ static void ase_file_write_cel_chunk(FILE* f,
       fputl(tile_f_dflip, f);
       ase_file_write_padding(f, 10);
 
-      ImageScanlines scan(image);
-      write_compressed_image(f, &scan, IMAGE_TILEMAP);
+      if (const base::buffer* data = (compressor ? compressor->compressedImage(image) : nullptr)) {
+        write_compressed_data(f, *data);
+      }
+      else {
+        ImageScanlines scan(image);
+        write_compressed_image(f, &scan, IMAGE_TILEMAP, compression_level(fop));
+      }
     }
   }
 }
@@ -1210,6 +1527,43 @@ static void ase_file_write_color_profile(FILE* f,
   }
 }
 
+static void ase_file_write_preview_chunk(FILE* f,
+                                         FileOp* fop,
+                                         dio::AsepriteFrameHeader* frame_header,
+                                         const Sprite* sprite,
+                                         const frame_t frame,
+                                         const int maxSize)
+{
+  const int w = sprite->width() * sprite->pixelRatio().w;
+  const int h = sprite->height() * sprite->pixelRatio().h;
+
+  // Downscale the sprite to fit in maxSize (never upscale it)
+  render::Zoom zoom(1, 1);
+  if (std::max(w, h) > maxSize)
+    zoom = render::Zoom(maxSize, std::max(w, h));
+
+  ImageRef preview(Image::create(IMAGE_RGB,
+                                 std::clamp(zoom.apply(w), 1, maxSize),
+                                 std::clamp(zoom.apply(h), 1, maxSize)));
+
+  render::Render render;
+  render.setNewBlend(fop->config().newBlend);
+  render.setBgOptions(render::BgOptions::MakeTransparent());
+  render.setProjection(render::Projection(sprite->pixelRatio(), zoom));
+  render.renderSprite(preview.get(),
+                      sprite,
+                      frame,
+                      gfx::Clip(0, 0, 0, 0, preview->width(), preview->height()));
+
+  ChunkWriter chunk(f, frame_header, ASE_FILE_CHUNK_PREVIEW);
+  fputw(preview->width(), f);
+  fputw(preview->height(), f);
+  ase_file_write_padding(f, 8);
+
+  ImageScanlines scan(preview.get());
+  write_compressed_image(f, &scan, IMAGE_RGB, compression_level(fop));
+}
+
 #if 0
 static void ase_file_write_mask_chunk(FILE* f, dio::AsepriteFrameHeader* frame_header, Mask* mask)
 {
@@ -1291,7 +1645,7 @@ static void ase_file_write_user_data_chunk(FILE* f,
 {
   ChunkWriter chunk(f, frame_header, ASE_FILE_CHUNK_USER_DATA);
 
-  size_t nmaps = count_nonempty_properties_maps(userData->propertiesMaps());
+  size_t nmaps = count_nonempty_properties_maps(*userData);
   int flags = 0;
   if (!userData->text().empty())
     flags |= ASE_USER_DATA_FLAG_HAS_TEXT;
@@ -1312,7 +1666,7 @@ static void ase_file_write_user_data_chunk(FILE* f,
   }
 
   if (flags & ASE_USER_DATA_FLAG_HAS_PROPERTIES) {
-    ase_file_write_properties_maps(f, fop, ext_files, nmaps, userData->propertiesMaps());
+    ase_file_write_properties_maps(f, fop, ext_files, nmaps, userData);
   }
 }
 
@@ -1411,12 +1765,15 @@ static void ase_file_write_external_files_chunk(FILE* f,
                                                 dio::AsepriteExternalFiles& ext_files,
                                                 const Sprite* sprite)
 {
-  auto putExtentionIds = [](const UserData::PropertiesMaps& propertiesMaps,
-                            dio::AsepriteExternalFiles& ext_files) {
-    for (auto propertiesMap : propertiesMaps) {
-      if (!propertiesMap.first.empty())
-        ext_files.insert(ASE_EXTERNAL_FILE_EXTENSION, propertiesMap.first);
-    }
+  // Lazy properties maps are not decoded here, we only need their keys
+  auto putExtentionIds = [](const UserData& userData, dio::AsepriteExternalFiles& ext_files) {
+    auto insertKey = [&ext_files](const std::string& key) {
+      if (!key.empty())
+        ext_files.insert(ASE_EXTERNAL_FILE_EXTENSION, key);
+    };
+    userData.forEachPropertiesMap(
+      [&insertKey](const std::string& key, const UserData::Properties&) { insertKey(key); },
+      [&insertKey](const std::string& key, const UserData::LazyProperties&) { insertKey(key); });
   };
 
   for (const Tileset* tileset : *sprite->tilesets()) {
@@ -1427,18 +1784,18 @@ static void ase_file_write_external_files_chunk(FILE* f,
       ext_files.insert(ASE_EXTERNAL_FILE_TILESET, tileset->externalFilename());
     }
 
-    putExtentionIds(tileset->userData().propertiesMaps(), ext_files);
+    putExtentionIds(tileset->userData(), ext_files);
 
     for (tile_index i = 0; i < tileset->size(); ++i) {
       UserData tileData = tileset->getTileData(i);
-      putExtentionIds(tileData.propertiesMaps(), ext_files);
+      putExtentionIds(tileData, ext_files);
     }
   }
 
-  putExtentionIds(sprite->userData().propertiesMaps(), ext_files);
+  putExtentionIds(sprite->userData(), ext_files);
 
   for (doc::Tag* tag : sprite->tags()) {
-    putExtentionIds(tag->userData().propertiesMaps(), ext_files);
+    putExtentionIds(tag->userData(), ext_files);
   }
 
   // Go through all the layers collecting all the extension IDs we find
@@ -1447,7 +1804,7 @@ static void ase_file_write_external_files_chunk(FILE* f,
     auto layer = layers.front();
     layers.pop_front();
 
-    putExtentionIds(layer->userData().propertiesMaps(), ext_files);
+    putExtentionIds(layer->userData(), ext_files);
     if (layer->isGroup()) {
       auto childLayers = static_cast<const LayerGroup*>(layer)->layers();
       layers.insert(layers.end(), childLayers.begin(), childLayers.end());
@@ -1456,7 +1813,7 @@ static void ase_file_write_external_files_chunk(FILE* f,
       for (frame_t frame : fop->roi().framesSequence()) {
         const Cel* cel = layer->cel(frame);
         if (cel && !cel->link()) {
-          putExtentionIds(cel->data()->userData().propertiesMaps(), ext_files);
+          putExtentionIds(cel->data()->userData(), ext_files);
         }
       }
     }
@@ -1467,7 +1824,7 @@ static void ase_file_write_external_files_chunk(FILE* f,
     if (slice->range(fop->roi().fromFrame(), fop->roi().toFrame()).empty())
       continue;
 
-    putExtentionIds(slice->userData().propertiesMaps(), ext_files);
+    putExtentionIds(slice->userData(), ext_files);
   }
 
   // Tile management plugin
@@ -1568,9 +1925,13 @@ static void ase_file_write_tileset_chunk(FILE* f,
   if (flags & ASE_TILESET_FLAG_EMBEDDED) {
     size_t beg = ftell(f);
 
-    // Save the cached tileset compressed data
+    // Save the cached tileset compressed data (if the smallest
+    // compression is used, the tileset is compressed again because
+    // the cached data could have been compressed with other level)
+    const int compressionLevel = compression_level(fop);
     if (!tileset->compressedData().empty() &&
-        tileset->compressedDataVersion() == tileset->version()) {
+        tileset->compressedDataVersion() == tileset->version() &&
+        compressionLevel != Z_BEST_COMPRESSION) {
       const base::buffer& data = tileset->compressedData();
 
       ASEFILE_TRACE("[%d] saving compressed tileset (%s)\n",
@@ -1592,7 +1953,11 @@ static void ase_file_write_tileset_chunk(FILE* f,
       if (fop->config().cacheCompressedTilesets)
         compressedDataPtr = &compressedData;
 
-      write_compressed_image(f, &gen, tileset->sprite()->pixelFormat(), compressedDataPtr);
+      write_compressed_image(f,
+                             &gen,
+                             tileset->sprite()->pixelFormat(),
+                             compressionLevel,
+                             compressedDataPtr);
 
       // As we've just compressed the tileset, we can cache this same
       // data (so saving the file again will not need recompressing).
@@ -1694,11 +2059,34 @@ static void ase_file_write_property_value(FILE* f, const UserData::Variant& valu
   }
 }
 
+static uint32_t ase_file_get_extension_id(FileOp* fop,
+                                          const dio::AsepriteExternalFiles& ext_files,
+                                          const std::string& extensionKey)
+{
+  uint32_t extensionId = 0;
+  if (!extensionKey.empty() &&
+      !ext_files.getIDByFilename(ASE_EXTERNAL_FILE_EXTENSION, extensionKey, extensionId)) {
+    // This shouldn't ever happen, but if it does...  most likely
+    // it is because we forgot to add the extensionID to the
+    // ext_files object. And this could happen if someone adds the
+    // possibility to store custom properties to some object that
+    // didn't support it previously.
+    ASSERT(false);
+    fop->setError("Error writing properties for extension '%s'.\n", extensionKey.c_str());
+
+    // We have to write something for this extensionId, because we
+    // wrote the number of expected property maps (nmaps) in the
+    // header.
+    // continue;
+  }
+  return extensionId;
+}
+
 static void ase_file_write_properties_maps(FILE* f,
                                            FileOp* fop,
                                            const dio::AsepriteExternalFiles& ext_files,
                                            size_t nmaps,
-                                           const doc::UserData::PropertiesMaps& propertiesMaps)
+                                           const doc::UserData* userData)
 {
   ASSERT(nmaps > 0);
 
@@ -1709,32 +2097,21 @@ static void ase_file_write_properties_maps(FILE* f,
   fputl(0, f);
 
   fputl(nmaps, f);
-  for (const auto& propertiesMap : propertiesMaps) {
-    const UserData::Properties& properties = propertiesMap.second;
-    // Skip properties map if it doesn't have any property
-    if (properties.empty())
-      continue;
-
-    const std::string& extensionKey = propertiesMap.first;
-    uint32_t extensionId = 0;
-    if (!extensionKey.empty() &&
-        !ext_files.getIDByFilename(ASE_EXTERNAL_FILE_EXTENSION, extensionKey, extensionId)) {
-      // This shouldn't ever happen, but if it does...  most likely
-      // it is because we forgot to add the extensionID to the
-      // ext_files object. And this could happen if someone adds the
-      // possibility to store custom properties to some object that
-      // didn't support it previously.
-      ASSERT(false);
-      fop->setError("Error writing properties for extension '%s'.\n", extensionKey.c_str());
-
-      // We have to write something for this extensionId, because we
-      // wrote the number of expected property maps (nmaps) in the
-      // header.
-      // continue;
-    }
-    fputl(extensionId, f);
-    ase_file_write_property_value(f, properties);
-  }
+  userData->forEachPropertiesMap(
+    [f, fop, &ext_files](const std::string& key, const UserData::Properties& properties) {
+      // Skip properties map if it doesn't have any property
+      if (properties.empty())
+        return;
+
+      fputl(ase_file_get_extension_id(fop, ext_files, key), f);
+      ase_file_write_property_value(f, properties);
+    },
+    // Properties that weren't decoded are saved as they were loaded
+    [f, fop, &ext_files](const std::string& key, const UserData::LazyProperties& lazy) {
+      const std::vector<uint8_t>& data = lazy.data();
+      fputl(ase_file_get_extension_id(fop, ext_files, key), f);
+      fwrite(data.data(), 1, data.size(), f);
+    });
   long endPos = ftell(f);
   // We can overwrite the properties maps size now
   fseek(f, startPos, SEEK_SET);
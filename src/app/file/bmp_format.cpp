@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2023  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -24,6 +24,9 @@
 #include "doc/doc.h"
 #include "fmt/format.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace app {
 
 // Max supported .bmp size (to filter out invalid image sizes)
@@ -63,7 +66,7 @@ class BmpFormat : public FileFormat {
   {
     return FILE_SUPPORT_LOAD | FILE_SUPPORT_SAVE | FILE_SUPPORT_RGB | FILE_SUPPORT_RGBA |
            FILE_SUPPORT_GRAY | FILE_SUPPORT_INDEXED | FILE_SUPPORT_SEQUENCES |
-           FILE_ENCODE_ABSTRACT_IMAGE;
+           FILE_ENCODE_ABSTRACT_IMAGE | FILE_SUPPORT_MEMORY;
   }
 
   bool onLoad(FileOp* fop) override;
@@ -486,171 +489,88 @@ static void read_bmicolors(FileOp* fop, int bytes, FILE* f, bool win_flag)
     fgetc(f);
 }
 
+// The read_*_line() functions convert one scanline of the file
+// (already read in "src") to the "line" row of the image. Indexed
+// images have one byte per pixel, RGB images four bytes per pixel.
+
 /* read_1bit_line:
  *  Support function for reading the 1 bit bitmap file format.
  */
-static void read_1bit_line(int length, FILE* f, Image* image, int line)
+static void read_1bit_line(int length, const uint8_t* src, Image* image, int line)
 {
-  unsigned char b[32];
-  unsigned long n;
-  int i, j, k;
-  int pix;
-
-  for (i = 0; i < length; i++) {
-    j = i % 32;
-    if (j == 0) {
-      n = fgetl(f);
-      n = ((n & 0x000000ff) << 24) | ((n & 0x0000ff00) << 8) | ((n & 0x00ff0000) >> 8) |
-          ((n & 0xff000000) >> 24);
-      for (k = 0; k < 32; k++) {
-        b[31 - k] = (char)(n & 1);
-        n = n >> 1;
-      }
-    }
-    pix = b[j];
-    put_pixel(image, i, line, pix);
-  }
+  uint8_t* dst = image->getPixelAddress(0, line);
+  for (int i = 0; i < length; i++)
+    dst[i] = (src[i >> 3] >> (7 - (i & 7))) & 1;
 }
 
 /* read_2bit_line (not standard):
  *  Support function for reading the 2 bit bitmap file format.
  */
-static void read_2bit_line(int length, FILE* f, Image* image, int line)
+static void read_2bit_line(int length, const uint8_t* src, Image* image, int line)
 {
-  unsigned char b[16];
-  unsigned long n;
-  int i, j, k;
-  int temp;
-  int pix;
-
-  for (i = 0; i < length; i++) {
-    j = i % 16;
-    if (j == 0) {
-      n = fgetl(f);
-      for (k = 0; k < 4; k++) {
-        temp = n & 255;
-        b[k * 4 + 3] = temp & 3;
-        temp = temp >> 2;
-        b[k * 4 + 2] = temp & 3;
-        temp = temp >> 2;
-        b[k * 4 + 1] = temp & 3;
-        temp = temp >> 2;
-        b[k * 4] = temp & 3;
-        n = n >> 8;
-      }
-    }
-    pix = b[j];
-    put_pixel(image, i, line, pix);
-  }
+  uint8_t* dst = image->getPixelAddress(0, line);
+  for (int i = 0; i < length; i++)
+    dst[i] = (src[i >> 2] >> (6 - 2 * (i & 3))) & 3;
 }
 
 /* read_4bit_line:
  *  Support function for reading the 4 bit bitmap file format.
  */
-static void read_4bit_line(int length, FILE* f, Image* image, int line)
+static void read_4bit_line(int length, const uint8_t* src, Image* image, int line)
 {
-  unsigned char b[8];
-  unsigned long n;
-  int i, j, k;
-  int temp;
-  int pix;
-
-  for (i = 0; i < length; i++) {
-    j = i % 8;
-    if (j == 0) {
-      n = fgetl(f);
-      for (k = 0; k < 4; k++) {
-        temp = n & 255;
-        b[k * 2 + 1] = temp & 15;
-        temp = temp >> 4;
-        b[k * 2] = temp & 15;
-        n = n >> 8;
-      }
-    }
-    pix = b[j];
-    put_pixel(image, i, line, pix);
-  }
+  uint8_t* dst = image->getPixelAddress(0, line);
+  for (int i = 0; i < length; i++)
+    dst[i] = (src[i >> 1] >> (i & 1 ? 0 : 4)) & 15;
 }
 
 /* read_8bit_line:
  *  Support function for reading the 8 bit bitmap file format.
  */
-static void read_8bit_line(int length, FILE* f, Image* image, int line)
+static void read_8bit_line(int length, const uint8_t* src, Image* image, int line)
 {
-  unsigned char b[4];
-  unsigned long n;
-  int i, j, k;
-  int pix;
-
-  for (i = 0; i < length; i++) {
-    j = i % 4;
-    if (j == 0) {
-      n = fgetl(f);
-      for (k = 0; k < 4; k++) {
-        b[k] = (char)(n & 255);
-        n = n >> 8;
-      }
-    }
-    pix = b[j];
-    put_pixel(image, i, line, pix);
-  }
+  std::copy(src, src + length, image->getPixelAddress(0, line));
 }
 
-static void read_16bit_line(int length, FILE* f, Image* image, int line, bool& withAlpha)
+static void read_16bit_line(int length,
+                            const uint8_t* src,
+                            Image* image,
+                            int line,
+                            bool& withAlpha)
 {
-  int i, r, g, b, a, word;
-
-  for (i = 0; i < length; i++) {
-    word = fgetw(f);
-
-    r = (word >> 10) & 0x1f;
-    g = (word >> 5) & 0x1f;
-    b = (word) & 0x1f;
-    a = (word & 0x8000 ? 255 : 0);
+  auto dst = (RgbTraits::address_t)image->getPixelAddress(0, line);
+  for (int i = 0; i < length; i++, src += 2) {
+    const int word = src[0] | (src[1] << 8);
+    const int r = (word >> 10) & 0x1f;
+    const int g = (word >> 5) & 0x1f;
+    const int b = (word) & 0x1f;
+    const int a = (word & 0x8000 ? 255 : 0);
     if (a)
       withAlpha = true;
-    put_pixel(image,
-              i,
-              line,
-              rgba(scale_5bits_to_8bits(r), scale_5bits_to_8bits(g), scale_5bits_to_8bits(b), a));
+    dst[i] = rgba(scale_5bits_to_8bits(r), scale_5bits_to_8bits(g), scale_5bits_to_8bits(b), a);
   }
-
-  i = (2 * i) % 4;
-  if (i > 0)
-    while (i++ < 4)
-      fgetc(f);
 }
 
-static void read_24bit_line(int length, FILE* f, Image* image, int line)
+static void read_24bit_line(int length, const uint8_t* src, Image* image, int line)
 {
-  int i, r, g, b;
-
-  for (i = 0; i < length; i++) {
-    b = fgetc(f);
-    g = fgetc(f);
-    r = fgetc(f);
-    put_pixel(image, i, line, rgba(r, g, b, 255));
-  }
-
-  i = (3 * i) % 4;
-  if (i > 0)
-    while (i++ < 4)
-      fgetc(f);
+  auto dst = (RgbTraits::address_t)image->getPixelAddress(0, line);
+  for (int i = 0; i < length; i++, src += 3)
+    dst[i] = rgba(src[2], src[1], src[0], 255);
 }
 
-static void read_32bit_line(int length, FILE* f, Image* image, int line, bool& withAlpha)
+static void read_32bit_line(int length,
+                            const uint8_t* src,
+                            Image* image,
+                            int line,
+                            bool& withAlpha)
 {
-  int i, r, g, b, a;
-
-  for (i = 0; i < length; i++) {
-    b = fgetc(f);
-    g = fgetc(f);
-    r = fgetc(f);
-    a = fgetc(f);
-    if (a)
-      withAlpha = true;
-    put_pixel(image, i, line, rgba(r, g, b, a));
+  auto dst = (RgbTraits::address_t)image->getPixelAddress(0, line);
+  uint8_t alpha = 0;
+  for (int i = 0; i < length; i++, src += 4) {
+    alpha |= src[3];
+    dst[i] = rgba(src[2], src[1], src[0], src[3]);
   }
+  if (alpha)
+    withAlpha = true;
 }
 
 /* read_image:
@@ -669,15 +589,25 @@ static void read_image(FILE* f,
   dir = height < 0 ? 1 : -1;
   height = ABS(height);
 
+  // Each scanline is read with just one fread() call (scanlines are
+  // aligned to 32 bits)
+  const int width = image->width();
+  const std::size_t rowSize = ((std::size_t(infoheader->biBitCount) * width + 31) / 32) * 4;
+  std::vector<uint8_t> row(rowSize);
+
   for (i = 0; i < height; i++, line += dir) {
+    const std::size_t read = fread(row.data(), 1, rowSize, f);
+    if (read < rowSize) // Truncated file
+      std::fill(row.begin() + read, row.end(), 0);
+
     switch (infoheader->biBitCount) {
-      case 1:  read_1bit_line(infoheader->biWidth, f, image, line); break;
-      case 2:  read_2bit_line(infoheader->biWidth, f, image, line); break;
-      case 4:  read_4bit_line(infoheader->biWidth, f, image, line); break;
-      case 8:  read_8bit_line(infoheader->biWidth, f, image, line); break;
-      case 16: read_16bit_line(infoheader->biWidth, f, image, line, withAlpha); break;
-      case 24: read_24bit_line(infoheader->biWidth, f, image, line); break;
-      case 32: read_32bit_line(infoheader->biWidth, f, image, line, withAlpha); break;
+      case 1:  read_1bit_line(width, row.data(), image, line); break;
+      case 2:  read_2bit_line(width, row.data(), image, line); break;
+      case 4:  read_4bit_line(width, row.data(), image, line); break;
+      case 8:  read_8bit_line(width, row.data(), image, line); break;
+      case 16: read_16bit_line(width, row.data(), image, line, withAlpha); break;
+      case 24: read_24bit_line(width, row.data(), image, line); break;
+      case 32: read_32bit_line(width, row.data(), image, line, withAlpha); break;
     }
 
     fop->setProgress((float)(i + 1) / (float)(height));
@@ -941,7 +871,7 @@ bool BmpFormat::onLoad(FileOp* fop)
   PixelFormat pixelFormat;
   int format;
 
-  FileHandle handle(open_file_with_exception(fop->filename(), "rb"));
+  FileHandle handle(fop->openFileForReading());
   FILE* f = handle.get();
 
   if (read_bmfileheader(f, &fileheader) != 0)
@@ -1163,7 +1093,7 @@ bool BmpFormat::onSave(FileOp* fop)
       bfSize = WININFOHEADERSIZE + OS2FILEHEADERSIZE + biSizeImage; // header + image data
   }
 
-  FileHandle handle(open_file_with_exception_sync_on_close(fop->filename(), "wb"));
+  FileHandle handle(fop->openFileForWriting());
   FILE* f = handle.get();
 
   /* file_header */
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2024  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -21,24 +21,30 @@
 #include "app/file/file_format.h"
 #include "app/file/file_formats_manager.h"
 #include "app/file/format_options.h"
+#include "app/file/frame_render_cache.h"
+#include "app/file/sequence_manifest.h"
 #include "app/file/split_filename.h"
 #include "app/filename_formatter.h"
 #include "app/i18n/strings.h"
 #include "app/modules/gui.h"
 #include "app/modules/palettes.h"
 #include "app/pref/preferences.h"
+#include "app/task_scheduler.h"
 #include "app/tx.h"
 #include "app/ui/incompat_file_window.h"
 #include "app/ui/optional_alert.h"
 #include "app/ui/status_bar.h"
+#include "base/exception.h"
 #include "base/fs.h"
 #include "base/string.h"
 #include "dio/detect_format.h"
 #include "doc/algorithm/resize_image.h"
 #include "doc/doc.h"
+#include "doc/task_group.h"
 #include "fmt/format.h"
 #include "render/quantization.h"
 #include "render/render.h"
+#include "tracing/metrics.h"
 #include "ui/alert.h"
 #include "ui/listitem.h"
 #include "ui/system.h"
@@ -49,12 +55,48 @@
 
 #include <algorithm>
 #include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
 
 namespace app {
 
 using namespace base;
 
+static tracing::Histogram g_loadTime("file.load_us");
+static tracing::Histogram g_saveTime("file.save_us");
+static tracing::Counter g_loadedBytes("file.loaded_bytes");
+static tracing::Counter g_savedBytes("file.saved_bytes");
+
+namespace {
+
+// Hash of everything that affects the encoded file of one frame of
+// a sequence (used to skip unchanged frames in incremental saves).
+uint64_t sequence_image_hash(const Image* image, const Palette* palette, const gfx::PointF& scale)
+{
+  auto mix = [](uint64_t hash, const uint64_t value) {
+    return (hash ^ value) * 1099511628211ull;
+  };
+
+  uint64_t hash = doc::calculate_image_hash64(image, image->bounds());
+  hash = mix(hash, uint64_t(image->pixelFormat()));
+  hash = mix(hash, (uint64_t(image->width()) << 32) | uint64_t(image->height()));
+  hash = mix(hash, uint64_t(scale.x * 1000.0));
+  hash = mix(hash, uint64_t(scale.y * 1000.0));
+
+  // The palette is saved in the file for indexed images
+  if (image->pixelFormat() == IMAGE_INDEXED) {
+    for (int i = 0; i < palette->size(); ++i)
+      hash = mix(hash, palette->getEntry(i));
+  }
+  return hash;
+}
+
+} // anonymous namespace
+
 class FileOp::FileAbstractImageImpl : public FileAbstractImage {
 public:
   FileAbstractImageImpl(FileOp* fop)
@@ -151,6 +193,7 @@ public:
     render::Render render;
     render.setNewBlend(m_newBlend);
     render.setBgOptions(render::BgOptions::MakeNone());
+    render.setParallelRender(true);
     render.renderSprite((needResize ? m_tmpUnscaledRender.get() : dst),
                         m_sprite,
                         frame,
@@ -166,6 +209,8 @@ public:
     }
   }
 
+  const gfx::PointF& scale() const { return m_scale; }
+
   void setScale(const gfx::PointF& scale)
   {
     m_scale = scale;
@@ -257,6 +302,62 @@ int save_document(Context* context, Doc* document)
   return (!fop->hasError() ? 0 : -1);
 }
 
+Doc* load_document_from_memory(Context* context,
+                               const std::string& filename,
+                               std::vector<uint8_t>&& data,
+                               const int flags)
+{
+  std::unique_ptr<FileOp> fop(
+    FileOp::createLoadDocumentOperationFromMemory(context, filename, std::move(data), flags));
+  if (!fop)
+    return nullptr;
+
+  if (!fop->hasError()) {
+    fop->operate();
+    fop->done();
+    fop->postLoad();
+  }
+
+  if (fop->hasError()) {
+    Console console(context);
+    console.printf(fop->error().c_str());
+  }
+
+  Doc* document = fop->releaseDocument();
+  if (document && context)
+    document->setContext(context);
+
+  return document;
+}
+
+int save_document_in_memory(Context* context,
+                            const FileOpROI& roi,
+                            const std::string& filename,
+                            std::vector<uint8_t>& output)
+{
+  std::unique_ptr<FileOp> fop(
+    FileOp::createSaveDocumentOperation(context, roi, filename, "", false));
+  if (!fop)
+    return -1;
+
+  if (!fop->hasError()) {
+    fop->saveInMemory();
+    if (!fop->hasError()) {
+      fop->operate();
+      fop->done();
+    }
+  }
+
+  if (fop->hasError()) {
+    Console console(context);
+    console.printf(fop->error().c_str());
+    return -1;
+  }
+
+  output = fop->memoryData();
+  return 0;
+}
+
 bool is_static_image_format(const std::string& filename)
 {
   // Get the format through the extension of the filename
@@ -275,7 +376,65 @@ bool format_supports_palette(const std::string& filename)
   return (format && format->support(FILE_SUPPORT_PALETTES));
 }
 
-FileOpROI::FileOpROI() : m_document(nullptr), m_slice(nullptr), m_tag(nullptr)
+// Returns the frames of the sprite in the given tag and/or frames
+// sequence (relative to the tag if adjustByTag is true), or all
+// frames if there is no tag and no frames.
+static FramesSequence calculate_roi_frames(const Sprite* sprite,
+                                           const Tag* tag,
+                                           FramesSequence framesSeq,
+                                           const bool adjustByTag)
+{
+  if (tag) {
+    if (framesSeq.empty())
+      framesSeq.insert(tag->fromFrame(), tag->toFrame());
+    else if (adjustByTag)
+      framesSeq.displace(tag->fromFrame());
+
+    framesSeq = framesSeq.filter(std::max(0, tag->fromFrame()),
+                                 std::min(tag->toFrame(), sprite->lastFrame()));
+  }
+  // All frames if selected frames is empty
+  else if (framesSeq.empty())
+    framesSeq.insert(0, sprite->lastFrame());
+  return framesSeq;
+}
+
+// Returns the image of the only cel in the given frame if rendering
+// the frame would give exactly the same pixels, so we can save the
+// cel image directly without a copy of the whole canvas (e.g. for
+// big sprite sheet textures). Returns nullptr if the frame must be
+// rendered.
+static ImageRef get_cel_image_to_save(const Sprite* sprite,
+                                      const frame_t frame,
+                                      const gfx::Rect& bounds,
+                                      const gfx::Size& canvasSize)
+{
+  const LayerList& layers = sprite->root()->layers();
+  if (layers.size() != 1 || bounds.size() != canvasSize)
+    return nullptr;
+
+  const Layer* layer = layers.front();
+  if (!layer->isImage() || layer->isTilemap() || layer->isReference() || !layer->isVisible() ||
+      layer->opacity() != 255 || layer->blendMode() != BlendMode::NORMAL) {
+    return nullptr;
+  }
+
+  const Cel* cel = layer->cel(frame);
+  if (!cel || cel->opacity() != 255 || cel->bounds() != bounds)
+    return nullptr;
+
+  ImageRef image = cel->imageRef();
+  if (!image || image->pixelFormat() != sprite->pixelFormat())
+    return nullptr;
+
+  return image;
+}
+
+FileOpROI::FileOpROI()
+  : m_document(nullptr)
+  , m_slice(nullptr)
+  , m_tag(nullptr)
+  , m_adjustByTag(false)
 {
 }
 
@@ -290,6 +449,8 @@ FileOpROI::FileOpROI(const Doc* doc,
   , m_slice(nullptr)
   , m_tag(nullptr)
   , m_framesSeq(framesSeq)
+  , m_tagName(tagName)
+  , m_adjustByTag(adjustByTag)
 {
   if (doc) {
     if (!sliceName.empty())
@@ -299,19 +460,28 @@ FileOpROI::FileOpROI(const Doc* doc,
     if (!tagName.empty())
       m_tag = doc->sprite()->tags().getByName(tagName);
 
-    if (m_tag) {
-      if (m_framesSeq.empty())
-        m_framesSeq.insert(m_tag->fromFrame(), m_tag->toFrame());
-      else if (adjustByTag)
-        m_framesSeq.displace(m_tag->fromFrame());
+    m_framesSeq = calculate_roi_frames(doc->sprite(), m_tag, m_framesSeq, adjustByTag);
+  }
+}
 
-      m_framesSeq = m_framesSeq.filter(std::max(0, m_tag->fromFrame()),
-                                       std::min(m_tag->toFrame(), doc->sprite()->lastFrame()));
-    }
-    // All frames if selected frames is empty
-    else if (m_framesSeq.empty())
-      m_framesSeq.insert(0, doc->sprite()->lastFrame());
+FramesSequence FileOpROI::framesToLoad(const Sprite* sprite) const
+{
+  const Tag* tag = (m_tagName.empty() ? nullptr : sprite->tags().getByName(m_tagName));
+  return calculate_roi_frames(sprite, tag, m_framesSeq, m_adjustByTag);
+}
+
+bool FileOpROI::isLayerToLoad(const Layer* layer) const
+{
+  if (m_layersToLoad.empty())
+    return true;
+
+  // The layer or one of its parent groups must be in the list
+  for (; layer && layer->parent(); layer = layer->parent()) {
+    if (std::find(m_layersToLoad.begin(), m_layersToLoad.end(), layer->name()) !=
+        m_layersToLoad.end())
+      return true;
   }
+  return false;
 }
 
 gfx::Rect FileOpROI::frameBounds(const frame_t frame) const
@@ -489,6 +659,10 @@ FileOp* FileOp::createLoadDocumentOperation(Context* context,
   if (flags & FILE_LOAD_ONE_FRAME)
     fop->m_oneframe = true;
 
+  // Load just the embedded preview
+  if (flags & FILE_LOAD_PREVIEW)
+    fop->m_preview = true;
+
   if (flags & FILE_LOAD_CREATE_PALETTE)
     fop->m_createPaletteFromRgba = true;
 
@@ -508,6 +682,57 @@ done:;
   return fop.release();
 }
 
+// static
+FileOp* FileOp::createLoadDocumentOperationFromMemory(Context* context,
+                                                      const std::string& filename,
+                                                      std::vector<uint8_t>&& data,
+                                                      const int flags,
+                                                      const FileOpConfig* config)
+{
+  std::unique_ptr<FileOp> fop(new FileOp(FileOpLoad, context, config));
+
+  LOG("FILE: Loading file \"%s\" from memory (%d bytes)\n", filename.c_str(), int(data.size()));
+
+  // Get the format through the file content or the extension of the
+  // filename
+  dio::FileFormat ff =
+    dio::detect_format_by_file_content_bytes(data.data(), int(std::min<size_t>(data.size(), 32)));
+  if (ff == dio::FileFormat::UNKNOWN)
+    ff = dio::detect_format_by_file_extension(filename);
+
+  fop->m_format = FileFormatsManager::instance()->getFileFormat(ff);
+  if (!fop->m_format || !fop->m_format->support(FILE_SUPPORT_LOAD) ||
+      !fop->m_format->support(FILE_SUPPORT_MEMORY)) {
+    fop->setError("%s can't load \"%s\" file from memory\n", get_app_name(), filename.c_str());
+    return fop.release();
+  }
+
+  fop->m_filename = filename;
+  fop->m_memory = true;
+  fop->m_memoryData = std::move(data);
+
+  // Just one file of the sequence is loaded
+  if (fop->m_format->support(FILE_SUPPORT_SEQUENCES)) {
+    fop->prepareForSequence();
+    fop->m_seq.flags = FILE_LOAD_SEQUENCE_NONE;
+    fop->m_seq.filename_list.push_back(filename);
+  }
+
+  if (flags & FILE_LOAD_ONE_FRAME)
+    fop->m_oneframe = true;
+
+  if (flags & FILE_LOAD_PREVIEW)
+    fop->m_preview = true;
+
+  if (flags & FILE_LOAD_CREATE_PALETTE)
+    fop->m_createPaletteFromRgba = true;
+
+  if (flags & FILE_LOAD_AVOID_BACKGROUND_LAYER)
+    fop->m_avoidBackgroundLayer = true;
+
+  return fop.release();
+}
+
 // static
 FileOp* FileOp::createSaveDocumentOperation(const Context* context,
                                             const FileOpROI& roi,
@@ -784,6 +1009,7 @@ void FileOp::operate(IFileOpProgress* progress)
   ASSERT(!isDone());
 
   m_progressInterface = progress;
+  const tracing::Histogram::Timer timer(m_type == FileOpLoad ? g_loadTime : g_saveTime);
 
   // Load //////////////////////////////////////////////////////////////////////
   if (m_type == FileOpLoad && m_format != NULL && m_format->support(FILE_SUPPORT_LOAD)) {
@@ -795,90 +1021,161 @@ void FileOp::operate(IFileOpProgress* progress)
       // Load the sequence
       frame_t frames(m_seq.filename_list.size());
       frame_t frame(0);
-      Image* old_image = nullptr;
       gfx::Size canvasSize(0, 0);
 
-      // TODO setPalette for each frame???
-      auto add_image = [&]() {
-        canvasSize |= m_seq.image->size();
+      // Last added cel with its own image (and the hash of the
+      // image) to link consecutive identical frames.
+      Cel* lastImageCel = nullptr;
+      uint64_t lastImageHash = 0;
 
-        m_seq.last_cel->data()->setImage(m_seq.image, m_seq.layer);
-        m_seq.layer->addCel(m_seq.last_cel);
+      // Adds the loaded m_seq.image/last_cel in the current frame
+      auto add_image = [&](Palette* palette, const uint64_t imageHash) {
+        canvasSize |= m_seq.canvas_size;
 
-        if (m_document->sprite()->palette(frame)->countDiff(m_seq.palette, NULL, NULL) > 0) {
-          m_seq.palette->setFrame(frame);
-          m_document->sprite()->setPalette(m_seq.palette, true);
+        if (lastImageCel && lastImageHash == imageHash &&
+            lastImageCel->position() == m_seq.last_cel->position() &&
+            doc::is_same_image(lastImageCel->image(), m_seq.image.get())) {
+          delete m_seq.last_cel;
+          m_seq.layer->addCel(Cel::MakeLink(frame, lastImageCel));
+        }
+        else {
+          m_seq.last_cel->data()->setImage(m_seq.image, m_seq.layer);
+          m_seq.layer->addCel(m_seq.last_cel);
+          lastImageCel = m_seq.last_cel;
+          lastImageHash = imageHash;
         }
 
-        old_image = m_seq.image.get();
+        // TODO setPalette for each frame???
+        if (m_document->sprite()->palette(frame)->countDiff(palette, NULL, NULL) > 0) {
+          palette->setFrame(frame);
+          m_document->sprite()->setPalette(palette, true);
+        }
+
+        m_document->sprite()->setFrameDuration(frame, m_seq.duration);
+
         m_seq.image.reset();
         m_seq.last_cel = NULL;
+        ++frame;
+        setProgress(1.0);
+        m_seq.progress_offset += m_seq.progress_fraction;
       };
 
       m_seq.has_alpha = false;
       m_seq.progress_offset = 0.0f;
       m_seq.progress_fraction = 1.0f / (double)frames;
 
-      auto it = m_seq.filename_list.begin(), end = m_seq.filename_list.end();
-      for (; it != end; ++it) {
-        m_filename = it->c_str();
+      // Call the "load" procedure to read the first bitmap (this
+      // creates the document).
+      m_filename = m_seq.filename_list[0];
+      const bool loadres = m_format->load(this);
+      if (!loadres)
+        setError("Error loading frame %d from file \"%s\"\n", frame + 1, m_filename.c_str());
 
-        // Call the "load" procedure to read the first bitmap.
-        bool loadres = m_format->load(this);
-        if (!loadres) {
-          setError("Error loading frame %d from file \"%s\"\n", frame + 1, m_filename.c_str());
-        }
-
-        // For the first frame...
-        if (!old_image) {
-          // Error reading the first frame
-          if (!loadres || !m_document || !m_seq.last_cel) {
-            m_seq.image.reset();
-            delete m_seq.last_cel;
-            delete m_document;
-            m_document = nullptr;
-            break;
-          }
-          // Read ok
-          else {
-            // Add the keyframe
-            add_image();
-          }
-        }
-        // For other frames
-        else {
-          // All done (or maybe not enough memory)
-          if (!loadres || !m_seq.last_cel) {
-            m_seq.image.reset();
-            delete m_seq.last_cel;
-            break;
-          }
-
-          // Compare the old frame with the new one
-#if USE_LINK // TODO this should be configurable through a check-box
-          if (count_diff_between_images(old_image, m_seq.image)) {
-            add_image();
+      // Error reading the first frame
+      if (!loadres || !m_document || !m_seq.last_cel) {
+        m_seq.image.reset();
+        delete m_seq.last_cel;
+        delete m_document;
+        m_document = nullptr;
+      }
+      // Read ok
+      else {
+        add_image(m_seq.palette,
+                  doc::calculate_image_hash64(m_seq.image.get(), m_seq.image->bounds()));
+
+        // Decode the other files in parallel (in small batches to
+        // avoid keeping too many decoded images in memory) and add
+        // them in order. Each file is decoded by its own FileOp
+        // (with its own temporary document).
+        struct FrameToLoad {
+          std::unique_ptr<FileOp> fop;
+          bool loaded = false;
+          uint64_t imageHash = 0;
+        };
+        const int batchSize = 2 * TaskScheduler::instance()->threads();
+        std::vector<FrameToLoad> batch;
+        bool failed = false;
+
+        while (frame < frames && !failed && !isStop()) {
+          batch.clear();
+          batch.resize(std::min<int>(batchSize, frames - frame));
+
+          doc::TaskGroup tasks;
+          for (int i = 0; i < int(batch.size()); ++i) {
+            FrameToLoad& frameToLoad = batch[i];
+            frameToLoad.fop.reset(new FileOp(FileOpLoad, m_context, &m_config));
+
+            FileOp* fop = frameToLoad.fop.get();
+            fop->m_format = m_format;
+            fop->m_filename = m_seq.filename_list[frame + i];
+            fop->m_seq.filename_list.push_back(fop->m_filename);
+            fop->m_oneframe = m_oneframe;
+            fop->m_createPaletteFromRgba = m_createPaletteFromRgba;
+            fop->m_avoidBackgroundLayer = m_avoidBackgroundLayer;
+            fop->m_roi = m_roi;
+            fop->prepareForSequence();
+            fop->m_seq.palette->makeBlack();
+
+            tasks.run([&frameToLoad] {
+              FileOp* fop = frameToLoad.fop.get();
+              try {
+                frameToLoad.loaded = fop->m_format->load(fop);
+              }
+              catch (const std::exception& ex) {
+                fop->setError("%s\n", ex.what());
+              }
+              if (frameToLoad.loaded && fop->m_seq.image) {
+                frameToLoad.imageHash = doc::calculate_image_hash64(fop->m_seq.image.get(),
+                                                                    fop->m_seq.image->bounds());
+              }
+            });
           }
-          // We don't need this image
-          else {
-            m_seq.image.reset();
 
-            // But add a link frame
-            m_seq.last_cel->image = image_index;
-            layer_add_frame(m_seq.layer, m_seq.last_cel);
-
-            m_seq.last_image = NULL;
-            m_seq.last_cel = NULL;
+          tasks.wait();
+
+          for (FrameToLoad& frameToLoad : batch) {
+            FileOp* fop = frameToLoad.fop.get();
+            m_filename = fop->m_filename;
+
+            if (fop->hasError())
+              setError("%s", fop->error().c_str());
+
+            if (!frameToLoad.loaded)
+              setError("Error loading frame %d from file \"%s\"\n", frame + 1, m_filename.c_str());
+            else if (fop->m_seq.image &&
+                     fop->m_seq.image->pixelFormat() != m_document->sprite()->pixelFormat()) {
+              setError("Error: image does not match color mode\n");
+              frameToLoad.loaded = false;
+            }
+
+            // All done (or maybe not enough memory)
+            const bool ok = (frameToLoad.loaded && fop->m_seq.last_cel);
+            if (ok) {
+              m_seq.image = fop->m_seq.image;
+              m_seq.last_cel = new Cel(frame, ImageRef(nullptr));
+              m_seq.last_cel->setPosition(fop->m_seq.last_cel->position());
+              m_seq.canvas_size = fop->m_seq.canvas_size;
+              if (fop->m_seq.partial_images)
+                m_seq.partial_images = true;
+              if (fop->m_seq.has_alpha)
+                m_seq.has_alpha = true;
+
+              add_image(fop->m_seq.palette, frameToLoad.imageHash);
+            }
+
+            // Delete the temporary document and cel
+            fop->m_seq.image.reset();
+            delete fop->m_seq.last_cel;
+            fop->m_seq.last_cel = nullptr;
+            delete fop->m_document;
+            fop->m_document = nullptr;
+
+            if (!ok) {
+              failed = true;
+              break;
+            }
           }
-#else
-          add_image();
-#endif
         }
-
-        m_document->sprite()->setFrameDuration(frame, m_seq.duration);
-
-        ++frame;
-        m_seq.progress_offset += m_seq.progress_fraction;
       }
       m_filename = *m_seq.filename_list.begin();
 
@@ -886,8 +1183,21 @@ void FileOp::operate(IFileOpProgress* progress)
       if (m_document) {
         // Configure the layer as the 'Background'. Only if background layers
         // are welcome.
-        if (!m_seq.has_alpha && !m_avoidBackgroundLayer)
+        if (!m_seq.has_alpha && !m_avoidBackgroundLayer) {
+          // The Background layer needs cels that cover the whole
+          // canvas (the pixels outside the ROI bounds are zero).
+          if (m_seq.partial_images) {
+            for (auto it = m_seq.layer->getCelBegin(); it != m_seq.layer->getCelEnd(); ++it) {
+              Cel* cel = *it;
+              ImageRef image(Image::create(cel->image()->pixelFormat(), canvasSize.w, canvasSize.h));
+              image->clear(0);
+              image->copy(cel->image(), gfx::Clip(cel->position(), cel->image()->bounds()));
+              cel->data()->setImage(image, m_seq.layer);
+              cel->setPosition(0, 0);
+            }
+          }
           m_seq.layer->configureAsBackground();
+        }
 
         // Set the final canvas size (as the bigger loaded
         // frame/image).
@@ -946,68 +1256,129 @@ void FileOp::operate(IFileOpProgress* progress)
 
       Sprite* sprite = m_document->sprite();
 
-      // Create a temporary bitmap
-      m_seq.image.reset(
-        Image::create(sprite->pixelFormat(), m_roi.fileCanvasSize().w, m_roi.fileCanvasSize().h));
-
       m_seq.progress_offset = 0.0f;
       m_seq.progress_fraction = 1.0f / (double)sprite->totalFrames();
 
-      // For each frame in the sprite.
-      render::Render render;
-      render.setNewBlend(m_config.newBlend);
+      // Frames can be rendered and encoded in parallel (each one
+      // with its own FileOp) except when they are resized on the fly,
+      // as resize_image() uses the RgbMap of the sprite.
+      const bool parallel = (m_seq.filename_list.size() > 1 &&
+                             (!m_abstractImage ||
+                              m_abstractImage->scale() == gfx::PointF(1.0, 1.0)));
 
-      frame_t outputFrame = 0;
-      for (frame_t frame : m_roi.framesSequence()) {
-        gfx::Rect bounds = m_roi.frameBounds(frame);
-        if (bounds.isEmpty())
-          continue; // Skip frame because there is no slice key
+      std::unique_ptr<SequenceManifest> manifest;
+      if (m_incremental && !m_memory)
+        manifest = std::make_unique<SequenceManifest>(m_seq.filename_list[0]);
 
-        if (m_abstractImage) {
-          m_abstractImage->setSpecSize(m_roi.fileCanvasSize(), bounds.size());
-        }
+      if (parallel) {
+        saveSequenceInParallel(manifest.get());
+      }
+      else {
+        // Temporary bitmap to render frames (it's created only if it's
+        // needed), and the last frame/bounds rendered in it
+        ImageRef renderImage;
+        frame_t renderedFrame = -1;
+        gfx::Rect renderedBounds;
+
+        // For each frame in the sprite.
+        render::Render render;
+        render.setNewBlend(m_config.newBlend);
+        render.setParallelRender(true);
+
+        frame_t outputFrame = 0;
+        for (frame_t frame : m_roi.framesSequence()) {
+          gfx::Rect bounds = m_roi.frameBounds(frame);
+          if (bounds.isEmpty())
+            continue; // Skip frame because there is no slice key
+
+          if (m_abstractImage) {
+            m_abstractImage->setSpecSize(m_roi.fileCanvasSize(), bounds.size());
+          }
 
-        // Render the (unscaled) sequenced image.
-        render.renderSprite(m_seq.image.get(), sprite, frame, gfx::Clip(gfx::Point(0, 0), bounds));
+          // Save the cel image directly if it's possible, or render the
+          // (unscaled) sequenced image.
+          m_seq.image = get_cel_image_to_save(sprite, frame, bounds, m_roi.fileCanvasSize());
+          if (!m_seq.image) {
+            if (!renderImage) {
+              renderImage.reset(Image::create(sprite->pixelFormat(),
+                                              m_roi.fileCanvasSize().w,
+                                              m_roi.fileCanvasSize().h));
+            }
+            m_seq.image = renderImage;
+
+            // Held frames (e.g. linked cels) are rendered only once
+            if (renderedFrame < 0 || renderedBounds != bounds ||
+                !sprite->hasSameCels(renderedFrame, frame)) {
+              if (!m_renderCache || !m_renderCache->render(m_seq.image.get(), frame, bounds)) {
+                render.renderSprite(m_seq.image.get(),
+                                    sprite,
+                                    frame,
+                                    gfx::Clip(gfx::Point(0, 0), bounds));
+              }
+              renderedFrame = frame;
+              renderedBounds = bounds;
+            }
+          }
 
-        bool save = true;
+          bool save = true;
 
-        // Check if we have to ignore empty frames
-        if (m_ignoreEmpty && !sprite->isOpaque() && doc::is_empty_image(m_seq.image.get())) {
-          save = false;
-        }
+          // Check if we have to ignore empty frames
+          if (m_ignoreEmpty && !sprite->isOpaque() && doc::is_empty_image(m_seq.image.get())) {
+            save = false;
+          }
 
-        if (save) {
-          // Setup the palette.
-          sprite->palette(frame)->copyColorsTo(m_seq.palette);
+          if (save) {
+            // Setup the palette.
+            sprite->palette(frame)->copyColorsTo(m_seq.palette);
+
+            // Setup the filename to be used.
+            m_filename = m_seq.filename_list[outputFrame];
+
+            // Skip the frame if it's the same as in the previous save
+            uint64_t hash = 0;
+            if (manifest) {
+              hash = sequence_image_hash(m_seq.image.get(),
+                                         m_seq.palette,
+                                         (m_abstractImage ? m_abstractImage->scale() :
+                                                            gfx::PointF(1.0, 1.0)));
+              save = !manifest->isUnchanged(m_filename, hash);
+            }
+          }
 
-          // Setup the filename to be used.
-          m_filename = m_seq.filename_list[outputFrame];
+          if (save) {
+            // Make directories
+            if (!m_memory)
+              makeDirectories();
 
-          // Make directories
-          makeDirectories();
+            // Call the "save" procedure... did it fail?
+            if (!m_format->save(this)) {
+              setError("Error saving frame %d in the file \"%s\"\n",
+                       outputFrame + 1,
+                       m_filename.c_str());
+              break;
+            }
 
-          // Call the "save" procedure... did it fail?
-          if (!m_format->save(this)) {
-            setError("Error saving frame %d in the file \"%s\"\n",
-                     outputFrame + 1,
-                     m_filename.c_str());
-            break;
+            if (manifest)
+              manifest->set(m_filename, hash);
           }
-        }
 
-        m_seq.progress_offset += m_seq.progress_fraction;
-        ++outputFrame;
+          m_seq.progress_offset += m_seq.progress_fraction;
+          ++outputFrame;
+        }
       }
 
       m_filename = *m_seq.filename_list.begin();
 
       // Destroy the image
       m_seq.image.reset();
+
+      if (manifest && !hasError())
+        manifest->save();
     }
     // Direct save to a file.
     else {
-      makeDirectories();
+      if (!m_memory)
+        makeDirectories();
 
       if (m_abstractImage) {
         m_abstractImage->setSpecSize(m_roi.fileCanvasSize(), m_roi.fileCanvasSize());
@@ -1036,11 +1407,176 @@ void FileOp::operate(IFileOpProgress* progress)
 #endif
   }
 
+  // Count the bytes read/written (all the files of a sequence)
+  if (!hasError()) {
+    int64_t bytes = 0;
+    if (m_memory)
+      bytes = int64_t(m_memoryData.size());
+    else if (m_seq.filename_list.empty())
+      bytes = int64_t(base::file_size(m_filename));
+    else {
+      for (const auto& fn : m_seq.filename_list)
+        bytes += int64_t(base::file_size(fn));
+    }
+    (m_type == FileOpLoad ? g_loadedBytes : g_savedBytes).add(bytes);
+  }
+
   // Progress = 100%
   setProgress(1.0f);
 }
 
 // After mark the 'fop' as 'done' you must to free it calling fop_free().
+void FileOp::saveSequenceInParallel(SequenceManifest* manifest)
+{
+  const Sprite* sprite = m_document->sprite();
+
+  struct FrameToSave {
+    frame_t frame;
+    frame_t outputFrame;
+    gfx::Rect bounds;
+    std::unique_ptr<FileOp> fop;
+    bool saved = true;
+    bool skipped = false;        // Same image as in the previous save
+    bool sameAsPrevious = false; // Same render as the previous frame
+    uint64_t hash = 0;
+  };
+  std::vector<FrameToSave> frames;
+
+  frame_t outputFrame = 0;
+  for (frame_t frame : m_roi.framesSequence()) {
+    const gfx::Rect bounds = m_roi.frameBounds(frame);
+    if (bounds.isEmpty())
+      continue; // Skip frame because there is no slice key
+
+    FrameToSave frameToSave{ frame, outputFrame, bounds };
+
+    // Held frames (e.g. linked cels) are rendered only once
+    if (!frames.empty() && frames.back().bounds == bounds &&
+        sprite->hasSameCels(frames.back().frame, frame)) {
+      frameToSave.sameAsPrevious = true;
+    }
+
+    frames.push_back(std::move(frameToSave));
+    ++outputFrame;
+  }
+
+  // Frames are saved in small batches to limit the number of
+  // rendered images in memory, and errors are reported in order.
+  const int batchSize = 2 * TaskScheduler::instance()->threads();
+  bool failed = false;
+
+  for (int i = 0; i < int(frames.size()) && !failed && !isStop(); i += batchSize) {
+    const int n = std::min<int>(batchSize, int(frames.size()) - i);
+
+    for (int j = i; j < i + n; ++j) {
+      FrameToSave& frameToSave = frames[j];
+      frameToSave.fop.reset(new FileOp(FileOpSave, m_context, &m_config));
+
+      FileOp* fop = frameToSave.fop.get();
+      fop->m_format = m_format;
+      fop->m_document = m_document;
+      fop->m_roi = m_roi;
+      fop->m_filename = m_seq.filename_list[frameToSave.outputFrame];
+      fop->m_seq.filename_list.push_back(fop->m_filename);
+      fop->prepareForSequence();
+      fop->m_formatOptions = m_formatOptions;
+      fop->m_seq.frame = frameToSave.frame;
+      if (m_format->support(FILE_ENCODE_ABSTRACT_IMAGE)) {
+        fop->makeAbstractImage();
+        fop->m_abstractImage->setSpecSize(m_roi.fileCanvasSize(), frameToSave.bounds.size());
+      }
+      fop->makeDirectories();
+    }
+
+    // Runs of frames [begin, end) with the same render, each run is
+    // rendered once and saved in its own task.
+    std::vector<std::pair<int, int>> runs;
+    for (int j = i; j < i + n; ++j) {
+      if (runs.empty() || !frames[j].sameAsPrevious)
+        runs.push_back(std::make_pair(j, j + 1));
+      else
+        runs.back().second = j + 1;
+    }
+
+    doc::TaskGroup tasks;
+    for (const auto& run : runs) {
+      tasks.run([this, sprite, manifest, run, &frames] {
+        FrameToSave& first = frames[run.first];
+        try {
+          // Render the (unscaled) sequenced image.
+          ImageRef image(Image::create(sprite->pixelFormat(),
+                                       m_roi.fileCanvasSize().w,
+                                       m_roi.fileCanvasSize().h));
+          if (!m_renderCache ||
+              !m_renderCache->render(image.get(), first.frame, first.bounds)) {
+            render::Render render;
+            render.setNewBlend(m_config.newBlend);
+            render.renderSprite(image.get(),
+                                sprite,
+                                first.frame,
+                                gfx::Clip(gfx::Point(0, 0), first.bounds));
+          }
+
+          // Check if we have to ignore empty frames
+          const bool save = (!m_ignoreEmpty || sprite->isOpaque() ||
+                             !doc::is_empty_image(image.get()));
+
+          for (int j = run.first; j < run.second && save; ++j) {
+            FrameToSave& frameToSave = frames[j];
+            FileOp* fop = frameToSave.fop.get();
+            fop->m_seq.image = image;
+            sprite->palette(frameToSave.frame)->copyColorsTo(fop->m_seq.palette);
+            if (manifest) {
+              frameToSave.hash = sequence_image_hash(image.get(),
+                                                     fop->m_seq.palette,
+                                                     gfx::PointF(1.0, 1.0));
+              frameToSave.skipped = manifest->isUnchanged(fop->m_filename, frameToSave.hash);
+            }
+            if (!frameToSave.skipped)
+              frameToSave.saved = m_format->save(fop);
+            fop->m_seq.image.reset();
+            if (!frameToSave.saved)
+              break;
+          }
+        }
+        catch (const std::exception& ex) {
+          first.fop->setError("%s\n", ex.what());
+          first.saved = false;
+        }
+      });
+    }
+    tasks.wait();
+
+    for (int j = i; j < i + n; ++j) {
+      FrameToSave& frameToSave = frames[j];
+      FileOp* fop = frameToSave.fop.get();
+
+      if (!failed) {
+        if (fop->hasError())
+          setError("%s", fop->error().c_str());
+
+        if (!frameToSave.saved) {
+          setError("Error saving frame %d in the file \"%s\"\n",
+                   frameToSave.outputFrame + 1,
+                   fop->m_filename.c_str());
+          failed = true;
+        }
+        else {
+          if (manifest && !frameToSave.skipped)
+            manifest->set(fop->m_filename, frameToSave.hash);
+
+          setProgress(1.0);
+          m_seq.progress_offset += m_seq.progress_fraction;
+        }
+      }
+
+      // The document is owned by this FileOp
+      fop->m_document = nullptr;
+      frameToSave.fop.reset();
+    }
+  }
+}
+
 void FileOp::done()
 {
   // Finally done.
@@ -1273,8 +1809,25 @@ void FileOp::sequenceGetAlpha(int index, int* a) const
     *a = 0;
 }
 
+gfx::Rect FileOp::loadBounds(const gfx::Size& canvasSize) const
+{
+  const gfx::Rect canvas(canvasSize);
+  const gfx::Rect bounds = (m_roi.bounds() & canvas);
+  return (bounds.isEmpty() ? canvas : bounds);
+}
+
 ImageRef FileOp::sequenceImageToLoad(const PixelFormat pixelFormat, const int w, const int h)
 {
+  return sequenceImageToLoad(pixelFormat, w, h, gfx::Rect(0, 0, w, h));
+}
+
+ImageRef FileOp::sequenceImageToLoad(const PixelFormat pixelFormat,
+                                     const int w,
+                                     const int h,
+                                     const gfx::Rect& bounds)
+{
+  ASSERT(gfx::Rect(0, 0, w, h).contains(bounds));
+
   Sprite* sprite;
 
   // Create the image
@@ -1316,8 +1869,12 @@ ImageRef FileOp::sequenceImageToLoad(const PixelFormat pixelFormat, const int w,
   }
 
   // Create a bitmap
-  m_seq.image.reset(Image::create(pixelFormat, w, h));
+  m_seq.image.reset(Image::create(pixelFormat, bounds.w, bounds.h));
   m_seq.last_cel = new Cel(m_seq.frame++, ImageRef(nullptr));
+  m_seq.last_cel->setPosition(bounds.origin());
+  m_seq.canvas_size = gfx::Size(w, h);
+  if (bounds != gfx::Rect(0, 0, w, h))
+    m_seq.partial_images = true;
 
   return m_seq.image;
 }
@@ -1441,13 +1998,17 @@ FileOp::FileOp(FileOpType type, Context* context, const FileOpConfig* config)
   , m_format(nullptr)
   , m_context(context)
   , m_document(nullptr)
+  , m_memory(false)
   , m_progress(0.0)
   , m_progressInterface(nullptr)
   , m_done(false)
   , m_stop(false)
   , m_oneframe(false)
+  , m_preview(false)
   , m_createPaletteFromRgba(false)
   , m_ignoreEmpty(false)
+  , m_incremental(false)
+  , m_renderCache(nullptr)
   , m_avoidBackgroundLayer(false)
   , m_embeddedColorProfile(false)
   , m_embeddedGridBounds(false)
@@ -1467,6 +2028,7 @@ FileOp::FileOp(FileOpType type, Context* context, const FileOpConfig* config)
   m_seq.frame = frame_t(0);
   m_seq.layer = nullptr;
   m_seq.last_cel = nullptr;
+  m_seq.partial_images = false;
   m_seq.duration = 100;
   m_seq.flags = 0;
 }
@@ -1477,6 +2039,91 @@ void FileOp::prepareForSequence()
   m_formatOptions.reset();
 }
 
+void FileOp::saveInMemory()
+{
+  ASSERT(m_type == FileOpSave);
+  ASSERT(m_format);
+
+  if (!m_format->support(FILE_SUPPORT_MEMORY)) {
+    setError("%s can't save \"%s\" file in memory\n", get_app_name(), m_filename.c_str());
+    return;
+  }
+  if (m_seq.filename_list.size() > 1) {
+    setError("Cannot save %d files in memory\n", int(m_seq.filename_list.size()));
+    return;
+  }
+
+  m_memory = true;
+  m_memoryData.clear();
+  m_dataFilename.clear();
+}
+
+base::FileHandle FileOp::openFileForReading()
+{
+  if (!m_memory)
+    return base::open_file_with_exception(m_filename, "rb");
+
+  FILE* f = nullptr;
+  if (!m_memoryData.empty()) {
+#ifdef _WIN32
+    // There is no fmemopen() on Windows, we use a temporary file
+    // (deleted automatically when it's closed)
+    f = std::tmpfile();
+    if (f) {
+      std::fwrite(m_memoryData.data(), 1, m_memoryData.size(), f);
+      std::rewind(f);
+    }
+#else
+    f = fmemopen(m_memoryData.data(), m_memoryData.size(), "rb");
+#endif
+  }
+  if (!f)
+    throw base::Exception("Cannot read \"%s\" from memory", m_filename.c_str());
+  return base::FileHandle(f, std::fclose);
+}
+
+base::FileHandle FileOp::openFileForWriting()
+{
+  if (!m_memory)
+    return base::open_file_with_exception_sync_on_close(m_filename, "wb");
+
+  m_memoryData.clear();
+
+#ifdef _WIN32
+  FILE* f = std::tmpfile();
+  if (!f)
+    throw base::Exception("Cannot write \"%s\" in memory", m_filename.c_str());
+
+  // Copy the temporary file content when the handle is closed
+  return base::FileHandle(f, [this](FILE* f) {
+    std::fseek(f, 0, SEEK_END);
+    const long size = std::ftell(f);
+    std::rewind(f);
+    m_memoryData.resize(std::max(0l, size));
+    m_memoryData.resize(std::fread(m_memoryData.data(), 1, m_memoryData.size(), f));
+    std::fclose(f);
+  });
+#else
+  struct Buffer {
+    char* data = nullptr;
+    size_t size = 0;
+  };
+  auto buffer = std::make_shared<Buffer>();
+  FILE* f = open_memstream(&buffer->data, &buffer->size);
+  if (!f)
+    throw base::Exception("Cannot write \"%s\" in memory", m_filename.c_str());
+
+  return base::FileHandle(f, [this, buffer](FILE* f) {
+    // The size of the buffer is the current position (formats can
+    // seek back to write headers)
+    std::fseek(f, 0, SEEK_END);
+    std::fclose(f);
+    m_memoryData.assign((const uint8_t*)buffer->data, (const uint8_t*)buffer->data + buffer->size);
+    std::free(buffer->data);
+  });
+#endif
+}
+
 void FileOp::makeDirectories()
 {
   std::string dir = base::get_file_path(m_filename);
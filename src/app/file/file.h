@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2023  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -14,6 +14,7 @@
 #include "app/file/file_op_config.h"
 #include "app/file/format_options.h"
 #include "app/pref/preferences.h"
+#include "base/file_handle.h"
 #include "base/paths.h"
 #include "doc/frame.h"
 #include "doc/frames_sequence.h"
@@ -21,10 +22,12 @@
 #include "doc/pixel_format.h"
 #include "os/color_space.h"
 
+#include <cstdint>
 #include <cstdio>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <vector>
 
 // Flags for FileOp::createLoadDocumentOperation()
 #define FILE_LOAD_SEQUENCE_NONE          0x00000001
@@ -35,6 +38,7 @@
 #define FILE_LOAD_DATA_FILE              0x00000020
 #define FILE_LOAD_CREATE_PALETTE         0x00000040
 #define FILE_LOAD_AVOID_BACKGROUND_LAYER 0x00000080
+#define FILE_LOAD_PREVIEW                0x00000100
 
 namespace doc {
 class Tag;
@@ -54,6 +58,8 @@ namespace app {
 
 class Context;
 class FileFormat;
+class FrameRenderCache;
+class SequenceManifest;
 
 using namespace doc;
 
@@ -77,6 +83,7 @@ public:
             const bool adjustByTag);
 
   const Doc* document() const { return m_document; }
+  const gfx::Rect& bounds() const { return m_bounds; }
   doc::Slice* slice() const { return m_slice; }
   doc::Tag* tag() const { return m_tag; }
   doc::frame_t fromFrame() const { return m_framesSeq.firstFrame(); }
@@ -85,6 +92,21 @@ public:
 
   doc::frame_t frames() const { return (doc::frame_t)m_framesSeq.size(); }
 
+  // In load operations (without document) the tag is specified by
+  // name, because it's known only when the file is being decoded.
+  const std::string& tagName() const { return m_tagName; }
+
+  // Frames of the given sprite that must be loaded (the tag and
+  // frames of this ROI are resolved with the sprite tags).
+  doc::FramesSequence framesToLoad(const doc::Sprite* sprite) const;
+
+  // Names of the layers that must be loaded in a load operation
+  // (empty = all layers). Cels of other layers can be skipped
+  // (children of the given groups are loaded too).
+  const std::vector<std::string>& layersToLoad() const { return m_layersToLoad; }
+  void setLayersToLoad(const std::vector<std::string>& layers) { m_layersToLoad = layers; }
+  bool isLayerToLoad(const doc::Layer* layer) const;
+
   // Returns an empty rectangle only when exporting a slice and the
   // slice doesn't have a slice key in this specific frame.
   gfx::Rect frameBounds(const frame_t frame) const;
@@ -100,6 +122,9 @@ private:
   doc::Slice* m_slice;
   doc::Tag* m_tag;
   doc::FramesSequence m_framesSeq;
+  std::string m_tagName;
+  bool m_adjustByTag;
+  std::vector<std::string> m_layersToLoad;
 };
 
 // Used by file formats with FILE_ENCODE_ABSTRACT_IMAGE flag, to
@@ -134,7 +159,9 @@ public:
   virtual const uint8_t* getScanline(int y) const = 0;
 
   // In case that the encoder supports animation and needs to render
-  // a full frame renders.
+  // a full frame renders. Several frames can be rendered at the same
+  // time (from different threads) only if the frames don't need to
+  // be resized (i.e. the frameBounds size is the spec() size).
   virtual void renderFrame(const doc::frame_t frame,
                            const gfx::Rect& frameBounds,
                            doc::Image* dst) const = 0;
@@ -159,16 +186,43 @@ public:
                                              const std::string& filenameFormat,
                                              const bool ignoreEmptyFrames);
 
+  // Loads the file from the given data instead of a file in disk.
+  // The filename is used to get the file format (when it cannot be
+  // detected from the data) and as the name of the document.
+  static FileOp* createLoadDocumentOperationFromMemory(Context* context,
+                                                       const std::string& filename,
+                                                       std::vector<uint8_t>&& data,
+                                                       const int flags,
+                                                       const FileOpConfig* config = nullptr);
+
   static bool checkIfFormatSupportResizeOnTheFly(const std::string& filename);
 
   ~FileOp();
 
   bool isSequence() const { return !m_seq.filename_list.empty(); }
   bool isOneFrame() const { return m_oneframe; }
+  bool isPreview() const { return m_preview; }
   bool preserveColorProfile() const { return m_config.preserveColorProfile; }
   const FileFormat* fileFormat() const { return m_format; }
 
   const std::string& filename() const { return m_filename; }
+
+  // Saves the file in memoryData() instead of a file in disk (it
+  // must be called before operate()). Only formats with the
+  // FILE_SUPPORT_MEMORY flag can be saved in memory, and only if
+  // the result is just one file.
+  void saveInMemory();
+
+  // True if the file is read from/written in memoryData().
+  bool isMemory() const { return m_memory; }
+  const std::vector<uint8_t>& memoryData() const { return m_memoryData; }
+
+  // Opens the file to load/save (the filename() file in disk or
+  // memoryData()). Formats with FILE_SUPPORT_MEMORY must use these
+  // functions. They throw an exception if the file cannot be
+  // opened.
+  base::FileHandle openFileForReading();
+  base::FileHandle openFileForWriting();
   const base::paths& filenames() const { return m_seq.filename_list; }
   Context* context() const { return m_context; }
   Doc* document() const { return m_document; }
@@ -181,6 +235,17 @@ public:
 
   const FileOpROI& roi() const { return m_roi; }
 
+  // Sets the region of interest of a load operation (it must be
+  // called before operate()). Formats that support it can skip the
+  // pixels outside the ROI bounds and the frames after the last ROI
+  // frame.
+  void setLoadROI(const FileOpROI& roi) { m_roi = roi; }
+
+  // Returns the region of a canvas of the given size that must be
+  // loaded (the whole canvas if the ROI doesn't have bounds or they
+  // are outside the canvas).
+  gfx::Rect loadBounds(const gfx::Size& canvasSize) const;
+
   // Creates a new document with the given sprite.
   void createDocument(Sprite* spr);
   void operate(IFileOpProgress* progress = nullptr);
@@ -239,6 +304,9 @@ public:
   void sequenceSetAlpha(int index, int a);
   void sequenceGetAlpha(int index, int* a) const;
   ImageRef sequenceImageToLoad(PixelFormat pixelFormat, int w, int h);
+  // Creates an image only for the given region of the w x h canvas
+  // (see loadBounds()), the decoder must fill only those pixels.
+  ImageRef sequenceImageToLoad(PixelFormat pixelFormat, int w, int h, const gfx::Rect& bounds);
   const ImageRef sequenceImageToSave() const { return m_seq.image; }
   const Palette* sequenceGetPalette() const { return m_seq.palette; }
   bool sequenceGetHasAlpha() const { return m_seq.has_alpha; }
@@ -254,6 +322,14 @@ public:
   FileAbstractImage* abstractImageToSave();
   void setOnTheFlyScale(const gfx::PointF& scale);
 
+  // Saves only the frames of a sequence that are different from the
+  // previous save (see SequenceManifest).
+  void setIncremental(const bool state) { m_incremental = state; }
+
+  // Uses the renders of the given cache (shared with other FileOps
+  // saving the same sprite) to save the frames of a sequence.
+  void setRenderCache(FrameRenderCache* cache) { m_renderCache = cache; }
+
   const std::string& error() const { return m_error; }
   void setError(const char* error, ...);
   bool hasError() const { return !m_error.empty(); }
@@ -290,6 +366,8 @@ private:
   std::string m_dataFilename; // File-name for a special XML .aseprite-data where extra sprite data
                               // can be stored
   FileOpROI m_roi;
+  bool m_memory;                     // True if the file is in m_memoryData
+  std::vector<uint8_t> m_memoryData; // File content to load/save in memory
 
   // Shared fields between threads.
   mutable std::mutex m_mutex; // Mutex to access to the next two fields.
@@ -302,8 +380,12 @@ private:
   bool m_oneframe;                    // Load just one frame (in formats
                                       // that support animation like
                                       // GIF/FLI/ASE).
+  bool m_preview;                     // Load just the embedded preview
+                                      // (if the file has one).
   bool m_createPaletteFromRgba;
   bool m_ignoreEmpty;
+  bool m_incremental;
+  FrameRenderCache* m_renderCache;
   bool m_avoidBackgroundLayer;
 
   // True if the file contained a color profile when it was loaded.
@@ -330,6 +412,8 @@ private:
     bool has_alpha;
     LayerImage* layer;
     Cel* last_cel;
+    gfx::Size canvas_size; // Canvas size of the last loaded image.
+    bool partial_images;   // True if some image doesn't cover its canvas.
     int duration;
     // Flags after the user choose what to do with the sequence.
     int flags;
@@ -339,6 +423,7 @@ private:
   std::unique_ptr<FileAbstractImageImpl> m_abstractImage;
 
   void prepareForSequence();
+  void saveSequenceInParallel(SequenceManifest* manifest);
   void makeAbstractImage();
   void makeDirectories();
 };
@@ -351,6 +436,19 @@ base::paths get_writable_extensions(const int requiredFormatFlag = 0);
 Doc* load_document(Context* context, const std::string& filename);
 int save_document(Context* context, Doc* document);
 
+// Loads/saves a document from/in memory. The filename is used to get
+// the file format (when it cannot be detected from the data) and as
+// the document name. Only formats with FILE_SUPPORT_MEMORY are
+// supported.
+Doc* load_document_from_memory(Context* context,
+                               const std::string& filename,
+                               std::vector<uint8_t>&& data,
+                               const int flags);
+int save_document_in_memory(Context* context,
+                            const FileOpROI& roi,
+                            const std::string& filename,
+                            std::vector<uint8_t>& output);
+
 // Returns true if the given filename contains a file extension that
 // can be used to save only static images (i.e. animations are saved
 // as sequence of files).
@@ -0,0 +1,320 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/context.h"
+#include "app/doc.h"
+#include "app/file/file.h"
+#include "app/file/file_format.h"
+#include "app/file/file_formats_manager.h"
+#include "base/file_handle.h"
+#include "base/fs.h"
+#include "dio/detect_format.h"
+#include "doc/cel.h"
+#include "doc/image.h"
+#include "doc/layer.h"
+#include "doc/primitives.h"
+#include "doc/sprite.h"
+#include "fmt/format.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace app;
+using namespace doc;
+
+namespace {
+
+// Synthetic sprite parameters (benchmark arguments).
+struct SpriteParams {
+  int w, h, layers, frames;
+
+  explicit SpriteParams(const benchmark::State& state)
+    : w(int(state.range(0)))
+    , h(int(state.range(1)))
+    , layers(int(state.range(2)))
+    , frames(int(state.range(3)))
+  {
+  }
+
+  // Bytes of raw RGBA pixels in the sprite, used to report the
+  // throughput independently of the compression ratio of each
+  // format.
+  int64_t rawBytes() const { return int64_t(w) * h * 4 * layers * frames; }
+};
+
+FileFormat* get_file_format(const std::string& ext)
+{
+  return FileFormatsManager::instance()->getFileFormat(
+    dio::detect_format_by_file_extension("file." + ext));
+}
+
+std::string bench_filename(const std::string& ext)
+{
+  return base::join_path(base::get_temp_path(), "aseprite-file-benchmark." + ext);
+}
+
+// Fills the image with runs of random colors, so it compresses like
+// pixel art does (neither a flat color nor incompressible noise).
+void fill_image(Image* image, std::mt19937& rnd)
+{
+  color_t c = 0;
+  for (int y = 0; y < image->height(); ++y) {
+    for (int x = 0; x < image->width(); ++x) {
+      if ((rnd() & 7) == 0)
+        c = rgba(rnd() & 0xff, rnd() & 0xff, rnd() & 0xff, (rnd() & 1) ? 255 : 128);
+      put_pixel_fast<RgbTraits>(image, x, y, c);
+    }
+  }
+}
+
+Doc* create_doc(Context* ctx, const SpriteParams& p)
+{
+  std::mt19937 rnd(p.w * p.h + p.layers * p.frames);
+  auto spr = std::make_unique<Sprite>(ImageSpec(ColorMode::RGB, p.w, p.h), 256);
+  spr->setTotalFrames(frame_t(p.frames));
+
+  for (int i = 0; i < p.layers; ++i) {
+    auto layer = new LayerImage(spr.get());
+    layer->setName(fmt::format("Layer {}", i + 1));
+    spr->root()->addLayer(layer);
+
+    for (frame_t frame = 0; frame < p.frames; ++frame) {
+      ImageRef image(Image::create(spr->spec()));
+      fill_image(image.get(), rnd);
+      layer->addCel(new Cel(frame, image));
+    }
+  }
+
+  Doc* doc = new Doc(spr.release());
+  doc->setContext(ctx);
+  return doc;
+}
+
+bool save_doc(Context* ctx, Doc* doc, const std::string& fn)
+{
+  std::unique_ptr<FileOp> fop(FileOp::createSaveDocumentOperation(
+    ctx,
+    FileOpROI(doc, doc->sprite()->bounds(), "", "", FramesSequence(), false),
+    fn,
+    "",
+    false));
+  if (!fop)
+    return false;
+
+  fop->operate();
+  fop->done();
+  return !fop->hasError();
+}
+
+bool load_doc(Context* ctx, const std::string& fn)
+{
+  std::unique_ptr<FileOp> fop(
+    FileOp::createLoadDocumentOperation(ctx, fn, FILE_LOAD_SEQUENCE_NONE));
+  if (!fop)
+    return false;
+
+  fop->operate();
+  fop->done();
+
+  std::unique_ptr<Doc> doc(fop->releaseDocument());
+  if (doc)
+    doc->close();
+  return doc && !fop->hasError();
+}
+
+// PSD files can only be loaded, so we write a flat RGBA .psd file
+// with raw (uncompressed) planar channels to benchmark its decoder.
+bool write_flat_psd(const SpriteParams& p, const std::string& fn)
+{
+  base::FileHandle handle(base::open_file_with_exception(fn, "wb"));
+  FILE* f = handle.get();
+
+  auto write16 = [f](int v) {
+    fputc((v >> 8) & 0xff, f);
+    fputc(v & 0xff, f);
+  };
+  auto write32 = [f](int v) {
+    fputc((v >> 24) & 0xff, f);
+    fputc((v >> 16) & 0xff, f);
+    fputc((v >> 8) & 0xff, f);
+    fputc(v & 0xff, f);
+  };
+
+  fwrite("8BPS", 1, 4, f);
+  write16(1); // Version
+  write16(0); // Reserved (6 bytes)
+  write32(0);
+  write16(4); // Channels (RGBA)
+  write32(p.h);
+  write32(p.w);
+  write16(8); // Depth
+  write16(3); // RGB color mode
+  write32(0); // Color mode data
+  write32(0); // Image resources
+  write32(0); // Layer and mask information
+  write16(0); // Raw image data
+
+  std::mt19937 rnd(p.w * p.h);
+  ImageRef image(Image::create(IMAGE_RGB, p.w, p.h));
+  fill_image(image.get(), rnd);
+
+  std::vector<uint8_t> scanline(p.w);
+  for (int shift = 0; shift < 32; shift += 8) {
+    for (int y = 0; y < p.h; ++y) {
+      auto src = (const RgbTraits::pixel_t*)image->getPixelAddress(0, y);
+      for (int x = 0; x < p.w; ++x)
+        scanline[x] = (src[x] >> shift) & 0xff;
+      fwrite(scanline.data(), 1, scanline.size(), f);
+    }
+  }
+  return !ferror(f);
+}
+
+// Formats without layers/frames support get a flattened one-frame
+// sprite, so they aren't saved as sequences of files.
+SpriteParams supported_params(const std::string& ext, SpriteParams p)
+{
+  FileFormat* format = get_file_format(ext);
+  if (!format->support(FILE_SUPPORT_LAYERS))
+    p.layers = 1;
+  if (!format->support(FILE_SUPPORT_FRAMES))
+    p.frames = 1;
+  return p;
+}
+
+void BM_SaveFile(benchmark::State& state, const std::string& ext)
+{
+  FileFormat* format = get_file_format(ext);
+  if (!format || !format->support(FILE_SUPPORT_SAVE)) {
+    state.SkipWithError("format cannot be saved");
+    return;
+  }
+
+  const SpriteParams p = supported_params(ext, SpriteParams(state));
+  const std::string fn = bench_filename(ext);
+  Context ctx;
+  std::unique_ptr<Doc> doc(create_doc(&ctx, p));
+
+  for (auto _ : state) {
+    if (!save_doc(&ctx, doc.get(), fn)) {
+      state.SkipWithError("error saving file");
+      break;
+    }
+  }
+
+  doc->close();
+  state.SetBytesProcessed(state.iterations() * p.rawBytes());
+  base::delete_file(fn);
+}
+
+void BM_LoadFile(benchmark::State& state, const std::string& ext)
+{
+  FileFormat* format = get_file_format(ext);
+  if (!format || !format->support(FILE_SUPPORT_LOAD)) {
+    state.SkipWithError("format cannot be loaded");
+    return;
+  }
+
+  SpriteParams p = supported_params(ext, SpriteParams(state));
+  const std::string fn = bench_filename(ext);
+  Context ctx;
+
+  if (format->support(FILE_SUPPORT_SAVE)) {
+    std::unique_ptr<Doc> doc(create_doc(&ctx, p));
+    const bool saved = save_doc(&ctx, doc.get(), fn);
+    doc->close();
+    if (!saved) {
+      state.SkipWithError("error saving file");
+      return;
+    }
+  }
+  else if (ext == "psd") {
+    p.layers = p.frames = 1;
+    if (!write_flat_psd(p, fn)) {
+      state.SkipWithError("error writing file");
+      return;
+    }
+  }
+  else {
+    state.SkipWithError("no way to create a file to load");
+    return;
+  }
+
+  for (auto _ : state) {
+    if (!load_doc(&ctx, fn)) {
+      state.SkipWithError("error loading file");
+      break;
+    }
+  }
+
+  state.SetBytesProcessed(state.iterations() * p.rawBytes());
+  base::delete_file(fn);
+}
+
+void register_benchmarks()
+{
+  // { width, height, layers, frames }
+  const std::vector<std::vector<int64_t>> args = {
+    { 64,   64,   1, 1  },
+    { 256,  256,  1, 1  },
+    { 1024, 1024, 1, 1  },
+    { 4096, 4096, 1, 1  },
+    { 256,  256,  4, 16 },
+    { 1024, 1024, 8, 8  },
+  };
+
+  for (const char* ext : { "ase", "png", "gif", "webp", "qoi", "tga", "bmp", "psd" }) {
+    const std::string name(ext);
+    FileFormat* format = get_file_format(name);
+    if (!format) // Disabled in this build (e.g. ENABLE_WEBP=OFF)
+      continue;
+
+    for (const bool save : { true, false }) {
+      if (save && !format->support(FILE_SUPPORT_SAVE))
+        continue;
+
+      auto* bm = (save ? benchmark::RegisterBenchmark(("BM_SaveFile/" + name).c_str(),
+                                                      BM_SaveFile,
+                                                      name) :
+                         benchmark::RegisterBenchmark(("BM_LoadFile/" + name).c_str(),
+                                                      BM_LoadFile,
+                                                      name));
+      for (const auto& a : args) {
+        // Skip layers/frames variations for flat formats (they
+        // would be the same as the one-frame cases).
+        if ((a[2] > 1 || a[3] > 1) && !format->support(FILE_SUPPORT_LAYERS) &&
+            !format->support(FILE_SUPPORT_FRAMES)) {
+          continue;
+        }
+        bm->Args(a);
+      }
+      bm->Unit(benchmark::kMillisecond);
+    }
+  }
+}
+
+} // anonymous namespace
+
+int app_main(int argc, char* argv[])
+{
+  register_benchmarks();
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+
+  FileFormatsManager::destroyInstance();
+  return 0;
+}
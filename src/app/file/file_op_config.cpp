@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -12,6 +12,8 @@
 
 #include "app/color_spaces.h"
 
+#include <algorithm>
+
 namespace app {
 
 void FileOpConfig::fillFromPreferences()
@@ -28,6 +30,12 @@ void FileOpConfig::fillFromPreferences()
   fitCriteria = pref.quantization.fitCriteria();
   cacheCompressedTilesets = pref.tileset.cacheCompressedTilesets();
   composeGroups = pref.experimental.composeGroups();
+  lazyLoadImages = pref.experimental.lazyLoadImages();
+  lazyImagesCacheSize = std::size_t(std::max(0, pref.experimental.lazyImagesCacheSize())) * 1024 *
+                        1024;
+  asepriteCompression = pref.asepriteFormat.compression();
+  asepritePreviewSize = std::max(0, pref.asepriteFormat.previewSize());
+  pngCompression = pref.png.compression();
 }
 
 } // namespace app
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -13,6 +13,8 @@
 #include "doc/rgbmap_algorithm.h"
 #include "gfx/color_space.h"
 
+#include <cstddef>
+
 namespace app {
 
 // Options that came from Preferences but can be used in the non-UI thread.
@@ -52,6 +54,25 @@ struct FileOpConfig {
   // blend mode and opacity fields are valid for groups too.
   bool composeGroups = false;
 
+  // True if the compressed cels of .aseprite files are decoded when
+  // they are used (instead of decoding all of them when the file is
+  // loaded), using up to lazyImagesCacheSize bytes for the decoded
+  // images.
+  bool lazyLoadImages = false;
+  std::size_t lazyImagesCacheSize = std::size_t(1024) * 1024 * 1024;
+
+  // Compression profile used to save .aseprite files (when the
+  // document doesn't have its own format options).
+  app::gen::CompressionProfile asepriteCompression = app::gen::CompressionProfile::DEFAULT;
+
+  // Maximum width/height of the preview embedded in .aseprite files
+  // (0 to save files without preview).
+  int asepritePreviewSize = 0;
+
+  // Encoder used to save .png files (when the document doesn't
+  // specify one in its PngOptions).
+  app::gen::PngCompression pngCompression = app::gen::PngCompression::DEFAULT;
+
   void fillFromPreferences();
 };
 
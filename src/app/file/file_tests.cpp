@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2023  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -12,7 +12,11 @@
 #include "app/doc.h"
 #include "app/file/file.h"
 #include "app/file/file_formats_manager.h"
+#include "app/file/png_options.h"
+#include "app/file/qoi_image.h"
+#include "app/pref/preferences.h"
 #include "base/base64.h"
+#include "base/fs.h"
 #include "doc/doc.h"
 #include "doc/user_data.h"
 #include "fmt/format.h"
@@ -363,3 +367,427 @@ TEST(File, CustomProperties)
     }
   }
 }
+
+TEST(File, LoadSequenceLinksIdenticalFrames)
+{
+  app::Context ctx;
+
+  // Frames 1-2 and 3-5 are identical
+  const doc::color_t colors[] = { doc::rgba(255, 0, 0, 255),
+                                  doc::rgba(255, 0, 0, 255),
+                                  doc::rgba(0, 0, 255, 255),
+                                  doc::rgba(0, 0, 255, 255),
+                                  doc::rgba(0, 0, 255, 255),
+                                  doc::rgba(0, 255, 0, 255) };
+  const int nframes = int(sizeof(colors) / sizeof(colors[0]));
+
+  for (int i = 0; i < nframes; ++i) {
+    std::unique_ptr<Doc> doc(ctx.documents().add(8, 8, doc::ColorMode::RGB, 256));
+    doc->setFilename(fmt::format("seq{}.png", i + 1));
+    doc->sprite()->root()->firstLayer()->cel(0)->image()->clear(colors[i]);
+    save_document(&ctx, doc.get());
+    doc->close();
+  }
+
+  std::unique_ptr<FileOp> fop(
+    FileOp::createLoadDocumentOperation(&ctx, "seq1.png", FILE_LOAD_SEQUENCE_YES));
+  ASSERT_TRUE(fop != nullptr);
+  fop->operate();
+  fop->done();
+  fop->postLoad();
+  EXPECT_FALSE(fop->hasError());
+
+  std::unique_ptr<Doc> doc(fop->releaseDocument());
+  ASSERT_TRUE(doc != nullptr);
+  ASSERT_EQ(nframes, doc->sprite()->totalFrames());
+
+  Layer* layer = doc->sprite()->root()->firstLayer();
+  for (int i = 0; i < nframes; ++i) {
+    Cel* cel = layer->cel(i);
+    ASSERT_TRUE(cel != nullptr);
+    EXPECT_EQ(colors[i], get_pixel(cel->image(), 0, 0));
+  }
+  EXPECT_EQ(layer->cel(0)->dataRef(), layer->cel(1)->dataRef());
+  EXPECT_NE(layer->cel(1)->dataRef(), layer->cel(2)->dataRef());
+  EXPECT_EQ(layer->cel(2)->dataRef(), layer->cel(3)->dataRef());
+  EXPECT_EQ(layer->cel(2)->dataRef(), layer->cel(4)->dataRef());
+  EXPECT_NE(layer->cel(4)->dataRef(), layer->cel(5)->dataRef());
+
+  doc->close();
+}
+
+TEST(File, LoadPartialROI)
+{
+  app::Context ctx;
+  const doc::color_t red = doc::rgba(255, 0, 0, 255);
+  const doc::color_t blue = doc::rgba(0, 0, 255, 255);
+
+  {
+    std::unique_ptr<Doc> doc(ctx.documents().add(8, 8, doc::ColorMode::RGB, 256));
+    doc->setFilename("partial.ase");
+    Sprite* sprite = doc->sprite();
+    sprite->setTotalFrames(4);
+
+    auto a = static_cast<LayerImage*>(sprite->root()->firstLayer());
+    a->setName("A");
+    a->cel(0)->image()->clear(red);
+    ImageRef image(Image::create(IMAGE_RGB, 8, 8));
+    image->clear(blue);
+    a->addCel(new Cel(2, image));
+    a->addCel(Cel::MakeLink(3, a->cel(0)));
+
+    auto b = new LayerImage(sprite);
+    b->setName("B");
+    sprite->root()->addLayer(b);
+    for (frame_t frame = 0; frame < 4; ++frame) {
+      ImageRef bImage(Image::create(IMAGE_RGB, 8, 8));
+      bImage->clear(blue);
+      b->addCel(new Cel(frame, bImage));
+    }
+
+    auto tag = new Tag(2, 3);
+    tag->setName("T");
+    sprite->tags().add(tag);
+
+    save_document(&ctx, doc.get());
+    doc->close();
+  }
+
+  // Load only the cels of layer "A" in the frames of tag "T"
+  std::unique_ptr<FileOp> fop(
+    FileOp::createLoadDocumentOperation(&ctx, "partial.ase", FILE_LOAD_SEQUENCE_NONE));
+  ASSERT_TRUE(fop != nullptr);
+  FileOpROI roi(nullptr, gfx::Rect(), std::string(), "T", doc::FramesSequence(), true);
+  roi.setLayersToLoad({ "A" });
+  fop->setLoadROI(roi);
+  fop->operate();
+  fop->done();
+  fop->postLoad();
+  EXPECT_FALSE(fop->hasError());
+
+  std::unique_ptr<Doc> doc(fop->releaseDocument());
+  ASSERT_TRUE(doc != nullptr);
+  ASSERT_EQ(4, doc->sprite()->totalFrames());
+
+  Layer* a = doc->sprite()->root()->firstLayer();
+  Layer* b = a->getNext();
+  ASSERT_TRUE(b != nullptr);
+  EXPECT_EQ(0, static_cast<LayerImage*>(b)->getCelsCount());
+
+  // The cel in frame 0 is loaded only because frame 3 is a link to it
+  EXPECT_TRUE(a->cel(1) == nullptr);
+  ASSERT_TRUE(a->cel(2) != nullptr);
+  ASSERT_TRUE(a->cel(3) != nullptr);
+  ASSERT_TRUE(a->cel(0) != nullptr);
+  EXPECT_EQ(blue, get_pixel(a->cel(2)->image(), 0, 0));
+  EXPECT_EQ(red, get_pixel(a->cel(3)->image(), 0, 0));
+  EXPECT_EQ(a->cel(0)->dataRef(), a->cel(3)->dataRef());
+
+  doc->close();
+}
+
+TEST(File, SaveSequence)
+{
+  app::Context ctx;
+
+  const doc::color_t colors[] = { doc::rgba(255, 0, 0, 255),
+                                  doc::rgba(0, 255, 0, 255),
+                                  doc::rgba(0, 0, 255, 255),
+                                  doc::rgba(255, 255, 0, 255),
+                                  doc::rgba(0, 255, 255, 255) };
+  const int nframes = int(sizeof(colors) / sizeof(colors[0]));
+
+  {
+    std::unique_ptr<Doc> doc(ctx.documents().add(8, 8, doc::ColorMode::RGB, 256));
+    doc->setFilename("saveseq1.png");
+
+    Sprite* sprite = doc->sprite();
+    auto* layer = static_cast<LayerImage*>(sprite->root()->firstLayer());
+    sprite->setTotalFrames(nframes);
+    layer->cel(0)->image()->clear(colors[0]);
+    for (int i = 1; i < nframes; ++i) {
+      ImageRef image(Image::create(IMAGE_RGB, 8, 8));
+      image->clear(colors[i]);
+      layer->addCel(new Cel(i, image));
+    }
+
+    ASSERT_EQ(0, save_document(&ctx, doc.get()));
+    doc->close();
+  }
+
+  // Each frame is saved in its own file
+  for (int i = 0; i < nframes; ++i) {
+    std::unique_ptr<Doc> doc(load_document(&ctx, fmt::format("saveseq{}.png", i + 1)));
+    ASSERT_TRUE(doc != nullptr);
+    EXPECT_EQ(1, doc->sprite()->totalFrames());
+    EXPECT_EQ(colors[i], get_pixel(doc->sprite()->root()->firstLayer()->cel(0)->image(), 0, 0));
+    doc->close();
+  }
+}
+
+TEST(File, SaveSequenceIncrementally)
+{
+  app::Context ctx;
+
+  std::unique_ptr<Doc> doc(ctx.documents().add(8, 8, doc::ColorMode::RGB, 256));
+  doc->setFilename("incseq1.png");
+
+  Sprite* sprite = doc->sprite();
+  auto* layer = static_cast<LayerImage*>(sprite->root()->firstLayer());
+  sprite->setTotalFrames(3);
+  layer->cel(0)->image()->clear(doc::rgba(255, 0, 0, 255));
+  for (int i = 1; i < 3; ++i) {
+    ImageRef image(Image::create(IMAGE_RGB, 8, 8));
+    image->clear(doc::rgba(0, 0, 255, 255));
+    layer->addCel(new Cel(i, image));
+  }
+
+  auto save = [&ctx, &doc] {
+    std::unique_ptr<FileOp> fop(FileOp::createSaveDocumentOperation(
+      &ctx,
+      FileOpROI(doc.get(), doc->sprite()->bounds(), "", "", FramesSequence(), false),
+      doc->filename(),
+      "",
+      false));
+    ASSERT_TRUE(fop != nullptr);
+    fop->setIncremental(true);
+    fop->operate();
+    fop->done();
+    ASSERT_FALSE(fop->hasError());
+  };
+  save();
+  EXPECT_TRUE(base::is_file(".incseq1.png.manifest"));
+
+  // Replace the first file with garbage (of the same size) to check
+  // that unchanged frames are not saved again
+  const std::size_t size = base::file_size("incseq1.png");
+  const std::vector<uint8_t> garbage(size, 'x');
+  base::write_file_content("incseq1.png", garbage.data(), garbage.size());
+
+  layer->cel(2)->image()->clear(doc::rgba(0, 255, 0, 255));
+  save();
+
+  EXPECT_EQ(garbage, base::read_file_content("incseq1.png"));
+
+  std::unique_ptr<Doc> doc3(load_document(&ctx, "incseq3.png"));
+  ASSERT_TRUE(doc3 != nullptr);
+  EXPECT_EQ(doc::rgba(0, 255, 0, 255),
+            get_pixel(doc3->sprite()->root()->firstLayer()->cel(0)->image(), 0, 0));
+  doc3->close();
+  doc->close();
+}
+
+TEST(File, SaveCelImageWithoutRender)
+{
+  app::Context ctx;
+  auto color = [](int x, int y) { return doc::rgba(x * 16, y * 16, 128, 7 + (x + y) * 8); };
+
+  // The cel covers the whole canvas (it's saved directly), and then
+  // it's moved (so the frame must be rendered)
+  for (const gfx::Point celPos : { gfx::Point(0, 0), gfx::Point(3, 2) }) {
+    {
+      std::unique_ptr<Doc> doc(ctx.documents().add(16, 16, doc::ColorMode::RGB, 256));
+      doc->setFilename("celimage.png");
+
+      Cel* cel = doc->sprite()->root()->firstLayer()->cel(0);
+      for (int y = 0; y < 16; ++y)
+        for (int x = 0; x < 16; ++x)
+          put_pixel(cel->image(), x, y, color(x, y));
+      cel->setPosition(celPos);
+
+      ASSERT_EQ(0, save_document(&ctx, doc.get()));
+      doc->close();
+    }
+
+    std::unique_ptr<Doc> doc(load_document(&ctx, "celimage.png"));
+    ASSERT_TRUE(doc != nullptr);
+    const Image* image = doc->sprite()->root()->firstLayer()->cel(0)->image();
+    EXPECT_EQ(color(0, 0), get_pixel(image, celPos.x, celPos.y));
+    EXPECT_EQ(color(5, 7), get_pixel(image, celPos.x + 5, celPos.y + 7));
+    EXPECT_EQ(color(12, 13), get_pixel(image, celPos.x + 12, celPos.y + 13));
+    doc->close();
+  }
+}
+
+TEST(File, CompressionProfiles)
+{
+  app::Context ctx;
+
+  const app::gen::CompressionProfile profiles[] = { app::gen::CompressionProfile::FASTEST,
+                                                    app::gen::CompressionProfile::DEFAULT,
+                                                    app::gen::CompressionProfile::SMALLEST };
+  std::vector<std::size_t> sizes;
+
+  for (const auto profile : profiles) {
+    ctx.preferences().asepriteFormat.compression(profile);
+
+    {
+      std::unique_ptr<Doc> doc(ctx.documents().add(64, 64, doc::ColorMode::RGB, 256));
+      doc->setFilename("compression.aseprite");
+
+      Image* image = doc->sprite()->root()->firstLayer()->cel(0)->image();
+      for (int y = 0; y < 64; ++y)
+        for (int x = 0; x < 64; ++x)
+          put_pixel(image, x, y, doc::rgba(x * 4, y * 4, (x ^ y) & 0xff, 255));
+
+      ASSERT_EQ(0, save_document(&ctx, doc.get()));
+      doc->close();
+    }
+
+    sizes.push_back(base::file_size("compression.aseprite"));
+
+    // All profiles generate files that can be loaded
+    std::unique_ptr<Doc> doc(load_document(&ctx, "compression.aseprite"));
+    ASSERT_TRUE(doc != nullptr);
+    const Image* image = doc->sprite()->root()->firstLayer()->cel(0)->image();
+    for (int y = 0; y < 64; ++y)
+      for (int x = 0; x < 64; ++x)
+        ASSERT_EQ(doc::rgba(x * 4, y * 4, (x ^ y) & 0xff, 255), get_pixel(image, x, y));
+    doc->close();
+  }
+
+  EXPECT_GE(sizes[0], sizes[2]);
+  ctx.preferences().asepriteFormat.compression(app::gen::CompressionProfile::DEFAULT);
+}
+
+TEST(File, EmbeddedPreview)
+{
+  app::Context ctx;
+  ctx.preferences().asepriteFormat.previewSize(16);
+
+  const doc::color_t red = doc::rgba(255, 0, 0, 255);
+  {
+    std::unique_ptr<Doc> doc(ctx.documents().add(64, 32, doc::ColorMode::RGB, 256));
+    doc->setFilename("preview.aseprite");
+    doc->sprite()->root()->firstLayer()->cel(0)->image()->clear(red);
+    ASSERT_EQ(0, save_document(&ctx, doc.get()));
+    doc->close();
+  }
+  ctx.preferences().asepriteFormat.previewSize(0);
+
+  // The preview is ignored by regular loads
+  {
+    std::unique_ptr<Doc> doc(load_document(&ctx, "preview.aseprite"));
+    ASSERT_TRUE(doc != nullptr);
+    EXPECT_EQ(64, doc->sprite()->width());
+    EXPECT_EQ(32, doc->sprite()->height());
+    doc->close();
+  }
+
+  std::unique_ptr<FileOp> fop(
+    FileOp::createLoadDocumentOperation(&ctx,
+                                        "preview.aseprite",
+                                        FILE_LOAD_SEQUENCE_NONE | FILE_LOAD_PREVIEW));
+  ASSERT_TRUE(fop != nullptr);
+  fop->operate();
+  fop->done();
+  fop->postLoad();
+  EXPECT_FALSE(fop->hasError());
+
+  std::unique_ptr<Doc> doc(fop->releaseDocument());
+  ASSERT_TRUE(doc != nullptr);
+  EXPECT_EQ(16, doc->sprite()->width());
+  EXPECT_EQ(8, doc->sprite()->height());
+  const Image* image = doc->sprite()->root()->firstLayer()->cel(0)->image();
+  EXPECT_EQ(red, get_pixel(image, 0, 0));
+  EXPECT_EQ(red, get_pixel(image, 15, 7));
+  doc->close();
+}
+
+TEST(File, PngCompression)
+{
+  app::Context ctx;
+
+  // Big enough to be compressed in several blocks
+  const int w = 600, h = 1200;
+  auto color = [](int x, int y) {
+    return doc::rgba(x & 0xff, y & 0xff, (x ^ y) & 0xff, 255 - (y & 3));
+  };
+
+  for (const auto compression : { PngOptions::Compression::Fast, PngOptions::Compression::Small }) {
+    {
+      std::unique_ptr<Doc> doc(ctx.documents().add(w, h, doc::ColorMode::RGB, 256));
+      doc->setFilename("compression.png");
+
+      auto opts = std::make_shared<PngOptions>();
+      opts->setCompression(compression);
+      doc->setFormatOptions(opts);
+
+      Image* image = doc->sprite()->root()->firstLayer()->cel(0)->image();
+      for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+          put_pixel(image, x, y, color(x, y));
+
+      ASSERT_EQ(0, save_document(&ctx, doc.get()));
+      doc->close();
+    }
+
+    std::unique_ptr<Doc> doc(load_document(&ctx, "compression.png"));
+    ASSERT_TRUE(doc != nullptr);
+    const Image* image = doc->sprite()->root()->firstLayer()->cel(0)->image();
+    for (int y = 0; y < h; ++y)
+      for (int x = 0; x < w; ++x)
+        ASSERT_EQ(color(x, y), get_pixel(image, x, y));
+    doc->close();
+  }
+}
+
+TEST(File, QoiImage)
+{
+  ImageRef image(Image::create(IMAGE_RGB, 97, 31));
+  for (int y = 0; y < image->height(); ++y)
+    for (int x = 0; x < image->width(); ++x)
+      put_pixel(image.get(), x, y, doc::rgba(x * 2, y, (x / 8) * 8, (x < 40 ? 255 : x)));
+
+  base::buffer data;
+  ASSERT_TRUE(encode_qoi_image(image.get(), data));
+
+  // Decode in a reused buffer
+  auto buffer = std::make_shared<ImageBuffer>();
+  for (int i = 0; i < 2; ++i) {
+    ImageRef decoded(decode_qoi_image(data.data(), data.size(), buffer));
+    ASSERT_TRUE(decoded != nullptr);
+    EXPECT_EQ(0, count_diff_between_images(image.get(), decoded.get()));
+  }
+
+  // Only RGB images are supported, and invalid data is not decoded
+  ImageRef indexed(Image::create(IMAGE_INDEXED, 4, 4));
+  EXPECT_FALSE(encode_qoi_image(indexed.get(), data));
+  EXPECT_TRUE(decode_qoi_image(data.data(), 4) == nullptr);
+}
+
+TEST(File, SaveAndLoadInMemory)
+{
+  app::Context ctx;
+
+  const int w = 37, h = 21;
+  auto color = [](int x, int y) { return doc::rgba(x * 6, y * 12, (x ^ y) & 0xff, 255); };
+
+  for (const char* fn : { "memory.png", "memory.bmp", "memory.ase" }) {
+    std::vector<uint8_t> data;
+    {
+      std::unique_ptr<Doc> doc(ctx.documents().add(w, h, doc::ColorMode::RGB, 256));
+      Image* image = doc->sprite()->root()->firstLayer()->cel(0)->image();
+      for (int y = 0; y < h; ++y)
+        for (int x = 0; x < w; ++x)
+          put_pixel(image, x, y, color(x, y));
+
+      FileOpROI roi(doc.get(), doc->sprite()->bounds(), "", "", FramesSequence(), false);
+      ASSERT_EQ(0, save_document_in_memory(&ctx, roi, fn, data));
+      doc->close();
+    }
+    EXPECT_FALSE(data.empty());
+    EXPECT_FALSE(base::is_file(fn));
+
+    std::unique_ptr<Doc> doc(
+      load_document_from_memory(&ctx, fn, std::move(data), FILE_LOAD_SEQUENCE_NONE));
+    ASSERT_TRUE(doc != nullptr);
+    EXPECT_EQ(w, doc->sprite()->width());
+    EXPECT_EQ(h, doc->sprite()->height());
+    const Image* image = doc->sprite()->root()->firstLayer()->cel(0)->image();
+    for (int y = 0; y < h; ++y)
+      for (int x = 0; x < w; ++x)
+        ASSERT_EQ(color(x, y), get_pixel(image, x, y));
+    doc->close();
+  }
+}
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2023  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -41,7 +41,7 @@ class FliFormat : public FileFormat {
   int onGetFlags() const override
   {
     return FILE_SUPPORT_LOAD | FILE_SUPPORT_SAVE | FILE_SUPPORT_INDEXED | FILE_SUPPORT_FRAMES |
-           FILE_SUPPORT_PALETTES | FILE_ENCODE_ABSTRACT_IMAGE;
+           FILE_SUPPORT_PALETTES | FILE_ENCODE_ABSTRACT_IMAGE | FILE_SUPPORT_MEMORY;
   }
 
   bool onLoad(FileOp* fop) override;
@@ -58,7 +58,7 @@ FileFormat* CreateFliFormat()
 bool FliFormat::onLoad(FileOp* fop)
 {
   // Open the file to read in binary mode
-  FileHandle handle(open_file_with_exception(fop->filename(), "rb"));
+  FileHandle handle(fop->openFileForReading());
   FILE* f = handle.get();
   flic::StdioFileInterface finterface(f);
   flic::Decoder decoder(&finterface);
@@ -197,7 +197,7 @@ bool FliFormat::onSave(FileOp* fop)
   const FileAbstractImage* sprite = fop->abstractImageToSave();
 
   // Open the file to write in binary mode
-  FileHandle handle(open_file_with_exception_sync_on_close(fop->filename(), "wb"));
+  FileHandle handle(fop->openFileForWriting());
   FILE* f = handle.get();
   flic::StdioFileInterface finterface(f);
   flic::Encoder encoder(&finterface);
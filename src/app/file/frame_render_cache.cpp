@@ -0,0 +1,69 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/file/frame_render_cache.h"
+
+#include "doc/image.h"
+#include "doc/sprite.h"
+#include "render/render.h"
+
+namespace app {
+
+FrameRenderCache::FrameRenderCache(const doc::Sprite* sprite, const bool newBlend)
+  : m_sprite(sprite)
+  , m_newBlend(newBlend)
+{
+}
+
+FrameRenderCache::~FrameRenderCache() = default;
+
+void FrameRenderCache::addUse(const doc::frame_t frame)
+{
+  const std::lock_guard lock(m_mutex);
+  auto& entry = m_entries[frame];
+  if (!entry)
+    entry = std::make_shared<Entry>();
+  ++entry->uses;
+  ++entry->remaining;
+}
+
+bool FrameRenderCache::render(doc::Image* dst, const doc::frame_t frame, const gfx::Rect& bounds)
+{
+  if (!m_sprite->bounds().contains(bounds))
+    return false;
+
+  std::shared_ptr<Entry> entry;
+  {
+    const std::lock_guard lock(m_mutex);
+    auto it = m_entries.find(frame);
+    if (it == m_entries.end() || it->second->uses < 2)
+      return false;
+
+    // Keep the entry alive only while we are using it if this is
+    // the last use of the frame
+    entry = it->second;
+    if (--entry->remaining == 0)
+      m_entries.erase(it);
+  }
+
+  std::call_once(entry->rendered, [this, &entry, frame] {
+    entry->image.reset(
+      doc::Image::create(m_sprite->pixelFormat(), m_sprite->width(), m_sprite->height()));
+
+    render::Render render;
+    render.setNewBlend(m_newBlend);
+    render.renderSprite(entry->image.get(), m_sprite, frame);
+  });
+
+  dst->copy(entry->image.get(), gfx::Clip(0, 0, bounds));
+  return true;
+}
+
+} // namespace app
@@ -0,0 +1,68 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_FILE_FRAME_RENDER_CACHE_H_INCLUDED
+#define APP_FILE_FRAME_RENDER_CACHE_H_INCLUDED
+#pragma once
+
+#include "base/disable_copying.h"
+#include "doc/frame.h"
+#include "doc/image_ref.h"
+#include "gfx/rect.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+
+namespace doc {
+class Image;
+class Sprite;
+} // namespace doc
+
+namespace app {
+
+// Renders of the whole canvas of a sprite shared between several
+// FileOps that save the same sprite at the same time (e.g. the CLI
+// with --split-slices saves the same frames for each slice). A frame
+// that is used by more than one FileOp is rendered only once, and its
+// image is released when all its uses are done.
+//
+// It can be used from several threads, but the sprite must not be
+// modified while it's used.
+class FrameRenderCache {
+public:
+  FrameRenderCache(const doc::Sprite* sprite, bool newBlend);
+  ~FrameRenderCache();
+
+  // Indicates that the given frame will be rendered one more time
+  // (must be called before the FileOps start).
+  void addUse(doc::frame_t frame);
+
+  // Copies the given area of the rendered frame in "dst" (at 0,0).
+  // Returns false if the frame is not shared between several uses
+  // (or the area is outside the canvas), in that case the caller
+  // should render the frame by itself.
+  bool render(doc::Image* dst, doc::frame_t frame, const gfx::Rect& bounds);
+
+private:
+  struct Entry {
+    int uses = 0;      // Total number of uses of this frame
+    int remaining = 0; // Uses that didn't call render() yet
+    std::once_flag rendered;
+    doc::ImageRef image;
+  };
+
+  const doc::Sprite* m_sprite;
+  bool m_newBlend;
+  std::mutex m_mutex;
+  std::map<doc::frame_t, std::shared_ptr<Entry>> m_entries;
+
+  DISABLE_COPYING(FrameRenderCache);
+};
+
+} // namespace app
+
+#endif
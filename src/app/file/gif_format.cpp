@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -20,11 +20,13 @@
 #include "app/file/gif_options.h"
 #include "app/modules/gui.h"
 #include "app/pref/preferences.h"
+#include "app/task_scheduler.h"
 #include "app/util/autocrop.h"
 #include "base/file_handle.h"
 #include "base/fs.h"
 #include "doc/doc.h"
 #include "doc/octree_map.h"
+#include "doc/task_group.h"
 #include "gfx/clip.h"
 #include "render/dithering.h"
 #include "render/ordered_dither.h"
@@ -35,6 +37,14 @@
 #include "gif_options.xml.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 
 #include <gif_lib.h>
 
@@ -176,6 +186,29 @@ static inline doc::color_t colormap2rgba(ColorMapObject* colormap, int i)
                    255);
 }
 
+// A frame read from the GIF file (pixels are indexes of its
+// colormap) waiting to be composed over the previous frames.
+struct GifDecodedFrame {
+  gfx::Rect bounds;
+  // Pixels of the frame or nullptr if the bounds are empty.
+  std::unique_ptr<Image> image;
+  // Copy of the local colormap (owned by this frame) or nullptr to
+  // use the global one.
+  ColorMapObject* localColormap = nullptr;
+  DisposalMethod disposalMethod = DisposalMethod::NONE;
+  int transparentIndex = -1;
+  int frameDelay = 1;
+
+  GifDecodedFrame() = default;
+  GifDecodedFrame(const GifDecodedFrame&) = delete;
+  GifDecodedFrame& operator=(const GifDecodedFrame&) = delete;
+  ~GifDecodedFrame()
+  {
+    if (localColormap)
+      GifFreeMapObject(localColormap);
+  }
+};
+
 // Decodes a GIF file trying to keep the image in Indexed format. If
 // it's not possible to handle it as Indexed (e.g. it contains more
 // than 256 colors), the file will be automatically converted to RGB.
@@ -185,8 +218,17 @@ static inline doc::color_t colormap2rgba(ColorMapObject* colormap, int i)
 // and combinations of local colormaps can output any number of
 // colors, not just 256. So previous RGB colors must be kept and
 // merged with new colormaps.
+//
+// The decoding is done in two stages: the main thread reads the
+// records and decompresses the LZW data of each frame, and a
+// background thread composes the frames in order (palette, colors,
+// disposal, and cels), so the next frame is decompressed while the
+// previous one is composed.
 class GifDecoder {
 public:
+  // Maximum number of decompressed frames waiting to be composed.
+  static constexpr int kMaxPendingFrames = 4;
+
   GifDecoder(FileOp* fop, GifFileType* gifFile, int fd, size_t filesize)
     : m_fop(fop)
     , m_gifFile(gifFile)
@@ -194,12 +236,13 @@ public:
     , m_filesize(filesize)
     , m_sprite(nullptr)
     , m_spriteBounds(0, 0, m_gifFile->SWidth, m_gifFile->SHeight)
+    , m_layer(nullptr)
+    , m_readFrames(0)
     , m_frameNum(0)
     , m_opaque(false)
-    , m_disposalMethod(DisposalMethod::NONE)
     , m_bgIndex(m_gifFile->SBackGroundColor >= 0 ? m_gifFile->SBackGroundColor : 0)
     , m_localTransparentIndex(-1)
-    , m_frameDelay(1)
+    , m_localColormap(nullptr)
     , m_remap(256)
     , m_hasLocalColormaps(false)
     , m_firstLocalColormap(nullptr)
@@ -212,6 +255,15 @@ public:
 
   ~GifDecoder()
   {
+    if (m_thread.joinable()) {
+      {
+        const std::lock_guard lock(m_mutex);
+        m_exit = true;
+      }
+      m_cv.notify_all();
+      m_thread.join();
+    }
+
     if (m_firstLocalColormap)
       GifFreeMapObject(m_firstLocalColormap);
   }
@@ -227,7 +279,7 @@ public:
       readRecord(recType);
 
       // Just one frame?
-      if (m_fop->isOneFrame() && m_frameNum > 0)
+      if (m_fop->isOneFrame() && m_readFrames > 0)
         break;
 
       if (m_fop->isStop())
@@ -239,6 +291,9 @@ public:
       }
     }
 
+    // Wait the last frames to be composed
+    finishFrames();
+
     if (m_sprite) {
       // Add entries to include the transparent color
       if (m_bgIndex >= m_sprite->palette(0)->size())
@@ -314,28 +369,132 @@ private:
       // to load the GIF file anyway (which is what is done by other
       // apps).
     if (!m_spriteBounds.contains(frameBounds))
-      throw Exception("Image %d is out of sprite bounds.\n", (int)m_frameNum);
+      throw Exception("Image %d is out of sprite bounds.\n", (int)m_readFrames);
 #endif
 
     // Create sprite if this is the first frame
     if (!m_sprite)
       createSprite();
 
+    // The extension records (read before this image) are in
+    // m_nextFrame.
+    std::unique_ptr<GifDecodedFrame> frame(std::move(m_nextFrame));
+    if (!frame)
+      frame = std::make_unique<GifDecodedFrame>();
+    frame->bounds = frameBounds;
+
+    // Load the frame pixels from the GIF file. We don't know if a GIF
+    // file could contain empty bounds (width or height=0), but we
+    // check this just in case.
+    if (!frameBounds.isEmpty())
+      frame->image.reset(readFrameIndexedImage(frameBounds));
+
+    // The local colormap is valid only until the next image
+    // descriptor is read, so we need a copy of it.
+    if (ColorMapObject* colormap = m_gifFile->Image.ColorMap) {
+      frame->localColormap = GifMakeMapObject(colormap->ColorCount, colormap->Colors);
+      if (!frame->localColormap)
+        throw Exception("Invalid local color map in frame %d.\n", m_readFrames);
+    }
+
+    ++m_readFrames;
+    composeFrame(std::move(frame));
+  }
+
+  // Composes the frame in the background thread, or right now if
+  // we're loading just one frame. If the background thread cannot
+  // compose the frames as fast as they are decompressed, we wait
+  // until there is space in the queue (to avoid keeping all the
+  // frames in memory). Errors composing previous frames are thrown
+  // from here.
+  void composeFrame(std::unique_ptr<GifDecodedFrame>&& frame)
+  {
+    if (m_fop->isOneFrame()) {
+      processFrame(*frame);
+      return;
+    }
+
+    // The sprite is created before starting the thread, after that
+    // only the background thread modifies it until finishFrames()
+    if (!m_thread.joinable())
+      m_thread = BlockingTask([this] { composerThread(); });
+
+    std::unique_lock lock(m_mutex);
+    m_cv.wait(lock, [this] { return int(m_frames.size()) < kMaxPendingFrames || m_error; });
+    rethrowError();
+
+    m_frames.push_back(std::move(frame));
+    m_cv.notify_all();
+  }
+
+  // Waits all frames to be composed.
+  void finishFrames()
+  {
+    if (!m_thread.joinable())
+      return;
+
+    std::unique_lock lock(m_mutex);
+    m_cv.wait(lock, [this] { return m_frames.empty() || m_error; });
+    rethrowError();
+  }
+
+  void composerThread()
+  {
+    std::unique_lock lock(m_mutex);
+    while (true) {
+      m_cv.wait(lock, [this] { return !m_frames.empty() || m_exit; });
+      if (m_exit)
+        break;
+
+      // The frame is removed from the queue when it's composed (the
+      // main thread only adds new frames at the end of the queue)
+      const GifDecodedFrame* frame = m_frames.front().get();
+      lock.unlock();
+      std::exception_ptr error;
+      try {
+        processFrame(*frame);
+      }
+      catch (...) {
+        error = std::current_exception();
+      }
+      lock.lock();
+
+      if (error) {
+        m_error = error;
+        m_frames.clear();
+        m_cv.notify_all();
+        break;
+      }
+      m_frames.pop_front();
+      m_cv.notify_all();
+    }
+  }
+
+  void rethrowError()
+  {
+    if (m_error) {
+      std::exception_ptr error = m_error;
+      m_error = nullptr;
+      std::rethrow_exception(error);
+    }
+  }
+
+  void processFrame(const GifDecodedFrame& frame)
+  {
+    const gfx::Rect& frameBounds = frame.bounds;
+    Image* frameImage = frame.image.get();
+
+    m_localTransparentIndex = frame.transparentIndex;
+    m_localColormap = frame.localColormap;
+
     // Add a frame if it's necessary
     if (m_sprite->lastFrame() < m_frameNum)
       m_sprite->addFrame(m_frameNum);
 
-    // Create a temporary image loading the frame pixels from the GIF file
-    std::unique_ptr<Image> frameImage;
-    // We don't know if a GIF file could contain empty bounds (width
-    // or height=0), but we check this just in case.
-    if (!frameBounds.isEmpty())
-      frameImage.reset(readFrameIndexedImage(frameBounds));
-
     GIF_TRACE("GIF: Frame[%d] transparentIndex=%d localMap=%d\n",
               (int)m_frameNum,
               m_localTransparentIndex,
-              m_gifFile->Image.ColorMap ? m_gifFile->Image.ColorMap->ColorCount : 0);
+              m_localColormap ? m_localColormap->ColorCount : 0);
 
     if (m_frameNum == 0) {
       if (m_localTransparentIndex >= 0)
@@ -346,7 +505,7 @@ private:
 
     // Merge this frame colors with the current palette
     if (frameImage && m_sprite->palette(m_frameNum)->size() <= 256)
-      updatePalette(frameImage.get());
+      updatePalette(frameImage);
 
     // Convert the sprite to RGB if we have more than 256 colors
     if ((m_sprite->pixelFormat() == IMAGE_INDEXED) &&
@@ -360,10 +519,10 @@ private:
     // Composite frame with previous frame
     if (frameImage) {
       if (m_sprite->pixelFormat() == IMAGE_INDEXED) {
-        compositeIndexedImageToIndexed(frameBounds, frameImage.get());
+        compositeIndexedImageToIndexed(frameBounds, frameImage);
       }
       else {
-        compositeIndexedImageToRgb(frameBounds, frameImage.get());
+        compositeIndexedImageToRgb(frameBounds, frameImage);
       }
     }
 
@@ -373,21 +532,19 @@ private:
     // Dispose/clear frame content
     process_disposal_method(m_previousImage.get(),
                             m_currentImage.get(),
-                            m_disposalMethod,
+                            frame.disposalMethod,
                             frameBounds,
                             m_bgIndex);
 
-    // Copy the current image into previous image
-    copy_image(m_previousImage.get(), m_currentImage.get());
+    // Copy the current image into previous image. Both images are
+    // equal outside the frame bounds (only the frame bounds are
+    // composed and disposed), so we don't need to copy the whole
+    // canvas on each frame.
+    m_previousImage->copy(m_currentImage.get(), gfx::Clip(frameBounds));
 
     // Set frame delay (1/100th seconds to milliseconds)
-    if (m_frameDelay >= 0)
-      m_sprite->setFrameDuration(m_frameNum, m_frameDelay * 10);
-
-    // Reset extension variables
-    m_disposalMethod = DisposalMethod::NONE;
-    m_localTransparentIndex = -1;
-    m_frameDelay = 1;
+    if (frame.frameDelay >= 0)
+      m_sprite->setFrameDuration(m_frameNum, frame.frameDelay * 10);
 
     // Next frame
     ++m_frameNum;
@@ -430,7 +587,7 @@ private:
   ColorMapObject* getFrameColormap()
   {
     ColorMapObject* global = m_gifFile->SColorMap;
-    ColorMapObject* colormap = m_gifFile->Image.ColorMap;
+    ColorMapObject* colormap = m_localColormap;
 
     if (!colormap) {
       // Doesn't have local map, use the global one
@@ -483,7 +640,7 @@ private:
   {
     ColorMapObject* colormap = getFrameColormap();
     int ncolors = colormap->ColorCount;
-    bool isLocalColormap = (m_gifFile->Image.ColorMap ? true : false);
+    bool isLocalColormap = (m_localColormap ? true : false);
 
     GIF_TRACE("GIF: Local colormap=%d, ncolors=%d\n", isLocalColormap, ncolors);
 
@@ -709,14 +866,17 @@ private:
 
     if (extCode == GRAPHICS_EXT_FUNC_CODE) {
       if (extension[0] >= 4) {
-        m_disposalMethod = (DisposalMethod)((extension[1] >> 2) & 7);
-        m_localTransparentIndex = (extension[1] & 1) ? extension[4] : -1;
-        m_frameDelay = (extension[3] << 8) | extension[2];
+        // These values are for the next image descriptor
+        if (!m_nextFrame)
+          m_nextFrame = std::make_unique<GifDecodedFrame>();
+        m_nextFrame->disposalMethod = (DisposalMethod)((extension[1] >> 2) & 7);
+        m_nextFrame->transparentIndex = (extension[1] & 1) ? extension[4] : -1;
+        m_nextFrame->frameDelay = (extension[3] << 8) | extension[2];
 
         GIF_TRACE("GIF: Disposal method: %d\n  Transparent index: %d\n  Frame delay: %d\n",
-                  m_disposalMethod,
-                  m_localTransparentIndex,
-                  m_frameDelay);
+                  m_nextFrame->disposalMethod,
+                  m_nextFrame->transparentIndex,
+                  m_nextFrame->frameDelay);
       }
     }
 
@@ -847,12 +1007,12 @@ private:
   std::unique_ptr<Sprite> m_sprite;
   gfx::Rect m_spriteBounds;
   LayerImage* m_layer;
-  int m_frameNum;
+  int m_readFrames;    // Number of frames read by the main thread
+  int m_frameNum;      // Frame being composed
   bool m_opaque;
-  DisposalMethod m_disposalMethod;
   int m_bgIndex;
   int m_localTransparentIndex;
-  int m_frameDelay;
+  ColorMapObject* m_localColormap;
   ImageRef m_currentImage;
   ImageRef m_previousImage;
   Remap m_remap;
@@ -862,6 +1022,18 @@ private:
   // all local colormaps are the same, so we can use it as a global
   // colormap.
   ColorMapObject* m_firstLocalColormap;
+
+  // Extension values (disposal method, transparent index, etc.) for
+  // the next frame to be read.
+  std::unique_ptr<GifDecodedFrame> m_nextFrame;
+
+  // Frames waiting to be composed in the background thread.
+  BlockingTask m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<std::unique_ptr<GifDecodedFrame>> m_frames;
+  std::exception_ptr m_error;
+  bool m_exit = false;
 };
 
 bool GifFormat::onLoad(FileOp* fop)
@@ -898,6 +1070,64 @@ bool GifFormat::onLoad(FileOp* fop)
 
 #ifdef ENABLE_SAVE
 
+// Minimum number of pixels of a frame to look for the changed pixels
+// from several threads.
+const int kParallelDeltaPixels = 256 * 256;
+
+static int gif_write_to_file(GifFileType* gifFile, const GifByteType* data, int size)
+{
+  return int(std::fwrite(data, 1, size, (FILE*)gifFile->UserData));
+}
+
+static int gif_write_to_memory(GifFileType* gifFile, const GifByteType* data, int size)
+{
+  auto bytes = (std::vector<uint8_t>*)gifFile->UserData;
+  bytes->insert(bytes->end(), data, data + size);
+  return size;
+}
+
+static GifFileType* gif_open(void* userData, OutputFunc outputFunc)
+{
+  #if GIFLIB_MAJOR >= 5
+  int errCode = 0;
+  return EGifOpen(userData, outputFunc, &errCode);
+  #else
+  return EGifOpen(userData, outputFunc);
+  #endif
+}
+
+// Index of each opaque color of a palette (the same index that
+// Palette::findExactMatch() returns for alpha=255), to avoid
+// searching the whole palette for each pixel of a frame.
+using ExactMatches = std::unordered_map<color_t, int>;
+
+static ExactMatches find_exact_matches(const Palette& palette, const int maskIndex)
+{
+  ExactMatches matches;
+  // In reverse order so the first index of repeated colors is used
+  for (int i = palette.size() - 1; i >= 0; --i) {
+    const color_t color = palette.getEntry(i);
+    if (i != maskIndex && rgba_geta(color) == 255)
+      matches[color] = i;
+  }
+  return matches;
+}
+
+// A GIF frame to be encoded in a task: the changed pixels
+// (deltaImage) are converted to indexes of its colormap and
+// compressed with LZW in memory, so then the encoded frames are
+// written in order.
+struct GifFrameData {
+  int gifFrame = 0;
+  frame_t frame = 0;
+  gfx::Rect bounds;
+  DisposalMethod disposal = DisposalMethod::NONE;
+  bool fixDuration = false;
+  std::unique_ptr<Image> deltaImage;
+  // Extension, image descriptor, and LZW data of this frame.
+  std::vector<uint8_t> bytes;
+};
+
 // Our stragegy to encode GIF files depends of the sprite color mode:
 //
 // 1) If the sprite is indexed, we have two paths:
@@ -930,9 +1160,10 @@ class GifEncoder {
 public:
   typedef int gifframe_t;
 
-  GifEncoder(FileOp* fop, GifFileType* gifFile)
+  GifEncoder(FileOp* fop, GifFileType* gifFile, FILE* file)
     : m_fop(fop)
     , m_gifFile(gifFile)
+    , m_file(file)
     , m_sprite(fop->document()->sprite())
     , m_img(fop->abstractImageToSave())
     , m_spec(m_img->spec())
@@ -1093,6 +1324,21 @@ public:
     // In this code "gifFrame" will be the GIF frame, and "frame" will
     // be the doc::Sprite frame.
     gifframe_t nframes = totalFrames();
+
+    if (m_globalColormap && !m_preservePaletteOrder)
+      m_globalExactMatches = find_exact_matches(m_globalColormapPalette, m_transparentIndex);
+
+    // Frames are rendered and compared with the previous one in this
+    // thread (each frame depends on the previous one), and then
+    // quantized and compressed in tasks. We encode batches of frames:
+    // one batch is encoded meanwhile we prepare the next one, then
+    // the first one is written in order.
+    const int batchSize = TaskScheduler::instance()->threads();
+    std::vector<std::unique_ptr<GifFrameData>> frames;
+    std::vector<std::unique_ptr<GifFrameData>> pendingFrames;
+    std::unique_ptr<doc::TaskGroup> tasks;
+    std::unique_ptr<doc::TaskGroup> pendingTasks;
+
     for (gifframe_t gifFrame = 0; gifFrame < nframes; ++gifFrame) {
       ASSERT(frame_it != frame_end);
       if (m_fop->isStop())
@@ -1123,15 +1369,31 @@ public:
 
       calculateDeltaImageFrameBoundsDisposal(gifFrame, frameBounds, disposal);
 
-      writeImage(gifFrame,
-                 frame,
-                 frameBounds,
-                 disposal,
-                 // Only the last frame in the animation needs the fix
-                 (fix_last_frame_duration && gifFrame == nframes - 1));
+      auto data = std::make_unique<GifFrameData>();
+      data->gifFrame = gifFrame;
+      data->frame = frame;
+      data->bounds = frameBounds;
+      data->disposal = disposal;
+      // Only the last frame in the animation needs the fix
+      data->fixDuration = (fix_last_frame_duration && gifFrame == nframes - 1);
+      data->deltaImage = std::move(m_deltaImage);
+
+      if (!tasks)
+        tasks = std::make_unique<doc::TaskGroup>();
+      tasks->run([this, frameData = data.get()] { encodeFrame(*frameData); });
+      frames.push_back(std::move(data));
+
+      if (int(frames.size()) == batchSize) {
+        writeFrames(pendingTasks, pendingFrames);
+        pendingTasks = std::move(tasks);
+        std::swap(pendingFrames, frames);
+      }
 
       m_fop->setProgress(double(gifFrame + 1) / double(nframes));
     }
+
+    writeFrames(pendingTasks, pendingFrames);
+    writeFrames(tasks, frames);
     return true;
   }
 
@@ -1189,52 +1451,42 @@ private:
           y1 = m_spriteBounds.h - 1;
         }
 
-        int i = 0;
-        int x, y;
-        const LockImageBits<RgbTraits> bits1(m_previousImage);
-        LockImageBits<RgbTraits> bits2(m_currentImage);
-        const LockImageBits<RgbTraits> bits3(m_nextImage);
-        m_deltaImage.reset(
-          Image::create(PixelFormat::IMAGE_RGB, m_spriteBounds.w, m_spriteBounds.h));
+        m_deltaImage.reset(Image::create(PixelFormat::IMAGE_RGB,
+                                         m_spriteBounds.w,
+                                         m_spriteBounds.h,
+                                         m_deltaImageBuf));
         clear_image(m_deltaImage.get(), 0);
-        LockImageBits<RgbTraits> deltaBits(m_deltaImage.get());
-        typename LockImageBits<RgbTraits>::iterator deltaIt;
-        typename LockImageBits<RgbTraits>::iterator it2, end2;
-        typename LockImageBits<RgbTraits>::const_iterator it1, it3, end1, deltaEnd;
 
-        bool previousImageMatchsCurrent = true;
-        for (it1 = bits1.begin(),
-            end1 = bits1.end(),
-            it2 = bits2.begin(),
-            end2 = bits2.end(),
-            it3 = bits3.begin(),
-            deltaIt = deltaBits.begin();
-             it1 != end1 && it2 != end2;
-             ++it1, ++it2, ++it3, ++deltaIt, ++i) {
-          x = i % m_spriteBounds.w;
-          y = i / m_spriteBounds.w;
-          // While we are checking color differences,
-          // we enlarge the frameBounds where the color differences take place
-          if ((rgba_geta(*it2) != 0 && *it1 != *it2) || rgba_geta(*it3) == 0) {
-            previousImageMatchsCurrent = false;
-            *it2 = (rgba_geta(*it2) ? *it2 : 0);
-            *deltaIt = *it2;
-            if (x < x1)
-              x1 = x;
-            if (x > x2)
-              x2 = x;
-            if (y < y1)
-              y1 = y;
-            if (y > y2)
-              y2 = y;
+        // Big frames are compared in bands of rows from several
+        // threads, each band expands its own bounds.
+        const int h = m_spriteBounds.h;
+        const int nbands = (m_spriteBounds.w * h >= kParallelDeltaPixels ?
+                              std::min(h, TaskScheduler::instance()->threads()) :
+                              1);
+        std::vector<DeltaBand> bands(nbands, DeltaBand{ x1, y1, x2, y2 });
+        if (nbands == 1) {
+          calculateDeltaBand(0, h, bands[0]);
+        }
+        else {
+          doc::TaskGroup tasks;
+          for (int i = 0; i < nbands; ++i) {
+            tasks.run([this, i, nbands, h, &bands] {
+              calculateDeltaBand(h * i / nbands, h * (i + 1) / nbands, bands[i]);
+            });
           }
+          tasks.wait();
+        }
 
-          // We need to change disposal mode DO_NOT_DISPOSE to RESTORE_BGCOLOR only
-          // if we found a "pixel clearing" in the next Image. RESTORE_BGCOLOR is
-          // our way to clear pixels.
-          if (rgba_geta(*it2) != 0 && rgba_geta(*it3) == 0) {
+        bool previousImageMatchsCurrent = true;
+        for (const DeltaBand& band : bands) {
+          x1 = std::min(x1, band.x1);
+          y1 = std::min(y1, band.y1);
+          x2 = std::max(x2, band.x2);
+          y2 = std::max(y2, band.y2);
+          if (!band.matches)
+            previousImageMatchsCurrent = false;
+          if (band.clearing)
             disposal = DisposalMethod::RESTORE_BGCOLOR;
-          }
         }
         if (previousImageMatchsCurrent)
           frameBounds = gfx::Rect(m_lastFrameBounds);
@@ -1268,6 +1520,52 @@ private:
     m_lastDisposal = disposal;
   }
 
+  // Changed pixels between the previous and current frames in a band
+  // of rows.
+  struct DeltaBand {
+    int x1, y1, x2, y2;
+    bool matches = true;  // True if the previous image matches the current one
+    bool clearing = false; // True if there is a "pixel clearing" in the next image
+  };
+
+  // Copies the pixels of the current image that are different from
+  // the previous image (or that are cleared in the next one) to the
+  // delta image, expanding the bounds of the band to include them.
+  void calculateDeltaBand(const int ya, const int yb, DeltaBand& band)
+  {
+    const int w = m_spriteBounds.w;
+    for (int y = ya; y < yb; ++y) {
+      auto it1 = get_pixel_address_fast<RgbTraits>(m_previousImage, 0, y);
+      auto it2 = get_pixel_address_fast<RgbTraits>(m_currentImage, 0, y);
+      auto it3 = get_pixel_address_fast<RgbTraits>(m_nextImage, 0, y);
+      auto deltaIt = get_pixel_address_fast<RgbTraits>(m_deltaImage.get(), 0, y);
+
+      for (int x = 0; x < w; ++x, ++it1, ++it2, ++it3, ++deltaIt) {
+        // While we are checking color differences,
+        // we enlarge the frameBounds where the color differences take place
+        if ((rgba_geta(*it2) != 0 && *it1 != *it2) || rgba_geta(*it3) == 0) {
+          band.matches = false;
+          *it2 = (rgba_geta(*it2) ? *it2 : 0);
+          *deltaIt = *it2;
+          if (x < band.x1)
+            band.x1 = x;
+          if (x > band.x2)
+            band.x2 = x;
+          if (y < band.y1)
+            band.y1 = y;
+          if (y > band.y2)
+            band.y2 = y;
+        }
+
+        // We need to change disposal mode DO_NOT_DISPOSE to RESTORE_BGCOLOR only
+        // if we found a "pixel clearing" in the next Image. RESTORE_BGCOLOR is
+        // our way to clear pixels.
+        if (rgba_geta(*it2) != 0 && rgba_geta(*it3) == 0)
+          band.clearing = true;
+      }
+    }
+  }
+
   doc::frame_t totalFrames() const { return m_fop->roi().frames(); }
 
   void writeHeader()
@@ -1320,15 +1618,14 @@ private:
   #endif
   }
 
-  // Writes graphics extension record (to save the duration of the
-  // frame and maybe the transparency index).
-  void writeExtension(const gifframe_t gifFrame,
-                      const frame_t frame,
-                      const int transparentIndex,
-                      const DisposalMethod disposalMethod,
-                      const bool fixDuration)
+  // Fills the graphics extension record (to save the duration of
+  // the frame and maybe the transparency index).
+  void fillExtension(const frame_t frame,
+                     const int transparentIndex,
+                     const DisposalMethod disposalMethod,
+                     const bool fixDuration,
+                     unsigned char extension_bytes[4])
   {
-    unsigned char extension_bytes[5];
     int frameDelay = m_img->frameDuration(frame) / 10;
 
     // Fix duration for Twitter. It looks like the last frame must be
@@ -1343,9 +1640,6 @@ private:
     extension_bytes[1] = (frameDelay & 0xff);
     extension_bytes[2] = (frameDelay >> 8) & 0xff;
     extension_bytes[3] = (transparentIndex >= 0 ? transparentIndex : 0);
-
-    if (EGifPutExtension(m_gifFile, GRAPHICS_EXT_FUNC_CODE, 4, extension_bytes) == GIF_ERROR)
-      throw Exception("Error writing GIF graphics extension record for frame %d.\n", gifFrame);
   }
 
   static gfx::Rect calculateFrameBounds(Image* a, Image* b)
@@ -1363,34 +1657,63 @@ private:
     return frameBounds;
   }
 
-  void writeImage(const gifframe_t gifFrame,
-                  const frame_t frame,
-                  const gfx::Rect& frameBounds,
-                  const DisposalMethod disposal,
-                  const bool fixDuration)
+  // Waits the given batch of frames to be encoded and writes them in
+  // the file.
+  void writeFrames(std::unique_ptr<doc::TaskGroup>& tasks,
+                   std::vector<std::unique_ptr<GifFrameData>>& frames)
+  {
+    if (tasks) {
+      tasks->wait();
+      tasks.reset();
+    }
+    for (const auto& frame : frames) {
+      if (std::fwrite(frame->bytes.data(), 1, frame->bytes.size(), m_file) !=
+          frame->bytes.size())
+        throw Exception("Error writing GIF frame %d.\n", frame->gifFrame);
+    }
+    frames.clear();
+  }
+
+  // Converts the delta image of the frame to indexes of its colormap
+  // and compresses it. Called from a task (several frames at the same
+  // time), so it doesn't modify the encoder.
+  void encodeFrame(GifFrameData& data) const
   {
+    const gifframe_t gifFrame = data.gifFrame;
+    const gfx::Rect& frameBounds = data.bounds;
+    const Image* deltaImage = data.deltaImage.get();
+
+    int transparentIndex = m_transparentIndex;
     Palette framePalette;
+    ExactMatches frameExactMatches;
     if (m_globalColormap)
       framePalette = m_globalColormapPalette;
-    else
-      framePalette = calculatePalette();
+    else {
+      framePalette = calculatePalette(deltaImage, transparentIndex);
+      if (!m_preservePaletteOrder)
+        frameExactMatches = find_exact_matches(framePalette, transparentIndex);
+    }
+    const ExactMatches& exactMatches = (m_globalColormap ? m_globalExactMatches :
+                                                           frameExactMatches);
 
     OctreeMap octree;
-    octree.regenerateMap(&framePalette, m_transparentIndex);
-    ImageRef frameImage(
-      Image::create(IMAGE_INDEXED, frameBounds.w, frameBounds.h, m_frameImageBuf));
+    octree.regenerateMap(&framePalette, transparentIndex);
+    ImageRef frameImage(Image::create(IMAGE_INDEXED, frameBounds.w, frameBounds.h));
 
     // Every frame might use a small portion of the global palette,
     // to optimize the gif file size, we will analize which colors
     // will be used in each processed frame.
     PalettePicks usedColors(framePalette.size());
 
-    int localTransparent = m_transparentIndex;
+    int localTransparent = transparentIndex;
     ColorMapObject* colormap = m_globalColormap;
+    std::unique_ptr<ColorMapObject, void (*)(ColorMapObject*)> localColormap(
+      nullptr,
+      [](ColorMapObject* colormap) { GifFreeMapObject(colormap); });
     Remap remap(256);
 
     if (!m_preservePaletteOrder) {
-      const LockImageBits<RgbTraits> srcBits(m_deltaImage.get());
+      const LockImageBits<RgbTraits> srcBits(deltaImage);
       LockImageBits<IndexedTraits> dstBits(frameImage.get());
 
       auto srcIt = srcBits.begin();
@@ -1405,17 +1728,15 @@ private:
           int i;
 
           if (rgba_geta(color) > 0) {
-            i = framePalette.findExactMatch(rgba_getr(color),
-                                            rgba_getg(color),
-                                            rgba_getb(color),
-                                            255,
-                                            m_transparentIndex);
-            if (i < 0)
-              i = octree.mapColor(color | rgba_a_mask); // alpha=255
+            auto it = exactMatches.find(color | rgba_a_mask); // alpha=255
+            if (it != exactMatches.end())
+              i = it->second;
+            else
+              i = octree.mapColor(color | rgba_a_mask);
           }
           else {
-            if (m_transparentIndex >= 0)
-              i = m_transparentIndex;
+            if (transparentIndex >= 0)
+              i = transparentIndex;
             else
               i = m_bgIndex;
           }
@@ -1449,72 +1770,95 @@ private:
           }
         }
 
-        colormap = createColorMap(&reducedPalette);
+        localColormap.reset(createColorMap(&reducedPalette));
+        colormap = localColormap.get();
         if (localTransparent >= 0)
           localTransparent = remap[localTransparent];
       }
 
-      if (localTransparent >= 0 && m_transparentIndex != localTransparent)
-        remap.map(m_transparentIndex, localTransparent);
+      if (localTransparent >= 0 && transparentIndex != localTransparent)
+        remap.map(transparentIndex, localTransparent);
     }
     else {
-      frameImage.reset(Image::createCopy(m_deltaImage.get()));
+      frameImage.reset(Image::createCopy(deltaImage));
       for (int i = 0; i < colormap->ColorCount; ++i)
         remap.map(i, i);
     }
 
-    // Write extension record.
-    writeExtension(gifFrame, frame, localTransparent, disposal, fixDuration);
-
-    // Write the image record.
-    if (EGifPutImageDesc(m_gifFile,
-                         frameBounds.x,
-                         frameBounds.y,
-                         frameBounds.w,
-                         frameBounds.h,
-                         m_interlaced ? 1 : 0,
-                         (colormap != m_globalColormap ? colormap : nullptr)) == GIF_ERROR) {
-      throw Exception("Error writing GIF frame %d.\n", gifFrame);
-    }
-
-    std::vector<uint8_t> scanline(frameBounds.w);
-
-    // Write the image data (pixels).
-    if (m_interlaced) {
-      // Need to perform 4 passes on the images.
-      for (int i = 0; i < 4; ++i)
-        for (int y = interlaced_offset[i]; y < frameBounds.h; y += interlaced_jumps[i]) {
-          IndexedTraits::address_t addr = (IndexedTraits::address_t)frameImage->getPixelAddress(0,
-                                                                                                y);
+    unsigned char extension[4];
+    fillExtension(data.frame, localTransparent, data.disposal, data.fixDuration, extension);
 
-          for (int i = 0; i < frameBounds.w; ++i, ++addr)
-            scanline[i] = remap[*addr];
+    // Convert the pixels to the final indexes
+    std::vector<uint8_t> pixels(frameBounds.w * frameBounds.h);
+    uint8_t* dst = pixels.data();
+    for (int y = 0; y < frameBounds.h; ++y) {
+      IndexedTraits::address_t addr = (IndexedTraits::address_t)frameImage->getPixelAddress(0, y);
 
-          if (EGifPutLine(m_gifFile, &scanline[0], frameBounds.w) == GIF_ERROR)
-            throw Exception("Error writing GIF image scanlines for frame %d.\n", gifFrame);
-        }
+      for (int i = 0; i < frameBounds.w; ++i, ++addr, ++dst)
+        *dst = remap[*addr];
     }
-    else {
-      // Write all image scanlines (not interlaced in this case).
-      for (int y = 0; y < frameBounds.h; ++y) {
-        IndexedTraits::address_t addr = (IndexedTraits::address_t)frameImage->getPixelAddress(0, y);
 
-        for (int i = 0; i < frameBounds.w; ++i, ++addr)
-          scanline[i] = remap[*addr];
+    // The frame is compressed by giflib in memory, with the same
+    // screen descriptor (global colormap) of the real file.
+    std::size_t size = 0;
+    {
+      GifFilePtr gifFile(gif_open(&data.bytes, gif_write_to_memory), &EGifCloseFile);
+      if (!gifFile ||
+          EGifPutScreenDesc(gifFile,
+                            m_spriteBounds.w,
+                            m_spriteBounds.h,
+                            m_bitsPerPixel,
+                            m_bgIndex,
+                            m_globalColormap) == GIF_ERROR)
+        throw Exception("Error encoding GIF frame %d.\n", gifFrame);
+      data.bytes.clear();
+
+      // Write extension record.
+      if (EGifPutExtension(gifFile, GRAPHICS_EXT_FUNC_CODE, 4, extension) == GIF_ERROR)
+        throw Exception("Error writing GIF graphics extension record for frame %d.\n",
+                        gifFrame);
+
+      // Write the image record.
+      if (EGifPutImageDesc(gifFile,
+                           frameBounds.x,
+                           frameBounds.y,
+                           frameBounds.w,
+                           frameBounds.h,
+                           m_interlaced ? 1 : 0,
+                           (colormap != m_globalColormap ? colormap : nullptr)) == GIF_ERROR) {
+        throw Exception("Error writing GIF frame %d.\n", gifFrame);
+      }
 
-        if (EGifPutLine(m_gifFile, &scanline[0], frameBounds.w) == GIF_ERROR)
+      const int w = frameBounds.w;
+      auto putLine = [&gifFile, &pixels, gifFrame, w](const int y) {
+        if (EGifPutLine(gifFile, &pixels[y * w], w) == GIF_ERROR)
           throw Exception("Error writing GIF image scanlines for frame %d.\n", gifFrame);
+      };
+
+      // Write the image data (pixels).
+      if (m_interlaced) {
+        // Need to perform 4 passes on the images.
+        for (int i = 0; i < 4; ++i)
+          for (int y = interlaced_offset[i]; y < frameBounds.h; y += interlaced_jumps[i])
+            putLine(y);
+      }
+      else {
+        // Write all image scanlines (not interlaced in this case).
+        for (int y = 0; y < frameBounds.h; ++y)
+          putLine(y);
       }
-    }
 
-    if (colormap && colormap != m_globalColormap)
-      GifFreeMapObject(colormap);
+      // Ignore the GIF trailer added when the memory file is closed
+      size = data.bytes.size();
+    }
+    data.bytes.resize(size);
+    data.deltaImage.reset();
   }
 
-  Palette calculatePalette()
+  static Palette calculatePalette(const Image* deltaImage, int& transparentIndex)
   {
     OctreeMap octree;
-    const LockImageBits<RgbTraits> imageBits(m_deltaImage.get());
+    const LockImageBits<RgbTraits> imageBits(deltaImage);
     auto it = imageBits.begin(), end = imageBits.end();
     bool maskColorFounded = false;
     for (; it != end; ++it) {
@@ -1530,7 +1874,7 @@ private:
       // If there is a mask color, the OctreeMap::makePalette adds it
       // by default at entry == 0.
       octree.makePalette(&palette, 256, 8);
-      m_transparentIndex = 0;
+      transparentIndex = 0;
       return palette;
     }
     else {
@@ -1540,7 +1884,7 @@ private:
       Palette paletteWithoutMask(0, palette.size() - 1);
       for (int i = 0; i < paletteWithoutMask.size(); i++)
         paletteWithoutMask.setEntry(i, palette.entry(i + 1));
-      m_transparentIndex = -1;
+      transparentIndex = -1;
       return paletteWithoutMask;
     }
   }
@@ -1582,6 +1926,7 @@ private:
 
   FileOp* m_fop;
   GifFileType* m_gifFile;
+  FILE* m_file;
   const Sprite* m_sprite;
   const FileAbstractImage* m_img;
   const ImageSpec m_spec;
@@ -1599,7 +1944,8 @@ private:
   bool m_preservePaletteOrder;
   gfx::Rect m_lastFrameBounds;
   DisposalMethod m_lastDisposal;
-  ImageBufferPtr m_frameImageBuf;
+  ImageBufferPtr m_deltaImageBuf;
+  ExactMatches m_globalExactMatches;
   ImageRef m_images[3];
   Image* m_previousImage;
   Image* m_currentImage;
@@ -1609,26 +1955,17 @@ private:
 
 bool GifFormat::onSave(FileOp* fop)
 {
-  #if GIFLIB_MAJOR >= 5
-  int errCode = 0;
-  #endif
-  int fd = base::open_file_descriptor_with_exception(fop->filename(), "wb");
-  GifFilePtr gif_file(EGifOpenFileHandle(fd
-  #if GIFLIB_MAJOR >= 5
-                                         ,
-                                         &errCode
-  #endif
-                                         ),
-                      &EGifCloseFile);
+  // The file is written with our own output function, so the frames
+  // encoded in memory can be written in the same FILE.
+  FileHandle handle(fop->openFileForWriting());
+  FILE* f = handle.get();
+  GifFilePtr gif_file(gif_open(f, gif_write_to_file), &EGifCloseFile);
 
   if (!gif_file)
     throw Exception("Error creating GIF file.\n");
 
-  GifEncoder encoder(fop, gif_file);
-  bool result = encoder.encode();
-  if (result)
-    base::sync_file_descriptor(fd);
-  return result;
+  GifEncoder encoder(fop, gif_file, f);
+  return encoder.encode();
 }
 
 #endif // ENABLE_SAVE
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2019  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -35,7 +35,7 @@ class IcoFormat : public FileFormat {
   int onGetFlags() const override
   {
     return FILE_SUPPORT_LOAD | FILE_SUPPORT_SAVE | FILE_SUPPORT_RGB | FILE_SUPPORT_GRAY |
-           FILE_SUPPORT_INDEXED;
+           FILE_SUPPORT_INDEXED | FILE_SUPPORT_MEMORY;
   }
 
   bool onLoad(FileOp* fop) override;
@@ -82,7 +82,7 @@ struct BITMAPINFOHEADER {
 
 bool IcoFormat::onLoad(FileOp* fop)
 {
-  FileHandle handle(open_file_with_exception(fop->filename(), "rb"));
+  FileHandle handle(fop->openFileForReading());
   FILE* f = handle.get();
 
   // Read the icon header
@@ -235,7 +235,7 @@ bool IcoFormat::onSave(FileOp* fop)
   int c, x, y, b, m, v;
   frame_t n, num = sprite->totalFrames();
 
-  FileHandle handle(open_file_with_exception_sync_on_close(fop->filename(), "wb"));
+  FileHandle handle(fop->openFileForWriting());
   FILE* f = handle.get();
 
   offset = 6 + num * 16; // ICONDIR + ICONDIRENTRYs
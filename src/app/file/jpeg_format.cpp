@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2024  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -59,7 +59,8 @@ class JpegFormat : public FileFormat {
   int onGetFlags() const override
   {
     return FILE_SUPPORT_LOAD | FILE_SUPPORT_SAVE | FILE_SUPPORT_RGB | FILE_SUPPORT_GRAY |
-           FILE_SUPPORT_SEQUENCES | FILE_SUPPORT_GET_FORMAT_OPTIONS | FILE_ENCODE_ABSTRACT_IMAGE;
+           FILE_SUPPORT_SEQUENCES | FILE_SUPPORT_GET_FORMAT_OPTIONS | FILE_ENCODE_ABSTRACT_IMAGE |
+           FILE_SUPPORT_MEMORY;
   }
 
   bool onLoad(FileOp* fop) override;
@@ -132,7 +133,7 @@ bool JpegFormat::onLoad(FileOp* fop)
   JDIMENSION buffer_height;
   int c;
 
-  FileHandle handle(open_file_with_exception(fop->filename(), "rb"));
+  FileHandle handle(fop->openFileForReading());
   FILE* file = handle.get();
 
   // Initialize the JPEG decompression object with error handling.
@@ -173,9 +174,14 @@ bool JpegFormat::onLoad(FileOp* fop)
   TinyEXIF::EXIFInfo info;
   int orientation = 0;
   {
-    std::ifstream istream(fop->filename(), std::ifstream::in | std::ifstream::binary);
     // Get EXIF information:
-    TinyEXIF::EXIFInfo info(istream);
+    TinyEXIF::EXIFInfo info;
+    if (fop->isMemory())
+      info.parseFrom(fop->memoryData().data(), unsigned(fop->memoryData().size()));
+    else {
+      std::ifstream istream(fop->filename(), std::ifstream::in | std::ifstream::binary);
+      info.parseFrom(istream);
+    }
     if (info.Fields != 0)
       orientation = info.Orientation;
   }
@@ -418,7 +424,7 @@ bool JpegFormat::onSave(FileOp* fop)
   LOG("JPEG: Saving with options: quality=%d\n", qualityValue);
 
   // Open the file for write in it.
-  FileHandle handle(open_file_with_exception_sync_on_close(fop->filename(), "wb"));
+  FileHandle handle(fop->openFileForWriting());
   FILE* file = handle.get();
 
   // Allocate and initialize JPEG compression object.
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2022-2023  Igara Studio S.A.
+// Copyright (C) 2022-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -36,7 +36,8 @@ class PcxFormat : public FileFormat {
   int onGetFlags() const override
   {
     return FILE_SUPPORT_LOAD | FILE_SUPPORT_SAVE | FILE_SUPPORT_RGB | FILE_SUPPORT_GRAY |
-           FILE_SUPPORT_INDEXED | FILE_SUPPORT_SEQUENCES | FILE_ENCODE_ABSTRACT_IMAGE;
+           FILE_SUPPORT_INDEXED | FILE_SUPPORT_SEQUENCES | FILE_ENCODE_ABSTRACT_IMAGE |
+           FILE_SUPPORT_MEMORY;
   }
 
   bool onLoad(FileOp* fop) override;
@@ -59,7 +60,7 @@ bool PcxFormat::onLoad(FileOp* fop)
   int x, y;
   char ch = 0;
 
-  FileHandle handle(open_file_with_exception(fop->filename(), "rb"));
+  FileHandle handle(fop->openFileForReading());
   FILE* f = handle.get();
 
   fgetc(f); /* skip manufacturer ID */
@@ -192,7 +193,7 @@ bool PcxFormat::onSave(FileOp* fop)
   char runchar;
   char ch = 0;
 
-  FileHandle handle(open_file_with_exception_sync_on_close(fop->filename(), "wb"));
+  FileHandle handle(fop->openFileForWriting());
   FILE* f = handle.get();
 
   if (spec.colorMode() == ColorMode::RGB) {
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2022  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -16,14 +16,22 @@
 #include "app/file/format_options.h"
 #include "app/file/png_format.h"
 #include "app/file/png_options.h"
+#include "app/task_scheduler.h"
 #include "base/file_handle.h"
 #include "doc/doc.h"
+#include "doc/task_group.h"
+#include "fmt/format.h"
 #include "gfx/color_space.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 #include "png.h"
+#include "zlib.h"
 
 #define PNG_TRACE(...) // TRACE
 
@@ -42,7 +50,7 @@ class PngFormat : public FileFormat {
   {
     return FILE_SUPPORT_LOAD | FILE_SUPPORT_SAVE | FILE_SUPPORT_RGB | FILE_SUPPORT_RGBA |
            FILE_SUPPORT_GRAY | FILE_SUPPORT_GRAYA | FILE_SUPPORT_INDEXED | FILE_SUPPORT_SEQUENCES |
-           FILE_SUPPORT_PALETTE_WITH_ALPHA | FILE_ENCODE_ABSTRACT_IMAGE;
+           FILE_SUPPORT_PALETTE_WITH_ALPHA | FILE_ENCODE_ABSTRACT_IMAGE | FILE_SUPPORT_MEMORY;
   }
 
   bool onLoad(FileOp* fop) override;
@@ -147,7 +155,7 @@ bool PngFormat::onLoad(FileOp* fop)
   png_bytepp rows_pointer;
   PixelFormat pixelFormat;
 
-  FileHandle handle(open_file_with_exception(fop->filename(), "rb"));
+  FileHandle handle(fop->openFileForReading());
   FILE* fp = handle.get();
 
   /* Create and initialize the png_struct with the desired error handler
@@ -247,7 +255,9 @@ bool PngFormat::onLoad(FileOp* fop)
 
   int imageWidth = png_get_image_width(png, info);
   int imageHeight = png_get_image_height(png, info);
-  ImageRef image = fop->sequenceImageToLoad(pixelFormat, imageWidth, imageHeight);
+  // Region of interest to load (e.g. only the --crop region)
+  const gfx::Rect bounds = fop->loadBounds(gfx::Size(imageWidth, imageHeight));
+  ImageRef image = fop->sequenceImageToLoad(pixelFormat, imageWidth, imageHeight, bounds);
   if (!image)
     return false;
 
@@ -289,16 +299,31 @@ bool PngFormat::onLoad(FileOp* fop)
     png_get_tRNS(png, info, nullptr, nullptr, &png_trans_color);
   }
 
+  // Interlaced images need all rows because each pass updates them,
+  // but for non-interlaced images we can read the rows before the
+  // ROI in one scratch row and stop reading after the last ROI row.
+  const bool interlaced = (number_passes > 1);
+  const png_uint_32 firstRow = (interlaced ? 0 : bounds.y);
+  const png_uint_32 lastRow = (interlaced ? height : bounds.y2());
+  png_bytep scratch_row = nullptr;
+
   // Allocate the memory to hold the image using the fields of info.
   rows_pointer = (png_bytepp)png_malloc(png, sizeof(png_bytep) * height);
-  for (y = 0; y < height; y++)
-    rows_pointer[y] = (png_bytep)png_malloc(png, png_get_rowbytes(png, info));
+  for (y = 0; y < height; y++) {
+    if (y >= firstRow && y < lastRow)
+      rows_pointer[y] = (png_bytep)png_malloc(png, png_get_rowbytes(png, info));
+    else {
+      if (!scratch_row)
+        scratch_row = (png_bytep)png_malloc(png, png_get_rowbytes(png, info));
+      rows_pointer[y] = scratch_row;
+    }
+  }
 
   for (int pass = 0; pass < number_passes; ++pass) {
-    for (y = 0; y < height; y++) {
+    for (y = 0; y < lastRow; y++) {
       png_read_rows(png, rows_pointer + y, nullptr, 1);
 
-      fop->setProgress((double)((double)pass + (double)(y + 1) / (double)(height)) /
+      fop->setProgress((double)((double)pass + (double)(y + 1) / (double)(lastRow)) /
                        (double)number_passes);
 
       if (fop->isStop())
@@ -306,15 +331,19 @@ bool PngFormat::onLoad(FileOp* fop)
     }
   }
 
+  // Bytes per pixel in rows_pointer (8-bit channels after
+  // png_set_strip_16() and png_set_packing())
+  const int channels = png_get_channels(png, info);
+
   // Convert rows_pointer into the doc::Image
-  for (y = 0; y < height; y++) {
+  for (y = bounds.y; y < png_uint_32(bounds.y2()); y++) {
     // RGB_ALPHA
     if (png_get_color_type(png, info) == PNG_COLOR_TYPE_RGB_ALPHA) {
-      uint8_t* src_address = rows_pointer[y];
-      uint32_t* dst_address = (uint32_t*)image->getPixelAddress(0, y);
+      uint8_t* src_address = rows_pointer[y] + bounds.x * channels;
+      uint32_t* dst_address = (uint32_t*)image->getPixelAddress(0, y - bounds.y);
       unsigned int x, r, g, b, a;
 
-      for (x = 0; x < width; x++) {
+      for (x = 0; x < png_uint_32(bounds.w); x++) {
         r = *(src_address++);
         g = *(src_address++);
         b = *(src_address++);
@@ -324,11 +353,11 @@ bool PngFormat::onLoad(FileOp* fop)
     }
     // RGB
     else if (png_get_color_type(png, info) == PNG_COLOR_TYPE_RGB) {
-      uint8_t* src_address = rows_pointer[y];
-      uint32_t* dst_address = (uint32_t*)image->getPixelAddress(0, y);
+      uint8_t* src_address = rows_pointer[y] + bounds.x * channels;
+      uint32_t* dst_address = (uint32_t*)image->getPixelAddress(0, y - bounds.y);
       unsigned int x, r, g, b, a;
 
-      for (x = 0; x < width; x++) {
+      for (x = 0; x < png_uint_32(bounds.w); x++) {
         r = *(src_address++);
         g = *(src_address++);
         b = *(src_address++);
@@ -348,11 +377,11 @@ bool PngFormat::onLoad(FileOp* fop)
     }
     // GRAY_ALPHA
     else if (png_get_color_type(png, info) == PNG_COLOR_TYPE_GRAY_ALPHA) {
-      uint8_t* src_address = rows_pointer[y];
-      uint16_t* dst_address = (uint16_t*)image->getPixelAddress(0, y);
+      uint8_t* src_address = rows_pointer[y] + bounds.x * channels;
+      uint16_t* dst_address = (uint16_t*)image->getPixelAddress(0, y - bounds.y);
       unsigned int x, k, a;
 
-      for (x = 0; x < width; x++) {
+      for (x = 0; x < png_uint_32(bounds.w); x++) {
         k = *(src_address++);
         a = *(src_address++);
         *(dst_address++) = graya(k, a);
@@ -360,11 +389,11 @@ bool PngFormat::onLoad(FileOp* fop)
     }
     // GRAY
     else if (png_get_color_type(png, info) == PNG_COLOR_TYPE_GRAY) {
-      uint8_t* src_address = rows_pointer[y];
-      uint16_t* dst_address = (uint16_t*)image->getPixelAddress(0, y);
+      uint8_t* src_address = rows_pointer[y] + bounds.x * channels;
+      uint16_t* dst_address = (uint16_t*)image->getPixelAddress(0, y - bounds.y);
       unsigned int x, k, a;
 
-      for (x = 0; x < width; x++) {
+      for (x = 0; x < png_uint_32(bounds.w); x++) {
         k = *(src_address++);
 
         // Transparent color
@@ -381,15 +410,17 @@ bool PngFormat::onLoad(FileOp* fop)
     }
     // PALETTE
     else if (png_get_color_type(png, info) == PNG_COLOR_TYPE_PALETTE) {
-      uint8_t* src_address = rows_pointer[y];
-      uint8_t* dst_address = (uint8_t*)image->getPixelAddress(0, y);
+      uint8_t* src_address = rows_pointer[y] + bounds.x * channels;
+      uint8_t* dst_address = (uint8_t*)image->getPixelAddress(0, y - bounds.y);
       unsigned int x;
 
-      for (x = 0; x < width; x++)
+      for (x = 0; x < png_uint_32(bounds.w); x++)
         *(dst_address++) = *(src_address++);
     }
-    png_free(png, rows_pointer[y]);
   }
+  for (y = firstRow; y < lastRow; y++)
+    png_free(png, rows_pointer[y]);
+  png_free(png, scratch_row);
   png_free(png, rows_pointer);
 
   // Setup the color space.
@@ -484,6 +515,338 @@ gfx::ColorSpaceRef PngFormat::loadColorSpace(png_structp png_ptr, png_infop info
 
 #ifdef ENABLE_SAVE
 
+// Converts the "y" row of the image to the PNG format of the given
+// color type. This function can be called from any thread.
+static void fill_png_row(FileOp* fop,
+                         const FileAbstractImage* img,
+                         const int color_type,
+                         const png_uint_32 y,
+                         uint8_t* dst)
+{
+  const ImageSpec spec = img->spec();
+  const ColorMode colorMode = spec.colorMode();
+  const png_uint_32 width = spec.width();
+  const png_uint_32 height = spec.height();
+
+  uint8_t* dst_address = dst;
+
+  if (color_type == PNG_COLOR_TYPE_RGB_ALPHA) {
+    unsigned int x, c, a;
+    bool opaque = true;
+
+    if (colorMode == ColorMode::RGB) {
+      auto src_address = (const uint32_t*)img->getScanline(y);
+
+      for (x = 0; x < width; ++x) {
+        c = *(src_address++);
+        a = rgba_geta(c);
+
+        if (opaque) {
+          if (a < 255)
+            opaque = false;
+          else if (fix_one_alpha_pixel && x == width - 1 && y == height - 1)
+            a = 254;
+        }
+
+        *(dst_address++) = rgba_getr(c);
+        *(dst_address++) = rgba_getg(c);
+        *(dst_address++) = rgba_getb(c);
+        *(dst_address++) = a;
+      }
+    }
+    // In case that we are converting an indexed image to RGB just
+    // to convert one pixel with alpha=254.
+    else if (colorMode == ColorMode::INDEXED) {
+      auto src_address = (const uint8_t*)img->getScanline(y);
+      unsigned int x, c;
+      int r, g, b, a;
+      bool opaque = true;
+
+      for (x = 0; x < width; ++x) {
+        c = *(src_address++);
+        fop->sequenceGetColor(c, &r, &g, &b);
+        fop->sequenceGetAlpha(c, &a);
+
+        if (opaque) {
+          if (a < 255)
+            opaque = false;
+          else if (fix_one_alpha_pixel && x == width - 1 && y == height - 1)
+            a = 254;
+        }
+
+        *(dst_address++) = r;
+        *(dst_address++) = g;
+        *(dst_address++) = b;
+        *(dst_address++) = a;
+      }
+    }
+  }
+  else if (color_type == PNG_COLOR_TYPE_RGB) {
+    auto src_address = (const uint32_t*)img->getScanline(y);
+    unsigned int x, c;
+
+    for (x = 0; x < width; ++x) {
+      c = *(src_address++);
+      *(dst_address++) = rgba_getr(c);
+      *(dst_address++) = rgba_getg(c);
+      *(dst_address++) = rgba_getb(c);
+    }
+  }
+  else if (color_type == PNG_COLOR_TYPE_GRAY_ALPHA) {
+    auto src_address = (const uint16_t*)img->getScanline(y);
+    unsigned int x, c, a;
+    bool opaque = true;
+
+    for (x = 0; x < width; x++) {
+      c = *(src_address++);
+      a = graya_geta(c);
+
+      if (opaque) {
+        if (a < 255)
+          opaque = false;
+        else if (fix_one_alpha_pixel && x == width - 1 && y == height - 1)
+          a = 254;
+      }
+
+      *(dst_address++) = graya_getv(c);
+      *(dst_address++) = a;
+    }
+  }
+  else if (color_type == PNG_COLOR_TYPE_GRAY) {
+    auto src_address = (const uint16_t*)img->getScanline(y);
+    unsigned int x, c;
+
+    for (x = 0; x < width; ++x) {
+      c = *(src_address++);
+      *(dst_address++) = graya_getv(c);
+    }
+  }
+  else if (color_type == PNG_COLOR_TYPE_PALETTE) {
+    auto src_address = (const uint8_t*)img->getScanline(y);
+    unsigned int x;
+
+    for (x = 0; x < width; ++x)
+      *(dst_address++) = *(src_address++);
+  }
+}
+// Size of the uncompressed data of each block of rows compressed by
+// write_png_idat_in_parallel(). Each block starts without the
+// previous data as dictionary, so a bigger block compresses better.
+static constexpr int kPngBlockSize = 1024 * 1024;
+
+static inline uint8_t paeth_predictor(const int a, const int b, const int c)
+{
+  const int p = a + b - c;
+  const int pa = std::abs(p - a);
+  const int pb = std::abs(p - b);
+  const int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc)
+    return a;
+  if (pb <= pc)
+    return b;
+  return c;
+}
+
+// Filters the given row with the PNG filter type (0=None, 1=Sub,
+// 2=Up, 3=Average, 4=Paeth), and returns the sum of the filtered
+// bytes as signed values (the heuristic recommended by the PNG
+// specification to choose the filter of each row).
+static int filter_png_row(const int type,
+                          const uint8_t* row,
+                          const uint8_t* prev,
+                          const int rowbytes,
+                          const int bpp,
+                          uint8_t* out)
+{
+  int sum = 0;
+  for (int i = 0; i < rowbytes; ++i) {
+    const int a = (i >= bpp ? row[i - bpp] : 0);
+    const int b = prev[i];
+    const int c = (i >= bpp ? prev[i - bpp] : 0);
+    uint8_t v = row[i];
+    switch (type) {
+      case 1: v -= a; break;
+      case 2: v -= b; break;
+      case 3: v -= (a + b) / 2; break;
+      case 4: v -= paeth_predictor(a, b, c); break;
+    }
+    out[i] = v;
+    sum += std::abs(int(int8_t(v)));
+  }
+  return sum;
+}
+
+// Block of rows of the image compressed in a raw deflate stream.
+struct PngBlock {
+  png_uint_32 y0, y1;
+  bool last;
+  std::vector<uint8_t> data;
+  uLong adler;
+  std::string error;
+};
+
+static void compress_png_block(FileOp* fop,
+                               const FileAbstractImage* img,
+                               const int color_type,
+                               const int rowbytes,
+                               const int bpp,
+                               const int level,
+                               PngBlock& block)
+{
+  // Indexed images are not filtered (as recommended by the PNG
+  // specification).
+  const bool adaptive = (color_type != PNG_COLOR_TYPE_PALETTE);
+
+  std::vector<uint8_t> prev(rowbytes, 0);
+  std::vector<uint8_t> row(rowbytes);
+  std::vector<uint8_t> best(rowbytes + 1);
+  std::vector<uint8_t> candidate(rowbytes + 1);
+
+  // We need the previous row (unfiltered) to filter the first row
+  if (block.y0 > 0)
+    fill_png_row(fop, img, color_type, block.y0 - 1, prev.data());
+
+  z_stream zstream;
+  zstream.zalloc = (alloc_func)0;
+  zstream.zfree = (free_func)0;
+  zstream.opaque = (voidpf)0;
+  // Raw deflate stream (without zlib header/trailer) so the blocks
+  // can be concatenated.
+  int err = deflateInit2(&zstream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+  if (err != Z_OK) {
+    block.error = fmt::format("ZLib error {} in deflateInit2().", err);
+    return;
+  }
+
+  block.adler = adler32(0L, Z_NULL, 0);
+  std::vector<uint8_t> compressed(64 * 1024);
+
+  for (png_uint_32 y = block.y0; y < block.y1; ++y) {
+    fill_png_row(fop, img, color_type, y, row.data());
+
+    best[0] = 0;
+    int bestSum = filter_png_row(0, row.data(), prev.data(), rowbytes, bpp, &best[1]);
+    if (adaptive) {
+      for (int type = 1; type <= 4; ++type) {
+        candidate[0] = type;
+        const int sum = filter_png_row(type, row.data(), prev.data(), rowbytes, bpp, &candidate[1]);
+        if (sum < bestSum) {
+          bestSum = sum;
+          std::swap(best, candidate);
+        }
+      }
+    }
+    block.adler = adler32(block.adler, best.data(), best.size());
+
+    // The last block finishes the stream, the other ones are aligned
+    // to a byte boundary with a sync flush (so the next block can be
+    // appended).
+    int flush = Z_NO_FLUSH;
+    if (y == block.y1 - 1)
+      flush = (block.last ? Z_FINISH : Z_SYNC_FLUSH);
+
+    zstream.next_in = (Bytef*)best.data();
+    zstream.avail_in = best.size();
+    do {
+      zstream.next_out = (Bytef*)compressed.data();
+      zstream.avail_out = compressed.size();
+
+      err = deflate(&zstream, flush);
+      if (err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR) {
+        deflateEnd(&zstream);
+        block.error = fmt::format("ZLib error {} in deflate().", err);
+        return;
+      }
+
+      const int output_bytes = compressed.size() - zstream.avail_out;
+      if (output_bytes > 0)
+        block.data.insert(block.data.end(), compressed.begin(), compressed.begin() + output_bytes);
+    } while (zstream.avail_out == 0);
+
+    std::swap(prev, row);
+  }
+
+  deflateEnd(&zstream);
+}
+
+// Writes the IDAT chunks of the image with one zlib stream created
+// from blocks of rows that are filtered and compressed in parallel
+// (the same technique used by pigz).
+static bool write_png_idat_in_parallel(FileOp* fop,
+                                       png_structp png,
+                                       png_infop info,
+                                       const FileAbstractImage* img,
+                                       const int color_type,
+                                       const int level)
+{
+  const png_uint_32 height = img->spec().height();
+  const int rowbytes = int(png_get_rowbytes(png, info));
+  const int bpp = std::max<int>(1, png_get_channels(png, info));
+  const int rowsPerBlock = std::max(1, kPngBlockSize / (rowbytes + 1));
+  const int blocksPerBatch = 2 * TaskScheduler::instance()->threads();
+
+  uLong adler = adler32(0L, Z_NULL, 0);
+  bool first = true;
+
+  for (png_uint_32 y = 0; y < height;) {
+    std::vector<PngBlock> blocks;
+    for (int i = 0; i < blocksPerBatch && y < height; ++i) {
+      PngBlock block;
+      block.y0 = y;
+      block.y1 = std::min<png_uint_32>(height, y + rowsPerBlock);
+      block.last = (block.y1 == height);
+      blocks.push_back(std::move(block));
+      y = blocks.back().y1;
+    }
+
+    doc::TaskGroup tasks;
+    for (PngBlock& block : blocks) {
+      tasks.run([&block, fop, img, color_type, rowbytes, bpp, level] {
+        try {
+          compress_png_block(fop, img, color_type, rowbytes, bpp, level, block);
+        }
+        catch (const std::exception& ex) {
+          block.error = ex.what();
+        }
+      });
+    }
+    tasks.wait();
+
+    // Write the blocks in order (each one in its own IDAT chunk)
+    for (PngBlock& block : blocks) {
+      if (!block.error.empty()) {
+        fop->setError("%s\n", block.error.c_str());
+        return false;
+      }
+
+      std::vector<uint8_t> data;
+      data.reserve(block.data.size() + 6);
+      if (first) {
+        // zlib header (32K window, FLEVEL according to the level)
+        data.push_back(0x78);
+        data.push_back(level == Z_BEST_SPEED ? 0x01 : 0xDA);
+        first = false;
+      }
+      data.insert(data.end(), block.data.begin(), block.data.end());
+
+      adler = adler32_combine(adler,
+                              block.adler,
+                              z_off_t(block.y1 - block.y0) * (rowbytes + 1));
+      if (block.last) {
+        data.push_back((adler >> 24) & 0xff);
+        data.push_back((adler >> 16) & 0xff);
+        data.push_back((adler >> 8) & 0xff);
+        data.push_back(adler & 0xff);
+      }
+
+      png_write_chunk(png, (png_const_bytep) "IDAT", data.data(), data.size());
+    }
+
+    fop->setProgress(double(y) / double(height));
+  }
+  return true;
+}
+
 bool PngFormat::onSave(FileOp* fop)
 {
   png_infop info;
@@ -491,7 +854,7 @@ bool PngFormat::onSave(FileOp* fop)
   png_bytep row_pointer;
   int color_type = 0;
 
-  FileHandle handle(open_file_with_exception_sync_on_close(fop->filename(), "wb"));
+  FileHandle handle(fop->openFileForWriting());
   FILE* fp = handle.get();
 
   png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING,
@@ -625,118 +988,49 @@ bool PngFormat::onSave(FileOp* fop)
   png_write_info(png, info);
   png_set_packing(png);
 
-  row_pointer = (png_bytep)png_malloc(png, png_get_rowbytes(png, info));
-
-  for (png_uint_32 y = 0; y < height; ++y) {
-    uint8_t* dst_address = row_pointer;
-
-    if (png_get_color_type(png, info) == PNG_COLOR_TYPE_RGB_ALPHA) {
-      unsigned int x, c, a;
-      bool opaque = true;
-
-      if (spec.colorMode() == ColorMode::RGB) {
-        auto src_address = (const uint32_t*)img->getScanline(y);
-
-        for (x = 0; x < width; ++x) {
-          c = *(src_address++);
-          a = rgba_geta(c);
-
-          if (opaque) {
-            if (a < 255)
-              opaque = false;
-            else if (fix_one_alpha_pixel && x == width - 1 && y == height - 1)
-              a = 254;
-          }
-
-          *(dst_address++) = rgba_getr(c);
-          *(dst_address++) = rgba_getg(c);
-          *(dst_address++) = rgba_getb(c);
-          *(dst_address++) = a;
-        }
-      }
-      // In case that we are converting an indexed image to RGB just
-      // to convert one pixel with alpha=254.
-      else if (spec.colorMode() == ColorMode::INDEXED) {
-        auto src_address = (const uint8_t*)img->getScanline(y);
-        unsigned int x, c;
-        int r, g, b, a;
-        bool opaque = true;
-
-        for (x = 0; x < width; ++x) {
-          c = *(src_address++);
-          fop->sequenceGetColor(c, &r, &g, &b);
-          fop->sequenceGetAlpha(c, &a);
-
-          if (opaque) {
-            if (a < 255)
-              opaque = false;
-            else if (fix_one_alpha_pixel && x == width - 1 && y == height - 1)
-              a = 254;
-          }
-
-          *(dst_address++) = r;
-          *(dst_address++) = g;
-          *(dst_address++) = b;
-          *(dst_address++) = a;
-        }
-      }
+  // Speed/size trade-off (the document options have priority over
+  // the preferences)
+  PngOptions::Compression compression = opts->compression();
+  if (compression == PngOptions::Compression::Default) {
+    switch (fop->config().pngCompression) {
+      case gen::PngCompression::FAST:  compression = PngOptions::Compression::Fast; break;
+      case gen::PngCompression::SMALL: compression = PngOptions::Compression::Small; break;
+      default:                         break;
     }
-    else if (png_get_color_type(png, info) == PNG_COLOR_TYPE_RGB) {
-      auto src_address = (const uint32_t*)img->getScanline(y);
-      unsigned int x, c;
-
-      for (x = 0; x < width; ++x) {
-        c = *(src_address++);
-        *(dst_address++) = rgba_getr(c);
-        *(dst_address++) = rgba_getg(c);
-        *(dst_address++) = rgba_getb(c);
-      }
-    }
-    else if (png_get_color_type(png, info) == PNG_COLOR_TYPE_GRAY_ALPHA) {
-      auto src_address = (const uint16_t*)img->getScanline(y);
-      unsigned int x, c, a;
-      bool opaque = true;
+  }
 
-      for (x = 0; x < width; x++) {
-        c = *(src_address++);
-        a = graya_geta(c);
+  if (compression == PngOptions::Compression::Default) {
+    row_pointer = (png_bytep)png_malloc(png, png_get_rowbytes(png, info));
 
-        if (opaque) {
-          if (a < 255)
-            opaque = false;
-          else if (fix_one_alpha_pixel && x == width - 1 && y == height - 1)
-            a = 254;
-        }
+    for (png_uint_32 y = 0; y < height; ++y) {
+      fill_png_row(fop, img, color_type, y, row_pointer);
+      png_write_rows(png, &row_pointer, 1);
 
-        *(dst_address++) = graya_getv(c);
-        *(dst_address++) = a;
-      }
+      fop->setProgress((double)(y + 1) / (double)(height));
     }
-    else if (png_get_color_type(png, info) == PNG_COLOR_TYPE_GRAY) {
-      auto src_address = (const uint16_t*)img->getScanline(y);
-      unsigned int x, c;
 
-      for (x = 0; x < width; ++x) {
-        c = *(src_address++);
-        *(dst_address++) = graya_getv(c);
-      }
-    }
-    else if (png_get_color_type(png, info) == PNG_COLOR_TYPE_PALETTE) {
-      auto src_address = (const uint8_t*)img->getScanline(y);
-      unsigned int x;
+    png_free(png, row_pointer);
+    png_write_end(png, info);
+  }
+  else {
+    const int level = (compression == PngOptions::Compression::Fast ? Z_BEST_SPEED :
+                                                                       Z_BEST_COMPRESSION);
+    if (!write_png_idat_in_parallel(fop, png, info, img, color_type, level))
+      return false;
 
-      for (x = 0; x < width; ++x)
-        *(dst_address++) = *(src_address++);
+    // png_write_end() cannot be used as libpng didn't write the IDAT
+    // chunks, so we write the user chunks after IDAT and IEND.
+    for (const auto& chunk : opts->chunks()) {
+      if ((chunk.location & PNG_AFTER_IDAT) && chunk.name.size() == 4) {
+        png_write_chunk(png,
+                        (png_const_bytep)chunk.name.c_str(),
+                        (png_const_bytep)chunk.data.data(),
+                        chunk.data.size());
+      }
     }
-
-    png_write_rows(png, &row_pointer, 1);
-
-    fop->setProgress((double)(y + 1) / (double)(height));
+    png_write_chunk(png, (png_const_bytep) "IEND", nullptr, 0);
   }
 
-  png_free(png, row_pointer);
-  png_write_end(png, info);
-
   if (spec.colorMode() == ColorMode::INDEXED) {
     png_free(png, palette);
     palette = nullptr;
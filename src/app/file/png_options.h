@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -25,6 +25,13 @@ public:
 
   using Chunks = std::vector<Chunk>;
 
+  // Speed/size trade-off used to encode the image. Fast and Small
+  // choose the filter of each row with an adaptive heuristic and
+  // compress blocks of rows in parallel (with the fastest or the best
+  // zlib compression level). Default uses the png.compression
+  // preference (which is the libpng encoder by default).
+  enum class Compression { Default, Fast, Small };
+
   void addChunk(Chunk&& chunk) { m_userChunks.emplace_back(std::move(chunk)); }
 
   bool isEmpty() const { return m_userChunks.empty(); }
@@ -33,8 +40,12 @@ public:
 
   const Chunks& chunks() const { return m_userChunks; }
 
+  Compression compression() const { return m_compression; }
+  void setCompression(Compression compression) { m_compression = compression; }
+
 private:
   Chunks m_userChunks;
+  Compression m_compression = Compression::Default;
 };
 
 } // namespace app
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2021  Igara Studio S.A.
+// Copyright (C) 2021-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -13,8 +13,13 @@
 #include "doc/palette.h"
 #include "doc/slice.h"
 #include "doc/sprite.h"
+#include "doc/task_group.h"
 #include "psd/psd.h"
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 namespace app {
 
 doc::PixelFormat psd_cmode_to_ase_format(const psd::ColorMode mode)
@@ -62,7 +67,7 @@ class PsdFormat : public FileFormat {
 
   dio::FileFormat onGetDioFormat() const override { return dio::FileFormat::PSD_IMAGE; }
 
-  int onGetFlags() const override { return FILE_SUPPORT_LOAD; }
+  int onGetFlags() const override { return FILE_SUPPORT_LOAD | FILE_SUPPORT_MEMORY; }
 
   bool onLoad(FileOp* fop) override;
   bool onSave(FileOp* fop) override;
@@ -73,8 +78,79 @@ FileFormat* CreatePsdFormat()
   return new PsdFormat();
 }
 
+namespace {
+
+// Normalized 8-bit values of each channel of an image (as they are
+// received from the decoder). Slots are 0=red/gray/index, 1=green,
+// 2=blue, 3=alpha/transparency mask. An empty plane means that the
+// channel wasn't received, so the current value of the image is kept.
+struct PsdPlanes {
+  doc::ImageRef image;
+  std::vector<uint8_t> slots[4];
+  int lastSlot = -1;
+  bool hasTransparentChannel = false;
+};
+
+// Composes the received channels in the image (this can be done in
+// a background thread, as the image is not used by the decoder
+// anymore).
+void compose_psd_planes(const PsdPlanes& planes)
+{
+  Image* image = planes.image.get();
+  const uint8_t* r = (planes.slots[0].empty() ? nullptr : planes.slots[0].data());
+  const uint8_t* g = (planes.slots[1].empty() ? nullptr : planes.slots[1].data());
+  const uint8_t* b = (planes.slots[2].empty() ? nullptr : planes.slots[2].data());
+  const uint8_t* a = (planes.slots[3].empty() ? nullptr : planes.slots[3].data());
+
+  // Without a transparent channel the alpha is opaque (except if the
+  // last received channel is the alpha channel).
+  auto alpha = [&planes, a](const int i, const int oldAlpha) -> int {
+    if (!planes.hasTransparentChannel)
+      return (planes.lastSlot == 3 ? a[i] : 255);
+    return (a ? a[i] : oldAlpha);
+  };
+
+  const int w = image->width();
+  for (int y = 0, i = 0; y < image->height(); ++y) {
+    switch (image->pixelFormat()) {
+      case IMAGE_RGB: {
+        auto dst = (RgbTraits::address_t)image->getPixelAddress(0, y);
+        for (int x = 0; x < w; ++x, ++i, ++dst) {
+          const color_t c = *dst;
+          *dst = rgba(r ? r[i] : rgba_getr(c),
+                      g ? g[i] : rgba_getg(c),
+                      b ? b[i] : rgba_getb(c),
+                      alpha(i, rgba_geta(c)));
+        }
+        break;
+      }
+      case IMAGE_GRAYSCALE: {
+        auto dst = (GrayscaleTraits::address_t)image->getPixelAddress(0, y);
+        for (int x = 0; x < w; ++x, ++i, ++dst) {
+          const color_t c = *dst;
+          *dst = graya(r ? r[i] : graya_getv(c), alpha(i, graya_geta(c)));
+        }
+        break;
+      }
+      case IMAGE_INDEXED: {
+        auto dst = (IndexedTraits::address_t)image->getPixelAddress(0, y);
+        if (r)
+          std::copy(r + i, r + i + w, dst);
+        i += w;
+        break;
+      }
+    }
+  }
+}
+
+} // anonymous namespace
+
 class PsdDecoderDelegate : public psd::DecoderDelegate {
 public:
+  // Maximum number of layers that can be waiting to be composed (to
+  // limit the memory used by the decoded channels).
+  static constexpr std::size_t kMaxPendingLayers = 8;
+
   PsdDecoderDelegate()
     : m_currentImage(nullptr)
     , m_currentLayer(nullptr)
@@ -86,7 +162,14 @@ public:
   {
   }
 
-  Sprite* getSprite() { return assembleDocument(); }
+  ~PsdDecoderDelegate() { waitPendingLayers(); }
+
+  Sprite* getSprite()
+  {
+    composeCurrentImage(false);
+    waitPendingLayers();
+    return assembleDocument();
+  }
 
   void onFileHeader(const psd::FileHeader& header) override
   {
@@ -135,6 +218,8 @@ public:
   // is about to be read
   void onBeginLayer(const psd::LayerRecord& layerRecord) override
   {
+    composeCurrentImage(false);
+
     if (layerRecord.isOpenGroup()) {
       LayerGroup* layerGroup = new LayerGroup(m_sprite);
       if (m_groups.empty())
@@ -172,8 +257,13 @@ public:
         m_layerHasTransparentChannel = hasTransparency(layerRecord.channels.size());
       }
       else {
+        // The channels are received in an existing image, so we wait
+        // its previous channels to be composed.
+        waitPendingLayers();
+
         m_currentLayer = *findIter;
         m_currentImage = m_currentLayer->cel(frame_t(0))->imageRef();
+        m_currentImageIsNew = false;
       }
     }
   }
@@ -182,6 +272,9 @@ public:
   {
     if (!m_framesInfo.empty() && (layerRecord.inFrames.size() == m_framesInfo.size()) &&
         m_currentImage) {
+      // The image is copied in each frame, so it must be composed now
+      composeCurrentImage(false);
+
       std::unique_ptr<Cel> layerCel(m_currentLayer->cel(frame_t(0)));
       LayerImage* imageLayer = static_cast<LayerImage*>(m_currentLayer);
       imageLayer->removeCel(layerCel.get());
@@ -203,6 +296,10 @@ public:
       }
     }
 
+    // Compose the channels of this layer in a background thread
+    // while the decoder reads the next layer.
+    composeCurrentImage(true);
+
     m_currentImage.reset();
     m_currentLayer = nullptr;
     m_layerHasTransparentChannel = false;
@@ -222,6 +319,8 @@ public:
   // Emitted when an image data is about to be transmitted
   void onBeginImage(const psd::ImageData& imageData) override
   {
+    composeCurrentImage(false);
+
     if (!m_currentImage) {
       // Only occurs where there's an image with no layer
       if (m_layers.empty()) {
@@ -266,64 +365,108 @@ public:
     if (!m_currentImage || y >= m_currentImage->height())
       return;
 
+    // The scanline is stored in the plane of its channel, and all
+    // channels are composed in the image at the end of the layer
+    const int slot = channelSlot(chanID);
+    if (!m_planes) {
+      m_planes = std::make_shared<PsdPlanes>();
+      m_planes->image = m_currentImage;
+    }
+    m_planes->lastSlot = slot;
+    m_planes->hasTransparentChannel = m_layerHasTransparentChannel;
+    if (slot < 0)
+      return;
+
+    const int w = m_currentImage->width();
+    std::vector<uint8_t>& plane = m_planes->slots[slot];
+    if (plane.empty())
+      initPlane(slot, plane);
+
     const int dataCount = bytes / (img.depth >= 8 ? (img.depth / 8) : 1);
-    uint8_t* dstGenericAddress = m_currentImage->getPixelAddress(0, y);
+    uint8_t* dst = &plane[std::size_t(y) * w];
+    for (int x = 0; x < dataCount && x < w; ++x)
+      *(dst++) = getNormalizedPixelValue(data, img.depth);
+  }
 
-    if (m_pixelFormat == doc::PixelFormat::IMAGE_INDEXED) {
-      IndexedTraits::address_t dstAddress = (IndexedTraits::address_t)dstGenericAddress;
-      for (int x = 0; x < dataCount && x < m_currentImage->width(); ++x) {
-        *(dstAddress)++ = getNormalizedPixelValue(data, img.depth);
-      }
+private:
+  inline bool hasTransparency(const size_t nchannels)
+  {
+    // RGBA or grayscale image with alpha channel
+    return nchannels == 4 || nchannels == 2;
+  }
+
+  int channelSlot(const psd::ChannelID chanID) const
+  {
+    if (m_pixelFormat == doc::PixelFormat::IMAGE_INDEXED)
+      return 0;
+    switch (chanID) {
+      case psd::ChannelID::Red:   return 0;
+      case psd::ChannelID::Green: return (m_pixelFormat == IMAGE_RGB ? 1 : -1);
+      case psd::ChannelID::Blue:  return (m_pixelFormat == IMAGE_RGB ? 2 : -1);
+      case psd::ChannelID::Alpha:
+      case psd::ChannelID::TransparencyMask: return 3;
+      default:                               return -1;
     }
-    else if (m_pixelFormat == doc::PixelFormat::IMAGE_GRAYSCALE) {
-      GrayscaleTraits::address_t dstAddress = (GrayscaleTraits::address_t)dstGenericAddress;
-      uint8_t v = 0, a = 0;
-      for (int x = 0; x < dataCount && x < m_currentImage->width(); ++x) {
-        const GrayscaleTraits::pixel_t pixel = *dstAddress;
-        const uint8_t newPixelValue = getNormalizedPixelValue(data, img.depth);
-        if (chanID == psd::ChannelID::Red) {
-          v = newPixelValue;
-          a = m_layerHasTransparentChannel ? graya_geta(pixel) : 255;
-        }
-        else if (chanID == psd::ChannelID::Alpha || chanID == psd::ChannelID::TransparencyMask) {
-          a = newPixelValue;
-          v = graya_getv(pixel);
+  }
+
+  // Initializes the plane with the current values of the channel in
+  // the image (in case that some scanlines are not received).
+  void initPlane(const int slot, std::vector<uint8_t>& plane) const
+  {
+    const Image* image = m_currentImage.get();
+    const int w = image->width();
+    plane.resize(std::size_t(w) * image->height(), 0);
+
+    // New images are cleared with zeros
+    if (m_currentImageIsNew)
+      return;
+
+    uint8_t* dst = plane.data();
+    for (int y = 0; y < image->height(); ++y) {
+      for (int x = 0; x < w; ++x) {
+        const color_t c = image->getPixel(x, y);
+        switch (m_pixelFormat) {
+          case IMAGE_RGB:
+            *(dst++) = (slot == 0 ? rgba_getr(c) :
+                        slot == 1 ? rgba_getg(c) :
+                        slot == 2 ? rgba_getb(c) :
+                                    rgba_geta(c));
+            break;
+          case IMAGE_GRAYSCALE: *(dst++) = (slot == 0 ? graya_getv(c) : graya_geta(c)); break;
+          default:              *(dst++) = c; break;
         }
-        *(dstAddress++) = graya(v, a);
       }
     }
-    else if (m_pixelFormat == doc::PixelFormat::IMAGE_RGB) {
-      RgbTraits::address_t dstAddress = (RgbTraits::address_t)dstGenericAddress;
-      uint8_t r, g, b, a;
-      for (int x = 0; x < dataCount && x < m_currentImage->width(); ++x) {
-        const uint8_t newPixelValue = getNormalizedPixelValue(data, img.depth);
-        const color_t c = *(dstAddress);
-        r = rgba_getr(c);
-        g = rgba_getg(c);
-        b = rgba_getb(c);
-        a = m_layerHasTransparentChannel ? rgba_geta(c) : 255;
-        if (chanID == psd::ChannelID::Red) {
-          r = newPixelValue;
-        }
-        else if (chanID == psd::ChannelID::Green) {
-          g = newPixelValue;
-        }
-        else if (chanID == psd::ChannelID::Blue) {
-          b = newPixelValue;
-        }
-        else if (chanID == psd::ChannelID::Alpha || chanID == psd::ChannelID::TransparencyMask) {
-          a = newPixelValue;
-        }
-        *(dstAddress++) = rgba(r, g, b, a);
-      }
+  }
+
+  // Composes the received channels of the current image, in a
+  // background thread if "async" is true.
+  void composeCurrentImage(const bool async)
+  {
+    if (!m_planes)
+      return;
+
+    std::shared_ptr<PsdPlanes> planes = std::move(m_planes);
+    if (planes->image == m_currentImage)
+      m_currentImageIsNew = false;
+
+    if (!async) {
+      compose_psd_planes(*planes);
+      return;
     }
+
+    if (m_pendingLayers == kMaxPendingLayers)
+      waitPendingLayers();
+    ++m_pendingLayers;
+    m_composeTasks.run([planes] { compose_psd_planes(*planes); });
   }
 
-private:
-  inline bool hasTransparency(const size_t nchannels)
+  // Waits all the layers pending to be composed (composing them in
+  // this thread if they weren't started yet).
+  void waitPendingLayers()
   {
-    // RGBA or grayscale image with alpha channel
-    return nchannels == 4 || nchannels == 2;
+    m_composeTasks.wait();
+    m_pendingLayers = 0;
   }
 
   void linkNewCel(Layer* layer, doc::ImageRef image)
@@ -384,6 +527,7 @@ private:
 
     m_currentImage.reset(Image::create(m_pixelFormat, width, height));
     clear_image(m_currentImage.get(), 0);
+    m_currentImageIsNew = true;
   }
 
   doc::ImageRef m_currentImage;
@@ -397,11 +541,15 @@ private:
   std::vector<psd::FrameInformation> m_framesInfo;
   Palette m_palette;
   bool m_layerHasTransparentChannel;
+  bool m_currentImageIsNew = false;
+  std::shared_ptr<PsdPlanes> m_planes;
+  std::size_t m_pendingLayers = 0;
+  doc::TaskGroup m_composeTasks;
 };
 
 bool PsdFormat::onLoad(FileOp* fop)
 {
-  base::FileHandle fileHandle = base::open_file_with_exception(fop->filename(), "rb");
+  base::FileHandle fileHandle = fop->openFileForReading();
   FILE* f = fileHandle.get();
   psd::StdioFileInterface fileInterface(f);
   PsdDecoderDelegate pDelegate;
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2023  Igara Studio S.A.
+// Copyright (C) 2023-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -8,6 +8,8 @@
   #include "config.h"
 #endif
 
+#include "app/file/qoi_image.h"
+
 #include "app/file/file.h"
 #include "app/file/file_format.h"
 #include "base/file_handle.h"
@@ -16,10 +18,234 @@
 #define QOI_IMPLEMENTATION
 #include "qoi.h"
 
+#include <climits>
+#include <cstring>
+
 namespace app {
 
 using namespace base;
 
+namespace {
+
+// Reads the header of the QOI image. Returns false if it's not a
+// valid QOI file.
+bool qoi_read_header(const unsigned char* bytes, const int size, qoi_desc* desc)
+{
+  if (size < QOI_HEADER_SIZE + (int)sizeof(qoi_padding))
+    return false;
+
+  int p = 0;
+  const unsigned int magic = qoi_read_32(bytes, &p);
+  desc->width = qoi_read_32(bytes, &p);
+  desc->height = qoi_read_32(bytes, &p);
+  desc->channels = bytes[p++];
+  desc->colorspace = bytes[p++];
+
+  return (magic == QOI_MAGIC && desc->width > 0 && desc->height > 0 &&
+          (desc->channels == 3 || desc->channels == 4) && desc->colorspace <= 1 &&
+          desc->height < QOI_PIXELS_MAX / desc->width);
+}
+
+// Same as qoi_decode() but the pixels are stored directly in the
+// given image, which contains only the "bounds" region of the QOI
+// image. QOI chunks must be decoded sequentially, so we cannot skip
+// the pixels before the bounds, but we can stop decoding after the
+// last row of the bounds.
+void qoi_decode_region(const unsigned char* bytes,
+                       const int size,
+                       const qoi_desc& desc,
+                       const gfx::Rect& bounds,
+                       doc::Image* image)
+{
+  qoi_rgba_t index[64];
+  std::memset(index, 0, sizeof(index));
+
+  qoi_rgba_t px;
+  px.rgba.r = 0;
+  px.rgba.g = 0;
+  px.rgba.b = 0;
+  px.rgba.a = 255;
+
+  const int chunks_len = size - (int)sizeof(qoi_padding);
+  int p = QOI_HEADER_SIZE;
+  int run = 0;
+
+  for (int y = 0; y < bounds.y2(); ++y) {
+    uint32_t* dst = (y >= bounds.y ? (uint32_t*)image->getPixelAddress(0, y - bounds.y) :
+                                     nullptr);
+
+    for (int x = 0; x < int(desc.width); ++x) {
+      if (run > 0) {
+        --run;
+      }
+      else if (p < chunks_len) {
+        const int b1 = bytes[p++];
+
+        if (b1 == QOI_OP_RGB) {
+          px.rgba.r = bytes[p++];
+          px.rgba.g = bytes[p++];
+          px.rgba.b = bytes[p++];
+        }
+        else if (b1 == QOI_OP_RGBA) {
+          px.rgba.r = bytes[p++];
+          px.rgba.g = bytes[p++];
+          px.rgba.b = bytes[p++];
+          px.rgba.a = bytes[p++];
+        }
+        else if ((b1 & QOI_MASK_2) == QOI_OP_INDEX) {
+          px = index[b1];
+        }
+        else if ((b1 & QOI_MASK_2) == QOI_OP_DIFF) {
+          px.rgba.r += ((b1 >> 4) & 0x03) - 2;
+          px.rgba.g += ((b1 >> 2) & 0x03) - 2;
+          px.rgba.b += (b1 & 0x03) - 2;
+        }
+        else if ((b1 & QOI_MASK_2) == QOI_OP_LUMA) {
+          const int b2 = bytes[p++];
+          const int vg = (b1 & 0x3f) - 32;
+          px.rgba.r += vg - 8 + ((b2 >> 4) & 0x0f);
+          px.rgba.g += vg;
+          px.rgba.b += vg - 8 + (b2 & 0x0f);
+        }
+        else if ((b1 & QOI_MASK_2) == QOI_OP_RUN) {
+          run = (b1 & 0x3f);
+        }
+
+        index[QOI_COLOR_HASH(px) & (64 - 1)] = px;
+      }
+
+      if (dst && x >= bounds.x && x < bounds.x2()) {
+        *(dst++) =
+          doc::rgba(px.rgba.r, px.rgba.g, px.rgba.b, (desc.channels == 4 ? px.rgba.a : 255));
+      }
+    }
+  }
+}
+
+} // anonymous namespace
+
+// Same as qoi_encode() but the pixels are read directly from the
+// image rows.
+bool encode_qoi_image(const doc::Image* image,
+                      base::buffer& output,
+                      const bool withAlpha,
+                      const bool sRGB)
+{
+  if (image->pixelFormat() != doc::IMAGE_RGB)
+    return false;
+
+  const int w = image->width();
+  const int h = image->height();
+  if (w <= 0 || h <= 0 || h >= QOI_PIXELS_MAX / w)
+    return false;
+
+  // Worst case: each pixel uses a QOI_OP_RGBA chunk
+  const int channels = (withAlpha ? 4 : 3);
+  output.resize(QOI_HEADER_SIZE + std::size_t(w) * h * (channels + 1) + sizeof(qoi_padding));
+  unsigned char* bytes = output.data();
+
+  int p = 0;
+  qoi_write_32(bytes, &p, QOI_MAGIC);
+  qoi_write_32(bytes, &p, w);
+  qoi_write_32(bytes, &p, h);
+  bytes[p++] = channels;
+  bytes[p++] = (sRGB ? QOI_SRGB : QOI_LINEAR);
+
+  qoi_rgba_t index[64];
+  std::memset(index, 0, sizeof(index));
+
+  qoi_rgba_t px, px_prev;
+  px_prev.rgba.r = 0;
+  px_prev.rgba.g = 0;
+  px_prev.rgba.b = 0;
+  px_prev.rgba.a = 255;
+  px = px_prev;
+
+  int run = 0;
+  for (int y = 0; y < h; ++y) {
+    auto src = (const uint32_t*)image->getPixelAddress(0, y);
+    for (int x = 0; x < w; ++x, ++src) {
+      const uint32_t c = *src;
+      px.rgba.r = doc::rgba_getr(c);
+      px.rgba.g = doc::rgba_getg(c);
+      px.rgba.b = doc::rgba_getb(c);
+      if (withAlpha)
+        px.rgba.a = doc::rgba_geta(c);
+
+      if (px.v == px_prev.v) {
+        ++run;
+        if (run == 62 || (y == h - 1 && x == w - 1)) {
+          bytes[p++] = QOI_OP_RUN | (run - 1);
+          run = 0;
+        }
+      }
+      else {
+        if (run > 0) {
+          bytes[p++] = QOI_OP_RUN | (run - 1);
+          run = 0;
+        }
+
+        const int index_pos = QOI_COLOR_HASH(px) & (64 - 1);
+        if (index[index_pos].v == px.v) {
+          bytes[p++] = QOI_OP_INDEX | index_pos;
+        }
+        else {
+          index[index_pos] = px;
+
+          if (px.rgba.a == px_prev.rgba.a) {
+            const signed char vr = px.rgba.r - px_prev.rgba.r;
+            const signed char vg = px.rgba.g - px_prev.rgba.g;
+            const signed char vb = px.rgba.b - px_prev.rgba.b;
+            const signed char vg_r = vr - vg;
+            const signed char vg_b = vb - vg;
+
+            if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2) {
+              bytes[p++] = QOI_OP_DIFF | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2);
+            }
+            else if (vg_r > -9 && vg_r < 8 && vg > -33 && vg < 32 && vg_b > -9 && vg_b < 8) {
+              bytes[p++] = QOI_OP_LUMA | (vg + 32);
+              bytes[p++] = (vg_r + 8) << 4 | (vg_b + 8);
+            }
+            else {
+              bytes[p++] = QOI_OP_RGB;
+              bytes[p++] = px.rgba.r;
+              bytes[p++] = px.rgba.g;
+              bytes[p++] = px.rgba.b;
+            }
+          }
+          else {
+            bytes[p++] = QOI_OP_RGBA;
+            bytes[p++] = px.rgba.r;
+            bytes[p++] = px.rgba.g;
+            bytes[p++] = px.rgba.b;
+            bytes[p++] = px.rgba.a;
+          }
+        }
+      }
+      px_prev = px;
+    }
+  }
+
+  for (int i = 0; i < (int)sizeof(qoi_padding); ++i)
+    bytes[p++] = qoi_padding[i];
+
+  output.resize(p);
+  return true;
+}
+
+doc::Image* decode_qoi_image(const uint8_t* data,
+                             const std::size_t size,
+                             const doc::ImageBufferPtr& buffer)
+{
+  qoi_desc desc;
+  if (size > std::size_t(INT_MAX) || !qoi_read_header(data, int(size), &desc))
+    return nullptr;
+
+  doc::Image* image = doc::Image::create(doc::IMAGE_RGB, desc.width, desc.height, buffer);
+  qoi_decode_region(data, int(size), desc, image->bounds(), image);
+  return image;
+}
+
 class QoiFormat : public FileFormat {
   const char* onGetName() const override { return "qoi"; }
 
@@ -30,7 +256,7 @@ class QoiFormat : public FileFormat {
   int onGetFlags() const override
   {
     return FILE_SUPPORT_LOAD | FILE_SUPPORT_SAVE | FILE_SUPPORT_RGB | FILE_SUPPORT_RGBA |
-           FILE_SUPPORT_SEQUENCES | FILE_ENCODE_ABSTRACT_IMAGE;
+           FILE_SUPPORT_SEQUENCES | FILE_ENCODE_ABSTRACT_IMAGE | FILE_SUPPORT_MEMORY;
   }
 
   bool onLoad(FileOp* fop) override;
@@ -46,7 +272,7 @@ FileFormat* CreateQoiFormat()
 
 bool QoiFormat::onLoad(FileOp* fop)
 {
-  FileHandle handle(open_file_with_exception(fop->filename(), "rb"));
+  FileHandle handle(fop->openFileForReading());
   FILE* f = handle.get();
 
   fseek(f, 0, SEEK_END);
@@ -60,36 +286,22 @@ bool QoiFormat::onLoad(FileOp* fop)
     return false;
 
   qoi_desc desc;
-  auto bytes_read = fread(data, 1, size, f);
-  auto pixels = qoi_decode(data, bytes_read, &desc, 0);
-  QOI_FREE(data);
-  if (!pixels)
+  const int bytes_read = int(fread(data, 1, size, f));
+  if (!qoi_read_header((const unsigned char*)data, bytes_read, &desc)) {
+    QOI_FREE(data);
     return false;
+  }
 
-  ImageRef image = fop->sequenceImageToLoad(IMAGE_RGB, desc.width, desc.height);
-  if (!image)
+  // Region of interest to load (e.g. only the --crop region)
+  const gfx::Rect bounds = fop->loadBounds(gfx::Size(desc.width, desc.height));
+  ImageRef image = fop->sequenceImageToLoad(IMAGE_RGB, desc.width, desc.height, bounds);
+  if (!image) {
+    QOI_FREE(data);
     return false;
-
-  auto src = (const uint8_t*)pixels;
-  for (int y = 0; y < desc.height; ++y) {
-    auto dst = (uint32_t*)image->getPixelAddress(0, y);
-    switch (desc.channels) {
-      case 4:
-        for (int x = 0; x < desc.width; ++x, ++dst) {
-          *dst = doc::rgba(src[0], src[1], src[2], src[3]);
-          src += 4;
-        }
-        break;
-      case 3:
-        for (int x = 0; x < desc.width; ++x, ++dst) {
-          *dst = doc::rgba(src[0], src[1], src[2], 255);
-          src += 3;
-        }
-        break;
-    }
   }
 
-  QOI_FREE(pixels);
+  qoi_decode_region((const unsigned char*)data, bytes_read, desc, bounds, image.get());
+  QOI_FREE(data);
 
   if (desc.channels == 4)
     fop->sequenceSetHasAlpha(true);
@@ -120,61 +332,18 @@ bool QoiFormat::onLoad(FileOp* fop)
 bool QoiFormat::onSave(FileOp* fop)
 {
   const FileAbstractImage* img = fop->abstractImageToSave();
-  FileHandle handle(open_file_with_exception_sync_on_close(fop->filename(), "wb"));
+  FileHandle handle(fop->openFileForWriting());
   FILE* f = handle.get();
   doc::ImageRef image = img->getScaledImage();
 
-  qoi_desc desc;
-  desc.width = img->width();
-  desc.height = img->height();
-  desc.channels = (img->needAlpha() ? 4 : 3);
-
-  if (img->osColorSpace() && img->osColorSpace()->isSRGB()) {
-    desc.colorspace = QOI_SRGB;
-  }
-  else {
-    // TODO support or warn about the color space
-    desc.colorspace = QOI_LINEAR;
-  }
-
-  auto pixels = (uint8_t*)QOI_MALLOC(desc.width * desc.height * desc.channels);
-  if (!pixels)
-    return false;
-
-  auto dst = pixels;
-  for (int y = 0; y < desc.height; ++y) {
-    auto src = (uint32_t*)image->getPixelAddress(0, y);
-    switch (desc.channels) {
-      case 4:
-        for (int x = 0; x < desc.width; ++x, ++src) {
-          uint32_t c = *src;
-          dst[0] = doc::rgba_getr(c);
-          dst[1] = doc::rgba_getg(c);
-          dst[2] = doc::rgba_getb(c);
-          dst[3] = doc::rgba_geta(c);
-          dst += 4;
-        }
-        break;
-      case 3:
-        for (int x = 0; x < desc.width; ++x, ++src) {
-          uint32_t c = *src;
-          dst[0] = doc::rgba_getr(c);
-          dst[1] = doc::rgba_getg(c);
-          dst[2] = doc::rgba_getb(c);
-          dst += 3;
-        }
-        break;
-    }
-  }
+  // TODO support or warn about the color space
+  const bool sRGB = (img->osColorSpace() && img->osColorSpace()->isSRGB());
 
-  int size = 0;
-  auto encoded = qoi_encode(pixels, &desc, &size);
-  QOI_FREE(pixels);
-  if (!encoded)
+  base::buffer encoded;
+  if (!encode_qoi_image(image.get(), encoded, img->needAlpha(), sRGB))
     return false;
 
-  fwrite(encoded, 1, size, f);
-  QOI_FREE(encoded);
+  fwrite(encoded.data(), 1, encoded.size(), f);
 
   if (ferror(handle.get())) {
     fop->setError("Error writing file.\n");
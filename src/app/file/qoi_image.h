@@ -0,0 +1,46 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_FILE_QOI_IMAGE_H_INCLUDED
+#define APP_FILE_QOI_IMAGE_H_INCLUDED
+#pragma once
+
+#include "base/buffer.h"
+#include "doc/image_buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace doc {
+class Image;
+}
+
+namespace app {
+
+// Encodes/decodes RGB images in QOI format directly from/to the rows
+// of the image (without a FileOp and without intermediate copies of
+// the pixels), so it can be used as a fast lossless format for
+// internal data (caches, clipboard, backups, etc.).
+
+// Replaces the content of "output" with the given RGB image encoded
+// in QOI format. Returns false if the image is not an RGB image or
+// it's too big to be encoded.
+bool encode_qoi_image(const doc::Image* image,
+                      base::buffer& output,
+                      bool withAlpha = true,
+                      bool sRGB = true);
+
+// Decodes a QOI image in a new RGB image, using the given buffer (if
+// it's not nullptr) to store the pixels, so it can be reused to
+// decode several images without allocating memory. Returns nullptr
+// if the data is not a valid QOI image.
+doc::Image* decode_qoi_image(const uint8_t* data,
+                             std::size_t size,
+                             const doc::ImageBufferPtr& buffer = doc::ImageBufferPtr());
+
+} // namespace app
+
+#endif
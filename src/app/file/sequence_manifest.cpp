@@ -0,0 +1,86 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/file/sequence_manifest.h"
+
+#include "base/fs.h"
+#include "base/fstream_path.h"
+#include "fmt/format.h"
+#include "ver/info.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+namespace app {
+
+namespace {
+
+// First line of the manifest file (change the version number if the
+// format of the manifest changes). The program version is added to
+// the header too, so a new version (which could encode the files in
+// a different way) saves all frames again.
+const char* kManifestHeader = "aseprite-sequence-manifest 1";
+
+std::string manifest_header()
+{
+  return fmt::format("{} {}", kManifestHeader, get_app_version());
+}
+
+} // anonymous namespace
+
+SequenceManifest::SequenceManifest(const std::string& firstFilename)
+  : m_filename(base::join_path(base::get_file_path(firstFilename),
+                               "." + base::get_file_name(firstFilename) + ".manifest"))
+{
+  std::ifstream f(FSTREAM_PATH(m_filename));
+  std::string line;
+  if (!f || !std::getline(f, line) || line != manifest_header())
+    return;
+
+  // Each line contains "<hash> <size> <filename>"
+  while (std::getline(f, line)) {
+    std::istringstream is(line);
+    std::string hash, filename;
+    Entry entry;
+    if (!(is >> hash >> entry.size) || !std::getline(is >> std::ws, filename))
+      continue;
+
+    entry.hash = std::strtoull(hash.c_str(), nullptr, 16);
+    m_entries[filename] = entry;
+  }
+}
+
+bool SequenceManifest::isUnchanged(const std::string& filename, const uint64_t hash) const
+{
+  auto it = m_entries.find(filename);
+  return (it != m_entries.end() && it->second.hash == hash && base::is_file(filename) &&
+          base::file_size(filename) == it->second.size);
+}
+
+void SequenceManifest::set(const std::string& filename, const uint64_t hash)
+{
+  if (base::is_file(filename))
+    m_entries[filename] = Entry{ hash, base::file_size(filename) };
+  else
+    m_entries.erase(filename);
+}
+
+void SequenceManifest::save() const
+{
+  std::string manifest = manifest_header();
+  manifest.push_back('\n');
+  for (const auto& [filename, entry] : m_entries)
+    manifest += fmt::format("{:016x} {} {}\n", entry.hash, entry.size, filename);
+
+  base::write_file_content(m_filename, (const uint8_t*)manifest.c_str(), manifest.size());
+}
+
+} // namespace app
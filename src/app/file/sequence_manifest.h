@@ -0,0 +1,49 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_FILE_SEQUENCE_MANIFEST_H_INCLUDED
+#define APP_FILE_SEQUENCE_MANIFEST_H_INCLUDED
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace app {
+
+// Hashes of the frames saved in a sequence of files (e.g. with
+// "--save-as frame{frame}.png --incremental"). The manifest is kept
+// in a hidden file next to the first file of the sequence, so frames
+// with the same rendered image as in the previous export can be
+// skipped (leaving their files untouched).
+class SequenceManifest {
+public:
+  // Loads the manifest of the sequence that starts with the given
+  // file (if the manifest exists).
+  explicit SequenceManifest(const std::string& firstFilename);
+
+  // Returns true if the given file was saved with the same hash and
+  // it wasn't modified/deleted since then.
+  bool isUnchanged(const std::string& filename, uint64_t hash) const;
+
+  // Records the hash of a file that was just saved.
+  void set(const std::string& filename, uint64_t hash);
+
+  void save() const;
+
+private:
+  struct Entry {
+    uint64_t hash = 0;
+    std::size_t size = 0;
+  };
+
+  std::string m_filename;
+  std::map<std::string, Entry> m_entries;
+};
+
+} // namespace app
+
+#endif
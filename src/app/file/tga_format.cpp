@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2023  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -26,6 +26,9 @@
 
 #include "tga_options.xml.h"
 
+#include <cstdio>
+#include <vector>
+
 namespace app {
 
 using namespace base;
@@ -42,7 +45,7 @@ class TgaFormat : public FileFormat {
     return FILE_SUPPORT_LOAD | FILE_SUPPORT_SAVE | FILE_SUPPORT_RGB | FILE_SUPPORT_RGBA |
            FILE_SUPPORT_GRAY | FILE_SUPPORT_INDEXED | FILE_SUPPORT_SEQUENCES |
            FILE_SUPPORT_GET_FORMAT_OPTIONS | FILE_SUPPORT_PALETTE_WITH_ALPHA |
-           FILE_ENCODE_ABSTRACT_IMAGE;
+           FILE_ENCODE_ABSTRACT_IMAGE | FILE_SUPPORT_MEMORY;
   }
 
   bool onLoad(FileOp* fop) override;
@@ -73,6 +76,51 @@ private:
   FileOp* m_fop;
 };
 
+// The tga library reads/writes the file byte by byte, so we read/write
+// the whole file in memory and then use this interface to access
+// those bytes (avoiding a locked stdio call for each byte).
+class TgaBufferInterface : public tga::FileInterface {
+public:
+  TgaBufferInterface(std::vector<uint8_t>& data) : m_data(data) {}
+
+  bool ok() const override { return m_ok; }
+  size_t tell() override { return m_pos; }
+  void seek(size_t absPos) override { m_pos = absPos; }
+
+  uint8_t read8() override
+  {
+    if (m_pos < m_data.size())
+      return m_data[m_pos++];
+    m_ok = false;
+    return 0;
+  }
+
+  void write8(uint8_t value) override
+  {
+    if (m_pos < m_data.size())
+      m_data[m_pos] = value;
+    else {
+      m_data.resize(m_pos);
+      m_data.push_back(value);
+    }
+    ++m_pos;
+  }
+
+private:
+  std::vector<uint8_t>& m_data;
+  size_t m_pos = 0;
+  bool m_ok = true;
+};
+
+bool read_whole_file(FILE* f, std::vector<uint8_t>& data)
+{
+  uint8_t buf[64 * 1024];
+  size_t n;
+  while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0)
+    data.insert(data.end(), buf, buf + n);
+  return !std::ferror(f);
+}
+
 bool get_image_spec(const tga::Header& header, ImageSpec& spec)
 {
   switch (header.imageType) {
@@ -105,8 +153,16 @@ bool get_image_spec(const tga::Header& header, ImageSpec& spec)
 
 bool TgaFormat::onLoad(FileOp* fop)
 {
-  FileHandle handle(open_file_with_exception(fop->filename(), "rb"));
-  tga::StdioFileInterface finterface(handle.get());
+  std::vector<uint8_t> data;
+  {
+    FileHandle handle(fop->openFileForReading());
+    if (!read_whole_file(handle.get(), data)) {
+      fop->setError("Error reading file.\n");
+      return false;
+    }
+  }
+
+  TgaBufferInterface finterface(data);
   tga::Decoder decoder(&finterface);
   tga::Header header;
   if (!decoder.readHeader(header)) {
@@ -166,9 +222,10 @@ bool TgaFormat::onLoad(FileOp* fop)
   // Post process gray image pixels (because we use grayscale images
   // with alpha).
   if (header.isGray()) {
-    doc::LockImageBits<GrayscaleTraits> bits(image.get());
-    for (auto it = bits.begin(), end = bits.end(); it != end; ++it) {
-      *it = doc::graya(*it, 255);
+    for (int y = 0; y < image->height(); ++y) {
+      auto p = (GrayscaleTraits::address_t)image->getPixelAddress(0, y);
+      for (int x = 0; x < image->width(); ++x, ++p)
+        *p = doc::graya(*p, 255);
     }
   }
 
@@ -180,14 +237,7 @@ bool TgaFormat::onLoad(FileOp* fop)
   opts->bitsPerPixel(header.bitsPerPixel);
   opts->compress(header.isRle());
   fop->setLoadedFormatOptions(opts);
-
-  if (ferror(handle.get())) {
-    fop->setError("Error reading file.\n");
-    return false;
-  }
-  else {
-    return true;
-  }
+  return true;
 }
 
 #ifdef ENABLE_SAVE
@@ -263,8 +313,8 @@ bool TgaFormat::onSave(FileOp* fop)
   const FileAbstractImage* img = fop->abstractImageToSave();
   const Palette* palette = fop->sequenceGetPalette();
 
-  FileHandle handle(open_file_with_exception_sync_on_close(fop->filename(), "wb"));
-  tga::StdioFileInterface finterface(handle.get());
+  std::vector<uint8_t> data;
+  TgaBufferInterface finterface(data);
   tga::Encoder encoder(&finterface);
   tga::Header header;
 
@@ -291,6 +341,8 @@ bool TgaFormat::onSave(FileOp* fop)
   encoder.writeImage(header, tgaImage);
   encoder.writeFooter();
 
+  FileHandle handle(fop->openFileForWriting());
+  std::fwrite(data.data(), 1, data.size(), handle.get());
   if (ferror(handle.get())) {
     fop->setError("Error writing file.\n");
     return false;
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2023  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2015-2018  David Capello
 // Copyright (C) 2015  Gabriel Rauter
 //
@@ -20,9 +20,11 @@
 #include "app/file/webp_options.h"
 #include "app/ini_file.h"
 #include "app/pref/preferences.h"
+#include "app/task_scheduler.h"
 #include "base/convert_to.h"
 #include "base/file_handle.h"
 #include "doc/doc.h"
+#include "doc/task_group.h"
 #include "ui/manager.h"
 
 #include "webp_options.xml.h"
@@ -31,6 +33,7 @@
 #include <cstdio>
 #include <cstdlib>
 #include <map>
+#include <vector>
 
 #include <webp/demux.h>
 #include <webp/mux.h>
@@ -49,7 +52,8 @@ class WebPFormat : public FileFormat {
   int onGetFlags() const override
   {
     return FILE_SUPPORT_LOAD | FILE_SUPPORT_SAVE | FILE_SUPPORT_RGB | FILE_SUPPORT_RGBA |
-           FILE_SUPPORT_FRAMES | FILE_SUPPORT_GET_FORMAT_OPTIONS | FILE_ENCODE_ABSTRACT_IMAGE;
+           FILE_SUPPORT_FRAMES | FILE_SUPPORT_GET_FORMAT_OPTIONS | FILE_ENCODE_ABSTRACT_IMAGE |
+           FILE_SUPPORT_MEMORY;
   }
 
   bool onLoad(FileOp* fop) override;
@@ -81,7 +85,7 @@ const char* getDecoderErrorMessage(VP8StatusCode statusCode)
 
 bool WebPFormat::onLoad(FileOp* fop)
 {
-  FileHandle handle(open_file_with_exception(fop->filename(), "rb"));
+  FileHandle handle(fop->openFileForReading());
   FILE* fp = handle.get();
 
   long len = 0;
@@ -243,7 +247,7 @@ static int progress_report(int percent, const WebPPicture* pic)
 
 bool WebPFormat::onSave(FileOp* fop)
 {
-  FileHandle handle(open_file_with_exception_sync_on_close(fop->filename(), "wb"));
+  FileHandle handle(fop->openFileForWriting());
   FILE* fp = handle.get();
 
   const FileAbstractImage* sprite = fop->abstractImageToSave();
@@ -281,12 +285,35 @@ bool WebPFormat::onSave(FileOp* fop)
       break;
   }
 
+  // Use threads in the encoder (if libwebp was compiled with
+  // multi-threading support)
+  config.thread_level = 1;
+
   WebPAnimEncoderOptions enc_options;
   WebPAnimEncoderOptionsInit(&enc_options);
   enc_options.anim_params.loop_count = (opts->loop() ? 0 : // 0 = infinite
                                                        1);              // 1 = loop once
+  enc_options.minimize_size = (opts->minimizeSize() ? 1 : 0);
+  if (opts->keyframeInterval() > 0) {
+    enc_options.kmax = opts->keyframeInterval();
+    enc_options.kmin = std::max(1, opts->keyframeInterval() / 2 + 1);
+  }
 
-  ImageRef image(Image::create(IMAGE_RGB, w, h));
+  // Frames are rendered in parallel in batches (and then added to
+  // the encoder in order). We can render in parallel only if the
+  // frames don't need to be resized (as the resize uses the shared
+  // RgbMap of the sprite).
+  std::vector<frame_t> frames;
+  bool parallelRender = true;
+  for (frame_t frame : fop->roi().framesSequence()) {
+    frames.push_back(frame);
+    if (fop->roi().frameBounds(frame).size() != gfx::Size(w, h))
+      parallelRender = false;
+  }
+  const int batchSize = (parallelRender ? TaskScheduler::instance()->threads() : 1);
+  std::vector<ImageRef> images(std::min<std::size_t>(batchSize, frames.size()));
+  for (auto& image : images)
+    image.reset(Image::create(IMAGE_RGB, w, h));
 
   const doc::frame_t totalFrames = fop->roi().frames();
   WriterData wd(fp, fop, totalFrames);
@@ -295,43 +322,61 @@ bool WebPFormat::onSave(FileOp* fop)
   pic.width = w;
   pic.height = h;
   pic.use_argb = true;
-  pic.argb = (uint32_t*)image->getPixelAddress(0, 0);
-  pic.argb_stride = image->rowPixels(); // Stride in pixels (not bytes)
   pic.user_data = &wd;
   pic.progress_hook = progress_report;
 
   WebPAnimEncoder* enc = WebPAnimEncoderNew(w, h, &enc_options);
   int timestamp_ms = 0;
-  for (frame_t frame : fop->roi().framesSequence()) {
-    // Render the frame in the bitmap
-    clear_image(image.get(), image->maskColor());
-    sprite->renderFrame(frame, fop->roi().frameBounds(frame), image.get());
-
-    // Switch R <-> B channels because WebPAnimEncoderAssemble()
-    // expects MODE_BGRA pictures.
-    {
-      LockImageBits<RgbTraits> bits(image.get(), Image::ReadWriteLock);
-      auto it = bits.begin(), end = bits.end();
-      for (; it != end; ++it) {
-        auto c = *it;
-        *it = rgba(rgba_getb(c), // Use blue in red channel
-                   rgba_getg(c),
-                   rgba_getr(c), // Use red in blue channel
-                   rgba_geta(c));
-      }
-    }
+  for (std::size_t i = 0; i < frames.size(); i += images.size()) {
+    const std::size_t n = std::min(images.size(), frames.size() - i);
+
+    // Render the frames in the bitmaps
+    doc::TaskGroup tasks;
+    for (std::size_t j = 0; j < n; ++j) {
+      auto renderFrame = [&, j] {
+        Image* image = images[j].get();
+        const frame_t frame = frames[i + j];
+        clear_image(image, image->maskColor());
+        sprite->renderFrame(frame, fop->roi().frameBounds(frame), image);
+
+        // Switch R <-> B channels because WebPAnimEncoderAssemble()
+        // expects MODE_BGRA pictures.
+        LockImageBits<RgbTraits> bits(image, Image::ReadWriteLock);
+        auto it = bits.begin(), end = bits.end();
+        for (; it != end; ++it) {
+          auto c = *it;
+          *it = rgba(rgba_getb(c), // Use blue in red channel
+                     rgba_getg(c),
+                     rgba_getr(c), // Use red in blue channel
+                     rgba_geta(c));
+        }
+      };
 
-    if (!WebPAnimEncoderAdd(enc, &pic, timestamp_ms, &config)) {
-      if (!fop->isStop()) {
-        fop->setError("Error saving frame %d info\n", frame);
-        return false;
-      }
+      if (n == 1)
+        renderFrame();
       else
-        return true;
+        tasks.run(std::move(renderFrame));
     }
-    timestamp_ms += sprite->frameDuration(frame);
+    tasks.wait();
+
+    for (std::size_t j = 0; j < n; ++j) {
+      const frame_t frame = frames[i + j];
+      pic.argb = (uint32_t*)images[j]->getPixelAddress(0, 0);
+      pic.argb_stride = images[j]->rowPixels(); // Stride in pixels (not bytes)
+
+      if (!WebPAnimEncoderAdd(enc, &pic, timestamp_ms, &config)) {
+        WebPAnimEncoderDelete(enc);
+        if (!fop->isStop()) {
+          fop->setError("Error saving frame %d info\n", frame);
+          return false;
+        }
+        else
+          return true;
+      }
+      timestamp_ms += sprite->frameDuration(frame);
 
-    wd.f++;
+      wd.f++;
+    }
   }
   WebPAnimEncoderAdd(enc, nullptr, timestamp_ms, nullptr);
 
@@ -365,6 +410,11 @@ FormatOptionsPtr WebPFormat::onAskUserForFormatOptions(FileOp* fop)
       if (pref.isSet(pref.webp.type))
         opts->setType(WebPOptions::Type(pref.webp.type()));
 
+      if (pref.isSet(pref.webp.keyframeInterval))
+        opts->setKeyframeInterval(pref.webp.keyframeInterval());
+      if (pref.isSet(pref.webp.minimizeSize))
+        opts->setMinimizeSize(pref.webp.minimizeSize());
+
       switch (opts->type()) {
         case WebPOptions::Lossless:
           if (pref.isSet(pref.webp.compression))
@@ -1,4 +1,5 @@
 // Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
 // Copyright (C) 2018  David Capello
 // Copyright (C) 2015  Gabriel Rauter
 //
@@ -31,6 +32,8 @@ public:
     , m_imageHint(WEBP_HINT_DEFAULT)
     , m_quality(100)
     , m_imagePreset(WEBP_PRESET_DEFAULT)
+    , m_keyframeInterval(0)
+    , m_minimizeSize(false)
   {
   }
 
@@ -40,6 +43,8 @@ public:
   WebPImageHint imageHint() const { return m_imageHint; }
   int quality() const { return m_quality; }
   WebPPreset imagePreset() const { return m_imagePreset; }
+  int keyframeInterval() const { return m_keyframeInterval; }
+  bool minimizeSize() const { return m_minimizeSize; }
 
   void setLoop(const bool loop) { m_loop = loop; }
 
@@ -77,6 +82,9 @@ public:
     m_imagePreset = imagePreset;
   }
 
+  void setKeyframeInterval(const int interval) { m_keyframeInterval = interval; }
+  void setMinimizeSize(const bool minimizeSize) { m_minimizeSize = minimizeSize; }
+
 private:
   bool m_loop;
   Type m_type;
@@ -86,6 +94,9 @@ private:
   // Lossy options
   int m_quality;            // Between 0 (smallest file) and 100 (biggest)
   WebPPreset m_imagePreset; // Image Preset for lossy webp.
+  // Animation options
+  int m_keyframeInterval; // Max distance between key-frames (0=libwebp default)
+  bool m_minimizeSize;    // Slower encoding trying all the options to get smaller files
 };
 
 } // namespace app
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -17,13 +17,18 @@
 
 #include "app/file_system.h"
 
+#include "app/task_scheduler.h"
 #include "base/fs.h"
 #include "base/string.h"
+#include "base/thread.h"
 #include "os/surface.h"
 #include "os/system.h"
 #include "os/window.h"
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <cstdio>
 #include <map>
 #include <utility>
@@ -60,6 +65,15 @@ namespace {
 class FileItem;
 using FileItemMap = std::map<std::string, FileItem*>;
 
+#ifndef _WIN32
+// An item read from a folder (without accessing the FileItems, so
+// it can be read from a background thread).
+struct FolderEntry {
+  std::string name;
+  bool isFolder;
+};
+#endif
+
 // the root of the file-system
 FileItem* rootitem = nullptr;
 FileItemMap* fileitems_map = nullptr;
@@ -81,6 +95,8 @@ public:
   FileItemList m_children;
   unsigned int m_version;
   bool m_removed;
+  bool m_listed;   // This item is in the m_children of its parent
+  bool m_updating; // A FolderReader is updating the m_children
   mutable bool m_is_folder;
 #ifdef _WIN32
   bool m_isHidden = false;
@@ -100,6 +116,23 @@ public:
   void insertChildSorted(FileItem* child);
   int compare(const FileItem& that) const;
 
+  // Returns true if the m_children list must be read from disk
+  // (first time or the file-system was refreshed).
+  bool needsChildrenUpdate() const
+  {
+    return (isFolder() && !m_updating && current_file_system_version > m_version);
+  }
+
+  // Functions to update the m_children list: all children are marked
+  // as removed, and then the existent ones are added again. If the
+  // update is canceled, we keep the old children.
+  void beginChildrenUpdate();
+  void endChildrenUpdate(const bool completed);
+#ifndef _WIN32
+  void addChildEntry(const FolderEntry& entry);
+  void sortChildren();
+#endif
+
   bool operator<(const FileItem& that) const { return compare(that) < 0; }
   bool operator>(const FileItem& that) const { return compare(that) > 0; }
   bool operator==(const FileItem& that) const { return compare(that) == 0; }
@@ -181,6 +214,42 @@ static FileItem* get_fileitem_by_path(const std::string& path, bool create_if_no
 static std::string remove_backslash_if_needed(const std::string& filename);
 static std::string get_key_for_filename(const std::string& filename);
 static void put_fileitem(FileItem* fileitem);
+
+// Reads the items of the given folder calling func(entry) for each
+// one (stops if func() returns false). It doesn't access the
+// FileItems, so it can be used from a background thread.
+template<typename Func>
+static void read_folder_entries(const std::string& path, Func&& func)
+{
+  DIR* dir = opendir(path.c_str());
+  if (!dir)
+    return;
+
+  dirent* entry;
+  while ((entry = readdir(dir)) != NULL) {
+    FolderEntry item;
+    item.name = entry->d_name;
+    if (item.name == "." || item.name == "..")
+      continue;
+
+  #ifdef DT_DIR
+    // Use the type from the directory entry to avoid a stat() call
+    // for each file (which is slow on network drives)
+    if (entry->d_type == DT_DIR)
+      item.isFolder = true;
+    else if (entry->d_type == DT_REG)
+      item.isFolder = false;
+    else
+  #endif
+      // Symbolic links (or unknown types) are folders if they point
+      // to a directory
+      item.isFolder = base::is_directory(base::join_path(path, item.name));
+
+    if (!func(item))
+      break;
+  }
+  closedir(dir);
+}
 #endif
 
 FileSystemModule* FileSystemModule::m_instance = nullptr;
@@ -427,20 +496,10 @@ IFileItem* FileItem::parent() const
 
 const FileItemList& FileItem::children()
 {
-  // Is the file-item a folder?
-  if (isFolder() &&
-      // if the children list is empty, or the file-system version
-      // change (it's like to say: the current m_children list
-      // is outdated)...
-      (m_children.empty() || current_file_system_version > m_version)) {
-    FileItemList::iterator it;
-    FileItem* child;
-
-    // we have to mark current items as deprecated
-    for (it = m_children.begin(); it != m_children.end(); ++it) {
-      child = static_cast<FileItem*>(*it);
-      child->m_removed = true;
-    }
+  // Is the file-item a folder and the current m_children list is
+  // outdated?
+  if (needsChildrenUpdate()) {
+    beginChildrenUpdate();
 
     // LOG("FS: Loading files for %p (%s)\n", fileitem, fileitem->displayname);
 #ifdef _WIN32
@@ -484,7 +543,7 @@ const FileItemList& FileItem::children()
             for (c = 0; c < fetched; ++c) {
               LPITEMIDLIST fullpidl = concat_pidl(m_fullpidl, itempidl[c]);
 
-              child = get_fileitem_by_fullpidl(fullpidl, false);
+              FileItem* child = get_fileitem_by_fullpidl(fullpidl, false);
               if (!child) {
                 child = new FileItem(this);
 
@@ -507,54 +566,36 @@ const FileItemList& FileItem::children()
       }
     }
 #else
-    {
-      DIR* dir = opendir(m_filename.c_str());
-      if (dir) {
-        dirent* entry;
-        while ((entry = readdir(dir)) != NULL) {
-          FileItem* child;
-          std::string fn = entry->d_name;
-          std::string fullfn = base::join_path(m_filename, fn);
-
-          if (fn == "." || fn == "..")
-            continue;
-
-          child = get_fileitem_by_path(fullfn, false);
-          if (!child) {
-            child = new FileItem(this);
-
-            bool is_folder;
-            struct stat fileStat;
+    read_folder_entries(m_filename, [this](const FolderEntry& entry) {
+      addChildEntry(entry);
+      return true;
+    });
+    sortChildren();
+#endif
 
-            stat(fullfn.c_str(), &fileStat);
+    endChildrenUpdate(true);
+  }
 
-            if ((fileStat.st_mode & S_IFMT) == S_IFLNK) {
-              is_folder = base::is_directory(fullfn);
-            }
-            else {
-              is_folder = ((fileStat.st_mode & S_IFMT) == S_IFDIR);
-            }
+  return m_children;
+}
 
-            child->m_filename = fullfn;
-            child->m_displayname = fn;
-            child->m_is_folder = is_folder;
+void FileItem::beginChildrenUpdate()
+{
+  // we have to mark current items as deprecated
+  for (auto ichild : m_children)
+    static_cast<FileItem*>(ichild)->m_removed = true;
 
-            put_fileitem(child);
-          }
-          else {
-            ASSERT(child->m_parent == this);
-          }
+  m_updating = true;
+}
 
-          insertChildSorted(child);
-        }
-        closedir(dir);
-      }
-    }
-#endif
+void FileItem::endChildrenUpdate(const bool completed)
+{
+  m_updating = false;
 
+  if (completed) {
     // check old file-items (maybe removed directories or file-items)
-    for (it = m_children.begin(); it != m_children.end();) {
-      child = static_cast<FileItem*>(*it);
+    for (auto it = m_children.begin(); it != m_children.end();) {
+      FileItem* child = static_cast<FileItem*>(*it);
       ASSERT(child);
 
       if (child && child->m_removed) {
@@ -569,9 +610,55 @@ const FileItemList& FileItem::children()
     // now this file-item is updated
     m_version = current_file_system_version;
   }
+  else {
+    // Keep the old children and read them again the next time
+    for (auto ichild : m_children)
+      static_cast<FileItem*>(ichild)->m_removed = false;
 
-  return m_children;
+    m_version = 0;
+  }
+}
+
+#ifndef _WIN32
+void FileItem::addChildEntry(const FolderEntry& entry)
+{
+  const std::string fullfn = base::join_path(m_filename, entry.name);
+
+  // We don't use get_fileitem_by_path() because it checks if the
+  // existent item is still on disk (and we've just read it from the
+  // folder, so we already know its type too)
+  FileItem* child;
+  auto it = fileitems_map->find(get_key_for_filename(fullfn));
+  if (it != fileitems_map->end()) {
+    child = it->second;
+    child->m_is_folder = entry.isFolder;
+    ASSERT(child->m_parent == this);
+  }
+  else {
+    child = new FileItem(this);
+    child->m_filename = fullfn;
+    child->m_displayname = entry.name;
+    child->m_is_folder = entry.isFolder;
+
+    put_fileitem(child);
+  }
+
+  // this file-item wasn't removed from the last lookup
+  child->m_removed = false;
+
+  if (!child->m_listed) {
+    child->m_listed = true;
+    m_children.push_back(child);
+  }
+}
+
+void FileItem::sortChildren()
+{
+  std::sort(m_children.begin(), m_children.end(), [](const IFileItem* a, const IFileItem* b) {
+    return *static_cast<const FileItem*>(a) < *static_cast<const FileItem*>(b);
+  });
 }
+#endif
 
 void FileItem::createDirectory(const std::string& dirname)
 {
@@ -615,8 +702,10 @@ FileItem::FileItem(FileItem* parent)
   m_filename = NOTINITIALIZED;
   m_displayname = NOTINITIALIZED;
   m_parent = parent;
-  m_version = current_file_system_version;
+  m_version = 0; // Children not read yet
   m_removed = false;
+  m_listed = false;
+  m_updating = false;
   m_is_folder = false;
   m_thumbnailProgress = 0.0;
   m_thumbnail = nullptr;
@@ -654,6 +743,7 @@ void FileItem::insertChildSorted(FileItem* child)
   if (std::find(m_children.begin(), m_children.end(), child) != m_children.end())
     return;
 
+  child->m_listed = true;
   for (auto it = m_children.begin(), end = m_children.end(); it != end; ++it) {
     if (*child < *static_cast<FileItem*>(*it)) {
       m_children.insert(it, child);
@@ -1101,4 +1191,133 @@ static void put_fileitem(FileItem* fileitem)
 
 #endif
 
+// ======================================================================
+// FolderReader
+// ======================================================================
+
+class FolderReader::Impl {
+public:
+  Impl(FileItem* folder) : m_folder(folder)
+  {
+    if (!m_folder->needsChildrenUpdate()) {
+      m_done = m_finished = true;
+      return;
+    }
+
+    // Just in case that the folder is deleted while we're reading it
+    // (e.g. if its parent is refreshed)
+    m_conn = FileSystemModule::instance()->ItemRemoved.connect([this](IFileItem* item) {
+      if (item == m_folder)
+        m_folder = nullptr;
+    });
+
+#ifdef _WIN32
+    // TODO The PIDLs are enumerated in the UI thread as the
+    //      IShellFolder would need to be marshaled to other thread
+    m_folder->children();
+    m_done = m_finished = true;
+#else
+    m_folder->beginChildrenUpdate();
+    m_thread = BlockingTask([this, path = m_folder->fileName()] {
+      base::this_thread::set_name("folder-reader");
+      read_folder_entries(path, [this](const FolderEntry& entry) {
+        const std::lock_guard lock(m_mutex);
+        m_entries.push_back(entry);
+        return !m_canceled;
+      });
+
+      const std::lock_guard lock(m_mutex);
+      m_done = true;
+      m_cv.notify_all();
+    });
+#endif
+  }
+
+  ~Impl()
+  {
+    m_canceled = true;
+    if (m_thread.joinable())
+      m_thread.join();
+
+    if (m_folder && !m_finished)
+      m_folder->endChildrenUpdate(false);
+  }
+
+  void wait(const int msecs)
+  {
+    std::unique_lock lock(m_mutex);
+    m_cv.wait_for(lock, std::chrono::milliseconds(msecs), [this] { return m_done; });
+  }
+
+  bool update()
+  {
+    if (!m_folder || m_finished)
+      return false;
+
+#ifdef _WIN32
+    return false;
+#else
+    std::vector<FolderEntry> entries;
+    bool done;
+    {
+      const std::lock_guard lock(m_mutex);
+      std::swap(entries, m_entries);
+      done = m_done;
+    }
+
+    for (const FolderEntry& entry : entries)
+      m_folder->addChildEntry(entry);
+    if (!entries.empty())
+      m_folder->sortChildren();
+
+    if (done) {
+      // Remove the items that weren't found
+      m_folder->endChildrenUpdate(true);
+      m_finished = true;
+      return true;
+    }
+    return !entries.empty();
+#endif
+  }
+
+  bool isDone() const { return m_finished; }
+
+private:
+  FileItem* m_folder;
+  obs::scoped_connection m_conn;
+  BlockingTask m_thread;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+#ifndef _WIN32
+  std::vector<FolderEntry> m_entries;
+#endif
+  std::atomic<bool> m_canceled = false;
+  bool m_done = false;     // The background thread read all items
+  bool m_finished = false; // All items were added to the folder
+};
+
+FolderReader::FolderReader(IFileItem* folder)
+  : m_impl(std::make_unique<Impl>(static_cast<FileItem*>(folder)))
+{
+}
+
+FolderReader::~FolderReader()
+{
+}
+
+void FolderReader::wait(const int msecs)
+{
+  m_impl->wait(msecs);
+}
+
+bool FolderReader::update()
+{
+  return m_impl->update();
+}
+
+bool FolderReader::isDone() const
+{
+  return m_impl->isDone();
+}
+
 } // namespace app
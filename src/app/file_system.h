@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2022  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -13,6 +13,7 @@
 #include "obs/signal.h"
 #include "os/surface.h"
 
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -89,6 +90,32 @@ public:
   virtual void setThumbnail(const os::SurfaceRef& thumbnail) = 0;
 };
 
+// Reads the content of a folder in a background thread, so the UI
+// isn't blocked by slow folders (e.g. network drives with thousands
+// of files). The children of the folder are updated incrementally
+// calling update() from the UI thread, and the reading is canceled
+// if the FolderReader is destroyed before it's done.
+class FolderReader {
+public:
+  explicit FolderReader(IFileItem* folder);
+  ~FolderReader();
+
+  // Waits until the whole folder is read or the given timeout (in
+  // milliseconds) expires.
+  void wait(const int msecs);
+
+  // Adds the items read since the last call to the children of the
+  // folder. Returns true if the list of children was modified.
+  bool update();
+
+  // Returns true when all the items were added to the folder.
+  bool isDone() const;
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> m_impl;
+};
+
 } // namespace app
 
 #endif
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019 Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -9,15 +9,21 @@
   #include "config.h"
 #endif
 
+#include "app/flatten.h"
+
 #include "doc/cel.h"
 #include "doc/frame.h"
 #include "doc/image.h"
 #include "doc/layer.h"
+#include "doc/primitives.h"
 #include "doc/sprite.h"
+#include "doc/task_group.h"
 #include "gfx/rect.h"
 #include "render/render.h"
 
+#include <algorithm>
 #include <memory>
+#include <vector>
 
 namespace app {
 
@@ -33,31 +39,85 @@ LayerImage* create_flatten_layer_copy(Sprite* dstSprite,
                                       const bool newBlend)
 {
   std::unique_ptr<LayerImage> flatLayer(new LayerImage(dstSprite));
-  render::Render render;
-  render.setNewBlend(newBlend);
-
-  for (frame_t frame = frmin; frame <= frmax; ++frame) {
+  if (frmax < frmin)
+    return flatLayer.release();
+
+  // Render all frames in parallel (each frame is independent)
+  struct FlatFrame {
+    ImageRef image;
+    uint64_t hash = 0;
+  };
+  std::vector<FlatFrame> flatFrames(frmax - frmin + 1);
+  const PixelFormat pixelFormat = flatLayer->sprite()->pixelFormat();
+
+  for_each_frame_in_parallel(frmin, frmax, [&](const frame_t frame) {
     // Does this frame have cels to render?
-    if (has_cels(srcLayer, frame)) {
-      // Create a new image to render each frame.
-      ImageRef image(Image::create(flatLayer->sprite()->pixelFormat(), bounds.w, bounds.h));
+    if (!has_cels(srcLayer, frame))
+      return;
 
-      // Create the new cel for the output layer.
-      std::unique_ptr<Cel> cel(new Cel(frame, image));
-      cel->setPosition(bounds.x, bounds.y);
+    ImageRef image(Image::create(pixelFormat, bounds.w, bounds.h));
+
+    render::Render render;
+    render.setNewBlend(newBlend);
+    render.renderLayer(image.get(), srcLayer, frame, gfx::Clip(0, 0, bounds));
 
-      // Render this frame.
-      render.renderLayer(image.get(), srcLayer, frame, gfx::Clip(0, 0, bounds));
+    FlatFrame& flatFrame = flatFrames[frame - frmin];
+    flatFrame.image = image;
+    flatFrame.hash = calculate_image_hash64(image.get(), image->bounds());
+  });
 
-      // Add the cel (and release the std::unique_ptr).
-      flatLayer->addCel(cel.get());
-      cel.release();
+  // Add the cels in order, linking frames with the same image
+  FlattenedCels flatCels;
+  for (frame_t frame = frmin; frame <= frmax; ++frame) {
+    FlatFrame& flatFrame = flatFrames[frame - frmin];
+    if (!flatFrame.image)
+      continue;
+
+    std::unique_ptr<Cel> cel;
+    if (const Cel* link = flatCels.find(flatFrame.image.get(), bounds.origin(), flatFrame.hash)) {
+      cel.reset(Cel::MakeLink(frame, link));
     }
+    else {
+      cel = std::make_unique<Cel>(frame, flatFrame.image);
+      cel->setPosition(bounds.x, bounds.y);
+      flatCels.add(cel.get(), flatFrame.hash);
+    }
+    flatFrame.image.reset();
+
+    // Add the cel (and release the std::unique_ptr).
+    flatLayer->addCel(cel.get());
+    cel.release();
   }
 
   return flatLayer.release();
 }
 
+void for_each_frame_in_parallel(const frame_t frmin,
+                                const frame_t frmax,
+                                const std::function<void(frame_t)>& func)
+{
+  doc::TaskGroup tasks;
+  for (frame_t frame = frmin; frame <= frmax; ++frame)
+    tasks.run([&func, frame] { func(frame); });
+  tasks.wait();
+}
+
+Cel* FlattenedCels::find(const Image* image, const gfx::Point& pos, const uint64_t hash) const
+{
+  const auto range = m_cels.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    Cel* cel = it->second;
+    if (cel->position() == pos && is_same_image(cel->image(), image))
+      return cel;
+  }
+  return nullptr;
+}
+
+void FlattenedCels::add(Cel* cel, const uint64_t hash)
+{
+  m_cels.emplace(hash, cel);
+}
+
 // Returns true if the "layer" or its children have any cel to render
 // in the given "frame".
 static bool has_cels(const Layer* layer, frame_t frame)
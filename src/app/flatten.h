@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019 Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2015  David Capello
 //
 // This program is distributed under the terms of
@@ -10,9 +10,16 @@
 #pragma once
 
 #include "doc/frame.h"
+#include "gfx/point.h"
 #include "gfx/rect.h"
 
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+
 namespace doc {
+class Cel;
+class Image;
 class Sprite;
 class Layer;
 class LayerImage;
@@ -23,6 +30,7 @@ namespace app {
 // Returns a new layer with the given layer at "srcLayer" rendered
 // frame by frame from "frmin" to "frmax" (inclusive).  The routine
 // flattens all children of "srcLayer" to an unique output layer.
+// Frames with the same rendered image are linked cels.
 //
 // Note: The layer is not added to the given sprite, but is related to
 // it, so you'll be able to add the flatten layer only into the given
@@ -34,6 +42,26 @@ LayerImage* create_flatten_layer_copy(Sprite* dstSprite,
                                       frame_t frmax,
                                       const bool newBlend);
 
+// Calls "func(frame)" for each frame in [frmin, frmax] from a thread
+// pool, and waits all calls to finish. Used to render the frames to
+// be flattened in parallel ("func" must not modify the sprite).
+void for_each_frame_in_parallel(const doc::frame_t frmin,
+                                const doc::frame_t frmax,
+                                const std::function<void(doc::frame_t)>& func);
+
+// Cels created for the flattened frames, used to link frames that
+// are rendered with the same image in the same position.
+class FlattenedCels {
+public:
+  // Returns a cel with the given image and position (or nullptr),
+  // "hash" must be the calculate_image_hash64() of the whole image.
+  doc::Cel* find(const doc::Image* image, const gfx::Point& pos, const uint64_t hash) const;
+  void add(doc::Cel* cel, const uint64_t hash);
+
+private:
+  std::unordered_multimap<uint64_t, doc::Cel*> m_cels;
+};
+
 } // namespace app
 
 #endif
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2025  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2017  David Capello
 //
 // This program is distributed under the terms of
@@ -56,7 +56,11 @@ private:
       bool hinting : 1;
       bool operator<(const Key& b) const
       {
-        return size < b.size || antialias < b.antialias || hinting < b.hinting;
+        if (size != b.size)
+          return size < b.size;
+        if (antialias != b.antialias)
+          return antialias < b.antialias;
+        return hinting < b.hinting;
       }
     };
     std::map<Key, text::FontRef> fonts;
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2025  Igara Studio S.A.
+// Copyright (C) 2025-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -12,12 +12,16 @@
 
 #include "app/fonts/font_data.h"
 #include "app/fonts/font_info.h"
+#include "base/convert_to.h"
 #include "text/font_mgr.h"
 
 namespace app {
 
 static Fonts* g_instance = nullptr;
 
+// Maximum number of fonts in Fonts::m_cache
+static constexpr std::size_t kMaxCachedFonts = 64;
+
 // static
 Fonts* Fonts::instance()
 {
@@ -66,6 +70,15 @@ text::FontRef Fonts::fontFromInfo(const FontInfo& fontInfo)
   if (!m_fontMgr)
     return nullptr;
 
+  // Fonts from FontData are already cached by FontData::getFont()
+  std::string cacheKey;
+  if (fontInfo.type() == FontInfo::Type::System || fontInfo.type() == FontInfo::Type::File) {
+    cacheKey = base::convert_to<std::string>(fontInfo);
+    auto it = m_cache.find(cacheKey);
+    if (it != m_cache.end())
+      return it->second;
+  }
+
   text::FontRef font;
   if (fontInfo.type() == FontInfo::Type::System) {
     // Just in case the typeface is not present in the FontInfo
@@ -90,6 +103,14 @@ text::FontRef Fonts::fontFromInfo(const FontInfo& fontInfo)
   if (font) {
     font->setAntialias(fontInfo.antialias());
     font->setHinting(fontInfo.hinting());
+
+    if (!cacheKey.empty()) {
+      // Avoid growing the cache indefinitely (e.g. trying several
+      // font sizes)
+      if (m_cache.size() >= kMaxCachedFonts)
+        m_cache.clear();
+      m_cache[cacheKey] = font;
+    }
   }
 
   return font;
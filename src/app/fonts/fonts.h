@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2025  Igara Studio S.A.
+// Copyright (C) 2025-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -42,6 +42,13 @@ public:
 private:
   text::FontMgrRef m_fontMgr;
   FontDataMap m_fonts;
+
+  // Fonts created by fontFromInfo() for system fonts and font files
+  // (key=FontInfo converted to string). Reusing the same text::Font
+  // avoids loading the font file each time and keeps the glyphs
+  // cached by the text backend (e.g. each time a key is pressed
+  // with the text tool).
+  std::map<std::string, text::FontRef> m_cache;
 };
 
 } // namespace app
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2023-2024  Igara Studio S.A.
+// Copyright (C) 2023-2026  Igara Studio S.A.
 // Copyright (C) 2016-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -17,14 +17,198 @@
 #include "app/resource_finder.h"
 #include "app/xml_document.h"
 #include "app/xml_exception.h"
+#include "base/convert_to.h"
 #include "base/debug.h"
 #include "base/fs.h"
+#include "base/sha1.h"
+#include "base/time.h"
 #include "cfg/cfg.h"
+#include "fmt/format.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
 
 namespace app {
 
+namespace {
+
+using StringsList = std::vector<std::pair<std::string, std::string>>;
+
+// First line of each cached file (change the version number if the
+// format of these files changes).
+const char* kStringsCacheHeader = "aseprite-strings 1\n";
+
+// Returns the directory of the cache of parsed .ini files, or an
+// empty string if it cannot be created.
+const std::string& cache_dir()
+{
+  static std::string dir;
+  static bool initialized = false;
+  if (!initialized) {
+    initialized = true;
+    try {
+      ResourceFinder rf;
+      rf.includeUserDir(base::join_path("strings-cache", ".").c_str());
+      dir = rf.getFirstOrCreateDefault();
+      if (!base::is_directory(dir))
+        base::make_all_directories(dir);
+    }
+    catch (const std::exception&) {
+      dir.clear();
+    }
+  }
+  return dir;
+}
+
+// Each .ini file has only one entry in the cache (identified by its
+// path), and the entry has a stamp to know if it's still valid.
+std::string entry_filename(const std::string& dir, const std::string& filename)
+{
+  const std::string key = base::convert_to<std::string>(
+    base::Sha1::calculateFromString(base::get_absolute_path(filename)));
+  return base::join_path(dir, key + ".strings");
+}
+
+std::string file_stamp(const std::string& filename)
+{
+  const base::Time t = base::get_modification_time(filename);
+  return fmt::format("{} {:04}{:02}{:02}{:02}{:02}{:02} {}\n",
+                     base::file_size(filename),
+                     t.year,
+                     t.month,
+                     t.day,
+                     t.hour,
+                     t.minute,
+                     t.second,
+                     base::get_absolute_path(filename));
+}
+
+// Strings in the cache are saved with their 32-bit length (in the
+// machine byte order, the cache is not shared between machines).
+void write_string(std::string& data, const std::string& str)
+{
+  const uint32_t size = uint32_t(str.size());
+  data.append((const char*)&size, sizeof(size));
+  data.append(str);
+}
+
+bool read_string(const uint8_t*& p, const uint8_t* end, std::string& str)
+{
+  uint32_t size;
+  if (size_t(end - p) < sizeof(size))
+    return false;
+  std::memcpy(&size, p, sizeof(size));
+  p += sizeof(size);
+  if (size_t(end - p) < size)
+    return false;
+  str.assign((const char*)p, size);
+  p += size;
+  return true;
+}
+
+// Loads the strings of the given .ini file from the cache (the
+// strings are already unescaped).
+bool load_strings_from_cache(const std::string& dir, const std::string& fn, StringsList& strings)
+{
+  const std::string entryFn = entry_filename(dir, fn);
+  if (!base::is_file(entryFn))
+    return false;
+
+  try {
+    const std::string header = kStringsCacheHeader + file_stamp(fn);
+    const base::buffer buf = base::read_file_content(entryFn);
+    if (buf.size() < header.size() || std::memcmp(buf.data(), header.c_str(), header.size()) != 0)
+      return false;
+
+    const uint8_t* p = buf.data() + header.size();
+    const uint8_t* end = buf.data() + buf.size();
+    std::pair<std::string, std::string> item;
+    while (p < end) {
+      if (!read_string(p, end, item.first) || !read_string(p, end, item.second)) {
+        strings.clear();
+        return false;
+      }
+      strings.push_back(item);
+    }
+    return true;
+  }
+  catch (const std::exception&) {
+    strings.clear();
+    return false;
+  }
+}
+
+void save_strings_in_cache(const std::string& dir,
+                           const std::string& fn,
+                           const StringsList& strings)
+{
+  std::string data = kStringsCacheHeader + file_stamp(fn);
+  for (const auto& item : strings) {
+    write_string(data, item.first);
+    write_string(data, item.second);
+  }
+  try {
+    base::write_file_content(entry_filename(dir, fn), (const uint8_t*)data.c_str(), data.size());
+  }
+  catch (const std::exception&) {
+    // Ignore errors, the file will be parsed again the next time
+  }
+}
+
+// Processes escaped chars (\\, \n, \s, \t, etc.)
+void unescape_string(std::string& value)
+{
+  for (int i = 0; i < int(value.size());) {
+    if (value[i] == '\\') {
+      value.erase(i, 1);
+      if (i == int(value.size()))
+        break;
+      int chr = value[i];
+      switch (chr) {
+        case '\\': chr = '\\'; break;
+        case 'n':  chr = '\n'; break;
+        case 't':  chr = '\t'; break;
+        case 's':  chr = ' '; break;
+      }
+      value[i] = chr;
+    }
+    else {
+      ++i;
+    }
+  }
+}
+
+void load_strings_from_ini(const std::string& fn, StringsList& strings)
+{
+  cfg::CfgFile cfg;
+  cfg.load(fn);
+
+  std::vector<std::string> sections;
+  std::vector<std::string> keys;
+  cfg.getAllSections(sections);
+  for (const auto& section : sections) {
+    keys.clear();
+    cfg.getAllKeys(section.c_str(), keys);
+
+    std::string textId = section;
+    textId.push_back('.');
+    for (const auto& key : keys) {
+      textId.append(key);
+
+      std::string value = cfg.getValue(section.c_str(), key.c_str(), "");
+      unescape_string(value);
+      strings.emplace_back(textId, std::move(value));
+
+      textId.erase(section.size() + 1);
+    }
+  }
+}
+
+} // anonymous namespace
+
 static Strings* singleton = nullptr;
 
 const char* Strings::kDefLanguage = "en";
@@ -187,50 +371,20 @@ void Strings::loadStringsFromExtension(const std::string& langId)
 
 void Strings::loadStringsFromFile(const std::string& fn)
 {
-  cfg::CfgFile cfg;
-  cfg.load(fn);
-
-  std::vector<std::string> sections;
-  std::vector<std::string> keys;
-  cfg.getAllSections(sections);
-  for (const auto& section : sections) {
-    keys.clear();
-    cfg.getAllKeys(section.c_str(), keys);
-
-    std::string textId = section;
-    std::string value;
-    textId.push_back('.');
-    for (auto key : keys) {
-      textId.append(key);
-
-      value = cfg.getValue(section.c_str(), key.c_str(), "");
-
-      // Process escaped chars (\\, \n, \s, \t, etc.)
-      for (int i = 0; i < int(value.size());) {
-        if (value[i] == '\\') {
-          value.erase(i, 1);
-          if (i == int(value.size()))
-            break;
-          int chr = value[i];
-          switch (chr) {
-            case '\\': chr = '\\'; break;
-            case 'n':  chr = '\n'; break;
-            case 't':  chr = '\t'; break;
-            case 's':  chr = ' '; break;
-          }
-          value[i] = chr;
-        }
-        else {
-          ++i;
-        }
-      }
-      m_strings[textId] = value;
-
-      // TRACE("I18N: Reading string %s -> %s\n", textId.c_str(), m_strings[textId].c_str());
-
-      textId.erase(section.size() + 1);
-    }
+  // Parsing the .ini files is slow (specially if we have to load
+  // en.ini + other language), so we keep a cache of parsed strings
+  // that is valid until the .ini file is modified.
+  StringsList strings;
+  const std::string& dir = cache_dir();
+  if (dir.empty() || !load_strings_from_cache(dir, fn, strings)) {
+    load_strings_from_ini(fn, strings);
+    if (!dir.empty())
+      save_strings_in_cache(dir, fn, strings);
   }
+
+  m_strings.reserve(m_strings.size() + strings.size());
+  for (auto& item : strings)
+    m_strings[item.first] = std::move(item.second);
 }
 
 const std::string& Strings::translate(const char* id) const
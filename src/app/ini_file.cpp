@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2024  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2016  David Capello
 //
 // This program is distributed under the terms of
@@ -12,9 +12,11 @@
 #include "app/ini_file.h"
 
 #include "app/resource_finder.h"
+#include "app/task_scheduler.h"
 #include "base/fs.h"
 #include "base/split_string.h"
 #include "base/string.h"
+#include "base/thread.h"
 #include "cfg/cfg.h"
 #include "fmt/format.h"
 
@@ -27,15 +29,161 @@
   #include "base/fs.h"
 #endif
 
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
 #include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace app {
 
 using namespace gfx;
 
+namespace {
+
+// Saves the configuration files in a background thread, so the UI
+// thread doesn't have to wait the disk (e.g. when the preferences of
+// each document are saved). Each file is written some time after the
+// first change, so several changes in a row are saved only once.
+class ConfigWriter {
+public:
+  using Clock = std::chrono::steady_clock;
+  static constexpr auto kDelay = std::chrono::milliseconds(500);
+
+  ConfigWriter() : m_thread([this] { writerThread(); }) {}
+
+  ~ConfigWriter()
+  {
+    {
+      const std::lock_guard lock(m_mutex);
+      m_done = true;
+      m_cv.notify_all();
+    }
+    // Pending files are saved before the thread finishes
+    m_thread.join();
+  }
+
+  // Replaces the whole content of the file.
+  void save(const std::string& filename, std::string&& data)
+  {
+    const std::lock_guard lock(m_mutex);
+    Pending& pending = getPending(filename);
+    // If the same file was already queued, we save the new data only
+    pending.data = std::move(data);
+    pending.hasData = true;
+    pending.values.reset();
+    m_cv.notify_all();
+  }
+
+  // Sets the given values in the file (the file is loaded and saved
+  // in the background thread).
+  void merge(const std::string& filename, std::unique_ptr<cfg::CfgFile>&& values)
+  {
+    const std::lock_guard lock(m_mutex);
+    Pending& pending = getPending(filename);
+    if (pending.values)
+      pending.values->merge(*values);
+    else
+      pending.values = std::move(values);
+    m_cv.notify_all();
+  }
+
+  // Waits until the given file is saved (e.g. to load it again).
+  void wait(const std::string& filename)
+  {
+    std::unique_lock lock(m_mutex);
+    auto it = m_pending.find(filename);
+    if (it != m_pending.end()) {
+      it->second.urgent = true;
+      m_cv.notify_all();
+    }
+    m_cv.wait(lock, [this, &filename] {
+      return (m_pending.find(filename) == m_pending.end() && m_writing != filename);
+    });
+  }
+
+private:
+  struct Pending {
+    Clock::time_point time; // When the file was queued
+    bool urgent = false;
+    bool hasData = false;
+    std::string data;
+    std::unique_ptr<cfg::CfgFile> values; // Values to set after "data" is saved
+  };
+
+  Pending& getPending(const std::string& filename)
+  {
+    auto it = m_pending.find(filename);
+    if (it == m_pending.end()) {
+      it = m_pending.emplace(filename, Pending()).first;
+      it->second.time = Clock::now();
+    }
+    return it->second;
+  }
+
+  void writerThread()
+  {
+    base::this_thread::set_name("config-writer");
+
+    std::unique_lock lock(m_mutex);
+    while (true) {
+      // Find the next file to be saved
+      const Clock::time_point now = Clock::now();
+      Clock::time_point next = Clock::time_point::max();
+      auto it = m_pending.begin();
+      for (; it != m_pending.end(); ++it) {
+        if (m_done || it->second.urgent || it->second.time + kDelay <= now)
+          break;
+        next = std::min(next, it->second.time + kDelay);
+      }
+
+      if (it == m_pending.end()) {
+        if (m_done)
+          break;
+        if (m_pending.empty())
+          m_cv.wait(lock);
+        else
+          m_cv.wait_until(lock, next);
+        continue;
+      }
+
+      m_writing = it->first;
+      Pending pending = std::move(it->second);
+      m_pending.erase(it);
+
+      lock.unlock();
+      if (pending.hasData)
+        cfg::CfgFile::saveData(m_writing, pending.data);
+      if (pending.values) {
+        cfg::CfgFile cfg;
+        if (cfg.load(m_writing)) {
+          cfg.merge(*pending.values);
+          cfg.save();
+        }
+      }
+      lock.lock();
+
+      m_writing.clear();
+      m_cv.notify_all();
+    }
+  }
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::map<std::string, Pending> m_pending;
+  std::string m_writing;
+  bool m_done = false;
+  BlockingTask m_thread;
+};
+
+} // anonymous namespace
+
 static std::string g_configFilename;
 static std::vector<cfg::CfgFile*> g_configs;
+static std::unique_ptr<ConfigWriter> g_writer;
 
 ConfigModule::ConfigModule()
 {
@@ -93,6 +241,8 @@ ConfigModule::ConfigModule()
 
 #endif
 
+  g_writer = std::make_unique<ConfigWriter>();
+
   set_config_file(fn.c_str());
   g_configFilename = fn;
 }
@@ -101,6 +251,9 @@ ConfigModule::~ConfigModule()
 {
   flush_config_file();
 
+  // Wait all files to be saved
+  g_writer.reset();
+
   for (auto cfg : g_configs)
     delete cfg;
   g_configs.clear();
@@ -126,7 +279,39 @@ void flush_config_file()
 {
   ASSERT(!g_configs.empty());
 
-  g_configs.back()->save();
+  cfg::CfgFile* cfg = g_configs.back();
+  if (!cfg->isModified())
+    return;
+
+  if (g_writer) {
+    std::string data;
+    if (cfg->serialize(data))
+      g_writer->save(cfg->filename(), std::move(data));
+  }
+  else
+    cfg->save();
+}
+
+void merge_config_file(const char* filename)
+{
+  ASSERT(!g_configs.empty());
+
+  cfg::CfgFile* cfg = g_configs.back();
+  if (!cfg->isModified())
+    return;
+
+  if (g_writer) {
+    auto values = std::make_unique<cfg::CfgFile>();
+    values->merge(*cfg);
+    g_writer->merge(filename, std::move(values));
+  }
+  else {
+    cfg::CfgFile file;
+    if (file.load(filename)) {
+      file.merge(*cfg);
+      file.save();
+    }
+  }
 }
 
 void set_config_file(const char* filename)
@@ -134,6 +319,10 @@ void set_config_file(const char* filename)
   if (g_configs.empty())
     g_configs.push_back(new cfg::CfgFile());
 
+  // The file could be still in the writer queue
+  if (g_writer)
+    g_writer->wait(filename);
+
   g_configs.back()->load(filename);
 }
 
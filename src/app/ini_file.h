@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2019  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2016  David Capello
 //
 // This program is distributed under the terms of
@@ -28,6 +28,11 @@ void pop_config_state();
 void flush_config_file();
 void set_config_file(const char* filename);
 
+// Sets the values of the current configuration (e.g. an empty
+// configuration pushed with push_config_state()) in the given file,
+// without loading the file in the calling thread.
+void merge_config_file(const char* filename);
+
 std::string main_config_filename();
 
 const char* get_config_string(const char* section, const char* name, const char* value);
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2021-2024  Igara Studio S.A.
+// Copyright (C) 2021-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -60,7 +60,7 @@ Job::~Job()
 
 void Job::startJob()
 {
-  m_thread = std::thread(&Job::thread_proc, this);
+  m_thread = BlockingTask([this] { thread_proc(this); });
   ++g_runningJobs;
 
   if (m_alert_window) {
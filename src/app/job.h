@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2021-2024  Igara Studio S.A.
+// Copyright (C) 2021-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -9,6 +9,7 @@
 #define APP_JOB_H_INCLUDED
 #pragma once
 
+#include "app/task_scheduler.h"
 #include "ui/alert.h"
 #include "ui/timer.h"
 
@@ -16,7 +17,6 @@
 #include <exception>
 #include <mutex>
 #include <string>
-#include <thread>
 
 namespace app {
 
@@ -62,7 +62,7 @@ private:
   static void monitor_proc(void* data);
   static void monitor_free(void* data);
 
-  std::thread m_thread;
+  BlockingTask m_thread;
   std::unique_ptr<ui::Timer> m_timer;
   std::mutex m_mutex;
   ui::AlertPtr m_alert_window;
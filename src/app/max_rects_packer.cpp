@@ -0,0 +1,299 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/max_rects_packer.h"
+
+#include "base/debug.h"
+#include "base/ints.h"
+#include "base/task.h"
+#include "base/time.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace app {
+
+namespace {
+
+// bestFit() stops trying other widths when the rectangles fill this
+// ratio of the bin.
+constexpr double kGoodEnoughFill = 0.95;
+
+// bestFit() stops when this number of consecutive widths didn't
+// improve the best texture size found.
+constexpr int kMaxTriesWithoutImprovement = 8;
+
+// Removes the free rectangles that intersect the "used" one, adding
+// the maximal free rectangles that remain around it.
+void split_free_rects(MaxRectsPacker::Rects& freeRects, const gfx::Rect& used)
+{
+  MaxRectsPacker::Rects newRects;
+
+  for (int i = 0; i < int(freeRects.size());) {
+    const gfx::Rect f = freeRects[i];
+    if (!f.intersects(used)) {
+      ++i;
+      continue;
+    }
+
+    if (used.x > f.x)
+      newRects.push_back(gfx::Rect(f.x, f.y, used.x - f.x, f.h));
+    if (used.x2() < f.x2())
+      newRects.push_back(gfx::Rect(used.x2(), f.y, f.x2() - used.x2(), f.h));
+    if (used.y > f.y)
+      newRects.push_back(gfx::Rect(f.x, f.y, f.w, used.y - f.y));
+    if (used.y2() < f.y2())
+      newRects.push_back(gfx::Rect(f.x, used.y2(), f.w, f.y2() - used.y2()));
+
+    freeRects[i] = freeRects.back();
+    freeRects.pop_back();
+  }
+
+  // Only the new rectangles can be redundant (contained in other free
+  // rectangles) or make old ones redundant, so we don't need to
+  // compare all free rectangles between them.
+  for (int i = 0; i < int(newRects.size()); ++i) {
+    const gfx::Rect& n = newRects[i];
+    bool redundant = false;
+
+    for (int j = 0; j < int(newRects.size()) && !redundant; ++j) {
+      if (i != j && newRects[j].contains(n) && (newRects[j] != n || j < i))
+        redundant = true;
+    }
+    for (int j = 0; j < int(freeRects.size()) && !redundant; ++j) {
+      if (freeRects[j].contains(n))
+        redundant = true;
+    }
+    if (redundant)
+      continue;
+
+    for (int j = 0; j < int(freeRects.size());) {
+      if (n.contains(freeRects[j])) {
+        freeRects[j] = freeRects.back();
+        freeRects.pop_back();
+      }
+      else
+        ++j;
+    }
+    freeRects.push_back(n);
+  }
+}
+
+} // anonymous namespace
+
+MaxRectsPacker::MaxRectsPacker(int borderPadding, int shapePadding)
+  : m_borderPadding(borderPadding)
+  , m_shapePadding(shapePadding)
+  , m_timeBudget(kDefaultTimeBudget)
+{
+}
+
+void MaxRectsPacker::add(const gfx::Size& sz)
+{
+  m_rects.push_back(gfx::Rect(sz));
+}
+
+gfx::Size MaxRectsPacker::bestFit(base::task_token& token,
+                                  const int fixedWidth,
+                                  const int fixedHeight)
+{
+  if (m_rects.empty())
+    return gfx::Size(0, 0);
+
+  sortRects();
+
+  // A fixed height is the same problem as a fixed width with all
+  // rectangles transposed.
+  const bool transposed = (fixedWidth == 0 && fixedHeight > 0);
+  const int fixedSide = (transposed ? fixedHeight : fixedWidth);
+
+  int minWidth = 0;
+  int binHeight = 0;
+  int64_t area = 0;
+  for (int i = 0; i < int(m_rects.size()); ++i) {
+    const gfx::Size sz = inflatedSize(i, transposed);
+    minWidth = std::max(minWidth, sz.w);
+    binHeight += sz.h;
+    area += int64_t(sz.w) * sz.h;
+  }
+
+  // Candidate bin widths (from a tall texture to a wide one)
+  std::vector<int> widths;
+  if (fixedSide > 0) {
+    widths.push_back(textureToBin(fixedSide));
+  }
+  else {
+    const int side = int(std::ceil(std::sqrt(double(area))));
+    const int maxWidth = std::max(minWidth, 2 * side);
+    for (int w = std::max(minWidth, 3 * side / 4); w < maxWidth; w = std::max(w + 1, 21 * w / 20))
+      widths.push_back(w);
+    widths.push_back(maxWidth);
+  }
+
+  const base::tick_t t0 = base::current_tick();
+  Rects output;
+  Rects bestOutput;
+  gfx::Size best(0, 0);
+  int64_t bestArea = std::numeric_limits<int64_t>::max();
+  int triesWithoutImprovement = 0;
+
+  for (int k = 0; k < int(widths.size()); ++k) {
+    token.set_progress(float(k) / widths.size());
+
+    int usedHeight = 0;
+    packInBin(widths[k], binHeight, Heuristic::BottomLeft, transposed, token, output, usedHeight);
+    if (token.canceled())
+      break;
+
+    const gfx::Size texSize(binToTexture(widths[k]), binToTexture(usedHeight));
+    const int64_t texArea = int64_t(texSize.w) * texSize.h;
+    if (texArea < bestArea ||
+        (texArea == bestArea && std::max(texSize.w, texSize.h) < std::max(best.w, best.h))) {
+      best = texSize;
+      bestArea = texArea;
+      std::swap(bestOutput, output);
+      triesWithoutImprovement = 0;
+    }
+    else if (++triesWithoutImprovement >= kMaxTriesWithoutImprovement) {
+      break;
+    }
+
+    if (double(area) >= kGoodEnoughFill * double(widths[k]) * usedHeight)
+      break;
+
+    if (m_timeBudget > 0 && base::current_tick() - t0 >= base::tick_t(m_timeBudget))
+      break;
+  }
+
+  if (!bestOutput.empty())
+    m_rects = std::move(bestOutput);
+
+  if (transposed)
+    std::swap(best.w, best.h);
+  return best;
+}
+
+bool MaxRectsPacker::pack(const gfx::Size& size, base::task_token& token)
+{
+  if (m_rects.empty())
+    return true;
+
+  sortRects();
+
+  Rects output;
+  int usedHeight = 0;
+  const int packed = packInBin(textureToBin(size.w),
+                               textureToBin(size.h),
+                               Heuristic::BestShortSideFit,
+                               false,
+                               token,
+                               output,
+                               usedHeight);
+  m_rects = std::move(output);
+  return (packed == int(m_rects.size()));
+}
+
+int MaxRectsPacker::packInBin(const int binWidth,
+                              const int binHeight,
+                              const Heuristic heuristic,
+                              const bool transposed,
+                              base::task_token& token,
+                              Rects& output,
+                              int& usedHeight) const
+{
+  output.resize(m_rects.size());
+  for (int i = 0; i < int(m_rects.size()); ++i)
+    output[i] = gfx::Rect(m_borderPadding, m_borderPadding, m_rects[i].w, m_rects[i].h);
+
+  usedHeight = 0;
+  if (binWidth <= 0 || binHeight <= 0)
+    return 0;
+
+  Rects freeRects;
+  freeRects.push_back(gfx::Rect(0, 0, binWidth, binHeight));
+
+  int packed = 0;
+  for (const int i : m_order) {
+    if (token.canceled())
+      break;
+
+    const gfx::Size sz = inflatedSize(i, transposed);
+    int best = -1;
+    int bestScore1 = std::numeric_limits<int>::max();
+    int bestScore2 = std::numeric_limits<int>::max();
+
+    for (int j = 0; j < int(freeRects.size()); ++j) {
+      const gfx::Rect& f = freeRects[j];
+      if (f.w < sz.w || f.h < sz.h)
+        continue;
+
+      int score1, score2;
+      switch (heuristic) {
+        case Heuristic::BestShortSideFit:
+          score1 = std::min(f.w - sz.w, f.h - sz.h);
+          score2 = std::max(f.w - sz.w, f.h - sz.h);
+          break;
+        case Heuristic::BottomLeft:
+        default:
+          score1 = f.y + sz.h;
+          score2 = f.x;
+          break;
+      }
+      if (score1 < bestScore1 || (score1 == bestScore1 && score2 < bestScore2)) {
+        best = j;
+        bestScore1 = score1;
+        bestScore2 = score2;
+      }
+    }
+
+    // This rectangle doesn't fit
+    if (best < 0)
+      continue;
+
+    const gfx::Rect used(freeRects[best].x, freeRects[best].y, sz.w, sz.h);
+    split_free_rects(freeRects, used);
+    usedHeight = std::max(usedHeight, used.y2());
+
+    gfx::Rect& rc = output[i];
+    rc.x = m_borderPadding + (transposed ? used.y : used.x);
+    rc.y = m_borderPadding + (transposed ? used.x : used.y);
+    ++packed;
+  }
+  return packed;
+}
+
+gfx::Size MaxRectsPacker::inflatedSize(const int i, const bool transposed) const
+{
+  const gfx::Rect& rc = m_rects[i];
+  if (transposed)
+    return gfx::Size(rc.h + m_shapePadding, rc.w + m_shapePadding);
+  return gfx::Size(rc.w + m_shapePadding, rc.h + m_shapePadding);
+}
+
+// Biggest rectangles are packed first (it's the order that gives
+// better results for MaxRects).
+void MaxRectsPacker::sortRects()
+{
+  m_order.resize(m_rects.size());
+  std::iota(m_order.begin(), m_order.end(), 0);
+  std::stable_sort(m_order.begin(), m_order.end(), [this](const int a, const int b) {
+    const gfx::Rect& ra = m_rects[a];
+    const gfx::Rect& rb = m_rects[b];
+    const int sa = std::max(ra.w, ra.h);
+    const int sb = std::max(rb.w, rb.h);
+    if (sa != sb)
+      return sa > sb;
+    return ra.w * ra.h > rb.w * rb.h;
+  });
+}
+
+} // namespace app
@@ -0,0 +1,101 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_MAX_RECTS_PACKER_H_INCLUDED
+#define APP_MAX_RECTS_PACKER_H_INCLUDED
+#pragma once
+
+#include "gfx/rect.h"
+#include "gfx/size.h"
+
+#include <vector>
+
+namespace base {
+class task_token;
+}
+
+namespace app {
+
+// Rectangle packer using the MaxRects algorithm. It has the same
+// interface as gfx::PackingRects, but bestFit() packs each
+// candidate texture width just once (with an unbounded height)
+// instead of re-packing each width/height pair, stops as soon as it
+// finds a tight enough texture, and stops refining the result when
+// its time budget is exhausted. This makes it scale to sprite
+// sheets with thousands of samples.
+class MaxRectsPacker {
+public:
+  typedef std::vector<gfx::Rect> Rects;
+  typedef Rects::const_iterator const_iterator;
+
+  // Default time budget for bestFit() in milliseconds.
+  static constexpr int kDefaultTimeBudget = 2000;
+
+  MaxRectsPacker(int borderPadding = 0, int shapePadding = 0);
+
+  // Maximum time (in milliseconds) that bestFit() can spend trying
+  // different texture sizes (0 means no limit). At least one size is
+  // always tried, so all rectangles are packed anyway.
+  void setTimeBudget(int msecs) { m_timeBudget = msecs; }
+
+  // Iterate over the packed rectangles (in the same order they were
+  // added).
+  std::size_t size() const { return m_rects.size(); }
+  const_iterator begin() const { return m_rects.begin(); }
+  const_iterator end() const { return m_rects.end(); }
+  const gfx::Rect& operator[](int i) const { return m_rects[i]; }
+
+  void add(const gfx::Size& sz);
+
+  // Returns the smallest texture size found to pack all the
+  // rectangles. If fixedWidth or fixedHeight is not zero, that
+  // dimension of the texture is fixed.
+  gfx::Size bestFit(base::task_token& token, int fixedWidth = 0, int fixedHeight = 0);
+
+  // Packs all the rectangles in a texture of the given size. Returns
+  // false if some rectangle doesn't fit (its position is left at
+  // the border padding origin).
+  bool pack(const gfx::Size& size, base::task_token& token);
+
+private:
+  enum class Heuristic {
+    BestShortSideFit, // For fixed size bins
+    BottomLeft,       // For bins with an unbounded height
+  };
+
+  // Packs the rectangles in a bin of binWidth x binHeight (the bin
+  // is the texture without borders, where each rectangle occupies
+  // its size + shape padding). If "transposed" is true, width and
+  // height are swapped for all rectangles. Returns the number of
+  // rectangles that fit, and the used height of the bin in
+  // "usedHeight".
+  int packInBin(int binWidth,
+                int binHeight,
+                Heuristic heuristic,
+                bool transposed,
+                base::task_token& token,
+                Rects& output,
+                int& usedHeight) const;
+
+  gfx::Size inflatedSize(int i, bool transposed) const;
+  int binToTexture(int binSize) const { return binSize + 2 * m_borderPadding - m_shapePadding; }
+  int textureToBin(int texSize) const { return texSize - 2 * m_borderPadding + m_shapePadding; }
+
+  void sortRects();
+
+  int m_borderPadding;
+  int m_shapePadding;
+  int m_timeBudget;
+  Rects m_rects;
+
+  // Indexes of m_rects in the order they should be packed (biggest
+  // rectangles first).
+  std::vector<int> m_order;
+};
+
+} // namespace app
+
+#endif
@@ -0,0 +1,132 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#include "tests/app_test.h"
+
+#include "app/max_rects_packer.h"
+#include "base/task.h"
+
+#include <random>
+
+using namespace app;
+
+// Checks that all rectangles are inside the texture (with the
+// border padding) and separated by the shape padding.
+static void expect_valid_packing(const MaxRectsPacker& packer,
+                                 const gfx::Size& size,
+                                 const int borderPadding,
+                                 const int shapePadding)
+{
+  const gfx::Rect inside(borderPadding,
+                         borderPadding,
+                         size.w - 2 * borderPadding,
+                         size.h - 2 * borderPadding);
+
+  for (int i = 0; i < int(packer.size()); ++i) {
+    const gfx::Rect& a = packer[i];
+    EXPECT_TRUE(inside.contains(a)) << "Rect " << i << " outside the texture";
+
+    for (int j = i + 1; j < int(packer.size()); ++j) {
+      gfx::Rect b = packer[j];
+      b.enlarge(shapePadding);
+      EXPECT_FALSE(a.intersects(b)) << "Rects " << i << " and " << j << " overlap";
+    }
+  }
+}
+
+TEST(MaxRectsPacker, Empty)
+{
+  base::task_token token;
+  MaxRectsPacker packer;
+  EXPECT_EQ(gfx::Size(0, 0), packer.bestFit(token));
+}
+
+TEST(MaxRectsPacker, KeepAddOrder)
+{
+  base::task_token token;
+  MaxRectsPacker packer;
+  packer.add(gfx::Size(2, 2));
+  packer.add(gfx::Size(8, 4));
+  packer.add(gfx::Size(1, 3));
+  packer.bestFit(token);
+
+  ASSERT_EQ(3, packer.size());
+  EXPECT_EQ(gfx::Size(2, 2), packer[0].size());
+  EXPECT_EQ(gfx::Size(8, 4), packer[1].size());
+  EXPECT_EQ(gfx::Size(1, 3), packer[2].size());
+}
+
+TEST(MaxRectsPacker, PerfectFit)
+{
+  base::task_token token;
+  MaxRectsPacker packer;
+  for (int i = 0; i < 16; ++i)
+    packer.add(gfx::Size(8, 8));
+
+  const gfx::Size size = packer.bestFit(token);
+  EXPECT_EQ(16 * 8 * 8, size.w * size.h);
+  expect_valid_packing(packer, size, 0, 0);
+}
+
+TEST(MaxRectsPacker, Padding)
+{
+  base::task_token token;
+  MaxRectsPacker packer(3, 2);
+  for (int i = 1; i < 20; ++i)
+    packer.add(gfx::Size(i, 21 - i));
+
+  const gfx::Size size = packer.bestFit(token);
+  expect_valid_packing(packer, size, 3, 2);
+}
+
+TEST(MaxRectsPacker, FixedWidthOrHeight)
+{
+  base::task_token token;
+  for (int fixed = 0; fixed < 2; ++fixed) {
+    MaxRectsPacker packer(1, 1);
+    for (int i = 0; i < 10; ++i)
+      packer.add(gfx::Size(10 + i, 5));
+
+    const gfx::Size size = (fixed == 0 ? packer.bestFit(token, 40, 0) :
+                                         packer.bestFit(token, 0, 40));
+    if (fixed == 0)
+      EXPECT_EQ(40, size.w);
+    else
+      EXPECT_EQ(40, size.h);
+    expect_valid_packing(packer, size, 1, 1);
+  }
+}
+
+TEST(MaxRectsPacker, FixedSize)
+{
+  base::task_token token;
+  MaxRectsPacker packer;
+  for (int i = 0; i < 4; ++i)
+    packer.add(gfx::Size(16, 16));
+
+  EXPECT_TRUE(packer.pack(gfx::Size(32, 32), token));
+  expect_valid_packing(packer, gfx::Size(32, 32), 0, 0);
+
+  packer.add(gfx::Size(1, 1));
+  EXPECT_FALSE(packer.pack(gfx::Size(32, 32), token));
+}
+
+TEST(MaxRectsPacker, ManyRects)
+{
+  base::task_token token;
+  MaxRectsPacker packer(0, 1);
+  std::mt19937 rnd(1);
+  int area = 0;
+  for (int i = 0; i < 2000; ++i) {
+    const gfx::Size sz(4 + rnd() % 60, 4 + rnd() % 60);
+    packer.add(sz);
+    area += (sz.w + 1) * (sz.h + 1);
+  }
+
+  const gfx::Size size = packer.bestFit(token);
+  EXPECT_GT(area, (size.w + 1) * (size.h + 1) * 3 / 4);
+  expect_valid_packing(packer, size, 0, 1);
+}
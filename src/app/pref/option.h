@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -10,7 +10,9 @@
 #pragma once
 
 #include "obs/signal.h"
+
 #include <string>
+#include <vector>
 
 #ifdef ENABLE_SCRIPTING
   #include "app/script/values.h"
@@ -32,6 +34,10 @@ public:
   virtual std::vector<Section*> sectionList() const { return {}; }
   virtual void save() = 0;
 
+  // Returns true if some option of this section (or its subsections)
+  // must be saved.
+  bool isDirty() const;
+
   obs::signal<void()> BeforeChange;
   obs::signal<void()> AfterChange;
 
@@ -45,6 +51,7 @@ public:
   virtual ~OptionBase() = default;
   const char* section() const { return m_section->name(); }
   const char* id() const { return m_id; }
+  virtual bool isDirty() const = 0;
   virtual void resetToDefault() = 0;
 
 #ifdef ENABLE_SCRIPTING
@@ -57,6 +64,19 @@ protected:
   const char* m_id;
 };
 
+inline bool Section::isDirty() const
+{
+  for (const OptionBase* opt : optionList()) {
+    if (opt->isDirty())
+      return true;
+  }
+  for (const Section* sec : sectionList()) {
+    if (sec->isDirty())
+      return true;
+  }
+  return false;
+}
+
 template<typename T>
 class Option : public OptionBase {
 public:
@@ -101,7 +121,7 @@ public:
   const T& defaultValue() const { return m_default; }
   void setDefaultValue(const T& defValue) { m_default = defValue; }
 
-  bool isDirty() const { return m_dirty; }
+  bool isDirty() const override { return m_dirty; }
   void forceDirtyFlag() { m_dirty = true; }
   void cleanDirtyFlag() { m_dirty = false; }
 
@@ -1,4 +1,5 @@
 // Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
 // Copyright (C) 2001-2015  David Capello
 //
 // This program is distributed under the terms of
@@ -18,8 +19,11 @@ namespace app {
 template<typename T>
 void load_option(Option<T>& opt)
 {
-  if (get_config_string(opt.section(), opt.id(), nullptr))
+  if (get_config_string(opt.section(), opt.id(), nullptr)) {
     opt(get_config_value(opt.section(), opt.id(), opt.defaultValue()));
+    // The value is already in the file, we don't need to save it
+    opt.cleanDirtyFlag();
+  }
   else
     opt.setValueAndDefault(opt.defaultValue());
 }
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2024  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -257,12 +257,13 @@ std::string Preferences::docConfigFileName(const Doc* doc)
 
 void Preferences::serializeDocPref(const Doc* doc, app::DocumentPreferences* docPref, bool save)
 {
-  bool flush_config = false;
+  std::string docFilename;
 
   if (doc) {
     // We do nothing if the document isn't associated to a file and we
-    // want to save its specific preferences.
-    if (save && !doc->isAssociatedToFile())
+    // want to save its specific preferences, or if there is nothing
+    // new to save (to avoid loading/saving its .ini file).
+    if (save && (!doc->isAssociatedToFile() || !docPref->isDirty()))
       return;
 
     // We always push a new configuration file in the stack to avoid
@@ -270,8 +271,13 @@ void Preferences::serializeDocPref(const Doc* doc, app::DocumentPreferences* doc
     // specified.
     push_config_state();
     if (doc->isAssociatedToFile()) {
-      set_config_file(docConfigFileName(doc).c_str());
-      flush_config = true;
+      docFilename = docConfigFileName(doc);
+
+      // To save the preferences we don't need to load the .ini file,
+      // only the modified values are merged with the file content in
+      // the background.
+      if (!save)
+        set_config_file(docFilename.c_str());
     }
   }
 
@@ -284,8 +290,8 @@ void Preferences::serializeDocPref(const Doc* doc, app::DocumentPreferences* doc
   }
 
   if (doc) {
-    if (save && flush_config)
-      flush_config_file();
+    if (save && !docFilename.empty())
+      merge_config_file(docFilename.c_str());
 
     pop_config_state();
   }
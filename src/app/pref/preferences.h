@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2023  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -14,6 +14,7 @@
 #include "app/docs_observer.h"
 #include "app/pref/option.h"
 #include "app/sprite_sheet_data_format.h"
+#include "app/sprite_sheet_pack_algorithm.h"
 #include "app/sprite_sheet_type.h"
 #include "app/tools/dynamics.h"
 #include "app/tools/freehand_algorithm.h"
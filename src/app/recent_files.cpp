@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2020  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -12,9 +12,12 @@
 #include "app/recent_files.h"
 
 #include "app/ini_file.h"
+#include "app/task_scheduler.h"
 #include "base/fs.h"
 #include "fmt/format.h"
+#include "ui/system.h"
 
+#include <algorithm>
 #include <cstdio>
 #include <cstring>
 #include <set>
@@ -41,13 +44,17 @@ struct compare_path {
 
 namespace app {
 
-RecentFiles::RecentFiles(const int limit) : m_limit(limit)
+RecentFiles::RecentFiles(const int limit)
+  : m_limit(limit)
+  , m_self(std::make_shared<RecentFiles*>(this))
 {
   load();
 }
 
 RecentFiles::~RecentFiles()
 {
+  // The result of the pending check of missing files is discarded
+  m_self.reset();
   save();
 }
 
@@ -70,6 +77,7 @@ void RecentFiles::addRecentFile(const std::string& filename)
   }
 
   Changed();
+  save();
 }
 
 void RecentFiles::removeRecentFile(const std::string& filename)
@@ -82,6 +90,7 @@ void RecentFiles::removeRecentFile(const std::string& filename)
     removeRecentFolder(dir);
 
   Changed();
+  save();
 }
 
 void RecentFiles::removeRecentFolder(const std::string& dir)
@@ -90,6 +99,7 @@ void RecentFiles::removeRecentFolder(const std::string& dir)
   removeItem(m_paths[kRecentFolders], fn);
 
   Changed();
+  save();
 }
 
 void RecentFiles::setLimit(const int newLimit)
@@ -106,6 +116,7 @@ void RecentFiles::setLimit(const int newLimit)
 
   m_limit = newLimit;
   Changed();
+  save();
 }
 
 void RecentFiles::clear()
@@ -115,18 +126,21 @@ void RecentFiles::clear()
   m_paths[kRecentFolders].clear();
 
   Changed();
+  save();
 }
 
 void RecentFiles::setFiles(const base::paths& pinnedFiles, const base::paths& recentFiles)
 {
   m_paths[kPinnedFiles] = pinnedFiles;
   m_paths[kRecentFiles] = recentFiles;
+  save();
 }
 
 void RecentFiles::setFolders(const base::paths& pinnedFolders, const base::paths& recentFolders)
 {
   m_paths[kPinnedFolders] = pinnedFolders;
   m_paths[kRecentFolders] = recentFolders;
+  save();
 }
 
 std::string RecentFiles::normalizePath(const std::string& filename)
@@ -160,6 +174,70 @@ void RecentFiles::removeItem(base::paths& list, const std::string& fn)
     list.erase(it);
 }
 
+void RecentFiles::removeMissingItems()
+{
+  PathLists lists;
+  for (int i = 0; i < kPinnedFonts; ++i)
+    lists[i] = m_paths[i];
+
+  // Without UI (e.g. CLI mode) there is no need to check the files in
+  // a background task.
+  if (!ui::UISystem::instance()) {
+    keepMissingItems(lists);
+    removeItems(lists);
+    return;
+  }
+
+  // Checking the files can take some time (e.g. network drives), so
+  // we do it in a background task and remove the missing items later
+  // from the UI thread.
+  std::weak_ptr<RecentFiles*> weak = m_self;
+  TaskScheduler::instance()->execute([weak, lists]() mutable {
+    keepMissingItems(lists);
+    if (std::all_of(lists.begin(), lists.end(), [](const base::paths& list) {
+          return list.empty();
+        })) {
+      return;
+    }
+
+    ui::execute_from_ui_thread([weak, lists] {
+      if (std::shared_ptr<RecentFiles*> self = weak.lock())
+        (*self)->removeItems(lists);
+    });
+  });
+}
+
+void RecentFiles::removeItems(const PathLists& lists)
+{
+  bool changed = false;
+  for (int i = 0; i < kPinnedFonts; ++i) {
+    for (const auto& fn : lists[i]) {
+      const std::size_t size = m_paths[i].size();
+      removeItem(m_paths[i], fn);
+      changed |= (m_paths[i].size() != size);
+    }
+  }
+  if (changed) {
+    Changed();
+    save();
+  }
+}
+
+// static
+void RecentFiles::keepMissingItems(PathLists& lists)
+{
+  for (int i = 0; i < kPinnedFonts; ++i) {
+    const bool files = (i == kPinnedFiles || i == kRecentFiles);
+    auto& list = lists[i];
+    list.erase(std::remove_if(list.begin(),
+                              list.end(),
+                              [files](const std::string& fn) {
+                                return (files ? base::is_file(fn) : base::is_directory(fn));
+                              }),
+               list.end());
+  }
+}
+
 void RecentFiles::load()
 {
   for (int i = 0; i < kCollections; ++i) {
@@ -184,19 +262,21 @@ void RecentFiles::load()
       }
 
       const char* fn = get_config_string(section, key.c_str(), nullptr);
-      if (fn && *fn &&
-          (((i == kPinnedFiles || i == kRecentFiles) && base::is_file(fn)) ||
-           ((i == kPinnedFolders || i == kRecentFolders) && base::is_directory(fn)))) {
+      if (i == kPinnedFonts) {
+        m_paths[i].push_back(fn);
+      }
+      else if (fn && *fn) {
         std::string normalFn = normalizePath(fn);
         m_paths[i].push_back(normalFn);
       }
-      else if (i == kPinnedFonts) {
-        m_paths[i].push_back(fn);
-      }
     }
   }
+
+  removeMissingItems();
 }
 
+// Updates the main configuration, the file is written in the
+// background (see flush_config_file()).
 void RecentFiles::save()
 {
   for (int i = 0; i < kCollections; ++i) {
@@ -222,6 +302,8 @@ void RecentFiles::save()
       set_config_bool(section, kConversionKey, true);
     }
   }
+
+  flush_config_file();
 }
 
 } // namespace app
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2019  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -12,6 +12,8 @@
 #include "base/paths.h"
 #include "obs/signal.h"
 
+#include <array>
+#include <memory>
 #include <string>
 
 namespace app {
@@ -42,14 +44,24 @@ public:
   obs::signal<void()> Changed;
 
 private:
+  // Lists of files and folders (pinned and recent ones)
+  using PathLists = std::array<base::paths, kPinnedFonts>;
+
   std::string normalizePath(const std::string& filename);
   void addItem(base::paths& list, const std::string& filename);
   void removeItem(base::paths& list, const std::string& filename);
+  void removeMissingItems();
+  void removeItems(const PathLists& lists);
+  static void keepMissingItems(PathLists& lists);
   void load();
   void save();
 
   base::paths m_paths[kCollections];
   int m_limit;
+
+  // To know if the RecentFiles still exists when the background task
+  // that checks the missing files finishes.
+  std::shared_ptr<RecentFiles*> m_self;
 };
 
 } // namespace app
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2022-2024  Igara Studio S.A.
+// Copyright (C) 2022-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -14,12 +14,21 @@
 
   #include "app/color_utils.h"
   #include "app/util/shader_helpers.h"
+  #include "doc/primitives.h"
   #include "doc/render_plan.h"
   #include "os/common/generic_surface.h"
   #include "os/skia/skia_surface.h"
 
   #include "include/core/SkCanvas.h"
+  #include "include/core/SkPixmap.h"
+  #include "include/core/SkSurface.h"
   #include "include/effects/SkRuntimeEffect.h"
+  #include "include/gpu/GrDirectContext.h"
+  #include "include/gpu/GrRecordingContext.h"
+  #include "include/gpu/ganesh/SkImageGanesh.h"
+  #include "include/gpu/ganesh/SkSurfaceGanesh.h"
+
+  #include <algorithm>
 
 namespace app {
 
@@ -56,6 +65,14 @@ half4 main(vec2 fragcoord) {
 }
 )";
 
+// Size of the tiles used to find the modified pixels of an image
+// that must be uploaded again to its texture.
+constexpr int kTextureTileSize = 64;
+
+// Maximum memory used by textures of images that weren't used in the
+// last render.
+constexpr std::size_t kMaxTexturesBytes = 512 * 1024 * 1024;
+
 inline SkBlendMode to_skia(const doc::BlendMode bm)
 {
   switch (bm) {
@@ -128,7 +145,8 @@ void ShaderRenderer::setProjection(const render::Projection& projection)
 
 void ShaderRenderer::setSelectedLayer(const doc::Layer* layer)
 {
-  // TODO impl
+  // TODO impl (non-active layers opacity)
+  m_activeLayer = layer;
 }
 
 void ShaderRenderer::setPreviewImage(const doc::Layer* layer,
@@ -183,6 +201,7 @@ void ShaderRenderer::renderSprite(os::Surface* dstSurface,
                                   const gfx::ClipF& area)
 {
   m_sprite = sprite;
+  ++m_texturesTick;
 
   // Copy the current color palette to a 256 palette (so all entries
   // outside the valid range will be transparent in the kIndexedShaderCode)
@@ -219,6 +238,8 @@ void ShaderRenderer::renderSprite(os::Surface* dstSurface,
     renderPlan(canvas, sprite, plan, frame, area);
   }
   canvas->restore();
+
+  removeUnusedTextures();
 }
 
 void ShaderRenderer::renderPlan(SkCanvas* canvas,
@@ -260,7 +281,13 @@ void ShaderRenderer::renderPlan(SkCanvas* canvas,
           int opacity = cel->opacity();
           opacity = MUL_UN8(opacity, imgLayer->opacity(), t);
 
-          drawImage(canvas, celImage, celBounds.x, celBounds.y, opacity, imgLayer->blendMode());
+          drawImage(canvas,
+                    celImage,
+                    celBounds.x,
+                    celBounds.y,
+                    opacity,
+                    imgLayer->blendMode(),
+                    celImage == m_previewImage || layer == m_activeLayer);
         }
         break;
       }
@@ -332,7 +359,8 @@ void ShaderRenderer::renderPlan(SkCanvas* canvas,
                         tileBoundsOnCanvas.x,
                         tileBoundsOnCanvas.y,
                         opacity,
-                        tilemapLayer->blendMode());
+                        tilemapLayer->blendMode(),
+                        layer == m_activeLayer);
             }
           }
         }
@@ -394,9 +422,12 @@ void ShaderRenderer::drawImage(SkCanvas* canvas,
                                const int x,
                                const int y,
                                const int opacity,
-                               const doc::BlendMode blendMode)
+                               const doc::BlendMode blendMode,
+                               const bool checkPixels)
 {
-  auto skImg = make_skimage_for_docimage(srcImage);
+  auto skImg = getSkImage(canvas, srcImage, checkPixels);
+  if (!skImg)
+    return;
 
   switch (srcImage->colorMode()) {
     case doc::ColorMode::RGB: {
@@ -453,6 +484,167 @@ void ShaderRenderer::drawImage(SkCanvas* canvas,
   }
 }
 
+sk_sp<SkImage> ShaderRenderer::getSkImage(SkCanvas* canvas,
+                                          const doc::Image* image,
+                                          const bool checkPixels)
+{
+  // On a raster canvas we can use the pixels of the image directly
+  // (there is nothing to upload).
+  GrRecordingContext* context = canvas->recordingContext();
+  GrDirectContext* directContext = (context ? context->asDirectContext() : nullptr);
+  if (!directContext)
+    return make_skimage_for_docimage(image);
+
+  if (m_texturesContext != directContext) {
+    m_textures.clear();
+    m_texturesBytes = 0;
+    m_texturesContext = directContext;
+  }
+
+  Texture& texture = m_textures[image->id()];
+  texture.tick = m_texturesTick;
+
+  if (texture.image && texture.size == image->size() &&
+      texture.pixelFormat == image->pixelFormat()) {
+    // Images are compared with their texture only when they were
+    // modified (or can be modified without a new version, e.g. the
+    // images of the active layer while the user paints).
+    if (texture.version != image->version() || checkPixels)
+      updateTexture(texture, directContext, image);
+  }
+  else
+    createTexture(texture, directContext, image);
+
+  if (!texture.image) {
+    m_textures.erase(image->id());
+    return make_skimage_for_docimage(image);
+  }
+  return texture.image;
+}
+
+void ShaderRenderer::createTexture(Texture& texture,
+                                   GrDirectContext* directContext,
+                                   const doc::Image* image)
+{
+  m_texturesBytes -= texture.bytes;
+
+  const SkImageInfo info = get_skimageinfo_for_docimage(image);
+  texture.version = image->version();
+  texture.size = image->size();
+  texture.pixelFormat = image->pixelFormat();
+  texture.bytes = std::size_t(image->rowBytes()) * image->height();
+  texture.image.reset();
+
+  // A GPU surface is used to upload only the modified tiles later
+  // (surfaces must be premultiplied, writePixels() converts the
+  // unpremultiplied RGBA pixels).
+  texture.surface = SkSurfaces::RenderTarget(
+    directContext,
+    skgpu::Budgeted::kYes,
+    (info.alphaType() == kUnpremul_SkAlphaType && info.colorType() != kAlpha_8_SkColorType ?
+       info.makeAlphaType(kPremul_SkAlphaType) :
+       info));
+  if (texture.surface &&
+      texture.surface->writePixels(SkPixmap(info, image->getPixelAddress(0, 0), image->rowBytes()),
+                                   0,
+                                   0)) {
+    texture.image = texture.surface->makeImageSnapshot();
+  }
+  else {
+    texture.surface.reset();
+    texture.image = SkImages::TextureFromImage(directContext,
+                                               make_skimage_for_docimage(image).get(),
+                                               skgpu::Mipmapped::kNo,
+                                               skgpu::Budgeted::kYes);
+  }
+
+  const int cols = (image->width() + kTextureTileSize - 1) / kTextureTileSize;
+  const int rows = (image->height() + kTextureTileSize - 1) / kTextureTileSize;
+  texture.tileHashes.resize(std::size_t(cols) * rows);
+  for (int v = 0, i = 0; v < rows; ++v) {
+    for (int u = 0; u < cols; ++u, ++i)
+      texture.tileHashes[i] = calculate_image_hash(image, textureTileBounds(image, u, v));
+  }
+
+  if (texture.image)
+    m_texturesBytes += texture.bytes;
+  else
+    texture.bytes = 0;
+}
+
+void ShaderRenderer::updateTexture(Texture& texture,
+                                   GrDirectContext* directContext,
+                                   const doc::Image* image)
+{
+  texture.version = image->version();
+
+  const int cols = (image->width() + kTextureTileSize - 1) / kTextureTileSize;
+  const int rows = (image->height() + kTextureTileSize - 1) / kTextureTileSize;
+  std::vector<gfx::Rect> modifiedTiles;
+  for (int v = 0, i = 0; v < rows; ++v) {
+    for (int u = 0; u < cols; ++u, ++i) {
+      const gfx::Rect tileBounds = textureTileBounds(image, u, v);
+      const uint32_t hash = calculate_image_hash(image, tileBounds);
+      if (texture.tileHashes[i] != hash) {
+        texture.tileHashes[i] = hash;
+        modifiedTiles.push_back(tileBounds);
+      }
+    }
+  }
+  if (modifiedTiles.empty())
+    return;
+
+  // Without a surface the whole image must be uploaded again
+  if (!texture.surface) {
+    createTexture(texture, directContext, image);
+    return;
+  }
+
+  // Release our reference to the snapshot so the surface doesn't
+  // need to copy its pixels before writing on it.
+  texture.image.reset();
+
+  const SkImageInfo info = get_skimageinfo_for_docimage(image);
+  for (const gfx::Rect& rc : modifiedTiles) {
+    texture.surface->writePixels(SkPixmap(info.makeWH(rc.w, rc.h),
+                                          image->getPixelAddress(rc.x, rc.y),
+                                          image->rowBytes()),
+                                 rc.x,
+                                 rc.y);
+  }
+  texture.image = texture.surface->makeImageSnapshot();
+}
+
+gfx::Rect ShaderRenderer::textureTileBounds(const doc::Image* image, const int u, const int v)
+{
+  return gfx::Rect(u * kTextureTileSize, v * kTextureTileSize, kTextureTileSize, kTextureTileSize)
+    .createIntersection(image->bounds());
+}
+
+void ShaderRenderer::removeUnusedTextures()
+{
+  if (m_texturesBytes <= kMaxTexturesBytes)
+    return;
+
+  // Remove the least recently used textures (but not the ones used in
+  // the last render).
+  std::vector<std::pair<uint64_t, doc::ObjectId>> unused;
+  for (const auto& it : m_textures) {
+    if (it.second.tick != m_texturesTick)
+      unused.emplace_back(it.second.tick, it.first);
+  }
+  std::sort(unused.begin(), unused.end());
+
+  for (const auto& it : unused) {
+    if (m_texturesBytes <= kMaxTexturesBytes)
+      break;
+
+    auto jt = m_textures.find(it.second);
+    m_texturesBytes -= jt->second.bytes;
+    m_textures.erase(jt);
+  }
+}
+
 // TODO this is equal to Render::checkIfWeShouldUsePreview(const Cel*),
 //      we might think in a way to merge both functions
 bool ShaderRenderer::checkIfWeShouldUsePreview(const doc::Cel* cel) const
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2022-2023  Igara Studio S.A.
+// Copyright (C) 2022-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -11,12 +11,25 @@
 #if SK_ENABLE_SKSL
 
   #include "app/render/renderer.h"
+  #include "doc/object_id.h"
+  #include "doc/object_version.h"
   #include "doc/palette.h"
+  #include "doc/pixel_format.h"
+  #include "gfx/rect.h"
+  #include "gfx/size.h"
 
   #include "include/core/SkRefCnt.h"
 
+  #include <cstddef>
+  #include <cstdint>
+  #include <unordered_map>
+  #include <vector>
+
+class GrDirectContext;
 class SkCanvas;
+class SkImage;
 class SkRuntimeEffect;
+class SkSurface;
 
 namespace doc {
 class RenderPlan;
@@ -77,6 +90,24 @@ public:
                    const doc::BlendMode blendMode) override;
 
 private:
+  // Pixels of a doc::Image uploaded to the GPU. The texture is used
+  // again while the image keeps the same version, and when it's
+  // modified only the tiles with different pixels are uploaded.
+  struct Texture {
+    doc::ObjectVersion version = 0;
+    gfx::Size size;
+    doc::PixelFormat pixelFormat = doc::IMAGE_RGB;
+    std::size_t bytes = 0;
+    // GPU surface to update the texture partially (it might be
+    // nullptr if the color type cannot be used in a surface).
+    sk_sp<SkSurface> surface;
+    sk_sp<SkImage> image;
+    // Hash of each tile of kTextureTileSize pixels.
+    std::vector<uint32_t> tileHashes;
+    // Last render where this texture was used.
+    uint64_t tick = 0;
+  };
+
   void renderPlan(SkCanvas* canvas,
                   const doc::Sprite* sprite,
                   const doc::RenderPlan& plan,
@@ -87,7 +118,18 @@ private:
                  const int x,
                  const int y,
                  const int opacity,
-                 const doc::BlendMode blendMode);
+                 const doc::BlendMode blendMode,
+                 const bool checkPixels);
+
+  // Returns the Skia image to draw the given doc::Image. On GPU
+  // canvases it's a cached texture. If "checkPixels" is true, the
+  // image is compared with its texture even if its version didn't
+  // change.
+  sk_sp<SkImage> getSkImage(SkCanvas* canvas, const doc::Image* image, const bool checkPixels);
+  void createTexture(Texture& texture, GrDirectContext* directContext, const doc::Image* image);
+  void updateTexture(Texture& texture, GrDirectContext* directContext, const doc::Image* image);
+  static gfx::Rect textureTileBounds(const doc::Image* image, const int u, const int v);
+  void removeUnusedTextures();
 
   bool checkIfWeShouldUsePreview(const doc::Cel* cel) const;
   void afterBackgroundLayerIsPainted();
@@ -109,6 +151,17 @@ private:
   gfx::Point m_previewPos;
   doc::BlendMode m_previewBlendMode = doc::BlendMode::NORMAL;
 
+  // Layer selected in the editor, its images (e.g. the images that
+  // are being modified by the user) are compared with their
+  // textures in each render.
+  const doc::Layer* m_activeLayer = nullptr;
+
+  // Textures of the rendered images by image ID.
+  std::unordered_map<doc::ObjectId, Texture> m_textures;
+  GrDirectContext* m_texturesContext = nullptr;
+  std::size_t m_texturesBytes = 0;
+  uint64_t m_texturesTick = 0;
+
   // Palette of 256 colors (useful for the indexed shader to set all
   // colors outside the valid range as transparent RGBA=0 values)
   doc::Palette m_palette;
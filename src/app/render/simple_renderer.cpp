@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2022-2023  Igara Studio S.A.
+// Copyright (C) 2022-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -20,6 +20,10 @@ using namespace doc;
 SimpleRenderer::SimpleRenderer()
 {
   m_properties.outputsUnpremultiplied = true;
+  m_render.setParallelRender(true);
+  m_render.setBelowLayersCache(true);
+  m_render.setMipmaps(true);
+  m_render.setTilemapCache(true);
 }
 
 void SimpleRenderer::setRefLayersVisiblity(const bool visible)
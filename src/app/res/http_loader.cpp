@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2022  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2001-2016  David Capello
 //
 // This program is distributed under the terms of
@@ -11,11 +11,12 @@
 
 #include "app/res/http_loader.h"
 
+#include "app/task_scheduler.h"
 #include "base/fs.h"
 #include "base/fstream_path.h"
 #include "base/replace_string.h"
-#include "base/scoped_value.h"
 #include "base/string.h"
+#include "net/http_headers.h"
 #include "net/http_request.h"
 #include "net/http_response.h"
 #include "ver/info.h"
@@ -24,21 +25,36 @@
 
 namespace app {
 
+// At most two requests are sent at the same time from the blocking
+// threads, as they are mostly waiting the network.
+static SerialTaskGroup& http_tasks()
+{
+  static SerialTaskGroup tasks(TaskKind::Blocking, 2);
+  return tasks;
+}
+
 HttpLoader::HttpLoader(const std::string& url)
   : m_url(url)
   , m_done(false)
+  , m_aborted(false)
   , m_request(nullptr)
-  , m_thread([this] { threadHttpRequest(); })
 {
+  http_tasks().run([this] { threadHttpRequest(); });
 }
 
 HttpLoader::~HttpLoader()
 {
-  m_thread.join();
+  abort();
+
+  std::unique_lock lock(m_mutex);
+  m_doneCV.wait(lock, [this] { return m_done.load(); });
 }
 
 void HttpLoader::abort()
 {
+  m_aborted = true;
+
+  const std::lock_guard lock(m_mutex);
   if (m_request)
     m_request->abort();
 }
@@ -46,8 +62,6 @@ void HttpLoader::abort()
 void HttpLoader::threadHttpRequest()
 {
   try {
-    base::ScopedValue<std::atomic<bool>, bool> scoped(m_done, false, true);
-
     LOG("HTTP: Sending http request to %s\n", m_url.c_str());
 
     std::string dir = base::join_path(base::get_temp_path(), get_app_name());
@@ -60,13 +74,59 @@ void HttpLoader::threadHttpRequest()
     base::replace_string(fn, "&", "-");
     fn = base::join_path(dir, fn);
 
-    std::ofstream output(FSTREAM_PATH(fn), std::ofstream::binary);
-    m_request = new net::HttpRequest(m_url);
+    // The ETag and Last-Modified headers of the last downloaded file
+    // are saved in a .info file to send a conditional request.
+    const std::string infoFn = fn + ".info";
+    std::string etag, lastModified;
+    if (base::is_file(fn) && base::is_file(infoFn)) {
+      std::ifstream info(FSTREAM_PATH(infoFn));
+      std::getline(info, etag);
+      std::getline(info, lastModified);
+    }
+
+    net::HttpHeaders headers;
+    if (!etag.empty())
+      headers.setHeader("If-None-Match", etag);
+    if (!lastModified.empty())
+      headers.setHeader("If-Modified-Since", lastModified);
+
+    // Download the body in a temporary file to keep the cached file
+    // if the request fails.
+    const std::string tmpFn = fn + ".tmp";
+    std::ofstream output(FSTREAM_PATH(tmpFn), std::ofstream::binary);
     net::HttpResponse response(&output);
-    if (m_request->send(response) && response.status() == 200) {
+    net::HttpRequest request(m_url);
+    request.setHeaders(headers);
+    {
+      const std::lock_guard lock(m_mutex);
+      m_request = &request;
+    }
+    const bool sent = (!m_aborted && request.send(response));
+    {
+      const std::lock_guard lock(m_mutex);
+      m_request = nullptr;
+    }
+    output.close();
+
+    if (sent && response.status() == 200) {
+      if (base::is_file(fn))
+        base::delete_file(fn);
+      base::move_file(tmpFn, fn);
+
+      std::ofstream info(FSTREAM_PATH(infoFn));
+      info << response.headers().header("etag") << "\n"
+           << response.headers().header("last-modified") << "\n";
+
+      m_filename = fn;
+    }
+    // Not modified, use the cached file
+    else if (sent && response.status() == 304) {
       m_filename = fn;
     }
 
+    if (base::is_file(tmpFn))
+      base::delete_file(tmpFn);
+
     LOG("HTTP: Response: %d\n", response.status());
   }
   catch (const std::exception& e) {
@@ -76,8 +136,9 @@ void HttpLoader::threadHttpRequest()
     LOG(ERROR, "HTTP: Unexpected unknown exception sending http request\n");
   }
 
-  delete m_request;
-  m_request = nullptr;
+  const std::lock_guard lock(m_mutex);
+  m_done = true;
+  m_doneCV.notify_all();
 }
 
 } // namespace app
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2022-2023  Igara Studio S.A.
+// Copyright (C) 2022-2026  Igara Studio S.A.
 // Copyright (C) 2001-2016  David Capello
 //
 // This program is distributed under the terms of
@@ -10,8 +10,9 @@
 #pragma once
 
 #include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <string>
-#include <thread>
 
 namespace net {
 class HttpRequest;
@@ -19,6 +20,10 @@ class HttpRequest;
 
 namespace app {
 
+// Downloads the given URL in a file of the temporary directory. The
+// requests are sent from a shared pool with a limited number of
+// threads, and the downloaded file is re-used if the server says
+// that it wasn't modified (using its ETag/Last-Modified headers).
 class HttpLoader {
 public:
   HttpLoader(const std::string& url);
@@ -33,8 +38,10 @@ private:
 
   std::string m_url;
   std::atomic<bool> m_done;
+  std::atomic<bool> m_aborted;
+  std::mutex m_mutex; // Protects m_request
+  std::condition_variable m_doneCV;
   net::HttpRequest* m_request;
-  std::thread m_thread;
   std::string m_filename;
 };
 
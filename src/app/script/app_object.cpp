@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2024  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2015-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -40,19 +40,23 @@
 #include "app/ui/status_bar.h"
 #include "app/ui/timeline/timeline.h"
 #include "app/ui_context.h"
+#include "app/util/memory_usage.h"
 #include "base/fs.h"
 #include "base/replace_string.h"
 #include "base/version.h"
+#include "doc/image_buffer_pool.h"
 #include "doc/layer.h"
 #include "doc/primitives.h"
 #include "doc/tag.h"
 #include "render/render.h"
+#include "tracing/metrics.h"
 #include "ui/alert.h"
 #include "ui/scale.h"
 #include "ver/info.h"
 
 #include <cstring>
 #include <iostream>
+#include <optional>
 
 namespace app { namespace script {
 
@@ -126,7 +130,10 @@ int App_exit(lua_State* L)
   return 0;
 }
 
-int App_transaction(lua_State* L)
+// Runs the function of app.transaction() or app.batch() inside a
+// transaction. If "deferNotifications" is true, the notifications of
+// the modified documents are collapsed and sent at the end.
+int run_transaction(lua_State* L, const bool deferNotifications)
 {
   int top = lua_gettop(L);
   int nresults = 0;
@@ -156,6 +163,13 @@ int App_transaction(lua_State* L)
       // RWLock now is re-entrant and we are able to call commands
       // inside the app.transaction() (creating inner ContextWriters).
       ContextWriter writer(ctx);
+
+      // Notifications are sent when "defer" is destroyed (after the
+      // transaction is committed).
+      std::optional<DeferDocNotifications> defer;
+      if (deferNotifications)
+        defer.emplace();
+
       Tx tx(writer, label);
 
       lua_pushvalue(L, -1);
@@ -172,6 +186,19 @@ int App_transaction(lua_State* L)
   return nresults;
 }
 
+int App_transaction(lua_State* L)
+{
+  return run_transaction(L, false);
+}
+
+int App_batch(lua_State* L)
+{
+  // Like app.transaction() but observers (editors, timeline, etc.)
+  // are notified only once at the end for each modified property,
+  // instead of once per change.
+  return run_transaction(L, true);
+}
+
 int App_undo(lua_State* L)
 {
   app::Context* ctx = App::instance()->context();
@@ -653,6 +680,41 @@ int App_get_sprites(lua_State* L)
   return 1;
 }
 
+int App_get_memory(lua_State* L)
+{
+  const DocMemoryUsage usage = get_docs_memory_usage(App::instance()->context()->documents());
+  const doc::ImageBufferPool* pool = doc::ImageBufferPool::instance();
+
+  lua_newtable(L);
+  setfield_uinteger(L, "images", usage.images);
+  setfield_uinteger(L, "undo", usage.undo);
+  setfield_uinteger(L, "cache", pool->unusedBytes());
+  setfield_uinteger(L, "cacheLimit", pool->maxBytes());
+  return 1;
+}
+
+int App_get_perf(lua_State* L)
+{
+  lua_newtable(L);
+  tracing::for_each_metric([L](const tracing::Metric& metric) {
+    if (metric.type() == tracing::Metric::Type::Counter) {
+      lua_pushinteger(L, static_cast<const tracing::Counter&>(metric).value());
+    }
+    else {
+      const auto& histogram = static_cast<const tracing::Histogram&>(metric);
+      lua_newtable(L);
+      setfield_uinteger(L, "count", histogram.count());
+      setfield_uinteger(L, "sum", histogram.sum());
+      setfield_uinteger(L, "max", histogram.max());
+      setfield_uinteger(L, "p50", histogram.percentile(0.5));
+      setfield_uinteger(L, "p90", histogram.percentile(0.9));
+      setfield_uinteger(L, "p99", histogram.percentile(0.99));
+    }
+    lua_setfield(L, -2, metric.name());
+  });
+  return 1;
+}
+
 int App_get_fgColor(lua_State* L)
 {
   push_obj<app::Color>(L, Preferences::instance().colorBar.fgColor());
@@ -853,6 +915,7 @@ const luaL_Reg App_methods[] = {
   { "open",        App_open        },
   { "exit",        App_exit        },
   { "transaction", App_transaction },
+  { "batch",       App_batch       },
   { "undo",        App_undo        },
   { "redo",        App_redo        },
   { "alert",       App_alert       },
@@ -884,6 +947,8 @@ const Property App_properties[] = {
   { "brush",          App_get_brush,          App_set_brush          },
 
   { "sprites",        App_get_sprites,        nullptr                },
+  { "memory",         App_get_memory,         nullptr                },
+  { "perf",           App_get_perf,           nullptr                },
   { "fgColor",        App_get_fgColor,        App_set_fgColor        },
   { "bgColor",        App_get_bgColor,        App_set_bgColor        },
   { "fgTile",         App_get_fgTile,         App_set_fgTile         },
@@ -0,0 +1,170 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/script/bytecode_cache.h"
+
+#include "app/resource_finder.h"
+#include "base/convert_to.h"
+#include "base/fs.h"
+#include "base/sha1.h"
+#include "base/time.h"
+#include "fmt/format.h"
+
+#include <cstring>
+
+namespace app { namespace script {
+
+namespace {
+
+// First line of each cached file (change the version number if the
+// format of these files changes).
+const char* kBytecodeHeader = "aseprite-luac 1\n";
+
+// Returns the directory of the cache, or an empty string if it
+// cannot be created.
+const std::string& cache_dir()
+{
+  static std::string dir;
+  static bool initialized = false;
+  if (!initialized) {
+    initialized = true;
+    try {
+      ResourceFinder rf;
+      rf.includeUserDir(base::join_path("scripts-cache", ".").c_str());
+      dir = rf.getFirstOrCreateDefault();
+      if (!base::is_directory(dir))
+        base::make_all_directories(dir);
+    }
+    catch (const std::exception&) {
+      dir.clear();
+    }
+  }
+  return dir;
+}
+
+// Each .lua file has only one entry in the cache (identified by its
+// path), and the entry has a stamp to know if it's still valid.
+std::string entry_filename(const std::string& dir, const std::string& filename)
+{
+  const std::string key = base::convert_to<std::string>(
+    base::Sha1::calculateFromString(base::get_absolute_path(filename)));
+  return base::join_path(dir, key + ".luac");
+}
+
+std::string file_stamp(const std::string& filename)
+{
+  const base::Time t = base::get_modification_time(filename);
+  return fmt::format("{} {} {:04}{:02}{:02}{:02}{:02}{:02} {}\n",
+                     LUA_VERSION_RELEASE_NUM,
+                     base::file_size(filename),
+                     t.year,
+                     t.month,
+                     t.day,
+                     t.hour,
+                     t.minute,
+                     t.second,
+                     base::get_absolute_path(filename));
+}
+
+int bytecode_writer(lua_State* L, const void* p, size_t sz, void* ud)
+{
+  ((std::string*)ud)->append((const char*)p, sz);
+  return 0;
+}
+
+// Searcher for package.searchers[2] (like the original Lua files
+// searcher, but using load_file_with_cache()).
+int lua_searcher(lua_State* L)
+{
+  const char* name = luaL_checkstring(L, 1);
+
+  // local filename, err = package.searchpath(name, package.path)
+  lua_getglobal(L, "package");
+  lua_getfield(L, -1, "searchpath");
+  lua_pushstring(L, name);
+  lua_getfield(L, -3, "path");
+  if (!lua_isstring(L, -1))
+    return luaL_error(L, "'package.path' must be a string");
+  lua_call(L, 2, 2);
+  if (lua_isnil(L, -2))
+    return 1; // Return the error message
+
+  lua_pop(L, 1);
+  const std::string filename = lua_tostring(L, -1);
+  if (load_file_with_cache(L, filename) != LUA_OK) {
+    return luaL_error(L,
+                      "error loading module '%s' from file '%s':\n\t%s",
+                      name,
+                      filename.c_str(),
+                      lua_tostring(L, -1));
+  }
+  lua_pushstring(L, filename.c_str()); // 2nd argument to the module
+  return 2;
+}
+
+} // anonymous namespace
+
+int load_file_with_cache(lua_State* L, const std::string& filename)
+{
+  const std::string& dir = cache_dir();
+  if (dir.empty() || !base::is_file(filename))
+    return luaL_loadfile(L, filename.c_str());
+
+  const std::string chunkname = "@" + filename;
+  const std::string entryFn = entry_filename(dir, filename);
+  const std::string header = kBytecodeHeader + file_stamp(filename);
+
+  // Load the compiled chunk from the cache
+  if (base::is_file(entryFn)) {
+    try {
+      const base::buffer buf = base::read_file_content(entryFn);
+      if (buf.size() > header.size() && std::memcmp(buf.data(), header.c_str(), header.size()) == 0) {
+        const char* bytecode = (const char*)buf.data() + header.size();
+        const size_t size = buf.size() - header.size();
+        if (luaL_loadbufferx(L, bytecode, size, chunkname.c_str(), "b") == LUA_OK)
+          return LUA_OK;
+
+        // Invalid bytecode, compile the file again
+        lua_pop(L, 1);
+      }
+    }
+    catch (const std::exception&) {
+      // Compile the file
+    }
+  }
+
+  const int status = luaL_loadfile(L, filename.c_str());
+  if (status != LUA_OK)
+    return status;
+
+  // Save the compiled chunk (with debug information, so errors and
+  // the debugger have the line numbers)
+  std::string data = header;
+  if (lua_dump(L, bytecode_writer, &data, 0) == 0) {
+    try {
+      base::write_file_content(entryFn, (const uint8_t*)data.c_str(), data.size());
+    }
+    catch (const std::exception&) {
+      // Ignore errors, the file will be compiled again the next time
+    }
+  }
+  return LUA_OK;
+}
+
+void use_bytecode_cache_for_require(lua_State* L)
+{
+  lua_getglobal(L, "package");
+  lua_getfield(L, -1, "searchers");
+  lua_pushcfunction(L, lua_searcher);
+  lua_rawseti(L, -2, 2);
+  lua_pop(L, 2);
+}
+
+}} // namespace app::script
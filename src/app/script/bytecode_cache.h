@@ -0,0 +1,32 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_SCRIPT_BYTECODE_CACHE_H_INCLUDED
+#define APP_SCRIPT_BYTECODE_CACHE_H_INCLUDED
+#pragma once
+
+#include "app/script/luacpp.h"
+
+#include <string>
+
+namespace app { namespace script {
+
+// Loads the given .lua file as a Lua function (pushed on the stack)
+// like luaL_loadfile(), but using a cache of compiled bytecode in
+// the user config directory, so the file is parsed only when it's
+// modified (the cache entry is identified by the path, size and
+// modification time of the file, and the Lua version). The chunk
+// name is "@filename". Returns LUA_OK or the error code of
+// luaL_loadfile() (with the error message pushed on the stack).
+int load_file_with_cache(lua_State* L, const std::string& filename);
+
+// Replaces the Lua files searcher of require() to load modules
+// with load_file_with_cache().
+void use_bytecode_cache_for_require(lua_State* L);
+
+}} // namespace app::script
+
+#endif
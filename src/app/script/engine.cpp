@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2024  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -17,6 +17,7 @@
 #include "app/doc_range.h"
 #include "app/pref/preferences.h"
 #include "app/script/blend_mode.h"
+#include "app/script/bytecode_cache.h"
 #include "app/script/luacpp.h"
 #include "app/script/require.h"
 #include "app/script/security.h"
@@ -124,7 +125,7 @@ int dofile(lua_State* L)
   }
 
   lua_settop(L, 1);
-  if (luaL_loadfile(L, fname.c_str()) != LUA_OK)
+  if (load_file_with_cache(L, fname) != LUA_OK)
     return lua_error(L);
   {
     AddScriptFilename add(fname);
@@ -181,6 +182,7 @@ void register_grid_class(lua_State* L);
 void register_image_class(lua_State* L);
 void register_image_iterator_class(lua_State* L);
 void register_image_spec_class(lua_State* L);
+void register_image_view_class(lua_State* L);
 void register_images_class(lua_State* L);
 void register_layer_class(lua_State* L);
 void register_layers_class(lua_State* L);
@@ -210,6 +212,7 @@ void register_tool_class(lua_State* L);
 void register_uuid_class(lua_State* L);
 void register_version_class(lua_State* L);
 void register_websocket_class(lua_State* L);
+void register_worker_class(lua_State* L);
 
 void set_app_params(lua_State* L, const Params& params);
 
@@ -241,7 +244,9 @@ Engine::Engine() : L(luaL_newstate()), m_delegate(nullptr), m_printLastResult(fa
   lua_setfield(L, -2, "clock");
   lua_pop(L, 1);
 
-  // Enhance require() function for plugins
+  // Enhance require() function for plugins (and load modules using
+  // the bytecode cache)
+  use_bytecode_cache_for_require(L);
   custom_require_function(L);
 
   // Generic code used by metatables
@@ -483,6 +488,7 @@ Engine::Engine() : L(luaL_newstate()), m_delegate(nullptr), m_printLastResult(fa
   register_image_class(L);
   register_image_iterator_class(L);
   register_image_spec_class(L);
+  register_image_view_class(L);
   register_images_class(L);
   register_layer_class(L);
   register_layers_class(L);
@@ -511,6 +517,7 @@ Engine::Engine() : L(luaL_newstate()), m_delegate(nullptr), m_printLastResult(fa
   register_tool_class(L);
   register_uuid_class(L);
   register_version_class(L);
+  register_worker_class(L);
 #if ENABLE_WEBSOCKET
   register_websocket_class(L);
 #endif
@@ -555,10 +562,17 @@ void Engine::printLastResult()
 }
 
 bool Engine::evalCode(const std::string& code, const std::string& filename)
+{
+  return evalLoadedChunk(luaL_loadbuffer(L, code.c_str(), code.size(), filename.c_str()));
+}
+
+// Calls the function loaded in the stack with the given load status
+// (the status of luaL_loadbuffer() or similar function).
+bool Engine::evalLoadedChunk(const int loadStatus)
 {
   bool ok = true;
   try {
-    if (luaL_loadbuffer(L, code.c_str(), code.size(), filename.c_str()) || lua_pcall(L, 0, 1, 0)) {
+    if (loadStatus != LUA_OK || lua_pcall(L, 0, 1, 0)) {
       const char* s = lua_tostring(L, -1);
       if (s)
         onConsoleError(s);
@@ -608,6 +622,20 @@ void Engine::handleException(const std::exception& ex)
 
 bool Engine::evalFile(const std::string& filename, const Params& params)
 {
+  std::string absFilename = base::get_absolute_path(filename);
+
+  // Without debugger we can load the compiled bytecode of the file
+  // from the cache (the debugger needs the source code)
+  if (!g_debuggerDelegate) {
+    if (!base::is_file(absFilename))
+      return false;
+
+    AddScriptFilename addScript(absFilename);
+    set_app_params(L, params);
+
+    return evalLoadedChunk(load_file_with_cache(L, absFilename));
+  }
+
   std::stringstream buf;
   {
     std::ifstream s(FSTREAM_PATH(filename));
@@ -616,18 +644,15 @@ bool Engine::evalFile(const std::string& filename, const Params& params)
       return false;
     buf << s.rdbuf();
   }
-  std::string absFilename = base::get_absolute_path(filename);
 
   AddScriptFilename addScript(absFilename);
   set_app_params(L, params);
 
-  if (g_debuggerDelegate)
-    g_debuggerDelegate->startFile(absFilename, buf.str());
+  g_debuggerDelegate->startFile(absFilename, buf.str());
 
   bool result = evalCode(buf.str(), "@" + absFilename);
 
-  if (g_debuggerDelegate)
-    g_debuggerDelegate->endFile(absFilename);
+  g_debuggerDelegate->endFile(absFilename);
 
   return result;
 }
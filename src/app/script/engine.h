@@ -115,6 +115,7 @@ public:
   void stopDebugger();
 
 private:
+  bool evalLoadedChunk(int loadStatus);
   void onConsoleError(const char* text);
   void onConsolePrint(const char* text);
 
@@ -154,6 +155,12 @@ void push_doc_range(lua_State* L, Site& site);
 void push_editor(lua_State* L, Editor* editor);
 void push_group_layers(lua_State* L, doc::LayerGroup* group);
 void push_image(lua_State* L, doc::Image* image);
+void push_image_view(lua_State* L,
+                     int imageIndex,
+                     doc::Image* image,
+                     const gfx::Rect& bounds,
+                     doc::Tileset* tileset,
+                     doc::tile_index ti);
 void push_layers(lua_State* L, const doc::ObjectIds& layers);
 void push_palette(lua_State* L, doc::Palette* palette);
 void push_plugin(lua_State* L, Extension* ext);
@@ -196,6 +203,8 @@ doc::Image* may_get_image_from_arg(lua_State* L, int index);
 doc::Image* get_image_from_arg(lua_State* L, int index);
 doc::Cel* get_image_cel_from_arg(lua_State* L, int index);
 doc::Tileset* get_image_tileset_from_arg(lua_State* L, int index);
+doc::Image* may_get_image_view_from_arg(lua_State* L, int index, gfx::Rect& bounds);
+void append_image_view_bytes(lua_State* L, int index, std::string& data);
 doc::frame_t get_frame_number_from_arg(lua_State* L, int index);
 doc::Mask* get_mask_from_arg(lua_State* L, int index);
 app::tools::Tool* get_tool_from_arg(lua_State* L, int index);
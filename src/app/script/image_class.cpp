@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2015-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -32,11 +32,13 @@
 #include "base/fs.h"
 #include "doc/algorithm/flip_image.h"
 #include "doc/algorithm/flip_type.h"
+#include "doc/algorithm/pixel_kernels.h"
 #include "doc/algorithm/shrink_bounds.h"
 #include "doc/blend_image.h"
 #include "doc/cel.h"
 #include "doc/image.h"
 #include "doc/image_ref.h"
+#include "doc/mask.h"
 #include "doc/primitives.h"
 #include "doc/sprite.h"
 #include "render/render.h"
@@ -45,6 +47,7 @@
 #include <algorithm>
 #include <cstring>
 #include <memory>
+#include <vector>
 
 namespace app { namespace script {
 
@@ -109,6 +112,112 @@ void render_sprite(Image* dst, const Sprite* sprite, const frame_t frame, const
   render.renderSprite(dst, sprite, frame, gfx::Clip(x, y, 0, 0, sprite->width(), sprite->height()));
 }
 
+// Returns the pixel color of the argument at "index" (an integer or
+// any value accepted by Color()), or the mask color of the image if
+// the argument is not specified.
+doc::color_t get_pixel_color_arg(lua_State* L, int index, const doc::Image* img)
+{
+  if (lua_isnone(L, index))
+    return img->maskColor();
+  else if (lua_isinteger(L, index))
+    return lua_tointeger(L, index);
+  else
+    return convert_args_into_pixel_color(L, index, img->pixelFormat());
+}
+
+// Calls modify(image) to modify the pixels of the image of "obj". If
+// the image is related to a cel, the modification is done in a copy
+// and then the modified area is copied to the cel image with undo
+// information.
+template<typename Func>
+void modify_image_pixels(lua_State* L, ImageObj* obj, Func&& modify)
+{
+  doc::Image* img = obj->image(L);
+
+  if (auto cel = obj->cel(L)) {
+    ImageRef tmp(Image::createCopy(img));
+    modify(tmp.get());
+
+    int x1, y1, x2, y2;
+    if (get_shrink_rect2(&x1, &y1, &x2, &y2, img, tmp.get())) {
+      Tx tx(cel->sprite());
+      tx(new cmd::CopyRect(img, tmp.get(), gfx::Clip(x1, y1, x1, y1, x2 - x1 + 1, y2 - y1 + 1)));
+      tx.commit();
+    }
+  }
+  // If the image is not related to a sprite, we just modify the
+  // image without undo information.
+  else {
+    modify(img);
+    img->incrementVersion();
+
+    // Rehash tileset
+    if (obj->tilesetId) {
+      if (doc::Tileset* ts = obj->tileset(L)) {
+        ts->incrementVersion();
+        ts->notifyTileContentChange(obj->ti);
+      }
+    }
+  }
+}
+
+// Reads a lookup table for Image:applyLut() from the field "name" of
+// the table at "index". The field can be a table with 256 values
+// (lut[v+1] is the new value for v) or a function(v) that returns
+// the new value.
+bool get_lut_field(lua_State* L, int index, const char* name, uint8_t* lut)
+{
+  const int type = lua_getfield(L, index, name);
+  if (type == LUA_TTABLE) {
+    for (int v = 0; v < 256; ++v) {
+      lua_geti(L, -1, v + 1);
+      lut[v] = uint8_t(std::clamp<lua_Integer>(lua_isnil(L, -1) ? v : lua_tointeger(L, -1), 0, 255));
+      lua_pop(L, 1);
+    }
+  }
+  else if (type == LUA_TFUNCTION) {
+    for (int v = 0; v < 256; ++v) {
+      lua_pushvalue(L, -1);
+      lua_pushinteger(L, v);
+      lua_call(L, 1, 1);
+      lut[v] = uint8_t(std::clamp<lua_Integer>(lua_tointeger(L, -1), 0, 255));
+      lua_pop(L, 1);
+    }
+  }
+  else if (type != LUA_TNIL) {
+    luaL_error(L, "Image:applyLut() expects a table or function in '%s'", name);
+  }
+  lua_pop(L, 1);
+  return (type != LUA_TNIL);
+}
+
+// Decodes the first frame of the given file content (without
+// creating a temporary file).
+int load_image_from_memory(lua_State* L, const std::string& filename, std::vector<uint8_t>&& data)
+{
+  std::unique_ptr<FileOp> fop(FileOp::createLoadDocumentOperationFromMemory(
+    nullptr,
+    filename,
+    std::move(data),
+    FILE_LOAD_ONE_FRAME | FILE_LOAD_SEQUENCE_NONE | FILE_LOAD_CREATE_PALETTE));
+  if (!fop->hasError()) {
+    fop->operate();
+    fop->done();
+    fop->postLoad();
+  }
+  std::unique_ptr<Doc> doc(fop->releaseDocument());
+  if (fop->hasError() || !doc)
+    return luaL_error(L, "cannot load image from bytes\n%s", fop->error().c_str());
+
+  doc::Image* image = doc::Image::create(doc->sprite()->spec());
+  if (!image)
+    return 0;
+
+  render_sprite(image, doc->sprite(), 0, 0, 0);
+  push_new<ImageObj>(L, image);
+  return 1;
+}
+
 int Image_clone(lua_State* L);
 
 int Image_new(lua_State* L)
@@ -150,6 +259,24 @@ int Image_new(lua_State* L)
     render_sprite(image, spr, 0, 0, 0);
   }
   else if (lua_istable(L, 1)) {
+    // Image{ fromBytes, filename }
+    if (lua_getfield(L, 1, "fromBytes") == LUA_TSTRING) {
+      size_t n = 0;
+      const auto* bytes = (const uint8_t*)lua_tolstring(L, -1, &n);
+      std::vector<uint8_t> data(bytes, bytes + n);
+      lua_pop(L, 1);
+
+      // The filename is optional, it's used to know the file format
+      // when it cannot be detected from the bytes (e.g. .tga files)
+      std::string fn;
+      if (lua_getfield(L, 1, "filename") == LUA_TSTRING)
+        fn = lua_tostring(L, -1);
+      lua_pop(L, 1);
+
+      return load_image_from_memory(L, fn, std::move(data));
+    }
+    lua_pop(L, 1);
+
     // Image{ fromFile }
     int type = lua_getfield(L, 1, "fromFile");
     if (type != LUA_TNIL) {
@@ -271,6 +398,7 @@ int Image_drawPixel(lua_State* L)
   else
     color = convert_args_into_pixel_color(L, 4, img->pixelFormat());
   doc::put_pixel(img, x, y, color);
+  img->incrementVersion();
 
   // Rehash tileset
   if (obj->tilesetId) {
@@ -285,14 +413,13 @@ int Image_drawPixel(lua_State* L)
 int Image_drawImage(lua_State* L)
 {
   auto obj = get_obj<ImageObj>(L, 1);
-  auto sprite = get_obj<ImageObj>(L, 2);
   gfx::Point pos = convert_args_into_point(L, 3);
 
   // Arguments index fix to support the following cases:
-  //   - Image:drawImage(image, x, y, opacity, blendMode)
-  //   - Image:drawImage(image, Point(x, y), opacity, blendMode)
-  //   - Image:drawImage(image, {x, y}, opacity, blendMode)
-  //   - Image:drawImage(image, {x=x1, y=y1}, opacity, blendMode)
+  //   - Image:drawImage(image, x, y, opacity, blendMode, sourceRect)
+  //   - Image:drawImage(image, Point(x, y), opacity, blendMode, sourceRect)
+  //   - Image:drawImage(image, {x, y}, opacity, blendMode, sourceRect)
+  //   - Image:drawImage(image, {x=x1, y=y1}, opacity, blendMode, sourceRect)
   //
   // TODO create a similar convert_args_into_point() function so we
   //      can get the argsFix/modified index directly from there to
@@ -312,20 +439,37 @@ int Image_drawImage(lua_State* L)
   }
 
   Image* dst = obj->image(L);
-  const Image* src = sprite->image(L);
+
+  // The source can be an image or an ImageView (a region of an image)
+  gfx::Rect srcBounds;
+  const Image* src = may_get_image_view_from_arg(L, 2, srcBounds);
+  if (!src) {
+    src = get_image_from_arg(L, 2);
+    srcBounds = src->bounds();
+  }
+
+  // Region of the source image/view to draw (the whole source by default)
+  if (auto rcPtr = may_get_obj<gfx::Rect>(L, 6 + argsFix)) {
+    const gfx::Rect rc = gfx::Rect(*rcPtr).offset(srcBounds.origin());
+    const gfx::Rect clipped = (rc & srcBounds);
+    pos += clipped.origin() - rc.origin();
+    srcBounds = clipped;
+  }
+  if (srcBounds.isEmpty())
+    return 0;
 
   if (auto cel = obj->cel(L)) {
-    gfx::Rect bounds(src->size());
+    gfx::Rect bounds(srcBounds.size());
 
     // Create the ImageBuffer only when it doesn't exist so we can
     // cache the allocated buffer.
     if (!buf)
       buf = std::make_shared<doc::ImageBuffer>();
 
-    ImageRef tmp_src(doc::crop_image(dst, gfx::Rect(pos, src->size()), 0, buf));
+    ImageRef tmp_src(doc::crop_image(dst, gfx::Rect(pos, srcBounds.size()), 0, buf));
     doc::blend_image(tmp_src.get(),
                      src,
-                     gfx::Clip(src->size()),
+                     gfx::Clip(gfx::Point(0, 0), srcBounds),
                      cel->sprite()->palette(0),
                      opacity,
                      blendMode);
@@ -344,7 +488,7 @@ int Image_drawImage(lua_State* L)
   else {
     doc::blend_image(dst,
                      src,
-                     gfx::Clip(pos, src->bounds()),
+                     gfx::Clip(pos, srcBounds),
                      get_current_palette(),
                      opacity,
                      blendMode);
@@ -391,6 +535,17 @@ int Image_pixels(lua_State* L)
   return 1;
 }
 
+int Image_view(lua_State* L)
+{
+  auto obj = get_obj<ImageObj>(L, 1);
+  auto img = obj->image(L);
+  gfx::Rect rc = img->bounds();
+  if (!lua_isnone(L, 2))
+    rc = convert_args_into_rect(L, 2);
+  push_image_view(L, 1, img, rc, obj->tileset(L), obj->ti);
+  return 1;
+}
+
 int Image_getPixel(lua_State* L)
 {
   const auto obj = get_obj<ImageObj>(L, 1);
@@ -401,6 +556,170 @@ int Image_getPixel(lua_State* L)
   return 1;
 }
 
+int Image_mapColors(lua_State* L)
+{
+  auto obj = get_obj<ImageObj>(L, 1);
+  auto img = obj->image(L);
+  luaL_checktype(L, 2, LUA_TTABLE);
+
+  gfx::Rect rc = img->bounds();
+  if (auto rcPtr = may_get_obj<gfx::Rect>(L, 3))
+    rc = *rcPtr;
+
+  // Image:mapColors({ [fromColor]=toColor, ... } [, rectangle])
+  doc::algorithm::ColorTable table;
+  lua_pushnil(L);
+  while (lua_next(L, 2) != 0) {
+    if (!lua_isinteger(L, -2))
+      return luaL_error(L, "Image:mapColors() expects integer pixel values as keys");
+
+    const doc::color_t from = lua_tointeger(L, -2);
+    table[from] = get_pixel_color_arg(L, lua_gettop(L), img);
+    lua_pop(L, 1);
+  }
+
+  int modified = 0;
+  modify_image_pixels(L, obj, [&](doc::Image* dst) {
+    modified = doc::algorithm::map_colors(dst, rc, table);
+  });
+  lua_pushinteger(L, modified);
+  return 1;
+}
+
+int Image_applyLut(lua_State* L)
+{
+  auto obj = get_obj<ImageObj>(L, 1);
+  auto img = obj->image(L);
+  luaL_checktype(L, 2, LUA_TTABLE);
+
+  uint8_t r[256], g[256], b[256], a[256];
+  doc::algorithm::ChannelLuts luts;
+
+  // Image:applyLut{ red, green, blue, alpha | gray, alpha | index [, rect] }
+  switch (img->pixelFormat()) {
+    case doc::IMAGE_RGB:
+      if (get_lut_field(L, 2, "red", r))
+        luts.r = r;
+      if (get_lut_field(L, 2, "green", g))
+        luts.g = g;
+      if (get_lut_field(L, 2, "blue", b))
+        luts.b = b;
+      if (get_lut_field(L, 2, "alpha", a))
+        luts.a = a;
+      break;
+    case doc::IMAGE_GRAYSCALE:
+      if (get_lut_field(L, 2, "gray", r))
+        luts.r = r;
+      if (get_lut_field(L, 2, "alpha", a))
+        luts.a = a;
+      break;
+    case doc::IMAGE_INDEXED:
+      if (get_lut_field(L, 2, "index", r))
+        luts.r = r;
+      break;
+    default: return luaL_error(L, "Image:applyLut() is not available for this color mode");
+  }
+
+  gfx::Rect rc = img->bounds();
+  if (lua_getfield(L, 2, "rect") != LUA_TNIL)
+    rc = convert_args_into_rect(L, -1);
+  lua_pop(L, 1);
+
+  if (!luts.r && !luts.g && !luts.b && !luts.a)
+    return 0;
+
+  modify_image_pixels(L, obj, [&](doc::Image* dst) {
+    doc::algorithm::apply_channel_luts(dst, rc, luts);
+  });
+  return 0;
+}
+
+int Image_fill(lua_State* L)
+{
+  auto obj = get_obj<ImageObj>(L, 1);
+  auto img = obj->image(L);
+  const doc::color_t color = get_pixel_color_arg(L, 2, img);
+
+  // Image:fill(color [, image [, position]])
+  if (const doc::Image* maskImg = may_get_image_from_arg(L, 3)) {
+    gfx::Point pos(0, 0);
+    if (!lua_isnone(L, 4))
+      pos = convert_args_into_point(L, 4);
+
+    // The mask cannot be read while it's being modified
+    ImageRef maskCopy;
+    if (maskImg == img) {
+      maskCopy.reset(Image::createCopy(maskImg));
+      maskImg = maskCopy.get();
+    }
+
+    int modified = 0;
+    modify_image_pixels(L, obj, [&](doc::Image* dst) {
+      modified = doc::algorithm::fill_masked(dst, maskImg, pos, color);
+    });
+    lua_pushinteger(L, modified);
+  }
+  // Image:fill(color, selection)
+  else if (!lua_isnone(L, 3)) {
+    const doc::Mask* mask = get_mask_from_arg(L, 3);
+    if (!mask->bitmap()) {
+      lua_pushinteger(L, 0);
+      return 1;
+    }
+
+    // The selection is in sprite coordinates
+    gfx::Point pos = mask->origin();
+    if (auto cel = obj->cel(L))
+      pos -= cel->position();
+
+    int modified = 0;
+    modify_image_pixels(L, obj, [&](doc::Image* dst) {
+      modified = doc::algorithm::fill_masked(dst, mask->bitmap(), pos, color);
+    });
+    lua_pushinteger(L, modified);
+  }
+  // Image:fill(color)
+  else {
+    modify_image_pixels(L, obj, [&](doc::Image* dst) { doc::clear_image(dst, color); });
+    lua_pushinteger(L, img->width() * img->height());
+  }
+  return 1;
+}
+
+int Image_histogram(lua_State* L)
+{
+  auto obj = get_obj<ImageObj>(L, 1);
+  auto img = obj->image(L);
+
+  gfx::Rect rc = img->bounds();
+  if (auto rcPtr = may_get_obj<gfx::Rect>(L, 2))
+    rc = *rcPtr;
+
+  doc::algorithm::ColorCount counts;
+  doc::algorithm::count_colors(img, rc, counts);
+
+  lua_createtable(L, 0, int(counts.size()));
+  for (const auto& [color, n] : counts) {
+    lua_pushinteger(L, n);
+    lua_rawseti(L, -2, color);
+  }
+  return 1;
+}
+
+int Image_countColor(lua_State* L)
+{
+  auto obj = get_obj<ImageObj>(L, 1);
+  auto img = obj->image(L);
+  const doc::color_t color = get_pixel_color_arg(L, 2, img);
+
+  gfx::Rect rc = img->bounds();
+  if (auto rcPtr = may_get_obj<gfx::Rect>(L, 3))
+    rc = *rcPtr;
+
+  lua_pushinteger(L, doc::algorithm::count_color(img, rc, color));
+  return 1;
+}
+
 int Image_isEqual(lua_State* L)
 {
   auto objA = get_obj<ImageObj>(L, 1);
@@ -684,6 +1003,7 @@ int Image_set_bytes(lua_State* L)
 
   if (bytes_size == bytes_needed) {
     std::memcpy(img->getPixelAddress(0, 0), bytes, bytes_size);
+    img->incrementVersion();
   }
   else {
     lua_pushfstring(L, "Data size does not match: given %d, needed %d.", bytes_size, bytes_needed);
@@ -764,6 +1084,12 @@ const luaL_Reg Image_methods[] = {
   { "drawSprite",   Image_drawSprite   },
   { "putSprite",    Image_drawSprite   }, // TODO putSprite is deprecated
   { "pixels",       Image_pixels       },
+  { "view",         Image_view         },
+  { "mapColors",    Image_mapColors    },
+  { "applyLut",     Image_applyLut     },
+  { "fill",         Image_fill         },
+  { "histogram",    Image_histogram    },
+  { "countColor",   Image_countColor   },
   { "isEqual",      Image_isEqual      },
   { "isEmpty",      Image_isEmpty      },
   { "isPlain",      Image_isPlain      },
@@ -0,0 +1,330 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/script/docobj.h"
+#include "app/script/engine.h"
+#include "app/script/luacpp.h"
+#include "doc/image.h"
+#include "doc/primitives_fast.h"
+#include "doc/tileset.h"
+
+#include <string>
+
+namespace app { namespace script {
+
+namespace {
+
+// A view of the pixels of a rectangle of an image. Pixels are read
+// and written directly in the image memory (there is no copy), and
+// each access checks that the image still exists and has the same
+// size/color mode that it had when the view was created (e.g. if the
+// image was resized, the view is invalidated).
+//
+// The view keeps a reference to the Image userdata (as its user
+// value) so standalone images are not deleted while the view is
+// alive.
+struct ImageViewObj {
+  doc::ObjectId imageId = 0;
+  doc::ObjectId tilesetId = 0;
+  doc::tile_index ti = 0;
+  doc::PixelFormat pixelFormat;
+  gfx::Size imageSize;
+  gfx::Rect bounds;
+
+  ImageViewObj(const doc::Image* image,
+               const gfx::Rect& bounds,
+               const doc::Tileset* tileset,
+               const doc::tile_index ti)
+    : imageId(image->id())
+    , tilesetId(tileset ? tileset->id() : 0)
+    , ti(ti)
+    , pixelFormat(image->pixelFormat())
+    , imageSize(image->size())
+    , bounds(bounds)
+  {
+  }
+
+  doc::Image* image(lua_State* L)
+  {
+    doc::Image* image = check_docobj(L, doc::get<doc::Image>(imageId));
+    if (image->pixelFormat() != pixelFormat || image->size() != imageSize)
+      luaL_error(L, "the image of this view was resized or its color mode changed");
+    return image;
+  }
+
+  // Converts the 1-based index of a pixel in the view to image
+  // coordinates.
+  gfx::Point pixelPos(lua_State* L, const lua_Integer i)
+  {
+    if (i < 1 || i > lua_Integer(bounds.w) * bounds.h)
+      luaL_error(L, "pixel index %d out of bounds [1, %d]", int(i), bounds.w * bounds.h);
+    return gfx::Point(bounds.x + int((i - 1) % bounds.w), bounds.y + int((i - 1) / bounds.w));
+  }
+
+  void notifyChanges(lua_State* L, doc::Image* image)
+  {
+    image->incrementVersion();
+
+    // Rehash tileset
+    if (tilesetId) {
+      if (doc::Tileset* ts = check_docobj(L, doc::get<doc::Tileset>(tilesetId))) {
+        ts->incrementVersion();
+        ts->notifyTileContentChange(ti);
+      }
+    }
+  }
+};
+
+doc::color_t get_view_pixel(const doc::Image* image, const gfx::Point& pt)
+{
+  switch (image->pixelFormat()) {
+    case doc::IMAGE_RGB:       return doc::get_pixel_fast<doc::RgbTraits>(image, pt.x, pt.y);
+    case doc::IMAGE_GRAYSCALE: return doc::get_pixel_fast<doc::GrayscaleTraits>(image, pt.x, pt.y);
+    case doc::IMAGE_INDEXED:   return doc::get_pixel_fast<doc::IndexedTraits>(image, pt.x, pt.y);
+    case doc::IMAGE_BITMAP:    return doc::get_pixel_fast<doc::BitmapTraits>(image, pt.x, pt.y);
+    case doc::IMAGE_TILEMAP:   return doc::get_pixel_fast<doc::TilemapTraits>(image, pt.x, pt.y);
+  }
+  return 0;
+}
+
+void put_view_pixel(doc::Image* image, const gfx::Point& pt, const doc::color_t c)
+{
+  switch (image->pixelFormat()) {
+    case doc::IMAGE_RGB:       doc::put_pixel_fast<doc::RgbTraits>(image, pt.x, pt.y, c); break;
+    case doc::IMAGE_GRAYSCALE: doc::put_pixel_fast<doc::GrayscaleTraits>(image, pt.x, pt.y, c); break;
+    case doc::IMAGE_INDEXED:   doc::put_pixel_fast<doc::IndexedTraits>(image, pt.x, pt.y, c); break;
+    case doc::IMAGE_BITMAP:    doc::put_pixel_fast<doc::BitmapTraits>(image, pt.x, pt.y, c); break;
+    case doc::IMAGE_TILEMAP:   doc::put_pixel_fast<doc::TilemapTraits>(image, pt.x, pt.y, c); break;
+  }
+}
+
+int ImageView_gc(lua_State* L)
+{
+  get_obj<ImageViewObj>(L, 1)->~ImageViewObj();
+  return 0;
+}
+
+int ImageView_len(lua_State* L)
+{
+  auto obj = get_obj<ImageViewObj>(L, 1);
+  lua_pushinteger(L, obj->bounds.w * obj->bounds.h);
+  return 1;
+}
+
+int ImageView_index(lua_State* L)
+{
+  auto obj = get_obj<ImageViewObj>(L, 1);
+
+  // view[i]
+  if (lua_isinteger(L, 2)) {
+    const gfx::Point pt = obj->pixelPos(L, lua_tointeger(L, 2));
+    lua_pushinteger(L, get_view_pixel(obj->image(L), pt));
+    return 1;
+  }
+
+  // Methods and properties
+  lua_getglobal(L, "__generic_mt_index");
+  lua_pushvalue(L, 1);
+  lua_pushvalue(L, 2);
+  lua_call(L, 2, 1);
+  return 1;
+}
+
+int ImageView_newindex(lua_State* L)
+{
+  auto obj = get_obj<ImageViewObj>(L, 1);
+
+  // view[i] = color
+  if (lua_isinteger(L, 2)) {
+    const gfx::Point pt = obj->pixelPos(L, lua_tointeger(L, 2));
+    doc::Image* image = obj->image(L);
+    doc::color_t color;
+    if (lua_isinteger(L, 3))
+      color = lua_tointeger(L, 3);
+    else
+      color = convert_args_into_pixel_color(L, 3, image->pixelFormat());
+    put_view_pixel(image, pt, color);
+    obj->notifyChanges(L, image);
+    return 0;
+  }
+
+  lua_getglobal(L, "__generic_mt_newindex");
+  lua_pushvalue(L, 1);
+  lua_pushvalue(L, 2);
+  lua_pushvalue(L, 3);
+  lua_call(L, 3, 0);
+  return 0;
+}
+
+int ImageView_get(lua_State* L)
+{
+  auto obj = get_obj<ImageViewObj>(L, 1);
+  const int x = lua_tointeger(L, 2);
+  const int y = lua_tointeger(L, 3);
+  if (x < 0 || y < 0 || x >= obj->bounds.w || y >= obj->bounds.h)
+    return luaL_error(L, "pixel (%d, %d) out of bounds", x, y);
+
+  lua_pushinteger(L, get_view_pixel(obj->image(L), obj->bounds.origin() + gfx::Point(x, y)));
+  return 1;
+}
+
+int ImageView_set(lua_State* L)
+{
+  auto obj = get_obj<ImageViewObj>(L, 1);
+  const int x = lua_tointeger(L, 2);
+  const int y = lua_tointeger(L, 3);
+  if (x < 0 || y < 0 || x >= obj->bounds.w || y >= obj->bounds.h)
+    return luaL_error(L, "pixel (%d, %d) out of bounds", x, y);
+
+  doc::Image* image = obj->image(L);
+  doc::color_t color;
+  if (lua_isinteger(L, 4))
+    color = lua_tointeger(L, 4);
+  else
+    color = convert_args_into_pixel_color(L, 4, image->pixelFormat());
+  put_view_pixel(image, obj->bounds.origin() + gfx::Point(x, y), color);
+  obj->notifyChanges(L, image);
+  return 0;
+}
+
+int ImageView_get_image(lua_State* L)
+{
+  get_obj<ImageViewObj>(L, 1);
+  lua_getuservalue(L, 1);
+  return 1;
+}
+
+int ImageView_get_width(lua_State* L)
+{
+  auto obj = get_obj<ImageViewObj>(L, 1);
+  lua_pushinteger(L, obj->bounds.w);
+  return 1;
+}
+
+int ImageView_get_height(lua_State* L)
+{
+  auto obj = get_obj<ImageViewObj>(L, 1);
+  lua_pushinteger(L, obj->bounds.h);
+  return 1;
+}
+
+int ImageView_get_bounds(lua_State* L)
+{
+  auto obj = get_obj<ImageViewObj>(L, 1);
+  push_obj(L, obj->bounds);
+  return 1;
+}
+
+int ImageView_get_rowStride(lua_State* L)
+{
+  auto obj = get_obj<ImageViewObj>(L, 1);
+  lua_pushinteger(L, obj->image(L)->rowBytes());
+  return 1;
+}
+
+int ImageView_get_bytesPerPixel(lua_State* L)
+{
+  auto obj = get_obj<ImageViewObj>(L, 1);
+  lua_pushinteger(L, obj->image(L)->bytesPerPixel());
+  return 1;
+}
+
+int ImageView_get_colorMode(lua_State* L)
+{
+  auto obj = get_obj<ImageViewObj>(L, 1);
+  lua_pushinteger(L, obj->image(L)->pixelFormat());
+  return 1;
+}
+
+const luaL_Reg ImageView_methods[] = {
+  { "get",        ImageView_get      },
+  { "set",        ImageView_set      },
+  { "__gc",       ImageView_gc       },
+  { "__len",      ImageView_len      },
+  { "__index",    ImageView_index    },
+  { "__newindex", ImageView_newindex },
+  { nullptr,      nullptr            }
+};
+
+const Property ImageView_properties[] = {
+  { "image",         ImageView_get_image,         nullptr },
+  { "width",         ImageView_get_width,         nullptr },
+  { "height",        ImageView_get_height,        nullptr },
+  { "bounds",        ImageView_get_bounds,        nullptr },
+  { "rowStride",     ImageView_get_rowStride,     nullptr },
+  { "bytesPerPixel", ImageView_get_bytesPerPixel, nullptr },
+  { "colorMode",     ImageView_get_colorMode,     nullptr },
+  { nullptr,         nullptr,                     nullptr }
+};
+
+} // anonymous namespace
+
+DEF_MTNAME(ImageViewObj);
+DEF_MTNAME_ALIAS(ImageViewObj, ImageView);
+
+void register_image_view_class(lua_State* L)
+{
+  using ImageView = ImageViewObj;
+  REG_CLASS(L, ImageView);
+  REG_CLASS_PROPERTIES(L, ImageView);
+}
+
+void push_image_view(lua_State* L,
+                     int imageIndex,
+                     doc::Image* image,
+                     const gfx::Rect& bounds,
+                     doc::Tileset* tileset,
+                     doc::tile_index ti)
+{
+  imageIndex = lua_absindex(L, imageIndex);
+  push_new<ImageViewObj>(L, image, bounds & image->bounds(), tileset, ti);
+  lua_pushvalue(L, imageIndex);
+  lua_setuservalue(L, -2);
+}
+
+doc::Image* may_get_image_view_from_arg(lua_State* L, int index, gfx::Rect& bounds)
+{
+  if (auto obj = may_get_obj<ImageViewObj>(L, index)) {
+    bounds = obj->bounds;
+    return obj->image(L);
+  }
+  return nullptr;
+}
+
+void append_image_view_bytes(lua_State* L, int index, std::string& data)
+{
+  auto obj = get_obj<ImageViewObj>(L, index);
+  const doc::Image* image = obj->image(L);
+  const gfx::Rect& rc = obj->bounds;
+  if (rc.isEmpty())
+    return;
+
+  // Bitmaps use 1 bit per pixel, so rows of a view that doesn't start
+  // in the first pixel cannot be copied byte by byte.
+  if (image->pixelFormat() == doc::IMAGE_BITMAP) {
+    for (int y = rc.y; y < rc.y2(); ++y)
+      for (int x = rc.x; x < rc.x2(); ++x)
+        data.push_back(char(get_view_pixel(image, gfx::Point(x, y))));
+    return;
+  }
+
+  // Full rows of the image are contiguous in memory
+  const int rowBytes = rc.w * image->bytesPerPixel();
+  if (rc.x == 0 && rc.w == image->width() && rowBytes == image->rowBytes()) {
+    data.append((const char*)image->getPixelAddress(0, rc.y), size_t(rowBytes) * rc.h);
+    return;
+  }
+
+  data.reserve(data.size() + size_t(rowBytes) * rc.h);
+  for (int y = rc.y; y < rc.y2(); ++y)
+    data.append((const char*)image->getPixelAddress(rc.x, y), rowBytes);
+}
+
+}} // namespace app::script
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2020  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2015-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -18,7 +18,12 @@
 #include "app/script/luacpp.h"
 #include "app/transaction.h"
 #include "app/tx.h"
+#include "doc/algorithm/mask_geometry.h"
 #include "doc/mask.h"
+#include "doc/mask_boundaries.h"
+#include "doc/mask_runs.h"
+
+#include <vector>
 
 namespace app { namespace script {
 
@@ -261,6 +266,69 @@ int Selection_contains(lua_State* L)
   return 1;
 }
 
+// Returns a table with the runs of selected pixels of each row as
+// rectangles of 1 pixel height.
+int Selection_spans(lua_State* L)
+{
+  const auto obj = get_obj<SelectionObj>(L, 1);
+  const MaskRuns runs(*obj->mask(L));
+  const gfx::Rect& bounds = runs.bounds();
+
+  lua_newtable(L);
+  int i = 0;
+  for (int y = bounds.y; y < bounds.y2(); ++y) {
+    for (const MaskRuns::Run& run : runs.row(y)) {
+      push_new<gfx::Rect>(L, run.x1, y, run.x2 - run.x1, 1);
+      lua_rawseti(L, -2, ++i);
+    }
+  }
+  return 1;
+}
+
+// Returns a table with a new standalone Selection for each
+// 4-connected group of selected pixels.
+int Selection_components(lua_State* L)
+{
+  const auto obj = get_obj<SelectionObj>(L, 1);
+  std::vector<MaskRuns> components;
+  algorithm::mask_components(MaskRuns(*obj->mask(L)), components);
+
+  lua_createtable(L, int(components.size()), 0);
+  int i = 0;
+  for (const MaskRuns& runs : components) {
+    auto mask = new Mask;
+    mask->add(runs);
+    push_new<SelectionObj>(L, mask, nullptr);
+    lua_rawseti(L, -2, ++i);
+  }
+  return 1;
+}
+
+// Returns a table with the contours of the selection, each one is
+// an array of points (corners of the pixels).
+int Selection_polygons(lua_State* L)
+{
+  const auto obj = get_obj<SelectionObj>(L, 1);
+  MaskBoundaries boundaries;
+  boundaries.regen(MaskRuns(*obj->mask(L)));
+
+  std::vector<algorithm::Polygon> polygons;
+  algorithm::mask_polygons(boundaries, polygons);
+
+  lua_createtable(L, int(polygons.size()), 0);
+  int i = 0;
+  for (const algorithm::Polygon& polygon : polygons) {
+    lua_createtable(L, int(polygon.size()), 0);
+    int j = 0;
+    for (const gfx::Point& pt : polygon) {
+      push_obj(L, pt);
+      lua_rawseti(L, -2, ++j);
+    }
+    lua_rawseti(L, -2, ++i);
+  }
+  return 1;
+}
+
 int Selection_get_bounds(lua_State* L)
 {
   const auto obj = get_obj<SelectionObj>(L, 1);
@@ -326,24 +394,35 @@ int Selection_get_isEmpty(lua_State* L)
   return 1;
 }
 
+int Selection_get_pixelCount(lua_State* L)
+{
+  const auto obj = get_obj<SelectionObj>(L, 1);
+  lua_pushinteger(L, algorithm::count_mask_pixels(MaskRuns(*obj->mask(L))));
+  return 1;
+}
+
 const luaL_Reg Selection_methods[] = {
-  { "deselect",  Selection_deselect  },
-  { "select",    Selection_select    },
-  { "selectAll", Selection_selectAll },
-  { "add",       Selection_add       },
-  { "subtract",  Selection_subtract  },
-  { "intersect", Selection_intersect },
-  { "contains",  Selection_contains  },
-  { "__gc",      Selection_gc        },
-  { "__eq",      Selection_eq        },
-  { nullptr,     nullptr             }
+  { "deselect",   Selection_deselect   },
+  { "select",     Selection_select     },
+  { "selectAll",  Selection_selectAll  },
+  { "add",        Selection_add        },
+  { "subtract",   Selection_subtract   },
+  { "intersect",  Selection_intersect  },
+  { "contains",   Selection_contains   },
+  { "spans",      Selection_spans      },
+  { "components", Selection_components },
+  { "polygons",   Selection_polygons   },
+  { "__gc",       Selection_gc         },
+  { "__eq",       Selection_eq         },
+  { nullptr,      nullptr              }
 };
 
 const Property Selection_properties[] = {
-  { "bounds",  Selection_get_bounds,  nullptr              },
-  { "origin",  Selection_get_origin,  Selection_set_origin },
-  { "isEmpty", Selection_get_isEmpty, nullptr              },
-  { nullptr,   nullptr,               nullptr              }
+  { "bounds",     Selection_get_bounds,     nullptr              },
+  { "origin",     Selection_get_origin,     Selection_set_origin },
+  { "isEmpty",    Selection_get_isEmpty,    nullptr              },
+  { "pixelCount", Selection_get_pixelCount, nullptr              },
+  { nullptr,      nullptr,                  nullptr              }
 };
 
 } // anonymous namespace
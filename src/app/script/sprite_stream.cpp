@@ -0,0 +1,282 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/script/sprite_stream.h"
+
+#include "app/doc.h"
+#include "app/doc_event.h"
+#include "app/pref/preferences.h"
+#include "app/task_scheduler.h"
+#include "doc/cel.h"
+#include "doc/cels_range.h"
+#include "doc/image.h"
+#include "doc/lazy_image.h"
+#include "doc/layer.h"
+#include "doc/sprite.h"
+#include "render/render.h"
+
+#include <ixwebsocket/IXWebSocket.h>
+
+#include "zlib.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace app { namespace script {
+
+namespace {
+
+// Maximum number of messages per stream waiting to be sent. If the
+// socket is slower than the changes, the modified regions are
+// accumulated and sent later.
+constexpr int kMaxPendingMessages = 4;
+
+// One task at a time, so messages are sent in the same order they
+// were rendered (in a blocking thread as sending can wait the socket).
+SerialTaskGroup& stream_tasks()
+{
+  static SerialTaskGroup tasks(TaskKind::Blocking);
+  return tasks;
+}
+
+void hash_combine(std::size_t& seed, const std::size_t value)
+{
+  seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+void put_u32(std::string& data, const uint32_t value)
+{
+  data.push_back(char(value & 0xff));
+  data.push_back(char((value >> 8) & 0xff));
+  data.push_back(char((value >> 16) & 0xff));
+  data.push_back(char((value >> 24) & 0xff));
+}
+
+} // anonymous namespace
+
+SpriteStream::SpriteStream(ix::WebSocket* ws, Doc* doc, const Options& options)
+  : m_ws(ws)
+  , m_spriteId(doc->sprite()->id())
+  , m_options(options)
+  , m_timer(options.interval)
+{
+  // All frames are sent the first time as their signatures are
+  // different from the initial ones.
+  doc->add_observer(this);
+
+  m_timer.Tick.connect([this] { sendChanges(); });
+  m_timer.start();
+}
+
+SpriteStream::~SpriteStream()
+{
+  m_timer.stop();
+
+  if (Doc* doc = document())
+    doc->remove_observer(this);
+
+  // Wait the messages that are being sent (they use the WebSocket)
+  std::unique_lock lock(m_mutex);
+  m_cv.wait(lock, [this] { return m_pending == 0; });
+}
+
+Doc* SpriteStream::document() const
+{
+  if (auto sprite = doc::get<doc::Sprite>(m_spriteId))
+    return static_cast<Doc*>(sprite->document());
+  return nullptr;
+}
+
+void SpriteStream::sendChanges()
+{
+  Doc* doc = document();
+  if (!doc || m_ws->getReadyState() != ix::ReadyState::Open)
+    return;
+
+  {
+    std::lock_guard lock(m_mutex);
+    if (m_pending >= kMaxPendingMessages)
+      return;
+  }
+
+  // Detect frames modified without notifications (undo/redo, scripts,
+  // commands, etc.)
+  const doc::Sprite* sprite = doc->sprite();
+  const doc::frame_t nframes = sprite->totalFrames();
+  m_signatures.resize(nframes, 0);
+  for (doc::frame_t frame = 0; frame < nframes; ++frame) {
+    const std::size_t signature = frameSignature(frame);
+    if (m_signatures[frame] != signature) {
+      m_signatures[frame] = signature;
+      invalidateFrame(frame, sprite->bounds());
+    }
+  }
+
+  if (m_dirty.empty())
+    return;
+
+  // Rendering is done in the background thread from a snapshot of
+  // the sprite (the sprite can be modified only from this thread).
+  m_snapshot = doc::SpriteSnapshot::Make(sprite, m_snapshot);
+  const bool composeGroups = Preferences::instance().experimental.composeGroups();
+
+  for (const auto& [frame, dirty] : m_dirty) {
+    const gfx::Rect bounds = dirty & sprite->bounds();
+    if (frame >= nframes || bounds.isEmpty())
+      continue;
+
+    {
+      std::lock_guard lock(m_mutex);
+      ++m_pending;
+    }
+
+    const uint32_t spriteId = m_spriteId;
+    const bool compress = m_options.compress;
+    stream_tasks().run(
+      [this, snapshot = m_snapshot, spriteId, frame, bounds, composeGroups, compress] {
+        // Lazy images of the snapshot can share the cache with the
+        // document, so they cannot be discarded while we render.
+        doc::LazyImagesCache::NoTrimScope noTrim;
+
+        render::Render render;
+        render.setNewBlend(true);
+        render.setComposeGroups(composeGroups);
+
+        std::unique_ptr<doc::Image> image(
+          doc::Image::create(doc::IMAGE_RGB, bounds.w, bounds.h));
+        render.renderSprite(image.get(),
+                            snapshot->sprite(),
+                            frame,
+                            gfx::Clip(0, 0, bounds.x, bounds.y, bounds.w, bounds.h));
+
+        const std::size_t rowBytes = std::size_t(bounds.w) * 4;
+        std::vector<uint8_t> pixels(rowBytes * bounds.h);
+        for (int y = 0; y < bounds.h; ++y)
+          std::copy_n(image->getPixelAddress(0, y), rowBytes, pixels.data() + rowBytes * y);
+
+        std::string data = encode(spriteId, frame, bounds, pixels, compress);
+        m_ws->sendBinary(data);
+
+        std::lock_guard lock(m_mutex);
+        --m_pending;
+        m_cv.notify_all();
+      });
+  }
+  m_dirty.clear();
+}
+
+// static
+std::string SpriteStream::encode(const uint32_t spriteId,
+                                 const doc::frame_t frame,
+                                 const gfx::Rect& bounds,
+                                 const std::vector<uint8_t>& pixels,
+                                 bool compress)
+{
+  std::string compressed;
+  if (compress) {
+    uLongf size = compressBound(pixels.size());
+    compressed.resize(size);
+    if (compress2((Bytef*)compressed.data(), &size, pixels.data(), pixels.size(), Z_BEST_SPEED) ==
+          Z_OK &&
+        size < pixels.size()) {
+      compressed.resize(size);
+    }
+    else {
+      // Send the raw pixels if they cannot be compressed
+      compress = false;
+    }
+  }
+
+  std::string data;
+  data.reserve(kHeaderSize + (compress ? compressed.size() : pixels.size()));
+  put_u32(data, kMagic);
+  data.push_back(char(kVersion));
+  data.push_back(char(compress ? kCompressed : 0));
+  data.push_back(0); // Reserved
+  data.push_back(0);
+  put_u32(data, spriteId);
+  put_u32(data, uint32_t(frame));
+  put_u32(data, uint32_t(bounds.x));
+  put_u32(data, uint32_t(bounds.y));
+  put_u32(data, uint32_t(bounds.w));
+  put_u32(data, uint32_t(bounds.h));
+  ASSERT(data.size() == kHeaderSize);
+
+  if (compress)
+    data.append(compressed);
+  else
+    data.append((const char*)pixels.data(), pixels.size());
+  return data;
+}
+
+void SpriteStream::onGeneralUpdate(DocEvent& ev)
+{
+  invalidateAll();
+}
+
+void SpriteStream::onPixelFormatChanged(DocEvent& ev)
+{
+  invalidateAll();
+}
+
+void SpriteStream::onPaletteChanged(DocEvent& ev)
+{
+  invalidateAll();
+}
+
+void SpriteStream::onSpriteSizeChanged(DocEvent& ev)
+{
+  invalidateAll();
+}
+
+void SpriteStream::onSpritePixelsModified(DocEvent& ev)
+{
+  if (ev.sprite() && ev.sprite()->id() == m_spriteId)
+    invalidateFrame(ev.frame(), ev.region().bounds());
+}
+
+void SpriteStream::invalidateAll()
+{
+  if (Doc* doc = document()) {
+    const doc::Sprite* sprite = doc->sprite();
+    for (doc::frame_t frame = 0; frame < sprite->totalFrames(); ++frame)
+      invalidateFrame(frame, sprite->bounds());
+  }
+}
+
+void SpriteStream::invalidateFrame(const doc::frame_t frame, const gfx::Rect& bounds)
+{
+  m_dirty[frame] |= bounds;
+}
+
+std::size_t SpriteStream::frameSignature(const doc::frame_t frame) const
+{
+  const doc::Sprite* sprite = document()->sprite();
+  // Starts with 1 so empty frames are different from the initial
+  // zero signatures.
+  std::size_t seed = 1;
+  for (const doc::Cel* cel : sprite->cels(frame)) {
+    const doc::Layer* layer = cel->layer();
+    const doc::Image* image = cel->image();
+    hash_combine(seed, cel->id());
+    hash_combine(seed, image->id());
+    hash_combine(seed, image->version());
+    hash_combine(seed, cel->x());
+    hash_combine(seed, cel->y());
+    hash_combine(seed, cel->opacity());
+    hash_combine(seed, cel->zIndex());
+    hash_combine(seed, layer->isVisibleHierarchy());
+    hash_combine(seed, layer->opacity());
+    hash_combine(seed, int(layer->blendMode()));
+  }
+  return seed;
+}
+
+}} // namespace app::script
@@ -0,0 +1,131 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_SCRIPT_SPRITE_STREAM_H_INCLUDED
+#define APP_SCRIPT_SPRITE_STREAM_H_INCLUDED
+#pragma once
+
+#include "app/doc_observer.h"
+#include "base/disable_copying.h"
+#include "doc/frame.h"
+#include "doc/object_id.h"
+#include "doc/sprite_snapshot.h"
+#include "gfx/rect.h"
+#include "ui/timer.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ix {
+class WebSocket;
+}
+
+namespace app {
+class Doc;
+
+namespace script {
+
+// Sends the modified regions of the frames of a sprite through a
+// WebSocket as binary messages. Modified regions are collected from
+// the document notifications (e.g. pixels modified by the tool loop)
+// and from the versions of the cels/images of each frame (e.g. to
+// detect undo/redo), and each "interval" a snapshot of the sprite is
+// taken in the UI thread. The rendering of the modified rectangle of
+// each frame, the encoding/compression, and the sending is done in a
+// background thread from that snapshot.
+//
+// Each message has a 32 bytes header (little-endian) followed by the
+// RGBA pixels of the rectangle (compressed with zlib if the
+// kCompressed flag is set):
+//
+//   uint32 magic ('ASEF')
+//   uint8  version (1)
+//   uint8  flags
+//   uint16 reserved
+//   uint32 sprite ID
+//   uint32 frame
+//   int32  x, y (rectangle in sprite coordinates)
+//   uint32 width, height
+class SpriteStream : public DocObserver {
+public:
+  static constexpr uint32_t kMagic = 0x46455341; // "ASEF"
+  static constexpr uint8_t kVersion = 1;
+  static constexpr int kHeaderSize = 32;
+
+  enum Flags : uint8_t {
+    kCompressed = 1,
+  };
+
+  struct Options {
+    bool compress = true;
+    int interval = 33; // Milliseconds between each check of changes
+  };
+
+  SpriteStream(ix::WebSocket* ws, Doc* doc, const Options& options);
+  ~SpriteStream();
+
+  ix::WebSocket* webSocket() const { return m_ws; }
+  doc::ObjectId spriteId() const { return m_spriteId; }
+
+  // Takes a snapshot of the sprite to render and send the modified
+  // regions in the background thread. Called each "interval" from
+  // the UI thread.
+  void sendChanges();
+
+  // Encodes a message to be sent. "pixels" must contain width*height
+  // RGBA pixels.
+  static std::string encode(uint32_t spriteId,
+                            doc::frame_t frame,
+                            const gfx::Rect& bounds,
+                            const std::vector<uint8_t>& pixels,
+                            bool compress);
+
+private:
+  // DocObserver impl
+  void onGeneralUpdate(DocEvent& ev) override;
+  void onPixelFormatChanged(DocEvent& ev) override;
+  void onPaletteChanged(DocEvent& ev) override;
+  void onSpriteSizeChanged(DocEvent& ev) override;
+  void onSpritePixelsModified(DocEvent& ev) override;
+
+  Doc* document() const;
+  void invalidateAll();
+  void invalidateFrame(doc::frame_t frame, const gfx::Rect& bounds);
+  std::size_t frameSignature(doc::frame_t frame) const;
+
+  ix::WebSocket* m_ws;
+  doc::ObjectId m_spriteId;
+  Options m_options;
+  ui::Timer m_timer;
+
+  // Modified rectangle of each frame that wasn't sent yet
+  std::map<doc::frame_t, gfx::Rect> m_dirty;
+
+  // Signature of each frame (cels/images IDs and versions) when it
+  // was sent, to detect changes without notifications.
+  std::vector<std::size_t> m_signatures;
+
+  // Last snapshot sent to the background thread, its unmodified
+  // images are reused in the next snapshot.
+  doc::SpriteSnapshotRef m_snapshot;
+
+  // Messages being encoded/sent in background threads
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  int m_pending = 0;
+
+  DISABLE_COPYING(SpriteStream);
+};
+
+} // namespace script
+} // namespace app
+
+#endif
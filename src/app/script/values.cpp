@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -363,6 +363,7 @@ doc::tile_t get_value_from_lua(lua_State* L, int index)
 FOR_ENUM(app::CelsTarget)
 FOR_ENUM(app::ColorBar::ColorSelector)
 FOR_ENUM(app::SpriteSheetDataFormat)
+FOR_ENUM(app::SpriteSheetPackAlgorithm)
 FOR_ENUM(app::SpriteSheetType)
 FOR_ENUM(app::TilesetMode)
 FOR_ENUM(app::gen::BgType)
@@ -370,6 +371,7 @@ FOR_ENUM(app::gen::BrushPreview)
 FOR_ENUM(app::gen::BrushType)
 FOR_ENUM(app::gen::CelContentFormat)
 FOR_ENUM(app::gen::ColorProfileBehavior)
+FOR_ENUM(app::gen::CompressionProfile)
 FOR_ENUM(app::gen::Downsampling)
 FOR_ENUM(app::gen::EyedropperChannel)
 FOR_ENUM(app::gen::EyedropperSample)
@@ -378,6 +380,7 @@ FOR_ENUM(app::gen::OnionskinType)
 FOR_ENUM(app::gen::PaintingCursorType)
 FOR_ENUM(app::gen::PivotPosition)
 FOR_ENUM(app::gen::PixelConnectivity)
+FOR_ENUM(app::gen::PngCompression)
 FOR_ENUM(app::gen::RightClickMode)
 FOR_ENUM(app::gen::SelectionMode)
 FOR_ENUM(app::gen::SequenceDecision)
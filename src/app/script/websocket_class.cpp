@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2021  Igara Studio S.A.
+// Copyright (C) 2021-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -10,17 +10,27 @@
 
 #include "app/app.h"
 #include "app/console.h"
+#include "app/doc.h"
+#include "app/script/docobj.h"
 #include "app/script/engine.h"
 #include "app/script/luacpp.h"
 #include "app/script/security.h"
+#include "app/script/sprite_stream.h"
+#include "doc/sprite.h"
+#include "gfx/rect.h"
 #include "ui/manager.h"
 #include "ui/system.h"
 #include "ui/timer.h"
 
 #include <ixwebsocket/IXNetSystem.h>
 #include <ixwebsocket/IXWebSocket.h>
+#include <algorithm>
+#include <map>
+#include <memory>
 #include <set>
 #include <sstream>
+#include <string>
+#include <vector>
 
 namespace app { namespace script {
 
@@ -31,9 +41,13 @@ namespace {
 
 static std::unique_ptr<ui::Timer> g_timer;
 static std::set<ix::WebSocket*> g_connections;
+static std::map<ix::WebSocket*, std::vector<std::unique_ptr<SpriteStream>>> g_streams;
 
 static void close_ws(ix::WebSocket* ws)
 {
+  // Stop streaming sprites (this waits the pending messages)
+  g_streams.erase(ws);
+
   ws->stop();
 
   g_connections.erase(ws);
@@ -154,16 +168,23 @@ int WebSocket_sendBinary(lua_State* L)
     return luaL_error(L, "WebSocket is not connected, can't send data");
   }
 
-  std::stringstream data;
+  std::string data;
   int argc = lua_gettop(L);
 
   for (int i = 2; i <= argc; i++) {
+    // Pixels of an ImageView are copied directly from the image
+    gfx::Rect bounds;
+    if (may_get_image_view_from_arg(L, i, bounds)) {
+      append_image_view_bytes(L, i, data);
+      continue;
+    }
+
     size_t bufLen;
     const char* buf = lua_tolstring(L, i, &bufLen);
-    data.write(buf, bufLen);
+    data.append(buf, bufLen);
   }
 
-  if (!ws->sendBinary(data.str()).success) {
+  if (!ws->sendBinary(data).success) {
     return luaL_error(L, "WebSocket failed to send data");
   }
   return 0;
@@ -187,6 +208,58 @@ int WebSocket_sendPing(lua_State* L)
   return 0;
 }
 
+int WebSocket_streamSprite(lua_State* L)
+{
+  auto ws = get_ptr<ix::WebSocket>(L, 1);
+  auto sprite = get_docobj<doc::Sprite>(L, 2);
+  auto& streams = g_streams[ws];
+  for (const auto& stream : streams) {
+    if (stream->spriteId() == sprite->id())
+      return 0;
+  }
+
+  SpriteStream::Options options;
+  if (lua_istable(L, 3)) {
+    int type = lua_getfield(L, 3, "compress");
+    if (type != LUA_TNIL)
+      options.compress = lua_toboolean(L, -1);
+    lua_pop(L, 1);
+
+    type = lua_getfield(L, 3, "interval");
+    if (type == LUA_TNUMBER)
+      options.interval = std::max(1, int(lua_tonumber(L, -1) * 1000.0));
+    lua_pop(L, 1);
+  }
+
+  streams.push_back(
+    std::make_unique<SpriteStream>(ws, static_cast<Doc*>(sprite->document()), options));
+  return 0;
+}
+
+int WebSocket_stopStreaming(lua_State* L)
+{
+  auto ws = get_ptr<ix::WebSocket>(L, 1);
+  auto it = g_streams.find(ws);
+  if (it == g_streams.end())
+    return 0;
+
+  // Stop all streams or only the stream of the given sprite
+  if (lua_isnoneornil(L, 2)) {
+    g_streams.erase(it);
+  }
+  else {
+    auto sprite = get_docobj<doc::Sprite>(L, 2);
+    auto& streams = it->second;
+    streams.erase(std::remove_if(streams.begin(),
+                                 streams.end(),
+                                 [sprite](const auto& stream) {
+                                   return stream->spriteId() == sprite->id();
+                                 }),
+                  streams.end());
+  }
+  return 0;
+}
+
 int WebSocket_connect(lua_State* L)
 {
   auto ws = get_ptr<ix::WebSocket>(L, 1);
@@ -218,13 +291,15 @@ int WebSocket_get_url(lua_State* L)
 }
 
 const luaL_Reg WebSocket_methods[] = {
-  { "__gc",       WebSocket_gc         },
-  { "close",      WebSocket_close      },
-  { "connect",    WebSocket_connect    },
-  { "sendText",   WebSocket_sendText   },
-  { "sendBinary", WebSocket_sendBinary },
-  { "sendPing",   WebSocket_sendPing   },
-  { nullptr,      nullptr              }
+  { "__gc",          WebSocket_gc            },
+  { "close",         WebSocket_close         },
+  { "connect",       WebSocket_connect       },
+  { "sendText",      WebSocket_sendText      },
+  { "sendBinary",    WebSocket_sendBinary    },
+  { "sendPing",      WebSocket_sendPing      },
+  { "streamSprite",  WebSocket_streamSprite  },
+  { "stopStreaming", WebSocket_stopStreaming },
+  { nullptr,         nullptr                 }
 };
 
 const Property WebSocket_properties[] = {
@@ -0,0 +1,564 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/app.h"
+#include "app/script/engine.h"
+#include "app/script/luacpp.h"
+#include "app/task_scheduler.h"
+#include "doc/color_mode.h"
+#include "doc/image.h"
+#include "ui/system.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace app { namespace script {
+
+void register_app_pixel_color_object(lua_State* L);
+void register_color_space_class(lua_State* L);
+void register_image_class(lua_State* L);
+void register_image_spec_class(lua_State* L);
+void register_image_view_class(lua_State* L);
+void register_point_class(lua_State* L);
+void register_rect_class(lua_State* L);
+void register_size_class(lua_State* L);
+
+namespace {
+
+// Maximum number of nested tables that can be passed from/to a worker
+constexpr int kMaxTableDepth = 64;
+
+// Number of Lua instructions between checks of the cancel flag
+constexpr int kCancelCheckCount = 10000;
+
+// Lua code can run for a long time, so workers use the blocking
+// threads (one worker per core at the same time).
+SerialTaskGroup& workers_tasks()
+{
+  static SerialTaskGroup tasks(TaskKind::Blocking, TaskScheduler::instance()->threads());
+  return tasks;
+}
+
+// A Lua value copied from one Lua state to be pushed in other Lua
+// state (workers run in their own lua_State). Images are copied
+// too, so each Lua state owns its own images.
+struct WorkerValue {
+  enum class Type { Nil, Boolean, Integer, Number, String, Table, Image };
+
+  Type type = Type::Nil;
+  bool boolean = false;
+  lua_Integer integer = 0;
+  lua_Number number = 0.0;
+  std::string string;
+  std::vector<std::pair<WorkerValue, WorkerValue>> table;
+  std::unique_ptr<doc::Image> image;
+};
+
+using WorkerValues = std::vector<WorkerValue>;
+
+WorkerValue get_worker_value(lua_State* L, int index, int depth = 0)
+{
+  index = lua_absindex(L, index);
+
+  WorkerValue value;
+  switch (lua_type(L, index)) {
+    case LUA_TNIL:
+    case LUA_TNONE: break;
+    case LUA_TBOOLEAN:
+      value.type = WorkerValue::Type::Boolean;
+      value.boolean = lua_toboolean(L, index);
+      break;
+    case LUA_TNUMBER:
+      if (lua_isinteger(L, index)) {
+        value.type = WorkerValue::Type::Integer;
+        value.integer = lua_tointeger(L, index);
+      }
+      else {
+        value.type = WorkerValue::Type::Number;
+        value.number = lua_tonumber(L, index);
+      }
+      break;
+    case LUA_TSTRING: {
+      size_t len;
+      const char* s = lua_tolstring(L, index, &len);
+      value.type = WorkerValue::Type::String;
+      value.string.assign(s, len);
+      break;
+    }
+    case LUA_TTABLE:
+      if (depth >= kMaxTableDepth)
+        luaL_error(L, "too many nested tables to be passed to/from a worker");
+
+      value.type = WorkerValue::Type::Table;
+      lua_pushnil(L);
+      while (lua_next(L, index) != 0) {
+        WorkerValue k = get_worker_value(L, -2, depth + 1);
+        WorkerValue v = get_worker_value(L, -1, depth + 1);
+        value.table.emplace_back(std::move(k), std::move(v));
+        lua_pop(L, 1);
+      }
+      break;
+    default:
+      // The image is copied, so the worker works with a snapshot of
+      // the pixels (e.g. of a cel image) without locking the sprite.
+      if (const doc::Image* image = may_get_image_from_arg(L, index)) {
+        value.type = WorkerValue::Type::Image;
+        value.image.reset(doc::Image::createCopy(image));
+        break;
+      }
+      luaL_error(L,
+                 "%s values cannot be passed to/from a worker",
+                 luaL_typename(L, index));
+      break;
+  }
+  return value;
+}
+
+void push_worker_value(lua_State* L, WorkerValue& value)
+{
+  switch (value.type) {
+    case WorkerValue::Type::Nil:     lua_pushnil(L); break;
+    case WorkerValue::Type::Boolean: lua_pushboolean(L, value.boolean); break;
+    case WorkerValue::Type::Integer: lua_pushinteger(L, value.integer); break;
+    case WorkerValue::Type::Number:  lua_pushnumber(L, value.number); break;
+    case WorkerValue::Type::String:
+      lua_pushlstring(L, value.string.c_str(), value.string.size());
+      break;
+    case WorkerValue::Type::Table:
+      lua_createtable(L, 0, int(value.table.size()));
+      for (auto& kv : value.table) {
+        push_worker_value(L, kv.first);
+        push_worker_value(L, kv.second);
+        lua_settable(L, -3);
+      }
+      break;
+    case WorkerValue::Type::Image:
+      // The new Image userdata owns the image
+      if (value.image)
+        push_image(L, value.image.release());
+      else
+        lua_pushnil(L);
+      break;
+  }
+}
+
+// State shared between the Worker userdata (in the main Lua state)
+// and the task that runs in the thread pool.
+struct WorkerTask {
+  std::string chunk; // Bytecode or source code of the function to run
+  std::string chunkName;
+  WorkerValues args;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool finished = false;
+  bool failed = false;
+  std::string error;
+  WorkerValues results;
+
+  std::atomic<bool> cancel = false;
+
+  // Accessed only from the main thread: true if the results were
+  // already given to the script (or the Worker was collected).
+  bool delivered = false;
+  int runningRef = LUA_REFNIL;
+};
+
+void worker_hook(lua_State* L, lua_Debug* ar)
+{
+  WorkerTask* task = *(WorkerTask**)lua_getextraspace(L);
+  if (task->cancel)
+    luaL_error(L, "worker canceled");
+}
+
+int WorkerImage_new(lua_State* L)
+{
+  if (lua_istable(L, 1)) {
+    const int type = lua_getfield(L, 1, "fromFile");
+    lua_pop(L, 1);
+    if (type != LUA_TNIL)
+      return luaL_error(L, "Image{ fromFile } cannot be used in a worker");
+  }
+
+  // Call the original Image() constructor
+  const int nargs = lua_gettop(L);
+  lua_pushvalue(L, lua_upvalueindex(1));
+  lua_insert(L, 1);
+  lua_call(L, nargs, LUA_MULTRET);
+  return lua_gettop(L);
+}
+
+// Creates a Lua state for a worker. Workers don't have access to
+// files, the app, or sprites (objects that are modified from the UI
+// thread), only to standalone images and basic types.
+lua_State* create_worker_state(WorkerTask* task)
+{
+  lua_State* L = luaL_newstate();
+  *(WorkerTask**)lua_getextraspace(L) = task;
+
+  const luaL_Reg libs[] = {
+    { LUA_GNAME,       luaopen_base      },
+    { LUA_COLIBNAME,   luaopen_coroutine },
+    { LUA_TABLIBNAME,  luaopen_table     },
+    { LUA_STRLIBNAME,  luaopen_string    },
+    { LUA_MATHLIBNAME, luaopen_math      },
+    { LUA_UTF8LIBNAME, luaopen_utf8      },
+    { nullptr,         nullptr           }
+  };
+  for (const luaL_Reg* lib = libs; lib->func; ++lib) {
+    luaL_requiref(L, lib->name, lib->func, 1);
+    lua_pop(L, 1);
+  }
+  for (const char* name : { "dofile", "loadfile" }) {
+    lua_pushnil(L);
+    lua_setglobal(L, name);
+  }
+
+  run_mt_index_code(L);
+
+  // app.pixelColor
+  lua_newtable(L);
+  lua_setglobal(L, "app");
+  register_app_pixel_color_object(L);
+
+  lua_newtable(L);
+  lua_pushvalue(L, -1);
+  lua_setglobal(L, "ColorMode");
+  setfield_integer(L, "RGB", doc::ColorMode::RGB);
+  setfield_integer(L, "GRAY", doc::ColorMode::GRAYSCALE);
+  setfield_integer(L, "GRAYSCALE", doc::ColorMode::GRAYSCALE);
+  setfield_integer(L, "INDEXED", doc::ColorMode::INDEXED);
+  setfield_integer(L, "TILEMAP", doc::ColorMode::TILEMAP);
+  lua_pop(L, 1);
+
+  register_color_space_class(L);
+  register_image_class(L);
+  register_image_spec_class(L);
+  register_image_view_class(L);
+  register_point_class(L);
+  register_rect_class(L);
+  register_size_class(L);
+
+  // Remove Image members that need files, sprites, or the UI
+  luaL_getmetatable(L, "Image");
+  for (const char* name : { "saveAs", "drawSprite", "putSprite", "resize" }) {
+    lua_pushnil(L);
+    lua_setfield(L, -2, name);
+  }
+  lua_getfield(L, -1, "__getters");
+  lua_pushnil(L);
+  lua_setfield(L, -2, "context");
+  lua_pop(L, 2);
+
+  lua_getglobal(L, "Image");
+  lua_pushcclosure(L, WorkerImage_new, 1);
+  lua_setglobal(L, "Image");
+
+  lua_sethook(L, worker_hook, LUA_MASKCOUNT, kCancelCheckCount);
+  return L;
+}
+
+// Runs the task function inside a protected call (so any Lua error,
+// including the conversion of the results, is caught by lua_pcall).
+int run_worker_chunk(lua_State* L)
+{
+  auto task = (WorkerTask*)lua_touserdata(L, 1);
+  auto results = (WorkerValues*)lua_touserdata(L, 2);
+  lua_settop(L, 0);
+
+  if (luaL_loadbuffer(L, task->chunk.c_str(), task->chunk.size(), task->chunkName.c_str()))
+    return lua_error(L);
+
+  luaL_checkstack(L, int(task->args.size()), "too many arguments for the worker");
+  for (auto& arg : task->args)
+    push_worker_value(L, arg);
+  lua_call(L, int(task->args.size()), LUA_MULTRET);
+
+  const int n = lua_gettop(L);
+  for (int i = 1; i <= n; ++i)
+    results->push_back(get_worker_value(L, i));
+  return 0;
+}
+
+void run_worker_task(WorkerTask* task)
+{
+  bool failed = false;
+  std::string error;
+  WorkerValues results;
+
+  if (task->cancel) {
+    failed = true;
+    error = "worker canceled";
+  }
+  else {
+    lua_State* L = create_worker_state(task);
+    lua_pushcfunction(L, run_worker_chunk);
+    lua_pushlightuserdata(L, task);
+    lua_pushlightuserdata(L, &results);
+    if (lua_pcall(L, 2, 0, 0)) {
+      failed = true;
+      results.clear();
+      if (const char* s = lua_tostring(L, -1))
+        error = s;
+    }
+    lua_close(L);
+  }
+
+  std::lock_guard lock(task->mutex);
+  task->args.clear();
+  task->finished = true;
+  task->failed = failed;
+  task->error = std::move(error);
+  task->results = std::move(results);
+  task->cv.notify_all();
+}
+
+struct Worker {
+  std::shared_ptr<WorkerTask> task;
+};
+
+// Pushes the results of a finished task in the stack, returns the
+// number of pushed values.
+int push_task_results(lua_State* L, WorkerTask* task)
+{
+  const int n = int(task->results.size());
+  luaL_checkstack(L, n, "too many results from the worker");
+  for (auto& result : task->results)
+    push_worker_value(L, result);
+  task->results.clear();
+  return n;
+}
+
+void unref_task(lua_State* L, WorkerTask* task)
+{
+  task->delivered = true;
+  if (task->runningRef != LUA_REFNIL) {
+    luaL_unref(L, LUA_REGISTRYINDEX, task->runningRef);
+    task->runningRef = LUA_REFNIL;
+  }
+}
+
+// Called from the UI thread when the task is finished to call the
+// onfinish/onerror callbacks.
+void deliver_task_results(lua_State* L, WorkerTask* task)
+{
+  if (task->delivered || task->runningRef == LUA_REFNIL)
+    return;
+
+  try {
+    lua_rawgeti(L, LUA_REGISTRYINDEX, task->runningRef); // Worker
+    const int workerIndex = lua_gettop(L);
+    unref_task(L, task);
+
+    lua_getuservalue(L, workerIndex);
+    int nargs;
+    if (task->failed) {
+      lua_getfield(L, -1, "onerror");
+      lua_pushstring(L, task->error.c_str());
+      nargs = 1;
+    }
+    else {
+      lua_getfield(L, -1, "onfinish");
+      nargs = push_task_results(L, task);
+    }
+
+    const int funcIndex = lua_gettop(L) - nargs;
+    if (lua_isfunction(L, funcIndex)) {
+      if (lua_pcall(L, nargs, 0, 0)) {
+        if (const char* s = lua_tostring(L, -1))
+          App::instance()->scriptEngine()->consolePrint(s);
+      }
+    }
+    else if (task->failed) {
+      App::instance()->scriptEngine()->consolePrint(task->error.c_str());
+    }
+    lua_settop(L, workerIndex - 1);
+  }
+  catch (const std::exception& ex) {
+    App::instance()->scriptEngine()->consolePrint(ex.what());
+  }
+}
+
+int chunk_writer(lua_State* L, const void* p, size_t sz, void* ud)
+{
+  ((std::string*)ud)->append((const char*)p, sz);
+  return 0;
+}
+
+int Worker_new(lua_State* L)
+{
+  if (!lua_istable(L, 1))
+    return luaL_error(L, "Worker{ run, args, onfinish, onerror } expected");
+
+  auto task = std::make_shared<WorkerTask>();
+
+  int type = lua_getfield(L, 1, "run");
+  if (type == LUA_TFUNCTION) {
+    // Functions are passed to the worker as bytecode, so they cannot
+    // reference local variables of the script (only globals that
+    // exist in the worker).
+    const char* name;
+    for (int i = 1; (name = lua_getupvalue(L, -1, i)); ++i) {
+      lua_pop(L, 1);
+      if (std::string(name) != "_ENV")
+        return luaL_error(L,
+                          "the worker function cannot use the local variable '%s', "
+                          "pass it in 'args'",
+                          name);
+    }
+    lua_dump(L, chunk_writer, &task->chunk, 0);
+    task->chunkName = "=worker";
+  }
+  else if (type == LUA_TSTRING) {
+    task->chunk = lua_tostring(L, -1);
+    task->chunkName = "=worker";
+  }
+  else {
+    return luaL_error(L, "'run' must be a function or a string with Lua code");
+  }
+  lua_pop(L, 1);
+
+  type = lua_getfield(L, 1, "args");
+  if (type == LUA_TTABLE) {
+    const int n = int(luaL_len(L, -1));
+    for (int i = 1; i <= n; ++i) {
+      lua_geti(L, -1, i);
+      task->args.push_back(get_worker_value(L, -1));
+      lua_pop(L, 1);
+    }
+  }
+  lua_pop(L, 1);
+
+  push_new<Worker>(L)->task = task;
+
+  // Keep the callbacks in the worker uservalue
+  lua_newtable(L);
+  for (const char* name : { "onfinish", "onerror" }) {
+    if (lua_getfield(L, 1, name) == LUA_TFUNCTION)
+      lua_setfield(L, -2, name);
+    else
+      lua_pop(L, 1);
+  }
+  lua_setuservalue(L, -2);
+  return 1;
+}
+
+int Worker_gc(lua_State* L)
+{
+  auto obj = get_obj<Worker>(L, 1);
+  if (obj->task) {
+    obj->task->cancel = true;
+    obj->task->delivered = true;
+  }
+  obj->~Worker();
+  return 0;
+}
+
+int Worker_start(lua_State* L)
+{
+  auto obj = get_obj<Worker>(L, 1);
+  auto task = obj->task;
+  if (task->runningRef != LUA_REFNIL || task->delivered)
+    return luaL_error(L, "the worker was already started");
+
+  // Keep the worker alive until its results are delivered
+  lua_pushvalue(L, 1);
+  task->runningRef = luaL_ref(L, LUA_REGISTRYINDEX);
+
+  // Results are delivered in the main thread of the Lua state, "L"
+  // can be a coroutine that is collected before the worker finishes.
+  lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+  lua_State* mainL = lua_tothread(L, -1);
+  lua_pop(L, 1);
+
+  workers_tasks().run([task, mainL] {
+    run_worker_task(task.get());
+
+    ui::execute_from_ui_thread([task, mainL] {
+      // The engine could be destroyed/reset while the worker was
+      // running (Worker_gc() marks the task as delivered in that case,
+      // but we check the Lua state anyway to avoid using a closed one).
+      App* app = App::instance();
+      Engine* engine = (app ? app->scriptEngine() : nullptr);
+      if (!engine || engine->luaState() != mainL)
+        return;
+
+      deliver_task_results(mainL, task.get());
+    });
+  });
+  return 0;
+}
+
+int Worker_wait(lua_State* L)
+{
+  auto obj = get_obj<Worker>(L, 1);
+  WorkerTask* task = obj->task.get();
+  if (task->delivered)
+    return luaL_error(L, "the worker results were already delivered");
+  if (task->runningRef == LUA_REFNIL)
+    return luaL_error(L, "the worker is not running");
+
+  {
+    std::unique_lock lock(task->mutex);
+    task->cv.wait(lock, [task] { return task->finished; });
+  }
+
+  // The results are returned here instead of calling onfinish/onerror
+  unref_task(L, task);
+  if (task->failed)
+    return luaL_error(L, "%s", task->error.c_str());
+  return push_task_results(L, task);
+}
+
+int Worker_cancel(lua_State* L)
+{
+  auto obj = get_obj<Worker>(L, 1);
+  obj->task->cancel = true;
+  return 0;
+}
+
+int Worker_get_isRunning(lua_State* L)
+{
+  auto obj = get_obj<Worker>(L, 1);
+  lua_pushboolean(L, obj->task->runningRef != LUA_REFNIL);
+  return 1;
+}
+
+const luaL_Reg Worker_methods[] = {
+  { "__gc",   Worker_gc     },
+  { "start",  Worker_start  },
+  { "wait",   Worker_wait   },
+  { "cancel", Worker_cancel },
+  { nullptr,  nullptr       }
+};
+
+const Property Worker_properties[] = {
+  { "isRunning", Worker_get_isRunning, nullptr },
+  { nullptr,     nullptr,              nullptr }
+};
+
+} // anonymous namespace
+
+DEF_MTNAME(Worker);
+
+void register_worker_class(lua_State* L)
+{
+  REG_CLASS(L, Worker);
+  REG_CLASS_NEW(L, Worker);
+  REG_CLASS_PROPERTIES(L, Worker);
+}
+
+}} // namespace app::script
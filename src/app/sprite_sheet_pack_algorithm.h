@@ -0,0 +1,18 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_SPRITE_SHEET_PACK_ALGORITHM_H_INCLUDED
+#define APP_SPRITE_SHEET_PACK_ALGORITHM_H_INCLUDED
+#pragma once
+
+namespace app {
+
+// Algorithm used to pack samples in SpriteSheetType::Packed sheets.
+enum class SpriteSheetPackAlgorithm { BestFit, MaxRects, Default = BestFit };
+
+} // namespace app
+
+#endif
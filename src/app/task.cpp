@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2022  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -10,35 +10,72 @@
 
 #include "app/task.h"
 
-#include "base/task.h"
-#include "base/thread.h"
-#include "base/thread_pool.h"
+#include "app/task_scheduler.h"
+#include "base/debug.h"
+#include "base/log.h"
+
+#include <exception>
 
 namespace app {
 
-static base::thread_pool tasks_pool(4);
+static std::atomic<int> g_runningTasks(0);
 
-Task::Task() : m_token(nullptr)
+// static
+int Task::runningTasks()
+{
+  return g_runningTasks;
+}
+
+Task::Task(const doc::TaskPriority priority)
+  : m_priority(priority)
+  , m_running(false)
+  , m_completed(false)
 {
 }
 
 Task::~Task()
 {
+  // The task must not be running when we destroy it
+  ASSERT(!m_running);
 }
 
 void Task::run(base::task::func_t&& func)
 {
-  const std::lock_guard lock(m_token_mutex);
-  m_task.on_execute(std::move(func));
-  m_token = &m_task.start(tasks_pool);
+  ASSERT(!m_running);
+
+  std::shared_ptr<base::task_token> token = std::make_shared<base::task_token>();
+  {
+    const std::lock_guard lock(m_token_mutex);
+    m_token = token;
+    m_running = true;
+    m_completed = false;
+  }
+  ++g_runningTasks;
+
+  TaskScheduler::instance()->execute(
+    [this, token, func = std::move(func)] {
+      try {
+        if (!token->canceled())
+          func(*token);
+      }
+      catch (const std::exception& ex) {
+        LOG(ERROR, "TASK: Error: %s\n", ex.what());
+      }
+
+      --g_runningTasks;
+
+      const std::lock_guard lock(m_token_mutex);
+      m_running = false;
+      m_completed = true;
+      m_completedCv.notify_all();
+    },
+    m_priority);
 }
 
 void Task::wait()
 {
-  // TODO wait a condition variable
-  while (!m_task.completed()) {
-    base::this_thread::sleep_for(0.1);
-  }
+  std::unique_lock lock(m_token_mutex);
+  m_completedCv.wait(lock, [this] { return !m_running; });
 }
 
 } // namespace app
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2020  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -9,25 +9,34 @@
 #pragma once
 
 #include "base/task.h"
+#include "doc/task_group.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <memory>
 #include <mutex>
 
 namespace app {
 
+// A function executed in the threads of the TaskScheduler that
+// can be canceled and reports its progress.
 class Task {
 public:
-  Task();
+  explicit Task(doc::TaskPriority priority = doc::TaskPriority::Background);
   ~Task();
 
   void run(base::task::func_t&& func);
   void wait();
 
+  // Number of tasks running in the background.
+  static int runningTasks();
+
   // Returns true when the task is completed (whether it was
   // canceled or not)
-  bool completed() const { return m_task.completed(); }
+  bool completed() const { return m_completed; }
 
-  bool running() const { return m_task.running(); }
+  bool running() const { return m_running; }
 
   bool canceled() const
   {
@@ -60,9 +69,14 @@ public:
   }
 
 private:
-  base::task m_task;
+  doc::TaskPriority m_priority;
+  std::atomic<bool> m_running;
+  std::atomic<bool> m_completed;
   mutable std::mutex m_token_mutex;
-  base::task_token* m_token;
+  std::condition_variable m_completedCv;
+  // New token for each run() so a canceled run doesn't cancel the
+  // next one.
+  std::shared_ptr<base::task_token> m_token;
 };
 
 } // namespace app
@@ -0,0 +1,361 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/task_scheduler.h"
+
+#include "base/debug.h"
+#include "base/log.h"
+#include "base/task.h"
+#include "base/thread.h"
+
+#include <algorithm>
+#include <exception>
+#include <utility>
+
+namespace app {
+
+static int g_threads = 0;
+
+TaskScheduler::TaskScheduler(const int threads)
+{
+  // The thread that waits a group is one of the threads that
+  // execute tasks.
+  const int workers = std::max(1, threads - 1);
+  m_maxBackground = std::max(1, workers / 2);
+
+  m_workers.reserve(workers);
+  for (int i = 0; i < workers; ++i)
+    m_workers.emplace_back([this] { workerProc(); });
+
+  doc::set_task_executor(this);
+}
+
+TaskScheduler::~TaskScheduler()
+{
+  // New doc::TaskGroups will execute their tasks in the waiting
+  // thread
+  doc::set_task_executor(nullptr);
+
+  {
+    const std::lock_guard lock(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  m_blockingCv.notify_all();
+  for (auto& worker : m_workers)
+    worker.join();
+
+  // Blocking threads can be created while we join them (a blocking
+  // function can execute other one)
+  for (;;) {
+    std::vector<std::thread> threads;
+    {
+      const std::lock_guard lock(m_mutex);
+      std::swap(threads, m_blockingThreads);
+    }
+    if (threads.empty())
+      break;
+    for (auto& thread : threads)
+      thread.join();
+  }
+}
+
+// static
+void TaskScheduler::SetThreads(const int threads)
+{
+  g_threads = threads;
+}
+
+// static
+TaskScheduler* TaskScheduler::instance()
+{
+  static TaskScheduler scheduler(
+    g_threads > 0 ? g_threads : std::max(1, int(std::thread::hardware_concurrency())));
+  return &scheduler;
+}
+
+void TaskScheduler::schedule(const doc::TaskPriority priority, std::function<void()>&& runOne)
+{
+  {
+    const std::lock_guard lock(m_mutex);
+    m_queues[int(priority)].push_back(std::move(runOne));
+  }
+  m_cv.notify_one();
+}
+
+void TaskScheduler::execute(std::function<void()>&& func,
+                            const doc::TaskPriority priority,
+                            const base::task_token* token)
+{
+  schedule(priority, [func = std::move(func), token] {
+    if (token && token->canceled())
+      return;
+    try {
+      func();
+    }
+    catch (const std::exception& ex) {
+      LOG(ERROR, "TASK: Error: %s\n", ex.what());
+    }
+    catch (...) {
+      // Ignore exceptions as a TaskGroup that isn't waited
+    }
+  });
+}
+
+void TaskScheduler::executeBlocking(std::function<void()>&& func)
+{
+  {
+    const std::lock_guard lock(m_mutex);
+    m_blockingQueue.push_back(std::move(func));
+
+    // Create a new thread if all of them are busy
+    if (m_idleBlockingThreads < int(m_blockingQueue.size()))
+      m_blockingThreads.emplace_back([this] { blockingProc(); });
+  }
+  m_blockingCv.notify_one();
+}
+
+void TaskScheduler::workerProc()
+{
+  base::this_thread::set_name("tasks");
+
+  for (;;) {
+    std::function<void()> func;
+    bool background = false;
+    {
+      std::unique_lock lock(m_mutex);
+      m_cv.wait(lock, [this] {
+        return (m_stop || !m_queues[int(doc::TaskPriority::Critical)].empty() ||
+                !m_queues[int(doc::TaskPriority::Interactive)].empty() ||
+                (!m_queues[int(doc::TaskPriority::Background)].empty() &&
+                 m_runningBackground < m_maxBackground));
+      });
+
+      for (auto& queue : m_queues) {
+        background = (&queue == &m_queues[int(doc::TaskPriority::Background)]);
+        if (background && m_runningBackground >= m_maxBackground)
+          break;
+        if (!queue.empty()) {
+          func = std::move(queue.front());
+          queue.pop_front();
+          break;
+        }
+      }
+      if (!func) {
+        if (m_stop)
+          return;
+        continue;
+      }
+      if (background)
+        ++m_runningBackground;
+    }
+
+    func();
+
+    if (background) {
+      {
+        const std::lock_guard lock(m_mutex);
+        --m_runningBackground;
+      }
+      m_cv.notify_one();
+    }
+  }
+}
+
+void TaskScheduler::blockingProc()
+{
+  for (;;) {
+    std::function<void()> func;
+    {
+      std::unique_lock lock(m_mutex);
+      ++m_idleBlockingThreads;
+      m_blockingCv.wait(lock, [this] { return m_stop || !m_blockingQueue.empty(); });
+      --m_idleBlockingThreads;
+
+      if (m_blockingQueue.empty())
+        return;
+      func = std::move(m_blockingQueue.front());
+      m_blockingQueue.pop_front();
+    }
+
+    base::this_thread::set_name("blocking");
+    func();
+  }
+}
+
+//////////////////////////////////////////////////////////////////////
+// BlockingTask
+
+struct BlockingTask::State {
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done = false;
+};
+
+BlockingTask::BlockingTask(std::function<void()>&& func) : m_state(std::make_shared<State>())
+{
+  TaskScheduler::instance()->executeBlocking([state = m_state, func = std::move(func)] {
+    try {
+      func();
+    }
+    catch (const std::exception& ex) {
+      LOG(ERROR, "TASK: Error: %s\n", ex.what());
+    }
+    catch (...) {
+      LOG(ERROR, "TASK: Unknown error\n");
+    }
+
+    const std::lock_guard lock(state->mutex);
+    state->done = true;
+    state->cv.notify_all();
+  });
+}
+
+BlockingTask& BlockingTask::operator=(BlockingTask&& other)
+{
+  // As std::thread we cannot replace a task that is not joined
+  ASSERT(!joinable());
+  if (joinable())
+    join();
+
+  m_state = std::move(other.m_state);
+  return *this;
+}
+
+BlockingTask::~BlockingTask()
+{
+  if (joinable())
+    join();
+}
+
+void BlockingTask::join()
+{
+  ASSERT(m_state);
+  if (!m_state)
+    return;
+
+  std::unique_lock lock(m_state->mutex);
+  m_state->cv.wait(lock, [this] { return m_state->done; });
+  lock.unlock();
+  m_state.reset();
+}
+
+//////////////////////////////////////////////////////////////////////
+// SerialTaskGroup
+
+struct SerialTaskGroup::State {
+  TaskKind kind;
+  int maxRunning;
+  doc::TaskPriority priority;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::function<void()>> tasks; // Tasks not started yet
+  int running = 0;
+  std::exception_ptr exception;
+
+  State(const TaskKind kind, const int maxRunning, const doc::TaskPriority priority)
+    : kind(kind)
+    , maxRunning(std::max(1, maxRunning))
+    , priority(priority)
+  {
+  }
+};
+
+SerialTaskGroup::SerialTaskGroup(const TaskKind kind,
+                                 const int maxRunning,
+                                 const doc::TaskPriority priority)
+  : m_state(std::make_shared<State>(kind, maxRunning, priority))
+{
+  // Create the scheduler before this group, so static groups are
+  // destroyed (and waited) before the scheduler threads are stopped
+  TaskScheduler::instance();
+}
+
+SerialTaskGroup::~SerialTaskGroup()
+{
+  try {
+    wait();
+  }
+  catch (...) {
+    // Ignore exceptions that weren't waited
+  }
+}
+
+void SerialTaskGroup::run(std::function<void()>&& func)
+{
+  {
+    const std::lock_guard lock(m_state->mutex);
+    m_state->tasks.push_back(std::move(func));
+    if (m_state->running >= m_state->maxRunning)
+      return;
+    ++m_state->running;
+  }
+  start(m_state);
+}
+
+void SerialTaskGroup::wait()
+{
+  std::exception_ptr exception;
+  {
+    std::unique_lock lock(m_state->mutex);
+    m_state->cv.wait(lock, [this] { return m_state->running == 0; });
+    std::swap(exception, m_state->exception);
+  }
+  if (exception)
+    std::rethrow_exception(exception);
+}
+
+// static
+void SerialTaskGroup::start(const std::shared_ptr<State>& state)
+{
+  auto func = [state] {
+    std::function<void()> task;
+    {
+      const std::lock_guard lock(state->mutex);
+      // Other running task could take the last task
+      if (state->tasks.empty()) {
+        if (--state->running == 0)
+          state->cv.notify_all();
+        return;
+      }
+      task = std::move(state->tasks.front());
+      state->tasks.pop_front();
+    }
+
+    try {
+      task();
+    }
+    catch (...) {
+      const std::lock_guard lock(state->mutex);
+      if (!state->exception)
+        state->exception = std::current_exception();
+    }
+
+    bool next;
+    {
+      const std::lock_guard lock(state->mutex);
+      next = !state->tasks.empty();
+      if (!next && --state->running == 0)
+        state->cv.notify_all();
+    }
+    // Continue with the next task in a new call, so the workers can
+    // execute tasks with more priority between our tasks
+    if (next)
+      start(state);
+  };
+
+  auto* scheduler = TaskScheduler::instance();
+  if (state->kind == TaskKind::Blocking)
+    scheduler->executeBlocking(std::move(func));
+  else
+    scheduler->execute(std::move(func), state->priority);
+}
+
+} // namespace app
@@ -0,0 +1,155 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_TASK_SCHEDULER_H_INCLUDED
+#define APP_TASK_SCHEDULER_H_INCLUDED
+#pragma once
+
+#include "base/disable_copying.h"
+#include "doc/task_group.h"
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace base {
+class task_token;
+}
+
+namespace app {
+
+// Threads shared by all the tasks of the program, so features that
+// split work in tasks (file decoding, resize, masks, etc.) use the
+// available cores without creating one pool each.
+//
+// There are two kind of threads:
+//
+// 1. Workers: one for each core (minus the thread that waits a
+//    doc::TaskGroup). They execute the doc::TaskGroup tasks and the
+//    execute() functions in order of priority. Background tasks use
+//    at most half of the workers.
+//
+// 2. Blocking threads: execute functions that can block the thread
+//    for a long time (waiting I/O, a queue of jobs, a script, etc.)
+//    without taking a worker. They are created when all of them are
+//    busy and re-used for the next blocking functions.
+//
+// The instance is installed as the doc::TaskExecutor, so doc/render
+// libraries split their work with the same workers.
+class TaskScheduler : public doc::TaskExecutor {
+public:
+  ~TaskScheduler();
+
+  // Changes the number of threads that execute tasks (including the
+  // thread that waits a group). Must be called before the first
+  // instance() call, by default it's the number of cores.
+  static void SetThreads(int threads);
+
+  static TaskScheduler* instance();
+
+  // doc::TaskExecutor impl
+  int threads() const override { return int(m_workers.size()) + 1; }
+  void schedule(doc::TaskPriority priority, std::function<void()>&& runOne) override;
+
+  // Executes the given function in a worker thread (without waiting
+  // it). The function is not called if the token is canceled.
+  void execute(std::function<void()>&& func,
+               doc::TaskPriority priority = doc::TaskPriority::Background,
+               const base::task_token* token = nullptr);
+
+  // Executes the given function in a blocking thread (without
+  // waiting it).
+  void executeBlocking(std::function<void()>&& func);
+
+private:
+  explicit TaskScheduler(int threads);
+  void workerProc();
+  void blockingProc();
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  // One entry for each scheduled task (an entry of a doc::TaskGroup
+  // does nothing if the task was already executed by the thread
+  // waiting the group).
+  std::deque<std::function<void()>> m_queues[3];
+  int m_runningBackground = 0;
+  int m_maxBackground;
+  std::vector<std::thread> m_workers;
+
+  std::condition_variable m_blockingCv;
+  std::deque<std::function<void()>> m_blockingQueue;
+  std::vector<std::thread> m_blockingThreads;
+  int m_idleBlockingThreads = 0;
+
+  bool m_stop = false;
+
+  DISABLE_COPYING(TaskScheduler);
+};
+
+// A function that can block or run for a long time (e.g. a loop
+// processing a queue of jobs), executed in a blocking thread of the
+// TaskScheduler instead of a new std::thread. It's joined like a
+// thread (the destructor joins it too). The function can change the
+// name of the thread, it's restored when the function returns.
+class BlockingTask {
+public:
+  BlockingTask() {}
+  explicit BlockingTask(std::function<void()>&& func);
+  BlockingTask(BlockingTask&& other) = default;
+  BlockingTask& operator=(BlockingTask&& other);
+  ~BlockingTask();
+
+  bool joinable() const { return m_state != nullptr; }
+  void join();
+
+private:
+  struct State;
+  std::shared_ptr<State> m_state;
+
+  DISABLE_COPYING(BlockingTask);
+};
+
+enum class TaskKind {
+  Compute,  // Uses the CPU (executed in the workers)
+  Blocking, // Can block the thread (I/O, scripts, etc.)
+};
+
+// Tasks executed in the same order they were added with at most
+// "maxRunning" tasks at the same time (by default one after the
+// other). Useful to serialize background jobs, or to limit the
+// number of concurrent I/O tasks. E.g.
+//
+//   static SerialTaskGroup tasks;
+//   tasks.run([] { ... });
+//
+// If a task throws an exception, wait() throws the first one. The
+// destructor waits all the tasks.
+class SerialTaskGroup {
+public:
+  explicit SerialTaskGroup(TaskKind kind = TaskKind::Compute,
+                           int maxRunning = 1,
+                           doc::TaskPriority priority = doc::TaskPriority::Background);
+  ~SerialTaskGroup();
+
+  void run(std::function<void()>&& func);
+  void wait();
+
+private:
+  struct State;
+  static void start(const std::shared_ptr<State>& state);
+
+  std::shared_ptr<State> m_state;
+
+  DISABLE_COPYING(SerialTaskGroup);
+};
+
+} // namespace app
+
+#endif
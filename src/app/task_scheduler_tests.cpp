@@ -0,0 +1,179 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#include "tests/app_test.h"
+
+#include "app/task_scheduler.h"
+#include "base/task.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace app;
+using namespace doc;
+
+TEST(TaskScheduler, RunAllTasks)
+{
+  TaskScheduler::instance();
+
+  std::atomic<int> sum(0);
+  TaskGroup tasks;
+  for (int i = 1; i <= 100; ++i)
+    tasks.run([&sum, i] { sum += i; });
+  tasks.wait();
+  EXPECT_EQ(5050, sum);
+}
+
+TEST(TaskScheduler, NestedGroups)
+{
+  // More outer tasks than workers, each one waiting its own tasks
+  const int n = TaskScheduler::instance()->threads() * 4;
+  std::atomic<int> count(0);
+  TaskGroup outer(TaskPriority::Background);
+  for (int i = 0; i < n; ++i) {
+    outer.run([&count] {
+      TaskGroup inner;
+      for (int j = 0; j < 10; ++j)
+        inner.run([&count] { ++count; });
+      inner.wait();
+    });
+  }
+  outer.wait();
+  EXPECT_EQ(n * 10, count);
+}
+
+TEST(TaskScheduler, CanceledTasks)
+{
+  TaskScheduler::instance();
+
+  base::task_token token;
+  token.cancel();
+
+  std::atomic<int> count(0);
+  TaskGroup tasks(TaskPriority::Interactive, &token);
+  for (int i = 0; i < 10; ++i)
+    tasks.run([&count] { ++count; });
+  tasks.wait();
+  EXPECT_EQ(0, count);
+}
+
+TEST(TaskScheduler, Exceptions)
+{
+  TaskScheduler::instance();
+
+  std::atomic<int> count(0);
+  TaskGroup tasks;
+  for (int i = 0; i < 10; ++i) {
+    tasks.run([&count, i] {
+      ++count;
+      if (i == 5)
+        throw std::runtime_error("error");
+    });
+  }
+  EXPECT_THROW(tasks.wait(), std::runtime_error);
+  EXPECT_EQ(10, count);
+}
+
+TEST(TaskScheduler, BlockingTasksDontTakeWorkers)
+{
+  // More blocking tasks than workers waiting each other
+  const int n = TaskScheduler::instance()->threads() + 2;
+  std::atomic<int> started(0);
+  std::vector<BlockingTask> tasks;
+  for (int i = 0; i < n; ++i) {
+    tasks.emplace_back([&started, n] {
+      ++started;
+      while (started < n)
+        std::this_thread::yield();
+    });
+  }
+
+  // Workers are still available
+  std::atomic<int> count(0);
+  TaskGroup group;
+  for (int i = 0; i < 10; ++i)
+    group.run([&count] { ++count; });
+  group.wait();
+  EXPECT_EQ(10, count);
+
+  for (auto& task : tasks) {
+    EXPECT_TRUE(task.joinable());
+    task.join();
+    EXPECT_FALSE(task.joinable());
+  }
+  EXPECT_EQ(n, started);
+}
+
+TEST(TaskScheduler, SerialTasksOrder)
+{
+  for (TaskKind kind : { TaskKind::Compute, TaskKind::Blocking }) {
+    std::mutex mutex;
+    std::vector<int> order;
+    std::atomic<int> running(0);
+    bool overlapped = false;
+
+    SerialTaskGroup tasks(kind);
+    for (int i = 0; i < 50; ++i) {
+      tasks.run([&, i] {
+        if (++running > 1)
+          overlapped = true;
+        {
+          const std::lock_guard lock(mutex);
+          order.push_back(i);
+        }
+        --running;
+      });
+    }
+    tasks.wait();
+
+    EXPECT_FALSE(overlapped);
+    ASSERT_EQ(50, order.size());
+    for (int i = 0; i < 50; ++i)
+      EXPECT_EQ(i, order[i]);
+  }
+}
+
+TEST(TaskScheduler, SerialTasksMaxRunning)
+{
+  std::atomic<int> running(0);
+  std::atomic<int> maxRunning(0);
+  std::atomic<int> count(0);
+
+  SerialTaskGroup tasks(TaskKind::Blocking, 2);
+  for (int i = 0; i < 20; ++i) {
+    tasks.run([&] {
+      const int n = ++running;
+      int m = maxRunning;
+      while (n > m && !maxRunning.compare_exchange_weak(m, n)) {}
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      ++count;
+      --running;
+    });
+  }
+  tasks.wait();
+
+  EXPECT_EQ(20, count);
+  EXPECT_LE(maxRunning, 2);
+}
+
+TEST(TaskScheduler, SerialTasksExceptions)
+{
+  std::atomic<int> count(0);
+  SerialTaskGroup tasks;
+  for (int i = 0; i < 10; ++i) {
+    tasks.run([&count, i] {
+      ++count;
+      if (i == 5)
+        throw std::runtime_error("error");
+    });
+  }
+  EXPECT_THROW(tasks.wait(), std::runtime_error);
+  EXPECT_EQ(10, count);
+}
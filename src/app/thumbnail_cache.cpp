@@ -0,0 +1,278 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/thumbnail_cache.h"
+
+#include "app/file/qoi_image.h"
+#include "base/convert_to.h"
+#include "base/fs.h"
+#include "base/fstream_path.h"
+#include "base/serialization.h"
+#include "base/sha1.h"
+#include "base/time.h"
+#include "doc/image.h"
+#include "doc/image_io.h"
+#include "doc/palette.h"
+#include "doc/palette_io.h"
+#include "fmt/format.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace app {
+
+using namespace base::serialization;
+using namespace base::serialization::little_endian;
+
+namespace {
+
+// First line of each thumbnail file and of the index file (change
+// the version number if the format of these files changes).
+const char* kThumbnailHeader = "aseprite-thumbnail 2";
+const char* kIndexHeader = "aseprite-thumbnail-index 1";
+
+// Formats of the image of each thumbnail file (RGB images are
+// stored as QOI images because they are faster to decode).
+enum ThumbnailImageFormat : uint8_t { kDocImage = 0, kQoiImage = 1 };
+
+// When the cache is full we remove entries until it's 75% full, so
+// we don't have to evict entries on each new thumbnail.
+const std::size_t kEvictionRatio = 75;
+
+} // anonymous namespace
+
+ThumbnailCache::ThumbnailCache(const std::string& dir, const std::size_t maxSize)
+  : m_dir(dir)
+  , m_maxSize(maxSize)
+{
+}
+
+ThumbnailCache::~ThumbnailCache()
+{
+  flush();
+}
+
+bool ThumbnailCache::load(const std::string& filename,
+                          std::unique_ptr<doc::Image>& image,
+                          std::unique_ptr<doc::Palette>& palette)
+{
+  const std::string key = keyForFile(filename);
+  if (key.empty())
+    return false;
+
+  const std::lock_guard lock(m_mutex);
+  loadIndex();
+
+  auto it = m_entries.find(key);
+  if (it == m_entries.end())
+    return false;
+
+  try {
+    std::ifstream f(FSTREAM_PATH(entryFilename(key)), std::ifstream::binary);
+    std::string header;
+    if (!f || !std::getline(f, header) || header != kThumbnailHeader)
+      throw std::runtime_error("Invalid thumbnail file");
+
+    if (read8(f) == kQoiImage) {
+      const uint32_t size = read32(f);
+      std::vector<uint8_t> data(size);
+      if (!f.read((char*)data.data(), size))
+        throw std::runtime_error("Invalid thumbnail file");
+      image.reset(decode_qoi_image(data.data(), data.size()));
+    }
+    else {
+      image.reset(doc::read_image(f, false));
+    }
+    palette.reset(doc::read_palette(f));
+    if (!image || !palette || !f)
+      throw std::runtime_error("Invalid thumbnail file");
+  }
+  catch (const std::exception&) {
+    image.reset();
+    palette.reset();
+    removeEntry(key);
+    return false;
+  }
+
+  it->second.lastUse = ++m_useCounter;
+  m_modified = true;
+  return true;
+}
+
+void ThumbnailCache::save(const std::string& filename,
+                          const doc::Image* image,
+                          const doc::Palette* palette)
+{
+  const std::string key = keyForFile(filename);
+  if (key.empty() || !image || !palette)
+    return;
+
+  // Encode the thumbnail in memory (without locking the mutex)
+  std::ostringstream data;
+  data << kThumbnailHeader << '\n';
+  base::buffer qoi;
+  if (encode_qoi_image(image, qoi)) {
+    write8(data, kQoiImage);
+    write32(data, uint32_t(qoi.size()));
+    data.write((const char*)qoi.data(), qoi.size());
+  }
+  else {
+    write8(data, kDocImage);
+    if (!doc::write_image(data, image))
+      return;
+  }
+  doc::write_palette(data, palette);
+
+  const std::string buf = data.str();
+
+  const std::lock_guard lock(m_mutex);
+  loadIndex();
+
+  try {
+    if (!base::is_directory(m_dir))
+      base::make_all_directories(m_dir);
+
+    base::write_file_content(entryFilename(key), (const uint8_t*)buf.c_str(), buf.size());
+  }
+  catch (const std::exception&) {
+    return;
+  }
+
+  Entry& entry = m_entries[key];
+  m_totalSize -= entry.size;
+  entry.size = buf.size();
+  entry.lastUse = ++m_useCounter;
+  m_totalSize += entry.size;
+  m_modified = true;
+
+  if (m_totalSize > m_maxSize)
+    evictEntries();
+}
+
+// The index contains one line for each entry with "<key> <size>
+// <lastUse>", where "lastUse" is used to sort the entries from the
+// least to the most recently used.
+void ThumbnailCache::flush()
+{
+  const std::lock_guard lock(m_mutex);
+  if (!m_modified)
+    return;
+
+  std::string index = kIndexHeader;
+  index.push_back('\n');
+  for (const auto& it : m_entries)
+    index += fmt::format("{} {} {}\n", it.first, it.second.size, it.second.lastUse);
+
+  try {
+    if (!base::is_directory(m_dir))
+      base::make_all_directories(m_dir);
+
+    base::write_file_content(indexFilename(), (const uint8_t*)index.c_str(), index.size());
+    m_modified = false;
+  }
+  catch (const std::exception&) {
+    // Ignore errors, we'll try again in the next flush()
+  }
+}
+
+std::string ThumbnailCache::keyForFile(const std::string& filename) const
+{
+  if (!base::is_file(filename))
+    return std::string();
+
+  const base::Time t = base::get_modification_time(filename);
+  const std::string id = fmt::format("{}\n{}\n{:04}{:02}{:02}{:02}{:02}{:02}",
+                                     base::normalize_path(filename),
+                                     base::file_size(filename),
+                                     t.year,
+                                     t.month,
+                                     t.day,
+                                     t.hour,
+                                     t.minute,
+                                     t.second);
+
+  return base::convert_to<std::string>(base::Sha1::calculateFromString(id));
+}
+
+std::string ThumbnailCache::entryFilename(const std::string& key) const
+{
+  return base::join_path(m_dir, key + ".thumb");
+}
+
+std::string ThumbnailCache::indexFilename() const
+{
+  return base::join_path(m_dir, "index");
+}
+
+void ThumbnailCache::loadIndex()
+{
+  if (m_indexLoaded)
+    return;
+  m_indexLoaded = true;
+
+  std::ifstream f(FSTREAM_PATH(indexFilename()));
+  std::string line;
+  if (!f || !std::getline(f, line) || line != kIndexHeader)
+    return;
+
+  std::string key;
+  Entry entry;
+  while (f >> key >> entry.size >> entry.lastUse) {
+    // Ignore entries of thumbnails that were deleted
+    if (!base::is_file(entryFilename(key)))
+      continue;
+
+    m_entries[key] = entry;
+    m_totalSize += entry.size;
+    m_useCounter = std::max(m_useCounter, entry.lastUse);
+  }
+}
+
+void ThumbnailCache::removeEntry(const std::string& key)
+{
+  auto it = m_entries.find(key);
+  if (it == m_entries.end())
+    return;
+
+  try {
+    const std::string fn = entryFilename(key);
+    if (base::is_file(fn))
+      base::delete_file(fn);
+  }
+  catch (const std::exception&) {
+    // Ignore errors, the entry is removed from the index anyway
+  }
+
+  m_totalSize -= it->second.size;
+  m_entries.erase(it);
+  m_modified = true;
+}
+
+void ThumbnailCache::evictEntries()
+{
+  std::vector<std::pair<uint64_t, std::string>> entries;
+  entries.reserve(m_entries.size());
+  for (const auto& it : m_entries)
+    entries.emplace_back(it.second.lastUse, it.first);
+
+  // Least recently used entries first
+  std::sort(entries.begin(), entries.end());
+
+  const std::size_t limit = m_maxSize * kEvictionRatio / 100;
+  for (const auto& entry : entries) {
+    if (m_totalSize <= limit)
+      break;
+    removeEntry(entry.second);
+  }
+}
+
+} // namespace app
@@ -0,0 +1,81 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_THUMBNAIL_CACHE_H_INCLUDED
+#define APP_THUMBNAIL_CACHE_H_INCLUDED
+#pragma once
+
+#include "base/disable_copying.h"
+#include "base/ints.h"
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace doc {
+class Image;
+class Palette;
+} // namespace doc
+
+namespace app {
+
+// Persistent cache of the thumbnails generated by the
+// ThumbnailGenerator. Each thumbnail is saved in its own file
+// (identified by the path, size and modification time of the
+// original file), and the least recently used ones are removed when
+// the cache exceeds its maximum size. All public member functions
+// can be called from any thread.
+class ThumbnailCache {
+public:
+  ThumbnailCache(const std::string& dir, std::size_t maxSize);
+  ~ThumbnailCache();
+
+  // Loads the thumbnail of the given file. Returns false if it's not
+  // in the cache or the file was modified after the thumbnail was
+  // saved.
+  bool load(const std::string& filename,
+            std::unique_ptr<doc::Image>& image,
+            std::unique_ptr<doc::Palette>& palette);
+
+  // Saves the thumbnail of the given file (its palette is used to
+  // convert the image to a surface when it's an indexed image).
+  void save(const std::string& filename, const doc::Image* image, const doc::Palette* palette);
+
+  // Writes the list of entries to disk (it's called automatically
+  // from the destructor).
+  void flush();
+
+private:
+  struct Entry {
+    std::size_t size = 0;
+    uint64_t lastUse = 0;
+  };
+
+  std::string keyForFile(const std::string& filename) const;
+  std::string entryFilename(const std::string& key) const;
+  std::string indexFilename() const;
+  void loadIndex();
+  void removeEntry(const std::string& key);
+  void evictEntries();
+
+  std::string m_dir;
+  std::size_t m_maxSize;
+  std::size_t m_totalSize = 0;
+  // Counter used to know the order in which the entries were used.
+  uint64_t m_useCounter = 0;
+  std::map<std::string, Entry> m_entries;
+  bool m_indexLoaded = false;
+  bool m_modified = false;
+  std::mutex m_mutex;
+
+  DISABLE_COPYING(ThumbnailCache);
+};
+
+} // namespace app
+
+#endif
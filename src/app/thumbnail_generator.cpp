@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -16,7 +16,12 @@
 #include "app/doc.h"
 #include "app/file/file.h"
 #include "app/file_system.h"
+#include "app/pref/preferences.h"
+#include "app/resource_finder.h"
+#include "app/task_scheduler.h"
+#include "app/thumbnail_cache.h"
 #include "app/util/conversion_to_surface.h"
+#include "base/fs.h"
 #include "base/thread.h"
 #include "doc/algorithm/rotate.h"
 #include "doc/image.h"
@@ -26,24 +31,31 @@
 #include "os/system.h"
 #include "render/projection.h"
 #include "render/render.h"
+#include "tracing/metrics.h"
 #include "ui/system.h"
 
 #include <algorithm>
 #include <atomic>
 #include <memory>
-#include <thread>
+#include <set>
 
 #define MAX_THUMBNAIL_SIZE 128
 #define THUMB_TRACE(...)
 
 namespace app {
 
+static tracing::Histogram g_loadTime("thumbnails.load_us");
+static tracing::Histogram g_queueDepth("thumbnails.queue_depth");
+static tracing::Counter g_cacheHits("thumbnails.cache.hits");
+static tracing::Counter g_cacheMisses("thumbnails.cache.misses");
+
 class ThumbnailGenerator::Worker {
 public:
-  Worker(base::concurrent_queue<ThumbnailGenerator::Item>& queue)
-    : m_queue(queue)
+  Worker(ThumbnailGenerator* generator)
+    : m_generator(generator)
+    , m_cache(generator->m_cache.get())
     , m_fop(nullptr)
-    , m_isDone(false)
+    , m_isBusy(false)
     , m_thread([this] { loadBgThread(); })
   {
   }
@@ -65,7 +77,16 @@ public:
       m_fop->stop();
   }
 
-  bool isDone() const { return m_isDone; }
+  // Stops the current thumbnail if it's not for one of the given
+  // items.
+  void stopIfNotIn(const std::set<IFileItem*>& fileitems) const
+  {
+    const std::lock_guard lock(m_mutex);
+    if (m_fop && m_item.fileitem && fileitems.find(m_item.fileitem) == fileitems.end())
+      m_fop->stop();
+  }
+
+  bool isBusy() const { return m_isBusy; }
 
   void updateProgress()
   {
@@ -81,6 +102,7 @@ private:
   void loadItem()
   {
     ASSERT(!m_fop);
+    const tracing::Histogram::Timer timer(g_loadTime);
     try {
       {
         const std::lock_guard lock(m_mutex);
@@ -88,66 +110,22 @@ private:
         ASSERT(m_fop);
       }
 
-      THUMB_TRACE("FOP loading thumbnail: %s\n", m_item.fileitem->fileName().c_str());
-
-      // Load the file
-      m_fop->operate(nullptr);
-
-      // Don't call post-load because postLoad() needs user interaction.
-      // m_fop->postLoad();
-
-      // Convert the loaded document into the os::Surface.
-      const Sprite* sprite =
-        (m_fop->document() && m_fop->document()->sprite() ? m_fop->document()->sprite() : nullptr);
-
       std::unique_ptr<Image> thumbnailImage;
       std::unique_ptr<Palette> palette;
-      if (!m_fop->isStop() && sprite) {
-        // The palette to convert the Image
-        palette.reset(new Palette(*sprite->palette(frame_t(0))));
-
-        // Special case for indexed images:
-        // If the sprite is transparent -> set the transparent color index alpha = 0
-        if (sprite->colorMode() == ColorMode::INDEXED && !sprite->backgroundLayer()) {
-          int i = sprite->transparentColor();
-          if (i >= 0 && i < int(palette->size()))
-            palette->setEntry(i, doc::rgba(0, 0, 0, 0));
-        }
 
-        const int w = sprite->width() * sprite->pixelRatio().w;
-        const int h = sprite->height() * sprite->pixelRatio().h;
-
-        // Calculate the thumbnail size
-        int thumb_w = MAX_THUMBNAIL_SIZE * w / std::max(w, h);
-        int thumb_h = MAX_THUMBNAIL_SIZE * h / std::max(w, h);
-        if (std::max(thumb_w, thumb_h) > std::max(w, h)) {
-          thumb_w = w;
-          thumb_h = h;
-        }
-        thumb_w = std::clamp(thumb_w, 1, MAX_THUMBNAIL_SIZE);
-        thumb_h = std::clamp(thumb_h, 1, MAX_THUMBNAIL_SIZE);
-
-        // Stretch the 'image'
-        thumbnailImage.reset(Image::create(sprite->pixelFormat(), thumb_w, thumb_h));
-
-        render::Projection proj(sprite->pixelRatio(), render::Zoom(thumb_w, w));
-        render::Render render;
-        render.setBgOptions(render::BgOptions::MakeTransparent());
-        render.setProjection(proj);
-        render.renderSprite(thumbnailImage.get(), sprite, frame_t(0), gfx::Clip(0, 0, 0, 0, w, h));
-
-        // Convert the image to sRGB color space
-        auto cs = sprite->colorSpace();
-        if (m_fop->preserveColorProfile() && cs && !cs->nearlyEqual(*gfx::ColorSpace::MakeSRGB())) {
-          app::cmd::convert_color_profile(thumbnailImage.get(),
-                                          palette.get(),
-                                          cs,
-                                          gfx::ColorSpace::MakeSRGB());
-        }
+      // Use the thumbnail from the disk cache (if the file wasn't
+      // modified) so we don't need to load the file again
+      if (m_cache && m_cache->load(m_fop->filename(), thumbnailImage, palette)) {
+        THUMB_TRACE("FOP thumbnail from cache: %s\n", m_item.fileitem->fileName().c_str());
+        g_cacheHits.add();
+      }
+      else {
+        if (m_cache)
+          g_cacheMisses.add();
+        loadThumbnail(thumbnailImage, palette);
+        if (thumbnailImage && m_cache && !m_fop->isStop())
+          m_cache->save(m_fop->filename(), thumbnailImage.get(), palette.get());
       }
-
-      // Close file
-      delete m_fop->releaseDocument();
 
       // Set the thumbnail of the file-item.
       if (thumbnailImage) {
@@ -186,6 +164,11 @@ private:
       if (m_item.fileitem->needThumbnail())
         m_item.fileitem->setThumbnail(nullptr);
     }
+    else if (m_item.fileitem->needThumbnail()) {
+      // Reset the progress of canceled thumbnails so they can be
+      // requested again (e.g. when the item is visible again).
+      m_item.fileitem->setThumbnailProgress(0.0);
+    }
 
     // Reset the m_item (first the fileitem so this worker is not
     // associated to this fileitem anymore, and then the FileOp).
@@ -204,31 +187,101 @@ private:
     ASSERT(!m_fop);
   }
 
+  // Loads the file and renders its first frame in a thumbnail image
+  void loadThumbnail(std::unique_ptr<Image>& thumbnailImage, std::unique_ptr<Palette>& palette)
+  {
+    THUMB_TRACE("FOP loading thumbnail: %s\n", m_item.fileitem->fileName().c_str());
+
+    // Load the file
+    m_fop->operate(nullptr);
+
+    // Don't call post-load because postLoad() needs user interaction.
+    // m_fop->postLoad();
+
+    // Convert the loaded document into the os::Surface.
+    const Sprite* sprite =
+      (m_fop->document() && m_fop->document()->sprite() ? m_fop->document()->sprite() : nullptr);
+
+    if (!m_fop->isStop() && sprite) {
+      // The palette to convert the Image
+      palette.reset(new Palette(*sprite->palette(frame_t(0))));
+
+      // Special case for indexed images:
+      // If the sprite is transparent -> set the transparent color index alpha = 0
+      if (sprite->colorMode() == ColorMode::INDEXED && !sprite->backgroundLayer()) {
+        int i = sprite->transparentColor();
+        if (i >= 0 && i < int(palette->size()))
+          palette->setEntry(i, doc::rgba(0, 0, 0, 0));
+      }
+
+      const int w = sprite->width() * sprite->pixelRatio().w;
+      const int h = sprite->height() * sprite->pixelRatio().h;
+
+      // Calculate the thumbnail size
+      int thumb_w = MAX_THUMBNAIL_SIZE * w / std::max(w, h);
+      int thumb_h = MAX_THUMBNAIL_SIZE * h / std::max(w, h);
+      if (std::max(thumb_w, thumb_h) > std::max(w, h)) {
+        thumb_w = w;
+        thumb_h = h;
+      }
+      thumb_w = std::clamp(thumb_w, 1, MAX_THUMBNAIL_SIZE);
+      thumb_h = std::clamp(thumb_h, 1, MAX_THUMBNAIL_SIZE);
+
+      // Stretch the 'image'
+      thumbnailImage.reset(Image::create(sprite->pixelFormat(), thumb_w, thumb_h));
+
+      render::Projection proj(sprite->pixelRatio(), render::Zoom(thumb_w, w));
+      render::Render render;
+      render.setBgOptions(render::BgOptions::MakeTransparent());
+      render.setProjection(proj);
+      render.renderSprite(thumbnailImage.get(), sprite, frame_t(0), gfx::Clip(0, 0, 0, 0, w, h));
+
+      // Convert the image to sRGB color space
+      auto cs = sprite->colorSpace();
+      if (m_fop->preserveColorProfile() && cs && !cs->nearlyEqual(*gfx::ColorSpace::MakeSRGB())) {
+        app::cmd::convert_color_profile(thumbnailImage.get(),
+                                        palette.get(),
+                                        cs,
+                                        gfx::ColorSpace::MakeSRGB());
+      }
+    }
+
+    // Close file
+    delete m_fop->releaseDocument();
+  }
+
   void loadBgThread()
   {
     base::this_thread::set_name("thumbnails");
 
-    while (!m_queue.empty()) {
-      bool success = true;
-      while (success) {
-        {
-          const std::lock_guard lock(m_mutex); // To access m_item
-          success = m_queue.try_pop(m_item);
-        }
-        if (success)
-          loadItem();
+    // Process the queue of the generator until it's destroyed
+    while (true) {
+      {
+        std::unique_lock queueLock(m_generator->m_queueMutex);
+        m_generator->m_queueCV.wait(queueLock, [this] {
+          return m_generator->m_exit || !m_generator->m_queue.empty();
+        });
+        if (m_generator->m_exit)
+          break;
+
+        const std::lock_guard lock(m_mutex); // To access m_item
+        m_item = m_generator->m_queue.front();
+        m_generator->m_queue.pop_front();
+        m_isBusy = true;
       }
-      base::this_thread::yield();
+
+      loadItem();
+      m_isBusy = false;
     }
-    m_isDone = true;
   }
 
-  base::concurrent_queue<Item>& m_queue;
+  ThumbnailGenerator* m_generator;
+  ThumbnailCache* m_cache;
   app::ThumbnailGenerator::Item m_item;
   FileOp* m_fop;
   mutable std::mutex m_mutex;
-  std::atomic<bool> m_isDone;
-  std::thread m_thread;
+  std::atomic<bool> m_isBusy;
+  BlockingTask m_thread;
 };
 
 ThumbnailGenerator* ThumbnailGenerator::instance()
@@ -246,27 +299,65 @@ ThumbnailGenerator* ThumbnailGenerator::instance()
 
 ThumbnailGenerator::ThumbnailGenerator()
 {
-  int n = std::thread::hardware_concurrency() - 1;
-  if (n < 1)
-    n = 1;
-  m_maxWorkers = n;
+  // Workers are long-lived blocking tasks that wait the file
+  // decoding, they are limited to the cores used by the task
+  // scheduler.
+  m_maxWorkers = std::max(1, TaskScheduler::instance()->threads() - 1);
+
+  // Disk cache of thumbnails (0 to disable it)
+  const int cacheSize = Preferences::instance().fileSelector.thumbnailCacheSize();
+  if (cacheSize > 0) {
+    ResourceFinder rf;
+    rf.includeUserDir(base::join_path("thumbnails", ".").c_str());
+    m_cache = std::make_unique<ThumbnailCache>(rf.getFirstOrCreateDefault(),
+                                               std::size_t(cacheSize) * 1024 * 1024);
+  }
 }
 
-bool ThumbnailGenerator::checkWorkers()
+ThumbnailGenerator::~ThumbnailGenerator()
 {
-  const std::lock_guard lock(m_workersAccess);
-  bool doingWork = (!m_workers.empty());
+  {
+    const std::lock_guard lock(m_queueMutex);
+    for (Item& item : m_queue)
+      delete item.fop;
+    m_queue.clear();
+    m_exit = true;
+  }
+  m_queueCV.notify_all();
 
-  for (WorkerList::iterator it = m_workers.begin(); it != m_workers.end();) {
-    (*it)->updateProgress();
-    if ((*it)->isDone()) {
-      it = m_workers.erase(it);
-    }
-    else {
-      ++it;
+  // Join all workers before the cache is destroyed
+  {
+    const std::lock_guard lock(m_workersAccess);
+    for (const auto& worker : m_workers)
+      worker->stop();
+  }
+  m_workers.clear();
+}
+
+bool ThumbnailGenerator::checkWorkers()
+{
+  bool working;
+  {
+    const std::lock_guard lock(m_queueMutex);
+    working = !m_queue.empty();
+  }
+  {
+    const std::lock_guard lock(m_workersAccess);
+    for (const auto& worker : m_workers) {
+      worker->updateProgress();
+      if (worker->isBusy())
+        working = true;
     }
   }
 
+  // Save the cache index when all thumbnails are generated
+  if (!working && m_wasWorking && m_cache)
+    m_cache->flush();
+
+  // Returns true one more time when the work is done so the last
+  // thumbnails are painted.
+  const bool doingWork = (working || m_wasWorking);
+  m_wasWorking = working;
   return doingWork;
 }
 
@@ -277,22 +368,15 @@ void ThumbnailGenerator::generateThumbnail(IFileItem* fileitem)
 
   if (fileitem->getThumbnailProgress() > 0.0) {
     if (fileitem->getThumbnailProgress() == 0.00001) {
-      m_remainingItems.prioritize(
-        [fileitem](const Item& item) { return (item.fileitem == fileitem); });
-
-      // If there is no more workers running, we have to start a new
-      // one to process the m_remainingItems queue. How is it possible
-      // that a IFileItem has a thumbnail progress == 0.00001 but
-      // there is no workers?  This is an edge case where:
-      // 1. The Worker::loadBgThread() asks for the queue of remaining items
-      //    and it's empty, so the thread is going to be closed
-      // 2. We've just created a FOP for this IFileItem and ask for
-      //    available workers and we've already launch the max quantity
-      //    of possible workers (m_maxWorkers)
-      // 3. All worker threads are just closed so there is no more
-      //    worker for the remaining item in the queue.
-      if (m_workers.empty())
-        startWorker();
+      const std::lock_guard lock(m_queueMutex);
+      auto it = std::find_if(m_queue.begin(), m_queue.end(), [fileitem](const Item& item) {
+        return (item.fileitem == fileitem);
+      });
+      if (it != m_queue.end() && it != m_queue.begin()) {
+        const Item item = *it;
+        m_queue.erase(it);
+        m_queue.push_front(item);
+      }
     }
     return;
   }
@@ -305,7 +389,8 @@ void ThumbnailGenerator::generateThumbnail(IFileItem* fileitem)
   std::unique_ptr<FileOp> fop(
     FileOp::createLoadDocumentOperation(nullptr,
                                         fileitem->fileName().c_str(),
-                                        FILE_LOAD_SEQUENCE_NONE | FILE_LOAD_ONE_FRAME));
+                                        FILE_LOAD_SEQUENCE_NONE | FILE_LOAD_ONE_FRAME |
+                                          FILE_LOAD_PREVIEW));
   if (!fop || fop->hasError()) {
     // Set a nullptr thumbnail so we don't try to generate a thumbnail
     // for this fileitem again.
@@ -313,17 +398,22 @@ void ThumbnailGenerator::generateThumbnail(IFileItem* fileitem)
     return;
   }
 
-  m_remainingItems.push(Item(fileitem, fop.get()));
+  {
+    const std::lock_guard lock(m_queueMutex);
+    m_queue.push_back(Item(fileitem, fop.get()));
+    g_queueDepth.add(int64_t(m_queue.size()));
+  }
   fop.release();
+  m_queueCV.notify_one();
 
   startWorker();
 }
 
 void ThumbnailGenerator::stopAllWorkers()
 {
-  Item item;
-  while (!m_remainingItems.empty()) {
-    while (m_remainingItems.try_pop(item)) {
+  {
+    const std::lock_guard lock(m_queueMutex);
+    for (Item& item : m_queue) {
       if (!item.fileitem->getThumbnail()) {
         // Reset progress to 0.0 because the FileOp wasn't used and we
         // will need to create it again if we require this FileItem
@@ -332,6 +422,7 @@ void ThumbnailGenerator::stopAllWorkers()
       }
       delete item.fop;
     }
+    m_queue.clear();
   }
 
   const std::lock_guard lock(m_workersAccess);
@@ -339,11 +430,34 @@ void ThumbnailGenerator::stopAllWorkers()
     worker->stop();
 }
 
+void ThumbnailGenerator::setVisibleItems(const std::vector<IFileItem*>& fileitems)
+{
+  const std::set<IFileItem*> visible(fileitems.begin(), fileitems.end());
+  {
+    const std::lock_guard lock(m_queueMutex);
+    for (auto it = m_queue.begin(); it != m_queue.end();) {
+      if (visible.find(it->fileitem) != visible.end()) {
+        ++it;
+        continue;
+      }
+      // Same as stopAllWorkers(), the thumbnail will be requested
+      // again when the item is visible.
+      it->fileitem->setThumbnailProgress(0.0);
+      delete it->fop;
+      it = m_queue.erase(it);
+    }
+  }
+
+  const std::lock_guard lock(m_workersAccess);
+  for (const auto& worker : m_workers)
+    worker->stopIfNotIn(visible);
+}
+
 void ThumbnailGenerator::startWorker()
 {
   const std::lock_guard lock(m_workersAccess);
   if (m_workers.size() < m_maxWorkers) {
-    m_workers.push_back(std::make_unique<Worker>(m_remainingItems));
+    m_workers.push_back(std::make_unique<Worker>(this));
   }
 }
 
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2022  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -9,33 +9,31 @@
 #define APP_THUMBNAIL_GENERATOR_H_INCLUDED
 #pragma once
 
-#include "base/concurrent_queue.h"
-
+#include <condition_variable>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <vector>
 
-namespace base {
-class thread;
-}
-
 namespace app {
 class FileOp;
 class IFileItem;
+class ThumbnailCache;
 
 class ThumbnailGenerator {
   ThumbnailGenerator();
 
 public:
+  ~ThumbnailGenerator();
+
   static ThumbnailGenerator* instance();
 
   // Generate a thumbnail for the given file-item.  It must be called
   // from the GUI thread.
   void generateThumbnail(IFileItem* fileitem);
 
-  // Checks the status of workers. If there are workers that already
-  // done its job, we've to destroy them. This function must be called
-  // from the GUI thread (because a thread is joint to it).
+  // Checks the status of workers and updates the progress of the
+  // file-items. This function must be called from the GUI thread.
   // Returns true if there are workers generating thumbnails.
   bool checkWorkers();
 
@@ -44,6 +42,12 @@ public:
   // thread.
   void stopAllWorkers();
 
+  // Cancels the thumbnails of file-items that aren't in the given
+  // list (e.g. items that aren't visible anymore in the FileList
+  // after scrolling). Canceled thumbnails can be requested again with
+  // generateThumbnail().
+  void setVisibleItems(const std::vector<IFileItem*>& fileitems);
+
 private:
   void startWorker();
 
@@ -60,9 +64,21 @@ private:
   };
 
   int m_maxWorkers;
+  std::unique_ptr<ThumbnailCache> m_cache;
+  // Workers are created on demand (up to m_maxWorkers) and reused
+  // until the generator is destroyed.
   WorkerList m_workers;
   std::mutex m_workersAccess;
-  base::concurrent_queue<Item> m_remainingItems;
+
+  // Items waiting for a worker (the first ones are generated first)
+  std::deque<Item> m_queue;
+  std::mutex m_queueMutex;
+  std::condition_variable m_queueCV;
+  bool m_exit = false;
+
+  // True if workers were generating thumbnails in the last
+  // checkWorkers() call.
+  bool m_wasWorking = false;
 };
 
 } // namespace app
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2018  David Capello
 // Copyright (C) 2016  Carlo Caputo
 //
@@ -10,56 +10,70 @@
   #include "config.h"
 #endif
 
+#include "app/thumbnails.h"
+
 #include "app/color_spaces.h"
+#include "app/task_scheduler.h"
 #include "app/util/conversion_to_surface.h"
 #include "doc/blend_mode.h"
 #include "doc/cel.h"
 #include "doc/layer.h"
+#include "doc/layer_tilemap.h"
+#include "doc/palette.h"
 #include "doc/sprite.h"
+#include "doc/tileset.h"
 #include "os/surface.h"
 #include "os/system.h"
 #include "render/render.h"
+#include "ui/system.h"
+
+#include <algorithm>
 
 namespace app { namespace thumb {
 
-os::SurfaceRef get_cel_thumbnail(ui::Display* display,
-                                 const doc::Cel* cel,
-                                 const bool scaleUpToFit,
-                                 const gfx::Size& fitInSize)
-{
-  gfx::Size newSize;
+namespace {
+
+// Maximum number of cached thumbnails and of thumbnails that can be
+// rendered in background at the same time (the rest are requested
+// again in the next paint).
+constexpr int kMaxThumbnails = 2048;
+constexpr int kMaxPendingThumbnails = 64;
 
+gfx::Size thumbnail_size(const doc::Cel* cel, const bool scaleUpToFit, const gfx::Size& fitInSize)
+{
   if (scaleUpToFit || cel->bounds().w > fitInSize.w || cel->bounds().h > fitInSize.h)
-    newSize = gfx::Rect(cel->bounds()).fitIn(gfx::Rect(fitInSize)).size();
+    return gfx::Rect(cel->bounds()).fitIn(gfx::Rect(fitInSize)).size();
   else
-    newSize = cel->bounds().size();
+    return cel->bounds().size();
+}
 
-  if (newSize.w < 1 || newSize.h < 1)
-    return nullptr;
+// [thread-safe] Renders the thumbnail of a cel image that isn't a
+// tilemap (so we don't need the sprite to render it).
+doc::ImageRef render_thumbnail_image(const doc::Image* image,
+                                     const doc::Palette* palette,
+                                     const doc::PixelRatio& pixelRatio,
+                                     const gfx::Size& newSize)
+{
+  ASSERT(!image->isTilemap());
 
   doc::ImageRef thumbnailImage(doc::Image::create(doc::IMAGE_RGB, newSize.w, newSize.h));
+  thumbnailImage->clear(0);
 
   render::Render render;
-  render::Projection proj(cel->sprite()->pixelRatio(), render::Zoom(newSize.w, cel->bounds().w));
+  render::Projection proj(pixelRatio, render::Zoom(newSize.w, image->width()));
   render.setProjection(proj);
+  render.renderImage(thumbnailImage.get(), image, palette, 0, 0, 255, doc::BlendMode::NORMAL);
+  return thumbnailImage;
+}
 
-  const doc::Palette* palette = cel->sprite()->palette(cel->frame());
-  render.renderCel(thumbnailImage.get(),
-                   cel,
-                   cel->sprite(),
-                   cel->image(),
-                   cel->layer(),
-                   palette,
-                   gfx::Rect(gfx::Point(0, 0), cel->bounds().size()),
-                   gfx::Clip(gfx::Rect(gfx::Point(0, 0), newSize)),
-                   255,
-                   doc::BlendMode::NORMAL);
-
-  if (os::SurfaceRef thumbnail = os::System::instance()->makeRgbaSurface(
-        thumbnailImage->width(),
-        thumbnailImage->height(),
-        get_current_color_space(display))) {
-    convert_image_to_surface(thumbnailImage.get(),
+os::SurfaceRef make_thumbnail_surface(const os::ColorSpaceRef& colorSpace,
+                                      const doc::Image* thumbnailImage,
+                                      const doc::Palette* palette)
+{
+  if (os::SurfaceRef thumbnail = os::System::instance()->makeRgbaSurface(thumbnailImage->width(),
+                                                                         thumbnailImage->height(),
+                                                                         colorSpace)) {
+    convert_image_to_surface(thumbnailImage,
                              palette,
                              thumbnail.get(),
                              0,
@@ -74,4 +88,193 @@ os::SurfaceRef get_cel_thumbnail(ui::Display* display,
     return nullptr;
 }
 
+} // anonymous namespace
+
+os::SurfaceRef get_cel_thumbnail(ui::Display* display,
+                                 const doc::Cel* cel,
+                                 const bool scaleUpToFit,
+                                 const gfx::Size& fitInSize)
+{
+  const gfx::Size newSize = thumbnail_size(cel, scaleUpToFit, fitInSize);
+  if (newSize.w < 1 || newSize.h < 1)
+    return nullptr;
+
+  const doc::Palette* palette = cel->sprite()->palette(cel->frame());
+  doc::ImageRef thumbnailImage;
+
+  if (cel->layer()->isTilemap()) {
+    thumbnailImage.reset(doc::Image::create(doc::IMAGE_RGB, newSize.w, newSize.h));
+
+    render::Render render;
+    render::Projection proj(cel->sprite()->pixelRatio(),
+                            render::Zoom(newSize.w, cel->bounds().w));
+    render.setProjection(proj);
+    render.renderCel(thumbnailImage.get(),
+                     cel,
+                     cel->sprite(),
+                     cel->image(),
+                     cel->layer(),
+                     palette,
+                     gfx::Rect(gfx::Point(0, 0), cel->bounds().size()),
+                     gfx::Clip(gfx::Rect(gfx::Point(0, 0), newSize)),
+                     255,
+                     doc::BlendMode::NORMAL);
+  }
+  else {
+    thumbnailImage =
+      render_thumbnail_image(cel->image(), palette, cel->sprite()->pixelRatio(), newSize);
+  }
+
+  return make_thumbnail_surface(get_current_color_space(display), thumbnailImage.get(), palette);
+}
+
+bool CelThumbnails::Key::operator<(const Key& other) const
+{
+  if (celId != other.celId)
+    return celId < other.celId;
+  if (size.w != other.size.w)
+    return size.w < other.size.w;
+  if (size.h != other.size.h)
+    return size.h < other.size.h;
+  return scaleUpToFit < other.scaleUpToFit;
+}
+
+bool CelThumbnails::Stamp::operator==(const Stamp& other) const
+{
+  return (imageId == other.imageId && imageVersion == other.imageVersion &&
+          paletteId == other.paletteId && paletteVersion == other.paletteVersion &&
+          tilesetVersion == other.tilesetVersion && celSize == other.celSize);
+}
+
+CelThumbnails::CelThumbnails() : m_self(std::make_shared<CelThumbnails*>(this))
+{
+}
+
+CelThumbnails::~CelThumbnails()
+{
+  // Results of pending tasks will be discarded
+  m_self.reset();
+}
+
+os::SurfaceRef CelThumbnails::get(ui::Display* display,
+                                  const doc::Cel* cel,
+                                  const bool scaleUpToFit,
+                                  const gfx::Size& fitInSize)
+{
+  ASSERT(ui::is_ui_thread());
+
+  const gfx::Size newSize = thumbnail_size(cel, scaleUpToFit, fitInSize);
+  if (newSize.w < 1 || newSize.h < 1)
+    return nullptr;
+
+  const doc::Image* image = cel->image();
+  const doc::Palette* palette = cel->sprite()->palette(cel->frame());
+
+  Stamp stamp;
+  stamp.imageId = image->id();
+  stamp.imageVersion = image->version();
+  stamp.paletteId = palette->id();
+  stamp.paletteVersion = palette->version();
+  stamp.celSize = cel->bounds().size();
+  if (cel->layer()->isTilemap()) {
+    auto tilemapLayer = static_cast<const doc::LayerTilemap*>(cel->layer());
+    stamp.tilesetVersion = tilemapLayer->tileset()->version();
+  }
+
+  const Key key{ cel->id(), fitInSize, scaleUpToFit };
+  auto it = m_entries.find(key);
+  if (it != m_entries.end()) {
+    Entry& entry = it->second;
+    entry.tick = ++m_tick;
+    if (entry.stamp == stamp) {
+      // Keep the old thumbnail (if any) as a placeholder until the
+      // new one is rendered.
+      return entry.surface;
+    }
+  }
+  else {
+    if (int(m_entries.size()) >= kMaxThumbnails)
+      removeLeastRecentlyUsed();
+    it = m_entries.insert(std::make_pair(key, Entry())).first;
+    it->second.tick = ++m_tick;
+  }
+
+  Entry& entry = it->second;
+
+  // Tilemaps are rendered from the UI thread as we need their
+  // tilesets (which could be modified in the meantime).
+  if (cel->layer()->isTilemap()) {
+    entry.stamp = stamp;
+    entry.surface = get_cel_thumbnail(display, cel, scaleUpToFit, fitInSize);
+    entry.pending = false;
+    return entry.surface;
+  }
+
+  if (m_pending >= kMaxPendingThumbnails)
+    return entry.surface;
+
+  entry.stamp = stamp;
+  entry.pending = true;
+  ++m_pending;
+
+  // The image is kept alive by the task, and the palette is copied as
+  // the original one could be modified or deleted. If the image is
+  // modified in the meantime, its version will change and the
+  // thumbnail will be rendered again.
+  doc::ImageRef imageRef = cel->imageRef();
+  std::shared_ptr<doc::Palette> paletteCopy = std::make_shared<doc::Palette>(*palette);
+  const doc::PixelRatio pixelRatio = cel->sprite()->pixelRatio();
+  os::ColorSpaceRef colorSpace = get_current_color_space(display);
+  std::weak_ptr<CelThumbnails*> weak = m_self;
+
+  TaskScheduler::instance()->execute([weak,
+                                      key,
+                                      stamp,
+                                      imageRef,
+                                      paletteCopy,
+                                      pixelRatio,
+                                      newSize,
+                                      colorSpace] {
+    doc::ImageRef thumbnailImage =
+      render_thumbnail_image(imageRef.get(), paletteCopy.get(), pixelRatio, newSize);
+
+    ui::execute_from_ui_thread([weak, key, stamp, thumbnailImage, paletteCopy, colorSpace] {
+      std::shared_ptr<CelThumbnails*> self = weak.lock();
+      if (!self)
+        return;
+
+      CelThumbnails* thumbnails = *self;
+      --thumbnails->m_pending;
+
+      // Discard the thumbnail if the cel was modified in the meantime
+      auto it = thumbnails->m_entries.find(key);
+      if (it == thumbnails->m_entries.end() || !it->second.pending || !(it->second.stamp == stamp))
+        return;
+
+      it->second.surface =
+        make_thumbnail_surface(colorSpace, thumbnailImage.get(), paletteCopy.get());
+      it->second.pending = false;
+      thumbnails->ThumbnailReady();
+    });
+  });
+
+  return entry.surface;
+}
+
+void CelThumbnails::clear()
+{
+  m_entries.clear();
+}
+
+void CelThumbnails::removeLeastRecentlyUsed()
+{
+  auto lru = m_entries.end();
+  for (auto it = m_entries.begin(); it != m_entries.end(); ++it) {
+    if (!it->second.pending && (lru == m_entries.end() || it->second.tick < lru->second.tick))
+      lru = it;
+  }
+  if (lru != m_entries.end())
+    m_entries.erase(lru);
+}
+
 }} // namespace app::thumb
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2016  Carlo Caputo
 //
 // This program is distributed under the terms of
@@ -9,10 +9,17 @@
 #define APP_THUMBNAILS_H_INCLUDED
 #pragma once
 
+#include "doc/object_id.h"
+#include "doc/object_version.h"
 #include "gfx/size.h"
+#include "obs/signal.h"
 #include "os/surface.h"
 #include "ui/display.h"
 
+#include <cstdint>
+#include <map>
+#include <memory>
+
 namespace doc {
 class Cel;
 }
@@ -28,6 +35,63 @@ os::SurfaceRef get_cel_thumbnail(ui::Display* display,
                                  const bool scaleUpToFit,
                                  const gfx::Size& fitInSize);
 
+// Cache of cel thumbnails (e.g. for the timeline). Thumbnails are
+// identified by the cel and the requested size, and are rendered
+// again when the cel image (or its palette) changes. Thumbnails of
+// image layers are rendered in background threads, so get() returns
+// nullptr until the thumbnail is ready (the ThumbnailReady signal is
+// generated from the UI thread in that moment).
+class CelThumbnails {
+public:
+  CelThumbnails();
+  ~CelThumbnails();
+
+  os::SurfaceRef get(ui::Display* display,
+                     const doc::Cel* cel,
+                     const bool scaleUpToFit,
+                     const gfx::Size& fitInSize);
+
+  void clear();
+
+  obs::signal<void()> ThumbnailReady;
+
+private:
+  struct Key {
+    doc::ObjectId celId;
+    gfx::Size size;
+    bool scaleUpToFit;
+    bool operator<(const Key& other) const;
+  };
+
+  // Information of the cel used to render a thumbnail, the thumbnail
+  // is rendered again if something changes.
+  struct Stamp {
+    doc::ObjectId imageId = doc::NullId;
+    doc::ObjectVersion imageVersion = 0;
+    doc::ObjectId paletteId = doc::NullId;
+    doc::ObjectVersion paletteVersion = 0;
+    doc::ObjectVersion tilesetVersion = 0;
+    gfx::Size celSize;
+    bool operator==(const Stamp& other) const;
+  };
+
+  struct Entry {
+    Stamp stamp;
+    os::SurfaceRef surface;
+    bool pending = false;
+    uint64_t tick = 0;
+  };
+
+  void removeLeastRecentlyUsed();
+
+  std::map<Key, Entry> m_entries;
+  uint64_t m_tick = 0;
+  int m_pending = 0;
+
+  // Used by background tasks to know if this cache still exists.
+  std::shared_ptr<CelThumbnails*> m_self;
+};
+
 }} // namespace app::thumb
 
 #endif
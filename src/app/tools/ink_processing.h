@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -23,6 +23,9 @@
 #include "render/dithering.h"
 #include "render/gradient.h"
 
+#include <algorithm>
+#include <vector>
+
 namespace app { namespace tools {
 
 using namespace gfx;
@@ -92,8 +95,16 @@ public:
       }
     }
 
+    static_cast<Derived*>(this)->processSpan(loop, x1, y, x2);
+  }
+
+  // Processes all pixels in the [x1, x2] span of the "y" scanline
+  // (when there is no mask). Inks that paint the same value in all
+  // pixels can hide this function to fill the whole span at once.
+  void processSpan(ToolLoop* loop, int x1, int y, int x2)
+  {
     static_cast<Derived*>(this)->initIterators(loop, x1, y);
-    for (x = x1; x <= x2; ++x) {
+    for (int x = x1; x <= x2; ++x) {
       static_cast<Derived*>(this)->processPixel(x, y);
       static_cast<Derived*>(this)->moveIterators();
     }
@@ -161,6 +172,14 @@ public:
 
   void processPixel(int x, int y) { *this->m_dstAddress = m_color; }
 
+  void processSpan(ToolLoop* loop, int x1, int y, int x2)
+  {
+    this->initIterators(loop, x1, y);
+    std::fill_n(this->m_dstAddress,
+                x2 - x1 + 1,
+                typename ImageTraits::pixel_t(m_color));
+  }
+
 private:
   color_t m_color;
 };
@@ -366,6 +385,11 @@ public:
     // Do nothing
   }
 
+  void processSpan(ToolLoop* loop, int x1, int y, int x2)
+  {
+    InkProcessing<MergeInkProcessing<ImageTraits>>::processSpan(loop, x1, y, x2);
+  }
+
 private:
   color_t m_color;
   int m_opacity;
@@ -377,12 +401,26 @@ void MergeInkProcessing<RgbTraits>::processPixel(int x, int y)
   *m_dstAddress = rgba_blender_merge(*m_srcAddress, m_color, m_opacity);
 }
 
+template<>
+void MergeInkProcessing<RgbTraits>::processSpan(ToolLoop* loop, int x1, int y, int x2)
+{
+  initIterators(loop, x1, y);
+  rgba_merge_span(m_dstAddress, m_srcAddress, m_color, x2 - x1 + 1, m_opacity);
+}
+
 template<>
 void MergeInkProcessing<GrayscaleTraits>::processPixel(int x, int y)
 {
   *m_dstAddress = graya_blender_merge(*m_srcAddress, m_color, m_opacity);
 }
 
+template<>
+void MergeInkProcessing<GrayscaleTraits>::processSpan(ToolLoop* loop, int x1, int y, int x2)
+{
+  initIterators(loop, x1, y);
+  graya_merge_span(m_dstAddress, m_srcAddress, m_color, x2 - x1 + 1, m_opacity);
+}
+
 template<>
 class MergeInkProcessing<IndexedTraits>
   : public DoubleInkProcessing<MergeInkProcessing<IndexedTraits>, IndexedTraits> {
@@ -470,7 +508,75 @@ public:
     }
   }
 
+  // Pixels where the whole 3x3 matrix is inside the source image are
+  // processed by rows: first the blurred colors of all pixels are
+  // calculated from the sums of each column, and then they are
+  // merged with rgba_merge_span(). The other pixels (borders of the
+  // image, with or without tiled mode) are processed pixel by pixel.
+  void processSpan(ToolLoop* loop, int x1, int y, int x2)
+  {
+    const int u1 = std::max(x1, 1);
+    const int u2 = std::min(x2, m_srcImage->width() - 2);
+    if (y < 1 || y > m_srcImage->height() - 2 || u1 > u2) {
+      Base::processSpan(loop, x1, y, x2);
+      return;
+    }
+    if (x1 < u1)
+      Base::processSpan(loop, x1, y, u1 - 1);
+
+    const int n = u2 - u1 + 1;
+    m_columns.resize(n + 2);
+    m_blurred.resize(n);
+
+    // Sums of the 3 pixels of each column (from u1-1 to u2+1)
+    const RgbTraits::pixel_t* rows[3];
+    for (int i = 0; i < 3; ++i)
+      rows[i] = (const RgbTraits::pixel_t*)m_srcImage->getPixelAddress(u1 - 1, y - 1 + i);
+    for (int i = 0; i < n + 2; ++i) {
+      ColumnSums& col = m_columns[i];
+      col.reset();
+      for (const RgbTraits::pixel_t* row : rows)
+        col(row[i]);
+    }
+
+    // The sums of 3 columns are the pixels of the 3x3 matrix
+    const RgbTraits::pixel_t* src = rows[1] + 1;
+    bool someEmpty = false;
+    for (int i = 0; i < n; ++i) {
+      const ColumnSums& a = m_columns[i];
+      const ColumnSums& b = m_columns[i + 1];
+      const ColumnSums& c = m_columns[i + 2];
+      const int count = a.count + b.count + c.count;
+      if (count > 0) {
+        m_blurred[i] = doc::rgba((a.r + b.r + c.r) / count,
+                                 (a.g + b.g + c.g) / count,
+                                 (a.b + b.b + c.b) / count,
+                                 (a.a + b.a + c.a) / 9);
+      }
+      else {
+        // This pixel is copied from the source image later
+        m_blurred[i] = src[i];
+        someEmpty = true;
+      }
+    }
+
+    RgbTraits::address_t dst = (RgbTraits::address_t)loop->getDstImage()->getPixelAddress(u1, y);
+    rgba_merge_span(dst, src, m_blurred.data(), n, m_opacity);
+
+    if (someEmpty) {
+      for (int i = 0; i < n; ++i) {
+        if (m_columns[i].count + m_columns[i + 1].count + m_columns[i + 2].count == 0)
+          dst[i] = src[i];
+      }
+    }
+
+    if (u2 < x2)
+      Base::processSpan(loop, u2 + 1, y, x2);
+  }
+
 private:
+  using Base = InkProcessing<BlurInkProcessing<RgbTraits>>;
+
   struct GetPixelsDelegate {
     int count, r, g, b, a;
 
@@ -487,11 +593,14 @@ private:
       }
     }
   };
+  using ColumnSums = GetPixelsDelegate;
 
   int m_opacity;
   TiledMode m_tiledMode;
   const Image* m_srcImage;
   GetPixelsDelegate m_area;
+  std::vector<ColumnSums> m_columns;
+  std::vector<RgbTraits::pixel_t> m_blurred;
 };
 
 template<>
@@ -520,7 +629,67 @@ public:
     }
   }
 
+  // Same as BlurInkProcessing<RgbTraits>::processSpan()
+  void processSpan(ToolLoop* loop, int x1, int y, int x2)
+  {
+    const int u1 = std::max(x1, 1);
+    const int u2 = std::min(x2, m_srcImage->width() - 2);
+    if (y < 1 || y > m_srcImage->height() - 2 || u1 > u2) {
+      Base::processSpan(loop, x1, y, x2);
+      return;
+    }
+    if (x1 < u1)
+      Base::processSpan(loop, x1, y, u1 - 1);
+
+    const int n = u2 - u1 + 1;
+    m_columns.resize(n + 2);
+    m_blurred.resize(n);
+
+    const GrayscaleTraits::pixel_t* rows[3];
+    for (int i = 0; i < 3; ++i)
+      rows[i] = (const GrayscaleTraits::pixel_t*)m_srcImage->getPixelAddress(u1 - 1, y - 1 + i);
+    for (int i = 0; i < n + 2; ++i) {
+      ColumnSums& col = m_columns[i];
+      col.reset();
+      for (const GrayscaleTraits::pixel_t* row : rows)
+        col(row[i]);
+    }
+
+    const GrayscaleTraits::pixel_t* src = rows[1] + 1;
+    bool someEmpty = false;
+    for (int i = 0; i < n; ++i) {
+      const ColumnSums& a = m_columns[i];
+      const ColumnSums& b = m_columns[i + 1];
+      const ColumnSums& c = m_columns[i + 2];
+      const int count = a.count + b.count + c.count;
+      if (count > 0) {
+        m_blurred[i] = GrayscaleTraits::pixel_t(
+          graya((a.v + b.v + c.v) / count, (a.a + b.a + c.a) / 9));
+      }
+      else {
+        m_blurred[i] = src[i];
+        someEmpty = true;
+      }
+    }
+
+    GrayscaleTraits::address_t dst =
+      (GrayscaleTraits::address_t)loop->getDstImage()->getPixelAddress(u1, y);
+    graya_merge_span(dst, src, m_blurred.data(), n, m_opacity);
+
+    if (someEmpty) {
+      for (int i = 0; i < n; ++i) {
+        if (m_columns[i].count + m_columns[i + 1].count + m_columns[i + 2].count == 0)
+          dst[i] = src[i];
+      }
+    }
+
+    if (u2 < x2)
+      Base::processSpan(loop, u2 + 1, y, x2);
+  }
+
 private:
+  using Base = InkProcessing<BlurInkProcessing<GrayscaleTraits>>;
+
   struct GetPixelsDelegate {
     int count, v, a;
 
@@ -535,11 +704,14 @@ private:
       }
     }
   };
+  using ColumnSums = GetPixelsDelegate;
 
   int m_opacity;
   TiledMode m_tiledMode;
   const Image* m_srcImage;
   GetPixelsDelegate m_area;
+  std::vector<ColumnSums> m_columns;
+  std::vector<GrayscaleTraits::pixel_t> m_blurred;
 };
 
 template<>
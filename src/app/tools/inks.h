@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2024  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -15,6 +15,7 @@
 #include "app/tools/pick_ink.h"
 #include "app/transformation.h"
 #include "doc/mask.h"
+#include "doc/mask_runs.h"
 #include "doc/tile.h"
 #include "gfx/region.h"
 
@@ -428,8 +429,9 @@ public:
 class SelectionInk : public BaseInk {
   bool m_modify_selection;
   Mask m_mask;
-  Mask m_intersectMask;
-  Rect m_maxBounds;
+  // Spans painted in the final step. They are applied to m_mask at
+  // the end, so we don't need a bitmap of the whole sprite.
+  MaskRuns m_runs;
 
 public:
   SelectionInk() : m_modify_selection(false) {}
@@ -447,20 +449,7 @@ public:
     gfx::Rect rc(BaseInk::tileSelectionToCanvas(x1, y, x2, loop, !m_modify_selection));
 
     if (m_modify_selection) {
-      int modifiers = int(loop->getModifiers());
-
-      if ((modifiers & (int(ToolLoopModifiers::kReplaceSelection) |
-                        int(ToolLoopModifiers::kAddSelection))) != 0) {
-        m_mask.add(rc);
-      }
-      else if ((modifiers & int(ToolLoopModifiers::kSubtractSelection)) != 0) {
-        m_mask.subtract(rc);
-      }
-      else if ((modifiers & int(ToolLoopModifiers::kIntersectSelection)) != 0) {
-        m_intersectMask.add(rc);
-      }
-
-      m_maxBounds |= rc;
+      m_runs.add(rc);
     }
     else {
       if (loop->isSelectionToolLoop()) {
@@ -481,28 +470,21 @@ public:
     int modifiers = int(loop->getModifiers());
 
     if (state) {
-      m_maxBounds = loop->getMask()->bounds();
-
       m_mask.copyFrom(loop->getMask());
-      m_mask.freeze();
-      m_mask.reserve(loop->sprite()->bounds());
-
-      if ((modifiers & int(ToolLoopModifiers::kIntersectSelection)) != 0) {
-        m_intersectMask.clear();
-        m_intersectMask.reserve(loop->sprite()->bounds());
-      }
+      m_runs.clear();
     }
     else {
-      if ((modifiers & int(ToolLoopModifiers::kIntersectSelection)) != 0) {
-        m_mask.intersect(m_intersectMask);
-        m_intersectMask.clear();
+      if ((modifiers & (int(ToolLoopModifiers::kReplaceSelection) |
+                        int(ToolLoopModifiers::kAddSelection))) != 0) {
+        m_mask.add(m_runs);
       }
-
-      // We can intersect the used bounds in inkHline() calls to
-      // reduce the shrink computation.
-      m_mask.intersect(m_maxBounds);
-
-      m_mask.unfreeze();
+      else if ((modifiers & int(ToolLoopModifiers::kSubtractSelection)) != 0) {
+        m_mask.subtract(m_runs);
+      }
+      else if ((modifiers & int(ToolLoopModifiers::kIntersectSelection)) != 0) {
+        m_mask.intersect(m_runs);
+      }
+      m_runs.clear();
 
       loop->setMask(&m_mask);
       const float cornerThick = (loop->isTilemapMode() ? CORNER_THICK_FOR_TILEMAP_MODE :
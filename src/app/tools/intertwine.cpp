@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2020  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -64,17 +64,14 @@ void Intertwine::doPointshapeStrokePt(const Stroke::Pt& pt, ToolLoop* loop)
 {
   Symmetry* symmetry = loop->getSymmetry();
   if (symmetry) {
-    // Convert the point to the sprite position so we can apply the
-    // symmetry transformation.
-    Stroke main_stroke;
-    main_stroke.addPoint(pt);
-
-    Strokes strokes;
-    symmetry->generateStrokes(main_stroke, strokes, loop);
-    for (const auto& stroke : strokes) {
+    // Apply the symmetry transformation to the point (without
+    // allocating strokes, as this is called for each painted point).
+    Symmetry::Points pts;
+    const int n = symmetry->generatePoints(pt, pts, loop);
+    for (int i = 0; i < n; ++i) {
       // We call transformPoint() moving back each point to the cel
       // origin.
-      doTransformPoint(stroke[0], loop);
+      doTransformPoint(pts[i], loop);
     }
   }
   else {
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2021  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -27,6 +27,11 @@ public:
   virtual bool snapByAngle() { return false; }
   virtual void prepareIntertwine(ToolLoop* loop) {}
 
+  // Returns true if joining a stroke with several new points of a
+  // freehand tool paints the same pixels as joining each pair of
+  // consecutive points in separate strokes.
+  virtual bool canJoinSeveralPoints() { return false; }
+
   // The given stroke must be relative to the cel origin.
   virtual void joinStroke(ToolLoop* loop, const Stroke& stroke) = 0;
   virtual void fillStroke(ToolLoop* loop, const Stroke& stroke) = 0;
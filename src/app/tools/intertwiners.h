@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -91,6 +91,10 @@ class IntertwineAsLines : public Intertwine {
 public:
   bool snapByAngle() override { return true; }
 
+  // Duplicated points between lines are discarded, so the result is
+  // the same.
+  bool canJoinSeveralPoints() override { return true; }
+
   void prepareIntertwine(ToolLoop* loop) override { m_firstStroke = true; }
 
   void joinStroke(ToolLoop* loop, const Stroke& stroke) override
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2017  David Capello
 //
 // This program is distributed under the terms of
@@ -14,7 +14,9 @@
 #include "render/gradient.h"
 
 #include <array>
+#include <map>
 #include <memory>
+#include <tuple>
 
 namespace app { namespace tools {
 
@@ -81,10 +83,27 @@ public:
 };
 
 class BrushPointShape : public PointShape {
+  using CompressedImages =
+    std::array<std::shared_ptr<CompressedImage>, int(SymmetryIndex::ELEMENTS)>;
+
+  // Brushes created for the dynamic size/angle in the current stroke
+  // (with their scanlines), so we don't need to generate the same
+  // brush again for each point.
+  struct CachedBrush {
+    BrushRef brush;
+    CompressedImages compressedImages;
+  };
+  using CachedBrushKey = std::tuple<BrushType, int, int>; // type, size, angle
+  static constexpr std::size_t kMaxCachedBrushes = 64;
+
   bool m_firstPoint;
   Brush* m_lastBrush;
   BrushType m_origBrushType;
-  std::array<std::shared_ptr<CompressedImage>, int(SymmetryIndex::ELEMENTS)> m_compressedImages;
+  std::map<CachedBrushKey, CachedBrush> m_cachedBrushes;
+  // Scanlines of m_lastBrush (points to m_brushCompressedImages or
+  // to the compressedImages of an item in m_cachedBrushes).
+  CompressedImages* m_compressedImages;
+  CompressedImages m_brushCompressedImages;
   // For dynamics
   DynamicsOptions m_dynamics;
   bool m_useDynamics;
@@ -99,6 +118,8 @@ public:
     m_firstPoint = true;
     m_lastBrush = nullptr;
     m_origBrushType = loop->getBrush()->type();
+    m_cachedBrushes.clear();
+    m_compressedImages = &m_brushCompressedImages;
 
     m_dynamics = loop->getDynamics();
     m_useDynamics = (m_dynamics.isDynamic() &&
@@ -187,13 +208,14 @@ public:
       if ((brush->size() != size) ||
           (brush->angle() != angle && m_origBrushType != kCircleBrushType) ||
           (m_hasDynamicGradient && pt.gradient != m_lastGradientValue)) {
-        // TODO cache brushes
-        BrushRef newBrush = std::make_shared<Brush>(m_origBrushType, size, angle);
+        BrushRef newBrush;
 
         // Dynamic gradient with dithering
         bool prepareInk = false;
         if (m_hasDynamicGradient && !ink->isEraser() &&
             (m_dynamics.ditheringMatrix.rows() > 1 || m_dynamics.ditheringMatrix.cols() > 1)) {
+          // The dithering modifies the brush image, so it cannot be cached
+          newBrush = std::make_shared<Brush>(m_origBrushType, size, angle);
           convert_bitmap_brush_to_dithering_brush(newBrush.get(),
                                                   loop->sprite()->pixelFormat(),
                                                   m_dynamics.ditheringMatrix,
@@ -202,6 +224,9 @@ public:
                                                   m_primaryColor);
           prepareInk = true;
         }
+        else {
+          newBrush = getCachedBrush(size, angle);
+        }
         m_lastGradientValue = pt.gradient;
 
         loop->setBrush(newBrush);
@@ -214,10 +239,9 @@ public:
       }
     }
 
-    // TODO cache compressed images (or remove them completelly)
     if (m_lastBrush != brush) {
       m_lastBrush = brush;
-      m_compressedImages.fill(nullptr);
+      m_compressedImages = &getCompressedImages(brush);
     }
 
     if (brush->type() == kImageBrushType && does_symmetry_rotate_image(pt.symmetry)) {
@@ -280,9 +304,41 @@ public:
   }
 
 private:
+  BrushRef getCachedBrush(const int size, const int angle)
+  {
+    // The angle of circular brushes is not used
+    const CachedBrushKey key(m_origBrushType,
+                             size,
+                             (m_origBrushType == kCircleBrushType ? 0 : angle));
+    auto it = m_cachedBrushes.find(key);
+    if (it != m_cachedBrushes.end())
+      return it->second.brush;
+
+    if (m_cachedBrushes.size() >= kMaxCachedBrushes) {
+      m_cachedBrushes.clear();
+      // m_compressedImages could point to a removed item
+      m_lastBrush = nullptr;
+      m_compressedImages = &m_brushCompressedImages;
+    }
+
+    CachedBrush& item = m_cachedBrushes[key];
+    item.brush = std::make_shared<Brush>(m_origBrushType, size, angle);
+    return item.brush;
+  }
+
+  CompressedImages& getCompressedImages(const Brush* brush)
+  {
+    for (auto& it : m_cachedBrushes) {
+      if (it.second.brush.get() == brush)
+        return it.second.compressedImages;
+    }
+    m_brushCompressedImages.fill(nullptr);
+    return m_brushCompressedImages;
+  }
+
   CompressedImage& getCompressedImage(doc::SymmetryIndex index)
   {
-    auto& compressPtr = m_compressedImages[int(index)];
+    auto& compressPtr = (*m_compressedImages)[int(index)];
     if (!compressPtr) {
       compressPtr.reset(new CompressedImage(m_lastBrush->getSymmetryImage(index),
                                             m_lastBrush->getSymmetryMask(index),
@@ -325,7 +381,8 @@ public:
       loop->getContiguous(),
       loop->isPixelConnectivityEightConnected(),
       loop,
-      (AlgoHLine)doInkHline);
+      (AlgoHLine)doInkHline,
+      true);
   }
 
   void getModifiedArea(ToolLoop* loop,
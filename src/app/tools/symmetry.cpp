@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2021-2025  Igara Studio S.A.
+// Copyright (C) 2021-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -16,93 +16,106 @@
 
 namespace app { namespace tools {
 
-void Symmetry::generateStrokes(const Stroke& stroke, Strokes& strokes, ToolLoop* loop)
+namespace {
+
+// Each symmetrical stroke/point is calculated from a previous one
+// (the "from" index, where 0 is the original one).
+struct SymmetryStep {
+  int from;
+  doc::SymmetryIndex symmetry;
+  bool isDoubleDiagonalSymmetry;
+};
+
+struct SymmetrySteps {
+  const SymmetryStep* steps;
+  int count;
+};
+
+constexpr SymmetryStep kHorizontalSteps[] = {
+  { 0, doc::SymmetryIndex::FLIPPED_X, false },
+};
+constexpr SymmetryStep kVerticalSteps[] = {
+  { 0, doc::SymmetryIndex::FLIPPED_Y, false },
+};
+constexpr SymmetryStep kBothSteps[] = {
+  { 0, doc::SymmetryIndex::FLIPPED_X,  false },
+  { 0, doc::SymmetryIndex::FLIPPED_Y,  false },
+  { 2, doc::SymmetryIndex::FLIPPED_XY, false },
+};
+constexpr SymmetryStep kRightDiagSteps[] = {
+  { 0, doc::SymmetryIndex::ROT_FLIP_270, false },
+};
+constexpr SymmetryStep kLeftDiagSteps[] = {
+  { 0, doc::SymmetryIndex::ROT_FLIP_90, false },
+};
+constexpr SymmetryStep kBothDiagSteps[] = {
+  { 0, doc::SymmetryIndex::ROT_FLIP_270, false },
+  { 0, doc::SymmetryIndex::ROT_FLIP_90,  false },
+  { 0, doc::SymmetryIndex::FLIPPED_XY,   true  },
+};
+constexpr SymmetryStep kAllSteps[] = {
+  { 0, doc::SymmetryIndex::FLIPPED_X,    false },
+  { 0, doc::SymmetryIndex::FLIPPED_Y,    false },
+  { 2, doc::SymmetryIndex::FLIPPED_XY,   false },
+  { 0, doc::SymmetryIndex::ROT_FLIP_90,  false },
+  { 4, doc::SymmetryIndex::ROTATED_270,  false },
+  { 0, doc::SymmetryIndex::ROT_FLIP_270, false },
+  { 6, doc::SymmetryIndex::ROTATED_90,   false },
+};
+
+template<std::size_t N>
+constexpr SymmetrySteps make_steps(const SymmetryStep (&steps)[N])
 {
-  Stroke stroke2;
-  strokes.push_back(stroke);
-  const gen::SymmetryMode symmetryMode = tools::Symmetry::resolveMode(loop->getSymmetry()->mode());
-  switch (symmetryMode) {
-    case gen::SymmetryMode::NONE: ASSERT(false); break;
-
-    case gen::SymmetryMode::HORIZONTAL:
-      calculateSymmetricalStroke(stroke, stroke2, loop, doc::SymmetryIndex::FLIPPED_X);
-      strokes.push_back(stroke2);
-      break;
-    case gen::SymmetryMode::VERTICAL:
-      calculateSymmetricalStroke(stroke, stroke2, loop, doc::SymmetryIndex::FLIPPED_Y);
-      strokes.push_back(stroke2);
-      break;
-
-    case gen::SymmetryMode::BOTH: {
-      calculateSymmetricalStroke(stroke, stroke2, loop, doc::SymmetryIndex::FLIPPED_X);
-      strokes.push_back(stroke2);
-
-      Stroke stroke3;
-      calculateSymmetricalStroke(stroke, stroke3, loop, doc::SymmetryIndex::FLIPPED_Y);
-      strokes.push_back(stroke3);
-
-      Stroke stroke4;
-      calculateSymmetricalStroke(stroke3, stroke4, loop, doc::SymmetryIndex::FLIPPED_XY);
-      strokes.push_back(stroke4);
-      break;
-    }
-
-    case gen::SymmetryMode::RIGHT_DIAG: {
-      calculateSymmetricalStroke(stroke, stroke2, loop, doc::SymmetryIndex::ROT_FLIP_270);
-      strokes.push_back(stroke2);
-      break;
-    }
-
-    case gen::SymmetryMode::LEFT_DIAG: {
-      calculateSymmetricalStroke(stroke, stroke2, loop, doc::SymmetryIndex::ROT_FLIP_90);
-      strokes.push_back(stroke2);
-      break;
-    }
-
-    case gen::SymmetryMode::BOTH_DIAG: {
-      calculateSymmetricalStroke(stroke, stroke2, loop, doc::SymmetryIndex::ROT_FLIP_270);
-      strokes.push_back(stroke2);
-
-      Stroke stroke3;
-      calculateSymmetricalStroke(stroke, stroke3, loop, doc::SymmetryIndex::ROT_FLIP_90);
-      strokes.push_back(stroke3);
-
-      Stroke stroke4;
-      calculateSymmetricalStroke(stroke, stroke4, loop, doc::SymmetryIndex::FLIPPED_XY, true);
-      strokes.push_back(stroke4);
-      break;
-    }
-
-    case gen::SymmetryMode::ALL: {
-      calculateSymmetricalStroke(stroke, stroke2, loop, doc::SymmetryIndex::FLIPPED_X);
-      strokes.push_back(stroke2);
-
-      Stroke stroke3;
-      calculateSymmetricalStroke(stroke, stroke3, loop, doc::SymmetryIndex::FLIPPED_Y);
-      strokes.push_back(stroke3);
+  return { steps, int(N) };
+}
 
-      Stroke stroke4;
-      calculateSymmetricalStroke(stroke3, stroke4, loop, doc::SymmetryIndex::FLIPPED_XY);
-      strokes.push_back(stroke4);
+SymmetrySteps get_symmetry_steps(const gen::SymmetryMode mode)
+{
+  switch (mode) {
+    case gen::SymmetryMode::HORIZONTAL: return make_steps(kHorizontalSteps);
+    case gen::SymmetryMode::VERTICAL:   return make_steps(kVerticalSteps);
+    case gen::SymmetryMode::BOTH:       return make_steps(kBothSteps);
+    case gen::SymmetryMode::RIGHT_DIAG: return make_steps(kRightDiagSteps);
+    case gen::SymmetryMode::LEFT_DIAG:  return make_steps(kLeftDiagSteps);
+    case gen::SymmetryMode::BOTH_DIAG:  return make_steps(kBothDiagSteps);
+    case gen::SymmetryMode::ALL:        return make_steps(kAllSteps);
+    default:                            ASSERT(false); return { nullptr, 0 };
+  }
+}
 
-      Stroke stroke5;
-      calculateSymmetricalStroke(stroke, stroke5, loop, doc::SymmetryIndex::ROT_FLIP_90);
-      strokes.push_back(stroke5);
+} // anonymous namespace
 
-      Stroke stroke6;
-      calculateSymmetricalStroke(stroke5, stroke6, loop, doc::SymmetryIndex::ROTATED_270);
-      strokes.push_back(stroke6);
+void Symmetry::generateStrokes(const Stroke& stroke, Strokes& strokes, ToolLoop* loop)
+{
+  const std::size_t first = strokes.size();
+  strokes.push_back(stroke);
 
-      Stroke stroke7;
-      calculateSymmetricalStroke(stroke, stroke7, loop, doc::SymmetryIndex::ROT_FLIP_270);
-      strokes.push_back(stroke7);
+  const SymmetrySteps steps = get_symmetry_steps(resolveMode(loop->getSymmetry()->mode()));
+  for (int i = 0; i < steps.count; ++i) {
+    const SymmetryStep& step = steps.steps[i];
+    Stroke stroke2;
+    calculateSymmetricalStroke(strokes[first + step.from],
+                               stroke2,
+                               loop,
+                               step.symmetry,
+                               step.isDoubleDiagonalSymmetry);
+    strokes.push_back(std::move(stroke2));
+  }
+}
 
-      Stroke stroke8;
-      calculateSymmetricalStroke(stroke7, stroke8, loop, doc::SymmetryIndex::ROTATED_90);
-      strokes.push_back(stroke8);
-      break;
-    }
+int Symmetry::generatePoints(const Stroke::Pt& pt, Points& pts, ToolLoop* loop)
+{
+  pts[0] = pt;
+
+  const SymmetrySteps steps = get_symmetry_steps(resolveMode(loop->getSymmetry()->mode()));
+  for (int i = 0; i < steps.count; ++i) {
+    const SymmetryStep& step = steps.steps[i];
+    pts[i + 1] = calculateSymmetricalPoint(pts[step.from],
+                                           loop,
+                                           step.symmetry,
+                                           step.isDoubleDiagonalSymmetry);
   }
+  return steps.count + 1;
 }
 
 void Symmetry::calculateSymmetricalStroke(const Stroke& refStroke,
@@ -110,11 +123,25 @@ void Symmetry::calculateSymmetricalStroke(const Stroke& refStroke,
                                           ToolLoop* loop,
                                           const doc::SymmetryIndex symmetry,
                                           const bool isDoubleDiagonalSymmetry)
+{
+  for (const auto& pt : refStroke)
+    stroke.addPoint(calculateSymmetricalPoint(pt, loop, symmetry, isDoubleDiagonalSymmetry));
+}
+
+Stroke::Pt Symmetry::calculateSymmetricalPoint(const Stroke::Pt& pt,
+                                               ToolLoop* loop,
+                                               const doc::SymmetryIndex symmetry,
+                                               const bool isDoubleDiagonalSymmetry)
 {
   gfx::Size brushSize(1, 1);
   gfx::Point brushCenter(0, 0);
-  auto brush = loop->getBrush();
-  if (!loop->getPointShape()->isFloodFill()) {
+  if (loop->getDynamics().isDynamic()) {
+    brushSize = gfx::Size(pt.size, pt.size);
+    int center = (brushSize.w - brushSize.w % 2) / 2;
+    brushCenter = gfx::Point(center, center);
+  }
+  else if (!loop->getPointShape()->isFloodFill()) {
+    auto brush = loop->getBrush();
     if (!does_symmetry_rotate_image(symmetry)) {
       brushSize = brush->bounds().size();
       brushCenter = brush->center();
@@ -125,50 +152,42 @@ void Symmetry::calculateSymmetricalStroke(const Stroke& refStroke,
     }
   }
 
-  const bool isDynamic = loop->getDynamics().isDynamic();
-  for (const auto& pt : refStroke) {
-    if (isDynamic) {
-      brushSize = gfx::Size(pt.size, pt.size);
-      int center = (brushSize.w - brushSize.w % 2) / 2;
-      brushCenter = gfx::Point(center, center);
-    }
-    Stroke::Pt pt2 = pt;
-    pt2.symmetry = symmetry;
-    switch (symmetry) {
-      case doc::SymmetryIndex::ROT_FLIP_270: {
-        int adj_x = 0;
-        int adj_y = 0;
-        if (m_x - double(int(m_x)) > 0)
-          adj_y = 1;
-        if (m_y - double(int(m_y)) > 0)
-          adj_x = 1;
-        if (adj_x == 1 && adj_y == 1) {
-          adj_x = 0;
-          adj_y = 0;
-        }
-        pt2.x = -pt.y + m_x + m_y - (brushSize.w % 2 ? 1 : 0) + adj_x;
-        pt2.y = -pt.x + m_x + m_y - (brushSize.h % 2 ? 1 : 0) + adj_y;
-        break;
-      }
-      case doc::SymmetryIndex::ROT_FLIP_90:
-        pt2.x = pt.y + m_x - m_y + (m_x - int(m_x));
-        pt2.y = pt.x - m_x + m_y + (m_y - int(m_y));
-        break;
-      case doc::SymmetryIndex::ROTATED_90:
-      case doc::SymmetryIndex::ROTATED_270:
-        pt2.y = 2 * m_y - pt.y - (brushSize.h % 2 ? 1 : 0);
-        break;
-      case doc::SymmetryIndex::FLIPPED_X:
-      case doc::SymmetryIndex::FLIPPED_XY: {
-        pt2.x = 2 * (m_x + brushCenter.x) - pt.x - brushSize.w;
-        if (isDoubleDiagonalSymmetry)
-          pt2.y = 2 * (m_y + brushCenter.y) - pt.y - brushSize.h;
-        break;
+  Stroke::Pt pt2 = pt;
+  pt2.symmetry = symmetry;
+  switch (symmetry) {
+    case doc::SymmetryIndex::ROT_FLIP_270: {
+      int adj_x = 0;
+      int adj_y = 0;
+      if (m_x - double(int(m_x)) > 0)
+        adj_y = 1;
+      if (m_y - double(int(m_y)) > 0)
+        adj_x = 1;
+      if (adj_x == 1 && adj_y == 1) {
+        adj_x = 0;
+        adj_y = 0;
       }
-      default: pt2.y = 2 * (m_y + brushCenter.y) - pt.y - brushSize.h; break;
+      pt2.x = -pt.y + m_x + m_y - (brushSize.w % 2 ? 1 : 0) + adj_x;
+      pt2.y = -pt.x + m_x + m_y - (brushSize.h % 2 ? 1 : 0) + adj_y;
+      break;
+    }
+    case doc::SymmetryIndex::ROT_FLIP_90:
+      pt2.x = pt.y + m_x - m_y + (m_x - int(m_x));
+      pt2.y = pt.x - m_x + m_y + (m_y - int(m_y));
+      break;
+    case doc::SymmetryIndex::ROTATED_90:
+    case doc::SymmetryIndex::ROTATED_270:
+      pt2.y = 2 * m_y - pt.y - (brushSize.h % 2 ? 1 : 0);
+      break;
+    case doc::SymmetryIndex::FLIPPED_X:
+    case doc::SymmetryIndex::FLIPPED_XY: {
+      pt2.x = 2 * (m_x + brushCenter.x) - pt.x - brushSize.w;
+      if (isDoubleDiagonalSymmetry)
+        pt2.y = 2 * (m_y + brushCenter.y) - pt.y - brushSize.h;
+      break;
     }
-    stroke.addPoint(pt2);
+    default: pt2.y = 2 * (m_y + brushCenter.y) - pt.y - brushSize.h; break;
   }
+  return pt2;
 }
 
 gen::SymmetryMode Symmetry::resolveMode(gen::SymmetryMode mode)
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2021-2025  Igara Studio S.A.
+// Copyright (C) 2021-2026  Igara Studio S.A.
 // Copyright (C) 2015  David Capello
 //
 // This program is distributed under the terms of
@@ -13,6 +13,8 @@
 #include "app/tools/stroke.h"
 #include "doc/brush.h"
 
+#include <array>
+
 namespace app { namespace tools {
 
 class ToolLoop;
@@ -34,8 +36,17 @@ public:
   {
   }
 
+  // Maximum number of symmetrical points/strokes (including the
+  // original one).
+  static constexpr int kMaxPoints = 8;
+  using Points = std::array<Stroke::Pt, kMaxPoints>;
+
   void generateStrokes(const Stroke& stroke, Strokes& strokes, ToolLoop* loop);
 
+  // Same as generateStrokes() for just one point (without allocating
+  // strokes), returns the number of generated points.
+  int generatePoints(const Stroke::Pt& pt, Points& pts, ToolLoop* loop);
+
   gen::SymmetryMode mode() const { return m_symmetryMode; }
 
   static gen::SymmetryMode resolveMode(gen::SymmetryMode mode);
@@ -46,6 +57,10 @@ private:
                                   ToolLoop* loop,
                                   const doc::SymmetryIndex symmetry,
                                   const bool isDoubleDiagonalSymmetry = false);
+  Stroke::Pt calculateSymmetricalPoint(const Stroke::Pt& pt,
+                                       ToolLoop* loop,
+                                       const doc::SymmetryIndex symmetry,
+                                       const bool isDoubleDiagonalSymmetry);
 
   gen::SymmetryMode m_symmetryMode;
   double m_x, m_y;
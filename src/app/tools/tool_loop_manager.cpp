@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -27,6 +27,7 @@
 #include "gfx/point_io.h"
 #include "gfx/rect_io.h"
 #include "gfx/region.h"
+#include "tracing/tracing.h"
 
 #include <algorithm>
 #include <climits>
@@ -169,25 +170,7 @@ bool ToolLoopManager::releaseButton(const Pointer& pointer)
 
 void ToolLoopManager::movement(Pointer pointer)
 {
-  // Filter points with the stabilizer
-  if (m_dynamics.stabilizer && m_dynamics.stabilizerFactor > 0) {
-    const double f = m_dynamics.stabilizerFactor;
-    const gfx::Point delta = (pointer.point() - m_stabilizerCenter);
-    const double distance = std::sqrt(delta.x * delta.x + delta.y * delta.y);
-
-    const double angle = std::atan2(delta.y, delta.x);
-    const gfx::PointF newPoint(m_stabilizerCenter.x + distance / f * std::cos(angle),
-                               m_stabilizerCenter.y + distance / f * std::sin(angle));
-
-    m_stabilizerCenter = newPoint;
-
-    pointer = Pointer(gfx::Point(newPoint),
-                      pointer.velocity(),
-                      pointer.button(),
-                      pointer.type(),
-                      pointer.pressure());
-  }
-
+  pointer = applyStabilizer(pointer);
   m_lastPointer = pointer;
 
   if (isCanceled())
@@ -203,6 +186,71 @@ void ToolLoopManager::movement(Pointer pointer)
   doLoopStep(false);
 }
 
+void ToolLoopManager::movement(const std::vector<Pointer>& pointers)
+{
+  if (pointers.size() <= 1 || !canJoinMovements(m_toolLoop)) {
+    for (const Pointer& pointer : pointers)
+      movement(pointer);
+    return;
+  }
+
+  if (isCanceled()) {
+    m_lastPointer = applyStabilizer(pointers.back());
+    return;
+  }
+
+  // The last painted point is the first one of the new lines
+  const int first = std::max(0, m_stroke.size() - 1);
+  for (const Pointer& pointer : pointers) {
+    m_lastPointer = applyStabilizer(pointer);
+    Stroke::Pt spritePoint = getSpriteStrokePt(m_lastPointer);
+    m_toolLoop->getController()->movement(m_toolLoop, m_stroke, spritePoint);
+  }
+
+  std::string statusText;
+  m_toolLoop->getController()->getStatusBarText(m_toolLoop, m_stroke, statusText);
+  m_toolLoop->updateStatusBar(statusText.c_str());
+
+  Stroke mainStroke;
+  for (int i = first; i < m_stroke.size(); ++i)
+    mainStroke.addPoint(m_stroke[i]);
+  doLoopStep(mainStroke, false);
+}
+
+// static
+bool ToolLoopManager::canJoinMovements(ToolLoop* toolLoop)
+{
+  // With TracePolicy::Overlap each step is painted over the result of
+  // the previous one (e.g. blur/jumble inks), so we cannot join steps.
+  return (toolLoop->getController()->isFreehand() &&
+          !toolLoop->getController()->handleTracePolicy() &&
+          toolLoop->getTracePolicy() == TracePolicy::Accumulate &&
+          toolLoop->getIntertwine()->canJoinSeveralPoints());
+}
+
+Pointer ToolLoopManager::applyStabilizer(const Pointer& pointer)
+{
+  // Filter points with the stabilizer
+  if (m_dynamics.stabilizer && m_dynamics.stabilizerFactor > 0) {
+    const double f = m_dynamics.stabilizerFactor;
+    const gfx::Point delta = (pointer.point() - m_stabilizerCenter);
+    const double distance = std::sqrt(delta.x * delta.x + delta.y * delta.y);
+
+    const double angle = std::atan2(delta.y, delta.x);
+    const gfx::PointF newPoint(m_stabilizerCenter.x + distance / f * std::cos(angle),
+                               m_stabilizerCenter.y + distance / f * std::sin(angle));
+
+    m_stabilizerCenter = newPoint;
+
+    return Pointer(gfx::Point(newPoint),
+                   pointer.velocity(),
+                   pointer.button(),
+                   pointer.type(),
+                   pointer.pressure());
+  }
+  return pointer;
+}
+
 void ToolLoopManager::disableMouseStabilizer()
 {
   // Disable mouse stabilizer for the current ToolLoopManager
@@ -219,6 +267,13 @@ void ToolLoopManager::doLoopStep(bool lastStep)
   else
     main_stroke = m_stroke;
 
+  doLoopStep(main_stroke, lastStep);
+}
+
+void ToolLoopManager::doLoopStep(const Stroke& main_stroke, bool lastStep)
+{
+  TRACING_SCOPE("ToolLoopManager::doLoopStep");
+
   // Calculate the area to be updated in all document observers.
   Symmetry* symmetry = m_toolLoop->getSymmetry();
   Strokes strokes;
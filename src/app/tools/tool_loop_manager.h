@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2017  David Capello
 //
 // This program is distributed under the terms of
@@ -79,6 +79,18 @@ public:
   // Should be called each time the user moves the mouse inside the editor.
   void movement(Pointer pointer);
 
+  // Processes several mouse movements (e.g. all the movements
+  // received in the same frame). If canJoinMovements() is true, all
+  // points are painted in just one step (the dirty area is the union
+  // of all painted areas), in other case movement() is called for
+  // each pointer.
+  void movement(const std::vector<Pointer>& pointers);
+
+  // Returns true if several movements can be painted in just one
+  // step with the given tool loop (freehand tools that accumulate
+  // the trace drawing lines between points).
+  static bool canJoinMovements(ToolLoop* toolLoop);
+
   // Should be called when Shift+brush tool is used to disable stabilizer
   // on the line preview
   void disableMouseStabilizer();
@@ -87,6 +99,8 @@ public:
 
 private:
   void doLoopStep(bool lastStep);
+  void doLoopStep(const Stroke& mainStroke, bool lastStep);
+  Pointer applyStabilizer(const Pointer& pointer);
   void snapToGrid(Stroke::Pt& pt);
   Stroke::Pt getSpriteStrokePt(const Pointer& pointer);
   bool useDynamics() const;
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2016-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -18,6 +18,7 @@
 #include "app/color_utils.h"
 #include "app/modules/gfx.h"
 #include "app/pref/preferences.h"
+#include "app/task_scheduler.h"
 #include "app/ui/skin/skin_theme.h"
 #include "app/ui/status_bar.h"
 #include "app/util/shader_helpers.h"
@@ -38,7 +39,7 @@
 #include <cmath>
 #include <condition_variable>
 #include <cstdio>
-#include <thread>
+#include <optional>
 
 #if SK_ENABLE_SKSL
   #include "os/skia/skia_surface.h"
@@ -71,6 +72,11 @@ using namespace ui;
 // start caring about invalidating old commands (outdated regions) or
 // cleaning the queue if it gets too big.
 //
+// All ColorSelector widgets share the same Painter (one background
+// thread and one canvas). Painting requests are coalesced: if a new
+// request comes while the thread is painting, the current painting
+// is cancelled and only the latest request is painted (e.g. when the
+// user drags the color we don't paint intermediate states).
 class ColorSelector::Painter {
 public:
   Painter() : m_canvas(nullptr) {}
@@ -81,16 +87,27 @@ public:
   {
     assert_ui_thread();
 
-    if (m_ref == 0)
-      m_paintingThread = std::thread([this] { paintingProc(); });
+    if (m_ref == 0) {
+      m_killing = false;
+      m_paintingThread = BlockingTask([this] { paintingProc(); });
+    }
 
     ++m_ref;
   }
 
-  void releaseRef()
+  void releaseRef(ColorSelector* colorSelector)
   {
     assert_ui_thread();
 
+    {
+      // The ColorSelector is being destroyed, so we cannot paint it
+      std::unique_lock<std::mutex> lock(m_mutex);
+      if (m_pending && m_pending->colorSelector == colorSelector)
+        m_pending.reset();
+      if (m_colorSelector == colorSelector)
+        stopCurrentPainting(lock);
+    }
+
     --m_ref;
     if (m_ref == 0) {
       {
@@ -135,6 +152,8 @@ public:
     return m_canvas.get();
   }
 
+  // Doesn't wait the current painting to finish, it just replaces
+  // any pending request and cancels the current painting.
   void startBgPainting(ColorSelector* colorSelector,
                        const gfx::Rect& mainBounds,
                        const gfx::Rect& bottomBarBounds,
@@ -144,28 +163,31 @@ public:
     COLSEL_TRACE("COLSEL: startBgPainting for %p\n", colorSelector);
 
     std::unique_lock<std::mutex> lock(m_mutex);
-    stopCurrentPainting(lock);
-
-    m_colorSelector = colorSelector;
-    m_manager = colorSelector->manager();
-    m_mainBounds = mainBounds;
-    m_bottomBarBounds = bottomBarBounds;
-    m_alphaBarBounds = alphaBarBounds;
-
-    m_stopPainting = false;
+    m_pending = Request{ colorSelector, mainBounds, bottomBarBounds, alphaBarBounds };
+    if (m_colorSelector)
+      m_stopPainting = true;
     m_paintingCV.notify_one();
   }
 
 private:
+  struct Request {
+    ColorSelector* colorSelector;
+    gfx::Rect mainBounds;
+    gfx::Rect bottomBarBounds;
+    gfx::Rect alphaBarBounds;
+  };
+
+  // Discards the pending request and waits the current painting to
+  // be cancelled.
   void stopCurrentPainting(std::unique_lock<std::mutex>& lock)
   {
-    // Stop current
+    m_pending.reset();
+
     if (m_colorSelector) {
       COLSEL_TRACE("COLSEL: stoppping painting of %p\n", m_colorSelector);
 
-      // TODO use another condition variable here
       m_stopPainting = true;
-      m_waitStopCV.wait(lock);
+      m_waitStopCV.wait(lock, [this] { return m_colorSelector == nullptr; });
     }
 
     ASSERT(m_colorSelector == nullptr);
@@ -179,14 +201,17 @@ private:
 
     std::unique_lock<std::mutex> lock(m_mutex);
     while (true) {
-      m_paintingCV.wait(lock);
+      m_paintingCV.wait(lock, [this] { return m_killing || m_pending.has_value(); });
 
       if (m_killing)
         break;
 
-      auto colorSel = m_colorSelector;
-      if (!colorSel)
-        break;
+      const Request request = *m_pending;
+      m_pending.reset();
+
+      auto colorSel = request.colorSelector;
+      m_colorSelector = colorSel;
+      m_stopPainting = false;
 
       COLSEL_TRACE("COLSEL: starting painting in bg for %p\n", colorSel);
 
@@ -194,9 +219,9 @@ private:
       {
         lock.unlock();
         colorSel->onPaintSurfaceInBgThread(m_canvas.get(),
-                                           m_mainBounds,
-                                           m_bottomBarBounds,
-                                           m_alphaBarBounds,
+                                           request.mainBounds,
+                                           request.bottomBarBounds,
+                                           request.alphaBarBounds,
                                            m_stopPainting);
         lock.lock();
       }
@@ -204,13 +229,13 @@ private:
       m_colorSelector = nullptr;
 
       if (m_stopPainting) {
-        COLSEL_TRACE("COLSEL: painting for %p stopped\n");
-        m_waitStopCV.notify_one();
+        COLSEL_TRACE("COLSEL: painting for %p stopped\n", colorSel);
       }
       else {
-        COLSEL_TRACE("COLSEL: painting for %p done and sending message\n");
+        COLSEL_TRACE("COLSEL: painting for %p done and sending message\n", colorSel);
         colorSel->m_paintFlags |= DoneFlag;
       }
+      m_waitStopCV.notify_all();
     }
 
     COLSEL_TRACE("COLSEL: paintingProc ends\n");
@@ -223,12 +248,11 @@ private:
   std::condition_variable m_paintingCV;
   std::condition_variable m_waitStopCV;
   os::SurfaceRef m_canvas;
-  ColorSelector* m_colorSelector;
-  ui::Manager* m_manager;
-  gfx::Rect m_mainBounds;
-  gfx::Rect m_bottomBarBounds;
-  gfx::Rect m_alphaBarBounds;
-  std::thread m_paintingThread;
+  // Color selector being painted right now in the background thread
+  ColorSelector* m_colorSelector = nullptr;
+  // Latest painting request (older requests are discarded)
+  std::optional<Request> m_pending;
+  BlockingTask m_paintingThread;
 };
 
 static ColorSelector::Painter painter;
@@ -252,7 +276,7 @@ ColorSelector::ColorSelector()
 
 ColorSelector::~ColorSelector()
 {
-  painter.releaseRef();
+  painter.releaseRef(this);
 }
 
 void ColorSelector::selectColor(const app::Color& color)
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -2318,8 +2318,9 @@ void ContextBar::updateForTool(tools::Tool* tool)
 
   if (!updateSamplingVisibility(tool)) {
     // updateSamplingVisibility() returns false if it doesn't layout()
-    // the ContextBar.
-    layout();
+    // the ContextBar. We defer the layout as the tool can be updated
+    // several times in the same event (e.g. changing tool and ink).
+    deferLayout();
   }
 }
 
@@ -2375,7 +2376,7 @@ bool ContextBar::updateSamplingVisibility(tools::Tool* tool)
 
   if (newVisibility == m_samplingSelector->hasFlags(HIDDEN)) {
     m_samplingSelector->setVisible(newVisibility);
-    layout();
+    deferLayout();
     return true;
   }
   return false;
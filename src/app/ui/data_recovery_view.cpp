@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2017  David Capello
 //
 // This program is distributed under the terms of
@@ -21,6 +21,7 @@
 #include "app/modules/gui.h"
 #include "app/pref/preferences.h"
 #include "app/task.h"
+#include "app/task_scheduler.h"
 #include "app/ui/data_recovery_view.h"
 #include "app/ui/drop_down_button.h"
 #include "app/ui/separator_in_view.h"
@@ -43,6 +44,7 @@
 #include "ver/info.h"
 
 #include <algorithm>
+#include <memory>
 
 namespace app {
 
@@ -57,6 +59,7 @@ public:
     : m_session(session)
     , m_backup(backup)
     , m_task(nullptr)
+    , m_self(std::make_shared<Item*>(this))
   {
   }
 
@@ -137,7 +140,10 @@ public:
       if (!m_backup)
         return;
 
-      setText(m_backup->description(Preferences::instance().general.showFullPath()));
+      if (m_backup->hasDescription())
+        setText(m_backup->description(Preferences::instance().general.showFullPath()));
+      else
+        loadDescription();
     }
   }
 
@@ -152,6 +158,29 @@ private:
     ListItem::onPaint(ev);
   }
 
+  // Reads the backup description in a worker thread, so all visible
+  // items are loaded in parallel without blocking the UI.
+  void loadDescription()
+  {
+    if (m_loadingDescription)
+      return;
+    m_loadingDescription = true;
+    setText(Strings::recover_files_loading());
+
+    std::weak_ptr<Item*> self = m_self;
+    TaskScheduler::instance()->execute([self, backup = m_backup] {
+      // Warning: This is executed from a worker thread
+      backup->loadDescription();
+      ui::execute_from_ui_thread([self] {
+        // The item could be deleted (e.g. the list was refreshed)
+        if (auto item = self.lock()) {
+          (*item)->m_loadingDescription = false;
+          (*item)->updateText();
+        }
+      });
+    });
+  }
+
   void onSizeHint(SizeHintEvent& ev) override
   {
     ListItem::onSizeHint(ev);
@@ -233,6 +262,10 @@ private:
   crash::Session* m_session;
   crash::Session::BackupPtr m_backup;
   TaskWidget* m_task;
+  bool m_loadingDescription = false;
+  // Pointer to this item, used by worker threads to know if the item
+  // still exists (with a std::weak_ptr).
+  std::shared_ptr<Item*> m_self;
 };
 
 } // anonymous namespace
@@ -324,7 +357,7 @@ void DataRecoveryView::fillListWith(const bool crashes)
   bool first = true;
 
   for (auto& session : m_dataRecovery->sessions()) {
-    if ((session->isEmpty()) || (crashes && !session->isCrashedSession()) ||
+    if ((session->backups().empty()) || (crashes && !session->isCrashedSession()) ||
         (!crashes && session->isCrashedSession()))
       continue;
 
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2022  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -17,9 +17,16 @@
 
 #include "app/app.h"
 #include "app/app_menus.h"
+#include "app/context.h"
+#include "app/doc.h"
 #include "app/ui/skin/skin_theme.h"
 #include "app/ui/workspace.h"
+#include "app/util/memory_usage.h"
+#include "base/mem_utils.h"
+#include "doc/image_buffer_pool.h"
+#include "doc/object.h"
 #include "fmt/format.h"
+#include "tracing/metrics.h"
 #include "ui/entry.h"
 #include "ui/message.h"
 #include "ui/system.h"
@@ -152,6 +159,48 @@ bool DevConsoleView::onProcessMessage(Message* msg)
 
 void DevConsoleView::onExecuteCommand(const std::string& cmd)
 {
+  // Show counters of the doc::Object registry
+  if (cmd == ":objects") {
+    const doc::ObjectsStats stats = doc::get_objects_stats();
+    onConsolePrint(fmt::format("Objects: {} alive, {} IDs created, {} lookups",
+                               stats.liveObjects,
+                               stats.createdIds,
+                               stats.lookups)
+                     .c_str());
+    return;
+  }
+
+  // Show the memory used by each document
+  if (cmd == ":memory") {
+    for (const Doc* doc : App::instance()->context()->documents()) {
+      const DocMemoryUsage usage = get_doc_memory_usage(doc);
+      onConsolePrint(fmt::format("{}: {} images, {} undo",
+                                 doc->name(),
+                                 base::get_pretty_memory_size(usage.images),
+                                 base::get_pretty_memory_size(usage.undo))
+                       .c_str());
+    }
+    const doc::ImageBufferPool* pool = doc::ImageBufferPool::instance();
+    onConsolePrint(fmt::format("Image buffers cache: {} of {}",
+                               base::get_pretty_memory_size(pool->unusedBytes()),
+                               base::get_pretty_memory_size(pool->maxBytes()))
+                     .c_str());
+    return;
+  }
+
+  // Show/reset the performance counters
+  if (cmd == ":perf") {
+    std::string text = tracing::metrics_to_text();
+    if (!text.empty() && text.back() == '\n')
+      text.pop_back();
+    onConsolePrint(text.empty() ? "No performance counters" : text.c_str());
+    return;
+  }
+  if (cmd == ":perf reset") {
+    tracing::reset_metrics();
+    return;
+  }
+
   m_engine->printLastResult();
   m_engine->evalCode(cmd);
 }
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -47,12 +47,18 @@
 #include "ui/manager.h"
 #include "ui/system.h"
 
+#include <algorithm>
 #include <array>
 
 namespace app {
 
 using namespace doc;
 
+// Maximum number of items in the caches of brush boundaries and
+// surfaces, and memory used by all the cached surfaces.
+static constexpr int kMaxCachedItems = 8;
+static constexpr std::size_t kMaxCachedSurfacesBytes = 16 * 1024 * 1024;
+
 static int g_crosshair_pattern[7 * 7] = {
   0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0,
   0, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0,
@@ -210,10 +216,18 @@ void BrushPreview::show(const gfx::Point& screenPos)
     const auto& dynamics = App::instance()->contextBar()->getDynamics();
     if (brush->type() != doc::kImageBrushType && (dynamics.size != tools::DynamicSensor::Static ||
                                                   dynamics.angle != tools::DynamicSensor::Static)) {
-      brush.reset(new Brush(
-        brush->type(),
-        (dynamics.size != tools::DynamicSensor::Static ? dynamics.minSize : brush->size()),
-        (dynamics.angle != tools::DynamicSensor::Static ? dynamics.minAngle : brush->angle())));
+      const int size =
+        (dynamics.size != tools::DynamicSensor::Static ? dynamics.minSize : brush->size());
+      const int angle =
+        (dynamics.angle != tools::DynamicSensor::Static ? dynamics.minAngle : brush->angle());
+
+      // Re-use the same brush (and its generation number) if
+      // possible, so we can re-use its boundaries too.
+      if (!m_dynamicsBrush || m_dynamicsBrush->type() != brush->type() ||
+          m_dynamicsBrush->size() != size || m_dynamicsBrush->angle() != angle) {
+        m_dynamicsBrush = std::make_shared<Brush>(brush->type(), size, angle);
+      }
+      brush = m_dynamicsBrush;
     }
   }
 
@@ -426,7 +440,7 @@ void BrushPreview::show(const gfx::Point& screenPos)
 
     // Create (or re-use) the UILayer
     if ((m_type & SELECTION_CROSSHAIR) || (m_type & BRUSH_BOUNDARIES)) {
-      bool cached = createUILayer(brushBounds);
+      const bool cached = createUILayer(brushBounds, uiCursorColor);
       const render::Projection& proj = m_editor->projection();
 
       if (m_uiLayer->surface()) {
@@ -450,12 +464,7 @@ void BrushPreview::show(const gfx::Point& screenPos)
       display->addLayer(m_uiLayer);
       m_layerAdded = true;
 
-      // Check if the cached brush painted in the m_uiLayer is still valid
-      if (m_cachedType != m_type || m_cachedBrushGen != m_brushGen) {
-        cached = false;
-      }
-
-      // Here we re-use the cached surface
+      // Paint the brush in the new surface
       if (!cached && m_uiLayer->surface()) {
         m_uiLayer->surface()->clear();
 
@@ -479,23 +488,21 @@ void BrushPreview::show(const gfx::Point& screenPos)
           strokeBrushBoundaries(&g, pos, paint);
         }
 
+      }
+
 #if LAF_SKIA
-        if (m_blackAndWhiteNegative) {
-          static sk_sp<SkBlender> blender;
-          if (!blender) {
-            SkRuntimeBlendBuilder builder(make_blender(kNegativeBlackAndWhiteShaderCode));
-            blender = builder.makeBlender();
-          }
-          m_uiLayer->paint().skPaint().setBlender(blender);
-        }
-        else {
-          m_uiLayer->paint().skPaint().setBlender(nullptr);
+      if (m_blackAndWhiteNegative) {
+        static sk_sp<SkBlender> blender;
+        if (!blender) {
+          SkRuntimeBlendBuilder builder(make_blender(kNegativeBlackAndWhiteShaderCode));
+          blender = builder.makeBlender();
         }
-#endif // LAF_SKIA
-
-        m_cachedType = m_type;
-        m_cachedBrushGen = m_brushGen;
+        m_uiLayer->paint().skPaint().setBlender(blender);
       }
+      else {
+        m_uiLayer->paint().skPaint().setBlender(nullptr);
+      }
+#endif // LAF_SKIA
     }
   }
 
@@ -586,7 +593,7 @@ void BrushPreview::calculateTileBoundariesOrigin(const doc::Grid& grid, const gf
   m_brushBoundaries.offset(canvasPos.x - spritePos.x, canvasPos.y - spritePos.y);
 }
 
-bool BrushPreview::createUILayer(const gfx::Rect& brushBounds)
+bool BrushPreview::createUILayer(const gfx::Rect& brushBounds, const gfx::Color cursorColor)
 {
   if (!m_uiLayer)
     m_uiLayer = ui::UILayer::Make();
@@ -603,17 +610,58 @@ bool BrushPreview::createUILayer(const gfx::Rect& brushBounds)
     sizeHint = brushSize;
   }
 
-  if (sizeHint.w == 0 || sizeHint.h == 0)
+  if (sizeHint.w == 0 || sizeHint.h == 0) {
+    // Don't paint over a cached surface
+    m_uiLayer->setSurface(nullptr);
     return false;
-
-  os::SurfaceRef surface = m_uiLayer->surface();
-  if (!surface || surface->width() != sizeHint.w || surface->height() != sizeHint.h) {
-    surface = os::System::instance()->makeRgbaSurface(sizeHint.w, sizeHint.h);
-    m_uiLayer->setSurface(surface);
   }
-  else
-    return true; // We can use the cached UILayer
 
+  SurfaceKey key;
+  key.type = m_type;
+  key.size = sizeHint;
+  key.scaleX = proj.scaleX();
+  key.scaleY = proj.scaleY();
+  key.blackAndWhiteNegative = m_blackAndWhiteNegative;
+  if (!m_blackAndWhiteNegative)
+    key.color = cursorColor;
+  if (m_type & BRUSH_BOUNDARIES) {
+    key.brushGen = m_brushGen;
+    key.onePixel = m_brushBoundariesOnePixel;
+    key.tileSize = m_brushBoundariesTileSize;
+    if (!m_brushBoundaries.isEmpty())
+      key.boundariesOrigin = m_brushBoundaries.begin()->bounds().origin();
+  }
+
+  auto it = std::find_if(m_cachedSurfaces.begin(),
+                         m_cachedSurfaces.end(),
+                         [&key](const CachedSurface& item) { return item.key == key; });
+  if (it != m_cachedSurfaces.end()) {
+    // Move the surface to the front (most recently used)
+    std::rotate(m_cachedSurfaces.begin(), it, it + 1);
+    m_uiLayer->setSurface(m_cachedSurfaces.front().surface);
+    return true; // We can use the cached surface
+  }
+
+  os::SurfaceRef surface = os::System::instance()->makeRgbaSurface(sizeHint.w, sizeHint.h);
+  m_uiLayer->setSurface(surface);
+
+  // Don't keep big surfaces (e.g. big brushes with a lot of zoom) in
+  // the cache, only the current one.
+  std::size_t bytes = std::size_t(sizeHint.w) * sizeHint.h * 4;
+  if (bytes <= kMaxCachedSurfacesBytes) {
+    m_cachedSurfaces.insert(m_cachedSurfaces.begin(), CachedSurface{ key, surface });
+    for (auto it = m_cachedSurfaces.begin() + 1; it != m_cachedSurfaces.end();) {
+      const std::size_t itemBytes = std::size_t(it->surface->width()) * it->surface->height() * 4;
+      if (bytes + itemBytes > kMaxCachedSurfacesBytes ||
+          it - m_cachedSurfaces.begin() >= kMaxCachedItems) {
+        it = m_cachedSurfaces.erase(it);
+      }
+      else {
+        bytes += itemBytes;
+        ++it;
+      }
+    }
+  }
   return false;
 }
 
@@ -623,8 +671,12 @@ void BrushPreview::createBoundaries(const Site& site, const gfx::Point& spritePo
   Layer* currentLayer = site.layer();
   TilemapMode tilemapMode = site.tilemapMode();
 
+  const bool isOnePixel = (m_editor->getCurrentEditorTool()->getPointShape(0)->isPixel() ||
+                           m_editor->getCurrentEditorTool()->getPointShape(0)->isFloodFill());
+
   if (tilemapMode == TilemapMode::Pixels && tilemapMode == m_lastTilemapMode &&
-      !m_brushBoundaries.isEmpty() && m_brushGen == brush->gen()) {
+      !m_brushBoundaries.isEmpty() && m_brushGen == brush->gen() &&
+      m_brushBoundariesOnePixel == isOnePixel) {
     return;
   }
   else if (tilemapMode == TilemapMode::Tiles && tilemapMode == m_lastTilemapMode &&
@@ -636,10 +688,36 @@ void BrushPreview::createBoundaries(const Site& site, const gfx::Point& spritePo
     return;
   }
 
-  const bool isOnePixel = (m_editor->getCurrentEditorTool()->getPointShape(0)->isPixel() ||
-                           m_editor->getCurrentEditorTool()->getPointShape(0)->isFloodFill());
+  // Keep the boundaries of the previous brush in the cache
+  if (m_brushBoundariesTileSize.isEmpty() && !m_brushBoundaries.isEmpty()) {
+    m_cachedBoundaries.insert(
+      m_cachedBoundaries.begin(),
+      CachedBoundaries{ m_brushGen, m_brushBoundariesOnePixel, std::move(m_brushBoundaries) });
+    if (int(m_cachedBoundaries.size()) > kMaxCachedItems)
+      m_cachedBoundaries.pop_back();
+    m_brushBoundaries = MaskBoundaries();
+  }
+
   Image* brushImage = brush->image();
   m_brushGen = brush->gen();
+  m_brushBoundariesOnePixel = isOnePixel;
+  m_brushBoundariesTileSize =
+    (tilemapMode == TilemapMode::Tiles ? site.grid().tileSize() : gfx::Size());
+
+  // Re-use the boundaries of a previous brush
+  if (tilemapMode == TilemapMode::Pixels) {
+    auto it = std::find_if(m_cachedBoundaries.begin(),
+                           m_cachedBoundaries.end(),
+                           [this](const CachedBoundaries& item) {
+                             return item.brushGen == m_brushGen &&
+                                    item.onePixel == m_brushBoundariesOnePixel;
+                           });
+    if (it != m_cachedBoundaries.end()) {
+      m_brushBoundaries = std::move(it->boundaries);
+      m_cachedBoundaries.erase(it);
+      return;
+    }
+  }
 
   Image* mask = nullptr;
   bool deleteMask = true;
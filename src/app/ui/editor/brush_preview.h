@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2016  David Capello
 //
 // This program is distributed under the terms of
@@ -94,7 +94,10 @@ private:
   // Used within 'generateBoundaries' function.
   void calculateTileBoundariesOrigin(const doc::Grid& grid, const gfx::Point& spritePos);
 
-  bool createUILayer(const gfx::Rect& brushBounds);
+  // Sets the surface of the UILayer for the current brush
+  // boundaries/crosshair, returns true if the surface was found in
+  // the cache (so it's already painted).
+  bool createUILayer(const gfx::Rect& brushBounds, const gfx::Color cursorColor);
   void createBoundaries(const Site& site, const gfx::Point& spritePos);
 
   // Creates a little native cursor to draw the CROSSHAIR
@@ -123,12 +126,54 @@ private:
   // UI layer to draw (and move) the brush boundaries
   ui::UILayerRef m_uiLayer;
   bool m_layerAdded = false;
-  int m_cachedType = 0;
-  int m_cachedBrushGen = 0;
 
   // Information about current brush
   doc::MaskBoundaries m_brushBoundaries;
-  int m_brushGen;
+  int m_brushGen = 0;
+  bool m_brushBoundariesOnePixel = false;
+  gfx::Size m_brushBoundariesTileSize; // Empty in TilemapMode::Pixels
+
+  // Brush used to show the minimum size/angle when dynamics are
+  // enabled (re-used while the size/angle doesn't change).
+  doc::BrushRef m_dynamicsBrush;
+
+  // Caches of the boundaries of the previously used brushes
+  // (TilemapMode::Pixels only) and the surfaces where they were
+  // painted (for each zoom level, cursor color, and tile origin), so
+  // we don't need to generate/paint them again when we go back to a
+  // previous brush or zoom level. The first item is the most
+  // recently used one.
+  struct CachedBoundaries {
+    int brushGen;
+    bool onePixel;
+    doc::MaskBoundaries boundaries;
+  };
+  struct SurfaceKey {
+    int type = 0;
+    int brushGen = 0;
+    bool onePixel = false;
+    gfx::Size tileSize;
+    gfx::Point boundariesOrigin;
+    gfx::Size size;
+    double scaleX = 0.0;
+    double scaleY = 0.0;
+    gfx::Color color = gfx::ColorNone;
+    bool blackAndWhiteNegative = false;
+
+    bool operator==(const SurfaceKey& o) const
+    {
+      return type == o.type && brushGen == o.brushGen && onePixel == o.onePixel &&
+             tileSize == o.tileSize && boundariesOrigin == o.boundariesOrigin && size == o.size &&
+             scaleX == o.scaleX && scaleY == o.scaleY && color == o.color &&
+             blackAndWhiteNegative == o.blackAndWhiteNegative;
+    }
+  };
+  struct CachedSurface {
+    SurfaceKey key;
+    os::SurfaceRef surface;
+  };
+  std::vector<CachedBoundaries> m_cachedBoundaries;
+  std::vector<CachedSurface> m_cachedSurfaces;
 
   gfx::Region m_clippingRegion;
 
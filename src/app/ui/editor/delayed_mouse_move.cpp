@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2022-2025  Igara Studio S.A.
+// Copyright (C) 2022-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -21,10 +21,13 @@ static const gfx::Point kNoPosReceived(std::numeric_limits<int>::min(),
 
 DelayedMouseMove::DelayedMouseMove(DelayedMouseMoveDelegate* delegate,
                                    Editor* editor,
-                                   const int interval)
+                                   const int interval,
+                                   const bool throttle)
   : m_delegate(delegate)
   , m_editor(editor)
   , m_timer(interval)
+  , m_interval(interval)
+  , m_throttle(throttle)
   , m_mouseMoveReceived(false)
   , m_mouseDownPos(kNoPosReceived)
   , m_mouseDownTime(base::current_tick())
@@ -68,7 +71,13 @@ bool DelayedMouseMove::onMouseMove(const ui::MouseMessage* msg)
     return false;
 
   if (!m_timer.isRunning()) {
-    if (m_timer.interval() > 0) {
+    const base::tick_t elapsed = base::current_tick() - m_lastCommitTime;
+    if (m_throttle && m_interval > 0 && elapsed < base::tick_t(m_interval)) {
+      // Wait the rest of the interval
+      m_timer.setInterval(m_interval - int(elapsed));
+      m_timer.start();
+    }
+    else if (!m_throttle && m_interval > 0) {
       m_timer.start();
     }
     else {
@@ -102,6 +111,7 @@ void DelayedMouseMove::commitMouseMove()
   if (m_timer.isRunning())
     m_timer.stop();
 
+  m_lastCommitTime = base::current_tick();
   try {
     m_delegate->onCommitMouseMove(m_editor, spritePos());
   }
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2022-2024  Igara Studio S.A.
+// Copyright (C) 2022-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -36,7 +36,16 @@ class DelayedMouseMove {
 public:
   // The "interval" is given in milliseconds, and can be zero if we
   // want to disable the delay between onMouseMove() -> onCommitMouseMove()
-  DelayedMouseMove(DelayedMouseMoveDelegate* delegate, Editor* editor, const int interval);
+  //
+  // If "throttle" is true, a mouse movement is committed immediately
+  // if the last onCommitMouseMove() was called "interval"
+  // milliseconds ago (or more), in other case it's delayed until the
+  // interval is elapsed. Useful to group all mouse movements received
+  // in the same frame without adding latency to the first movement.
+  DelayedMouseMove(DelayedMouseMoveDelegate* delegate,
+                   Editor* editor,
+                   const int interval,
+                   const bool throttle = false);
 
   // Resets internals to receive an onMouseDown() again and
   // interpret a "one click" correctly again.
@@ -70,6 +79,9 @@ private:
   DelayedMouseMoveDelegate* m_delegate;
   Editor* m_editor;
   ui::Timer m_timer;
+  const int m_interval;
+  const bool m_throttle;
+  base::tick_t m_lastCommitTime = 0;
 
   // These fields are used to detect a single click, e.g. in a
   // selection tool, a single click deselect (press and release the
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2024  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -45,6 +45,10 @@ namespace app {
 
 using namespace ui;
 
+// Maximum number of strokes steps per second for freehand tools
+// that can join several mouse movements in just one step.
+static constexpr int kJoinMovementsInterval = 1000 / 60;
+
 static int get_delay_interval_for_tool_loop(tools::ToolLoop* toolLoop)
 {
   if (toolLoop->getTracePolicy() == tools::TracePolicy::Last) {
@@ -53,6 +57,11 @@ static int get_delay_interval_for_tool_loop(tools::ToolLoop* toolLoop)
     // shape, so we can discard intermediate positions).
     return 5;
   }
+  else if (tools::ToolLoopManager::canJoinMovements(toolLoop)) {
+    // Group the mouse movements received in the same frame (e.g. from
+    // a tablet) to paint all of them in one step.
+    return kJoinMovementsInterval;
+  }
   else {
     // Without delay for freehand-like tools
     return 0;
@@ -62,7 +71,8 @@ static int get_delay_interval_for_tool_loop(tools::ToolLoop* toolLoop)
 DrawingState::DrawingState(Editor* editor, tools::ToolLoop* toolLoop, const DrawingType type)
   : m_editor(editor)
   , m_type(type)
-  , m_delayedMouseMove(this, editor, get_delay_interval_for_tool_loop(toolLoop))
+  , m_joinMovements(tools::ToolLoopManager::canJoinMovements(toolLoop))
+  , m_delayedMouseMove(this, editor, get_delay_interval_for_tool_loop(toolLoop), m_joinMovements)
   , m_toolLoop(toolLoop)
   , m_toolLoopManager(new tools::ToolLoopManager(toolLoop))
   , m_mousePressedReceived(false)
@@ -201,6 +211,12 @@ bool DrawingState::onMouseUp(Editor* editor, MouseMessage* msg)
   m_lastPointer = pointer_from_msg(editor, msg, m_velocity.velocity());
   m_delayedMouseMove.onMouseUp(msg);
 
+  // Paint the pending movements (if onMouseUp() didn't commit them)
+  if (!m_pendingPointers.empty()) {
+    m_delayedMouseMove.stopTimer();
+    handleMouseMovement();
+  }
+
   // Selection tools with Replace mode are cancelled with a simple click.
   // ("one point" controller selection tool i.e. the magic wand, and
   // selection tools with Add or Subtract mode aren't cancelled with
@@ -253,6 +269,19 @@ bool DrawingState::onMouseMove(Editor* editor, MouseMessage* msg)
   // the scroll.
   base::ScopedValue disableScroll(m_processScrollChange, false);
 
+  // Add the positions of the mouse movements that were coalesced in
+  // this message, so freehand tools paint all the movement.
+  if (m_joinMovements) {
+    for (const ui::MouseMessage::Sample& sample : msg->history()) {
+      m_velocity.updateWithDisplayPoint(sample.position);
+      addPendingPointer(tools::Pointer(gfx::Point(editor->screenToEditorF(sample.position)),
+                                       m_velocity.velocity(),
+                                       button_from_msg(msg),
+                                       msg->pointerType(),
+                                       sample.pressure));
+    }
+  }
+
   // Update velocity sensor.
   m_velocity.updateWithDisplayPoint(msg->position());
 
@@ -262,10 +291,12 @@ bool DrawingState::onMouseMove(Editor* editor, MouseMessage* msg)
                                  button_from_msg(msg),
                                  msg->pointerType(),
                                  msg->pressure());
+  if (m_joinMovements)
+    addPendingPointer(m_lastPointer);
 
   // Use DelayedMouseMove for tools like line, rectangle, etc. (that
   // use the only the last mouse position) to filter out rapid mouse
-  // movement.
+  // movement, or to group the movements of freehand tools.
   m_delayedMouseMove.onMouseMove(msg);
   return true;
 }
@@ -368,7 +399,28 @@ void DrawingState::handleMouseMovement()
 {
   // Notify mouse movement to the tool
   ASSERT(m_toolLoopManager);
-  m_toolLoopManager->movement(m_lastPointer);
+  if (m_joinMovements) {
+    addPendingPointer(m_lastPointer);
+
+    // Paint all the movements received since the last step
+    std::vector<tools::Pointer> pointers;
+    std::swap(pointers, m_pendingPointers);
+    m_toolLoopManager->movement(pointers);
+  }
+  else {
+    m_toolLoopManager->movement(m_lastPointer);
+  }
+}
+
+void DrawingState::addPendingPointer(const tools::Pointer& pointer)
+{
+  // Replace the last pointer if it's in the same position (e.g. only
+  // the pressure was changed), we don't want to paint one line with
+  // zero length.
+  if (!m_pendingPointers.empty() && m_pendingPointers.back().point() == pointer.point())
+    m_pendingPointers.back() = pointer;
+  else
+    m_pendingPointers.push_back(pointer);
 }
 
 bool DrawingState::canExecuteCommands()
@@ -418,6 +470,9 @@ void DrawingState::destroyLoopIfCanceled(Editor* editor)
 
 void DrawingState::destroyLoop(Editor* editor)
 {
+  m_delayedMouseMove.stopTimer();
+  m_pendingPointers.clear();
+
   if (editor)
     editor->renderEngine().removePreviewImage();
 
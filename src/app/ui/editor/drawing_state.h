@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2022  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2017  David Capello
 //
 // This program is distributed under the terms of
@@ -16,6 +16,7 @@
 #include "base/time.h"
 #include "obs/connection.h"
 #include <memory>
+#include <vector>
 
 namespace app {
 namespace tools {
@@ -68,6 +69,7 @@ public:
 
 private:
   void handleMouseMovement();
+  void addPendingPointer(const tools::Pointer& pointer);
   bool canExecuteCommands();
   void onBeforeCommandExecution(CommandExecutionEvent& ev);
   void destroyLoopIfCanceled(Editor* editor);
@@ -78,8 +80,16 @@ private:
 
   Editor* m_editor;
   DrawingType m_type;
+
+  // True if the mouse movements received in the same frame are
+  // painted together (see ToolLoopManager::canJoinMovements()).
+  bool m_joinMovements;
   DelayedMouseMove m_delayedMouseMove;
 
+  // Pointers received since the last committed mouse movement (only
+  // when m_joinMovements is true).
+  std::vector<tools::Pointer> m_pendingPointers;
+
   // The tool-loop.
   std::unique_ptr<tools::ToolLoop> m_toolLoop;
 
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -15,12 +15,14 @@
 #include "app/app_menus.h"
 #include "app/color.h"
 #include "app/color_picker.h"
+#include "app/color_spaces.h"
 #include "app/color_utils.h"
 #include "app/commands/commands.h"
 #include "app/commands/params.h"
 #include "app/commands/quick_command.h"
 #include "app/console.h"
 #include "app/doc_event.h"
+#include "app/doc_undo.h"
 #include "app/i18n/strings.h"
 #include "app/ini_file.h"
 #include "app/modules/gfx.h"
@@ -68,6 +70,7 @@
 #include "os/surface.h"
 #include "os/system.h"
 #include "render/rasterize.h"
+#include "tracing/tracing.h"
 #include "ui/ui.h"
 #include "view/layers.h"
 
@@ -77,6 +80,14 @@
 #include <limits>
 #include <memory>
 
+#if LAF_SKIA && SK_ENABLE_SKSL
+  #include "app/util/shader_helpers.h"
+  #include "os/skia/skia_surface.h"
+
+  #include "include/core/SkCanvas.h"
+  #include "include/effects/SkRuntimeEffect.h"
+#endif
+
 namespace app {
 
 using namespace app::skin;
@@ -88,6 +99,81 @@ using namespace render;
 static base::Chrono renderChrono;
 static double renderElapsed = 0.0;
 
+#if LAF_SKIA && SK_ENABLE_SKSL
+
+// Draws the same lines as Editor::drawGrid() in one pass. iOrigin is
+// the position of the first vertical/horizontal lines, iSize the
+// distance between lines, and iBounds the limits of the horizontal
+// (x1, x2) and vertical (y1, y2) lines. Lines are placed in the
+// truncated position (as drawHLine()/drawVLine() do with integer
+// arguments), and crossing lines are blended twice.
+static const char* kGridShaderCode = R"(
+uniform float2 iOrigin;
+uniform float2 iSize;
+uniform float4 iBounds;
+uniform half4 iColor;
+
+float is_line(float p, float origin, float size, float end) {
+ float lo = (p > 0.0 ? p: p - 1.0);
+ float hi = (p >= 0.0 ? p + 1.0: p);
+ float c = origin + max(0.0, ceil((lo - origin) / size)) * size;
+ return (c < hi && c <= end ? 1.0: 0.0);
+}
+
+half4 main(vec2 fragcoord) {
+ float2 p = floor(fragcoord);
+ float n = 0.0;
+ if (p.x >= iBounds.x && p.x < iBounds.z)
+  n += is_line(p.y, iOrigin.y, iSize.y, iBounds.w);
+ if (p.y >= iBounds.y && p.y < iBounds.w)
+  n += is_line(p.x, iOrigin.x, iSize.x, iBounds.z);
+ half a = 1.0 - pow(1.0 - iColor.a, n);
+ return half4(iColor.rgb * a, a);
+}
+)";
+
+static bool draw_grid_with_shader(Display* display,
+                                  Graphics* g,
+                                  const gfx::Rect& rc,
+                                  const gfx::PointF& origin,
+                                  const gfx::SizeF& size,
+                                  const gfx::Rect& spriteBounds,
+                                  const gfx::Color color)
+{
+  // Only if we can render directly in the ui::Graphics surface (the
+  // same condition used in ColorSelector::onPaint())
+  auto displayCs = get_current_color_space(display);
+  auto gCs = g->getInternalSurface()->colorSpace();
+  if ((displayCs && !displayCs->isSRGB()) || (gCs && !gCs->isSRGB()))
+    return false;
+
+  static const sk_sp<SkRuntimeEffect> effect = make_shader(kGridShaderCode);
+  if (!effect)
+    return false;
+
+  SkRuntimeShaderBuilder builder(effect);
+  builder.uniform("iOrigin") = SkV2{ float(origin.x), float(origin.y) };
+  builder.uniform("iSize") = SkV2{ float(size.w), float(size.h) };
+  builder.uniform("iBounds") = SkV4{ float(spriteBounds.x),
+                                     float(spriteBounds.y),
+                                     float(spriteBounds.x2()),
+                                     float(spriteBounds.y2()) };
+  builder.uniform("iColor") = gfxColor_to_SkV4(color);
+
+  SkPaint p;
+  p.setStyle(SkPaint::kFill_Style);
+  p.setShader(builder.makeShader());
+
+  SkCanvas* canvas = &static_cast<os::SkiaSurface*>(g->getInternalSurface())->canvas();
+  canvas->save();
+  canvas->translate(g->getInternalDeltaX(), g->getInternalDeltaY());
+  canvas->drawRect(SkRect::MakeXYWH(rc.x, rc.y, rc.w, rc.h), p);
+  canvas->restore();
+  return true;
+}
+
+#endif // LAF_SKIA && SK_ENABLE_SKSL
+
 class EditorPostRenderImpl : public EditorPostRender {
 public:
   EditorPostRenderImpl(Editor* editor, Graphics* g) : m_editor(editor), m_g(g) {}
@@ -587,16 +673,19 @@ void Editor::updateEditor(const bool restoreScrollPos)
   View::getView(this)->updateView(restoreScrollPos);
 }
 
-void Editor::drawOneSpriteUnclippedRect(ui::Graphics* g,
-                                        const gfx::Rect& spriteRectToDraw,
-                                        int dx,
-                                        int dy)
+bool Editor::calcOneSpriteRects(ui::Graphics* g,
+                                const gfx::Rect& spriteRectToDraw,
+                                const int dx,
+                                const int dy,
+                                gfx::Rect& expose,
+                                gfx::Rect& rc2,
+                                gfx::Rect& dest) const
 {
   // Clip from sprite and apply zoom
   gfx::Rect rc = m_sprite->bounds().createIntersection(spriteRectToDraw);
   rc = m_proj.apply(rc);
 
-  gfx::Rect dest(dx + m_padding.x + rc.x, dy + m_padding.y + rc.y, 0, 0);
+  dest = gfx::Rect(dx + m_padding.x + rc.x, dy + m_padding.y + rc.y, 0, 0);
 
   // Clip from graphics/screen
   const gfx::Rect& clip = g->getClipBounds();
@@ -618,11 +707,11 @@ void Editor::drawOneSpriteUnclippedRect(ui::Graphics* g,
   }
 
   if (rc.isEmpty())
-    return;
+    return false;
 
   // Bounds of pixels from the sprite canvas that will be exposed in
   // this render cycle.
-  gfx::Rect expose = m_proj.remove(rc);
+  expose = m_proj.remove(rc);
 
   // If the zoom level is less than 100%, we add extra pixels to
   // the exposed area. Those pixels could be shown in the
@@ -649,13 +738,10 @@ void Editor::drawOneSpriteUnclippedRect(ui::Graphics* g,
   expose.w = std::clamp(expose.w, 0, maxw);
   expose.h = std::clamp(expose.h, 0, maxh);
   if (expose.isEmpty())
-    return;
+    return false;
 
   // rc2 is the rectangle used to create a temporal rendered image of the sprite
-  const auto& pref = Preferences::instance();
-  const bool newEngine = isUsingNewRenderEngine();
-  gfx::Rect rc2;
-  if (newEngine) {
+  if (isUsingNewRenderEngine()) {
     rc2 = expose; // New engine, exposed rectangle (without zoom)
     dest.x = dx + m_padding.x + m_proj.applyX(rc2.x);
     dest.y = dy + m_padding.y + m_proj.applyY(rc2.y);
@@ -667,23 +753,47 @@ void Editor::drawOneSpriteUnclippedRect(ui::Graphics* g,
     dest.w = rc.w;
     dest.h = rc.h;
   }
+  return true;
+}
+
+void Editor::drawOneSpriteUnclippedRect(ui::Graphics* g,
+                                        const gfx::Rect& spriteRectToDraw,
+                                        int dx,
+                                        int dy)
+{
+  gfx::Rect expose, rc2, dest;
+  if (!calcOneSpriteRects(g, spriteRectToDraw, dx, dy, expose, rc2, dest))
+    return;
+
+  // In tiled mode the area of all copies of the sprite can be
+  // rendered just once (see beginTiledRender()), and then each copy
+  // is drawn from a part of that render.
+  gfx::Rect renderBounds = rc2;
+  if (!m_tiledRender.bounds.isEmpty()) {
+    ASSERT(m_tiledRender.bounds.contains(rc2));
+    renderBounds = m_tiledRender.bounds;
+    expose = m_tiledRender.expose;
+  }
+  const gfx::Point srcOffset = rc2.origin() - renderBounds.origin();
+
+  const auto& pref = Preferences::instance();
+  const bool newEngine = isUsingNewRenderEngine();
 
   // Convert the render to a os::Surface
   static os::SurfaceRef rendered = nullptr; // TODO move this to other centralized place
+  os::SurfaceRef surface;                   // Surface to draw (rendered or from the cache)
   const auto& renderProperties = m_renderEngine->properties();
   try {
+    // Re-use the render of the first copy of the sprite in tiled mode
+    surface = m_tiledRender.surface;
+
     // Generate a "expose sprite pixels" notification. This is used by
     // tool managers that need to validate this region (copy pixels from
     // the original cel) before it can be used by the RenderEngine.
-    m_document->notifyExposeSpritePixels(m_sprite, gfx::Region(expose));
+    if (!surface)
+      m_document->notifyExposeSpritePixels(m_sprite, gfx::Region(expose));
 
-    m_renderEngine->setComposeGroups(pref.experimental.composeGroups());
-    m_renderEngine->setNewBlendMethod(pref.experimental.newBlend());
-    m_renderEngine->setRefLayersVisiblity(true);
-    m_renderEngine->setSelectedLayer(m_layer);
-    m_renderEngine->setNonactiveLayersOpacity(otherLayersOpacity());
-    m_renderEngine->setupBackground(m_document, IMAGE_RGB);
-    m_renderEngine->disableOnionskin();
+    setupRenderEngine();
 
     if ((m_flags & kShowOnionskin) == kShowOnionskin) {
       if (m_docPref.onionskin.active()) {
@@ -710,8 +820,9 @@ void Editor::drawOneSpriteUnclippedRect(ui::Graphics* g,
       }
     }
 
+    bool useCache = (m_playbackCache && canCachePlaybackFrames());
     ExtraCelRef extraCel = m_document->extraCel();
-    if (extraCel && extraCel->type() != render::ExtraType::NONE &&
+    if (!surface && extraCel && extraCel->type() != render::ExtraType::NONE &&
         // We render the extra cel if:
         ( // 1) it doesn't contains the brush preview (e.g. the user
           // is transforming the selection),
@@ -728,6 +839,7 @@ void Editor::drawOneSpriteUnclippedRect(ui::Graphics* g,
                                     extraCel->blendMode(),
                                     m_layer,
                                     m_frame);
+      useCache = false;
     }
 
     // Render background first (e.g. new ShaderRenderer will paint the
@@ -742,16 +854,49 @@ void Editor::drawOneSpriteUnclippedRect(ui::Graphics* g,
                                                           m_proj.apply(rc2)));
     }
 
-    // Create a temporary surface to draw the sprite on it
-    if (!rendered || rendered->width() < rc2.w || rendered->height() < rc2.h ||
-        rendered->colorSpace() != m_document->osColorSpace()) {
-      const int maxw = std::max(rc2.w, rendered ? rendered->width() : 0);
-      const int maxh = std::max(rc2.h, rendered ? rendered->height() : 0);
-      rendered = os::System::instance()->makeRgbaSurface(maxw, maxh, m_document->osColorSpace());
+    // Use the frame rendered previously during the playback
+    PlaybackFrameCache::Key cacheKey;
+    if (useCache && !surface) {
+      cacheKey = playbackFrameKey(m_frame, renderBounds);
+      surface = m_playbackCache->get(cacheKey);
+      if (surface && surface->colorSpace() != m_document->osColorSpace())
+        surface = nullptr;
     }
 
-    m_renderEngine->setProjection(newEngine ? render::Projection() : m_proj);
-    m_renderEngine->renderSprite(rendered.get(), m_sprite, m_frame, gfx::Clip(0, 0, rc2));
+    if (!surface) {
+      // Render the frame in its own surface to keep it in the cache
+      if (useCache && m_playbackCache->canAdd(renderBounds.size())) {
+        surface = os::System::instance()->makeRgbaSurface(renderBounds.w,
+                                                          renderBounds.h,
+                                                          m_document->osColorSpace());
+      }
+      else {
+        // Create a temporary surface to draw the sprite on it
+        if (!rendered || rendered->width() < renderBounds.w ||
+            rendered->height() < renderBounds.h ||
+            rendered->colorSpace() != m_document->osColorSpace()) {
+          const int maxw = std::max(renderBounds.w, rendered ? rendered->width() : 0);
+          const int maxh = std::max(renderBounds.h, rendered ? rendered->height() : 0);
+          rendered = os::System::instance()->makeRgbaSurface(maxw,
+                                                             maxh,
+                                                             m_document->osColorSpace());
+        }
+        surface = rendered;
+        useCache = false;
+      }
+
+      m_renderEngine->setProjection(newEngine ? render::Projection() : m_proj);
+      m_renderEngine->renderSprite(surface.get(),
+                                   m_sprite,
+                                   m_frame,
+                                   gfx::Clip(0, 0, renderBounds));
+
+      if (useCache)
+        m_playbackCache->add(cacheKey, surface);
+    }
+
+    if (!m_tiledRender.bounds.isEmpty())
+      m_tiledRender.surface = surface;
 
     m_renderEngine->removeExtraImage();
 
@@ -764,7 +909,7 @@ void Editor::drawOneSpriteUnclippedRect(ui::Graphics* g,
     Console::showException(e);
   }
 
-  if (rendered && rendered->nativeHandle()) {
+  if (surface && surface->nativeHandle()) {
     os::Paint p;
     if (newEngine) {
       os::Sampling sampling;
@@ -800,11 +945,15 @@ void Editor::drawOneSpriteUnclippedRect(ui::Graphics* g,
 
       IntersectClip clip(g, destClip);
       if (clip)
-        g->drawSurface(rendered.get(), gfx::Rect(0, 0, rc2.w, rc2.h), dest, sampling, &p);
+        g->drawSurface(surface.get(),
+                       gfx::Rect(srcOffset.x, srcOffset.y, rc2.w, rc2.h),
+                       dest,
+                       sampling,
+                       &p);
     }
     else {
-      g->drawSurface(rendered.get(),
-                     gfx::Rect(0, 0, dest.w, dest.h),
+      g->drawSurface(surface.get(),
+                     gfx::Rect(srcOffset.x, srcOffset.y, dest.w, dest.h),
                      gfx::Rect(dest.x, dest.y, dest.w, dest.h),
                      os::Sampling(os::Sampling::Filter::Nearest),
                      &p);
@@ -973,8 +1122,38 @@ void Editor::drawBackground(ui::Graphics* g)
   g->drawHLine(theme->colors.editorSpriteBottomBorder(), rc.x, rc.y2(), rc.w);
 }
 
+void Editor::beginTiledRender(ui::Graphics* g,
+                              const gfx::Rect& rc,
+                              const std::vector<gfx::Point>& copies)
+{
+  m_tiledRender = TiledRender();
+
+  gfx::Rect bounds, expose;
+  int64_t area = 0;
+  for (const gfx::Point& copy : copies) {
+    gfx::Rect copyExpose, copyRc2, copyDest;
+    if (calcOneSpriteRects(g, rc, copy.x, copy.y, copyExpose, copyRc2, copyDest)) {
+      bounds |= copyRc2;
+      expose |= copyExpose;
+      area += int64_t(copyRc2.w) * copyRc2.h;
+    }
+  }
+
+  // All copies show the same pixels of the sprite, so we can render
+  // the area of all of them just once (e.g. when the whole tiled
+  // sprite is visible at low zoom levels). But if each copy shows a
+  // different part of the sprite (e.g. we are seeing the corners of 4
+  // copies at high zoom levels), it's better to render each part.
+  if (area > 0 && int64_t(bounds.w) * bounds.h <= area) {
+    m_tiledRender.bounds = bounds;
+    m_tiledRender.expose = expose;
+  }
+}
+
 void Editor::drawSpriteUnclippedRect(ui::Graphics* g, const gfx::Rect& _rc)
 {
+  TRACING_SCOPE("Editor::drawSpriteUnclippedRect");
+
   gfx::Rect rc = _rc;
   // For odd zoom scales minor than 100% we have to add an extra window
   // just to make sure the whole rectangle is drawn.
@@ -998,32 +1177,40 @@ void Editor::drawSpriteUnclippedRect(ui::Graphics* g, const gfx::Rect& _rc)
   }
 
   // Draw the main sprite at the center.
-  drawOneSpriteUnclippedRect(g, rc, 0, 0);
+  std::vector<gfx::Point> copies = { gfx::Point(0, 0) };
 
   // Document preferences
   if (int(m_docPref.tiled.mode()) & int(filters::TiledMode::X_AXIS)) {
-    drawOneSpriteUnclippedRect(g, rc, spriteRect.w, 0);
-    drawOneSpriteUnclippedRect(g, rc, spriteRect.w * 2, 0);
+    copies.push_back(gfx::Point(spriteRect.w, 0));
+    copies.push_back(gfx::Point(spriteRect.w * 2, 0));
 
     enclosingRect = gfx::Rect(spriteRect.x, spriteRect.y, spriteRect.w * 3, spriteRect.h);
   }
 
   if (int(m_docPref.tiled.mode()) & int(filters::TiledMode::Y_AXIS)) {
-    drawOneSpriteUnclippedRect(g, rc, 0, spriteRect.h);
-    drawOneSpriteUnclippedRect(g, rc, 0, spriteRect.h * 2);
+    copies.push_back(gfx::Point(0, spriteRect.h));
+    copies.push_back(gfx::Point(0, spriteRect.h * 2));
 
     enclosingRect = gfx::Rect(spriteRect.x, spriteRect.y, spriteRect.w, spriteRect.h * 3);
   }
 
   if (m_docPref.tiled.mode() == filters::TiledMode::BOTH) {
-    drawOneSpriteUnclippedRect(g, rc, spriteRect.w, spriteRect.h);
-    drawOneSpriteUnclippedRect(g, rc, spriteRect.w * 2, spriteRect.h);
-    drawOneSpriteUnclippedRect(g, rc, spriteRect.w, spriteRect.h * 2);
-    drawOneSpriteUnclippedRect(g, rc, spriteRect.w * 2, spriteRect.h * 2);
+    copies.push_back(gfx::Point(spriteRect.w, spriteRect.h));
+    copies.push_back(gfx::Point(spriteRect.w * 2, spriteRect.h));
+    copies.push_back(gfx::Point(spriteRect.w, spriteRect.h * 2));
+    copies.push_back(gfx::Point(spriteRect.w * 2, spriteRect.h * 2));
 
     enclosingRect = gfx::Rect(spriteRect.x, spriteRect.y, spriteRect.w * 3, spriteRect.h * 3);
   }
 
+  if (copies.size() > 1)
+    beginTiledRender(g, rc, copies);
+
+  for (const gfx::Point& copy : copies)
+    drawOneSpriteUnclippedRect(g, rc, copy.x, copy.y);
+
+  m_tiledRender = TiledRender();
+
   // Draw active layer/cel edges
   if ((m_docPref.show.layerEdges() || m_showAutoCelGuides) &&
       // Show layer edges and possibly cel guides only on states that
@@ -1105,9 +1292,6 @@ void Editor::drawMaskBoundaries(ui::Graphics* g, doc::MaskBoundaries& segs, cons
   pt.x = m_padding.x + m_proj.applyX(pt.x);
   pt.y = m_padding.y + m_proj.applyY(pt.y);
 
-  // Create the mask boundaries path
-  segs.createPathIfNeeeded();
-
   ui::Paint paint;
   paint.style(ui::Paint::Stroke);
   set_checkered_paint_mode(paint,
@@ -1115,12 +1299,27 @@ void Editor::drawMaskBoundaries(ui::Graphics* g, doc::MaskBoundaries& segs, cons
                            gfx::rgba(0, 0, 0, 255),
                            gfx::rgba(255, 255, 255, 255));
 
+  // Big selections are drawn with reduced boundaries when we are
+  // zoomed out (one sprite pixel is less than one screen pixel).
+  int factor;
+  doc::MaskBoundaries& level = segs.levelForScale(std::min(m_proj.scaleX(), m_proj.scaleY()),
+                                                  factor);
+  const gfx::Matrix matrix = gfx::Matrix::MakeScale(m_proj.scaleX() * factor,
+                                                    m_proj.scaleY() * factor);
+
+  // Visible area in coordinates of the boundaries, so we only draw
+  // the bands of segments that intersect the clip region.
+  gfx::Rect area = m_proj.remove(gfx::Rect(g->getClipBounds()).offset(-pt));
+  area = gfx::Rect(area.x / factor, area.y / factor, area.w / factor, area.h / factor).enlarge(2);
+
   // We translate the path instead of applying a matrix to the
   // ui::Graphics so the "checkered" pattern is not scaled too.
-  gfx::Path path;
-  segs.path().transform(m_proj.scaleMatrix(), &path);
-  path.offset(pt.x, pt.y);
-  g->drawPath(path, paint);
+  level.forEachPath(area, [g, &pt, &paint, &matrix](gfx::Path& levelPath) {
+    gfx::Path path;
+    levelPath.transform(matrix, &path);
+    path.offset(pt.x, pt.y);
+    g->drawPath(path, paint);
+  });
 }
 
 void Editor::drawMaskSafe()
@@ -1203,21 +1402,48 @@ void Editor::drawGrid(Graphics* g,
   grid_color =
     gfx::rgba(gfx::getr(grid_color), gfx::getg(grid_color), gfx::getb(grid_color), alpha);
 
-  // Draw horizontal lines
-  int x1 = spriteBounds.x;
-  int y1 = gridF.y;
-  int x2 = spriteBounds.x + spriteBounds.w;
-  int y2 = spriteBounds.y + spriteBounds.h;
+  // Position of the first vertical and horizontal lines
+  const int gx1 = gridF.x;
+  const int gy1 = gridF.y;
+  const int x2 = spriteBounds.x + spriteBounds.w;
+  const int y2 = spriteBounds.y + spriteBounds.h;
+
+  // Only the lines inside the clipping region are drawn
+  const gfx::Rect clipBounds = g->getClipBounds() &
+                               gfx::Rect(gfx::Point(std::min(spriteBounds.x, gx1),
+                                                    std::min(spriteBounds.y, gy1)),
+                                         gfx::Point(x2 + 1, y2 + 1));
+  if (clipBounds.isEmpty())
+    return;
 
-  for (double c = y1; c <= y2; c += gridF.h)
-    g->drawHLine(grid_color, x1, c, spriteBounds.w);
+#if LAF_SKIA && SK_ENABLE_SKSL
+  // With a lot of lines (e.g. the pixel grid with a big zoom level)
+  // it's faster to draw the whole grid with one shader
+  if (draw_grid_with_shader(display(),
+                            g,
+                            clipBounds,
+                            gfx::PointF(gx1, gy1),
+                            gridF.size(),
+                            spriteBounds,
+                            grid_color))
+    return;
+#endif
 
-  // Draw vertical lines
-  x1 = gridF.x;
-  y1 = spriteBounds.y;
+  // Draw horizontal lines
+  for (int i = std::max(0, int((clipBounds.y - 1 - gy1) / gridF.h));; ++i) {
+    const double c = gy1 + i * gridF.h;
+    if (c > y2 || c >= clipBounds.y2())
+      break;
+    g->drawHLine(grid_color, spriteBounds.x, c, spriteBounds.w);
+  }
 
-  for (double c = x1; c <= x2; c += gridF.w)
-    g->drawVLine(grid_color, c, y1, spriteBounds.h);
+  // Draw vertical lines
+  for (int i = std::max(0, int((clipBounds.x - 1 - gx1) / gridF.w));; ++i) {
+    const double c = gx1 + i * gridF.w;
+    if (c > x2 || c >= clipBounds.x2())
+      break;
+    g->drawVLine(grid_color, c, spriteBounds.y, spriteBounds.h);
+  }
 }
 
 void Editor::drawSlices(ui::Graphics* g)
@@ -1231,20 +1457,26 @@ void Editor::drawSlices(ui::Graphics* g)
   auto theme = SkinTheme::get(this);
   gfx::Point mainOffset(mainTilePosition());
 
+  // Only slices that intersect the clipping region are drawn
+  const gfx::Rect clipBounds = g->getClipBounds();
+
   for (auto slice : m_sprite->slices()) {
     auto key = slice->getByFrame(m_frame);
     if (!key)
       continue;
 
+    gfx::Rect out = key->bounds();
+    out.offset(mainOffset);
+    out = editorToScreen(out);
+    out.offset(-bounds().origin());
+    if (!clipBounds.intersects(gfx::Rect(out).enlarge(2 * guiscale())))
+      continue;
+
     doc::color_t docColor = slice->userData().color();
     gfx::Color color = gfx::rgba(doc::rgba_getr(docColor),
                                  doc::rgba_getg(docColor),
                                  doc::rgba_getb(docColor),
                                  doc::rgba_geta(docColor));
-    gfx::Rect out = key->bounds();
-    out.offset(mainOffset);
-    out = editorToScreen(out);
-    out.offset(-bounds().origin());
 
     // Center slices
     if (key->hasCenter()) {
@@ -2393,6 +2625,8 @@ void Editor::onResize(ui::ResizeEvent& ev)
 
 void Editor::onPaint(ui::PaintEvent& ev)
 {
+  TRACING_SCOPE("Editor::onPaint");
+
   std::unique_ptr<HideBrushPreview> hide;
   if (m_flashing == Flashing::None) {
     // If we are drawing the editor for a tooltip background or any
@@ -2600,6 +2834,11 @@ void Editor::onRemoveSlice(DocEvent& ev)
 
 void Editor::onBeforeLayerVisibilityChange(DocEvent& ev, bool newState)
 {
+  // Layer visibility is not included in the undo history, so the
+  // frames rendered for the playback are not valid anymore.
+  if (m_playbackCache)
+    m_playbackCache->clear();
+
   if (m_state)
     m_state->onBeforeLayerVisibilityChange(this, ev.layer(), newState);
 }
@@ -3006,6 +3245,7 @@ void Editor::play(const bool playOnce, const bool playAll, const bool playSubtag
     stop();
 
   m_isPlaying = true;
+  m_playbackCache = std::make_unique<PlaybackFrameCache>();
   setState(EditorStatePtr(new PlayState(playOnce, playAll, playSubtags)));
 }
 
@@ -3020,6 +3260,7 @@ void Editor::stop()
       backToPreviousState();
 
     m_isPlaying = false;
+    m_playbackCache.reset();
 
     ASSERT(m_state && dynamic_cast<PlayState*>(m_state.get()));
     if (m_state)
@@ -3032,6 +3273,48 @@ bool Editor::isPlaying() const
   return m_isPlaying;
 }
 
+bool Editor::renderPlaybackFrameInAdvance(const doc::frame_t frame)
+{
+  if (!m_playbackCache || !canCachePlaybackFrames() || frame == m_frame || frame < 0 ||
+      frame > m_sprite->lastFrame()) {
+    return false;
+  }
+
+  // The extra cel is not included in cached frames
+  ExtraCelRef extraCel = m_document->extraCel();
+  if (extraCel && extraCel->type() != render::ExtraType::NONE)
+    return false;
+
+  const bool newEngine = isUsingNewRenderEngine();
+  bool result = false;
+  for (const gfx::Rect& rc2 : m_playbackCache->lastBounds()) {
+    const PlaybackFrameCache::Key key = playbackFrameKey(frame, rc2);
+    if (m_playbackCache->contains(key))
+      continue;
+    if (!m_playbackCache->canAdd(rc2.size()))
+      break;
+
+    const gfx::Rect expose = (newEngine ? rc2 : m_proj.remove(rc2)) & m_sprite->bounds();
+    m_document->notifyExposeSpritePixels(m_sprite, gfx::Region(expose));
+
+    os::SurfaceRef surface =
+      os::System::instance()->makeRgbaSurface(rc2.w, rc2.h, m_document->osColorSpace());
+    try {
+      setupRenderEngine();
+      m_renderEngine->setProjection(newEngine ? render::Projection() : m_proj);
+      m_renderEngine->renderSprite(surface.get(), m_sprite, frame, gfx::Clip(0, 0, rc2));
+    }
+    catch (const std::exception& e) {
+      Console::showException(e);
+      return false;
+    }
+
+    m_playbackCache->add(key, surface);
+    result = true;
+  }
+  return result;
+}
+
 void Editor::showAnimationSpeedMultiplierPopup()
 {
   const bool wasPlaying = isPlaying();
@@ -3170,6 +3453,40 @@ void Editor::updateAutoCelGuides(ui::Message* msg)
   }
 }
 
+void Editor::setupRenderEngine()
+{
+  const auto& pref = Preferences::instance();
+  m_renderEngine->setComposeGroups(pref.experimental.composeGroups());
+  m_renderEngine->setNewBlendMethod(pref.experimental.newBlend());
+  m_renderEngine->setRefLayersVisiblity(true);
+  m_renderEngine->setSelectedLayer(m_layer);
+  m_renderEngine->setNonactiveLayersOpacity(otherLayersOpacity());
+  m_renderEngine->setupBackground(m_document, IMAGE_RGB);
+  m_renderEngine->disableOnionskin();
+}
+
+bool Editor::canCachePlaybackFrames() const
+{
+  // Onionskin frames depend on the current frame and its settings
+  return ((m_flags & kShowOnionskin) != kShowOnionskin || !m_docPref.onionskin.active());
+}
+
+PlaybackFrameCache::Key Editor::playbackFrameKey(const doc::frame_t frame,
+                                                  const gfx::Rect& bounds) const
+{
+  PlaybackFrameCache::Key key;
+  key.frame = frame;
+  key.undoState = m_document->undoHistory()->currentState();
+  key.spriteVersion = m_sprite->version();
+  key.layerId = (m_layer ? m_layer->id() : doc::NullId);
+  key.nonactiveLayersOpacity = otherLayersOpacity();
+  key.newEngine = isUsingNewRenderEngine();
+  key.scaleX = m_proj.scaleX();
+  key.scaleY = m_proj.scaleY();
+  key.bounds = bounds;
+  return key;
+}
+
 int Editor::otherLayersOpacity() const
 {
   if (m_docView && m_docView->isPreview())
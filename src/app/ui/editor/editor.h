@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -21,6 +21,7 @@
 #include "app/ui/editor/editor_observers.h"
 #include "app/ui/editor/editor_state.h"
 #include "app/ui/editor/editor_states_history.h"
+#include "app/ui/editor/playback_frame_cache.h"
 #include "app/ui/tile_source.h"
 #include "app/util/tiled_mode.h"
 #include "doc/algorithm/flip_type.h"
@@ -41,6 +42,7 @@
 
 #include <memory>
 #include <set>
+#include <vector>
 
 namespace doc {
 class Layer;
@@ -270,6 +272,13 @@ public:
   void stop();
   bool isPlaying() const;
 
+  // Renders the areas of the given frame that were painted for the
+  // current frame in the playback cache (so they are ready when the
+  // playback reaches that frame). Returns true if something was
+  // rendered, false if the frame was already cached or cannot be
+  // cached.
+  bool renderPlaybackFrameInAdvance(const doc::frame_t frame);
+
   // Shows a popup menu to change the editor animation speed.
   void showAnimationSpeedMultiplierPopup();
   double getAnimationSpeedMultiplier() const;
@@ -406,6 +415,25 @@ private:
   // You should setup the clip of the screen before calling this
   // routine.
   void drawOneSpriteUnclippedRect(ui::Graphics* g, const gfx::Rect& rc, int dx, int dy);
+  bool calcOneSpriteRects(ui::Graphics* g,
+                          const gfx::Rect& spriteRectToDraw,
+                          int dx,
+                          int dy,
+                          gfx::Rect& expose,
+                          gfx::Rect& rc2,
+                          gfx::Rect& dest) const;
+  void beginTiledRender(ui::Graphics* g,
+                        const gfx::Rect& rc,
+                        const std::vector<gfx::Point>& copies);
+
+  // Configures the shared render engine with the options of this
+  // editor (without onionskin or extra images).
+  void setupRenderEngine();
+
+  // Returns true if the rendered frames can be stored in the playback
+  // cache (e.g. they don't depend on the onionskin).
+  bool canCachePlaybackFrames() const;
+  PlaybackFrameCache::Key playbackFrameKey(const doc::frame_t frame, const gfx::Rect& bounds) const;
 
   gfx::Point calcExtraPadding(const render::Projection& proj);
 
@@ -489,6 +517,18 @@ private:
   double m_aniSpeed;
   bool m_isPlaying;
 
+  // Rendered frames while the animation is being played.
+  std::unique_ptr<PlaybackFrameCache> m_playbackCache;
+
+  // Area of the sprite rendered only once to draw all its copies in
+  // tiled mode (bounds is empty if each copy is rendered).
+  struct TiledRender {
+    gfx::Rect bounds; // Rendered area (with zoom in the old render engine)
+    gfx::Rect expose; // Exposed sprite pixels
+    os::SurfaceRef surface;
+  };
+  TiledRender m_tiledRender;
+
   // The Cel that is above the mouse if the Ctrl (or Cmd) key is
   // pressed (move key).
   Cel* m_showGuidesThisCel;
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2023  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2018  David Capello
 //
 // This program is distributed under the terms of
@@ -15,6 +15,7 @@
 #include "app/pref/preferences.h"
 #include "app/render/shader_renderer.h"
 #include "app/render/simple_renderer.h"
+#include "tracing/tracing.h"
 
 namespace app {
 
@@ -180,6 +181,7 @@ void EditorRender::renderSprite(os::Surface* dstSurface,
                                 doc::frame_t frame,
                                 const gfx::ClipF& area)
 {
+  TRACING_SCOPE("EditorRender::renderSprite");
   m_renderer->renderSprite(dstSurface, sprite, frame, area);
 }
 
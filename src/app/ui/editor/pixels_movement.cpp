@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -24,6 +24,7 @@
 #include "app/pref/preferences.h"
 #include "app/site.h"
 #include "app/snap_to_grid.h"
+#include "app/task_scheduler.h"
 #include "app/ui/editor/pivot_helpers.h"
 #include "app/ui/editor/vec2.h"
 #include "app/ui/status_bar.h"
@@ -39,14 +40,18 @@
 #include "doc/blend_internals.h"
 #include "doc/cel.h"
 #include "doc/image.h"
+#include "doc/image_buffer_pool.h"
 #include "doc/layer.h"
 #include "doc/mask.h"
 #include "doc/sprite.h"
+#include "doc/task_group.h"
 #include "doc/util.h"
 #include "gfx/region.h"
 #include "render/render.h"
+#include "ui/system.h"
 
 #include <algorithm>
+#include <atomic>
 
 #if _DEBUG
   #define DUMP_INNER_CMDS() dumpInnerCmds()
@@ -56,6 +61,85 @@
 
 namespace app {
 
+namespace {
+
+// Only one task at a time renders the RotSprite version of the extra
+// cel (old renders are discarded anyway).
+SerialTaskGroup& quality_render_tasks()
+{
+  static SerialTaskGroup tasks(TaskKind::Compute, 1, doc::TaskPriority::Interactive);
+  return tasks;
+}
+
+// Draws the "src" image transformed to the given corners in "dst"
+// using the given rotation algorithm. Returns false if there is not
+// enough memory to use RotSprite (in that case the fast algorithm is
+// used anyway).
+bool draw_parallelogram(const tools::RotationAlgorithm rotAlgo,
+                        doc::algorithm::RotSprite& rotSprite,
+                        doc::Image* dst,
+                        const doc::Image* src,
+                        const doc::Image* mask,
+                        const Transformation::Corners& corners,
+                        const gfx::PointF& leftTop)
+{
+  const int x1 = int(corners.leftTop().x - leftTop.x);
+  const int y1 = int(corners.leftTop().y - leftTop.y);
+  const int x2 = int(corners.rightTop().x - leftTop.x);
+  const int y2 = int(corners.rightTop().y - leftTop.y);
+  const int x3 = int(corners.rightBottom().x - leftTop.x);
+  const int y3 = int(corners.rightBottom().y - leftTop.y);
+  const int x4 = int(corners.leftBottom().x - leftTop.x);
+  const int y4 = int(corners.leftBottom().y - leftTop.y);
+
+  if (rotAlgo == tools::RotationAlgorithm::ROTSPRITE) {
+    try {
+      rotSprite.rotate(dst, src, mask, x1, y1, x2, y2, x3, y3, x4, y4);
+      return true;
+    }
+    catch (const std::bad_alloc&) {
+      // Release the cached upscaled images and try with the fast
+      // algorithm anyway.
+      rotSprite.clear();
+      doc::algorithm::parallelogram(dst, src, mask, x1, y1, x2, y2, x3, y3, x4, y4);
+      return false;
+    }
+  }
+
+  doc::algorithm::parallelogram(dst, src, mask, x1, y1, x2, y2, x3, y3, x4, y4);
+  return true;
+}
+
+} // anonymous namespace
+
+struct PixelsMovement::QualityRender {
+  // Owner of the render, it's nullptr when the PixelsMovement is
+  // destroyed (it's used only from the UI thread).
+  PixelsMovement* owner = nullptr;
+
+  // Incremented each time the extra cel is redrawn, so pending
+  // renders are discarded.
+  std::atomic<int> generation = 0;
+};
+
+struct PixelsMovement::StampJob {
+  // Where to stamp the image
+  Layer* layer = nullptr;
+  doc::frame_t frame = 0;
+  TilemapMode tilemapMode = TilemapMode::Pixels;
+  TilesetMode tilesetMode = TilesetMode::Auto;
+  gfx::Point position;
+
+  // Transformation to draw "src" in "dst" (which already contains
+  // the original layer below the transformed pixels)
+  ImageRef dst;
+  ImageRef src;
+  ImageRef mask;
+  Transformation::Corners corners;
+  gfx::PointF pt;
+  tools::RotationAlgorithm rotAlgo = tools::RotationAlgorithm::FAST;
+};
+
 PixelsMovement::InnerCmd::InnerCmd(InnerCmd&& c) : type(None)
 {
   std::swap(type, c.type);
@@ -125,7 +209,10 @@ PixelsMovement::PixelsMovement(Context* context,
   , m_canHandleFrameChange(false)
   , m_fastMode(false)
   , m_needsRotSpriteRedraw(false)
+  , m_qualityRender(std::make_shared<QualityRender>())
 {
+  m_qualityRender->owner = this;
+
   // Save and Lock the TilemapMode.
   // TODO: enable TilemapMode exchanges during PixelMovement.
   if (m_site.layer()->isTilemap() && ColorBar::instance())
@@ -170,6 +257,9 @@ PixelsMovement::PixelsMovement(Context* context,
 
 PixelsMovement::~PixelsMovement()
 {
+  m_qualityRender->owner = nullptr;
+  ++m_qualityRender->generation;
+
   if (ColorBar::instance())
     ColorBar::instance()->unlockTilemapMode();
 }
@@ -191,8 +281,8 @@ void PixelsMovement::setFastMode(const bool fastMode)
   bool redraw = (m_fastMode && !fastMode);
   m_fastMode = fastMode;
   if (m_needsRotSpriteRedraw && redraw) {
-    redrawExtraImage();
-    update_screen_for_document(m_document);
+    // Keep the fast preview until the RotSprite version is ready
+    startQualityRender();
     m_needsRotSpriteRedraw = false;
   }
 }
@@ -771,7 +861,8 @@ void PixelsMovement::getDraggedImageCopy(std::unique_ptr<Image>& outputImage,
     pixelFormat = m_site.sprite()->pixelFormat();
   }
 
-  std::unique_ptr<Image> image(Image::create(pixelFormat, imgSize.w, imgSize.h));
+  const ImageSpec spec(ColorMode(pixelFormat), imgSize.w, imgSize.h);
+  std::unique_ptr<Image> image(Image::create(spec, ImageBufferPool::instance()->get(spec)));
 
   drawImage(m_currentData, image.get(), gfx::PointF(bounds.origin()), false);
 
@@ -893,6 +984,10 @@ void PixelsMovement::stampImage(bool finalStamp)
   const gfx::Size deltaB(currentAlignedBounds.x2() - initialAlignedBounds.x2(),
                          currentAlignedBounds.y2() - initialAlignedBounds.y2());
 
+  // Transformed images of the cels that are not tilemaps
+  std::vector<StampJob> jobs;
+  jobs.reserve(cels.size());
+
   for (Cel* target : cels) {
     // We'll re-create the transformation for the other cels
     if (target != currentCel) {
@@ -930,13 +1025,20 @@ void PixelsMovement::stampImage(bool finalStamp)
         m_site.tilemapMode(TilemapMode::Pixels);
         m_site.tilesetMode(TilesetMode::Auto);
       }
-      reproduceAllTransformationsWithInnerCmds();
+      reproduceAllTransformationsWithInnerCmds(false);
     }
 
-    redrawExtraImage();
-    stampExtraCelImage();
+    if (m_site.tilemapMode() == TilemapMode::Tiles && m_site.layer()->isTilemap()) {
+      redrawExtraImage();
+      stampExtraCelImage();
+    }
+    else {
+      addStampJob(jobs);
+    }
   }
 
+  stampJobs(jobs);
+
   m_initialMask0->replace(initialMask0);
   m_initialMask->replace(initialMask);
   m_currentMask->replace(currentMask);
@@ -960,8 +1062,13 @@ void PixelsMovement::stampExtraCelImage()
   if (!image)
     return;
 
-  const Cel* cel = m_extraCel->cel();
+  stampImageInSite(image, m_extraCel->cel()->position());
+}
 
+// Stamps the given image (with the size of the extra cel) at the
+// given position of the active cel in m_site.
+void PixelsMovement::stampImageInSite(const doc::Image* image, const gfx::Point& position)
+{
   // Expand the canvas to paste the image in the fully visible
   // portion of sprite.
   ExpandCelCanvas expand(m_site, m_site.layer(), TiledMode::NONE, m_tx, ExpandCelCanvas::None);
@@ -970,21 +1077,86 @@ void PixelsMovement::stampExtraCelImage()
   gfx::Size canvasImageSize = image->size();
   if (m_site.tilemapMode() == TilemapMode::Tiles) {
     doc::Grid grid = m_site.grid();
-    dstPt = grid.canvasToTile(cel->position());
+    dstPt = grid.canvasToTile(position);
     canvasImageSize = grid.tileToCanvas(gfx::Rect(dstPt, canvasImageSize)).size();
   }
   else {
-    dstPt = cel->position() - expand.getCel()->position();
+    dstPt = position - expand.getCel()->position();
   }
 
   // We cannot use cel->bounds() because cel->image() is nullptr
-  expand.validateDestCanvas(gfx::Region(gfx::Rect(cel->position(), canvasImageSize)));
+  expand.validateDestCanvas(gfx::Region(gfx::Rect(position, canvasImageSize)));
 
   expand.getDestCanvas()->copy(image, gfx::Clip(dstPt, image->bounds()));
 
   expand.commit();
 }
 
+void PixelsMovement::addStampJob(std::vector<StampJob>& jobs)
+{
+  const gfx::Rect bounds = m_currentData.transformedBounds();
+  if (bounds.isEmpty())
+    return;
+
+  StampJob job;
+  job.layer = m_site.layer();
+  job.frame = m_site.frame();
+  job.tilemapMode = m_site.tilemapMode();
+  job.tilesetMode = m_site.tilesetMode();
+  job.position = bounds.origin();
+  job.corners = m_currentData.transformedCorners();
+  job.pt = gfx::PointF(bounds.origin());
+  job.rotAlgo = rotationAlgorithm(m_currentData);
+
+  // The original layer is rendered here in the UI thread, and the
+  // mask is copied as m_initialMask is modified for each cel (the
+  // m_originalImage is re-created for each cel so we can keep a
+  // reference to it).
+  job.dst.reset(Image::create(m_site.sprite()->pixelFormat(), bounds.w, bounds.h));
+  drawImageBackground(job.dst.get(), job.corners.bounds(m_currentData.cornerThick()), job.pt, true);
+  job.src = m_originalImage;
+  if (m_initialMask->bitmap())
+    job.mask.reset(Image::createCopy(m_initialMask->bitmap()));
+
+  jobs.push_back(std::move(job));
+}
+
+void PixelsMovement::stampJobs(std::vector<StampJob>& jobs)
+{
+  std::atomic<bool> notEnoughMemory = false;
+
+  // Transform the cels to stamp in parallel when we edit multiple cels
+  doc::TaskGroup tasks;
+  for (StampJob& job : jobs) {
+    tasks.run([&job, &notEnoughMemory] {
+      doc::algorithm::RotSprite rotSprite;
+      if (!draw_parallelogram(job.rotAlgo,
+                              rotSprite,
+                              job.dst.get(),
+                              job.src.get(),
+                              job.mask.get(),
+                              job.corners,
+                              job.pt)) {
+        notEnoughMemory = true;
+      }
+    });
+  }
+  tasks.wait();
+
+  if (notEnoughMemory)
+    StatusBar::instance()->showTip(1000, Strings::statusbar_tips_not_enough_rotsprite_memory());
+
+  // Stamp the images in the same order as the cels were given (so the
+  // commands are added to the transaction in a predictable order).
+  for (const StampJob& job : jobs) {
+    m_site.layer(job.layer);
+    m_site.frame(job.frame);
+    m_site.tilemapMode(job.tilemapMode);
+    m_site.tilesetMode(job.tilesetMode);
+    stampImageInSite(job.dst.get(), job.position);
+  }
+}
+
 void PixelsMovement::dropImageTemporarily()
 {
   m_isDragging = false;
@@ -1111,6 +1283,9 @@ void PixelsMovement::redrawExtraImage(Transformation* transformation)
   if (!transformation)
     transformation = &m_currentData;
 
+  // Discard the pending RotSprite render (if any)
+  ++m_qualityRender->generation;
+
   int t, opacity =
            (m_site.layer()->isImage() ? static_cast<LayerImage*>(m_site.layer())->opacity() : 255);
   Cel* cel = m_site.cel();
@@ -1163,6 +1338,69 @@ void PixelsMovement::redrawCurrentMask()
   drawMask(m_currentMask.get(), true);
 }
 
+void PixelsMovement::startQualityRender()
+{
+  const Image* extraImage = (m_extraCel ? m_extraCel->image() : nullptr);
+  const gfx::Rect extraBounds = m_currentData.transformedBounds();
+
+  // Tilemaps don't use RotSprite
+  if (!extraImage || m_site.tilemapMode() == TilemapMode::Tiles ||
+      extraImage->size() != extraBounds.size()) {
+    redrawExtraImage();
+    update_screen_for_document(m_document);
+    return;
+  }
+
+  const int generation = ++m_qualityRender->generation;
+
+  // Render the original layer in the UI thread (as the layer belongs
+  // to the document), and copy the image/mask to transform as they
+  // can be modified while the RotSprite is calculated.
+  const auto corners = m_currentData.transformedCorners();
+  const gfx::PointF pt(extraBounds.origin());
+  ImageRef dst(Image::create(extraImage->spec()));
+  drawImageBackground(dst.get(), corners.bounds(m_currentData.cornerThick()), pt, true);
+
+  ImageRef src(Image::createCopy(m_originalImage.get()));
+  src->setMaskColor(m_originalImage->maskColor());
+  ImageRef mask(m_initialMask->bitmap() ? Image::createCopy(m_initialMask->bitmap()) : nullptr);
+
+  quality_render_tasks().run([qr = m_qualityRender, generation, dst, src, mask, corners, pt] {
+    if (qr->generation != generation)
+      return;
+
+    // Keep the fast preview if there is not enough memory
+    doc::algorithm::RotSprite rotSprite;
+    if (!draw_parallelogram(tools::RotationAlgorithm::ROTSPRITE,
+                            rotSprite,
+                            dst.get(),
+                            src.get(),
+                            mask.get(),
+                            corners,
+                            pt)) {
+      return;
+    }
+
+    if (qr->generation != generation)
+      return;
+
+    ui::execute_from_ui_thread([qr, generation, dst] {
+      if (qr->owner && qr->generation == generation)
+        qr->owner->onQualityRenderReady(dst);
+    });
+  });
+}
+
+void PixelsMovement::onQualityRenderReady(const ImageRef& image)
+{
+  Image* extraImage = (m_extraCel ? m_extraCel->image() : nullptr);
+  if (!extraImage || extraImage->size() != image->size())
+    return;
+
+  extraImage->copy(image.get(), gfx::Clip(image->bounds()));
+  update_screen_for_document(m_document);
+}
+
 void PixelsMovement::drawImage(const Transformation& transformation,
                                doc::Image* dst,
                                const gfx::PointF& pt,
@@ -1185,34 +1423,45 @@ void PixelsMovement::drawImage(const Transformation& transformation,
     drawTransformedTilemap(transformation, dst, m_originalImage.get(), m_initialMask.get());
   }
   else {
-    dst->setMaskColor(m_site.sprite()->transparentColor());
-    dst->clear(dst->maskColor());
-
-    if (renderOriginalLayer) {
-      render::Render render;
-      render.renderLayer(dst,
-                         m_site.layer(),
-                         m_site.frame(),
-                         gfx::Clip(bounds.x - pt.x, bounds.y - pt.y, bounds),
-                         BlendMode::SRC);
-    }
+    drawImageBackground(dst, bounds, pt, renderOriginalLayer);
+    drawParallelogram(transformation, dst, m_originalImage.get(), m_initialMask.get(), corners, pt);
+  }
+}
 
-    color_t maskColor = m_maskColor;
+// Clears the "dst" image and draws the original layer (if
+// "renderOriginalLayer" is true) below the transformed pixels. It
+// also sets the mask color of m_originalImage to draw it with
+// drawParallelogram().
+void PixelsMovement::drawImageBackground(doc::Image* dst,
+                                         const gfx::Rect& bounds,
+                                         const gfx::PointF& pt,
+                                         const bool renderOriginalLayer)
+{
+  dst->setMaskColor(m_site.sprite()->transparentColor());
+  dst->clear(dst->maskColor());
 
-    // In case that Opaque option is enabled, or if we are drawing the
-    // image for the clipboard (renderOriginalLayer is false), we use a
-    // dummy mask color to call drawParallelogram(). In this way all
-    // pixels will be opaqued (all colors are copied)
-    if (m_opaque || !renderOriginalLayer) {
-      if (m_originalImage->pixelFormat() == IMAGE_INDEXED)
-        maskColor = -1;
-      else
-        maskColor = 0;
-    }
-    m_originalImage->setMaskColor(maskColor);
+  if (renderOriginalLayer) {
+    render::Render render;
+    render.renderLayer(dst,
+                       m_site.layer(),
+                       m_site.frame(),
+                       gfx::Clip(bounds.x - pt.x, bounds.y - pt.y, bounds),
+                       BlendMode::SRC);
+  }
 
-    drawParallelogram(transformation, dst, m_originalImage.get(), m_initialMask.get(), corners, pt);
+  color_t maskColor = m_maskColor;
+
+  // In case that Opaque option is enabled, or if we are drawing the
+  // image for the clipboard (renderOriginalLayer is false), we use a
+  // dummy mask color to call drawParallelogram(). In this way all
+  // pixels will be opaqued (all colors are copied)
+  if (m_opaque || !renderOriginalLayer) {
+    if (m_originalImage->pixelFormat() == IMAGE_INDEXED)
+      maskColor = -1;
+    else
+      maskColor = 0;
   }
+  m_originalImage->setMaskColor(maskColor);
 }
 
 void PixelsMovement::drawMask(doc::Mask* mask, bool shrink)
@@ -1239,12 +1488,7 @@ void PixelsMovement::drawMask(doc::Mask* mask, bool shrink)
     mask->unfreeze();
 }
 
-void PixelsMovement::drawParallelogram(const Transformation& transformation,
-                                       doc::Image* dst,
-                                       const doc::Image* src,
-                                       const doc::Mask* mask,
-                                       const Transformation::Corners& corners,
-                                       const gfx::PointF& leftTop)
+tools::RotationAlgorithm PixelsMovement::rotationAlgorithm(const Transformation& transformation)
 {
   tools::RotationAlgorithm rotAlgo = Preferences::instance().selection.rotationAlgorithm();
 
@@ -1265,45 +1509,24 @@ void PixelsMovement::drawParallelogram(const Transformation& transformation,
     rotAlgo = tools::RotationAlgorithm::FAST;
   }
 
-retry:; // In case that we don't have enough memory for RotSprite
-        // we can try with the fast algorithm anyway.
-
-  switch (rotAlgo) {
-    case tools::RotationAlgorithm::FAST:
-      doc::algorithm::parallelogram(dst,
-                                    src,
-                                    (mask ? mask->bitmap() : nullptr),
-                                    int(corners.leftTop().x - leftTop.x),
-                                    int(corners.leftTop().y - leftTop.y),
-                                    int(corners.rightTop().x - leftTop.x),
-                                    int(corners.rightTop().y - leftTop.y),
-                                    int(corners.rightBottom().x - leftTop.x),
-                                    int(corners.rightBottom().y - leftTop.y),
-                                    int(corners.leftBottom().x - leftTop.x),
-                                    int(corners.leftBottom().y - leftTop.y));
-      break;
-
-    case tools::RotationAlgorithm::ROTSPRITE:
-      try {
-        doc::algorithm::rotsprite_image(dst,
-                                        src,
-                                        (mask ? mask->bitmap() : nullptr),
-                                        int(corners.leftTop().x - leftTop.x),
-                                        int(corners.leftTop().y - leftTop.y),
-                                        int(corners.rightTop().x - leftTop.x),
-                                        int(corners.rightTop().y - leftTop.y),
-                                        int(corners.rightBottom().x - leftTop.x),
-                                        int(corners.rightBottom().y - leftTop.y),
-                                        int(corners.leftBottom().x - leftTop.x),
-                                        int(corners.leftBottom().y - leftTop.y));
-      }
-      catch (const std::bad_alloc&) {
-        StatusBar::instance()->showTip(1000, Strings::statusbar_tips_not_enough_rotsprite_memory());
+  return rotAlgo;
+}
 
-        rotAlgo = tools::RotationAlgorithm::FAST;
-        goto retry;
-      }
-      break;
+void PixelsMovement::drawParallelogram(const Transformation& transformation,
+                                       doc::Image* dst,
+                                       const doc::Image* src,
+                                       const doc::Mask* mask,
+                                       const Transformation::Corners& corners,
+                                       const gfx::PointF& leftTop)
+{
+  if (!draw_parallelogram(rotationAlgorithm(transformation),
+                          m_rotSprite,
+                          dst,
+                          src,
+                          (mask ? mask->bitmap() : nullptr),
+                          corners,
+                          leftTop)) {
+    StatusBar::instance()->showTip(1000, Strings::statusbar_tips_not_enough_rotsprite_memory());
   }
 }
 
@@ -1505,8 +1728,9 @@ bool PixelsMovement::gotoFrame(const doc::frame_t deltaFrame)
   return false;
 }
 
-// Reproduces all the inner commands in the active m_site
-void PixelsMovement::reproduceAllTransformationsWithInnerCmds()
+// Reproduces all the inner commands in the active m_site. The extra
+// cel is redrawn at the end only if "redrawExtraCel" is true.
+void PixelsMovement::reproduceAllTransformationsWithInnerCmds(const bool redrawExtraCel)
 {
   TRACEARGS("MOVPIXS: reproduceAllTransformationsWithInnerCmds",
             "layer",
@@ -1541,7 +1765,8 @@ void PixelsMovement::reproduceAllTransformationsWithInnerCmds()
     }
   }
 
-  redrawExtraImage();
+  if (redrawExtraCel)
+    redrawExtraImage();
   redrawCurrentMask();
   updateDocumentMask();
 }
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -12,16 +12,19 @@
 #include "app/context_access.h"
 #include "app/extra_cel.h"
 #include "app/site.h"
+#include "app/tools/rotation_algorithm.h"
 #include "app/transformation.h"
 #include "app/tx.h"
 #include "app/ui/editor/handle_type.h"
 #include "doc/algorithm/flip_type.h"
+#include "doc/algorithm/rotsprite.h"
 #include "doc/frame.h"
 #include "doc/image_ref.h"
 #include "gfx/size.h"
 #include "obs/connection.h"
 
 #include <memory>
+#include <vector>
 
 namespace doc {
 class Image;
@@ -136,15 +139,23 @@ private:
   bool editMultipleCels() const;
   void stampImage(bool finalStamp);
   void stampExtraCelImage();
+  void stampImageInSite(const doc::Image* image, const gfx::Point& position);
   void onPivotChange();
   void onRotationAlgorithmChange();
   void redrawExtraImage(Transformation* transformation = nullptr);
   void redrawCurrentMask();
+  void startQualityRender();
+  void onQualityRenderReady(const doc::ImageRef& image);
   void drawImage(const Transformation& transformation,
                  doc::Image* dst,
                  const gfx::PointF& pt,
                  const bool renderOriginalLayer);
+  void drawImageBackground(doc::Image* dst,
+                           const gfx::Rect& bounds,
+                           const gfx::PointF& pt,
+                           const bool renderOriginalLayer);
   void drawMask(doc::Mask* dst, bool shrink);
+  tools::RotationAlgorithm rotationAlgorithm(const Transformation& transformation);
   void drawParallelogram(const Transformation& transformation,
                          doc::Image* dst,
                          const doc::Image* src,
@@ -161,7 +172,7 @@ private:
   void flipOriginalImage(const doc::algorithm::FlipType flipType);
   void shiftOriginalImage(const int dx, const int dy, const double angle);
   CelList getEditableCels();
-  void reproduceAllTransformationsWithInnerCmds();
+  void reproduceAllTransformationsWithInnerCmds(const bool redrawExtraCel = true);
 
   void alignMasksAndTransformData(const Mask* initialMask0,
                                   const Mask* initialMask,
@@ -203,6 +214,24 @@ private:
   bool m_fastMode;
   bool m_needsRotSpriteRedraw;
 
+  // The RotSprite version of the extra cel (when the fast mode ends)
+  // is rendered in a background thread, and it's copied to the extra
+  // cel when it's ready (if the extra cel wasn't redrawn in the
+  // meantime).
+  struct QualityRender;
+  std::shared_ptr<QualityRender> m_qualityRender;
+
+  // Transformation of one cel to be stamped when editing multiple
+  // cels. These are calculated in parallel (RotSprite can be slow)
+  // and then stamped in the same order.
+  struct StampJob;
+  void addStampJob(std::vector<StampJob>& jobs);
+  void stampJobs(std::vector<StampJob>& jobs);
+
+  // Keeps the upscaled original image/mask between successive
+  // RotSprite transformations.
+  doc::algorithm::RotSprite m_rotSprite;
+
   // Commands used in the interaction with the transformed pixels.
   // This is used to re-create the whole interaction on each
   // modified cel when we are modifying multiples cels at the same
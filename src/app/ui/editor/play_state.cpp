@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2023  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -40,6 +40,8 @@ PlayState::PlayState(const bool playOnce, const bool playAll, const bool playSub
   , m_nextFrameTime(-1)
   , m_refFrame(0)
   , m_tag(nullptr)
+  , m_forward(1)
+  , m_renderFrameTime(0)
 {
   m_playTimer.Tick.connect(&PlayState::onPlaybackTick, this);
 
@@ -108,6 +110,7 @@ void PlayState::onEnterState(Editor* editor)
       m_tag);
     m_nextFrameTime = getNextFrameTime();
     m_curFrameTick = base::current_tick();
+    m_forward = (m_tag && m_tag->aniDir() == AniDir::REVERSE ? -1 : 1);
     m_playTimer.start();
   }
 }
@@ -222,11 +225,49 @@ void PlayState::onPlaybackTick()
       m_editor->stop();
       break;
     }
+    // Direction of the playback to guess the next frames
+    const frame_t delta = frame - m_editor->frame();
+    if (delta == 1 || delta == -1)
+      m_forward = delta;
+
     m_editor->setFrame(frame);
     m_nextFrameTime += getNextFrameTime();
   }
 
   m_curFrameTick = base::current_tick();
+
+  if (m_editor->isPlaying())
+    renderNextFramesInAdvance();
+}
+
+void PlayState::renderNextFramesInAdvance()
+{
+  // Render only if we have time before showing the next frame
+  if (m_nextFrameTime < 2.0 * m_renderFrameTime)
+    return;
+
+  // We don't know the exact next frames (e.g. with ping-pong tags
+  // or repeats), so we guess them from the range of the playing tag
+  // and the last direction of the playback.
+  const Tag* tag = m_playback.tag();
+  const frame_t first = (tag ? tag->fromFrame() : 0);
+  const frame_t last = (tag ? tag->toFrame() : m_editor->sprite()->lastFrame());
+
+  frame_t frame = m_editor->frame();
+  for (int i = 0; i < kFramesInAdvance; ++i) {
+    frame += m_forward;
+    if (frame > last)
+      frame = first;
+    else if (frame < first)
+      frame = last;
+
+    const base::tick_t t0 = base::current_tick();
+    if (m_editor->renderPlaybackFrameInAdvance(frame)) {
+      // Just one frame for each tick of the timer
+      m_renderFrameTime = base::current_tick() - t0;
+      break;
+    }
+  }
 }
 
 // Before executing any command, we stop the animation
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2022  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2001-2017  David Capello
 //
 // This program is distributed under the terms of
@@ -44,6 +44,10 @@ public:
 private:
   void onPlaybackTick();
 
+  // Renders the next frames in the playback cache of the editor if
+  // there is time left before the next frame must be shown.
+  void renderNextFramesInAdvance();
+
   // ContextObserver
   void onBeforeCommandExecution(CommandExecutionEvent& ev);
 
@@ -65,6 +69,13 @@ private:
   doc::frame_t m_refFrame;
   doc::Tag* m_tag;
 
+  // Number of frames after the current one that can be rendered in
+  // advance, the last direction of the playback (+1 or -1), and the
+  // time that took the last frame rendered in advance.
+  static constexpr int kFramesInAdvance = 4;
+  doc::frame_t m_forward;
+  base::tick_t m_renderFrameTime;
+
   obs::scoped_connection m_ctxConn;
 };
 
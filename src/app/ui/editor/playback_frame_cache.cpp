@@ -0,0 +1,126 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/ui/editor/playback_frame_cache.h"
+
+#include "base/debug.h"
+
+#include <algorithm>
+
+namespace app {
+
+bool PlaybackFrameCache::Key::sameOptions(const Key& other) const
+{
+  return undoState == other.undoState && spriteVersion == other.spriteVersion &&
+         layerId == other.layerId && nonactiveLayersOpacity == other.nonactiveLayersOpacity &&
+         newEngine == other.newEngine && scaleX == other.scaleX && scaleY == other.scaleY;
+}
+
+PlaybackFrameCache::PlaybackFrameCache(const std::size_t maxBytes) : m_maxBytes(maxBytes)
+{
+}
+
+os::SurfaceRef PlaybackFrameCache::get(const Key& key)
+{
+  if (key.frame != m_lastKey.frame || !key.sameOptions(m_lastKey))
+    m_lastBounds.clear();
+  if (std::find(m_lastBounds.begin(), m_lastBounds.end(), key.bounds) == m_lastBounds.end())
+    m_lastBounds.push_back(key.bounds);
+  m_lastKey = key;
+
+  if (const Entry* entry = find(key))
+    return entry->surface;
+  return nullptr;
+}
+
+bool PlaybackFrameCache::contains(const Key& key) const
+{
+  return (find(key) != nullptr);
+}
+
+bool PlaybackFrameCache::canAdd(const gfx::Size& size)
+{
+  const std::size_t bytes = surfaceBytes(size);
+  if (m_bytes + bytes <= m_maxBytes)
+    return true;
+
+  removeStaleEntries(m_lastKey);
+  return (m_bytes + bytes <= m_maxBytes);
+}
+
+bool PlaybackFrameCache::add(const Key& key, const os::SurfaceRef& surface)
+{
+  ASSERT(surface);
+  const gfx::Size size(surface->width(), surface->height());
+  const std::size_t bytes = surfaceBytes(size);
+  if (m_bytes + bytes > m_maxBytes) {
+    removeStaleEntries(key);
+    if (m_bytes + bytes > m_maxBytes)
+      return false;
+  }
+
+  std::vector<Entry>& entries = m_frames[key.frame];
+  for (Entry& entry : entries) {
+    if (entry.key == key) {
+      m_bytes -= surfaceBytes(gfx::Size(entry.surface->width(), entry.surface->height()));
+      entry.surface = surface;
+      m_bytes += bytes;
+      return true;
+    }
+  }
+  entries.push_back(Entry{ key, surface });
+  m_bytes += bytes;
+  return true;
+}
+
+void PlaybackFrameCache::clear()
+{
+  m_frames.clear();
+  m_bytes = 0;
+  m_lastKey = Key();
+  m_lastBounds.clear();
+}
+
+const PlaybackFrameCache::Entry* PlaybackFrameCache::find(const Key& key) const
+{
+  auto it = m_frames.find(key.frame);
+  if (it == m_frames.end())
+    return nullptr;
+
+  for (const Entry& entry : it->second) {
+    if (entry.key == key)
+      return &entry;
+  }
+  return nullptr;
+}
+
+void PlaybackFrameCache::removeStaleEntries(const Key& key)
+{
+  for (auto it = m_frames.begin(); it != m_frames.end();) {
+    std::vector<Entry>& entries = it->second;
+    for (auto jt = entries.begin(); jt != entries.end();) {
+      const bool stale = (!jt->key.sameOptions(key) ||
+                          std::find(m_lastBounds.begin(), m_lastBounds.end(), jt->key.bounds) ==
+                            m_lastBounds.end());
+      if (stale) {
+        m_bytes -= surfaceBytes(gfx::Size(jt->surface->width(), jt->surface->height()));
+        jt = entries.erase(jt);
+      }
+      else
+        ++jt;
+    }
+    if (entries.empty())
+      it = m_frames.erase(it);
+    else
+      ++it;
+  }
+}
+
+} // namespace app
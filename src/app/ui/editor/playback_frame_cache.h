@@ -0,0 +1,112 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_UI_EDITOR_PLAYBACK_FRAME_CACHE_H_INCLUDED
+#define APP_UI_EDITOR_PLAYBACK_FRAME_CACHE_H_INCLUDED
+#pragma once
+
+#include "doc/frame.h"
+#include "doc/object_id.h"
+#include "doc/object_version.h"
+#include "gfx/rect.h"
+#include "os/surface.h"
+
+#include <cstddef>
+#include <map>
+#include <vector>
+
+namespace undo {
+class UndoState;
+}
+
+namespace app {
+
+// Cache of rendered sprite frames used by the Editor while the
+// animation is being played, so a loop over an unchanged sprite
+// doesn't need to render each frame again. The cache has a limit of
+// memory, when it's full new frames are not added (instead of
+// removing old ones), so all frames of a loop that fit in the cache
+// stay there until the playback is stopped.
+class PlaybackFrameCache {
+public:
+  static constexpr std::size_t kDefaultMaxBytes = 256 * 1024 * 1024;
+
+  // Everything that can change the rendered pixels of a frame.
+  struct Key {
+    doc::frame_t frame = 0;
+    // Any change in the document (a new transaction, undo, redo)
+    // changes its current undo state.
+    const undo::UndoState* undoState = nullptr;
+    doc::ObjectVersion spriteVersion = 0;
+    doc::ObjectId layerId = doc::NullId;
+    int nonactiveLayersOpacity = 255;
+    bool newEngine = false;
+    double scaleX = 1.0;
+    double scaleY = 1.0;
+    // Bounds of the rendered area (in sprite coordinates for the new
+    // engine, or in zoomed coordinates for the old one).
+    gfx::Rect bounds;
+
+    bool sameOptions(const Key& other) const;
+    bool operator==(const Key& other) const
+    {
+      return frame == other.frame && sameOptions(other) && bounds == other.bounds;
+    }
+  };
+
+  explicit PlaybackFrameCache(std::size_t maxBytes = kDefaultMaxBytes);
+
+  // Returns the rendered surface for the given key (or nullptr if
+  // it's not in the cache). The bounds of the requested keys for the
+  // last requested frame are remembered (see lastBounds()).
+  os::SurfaceRef get(const Key& key);
+
+  // Returns true if the key is in the cache (without remembering its
+  // bounds as get() does).
+  bool contains(const Key& key) const;
+
+  // Returns true if a surface of the given size can be added.
+  bool canAdd(const gfx::Size& size);
+
+  // Adds the rendered surface for the given key, returns false if
+  // the cache is full.
+  bool add(const Key& key, const os::SurfaceRef& surface);
+
+  // Areas requested for the last frame with get(), used to render the
+  // same areas of the next frames in advance.
+  const std::vector<gfx::Rect>& lastBounds() const { return m_lastBounds; }
+
+  void clear();
+
+private:
+  struct Entry {
+    Key key;
+    os::SurfaceRef surface;
+  };
+
+  static std::size_t surfaceBytes(const gfx::Size& size)
+  {
+    return std::size_t(size.w) * size.h * 4;
+  }
+
+  const Entry* find(const Key& key) const;
+
+  // Removes entries that cannot be used anymore (e.g. the document
+  // was modified or the editor was scrolled/zoomed) to make room
+  // for the given key.
+  void removeStaleEntries(const Key& key);
+
+  std::map<doc::frame_t, std::vector<Entry>> m_frames;
+  std::size_t m_bytes = 0;
+  std::size_t m_maxBytes;
+
+  Key m_lastKey;
+  std::vector<gfx::Rect> m_lastBounds;
+};
+
+} // namespace app
+
+#endif
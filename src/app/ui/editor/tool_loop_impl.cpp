@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -483,10 +483,14 @@ public:
     , m_floodfillSrcImage(nullptr)
     , m_saveLastPoint(saveLastPoint)
   {
+    // Don't create a backup in the middle of the stroke
+    m_document->setDeferBackup(true);
   }
 
   ~PaintToolLoopBase()
   {
+    m_document->setDeferBackup(false);
+
     if (m_editor)
       m_editor->remove_observer(this);
   }
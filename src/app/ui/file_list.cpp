@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -85,6 +85,15 @@ void FileList::setCurrentFolder(IFileItem* folder)
   m_req_valid = false;
   m_selected = nullptr;
 
+  // Read the folder in a background thread, but wait a little so
+  // fast folders are displayed complete (without flickering)
+  m_folderReader.reset();
+  m_folderReader = std::make_unique<FolderReader>(folder);
+  m_folderReader->wait(100);
+  m_folderReader->update();
+  if (m_folderReader->isDone())
+    m_folderReader.reset();
+
   regenerateList();
 
   // As now we are in other folder, we can stop the generation of all
@@ -640,6 +649,19 @@ void FileList::onCurrentFolderChanged()
 
 void FileList::onMonitoringTick()
 {
+  // Cancel the thumbnails of items that aren't visible anymore after
+  // scrolling
+  if (View* view = View::getView(this)) {
+    const gfx::Point scroll = view->viewScroll();
+    if (scroll != m_thumbnailsScroll) {
+      m_thumbnailsScroll = scroll;
+      cancelHiddenThumbnails();
+    }
+  }
+
+  if (m_folderReader)
+    updateFolderReader();
+
   auto start = base::current_tick();
   while (!m_generateThumbnailsForTheseItems.empty() &&
          // No more than 200ms launching thumbnail generators
@@ -824,6 +846,35 @@ void FileList::makeSelectedFileitemVisible()
   view->setViewScroll(scroll);
 }
 
+void FileList::updateFolderReader()
+{
+  const bool modified = m_folderReader->update();
+  if (m_folderReader->isDone())
+    m_folderReader.reset();
+  if (!modified)
+    return;
+
+  regenerateList();
+
+  // Forget items that were removed from the folder
+  auto notListed = [this](IFileItem* fi) {
+    return (std::find(m_list.begin(), m_list.end(), fi) == m_list.end());
+  };
+  if (m_selected && notListed(m_selected))
+    m_selected = nullptr;
+  if (m_itemToGenerateThumbnail && notListed(m_itemToGenerateThumbnail))
+    m_itemToGenerateThumbnail = nullptr;
+  m_generateThumbnailsForTheseItems.erase(std::remove_if(m_generateThumbnailsForTheseItems.begin(),
+                                                         m_generateThumbnailsForTheseItems.end(),
+                                                         notListed),
+                                          m_generateThumbnailsForTheseItems.end());
+
+  m_req_valid = false;
+  invalidate();
+  if (View* view = View::getView(this))
+    view->updateView();
+}
+
 void FileList::regenerateList()
 {
   // get the children of the current folder
@@ -894,6 +945,36 @@ void FileList::generateThumbnailForFileItem(IFileItem* fi)
   }
 }
 
+void FileList::cancelHiddenThumbnails()
+{
+  View* view = View::getView(this);
+  if (!view)
+    return;
+
+  const gfx::Rect vp = view->viewportBounds();
+  std::vector<IFileItem*> visibleItems;
+  int i = 0;
+  for (IFileItem* fi : m_list) {
+    gfx::Rect itemBounds = getFileItemInfo(i).bounds;
+    itemBounds.offset(bounds().origin());
+    if (fi == m_selected || vp.intersects(itemBounds))
+      visibleItems.push_back(fi);
+    ++i;
+  }
+
+  // Remove hidden items from the list of pending thumbnails
+  m_generateThumbnailsForTheseItems.erase(
+    std::remove_if(m_generateThumbnailsForTheseItems.begin(),
+                   m_generateThumbnailsForTheseItems.end(),
+                   [&visibleItems](IFileItem* fi) {
+                     return std::find(visibleItems.begin(), visibleItems.end(), fi) ==
+                            visibleItems.end();
+                   }),
+    m_generateThumbnailsForTheseItems.end());
+
+  ThumbnailGenerator::instance()->setVisibleItems(visibleItems);
+}
+
 void FileList::delayThumbnailGenerationForSelectedItem()
 {
   if (m_selected && !m_selected->isFolder() && !m_selected->getThumbnail()) {
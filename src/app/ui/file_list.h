@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2022  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -18,6 +18,7 @@
 #include "ui/widget.h"
 
 #include <deque>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -88,10 +89,12 @@ private:
   ItemInfo getFileItemInfo(int i) const;
   void makeSelectedFileitemVisible();
   void regenerateList();
+  void updateFolderReader();
   int selectedIndex() const;
   void selectIndex(int index);
   void generateThumbnailForFileItem(IFileItem* fi);
   void delayThumbnailGenerationForSelectedItem();
+  void cancelHiddenThumbnails();
   bool hasThumbnailsPerItem() const { return m_zoom > 1.0; }
   bool isListView() const { return !hasThumbnailsPerItem(); }
   bool isIconView() const { return hasThumbnailsPerItem(); }
@@ -102,6 +105,10 @@ private:
 
   IFileItem* m_currentFolder;
   FileItemList m_list;
+
+  // Reads the content of m_currentFolder in a background thread
+  // (m_monitoringTimer adds the new items to m_list).
+  std::unique_ptr<FolderReader> m_folderReader;
   std::vector<ItemInfo> m_info;
 
   bool m_req_valid;
@@ -129,6 +136,10 @@ private:
   // a isIconView()
   std::deque<IFileItem*> m_generateThumbnailsForTheseItems;
 
+  // Scroll position of the view when we checked which thumbnails
+  // are visible for the last time.
+  gfx::Point m_thumbnailsScroll;
+
   // True if this listbox accepts selecting multiple items at the
   // same time.
   bool m_multiselect;
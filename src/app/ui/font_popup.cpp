@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2025  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -53,6 +53,8 @@
 
 #include <algorithm>
 #include <map>
+#include <mutex>
+#include <vector>
 
 namespace app {
 
@@ -69,6 +71,19 @@ struct ThumbnailInfo {
 
 static std::map<std::string, ThumbnailInfo> g_thumbnails;
 
+// A system font family (or a font file when "set" is nullptr).
+struct SystemFont {
+  std::string name;
+  text::FontStyle style;
+  text::FontStyleSetRef set;
+};
+
+// System fonts found by the first FontPopup, so the next popups
+// don't need to enumerate all the fonts again.
+static std::mutex g_systemFontsMutex;
+static std::vector<SystemFont> g_systemFonts;
+static bool g_systemFontsIndexed = false;
+
 } // namespace
 
 class FontItem : public ListItem {
@@ -183,12 +198,21 @@ private:
                                      text::FontStyle(),
                                      FontInfo::Flags::Antialias,
                                      text::FontHinting::Normal);
-      const text::FontRef font = fonts->fontFromInfo(fontInfoDefSize);
+      text::FontRef font = fonts->fontFromInfo(fontInfoDefSize);
       if (!font)
         return;
 
-      if (font->type() != text::FontType::SpriteSheet)
-        font->setSize(12.0f);
+      // Fonts are shared (cached by Fonts), so we ask for a 12pt font
+      // instead of changing the size of the default one.
+      if (font->type() != text::FontType::SpriteSheet) {
+        font = fonts->fontFromInfo(FontInfo(fontInfoDefSize,
+                                            12.0f,
+                                            text::FontStyle(),
+                                            FontInfo::Flags::Antialias,
+                                            text::FontHinting::Normal));
+        if (!font)
+          return;
+      }
 
       text::TextBlobRef blob = text::TextBlob::MakeWithShaper(fonts->fontMgr(), font, text());
       if (!blob)
@@ -456,98 +480,128 @@ bool FontPopup::onProcessMessage(ui::Message* msg)
 
 void FontPopup::listSystemFonts(base::task_token& token)
 {
-  Fonts* fonts = Fonts::instance();
-  bool empty = true;
-
-  // Get system fonts from laf-text module
-  const text::FontMgrRef fontMgr = fonts->fontMgr();
-  const int n = fontMgr->countFamilies();
-  if (n > 0) {
-    for (int i = 0; i < n; ++i) {
-      std::string name = fontMgr->familyName(i);
-      text::FontStyleSetRef set = fontMgr->familyStyleSet(i);
-      if (set && set->count() > 0) {
-        // Match the typeface with the default FontStyle (Normal
-        // weight, Upright slant, etc.)
-        auto typeface = set->matchStyle(text::FontStyle());
-        if (typeface) {
-          ui::execute_from_ui_thread([=, &token] {
-            if (token.canceled())
-              return;
-
-            auto* item = new FontItem(name, typeface->fontStyle(), set);
-            item->ThumbnailGenerated.connect([this] { onThumbnailGenerated(); });
+  // Adds the item of the given font in the list (from the UI thread)
+  auto addItem = [this](const SystemFont& systemFont) {
+    // Font file
+    if (!systemFont.set) {
+      m_listBox.addChild(new FontItem(systemFont.name));
+      return;
+    }
 
-            int j = m_listBox.getChildIndex(m_systemFontsSeparator) + 1;
-            for (; j < m_listBox.getItemsCount(); ++j) {
-              if (name < m_listBox.at(j)->text())
-                break;
-            }
-            m_listBox.insertChild(j, item);
-            layout();
-          });
-          empty = false;
-        }
-      }
+    auto* item = new FontItem(systemFont.name, systemFont.style, systemFont.set);
+    item->ThumbnailGenerated.connect([this] { onThumbnailGenerated(); });
 
-      if (token.canceled())
-        goto done;
+    int j = m_listBox.getChildIndex(m_systemFontsSeparator) + 1;
+    for (; j < m_listBox.getItemsCount(); ++j) {
+      if (systemFont.name < m_listBox.at(j)->text())
+        break;
     }
+    m_listBox.insertChild(j, item);
+    layout();
+  };
+
+  // Use the fonts found by a previous FontPopup
+  std::vector<SystemFont> systemFonts;
+  bool indexed;
+  {
+    const std::lock_guard lock(g_systemFontsMutex);
+    indexed = g_systemFontsIndexed;
+    if (indexed)
+      systemFonts = g_systemFonts;
   }
-  // Get fonts listing .ttf files TODO we should be able to remove
-  // this code in the future (probably after DirectWrite API is always
-  // available).
-  else {
-    base::paths fontDirs;
-    get_font_dirs(fontDirs);
-
-    // Create a list of fullpaths to every font found in all font
-    // directories (fontDirs)
-    base::paths files;
-    for (const auto& fontDir : fontDirs) {
-      for (const auto& file : base::list_files(fontDir, base::ItemType::Files)) {
-        files.push_back(base::join_path(fontDir, file));
+
+  if (!indexed) {
+    Fonts* fonts = Fonts::instance();
+
+    // Get system fonts from laf-text module
+    const text::FontMgrRef fontMgr = fonts->fontMgr();
+    const int n = fontMgr->countFamilies();
+    if (n > 0) {
+      for (int i = 0; i < n; ++i) {
+        std::string name = fontMgr->familyName(i);
+        text::FontStyleSetRef set = fontMgr->familyStyleSet(i);
+        if (set && set->count() > 0) {
+          // Match the typeface with the default FontStyle (Normal
+          // weight, Upright slant, etc.)
+          auto typeface = set->matchStyle(text::FontStyle());
+          if (typeface) {
+            SystemFont systemFont{ name, typeface->fontStyle(), set };
+            ui::execute_from_ui_thread([systemFont, addItem, &token] {
+              if (token.canceled())
+                return;
+
+              addItem(systemFont);
+            });
+            systemFonts.push_back(std::move(systemFont));
+          }
+        }
+
         if (token.canceled())
-          goto done;
+          return;
       }
     }
-
-    // Sort all files by "file title"
-    std::sort(files.begin(), files.end(), [](const std::string& a, const std::string& b) {
-      return base::utf8_icmp(base::get_file_title(a), base::get_file_title(b)) < 0;
-    });
-
-    for (auto& file : files) {
-      std::string ext = base::string_to_lower(base::get_file_extension(file));
-      if (ext == "ttf" || ext == "ttc" || ext == "otf" || ext == "dfont") {
-        ui::execute_from_ui_thread([this, file, &token] {
+    // Get fonts listing .ttf files TODO we should be able to remove
+    // this code in the future (probably after DirectWrite API is always
+    // available).
+    else {
+      base::paths fontDirs;
+      get_font_dirs(fontDirs);
+
+      // Create a list of fullpaths to every font found in all font
+      // directories (fontDirs)
+      base::paths files;
+      for (const auto& fontDir : fontDirs) {
+        for (const auto& file : base::list_files(fontDir, base::ItemType::Files)) {
+          files.push_back(base::join_path(fontDir, file));
           if (token.canceled())
             return;
+        }
+      }
+
+      // Sort all files by "file title"
+      std::sort(files.begin(), files.end(), [](const std::string& a, const std::string& b) {
+        return base::utf8_icmp(base::get_file_title(a), base::get_file_title(b)) < 0;
+      });
+
+      for (auto& file : files) {
+        std::string ext = base::string_to_lower(base::get_file_extension(file));
+        if (ext == "ttf" || ext == "ttc" || ext == "otf" || ext == "dfont") {
+          SystemFont systemFont{ file };
+          ui::execute_from_ui_thread([systemFont, addItem, &token] {
+            if (token.canceled())
+              return;
 
-          m_listBox.addChild(new FontItem(file));
-        });
-        empty = false;
+            addItem(systemFont);
+          });
+          systemFonts.push_back(std::move(systemFont));
+        }
       }
     }
+
+    // Save the index for the next FontPopups (only when the whole
+    // list was created)
+    if (token.canceled())
+      return;
+    {
+      const std::lock_guard lock(g_systemFontsMutex);
+      g_systemFonts = systemFonts;
+      g_systemFontsIndexed = true;
+    }
   }
 
-done:;
-  if (token.canceled())
-    return;
+  ui::execute_from_ui_thread([this, indexed, systemFonts, addItem, &token] {
+    if (token.canceled())
+      return;
 
-  if (empty) {
-    ui::execute_from_ui_thread([this, &token] {
-      if (token.canceled())
-        return;
+    if (indexed) {
+      for (const auto& systemFont : systemFonts)
+        addItem(systemFont);
+    }
 
+    if (systemFonts.empty()) {
       m_listBox.addChild(new ListItem(Strings::font_popup_empty_fonts()));
       layout();
-    });
-  }
-
-  ui::execute_from_ui_thread([this, &token] {
-    if (token.canceled())
-      return;
+    }
 
     // Stop the view relayout
     onTickRelayout();
@@ -0,0 +1,246 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/ui/input_recorder.h"
+
+#include "app/app.h"
+#include "app/context.h"
+#include "app/doc.h"
+#include "app/file/file.h"
+#include "app/ui/main_window.h"
+#include "base/fstream_path.h"
+#include "base/log.h"
+#include "os/event.h"
+#include "os/event_queue.h"
+#include "ui/manager.h"
+#include "ui/message.h"
+
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+namespace app {
+
+using namespace ui;
+
+namespace {
+
+// Recorded messages and their names in the file.
+struct {
+  MessageType type;
+  const char* name;
+} kMessages[] = {
+  { kMouseMoveMessage,   "mousemove" },
+  { kMouseDownMessage,   "mousedown" },
+  { kMouseUpMessage,     "mouseup"   },
+  { kDoubleClickMessage, "dblclick"  },
+  { kMouseWheelMessage,  "wheel"     },
+  { kKeyDownMessage,     "keydown"   },
+  { kKeyUpMessage,       "keyup"     },
+};
+
+bool is_key_message(const MessageType type)
+{
+  return (type == kKeyDownMessage || type == kKeyUpMessage);
+}
+
+} // anonymous namespace
+
+void InputRecording::load(const std::string& filename)
+{
+  std::ifstream f(FSTREAM_PATH(filename));
+  if (!f)
+    throw std::runtime_error("Cannot open input recording " + filename);
+
+  std::string line;
+  while (std::getline(f, line)) {
+    std::istringstream is(line);
+    std::string word;
+    if (line.empty() || line[0] == '#' || !(is >> word))
+      continue;
+
+    if (word == "doc") {
+      std::getline(is >> std::ws, docFilename);
+      continue;
+    }
+    if (word == "window") {
+      is >> windowSize.w >> windowSize.h;
+      continue;
+    }
+
+    // Lines with events start with the time
+    InputEvent ev;
+    ev.time = std::stoll(word);
+    is >> word;
+
+    bool found = false;
+    for (const auto& m : kMessages) {
+      if (word == m.name) {
+        ev.type = m.type;
+        found = true;
+        break;
+      }
+    }
+    if (!found)
+      continue;
+
+    int modifiers = 0;
+    if (is_key_message(ev.type)) {
+      int scancode = 0;
+      is >> scancode >> ev.unicodeChar >> ev.repeat >> modifiers;
+      ev.scancode = KeyScancode(scancode);
+    }
+    else {
+      int button = 0, pointerType = 0, preciseWheel = 0;
+      is >> ev.position.x >> ev.position.y >> button >> pointerType >> ev.pressure >>
+        ev.wheelDelta.x >> ev.wheelDelta.y >> preciseWheel >> modifiers;
+      ev.button = MouseButton(button);
+      ev.pointerType = PointerType(pointerType);
+      ev.preciseWheel = (preciseWheel != 0);
+    }
+    ev.modifiers = KeyModifiers(modifiers);
+
+    if (!is.fail())
+      events.push_back(ev);
+  }
+}
+
+InputRecorder::InputRecorder(Context* ctx, const std::string& filename)
+  : m_file(FSTREAM_PATH(filename))
+  , m_startTime(base::current_tick())
+{
+  if (!m_file) {
+    LOG(ERROR, "APP: Cannot create input recording %s\n", filename.c_str());
+    return;
+  }
+
+  m_file << "# Aseprite input recording\n";
+
+  // Save a copy of the active document so the replay starts with the
+  // same sprite.
+  if (Doc* doc = ctx->activeDocument()) {
+    const std::string docFilename = filename + ".aseprite";
+    std::unique_ptr<Doc> copy(doc->duplicate(DuplicateExactCopy));
+    copy->setFilename(docFilename);
+    if (save_document(ctx, copy.get()) == 0)
+      m_file << "doc " << docFilename << "\n";
+  }
+
+  if (MainWindow* mainWindow = App::instance()->mainWindow()) {
+    const gfx::Size size = mainWindow->bounds().size();
+    m_file << "window " << size.w << " " << size.h << "\n";
+  }
+
+  auto* manager = Manager::getDefault();
+  for (const auto& m : kMessages)
+    manager->addMessageFilter(m.type, this);
+}
+
+InputRecorder::~InputRecorder()
+{
+  if (auto* manager = Manager::getDefault())
+    manager->removeMessageFilterFor(this);
+}
+
+bool InputRecorder::onProcessMessage(Message* msg)
+{
+  InputEvent ev;
+  ev.time = base::current_tick() - m_startTime;
+  ev.type = msg->type();
+  ev.modifiers = msg->modifiers();
+
+  if (!is_key_message(ev.type)) {
+    auto* mouseMsg = static_cast<MouseMessage*>(msg);
+    ev.button = mouseMsg->button();
+    ev.pointerType = mouseMsg->pointerType();
+    ev.wheelDelta = mouseMsg->wheelDelta();
+    ev.preciseWheel = mouseMsg->preciseWheel();
+
+    // Coalesced mouse movements are recorded as individual events
+    for (const auto& sample : mouseMsg->history()) {
+      ev.position = sample.position;
+      ev.pressure = sample.pressure;
+      write(ev);
+    }
+    ev.position = mouseMsg->position();
+    ev.pressure = mouseMsg->pressure();
+    write(ev);
+  }
+  else {
+    auto* keyMsg = static_cast<KeyMessage*>(msg);
+    ev.scancode = keyMsg->scancode();
+    ev.unicodeChar = int(keyMsg->unicodeChar());
+    ev.repeat = keyMsg->repeat();
+    write(ev);
+  }
+
+  // Continue sending the message to its recipient
+  return false;
+}
+
+void InputRecorder::write(const InputEvent& ev)
+{
+  if (!m_file)
+    return;
+
+  const char* name = nullptr;
+  for (const auto& m : kMessages) {
+    if (ev.type == m.type) {
+      name = m.name;
+      break;
+    }
+  }
+  if (!name)
+    return;
+
+  m_file << ev.time << " " << name << " ";
+  if (is_key_message(ev.type)) {
+    m_file << int(ev.scancode) << " " << ev.unicodeChar << " " << ev.repeat;
+  }
+  else {
+    m_file << ev.position.x << " " << ev.position.y << " " << int(ev.button) << " "
+           << int(ev.pointerType) << " " << ev.pressure << " " << ev.wheelDelta.x << " "
+           << ev.wheelDelta.y << " " << (ev.preciseWheel ? 1 : 0);
+  }
+  m_file << " " << int(ev.modifiers) << "\n";
+}
+
+void queue_input_event(const InputEvent& ev)
+{
+  os::Event osEvent;
+  switch (ev.type) {
+    case kMouseMoveMessage:   osEvent.setType(os::Event::MouseMove); break;
+    case kMouseDownMessage:   osEvent.setType(os::Event::MouseDown); break;
+    case kMouseUpMessage:     osEvent.setType(os::Event::MouseUp); break;
+    case kDoubleClickMessage: osEvent.setType(os::Event::MouseDoubleClick); break;
+    case kMouseWheelMessage:  osEvent.setType(os::Event::MouseWheel); break;
+    case kKeyDownMessage:     osEvent.setType(os::Event::KeyDown); break;
+    case kKeyUpMessage:       osEvent.setType(os::Event::KeyUp); break;
+    default:                  return;
+  }
+
+  osEvent.setModifiers(ev.modifiers);
+  if (is_key_message(ev.type)) {
+    osEvent.setScancode(ev.scancode);
+    osEvent.setUnicodeChar(ev.unicodeChar);
+    osEvent.setRepeat(ev.repeat);
+  }
+  else {
+    osEvent.setPosition(ev.position);
+    osEvent.setButton(os::Event::MouseButton(ev.button));
+    osEvent.setPointerType(ev.pointerType);
+    osEvent.setPressure(ev.pressure);
+    osEvent.setWheelDelta(ev.wheelDelta);
+    osEvent.setPreciseWheel(ev.preciseWheel);
+  }
+  os::queue_event(osEvent);
+}
+
+} // namespace app
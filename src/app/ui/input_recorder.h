@@ -0,0 +1,91 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_UI_INPUT_RECORDER_H_INCLUDED
+#define APP_UI_INPUT_RECORDER_H_INCLUDED
+#pragma once
+
+#include "base/time.h"
+#include "gfx/point.h"
+#include "gfx/size.h"
+#include "ui/keys.h"
+#include "ui/message_type.h"
+#include "ui/mouse_button.h"
+#include "ui/pointer_type.h"
+#include "ui/widget.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace app {
+
+class Context;
+
+// One input message received by the UI.
+struct InputEvent {
+  base::tick_t time = 0; // Milliseconds since the recording started
+  ui::MessageType type = ui::kMouseMoveMessage;
+  // Mouse messages
+  gfx::Point position;
+  ui::MouseButton button = ui::kButtonNone;
+  ui::PointerType pointerType = ui::PointerType::Unknown;
+  float pressure = 0.0f;
+  gfx::Point wheelDelta;
+  bool preciseWheel = false;
+  // Keyboard messages
+  ui::KeyScancode scancode = ui::kKeyNil;
+  int unicodeChar = 0;
+  int repeat = 0;
+  // All messages
+  ui::KeyModifiers modifiers = ui::kKeyNoneModifier;
+};
+
+// A session of input messages to be replayed (e.g. in
+// editor_benchmark to use real sessions as benchmarks).
+struct InputRecording {
+  // Copy of the active document when the recording started (empty
+  // if there wasn't an active document).
+  std::string docFilename;
+  // Size of the main window when the recording started (the mouse
+  // positions are relative to it).
+  gfx::Size windowSize;
+  std::vector<InputEvent> events;
+
+  // Loads a file saved by InputRecorder, throws an exception if the
+  // file cannot be read.
+  void load(const std::string& filename);
+};
+
+// Records the mouse/keyboard messages received by the UI in a text
+// file (--record-input <filename> option). The messages are captured
+// as a ui::Manager message filter, so they are recorded even if the
+// recipient widget uses them.
+class InputRecorder : public ui::Widget {
+public:
+  // Saves a copy of the active document of the given context in
+  // "<filename>.aseprite" and starts the recording.
+  InputRecorder(Context* ctx, const std::string& filename);
+  ~InputRecorder();
+
+protected:
+  bool onProcessMessage(ui::Message* msg) override;
+
+private:
+  void write(const InputEvent& ev);
+
+  std::ofstream m_file;
+  base::tick_t m_startTime;
+};
+
+// Queues the given event in the laf-os event queue as if it were
+// generated by the OS (so it's converted to a ui::Message by the
+// ui::Manager). Must be called from the UI thread.
+void queue_input_event(const InputEvent& ev);
+
+} // namespace app
+
+#endif
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -33,6 +33,7 @@ struct KeyShortcutAction {
 };
 
 std::vector<KeyShortcutAction> g_actions;
+int g_shortcutsVersion = 0;
 
 const std::vector<KeyShortcutAction>& actions()
 {
@@ -413,6 +414,18 @@ KeyPtr Key::MakeDragAction(WheelAction dragAction)
   return k;
 }
 
+// static
+int Key::shortcutsVersion()
+{
+  return g_shortcutsVersion;
+}
+
+void Key::invalidateShortcuts()
+{
+  m_shortcuts.reset();
+  ++g_shortcutsVersion;
+}
+
 const AppShortcuts& Key::shortcuts() const
 {
   if (!m_shortcuts) {
@@ -453,7 +466,7 @@ const AppShortcuts& Key::shortcuts() const
 void Key::add(const ui::Shortcut& shortcut, const KeySource source, KeyboardShortcuts& globalKeys)
 {
   m_adds.push_back(AppShortcut(source, shortcut));
-  m_shortcuts.reset();
+  invalidateShortcuts();
 
   // Remove the shortcut from other commands
   if (source == KeySource::ExtensionDefined || source == KeySource::UserDefined) {
@@ -566,14 +579,14 @@ void Key::disableShortcut(const ui::Shortcut& shortcut, const KeySource source)
   erase_shortcut(m_dels, source, shortcut);
 
   m_dels.push_back(AppShortcut(source, shortcut));
-  m_shortcuts.reset();
+  invalidateShortcuts();
 }
 
 void Key::reset()
 {
   erase_shortcuts(m_adds, KeySource::UserDefined);
   erase_shortcuts(m_dels, KeySource::UserDefined);
-  m_shortcuts.reset();
+  invalidateShortcuts();
 }
 
 void Key::copyOriginalToUser()
@@ -586,7 +599,7 @@ void Key::copyOriginalToUser()
   auto copy = m_adds;
   for (const auto& kv : copy)
     m_adds.push_back(AppShortcut(KeySource::UserDefined, kv));
-  m_shortcuts.reset();
+  invalidateShortcuts();
 }
 
 std::string Key::triggerString() const
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -148,6 +148,10 @@ public:
   explicit Key(const WheelAction action);
   static KeyPtr MakeDragAction(WheelAction dragAction);
 
+  // Number incremented each time the shortcuts of any key are
+  // modified (used by KeyboardShortcuts to invalidate its indexes).
+  static int shortcutsVersion();
+
   KeyType type() const { return m_type; }
   const AppShortcuts& shortcuts() const;
   const AppShortcuts& addsKeys() const { return m_adds; }
@@ -192,6 +196,8 @@ public:
   std::string triggerString() const;
 
 private:
+  void invalidateShortcuts();
+
   KeyType m_type;
   AppShortcuts m_adds;
   AppShortcuts m_dels;
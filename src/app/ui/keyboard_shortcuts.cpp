@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -35,6 +35,7 @@
 #include "tinyxml2.h"
 
 #include <algorithm>
+#include <functional>
 #include <set>
 #include <vector>
 
@@ -109,12 +110,83 @@ void KeyboardShortcuts::setKeys(const KeyboardShortcuts& keys, const bool cloneK
   else {
     m_keys = keys.m_keys;
   }
+  rebuildIndexes();
   UserChange();
 }
 
 void KeyboardShortcuts::clear()
 {
   m_keys.clear();
+  rebuildIndexes();
+}
+
+std::size_t KeyboardShortcuts::KeyIdHash::operator()(const KeyId& id) const
+{
+  std::size_t h = std::hash<const void*>()(id.ptr);
+  h = h * 31 + std::size_t(id.value);
+  h = h * 31 + std::size_t(id.type);
+  h = h * 31 + std::size_t(id.keyContext);
+  return h;
+}
+
+// static
+KeyboardShortcuts::KeyId KeyboardShortcuts::keyId(const Key* key)
+{
+  switch (key->type()) {
+    case KeyType::Command:   return { key->type(), key->command(), 0, key->keycontext() };
+    case KeyType::Tool:
+    case KeyType::Quicktool: return { key->type(), key->tool(), 0, KeyContext::Any };
+    case KeyType::Action:    return { key->type(), nullptr, int(key->action()), key->keycontext() };
+    case KeyType::WheelAction:
+    case KeyType::DragAction:
+      return { key->type(), nullptr, int(key->wheelAction()), KeyContext::Any };
+  }
+  return { key->type(), nullptr, 0, KeyContext::Any };
+}
+
+KeyPtr KeyboardShortcuts::findKey(const KeyId& id, const Params* params) const
+{
+  auto it = m_keysIndex.find(id);
+  if (it != m_keysIndex.end()) {
+    for (const KeyPtr& key : it->second) {
+      if (!params || key->params() == *params)
+        return key;
+    }
+  }
+  return nullptr;
+}
+
+void KeyboardShortcuts::addKey(const KeyPtr& key) const
+{
+  m_keys.push_back(key);
+  m_keysIndex[keyId(key.get())].push_back(key);
+
+  // New keys without shortcuts don't modify the shortcuts index
+  if (!key->shortcuts().empty())
+    m_shortcutsIndexVersion = -1;
+}
+
+void KeyboardShortcuts::rebuildIndexes() const
+{
+  m_keysIndex.clear();
+  for (const KeyPtr& key : m_keys)
+    m_keysIndex[keyId(key.get())].push_back(key);
+
+  m_shortcutsIndex.clear();
+  m_shortcutsIndexVersion = -1;
+}
+
+void KeyboardShortcuts::updateShortcutsIndex() const
+{
+  if (m_shortcutsIndexVersion == Key::shortcutsVersion())
+    return;
+
+  m_shortcutsIndex.clear();
+  for (std::size_t i = 0; i < m_keys.size(); ++i) {
+    for (const AppShortcut& shortcut : m_keys[i]->shortcuts())
+      m_shortcutsIndex[shortcut.toString()].push_back(i);
+  }
+  m_shortcutsIndexVersion = Key::shortcutsVersion();
 }
 
 void KeyboardShortcuts::importFile(XMLElement* rootElement, KeySource source)
@@ -445,81 +517,61 @@ KeyPtr KeyboardShortcuts::command(const char* commandName,
   if (!command)
     return nullptr;
 
-  for (KeyPtr& key : m_keys) {
-    if (key->type() == KeyType::Command && key->keycontext() == keyContext &&
-        key->command() == command && key->params() == params) {
-      return key;
-    }
-  }
+  if (KeyPtr key = findKey({ KeyType::Command, command, 0, keyContext }, &params))
+    return key;
 
   KeyPtr key = std::make_shared<Key>(command, params, keyContext);
-  m_keys.push_back(key);
+  addKey(key);
   return key;
 }
 
 KeyPtr KeyboardShortcuts::tool(tools::Tool* tool) const
 {
-  for (KeyPtr& key : m_keys) {
-    if (key->type() == KeyType::Tool && key->tool() == tool) {
-      return key;
-    }
-  }
+  if (KeyPtr key = findKey({ KeyType::Tool, tool, 0, KeyContext::Any }))
+    return key;
 
   KeyPtr key = std::make_shared<Key>(KeyType::Tool, tool);
-  m_keys.push_back(key);
+  addKey(key);
   return key;
 }
 
 KeyPtr KeyboardShortcuts::quicktool(tools::Tool* tool) const
 {
-  for (KeyPtr& key : m_keys) {
-    if (key->type() == KeyType::Quicktool && key->tool() == tool) {
-      return key;
-    }
-  }
+  if (KeyPtr key = findKey({ KeyType::Quicktool, tool, 0, KeyContext::Any }))
+    return key;
 
   KeyPtr key = std::make_shared<Key>(KeyType::Quicktool, tool);
-  m_keys.push_back(key);
+  addKey(key);
   return key;
 }
 
 KeyPtr KeyboardShortcuts::action(const KeyAction action, const KeyContext keyContext) const
 {
-  for (KeyPtr& key : m_keys) {
-    if (key->type() == KeyType::Action && key->action() == action &&
-        key->keycontext() == keyContext) {
-      return key;
-    }
-  }
+  if (KeyPtr key = findKey({ KeyType::Action, nullptr, int(action), keyContext }))
+    return key;
 
   KeyPtr key = std::make_shared<Key>(action, keyContext);
-  m_keys.push_back(key);
+  addKey(key);
   return key;
 }
 
 KeyPtr KeyboardShortcuts::wheelAction(const WheelAction wheelAction) const
 {
-  for (KeyPtr& key : m_keys) {
-    if (key->type() == KeyType::WheelAction && key->wheelAction() == wheelAction) {
-      return key;
-    }
-  }
+  if (KeyPtr key = findKey({ KeyType::WheelAction, nullptr, int(wheelAction), KeyContext::Any }))
+    return key;
 
   KeyPtr key = std::make_shared<Key>(wheelAction);
-  m_keys.push_back(key);
+  addKey(key);
   return key;
 }
 
 KeyPtr KeyboardShortcuts::dragAction(const WheelAction dragAction) const
 {
-  for (KeyPtr& key : m_keys) {
-    if (key->type() == KeyType::DragAction && key->wheelAction() == dragAction) {
-      return key;
-    }
-  }
+  if (KeyPtr key = findKey({ KeyType::DragAction, nullptr, int(dragAction), KeyContext::Any }))
+    return key;
 
   KeyPtr key = Key::MakeDragAction(dragAction);
-  m_keys.push_back(key);
+  addKey(key);
   return key;
 }
 
@@ -584,20 +636,50 @@ KeyPtr KeyboardShortcuts::findBestKeyFromMessage(const ui::Message* msg,
   int n = (contexts[0] != contexts[1] ? 2 : 1);
   KeyPtr bestKey = nullptr;
   const AppShortcut* bestShortcut = nullptr;
-  for (int i = 0; i < n; ++i) {
-    for (const KeyPtr& key : m_keys) {
-      // Skip keys that are not for the specific KeyType (e.g. only for commands).
-      if (filterByType.has_value() && key->type() != *filterByType)
-        continue;
-
-      const AppShortcut* shortcut = key->isPressed(msg, contexts[i]);
-      if (shortcut && (!bestKey || shortcut->fitsBetterThan(currentKeyContext,
-                                                            key->keycontext(),
-                                                            bestKey->keycontext(),
-                                                            *bestShortcut))) {
-        bestKey = key;
-        bestShortcut = shortcut;
-      }
+
+  auto checkKey = [&](const KeyPtr& key, const KeyContext keyContext) {
+    // Skip keys that are not for the specific KeyType (e.g. only for commands).
+    if (filterByType.has_value() && key->type() != *filterByType)
+      return;
+
+    const AppShortcut* shortcut = key->isPressed(msg, keyContext);
+    if (shortcut && (!bestKey || shortcut->fitsBetterThan(currentKeyContext,
+                                                          key->keycontext(),
+                                                          bestKey->keycontext(),
+                                                          *bestShortcut))) {
+      bestKey = key;
+      bestShortcut = shortcut;
+    }
+  };
+
+  // For key messages we check only the keys that have a shortcut
+  // equal to the pressed key (the same comparison that
+  // ui::Shortcut::isPressed() does), in the same order as m_keys.
+  if (const auto* keyMsg = dynamic_cast<const ui::KeyMessage*>(msg)) {
+    updateShortcutsIndex();
+
+    std::vector<std::size_t> candidates;
+    auto addCandidates = [this, &candidates](const ui::Shortcut& shortcut) {
+      auto it = m_shortcutsIndex.find(shortcut.toString());
+      if (it != m_shortcutsIndex.end())
+        candidates.insert(candidates.end(), it->second.begin(), it->second.end());
+    };
+    if (keyMsg->scancode())
+      addCandidates(ui::Shortcut(keyMsg->modifiers(), keyMsg->scancode(), 0));
+    if (keyMsg->unicodeChar())
+      addCandidates(ui::Shortcut(keyMsg->modifiers(), ui::kKeyNil, keyMsg->unicodeChar()));
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    for (int i = 0; i < n; ++i) {
+      for (const std::size_t j : candidates)
+        checkKey(m_keys[j], contexts[i]);
+    }
+  }
+  else {
+    for (int i = 0; i < n; ++i) {
+      for (const KeyPtr& key : m_keys)
+        checkKey(key, contexts[i]);
     }
   }
   return bestKey;
@@ -703,6 +785,7 @@ void KeyboardShortcuts::clearMouseWheelKeys()
     else
       ++it;
   }
+  rebuildIndexes();
 }
 
 void KeyboardShortcuts::addMissingMouseWheelKeys()
@@ -714,7 +797,7 @@ void KeyboardShortcuts::addMissingMouseWheelKeys()
     });
     if (it == m_keys.end()) {
       KeyPtr key = std::make_shared<Key>((WheelAction)action);
-      m_keys.push_back(key);
+      addKey(key);
     }
 
     // Drag actions
@@ -723,7 +806,7 @@ void KeyboardShortcuts::addMissingMouseWheelKeys()
     });
     if (it == m_keys.end()) {
       KeyPtr key = Key::MakeDragAction((WheelAction)action);
-      m_keys.push_back(key);
+      addKey(key);
     }
   }
 }
@@ -737,38 +820,38 @@ void KeyboardShortcuts::setDefaultMouseWheelKeys(const bool zoomWithWheel)
   key->add(Shortcut(zoomWithWheel ? kKeyNoneModifier : kKeyCtrlModifier, kKeyNil, 0),
            KeySource::Original,
            *this);
-  m_keys.push_back(key);
+  addKey(key);
 
   if (!zoomWithWheel) {
     key = std::make_shared<Key>(WheelAction::VScroll);
     key->add(Shortcut(kKeyNoneModifier, kKeyNil, 0), KeySource::Original, *this);
-    m_keys.push_back(key);
+    addKey(key);
   }
 
   key = std::make_shared<Key>(WheelAction::HScroll);
   key->add(Shortcut(kKeyShiftModifier, kKeyNil, 0), KeySource::Original, *this);
-  m_keys.push_back(key);
+  addKey(key);
 
   key = std::make_shared<Key>(WheelAction::FgColor);
   key->add(Shortcut(kKeyAltModifier, kKeyNil, 0), KeySource::Original, *this);
-  m_keys.push_back(key);
+  addKey(key);
 
   key = std::make_shared<Key>(WheelAction::BgColor);
   key->add(Shortcut((KeyModifiers)(kKeyAltModifier | kKeyShiftModifier), kKeyNil, 0),
            KeySource::Original,
            *this);
-  m_keys.push_back(key);
+  addKey(key);
 
   if (zoomWithWheel) {
     key = std::make_shared<Key>(WheelAction::BrushSize);
     key->add(Shortcut(kKeyCtrlModifier, kKeyNil, 0), KeySource::Original, *this);
-    m_keys.push_back(key);
+    addKey(key);
 
     key = std::make_shared<Key>(WheelAction::Frame);
     key->add(Shortcut((KeyModifiers)(kKeyCtrlModifier | kKeyShiftModifier), kKeyNil, 0),
              KeySource::Original,
              *this);
-    m_keys.push_back(key);
+    addKey(key);
   }
 }
 
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2025  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -13,6 +13,9 @@
 #include "obs/signal.h"
 
 #include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 namespace tinyxml2 {
 class XMLElement;
@@ -89,6 +92,32 @@ public:
   obs::signal<void()> UserChange;
 
 private:
+  // Identifies the command/tool/action of a key to find it without
+  // iterating all keys (params of commands are compared after the
+  // lookup).
+  struct KeyId {
+    KeyType type;
+    const void* ptr;
+    int value;
+    KeyContext keyContext;
+
+    bool operator==(const KeyId& other) const
+    {
+      return (type == other.type && ptr == other.ptr && value == other.value &&
+              keyContext == other.keyContext);
+    }
+  };
+
+  struct KeyIdHash {
+    std::size_t operator()(const KeyId& id) const;
+  };
+
+  static KeyId keyId(const Key* key);
+  KeyPtr findKey(const KeyId& id, const Params* params = nullptr) const;
+  void addKey(const KeyPtr& key) const;
+  void rebuildIndexes() const;
+  void updateShortcutsIndex() const;
+
   void exportKeys(tinyxml2::XMLElement* parent, KeyType type);
   static void exportShortcut(tinyxml2::XMLElement* parent,
                              const Key* key,
@@ -96,6 +125,16 @@ private:
                              bool removed);
 
   mutable Keys m_keys;
+
+  // Keys by their KeyId (in the same order as m_keys).
+  mutable std::unordered_map<KeyId, Keys, KeyIdHash> m_keysIndex;
+
+  // Indexes of m_keys by the string of each shortcut (two shortcuts
+  // are equal if they have the same string, see ui::Shortcut). It's
+  // rebuilt when it's used and the shortcuts of some key were
+  // modified (m_shortcutsIndexVersion != Key::shortcutsVersion()).
+  mutable std::unordered_map<std::string, std::vector<std::size_t>> m_shortcutsIndex;
+  mutable int m_shortcutsIndexVersion = -1;
 };
 
 inline std::string key_tooltip(const char* str,
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2025  Igara Studio S.A.
+// Copyright (C) 2025-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -168,6 +168,32 @@ TEST(KeyboardShortcuts, FramesSelection)
   EXPECT_COMMAND_FOR_KEY(SetLoopSection, kKeyF2, KeyContext::FramesSelection);
 }
 
+TEST(KeyboardShortcuts, FindKeysAfterModifications)
+{
+  ks->clear();
+
+  Params params;
+  params.set("target", "background");
+  KeyPtr a = ks->command(CommandId::Undo(), {}, KeyContext::Any);
+  KeyPtr b = ks->command(CommandId::Undo(), params, KeyContext::Any);
+  EXPECT_NE(a, b);
+  EXPECT_EQ(a, ks->command(CommandId::Undo(), {}, KeyContext::Any));
+  EXPECT_EQ(b, ks->command(CommandId::Undo(), params, KeyContext::Any));
+
+  DEFINE_KEY(Redo, kKeyY, KeyContext::Any);
+  EXPECT_COMMAND_FOR_KEY(Redo, kKeyY, KeyContext::Normal);
+
+  // Key shortcuts modified after the first lookup
+  DEFINE_USER_KEY(Undo, kKeyZ, KeyContext::Any);
+  EXPECT_COMMAND_FOR_KEY(Undo, kKeyZ, KeyContext::Normal);
+  ks->reset();
+  NO_COMMAND_FOR_KEY(kKeyZ, KeyContext::Normal);
+  EXPECT_COMMAND_FOR_KEY(Redo, kKeyY, KeyContext::Normal);
+
+  ks->clear();
+  NO_COMMAND_FOR_KEY(kKeyY, KeyContext::Normal);
+}
+
 int app_main(int argc, char* argv[])
 {
   os::SystemRef system = os::System::make();
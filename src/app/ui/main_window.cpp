@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -40,6 +40,7 @@
 #include "app/ui/workspace.h"
 #include "app/ui/workspace_tabs.h"
 #include "app/ui_context.h"
+#include "app/util/memory_usage.h"
 #include "base/fs.h"
 #include "os/event.h"
 #include "os/event_queue.h"
@@ -101,6 +102,7 @@ MainWindow::MainWindow()
 #ifdef ENABLE_SCRIPTING
   , m_devConsoleView(nullptr)
 #endif
+  , m_trimLazyImagesTimer(1000)
 {
   enableFlags(ALLOW_DROP);
   setNeedsTabletPressure(true);
@@ -198,10 +200,14 @@ void MainWindow::initialize()
   Strings::instance()->LanguageChange.connect([this] { onLanguageChange(); });
 
   initTheme();
+
+  m_trimLazyImagesTimer.Tick.connect([this] { onTrimLazyImages(); });
+  m_trimLazyImagesTimer.start();
 }
 
 MainWindow::~MainWindow()
 {
+  m_trimLazyImagesTimer.stop();
   m_timelineResizeConn.disconnect();
   m_colorBarResizeConn.disconnect();
   m_saveDockLayoutConn.disconnect();
@@ -809,4 +815,11 @@ void MainWindow::saveActiveLayout()
   m_layoutSelector->updateActiveLayout(layout);
 }
 
+void MainWindow::onTrimLazyImages()
+{
+  // Decoded images are not discarded while they are being used, so
+  // this is called from the UI thread between messages.
+  trim_lazy_images_caches(UIContext::instance());
+}
+
 } // namespace app
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -11,6 +11,7 @@
 
 #include "app/ui/tabs.h"
 #include "obs/connection.h"
+#include "ui/timer.h"
 #include "ui/window.h"
 
 #include <memory>
@@ -138,6 +139,7 @@ private:
   void saveTimelineConfiguration();
   void saveColorBarConfiguration();
   void saveActiveLayout();
+  void onTrimLazyImages();
 
   ui::TooltipManager* m_tooltipManager;
   Dock* m_dock;
@@ -165,6 +167,9 @@ private:
   obs::scoped_connection m_colorBarResizeConn;
   obs::scoped_connection m_saveDockLayoutConn;
   bool m_firstResize = true;
+
+  // Discards decoded lazy images from time to time (when it's safe).
+  ui::Timer m_trimLazyImagesTimer;
 };
 
 } // namespace app
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -54,6 +54,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <set>
+#include <vector>
 
 namespace app {
 
@@ -303,22 +304,13 @@ public:
     draw_color(g, box, app::Color::fromMask(), doc::ColorMode::RGB);
 
     doc::ImageRef tileImage;
-    if (auto t = this->tileset())
-      tileImage = t->get(palIdx);
+    doc::Tileset* tileset = this->tileset();
+    if (tileset)
+      tileImage = tileset->get(palIdx);
     if (tileImage) {
       int w = tileImage->width();
       int h = tileImage->height();
-      os::SurfaceRef surface =
-        os::System::instance()->makeRgbaSurface(w, h, get_current_color_space(g->display()));
-      convert_image_to_surface(tileImage.get(),
-                               get_current_palette(),
-                               surface.get(),
-                               0,
-                               0,
-                               0,
-                               0,
-                               w,
-                               h);
+      os::Surface* surface = getTileSurface(g->display(), tileset, palIdx, tileImage);
 
       ui::Paint paint;
       paint.blendMode(os::BlendMode::SrcOver);
@@ -328,7 +320,7 @@ public:
         sampling = os::Sampling(os::Sampling::Filter::Linear, os::Sampling::Mipmap::Nearest);
       }
 
-      g->drawSurface(surface.get(), gfx::Rect(0, 0, w, h), box, sampling, &paint);
+      g->drawSurface(surface, gfx::Rect(0, 0, w, h), box, sampling, &paint);
     }
     negColor = gfx::rgba(255, 255, 255);
   }
@@ -343,6 +335,52 @@ public:
   }
 
 private:
+  // Tiles converted to surfaces are kept between paints, so we only
+  // convert again the tiles that were modified (the version of the
+  // tile image is incremented on each change).
+  struct CachedTile {
+    doc::ObjectId imageId = doc::NullId;
+    doc::ObjectVersion version = 0;
+    os::SurfaceRef surface;
+  };
+
+  os::Surface* getTileSurface(ui::Display* display,
+                              const doc::Tileset* tileset,
+                              const int index,
+                              const doc::ImageRef& tileImage)
+  {
+    const doc::Palette* palette = get_current_palette();
+    os::ColorSpaceRef colorSpace = get_current_color_space(display);
+
+    // Discard all tiles if the tileset, palette, or color space changed
+    if (m_tilesetId != tileset->id() || m_paletteModifications != palette->getModifications() ||
+        m_colorSpace != colorSpace) {
+      m_tilesetId = tileset->id();
+      m_paletteModifications = palette->getModifications();
+      m_colorSpace = colorSpace;
+      m_tiles.clear();
+    }
+    if (index >= int(m_tiles.size()))
+      m_tiles.resize(tileset->size());
+
+    CachedTile& tile = m_tiles[index];
+    const int w = tileImage->width();
+    const int h = tileImage->height();
+    if (!tile.surface || tile.imageId != tileImage->id() ||
+        tile.version != tileImage->version() || tile.surface->width() != w ||
+        tile.surface->height() != h) {
+      tile.imageId = tileImage->id();
+      tile.version = tileImage->version();
+      tile.surface = os::System::instance()->makeRgbaSurface(w, h, colorSpace);
+      convert_image_to_surface(tileImage.get(), palette, tile.surface.get(), 0, 0, 0, 0, w, h);
+    }
+    return tile.surface.get();
+  }
+
+  doc::ObjectId m_tilesetId = doc::NullId;
+  int m_paletteModifications = -1;
+  os::ColorSpaceRef m_colorSpace;
+  std::vector<CachedTile> m_tiles;
 };
 
 PaletteView::PaletteView(bool editable,
@@ -816,6 +854,7 @@ void PaletteView::onPaint(ui::PaintEvent& ev)
   g->fillRect(theme->colors.editorFace(), bounds);
 
   // Draw palette/tileset entries
+  const gfx::Rect clipBounds = g->getClipBounds();
   int picksCount = m_selectedEntries.picks();
   int idxOffset = 0;
   int boxOffset = 0;
@@ -837,6 +876,12 @@ void PaletteView::onPaint(ui::PaintEvent& ev)
     }
 
     gfx::Rect box = getPaletteEntryBounds(i + boxOffset);
+
+    // Skip entries outside the area to be painted (e.g. when the
+    // view is scrolled only the new visible entries are painted)
+    if (!clipBounds.intersects(gfx::Rect(box).enlarge(childSpacing())))
+      continue;
+
     gfx::Color negColor;
     m_adapter->drawEntry(g, theme, i + idxOffset, i + boxOffset, childSpacing(), box, negColor);
     const int boxsize = boxSizePx();
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2021  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -18,7 +18,8 @@ RgbMapAlgorithmSelector::RgbMapAlgorithmSelector()
 {
   // addItem() must match the RgbMapAlgorithm enum
   static_assert(int(doc::RgbMapAlgorithm::DEFAULT) == 0 && int(doc::RgbMapAlgorithm::RGB5A3) == 1 &&
-                  int(doc::RgbMapAlgorithm::OCTREE) == 2,
+                  int(doc::RgbMapAlgorithm::OCTREE) == 2 &&
+                  int(doc::RgbMapAlgorithm::PRECOMPUTED) == 3,
                 "Unexpected doc::RgbMapAlgorithm values");
 
   setId("rgbmap_algorithm_selector");
@@ -26,6 +27,7 @@ RgbMapAlgorithmSelector::RgbMapAlgorithmSelector()
   addItem(Strings::rgbmap_algorithm_selector_default());
   addItem(Strings::rgbmap_algorithm_selector_rgb5a3());
   addItem(Strings::rgbmap_algorithm_selector_octree());
+  addItem(Strings::rgbmap_algorithm_selector_precomputed());
 
   algorithm(doc::RgbMapAlgorithm::DEFAULT);
 }
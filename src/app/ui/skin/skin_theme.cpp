@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -30,6 +30,7 @@
 #include "base/fs.h"
 #include "base/log.h"
 #include "base/string.h"
+#include "base/time.h"
 #include "base/utf8_decode.h"
 #include "fmt/format.h"
 #include "gfx/border.h"
@@ -139,6 +140,49 @@ public:
   }
 };
 
+namespace {
+
+// Retained surface with the last painting of a widget made with
+// SkinTheme::paintWidget(). It's blitted while the key (everything
+// that can change the look of the widget) is the same.
+class PaintCacheProperty : public ui::Property {
+public:
+  static constexpr const char* Name = "PaintCacheProperty";
+
+  // Big widgets are not cached to limit the memory usage.
+  static constexpr int kMaxArea = 512 * 512;
+
+  struct Key {
+    int generation = 0;
+    int scale = 0;
+    const ui::Style* style = nullptr;
+    gfx::Size size;
+    int styleFlags = 0;
+    gfx::Color bgColor = gfx::ColorNone;
+    std::string text;
+    const text::TextBlob* textBlob = nullptr;
+    float baseline = 0.0f;
+    int mnemonic = 0;
+    const os::Surface* icon = nullptr;
+
+    bool operator==(const Key& o) const
+    {
+      return generation == o.generation && scale == o.scale && style == o.style &&
+             size == o.size && styleFlags == o.styleFlags && bgColor == o.bgColor &&
+             text == o.text && textBlob == o.textBlob && baseline == o.baseline &&
+             mnemonic == o.mnemonic && icon == o.icon;
+    }
+    bool operator!=(const Key& o) const { return !operator==(o); }
+  };
+
+  PaintCacheProperty() : ui::Property(Name) {}
+
+  Key key;
+  os::SurfaceRef surface;
+};
+
+} // anonymous namespace
+
 static const char* g_cursor_names[kCursorTypes] = {
   "null",       // kNoCursor
   "normal",     // kArrowCursor
@@ -404,6 +448,7 @@ SkinTheme::~SkinTheme()
 void SkinTheme::onRegenerateTheme()
 {
   Preferences& pref = Preferences::instance();
+  ++m_paintCacheGeneration;
   BackwardCompatibility backward;
 
   // First we load the skin from default theme, which is more proper
@@ -474,22 +519,48 @@ void SkinTheme::loadSheet()
 
   // Load the skin sheet
   std::string sheet_filename(base::join_path(m_path, "sheet.png"));
-  os::SurfaceRef newSheet;
-  try {
-    newSheet = os::System::instance()->loadRgbaSurface(sheet_filename.c_str());
+  const base::Time t = base::get_modification_time(sheet_filename);
+  const std::string stamp = fmt::format("{} {:04}{:02}{:02}{:02}{:02}{:02}",
+                                        base::file_size(sheet_filename),
+                                        t.year,
+                                        t.month,
+                                        t.day,
+                                        t.hour,
+                                        t.minute,
+                                        t.second);
+
+  CachedSheet& cached = m_sheetsCache[sheet_filename];
+  if (!cached.unscaled || cached.stamp != stamp) {
+    os::SurfaceRef newSheet;
+    try {
+      newSheet = system->loadRgbaSurface(sheet_filename.c_str());
+    }
+    catch (...) {
+      // Ignore the error, newSheet is nullptr and we will throw our own
+      // exception.
+    }
+    if (!newSheet) {
+      m_sheetsCache.erase(sheet_filename);
+      throw base::Exception("Error loading %s file", sheet_filename.c_str());
+    }
+
+    newSheet->setImmutable();
+    cached.stamp = stamp;
+    cached.unscaled = newSheet;
+    cached.scaled = nullptr;
   }
-  catch (...) {
-    // Ignore the error, newSheet is nullptr and we will throw our own
-    // exception.
+
+  // Scale the sheet only if the UI scale has changed.
+  const int scale = guiscale();
+  if (!cached.scaled || cached.scale != scale) {
+    cached.scaled = cached.unscaled->applyScale(scale);
+    cached.scaled->setImmutable();
+    cached.scale = scale;
   }
-  if (!newSheet)
-    throw base::Exception("Error loading %s file", sheet_filename.c_str());
 
   // Set the unscaled and scaled version of the sprite sheet.
-  m_unscaledSheet = newSheet;
-  m_unscaledSheet->setImmutable();
-  m_sheet = newSheet->applyScale(guiscale());
-  m_sheet->setImmutable();
+  m_unscaledSheet = cached.unscaled;
+  m_sheet = cached.scaled;
 
   // Reset sprite sheet and font of all layer styles (to avoid
   // dangling pointers to os::Surface or text::Font).
@@ -1800,6 +1871,61 @@ void SkinTheme::paintComboBoxEntry(ui::PaintEvent& ev)
   drawEntryText(g, widget);
 }
 
+void SkinTheme::paintWidget(ui::Graphics* g,
+                            const ui::Widget* widget,
+                            const ui::Style* style,
+                            const gfx::Rect& bounds)
+{
+  if (!Preferences::instance().experimental.widgetRenderCache() || bounds.isEmpty() ||
+      bounds.w * bounds.h > PaintCacheProperty::kMaxArea) {
+    Theme::paintWidget(g, widget, style, bounds);
+    return;
+  }
+
+  PaintWidgetPartInfo info(widget);
+  PaintCacheProperty::Key key;
+  key.generation = m_paintCacheGeneration;
+  key.scale = guiscale();
+  key.style = style;
+  key.size = bounds.size();
+  key.styleFlags = info.styleFlags;
+  key.bgColor = info.bgColor;
+  key.text = (info.text ? *info.text : std::string());
+  key.textBlob = info.textBlob.get();
+  key.baseline = info.baseline;
+  key.mnemonic = info.mnemonic;
+  key.icon = info.icon;
+
+  auto cache = std::static_pointer_cast<PaintCacheProperty>(
+    widget->getProperty(PaintCacheProperty::Name));
+  if (!cache) {
+    cache = std::make_shared<PaintCacheProperty>();
+    // The cache is not part of the widget state, it's just the
+    // result of the last painting.
+    const_cast<Widget*>(widget)->setProperty(cache);
+  }
+
+  // Paint the widget again only if something that can change its look
+  // was modified.
+  if (!cache->surface || cache->key != key) {
+    if (!cache->surface || cache->surface->width() != bounds.w ||
+        cache->surface->height() != bounds.h) {
+      cache->surface =
+        os::System::instance()->makeRgbaSurface(bounds.w,
+                                                bounds.h,
+                                                g->getInternalSurface()->colorSpace());
+    }
+    cache->surface->clear();
+    {
+      Graphics cacheG(cache->surface);
+      paintWidgetPart(&cacheG, style, gfx::Rect(bounds.size()), info);
+    }
+    cache->key = key;
+  }
+
+  g->drawRgbaSurface(cache->surface.get(), bounds.x, bounds.y);
+}
+
 void SkinTheme::paintTextBox(ui::PaintEvent& ev)
 {
   Graphics* g = ev.graphics();
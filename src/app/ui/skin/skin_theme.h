@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2025  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2001-2017  David Capello
 //
 // This program is distributed under the terms of
@@ -92,6 +92,10 @@ public:
   void paintComboBoxEntry(ui::PaintEvent& ev) override;
   void paintTextBox(ui::PaintEvent& ev) override;
   void paintViewViewport(ui::PaintEvent& ev) override;
+  void paintWidget(ui::Graphics* g,
+                   const ui::Widget* widget,
+                   const ui::Style* style,
+                   const gfx::Rect& bounds) override;
 
   SkinPartPtr getToolPart(const char* toolId) const;
   os::Surface* getToolIcon(const char* toolId) const;
@@ -207,6 +211,18 @@ private:
   os::SurfaceRef m_sheet;
   // Contains the sheet surface as is, without any scale.
   os::SurfaceRef m_unscaledSheet;
+
+  // Decoded sheet.png files by path, so the PNG files aren't decoded
+  // again each time the theme is regenerated (e.g. when the UI scale
+  // is changed, or the default theme is loaded before the selected
+  // one).
+  struct CachedSheet {
+    std::string stamp; // Size and modification time of the file
+    os::SurfaceRef unscaled;
+    os::SurfaceRef scaled;
+    int scale = 0;
+  };
+  std::map<std::string, CachedSheet> m_sheetsCache;
   std::map<std::string, SkinPartPtr> m_parts_by_id;
   // Stores the same SkinParts as m_parts_by_id but unscaled, using the same keys.
   std::map<std::string, SkinPartPtr> m_unscaledParts_by_id;
@@ -224,6 +240,9 @@ private:
   text::FontRef m_miniFont;
   int m_preferredScreenScaling;
   int m_preferredUIScaling;
+  // Incremented each time the theme is regenerated to invalidate the
+  // retained surfaces of widgets (see SkinTheme::paintWidget()).
+  int m_paintCacheGeneration = 0;
 };
 
 }} // namespace app::skin
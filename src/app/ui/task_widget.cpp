@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -27,6 +27,7 @@ TaskWidget::TaskWidget(const Type type, base::task::func_t&& func)
   , m_monitorTimer(25)
   , m_cancelButton("Cancel")
   , m_progressBar(0, 100, 0)
+  , m_task(doc::TaskPriority::Interactive)
 {
   if (int(type) & int(kCanCancel)) {
     addChild(&m_cancelButton);
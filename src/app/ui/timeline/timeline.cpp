@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -255,6 +255,7 @@ Timeline::Timeline(TooltipManager* tooltipManager)
 
   m_ctxConn1 = m_context->BeforeCommandExecution.connect(&Timeline::onBeforeCommandExecution, this);
   m_ctxConn2 = m_context->AfterCommandExecution.connect(&Timeline::onAfterCommandExecution, this);
+  m_thumbnailReadyConn = m_thumbnails.ThumbnailReady.connect([this] { invalidate(); });
   m_context->documents().add_observer(this);
   m_context->add_observer(this);
 
@@ -395,6 +396,7 @@ void Timeline::detachDocument()
 
   if (m_document) {
     m_thumbnailsPrefConn.disconnect();
+    m_thumbnails.clear();
     m_document->remove_observer(this);
     m_document = nullptr;
   }
@@ -1654,6 +1656,8 @@ void Timeline::onResize(ui::ResizeEvent& ev)
 void Timeline::onPaint(ui::PaintEvent& ev)
 {
   Graphics* g = ev.graphics();
+  font()->metrics(&m_fontMetrics);
+
   bool noDoc = (m_document == NULL);
   if (noDoc)
     goto paintNoDoc;
@@ -1673,8 +1677,14 @@ void Timeline::onPaint(ui::PaintEvent& ev)
     layer_t layer, firstLayer, lastLayer;
     col_t frame, firstFrame, lastFrame;
 
-    const bool hasLayers = getDrawableLayers(&firstLayer, &lastLayer);
+    // Only the layers and frames that intersect the area that is
+    // being painted are drawn (e.g. when only one cel is invalidated
+    // because the mouse is over it).
+    const gfx::Rect clipBounds = g->getClipBounds();
+    const bool hasLayers = (getDrawableLayers(&firstLayer, &lastLayer) &&
+                            clipDrawableLayers(clipBounds, &firstLayer, &lastLayer));
     getDrawableFrames(&firstFrame, &lastFrame);
+    clipDrawableFrames(clipBounds, &firstFrame, &lastFrame);
 
     drawTop(g);
 
@@ -2125,6 +2135,43 @@ void Timeline::getDrawableFrames(col_t* firstFrame, col_t* lastFrame)
   *lastFrame = getFrameInXPos(viewScroll().x + availW);
 }
 
+// Reduces the [firstLayer, lastLayer] range to the layers which rows
+// intersect the given clipping bounds. Returns false if no row
+// intersects the clipping bounds.
+bool Timeline::clipDrawableLayers(const gfx::Rect& clip,
+                                  layer_t* firstLayer,
+                                  layer_t* lastLayer) const
+{
+  // The first layer is at the bottom of the timeline
+  auto rowIntersects = [this, &clip](const layer_t layer) {
+    const gfx::Rect rc = getPartBounds(Hit(PART_ROW, layer));
+    return (rc.y < clip.y2() && clip.y < rc.y2());
+  };
+
+  while (*firstLayer <= *lastLayer && !rowIntersects(*firstLayer))
+    ++*firstLayer;
+  while (*lastLayer >= *firstLayer && !rowIntersects(*lastLayer))
+    --*lastLayer;
+  return (*firstLayer <= *lastLayer);
+}
+
+// Reduces the [firstFrame, lastFrame] range to the frames which
+// columns intersect the given clipping bounds. At least one frame is
+// kept to draw empty rows (e.g. for layer headers).
+void Timeline::clipDrawableFrames(const gfx::Rect& clip, col_t* firstFrame, col_t* lastFrame) const
+{
+  const int x = getCelsBounds().x + m_separator_w - guiscale() - viewScroll().x;
+  auto columnIntersects = [this, &clip, x](const col_t frame) {
+    const int x1 = x + getFrameXPos(frame);
+    return (x1 < clip.x2() && clip.x < x1 + getFrameWidth(frame));
+  };
+
+  while (*firstFrame < *lastFrame && !columnIntersects(*firstFrame))
+    *firstFrame = col_t(*firstFrame + 1);
+  while (*lastFrame > *firstFrame && !columnIntersects(*lastFrame))
+    *lastFrame = col_t(*lastFrame - 1);
+}
+
 // Gets the range of columns used by the tag. Returns false if the tag
 // is not visible (or is partially visible) with the current timeline
 // adapter/view.
@@ -2164,10 +2211,10 @@ void Timeline::drawPart(ui::Graphics* g,
                     (is_clicked ? ui::Style::Layer::kSelected : 0) |
                     (is_disabled ? ui::Style::Layer::kDisabled : 0);
 
-  text::FontMetrics metrics;
-  font()->metrics(&metrics);
-  info.baseline = guiscaled_center(bounds.y, bounds.h, metrics.descent - metrics.ascent) -
-                  metrics.ascent;
+  info.baseline = guiscaled_center(bounds.y,
+                                   bounds.h,
+                                   m_fontMetrics.descent - m_fontMetrics.ascent) -
+                  m_fontMetrics.ascent;
 
   theme()->paintWidgetPart(g, style, bounds, info);
 }
@@ -2515,11 +2562,13 @@ void Timeline::drawCel(ui::Graphics* g,
     gfx::Rect thumb_bounds = gfx::Rect(bounds).shrink(skinTheme()->calcBorder(this, style));
 
     if (!thumb_bounds.isEmpty()) {
-      if (os::SurfaceRef surface =
-            thumb::get_cel_thumbnail(g->display(), cel, m_scaleUpToFit, thumb_bounds.size())) {
-        const int t = std::clamp(thumb_bounds.w / 8, 4, 16);
-        draw_checkered_grid(g, thumb_bounds, gfx::Size(t, t), docPref());
+      // The checkered grid is a placeholder until the thumbnail is
+      // rendered in background.
+      const int t = std::clamp(thumb_bounds.w / 8, 4, 16);
+      draw_checkered_grid(g, thumb_bounds, gfx::Size(t, t), docPref());
 
+      if (os::SurfaceRef surface =
+            m_thumbnails.get(g->display(), cel, m_scaleUpToFit, thumb_bounds.size())) {
         g->drawRgbaSurface(surface.get(),
                            thumb_bounds.center().x - surface->width() / 2,
                            thumb_bounds.center().y - surface->height() / 2);
@@ -2608,15 +2657,14 @@ void Timeline::drawCelOverlay(ui::Graphics* g)
     return;
 
   gfx::Rect rc = m_sprite->bounds().fitIn(gfx::Rect(m_thumbnailsOverlayBounds).shrink(1));
-  if (os::SurfaceRef surface =
-        thumb::get_cel_thumbnail(g->display(), cel, m_scaleUpToFit, rc.size())) {
-    draw_checkered_grid(g, rc, gfx::Size(8, 8) * ui::guiscale(), docPref());
+  draw_checkered_grid(g, rc, gfx::Size(8, 8) * ui::guiscale(), docPref());
 
+  if (os::SurfaceRef surface = m_thumbnails.get(g->display(), cel, m_scaleUpToFit, rc.size())) {
     g->drawRgbaSurface(surface.get(),
                        rc.center().x - surface->width() / 2,
                        rc.center().y - surface->height() / 2);
-    g->drawRect(gfx::rgba(0, 0, 0, 128), m_thumbnailsOverlayBounds);
   }
+  g->drawRect(gfx::rgba(0, 0, 0, 128), m_thumbnailsOverlayBounds);
 }
 
 void Timeline::drawCelLinkDecorators(ui::Graphics* g,
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -13,6 +13,7 @@
 #include "app/docs_observer.h"
 #include "app/loop_tag.h"
 #include "app/pref/preferences.h"
+#include "app/thumbnails.h"
 #include "app/ui/dockable.h"
 #include "app/ui/editor/editor_observer.h"
 #include "app/ui/input_chain_element.h"
@@ -29,6 +30,7 @@
 #include "gfx/color.h"
 #include "obs/connection.h"
 #include "obs/observable.h"
+#include "text/font_metrics.h"
 #include "ui/scroll_bar.h"
 #include "ui/timer.h"
 #include "ui/widget.h"
@@ -294,6 +296,8 @@ private:
   void setCursor(ui::Message* msg, const Hit& hit);
   bool getDrawableLayers(layer_t* firstLayer, layer_t* lastLayer);
   void getDrawableFrames(col_t* firstFrame, col_t* lastFrame);
+  bool clipDrawableLayers(const gfx::Rect& clip, layer_t* firstLayer, layer_t* lastLayer) const;
+  void clipDrawableFrames(const gfx::Rect& clip, col_t* firstFrame, col_t* lastFrame) const;
   bool getTagFrames(const doc::Tag* tag, col_t* fromFrame, col_t* toFrame) const;
   void drawPart(ui::Graphics* g,
                 const gfx::Rect& bounds,
@@ -450,6 +454,10 @@ private:
   // Data used to display columns in the timeline
   col_t m_ncols;
 
+  // Metrics of the font used in drawPart(), calculated for each paint
+  // event (instead of each drawn part).
+  text::FontMetrics m_fontMetrics;
+
   // Data used to display each row in the timeline
   std::vector<Row> m_rows;
 
@@ -491,6 +499,8 @@ private:
   Hit m_thumbnailsOverlayHit;
   gfx::Point m_thumbnailsOverlayDirection;
   obs::connection m_thumbnailsPrefConn;
+  thumb::CelThumbnails m_thumbnails;
+  obs::scoped_connection m_thumbnailReadyConn;
 
   // Temporal data used to move the range.
   struct MoveRange {
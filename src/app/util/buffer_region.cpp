@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2023  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -14,9 +14,148 @@
 #include "gfx/region.h"
 
 #include <algorithm>
+#include <cstring>
 
 namespace app {
 
+namespace {
+
+// Run-length encoding of pixels: each packet starts with a header
+// byte "h", if h < 128 then h+1 different pixels follow, in other
+// case the next pixel is repeated h-126 times (2 to 129 times).
+constexpr int kMaxLiterals = 128;
+constexpr int kMaxRun = 129;
+
+class RlePixelsEncoder {
+public:
+  RlePixelsEncoder(base::buffer& buffer, const int bytesPerPixel)
+    : m_buffer(buffer)
+    , m_bpp(bytesPerPixel)
+  {
+  }
+
+  void add(const uint8_t* pixels, const int n)
+  {
+    for (int i = 0; i < n; ++i, pixels += m_bpp)
+      addPixel(pixels);
+  }
+
+  void flush()
+  {
+    flushPixel();
+    writeLiterals();
+  }
+
+private:
+  void addPixel(const uint8_t* p)
+  {
+    if (m_count > 0 && std::memcmp(p, m_pixel, m_bpp) == 0) {
+      if (++m_count == kMaxRun) {
+        writeLiterals();
+        writeRun();
+      }
+      return;
+    }
+    flushPixel();
+    std::copy(p, p + m_bpp, m_pixel);
+    m_count = 1;
+  }
+
+  // Moves the current pixel to the literals (if it's not repeated)
+  // or writes it as a run.
+  void flushPixel()
+  {
+    if (m_count == 1) {
+      std::copy(m_pixel, m_pixel + m_bpp, m_literals + m_nliterals * m_bpp);
+      if (++m_nliterals == kMaxLiterals)
+        writeLiterals();
+    }
+    else if (m_count > 1) {
+      writeLiterals();
+      writeRun();
+    }
+    m_count = 0;
+  }
+
+  void writeLiterals()
+  {
+    if (m_nliterals == 0)
+      return;
+    m_buffer.push_back(uint8_t(m_nliterals - 1));
+    m_buffer.insert(m_buffer.end(), m_literals, m_literals + m_nliterals * m_bpp);
+    m_nliterals = 0;
+  }
+
+  void writeRun()
+  {
+    m_buffer.push_back(uint8_t(m_count + 126));
+    m_buffer.insert(m_buffer.end(), m_pixel, m_pixel + m_bpp);
+    m_count = 0;
+  }
+
+  base::buffer& m_buffer;
+  const int m_bpp;
+  uint8_t m_pixel[4];
+  int m_count = 0;
+  uint8_t m_literals[kMaxLiterals * 4];
+  int m_nliterals = 0;
+};
+
+class RlePixelsDecoder {
+public:
+  RlePixelsDecoder(const base::buffer& buffer, const int bytesPerPixel)
+    : m_it(buffer.data())
+    , m_end(buffer.data() + buffer.size())
+    , m_bpp(bytesPerPixel)
+  {
+  }
+
+  void read(uint8_t* pixels, int n)
+  {
+    while (n > 0) {
+      if (m_literals > 0) {
+        const int k = std::min(n, m_literals);
+        std::copy(m_it, m_it + k * m_bpp, pixels);
+        m_it += k * m_bpp;
+        pixels += k * m_bpp;
+        m_literals -= k;
+        n -= k;
+      }
+      else if (m_run > 0) {
+        const int k = std::min(n, m_run);
+        for (int i = 0; i < k; ++i, pixels += m_bpp)
+          std::copy(m_runPixel, m_runPixel + m_bpp, pixels);
+        m_run -= k;
+        n -= k;
+      }
+      else {
+        ASSERT(m_it < m_end);
+        if (m_it >= m_end)
+          return;
+
+        const int h = *(m_it++);
+        if (h < kMaxLiterals)
+          m_literals = h + 1;
+        else {
+          m_run = h - 126;
+          m_runPixel = m_it;
+          m_it += m_bpp;
+        }
+      }
+    }
+  }
+
+private:
+  const uint8_t* m_it;
+  const uint8_t* m_end;
+  const int m_bpp;
+  int m_literals = 0;
+  int m_run = 0;
+  const uint8_t* m_runPixel = nullptr;
+};
+
+} // anonymous namespace
+
 void save_image_region_in_buffer(const gfx::Region& region,
                                  const doc::Image* image,
                                  const gfx::Point& imagePos,
@@ -57,4 +196,85 @@ void swap_image_region_with_buffer(const gfx::Region& region,
   }
 }
 
+gfx::Region get_different_image_region(const gfx::Region& region,
+                                       const doc::Image* a,
+                                       const doc::Image* b,
+                                       const gfx::Point& bPos)
+{
+  // Height of the bands to calculate the different region (smaller
+  // bands give us a finer region but with more rectangles)
+  constexpr int kBandHeight = 16;
+
+  ASSERT(a->pixelFormat() == b->pixelFormat());
+  if (a->pixelFormat() != b->pixelFormat())
+    return region;
+
+  const int bpp = a->bytesPerPixel();
+  gfx::Region result;
+  for (const auto& rc : region) {
+    for (int y1 = rc.y; y1 < rc.y2(); y1 += kBandHeight) {
+      const int y2 = std::min(y1 + kBandHeight, rc.y2());
+      gfx::Rect band;
+      for (int y = y1; y < y2; ++y) {
+        auto pa = (const uint8_t*)a->getPixelAddress(rc.x, y);
+        auto pb = (const uint8_t*)b->getPixelAddress(rc.x - bPos.x, y - bPos.y);
+        if (std::memcmp(pa, pb, bpp * rc.w) == 0)
+          continue;
+
+        int l = 0;
+        while (std::memcmp(pa + l * bpp, pb + l * bpp, bpp) == 0)
+          ++l;
+        int r = rc.w - 1;
+        while (std::memcmp(pa + r * bpp, pb + r * bpp, bpp) == 0)
+          --r;
+        band |= gfx::Rect(rc.x + l, y, r - l + 1, 1);
+      }
+      if (!band.isEmpty())
+        result |= gfx::Region(band);
+    }
+  }
+  return result;
+}
+
+void save_image_region_in_rle_buffer(const gfx::Region& region,
+                                     const doc::Image* image,
+                                     const gfx::Point& imagePos,
+                                     base::buffer& buffer)
+{
+  buffer.clear();
+  RlePixelsEncoder encoder(buffer, image->bytesPerPixel());
+  for (const auto& rc : region) {
+    for (int y = 0; y < rc.h; ++y) {
+      auto p = (const uint8_t*)image->getPixelAddress(rc.x - imagePos.x, rc.y - imagePos.y + y);
+      encoder.add(p, rc.w);
+    }
+  }
+  encoder.flush();
+  buffer.shrink_to_fit();
+}
+
+void swap_image_region_with_rle_buffer(const gfx::Region& region,
+                                       doc::Image* image,
+                                       base::buffer& buffer)
+{
+  const int bpp = image->bytesPerPixel();
+  base::buffer output;
+  output.reserve(buffer.size());
+
+  RlePixelsEncoder encoder(output, bpp);
+  RlePixelsDecoder decoder(buffer, bpp);
+  for (const auto& rc : region) {
+    for (int y = 0; y < rc.h; ++y) {
+      auto p = (uint8_t*)image->getPixelAddress(rc.x, rc.y + y);
+      // Save the current pixels before they are replaced with the
+      // buffer ones
+      encoder.add(p, rc.w);
+      decoder.read(p, rc.w);
+    }
+  }
+  encoder.flush();
+  output.shrink_to_fit();
+  buffer.swap(output);
+}
+
 } // namespace app
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -26,6 +26,28 @@ void swap_image_region_with_buffer(const gfx::Region& region,
                                    doc::Image* image,
                                    base::buffer& buffer);
 
+// Returns the part of the given region (in "a" coordinates) where
+// the pixels of "a" are different from the pixels of "b" (which is
+// located at "bPos"). The region is calculated in horizontal bands,
+// so a few equal pixels can be included.
+gfx::Region get_different_image_region(const gfx::Region& region,
+                                       const doc::Image* a,
+                                       const doc::Image* b,
+                                       const gfx::Point& bPos);
+
+// Same as save_image_region_in_buffer() and
+// swap_image_region_with_buffer() but the pixels in the buffer are
+// compressed with run-length encoding (consecutive equal pixels are
+// stored only once).
+void save_image_region_in_rle_buffer(const gfx::Region& region,
+                                     const doc::Image* image,
+                                     const gfx::Point& imagePos,
+                                     base::buffer& buffer);
+
+void swap_image_region_with_rle_buffer(const gfx::Region& region,
+                                       doc::Image* image,
+                                       base::buffer& buffer);
+
 } // namespace app
 
 #endif
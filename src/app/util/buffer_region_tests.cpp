@@ -0,0 +1,261 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#include "tests/app_test.h"
+
+#include "app/util/buffer_region.h"
+#include "doc/image.h"
+#include "doc/image_ref.h"
+#include "doc/primitives.h"
+#include "gfx/region.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace app;
+using namespace doc;
+
+namespace {
+
+const PixelFormat kFormats[] = { IMAGE_RGB, IMAGE_GRAYSCALE, IMAGE_INDEXED, IMAGE_TILEMAP };
+
+// Sets the raw bytes of a pixel (so we can use the same values for
+// all pixel formats). Consecutive values give different pixels even
+// in 1 byte per pixel formats.
+void set_raw_pixel(Image* image, const int x, const int y, const uint32_t value)
+{
+  auto p = (uint8_t*)image->getPixelAddress(x, y);
+  for (int i = 0; i < image->bytesPerPixel(); ++i)
+    p[i] = uint8_t(value >> (8 * i));
+}
+
+// Changes all bytes of a pixel
+void invert_raw_pixel(Image* image, const int x, const int y)
+{
+  auto p = (uint8_t*)image->getPixelAddress(x, y);
+  for (int i = 0; i < image->bytesPerPixel(); ++i)
+    p[i] = ~p[i];
+}
+
+// Fills a row with runs of equal pixels and sequences of different
+// pixels of the given lengths (positive lengths are runs, negative
+// ones are different pixels).
+void fill_row(Image* image, const int y, const std::vector<int>& lengths, uint32_t& value)
+{
+  int x = 0;
+  for (const int len : lengths) {
+    for (int i = 0; i < std::abs(len) && x < image->width(); ++i, ++x) {
+      if (len < 0 || i == 0)
+        ++value;
+      set_raw_pixel(image, x, y, value);
+    }
+  }
+  for (; x < image->width(); ++x)
+    set_raw_pixel(image, x, y, ++value);
+}
+
+ImageRef create_test_image(const PixelFormat format)
+{
+  ImageRef image(Image::create(format, 300, 8));
+  uint32_t value = 0;
+  // Runs around the 129 pixels limit, and different pixels around
+  // the 128 pixels limit of each packet.
+  fill_row(image.get(), 0, { 1, 2, 127, 128, 129, 130 }, value);
+  fill_row(image.get(), 1, { -127, 1, -128, 2, -129 }, value);
+  fill_row(image.get(), 2, { 258, -1, 259 }, value);
+  fill_row(image.get(), 3, { -255, 1, -1, 1, -1 }, value);
+  fill_row(image.get(), 4, { 300 }, value);
+  fill_row(image.get(), 5, { -300 }, value);
+  fill_row(image.get(), 6, { 129, -128, 129, -43 }, value);
+  fill_row(image.get(), 7, { 2, -1, 2, -1, 2, -1, 2 }, value);
+  return image;
+}
+
+bool same_pixels(const gfx::Region& region, const Image* a, const Image* b)
+{
+  const int bpp = a->bytesPerPixel();
+  for (const auto& rc : region) {
+    for (int y = rc.y; y < rc.y2(); ++y) {
+      if (std::memcmp(a->getPixelAddress(rc.x, y), b->getPixelAddress(rc.x, y), bpp * rc.w) != 0)
+        return false;
+    }
+  }
+  return true;
+}
+
+gfx::Region multi_rect_region()
+{
+  gfx::Region region(gfx::Rect(0, 0, 10, 3));
+  region |= gfx::Region(gfx::Rect(20, 1, 200, 3));
+  region |= gfx::Region(gfx::Rect(5, 4, 290, 1));
+  region |= gfx::Region(gfx::Rect(130, 5, 170, 3));
+  return region;
+}
+
+// Size of the RLE buffer for one row of the given pixels
+size_t rle_row_size(const PixelFormat format, const std::vector<int>& lengths)
+{
+  const int w = [&lengths] {
+    int n = 0;
+    for (const int len : lengths)
+      n += std::abs(len);
+    return n;
+  }();
+  ImageRef image(Image::create(format, w, 1));
+  uint32_t value = 0;
+  fill_row(image.get(), 0, lengths, value);
+
+  base::buffer buffer;
+  save_image_region_in_rle_buffer(gfx::Region(image->bounds()),
+                                  image.get(),
+                                  gfx::Point(0, 0),
+                                  buffer);
+  return buffer.size();
+}
+
+} // anonymous namespace
+
+TEST(BufferRegion, RlePacketLimits)
+{
+  for (const PixelFormat format : kFormats) {
+    ImageRef tmp(Image::create(format, 1, 1));
+    const size_t bpp = tmp->bytesPerPixel();
+
+    // Runs: header + one pixel for each 129 pixels
+    EXPECT_EQ(1 + bpp, rle_row_size(format, { 2 }));
+    EXPECT_EQ(1 + bpp, rle_row_size(format, { 128 }));
+    EXPECT_EQ(1 + bpp, rle_row_size(format, { 129 }));
+    EXPECT_EQ(2 + 2 * bpp, rle_row_size(format, { 130 }));
+    EXPECT_EQ(2 + 2 * bpp, rle_row_size(format, { 258 }));
+    EXPECT_EQ(3 + 3 * bpp, rle_row_size(format, { 259 }));
+
+    // Different pixels: header + all pixels for each 128 pixels
+    EXPECT_EQ(1 + bpp, rle_row_size(format, { -1 }));
+    EXPECT_EQ(1 + 128 * bpp, rle_row_size(format, { -128 }));
+    EXPECT_EQ(2 + 129 * bpp, rle_row_size(format, { -129 }));
+    EXPECT_EQ(2 + 256 * bpp, rle_row_size(format, { -256 }));
+  }
+}
+
+TEST(BufferRegion, RleRoundTrip)
+{
+  for (const PixelFormat format : kFormats) {
+    for (const gfx::Region& region :
+         { gfx::Region(gfx::Rect(0, 0, 300, 8)), multi_rect_region() }) {
+      ImageRef orig = create_test_image(format);
+      ImageRef image(Image::createCopy(orig.get()));
+
+      base::buffer buffer;
+      save_image_region_in_rle_buffer(region, image.get(), gfx::Point(0, 0), buffer);
+      EXPECT_LT(buffer.size(), orig->rowBytes() * orig->height());
+
+      // The saved pixels are restored
+      clear_image(image.get(), 0);
+      ImageRef cleared(Image::createCopy(image.get()));
+      swap_image_region_with_rle_buffer(region, image.get(), buffer);
+      EXPECT_TRUE(same_pixels(region, orig.get(), image.get()));
+
+      // Swapping twice restores the original image (as undo+redo)
+      swap_image_region_with_rle_buffer(region, image.get(), buffer);
+      EXPECT_TRUE(same_pixels(region, cleared.get(), image.get()));
+      swap_image_region_with_rle_buffer(region, image.get(), buffer);
+      EXPECT_TRUE(same_pixels(region, orig.get(), image.get()));
+
+      // Pixels outside the region are not modified
+      gfx::Region outside(image->bounds());
+      outside -= region;
+      EXPECT_TRUE(same_pixels(outside, cleared.get(), image.get()));
+    }
+  }
+}
+
+TEST(BufferRegion, RleAndRawBuffersAreEquivalent)
+{
+  const gfx::Region region = multi_rect_region();
+  for (const PixelFormat format : kFormats) {
+    ImageRef orig = create_test_image(format);
+    ImageRef a(Image::create(format, orig->width(), orig->height()));
+    ImageRef b(Image::create(format, orig->width(), orig->height()));
+    clear_image(a.get(), 0);
+    clear_image(b.get(), 0);
+
+    base::buffer raw, rle;
+    save_image_region_in_buffer(region, orig.get(), gfx::Point(0, 0), raw);
+    save_image_region_in_rle_buffer(region, orig.get(), gfx::Point(0, 0), rle);
+
+    swap_image_region_with_buffer(region, a.get(), raw);
+    swap_image_region_with_rle_buffer(region, b.get(), rle);
+    EXPECT_TRUE(same_pixels(gfx::Region(orig->bounds()), a.get(), b.get()));
+    EXPECT_TRUE(same_pixels(region, orig.get(), b.get()));
+  }
+}
+
+TEST(BufferRegion, SaveWithImagePosition)
+{
+  // The image is located at (10, 20) in the region coordinates
+  const gfx::Point imagePos(10, 20);
+  for (const PixelFormat format : kFormats) {
+    ImageRef orig = create_test_image(format);
+    gfx::Region region(gfx::Rect(imagePos.x + 3, imagePos.y + 1, 250, 5));
+
+    base::buffer rle;
+    save_image_region_in_rle_buffer(region, orig.get(), imagePos, rle);
+
+    ImageRef image(Image::create(format, orig->width(), orig->height()));
+    clear_image(image.get(), 0);
+    region.offset(-imagePos);
+    swap_image_region_with_rle_buffer(region, image.get(), rle);
+    EXPECT_TRUE(same_pixels(region, orig.get(), image.get()));
+  }
+}
+
+TEST(BufferRegion, DifferentImageRegion)
+{
+  for (const PixelFormat format : kFormats) {
+    ImageRef a = create_test_image(format);
+    ImageRef b(Image::createCopy(a.get()));
+    const gfx::Region region(a->bounds());
+
+    EXPECT_TRUE(get_different_image_region(region, a.get(), b.get(), gfx::Point(0, 0)).isEmpty());
+
+    invert_raw_pixel(b.get(), 0, 0);
+    invert_raw_pixel(b.get(), 299, 7);
+    invert_raw_pixel(b.get(), 150, 3);
+    gfx::Region diff = get_different_image_region(region, a.get(), b.get(), gfx::Point(0, 0));
+    EXPECT_TRUE(diff.contains(gfx::Point(0, 0)));
+    EXPECT_TRUE(diff.contains(gfx::Point(299, 7)));
+    EXPECT_TRUE(diff.contains(gfx::Point(150, 3)));
+
+    // The pixels outside the different region are equal
+    gfx::Region equal(region);
+    equal -= diff;
+    EXPECT_TRUE(same_pixels(equal, a.get(), b.get()));
+
+    // Only the given region is checked
+    diff = get_different_image_region(gfx::Region(gfx::Rect(10, 0, 100, 8)),
+                                      a.get(),
+                                      b.get(),
+                                      gfx::Point(0, 0));
+    EXPECT_TRUE(diff.isEmpty());
+  }
+}
+
+TEST(BufferRegion, DifferentImageRegionWithOffset)
+{
+  ImageRef a = create_test_image(IMAGE_RGB);
+
+  // "b" is a copy of a part of "a" located at (100, 2)
+  const gfx::Point bPos(100, 2);
+  ImageRef b(crop_image(a.get(), gfx::Rect(bPos, gfx::Size(50, 4)), 0));
+  const gfx::Region region(gfx::Rect(bPos, b->size()));
+  EXPECT_TRUE(get_different_image_region(region, a.get(), b.get(), bPos).isEmpty());
+
+  invert_raw_pixel(b.get(), 10, 1);
+  const gfx::Region diff = get_different_image_region(region, a.get(), b.get(), bPos);
+  EXPECT_TRUE(diff.contains(gfx::Point(bPos.x + 10, bPos.y + 1)));
+  EXPECT_FALSE(diff.contains(gfx::Point(bPos.x + 10, bPos.y + 3)));
+}
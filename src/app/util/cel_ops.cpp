@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -22,6 +22,7 @@
 #include "app/cmd/set_cel_position.h"
 #include "app/cmd_sequence.h"
 #include "app/doc.h"
+#include "app/task_scheduler.h"
 #include "doc/algorithm/fill_selection.h"
 #include "doc/algorithm/flip_image.h"
 #include "doc/algorithm/resize_image.h"
@@ -35,7 +36,9 @@
 #include "doc/palette.h"
 #include "doc/primitives.h"
 #include "doc/sprite.h"
+#include "doc/task_group.h"
 #include "doc/tileset.h"
+#include "doc/tileset_hash_table.h"
 #include "doc/tilesets.h"
 #include "gfx/region.h"
 #include "render/dithering.h"
@@ -112,140 +115,114 @@ void for_each_tile_using_tileset(Tileset* tileset, UnaryFunction f)
   }
 }
 
-struct Mod {
-  tile_index tileIndex;
-  ImageRef tileDstImage;
-  ImageRef tileImage;
-  gfx::Region tileRgn;
-};
+// Minimum number of tiles to convert an image to a tilemap from
+// several threads, and the maximum number of tile images that are
+// kept in memory at the same time (tiles are processed in bands of
+// rows to avoid keeping a copy of the whole image in tiles).
+constexpr int kParallelMinTiles = 1024;
+constexpr int kMaxTilesPerBand = 64 * 1024;
 
-class DoFlip {
-public:
-  DoFlip(const doc::ImageRef& image, const doc::algorithm::FlipType flipType)
-    : m_image(image.get())
-    , m_flipType(flipType)
-  {
-  }
-  ~DoFlip() { reset(); }
-  void flip()
-  {
-    m_flipped = !m_flipped;
-    doc::algorithm::flip_image(m_image, m_image->bounds(), m_flipType);
-  }
-  void reset()
-  {
-    if (m_flipped)
-      flip();
-  }
-  bool operator!() const { return !m_flipped; }
+int cel_ops_threads()
+{
+  return TaskScheduler::instance()->threads();
+}
 
-private:
-  doc::Image* m_image;
-  bool m_flipped = false;
-  doc::algorithm::FlipType m_flipType;
+// Tiles of a group of rows of the tilemap, cropped from the source
+// image and deduplicated in a partial tileset. "refs" contains the
+// index of the "uniqueTiles" element for each tile of the group
+// (in row-major order), and the unique tiles are sorted by their
+// first appearance.
+struct TilesGroup {
+  gfx::Rect tiles; // Tiles of the group (in the tilemap)
+  std::vector<ImageRef> uniqueTiles;
+  std::vector<int> refs;
 };
 
-// This is a terrible way to find tiles, i.e. flipping several times
-// the image, instead of searching for flipped hashes. In the future
-// we could try to improve it.
-bool find_tile(doc::Tileset* tileset,
-               doc::ImageRef& tileImage,
-               doc::tile_index& tileIndex,
-               doc::tile_flags& tileFlags)
+ImageRef crop_tile_image(const Image* srcImage,
+                         const Grid& grid,
+                         const gfx::Point& tilePt,
+                         const gfx::Point& srcImagePos)
 {
-  // Find without flags
-  if (tileset->findTileIndex(tileImage, tileIndex)) {
-    tileFlags = 0;
-    return true;
-  }
-
-  if (tileset->matchFlags() == 0) // In case we don't allow flipped tiles
-    return false;
-
-  DoFlip x(tileImage, doc::algorithm::FlipHorizontal);
-
-  // Find with X flip
-  if (tileset->matchFlags() & doc::tile_f_xflip) {
-    x.flip();
-    if (tileset->findTileIndex(tileImage, tileIndex)) {
-      tileFlags = doc::tile_f_xflip;
-      return true;
-    }
-    x.reset();
-  }
+  const gfx::Point tilePtInCanvas = grid.tileToCanvas(tilePt);
+  const gfx::Size tileSize = grid.tileSize();
+  ImageRef tileImage(crop_image(srcImage,
+                                tilePtInCanvas.x - srcImagePos.x,
+                                tilePtInCanvas.y - srcImagePos.y,
+                                tileSize.w,
+                                tileSize.h,
+                                srcImage->maskColor()));
+  if (grid.hasMask())
+    mask_image(tileImage.get(), grid.mask().get());
+
+  preprocess_transparent_pixels(tileImage.get());
+  return tileImage;
+}
 
-  // Find with Y flip
-  DoFlip y(tileImage, doc::algorithm::FlipVertical);
-  if (tileset->matchFlags() & doc::tile_f_yflip) {
-    y.flip();
-    if (tileset->findTileIndex(tileImage, tileIndex)) {
-      tileFlags = doc::tile_f_yflip;
-      return true;
-    }
+// [thread safe] Crops and deduplicates the tiles of the given group.
+void crop_tiles_group(const Image* srcImage,
+                      const Grid& grid,
+                      const gfx::Point& srcImagePos,
+                      TilesGroup& group)
+{
+  TilesetHashTable hashTable;
+  group.refs.reserve(group.tiles.w * group.tiles.h);
+
+  for (int v = group.tiles.y; v < group.tiles.y2(); ++v) {
+    for (int u = group.tiles.x; u < group.tiles.x2(); ++u) {
+      ImageRef tileImage = crop_tile_image(srcImage, grid, gfx::Point(u, v), srcImagePos);
+      const uint32_t hash = calculate_image_hash(tileImage.get(), tileImage->bounds());
+
+      int ref = -1;
+      hashTable.forEachTile(hash, [&group, &tileImage, &ref](const tile_index i) {
+        if ((ref < 0 || int(i) < ref) &&
+            is_same_image(group.uniqueTiles[i].get(), tileImage.get()))
+          ref = int(i);
+      });
 
-    if (tileset->matchFlags() & doc::tile_f_xflip) {
-      // Find with X+Y flip
-      x.flip();
-      if (tileset->findTileIndex(tileImage, tileIndex)) {
-        tileFlags = doc::tile_f_xflip | doc::tile_f_yflip;
-        return true;
+      if (ref < 0) {
+        ref = int(group.uniqueTiles.size());
+        hashTable.insert(hash, tile_index(ref));
+        group.uniqueTiles.push_back(tileImage);
       }
-      x.reset();
+      group.refs.push_back(ref);
     }
-    y.reset();
   }
+}
 
-  // Check if we can match diagonal flips
-  if ((tileset->matchFlags() & doc::tile_f_dflip) == 0)
-    return false;
-
-  // Find with D flip
-  DoFlip d(tileImage, doc::algorithm::FlipDiagonal);
-  d.flip();
-  if (tileset->findTileIndex(tileImage, tileIndex)) {
-    tileFlags = doc::tile_f_dflip;
-    return true;
-  }
-
-  // Find with X+D flip
-  if (tileset->matchFlags() & doc::tile_f_xflip) {
-    d.reset();
-    x.flip();
-    d.flip();
-    if (tileset->findTileIndex(tileImage, tileIndex)) {
-      tileFlags = doc::tile_f_xflip | doc::tile_f_dflip;
-      return true;
-    }
-
-    // Find with X+Y+D flip
-    if (tileset->matchFlags() & doc::tile_f_yflip) {
-      d.reset();
-      y.flip();
-      d.flip();
-      if (tileset->findTileIndex(tileImage, tileIndex)) {
-        tileFlags = doc::tile_f_xflip | doc::tile_f_yflip | doc::tile_f_dflip;
-        return true;
-      }
-    }
+// Crops the tiles of the "band" rows of the tilemap from several
+// threads, each one with a group of rows.
+void crop_tiles_in_parallel(const Image* srcImage,
+                            const Grid& grid,
+                            const gfx::Point& srcImagePos,
+                            const gfx::Rect& band,
+                            std::vector<TilesGroup>& groups)
+{
+  const int nthreads = cel_ops_threads();
+  const int rowsPerGroup = std::max(1, (band.h + nthreads * 4 - 1) / (nthreads * 4));
+
+  groups.clear();
+  for (int v = band.y; v < band.y2(); v += rowsPerGroup) {
+    TilesGroup group;
+    group.tiles = gfx::Rect(band.x, v, band.w, std::min(rowsPerGroup, band.y2() - v));
+    groups.push_back(std::move(group));
   }
 
-  // Find with Y+D flip only
-  if (tileset->matchFlags() & doc::tile_f_yflip) {
-    d.reset();
-    x.reset();
-    if (!y)
-      y.flip();
-    d.flip();
-    if (tileset->findTileIndex(tileImage, tileIndex)) {
-      tileFlags = doc::tile_f_yflip | doc::tile_f_dflip;
-      return true;
-    }
+  doc::TaskGroup tasks;
+  for (TilesGroup& group : groups) {
+    tasks.run([srcImage, &grid, &srcImagePos, &group] {
+      crop_tiles_group(srcImage, grid, srcImagePos, group);
+    });
   }
-
-  // DoFlip destructors will reset the image.
-  return false;
+  tasks.wait();
 }
 
+struct Mod {
+  tile_index tileIndex;
+  ImageRef tileDstImage;
+  ImageRef tileImage;
+  gfx::Region tileRgn;
+};
+
 } // anonymous namespace
 
 void create_region_with_differences(const Image* a,
@@ -497,7 +474,6 @@ void draw_image_into_new_tilemap_cel(CmdSequence* cmds,
   doc::Grid grid = tileset->grid();
   grid.origin(gridOrigin);
 
-  gfx::Size tileSize = grid.tileSize();
   const gfx::Rect tilemapBounds = grid.canvasToTile(canvasBounds);
 
   if (!newTilemap) {
@@ -510,23 +486,13 @@ void draw_image_into_new_tilemap_cel(CmdSequence* cmds,
     ASSERT(tilemapBounds.h == newTilemap->height());
   }
 
-  for (const gfx::Point& tilePt : grid.tilesInCanvasRegion(gfx::Region(canvasBounds))) {
-    const gfx::Point tilePtInCanvas = grid.tileToCanvas(tilePt);
-    doc::ImageRef tileImage(doc::crop_image(srcImage,
-                                            tilePtInCanvas.x - srcImagePos.x,
-                                            tilePtInCanvas.y - srcImagePos.y,
-                                            tileSize.w,
-                                            tileSize.h,
-                                            srcImage->maskColor()));
-    if (grid.hasMask())
-      mask_image(tileImage.get(), grid.mask().get());
-
-    preprocess_transparent_pixels(tileImage.get());
-
+  // Returns the tile in the tileset for the given tile image (adding
+  // it to the tileset if it's a new tile).
+  auto findOrAddTile = [cmds, doc, tileset, dstLayer, dstCel](const ImageRef& tileImage) {
     doc::tile_index tileIndex;
     doc::tile_flags tileFlag = 0;
 
-    if (!find_tile(tileset, tileImage, tileIndex, tileFlag)) {
+    if (!tileset->findTileIndex(tileImage, tileIndex, tileFlag)) {
       auto addTile = new cmd::AddTile(tileset, tileImage);
 
       if (cmds)
@@ -543,17 +509,51 @@ void draw_image_into_new_tilemap_cel(CmdSequence* cmds,
 
       doc->notifyAfterAddTile(dstLayer, dstCel->frame(), tileIndex);
     }
+    return doc::tile(tileIndex, tileFlag);
+  };
 
+  auto putTile = [&newTilemap, &tilemapBounds](const gfx::Point& tilePt, const doc::tile_t t) {
     // We were using newTilemap->putPixel() directly but received a
     // crash report about an "access violation". So now we've added
     // some checks to the operation.
-    {
-      const int u = tilePt.x - tilemapBounds.x;
-      const int v = tilePt.y - tilemapBounds.y;
-      ASSERT((u >= 0) && (v >= 0) && (u < newTilemap->width()) && (v < newTilemap->height()));
-      doc::put_pixel(newTilemap.get(), u, v, doc::tile(tileIndex, tileFlag));
+    const int u = tilePt.x - tilemapBounds.x;
+    const int v = tilePt.y - tilemapBounds.y;
+    ASSERT((u >= 0) && (v >= 0) && (u < newTilemap->width()) && (v < newTilemap->height()));
+    doc::put_pixel(newTilemap.get(), u, v, t);
+  };
+
+  if (cel_ops_threads() > 1 && tilemapBounds.w * tilemapBounds.h >= kParallelMinTiles) {
+    // Tiles are cropped and deduplicated from several threads, and
+    // then the partial tilesets are merged from the first row to the
+    // last one, so the new tiles are added in the same order as if
+    // they were found one by one.
+    const int bandRows = std::max(1, kMaxTilesPerBand / tilemapBounds.w);
+    std::vector<TilesGroup> groups;
+    std::vector<doc::tile_t> uniqueTiles;
+
+    for (int v = tilemapBounds.y; v < tilemapBounds.y2(); v += bandRows) {
+      const gfx::Rect band(tilemapBounds.x,
+                           v,
+                           tilemapBounds.w,
+                           std::min(bandRows, tilemapBounds.y2() - v));
+      crop_tiles_in_parallel(srcImage, grid, srcImagePos, band, groups);
+
+      for (const TilesGroup& group : groups) {
+        uniqueTiles.clear();
+        for (const ImageRef& tileImage : group.uniqueTiles)
+          uniqueTiles.push_back(findOrAddTile(tileImage));
+
+        auto ref = group.refs.begin();
+        for (int y = group.tiles.y; y < group.tiles.y2(); ++y)
+          for (int x = group.tiles.x; x < group.tiles.x2(); ++x, ++ref)
+            putTile(gfx::Point(x, y), uniqueTiles[*ref]);
+      }
     }
   }
+  else {
+    for (const gfx::Point& tilePt : grid.tilesInCanvasRegion(gfx::Region(canvasBounds)))
+      putTile(tilePt, findOrAddTile(crop_tile_image(srcImage, grid, tilePt, srcImagePos)));
+  }
 
   doc->notifyTilesetChanged(tileset);
 
@@ -686,7 +686,7 @@ void modify_tilemap_cel_region(CmdSequence* cmds,
       doc::tile_index tileIndex;
       doc::tile_flags tileFlag = 0;
 
-      if (find_tile(tileset, tileImage, tileIndex, tileFlag)) {
+      if (tileset->findTileIndex(tileImage, tileIndex, tileFlag)) {
         // We can re-use an existent tile (tileIndex) from the tileset
       }
       else if (tilesetMode == TilesetMode::Auto && t != doc::notile && ti >= 0 &&
@@ -855,6 +855,14 @@ void modify_tilemap_cel_region(CmdSequence* cmds,
           mods.push_back(mod);
         }
         else {
+          // The given tileset (e.g. the preview tileset of
+          // ExpandCelCanvas) can share the images of unmodified tiles
+          // with the layer tileset, so we copy the tile before its
+          // first modification.
+          if (tileDstImage == tilemapLayer->tileset()->get(ti)) {
+            tileDstImage.reset(Image::createCopy(tileDstImage.get()));
+            tileset->set(ti, tileDstImage);
+          }
           copy_image(tileDstImage.get(), tileImage.get(), tileRgn);
           tileset->notifyTileContentChange(ti);
         }
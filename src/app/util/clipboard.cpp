@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -120,6 +120,11 @@ struct Clipboard::Data {
   // Selected slices
   std::vector<Slice> slices;
 
+  // ID of the native clipboard image that contains this same "image"
+  // (0 if the image wasn't set in the native clipboard), so we can
+  // avoid reading the native clipboard image to paste it.
+  uint32_t nativeBitmapId = 0;
+
   Data() { range.observeUIContext(); }
 
   ~Data()
@@ -139,6 +144,7 @@ struct Clipboard::Data {
     mask.reset();
     range.invalidate();
     slices.clear();
+    nativeBitmapId = 0;
   }
 
   ClipboardFormat format() const
@@ -243,18 +249,21 @@ void Clipboard::setData(Image* image,
 
   if (set_native_clipboard && use_native_clipboard()) {
     // Copy tilemap to the native clipboard
+    bool result;
     if (isTilemap) {
       ASSERT(tileset);
-      setNativeBitmap(image, mask, palette, tileset, -1);
+      result = setNativeBitmap(image, mask, palette, tileset, -1);
     }
     // Copy non-tilemap images to the native clipboard
     else {
-      setNativeBitmap(image,
-                      mask,
-                      palette,
-                      nullptr,
-                      image_source_is_transparent ? image->maskColor() : -1);
+      result = setNativeBitmap(image,
+                               mask,
+                               palette,
+                               nullptr,
+                               image_source_is_transparent ? image->maskColor() : -1);
     }
+    if (result)
+      m_data->nativeBitmapId = m_nativeBitmapId;
   }
 }
 
@@ -845,8 +854,11 @@ void Clipboard::paste(Context* ctx, const bool interactive, const gfx::Point* po
 
 ImageRef Clipboard::getImage(Palette* palette)
 {
-  // Get the image from the native clipboard.
-  if (use_native_clipboard()) {
+  // Get the image from the native clipboard (if it's not the same
+  // image that we've copied from this process, in that case we can
+  // share the same image).
+  if (use_native_clipboard() &&
+      (!m_data->nativeBitmapId || m_data->nativeBitmapId != getOwnNativeBitmapId())) {
     Image* native_image = nullptr;
     Mask* native_mask = nullptr;
     Palette* native_palette = nullptr;
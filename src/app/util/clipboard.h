@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -16,6 +16,7 @@
 #include "ui/base.h"
 #include "ui/clipboard_delegate.h"
 
+#include <cstdint>
 #include <memory>
 
 namespace doc {
@@ -119,11 +120,16 @@ private:
   void registerNativeFormats();
   bool hasNativeBitmap() const;
   bool getNativeBitmapSize(gfx::Size* size);
+  uint32_t getOwnNativeBitmapId() const;
 
   bool setNativePalette(const doc::Palette* palette, const doc::PalettePicks& picks);
 
   struct Data;
   std::unique_ptr<Data> m_data;
+
+  // ID of the last image that we've set in the native clipboard (so
+  // we can know if the native clipboard still contains that image).
+  uint32_t m_nativeBitmapId = 0;
 };
 
 } // namespace app
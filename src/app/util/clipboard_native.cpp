@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2025  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2016-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -12,6 +12,7 @@
 #include "app/util/clipboard.h"
 
 #include "app/i18n/strings.h"
+#include "base/process.h"
 #include "base/serialization.h"
 #include "clip/clip.h"
 #include "doc/color_scales.h"
@@ -27,6 +28,7 @@
 #include "os/window.h"
 #include "ui/alert.h"
 
+#include <cstring>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -38,6 +40,7 @@ using namespace base::serialization::little_endian;
 
 namespace {
 clip::format custom_image_format = 0;
+clip::format custom_image_id_format = 0;
 bool show_clip_errors = true;
 
 class InhibitClipErrors {
@@ -87,6 +90,7 @@ void Clipboard::registerNativeFormats()
 {
   clip::set_error_handler(custom_error_handler);
   custom_image_format = clip::register_format("org.aseprite.Image");
+  custom_image_id_format = clip::register_format("org.aseprite.ImageId");
 }
 
 bool Clipboard::hasNativeBitmap() const
@@ -114,8 +118,10 @@ bool Clipboard::setNativeBitmap(const doc::Image* image,
   if (custom_image_format) {
     std::stringstream os;
     write32(os, (image ? 1 : 0) | (mask ? 2 : 0) | (palette ? 4 : 0) | (tileset ? 8 : 0));
+    // Use the fastest compression level as this is done each time
+    // the user copies an image
     if (image)
-      doc::write_image(os, image);
+      doc::write_image(os, image, nullptr, 1);
     if (mask)
       doc::write_mask(os, mask);
     if (palette)
@@ -135,6 +141,14 @@ bool Clipboard::setNativeBitmap(const doc::Image* image,
     }
   }
 
+  // Identify this image with the process ID and a counter, so we can
+  // know if we can paste our own copy of the image (see
+  // getOwnNativeBitmapId())
+  if (custom_image_id_format) {
+    const uint32_t id[2] = { uint32_t(base::get_current_process_id()), ++m_nativeBitmapId };
+    l.set_data(custom_image_id_format, (const char*)id, sizeof(id));
+  }
+
   clip::image_spec spec;
   spec.width = image->width();
   spec.height = image->height();
@@ -159,12 +173,11 @@ bool Clipboard::setNativeBitmap(const doc::Image* image,
     }
     case doc::IMAGE_GRAYSCALE: {
       const clip::image img(spec);
-      const doc::LockImageBits<doc::GrayscaleTraits> bits(image);
-      auto it = bits.begin();
-      uint32_t* dst = (uint32_t*)img.data();
       for (int y = 0; y < image->height(); ++y) {
-        for (int x = 0; x < image->width(); ++x, ++it) {
-          doc::color_t c = *it;
+        auto src = (doc::GrayscaleTraits::const_address_t)image->getPixelAddress(0, y);
+        auto dst = (uint32_t*)(img.data() + spec.bytes_per_row * y);
+        for (int x = 0; x < image->width(); ++x, ++src) {
+          const doc::color_t c = *src;
           *(dst++) = doc::rgba(doc::graya_getv(c),
                                doc::graya_getv(c),
                                doc::graya_getv(c),
@@ -178,20 +191,22 @@ bool Clipboard::setNativeBitmap(const doc::Image* image,
       if (!palette)
         return false;
 
-      const clip::image img(spec);
-      const doc::LockImageBits<doc::IndexedTraits> bits(image);
-      auto it = bits.begin();
-      uint32_t* dst = (uint32_t*)img.data();
-      for (int y = 0; y < image->height(); ++y) {
-        for (int x = 0; x < image->width(); ++x, ++it) {
-          doc::color_t c = palette->getEntry(*it);
+      // Table to convert indexes to RGBA colors
+      uint32_t colors[256];
+      for (int i = 0; i < 256; ++i) {
+        colors[i] = (i < palette->size() ? palette->getEntry(i) : 0);
 
-          // Use alpha=0 for mask color
-          if (*it == indexMaskColor)
-            c &= doc::rgba_rgb_mask;
+        // Use alpha=0 for mask color
+        if (i == indexMaskColor)
+          colors[i] &= doc::rgba_rgb_mask;
+      }
 
-          *(dst++) = c;
-        }
+      const clip::image img(spec);
+      for (int y = 0; y < image->height(); ++y) {
+        auto src = (doc::IndexedTraits::const_address_t)image->getPixelAddress(0, y);
+        auto dst = (uint32_t*)(img.data() + spec.bytes_per_row * y);
+        for (int x = 0; x < image->width(); ++x, ++src)
+          *(dst++) = colors[*src];
       }
       l.set_image(img);
       break;
@@ -269,6 +284,17 @@ bool Clipboard::getNativeBitmap(doc::Image** image,
       break;
     }
     case 32: {
+      // Copy rows directly if the clipboard uses the same format
+      if (spec.red_mask == doc::rgba_r_mask && spec.green_mask == doc::rgba_g_mask &&
+          spec.blue_mask == doc::rgba_b_mask && spec.alpha_mask == doc::rgba_a_mask) {
+        for (unsigned long y = 0; y < spec.height; ++y) {
+          std::memcpy(dst->getPixelAddress(0, y),
+                      img.data() + spec.bytes_per_row * y,
+                      4 * spec.width);
+        }
+        break;
+      }
+
       doc::LockImageBits<doc::RgbTraits> bits(dst.get(), doc::Image::WriteLock);
       auto it = bits.begin();
       for (unsigned long y = 0; y < spec.height; ++y) {
@@ -324,6 +350,27 @@ bool Clipboard::getNativeBitmap(doc::Image** image,
   return true;
 }
 
+uint32_t Clipboard::getOwnNativeBitmapId() const
+{
+  InhibitClipErrors inhibitErrors;
+
+  clip::lock l(native_window_handle());
+  if (!l.locked() || !custom_image_id_format || !l.is_convertible(custom_image_id_format))
+    return 0;
+
+  uint32_t id[2];
+  if (l.get_data_length(custom_image_id_format) != sizeof(id) ||
+      !l.get_data(custom_image_id_format, (char*)id, sizeof(id))) {
+    return 0;
+  }
+
+  // Image copied from other process
+  if (id[0] != uint32_t(base::get_current_process_id()))
+    return 0;
+
+  return id[1];
+}
+
 bool Clipboard::getNativeBitmapSize(gfx::Size* size)
 {
   // Don't show errors when we are trying to get the size of the image
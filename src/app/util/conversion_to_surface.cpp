@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (c) 2020-2025  Igara Studio S.A.
+// Copyright (c) 2020-2026  Igara Studio S.A.
 // Copyright (c) 2001-2018 David Capello
 //
 // This program is distributed under the terms of
@@ -27,6 +27,13 @@
 #include <algorithm>
 #include <stdexcept>
 
+#if defined(__x86_64__) || defined(_WIN64)
+  #include <emmintrin.h>
+  #define APP_USE_SSE2_CONVERSION_TO_SURFACE 1
+#else
+  #define APP_USE_SSE2_CONVERSION_TO_SURFACE 0
+#endif
+
 namespace app {
 
 using namespace doc;
@@ -213,6 +220,88 @@ void convert_image_to_surface_selector(const Image* image,
   }
 }
 
+// Converts an indexed image to a 32bpp surface using a table with
+// the 256 possible pixel values already converted to the surface
+// format.
+void convert_indexed_image_to_32bpp_surface(const Image* image,
+                                            os::Surface* surface,
+                                            const int src_x,
+                                            const int src_y,
+                                            const int dst_x,
+                                            const int dst_y,
+                                            const int w,
+                                            const int h,
+                                            const Palette* palette,
+                                            const os::SurfaceFormatData* fd)
+{
+  const ImageSpec& spec = image->spec();
+  uint32_t table[256];
+  for (int i = 0; i < 256; ++i) {
+    table[i] =
+      convert_color_to_surface<IndexedTraits, os::kRgbaSurfaceFormat>(i, palette, spec, fd);
+  }
+
+  for (int v = 0; v < h; ++v) {
+    const uint8_t* src = image->getPixelAddress(src_x, src_y + v);
+    uint32_t* dst = (uint32_t*)surface->getData(dst_x, dst_y + v);
+    int u = 0;
+    for (; u + 4 <= w; u += 4) {
+      dst[u] = table[src[u]];
+      dst[u + 1] = table[src[u + 1]];
+      dst[u + 2] = table[src[u + 2]];
+      dst[u + 3] = table[src[u + 3]];
+    }
+    for (; u < w; ++u)
+      dst[u] = table[src[u]];
+  }
+}
+
+// Converts a grayscale image to a 32bpp surface, 8 pixels at the
+// same time when the surface has the RGBA byte order.
+void convert_grayscale_image_to_32bpp_surface(const Image* image,
+                                              os::Surface* surface,
+                                              const int src_x,
+                                              const int src_y,
+                                              const int dst_x,
+                                              const int dst_y,
+                                              const int w,
+                                              const int h,
+                                              const Palette* palette,
+                                              const os::SurfaceFormatData* fd)
+{
+#if APP_USE_SSE2_CONVERSION_TO_SURFACE
+  const bool rgbaOrder = (fd->redShift == 0 && fd->greenShift == 8 && fd->blueShift == 16 &&
+                          fd->alphaShift == 24 && fd->redMask == 0xff && fd->greenMask == 0xff00 &&
+                          fd->blueMask == 0xff0000 && fd->alphaMask == 0xff000000);
+  const __m128i valueMask = _mm_set1_epi16(0xff);
+#endif
+
+  for (int v = 0; v < h; ++v) {
+    const uint16_t* src = (const uint16_t*)image->getPixelAddress(src_x, src_y + v);
+    uint32_t* dst = (uint32_t*)surface->getData(dst_x, dst_y + v);
+    int u = 0;
+#if APP_USE_SSE2_CONVERSION_TO_SURFACE
+    if (rgbaOrder) {
+      for (; u + 8 <= w; u += 8) {
+        // Each 16-bit gray pixel (value | alpha<<8) is converted to
+        // (value | value<<8) | (value | alpha<<8)<<16
+        const __m128i graya = _mm_loadu_si128((const __m128i*)(src + u));
+        __m128i value = _mm_and_si128(graya, valueMask);
+        value = _mm_or_si128(value, _mm_slli_epi16(value, 8));
+        _mm_storeu_si128((__m128i*)(dst + u), _mm_unpacklo_epi16(value, graya));
+        _mm_storeu_si128((__m128i*)(dst + u + 4), _mm_unpackhi_epi16(value, graya));
+      }
+    }
+#endif
+    for (; u < w; ++u) {
+      dst[u] = convert_color_to_surface<GrayscaleTraits, os::kRgbaSurfaceFormat>(src[u],
+                                                                                 palette,
+                                                                                 image->spec(),
+                                                                                 fd);
+    }
+  }
+}
+
 } // anonymous namespace
 
 void convert_image_to_surface(const doc::Image* image,
@@ -261,23 +350,60 @@ void convert_image_to_surface(const doc::Image* image,
       // Fast path
       if (gfx::ColorRShift == fd.redShift && gfx::ColorGShift == fd.greenShift &&
           gfx::ColorBShift == fd.blueShift && gfx::ColorAShift == fd.alphaShift) {
-        for (int v = 0; v < h; ++v, ++src_y, ++dst_y) {
-          uint8_t* src_address = image->getPixelAddress(src_x, src_y);
-          uint8_t* dst_address = surface->getData(dst_x, dst_y);
-          std::copy(src_address, src_address + RgbTraits::bytes_per_pixel * w, dst_address);
+        const int rowBytes = RgbTraits::bytes_per_pixel * w;
+
+        // Copy all rows at once if they are contiguous in both
+        // the image and the surface
+        if (h > 1 && int(image->rowBytes()) == rowBytes &&
+            surface->getData(dst_x, dst_y + 1) - surface->getData(dst_x, dst_y) == rowBytes) {
+          const uint8_t* src_address = image->getPixelAddress(src_x, src_y);
+          std::copy(src_address, src_address + rowBytes * h, surface->getData(dst_x, dst_y));
+        }
+        else {
+          for (int v = 0; v < h; ++v, ++src_y, ++dst_y) {
+            uint8_t* src_address = image->getPixelAddress(src_x, src_y);
+            uint8_t* dst_address = surface->getData(dst_x, dst_y);
+            std::copy(src_address, src_address + rowBytes, dst_address);
+          }
         }
-        return;
+        break;
       }
       convert_image_to_surface_selector<
         RgbTraits>(image, surface, src_x, src_y, dst_x, dst_y, w, h, palette, &fd);
       break;
 
     case IMAGE_GRAYSCALE:
+      if (fd.bitsPerPixel == 32) {
+        convert_grayscale_image_to_32bpp_surface(image,
+                                                 surface,
+                                                 src_x,
+                                                 src_y,
+                                                 dst_x,
+                                                 dst_y,
+                                                 w,
+                                                 h,
+                                                 palette,
+                                                 &fd);
+        break;
+      }
       convert_image_to_surface_selector<
         GrayscaleTraits>(image, surface, src_x, src_y, dst_x, dst_y, w, h, palette, &fd);
       break;
 
     case IMAGE_INDEXED:
+      if (fd.bitsPerPixel == 32) {
+        convert_indexed_image_to_32bpp_surface(image,
+                                               surface,
+                                               src_x,
+                                               src_y,
+                                               dst_x,
+                                               dst_y,
+                                               w,
+                                               h,
+                                               palette,
+                                               &fd);
+        break;
+      }
       convert_image_to_surface_selector<
         IndexedTraits>(image, surface, src_x, src_y, dst_x, dst_y, w, h, palette, &fd);
       break;
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -13,7 +13,6 @@
 
 #include "app/util/expand_cel_canvas.h"
 
-#include "app/app.h"
 #include "app/cmd/add_cel.h"
 #include "app/cmd/copy_rect.h"
 #include "app/cmd/copy_region.h"
@@ -27,6 +26,7 @@
 #include "doc/algorithm/shrink_bounds.h"
 #include "doc/cel.h"
 #include "doc/image.h"
+#include "doc/image_buffer_pool.h"
 #include "doc/layer.h"
 #include "doc/layer_tilemap.h"
 #include "doc/primitives.h"
@@ -41,27 +41,9 @@
 
 namespace {
 
-// We cannot have two ExpandCelCanvas instances at the same time
-// (because we share ImageBuffers between them).
-static app::ExpandCelCanvas* singleton = nullptr;
-
-static doc::ImageBufferPtr src_buffer;
-static doc::ImageBufferPtr dst_buffer;
-
-static void destroy_buffers()
+static int tiles_count(const int pixels, const int tileSize)
 {
-  src_buffer.reset();
-  dst_buffer.reset();
-}
-
-static void create_buffers()
-{
-  if (!src_buffer) {
-    app::App::instance()->Exit.connect(&destroy_buffers);
-
-    src_buffer.reset(new doc::ImageBuffer(1));
-    dst_buffer.reset(new doc::ImageBuffer(1));
-  }
+  return (pixels + tileSize - 1) / tileSize;
 }
 
 } // namespace
@@ -96,11 +78,6 @@ ExpandCelCanvas::ExpandCelCanvas(Site site,
   }
   m_canCompareSrcVsDst = ((m_flags & NeedsSource) == NeedsSource);
 
-  ASSERT(!singleton);
-  singleton = this;
-
-  create_buffers();
-
   if (previewSpecificLayerChanges()) {
     m_cel = m_layer->cel(site.frame());
     if (m_cel)
@@ -164,9 +141,13 @@ ExpandCelCanvas::ExpandCelCanvas(Site site,
             m_grid.origin(),
             m_grid.tileSize());
 
+  // When m_dstImage is used as the cel image it must be cleared
+  // completely (it can be rendered in other places, not only the
+  // validated areas in the editor).
   if (m_celCreated) {
     // Calling "getDestCanvas()" we create the m_dstImage
     getDestCanvas();
+    clearTiles(m_dstImage.get(), m_clearedDstTiles, gfx::Region(m_dstImage->bounds()));
 
     m_cel->data()->setImage(m_dstImage, m_layer);
 
@@ -175,12 +156,14 @@ ExpandCelCanvas::ExpandCelCanvas(Site site,
   }
   else if (m_layer->isTilemap() && m_tilemapMode == TilemapMode::Tiles) {
     getDestCanvas();
+    clearTiles(m_dstImage.get(), m_clearedDstTiles, gfx::Region(m_dstImage->bounds()));
     m_cel->data()->setImage(m_dstImage, m_layer);
   }
   // If we are in a tilemap, we use m_dstImage to draw pixels (instead
   // of the tilemap image).
   else if (m_layer->isTilemap() && m_tilemapMode == TilemapMode::Pixels && !isTilesetPreview()) {
     getDestCanvas();
+    clearTiles(m_dstImage.get(), m_clearedDstTiles, gfx::Region(m_dstImage->bounds()));
     m_cel->data()->setImage(m_dstImage, m_layer);
   }
   else if (isTilesetPreview()) {
@@ -190,9 +173,6 @@ ExpandCelCanvas::ExpandCelCanvas(Site site,
 
 ExpandCelCanvas::~ExpandCelCanvas()
 {
-  ASSERT(singleton == this);
-  singleton = nullptr;
-
   try {
     if (!m_committed && !m_closed)
       rollback();
@@ -344,6 +324,10 @@ void ExpandCelCanvas::commit()
 
         // Patch tiles
         for (tile_index ti = 1; ti < srcTileset->size(); ++ti) {
+          // Unmodified tile (shared with the original tileset)
+          if (m_dstTileset->get(ti) == srcTileset->get(ti))
+            continue;
+
           gfx::Region diffRgn;
           create_region_with_differences(srcTileset->get(ti).get(),
                                          m_dstTileset->get(ti).get(),
@@ -434,20 +418,30 @@ gfx::Point ExpandCelCanvas::getCelOrigin() const
     return m_cel->position();
 }
 
+Image* ExpandCelCanvas::createScratchImage(const PixelFormat pixelFormat) const
+{
+  // The source/destination canvases are only temporary images (the
+  // document receives copies of their pixels), so their buffers are
+  // reused from the pool in each tool loop.
+  const ImageSpec spec(ColorMode(pixelFormat), m_bounds.w, m_bounds.h);
+  return Image::create(spec, ImageBufferPool::instance()->get(spec));
+}
+
 Image* ExpandCelCanvas::getSourceCanvas()
 {
   ASSERT((m_flags & NeedsSource) == NeedsSource);
 
   if (!m_srcImage) {
     if (m_tilemapMode == TilemapMode::Tiles) {
-      m_srcImage.reset(Image::create(IMAGE_TILEMAP, m_bounds.w, m_bounds.h, src_buffer));
+      m_srcImage.reset(createScratchImage(IMAGE_TILEMAP));
       m_srcImage->setMaskColor(doc::notile);
     }
     else {
-      m_srcImage.reset(Image::create(m_sprite->pixelFormat(), m_bounds.w, m_bounds.h, src_buffer));
+      m_srcImage.reset(createScratchImage(m_sprite->pixelFormat()));
       m_srcImage->setMaskColor(m_sprite->transparentColor());
     }
-    m_srcImage->clear(m_srcImage->maskColor());
+    m_clearedSrcTiles.assign(
+      tiles_count(m_bounds.w, kTileSize) * tiles_count(m_bounds.h, kTileSize), false);
   }
   return m_srcImage.get();
 }
@@ -456,14 +450,15 @@ Image* ExpandCelCanvas::getDestCanvas()
 {
   if (!m_dstImage) {
     if (m_tilemapMode == TilemapMode::Tiles) {
-      m_dstImage.reset(Image::create(IMAGE_TILEMAP, m_bounds.w, m_bounds.h, dst_buffer));
+      m_dstImage.reset(createScratchImage(IMAGE_TILEMAP));
       m_dstImage->setMaskColor(doc::notile);
     }
     else {
-      m_dstImage.reset(Image::create(m_sprite->pixelFormat(), m_bounds.w, m_bounds.h, dst_buffer));
+      m_dstImage.reset(createScratchImage(m_sprite->pixelFormat()));
       m_dstImage->setMaskColor(m_sprite->transparentColor());
     }
-    m_dstImage->clear(m_dstImage->maskColor());
+    m_clearedDstTiles.assign(
+      tiles_count(m_bounds.w, kTileSize) * tiles_count(m_bounds.h, kTileSize), false);
   }
   return m_dstImage.get();
 }
@@ -484,8 +479,9 @@ Tileset* ExpandCelCanvas::getDestTileset()
     const Tileset* srcTileset = static_cast<LayerTilemap*>(m_layer)->tileset();
 
     ASSERT(srcTileset);
-    m_dstTileset.reset(Tileset::MakeCopyWithoutImages(srcTileset));
-    copySourceTilestToDestTileset();
+    // Tiles are shared with the original tileset, and copied only
+    // when they are modified (see modify_tilemap_cel_region()).
+    m_dstTileset.reset(Tileset::MakeCopyWithSameImages(srcTileset));
   }
   return m_dstTileset.get();
 }
@@ -514,6 +510,7 @@ void ExpandCelCanvas::validateSourceCanvas(const gfx::Region& rgn)
   rgnToValidate.offset(zeroPos);
   rgnToValidate.createSubtraction(rgnToValidate, m_validSrcRegion);
   rgnToValidate.createIntersection(rgnToValidate, gfx::Region(m_srcImage->bounds()));
+  clearTiles(m_srcImage.get(), m_clearedSrcTiles, rgnToValidate);
 
   if (m_celImage && previewSpecificLayerChanges()) {
     gfx::Region rgnToClear;
@@ -614,6 +611,7 @@ void ExpandCelCanvas::validateDestCanvas(const gfx::Region& rgn)
     rgnToValidate.offset(-m_bounds.origin());
   rgnToValidate.createSubtraction(rgnToValidate, m_validDstRegion);
   rgnToValidate.createIntersection(rgnToValidate, gfx::Region(m_dstImage->bounds()));
+  clearTiles(m_dstImage.get(), m_clearedDstTiles, rgnToValidate);
 
   // ASSERT(src);                  // TODO is it always true?
   if (src) {
@@ -662,8 +660,7 @@ void ExpandCelCanvas::invalidateDestCanvas()
   EXP_TRACE("ExpandCelCanvas::invalidateDestCanvas");
   m_validDstRegion.clear();
 
-  // Copy tileset for preview again
-  // TODO Is there a way to avoid copying tiles that weren't modified? comparing versions maybe?
+  // Restore the modified tiles of the preview tileset
   if (m_dstTileset)
     copySourceTilestToDestTileset();
 }
@@ -715,16 +712,54 @@ ImageRef ExpandCelCanvas::trimDstImage(const gfx::Rect& bounds) const
                              m_dstImage->maskColor()));
 }
 
+void ExpandCelCanvas::clearTiles(Image* image,
+                                 std::vector<bool>& clearedTiles,
+                                 const gfx::Region& rgn)
+{
+  const int cols = tiles_count(image->width(), kTileSize);
+  const color_t maskColor = image->maskColor();
+
+  for (const gfx::Rect& rc : rgn) {
+    const gfx::Rect tiles(rc.x / kTileSize,
+                          rc.y / kTileSize,
+                          tiles_count(rc.x2(), kTileSize) - rc.x / kTileSize,
+                          tiles_count(rc.y2(), kTileSize) - rc.y / kTileSize);
+
+    for (int v = tiles.y; v < tiles.y2(); ++v) {
+      // Clear consecutive tiles of the same row at once
+      for (int u = tiles.x; u < tiles.x2();) {
+        if (clearedTiles[v * cols + u]) {
+          ++u;
+          continue;
+        }
+
+        const int u0 = u;
+        for (; u < tiles.x2() && !clearedTiles[v * cols + u]; ++u)
+          clearedTiles[v * cols + u] = true;
+
+        fill_rect(
+          image,
+          gfx::Rect(u0 * kTileSize, v * kTileSize, (u - u0) * kTileSize, kTileSize) &
+            image->bounds(),
+          maskColor);
+      }
+    }
+  }
+}
+
 void ExpandCelCanvas::copySourceTilestToDestTileset()
 {
   ASSERT(m_layer->isTilemap());
   const Tileset* srcTileset = static_cast<LayerTilemap*>(m_layer)->tileset();
 
+  // Only modified tiles have their own image, the rest are still
+  // shared with the original tileset.
   for (tile_index i = 0; i < srcTileset->size(); ++i) {
-    doc::copy_image(m_dstTileset->get(i).get(), srcTileset->get(i).get());
-    m_dstTileset->setTileData(i, srcTileset->getTileData(i));
-    // To rehash the tileset
-    m_dstTileset->notifyTileContentChange(i);
+    const ImageRef srcTile = srcTileset->get(i);
+    if (m_dstTileset->get(i) != srcTile) {
+      m_dstTileset->set(i, srcTile);
+      m_dstTileset->setTileData(i, srcTileset->getTileData(i));
+    }
   }
 }
 
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2021  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -15,12 +15,15 @@
 #include "doc/grid.h"
 #include "doc/image_ref.h"
 #include "doc/layer.h"
+#include "doc/pixel_format.h"
 #include "filters/tiled_mode.h"
 #include "gfx/point.h"
 #include "gfx/rect.h"
 #include "gfx/region.h"
 #include "gfx/size.h"
 
+#include <vector>
+
 namespace doc {
 class Cel;
 class Image;
@@ -98,6 +101,11 @@ private:
   gfx::Rect getTrimDstImageBounds() const;
   ImageRef trimDstImage(const gfx::Rect& bounds) const;
   void copySourceTilestToDestTileset();
+  Image* createScratchImage(PixelFormat pixelFormat) const;
+
+  // Clears (with the mask color) the tiles of the image that
+  // intersect the given region and weren't cleared yet.
+  void clearTiles(Image* image, std::vector<bool>& clearedTiles, const gfx::Region& rgn);
 
   bool isTilesetPreview() const { return ((m_flags & TilesetPreview) == TilesetPreview); }
 
@@ -129,6 +137,15 @@ private:
   gfx::Region m_validSrcRegion;
   gfx::Region m_validDstRegion;
 
+  // m_srcImage and m_dstImage are not cleared completely when they
+  // are created (they can be as big as the whole canvas), only tiles
+  // of kTileSize x kTileSize pixels are cleared when they are
+  // validated for the first time. So the memory of areas that are
+  // not touched by the stroke is never written.
+  static constexpr int kTileSize = 64;
+  std::vector<bool> m_clearedSrcTiles;
+  std::vector<bool> m_clearedDstTiles;
+
   // True if we can compare src image with dst image to patch the
   // cel. This is false when dst is copied to the src, so we cannot
   // reduce the patched region because both images will be the same.
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2024  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2018  David Capello
 //
 // This program is distributed under the terms of
@@ -34,7 +34,11 @@ void select_layer_boundaries(Layer* layer, const frame_t frame, const SelectLaye
   const Cel* cel = layer->cel(frame);
   if (cel) {
     const Image* image = cel->image();
-    newMask.fromImage(image, cel->bounds().origin(), 128); // TODO configurable alpha threshold
+    gfx::Rect opaqueBounds;
+    // Completely transparent images (the usual empty cels) generate an
+    // empty mask
+    if (image->isTilemap() || image->opaqueBounds(opaqueBounds))
+      newMask.fromImage(image, cel->bounds().origin(), 128); // TODO configurable alpha threshold
   }
 
   try {
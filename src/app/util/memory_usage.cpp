@@ -0,0 +1,112 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/util/memory_usage.h"
+
+#include "app/context.h"
+#include "app/doc.h"
+#include "app/doc_undo.h"
+#include "app/docs.h"
+#include "app/job.h"
+#include "app/pref/preferences.h"
+#include "app/task.h"
+#include "doc/cel.h"
+#include "doc/cel_data.h"
+#include "doc/image.h"
+#include "doc/image_buffer_pool.h"
+#include "doc/lazy_image.h"
+#include "doc/sprite.h"
+#include "ui/manager.h"
+#include "ui/system.h"
+
+#include <algorithm>
+#include <set>
+#include <vector>
+
+namespace app {
+
+DocMemoryUsage get_doc_memory_usage(const Doc* doc)
+{
+  DocMemoryUsage usage;
+
+  // Sprite::getMemSize() returns an int, so we sum the image sizes
+  // here to avoid overflows in big sprites.
+  if (const doc::Sprite* sprite = doc->sprite()) {
+    std::vector<doc::ImageRef> images;
+    sprite->getImages(images);
+    for (const doc::ImageRef& image : images)
+      usage.images += std::size_t(image->rowBytes()) * image->height();
+  }
+
+  if (const DocUndo* undo = doc->undoHistory())
+    usage.undo = undo->totalUndoSize();
+
+  return usage;
+}
+
+DocMemoryUsage get_docs_memory_usage(const Docs& docs)
+{
+  DocMemoryUsage usage;
+  for (const Doc* doc : docs)
+    usage += get_doc_memory_usage(doc);
+  return usage;
+}
+
+void apply_image_buffers_cache_limit()
+{
+  const int mb = std::max(0, Preferences::instance().experimental.imageBuffersCacheSize());
+  doc::ImageBufferPool::instance()->setMaxBytes(std::size_t(mb) * 1024 * 1024);
+}
+
+bool trim_lazy_images_caches(Context* ctx)
+{
+  ui::assert_ui_thread();
+
+  // Commands, jobs (e.g. Export Sprite Sheet), and tasks (e.g. filter
+  // previews) can be using raw pointers to decoded images.
+  if (ctx->executingCommand() || Job::runningJobs() > 0 || Task::runningTasks() > 0)
+    return false;
+
+  // The mouse is captured while the user is drawing or moving pixels
+  // in the editor (the tool loop uses raw pointers too).
+  if (ui::Manager* manager = ui::Manager::getDefault(); manager && manager->getCapture())
+    return false;
+
+  // Lock all documents so other threads (e.g. the data recovery)
+  // cannot read images while we discard them.
+  std::vector<std::pair<Doc*, Doc::LockResult>> locks;
+  bool locked = true;
+  for (Doc* doc : ctx->documents()) {
+    const Doc::LockResult res = doc->writeLock(0);
+    if (res == Doc::LockResult::Fail) {
+      locked = false;
+      break;
+    }
+    locks.emplace_back(doc, res);
+  }
+
+  if (locked) {
+    std::set<doc::LazyImagesCache*> caches;
+    for (const auto& lock : locks) {
+      for (const doc::Cel* cel : lock.first->sprite()->uniqueCels()) {
+        if (const doc::LazyImageRef& lazyImage = cel->data()->lazyImage())
+          caches.insert(lazyImage->cache().get());
+      }
+    }
+    for (doc::LazyImagesCache* cache : caches)
+      cache->trim();
+  }
+
+  for (auto& lock : locks)
+    lock.first->unlock(lock.second);
+  return locked;
+}
+
+} // namespace app
@@ -0,0 +1,53 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_UTIL_MEMORY_USAGE_H_INCLUDED
+#define APP_UTIL_MEMORY_USAGE_H_INCLUDED
+#pragma once
+
+#include <cstddef>
+
+namespace app {
+class Context;
+class Doc;
+class Docs;
+
+// Approximate memory (in bytes) used by a document.
+struct DocMemoryUsage {
+  std::size_t images = 0; // Pixels of cels and tilesets
+  std::size_t undo = 0;   // Undo history
+
+  std::size_t total() const { return images + undo; }
+
+  DocMemoryUsage& operator+=(const DocMemoryUsage& other)
+  {
+    images += other.images;
+    undo += other.undo;
+    return *this;
+  }
+};
+
+DocMemoryUsage get_doc_memory_usage(const Doc* doc);
+
+// Sum of the memory used by all the given documents.
+DocMemoryUsage get_docs_memory_usage(const Docs& docs);
+
+// Applies the limit of the cache of unused image buffers from the
+// preferences (experimental.image_buffers_cache_size in MB), and
+// deletes the unused buffers that exceed the new limit.
+void apply_image_buffers_cache_limit();
+
+// Discards decoded lazy images of the context documents that exceed
+// the limit of their caches (see doc::LazyImagesCache::trim()). It
+// must be called from the UI thread, and it does nothing if it's not
+// a safe point to discard images (a command, a job, or a task is
+// running, or a document is locked). Returns true if the caches were
+// trimmed.
+bool trim_lazy_images_caches(Context* ctx);
+
+} // namespace app
+
+#endif
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020-2021  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -10,6 +10,9 @@
 
 #include "app/commands/cmd_open_file.h"
 #include "app/context.h"
+#include "app/file/file.h"
+#include "fmt/format.h"
+#include "gfx/rect.h"
 
 namespace app {
 
@@ -19,11 +22,37 @@ namespace app {
 // elements)
 class OpenBatchOfFiles {
 public:
-  void open(Context* ctx, const std::string& fn, const bool oneFrame)
+  // If the region of interest is specified, formats that support it
+  // will decode only the pixels inside its bounds, and the cels of
+  // its tag/frames/layers.
+  void open(Context* ctx,
+            const std::string& fn,
+            const bool oneFrame,
+            const FileOpROI* roi = nullptr)
   {
     Params params;
     params.set("filename", fn.c_str());
 
+    if (roi) {
+      const gfx::Rect& bounds = roi->bounds();
+      if (!bounds.isEmpty())
+        params.set("roi",
+                   fmt::format("{},{},{},{}", bounds.x, bounds.y, bounds.w, bounds.h).c_str());
+      if (!roi->tagName().empty())
+        params.set("roi_tag", roi->tagName().c_str());
+      if (!roi->framesSequence().empty())
+        params.set("roi_frames", fmt::format("{},{}", roi->fromFrame(), roi->toFrame()).c_str());
+      if (!roi->layersToLoad().empty()) {
+        std::string layers;
+        for (const std::string& layer : roi->layersToLoad()) {
+          if (!layers.empty())
+            layers.push_back(',');
+          layers += layer;
+        }
+        params.set("roi_layers", layers.c_str());
+      }
+    }
+
     if (oneFrame)
       params.set("oneframe", "true");
     else {
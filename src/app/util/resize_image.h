@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (c) 2019-2025  Igara Studio S.A.
+// Copyright (c) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -10,6 +10,7 @@
 
 #include "doc/algorithm/resize_image.h"
 #include "doc/color.h"
+#include "doc/image_ref.h"
 #include "gfx/point.h"
 #include "gfx/size.h"
 
@@ -32,11 +33,24 @@ doc::Image* resize_image(doc::Image* image,
                          const doc::Palette* pal,
                          const doc::RgbMap* rgbmap);
 
+// Creates the resized image that resize_cel_image() uses to replace
+// the cel image (nullptr if the cel image is not resized, e.g. linked
+// cels or reference layers). It doesn't modify the sprite, so it can
+// be called from several threads for different cels, except for
+// indexed images and the bilinear method (which use the RgbMap of
+// the sprite).
+doc::ImageRef create_resized_cel_image(doc::Cel* cel,
+                                       const gfx::SizeF& scale,
+                                       const doc::algorithm::ResizeMethod method);
+
+// Resizes the cel image. If "newImage" is not nullptr, it must be the
+// result of create_resized_cel_image() for the same cel.
 void resize_cel_image(Tx& tx,
                       doc::Cel* cel,
                       const gfx::SizeF& scale,
                       const doc::algorithm::ResizeMethod method,
-                      const gfx::PointF& pivot);
+                      const gfx::PointF& pivot,
+                      doc::ImageRef newImage = doc::ImageRef());
 
 } // namespace app
 
@@ -0,0 +1,335 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "app/util/undo_buffer.h"
+
+#include "app/task_scheduler.h"
+#include "base/convert_to.h"
+#include "base/exception.h"
+#include "base/fs.h"
+#include "base/fstream_path.h"
+#include "base/process.h"
+#include "zlib.h"
+
+#include <atomic>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace app {
+
+// Small buffers are not compressed or moved to disk (the gain
+// doesn't justify the extra work).
+static constexpr std::size_t kMinSizeToCompress = 4096;
+
+struct UndoBuffer::Data {
+  enum class Kind { Raw, Compressed, OnDisk };
+
+  mutable std::mutex mutex;
+  Kind kind = Kind::Raw;
+
+  // Incremented each time the raw data is used, to avoid compressing
+  // a buffer that is in use.
+  int generation = 0;
+
+  std::size_t rawSize = 0;
+  base::buffer raw;
+  base::buffer compressed;
+  std::string filename;
+
+  // True if the file contains compressed data (or false if it
+  // contains the raw data)
+  bool compressedOnDisk = false;
+
+  // True if the buffer was scheduled to be moved to disk
+  bool spillPending = false;
+
+  ~Data()
+  {
+    if (kind == Kind::Compressed)
+      removeCompressedBytes();
+    else if (kind == Kind::OnDisk)
+      deleteFile();
+  }
+
+  void restore();
+  void compress(const int gen);
+  void moveToDisk();
+
+private:
+  void deleteFile();
+  void removeCompressedBytes();
+};
+
+namespace {
+
+std::mutex g_mutex;
+
+// Buffers used since the last packPendingBuffers()
+std::vector<std::weak_ptr<UndoBuffer::Data>> g_pending;
+
+// Compressed buffers in memory (the oldest ones first)
+std::deque<std::weak_ptr<UndoBuffer::Data>> g_compressed;
+std::atomic<std::size_t> g_compressedBytes = 0;
+
+// Buffers are compressed/moved to disk one after the other in the
+// background workers
+SerialTaskGroup& pack_tasks()
+{
+  static SerialTaskGroup tasks(TaskKind::Compute, 1, doc::TaskPriority::Background);
+  return tasks;
+}
+
+std::string new_temp_filename()
+{
+  static std::atomic<int> counter = 0;
+  return base::join_path(base::get_temp_path(),
+                         "aseprite-undo-" +
+                           base::convert_to<std::string>(int(base::get_current_process_id())) +
+                           "-" + base::convert_to<std::string>(++counter) + ".tmp");
+}
+
+} // anonymous namespace
+
+void UndoBuffer::Data::restore()
+{
+  ++generation;
+
+  if (kind == Kind::Raw)
+    return;
+
+  if (kind == Kind::OnDisk) {
+    base::buffer data;
+    std::ifstream f(FSTREAM_PATH(filename), std::ifstream::binary);
+    f.seekg(0, std::ios::end);
+    data.resize(f.tellg());
+    f.seekg(0);
+    f.read((char*)data.data(), data.size());
+    if (!f)
+      throw base::Exception("Error reading undo information from %s", filename.c_str());
+    deleteFile();
+
+    if (!compressedOnDisk) {
+      raw.swap(data);
+      kind = Kind::Raw;
+      return;
+    }
+    compressed.swap(data);
+  }
+  else {
+    removeCompressedBytes();
+  }
+
+  raw.resize(rawSize);
+  uLongf size = rawSize;
+  const int err = uncompress(raw.data(), &size, compressed.data(), compressed.size());
+  if (err != Z_OK || size != rawSize)
+    throw base::Exception("ZLib error %d decompressing undo information", err);
+
+  base::buffer().swap(compressed);
+  kind = Kind::Raw;
+}
+
+void UndoBuffer::Data::compress(const int gen)
+{
+  // The buffer was used after it was scheduled to be compressed
+  if (kind != Kind::Raw || gen != generation || raw.size() < kMinSizeToCompress)
+    return;
+
+  compressed.resize(compressBound(raw.size()));
+  uLongf size = compressed.size();
+  if (compress2(compressed.data(), &size, raw.data(), raw.size(), Z_BEST_SPEED) != Z_OK ||
+      size >= raw.size()) {
+    // Keep the raw data
+    base::buffer().swap(compressed);
+    return;
+  }
+
+  compressed.resize(size);
+  compressed.shrink_to_fit();
+  rawSize = raw.size();
+  base::buffer().swap(raw);
+  kind = Kind::Compressed;
+  g_compressedBytes += compressed.size();
+}
+
+void UndoBuffer::Data::moveToDisk()
+{
+  spillPending = false;
+
+  base::buffer* data;
+  if (kind == Kind::Compressed)
+    data = &compressed;
+  else if (kind == Kind::Raw && raw.size() >= kMinSizeToCompress)
+    data = &raw;
+  else
+    return;
+
+  std::string fn = new_temp_filename();
+  {
+    std::ofstream f(FSTREAM_PATH(fn), std::ofstream::binary);
+    f.write((const char*)data->data(), data->size());
+    if (!f) {
+      // Keep the data in memory
+      f.close();
+      base::delete_file(fn);
+      return;
+    }
+  }
+
+  compressedOnDisk = (kind == Kind::Compressed);
+  if (compressedOnDisk)
+    removeCompressedBytes();
+  else
+    rawSize = raw.size();
+  base::buffer().swap(*data);
+  filename = fn;
+  kind = Kind::OnDisk;
+}
+
+void UndoBuffer::Data::deleteFile()
+{
+  try {
+    base::delete_file(filename);
+  }
+  catch (const std::exception&) {
+    // Ignore errors
+  }
+  filename.clear();
+}
+
+void UndoBuffer::Data::removeCompressedBytes()
+{
+  g_compressedBytes -= compressed.size();
+}
+
+UndoBuffer::UndoBuffer() : m_data(std::make_shared<Data>())
+{
+}
+
+UndoBuffer::~UndoBuffer()
+{
+}
+
+base::buffer& UndoBuffer::data()
+{
+  {
+    const std::lock_guard lock(m_data->mutex);
+    m_data->restore();
+  }
+  {
+    const std::lock_guard lock(g_mutex);
+    g_pending.push_back(m_data);
+  }
+  return m_data->raw;
+}
+
+std::size_t UndoBuffer::memSize() const
+{
+  const std::lock_guard lock(m_data->mutex);
+  switch (m_data->kind) {
+    case Data::Kind::Raw:        return m_data->raw.size();
+    case Data::Kind::Compressed: return m_data->compressed.size();
+    case Data::Kind::OnDisk:     return 0;
+  }
+  return 0;
+}
+
+std::size_t UndoBuffer::spillToDisk()
+{
+  int gen;
+  std::size_t size;
+  {
+    const std::lock_guard lock(m_data->mutex);
+    if (m_data->spillPending)
+      return 0;
+
+    switch (m_data->kind) {
+      case Data::Kind::Raw:
+        if (m_data->raw.size() < kMinSizeToCompress)
+          return 0;
+        size = m_data->raw.size();
+        break;
+      case Data::Kind::Compressed: size = m_data->compressed.size(); break;
+      default:                     return 0;
+    }
+    m_data->spillPending = true;
+    gen = m_data->generation;
+  }
+
+  pack_tasks().run([weak = std::weak_ptr<Data>(m_data), gen] {
+    if (auto data = weak.lock()) {
+      const std::lock_guard lock(data->mutex);
+      // The buffer was used after it was scheduled
+      if (gen != data->generation) {
+        data->spillPending = false;
+        return;
+      }
+      data->moveToDisk();
+    }
+  });
+  return size;
+}
+
+// static
+void UndoBuffer::packPendingBuffers(const Options& options)
+{
+  std::vector<std::weak_ptr<Data>> pending;
+  {
+    const std::lock_guard lock(g_mutex);
+    g_pending.swap(pending);
+  }
+  if (!options.compress)
+    return;
+
+  for (auto& weak : pending) {
+    auto data = weak.lock();
+    if (!data)
+      continue;
+
+    int gen;
+    {
+      const std::lock_guard lock(data->mutex);
+      gen = data->generation;
+    }
+
+    pack_tasks().run([weak, gen, options] {
+      if (auto data = weak.lock()) {
+        const std::lock_guard lock(data->mutex);
+        data->compress(gen);
+        if (data->kind != Data::Kind::Compressed)
+          return;
+      }
+      else
+        return;
+
+      const std::lock_guard lock(g_mutex);
+      g_compressed.push_back(weak);
+
+      // Move the oldest compressed buffers to disk
+      while (options.maxMemory > 0 && g_compressedBytes > options.maxMemory &&
+             !g_compressed.empty()) {
+        auto oldest = g_compressed.front().lock();
+        g_compressed.pop_front();
+        if (oldest) {
+          const std::lock_guard lock(oldest->mutex);
+          // Raw buffers (restored since they were compressed) could
+          // be in use
+          if (oldest->kind == Data::Kind::Compressed)
+            oldest->moveToDisk();
+        }
+      }
+    });
+  }
+}
+
+} // namespace app
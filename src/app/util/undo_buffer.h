@@ -0,0 +1,72 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef APP_UTIL_UNDO_BUFFER_H_INCLUDED
+#define APP_UTIL_UNDO_BUFFER_H_INCLUDED
+#pragma once
+
+#include "base/buffer.h"
+#include "base/disable_copying.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace app {
+
+// Buffer to store the undo information of commands (e.g. pixels
+// of a cmd::CopyRegion). When the command is committed, the data can
+// be compressed in a background thread and, if there is too much
+// compressed data in memory, the oldest buffers are moved to
+// temporary files. The original data is restored when it's needed
+// again (e.g. to undo/redo the command).
+class UndoBuffer {
+public:
+  struct Options {
+    // True if the buffers should be compressed.
+    bool compress = false;
+
+    // Maximum number of compressed bytes to keep in memory (the
+    // oldest buffers are moved to disk), or 0 to keep all of them
+    // in memory.
+    std::size_t maxMemory = 0;
+  };
+
+  UndoBuffer();
+  ~UndoBuffer();
+
+  // Returns the uncompressed data (decompressing it if it's needed)
+  // to use/modify it. After using it, the buffer will be packed
+  // again in the next call to packPendingBuffers().
+  base::buffer& data();
+
+  // Bytes of this buffer in memory.
+  std::size_t memSize() const;
+
+  // Moves the data to a temporary file in a background thread (even
+  // if it's not compressed). It's used to keep the memory of old undo
+  // states low. Returns the number of bytes that will be released
+  // from memory (0 if the buffer is too small or it's already on
+  // disk).
+  std::size_t spillToDisk();
+
+  // Compresses all the buffers that were used since the last call,
+  // in a background thread. This should be called when the buffers
+  // are not used anymore (e.g. when a command is committed to the
+  // undo history, or when it's undone/redone).
+  static void packPendingBuffers(const Options& options);
+
+  // Internal data shared with the background thread.
+  struct Data;
+
+private:
+  std::shared_ptr<Data> m_data;
+
+  DISABLE_COPYING(UndoBuffer);
+};
+
+} // namespace app
+
+#endif
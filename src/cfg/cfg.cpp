@@ -1,5 +1,5 @@
 // Aseprite Config Library
-// Copyright (C) 2019-2023  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2014-2017  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -14,10 +14,16 @@
 #include "base/file_handle.h"
 #include "base/string.h"
 
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <list>
 
+#ifdef _WIN32
+  #include <windows.h>
+#endif
+
 #include "SimpleIni.h"
 
 #include "base/log.h"
@@ -70,27 +76,54 @@ public:
 
   void setValue(const char* section, const char* name, const char* value)
   {
+    const char* oldValue = m_ini.GetValue(section, name, nullptr);
+    if (oldValue && value && std::strcmp(oldValue, value) == 0)
+      return;
+
     m_ini.SetValue(section, name, value);
+    m_modified = true;
   }
 
   void setBoolValue(const char* section, const char* name, bool value)
   {
+    if (hasValue(section, name) && m_ini.GetBoolValue(section, name, !value) == value)
+      return;
+
     m_ini.SetBoolValue(section, name, value);
+    m_modified = true;
   }
 
   void setIntValue(const char* section, const char* name, int value)
   {
+    if (hasValue(section, name) && m_ini.GetLongValue(section, name, 0) == value)
+      return;
+
     m_ini.SetLongValue(section, name, value);
+    m_modified = true;
   }
 
   void setDoubleValue(const char* section, const char* name, double value)
   {
+    if (hasValue(section, name) && m_ini.GetDoubleValue(section, name, 0.0) == value)
+      return;
+
     m_ini.SetDoubleValue(section, name, value);
+    m_modified = true;
+  }
+
+  void deleteValue(const char* section, const char* name)
+  {
+    if (m_ini.Delete(section, name, true))
+      m_modified = true;
   }
 
-  void deleteValue(const char* section, const char* name) { m_ini.Delete(section, name, true); }
+  void deleteSection(const char* section)
+  {
+    if (m_ini.Delete(section, nullptr, true))
+      m_modified = true;
+  }
 
-  void deleteSection(const char* section) { m_ini.Delete(section, nullptr, true); }
+  bool isModified() const { return m_modified; }
 
   bool load(const std::string& filename)
   {
@@ -105,23 +138,69 @@ public:
         return false;
       }
     }
+    m_modified = false;
     return true;
   }
 
   void save()
   {
-    base::FileHandle file(base::open_file(m_filename, "wb"));
-    if (file) {
-      SI_Error err = m_ini.SaveFile(file.get());
-      if (err != SI_OK) {
-        LOG(ERROR, "CFG: Error %d saving configuration into %s\n", (int)err, m_filename.c_str());
+    std::string data;
+    if (m_modified && serialize(data))
+      saveData(m_filename, data);
+  }
+
+  bool serialize(std::string& data)
+  {
+    SI_Error err = m_ini.Save(data);
+    if (err != SI_OK) {
+      LOG(ERROR, "CFG: Error %d saving configuration into %s\n", (int)err, m_filename.c_str());
+      return false;
+    }
+    m_modified = false;
+    return true;
+  }
+
+  static bool saveData(const std::string& filename, const std::string& data)
+  {
+    // Write a temporary file and then replace the old one, so we
+    // don't lose the whole configuration if the program crashes
+    // while the file is being written.
+    const std::string tmpFilename = filename + ".tmp";
+    {
+      base::FileHandle file(base::open_file(tmpFilename, "wb"));
+      if (!file)
+        return false;
+
+      if (std::fwrite(data.data(), 1, data.size(), file.get()) != data.size() ||
+          std::fflush(file.get()) != 0) {
+        LOG(ERROR, "CFG: Error writing configuration into %s\n", tmpFilename.c_str());
+        return false;
       }
     }
+
+#ifdef _WIN32
+    const bool ok = MoveFileExW(base::from_utf8(tmpFilename).c_str(),
+                                base::from_utf8(filename).c_str(),
+                                MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+    const bool ok = (std::rename(tmpFilename.c_str(), filename.c_str()) == 0);
+#endif
+    if (!ok) {
+      LOG(ERROR, "CFG: Error replacing configuration file %s\n", filename.c_str());
+      return false;
+    }
+    return true;
   }
 
 private:
+  bool hasValue(const char* section, const char* name) const
+  {
+    return (m_ini.GetValue(section, name, nullptr) != nullptr);
+  }
+
   std::string m_filename;
   CSimpleIniA m_ini;
+  bool m_modified = false;
 };
 
 CfgFile::CfgFile() : m_impl(new CfgFileImpl)
@@ -198,14 +277,43 @@ void CfgFile::deleteSection(const char* section)
   m_impl->deleteSection(section);
 }
 
+void CfgFile::merge(const CfgFile& other)
+{
+  std::vector<std::string> sections;
+  std::vector<std::string> keys;
+  other.getAllSections(sections);
+  for (const auto& section : sections) {
+    keys.clear();
+    other.getAllKeys(section.c_str(), keys);
+    for (const auto& key : keys)
+      setValue(section.c_str(), key.c_str(), other.getValue(section.c_str(), key.c_str(), ""));
+  }
+}
+
 bool CfgFile::load(const std::string& filename)
 {
   return m_impl->load(filename);
 }
 
+bool CfgFile::isModified() const
+{
+  return m_impl->isModified();
+}
+
 void CfgFile::save()
 {
   m_impl->save();
 }
 
+bool CfgFile::serialize(std::string& data)
+{
+  return m_impl->serialize(data);
+}
+
+// static
+bool CfgFile::saveData(const std::string& filename, const std::string& data)
+{
+  return CfgFileImpl::saveData(filename, data);
+}
+
 } // namespace cfg
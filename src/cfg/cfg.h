@@ -1,5 +1,5 @@
 // Aseprite Config Library
-// Copyright (C) 2019-2023  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2014-2016  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -37,9 +37,25 @@ public:
   void deleteValue(const char* section, const char* name);
   void deleteSection(const char* section);
 
+  // Copies all the values of the other file into this one.
+  void merge(const CfgFile& other);
+
+  // Returns true if some value was changed/deleted since the file
+  // was loaded or saved.
+  bool isModified() const;
+
   bool load(const std::string& filename);
+
+  // Saves the file (only if it was modified) replacing the old file
+  // atomically.
   void save();
 
+  // Serializes the content of the file to be saved later with
+  // CfgFile::saveData() (e.g. from a background thread). The file
+  // is marked as not modified.
+  bool serialize(std::string& data);
+  static bool saveData(const std::string& filename, const std::string& data);
+
 private:
   class CfgFileImpl;
   CfgFileImpl* m_impl;
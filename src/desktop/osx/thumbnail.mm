@@ -1,15 +1,14 @@
 // Desktop Integration
-// Copyright (c) 2022-2025  Igara Studio S.A.
+// Copyright (c) 2022-2026  Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
 
 #include "app/file_system.h"
-#include "dio/decode_delegate.h"
-#include "dio/decode_file.h"
+#include "desktop/thumbnail.h"
 #include "dio/file_interface.h"
-#include "doc/sprite.h"
-#include "render/render.h"
+#include "doc/image.h"
+#include "doc/image_bits.h"
 
 #include <Cocoa/Cocoa.h>
 #include <QuickLookThumbnailing/QuickLookThumbnailing.h>
@@ -18,20 +17,6 @@ namespace desktop {
 
 namespace {
 
-class DecodeDelegate : public dio::DecodeDelegate {
-public:
-  DecodeDelegate() : m_sprite(nullptr) {}
-  ~DecodeDelegate() { delete m_sprite; }
-
-  bool decodeOneFrame() override { return true; }
-  void onSprite(doc::Sprite* sprite) override { m_sprite = sprite; }
-
-  doc::Sprite* sprite() { return m_sprite; }
-
-private:
-  doc::Sprite* m_sprite;
-};
-
 class StreamAdaptor : public dio::FileInterface {
 public:
   StreamAdaptor(NSData* data) : m_data(data), m_ok(m_data != nullptr), m_pos(0) {}
@@ -95,34 +80,14 @@ CGImageRef get_thumbnail(CFURLRef url, CGSize maxSize)
   int w, h;
 
   try {
-    DecodeDelegate delegate;
-    StreamAdaptor adaptor(data);
-    if (!dio::decode_file(&delegate, &adaptor))
-      return nullptr;
-
-    const doc::Sprite* spr = delegate.sprite();
-    if (!spr)
-      return nullptr;
-
-    w = spr->width();
-    h = spr->height();
-    int wh = std::max<int>(w, h);
-    int cx;
+    int cx = 0;
     if (maxSize.width && maxSize.height)
       cx = std::min<int>(maxSize.width, maxSize.height);
-    else
-      cx = wh;
-
-    image.reset(doc::Image::create(doc::IMAGE_RGB, cx * w / wh, cx * h / wh));
-    image->clear(0);
-
-    render::Render render;
-    render.setBgOptions(render::BgOptions::MakeTransparent());
-    render.setProjection(render::Projection(doc::PixelRatio(1, 1), render::Zoom(cx, wh)));
-    render.renderSprite(image.get(),
-                        spr,
-                        0,
-                        gfx::ClipF(0, 0, 0, 0, image->width(), image->height()));
+
+    StreamAdaptor adaptor(data);
+    image = make_thumbnail(&adaptor, cx);
+    if (!image)
+      return nullptr;
 
     // Alpha premultiplication.
     // CGBitmapContextCreate doesn't support unpremultiplied alpha images (kCGImageAlphaFirst).
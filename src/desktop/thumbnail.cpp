@@ -0,0 +1,88 @@
+// Desktop Integration
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "desktop/thumbnail.h"
+
+#include "dio/decode_delegate.h"
+#include "dio/decode_file.h"
+#include "doc/cel.h"
+#include "doc/image.h"
+#include "doc/layer.h"
+#include "doc/sprite.h"
+#include "render/render.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace desktop {
+
+namespace {
+
+class ThumbnailDecodeDelegate : public dio::DecodeDelegate {
+public:
+  // Only the first frame is needed, and cels that are not visible
+  // in the thumbnail are not even read from the file.
+  bool decodeOneFrame() override { return true; }
+  bool decodeCelsInLayer(const doc::Layer* layer) override
+  {
+    return (layer->isVisibleHierarchy() && !layer->isReference());
+  }
+
+  // Files with an embedded preview are rendered from it (the
+  // preview is scaled again to the requested size).
+  bool decodePreview() override { return true; }
+  void onPreview(const doc::ImageRef& image) override
+  {
+    m_sprite = std::make_unique<doc::Sprite>(image->spec(), 256);
+    auto layer = new doc::LayerImage(m_sprite.get());
+    m_sprite->root()->addLayer(layer);
+    layer->addCel(new doc::Cel(0, image));
+  }
+
+  void onSprite(doc::Sprite* sprite) override { m_sprite.reset(sprite); }
+
+  const doc::Sprite* sprite() const { return m_sprite.get(); }
+
+private:
+  std::unique_ptr<doc::Sprite> m_sprite;
+};
+
+} // anonymous namespace
+
+doc::ImageRef make_thumbnail(dio::FileInterface* f, const int maxSize)
+{
+  ThumbnailDecodeDelegate delegate;
+  if (!dio::decode_file(&delegate, f))
+    return nullptr;
+
+  const doc::Sprite* spr = delegate.sprite();
+  if (!spr)
+    return nullptr;
+
+  const int w = spr->width();
+  const int h = spr->height();
+  const int wh = std::max<int>(w, h);
+  const int size = (maxSize > 0 ? maxSize : wh);
+
+  // Render the sprite directly at the thumbnail size (each cel is
+  // scaled while it's composited), so we never need an image of
+  // the whole canvas.
+  doc::ImageRef image(doc::Image::create(doc::IMAGE_RGB,
+                                         std::max(1, size * w / wh),
+                                         std::max(1, size * h / wh)));
+  image->clear(0);
+
+  render::Render render;
+  render.setBgOptions(render::BgOptions::MakeTransparent());
+  render.setProjection(render::Projection(doc::PixelRatio(1, 1), render::Zoom(size, wh)));
+  render.renderSprite(image.get(),
+                      spr,
+                      0,
+                      gfx::ClipF(0, 0, 0, 0, image->width(), image->height()));
+  return image;
+}
+
+} // namespace desktop
@@ -0,0 +1,30 @@
+// Desktop Integration
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef DESKTOP_THUMBNAIL_H_INCLUDED
+#define DESKTOP_THUMBNAIL_H_INCLUDED
+#pragma once
+
+#include "doc/image_ref.h"
+
+namespace dio {
+class FileInterface;
+}
+
+namespace desktop {
+
+// Decodes only the first frame of the given .aseprite file (without
+// the cels of hidden and reference layers) and renders it directly
+// at the thumbnail size in a new RGB image that fits in a square of
+// "maxSize" pixels (or at 100% if maxSize is 0). Returns an empty
+// ImageRef if the file cannot be decoded.
+//
+// Used by the thumbnailers of Windows Explorer and macOS Finder.
+doc::ImageRef make_thumbnail(dio::FileInterface* f, const int maxSize);
+
+} // namespace desktop
+
+#endif
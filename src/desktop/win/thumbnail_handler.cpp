@@ -1,21 +1,17 @@
 // Desktop Integration
-// Copyright (C) 2021-2022  Igara Studio S.A.
+// Copyright (C) 2021-2026  Igara Studio S.A.
 // Copyright (C) 2017-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
 
 #include "base/base.h"
-#include "dio/decode_delegate.h"
-#include "dio/decode_file.h"
+#include "desktop/thumbnail.h"
 #include "dio/file_interface.h"
 #include "doc/color.h"
-#include "doc/document.h"
+#include "doc/image.h"
 #include "doc/image_ref.h"
 #include "doc/image_traits.h"
-#include "doc/pixel_format.h"
-#include "doc/sprite.h"
-#include "render/render.h"
 
 #include "desktop/win/thumbnail_handler.h"
 
@@ -30,20 +26,6 @@ namespace desktop {
 
 namespace {
 
-class DecodeDelegate : public dio::DecodeDelegate {
-public:
-  DecodeDelegate() : m_sprite(nullptr) {}
-  ~DecodeDelegate() { delete m_sprite; }
-
-  bool decodeOneFrame() override { return true; }
-  void onSprite(doc::Sprite* sprite) override { m_sprite = sprite; }
-
-  doc::Sprite* sprite() { return m_sprite; }
-
-private:
-  doc::Sprite* m_sprite;
-};
-
 class StreamAdaptor : public dio::FileInterface {
 public:
   StreamAdaptor(IStream* stream) : m_stream(stream), m_ok(m_stream != nullptr) {}
@@ -183,28 +165,11 @@ HRESULT ThumbnailHandler::GetThumbnail(UINT cx, HBITMAP* phbmp, WTS_ALPHATYPE* p
   int w, h;
 
   try {
-    DecodeDelegate delegate;
     StreamAdaptor adaptor(m_stream.get());
-    if (!dio::decode_file(&delegate, &adaptor))
+    image = make_thumbnail(&adaptor, cx);
+    if (!image)
       return E_FAIL;
 
-    const doc::Sprite* spr = delegate.sprite();
-    w = spr->width();
-    h = spr->height();
-    int wh = std::max<int>(w, h);
-
-    image.reset(doc::Image::create(doc::IMAGE_RGB, cx * w / wh, cx * h / wh));
-    image->clear(0);
-
-#undef TRANSPARENT // Windows defines TRANSPARENT macro
-    render::Render render;
-    render.setBgOptions(render::BgOptions::MakeTransparent());
-    render.setProjection(render::Projection(doc::PixelRatio(1, 1), render::Zoom(cx, wh)));
-    render.renderSprite(image.get(),
-                        spr,
-                        0,
-                        gfx::ClipF(0, 0, 0, 0, image->width(), image->height()));
-
     w = image->width();
     h = image->height();
   }
@@ -1,5 +1,5 @@
 // Aseprite Document IO Library
-// Copyright (c) 2018-2025 Igara Studio S.A.
+// Copyright (c) 2018-2026 Igara Studio S.A.
 // Copyright (c) 2001-2018 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -19,19 +19,33 @@
 #include "dio/aseprite_common.h"
 #include "dio/decode_delegate.h"
 #include "dio/file_interface.h"
+#include "dio/mapped_file.h"
 #include "dio/pixel_io.h"
 #include "doc/doc.h"
+#include "doc/lazy_image.h"
+#include "doc/task_group.h"
 #include "doc/util.h"
 #include "fixmath/fixmath.h"
 #include "fmt/format.h"
 #include "gfx/color_space.h"
 #include "zlib.h"
 
+#include <algorithm>
 #include <cstdio>
+#include <functional>
+#include <memory>
 #include <vector>
 
 namespace dio {
 
+AsepriteDecoder::AsepriteDecoder()
+{
+}
+
+AsepriteDecoder::~AsepriteDecoder()
+{
+}
+
 bool AsepriteDecoder::decode()
 {
   bool ignore_old_color_chunks = false;
@@ -86,6 +100,13 @@ bool AsepriteDecoder::decode()
   auto tag_end = sprite->tags().end();
 
   m_allLayers.clear();
+  m_inflater = std::make_unique<ImagesInflater>();
+
+  // Compressed cels can be decoded later (when they are used) from
+  // the memory-mapped file
+  m_lazyFile = delegate()->lazyImagesFile();
+  if (m_lazyFile)
+    m_lazyCache = std::make_shared<doc::LazyImagesCache>(delegate()->lazyImagesCacheSize());
 
   int current_level = -1;
   AsepriteExternalFiles extFiles;
@@ -95,6 +116,15 @@ bool AsepriteDecoder::decode()
   if (nframes > 1 && delegate()->decodeOneFrame())
     nframes = 1;
 
+  // Just some frames/region?
+  const doc::frame_t lastFrame = delegate()->decodeLastFrame();
+  if (lastFrame >= 0 && lastFrame < nframes)
+    nframes = lastFrame + 1;
+  m_decodeBounds = delegate()->decodeBounds();
+  m_decodeLayerCels.clear();
+  m_decodeCelsFrame = -1;
+  m_skippedCels.clear();
+
   // Read frame by frame to end-of-file
   for (doc::frame_t frame = 0; frame < nframes; ++frame) {
     // Start frame position
@@ -172,6 +202,7 @@ bool AsepriteDecoder::decode()
               last_object_with_user_data = cel->data();
             }
             else {
+              last_cel = nullptr;
               last_object_with_user_data = nullptr;
             }
             break;
@@ -285,6 +316,25 @@ bool AsepriteDecoder::decode()
             break;
           }
 
+          case ASE_FILE_CHUNK_PREVIEW: {
+            if (!delegate()->decodePreview())
+              break;
+
+            doc::ImageRef preview = readPreviewChunk(&header, chunk_pos + chunk_size);
+            if (preview) {
+              // The preview is the only thing we need, we can discard
+              // the rest of the sprite
+              m_inflater->finish(delegate());
+              m_inflater.reset();
+              m_lazyFile.reset();
+              m_lazyCache.reset();
+
+              delegate()->onPreview(preview);
+              return true;
+            }
+            break;
+          }
+
           default:
             delegate()->incompatibilityError(
               fmt::format("Warning: Unsupported chunk type {0} (skipping)", chunk_type));
@@ -303,6 +353,12 @@ bool AsepriteDecoder::decode()
       break;
   }
 
+  // Wait all the images being decompressed
+  m_inflater->finish(delegate());
+  m_inflater.reset();
+  m_lazyFile.reset();
+  m_lazyCache.reset();
+
   delegate()->onSprite(sprite.release());
   return true;
 }
@@ -681,12 +737,40 @@ void read_raw_image(FileInterface* f,
 // Compressed Image
 //////////////////////////////////////////////////////////////////////
 
+// Reads the compressed data of an image (from the current position
+// to the end of the chunk) to inflate it later.
+base::buffer read_compressed_data(FileInterface* f,
+                                  DecodeDelegate* delegate,
+                                  const AsepriteHeader* header,
+                                  const size_t chunk_end)
+{
+  base::buffer data;
+
+  while (f->tell() < chunk_end) {
+    const size_t input_bytes = std::min<size_t>(chunk_end - f->tell(), 4096);
+    const size_t n = data.size();
+    data.resize(n + input_bytes);
+
+    size_t bytes_read = f->readBytes(&data[n], input_bytes);
+    data.resize(n + bytes_read);
+
+    // Error reading "input_bytes" bytes, broken file? chunk without
+    // enough compressed data?
+    if (bytes_read == 0) {
+      delegate->error(fmt::format("Error reading {} bytes of compressed data", input_bytes));
+      break;
+    }
+
+    delegate->progress((float)f->tell() / (float)header->size);
+  }
+
+  return data;
+}
+
+// Inflates the given compressed data into the image. This function
+// can be called from any thread.
 template<typename ImageTraits>
-void read_compressed_image_templ(FileInterface* f,
-                                 DecodeDelegate* delegate,
-                                 doc::Image* image,
-                                 const AsepriteHeader* header,
-                                 const size_t chunk_end)
+void inflate_image_templ(const uint8_t* data, const size_t size, doc::Image* image)
 {
   PixelIO<ImageTraits> pixel_io;
   z_stream zstream;
@@ -701,78 +785,57 @@ void read_compressed_image_templ(FileInterface* f,
   const int width = image->width();
   const int widthBytes = image->widthBytes();
   std::vector<uint8_t> scanline(widthBytes);
-  std::vector<uint8_t> compressed(4096);
   std::vector<uint8_t> uncompressed(4096);
   int scanline_offset = 0;
   int y = 0;
 
-  while (true) {
-    size_t input_bytes;
+  zstream.next_in = (Bytef*)data;
+  zstream.avail_in = size;
+  zstream.avail_out = 0;
 
-    if (f->tell() + compressed.size() > chunk_end) {
-      input_bytes = chunk_end - f->tell(); // Remaining bytes
-      ASSERT(input_bytes < compressed.size());
+  while (zstream.avail_in != 0 || zstream.avail_out == 0) {
+    zstream.next_out = (Bytef*)&uncompressed[0];
+    zstream.avail_out = uncompressed.size();
 
-      if (input_bytes == 0)
-        break; // Done, we consumed all chunk
-    }
-    else {
-      input_bytes = compressed.size();
+    err = inflate(&zstream, Z_NO_FLUSH);
+    if (err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR) {
+      inflateEnd(&zstream);
+      throw base::Exception("ZLib error %d in inflate().", err);
     }
 
-    size_t bytes_read = f->readBytes(&compressed[0], input_bytes);
-
-    // Error reading "input_bytes" bytes, broken file? chunk without
-    // enough compressed data?
-    if (bytes_read == 0) {
-      delegate->error(fmt::format("Error reading {} bytes of compressed data", input_bytes));
-      break;
-    }
-
-    zstream.next_in = (Bytef*)&compressed[0];
-    zstream.avail_in = bytes_read;
-
-    do {
-      zstream.next_out = (Bytef*)&uncompressed[0];
-      zstream.avail_out = uncompressed.size();
-
-      err = inflate(&zstream, Z_NO_FLUSH);
-      if (err != Z_OK && err != Z_STREAM_END && err != Z_BUF_ERROR)
-        throw base::Exception("ZLib error %d in inflate().", err);
-
-      size_t uncompressed_bytes = uncompressed.size() - zstream.avail_out;
-      if (uncompressed_bytes > 0) {
-        int i = 0;
-        while (y < image->height()) {
-          int n = std::min(uncompressed_bytes, scanline.size() - scanline_offset);
-          if (n > 0) {
-            // Fill the scanline buffer until it's completed
-            std::copy(uncompressed.begin() + i,
-                      uncompressed.begin() + i + n,
-                      scanline.begin() + scanline_offset);
-            uncompressed_bytes -= n;
-            scanline_offset += n;
-            i += n;
-          }
-          else if (scanline_offset < widthBytes) {
-            // The scanline is not filled yet.
+    size_t uncompressed_bytes = uncompressed.size() - zstream.avail_out;
+    if (uncompressed_bytes > 0) {
+      int i = 0;
+      while (y < image->height()) {
+        int n = std::min(uncompressed_bytes, scanline.size() - scanline_offset);
+        if (n > 0) {
+          // Fill the scanline buffer until it's completed
+          std::copy(uncompressed.begin() + i,
+                    uncompressed.begin() + i + n,
+                    scanline.begin() + scanline_offset);
+          uncompressed_bytes -= n;
+          scanline_offset += n;
+          i += n;
+        }
+        else if (scanline_offset < widthBytes) {
+          // The scanline is not filled yet.
+          break;
+        }
+        else {
+          // Copy the whole scanline to the image
+          pixel_io.read_scanline((typename ImageTraits::address_t)image->getPixelAddress(0, y),
+                                 width,
+                                 &scanline[0]);
+          ++y;
+          scanline_offset = 0;
+          if (uncompressed_bytes == 0)
             break;
-          }
-          else {
-            // Copy the whole scanline to the image
-            pixel_io.read_scanline((typename ImageTraits::address_t)image->getPixelAddress(0, y),
-                                   width,
-                                   &scanline[0]);
-            ++y;
-            scanline_offset = 0;
-            if (uncompressed_bytes == 0)
-              break;
-          }
         }
       }
-    } while (zstream.avail_in != 0 && zstream.avail_out == 0);
+    }
 
-    delegate->progress((float)f->tell() / (float)header->size);
+    if (err == Z_STREAM_END)
+      break;
   }
 
   err = inflateEnd(&zstream);
@@ -780,41 +843,199 @@ void read_compressed_image_templ(FileInterface* f,
     throw base::Exception("ZLib error %d in inflateEnd().", err);
 }
 
-void read_compressed_image(FileInterface* f,
-                           DecodeDelegate* delegate,
-                           doc::Image* image,
-                           const AsepriteHeader* header,
-                           const size_t chunk_end)
+void inflate_image(const uint8_t* data, const size_t size, doc::Image* image)
 {
-  // Try to read pixel data
-  try {
-    switch (image->pixelFormat()) {
-      case doc::IMAGE_RGB:
-        read_compressed_image_templ<doc::RgbTraits>(f, delegate, image, header, chunk_end);
-        break;
-
-      case doc::IMAGE_GRAYSCALE:
-        read_compressed_image_templ<doc::GrayscaleTraits>(f, delegate, image, header, chunk_end);
-        break;
+  switch (image->pixelFormat()) {
+    case doc::IMAGE_RGB:       inflate_image_templ<doc::RgbTraits>(data, size, image); break;
+    case doc::IMAGE_GRAYSCALE: inflate_image_templ<doc::GrayscaleTraits>(data, size, image); break;
+    case doc::IMAGE_INDEXED:   inflate_image_templ<doc::IndexedTraits>(data, size, image); break;
+    case doc::IMAGE_TILEMAP:   inflate_image_templ<doc::TilemapTraits>(data, size, image); break;
+  }
+}
 
-      case doc::IMAGE_INDEXED:
-        read_compressed_image_templ<doc::IndexedTraits>(f, delegate, image, header, chunk_end);
-        break;
+// Image of a compressed cel that is decoded from the memory-mapped
+// file when it's needed.
+class AsepriteLazyImage : public doc::LazyImage {
+public:
+  AsepriteLazyImage(const MappedFileRef& file,
+                    const size_t offset,
+                    const size_t size,
+                    const doc::PixelFormat pixelFormat,
+                    const int width,
+                    const int height,
+                    const doc::LazyImagesCacheRef& cache)
+    : LazyImage(pixelFormat, width, height, cache)
+    , m_file(file)
+    , m_offset(offset)
+    , m_size(size)
+  {
+    ASSERT(m_offset + m_size <= m_file->size());
+  }
 
-      case doc::IMAGE_TILEMAP:
-        read_compressed_image_templ<doc::TilemapTraits>(f, delegate, image, header, chunk_end);
-        break;
+protected:
+  doc::ImageRef onDecode() override
+  {
+    doc::ImageRef image(doc::Image::create(pixelFormat(), width(), height()));
+    const MappedFileRef file = std::atomic_load(&m_file);
+    ASSERT(file); // Pinned images are not decoded again
+    try {
+      // We don't use the mapped memory because it's not safe to
+      // access it if the file was truncated by other program.
+      std::vector<uint8_t> data(m_size);
+      if (!file || !file->read(m_offset, m_size, data.data()))
+        throw base::Exception("Cannot read cel data");
+      inflate_image(data.data(), m_size, image.get());
+    }
+    catch (const std::exception&) {
+      // The file was already loaded successfully, so this shouldn't
+      // happen unless the file was modified by other program.
+      image->clear(0);
     }
+    return image;
   }
-  // OK, in case of error we can show the problem, but continue
-  // loading more cels.
-  catch (const std::exception& e) {
-    delegate->error(e.what());
+
+  doc::LazyImageRef onClone() const override
+  {
+    const MappedFileRef file = std::atomic_load(&m_file);
+    if (!file)
+      return nullptr;
+    return std::make_shared<AsepriteLazyImage>(file,
+                                               m_offset,
+                                               m_size,
+                                               pixelFormat(),
+                                               width(),
+                                               height(),
+                                               cache());
   }
-}
+
+  // The file is unmapped and closed when all its images are pinned
+  // (e.g. to overwrite it).
+  void onPinned() override { std::atomic_store(&m_file, MappedFileRef()); }
+
+private:
+  MappedFileRef m_file;
+  size_t m_offset;
+  size_t m_size;
+};
+
+// Reads the raw bytes of lazy properties from memory.
+class BufferFileInterface : public FileInterface {
+public:
+  BufferFileInterface(const std::vector<uint8_t>& data) : m_data(data) {}
+
+  bool ok() const override { return m_ok; }
+  size_t tell() override { return m_pos; }
+  void seek(size_t absPos) override { m_pos = absPos; }
+
+  uint8_t read8() override
+  {
+    if (m_pos < m_data.size())
+      return m_data[m_pos++];
+    m_ok = false;
+    return 0;
+  }
+
+  size_t readBytes(uint8_t* buf, size_t n) override
+  {
+    const size_t n2 = (m_pos < m_data.size() ? std::min(n, m_data.size() - m_pos) : 0);
+    std::copy(m_data.begin() + m_pos, m_data.begin() + m_pos + n2, buf);
+    m_pos += n2;
+    if (n2 != n)
+      m_ok = false;
+    return n2;
+  }
+
+  void write8(uint8_t value) override { ASSERT(false); }
+
+private:
+  const std::vector<uint8_t>& m_data;
+  size_t m_pos = 0;
+  bool m_ok = true;
+};
 
 } // anonymous namespace
 
+// Properties map that is decoded from its raw bytes (read from the
+// file) the first time it's accessed.
+class AsepriteDecoder::LazyProperties : public doc::UserData::LazyProperties {
+public:
+  LazyProperties(std::vector<uint8_t>&& data) : doc::UserData::LazyProperties(std::move(data)) {}
+
+  doc::UserData::Properties decode() const override
+  {
+    BufferFileInterface f(data());
+    AsepriteDecoder decoder;
+    decoder.initialize(nullptr, &f);
+    try {
+      return doc::get_value<doc::UserData::Properties>(
+        decoder.readPropertyValue(USER_DATA_PROPERTY_TYPE_PROPERTIES));
+    }
+    catch (const std::exception&) {
+      // The structure of the properties was validated when the file
+      // was loaded, so this shouldn't happen.
+      ASSERT(false);
+      return doc::UserData::Properties();
+    }
+  }
+};
+
+// Inflates the compressed images of cels and tilesets in background
+// tasks while the rest of the file is read. The "done" functions (to
+// finish the cels/tilesets with the decompressed pixels) are called
+// from the decoder thread in the same order the images were added.
+class AsepriteDecoder::ImagesInflater {
+public:
+  using DoneFunc = std::function<void()>;
+
+  void add(const doc::ImageRef& image, base::buffer&& data, DoneFunc&& done = nullptr)
+  {
+    auto item = std::make_unique<Item>();
+    item->image = image;
+    item->data = std::move(data);
+    item->done = std::move(done);
+
+    Item* ptr = item.get();
+    m_items.push_back(std::move(item));
+
+    m_tasks.run([ptr] {
+      try {
+        inflate_image(ptr->data.data(), ptr->data.size(), ptr->image.get());
+      }
+      catch (const std::exception& e) {
+        ptr->error = e.what();
+      }
+      base::buffer().swap(ptr->data);
+    });
+  }
+
+  // Waits all the images and calls their "done" functions.
+  void finish(DecodeDelegate* delegate)
+  {
+    m_tasks.wait();
+    for (auto& item : m_items) {
+      // OK, in case of error we can show the problem, but continue
+      // loading more cels.
+      if (!item->error.empty())
+        delegate->error(item->error);
+      if (item->done)
+        item->done();
+    }
+    m_items.clear();
+  }
+
+private:
+  struct Item {
+    doc::ImageRef image;
+    base::buffer data;
+    std::string error;
+    DoneFunc done;
+  };
+
+  std::vector<std::unique_ptr<Item>> m_items;
+  // Destroyed first, so it waits the tasks that use the items
+  doc::TaskGroup m_tasks;
+};
+
 //////////////////////////////////////////////////////////////////////
 // Cel Chunk
 //////////////////////////////////////////////////////////////////////
@@ -825,6 +1046,8 @@ doc::Cel* AsepriteDecoder::readCelChunk(doc::Sprite* sprite,
                                         const AsepriteHeader* header,
                                         const size_t chunk_end)
 {
+  const size_t chunk_data_pos = f()->tell();
+
   // Read chunk data
   doc::layer_t layer_index = read16();
   int x = ((int16_t)read16());
@@ -854,6 +1077,14 @@ doc::Cel* AsepriteDecoder::readCelChunk(doc::Sprite* sprite,
     return nullptr;
   }
 
+  // Skip cels of layers and frames that weren't requested
+  if (!decodeCelsInLayer(layer_index, layer))
+    return nullptr;
+  if (!m_readingSkippedCel && !decodeCelsInFrame(sprite, frame)) {
+    m_skippedCels[std::make_pair(layer_index, frame)] = std::make_pair(chunk_data_pos, chunk_end);
+    return nullptr;
+  }
+
   // Create the new frame.
   std::unique_ptr<doc::Cel> cel;
 
@@ -863,7 +1094,7 @@ doc::Cel* AsepriteDecoder::readCelChunk(doc::Sprite* sprite,
       int w = read16();
       int h = read16();
 
-      if (w > 0 && h > 0) {
+      if (w > 0 && h > 0 && !isOutsideDecodeBounds(gfx::Rect(x, y, w, h))) {
         // Read pixel data
         doc::ImageRef image(doc::Image::create(pixelFormat, w, h));
         read_raw_image(f(), delegate(), image.get(), header);
@@ -880,6 +1111,8 @@ doc::Cel* AsepriteDecoder::readCelChunk(doc::Sprite* sprite,
       // Read link position
       doc::frame_t link_frame = doc::frame_t(read16());
       doc::Cel* link = layer->cel(link_frame);
+      if (!link)
+        link = readSkippedCel(sprite, layer_index, link_frame, pixelFormat, header);
 
       if (link) {
         // There were a beta version that allow to the user specify
@@ -889,6 +1122,9 @@ doc::Cel* AsepriteDecoder::readCelChunk(doc::Sprite* sprite,
           cel.reset(doc::Cel::MakeLink(frame, link));
         }
         else {
+          // We need the pixels of the linked cel to make the copy
+          m_inflater->finish(delegate());
+
           cel.reset(doc::Cel::MakeCopy(frame, link));
           cel->setPosition(x, y);
           cel->setOpacity(opacity);
@@ -907,9 +1143,30 @@ doc::Cel* AsepriteDecoder::readCelChunk(doc::Sprite* sprite,
       int w = read16();
       int h = read16();
 
-      if (w > 0 && h > 0) {
+      // Skip cels outside the region to decode
+      if (isOutsideDecodeBounds(gfx::Rect(x, y, w, h)))
+        break;
+
+      const size_t pos = f()->tell();
+      if (w > 0 && h > 0 && m_lazyFile && pos < chunk_end && chunk_end <= m_lazyFile->size()) {
+        auto celData = std::make_shared<doc::CelData>(doc::ImageRef(nullptr));
+        celData->setLazyImage(std::make_shared<AsepriteLazyImage>(m_lazyFile,
+                                                                  pos,
+                                                                  chunk_end - pos,
+                                                                  pixelFormat,
+                                                                  w,
+                                                                  h,
+                                                                  m_lazyCache),
+                              layer);
+
+        cel = std::make_unique<doc::Cel>(frame, celData);
+        cel->setPosition(x, y);
+        cel->setOpacity(opacity);
+        cel->setZIndex(zIndex);
+      }
+      else if (w > 0 && h > 0) {
         doc::ImageRef image(doc::Image::create(pixelFormat, w, h));
-        read_compressed_image(f(), delegate(), image.get(), header, chunk_end);
+        m_inflater->add(image, read_compressed_data(f(), delegate(), header, chunk_end));
 
         cel = std::make_unique<doc::Cel>(frame, image);
         cel->setPosition(x, y);
@@ -940,51 +1197,71 @@ doc::Cel* AsepriteDecoder::readCelChunk(doc::Sprite* sprite,
         break;
       }
 
+      doc::Tileset* ts = static_cast<doc::LayerTilemap*>(layer)->tileset();
+
+      // Skip tilemaps outside the region to decode
+      if (ts) {
+        const gfx::Size tileSize = ts->grid().tileSize();
+        if (isOutsideDecodeBounds(gfx::Rect(x, y, w * tileSize.w, h * tileSize.h)))
+          break;
+      }
+
       if (w > 0 && h > 0) {
         doc::ImageRef image(doc::Image::create(doc::IMAGE_TILEMAP, w, h));
         image->setMaskColor(doc::notile);
         image->clear(doc::notile);
-        read_compressed_image(f(), delegate(), image.get(), header, chunk_end);
-
         // Check if the tileset of this tilemap has the
         // "ASE_TILESET_FLAG_ZERO_IS_NOTILE" we have to adjust all
         // tile references to the new format (where empty tile is
         // zero)
-        doc::Tileset* ts = static_cast<doc::LayerTilemap*>(layer)->tileset();
         doc::tileset_index tsi = static_cast<doc::LayerTilemap*>(layer)->tilesetIndex();
         ASSERT(tsi >= 0 && tsi < m_tilesetFlags.size());
-        if (tsi >= 0 && tsi < m_tilesetFlags.size() &&
-            (m_tilesetFlags[tsi] & ASE_TILESET_FLAG_ZERO_IS_NOTILE) == 0) {
-          doc::fix_old_tilemap(image.get(), ts, tileIDMask, flagsMask);
-        }
-
-        // Convert the tile index and masks to a proper in-memory
-        // representation for the doc-lib.
-        doc::transform_image<doc::TilemapTraits>(
-          image.get(),
-          [ts, tileIDMask, tileIDShift, xflipMask, yflipMask, dflipMask](doc::tile_t tile) {
-            // Get the tile index.
-            doc::tile_index ti = ((tile & tileIDMask) >> tileIDShift);
-
-            // If the index is out of bounds from the tileset, we
-            // allow to keep some small values in-memory, but if the
-            // index is too big, we consider it as a broken file and
-            // remove the tile (as an huge index bring some lag
-            // problems in the remove_unused_tiles_from_tileset()
-            // creating a big Remap structure).
-            //
-            // Related to https://github.com/aseprite/aseprite/issues/2877
-            if (ti > ts->size() && ti > 0xffffff) {
-              return doc::notile;
-            }
-
-            // Convert read index to doc::tile_i_mask, and flags to doc::tile_f_mask
-            tile = doc::tile(ti,
-                             ((tile & xflipMask) == xflipMask ? doc::tile_f_xflip : 0) |
-                               ((tile & yflipMask) == yflipMask ? doc::tile_f_yflip : 0) |
-                               ((tile & dflipMask) == dflipMask ? doc::tile_f_dflip : 0));
-
-            return tile;
+        const bool fixOldTilemap = (tsi >= 0 && tsi < m_tilesetFlags.size() &&
+                                    (m_tilesetFlags[tsi] & ASE_TILESET_FLAG_ZERO_IS_NOTILE) == 0);
+
+        m_inflater->add(
+          image,
+          read_compressed_data(f(), delegate(), header, chunk_end),
+          [image = image.get(),
+           ts,
+           fixOldTilemap,
+           tileIDMask,
+           tileIDShift,
+           xflipMask,
+           yflipMask,
+           dflipMask,
+           flagsMask] {
+            if (fixOldTilemap)
+              doc::fix_old_tilemap(image, ts, tileIDMask, flagsMask);
+
+            // Convert the tile index and masks to a proper in-memory
+            // representation for the doc-lib.
+            doc::transform_image<doc::TilemapTraits>(
+              image,
+              [ts, tileIDMask, tileIDShift, xflipMask, yflipMask, dflipMask](doc::tile_t tile) {
+                // Get the tile index.
+                doc::tile_index ti = ((tile & tileIDMask) >> tileIDShift);
+
+                // If the index is out of bounds from the tileset, we
+                // allow to keep some small values in-memory, but if the
+                // index is too big, we consider it as a broken file and
+                // remove the tile (as an huge index bring some lag
+                // problems in the remove_unused_tiles_from_tileset()
+                // creating a big Remap structure).
+                //
+                // Related to https://github.com/aseprite/aseprite/issues/2877
+                if (ti > ts->size() && ti > 0xffffff) {
+                  return doc::notile;
+                }
+
+                // Convert read index to doc::tile_i_mask, and flags to doc::tile_f_mask
+                tile = doc::tile(ti,
+                                 ((tile & xflipMask) == xflipMask ? doc::tile_f_xflip : 0) |
+                                   ((tile & yflipMask) == yflipMask ? doc::tile_f_yflip : 0) |
+                                   ((tile & dflipMask) == dflipMask ? doc::tile_f_dflip : 0));
+
+                return tile;
+              });
           });
 
         cel = std::make_unique<doc::Cel>(frame, image);
@@ -1007,6 +1284,60 @@ doc::Cel* AsepriteDecoder::readCelChunk(doc::Sprite* sprite,
   return cel.release();
 }
 
+bool AsepriteDecoder::isOutsideDecodeBounds(const gfx::Rect& celBounds) const
+{
+  return (!m_decodeBounds.isEmpty() && !m_decodeBounds.intersects(celBounds));
+}
+
+bool AsepriteDecoder::decodeCelsInLayer(const doc::layer_t layerIndex, const doc::Layer* layer)
+{
+  if (layerIndex >= doc::layer_t(m_decodeLayerCels.size()))
+    m_decodeLayerCels.resize(layerIndex + 1, -1);
+
+  int8_t& decode = m_decodeLayerCels[layerIndex];
+  if (decode < 0)
+    decode = (delegate()->decodeCelsInLayer(layer) ? 1 : 0);
+  return (decode == 1);
+}
+
+bool AsepriteDecoder::decodeCelsInFrame(const doc::Sprite* sprite, const doc::frame_t frame)
+{
+  if (m_decodeCelsFrame != frame) {
+    m_decodeCelsFrame = frame;
+    m_decodeFrameCels = delegate()->decodeCelsInFrame(sprite, frame);
+  }
+  return m_decodeFrameCels;
+}
+
+// Decodes a cel that was skipped (because its frame wasn't requested)
+// when a requested cel is a link to it. The cel is added in its
+// original frame, so other links to it can use it too.
+doc::Cel* AsepriteDecoder::readSkippedCel(doc::Sprite* sprite,
+                                          const doc::layer_t layerIndex,
+                                          const doc::frame_t frame,
+                                          const doc::PixelFormat pixelFormat,
+                                          const AsepriteHeader* header)
+{
+  auto it = m_skippedCels.find(std::make_pair(layerIndex, frame));
+  if (it == m_skippedCels.end())
+    return nullptr;
+
+  const size_t pos = it->second.first;
+  const size_t chunkEnd = it->second.second;
+  m_skippedCels.erase(it);
+
+  const size_t oldPos = f()->tell();
+  const bool oldReadingSkippedCel = m_readingSkippedCel;
+  m_readingSkippedCel = true;
+  f()->seek(pos);
+
+  doc::Cel* cel = readCelChunk(sprite, frame, pixelFormat, header, chunkEnd);
+
+  m_readingSkippedCel = oldReadingSkippedCel;
+  f()->seek(oldPos);
+  return cel;
+}
+
 void AsepriteDecoder::readCelExtraChunk(doc::Cel* cel)
 {
   // Read chunk data
@@ -1170,7 +1501,7 @@ void AsepriteDecoder::readUserDataChunk(doc::UserData* userData,
   }
 
   if (flags & ASE_USER_DATA_FLAG_HAS_PROPERTIES) {
-    readPropertiesMaps(userData->propertiesMaps(), extFiles);
+    readPropertiesMaps(userData, extFiles);
   }
 }
 
@@ -1274,30 +1605,44 @@ doc::Tileset* AsepriteDecoder::readTilesetChunk(doc::Sprite* sprite,
       const size_t dataBeg = f()->tell();
       const size_t dataEnd = dataBeg + dataSize;
 
-      base::buffer compressed;
-      if (delegate()->cacheCompressedTilesets() && dataSize > 0) {
-        compressed.resize(dataSize);
-        f()->readBytes(&compressed[0], dataSize);
-        f()->seek(dataBeg);
-      }
-
       doc::ImageRef alltiles(doc::Image::create(sprite->pixelFormat(), w, h * ntiles));
       alltiles->setMaskColor(sprite->transparentColor());
 
-      read_compressed_image(f(), delegate(), alltiles.get(), header, dataEnd);
+      base::buffer data = read_compressed_data(f(), delegate(), header, dataEnd);
       f()->seek(dataEnd);
 
-      for (doc::tile_index i = 0; i < ntiles; ++i) {
-        doc::ImageRef tile(doc::crop_image(alltiles.get(), 0, i * h, w, h, alltiles->maskColor()));
-        tileset->set(i, tile);
-      }
-
-      // If we are reading and old .aseprite file (where empty tile is not the zero]
+      base::buffer compressed;
+      if (delegate()->cacheCompressedTilesets() && dataSize > 0 && data.size() == dataSize)
+        compressed = data;
+
+      m_inflater->add(alltiles,
+                      std::move(data),
+                      [tileset,
+                       alltiles = alltiles.get(),
+                       w,
+                       h,
+                       ntiles,
+                       flags,
+                       compressed = std::move(compressed)] {
+                        for (doc::tile_index i = 0; i < ntiles; ++i) {
+                          doc::ImageRef tile(
+                            doc::crop_image(alltiles, 0, i * h, w, h, alltiles->maskColor()));
+                          tileset->set(i, tile);
+                        }
+
+                        // If we are reading and old .aseprite file (where empty tile is not the zero]
+                        if ((flags & ASE_TILESET_FLAG_ZERO_IS_NOTILE) == 0)
+                          doc::fix_old_tileset(tileset);
+
+                        if (!compressed.empty())
+                          tileset->setCompressedData(compressed);
+                      });
+
+      // Old tilesets change their number of tiles and base index
+      // (which are used by the following chunks), so we cannot
+      // defer them.
       if ((flags & ASE_TILESET_FLAG_ZERO_IS_NOTILE) == 0)
-        doc::fix_old_tileset(tileset);
-
-      if (!compressed.empty())
-        tileset->setCompressedData(compressed);
+        m_inflater->finish(delegate());
     }
     sprite->tilesets()->set(id, tileset);
   }
@@ -1313,7 +1658,33 @@ doc::Tileset* AsepriteDecoder::readTilesetChunk(doc::Sprite* sprite,
   return tileset;
 }
 
-void AsepriteDecoder::readPropertiesMaps(doc::UserData::PropertiesMaps& propertiesMaps,
+doc::ImageRef AsepriteDecoder::readPreviewChunk(const AsepriteHeader* header,
+                                               const size_t chunk_end)
+{
+  const int w = read16();
+  const int h = read16();
+  readPadding(8);
+
+  if (w < 1 || h < 1) {
+    delegate()->incompatibilityError(fmt::format("Invalid preview size {0}x{1}", w, h));
+    return nullptr;
+  }
+
+  doc::ImageRef image(doc::Image::create(doc::IMAGE_RGB, w, h));
+  image->clear(0);
+
+  base::buffer data = read_compressed_data(f(), delegate(), header, chunk_end);
+  try {
+    inflate_image(data.data(), data.size(), image.get());
+  }
+  catch (const base::Exception& e) {
+    delegate()->incompatibilityError(fmt::format("Error reading preview: {0}", e.what()));
+    return nullptr;
+  }
+  return image;
+}
+
+void AsepriteDecoder::readPropertiesMaps(doc::UserData* userData,
                                          const AsepriteExternalFiles& extFiles)
 {
   auto startPos = f()->tell();
@@ -1329,8 +1700,12 @@ void AsepriteDecoder::readPropertiesMaps(doc::UserData::PropertiesMaps& properti
         extensionId = fmt::format("__missed__{}", id);
         delegate()->error(fmt::format("Error: Invalid extension ID (id={0} not found)", id));
       }
-      auto properties = readPropertyValue(USER_DATA_PROPERTY_TYPE_PROPERTIES);
-      propertiesMaps[extensionId] = doc::get_value<doc::UserData::Properties>(properties);
+      // Properties are decoded when they are accessed for the first
+      // time, here we just validate and keep their raw bytes
+      if (auto properties = readLazyProperties(startPos + size))
+        userData->setLazyProperties(extensionId, properties);
+      else
+        userData->properties(extensionId);
     }
   }
   catch (const base::Exception& e) {
@@ -1452,6 +1827,77 @@ const doc::UserData::Variant AsepriteDecoder::readPropertyValue(uint16_t type)
   return doc::UserData::Variant{};
 }
 
+doc::UserData::LazyPropertiesRef AsepriteDecoder::readLazyProperties(const size_t maxPos)
+{
+  const size_t startPos = f()->tell();
+  const uint32_t numProps = read32();
+  if (numProps == 0)
+    return nullptr;
+
+  f()->seek(startPos);
+  skipPropertyValue(USER_DATA_PROPERTY_TYPE_PROPERTIES);
+  const size_t endPos = f()->tell();
+  if (!f()->ok() || endPos <= startPos || endPos > maxPos)
+    throw base::Exception("Unexpected end of file reading properties");
+
+  std::vector<uint8_t> data(endPos - startPos);
+  f()->seek(startPos);
+  if (readBytes(data.data(), data.size()) != data.size())
+    throw base::Exception("Unexpected end of file reading properties");
+
+  return std::make_shared<LazyProperties>(std::move(data));
+}
+
+void AsepriteDecoder::skipPropertyValue(uint16_t type)
+{
+  auto skipBytes = [this](const size_t n) { f()->seek(f()->tell() + n); };
+
+  switch (type) {
+    case USER_DATA_PROPERTY_TYPE_NULLPTR: ASSERT(false); break;
+    case USER_DATA_PROPERTY_TYPE_BOOL:
+    case USER_DATA_PROPERTY_TYPE_INT8:
+    case USER_DATA_PROPERTY_TYPE_UINT8:   skipBytes(1); break;
+    case USER_DATA_PROPERTY_TYPE_INT16:
+    case USER_DATA_PROPERTY_TYPE_UINT16:  skipBytes(2); break;
+    case USER_DATA_PROPERTY_TYPE_INT32:
+    case USER_DATA_PROPERTY_TYPE_UINT32:
+    case USER_DATA_PROPERTY_TYPE_FIXED:
+    case USER_DATA_PROPERTY_TYPE_FLOAT:   skipBytes(4); break;
+    case USER_DATA_PROPERTY_TYPE_INT64:
+    case USER_DATA_PROPERTY_TYPE_UINT64:
+    case USER_DATA_PROPERTY_TYPE_DOUBLE:
+    case USER_DATA_PROPERTY_TYPE_POINT:
+    case USER_DATA_PROPERTY_TYPE_SIZE:    skipBytes(8); break;
+    case USER_DATA_PROPERTY_TYPE_RECT:
+    case USER_DATA_PROPERTY_TYPE_UUID:    skipBytes(16); break;
+    case USER_DATA_PROPERTY_TYPE_STRING:  skipBytes(read16()); break;
+    case USER_DATA_PROPERTY_TYPE_VECTOR:  {
+      auto numElems = read32();
+      auto elemsType = read16();
+      auto elemType = elemsType;
+      for (int k = 0; k < numElems && f()->ok(); ++k) {
+        if (elemsType == 0) {
+          elemType = read16();
+        }
+        skipPropertyValue(elemType);
+      }
+      break;
+    }
+    case USER_DATA_PROPERTY_TYPE_PROPERTIES: {
+      auto numProps = read32();
+      for (int j = 0; j < numProps && f()->ok(); ++j) {
+        skipBytes(read16()); // Name
+        skipPropertyValue(read16());
+      }
+      break;
+    }
+    default: {
+      throw base::Exception(
+        fmt::format("Unexpected property type '{0}' at file position {1}", type, f()->tell()));
+    }
+  }
+}
+
 void AsepriteDecoder::readTilesData(doc::Tileset* tileset, const AsepriteExternalFiles& extFiles)
 {
   // Read as many user data chunks as tiles are in the tileset
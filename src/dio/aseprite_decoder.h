@@ -1,5 +1,5 @@
 // Aseprite Document IO Library
-// Copyright (c) 2018-2025 Igara Studio S.A.
+// Copyright (c) 2018-2026 Igara Studio S.A.
 // Copyright (c) 2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -12,15 +12,23 @@
 #include "base/uuid.h"
 #include "dio/aseprite_common.h"
 #include "dio/decoder.h"
+#include "dio/mapped_file.h"
 #include "doc/frame.h"
+#include "doc/image_ref.h"
 #include "doc/layer_list.h"
+#include "doc/lazy_image.h"
 #include "doc/pixel_format.h"
 #include "doc/slices.h"
 #include "doc/tags.h"
 #include "doc/tileset.h"
 #include "doc/user_data.h"
+#include "gfx/rect.h"
 
+#include <cstdint>
+#include <map>
+#include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace doc {
@@ -41,10 +49,16 @@ class AsepriteExternalFiles;
 
 class AsepriteDecoder : public Decoder {
 public:
+  AsepriteDecoder();
+  ~AsepriteDecoder();
+
   bool decode() override;
   int celType() const { return m_celType; }
 
 private:
+  class ImagesInflater;
+  class LazyProperties;
+
   bool readHeader(AsepriteHeader* header);
   void readFrameHeader(AsepriteFrameHeader* frame_header);
   void readPadding(const int bytes);
@@ -63,6 +77,14 @@ private:
                          doc::PixelFormat pixelFormat,
                          const AsepriteHeader* header,
                          const size_t chunk_end);
+  bool isOutsideDecodeBounds(const gfx::Rect& celBounds) const;
+  bool decodeCelsInLayer(doc::layer_t layerIndex, const doc::Layer* layer);
+  bool decodeCelsInFrame(const doc::Sprite* sprite, doc::frame_t frame);
+  doc::Cel* readSkippedCel(doc::Sprite* sprite,
+                           doc::layer_t layerIndex,
+                           doc::frame_t frame,
+                           doc::PixelFormat pixelFormat,
+                           const AsepriteHeader* header);
   void readCelExtraChunk(doc::Cel* cel);
   void readColorProfile(doc::Sprite* sprite);
   void readExternalFiles(AsepriteExternalFiles& extFiles);
@@ -74,15 +96,41 @@ private:
   doc::Tileset* readTilesetChunk(doc::Sprite* sprite,
                                  const AsepriteHeader* header,
                                  const AsepriteExternalFiles& extFiles);
-  void readPropertiesMaps(doc::UserData::PropertiesMaps& propertiesMaps,
-                          const AsepriteExternalFiles& extFiles);
+  doc::ImageRef readPreviewChunk(const AsepriteHeader* header, size_t chunk_end);
+  void readPropertiesMaps(doc::UserData* userData, const AsepriteExternalFiles& extFiles);
   const doc::UserData::Variant readPropertyValue(uint16_t type);
+  doc::UserData::LazyPropertiesRef readLazyProperties(size_t maxPos);
+  void skipPropertyValue(uint16_t type);
   void readTilesData(doc::Tileset* tileset, const AsepriteExternalFiles& extFiles);
   base::Uuid readUuid();
 
   doc::LayerList m_allLayers;
   std::vector<uint32_t> m_tilesetFlags;
   int m_celType = ASE_FILE_COMPRESSED_CEL;
+
+  // Cels outside these bounds aren't loaded (empty = whole canvas).
+  gfx::Rect m_decodeBounds;
+
+  // Cached results of DecodeDelegate::decodeCelsInLayer() for each
+  // layer index (-1 if it's unknown) and decodeCelsInFrame() for the
+  // last frame.
+  std::vector<int8_t> m_decodeLayerCels;
+  doc::frame_t m_decodeCelsFrame = -1;
+  bool m_decodeFrameCels = true;
+
+  // Cel chunks (data start and chunk end) that were skipped because
+  // their frames weren't requested, by layer index and frame. A
+  // requested cel can be a link to one of these cels.
+  std::map<std::pair<doc::layer_t, doc::frame_t>, std::pair<size_t, size_t>> m_skippedCels;
+  bool m_readingSkippedCel = false;
+
+  // Compressed images of cels/tilesets are inflated in parallel
+  // while the rest of the file is read.
+  std::unique_ptr<ImagesInflater> m_inflater;
+
+  // File used to decode compressed cels lazily.
+  MappedFileRef m_lazyFile;
+  doc::LazyImagesCacheRef m_lazyCache;
 };
 
 } // namespace dio
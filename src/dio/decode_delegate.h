@@ -1,5 +1,5 @@
 // Aseprite Document IO Library
-// Copyright (c) 2023 Igara Studio S.A.
+// Copyright (c) 2023-2026 Igara Studio S.A.
 // Copyright (c) 2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -9,10 +9,14 @@
 #define DIO_DECODE_DELEGATE_H_INCLUDED
 #pragma once
 
+#include "dio/mapped_file.h"
 #include "doc/color.h"
 #include "doc/frame.h"
+#include "doc/image_ref.h"
 #include "doc/sprite.h"
+#include "gfx/rect.h"
 
+#include <cstddef>
 #include <string>
 
 namespace dio {
@@ -38,6 +42,33 @@ public:
   // to generate a thumbnail)
   virtual bool decodeOneFrame() { return false; }
 
+  // Return the last frame that must be read, frames after it are not
+  // decoded (e.g. to load only the frames of a specific range), or
+  // -1 to read all frames.
+  virtual doc::frame_t decodeLastFrame() { return -1; }
+
+  // Return the region of the canvas that must be decoded, cels that
+  // are completely outside this region are not loaded at all. An
+  // empty rectangle means the whole canvas.
+  virtual gfx::Rect decodeBounds() { return gfx::Rect(); }
+
+  // Return false to skip the cels of the given layer or frame (e.g.
+  // to load only the layers/frames that will be exported). These
+  // are called when cel chunks are read, so all layers and tags of
+  // the sprite are already available.
+  virtual bool decodeCelsInLayer(const doc::Layer* layer) { return true; }
+  virtual bool decodeCelsInFrame(const doc::Sprite* sprite, doc::frame_t frame) { return true; }
+
+  // Return true to read only the embedded preview of the file (e.g.
+  // to generate a thumbnail). If the file has a preview, onPreview()
+  // is called instead of onSprite() and the rest of the file is not
+  // decoded.
+  virtual bool decodePreview() { return false; }
+
+  // Called with the embedded RGB preview image (a precomposited and
+  // downscaled version of the first frame).
+  virtual void onPreview(const doc::ImageRef& image) {}
+
   // Default color for slices without user data
   virtual doc::color_t defaultSliceColor() { return doc::rgba(0, 0, 255, 255); }
 
@@ -53,6 +84,14 @@ public:
   // tilesets exactly as they are in the disk (so we can save it
   // without re-compressing).
   virtual bool cacheCompressedTilesets() const { return false; }
+
+  // Returns the same file that is being decoded mapped in memory to
+  // decode compressed cels lazily (when they are used), or nullptr
+  // to decode all cels when the file is loaded.
+  virtual MappedFileRef lazyImagesFile() { return nullptr; }
+
+  // Maximum number of bytes used by decoded lazy images.
+  virtual std::size_t lazyImagesCacheSize() const { return 0; }
 };
 
 } // namespace dio
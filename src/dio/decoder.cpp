@@ -1,5 +1,5 @@
 // Aseprite Document IO Library
-// Copyright (c) 2018 Igara Studio S.A.
+// Copyright (c) 2018-2026 Igara Studio S.A.
 // Copyright (c) 2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -8,11 +8,12 @@
 #include "dio/decoder.h"
 
 #include "dio/file_interface.h"
+#include "dio/mapped_file.h"
 #include "doc/document.h"
 
 namespace dio {
 
-Decoder::Decoder() : m_delegate(nullptr), m_f(nullptr)
+Decoder::Decoder() : m_delegate(nullptr), m_f(nullptr), m_mapped(nullptr)
 {
 }
 
@@ -24,15 +25,21 @@ void Decoder::initialize(DecodeDelegate* delegate, FileInterface* f)
 {
   m_delegate = delegate;
   m_f = f;
+  m_mapped = dynamic_cast<MappedFileInterface*>(f);
 }
 
 uint8_t Decoder::read8()
 {
+  if (m_mapped)
+    return m_mapped->read8();
   return m_f->read8();
 }
 
 uint16_t Decoder::read16()
 {
+  if (m_mapped)
+    return m_mapped->readLE<uint16_t>();
+
   int b1 = m_f->read8();
   int b2 = m_f->read8();
 
@@ -45,6 +52,9 @@ uint16_t Decoder::read16()
 
 uint32_t Decoder::read32()
 {
+  if (m_mapped)
+    return m_mapped->readLE<uint32_t>();
+
   int b1 = m_f->read8();
   int b2 = m_f->read8();
   int b3 = m_f->read8();
@@ -60,6 +70,9 @@ uint32_t Decoder::read32()
 
 uint64_t Decoder::read64()
 {
+  if (m_mapped)
+    return m_mapped->readLE<uint64_t>();
+
   int b1 = m_f->read8();
   int b2 = m_f->read8();
   int b3 = m_f->read8();
@@ -81,6 +94,8 @@ uint64_t Decoder::read64()
 
 size_t Decoder::readBytes(uint8_t* buf, size_t n)
 {
+  if (m_mapped)
+    return m_mapped->readBytes(buf, n);
   return m_f->readBytes(buf, n);
 }
 
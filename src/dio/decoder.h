@@ -1,5 +1,5 @@
 // Aseprite Document IO Library
-// Copyright (c) 2018 Igara Studio S.A.
+// Copyright (c) 2018-2026 Igara Studio S.A.
 // Copyright (c) 2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -20,6 +20,7 @@ namespace dio {
 
 class DecodeDelegate;
 class FileInterface;
+class MappedFileInterface;
 
 class Decoder {
 public:
@@ -41,6 +42,8 @@ protected:
 private:
   DecodeDelegate* m_delegate;
   FileInterface* m_f;
+  // Same as m_f if it's a MappedFileInterface (to avoid virtual calls)
+  MappedFileInterface* m_mapped;
 };
 
 } // namespace dio
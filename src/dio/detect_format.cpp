@@ -1,5 +1,5 @@
 // Aseprite Document IO Library
-// Copyright (c) 2021-2023 Igara Studio S.A.
+// Copyright (c) 2021-2026 Igara Studio S.A.
 // Copyright (c) 2016-2018 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -10,9 +10,13 @@
 #include "base/file_handle.h"
 #include "base/fs.h"
 #include "base/string.h"
+#include "base/time.h"
 #include "flic/flic_details.h"
 
 #include <cstring>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 
 #define ASE_MAGIC_NUMBER 0xA5E0
 #define BMP_MAGIC_NUMBER 0x4D42 // "BM"
@@ -28,6 +32,30 @@
 
 namespace dio {
 
+namespace {
+
+// Formats detected by file content, by file path. The file selector
+// and the thumbnail generator can ask for the format of the same
+// files several times, so we avoid opening and reading them again if
+// their size/modification time didn't change.
+struct DetectedFormat {
+  size_t size;
+  base::Time time;
+  FileFormat format;
+};
+
+const size_t kMaxDetectedFormats = 4096;
+std::mutex g_detectedMutex;
+std::unordered_map<std::string, DetectedFormat> g_detectedFormats;
+
+bool is_same_time(const base::Time& a, const base::Time& b)
+{
+  return (a.year == b.year && a.month == b.month && a.day == b.day && a.hour == b.hour &&
+          a.minute == b.minute && a.second == b.second);
+}
+
+} // anonymous namespace
+
 FileFormat detect_format(const std::string& filename)
 {
   FileFormat ff = detect_format_by_file_content(filename);
@@ -88,6 +116,17 @@ FileFormat detect_format_by_file_content_bytes(const uint8_t* buf, const int n)
 
 FileFormat detect_format_by_file_content(const std::string& filename)
 {
+  const size_t size = base::file_size(filename);
+  const base::Time time = base::get_modification_time(filename);
+  {
+    const std::lock_guard lock(g_detectedMutex);
+    auto it = g_detectedFormats.find(filename);
+    if (it != g_detectedFormats.end() && it->second.size == size &&
+        is_same_time(it->second.time, time)) {
+      return it->second.format;
+    }
+  }
+
   base::FileHandle handle(base::open_file(filename.c_str(), "rb"));
   if (!handle)
     return FileFormat::ERROR;
@@ -96,7 +135,14 @@ FileFormat detect_format_by_file_content(const std::string& filename)
   uint8_t buf[12];
   int n = (int)fread(buf, 1, 12, f);
 
-  return detect_format_by_file_content_bytes(buf, n);
+  const FileFormat format = detect_format_by_file_content_bytes(buf, n);
+  {
+    const std::lock_guard lock(g_detectedMutex);
+    if (g_detectedFormats.size() >= kMaxDetectedFormats)
+      g_detectedFormats.clear();
+    g_detectedFormats[filename] = DetectedFormat{ size, time, format };
+  }
+  return format;
 }
 
 FileFormat detect_format_by_file_extension(const std::string& filename)
@@ -0,0 +1,152 @@
+// Aseprite Document IO Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "dio/mapped_file.h"
+
+#include "base/exception.h"
+
+#ifdef _WIN32
+  #include "base/string.h"
+
+  #include <windows.h>
+#else
+  #include <cerrno>
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+namespace dio {
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& filename) : m_filename(filename)
+{
+  // Other programs (or we) can overwrite, rename, or delete the file
+  // while it's opened. Anyway the file cannot be truncated while the
+  // mapping exists.
+  HANDLE file = CreateFileW(base::from_utf8(filename).c_str(),
+                            GENERIC_READ,
+                            FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                            nullptr,
+                            OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL,
+                            nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    throw base::Exception("Cannot open file %s", filename.c_str());
+
+  LARGE_INTEGER size;
+  if (GetFileType(file) != FILE_TYPE_DISK || !GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    CloseHandle(file);
+    throw base::Exception("Cannot map empty or non-regular file %s", filename.c_str());
+  }
+
+  HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    CloseHandle(file);
+    throw base::Exception("Cannot map file %s", filename.c_str());
+  }
+
+  void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (!data) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    throw base::Exception("Cannot map file %s", filename.c_str());
+  }
+
+  m_file = file;
+  m_mapping = mapping;
+  m_data = (const uint8_t*)data;
+  m_size = std::size_t(size.QuadPart);
+}
+
+MappedFile::~MappedFile()
+{
+  UnmapViewOfFile(m_data);
+  CloseHandle((HANDLE)m_mapping);
+  CloseHandle((HANDLE)m_file);
+}
+
+bool MappedFile::read(const std::size_t offset, const std::size_t size, uint8_t* buf) const
+{
+  if (offset > m_size || size > m_size - offset)
+    return false;
+
+  std::size_t done = 0;
+  while (done < size) {
+    OVERLAPPED overlapped = {};
+    const uint64_t pos = uint64_t(offset + done);
+    overlapped.Offset = DWORD(pos & 0xffffffff);
+    overlapped.OffsetHigh = DWORD(pos >> 32);
+
+    const DWORD n = DWORD(std::min<std::size_t>(size - done, 0x40000000));
+    DWORD read = 0;
+    if (!ReadFile((HANDLE)m_file, buf + done, n, &read, &overlapped) || read == 0)
+      return false;
+    done += read;
+  }
+  return true;
+}
+
+#else
+
+MappedFile::MappedFile(const std::string& filename) : m_filename(filename)
+{
+  const int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw base::Exception("Cannot open file %s", filename.c_str());
+
+  struct stat sb;
+  if (fstat(fd, &sb) != 0 || !S_ISREG(sb.st_mode) || sb.st_size == 0) {
+    close(fd);
+    throw base::Exception("Cannot map empty or non-regular file %s", filename.c_str());
+  }
+
+  void* data = mmap(nullptr, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    close(fd);
+    throw base::Exception("Cannot map file %s", filename.c_str());
+  }
+
+  // The file descriptor is kept for read(), pread() returns an error
+  // if the file was truncated instead of raising SIGBUS as the
+  // mapped memory does.
+  m_fd = fd;
+  m_data = (const uint8_t*)data;
+  m_size = std::size_t(sb.st_size);
+}
+
+MappedFile::~MappedFile()
+{
+  munmap((void*)m_data, m_size);
+  close(m_fd);
+}
+
+bool MappedFile::read(const std::size_t offset, const std::size_t size, uint8_t* buf) const
+{
+  if (offset > m_size || size > m_size - offset)
+    return false;
+
+  std::size_t done = 0;
+  while (done < size) {
+    const ssize_t n = pread(m_fd, buf + done, size - done, off_t(offset + done));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    done += std::size_t(n);
+  }
+  return true;
+}
+
+#endif
+
+} // namespace dio
@@ -0,0 +1,127 @@
+// Aseprite Document IO Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef DIO_MAPPED_FILE_H_INCLUDED
+#define DIO_MAPPED_FILE_H_INCLUDED
+#pragma once
+
+#include "base/disable_copying.h"
+#include "dio/file_interface.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+
+namespace dio {
+
+// A whole file mapped in memory for reading. The mapped memory is
+// used only while the file is being loaded, other program could
+// truncate the file later (and accessing the memory would crash), so
+// read() must be used after that.
+class MappedFile {
+public:
+  // Throws a base::Exception if the file cannot be mapped (e.g. it
+  // is empty or it is not a regular file).
+  MappedFile(const std::string& filename);
+  ~MappedFile();
+
+  const std::string& filename() const { return m_filename; }
+  const uint8_t* data() const { return m_data; }
+  std::size_t size() const { return m_size; }
+
+  // Copies bytes from the file to the given buffer. Returns false if
+  // the bytes cannot be read (e.g. the file was truncated). It can
+  // be called from any thread.
+  bool read(std::size_t offset, std::size_t size, uint8_t* buf) const;
+
+private:
+  std::string m_filename;
+  const uint8_t* m_data = nullptr;
+  std::size_t m_size = 0;
+#ifdef _WIN32
+  void* m_file = nullptr;
+  void* m_mapping = nullptr;
+#else
+  int m_fd = -1;
+#endif
+
+  DISABLE_COPYING(MappedFile);
+};
+
+using MappedFileRef = std::shared_ptr<MappedFile>;
+
+// Reads a memory-mapped file. All functions are inlined and don't
+// need locks (as stdio functions do), so it's faster to decode files
+// with a lot of small fields/chunks. Decoder uses these functions
+// directly (without virtual calls) when it receives an instance of
+// this class.
+class MappedFileInterface final : public FileInterface {
+public:
+  MappedFileInterface(const MappedFileRef& file)
+    : m_file(file)
+    , m_data(file->data())
+    , m_size(file->size())
+  {
+  }
+
+  const MappedFileRef& file() const { return m_file; }
+
+  bool ok() const override { return m_ok; }
+  size_t tell() override { return m_pos; }
+  void seek(size_t absPos) override { m_pos = absPos; }
+
+  uint8_t read8() override
+  {
+    if (m_pos < m_size)
+      return m_data[m_pos++];
+    m_ok = false;
+    return 0;
+  }
+
+  size_t readBytes(uint8_t* buf, size_t n) override
+  {
+    const size_t n2 = (m_pos < m_size ? std::min(n, m_size - m_pos) : 0);
+    std::memcpy(buf, m_data + m_pos, n2);
+    m_pos += n2;
+    if (n2 != n)
+      m_ok = false;
+    return n2;
+  }
+
+  // Reads a little endian integer of N bytes, returns 0 if there are
+  // not enough bytes.
+  template<typename T, size_t N = sizeof(T)>
+  T readLE()
+  {
+    if (m_pos >= m_size || m_size - m_pos < N) {
+      m_pos = m_size;
+      m_ok = false;
+      return 0;
+    }
+    T value = 0;
+    for (size_t i = 0; i < N; ++i)
+      value |= T(m_data[m_pos + i]) << (8 * i);
+    m_pos += N;
+    return value;
+  }
+
+  // The mapped file is read-only
+  void write8(uint8_t value) override {}
+
+private:
+  MappedFileRef m_file;
+  const uint8_t* m_data;
+  size_t m_size;
+  size_t m_pos = 0;
+  bool m_ok = true;
+};
+
+} // namespace dio
+
+#endif
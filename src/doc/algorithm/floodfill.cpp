@@ -1,56 +1,79 @@
-// The floodfill routine.
-// By Shawn Hargreaves.
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+// Copyright (c) 2001-2017 David Capello
 //
-// Changes by David Capello:
-// - Adapted to Aseprite
-// - Added non-contiguous mode
-// - Added mask parameter
+// The first version of this file was based on the floodfill routine
+// by Shawn Hargreaves.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
-//
-// TODO rewrite this algorithm from scratch
 
 #ifdef HAVE_CONFIG_H
   #include "config.h"
 #endif
 
+#include "doc/algorithm/floodfill.h"
+
 #include "base/base.h"
-#include "doc/algo.h"
 #include "doc/image.h"
 #include "doc/mask.h"
 #include "doc/primitives.h"
 #include "doc/primitives_fast.h"
+#include "doc/task_group.h"
+#include "tracing/tracing.h"
 
-#include <climits>
-#include <cmath>
-#include <limits>
+#include <algorithm>
+#include <cstdint>
 #include <vector>
 
+#if defined(__x86_64__) || defined(_WIN64)
+  #include <emmintrin.h>
+  #define DOC_USE_SSE2_FLOODFILL 1
+#else
+  #define DOC_USE_SSE2_FLOODFILL 0
+#endif
+
+#ifdef _MSC_VER
+  #include <intrin.h>
+#endif
+
 namespace doc { namespace algorithm {
 
-struct FLOODED_LINE { // store segments which have been flooded
-  char flags;         // status of the segment
-  int lpos, rpos;     // left and right ends of segment
-  int y;              // y coordinate of the segment
-  int next;           // linked list if several per line
-};
+namespace {
 
-static std::vector<FLOODED_LINE> flood_buf;
-static int flood_count; /* number of flooded segments */
+// Minimum number of pixels inside the bounds to compare the rows
+// from several threads when the parallel mode is requested.
+constexpr int kParallelMinArea = 256 * 256;
 
-#define FLOOD_IN_USE     1
-#define FLOOD_TODO_ABOVE 2
-#define FLOOD_TODO_BELOW 4
+// Index of the lowest/highest bit set in v (v cannot be zero).
+inline int first_bit(const uint32_t v)
+{
+#ifdef _MSC_VER
+  unsigned long i;
+  _BitScanForward(&i, v);
+  return int(i);
+#else
+  return __builtin_ctz(v);
+#endif
+}
 
-#define FLOOD_LINE(c)    (&flood_buf[c])
+inline int last_bit(const uint32_t v)
+{
+#ifdef _MSC_VER
+  unsigned long i;
+  _BitScanReverse(&i, v);
+  return int(i);
+#else
+  return 31 - __builtin_clz(v);
+#endif
+}
 
-static inline bool color_equal_32_raw(color_t c1, color_t c2)
+inline bool color_equal_32_raw(color_t c1, color_t c2)
 {
   return (c1 == c2);
 }
 
-static inline bool color_equal_32(color_t c1, color_t c2, int tolerance)
+inline bool color_equal_32(color_t c1, color_t c2, int tolerance)
 {
   if (tolerance == 0)
     return (c1 == c2) || (rgba_geta(c1) == 0 && rgba_geta(c2) == 0);
@@ -72,7 +95,7 @@ static inline bool color_equal_32(color_t c1, color_t c2, int tolerance)
   }
 }
 
-static inline bool color_equal_16(color_t c1, color_t c2, int tolerance)
+inline bool color_equal_16(color_t c1, color_t c2, int tolerance)
 {
   if (tolerance == 0)
     return (c1 == c2) || (graya_geta(c1) == 0 && graya_geta(c2) == 0);
@@ -89,7 +112,7 @@ static inline bool color_equal_16(color_t c1, color_t c2, int tolerance)
   }
 }
 
-static inline bool color_equal_8(color_t c1, color_t c2, int tolerance)
+inline bool color_equal_8(color_t c1, color_t c2, int tolerance)
 {
   if (tolerance == 0)
     return (c1 == c2);
@@ -98,7 +121,7 @@ static inline bool color_equal_8(color_t c1, color_t c2, int tolerance)
 }
 
 template<typename ImageTraits>
-static inline bool color_equal(color_t c1, color_t c2, int tolerance)
+inline bool color_equal(color_t c1, color_t c2, int tolerance)
 {
   static_assert(false && sizeof(ImageTraits), "Invalid color comparison");
   return false;
@@ -128,463 +151,446 @@ inline bool color_equal<TilemapTraits>(color_t c1, color_t c2, int tolerance)
   return color_equal_32_raw(c1, c2);
 }
 
-/* flooder:
- *  Fills a horizontal line around the specified position, and adds it
- *  to the list of drawn segments. Returns the first x coordinate after
- *  the part of the line which it has dealt with.
- */
-static int flooder(const Image* image,
-                   const Mask* mask,
-                   int x,
-                   int y,
-                   const gfx::Rect& bounds,
-                   color_t src_color,
-                   int tolerance,
-                   void* data,
-                   AlgoHLine proc)
-{
-#define MASKED(u, v)                                                                               \
-  (mask && (!mask->bounds().contains(u, v) ||                                                      \
-            (mask->bitmap() && !get_pixel_fast<BitmapTraits>(mask->bitmap(),                       \
-                                                             (u) - mask->bounds().x,               \
-                                                             (v) - mask->bounds().y))))
-
-  FLOODED_LINE* p;
-  int left = 0, right = 0;
-  int c;
-
-  switch (image->pixelFormat()) {
-    case IMAGE_RGB: {
-      uint32_t* address = reinterpret_cast<uint32_t*>(image->getPixelAddress(0, y));
+// Compares a run of pixels with the source color. The SSE2 version
+// compares 16 bytes at the same time using the same rules as
+// color_equal<ImageTraits>(): the absolute difference of each
+// channel must be <= tolerance, or both colors must be transparent.
+template<typename ImageTraits>
+class ColorMatch {
+public:
+  using pixel_t = typename ImageTraits::pixel_t;
+
+  ColorMatch(const color_t srcColor, const int tolerance)
+    : m_srcColor(srcColor)
+    , m_tolerance(tolerance)
+  {
+#if DOC_USE_SSE2_FLOODFILL
+    const int tol = std::clamp(tolerance, 0, 255);
+    m_tol = _mm_set1_epi8(char(tol));
+    switch (ImageTraits::pixel_format) {
+      case IMAGE_RGB:
+        m_src = _mm_set1_epi32(int(srcColor));
+        m_alpha = _mm_set1_epi32(int(rgba_a_mask));
+        m_transparent = (rgba_geta(srcColor) == 0);
+        break;
+      case IMAGE_GRAYSCALE:
+        m_src = _mm_set1_epi16(short(srcColor));
+        m_alpha = _mm_set1_epi16(short(graya_a_mask));
+        m_transparent = (graya_geta(srcColor) == 0);
+        break;
+      case IMAGE_INDEXED:
+        m_src = _mm_set1_epi8(char(srcColor));
+        m_transparent = false;
+        break;
+      case IMAGE_TILEMAP:
+        m_src = _mm_set1_epi32(int(srcColor));
+        m_transparent = false;
+        break;
+      default: break;
+    }
+#endif
+  }
 
-      // Check start pixel
-      if (!color_equal_32((int)*(address + x), src_color, tolerance) || MASKED(x, y))
-        return x + 1;
+  // Sets the bit (x - bounds.x) of the "bits" array for each pixel
+  // in the row "y" that matches the source color.
+  void matchRow(const Image* image, const gfx::Rect& bounds, const int y, uint32_t* bits) const
+  {
+    const pixel_t* p = reinterpret_cast<const pixel_t*>(image->getPixelAddress(bounds.x, y));
+    const int n = bounds.w;
+    int i = 0;
+#if DOC_USE_SSE2_FLOODFILL
+    // kPixels is 4, 8 or 16, so each group of bits fits in the same
+    // 32-bit word.
+    for (; i + kPixels <= n; i += kPixels)
+      bits[i >> 5] |= uint32_t(matchBits(p + i)) << (i & 31);
+#endif
+    for (; i < n; ++i) {
+      if (color_equal<ImageTraits>(p[i], m_srcColor, m_tolerance))
+        bits[i >> 5] |= (1u << (i & 31));
+    }
+  }
 
-      // Work left from starting point
-      for (left = x - 1; left >= bounds.x; left--) {
-        if (!color_equal_32((int)*(address + left), src_color, tolerance) || MASKED(left, y))
-          break;
+private:
+#if DOC_USE_SSE2_FLOODFILL
+  static constexpr int kPixels = 16 / sizeof(pixel_t);
+
+  // Returns one bit for each of the kPixels pixels starting at p.
+  int matchBits(const pixel_t* p) const
+  {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+
+    if (ImageTraits::pixel_format == IMAGE_TILEMAP)
+      return _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(c, m_src)));
+
+    // Absolute difference of each channel minus the tolerance (zero
+    // if the channel is similar).
+    const __m128i diff = _mm_subs_epu8(
+      _mm_or_si128(_mm_subs_epu8(c, m_src), _mm_subs_epu8(m_src, c)),
+      m_tol);
+
+    switch (ImageTraits::pixel_format) {
+      case IMAGE_RGB: {
+        __m128i m = _mm_cmpeq_epi32(diff, zero);
+        if (m_transparent)
+          m = _mm_or_si128(m, _mm_cmpeq_epi32(_mm_and_si128(c, m_alpha), zero));
+        return _mm_movemask_ps(_mm_castsi128_ps(m));
       }
-
-      // Work right from starting point
-      for (right = x + 1; right < bounds.x2(); right++) {
-        if (!color_equal_32((int)*(address + right), src_color, tolerance) || MASKED(right, y))
-          break;
+      case IMAGE_GRAYSCALE: {
+        __m128i m = _mm_cmpeq_epi16(diff, zero);
+        if (m_transparent)
+          m = _mm_or_si128(m, _mm_cmpeq_epi16(_mm_and_si128(c, m_alpha), zero));
+        return _mm_movemask_epi8(_mm_packs_epi16(m, zero));
       }
-    } break;
+      case IMAGE_INDEXED: return _mm_movemask_epi8(_mm_cmpeq_epi8(diff, zero));
+      default:            break;
+    }
+    return 0;
+  }
 
-    case IMAGE_GRAYSCALE: {
-      uint16_t* address = reinterpret_cast<uint16_t*>(image->getPixelAddress(0, y));
+  __m128i m_src;
+  __m128i m_tol;
+  __m128i m_alpha;
+  bool m_transparent;
+#endif
 
-      // Check start pixel
-      if (!color_equal_16((int)*(address + x), src_color, tolerance) || MASKED(x, y))
-        return x + 1;
+  color_t m_srcColor;
+  int m_tolerance;
+};
 
-      // Work left from starting point
-      for (left = x - 1; left >= bounds.x; left--) {
-        if (!color_equal_16((int)*(address + left), src_color, tolerance) || MASKED(left, y))
-          break;
-      }
+// Keeps one bit for each pixel inside the bounds that can be filled
+// (it matches the source color, it's inside the mask, and it wasn't
+// filled yet). Rows are compared with the source color the first
+// time they are used, or all at once from several threads in the
+// parallel mode.
+template<typename ImageTraits>
+class FloodFill {
+public:
+  FloodFill(const Image* image,
+            const Mask* mask,
+            const gfx::Rect& bounds,
+            const color_t srcColor,
+            const int tolerance)
+    : m_image(image)
+    , m_mask(mask)
+    , m_bounds(bounds)
+    , m_match(srcColor, tolerance)
+    , m_rowWords((bounds.w + 31) / 32)
+    , m_bits(std::size_t(m_rowWords) * bounds.h, 0)
+    , m_ready(bounds.h, 0)
+  {
+  }
 
-      // Work right from starting point
-      for (right = x + 1; right < bounds.x2(); right++) {
-        if (!color_equal_16((int)*(address + right), src_color, tolerance) || MASKED(right, y))
-          break;
-      }
-    } break;
+  // Compares all rows using the floodfill thread pool.
+  void matchAllRows(const int nthreads)
+  {
+    const int h = m_bounds.h;
+    const int rowsPerTask = std::max(1, (h + nthreads * 4 - 1) / (nthreads * 4));
+
+    TaskGroup tasks;
+    for (int y = 0; y < h; y += rowsPerTask) {
+      const int y2 = std::min(y + rowsPerTask, h);
+      tasks.run([this, y, y2] {
+        TRACING_SCOPE("floodfill task");
+        for (int v = y; v < y2; ++v)
+          matchRow(v);
+      });
+    }
+    tasks.wait();
+  }
 
-    case IMAGE_INDEXED: {
-      uint8_t* address = image->getPixelAddress(0, y);
+  // Fills the contiguous region that includes (x, y).
+  void fill(const int x, const int y, const bool isEightConnected, void* data, AlgoHLine proc)
+  {
+    struct Segment {
+      int y, x1, x2; // Range [x1, x2) of the row y to check
+    };
+    std::vector<Segment> stack;
 
-      // Check start pixel
-      if (!color_equal_8((int)*(address + x), src_color, tolerance) || MASKED(x, y))
-        return x + 1;
+    if (!fillable(x, y))
+      return;
 
-      // Work left from starting point
-      for (left = x - 1; left >= bounds.x; left--) {
-        if (!color_equal_8((int)*(address + left), src_color, tolerance) || MASKED(left, y))
-          break;
-      }
+    const int d = (isEightConnected ? 1 : 0);
+    stack.push_back({ y, x, x + 1 });
 
-      // Work right from starting point
-      for (right = x + 1; right < bounds.x2(); right++) {
-        if (!color_equal_8((int)*(address + right), src_color, tolerance) || MASKED(right, y))
-          break;
-      }
-    } break;
+    while (!stack.empty()) {
+      const Segment s = stack.back();
+      stack.pop_back();
 
-    case IMAGE_TILEMAP: {
-      // TODO add support for mask
+      int u = s.x1;
+      while ((u = nextFillable(s.y, u, s.x2)) < s.x2) {
+        const int left = runBegin(s.y, u);
+        const int right = runEnd(s.y, u);
+        setFilled(s.y, left, right);
 
-      uint32_t* address = reinterpret_cast<uint32_t*>(image->getPixelAddress(0, y));
+        (*proc)(left, s.y, right - 1, data);
 
-      // Check start pixel
-      if (!color_equal_32_raw((int)*(address + x), src_color))
-        return x + 1;
+        const int x1 = std::max(left - d, m_bounds.x);
+        const int x2 = std::min(right + d, m_bounds.x2());
+        if (s.y + 1 < m_bounds.y2())
+          stack.push_back({ s.y + 1, x1, x2 });
+        if (s.y > m_bounds.y)
+          stack.push_back({ s.y - 1, x1, x2 });
 
-      // Work left from starting point
-      for (left = x - 1; left >= bounds.x; left--) {
-        if (!color_equal_32_raw((int)*(address + left), src_color))
-          break;
+        u = right;
       }
+    }
+  }
 
-      // Work right from starting point
-      for (right = x + 1; right < bounds.x2(); right++) {
-        if (!color_equal_32_raw((int)*(address + right), src_color))
-          break;
+  // Calls proc for each run of matching pixels (non-contiguous mode).
+  void fillAll(void* data, AlgoHLine proc)
+  {
+    for (int y = m_bounds.y; y < m_bounds.y2(); ++y) {
+      int u = m_bounds.x;
+      while ((u = nextFillable(y, u, m_bounds.x2())) < m_bounds.x2()) {
+        const int right = runEnd(y, u);
+        (*proc)(u, y, right - 1, data);
+        u = right;
       }
-    } break;
+    }
+  }
 
-    default:
-      // Check start pixel
-      if (get_pixel(image, x, y) != src_color || MASKED(x, y))
-        return x + 1;
+private:
+  void matchRow(const int v)
+  {
+    uint32_t* bits = &m_bits[std::size_t(m_rowWords) * v];
+    const int y = m_bounds.y + v;
 
-      // Work left from starting point
-      for (left = x - 1; left >= bounds.x; left--) {
-        if (get_pixel(image, left, y) != src_color || MASKED(left, y))
-          break;
-      }
+    m_match.matchRow(m_image, m_bounds, y, bits);
+    if (m_mask)
+      intersectMask(y, bits);
 
-      // Work right from starting point
-      for (right = x + 1; right < bounds.x2(); right++) {
-        if (get_pixel(image, right, y) != src_color || MASKED(right, y))
-          break;
-      }
-      break;
+    m_ready[v] = 1;
   }
 
-  left++;
-  right--;
+  // Clears the bits of the pixels outside the mask.
+  void intersectMask(const int y, uint32_t* bits) const
+  {
+    const gfx::Rect& maskBounds = m_mask->bounds();
+    const int u1 = std::max(m_bounds.x, maskBounds.x);
+    const int u2 = std::min(m_bounds.x2(), maskBounds.x2());
 
-  /* draw the line */
-  (*proc)(left, y, right, data);
+    if (y < maskBounds.y || y >= maskBounds.y2() || u1 >= u2) {
+      std::fill(bits, bits + m_rowWords, 0);
+      return;
+    }
 
-  /* store it in the list of flooded segments */
-  c = y;
-  p = FLOOD_LINE(c);
+    clearBits(bits, 0, u1 - m_bounds.x);
+    clearBits(bits, u2 - m_bounds.x, m_bounds.w);
 
-  if (p->flags) {
-    while (p->next) {
-      c = p->next;
-      p = FLOOD_LINE(c);
+    if (const Image* bitmap = m_mask->bitmap()) {
+      for (int u = u1; u < u2; ++u) {
+        if (!get_pixel_fast<BitmapTraits>(bitmap, u - maskBounds.x, y - maskBounds.y)) {
+          const int i = u - m_bounds.x;
+          bits[i >> 5] &= ~(1u << (i & 31));
+        }
+      }
     }
-
-    p->next = c = flood_count++;
-    flood_buf.resize(flood_count);
-    p = FLOOD_LINE(c);
   }
 
-  p->flags = FLOOD_IN_USE;
-  p->lpos = left;
-  p->rpos = right;
-  p->y = y;
-  p->next = 0;
-
-  if (y > bounds.y)
-    p->flags |= FLOOD_TODO_ABOVE;
-
-  if (y + 1 < bounds.y2())
-    p->flags |= FLOOD_TODO_BELOW;
-
-  return right + 2;
-}
+  const uint32_t* row(const int y)
+  {
+    const int v = y - m_bounds.y;
+    if (!m_ready[v])
+      matchRow(v);
+    return &m_bits[std::size_t(m_rowWords) * v];
+  }
 
-/* check_flood_line:
- *  Checks a line segment, using the scratch buffer is to store a list of
- *  segments which have already been drawn in order to minimise the required
- *  number of tests.
- */
-static int check_flood_line(const Image* image,
-                            const Mask* mask,
-                            int y,
-                            int left,
-                            int right,
-                            const gfx::Rect& bounds,
-                            int src_color,
-                            int tolerance,
-                            void* data,
-                            AlgoHLine proc)
-{
-  int c;
-  FLOODED_LINE* p;
-  int ret = false;
+  bool fillable(const int x, const int y)
+  {
+    const int i = x - m_bounds.x;
+    return (row(y)[i >> 5] & (1u << (i & 31))) != 0;
+  }
 
-  while (left <= right) {
-    c = y;
+  // Returns the first pixel in [x, x2) that can be filled, or x2.
+  int nextFillable(const int y, const int x, const int x2)
+  {
+    if (x >= x2)
+      return x2;
+
+    const uint32_t* bits = row(y);
+    int i = x - m_bounds.x;
+    int w = (i >> 5);
+    uint32_t word = bits[w] & (~0u << (i & 31));
+    while (!word) {
+      if (++w >= m_rowWords)
+        return x2;
+      word = bits[w];
+    }
+    return std::min(m_bounds.x + (w << 5) + first_bit(word), x2);
+  }
 
-    for (;;) {
-      p = FLOOD_LINE(c);
+  // Returns the first pixel after x that cannot be filled. The
+  // padding bits of the last word are always zero.
+  int runEnd(const int y, const int x)
+  {
+    const uint32_t* bits = row(y);
+    int i = x - m_bounds.x;
+    int w = (i >> 5);
+    uint32_t word = ~bits[w] & (~0u << (i & 31));
+    while (!word) {
+      if (++w >= m_rowWords)
+        return m_bounds.x2();
+      word = ~bits[w];
+    }
+    return std::min(m_bounds.x + (w << 5) + first_bit(word), m_bounds.x2());
+  }
 
-      if ((left >= p->lpos) && (left <= p->rpos)) {
-        left = p->rpos + 2;
-        break;
-      }
+  // Returns the first pixel of the run that includes x.
+  int runBegin(const int y, const int x)
+  {
+    const uint32_t* bits = row(y);
+    int i = x - m_bounds.x;
+    int w = (i >> 5);
+    uint32_t word = ~bits[w] & ((1u << (i & 31)) - 1);
+    while (!word) {
+      if (--w < 0)
+        return m_bounds.x;
+      word = ~bits[w];
+    }
+    return m_bounds.x + (w << 5) + last_bit(word) + 1;
+  }
 
-      c = p->next;
+  void setFilled(const int y, const int x1, const int x2)
+  {
+    uint32_t* bits = &m_bits[std::size_t(m_rowWords) * (y - m_bounds.y)];
+    clearBits(bits, x1 - m_bounds.x, x2 - m_bounds.x);
+  }
 
-      if (!c) {
-        left = flooder(image, mask, left, y, bounds, src_color, tolerance, data, proc);
-        ret = true;
-        break;
-      }
-    }
+  // Clears the bits in the range [i1, i2).
+  static void clearBits(uint32_t* bits, int i1, const int i2)
+  {
+    for (; i1 < i2 && (i1 & 31); ++i1)
+      bits[i1 >> 5] &= ~(1u << (i1 & 31));
+    for (; i1 + 32 <= i2; i1 += 32)
+      bits[i1 >> 5] = 0;
+    for (; i1 < i2; ++i1)
+      bits[i1 >> 5] &= ~(1u << (i1 & 31));
   }
 
-  return ret;
-}
+  const Image* m_image;
+  const Mask* m_mask;
+  gfx::Rect m_bounds;
+  ColorMatch<ImageTraits> m_match;
+  int m_rowWords;
+  std::vector<uint32_t> m_bits;
+  std::vector<uint8_t> m_ready;
+};
 
 template<typename ImageTraits>
-static void replace_color(const Image* image,
-                          const gfx::Rect& bounds,
-                          int src_color,
-                          int tolerance,
-                          void* data,
-                          AlgoHLine proc)
+void floodfill_templ(const Image* image,
+                     const Mask* mask,
+                     const int x,
+                     const int y,
+                     const gfx::Rect& bounds,
+                     const color_t srcColor,
+                     const int tolerance,
+                     const bool contiguous,
+                     const bool isEightConnected,
+                     void* data,
+                     AlgoHLine proc,
+                     const bool parallel)
 {
-  typename ImageTraits::address_t address;
-
-  for (int y = bounds.y; y < bounds.y2(); ++y) {
-    address = reinterpret_cast<typename ImageTraits::address_t>(
-      image->getPixelAddress(bounds.x, y));
-
-    for (int x = bounds.x; x < bounds.x2(); ++x, ++address) {
-      int right = -1;
-
-      if (color_equal<ImageTraits>((int)(*address), src_color, tolerance)) {
-        ++address;
-        for (right = x + 1; right < bounds.x2(); ++right, ++address) {
-          if (!color_equal<ImageTraits>((int)(*address), src_color, tolerance))
-            break;
-        }
-        (*proc)(x, y, right - 1, data);
-        x = right;
-      }
-    }
-  }
+  // The non-contiguous mode doesn't use the mask.
+  FloodFill<ImageTraits> floodfill(image,
+                                   (contiguous ? mask : nullptr),
+                                   bounds,
+                                   srcColor,
+                                   tolerance);
+
+  const int nthreads = task_threads();
+  if (parallel && nthreads >= 2 && bounds.w * bounds.h >= kParallelMinArea)
+    floodfill.matchAllRows(nthreads);
+
+  if (contiguous)
+    floodfill.fill(x, y, isEightConnected, data, proc);
+  else
+    floodfill.fillAll(data, proc);
 }
 
-/* floodfill:
- *  Fills an enclosed area (starting at point x, y) with the specified color.
- */
+} // anonymous namespace
+
 void floodfill(const Image* image,
                const Mask* mask,
                const int x,
                const int y,
-               const gfx::Rect& bounds,
-               const doc::color_t src_color,
+               const gfx::Rect& _bounds,
+               const doc::color_t srcColor,
                const int tolerance,
                const bool contiguous,
                const bool isEightConnected,
                void* data,
-               AlgoHLine proc)
+               AlgoHLine proc,
+               const bool parallel)
 {
   // Make sure we have a valid starting point
   if ((x < 0) || (x >= image->width()) || (y < 0) || (y >= image->height()))
     return;
 
-  // Non-contiguous case, we replace colors in the whole image.
-  if (!contiguous) {
-    switch (image->pixelFormat()) {
-      case IMAGE_RGB:
-        replace_color<RgbTraits>(image, bounds, src_color, tolerance, data, proc);
-        break;
-      case IMAGE_GRAYSCALE:
-        replace_color<GrayscaleTraits>(image, bounds, src_color, tolerance, data, proc);
-        break;
-      case IMAGE_INDEXED:
-        replace_color<IndexedTraits>(image, bounds, src_color, tolerance, data, proc);
-        break;
-      case IMAGE_TILEMAP:
-        replace_color<TilemapTraits>(image, bounds, src_color, tolerance, data, proc);
-        break;
-    }
+  const gfx::Rect bounds = (_bounds & image->bounds());
+  if (bounds.isEmpty() || (contiguous && !bounds.contains(gfx::Point(x, y))))
     return;
-  }
 
-  /* set up the list of flooded segments */
-  flood_buf.resize(image->height());
-  flood_count = image->height();
-  FLOODED_LINE* p = (FLOODED_LINE*)&flood_buf[0];
-  for (int c = 0; c < flood_count; c++) {
-    p[c].flags = 0;
-    p[c].lpos = std::numeric_limits<int>::max();
-    p[c].rpos = std::numeric_limits<int>::min();
-    p[c].y = y;
-    p[c].next = 0;
+  switch (image->pixelFormat()) {
+    case IMAGE_RGB:
+      floodfill_templ<RgbTraits>(image,
+                                 mask,
+                                 x,
+                                 y,
+                                 bounds,
+                                 srcColor,
+                                 tolerance,
+                                 contiguous,
+                                 isEightConnected,
+                                 data,
+                                 proc,
+                                 parallel);
+      break;
+    case IMAGE_GRAYSCALE:
+      floodfill_templ<GrayscaleTraits>(image,
+                                       mask,
+                                       x,
+                                       y,
+                                       bounds,
+                                       srcColor,
+                                       tolerance,
+                                       contiguous,
+                                       isEightConnected,
+                                       data,
+                                       proc,
+                                       parallel);
+      break;
+    case IMAGE_INDEXED:
+      floodfill_templ<IndexedTraits>(image,
+                                     mask,
+                                     x,
+                                     y,
+                                     bounds,
+                                     srcColor,
+                                     tolerance,
+                                     contiguous,
+                                     isEightConnected,
+                                     data,
+                                     proc,
+                                     parallel);
+      break;
+    case IMAGE_TILEMAP:
+      // TODO add support for mask
+      floodfill_templ<TilemapTraits>(image,
+                                     nullptr,
+                                     x,
+                                     y,
+                                     bounds,
+                                     srcColor,
+                                     tolerance,
+                                     contiguous,
+                                     isEightConnected,
+                                     data,
+                                     proc,
+                                     parallel);
+      break;
+    default: break;
   }
-
-  // Start up the flood algorithm
-  flooder(image, mask, x, y, bounds, src_color, tolerance, data, proc);
-
-  // Continue as long as there are some segments still to test
-  bool done;
-  do {
-    done = true;
-
-    // For each line on the screen
-    for (int c = 0; c < flood_count; c++) {
-      p = FLOOD_LINE(c);
-
-      // Check below the segment?
-      if (p->flags & FLOOD_TODO_BELOW) {
-        p->flags &= ~FLOOD_TODO_BELOW;
-
-        if (isEightConnected) {
-          if (p->lpos + 1 < bounds.x2() && check_flood_line(image,
-                                                            mask,
-                                                            p->y + 1,
-                                                            p->lpos + 1,
-                                                            p->rpos,
-                                                            bounds,
-                                                            src_color,
-                                                            tolerance,
-                                                            data,
-                                                            proc)) {
-            done = false;
-            p = FLOOD_LINE(c);
-          }
-
-          if (p->lpos - 1 >= bounds.x && check_flood_line(image,
-                                                          mask,
-                                                          p->y + 1,
-                                                          p->lpos - 1,
-                                                          p->rpos,
-                                                          bounds,
-                                                          src_color,
-                                                          tolerance,
-                                                          data,
-                                                          proc)) {
-            done = false;
-            p = FLOOD_LINE(c);
-          }
-
-          if (p->rpos + 1 < bounds.x2() && check_flood_line(image,
-                                                            mask,
-                                                            p->y + 1,
-                                                            p->lpos,
-                                                            p->rpos + 1,
-                                                            bounds,
-                                                            src_color,
-                                                            tolerance,
-                                                            data,
-                                                            proc)) {
-            done = false;
-            p = FLOOD_LINE(c);
-          }
-
-          if (p->rpos - 1 >= bounds.x && check_flood_line(image,
-                                                          mask,
-                                                          p->y + 1,
-                                                          p->lpos,
-                                                          p->rpos - 1,
-                                                          bounds,
-                                                          src_color,
-                                                          tolerance,
-                                                          data,
-                                                          proc)) {
-            done = false;
-            p = FLOOD_LINE(c);
-          }
-        }
-
-        if (check_flood_line(image,
-                             mask,
-                             p->y + 1,
-                             p->lpos,
-                             p->rpos,
-                             bounds,
-                             src_color,
-                             tolerance,
-                             data,
-                             proc)) {
-          done = false;
-          p = FLOOD_LINE(c);
-        }
-      }
-
-      // Check above the segment?
-      if (p->flags & FLOOD_TODO_ABOVE) {
-        p->flags &= ~FLOOD_TODO_ABOVE;
-
-        if (isEightConnected) {
-          if (p->lpos + 1 < bounds.x2() && check_flood_line(image,
-                                                            mask,
-                                                            p->y - 1,
-                                                            p->lpos + 1,
-                                                            p->rpos,
-                                                            bounds,
-                                                            src_color,
-                                                            tolerance,
-                                                            data,
-                                                            proc)) {
-            done = false;
-            p = FLOOD_LINE(c);
-          }
-
-          if (p->lpos - 1 >= bounds.x && check_flood_line(image,
-                                                          mask,
-                                                          p->y - 1,
-                                                          p->lpos - 1,
-                                                          p->rpos,
-                                                          bounds,
-                                                          src_color,
-                                                          tolerance,
-                                                          data,
-                                                          proc)) {
-            done = false;
-            p = FLOOD_LINE(c);
-          }
-
-          if (p->rpos + 1 < bounds.x2() && check_flood_line(image,
-                                                            mask,
-                                                            p->y - 1,
-                                                            p->lpos,
-                                                            p->rpos + 1,
-                                                            bounds,
-                                                            src_color,
-                                                            tolerance,
-                                                            data,
-                                                            proc)) {
-            done = false;
-            p = FLOOD_LINE(c);
-          }
-
-          if (p->rpos - 1 >= bounds.x && check_flood_line(image,
-                                                          mask,
-                                                          p->y - 1,
-                                                          p->lpos,
-                                                          p->rpos - 1,
-                                                          bounds,
-                                                          src_color,
-                                                          tolerance,
-                                                          data,
-                                                          proc)) {
-            done = false;
-            p = FLOOD_LINE(c);
-          }
-        }
-
-        if (check_flood_line(image,
-                             mask,
-                             p->y - 1,
-                             p->lpos,
-                             p->rpos,
-                             bounds,
-                             src_color,
-                             tolerance,
-                             data,
-                             proc)) {
-          done = false;
-
-          // Special case shortcut for going backwards
-          if ((c > bounds.y) && (c < bounds.y2()))
-            c -= 2;
-        }
-      }
-    }
-  } while (!done);
 }
 
 }} // namespace doc::algorithm
@@ -1,4 +1,5 @@
 // Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
 // Copyright (c) 2001-2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -19,6 +20,13 @@ class Mask;
 
 namespace algorithm {
 
+// Calls proc for each horizontal span of the contiguous region of
+// pixels similar to srcColor that includes the (x, y) point (or for
+// each span of similar pixels inside bounds if contiguous is false).
+//
+// If parallel is true and the bounds are big enough, the pixels are
+// compared with srcColor from several threads before filling the
+// region. proc is always called from the calling thread.
 void floodfill(const Image* image,
                const Mask* mask,
                const int x,
@@ -29,7 +37,8 @@ void floodfill(const Image* image,
                const bool contiguous,
                const bool isEightConnected,
                void* data,
-               AlgoHLine proc);
+               AlgoHLine proc,
+               const bool parallel = false);
 
 }
 } // namespace doc
@@ -0,0 +1,250 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "doc/algorithm/floodfill.h"
+#include "doc/image.h"
+#include "doc/image_ref.h"
+#include "doc/mask.h"
+#include "doc/primitives.h"
+
+#include <vector>
+
+using namespace doc;
+using namespace gfx;
+
+namespace {
+
+// Marks each pixel filled by floodfill() with 1 (or 2 if it was
+// filled twice).
+struct Filled {
+  ImageRef image;
+  explicit Filled(const Image* src)
+    : image(Image::create(IMAGE_INDEXED, src->width(), src->height()))
+  {
+    image->clear(0);
+  }
+};
+
+void hline(int x1, int y, int x2, void* data)
+{
+  Image* image = static_cast<Filled*>(data)->image.get();
+  for (int x = x1; x <= x2; ++x)
+    put_pixel(image, x, y, get_pixel(image, x, y) + 1);
+}
+
+::testing::AssertionResult cmp_img(const std::vector<color_t>& pixels, const Image* image)
+{
+  int c = 0;
+  for (int y = 0; y < image->height(); ++y) {
+    for (int x = 0; x < image->width(); ++x) {
+      if (pixels[c] != image->getPixel(x, y)) {
+        return ::testing::AssertionFailure()
+               << "ExpectedPixel=" << (int)pixels[c]
+               << " ActualPixel=" << (int)image->getPixel(x, y) << " x=" << x << " y=" << y;
+      }
+      ++c;
+    }
+  }
+  return ::testing::AssertionSuccess();
+}
+
+ImageRef create_indexed(const int w, const int h, const std::vector<color_t>& pixels)
+{
+  ImageRef image(Image::create(IMAGE_INDEXED, w, h));
+  int c = 0;
+  for (int y = 0; y < h; ++y)
+    for (int x = 0; x < w; ++x)
+      put_pixel(image.get(), x, y, pixels[c++]);
+  return image;
+}
+
+} // anonymous namespace
+
+TEST(FloodFill, Connectivity)
+{
+  ImageRef image = create_indexed(5,
+                                  4,
+                                  { 1, 1, 0, 0, 1, //
+                                    0, 1, 0, 1, 0, //
+                                    1, 0, 1, 1, 0, //
+                                    1, 0, 0, 0, 1 });
+  {
+    Filled filled(image.get());
+    algorithm::floodfill(image.get(),
+                         nullptr,
+                         0,
+                         0,
+                         image->bounds(),
+                         1,
+                         0,
+                         true,
+                         false,
+                         &filled,
+                         hline);
+    EXPECT_TRUE(cmp_img({ 1, 1, 0, 0, 0, //
+                          0, 1, 0, 0, 0, //
+                          0, 0, 0, 0, 0, //
+                          0, 0, 0, 0, 0 },
+                        filled.image.get()));
+  }
+  {
+    Filled filled(image.get());
+    algorithm::floodfill(image.get(),
+                         nullptr,
+                         0,
+                         0,
+                         image->bounds(),
+                         1,
+                         0,
+                         true,
+                         true,
+                         &filled,
+                         hline);
+    EXPECT_TRUE(cmp_img({ 1, 1, 0, 0, 1, //
+                          0, 1, 0, 1, 0, //
+                          1, 0, 1, 1, 0, //
+                          1, 0, 0, 0, 1 },
+                        filled.image.get()));
+  }
+}
+
+TEST(FloodFill, NonContiguousAndTolerance)
+{
+  ImageRef image = create_indexed(4,
+                                  2,
+                                  { 5, 6, 9, 4, //
+                                    7, 2, 5, 3 });
+  Filled filled(image.get());
+  algorithm::floodfill(image.get(),
+                       nullptr,
+                       0,
+                       0,
+                       image->bounds(),
+                       5,
+                       1,
+                       false,
+                       false,
+                       &filled,
+                       hline);
+  EXPECT_TRUE(cmp_img({ 1, 1, 0, 1, //
+                        0, 0, 1, 0 },
+                      filled.image.get()));
+}
+
+TEST(FloodFill, BoundsAndMask)
+{
+  ImageRef image(Image::create(IMAGE_INDEXED, 4, 4));
+  image->clear(1);
+
+  Mask mask;
+  mask.replace(Rect(1, 0, 3, 3));
+  Filled filled(image.get());
+  algorithm::floodfill(image.get(),
+                       &mask,
+                       2,
+                       1,
+                       Rect(0,
+                       1,
+                       3,
+                       3),
+                       1,
+                       0,
+                       true,
+                       false,
+                       &filled,
+                       hline);
+  EXPECT_TRUE(cmp_img({ 0, 0, 0, 0, //
+                        0, 1, 1, 0, //
+                        0, 1, 1, 0, //
+                        0, 0, 0, 0 },
+                      filled.image.get()));
+}
+
+TEST(FloodFill, TransparentRgb)
+{
+  ImageRef image(Image::create(IMAGE_RGB, 19, 3));
+  image->clear(rgba(0, 0, 0, 0));
+  put_pixel(image.get(), 12, 0, rgba(255, 0, 0, 0));
+  put_pixel(image.get(), 17, 1, rgba(1, 1, 0, 1));
+  for (int y = 0; y < 3; ++y)
+    put_pixel(image.get(), 9, y, rgba(0, 0, 0, 255));
+
+  // All transparent pixels are equal, (1, 1, 0, 1) is similar
+  // with tolerance, and the opaque column splits the image.
+  for (int tolerance = 0; tolerance < 2; ++tolerance) {
+    Filled filled(image.get());
+    algorithm::floodfill(image.get(),
+                         nullptr,
+                         18,
+                         2,
+                         image->bounds(),
+                         0,
+                         tolerance,
+                         true,
+                         false,
+                         &filled,
+                         hline);
+    for (int y = 0; y < 3; ++y) {
+      for (int x = 0; x < 19; ++x) {
+        const int expected = (x > 9 && (x != 17 || y != 1 || tolerance > 0) ? 1 : 0);
+        EXPECT_EQ(expected, get_pixel(filled.image.get(), x, y)) << x << "," << y;
+      }
+    }
+  }
+}
+
+TEST(FloodFill, ParallelMode)
+{
+  // A big spiral-like maze to compare the serial and parallel modes.
+  ImageRef image(Image::create(IMAGE_GRAYSCALE, 600, 500));
+  image->clear(graya(0, 255));
+  for (int y = 0; y < image->height(); ++y)
+    for (int x = 0; x < image->width(); ++x)
+      if ((x % 7 == 3 && y % 50 != x % 50) || (y % 9 == 4 && x % 23 == 0))
+        put_pixel(image.get(), x, y, graya(200, 255));
+
+  for (int eight = 0; eight < 2; ++eight) {
+    Filled serial(image.get());
+    Filled parallel(image.get());
+    algorithm::floodfill(image.get(),
+                         nullptr,
+                         0,
+                         0,
+                         image->bounds(),
+                         graya(2, 255),
+                         2,
+                         true,
+                         eight != 0,
+                         &serial,
+                         hline,
+                         false);
+    algorithm::floodfill(image.get(),
+                         nullptr,
+                         0,
+                         0,
+                         image->bounds(),
+                         graya(2, 255),
+                         2,
+                         true,
+                         eight != 0,
+                         &parallel,
+                         hline,
+                         true);
+
+    int count = 0;
+    for (int y = 0; y < image->height(); ++y) {
+      for (int x = 0; x < image->width(); ++x) {
+        const color_t c = get_pixel(serial.image.get(), x, y);
+        ASSERT_EQ(c, get_pixel(parallel.image.get(), x, y));
+        ASSERT_LE(c, 1);
+        count += c;
+      }
+    }
+    EXPECT_GT(count, 0);
+  }
+}
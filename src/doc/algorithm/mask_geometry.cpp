@@ -0,0 +1,202 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "doc/algorithm/mask_geometry.h"
+
+#include "doc/mask_boundaries.h"
+#include "doc/mask_runs.h"
+
+#include <cstdint>
+#include <numeric>
+#include <unordered_map>
+#include <utility>
+
+namespace doc { namespace algorithm {
+
+namespace {
+
+int find_root(std::vector<int>& parents, int i)
+{
+  while (parents[i] != i) {
+    parents[i] = parents[parents[i]];
+    i = parents[i];
+  }
+  return i;
+}
+
+void join(std::vector<int>& parents, int a, int b)
+{
+  a = find_root(parents, a);
+  b = find_root(parents, b);
+  // The smallest index is the root, so the root is the first run of
+  // the component.
+  if (a < b)
+    parents[b] = a;
+  else if (b < a)
+    parents[a] = b;
+}
+
+// Directed edge of a polygon.
+struct Edge {
+  gfx::Point start, end;
+  bool used = false;
+
+  gfx::Point dir() const
+  {
+    return gfx::Point((end.x > start.x) - (end.x < start.x), (end.y > start.y) - (end.y < start.y));
+  }
+};
+
+uint64_t point_key(const gfx::Point& pt)
+{
+  return (uint64_t(uint32_t(pt.x)) << 32) | uint32_t(pt.y);
+}
+
+} // anonymous namespace
+
+int count_mask_pixels(const MaskRuns& runs)
+{
+  int count = 0;
+  const gfx::Rect& bounds = runs.bounds();
+  for (int y = bounds.y; y < bounds.y2(); ++y) {
+    for (const MaskRuns::Run& run : runs.row(y))
+      count += run.x2 - run.x1;
+  }
+  return count;
+}
+
+void mask_components(const MaskRuns& runs, std::vector<MaskRuns>& components)
+{
+  components.clear();
+  if (runs.isEmpty())
+    return;
+
+  const gfx::Rect& bounds = runs.bounds();
+
+  // Index of the first run of each row
+  std::vector<int> firstRun(bounds.h + 1);
+  int nruns = 0;
+  for (int y = bounds.y; y < bounds.y2(); ++y) {
+    firstRun[y - bounds.y] = nruns;
+    nruns += int(runs.row(y).size());
+  }
+  firstRun[bounds.h] = nruns;
+
+  std::vector<int> parents(nruns);
+  std::iota(parents.begin(), parents.end(), 0);
+
+  // Join the runs that overlap with runs of the previous row (both
+  // rows are sorted, so we can advance in both lists at the same
+  // time).
+  for (int y = bounds.y + 1; y < bounds.y2(); ++y) {
+    const MaskRuns::Row& prev = runs.row(y - 1);
+    const MaskRuns::Row& row = runs.row(y);
+    const int prevBase = firstRun[y - 1 - bounds.y];
+    const int base = firstRun[y - bounds.y];
+    std::size_t i = 0, j = 0;
+    while (i < prev.size() && j < row.size()) {
+      if (prev[i].x1 < row[j].x2 && row[j].x1 < prev[i].x2)
+        join(parents, prevBase + int(i), base + int(j));
+
+      if (prev[i].x2 < row[j].x2)
+        ++i;
+      else
+        ++j;
+    }
+  }
+
+  // Create one MaskRuns for each root
+  std::unordered_map<int, int> componentIndex;
+  for (int y = bounds.y; y < bounds.y2(); ++y) {
+    const MaskRuns::Row& row = runs.row(y);
+    const int base = firstRun[y - bounds.y];
+    for (std::size_t i = 0; i < row.size(); ++i) {
+      const int root = find_root(parents, base + int(i));
+      auto it = componentIndex.find(root);
+      if (it == componentIndex.end()) {
+        it = componentIndex.insert(std::make_pair(root, int(components.size()))).first;
+        components.emplace_back();
+      }
+      components[it->second].add(gfx::Rect(row[i].x1, y, row[i].x2 - row[i].x1, 1));
+    }
+  }
+}
+
+void mask_polygons(const MaskBoundaries& boundaries, std::vector<Polygon>& polygons)
+{
+  polygons.clear();
+
+  // Convert segments to edges with the selected area on the right
+  // side: "open" horizontal segments have the selected pixels below,
+  // and "open" vertical segments have the selected pixels at the
+  // right side.
+  std::vector<Edge> edges;
+  std::unordered_multimap<uint64_t, int> edgesByStart;
+  for (const auto& seg : boundaries) {
+    const gfx::Rect& rc = seg.bounds();
+    Edge edge;
+    if (seg.horizontal()) {
+      if (rc.w == 0)
+        continue;
+      edge.start = gfx::Point(seg.open() ? rc.x : rc.x2(), rc.y);
+      edge.end = gfx::Point(seg.open() ? rc.x2() : rc.x, rc.y);
+    }
+    else {
+      if (rc.h == 0)
+        continue;
+      edge.start = gfx::Point(rc.x, seg.open() ? rc.y2() : rc.y);
+      edge.end = gfx::Point(rc.x, seg.open() ? rc.y : rc.y2());
+    }
+    edgesByStart.insert(std::make_pair(point_key(edge.start), int(edges.size())));
+    edges.push_back(edge);
+  }
+
+  for (std::size_t first = 0; first < edges.size(); ++first) {
+    if (edges[first].used)
+      continue;
+
+    Polygon points;
+    int current = int(first);
+    do {
+      Edge& edge = edges[current];
+      edge.used = true;
+      points.push_back(edge.start);
+
+      // Next edge, when there are two options (two pixels touching
+      // diagonally), turn right to keep the pixels separated (so each
+      // edge has only one possible next edge and the contour is
+      // closed at the first edge).
+      const gfx::Point dir = edge.dir();
+      const gfx::Point rightDir(-dir.y, dir.x);
+      int next = -1;
+      auto range = edgesByStart.equal_range(point_key(edge.end));
+      for (auto it = range.first; it != range.second; ++it) {
+        if (next < 0 || edges[it->second].dir() == rightDir)
+          next = it->second;
+      }
+      current = next;
+    } while (current >= 0 && !edges[current].used);
+
+    // Keep only the corners (edges in the same direction can be
+    // split, e.g. in bands of rows)
+    Polygon polygon;
+    const std::size_t n = points.size();
+    for (std::size_t i = 0; i < n; ++i) {
+      const gfx::Point& a = points[(i + n - 1) % n];
+      const gfx::Point& b = points[i];
+      const gfx::Point& c = points[(i + 1) % n];
+      if (!(a.x == b.x && b.x == c.x) && !(a.y == b.y && b.y == c.y))
+        polygon.push_back(b);
+    }
+    polygons.push_back(std::move(polygon));
+  }
+}
+
+}} // namespace doc::algorithm
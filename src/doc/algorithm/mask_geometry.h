@@ -0,0 +1,45 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef DOC_ALGORITHM_MASK_GEOMETRY_H_INCLUDED
+#define DOC_ALGORITHM_MASK_GEOMETRY_H_INCLUDED
+#pragma once
+
+#include "gfx/point.h"
+
+#include <vector>
+
+// Queries over the geometry of a selection that work with its runs
+// or boundaries instead of checking each pixel of its bounds.
+
+namespace doc {
+class MaskBoundaries;
+class MaskRuns;
+
+namespace algorithm {
+
+using Polygon = std::vector<gfx::Point>;
+
+// Returns the number of selected pixels.
+int count_mask_pixels(const MaskRuns& runs);
+
+// Splits the selection in its 4-connected components. Components
+// are sorted by their first pixel (from top to bottom and left to
+// right).
+void mask_components(const MaskRuns& runs, std::vector<MaskRuns>& components);
+
+// Converts the boundaries of a selection to closed polygons (only the
+// corners are included, the last point is not the first one).
+// Polygons follow the edges of the pixels with the selected area on
+// the right side, so outer contours are clockwise and holes are
+// counter-clockwise (with the Y axis pointing down). Diagonally
+// adjacent pixels are in different contours (like components).
+void mask_polygons(const MaskBoundaries& boundaries, std::vector<Polygon>& polygons);
+
+} // namespace algorithm
+} // namespace doc
+
+#endif
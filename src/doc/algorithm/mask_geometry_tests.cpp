@@ -0,0 +1,112 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "doc/algorithm/mask_geometry.h"
+#include "doc/mask_boundaries.h"
+#include "doc/mask_runs.h"
+
+#include <algorithm>
+
+using namespace doc;
+using namespace doc::algorithm;
+using namespace gfx;
+
+TEST(MaskGeometry, CountPixels)
+{
+  MaskRuns runs;
+  EXPECT_EQ(0, count_mask_pixels(runs));
+
+  runs.add(Rect(0, 0, 10, 10));
+  runs.subtract(Rect(2, 2, 3, 3));
+  runs.add(Rect(20, 5, 2, 1));
+  EXPECT_EQ(100 - 9 + 2, count_mask_pixels(runs));
+}
+
+TEST(MaskGeometry, Components)
+{
+  MaskRuns runs;
+  runs.add(Rect(0, 0, 4, 1)); // A
+  runs.add(Rect(3, 1, 1, 2)); // A
+  runs.add(Rect(0, 2, 2, 2)); // B
+  runs.add(Rect(4, 3, 1, 1)); // C (diagonal to A)
+  runs.add(Rect(6, 0, 1, 4)); // D
+
+  std::vector<MaskRuns> components;
+  mask_components(runs, components);
+  ASSERT_EQ(4u, components.size());
+  EXPECT_EQ(Rect(0, 0, 4, 3), components[0].bounds());
+  EXPECT_EQ(6, count_mask_pixels(components[0]));
+  EXPECT_EQ(Rect(6, 0, 1, 4), components[1].bounds());
+  EXPECT_EQ(Rect(0, 2, 2, 2), components[2].bounds());
+  EXPECT_EQ(Rect(4, 3, 1, 1), components[3].bounds());
+
+  // A "U" shape is only one component
+  runs.clear();
+  runs.add(Rect(0, 0, 1, 5));
+  runs.add(Rect(4, 0, 1, 5));
+  runs.add(Rect(0, 4, 5, 1));
+  mask_components(runs, components);
+  ASSERT_EQ(1u, components.size());
+  EXPECT_EQ(runs, components[0]);
+}
+
+TEST(MaskGeometry, Polygons)
+{
+  MaskRuns runs;
+  runs.add(Rect(1, 2, 3, 2));
+
+  MaskBoundaries boundaries;
+  boundaries.regen(runs);
+
+  std::vector<Polygon> polygons;
+  mask_polygons(boundaries, polygons);
+  ASSERT_EQ(1u, polygons.size());
+  ASSERT_EQ(4u, polygons[0].size());
+
+  // Clockwise starting from any corner
+  const Polygon expected = { Point(1, 2), Point(4, 2), Point(4, 4), Point(1, 4) };
+  auto it = std::find(polygons[0].begin(), polygons[0].end(), expected[0]);
+  ASSERT_TRUE(it != polygons[0].end());
+  std::rotate(polygons[0].begin(), it, polygons[0].end());
+  EXPECT_EQ(expected, polygons[0]);
+}
+
+TEST(MaskGeometry, PolygonsWithHoleAndDiagonals)
+{
+  // A square with a hole
+  MaskRuns runs;
+  runs.add(Rect(0, 0, 5, 5));
+  runs.subtract(Rect(1, 1, 3, 3));
+
+  MaskBoundaries boundaries;
+  boundaries.regen(runs);
+
+  std::vector<Polygon> polygons;
+  mask_polygons(boundaries, polygons);
+  ASSERT_EQ(2u, polygons.size());
+  EXPECT_EQ(4u, polygons[0].size());
+  EXPECT_EQ(4u, polygons[1].size());
+
+  // Two pixels touching diagonally are two polygons
+  runs.clear();
+  runs.add(Rect(0, 0, 1, 1));
+  runs.add(Rect(1, 1, 1, 1));
+  boundaries.regen(runs);
+  mask_polygons(boundaries, polygons);
+  ASSERT_EQ(2u, polygons.size());
+  EXPECT_EQ(4u, polygons[0].size());
+  EXPECT_EQ(4u, polygons[1].size());
+
+  // A tall selection split in bands of rows has only 4 corners
+  runs.clear();
+  runs.add(Rect(0, 0, 2, MaskBoundaries::kBandRows * 3));
+  boundaries.regen(runs);
+  mask_polygons(boundaries, polygons);
+  ASSERT_EQ(1u, polygons.size());
+  EXPECT_EQ(4u, polygons[0].size());
+}
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2021 Igara Studio S.A.
+// Copyright (c) 2021-2026 Igara Studio S.A.
 // Copyright (c) 2018 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -15,73 +15,204 @@
 #include "doc/mask.h"
 #include "doc/primitives.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <vector>
 
 namespace doc { namespace algorithm {
 
-// TODO create morphological operators/functions in "doc" namespace
-// TODO the impl is not optimal, but is good enough as a first version
+namespace {
+
+// Rectangle of the kernel (inclusive offsets relative to its
+// center). The whole kernel is the union of these rectangles.
+struct KernelRect {
+  int x1, x2, y1, y2;
+};
+
+// Splits the kernel of the given brush in rectangles grouping
+// consecutive rows with the same horizontal span (a square is just
+// one rectangle).
+std::vector<KernelRect> kernel_rects(const int radius, const BrushType brush)
+{
+  if (brush != kCircleBrushType)
+    return { { -radius, radius, -radius, radius } };
+
+  const int size = 2 * radius + 1;
+  std::unique_ptr<Image> kernel(Image::create(IMAGE_BITMAP, size, size));
+  clear_image(kernel.get(), 0);
+  fill_ellipse(kernel.get(), 0, 0, size - 1, size - 1, 0, 0, 1);
+
+  std::vector<KernelRect> rects;
+  for (int v = 0; v < size; ++v) {
+    int x1 = size, x2 = -1;
+    for (int u = 0; u < size; ++u) {
+      if (kernel->getPixel(u, v)) {
+        x1 = std::min(x1, u);
+        x2 = u;
+      }
+    }
+    if (x2 < 0)
+      continue;
+
+    x1 -= radius;
+    x2 -= radius;
+    const int y = v - radius;
+    if (!rects.empty() && rects.back().x1 == x1 && rects.back().x2 == x2 &&
+        rects.back().y2 == y - 1) {
+      rects.back().y2 = y;
+    }
+    else
+      rects.push_back({ x1, x2, y, y });
+  }
+  return rects;
+}
+
+template<bool Dilate>
+inline uint8_t extremum(const uint8_t a, const uint8_t b)
+{
+  return (Dilate ? std::max(a, b) : std::min(a, b));
+}
+
+// Calculates in dst[i] the maximum (Dilate=true) or the minimum of
+// the src[i+a]...src[i+b] values (where values outside the "n"
+// elements are 0) using the van Herk/Gil-Werman algorithm, which
+// needs 3 comparisons per value no matter the size of the window.
+template<bool Dilate>
+void running_extremum(const uint8_t* src,
+                      uint8_t* dst,
+                      const int n,
+                      const int a,
+                      const int b,
+                      std::vector<uint8_t>& g,
+                      std::vector<uint8_t>& h)
+{
+  const int k = b - a + 1;
+  const int m = n + k - 1;
+  g.resize(m);
+  h.resize(m);
+
+  auto value = [src, n, a](const int t) -> uint8_t {
+    const int i = t + a;
+    return (i >= 0 && i < n ? src[i] : 0);
+  };
+
+  // Prefix/suffix extremums inside blocks of k values
+  for (int t = 0; t < m; ++t)
+    g[t] = (t % k == 0 ? value(t) : extremum<Dilate>(g[t - 1], value(t)));
+  for (int t = m - 1; t >= 0; --t)
+    h[t] = ((t + 1) % k == 0 || t == m - 1 ? value(t) : extremum<Dilate>(h[t + 1], value(t)));
+
+  // Each window of k values is the suffix of one block plus the
+  // prefix of the next one
+  for (int i = 0; i < n; ++i)
+    dst[i] = extremum<Dilate>(h[i], g[i + k - 1]);
+}
+
+class Morphology {
+public:
+  Morphology(const int w, const int h, const int nrects, ModifySelectionDelegate* delegate)
+    : m_w(w)
+    , m_h(h)
+    , m_tmp(w * h)
+    , m_col(h)
+    , m_colDst(h)
+    , m_steps(2.0 * nrects)
+    , m_step(0)
+    , m_delegate(delegate)
+  {
+  }
+
+  // Dilates (or erodes) the "src" image with the given rectangle and
+  // accumulates the result in "acc" (union for dilation or
+  // intersection for erosion). Returns false if the delegate
+  // canceled the operation.
+  template<bool Dilate>
+  bool apply(const std::vector<uint8_t>& src, const KernelRect& rc, std::vector<uint8_t>& acc)
+  {
+    // Horizontal pass
+    for (int y = 0; y < m_h; ++y) {
+      running_extremum<Dilate>(&src[y * m_w], &m_tmp[y * m_w], m_w, rc.x1, rc.x2, m_g, m_hh);
+      if ((y & 63) == 63 && !notifyProgress(double(y) / m_h))
+        return false;
+    }
+    ++m_step;
+
+    // Vertical pass
+    for (int x = 0; x < m_w; ++x) {
+      for (int y = 0; y < m_h; ++y)
+        m_col[y] = m_tmp[y * m_w + x];
+
+      running_extremum<Dilate>(m_col.data(), m_colDst.data(), m_h, rc.y1, rc.y2, m_g, m_hh);
+
+      for (int y = 0; y < m_h; ++y) {
+        uint8_t& a = acc[y * m_w + x];
+        a = extremum<Dilate>(a, m_colDst[y]);
+      }
+      if ((x & 63) == 63 && !notifyProgress(double(x) / m_w))
+        return false;
+    }
+    ++m_step;
+    return true;
+  }
+
+private:
+  bool notifyProgress(const double f)
+  {
+    if (!m_delegate)
+      return true;
+    m_delegate->notifyProgress((m_step + f) / m_steps);
+    return m_delegate->continueTask();
+  }
+
+  int m_w, m_h;
+  std::vector<uint8_t> m_tmp;
+  std::vector<uint8_t> m_col, m_colDst;
+  std::vector<uint8_t> m_g, m_hh;
+  double m_steps;
+  int m_step;
+  ModifySelectionDelegate* m_delegate;
+};
+
+} // anonymous namespace
+
 void modify_selection(const SelectionModifier modifier,
                       const Mask* srcMask,
                       Mask* dstMask,
                       const int radius,
-                      const doc::BrushType brush)
+                      const doc::BrushType brush,
+                      ModifySelectionDelegate* delegate)
 {
   const doc::Image* srcImage = srcMask->bitmap();
   doc::Image* dstImage = dstMask->bitmap();
-  const gfx::Point offset = srcMask->bounds().origin() - dstMask->bounds().origin();
+  const gfx::Point offset = srcMask->bounds().origin() - dstMask->bounds().origin() -
+                            gfx::Point(radius, radius);
 
-  // Image bounds to clip get/put pixels
-  const gfx::Rect srcBounds = srcImage->bounds();
+  // Source pixels with a border of "radius" pixels where the kernel
+  // can reach some source pixel
+  const int w = srcImage->width() + 2 * radius;
+  const int h = srcImage->height() + 2 * radius;
+  std::vector<uint8_t> src(w * h, 0);
+  for (int y = 0; y < srcImage->height(); ++y)
+    for (int x = 0; x < srcImage->width(); ++x)
+      src[(y + radius) * w + x + radius] = (srcImage->getPixel(x, y) ? 1 : 0);
 
-  // Create a kernel
-  const int size = 2 * radius + 1;
-  std::unique_ptr<doc::Image> kernel(doc::Image::create(IMAGE_BITMAP, size, size));
-  doc::clear_image(kernel.get(), 0);
-  if (brush == doc::kCircleBrushType)
-    doc::fill_ellipse(kernel.get(), 0, 0, size - 1, size - 1, 0, 0, 1);
-  else
-    doc::fill_rect(kernel.get(), 0, 0, size - 1, size - 1, 1);
-  doc::put_pixel(kernel.get(), radius, radius, 0);
-
-  int total = 0; // Number of 1s in the kernel image
-  for (int v = 0; v < size; ++v)
-    for (int u = 0; u < size; ++u)
-      total += kernel->getPixel(u, v);
-
-  for (int y = -radius; y < srcBounds.h + radius; ++y) {
-    for (int x = -radius; x < srcBounds.w + radius; ++x) {
-      doc::color_t c;
-      if (srcBounds.contains(x, y))
-        c = srcImage->getPixel(x, y);
-      else
-        c = 0;
-
-      int accum = 0;
-      for (int v = 0; v < size; ++v) {
-        for (int u = 0; u < size; ++u) {
-          if (kernel->getPixel(u, v)) {
-            if (srcBounds.contains(x + u - radius, y + v - radius))
-              accum += srcImage->getPixel(x - radius + u, y - radius + v);
-          }
-        }
-      }
+  // Expand is a dilation of the selection, Contract is an erosion,
+  // and Border the selected pixels that are not in the erosion.
+  const bool dilate = (modifier == SelectionModifier::Expand);
+  std::vector<uint8_t> acc(w * h, dilate ? 0 : 1);
 
-      switch (modifier) {
-        case SelectionModifier::Border: {
-          c = (c && accum < total) ? 1 : 0;
-          break;
-        }
-        case SelectionModifier::Expand: {
-          c = (c || accum > 0) ? 1 : 0;
-          break;
-        }
-        case SelectionModifier::Contract: {
-          c = (c && accum == total) ? 1 : 0;
-          break;
-        }
-      }
+  const std::vector<KernelRect> rects = kernel_rects(radius, brush);
+  Morphology morph(w, h, int(rects.size()), delegate);
+  for (const KernelRect& rc : rects) {
+    if (!(dilate ? morph.apply<true>(src, rc, acc) : morph.apply<false>(src, rc, acc)))
+      return;
+  }
 
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      const int i = y * w + x;
+      const bool c = (modifier == SelectionModifier::Border ? src[i] && !acc[i] : acc[i] != 0);
       if (c)
         doc::put_pixel(dstImage, offset.x + x, offset.y + y, 1);
     }
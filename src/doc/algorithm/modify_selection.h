@@ -1,4 +1,5 @@
 // Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
 // Copyright (c) 2018 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -22,11 +23,26 @@ enum class SelectionModifier {
   Contract,
 };
 
+// Used to report the progress of modify_selection() and to cancel
+// it (e.g. when it's executed from a background thread).
+class ModifySelectionDelegate {
+public:
+  virtual ~ModifySelectionDelegate() {}
+  virtual void notifyProgress(double progress) = 0;
+  virtual bool continueTask() = 0;
+};
+
+// Adds to dstMask the srcMask modified with a square or circle
+// kernel of the given radius. The kernel is decomposed in
+// rectangles and each rectangle is applied with separable running
+// min/max passes, so the cost doesn't depend on the radius for
+// squares (and only linearly for circles).
 void modify_selection(const SelectionModifier modifier,
                       const Mask* srcMask,
                       Mask* dstMask,
                       const int radius,
-                      const BrushType brush);
+                      const BrushType brush,
+                      ModifySelectionDelegate* delegate = nullptr);
 
 } // namespace algorithm
 } // namespace doc
@@ -0,0 +1,126 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "doc/algorithm/modify_selection.h"
+#include "doc/image.h"
+#include "doc/mask.h"
+#include "doc/primitives.h"
+
+#include <cstdlib>
+#include <memory>
+
+using namespace doc;
+using namespace doc::algorithm;
+using namespace gfx;
+
+namespace {
+
+// Previous implementation of modify_selection() which applies the
+// kernel for each pixel, used to compare the results.
+void modify_selection_reference(const SelectionModifier modifier,
+                                const Mask* srcMask,
+                                Mask* dstMask,
+                                const int radius,
+                                const BrushType brush)
+{
+  const Image* srcImage = srcMask->bitmap();
+  Image* dstImage = dstMask->bitmap();
+  const Point offset = srcMask->bounds().origin() - dstMask->bounds().origin();
+  const Rect srcBounds = srcImage->bounds();
+
+  const int size = 2 * radius + 1;
+  std::unique_ptr<Image> kernel(Image::create(IMAGE_BITMAP, size, size));
+  clear_image(kernel.get(), 0);
+  if (brush == kCircleBrushType)
+    fill_ellipse(kernel.get(), 0, 0, size - 1, size - 1, 0, 0, 1);
+  else
+    fill_rect(kernel.get(), 0, 0, size - 1, size - 1, 1);
+  put_pixel(kernel.get(), radius, radius, 0);
+
+  int total = 0;
+  for (int v = 0; v < size; ++v)
+    for (int u = 0; u < size; ++u)
+      total += kernel->getPixel(u, v);
+
+  for (int y = -radius; y < srcBounds.h + radius; ++y) {
+    for (int x = -radius; x < srcBounds.w + radius; ++x) {
+      color_t c = (srcBounds.contains(x, y) ? srcImage->getPixel(x, y) : 0);
+      int accum = 0;
+      for (int v = 0; v < size; ++v)
+        for (int u = 0; u < size; ++u)
+          if (kernel->getPixel(u, v) && srcBounds.contains(x + u - radius, y + v - radius))
+            accum += srcImage->getPixel(x - radius + u, y - radius + v);
+
+      switch (modifier) {
+        case SelectionModifier::Border:   c = (c && accum < total) ? 1 : 0; break;
+        case SelectionModifier::Expand:   c = (c || accum > 0) ? 1 : 0; break;
+        case SelectionModifier::Contract: c = (c && accum == total) ? 1 : 0; break;
+      }
+      if (c)
+        put_pixel(dstImage, offset.x + x, offset.y + y, 1);
+    }
+  }
+}
+
+std::unique_ptr<Mask> make_dst_mask()
+{
+  auto mask = std::make_unique<Mask>();
+  mask->reserve(Rect(0, 0, 64, 48));
+  mask->freeze();
+  return mask;
+}
+
+} // anonymous namespace
+
+TEST(ModifySelection, SameResultAsKernelPerPixel)
+{
+  std::srand(7);
+
+  Mask src;
+  src.replace(Rect(10, 12, 30, 20));
+  for (int y = 0; y < 20; ++y)
+    for (int x = 0; x < 30; ++x)
+      if ((std::rand() % 4) == 0)
+        src.bitmap()->putPixel(x, y, 0);
+
+  for (const SelectionModifier modifier :
+       { SelectionModifier::Border, SelectionModifier::Expand, SelectionModifier::Contract }) {
+    for (const BrushType brush : { kSquareBrushType, kCircleBrushType }) {
+      for (int radius = 0; radius <= 7; ++radius) {
+        auto expected = make_dst_mask();
+        auto result = make_dst_mask();
+        modify_selection_reference(modifier, &src, expected.get(), radius, brush);
+        modify_selection(modifier, &src, result.get(), radius, brush);
+
+        for (int y = 0; y < 48; ++y)
+          for (int x = 0; x < 64; ++x)
+            ASSERT_EQ(expected->bitmap()->getPixel(x, y), result->bitmap()->getPixel(x, y))
+              << "modifier=" << int(modifier) << " brush=" << int(brush)
+              << " radius=" << radius << " x=" << x << " y=" << y;
+      }
+    }
+  }
+}
+
+TEST(ModifySelection, Cancel)
+{
+  struct Delegate : ModifySelectionDelegate {
+    double progress = 0.0;
+    void notifyProgress(double p) override { progress = p; }
+    bool continueTask() override { return false; }
+  } delegate;
+
+  Mask src;
+  src.replace(Rect(0, 0, 256, 256));
+
+  auto result = make_dst_mask();
+  modify_selection(SelectionModifier::Expand, &src, result.get(), 4, kSquareBrushType, &delegate);
+  EXPECT_GT(delegate.progress, 0.0);
+  EXPECT_LT(delegate.progress, 1.0);
+  EXPECT_EQ(0, result->bitmap()->getPixel(10, 10));
+}
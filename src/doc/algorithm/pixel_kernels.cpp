@@ -0,0 +1,408 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "doc/algorithm/pixel_kernels.h"
+
+#include "doc/image.h"
+#include "doc/image_traits.h"
+#include "doc/primitives_fast.h"
+#include "doc/task_group.h"
+#include "tracing/tracing.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <type_traits>
+#include <vector>
+
+namespace doc { namespace algorithm {
+
+namespace {
+
+// Minimum number of pixels to process the rows of a rectangle from
+// several threads.
+constexpr int kParallelMinArea = 256 * 256;
+
+// Number of groups of rows in which the rows of "rc" are divided.
+struct RowsGroups {
+  int rowsPerGroup;
+  int count;
+};
+
+RowsGroups rows_groups(const gfx::Rect& rc)
+{
+  const int nthreads = task_threads();
+  if (nthreads < 2 || rc.w * rc.h < kParallelMinArea)
+    return { rc.h, 1 };
+
+  const int rowsPerGroup = std::max(1, (rc.h + nthreads * 4 - 1) / (nthreads * 4));
+  return { rowsPerGroup, (rc.h + rowsPerGroup - 1) / rowsPerGroup };
+}
+
+// Calls func(group, y1, y2) for each group of rows of "rc". When
+// there are several groups, each one is processed in a different
+// task of the pool.
+template<typename Func>
+void for_each_rows_group(const gfx::Rect& rc, const RowsGroups& groups, Func&& func)
+{
+  if (groups.count == 1) {
+    func(0, rc.y, rc.y2());
+    return;
+  }
+
+  TaskGroup tasks;
+  for (int i = 0; i < groups.count; ++i) {
+    const int y1 = rc.y + i * groups.rowsPerGroup;
+    const int y2 = std::min(y1 + groups.rowsPerGroup, rc.y2());
+    tasks.run([&func, i, y1, y2] {
+      TRACING_SCOPE("pixel_kernels task");
+      func(i, y1, y2);
+    });
+  }
+  tasks.wait();
+}
+
+// Calls f(pixel, x, y) for each pixel of the rows [y1, y2) of "rc",
+// the pixel can be modified in place and "f" must return true if it
+// was modified. Returns the number of modified pixels.
+template<typename ImageTraits, typename Func>
+int modify_rows(Image* image, const gfx::Rect& rc, const int y1, const int y2, Func&& f)
+{
+  using pixel_t = typename ImageTraits::pixel_t;
+  int modified = 0;
+
+  for (int y = y1; y < y2; ++y) {
+    if constexpr (std::is_same_v<ImageTraits, BitmapTraits>) {
+      for (int x = rc.x; x < rc.x2(); ++x) {
+        pixel_t c = get_pixel_fast<BitmapTraits>(image, x, y);
+        if (f(c, x, y)) {
+          put_pixel_fast<BitmapTraits>(image, x, y, c);
+          ++modified;
+        }
+      }
+    }
+    else {
+      auto* p = (pixel_t*)image->getPixelAddress(rc.x, y);
+      for (int x = rc.x; x < rc.x2(); ++x, ++p) {
+        if (f(*p, x, y))
+          ++modified;
+      }
+    }
+  }
+  return modified;
+}
+
+// Calls f(pixel) for each pixel of the rows [y1, y2) of "rc".
+template<typename ImageTraits, typename Func>
+void read_rows(const Image* image, const gfx::Rect& rc, const int y1, const int y2, Func&& f)
+{
+  using pixel_t = typename ImageTraits::pixel_t;
+
+  for (int y = y1; y < y2; ++y) {
+    if constexpr (std::is_same_v<ImageTraits, BitmapTraits>) {
+      for (int x = rc.x; x < rc.x2(); ++x)
+        f(get_pixel_fast<BitmapTraits>(image, x, y));
+    }
+    else {
+      const auto* p = (const pixel_t*)image->getPixelAddress(rc.x, y);
+      for (int x = rc.x; x < rc.x2(); ++x, ++p)
+        f(*p);
+    }
+  }
+}
+
+// Calls Kernel<ImageTraits>::run(args...) depending on the pixel
+// format of the image.
+template<template<typename> class Kernel, typename... Args>
+auto dispatch(const Image* image, Args&&... args)
+{
+  switch (image->pixelFormat()) {
+    case IMAGE_RGB:       return Kernel<RgbTraits>::run(std::forward<Args>(args)...);
+    case IMAGE_GRAYSCALE: return Kernel<GrayscaleTraits>::run(std::forward<Args>(args)...);
+    case IMAGE_INDEXED:   return Kernel<IndexedTraits>::run(std::forward<Args>(args)...);
+    case IMAGE_BITMAP:    return Kernel<BitmapTraits>::run(std::forward<Args>(args)...);
+    case IMAGE_TILEMAP:   return Kernel<TilemapTraits>::run(std::forward<Args>(args)...);
+  }
+  ASSERT(false);
+  return Kernel<RgbTraits>::run(std::forward<Args>(args)...);
+}
+
+template<typename ImageTraits>
+struct MapColors {
+  static int run(Image* image, const gfx::Rect& rc, const ColorTable& table)
+  {
+    using pixel_t = typename ImageTraits::pixel_t;
+    const RowsGroups groups = rows_groups(rc);
+    std::atomic<int> modified(0);
+
+    // For 8-bit images we can convert the table to a plain array.
+    if constexpr (sizeof(pixel_t) == 1) {
+      std::array<int, 256> lut;
+      lut.fill(-1);
+      for (const auto& [from, to] : table) {
+        if (from < 256)
+          lut[from] = pixel_t(to);
+      }
+      for_each_rows_group(rc, groups, [&](int, int y1, int y2) {
+        modified += modify_rows<ImageTraits>(image, rc, y1, y2, [&lut](pixel_t& c, int, int) {
+          const int to = lut[c];
+          if (to < 0 || to == c)
+            return false;
+          c = pixel_t(to);
+          return true;
+        });
+      });
+    }
+    else {
+      for_each_rows_group(rc, groups, [&](int, int y1, int y2) {
+        // Consecutive pixels of the same color are common, so we
+        // remember the last lookup to avoid hashing each pixel.
+        pixel_t last = 0;
+        const color_t* lastTo = nullptr;
+        bool hasLast = false;
+
+        modified += modify_rows<ImageTraits>(image, rc, y1, y2, [&](pixel_t& c, int, int) {
+          if (!hasLast || c != last) {
+            const auto it = table.find(c);
+            last = c;
+            lastTo = (it != table.end() ? &it->second : nullptr);
+            hasLast = true;
+          }
+          if (!lastTo || pixel_t(*lastTo) == c)
+            return false;
+          c = pixel_t(*lastTo);
+          return true;
+        });
+      });
+    }
+    return modified.load();
+  }
+};
+
+template<typename ImageTraits>
+struct ApplyLuts {
+  static void run(Image* image, const gfx::Rect& rc, const ChannelLuts& luts)
+  {
+    using pixel_t = typename ImageTraits::pixel_t;
+
+    std::array<std::array<uint8_t, 256>, 4> tables;
+    const uint8_t* src[4] = { luts.r, luts.g, luts.b, luts.a };
+    for (int i = 0; i < 4; ++i) {
+      for (int v = 0; v < 256; ++v)
+        tables[i][v] = (src[i] ? src[i][v] : uint8_t(v));
+    }
+    const auto& r = tables[0];
+    const auto& g = tables[1];
+    const auto& b = tables[2];
+    const auto& a = tables[3];
+
+    for_each_rows_group(rc, rows_groups(rc), [&](int, int y1, int y2) {
+      modify_rows<ImageTraits>(image, rc, y1, y2, [&](pixel_t& c, int, int) {
+        if constexpr (std::is_same_v<ImageTraits, RgbTraits>) {
+          c = rgba(r[rgba_getr(c)], g[rgba_getg(c)], b[rgba_getb(c)], a[rgba_geta(c)]);
+        }
+        else if constexpr (std::is_same_v<ImageTraits, GrayscaleTraits>) {
+          c = graya(r[graya_getv(c)], a[graya_geta(c)]);
+        }
+        else {
+          c = r[c];
+        }
+        return true;
+      });
+    });
+  }
+};
+
+// Fills "out" with 1 where the pixels of a row of the mask are
+// different from the mask color.
+template<typename MaskTraits>
+void read_mask_row(const Image* mask, const int x, const int y, const int w, uint8_t* out)
+{
+  using pixel_t = typename MaskTraits::pixel_t;
+  const pixel_t maskColor = pixel_t(mask->maskColor());
+
+  if constexpr (std::is_same_v<MaskTraits, BitmapTraits>) {
+    for (int u = 0; u < w; ++u)
+      out[u] = !MaskTraits::same_color(get_pixel_fast<BitmapTraits>(mask, x + u, y), maskColor);
+  }
+  else {
+    const auto* p = (const pixel_t*)mask->getPixelAddress(x, y);
+    for (int u = 0; u < w; ++u, ++p)
+      out[u] = !MaskTraits::same_color(*p, maskColor);
+  }
+}
+
+void read_mask_row(const Image* mask, const int x, const int y, const int w, uint8_t* out)
+{
+  switch (mask->pixelFormat()) {
+    case IMAGE_RGB:       read_mask_row<RgbTraits>(mask, x, y, w, out); break;
+    case IMAGE_GRAYSCALE: read_mask_row<GrayscaleTraits>(mask, x, y, w, out); break;
+    case IMAGE_INDEXED:   read_mask_row<IndexedTraits>(mask, x, y, w, out); break;
+    case IMAGE_BITMAP:    read_mask_row<BitmapTraits>(mask, x, y, w, out); break;
+    case IMAGE_TILEMAP:   read_mask_row<TilemapTraits>(mask, x, y, w, out); break;
+  }
+}
+
+template<typename ImageTraits>
+struct FillMasked {
+  static int run(Image* image, const Image* mask, const gfx::Point& maskOrigin, const color_t color)
+  {
+    using pixel_t = typename ImageTraits::pixel_t;
+    const gfx::Rect rc = image->bounds() & gfx::Rect(maskOrigin, mask->size());
+    if (rc.isEmpty())
+      return 0;
+
+    const pixel_t value = pixel_t(color);
+    std::atomic<int> modified(0);
+
+    for_each_rows_group(rc, rows_groups(rc), [&](int, int y1, int y2) {
+      std::vector<uint8_t> rowMask(rc.w);
+      int n = 0;
+      for (int y = y1; y < y2; ++y) {
+        read_mask_row(mask, rc.x - maskOrigin.x, y - maskOrigin.y, rc.w, rowMask.data());
+        const uint8_t* m = rowMask.data();
+        n += modify_rows<ImageTraits>(image, rc, y, y + 1, [m, &rc, value](pixel_t& c, int x, int) {
+          if (!m[x - rc.x] || c == value)
+            return false;
+          c = value;
+          return true;
+        });
+      }
+      modified += n;
+    });
+    return modified.load();
+  }
+};
+
+template<typename ImageTraits>
+struct CountColors {
+  static void run(const Image* image, const gfx::Rect& rc, ColorCount& result)
+  {
+    using pixel_t = typename ImageTraits::pixel_t;
+    const RowsGroups groups = rows_groups(rc);
+
+    // Dense counters for 8-bit and 16-bit images.
+    if constexpr (sizeof(pixel_t) <= 2) {
+      constexpr int N = (1 << (8 * sizeof(pixel_t)));
+      std::vector<std::vector<int>> partials(groups.count);
+      for_each_rows_group(rc, groups, [&](int i, int y1, int y2) {
+        auto& counts = partials[i];
+        counts.resize(N, 0);
+        read_rows<ImageTraits>(image, rc, y1, y2, [&counts](pixel_t c) { ++counts[c]; });
+      });
+      for (int c = 0; c < N; ++c) {
+        int n = 0;
+        for (const auto& counts : partials)
+          n += counts[c];
+        if (n > 0)
+          result[c] += n;
+      }
+    }
+    else {
+      std::vector<ColorCount> partials(groups.count);
+      for_each_rows_group(rc, groups, [&](int i, int y1, int y2) {
+        auto& counts = partials[i];
+        pixel_t last = 0;
+        int run = 0;
+        read_rows<ImageTraits>(image, rc, y1, y2, [&](pixel_t c) {
+          if (run > 0 && c != last) {
+            counts[last] += run;
+            run = 0;
+          }
+          last = c;
+          ++run;
+        });
+        if (run > 0)
+          counts[last] += run;
+      });
+      for (const auto& counts : partials) {
+        for (const auto& [c, n] : counts)
+          result[c] += n;
+      }
+    }
+  }
+};
+
+template<typename ImageTraits>
+struct CountColor {
+  static int run(const Image* image, const gfx::Rect& rc, const color_t color)
+  {
+    using pixel_t = typename ImageTraits::pixel_t;
+    const pixel_t value = pixel_t(color);
+    std::atomic<int> count(0);
+
+    for_each_rows_group(rc, rows_groups(rc), [&](int, int y1, int y2) {
+      int n = 0;
+      read_rows<ImageTraits>(image, rc, y1, y2, [&n, value](pixel_t c) {
+        if (ImageTraits::same_color(c, value))
+          ++n;
+      });
+      count += n;
+    });
+    return count.load();
+  }
+};
+
+} // anonymous namespace
+
+int map_colors(Image* image, const gfx::Rect& bounds, const ColorTable& table)
+{
+  const gfx::Rect rc = bounds & image->bounds();
+  if (rc.isEmpty() || table.empty())
+    return 0;
+
+  return dispatch<MapColors>(image, image, rc, table);
+}
+
+void apply_channel_luts(Image* image, const gfx::Rect& bounds, const ChannelLuts& luts)
+{
+  ASSERT(image->pixelFormat() == IMAGE_RGB || image->pixelFormat() == IMAGE_GRAYSCALE ||
+         image->pixelFormat() == IMAGE_INDEXED);
+
+  const gfx::Rect rc = bounds & image->bounds();
+  if (rc.isEmpty())
+    return;
+
+  switch (image->pixelFormat()) {
+    case IMAGE_RGB:       ApplyLuts<RgbTraits>::run(image, rc, luts); break;
+    case IMAGE_GRAYSCALE: ApplyLuts<GrayscaleTraits>::run(image, rc, luts); break;
+    case IMAGE_INDEXED:   ApplyLuts<IndexedTraits>::run(image, rc, luts); break;
+    default:              break;
+  }
+}
+
+int fill_masked(Image* image, const Image* mask, const gfx::Point& maskOrigin, const color_t color)
+{
+  ASSERT(mask);
+  if (!mask)
+    return 0;
+
+  return dispatch<FillMasked>(image, image, mask, maskOrigin, color);
+}
+
+void count_colors(const Image* image, const gfx::Rect& bounds, ColorCount& result)
+{
+  const gfx::Rect rc = bounds & image->bounds();
+  if (rc.isEmpty())
+    return;
+
+  dispatch<CountColors>(image, image, rc, result);
+}
+
+int count_color(const Image* image, const gfx::Rect& bounds, const color_t color)
+{
+  const gfx::Rect rc = bounds & image->bounds();
+  if (rc.isEmpty())
+    return 0;
+
+  return dispatch<CountColor>(image, image, rc, color);
+}
+
+}} // namespace doc::algorithm
@@ -0,0 +1,65 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef DOC_ALGORITHM_PIXEL_KERNELS_H_INCLUDED
+#define DOC_ALGORITHM_PIXEL_KERNELS_H_INCLUDED
+#pragma once
+
+#include "doc/color.h"
+#include "gfx/point.h"
+#include "gfx/rect.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+// Bulk operations over all the pixels of a rectangle of an image,
+// used by scripts to avoid a Lua <-> C++ transition per pixel. Rows
+// are read/written directly, and big rectangles are processed by
+// groups of rows from a thread pool.
+
+namespace doc {
+class Image;
+
+namespace algorithm {
+
+using ColorTable = std::unordered_map<color_t, color_t>;
+using ColorCount = std::unordered_map<color_t, int>;
+
+// Lookup tables (256 entries) for each channel of a pixel. A nullptr
+// table keeps the channel as it is. For grayscale images "v" is
+// mapped with the "r" table and the alpha with the "a" table, for
+// indexed images the index is mapped with the "r" table.
+struct ChannelLuts {
+  const uint8_t* r = nullptr;
+  const uint8_t* g = nullptr;
+  const uint8_t* b = nullptr;
+  const uint8_t* a = nullptr;
+};
+
+// Replaces the pixels inside "bounds" that are keys of the "table"
+// with the mapped value. Returns the number of modified pixels.
+int map_colors(Image* image, const gfx::Rect& bounds, const ColorTable& table);
+
+// Maps each channel of the pixels inside "bounds" with the given
+// lookup tables. The image must be RGB, grayscale, or indexed.
+void apply_channel_luts(Image* image, const gfx::Rect& bounds, const ChannelLuts& luts);
+
+// Fills with "color" the pixels of "image" where the "mask" pixels
+// are different from its mask color. "maskOrigin" is the position of
+// the mask in "image" coordinates. Returns the number of modified
+// pixels.
+int fill_masked(Image* image, const Image* mask, const gfx::Point& maskOrigin, color_t color);
+
+// Counts the number of pixels of each color inside "bounds".
+void count_colors(const Image* image, const gfx::Rect& bounds, ColorCount& result);
+
+// Counts the number of pixels inside "bounds" with the given color.
+int count_color(const Image* image, const gfx::Rect& bounds, color_t color);
+
+} // namespace algorithm
+} // namespace doc
+
+#endif
@@ -0,0 +1,127 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "doc/algorithm/pixel_kernels.h"
+#include "doc/image.h"
+#include "doc/image_ref.h"
+#include "doc/primitives.h"
+
+using namespace doc;
+using namespace doc::algorithm;
+
+TEST(PixelKernels, MapColorsRgb)
+{
+  // Big enough to be processed by several threads
+  ImageRef img(Image::create(IMAGE_RGB, 300, 300));
+  for (int y = 0; y < img->height(); ++y)
+    for (int x = 0; x < img->width(); ++x)
+      put_pixel(img.get(), x, y, (x & 1) ? rgba(255, 0, 0, 255) : rgba(0, 0, 255, 255));
+
+  ColorTable table;
+  table[rgba(255, 0, 0, 255)] = rgba(0, 255, 0, 255);
+  EXPECT_EQ(150 * 300, map_colors(img.get(), img->bounds(), table));
+
+  for (int y = 0; y < img->height(); ++y)
+    for (int x = 0; x < img->width(); ++x)
+      ASSERT_EQ((x & 1) ? rgba(0, 255, 0, 255) : rgba(0, 0, 255, 255), get_pixel(img.get(), x, y));
+
+  // Only inside the given bounds
+  table.clear();
+  table[rgba(0, 0, 255, 255)] = rgba(0, 0, 0, 0);
+  EXPECT_EQ(2, map_colors(img.get(), gfx::Rect(-2, 0, 6, 1), table));
+  EXPECT_EQ(rgba(0, 0, 0, 0), get_pixel(img.get(), 0, 0));
+  EXPECT_EQ(rgba(0, 0, 0, 0), get_pixel(img.get(), 2, 0));
+  EXPECT_EQ(rgba(0, 0, 255, 255), get_pixel(img.get(), 4, 0));
+}
+
+TEST(PixelKernels, MapColorsIndexed)
+{
+  ImageRef img(Image::create(IMAGE_INDEXED, 4, 1));
+  put_pixel(img.get(), 0, 0, 1);
+  put_pixel(img.get(), 1, 0, 2);
+  put_pixel(img.get(), 2, 0, 3);
+  put_pixel(img.get(), 3, 0, 1);
+
+  ColorTable table;
+  table[1] = 3;
+  table[3] = 1;
+  EXPECT_EQ(3, map_colors(img.get(), img->bounds(), table));
+  EXPECT_EQ(3, get_pixel(img.get(), 0, 0));
+  EXPECT_EQ(2, get_pixel(img.get(), 1, 0));
+  EXPECT_EQ(1, get_pixel(img.get(), 2, 0));
+  EXPECT_EQ(3, get_pixel(img.get(), 3, 0));
+}
+
+TEST(PixelKernels, ApplyChannelLuts)
+{
+  uint8_t invert[256];
+  for (int i = 0; i < 256; ++i)
+    invert[i] = 255 - i;
+
+  ChannelLuts luts;
+  luts.r = invert;
+  luts.b = invert;
+
+  ImageRef img(Image::create(IMAGE_RGB, 2, 1));
+  put_pixel(img.get(), 0, 0, rgba(0, 10, 20, 30));
+  put_pixel(img.get(), 1, 0, rgba(255, 128, 0, 255));
+  apply_channel_luts(img.get(), img->bounds(), luts);
+  EXPECT_EQ(rgba(255, 10, 235, 30), get_pixel(img.get(), 0, 0));
+  EXPECT_EQ(rgba(0, 128, 255, 255), get_pixel(img.get(), 1, 0));
+
+  ImageRef gray(Image::create(IMAGE_GRAYSCALE, 1, 1));
+  put_pixel(gray.get(), 0, 0, graya(10, 20));
+  luts.a = invert;
+  apply_channel_luts(gray.get(), gray->bounds(), luts);
+  EXPECT_EQ(graya(245, 235), get_pixel(gray.get(), 0, 0));
+}
+
+TEST(PixelKernels, FillMasked)
+{
+  ImageRef img(Image::create(IMAGE_INDEXED, 4, 4));
+  img->clear(0);
+
+  ImageRef mask(Image::create(IMAGE_BITMAP, 2, 2));
+  mask->clear(0);
+  put_pixel(mask.get(), 0, 0, 1);
+  put_pixel(mask.get(), 1, 1, 1);
+
+  EXPECT_EQ(2, fill_masked(img.get(), mask.get(), gfx::Point(1, 1), 5));
+  EXPECT_EQ(5, get_pixel(img.get(), 1, 1));
+  EXPECT_EQ(5, get_pixel(img.get(), 2, 2));
+  EXPECT_EQ(0, get_pixel(img.get(), 2, 1));
+  EXPECT_EQ(0, get_pixel(img.get(), 1, 2));
+
+  // Mask partially outside the image
+  EXPECT_EQ(1, fill_masked(img.get(), mask.get(), gfx::Point(-1, -1), 7));
+  EXPECT_EQ(7, get_pixel(img.get(), 0, 0));
+}
+
+TEST(PixelKernels, CountColors)
+{
+  ImageRef img(Image::create(IMAGE_RGB, 300, 300));
+  img->clear(rgba(0, 0, 0, 255));
+  fill_rect(img.get(), gfx::Rect(0, 0, 10, 300), rgba(255, 255, 255, 255));
+
+  ColorCount counts;
+  count_colors(img.get(), img->bounds(), counts);
+  EXPECT_EQ(2u, counts.size());
+  EXPECT_EQ(10 * 300, counts[rgba(255, 255, 255, 255)]);
+  EXPECT_EQ(290 * 300, counts[rgba(0, 0, 0, 255)]);
+
+  EXPECT_EQ(10 * 300, count_color(img.get(), img->bounds(), rgba(255, 255, 255, 255)));
+  EXPECT_EQ(5, count_color(img.get(), gfx::Rect(5, 0, 10, 1), rgba(255, 255, 255, 255)));
+
+  ImageRef gray(Image::create(IMAGE_GRAYSCALE, 3, 1));
+  gray->clear(graya(1, 255));
+  put_pixel(gray.get(), 2, 0, graya(2, 255));
+  counts.clear();
+  count_colors(gray.get(), gray->bounds(), counts);
+  EXPECT_EQ(2, counts[graya(1, 255)]);
+  EXPECT_EQ(1, counts[graya(2, 255)]);
+}
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2019-2025  Igara Studio S.A.
+// Copyright (c) 2019-2026  Igara Studio S.A.
 // Copyright (c) 2001-2018 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -16,31 +16,345 @@
 #include "doc/palette.h"
 #include "doc/primitives_fast.h"
 #include "doc/rgbmap.h"
+#include "doc/task_group.h"
 #include "gfx/point.h"
+#include "tracing/tracing.h"
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_WIN64)
+  #include <emmintrin.h>
+  #define DOC_USE_SSE2_RESIZE_IMAGE 1
+#else
+  #define DOC_USE_SSE2_RESIZE_IMAGE 0
+#endif
 
 namespace doc { namespace algorithm {
 
+namespace {
+
+// Minimum number of pixels of the destination image to resize its
+// rows from several threads.
+constexpr int kParallelMinArea = 256 * 256;
+
+// Calls resizeRows(y1, y2) for groups of rows of the destination
+// image. Each group is resized in a different task of the pool if
+// "parallel" is true and the image is big enough.
+template<typename Func>
+void for_each_rows_group(const Image* dst, const bool parallel, Func&& resizeRows)
+{
+  const int h = dst->height();
+  const int nthreads = task_threads();
+  if (!parallel || nthreads < 2 || dst->width() * h < kParallelMinArea) {
+    resizeRows(0, h);
+    return;
+  }
+
+  // Each task writes different rows of the destination image.
+  const int rowsPerTask = std::max(1, (h + nthreads * 4 - 1) / (nthreads * 4));
+  TaskGroup tasks;
+  for (int y = 0; y < h; y += rowsPerTask) {
+    const int y2 = std::min(y + rowsPerTask, h);
+    tasks.run([&resizeRows, y, y2] {
+      TRACING_SCOPE("resize_image task");
+      resizeRows(y, y2);
+    });
+  }
+  tasks.wait();
+}
+
+// Source coordinates of each destination column (or row) for the
+// nearest neighbor method.
+std::vector<int> nearest_coords(const int srcSize, const int dstSize)
+{
+  const double ratio = double(srcSize) / double(dstSize);
+  std::vector<int> coords(dstSize);
+  for (int i = 0; i < dstSize; ++i)
+    coords[i] = int(std::floor(i * ratio));
+  return coords;
+}
+
 template<typename ImageTraits>
-void resize_image_nearest(const Image* src, Image* dst)
+void resize_image_nearest_rows(const Image* src,
+                               Image* dst,
+                               const std::vector<int>& srcX,
+                               const std::vector<int>& srcY,
+                               const int y1,
+                               const int y2)
+{
+  using pixel_t = typename ImageTraits::pixel_t;
+  const int w = dst->width();
+
+  for (int y = y1; y < y2; ++y) {
+    const auto* srcRow = (const pixel_t*)src->getPixelAddress(0, srcY[y]);
+    auto* dstRow = (pixel_t*)dst->getPixelAddress(0, y);
+    for (int x = 0; x < w; ++x)
+      dstRow[x] = srcRow[srcX[x]];
+  }
+}
+
+template<>
+void resize_image_nearest_rows<BitmapTraits>(const Image* src,
+                                             Image* dst,
+                                             const std::vector<int>& srcX,
+                                             const std::vector<int>& srcY,
+                                             const int y1,
+                                             const int y2)
+{
+  const int w = dst->width();
+
+  for (int y = y1; y < y2; ++y) {
+    for (int x = 0; x < w; ++x)
+      put_pixel_fast<BitmapTraits>(dst, x, y, get_pixel_fast<BitmapTraits>(src, srcX[x], srcY[y]));
+  }
+}
+
+// Source coordinates and weight of each destination column (or row)
+// for the bilinear method.
+struct BilinearCoord {
+  int i1, i2; // The two source pixels to interpolate
+  double t1;  // Weight of i2 (the weight of i1 is 1-t1)
+};
+
+// The coordinates are accumulated in the same way the old per-pixel
+// loop did, so the weights are exactly the same.
+std::vector<BilinearCoord> bilinear_coords(const int srcSize, const int dstSize)
+{
+  std::vector<BilinearCoord> coords(dstSize);
+  const double du = (srcSize - 1) * 1.0 / (dstSize - 1);
+  double u = 0.0;
+  for (int i = 0; i < dstSize; ++i, u += du) {
+    int i1 = (int)std::floor(u);
+    int i2;
+    if (i1 > srcSize - 1) {
+      i1 = srcSize - 1;
+      i2 = srcSize - 1;
+    }
+    else if (i1 == srcSize - 1)
+      i2 = i1;
+    else
+      i2 = i1 + 1;
+    coords[i] = BilinearCoord{ i1, i2, u - i1 };
+  }
+  return coords;
+}
+
+// Interpolates the RGBA components of the four colors.
+inline void bilinear_rgba(const color_t c0,
+                          const color_t c1,
+                          const color_t c2,
+                          const color_t c3,
+                          const double u1,
+                          const double v1,
+                          int& r,
+                          int& g,
+                          int& b,
+                          int& a)
+{
+  const double u2 = 1 - u1;
+  const double v2 = 1 - v1;
+
+#if DOC_USE_SSE2_RESIZE_IMAGE
+  // RG and BA channels in two registers of doubles, with the same
+  // operations (and rounding) of the scalar version.
+  const __m128i zero = _mm_setzero_si128();
+  auto rg_ba = [zero](const color_t c, __m128d& rg, __m128d& ba) {
+    const __m128i v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(int(c)), zero),
+                                         zero);
+    rg = _mm_cvtepi32_pd(v);
+    ba = _mm_cvtepi32_pd(_mm_srli_si128(v, 8));
+  };
+
+  __m128d rg0, ba0, rg1, ba1, rg2, ba2, rg3, ba3;
+  rg_ba(c0, rg0, ba0);
+  rg_ba(c1, rg1, ba1);
+  rg_ba(c2, rg2, ba2);
+  rg_ba(c3, rg3, ba3);
+
+  const __m128d U1 = _mm_set1_pd(u1);
+  const __m128d U2 = _mm_set1_pd(u2);
+  const __m128d V1 = _mm_set1_pd(v1);
+  const __m128d V2 = _mm_set1_pd(v2);
+  auto interpolate = [&](const __m128d p0, const __m128d p1, const __m128d p2, const __m128d p3) {
+    return _mm_cvttpd_epi32(
+      _mm_add_pd(_mm_mul_pd(_mm_add_pd(_mm_mul_pd(p0, U2), _mm_mul_pd(p1, U1)), V2),
+                 _mm_mul_pd(_mm_add_pd(_mm_mul_pd(p2, U2), _mm_mul_pd(p3, U1)), V1)));
+  };
+
+  const __m128i rg = interpolate(rg0, rg1, rg2, rg3);
+  const __m128i ba = interpolate(ba0, ba1, ba2, ba3);
+  r = _mm_cvtsi128_si32(rg);
+  g = _mm_cvtsi128_si32(_mm_srli_si128(rg, 4));
+  b = _mm_cvtsi128_si32(ba);
+  a = _mm_cvtsi128_si32(_mm_srli_si128(ba, 4));
+#else
+  r = int((rgba_getr(c0) * u2 + rgba_getr(c1) * u1) * v2 +
+          (rgba_getr(c2) * u2 + rgba_getr(c3) * u1) * v1);
+  g = int((rgba_getg(c0) * u2 + rgba_getg(c1) * u1) * v2 +
+          (rgba_getg(c2) * u2 + rgba_getg(c3) * u1) * v1);
+  b = int((rgba_getb(c0) * u2 + rgba_getb(c1) * u1) * v2 +
+          (rgba_getb(c2) * u2 + rgba_getb(c3) * u1) * v1);
+  a = int((rgba_geta(c0) * u2 + rgba_geta(c1) * u1) * v2 +
+          (rgba_geta(c2) * u2 + rgba_geta(c3) * u1) * v1);
+#endif
+}
+
+template<typename ImageTraits>
+void resize_image_bilinear_rows(const Image* src,
+                                Image* dst,
+                                const std::vector<BilinearCoord>& xs,
+                                const std::vector<BilinearCoord>& ys,
+                                const Palette* pal,
+                                const RgbMap* rgbmap,
+                                const color_t maskColor,
+                                const int y1,
+                                const int y2);
+
+template<>
+void resize_image_bilinear_rows<RgbTraits>(const Image* src,
+                                           Image* dst,
+                                           const std::vector<BilinearCoord>& xs,
+                                           const std::vector<BilinearCoord>& ys,
+                                           const Palette*,
+                                           const RgbMap*,
+                                           const color_t,
+                                           const int y1,
+                                           const int y2)
 {
-  double x_ratio = double(src->width()) / double(dst->width());
-  double y_ratio = double(src->height()) / double(dst->height());
-  double px, py;
-
-  LockImageBits<ImageTraits> dstBits(dst);
-  auto dstIt = dstBits.begin();
-
-  for (int y = 0; y < dst->height(); ++y) {
-    py = std::floor(y * y_ratio);
-    for (int x = 0; x < dst->width(); ++x, ++dstIt) {
-      px = std::floor(x * x_ratio);
-      *dstIt = get_pixel_fast<ImageTraits>(src, int(px), int(py));
+  const int w = dst->width();
+  int r, g, b, a;
+
+  for (int y = y1; y < y2; ++y) {
+    const BilinearCoord& v = ys[y];
+    const auto* row1 = (const RgbTraits::pixel_t*)src->getPixelAddress(0, v.i1);
+    const auto* row2 = (const RgbTraits::pixel_t*)src->getPixelAddress(0, v.i2);
+    auto* dstRow = (RgbTraits::pixel_t*)dst->getPixelAddress(0, y);
+
+    for (int x = 0; x < w; ++x) {
+      const BilinearCoord& u = xs[x];
+      bilinear_rgba(row1[u.i1], row1[u.i2], row2[u.i1], row2[u.i2], u.t1, v.t1, r, g, b, a);
+      dstRow[x] = rgba(r, g, b, a);
     }
   }
 }
 
+template<>
+void resize_image_bilinear_rows<GrayscaleTraits>(const Image* src,
+                                                 Image* dst,
+                                                 const std::vector<BilinearCoord>& xs,
+                                                 const std::vector<BilinearCoord>& ys,
+                                                 const Palette*,
+                                                 const RgbMap*,
+                                                 const color_t,
+                                                 const int y1,
+                                                 const int y2)
+{
+  const int w = dst->width();
+  color_t color[4];
+
+  for (int y = y1; y < y2; ++y) {
+    const BilinearCoord& v = ys[y];
+    const auto* row1 = (const GrayscaleTraits::pixel_t*)src->getPixelAddress(0, v.i1);
+    const auto* row2 = (const GrayscaleTraits::pixel_t*)src->getPixelAddress(0, v.i2);
+    auto* dstRow = (GrayscaleTraits::pixel_t*)dst->getPixelAddress(0, y);
+    const double v1 = v.t1;
+    const double v2 = 1 - v1;
+
+    for (int x = 0; x < w; ++x) {
+      const BilinearCoord& u = xs[x];
+      const double u1 = u.t1;
+      const double u2 = 1 - u1;
+      color[0] = row1[u.i1];
+      color[1] = row1[u.i2];
+      color[2] = row2[u.i1];
+      color[3] = row2[u.i2];
+
+      const int k = int((graya_getv(color[0]) * u2 + graya_getv(color[1]) * u1) * v2 +
+                        (graya_getv(color[2]) * u2 + graya_getv(color[3]) * u1) * v1);
+      const int a = int((graya_geta(color[0]) * u2 + graya_geta(color[1]) * u1) * v2 +
+                        (graya_geta(color[2]) * u2 + graya_geta(color[3]) * u1) * v1);
+      dstRow[x] = graya(k, a);
+    }
+  }
+}
+
+template<>
+void resize_image_bilinear_rows<IndexedTraits>(const Image* src,
+                                               Image* dst,
+                                               const std::vector<BilinearCoord>& xs,
+                                               const std::vector<BilinearCoord>& ys,
+                                               const Palette* pal,
+                                               const RgbMap* rgbmap,
+                                               const color_t maskColor,
+                                               const int y1,
+                                               const int y2)
+{
+  const int w = dst->width();
+  color_t color[4];
+  int r, g, b, a;
+
+  // Convert index to RGBA values (alpha = 0 for the mask color)
+  auto entry = [pal, maskColor](const color_t i) -> color_t {
+    if (i == maskColor)
+      return pal->getEntry(i) & rgba_rgb_mask;
+    return pal->getEntry(i);
+  };
+
+  for (int y = y1; y < y2; ++y) {
+    const BilinearCoord& v = ys[y];
+    const auto* row1 = (const IndexedTraits::pixel_t*)src->getPixelAddress(0, v.i1);
+    const auto* row2 = (const IndexedTraits::pixel_t*)src->getPixelAddress(0, v.i2);
+    auto* dstRow = (IndexedTraits::pixel_t*)dst->getPixelAddress(0, y);
+
+    for (int x = 0; x < w; ++x) {
+      const BilinearCoord& u = xs[x];
+      color[0] = entry(row1[u.i1]);
+      color[1] = entry(row1[u.i2]);
+      color[2] = entry(row2[u.i1]);
+      color[3] = entry(row2[u.i2]);
+
+      bilinear_rgba(color[0], color[1], color[2], color[3], u.t1, v.t1, r, g, b, a);
+      dstRow[x] = rgbmap->mapColor(r, g, b, a);
+    }
+  }
+}
+
+} // anonymous namespace
+
+template<typename ImageTraits>
+void resize_image_nearest(const Image* src, Image* dst)
+{
+  const std::vector<int> srcX = nearest_coords(src->width(), dst->width());
+  const std::vector<int> srcY = nearest_coords(src->height(), dst->height());
+
+  for_each_rows_group(dst, true, [src, dst, &srcX, &srcY](const int y1, const int y2) {
+    resize_image_nearest_rows<ImageTraits>(src, dst, srcX, srcY, y1, y2);
+  });
+}
+
+template<typename ImageTraits>
+void resize_image_bilinear(const Image* src,
+                           Image* dst,
+                           const Palette* pal,
+                           const RgbMap* rgbmap,
+                           const color_t maskColor)
+{
+  const std::vector<BilinearCoord> xs = bilinear_coords(src->width(), dst->width());
+  const std::vector<BilinearCoord> ys = bilinear_coords(src->height(), dst->height());
+
+  // Some RgbMap implementations (e.g. OctreeMap or RgbMapRGB5A3)
+  // calculate their entries lazily in mapColor(), so they cannot be
+  // used from several threads at the same time.
+  const bool parallel = (ImageTraits::pixel_format != IMAGE_INDEXED ||
+                         rgbmap->rgbmapAlgorithm() == RgbMapAlgorithm::PRECOMPUTED);
+
+  for_each_rows_group(dst, parallel, [&](const int y1, const int y2) {
+    resize_image_bilinear_rows<ImageTraits>(src, dst, xs, ys, pal, rgbmap, maskColor, y1, y2);
+  });
+}
+
 void resize_image(Image* src,
                   Image* dst,
                   const ResizeMethod method,
@@ -54,7 +368,6 @@ void resize_image(Image* src,
     fixup_image_transparent_colors(src);
 
   switch (method) {
-    // TODO optimize this
     case RESIZE_METHOD_NEAREST_NEIGHBOR: {
       ASSERT(src->pixelFormat() == dst->pixelFormat());
 
@@ -67,14 +380,7 @@ void resize_image(Image* src,
       break;
     }
 
-    // TODO optimize this
     case RESIZE_METHOD_BILINEAR: {
-      uint32_t color[4], dst_color = 0;
-      double u, v, du, dv;
-      int u_floor, u_floor2;
-      int v_floor, v_floor2;
-      int x, y;
-
       // We cannot do interpolations between RGB values on indexed
       // images without a palette/rgbmap.
       if (dst->pixelFormat() == IMAGE_INDEXED && (!pal || !rgbmap)) {
@@ -82,92 +388,16 @@ void resize_image(Image* src,
         return;
       }
 
-      u = v = 0.0;
-      du = (src->width() - 1) * 1.0 / (dst->width() - 1);
-      dv = (src->height() - 1) * 1.0 / (dst->height() - 1);
-      for (y = 0; y < dst->height(); ++y) {
-        for (x = 0; x < dst->width(); ++x) {
-          u_floor = (int)std::floor(u);
-          v_floor = (int)std::floor(v);
-
-          if (u_floor > src->width() - 1) {
-            u_floor = src->width() - 1;
-            u_floor2 = src->width() - 1;
-          }
-          else if (u_floor == src->width() - 1)
-            u_floor2 = u_floor;
-          else
-            u_floor2 = u_floor + 1;
-
-          if (v_floor > src->height() - 1) {
-            v_floor = src->height() - 1;
-            v_floor2 = src->height() - 1;
-          }
-          else if (v_floor == src->height() - 1)
-            v_floor2 = v_floor;
-          else
-            v_floor2 = v_floor + 1;
-
-          // get the four colors
-          color[0] = src->getPixel(u_floor, v_floor);
-          color[1] = src->getPixel(u_floor2, v_floor);
-          color[2] = src->getPixel(u_floor, v_floor2);
-          color[3] = src->getPixel(u_floor2, v_floor2);
-
-          // calculate the interpolated color
-          double u1 = u - u_floor;
-          double v1 = v - v_floor;
-          double u2 = 1 - u1;
-          double v2 = 1 - v1;
-
-          switch (dst->pixelFormat()) {
-            case IMAGE_RGB: {
-              int r = int((rgba_getr(color[0]) * u2 + rgba_getr(color[1]) * u1) * v2 +
-                          (rgba_getr(color[2]) * u2 + rgba_getr(color[3]) * u1) * v1);
-              int g = int((rgba_getg(color[0]) * u2 + rgba_getg(color[1]) * u1) * v2 +
-                          (rgba_getg(color[2]) * u2 + rgba_getg(color[3]) * u1) * v1);
-              int b = int((rgba_getb(color[0]) * u2 + rgba_getb(color[1]) * u1) * v2 +
-                          (rgba_getb(color[2]) * u2 + rgba_getb(color[3]) * u1) * v1);
-              int a = int((rgba_geta(color[0]) * u2 + rgba_geta(color[1]) * u1) * v2 +
-                          (rgba_geta(color[2]) * u2 + rgba_geta(color[3]) * u1) * v1);
-              dst_color = rgba(r, g, b, a);
-              break;
-            }
-            case IMAGE_GRAYSCALE: {
-              int v = int((graya_getv(color[0]) * u2 + graya_getv(color[1]) * u1) * v2 +
-                          (graya_getv(color[2]) * u2 + graya_getv(color[3]) * u1) * v1);
-              int a = int((graya_geta(color[0]) * u2 + graya_geta(color[1]) * u1) * v2 +
-                          (graya_geta(color[2]) * u2 + graya_geta(color[3]) * u1) * v1);
-              dst_color = graya(v, a);
-              break;
-            }
-            case IMAGE_INDEXED: {
-              // Convert index to RGBA values
-              for (int i = 0; i < 4; ++i) {
-                if (color[i] == maskColor)
-                  color[i] = pal->getEntry(color[i]) & rgba_rgb_mask; // Set alpha = 0
-                else
-                  color[i] = pal->getEntry(color[i]);
-              }
-
-              int r = int((rgba_getr(color[0]) * u2 + rgba_getr(color[1]) * u1) * v2 +
-                          (rgba_getr(color[2]) * u2 + rgba_getr(color[3]) * u1) * v1);
-              int g = int((rgba_getg(color[0]) * u2 + rgba_getg(color[1]) * u1) * v2 +
-                          (rgba_getg(color[2]) * u2 + rgba_getg(color[3]) * u1) * v1);
-              int b = int((rgba_getb(color[0]) * u2 + rgba_getb(color[1]) * u1) * v2 +
-                          (rgba_getb(color[2]) * u2 + rgba_getb(color[3]) * u1) * v1);
-              int a = int((rgba_geta(color[0]) * u2 + rgba_geta(color[1]) * u1) * v2 +
-                          (rgba_geta(color[2]) * u2 + rgba_geta(color[3]) * u1) * v1);
-              dst_color = rgbmap->mapColor(r, g, b, a);
-              break;
-            }
-          }
-
-          dst->putPixel(x, y, dst_color);
-          u += du;
-        }
-        u = 0.0;
-        v += dv;
+      switch (dst->pixelFormat()) {
+        case IMAGE_RGB:
+          resize_image_bilinear<RgbTraits>(src, dst, pal, rgbmap, maskColor);
+          break;
+        case IMAGE_GRAYSCALE:
+          resize_image_bilinear<GrayscaleTraits>(src, dst, pal, rgbmap, maskColor);
+          break;
+        case IMAGE_INDEXED:
+          resize_image_bilinear<IndexedTraits>(src, dst, pal, rgbmap, maskColor);
+          break;
       }
       break;
     }
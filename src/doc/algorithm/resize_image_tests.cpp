@@ -0,0 +1,80 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "doc/algorithm/resize_image.h"
+#include "doc/image.h"
+#include "doc/image_ref.h"
+#include "doc/primitives.h"
+
+#include <cmath>
+
+using namespace doc;
+using namespace doc::algorithm;
+
+TEST(ResizeImage, NearestNeighbor)
+{
+  // Big enough to be resized by several threads
+  ImageRef src(Image::create(IMAGE_RGB, 301, 207));
+  for (int y = 0; y < src->height(); ++y)
+    for (int x = 0; x < src->width(); ++x)
+      put_pixel(src.get(), x, y, rgba(x & 0xff, y & 0xff, (x + y) & 0xff, 255));
+
+  ImageRef dst(Image::create(IMAGE_RGB, 713, 451));
+  resize_image(src.get(), dst.get(), RESIZE_METHOD_NEAREST_NEIGHBOR, nullptr, nullptr, 0);
+
+  const double xRatio = double(src->width()) / double(dst->width());
+  const double yRatio = double(src->height()) / double(dst->height());
+  for (int y = 0; y < dst->height(); ++y) {
+    for (int x = 0; x < dst->width(); ++x) {
+      const int u = int(std::floor(x * xRatio));
+      const int v = int(std::floor(y * yRatio));
+      ASSERT_EQ(get_pixel(src.get(), u, v), get_pixel(dst.get(), x, y)) << x << "," << y;
+    }
+  }
+}
+
+TEST(ResizeImage, NearestNeighborBitmap)
+{
+  ImageRef src(Image::create(IMAGE_BITMAP, 3, 2));
+  clear_image(src.get(), 0);
+  put_pixel(src.get(), 1, 0, 1);
+  put_pixel(src.get(), 2, 1, 1);
+
+  ImageRef dst(Image::create(IMAGE_BITMAP, 6, 4));
+  resize_image(src.get(), dst.get(), RESIZE_METHOD_NEAREST_NEIGHBOR, nullptr, nullptr, 0);
+
+  for (int y = 0; y < 4; ++y)
+    for (int x = 0; x < 6; ++x)
+      EXPECT_EQ(get_pixel(src.get(), x / 2, y / 2), get_pixel(dst.get(), x, y)) << x << "," << y;
+}
+
+TEST(ResizeImage, Bilinear)
+{
+  ImageRef src(Image::create(IMAGE_RGB, 2, 2));
+  put_pixel(src.get(), 0, 0, rgba(0, 0, 0, 255));
+  put_pixel(src.get(), 1, 0, rgba(200, 0, 0, 255));
+  put_pixel(src.get(), 0, 1, rgba(0, 100, 0, 255));
+  put_pixel(src.get(), 1, 1, rgba(200, 100, 40, 255));
+
+  ImageRef dst(Image::create(IMAGE_RGB, 3, 3));
+  resize_image(src.get(), dst.get(), RESIZE_METHOD_BILINEAR, nullptr, nullptr, 0);
+
+  EXPECT_EQ(rgba(0, 0, 0, 255), get_pixel(dst.get(), 0, 0));
+  EXPECT_EQ(rgba(100, 0, 0, 255), get_pixel(dst.get(), 1, 0));
+  EXPECT_EQ(rgba(200, 0, 0, 255), get_pixel(dst.get(), 2, 0));
+  EXPECT_EQ(rgba(0, 50, 0, 255), get_pixel(dst.get(), 0, 1));
+  EXPECT_EQ(rgba(100, 50, 10, 255), get_pixel(dst.get(), 1, 1));
+  EXPECT_EQ(rgba(200, 100, 40, 255), get_pixel(dst.get(), 2, 2));
+
+  ImageRef gray(Image::create(IMAGE_GRAYSCALE, 2, 1));
+  put_pixel(gray.get(), 0, 0, graya(10, 255));
+  put_pixel(gray.get(), 1, 0, graya(30, 255));
+  ImageRef grayDst(Image::create(IMAGE_GRAYSCALE, 3, 1));
+  resize_image(gray.get(), grayDst.get(), RESIZE_METHOD_BILINEAR, nullptr, nullptr, 0);
+  EXPECT_EQ(graya(20, 255), get_pixel(grayDst.get(), 1, 0));
+}
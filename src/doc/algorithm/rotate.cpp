@@ -29,7 +29,9 @@ static void ase_parallelogram_map_standard(Image* bmp,
                                            const Image* sprite,
                                            const Image* mask,
                                            fixed xs[4],
-                                           fixed ys[4]);
+                                           fixed ys[4],
+                                           int rows_y1,
+                                           int rows_y2);
 
 static void ase_rotate_scale_flip_coordinates(fixed w,
                                               fixed h,
@@ -217,7 +219,7 @@ void rotate_image(Image* dst,
                                     xs,
                                     ys);
 
-  ase_parallelogram_map_standard(dst, src, nullptr, xs, ys);
+  ase_parallelogram_map_standard(dst, src, nullptr, xs, ys, 0, dst->height());
 }
 
 /*    1-----2
@@ -235,6 +237,23 @@ void parallelogram(Image* bmp,
                    int y3,
                    int x4,
                    int y4)
+{
+  parallelogram_rows(bmp, sprite, mask, x1, y1, x2, y2, x3, y3, x4, y4, 0, bmp->height());
+}
+
+void parallelogram_rows(Image* bmp,
+                        const Image* sprite,
+                        const Image* mask,
+                        int x1,
+                        int y1,
+                        int x2,
+                        int y2,
+                        int x3,
+                        int y3,
+                        int x4,
+                        int y4,
+                        int rows_y1,
+                        int rows_y2)
 {
   fixed xs[4], ys[4];
 
@@ -247,7 +266,7 @@ void parallelogram(Image* bmp,
   xs[3] = itofix(x4);
   ys[3] = itofix(y4);
 
-  ase_parallelogram_map_standard(bmp, sprite, mask, xs, ys);
+  ase_parallelogram_map_standard(bmp, sprite, mask, xs, ys, rows_y1, rows_y2);
 }
 
 // Scanline drawers.
@@ -423,6 +442,8 @@ static void ase_parallelogram_map(Image* bmp,
                                   fixed xs[4],
                                   fixed ys[4],
                                   int sub_pixel_accuracy,
+                                  int rows_y1,
+                                  int rows_y2,
                                   Delegate delegate)
 {
   /* Index in xs[] and ys[] to topmost point. */
@@ -543,6 +564,13 @@ static void ase_parallelogram_map(Image* bmp,
   if (clip_bottom_i > bmp->height())
     clip_bottom_i = bmp->height();
 
+  /* Only the scanlines in the [rows_y1, rows_y2) range are drawn, but
+     we have to walk from the first scanline anyway so the incremental
+     edges are exactly the same (and different ranges can be drawn from
+     different threads). */
+  if (clip_bottom_i > rows_y2)
+    clip_bottom_i = rows_y2;
+
   /* Calculate y coordinate of first scanline. */
   if (sub_pixel_accuracy)
     bmp_y_i = top_bmp_y >> 16;
@@ -656,6 +684,10 @@ static void ase_parallelogram_map(Image* bmp,
       r_bmp_y_bottom_i = clip_bottom_i;
     }
 
+    /* Scanline above the range that we have to draw. */
+    if (bmp_y_i < rows_y1)
+      goto skip_draw;
+
     /* Make left bmp coordinate be an integer and clip it. */
     if (sub_pixel_accuracy)
       l_bmp_x_rounded = l_bmp_x;
@@ -804,12 +836,22 @@ static void ase_parallelogram_map_standard(Image* bmp,
                                            const Image* sprite,
                                            const Image* mask,
                                            fixed xs[4],
-                                           fixed ys[4])
+                                           fixed ys[4],
+                                           int rows_y1,
+                                           int rows_y2)
 {
   switch (bmp->pixelFormat()) {
     case IMAGE_RGB: {
       RgbDelegate delegate(sprite->maskColor());
-      ase_parallelogram_map<RgbTraits, RgbDelegate>(bmp, sprite, mask, xs, ys, false, delegate);
+      ase_parallelogram_map<RgbTraits, RgbDelegate>(bmp,
+                                                    sprite,
+                                                    mask,
+                                                    xs,
+                                                    ys,
+                                                    false,
+                                                    rows_y1,
+                                                    rows_y2,
+                                                    delegate);
       break;
     }
 
@@ -821,6 +863,8 @@ static void ase_parallelogram_map_standard(Image* bmp,
                                                                 xs,
                                                                 ys,
                                                                 false,
+                                                                rows_y1,
+                                                                rows_y2,
                                                                 delegate);
       break;
     }
@@ -833,6 +877,8 @@ static void ase_parallelogram_map_standard(Image* bmp,
                                                             xs,
                                                             ys,
                                                             false,
+                                                            rows_y1,
+                                                            rows_y2,
                                                             delegate);
       break;
     }
@@ -845,6 +891,8 @@ static void ase_parallelogram_map_standard(Image* bmp,
                                                           xs,
                                                           ys,
                                                           false,
+                                                          rows_y1,
+                                                          rows_y2,
                                                           delegate);
       break;
     }
@@ -857,6 +905,8 @@ static void ase_parallelogram_map_standard(Image* bmp,
                                                             xs,
                                                             ys,
                                                             false,
+                                                            rows_y1,
+                                                            rows_y2,
                                                             delegate);
       break;
     }
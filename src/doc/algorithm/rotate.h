@@ -46,6 +46,24 @@ void parallelogram(Image* dst,
                    int x4,
                    int y4);
 
+// Same as parallelogram() but only draws the scanlines of "dst" in
+// the [rows_y1, rows_y2) range. The result is the same as drawing the
+// whole parallelogram, so different ranges can be drawn from
+// different threads.
+void parallelogram_rows(Image* dst,
+                        const Image* src,
+                        const Image* mask,
+                        int x1,
+                        int y1,
+                        int x2,
+                        int y2,
+                        int x3,
+                        int y3,
+                        int x4,
+                        int y4,
+                        int rows_y1,
+                        int rows_y2);
+
 } // namespace algorithm
 } // namespace doc
 
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2020-2023  Igara Studio S.A.
+// Copyright (c) 2020-2026  Igara Studio S.A.
 // Copyright (c) 2001-2018 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -9,151 +9,144 @@
   #include "config.h"
 #endif
 
+#include "doc/algorithm/rotsprite.h"
+
 #include "doc/algorithm/rotate.h"
 #include "doc/image.h"
 #include "doc/primitives.h"
+#include "doc/primitives_fast.h"
+#include "doc/task_group.h"
+#include "tracing/tracing.h"
 
 #include <algorithm>
+#include <functional>
 #include <memory>
+#include <string_view>
 
 namespace doc { namespace algorithm {
 
+namespace {
+
+// Minimum number of pixels of the destination image to process its
+// rows from several threads.
+constexpr int kParallelMinArea = 256 * 256;
+
+// Upscaled images kept by each RotSprite engine (the source image,
+// its mask, and the mask itself when it's the source to rotate, as
+// PixelsMovement does to transform the selection).
+constexpr int kMaxCachedImages = 3;
+
+// Calls processRows(y1, y2) for groups of the "h" rows. Each group
+// is processed in a different task of the pool when the destination
+// area (dstArea) is big enough.
+template<typename Func>
+void for_each_rows_group(const int h, const int dstArea, Func&& processRows)
+{
+  const int nthreads = task_threads();
+  if (nthreads < 2 || dstArea < kParallelMinArea) {
+    processRows(0, h);
+    return;
+  }
+
+  const int rowsPerTask = std::max(1, (h + nthreads * 4 - 1) / (nthreads * 4));
+  TaskGroup tasks;
+  for (int y = 0; y < h; y += rowsPerTask) {
+    const int y2 = std::min(y + rowsPerTask, h);
+    tasks.run([&processRows, y, y2] {
+      TRACING_SCOPE("rotsprite task");
+      processRows(y, y2);
+    });
+  }
+  tasks.wait();
+}
+
+// Hash of the pixels of the image to know if a cached upscaled
+// image is still valid for it.
+std::size_t image_hash(const Image* image)
+{
+  std::size_t hash = 0;
+  for (int y = 0; y < image->height(); ++y) {
+    const std::string_view row((const char*)image->getPixelAddress(0, y), image->rowBytes());
+    hash ^= std::hash<std::string_view>()(row) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+  }
+  return hash;
+}
+
 // More information about EPX/Scale2x:
 // http://en.wikipedia.org/wiki/Pixel_art_scaling_algorithms#EPX.2FScale2.C3.97.2FAdvMAME2.C3.97
 // http://scale2x.sourceforge.net/algorithm.html
 // http://scale2x.sourceforge.net/scale2xandepx.html
+//
+// Scales the [y1, y2) rows of the src_w x src_h area of "src" to the
+// (2*y1, 2*y2) rows of "dst".
 template<typename ImageTraits>
-static void image_scale2x_tpl(Image* dst, const Image* src, int src_w, int src_h)
+void image_scale2x_rows(Image* dst,
+                        const Image* src,
+                        const int src_w,
+                        const int src_h,
+                        const int y1,
+                        const int y2)
 {
-#if 0 // TODO complete this implementation that should be faster
-      // than using a lot of get/put_pixel_fast calls.
-  int dst_w = src_w*2;
-  int dst_h = src_h*2;
-
-  LockImageBits<ImageTraits> dstBits(dst, Image::WriteLock, gfx::Rect(0, 0, dst_w, dst_h));
-  const LockImageBits<ImageTraits> srcBits(src);
-
-  LockImageBits<ImageTraits>::iterator dstRow0_it = dstBits.begin();
-  LockImageBits<ImageTraits>::iterator dstRow1_it = dstBits.begin();
-  LockImageBits<ImageTraits>::iterator dstRow0_end = dstBits.end();
-  LockImageBits<ImageTraits>::iterator dstRow1_end = dstBits.end();
-
-  // Iterators:
-  //   A
-  // C P B
-  //   D
-  //
-  // These iterators are displaced through src image and are modified in this way:
-  //
-  // P: is the simplest one, we just start from (0, 0) to srcEnd.
-  // A: starts from row 0 (so A = P in the first row), then we start
-  //    again from the row 0.
-  // B: It starts from (1, row) and in the last pixel we don't moved it.
-  // C: It starts from (0, 0) and then it is moved with a delay.
-  // D: It starts from row 1 and continues until we reach the last
-  //    row, in that case we start D iterator again.
-  //
-  LockImageBits<ImageTraits>::const_iterator itP, itA, itB, itC, itD, savedD;
-  LockImageBits<ImageTraits>::const_iterator srcEnd = srcBits.end();
-  color_t P, A, B, C, D;
-
-  // Adjust iterators
-  itP = itA = itB = itC = itD = savedD = srcBits.begin();
-  dstRow1_it += dst_w;
-  itD += src->width();
-
-  for (int y=0; y<src_h; ++y) {
-    if (y == 1) itA = srcBits.begin();
-    if (y == src_h-2) savedD = itD;
-    if (y == src_h-1) itD = savedD;
-    ++itB;
-
-    for (int x=0; x<src_w; ++x) {
-      ASSERT(itP != srcEnd);
-      ASSERT(itA != srcEnd);
-      ASSERT(itB != srcEnd);
-      ASSERT(itC != srcEnd);
-      ASSERT(itD != srcEnd);
-      ASSERT(dstRow0_it != dstRow0_end);
-      ASSERT(dstRow1_it != dstRow1_end);
-
-      P = *itP;
-      A = *itA;                 // y-1
-      B = *itB;                 // x+1
-      C = *itC;                 // x-1
-      D = *itD;                 // y+1
-
-      *dstRow0_it = (C == A && C != D && A != B ? A: P);
-      ++dstRow0_it;
-      *dstRow0_it = (A == B && A != C && B != D ? B: P);
-      ++dstRow0_it;
-
-      *dstRow1_it = (D == C && D != B && C != A ? C: P);
-      ++dstRow1_it;
-      *dstRow1_it = (B == D && B != A && D != C ? D: P);
-      ++dstRow1_it;
-
-      ++itP;
-      ++itA;
-      if (x < src_w-2) ++itB;
-      if (x > 0) ++itC;
-      ++itD;
-    }
+  using pixel_t = typename ImageTraits::pixel_t;
+
+  for (int y = y1; y < y2; ++y) {
+    const auto* row = (const pixel_t*)src->getPixelAddress(0, y);
+    const auto* above = (y > 0 ? (const pixel_t*)src->getPixelAddress(0, y - 1) : row);
+    const auto* below = (y < src_h - 1 ? (const pixel_t*)src->getPixelAddress(0, y + 1) : row);
+    auto* dst0 = (pixel_t*)dst->getPixelAddress(0, 2 * y);
+    auto* dst1 = (pixel_t*)dst->getPixelAddress(0, 2 * y + 1);
 
-    // Adjust iterators for the next two rows.
-    ++itB;
-    ++itC;
-    dstRow0_it += dst_w;
-    if (y < src_h-1)
-      dstRow1_it += dst_w;
+    for (int x = 0; x < src_w; ++x) {
+      const pixel_t P = row[x];
+      const pixel_t A = above[x];
+      const pixel_t B = (x < src_w - 1 ? row[x + 1] : P);
+      const pixel_t C = (x > 0 ? row[x - 1] : P);
+      const pixel_t D = below[x];
+
+      *(dst0++) = (C == A && C != D && A != B ? A : P);
+      *(dst0++) = (A == B && A != C && B != D ? B : P);
+      *(dst1++) = (D == C && D != B && C != A ? C : P);
+      *(dst1++) = (B == D && B != A && D != C ? D : P);
+    }
   }
+}
 
-  // ASSERT(itP == srcEnd);
-  // ASSERT(itA == srcEnd);
-  // ASSERT(itB == srcEnd);
-  // ASSERT(itC == srcEnd);
-  // ASSERT(itD == srcEnd);
-  ASSERT(dstRow0_it == dstRow0_end);
-  ASSERT(dstRow1_it == dstRow1_end);
-#else
-
-  #define A c[0]
-  #define B c[1]
-  #define C c[2]
-  #define D c[3]
-  #define P c[4]
-
-  LockImageBits<ImageTraits> dstBits(dst, gfx::Rect(0, 0, src_w * 2, src_h * 2));
-  auto dstIt = dstBits.begin();
-  auto dstIt2 = dstIt;
-
-  color_t c[5];
-  for (int y = 0; y < src_h; ++y) {
-    dstIt2 += src_w * 2;
+template<>
+void image_scale2x_rows<BitmapTraits>(Image* dst,
+                                      const Image* src,
+                                      const int src_w,
+                                      const int src_h,
+                                      const int y1,
+                                      const int y2)
+{
+  for (int y = y1; y < y2; ++y) {
     for (int x = 0; x < src_w; ++x) {
-      P = get_pixel_fast<ImageTraits>(src, x, y);
-      A = (y > 0 ? get_pixel_fast<ImageTraits>(src, x, y - 1) : P);
-      B = (x < src_w - 1 ? get_pixel_fast<ImageTraits>(src, x + 1, y) : P);
-      C = (x > 0 ? get_pixel_fast<ImageTraits>(src, x - 1, y) : P);
-      D = (y < src_h - 1 ? get_pixel_fast<ImageTraits>(src, x, y + 1) : P);
-
-      *dstIt = (C == A && C != D && A != B ? A : P);
-      ++dstIt;
-      *dstIt = (A == B && A != C && B != D ? B : P);
-      ++dstIt;
-
-      *dstIt2 = (D == C && D != B && C != A ? C : P);
-      ++dstIt2;
-      *dstIt2 = (B == D && B != A && D != C ? D : P);
-      ++dstIt2;
+      const color_t P = get_pixel_fast<BitmapTraits>(src, x, y);
+      const color_t A = (y > 0 ? get_pixel_fast<BitmapTraits>(src, x, y - 1) : P);
+      const color_t B = (x < src_w - 1 ? get_pixel_fast<BitmapTraits>(src, x + 1, y) : P);
+      const color_t C = (x > 0 ? get_pixel_fast<BitmapTraits>(src, x - 1, y) : P);
+      const color_t D = (y < src_h - 1 ? get_pixel_fast<BitmapTraits>(src, x, y + 1) : P);
+
+      put_pixel_fast<BitmapTraits>(dst, 2 * x, 2 * y, (C == A && C != D && A != B ? A : P));
+      put_pixel_fast<BitmapTraits>(dst, 2 * x + 1, 2 * y, (A == B && A != C && B != D ? B : P));
+      put_pixel_fast<BitmapTraits>(dst, 2 * x, 2 * y + 1, (D == C && D != B && C != A ? C : P));
+      put_pixel_fast<BitmapTraits>(dst,
+                                   2 * x + 1,
+                                   2 * y + 1,
+                                   (B == D && B != A && D != C ? D : P));
     }
-    dstIt += src_w * 2;
   }
+}
 
-#endif
+template<typename ImageTraits>
+void image_scale2x_tpl(Image* dst, const Image* src, const int src_w, const int src_h)
+{
+  for_each_rows_group(src_h, 4 * src_w * src_h, [=](const int y1, const int y2) {
+    image_scale2x_rows<ImageTraits>(dst, src, src_w, src_h, y1, y2);
+  });
 }
 
-static void image_scale2x(Image* dst, const Image* src, int src_w, int src_h)
+void image_scale2x(Image* dst, const Image* src, int src_w, int src_h)
 {
   switch (src->pixelFormat()) {
     case IMAGE_RGB:       image_scale2x_tpl<RgbTraits>(dst, src, src_w, src_h); break;
@@ -163,24 +156,111 @@ static void image_scale2x(Image* dst, const Image* src, int src_w, int src_h)
   }
 }
 
-void rotsprite_image(Image* bmp,
-                     const Image* spr,
-                     const Image* mask,
-                     int x1,
-                     int y1,
-                     int x2,
-                     int y2,
-                     int x3,
-                     int y3,
-                     int x4,
-                     int y4)
+} // anonymous namespace
+
+struct RotSprite::Scaled {
+  // True if it's a mask scaled with nearest neighbor, false if it's
+  // an image scaled with Scale2x.
+  bool isMask = false;
+  PixelFormat format = IMAGE_RGB;
+  int width = 0;
+  int height = 0;
+  std::size_t hash = 0;
+  uint64_t tick = 0;
+  ImageBufferPtr buffer;
+  std::unique_ptr<Image> image;
+};
+
+RotSprite::RotSprite()
 {
-  static ImageBufferPtr buf[3]; // TODO non-thread safe
+}
 
-  for (int i = 0; i < 3; ++i)
-    if (!buf[i])
-      buf[i].reset(new ImageBuffer(1));
+RotSprite::~RotSprite()
+{
+}
 
+void RotSprite::clear()
+{
+  m_cache.clear();
+  m_tmpBuf.reset();
+  m_dstBuf.reset();
+}
+
+Image* RotSprite::getScaled(const Image* src, const bool isMask)
+{
+  const PixelFormat format = src->pixelFormat();
+  const int w = src->width();
+  const int h = src->height();
+  const std::size_t hash = image_hash(src);
+
+  for (auto& scaled : m_cache) {
+    if (scaled->isMask == isMask && scaled->format == format && scaled->width == w &&
+        scaled->height == h && scaled->hash == hash) {
+      scaled->tick = ++m_tick;
+      return scaled->image.get();
+    }
+  }
+
+  // Replace the least recently used image (its buffer is reused)
+  Scaled* scaled;
+  if (int(m_cache.size()) < kMaxCachedImages) {
+    m_cache.push_back(std::make_unique<Scaled>());
+    scaled = m_cache.back().get();
+    scaled->buffer.reset(new ImageBuffer(1));
+  }
+  else {
+    scaled = std::min_element(m_cache.begin(),
+                              m_cache.end(),
+                              [](const auto& a, const auto& b) { return a->tick < b->tick; })
+               ->get();
+  }
+
+  // Invalidate the entry until it's completely scaled (in case that
+  // we run out of memory in the middle).
+  scaled->hash = 0;
+  scaled->width = scaled->height = 0;
+  scaled->image.reset();
+
+  constexpr int scale = 8;
+  scaled->image.reset(Image::create(format, w * scale, h * scale, scaled->buffer));
+
+  if (isMask) {
+    clear_image(scaled->image.get(), 0);
+    scale_image(scaled->image.get(), src, 0, 0, w * scale, h * scale, 0, 0, w, h);
+  }
+  else {
+    if (!m_tmpBuf)
+      m_tmpBuf.reset(new ImageBuffer(1));
+
+    // Ping-pong the three Scale2x passes between the final image and
+    // a 4x temporary image (instead of copying back each pass).
+    std::unique_ptr<Image> tmp(Image::create(format, w * 4, h * 4, m_tmpBuf));
+    image_scale2x(scaled->image.get(), src, w, h);
+    image_scale2x(tmp.get(), scaled->image.get(), w * 2, h * 2);
+    image_scale2x(scaled->image.get(), tmp.get(), w * 4, h * 4);
+  }
+
+  scaled->isMask = isMask;
+  scaled->format = format;
+  scaled->width = w;
+  scaled->height = h;
+  scaled->hash = hash;
+  scaled->tick = ++m_tick;
+  return scaled->image.get();
+}
+
+void RotSprite::rotate(Image* bmp,
+                       const Image* spr,
+                       const Image* mask,
+                       int x1,
+                       int y1,
+                       int x2,
+                       int y2,
+                       int x3,
+                       int y3,
+                       int x4,
+                       int y4)
+{
   int xmin = std::min(x1, std::min(x2, std::min(x3, x4)));
   int xmax = std::max(x1, std::max(x2, std::max(x3, x4)));
   int ymin = std::min(y1, std::min(y2, std::min(y3, y4)));
@@ -192,58 +272,39 @@ void rotsprite_image(Image* bmp,
     return;
 
   int scale = 8;
-  std::unique_ptr<Image> bmp_copy(
-    Image::create(bmp->pixelFormat(), rot_width * scale, rot_height * scale, buf[0]));
-  std::unique_ptr<Image> tmp_copy(
-    Image::create(spr->pixelFormat(), spr->width() * scale, spr->height() * scale, buf[1]));
-  std::unique_ptr<Image> spr_copy(
-    Image::create(spr->pixelFormat(), spr->width() * scale, spr->height() * scale, buf[2]));
-  std::unique_ptr<Image> msk_copy;
-
   color_t maskColor = spr->maskColor();
 
-  bmp_copy->setMaskColor(maskColor);
-  tmp_copy->setMaskColor(maskColor);
+  Image* spr_copy = getScaled(spr, false);
   spr_copy->setMaskColor(maskColor);
 
-  spr_copy->clear(maskColor);
-  spr_copy->copy(spr, gfx::Clip(spr->bounds()));
+  const Image* msk_copy = (mask ? getScaled(mask, true) : nullptr);
 
-  for (int i = 0; i < 3; ++i) {
-    // clear_image(tmp_copy, maskColor);
-    image_scale2x(tmp_copy.get(), spr_copy.get(), spr->width() * (1 << i), spr->height() * (1 << i));
-    spr_copy->copy(tmp_copy.get(), gfx::Clip(tmp_copy->bounds()));
-  }
+  if (!m_dstBuf)
+    m_dstBuf.reset(new ImageBuffer(1));
 
-  if (mask) {
-    // Same ImageBuffer than tmp_copy
-    msk_copy.reset(
-      Image::create(IMAGE_BITMAP, mask->width() * scale, mask->height() * scale, buf[1]));
-    clear_image(msk_copy.get(), 0);
-    scale_image(msk_copy.get(),
-                mask,
-                0,
-                0,
-                msk_copy->width(),
-                msk_copy->height(),
-                0,
-                0,
-                mask->width(),
-                mask->height());
-  }
+  std::unique_ptr<Image> bmp_copy(
+    Image::create(bmp->pixelFormat(), rot_width * scale, rot_height * scale, m_dstBuf));
+  bmp_copy->setMaskColor(maskColor);
 
-  clear_image(bmp_copy.get(), maskColor);
-  parallelogram(bmp_copy.get(),
-                spr_copy.get(),
-                msk_copy.get(),
-                (x1 - xmin) * scale,
-                (y1 - ymin) * scale,
-                (x2 - xmin) * scale,
-                (y2 - ymin) * scale,
-                (x3 - xmin) * scale,
-                (y3 - ymin) * scale,
-                (x4 - xmin) * scale,
-                (y4 - ymin) * scale);
+  // Each group of rows of bmp_copy is cleared and sampled in a
+  // different thread.
+  auto sampleRows = [&](const int rows_y1, const int rows_y2) {
+    bmp_copy->fillRect(0, rows_y1, bmp_copy->width() - 1, rows_y2 - 1, maskColor);
+    parallelogram_rows(bmp_copy.get(),
+                       spr_copy,
+                       msk_copy,
+                       (x1 - xmin) * scale,
+                       (y1 - ymin) * scale,
+                       (x2 - xmin) * scale,
+                       (y2 - ymin) * scale,
+                       (x3 - xmin) * scale,
+                       (y3 - ymin) * scale,
+                       (x4 - xmin) * scale,
+                       (y4 - ymin) * scale,
+                       rows_y1,
+                       rows_y2);
+  };
+  for_each_rows_group(bmp_copy->height(), bmp_copy->width() * bmp_copy->height(), sampleRows);
 
   scale_image(bmp,
               bmp_copy.get(),
@@ -257,4 +318,19 @@ void rotsprite_image(Image* bmp,
               bmp_copy->height());
 }
 
+void rotsprite_image(Image* bmp,
+                     const Image* spr,
+                     const Image* mask,
+                     int x1,
+                     int y1,
+                     int x2,
+                     int y2,
+                     int x3,
+                     int y3,
+                     int x4,
+                     int y4)
+{
+  RotSprite().rotate(bmp, spr, mask, x1, y1, x2, y2, x3, y3, x4, y4);
+}
+
 }} // namespace doc::algorithm
@@ -1,4 +1,5 @@
 // Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
 // Copyright (c) 2001-2015 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -8,11 +9,60 @@
 #define DOC_ALGORITHM_ROTSPRITE_H_INCLUDED
 #pragma once
 
+#include "doc/image_buffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
 namespace doc {
 class Image;
 
 namespace algorithm {
 
+// RotSprite engine which keeps the 8x upscaled version of the last
+// rotated sources (and their masks), so the same image can be
+// rotated again with other angles (e.g. while the user drags the
+// rotation handle) without upscaling it again. Sources are
+// identified by their content, so a modified source is upscaled
+// again automatically.
+//
+// The upscaling and the sampling of the rotated image are done from
+// several threads. A RotSprite instance must not be used from
+// different threads at the same time.
+class RotSprite {
+public:
+  RotSprite();
+  ~RotSprite();
+
+  void rotate(Image* dst,
+              const Image* src,
+              const Image* mask,
+              int x1,
+              int y1,
+              int x2,
+              int y2,
+              int x3,
+              int y3,
+              int x4,
+              int y4);
+
+  // Releases the cached images and buffers.
+  void clear();
+
+private:
+  struct Scaled;
+
+  Image* getScaled(const Image* src, bool isMask);
+
+  std::vector<std::unique_ptr<Scaled>> m_cache;
+  uint64_t m_tick = 0;
+  ImageBufferPtr m_tmpBuf;
+  ImageBufferPtr m_dstBuf;
+};
+
+// Rotates "src" with a temporary RotSprite engine (nothing is kept
+// between calls, so it can be called from different threads).
 void rotsprite_image(Image* dst,
                      const Image* src,
                      const Image* mask,
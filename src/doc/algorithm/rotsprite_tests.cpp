@@ -0,0 +1,107 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "doc/algorithm/rotsprite.h"
+#include "doc/image.h"
+#include "doc/image_ref.h"
+#include "doc/primitives.h"
+
+#include <cmath>
+
+using namespace doc;
+using namespace doc::algorithm;
+
+namespace {
+
+// Corners of the src image rotated around its center.
+struct Corners {
+  int x[4], y[4];
+};
+
+Corners rotated_corners(const Image* src, const double angle)
+{
+  const double cx = src->width() / 2.0;
+  const double cy = src->height() / 2.0;
+  const double c = std::cos(angle);
+  const double s = std::sin(angle);
+  const double xs[4] = { 0.0, double(src->width()), double(src->width()), 0.0 };
+  const double ys[4] = { 0.0, 0.0, double(src->height()), double(src->height()) };
+
+  Corners corners;
+  for (int i = 0; i < 4; ++i) {
+    corners.x[i] = int(cx + (xs[i] - cx) * c - (ys[i] - cy) * s + src->width() / 2);
+    corners.y[i] = int(cy + (xs[i] - cx) * s + (ys[i] - cy) * c + src->height() / 2);
+  }
+  return corners;
+}
+
+void expect_same_rotation(RotSprite& rotSprite,
+                          const Image* src,
+                          const Image* mask,
+                          const double angle)
+{
+  const Corners k = rotated_corners(src, angle);
+
+  ImageRef expected(Image::create(src->pixelFormat(), src->width() * 2, src->height() * 2));
+  ImageRef result(Image::create(src->pixelFormat(), src->width() * 2, src->height() * 2));
+  clear_image(expected.get(), 0);
+  clear_image(result.get(), 0);
+
+  rotsprite_image(expected.get(),
+                  src,
+                  mask,
+                  k.x[0],
+                  k.y[0],
+                  k.x[1],
+                  k.y[1],
+                  k.x[2],
+                  k.y[2],
+                  k.x[3],
+                  k.y[3]);
+  rotSprite.rotate(result.get(),
+                   src,
+                   mask,
+                   k.x[0],
+                   k.y[0],
+                   k.x[1],
+                   k.y[1],
+                   k.x[2],
+                   k.y[2],
+                   k.x[3],
+                   k.y[3]);
+
+  EXPECT_EQ(0, count_diff_between_images(expected.get(), result.get())) << angle;
+}
+
+} // anonymous namespace
+
+TEST(RotSprite, CachedSource)
+{
+  // Big enough to be upscaled and sampled by several threads
+  ImageRef src(Image::create(IMAGE_RGB, 67, 45));
+  for (int y = 0; y < src->height(); ++y)
+    for (int x = 0; x < src->width(); ++x)
+      put_pixel(src.get(), x, y, ((x / 3 + y / 5) & 1 ? rgba(255, x * 3, y * 5, 255) : 0));
+
+  ImageRef mask(Image::create(IMAGE_BITMAP, src->width(), src->height()));
+  clear_image(mask.get(), 1);
+  fill_rect(mask.get(), 10, 10, 20, 30, 0);
+
+  RotSprite rotSprite;
+  for (double angle : { 0.3, 0.6, 1.2, 2.5 }) {
+    expect_same_rotation(rotSprite, src.get(), mask.get(), angle);
+    expect_same_rotation(rotSprite, mask.get(), nullptr, angle);
+  }
+
+  // The modified source must be upscaled again
+  fill_rect(src.get(), 30, 5, 50, 15, rgba(0, 0, 255, 255));
+  expect_same_rotation(rotSprite, src.get(), mask.get(), 0.6);
+
+  rotSprite.clear();
+  expect_same_rotation(rotSprite, src.get(), nullptr, 0.9);
+}
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2019-2024 Igara Studio S.A.
+// Copyright (c) 2019-2026 Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -12,6 +12,7 @@
 
 #include "doc/color.h"
 #include "doc/image.h"
+#include "doc/primitives.h"
 
 #include <benchmark/benchmark.h>
 #include <memory>
@@ -32,6 +33,23 @@ void BM_ShrinkBounds(benchmark::State& state)
   }
 }
 
+// Trims a 4K frame with a big opaque area in the middle (like an
+// exported animation frame), so all rows must be scanned.
+void BM_ShrinkBounds4KFrame(benchmark::State& state)
+{
+  const PixelFormat pixelFormat = (PixelFormat)state.range(0);
+  const int w = 3840;
+  const int h = 2160;
+
+  std::unique_ptr<Image> img(Image::create(pixelFormat, w, h));
+  img->clear(0);
+  fill_rect(img.get(), w / 4, h / 4, 3 * w / 4, 3 * h / 4, rgba(1, 2, 3, 255));
+  gfx::Rect rc;
+  for (auto _ : state) {
+    doc::algorithm::shrink_bounds(img.get(), 0, nullptr, rc);
+  }
+}
+
 #define DEFARGS(MODE)                                                                              \
   ->Args({ MODE, 100, 100 })                                                                       \
     ->Args({ MODE, 200, 200 })                                                                     \
@@ -47,6 +65,7 @@ void BM_ShrinkBounds(benchmark::State& state)
     ->Args({ MODE, 1000, 1000 })                                                                   \
     ->Args({ MODE, 1500, 1500 })                                                                   \
     ->Args({ MODE, 2000, 2000 })                                                                   \
+    ->Args({ MODE, 3840, 2160 })                                                                   \
     ->Args({ MODE, 4000, 4000 })                                                                   \
     ->Args({ MODE, 8000, 8000 })
 
@@ -55,4 +74,11 @@ DEFARGS(IMAGE_RGB)
 DEFARGS(IMAGE_GRAYSCALE)
 DEFARGS(IMAGE_INDEXED)->Unit(benchmark::kMicrosecond)->UseRealTime();
 
+BENCHMARK(BM_ShrinkBounds4KFrame)
+  ->Arg(IMAGE_RGB)
+  ->Arg(IMAGE_GRAYSCALE)
+  ->Arg(IMAGE_INDEXED)
+  ->Unit(benchmark::kMicrosecond)
+  ->UseRealTime();
+
 BENCHMARK_MAIN();
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2019-2023 Igara Studio S.A.
+// Copyright (c) 2019-2026 Igara Studio S.A.
 // Copyright (c) 2001-2016 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -20,152 +20,209 @@
 #include "doc/primitives_fast.h"
 #include "doc/tileset.h"
 
-#include <thread>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_WIN64)
+  #include <emmintrin.h>
+  #define DOC_USE_SSE2_SHRINK_BOUNDS 1
+#else
+  #define DOC_USE_SSE2_SHRINK_BOUNDS 0
+#endif
 
 namespace doc { namespace algorithm {
 
 namespace {
 
+// Scans rows of pixels to find the first/last pixel that is different
+// from the reference pixel, comparing blocks of 16 bytes (or 8 bytes
+// if SSE2 isn't available) until a block with a different pixel is
+// found. A pixel "p" is equal to the reference pixel if
+// (p & m_mask) == m_value, so two transparent RGB or grayscale pixels
+// are equal even if they have different RGB/gray values.
 template<typename ImageTraits>
-bool is_same_pixel(color_t pixel1, color_t pixel2)
-{
-  static_assert(false && sizeof(ImageTraits), "No is_same_pixel impl");
-  return false;
-}
+class RowScanner {
+public:
+  using pixel_t = typename ImageTraits::pixel_t;
+
+  RowScanner(const color_t refpixel)
+  {
+    pixel_t mask = ~pixel_t(0);
+    pixel_t value = pixel_t(refpixel);
+    if (ImageTraits::pixel_format == IMAGE_RGB && rgba_geta(refpixel) == 0) {
+      mask = pixel_t(rgba_a_mask);
+      value = 0;
+    }
+    else if (ImageTraits::pixel_format == IMAGE_GRAYSCALE && graya_geta(refpixel) == 0) {
+      mask = pixel_t(graya_a_mask);
+      value = 0;
+    }
+    m_mask = mask;
+    m_value = value;
+
+    pixel_t masks[kPixels], values[kPixels];
+    std::fill(masks, masks + kPixels, mask);
+    std::fill(values, values + kPixels, value);
+#if DOC_USE_SSE2_SHRINK_BOUNDS
+    m_masks = _mm_loadu_si128(reinterpret_cast<const __m128i*>(masks));
+    m_values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+#else
+    std::memcpy(&m_masks, masks, sizeof(m_masks));
+    std::memcpy(&m_values, values, sizeof(m_values));
+#endif
+  }
 
-template<>
-bool is_same_pixel<RgbTraits>(color_t pixel1, color_t pixel2)
-{
-  return (rgba_geta(pixel1) == 0 && rgba_geta(pixel2) == 0) || (pixel1 == pixel2);
-}
+  // Returns the index of the first pixel of p[0..n) that is
+  // different from the reference pixel, or n if all are equal.
+  int firstDiff(const pixel_t* p, const int n) const
+  {
+    int i = 0;
+    while (i + kPixels <= n && isSameBlock(p + i))
+      i += kPixels;
+    for (; i < n; ++i) {
+      if (!isSame(p[i]))
+        return i;
+    }
+    return n;
+  }
 
-template<>
-bool is_same_pixel<GrayscaleTraits>(color_t pixel1, color_t pixel2)
-{
-  return (graya_geta(pixel1) == 0 && graya_geta(pixel2) == 0) || (pixel1 == pixel2);
-}
+  // Returns the index of the last pixel of p[0..n) that is different
+  // from the reference pixel, or -1 if all are equal.
+  int lastDiff(const pixel_t* p, const int n) const
+  {
+    int i = n;
+    while (i - kPixels >= 0 && isSameBlock(p + i - kPixels))
+      i -= kPixels;
+    for (--i; i >= 0; --i) {
+      if (!isSame(p[i]))
+        return i;
+    }
+    return -1;
+  }
 
-template<>
-bool is_same_pixel<IndexedTraits>(color_t pixel1, color_t pixel2)
-{
-  return pixel1 == pixel2;
-}
+private:
+  static constexpr int kPixels = (DOC_USE_SSE2_SHRINK_BOUNDS ? 16 : 8) / sizeof(pixel_t);
+
+  bool isSame(const pixel_t c) const { return (c & m_mask) == m_value; }
+
+  // Returns true if the kPixels pixels starting at p are equal to
+  // the reference pixel.
+  bool isSameBlock(const pixel_t* p) const
+  {
+#if DOC_USE_SSE2_SHRINK_BOUNDS
+    const __m128i c = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)),
+                                    m_masks);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(c, m_values)) == 0xffff;
+#else
+    uint64_t c;
+    std::memcpy(&c, p, sizeof(c));
+    return (c & m_masks) == m_values;
+#endif
+  }
 
-template<>
-bool is_same_pixel<BitmapTraits>(color_t pixel1, color_t pixel2)
-{
-  return pixel1 == pixel2;
-}
+  pixel_t m_mask;
+  pixel_t m_value;
+#if DOC_USE_SSE2_SHRINK_BOUNDS
+  __m128i m_masks;
+  __m128i m_values;
+#else
+  uint64_t m_masks;
+  uint64_t m_values;
+#endif
+};
 
+// Shrinks the bounds scanning rows only (which are contiguous in
+// memory): first the top and bottom rows that are completely equal
+// to the reference pixel, and then the left/right limits from the
+// rest of rows (checking only the pixels that are outside the
+// limits found in the previous rows).
 template<typename ImageTraits>
-bool shrink_bounds_left_templ(const Image* image, gfx::Rect& bounds, color_t refpixel, int rowPixels)
+bool shrink_bounds_templ(const Image* image, gfx::Rect& bounds, color_t refpixel)
 {
-  int u, v;
-  // Shrink left side
-  for (u = bounds.x; u < bounds.x2(); ++u) {
-    auto ptr = get_pixel_address_fast<ImageTraits>(image, u, v = bounds.y);
-    for (; v < bounds.y2(); ++v, ptr += rowPixels) {
-      ASSERT(ptr == get_pixel_address_fast<ImageTraits>(image, u, v));
-      if (!is_same_pixel<ImageTraits>(*ptr, refpixel))
-        return (!bounds.isEmpty());
-    }
-    ++bounds.x;
-    --bounds.w;
+  using pixel_t = typename ImageTraits::pixel_t;
+
+  if (bounds.isEmpty())
+    return false;
+
+  const RowScanner<ImageTraits> scanner(refpixel);
+  auto row = [image, &bounds](const int v) {
+    return reinterpret_cast<const pixel_t*>(image->getPixelAddress(bounds.x, v));
+  };
+
+  // Shrink top side
+  int top = bounds.y;
+  int left = bounds.w;
+  for (; top < bounds.y2(); ++top) {
+    left = scanner.firstDiff(row(top), bounds.w);
+    if (left < bounds.w)
+      break;
   }
-  return (!bounds.isEmpty());
-}
+  if (top == bounds.y2()) {
+    bounds.h = 0;
+    return false;
+  }
+  int right = scanner.lastDiff(row(top), bounds.w);
 
-template<typename ImageTraits>
-bool shrink_bounds_right_templ(const Image* image,
-                               gfx::Rect& bounds,
-                               color_t refpixel,
-                               int rowPixels)
-{
-  int u, v;
-  // Shrink right side
-  for (u = bounds.x2() - 1; u >= bounds.x; --u) {
-    auto ptr = get_pixel_address_fast<ImageTraits>(image, u, v = bounds.y);
-    for (; v < bounds.y2(); ++v, ptr += rowPixels) {
-      ASSERT(ptr == get_pixel_address_fast<ImageTraits>(image, u, v));
-      if (!is_same_pixel<ImageTraits>(*ptr, refpixel))
-        return (!bounds.isEmpty());
+  // Shrink bottom side
+  int bottom = bounds.y2() - 1;
+  for (; bottom > top; --bottom) {
+    const pixel_t* p = row(bottom);
+    const int l = scanner.firstDiff(p, bounds.w);
+    if (l < bounds.w) {
+      left = std::min(left, l);
+      right = std::max(right, scanner.lastDiff(p, bounds.w));
+      break;
     }
-    --bounds.w;
   }
-  return (!bounds.isEmpty());
-}
 
-template<typename ImageTraits>
-bool shrink_bounds_top_templ(const Image* image, gfx::Rect& bounds, color_t refpixel)
-{
-  int u, v;
-  // Shrink top side
-  for (v = bounds.y; v < bounds.y2(); ++v) {
-    auto ptr = get_pixel_address_fast<ImageTraits>(image, u = bounds.x, v);
-    for (; u < bounds.x2(); ++u, ++ptr) {
-      ASSERT(ptr == get_pixel_address_fast<ImageTraits>(image, u, v));
-      if (!is_same_pixel<ImageTraits>(*ptr, refpixel))
-        return (!bounds.isEmpty());
-    }
-    ++bounds.y;
-    --bounds.h;
+  // Shrink left and right sides
+  for (int v = top + 1; v < bottom && (left > 0 || right < bounds.w - 1); ++v) {
+    const pixel_t* p = row(v);
+    left = scanner.firstDiff(p, left);
+    right += 1 + scanner.lastDiff(p + right + 1, bounds.w - right - 1);
   }
-  return (!bounds.isEmpty());
+
+  bounds = gfx::Rect(bounds.x + left, top, right - left + 1, bottom - top + 1);
+  return true;
 }
 
-template<typename ImageTraits>
-bool shrink_bounds_bottom_templ(const Image* image, gfx::Rect& bounds, color_t refpixel)
+// Bitmaps are shrunk pixel by pixel.
+template<>
+bool shrink_bounds_templ<BitmapTraits>(const Image* image, gfx::Rect& bounds, color_t refpixel)
 {
-  int u, v;
-  // Shrink bottom side
-  for (v = bounds.y2() - 1; v >= bounds.y; --v) {
-    auto ptr = get_pixel_address_fast<ImageTraits>(image, u = bounds.x, v);
-    for (; u < bounds.x2(); ++u, ++ptr) {
-      ASSERT(ptr == get_pixel_address_fast<ImageTraits>(image, u, v));
-      if (!is_same_pixel<ImageTraits>(*ptr, refpixel))
-        return (!bounds.isEmpty());
+  auto isRowEqual = [image, &bounds, refpixel](const int v) {
+    for (int u = bounds.x; u < bounds.x2(); ++u) {
+      if (get_pixel_fast<BitmapTraits>(image, u, v) != refpixel)
+        return false;
     }
+    return true;
+  };
+  auto isColumnEqual = [image, &bounds, refpixel](const int u) {
+    for (int v = bounds.y; v < bounds.y2(); ++v) {
+      if (get_pixel_fast<BitmapTraits>(image, u, v) != refpixel)
+        return false;
+    }
+    return true;
+  };
+
+  // Shrink top and bottom sides
+  while (!bounds.isEmpty() && isRowEqual(bounds.y)) {
+    ++bounds.y;
     --bounds.h;
   }
-  return (!bounds.isEmpty());
-}
+  while (!bounds.isEmpty() && isRowEqual(bounds.y2() - 1))
+    --bounds.h;
 
-template<typename ImageTraits>
-bool shrink_bounds_templ(const Image* image, gfx::Rect& bounds, color_t refpixel)
-{
-  // Pixels per row
-  const int rowPixels = image->rowPixels();
-  const int canvasSize = image->width() * image->height();
-  if ((std::thread::hardware_concurrency() >= 4) &&
-      ((image->pixelFormat() == IMAGE_RGB && canvasSize >= 800 * 800) ||
-       (image->pixelFormat() != IMAGE_RGB && canvasSize >= 500 * 500))) {
-    gfx::Rect leftBounds(bounds), rightBounds(bounds), topBounds(bounds), bottomBounds(bounds);
-
-    // TODO use a base::thread_pool and a base::task for each border
-
-    std::thread left(
-      [&] { shrink_bounds_left_templ<ImageTraits>(image, leftBounds, refpixel, rowPixels); });
-    std::thread right(
-      [&] { shrink_bounds_right_templ<ImageTraits>(image, rightBounds, refpixel, rowPixels); });
-    std::thread top([&] { shrink_bounds_top_templ<ImageTraits>(image, topBounds, refpixel); });
-    std::thread bottom(
-      [&] { shrink_bounds_bottom_templ<ImageTraits>(image, bottomBounds, refpixel); });
-    left.join();
-    right.join();
-    top.join();
-    bottom.join();
-    bounds = leftBounds;
-    bounds &= rightBounds;
-    bounds &= topBounds;
-    bounds &= bottomBounds;
-    return !bounds.isEmpty();
-  }
-  else {
-    return shrink_bounds_left_templ<ImageTraits>(image, bounds, refpixel, rowPixels) &&
-           shrink_bounds_right_templ<ImageTraits>(image, bounds, refpixel, rowPixels) &&
-           shrink_bounds_top_templ<ImageTraits>(image, bounds, refpixel) &&
-           shrink_bounds_bottom_templ<ImageTraits>(image, bounds, refpixel);
+  // Shrink left and right sides
+  while (!bounds.isEmpty() && isColumnEqual(bounds.x)) {
+    ++bounds.x;
+    --bounds.w;
   }
+  while (!bounds.isEmpty() && isColumnEqual(bounds.x2() - 1))
+    --bounds.w;
+
+  return !bounds.isEmpty();
 }
 
 template<typename ImageTraits>
@@ -358,7 +415,13 @@ bool shrink_bounds(const Image* image, const color_t refpixel, const Layer* laye
 
 bool shrink_cel_bounds(const Cel* cel, const color_t refpixel, gfx::Rect& bounds)
 {
-  if (shrink_bounds(cel->image(), refpixel, cel->layer(), bounds)) {
+  const Image* image = cel->image();
+
+  // Use the cached bounds of the image when possible
+  const bool shrink = (!image->isTilemap() && refpixel == image->maskColor() ?
+                         image->opaqueBounds(bounds) :
+                         shrink_bounds(image, refpixel, cel->layer(), bounds));
+  if (shrink) {
     // For tilemaps, we have to convert imgBounds (in tiles
     // coordinates) to canvas coordinates using the Grid specs.
     if (cel->layer()->isTilemap()) {
@@ -0,0 +1,83 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "doc/algorithm/shrink_bounds.h"
+
+#include "doc/image.h"
+#include "doc/image_ref.h"
+#include "doc/primitives.h"
+#include "gfx/rect.h"
+
+#include <algorithm>
+
+using namespace doc;
+using namespace gfx;
+
+namespace {
+
+color_t opaque_color(const PixelFormat pf)
+{
+  switch (pf) {
+    case IMAGE_RGB:       return rgba(10, 20, 30, 255);
+    case IMAGE_GRAYSCALE: return graya(10, 255);
+    case IMAGE_BITMAP:    return 1;
+    default:              return 7;
+  }
+}
+
+} // anonymous namespace
+
+TEST(ShrinkBounds, Pixels)
+{
+  for (auto pf : { IMAGE_RGB, IMAGE_GRAYSCALE, IMAGE_INDEXED, IMAGE_BITMAP }) {
+    for (int w : { 1, 3, 17, 64, 101 }) {
+      ImageRef image(Image::create(pf, w, 40));
+      const color_t c = opaque_color(pf);
+      gfx::Rect bounds;
+
+      clear_image(image.get(), 0);
+      EXPECT_FALSE(algorithm::shrink_bounds(image.get(), 0, nullptr, bounds));
+
+      for (int x = 0; x < w; x += 5) {
+        clear_image(image.get(), 0);
+        put_pixel(image.get(), x, 30, c);
+        put_pixel(image.get(), w - 1 - x / 2, 10, c);
+
+        const int x1 = std::min(x, w - 1 - x / 2);
+        const int x2 = std::max(x, w - 1 - x / 2);
+        ASSERT_TRUE(algorithm::shrink_bounds(image.get(), 0, nullptr, bounds));
+        EXPECT_EQ(gfx::Rect(x1, 10, x2 - x1 + 1, 21), bounds) << "Pixel format=" << pf;
+
+        // Only pixels inside the start bounds are checked
+        ASSERT_TRUE(
+          algorithm::shrink_bounds(image.get(), 0, nullptr, gfx::Rect(0, 20, w, 20), bounds));
+        EXPECT_EQ(gfx::Rect(x, 30, 1, 1), bounds) << "Pixel format=" << pf;
+      }
+    }
+  }
+}
+
+TEST(ShrinkBounds, TransparentPixels)
+{
+  ImageRef image(Image::create(IMAGE_RGB, 50, 20));
+  clear_image(image.get(), rgba(255, 0, 0, 0));
+  put_pixel(image.get(), 5, 6, rgba(0, 255, 0, 0));
+  put_pixel(image.get(), 40, 15, rgba(0, 0, 255, 1));
+
+  // Transparent pixels are equal even with different RGB values
+  gfx::Rect bounds;
+  ASSERT_TRUE(algorithm::shrink_bounds(image.get(), 0, nullptr, bounds));
+  EXPECT_EQ(gfx::Rect(40, 15, 1, 1), bounds);
+
+  // But not if the reference pixel is opaque
+  clear_image(image.get(), rgba(255, 0, 0, 255));
+  put_pixel(image.get(), 5, 6, rgba(255, 0, 0, 254));
+  put_pixel(image.get(), 40, 15, rgba(255, 1, 0, 255));
+  ASSERT_TRUE(algorithm::shrink_bounds(image.get(), rgba(255, 0, 0, 255), nullptr, bounds));
+  EXPECT_EQ(gfx::Rect(5, 6, 36, 10), bounds);
+}
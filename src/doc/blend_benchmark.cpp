@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2024 Igara Studio S.A.
+// Copyright (c) 2024-2026 Igara Studio S.A.
 // Copyright (c) 2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -13,6 +13,8 @@
 
 #include <benchmark/benchmark.h>
 
+#include <vector>
+
 using namespace doc;
 
 static void CustomArguments(benchmark::internal::Benchmark* b)
@@ -56,4 +58,47 @@ BENCHMARK_TEMPLATE(BM_Rgba, rgba_blender_hsl_saturation)->Apply(CustomArguments)
 BENCHMARK_TEMPLATE(BM_Rgba, rgba_blender_hsl_color)->Apply(CustomArguments);
 BENCHMARK_TEMPLATE(BM_Rgba, rgba_blender_hsl_luminosity)->Apply(CustomArguments);
 
+// Compares the scalar BlendFunc called for each pixel with the span
+// blender (which might use SIMD instructions) for one scanline.
+template<bool Span>
+void BM_RgbaScanline(benchmark::State& state)
+{
+  const BlendMode blendMode = BlendMode(state.range(0));
+  const bool newBlend = (state.range(1) != 0);
+  const int n = 1024;
+  std::vector<color_t> dst(n), src(n);
+  for (int x = 0; x < n; ++x) {
+    dst[x] = rgba(200, 128, 64, x & 0xff);
+    src[x] = rgba(32, 128, 200, (x * 3) & 0xff);
+  }
+
+  BlendFunc func = get_rgba_blender(blendMode, newBlend);
+  BlendSpanFunc spanFunc = get_rgba_span_blender(blendMode, newBlend);
+  for (auto _ : state) {
+    if constexpr (Span) {
+      spanFunc(dst.data(), src.data(), n, 128, 0);
+    }
+    else {
+      for (int x = 0; x < n; ++x)
+        dst[x] = func(dst[x], src[x], 128);
+    }
+    benchmark::DoNotOptimize(dst.data());
+  }
+}
+
+static void ScanlineArguments(benchmark::internal::Benchmark* b)
+{
+  for (BlendMode mode : { BlendMode::NORMAL,
+                          BlendMode::MULTIPLY,
+                          BlendMode::SCREEN,
+                          BlendMode::OVERLAY,
+                          BlendMode::ADDITION,
+                          BlendMode::DIFFERENCE }) {
+    b->Args({ int(mode), 0 })->Args({ int(mode), 1 });
+  }
+}
+
+BENCHMARK_TEMPLATE(BM_RgbaScanline, false)->Apply(ScanlineArguments);
+BENCHMARK_TEMPLATE(BM_RgbaScanline, true)->Apply(ScanlineArguments);
+
 BENCHMARK_MAIN();
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2019-2025 Igara Studio S.A.
+// Copyright (c) 2019-2026 Igara Studio S.A.
 // Copyright (c) 2001-2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -25,6 +25,13 @@
 #include <algorithm>
 #include <cmath>
 
+#if defined(__x86_64__) || defined(_WIN64)
+  #include <emmintrin.h>
+  #define DOC_USE_SSE2_BLENDERS 1
+#else
+  #define DOC_USE_SSE2_BLENDERS 0
+#endif
+
 namespace {
 
 #define blend_multiply(b, s, t) (MUL_UN8((b), (s), (t)))
@@ -831,4 +838,517 @@ BlendFunc get_indexed_blender(BlendMode blendmode, const bool newBlend)
   return indexed_blender_src;
 }
 
+//////////////////////////////////////////////////////////////////////
+// RGB span blenders
+
+namespace {
+
+void rgba_span_blender_src(color_t* dst, const color_t* src, int n, int, color_t)
+{
+  std::copy(src, src + n, dst);
+}
+
+// Generic span blender, the scalar BlendFunc is a template argument
+// so it can be inlined in the loop (instead of calling a function
+// pointer for each pixel).
+template<BlendFunc F>
+void rgba_span_blender(color_t* dst, const color_t* src, int n, int opacity, color_t maskColor)
+{
+  for (int x = 0; x < n; ++x, ++dst, ++src) {
+    if (*src != maskColor)
+      *dst = F(*dst, *src, opacity);
+  }
+}
+
+#if DOC_USE_SSE2_BLENDERS
+
+// Each __m128i contains 4 pixels, or one channel of 4 pixels (one
+// 32-bit lane per pixel). The operations are the same ones used in
+// the scalar versions, so the results are exactly the same.
+
+struct Sse2Channels {
+  __m128i r, g, b, a;
+};
+
+inline Sse2Channels sse2_unpack(const __m128i c)
+{
+  const __m128i m = _mm_set1_epi32(0xff);
+  return { _mm_and_si128(c, m),
+           _mm_and_si128(_mm_srli_epi32(c, rgba_g_shift), m),
+           _mm_and_si128(_mm_srli_epi32(c, rgba_b_shift), m),
+           _mm_srli_epi32(c, rgba_a_shift) };
+}
+
+inline __m128i sse2_pack(const __m128i r, const __m128i g, const __m128i b, const __m128i a)
+{
+  return _mm_or_si128(_mm_or_si128(r, _mm_slli_epi32(g, rgba_g_shift)),
+                      _mm_or_si128(_mm_slli_epi32(b, rgba_b_shift), _mm_slli_epi32(a, rgba_a_shift)));
+}
+
+// Returns a where mask is set, or b in other case
+inline __m128i sse2_select(const __m128i mask, const __m128i a, const __m128i b)
+{
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// MUL_UN8(a, b) for a and b in [0, 255]. The product fits in 16-bits
+// so we can use _mm_mullo_epi16() on 32-bit lanes.
+inline __m128i sse2_mul_un8(const __m128i a, const __m128i b)
+{
+  const __m128i t = _mm_add_epi32(_mm_mullo_epi16(a, b), _mm_set1_epi32(ONE_HALF));
+  return _mm_srli_epi32(_mm_add_epi32(_mm_srli_epi32(t, G_SHIFT), t), G_SHIFT);
+}
+
+// MUL_UN8(a, b) for a in [-255, 255] and b in [0, 255]. SSE2 doesn't
+// have a 32-bit multiplication, but the product is exact in float.
+inline __m128i sse2_mul_un8_signed(const __m128i a, const __m128i b)
+{
+  __m128i t = _mm_cvttps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(a), _mm_cvtepi32_ps(b)));
+  t = _mm_add_epi32(t, _mm_set1_epi32(ONE_HALF));
+  return _mm_srai_epi32(_mm_add_epi32(_mm_srai_epi32(t, G_SHIFT), t), G_SHIFT);
+}
+
+// Same as rgba_blender_normal()
+inline __m128i sse2_blend_normal(const __m128i B, const __m128i S, const __m128i opacity)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const Sse2Channels b = sse2_unpack(B);
+  const Sse2Channels s = sse2_unpack(S);
+  const __m128i Sa = sse2_mul_un8(s.a, opacity);
+
+  // Transparent backdrop
+  const __m128i onTransparent = _mm_or_si128(_mm_and_si128(S, _mm_set1_epi32(rgba_rgb_mask)),
+                                             _mm_slli_epi32(Sa, rgba_a_shift));
+
+  // Ra = Sa + Ba - Ba*Sa
+  const __m128i Ra = _mm_sub_epi32(_mm_add_epi32(Sa, b.a), sse2_mul_un8(b.a, Sa));
+
+  // Rc = Bc + (Sc-Bc)*Sa/Ra, the quotient is truncated as the
+  // integer division does (the float division of these small
+  // integers cannot cross an integer boundary).
+  const __m128 fSa = _mm_cvtepi32_ps(Sa);
+  const __m128 fRa = _mm_max_ps(_mm_cvtepi32_ps(Ra), _mm_set1_ps(1.0f));
+  auto channel = [fSa, fRa](const __m128i Bc, const __m128i Sc) {
+    return _mm_add_epi32(
+      Bc,
+      _mm_cvttps_epi32(_mm_div_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_sub_epi32(Sc, Bc)), fSa), fRa)));
+  };
+  __m128i R = sse2_pack(channel(b.r, s.r), channel(b.g, s.g), channel(b.b, s.b), Ra);
+
+  R = sse2_select(_mm_cmpeq_epi32(s.a, zero), B, R);
+  return sse2_select(_mm_cmpeq_epi32(b.a, zero), onTransparent, R);
+}
+
+// Same as rgba_blender_merge() with an opacity for each pixel
+inline __m128i sse2_blend_merge(const __m128i B, const __m128i S, const __m128i opacity)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i rgbMask = _mm_set1_epi32(rgba_rgb_mask);
+  const Sse2Channels b = sse2_unpack(B);
+  const Sse2Channels s = sse2_unpack(S);
+
+  __m128i rgb = sse2_pack(_mm_add_epi32(b.r, sse2_mul_un8_signed(_mm_sub_epi32(s.r, b.r), opacity)),
+                          _mm_add_epi32(b.g, sse2_mul_un8_signed(_mm_sub_epi32(s.g, b.g), opacity)),
+                          _mm_add_epi32(b.b, sse2_mul_un8_signed(_mm_sub_epi32(s.b, b.b), opacity)),
+                          zero);
+  rgb = sse2_select(_mm_cmpeq_epi32(s.a, zero), _mm_and_si128(B, rgbMask), rgb);
+  rgb = sse2_select(_mm_cmpeq_epi32(b.a, zero), _mm_and_si128(S, rgbMask), rgb);
+
+  const __m128i Ra = _mm_add_epi32(b.a, sse2_mul_un8_signed(_mm_sub_epi32(s.a, b.a), opacity));
+  rgb = _mm_andnot_si128(_mm_cmpeq_epi32(Ra, zero), rgb);
+  return _mm_or_si128(rgb, _mm_slli_epi32(Ra, rgba_a_shift));
+}
+
+// Separable blend modes: the Op computes each RGB channel from the
+// backdrop and source channels and the result is composited with
+// the normal blender (as the scalar rgba_blender_* functions do).
+
+struct Sse2Normal {
+  static __m128i op(const __m128i, const __m128i s) { return s; }
+};
+
+struct Sse2Multiply {
+  static __m128i op(const __m128i b, const __m128i s) { return sse2_mul_un8(b, s); }
+};
+
+struct Sse2Screen {
+  static __m128i op(const __m128i b, const __m128i s)
+  {
+    return _mm_sub_epi32(_mm_add_epi32(b, s), sse2_mul_un8(b, s));
+  }
+};
+
+struct Sse2HardLight {
+  static __m128i op(const __m128i b, const __m128i s)
+  {
+    const __m128i s2 = _mm_slli_epi32(s, 1);
+    return sse2_select(_mm_cmplt_epi32(s, _mm_set1_epi32(128)),
+                       Sse2Multiply::op(b, s2),
+                       Sse2Screen::op(b, _mm_sub_epi32(s2, _mm_set1_epi32(255))));
+  }
+};
+
+struct Sse2Overlay {
+  static __m128i op(const __m128i b, const __m128i s) { return Sse2HardLight::op(s, b); }
+};
+
+struct Sse2Darken {
+  static __m128i op(const __m128i b, const __m128i s) { return _mm_min_epi16(b, s); }
+};
+
+struct Sse2Lighten {
+  static __m128i op(const __m128i b, const __m128i s) { return _mm_max_epi16(b, s); }
+};
+
+struct Sse2Difference {
+  static __m128i op(const __m128i b, const __m128i s)
+  {
+    return _mm_sub_epi32(_mm_max_epi16(b, s), _mm_min_epi16(b, s));
+  }
+};
+
+struct Sse2Exclusion {
+  static __m128i op(const __m128i b, const __m128i s)
+  {
+    return _mm_sub_epi32(_mm_add_epi32(b, s), _mm_slli_epi32(sse2_mul_un8(b, s), 1));
+  }
+};
+
+struct Sse2Addition {
+  static __m128i op(const __m128i b, const __m128i s)
+  {
+    return _mm_min_epi16(_mm_add_epi32(b, s), _mm_set1_epi32(255));
+  }
+};
+
+struct Sse2Subtract {
+  static __m128i op(const __m128i b, const __m128i s)
+  {
+    return _mm_max_epi16(_mm_sub_epi32(b, s), _mm_setzero_si128());
+  }
+};
+
+template<typename Op>
+inline __m128i sse2_blend(const __m128i B, const __m128i S, const __m128i opacity)
+{
+  const Sse2Channels b = sse2_unpack(B);
+  const Sse2Channels s = sse2_unpack(S);
+  return sse2_blend_normal(
+    B,
+    sse2_pack(Op::op(b.r, s.r), Op::op(b.g, s.g), Op::op(b.b, s.b), s.a),
+    opacity);
+}
+
+// Same as RGBA_BLENDER_N()
+template<typename Op>
+inline __m128i sse2_blend_n(const __m128i B, const __m128i S, const __m128i opacity)
+{
+  const __m128i normal = sse2_blend_normal(B, S, opacity);
+  const __m128i blend = sse2_blend<Op>(B, S, opacity);
+  const __m128i Ba = _mm_srli_epi32(B, rgba_a_shift);
+  const __m128i normalToBlendMerge = sse2_blend_merge(normal, blend, Ba);
+  const __m128i srcTotalAlpha = sse2_mul_un8(_mm_srli_epi32(S, rgba_a_shift), opacity);
+  const __m128i compositeAlpha = sse2_mul_un8(Ba, srcTotalAlpha);
+  const __m128i R = sse2_blend_merge(normalToBlendMerge, blend, compositeAlpha);
+  return sse2_select(_mm_cmpeq_epi32(Ba, _mm_setzero_si128()), normal, R);
+}
+
+// F is the equivalent scalar blender used for the last pixels of
+// the span (when there are less than 4 pixels).
+template<typename Op, bool NewBlend, BlendFunc F>
+void rgba_span_blender_sse2(color_t* dst,
+                            const color_t* src,
+                            int n,
+                            int opacity,
+                            color_t maskColor)
+{
+  const __m128i opacity4 = _mm_set1_epi32(opacity);
+  const __m128i maskColor4 = _mm_set1_epi32(int(maskColor));
+
+  int x = 0;
+  for (; x + 4 <= n; x += 4, dst += 4, src += 4) {
+    const __m128i B = _mm_loadu_si128((const __m128i*)dst);
+    const __m128i S = _mm_loadu_si128((const __m128i*)src);
+    __m128i R;
+    if constexpr (NewBlend)
+      R = sse2_blend_n<Op>(B, S, opacity4);
+    else
+      R = sse2_blend<Op>(B, S, opacity4);
+    _mm_storeu_si128((__m128i*)dst, sse2_select(_mm_cmpeq_epi32(S, maskColor4), B, R));
+  }
+
+  rgba_span_blender<F>(dst, src, n - x, opacity, maskColor);
+}
+
+#endif // DOC_USE_SSE2_BLENDERS
+
+} // anonymous namespace
+
+BlendSpanFunc get_rgba_span_blender(BlendMode blendmode, const bool newBlend)
+{
+#if DOC_USE_SSE2_BLENDERS
+  switch (blendmode) {
+    case BlendMode::NORMAL: return rgba_span_blender_sse2<Sse2Normal, false, rgba_blender_normal>;
+    case BlendMode::MULTIPLY:
+      return newBlend ? rgba_span_blender_sse2<Sse2Multiply, true, rgba_blender_multiply_n> :
+                        rgba_span_blender_sse2<Sse2Multiply, false, rgba_blender_multiply>;
+    case BlendMode::SCREEN:
+      return newBlend ? rgba_span_blender_sse2<Sse2Screen, true, rgba_blender_screen_n> :
+                        rgba_span_blender_sse2<Sse2Screen, false, rgba_blender_screen>;
+    case BlendMode::OVERLAY:
+      return newBlend ? rgba_span_blender_sse2<Sse2Overlay, true, rgba_blender_overlay_n> :
+                        rgba_span_blender_sse2<Sse2Overlay, false, rgba_blender_overlay>;
+    case BlendMode::DARKEN:
+      return newBlend ? rgba_span_blender_sse2<Sse2Darken, true, rgba_blender_darken_n> :
+                        rgba_span_blender_sse2<Sse2Darken, false, rgba_blender_darken>;
+    case BlendMode::LIGHTEN:
+      return newBlend ? rgba_span_blender_sse2<Sse2Lighten, true, rgba_blender_lighten_n> :
+                        rgba_span_blender_sse2<Sse2Lighten, false, rgba_blender_lighten>;
+    case BlendMode::HARD_LIGHT:
+      return newBlend ? rgba_span_blender_sse2<Sse2HardLight, true, rgba_blender_hard_light_n> :
+                        rgba_span_blender_sse2<Sse2HardLight, false, rgba_blender_hard_light>;
+    case BlendMode::DIFFERENCE:
+      return newBlend ? rgba_span_blender_sse2<Sse2Difference, true, rgba_blender_difference_n> :
+                        rgba_span_blender_sse2<Sse2Difference, false, rgba_blender_difference>;
+    case BlendMode::EXCLUSION:
+      return newBlend ? rgba_span_blender_sse2<Sse2Exclusion, true, rgba_blender_exclusion_n> :
+                        rgba_span_blender_sse2<Sse2Exclusion, false, rgba_blender_exclusion>;
+    case BlendMode::ADDITION:
+      return newBlend ? rgba_span_blender_sse2<Sse2Addition, true, rgba_blender_addition_n> :
+                        rgba_span_blender_sse2<Sse2Addition, false, rgba_blender_addition>;
+    case BlendMode::SUBTRACT:
+      return newBlend ? rgba_span_blender_sse2<Sse2Subtract, true, rgba_blender_subtract_n> :
+                        rgba_span_blender_sse2<Sse2Subtract, false, rgba_blender_subtract>;
+    default:
+      // Use the generic span blenders for the rest of modes
+      break;
+  }
+#endif
+
+  switch (blendmode) {
+    case BlendMode::SRC:       return rgba_span_blender_src;
+    case BlendMode::MERGE:     return rgba_span_blender<rgba_blender_merge>;
+    case BlendMode::NEG_BW:    return rgba_span_blender<rgba_blender_neg_bw>;
+    case BlendMode::RED_TINT:  return rgba_span_blender<rgba_blender_red_tint>;
+    case BlendMode::BLUE_TINT: return rgba_span_blender<rgba_blender_blue_tint>;
+    case BlendMode::DST_OVER:  return rgba_span_blender<rgba_blender_normal_dst_over>;
+
+    case BlendMode::NORMAL: return rgba_span_blender<rgba_blender_normal>;
+    case BlendMode::MULTIPLY:
+      return newBlend ? rgba_span_blender<rgba_blender_multiply_n> :
+                        rgba_span_blender<rgba_blender_multiply>;
+    case BlendMode::SCREEN:
+      return newBlend ? rgba_span_blender<rgba_blender_screen_n> :
+                        rgba_span_blender<rgba_blender_screen>;
+    case BlendMode::OVERLAY:
+      return newBlend ? rgba_span_blender<rgba_blender_overlay_n> :
+                        rgba_span_blender<rgba_blender_overlay>;
+    case BlendMode::DARKEN:
+      return newBlend ? rgba_span_blender<rgba_blender_darken_n> :
+                        rgba_span_blender<rgba_blender_darken>;
+    case BlendMode::LIGHTEN:
+      return newBlend ? rgba_span_blender<rgba_blender_lighten_n> :
+                        rgba_span_blender<rgba_blender_lighten>;
+    case BlendMode::COLOR_DODGE:
+      return newBlend ? rgba_span_blender<rgba_blender_color_dodge_n> :
+                        rgba_span_blender<rgba_blender_color_dodge>;
+    case BlendMode::COLOR_BURN:
+      return newBlend ? rgba_span_blender<rgba_blender_color_burn_n> :
+                        rgba_span_blender<rgba_blender_color_burn>;
+    case BlendMode::HARD_LIGHT:
+      return newBlend ? rgba_span_blender<rgba_blender_hard_light_n> :
+                        rgba_span_blender<rgba_blender_hard_light>;
+    case BlendMode::SOFT_LIGHT:
+      return newBlend ? rgba_span_blender<rgba_blender_soft_light_n> :
+                        rgba_span_blender<rgba_blender_soft_light>;
+    case BlendMode::DIFFERENCE:
+      return newBlend ? rgba_span_blender<rgba_blender_difference_n> :
+                        rgba_span_blender<rgba_blender_difference>;
+    case BlendMode::EXCLUSION:
+      return newBlend ? rgba_span_blender<rgba_blender_exclusion_n> :
+                        rgba_span_blender<rgba_blender_exclusion>;
+    case BlendMode::HSL_HUE:
+      return newBlend ? rgba_span_blender<rgba_blender_hsl_hue_n> :
+                        rgba_span_blender<rgba_blender_hsl_hue>;
+    case BlendMode::HSL_SATURATION:
+      return newBlend ? rgba_span_blender<rgba_blender_hsl_saturation_n> :
+                        rgba_span_blender<rgba_blender_hsl_saturation>;
+    case BlendMode::HSL_COLOR:
+      return newBlend ? rgba_span_blender<rgba_blender_hsl_color_n> :
+                        rgba_span_blender<rgba_blender_hsl_color>;
+    case BlendMode::HSL_LUMINOSITY:
+      return newBlend ? rgba_span_blender<rgba_blender_hsl_luminosity_n> :
+                        rgba_span_blender<rgba_blender_hsl_luminosity>;
+    case BlendMode::ADDITION:
+      return newBlend ? rgba_span_blender<rgba_blender_addition_n> :
+                        rgba_span_blender<rgba_blender_addition>;
+    case BlendMode::SUBTRACT:
+      return newBlend ? rgba_span_blender<rgba_blender_subtract_n> :
+                        rgba_span_blender<rgba_blender_subtract>;
+    case BlendMode::DIVIDE:
+      return newBlend ? rgba_span_blender<rgba_blender_divide_n> :
+                        rgba_span_blender<rgba_blender_divide>;
+  }
+  ASSERT(false);
+  return rgba_span_blender_src;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Merge spans
+
+namespace {
+
+// Src is a function that returns the source color of the i-th pixel
+template<typename Src>
+void rgba_merge_span_impl(color_t* dst,
+                          const color_t* backdrop,
+                          Src&& src,
+                          const int n,
+                          const int opacity)
+{
+  int x = 0;
+#if DOC_USE_SSE2_BLENDERS
+  const __m128i opacity4 = _mm_set1_epi32(opacity);
+  for (; x + 4 <= n; x += 4) {
+    const __m128i B = _mm_loadu_si128((const __m128i*)(backdrop + x));
+    _mm_storeu_si128((__m128i*)(dst + x), sse2_blend_merge(B, src.sse2(x), opacity4));
+  }
+#endif
+  for (; x < n; ++x)
+    dst[x] = rgba_blender_merge(backdrop[x], src(x), opacity);
+}
+
+#if DOC_USE_SSE2_BLENDERS
+
+// Same as graya_blender_merge() for 4 grayscale pixels in 32-bit lanes
+inline __m128i sse2_graya_blend_merge(const __m128i B, const __m128i S, const __m128i opacity)
+{
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i m = _mm_set1_epi32(0xff);
+  const __m128i Bv = _mm_and_si128(B, m);
+  const __m128i Ba = _mm_srli_epi32(B, graya_a_shift);
+  const __m128i Sv = _mm_and_si128(S, m);
+  const __m128i Sa = _mm_srli_epi32(S, graya_a_shift);
+
+  __m128i v = _mm_add_epi32(Bv, sse2_mul_un8_signed(_mm_sub_epi32(Sv, Bv), opacity));
+  v = sse2_select(_mm_cmpeq_epi32(Sa, zero), Bv, v);
+  v = sse2_select(_mm_cmpeq_epi32(Ba, zero), Sv, v);
+
+  const __m128i Ra = _mm_add_epi32(Ba, sse2_mul_un8_signed(_mm_sub_epi32(Sa, Ba), opacity));
+  v = _mm_andnot_si128(_mm_cmpeq_epi32(Ra, zero), v);
+  return _mm_or_si128(v, _mm_slli_epi32(Ra, graya_a_shift));
+}
+
+// Packs the 16-bit values of two registers with 32-bit lanes
+// (_mm_packs_epi32() saturates signed values, so the values are
+// sign-extended first to keep the same 16 bits).
+inline __m128i sse2_pack_u16(const __m128i lo, const __m128i hi)
+{
+  return _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(lo, 16), 16),
+                         _mm_srai_epi32(_mm_slli_epi32(hi, 16), 16));
+}
+
+#endif // DOC_USE_SSE2_BLENDERS
+
+template<typename Src>
+void graya_merge_span_impl(uint16_t* dst,
+                           const uint16_t* backdrop,
+                           Src&& src,
+                           const int n,
+                           const int opacity)
+{
+  int x = 0;
+#if DOC_USE_SSE2_BLENDERS
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i opacity4 = _mm_set1_epi32(opacity);
+  for (; x + 8 <= n; x += 8) {
+    const __m128i B = _mm_loadu_si128((const __m128i*)(backdrop + x));
+    const __m128i S = src.sse2(x);
+    const __m128i lo =
+      sse2_graya_blend_merge(_mm_unpacklo_epi16(B, zero), _mm_unpacklo_epi16(S, zero), opacity4);
+    const __m128i hi =
+      sse2_graya_blend_merge(_mm_unpackhi_epi16(B, zero), _mm_unpackhi_epi16(S, zero), opacity4);
+    _mm_storeu_si128((__m128i*)(dst + x), sse2_pack_u16(lo, hi));
+  }
+#endif
+  for (; x < n; ++x)
+    dst[x] = uint16_t(graya_blender_merge(backdrop[x], src(x), opacity));
+}
+
+template<typename T>
+struct SpanSrc {
+  const T* src;
+  color_t operator()(const int x) const { return src[x]; }
+#if DOC_USE_SSE2_BLENDERS
+  __m128i sse2(const int x) const { return _mm_loadu_si128((const __m128i*)(src + x)); }
+#endif
+};
+
+struct SolidSrc {
+  color_t color;
+#if DOC_USE_SSE2_BLENDERS
+  __m128i color4;
+#endif
+  color_t operator()(const int) const { return color; }
+#if DOC_USE_SSE2_BLENDERS
+  __m128i sse2(const int) const { return color4; }
+#endif
+};
+
+SolidSrc rgba_solid_src(const color_t color)
+{
+#if DOC_USE_SSE2_BLENDERS
+  return { color, _mm_set1_epi32(int(color)) };
+#else
+  return { color };
+#endif
+}
+
+SolidSrc graya_solid_src(const color_t color)
+{
+#if DOC_USE_SSE2_BLENDERS
+  return { color, _mm_set1_epi16(short(color)) };
+#else
+  return { color };
+#endif
+}
+
+} // anonymous namespace
+
+void rgba_merge_span(color_t* dst,
+                     const color_t* backdrop,
+                     const color_t* src,
+                     const int n,
+                     const int opacity)
+{
+  rgba_merge_span_impl(dst, backdrop, SpanSrc<color_t>{ src }, n, opacity);
+}
+
+void rgba_merge_span(color_t* dst,
+                     const color_t* backdrop,
+                     const color_t src,
+                     const int n,
+                     const int opacity)
+{
+  rgba_merge_span_impl(dst, backdrop, rgba_solid_src(src), n, opacity);
+}
+
+void graya_merge_span(uint16_t* dst,
+                      const uint16_t* backdrop,
+                      const uint16_t* src,
+                      const int n,
+                      const int opacity)
+{
+  graya_merge_span_impl(dst, backdrop, SpanSrc<uint16_t>{ src }, n, opacity);
+}
+
+void graya_merge_span(uint16_t* dst,
+                      const uint16_t* backdrop,
+                      const color_t src,
+                      const int n,
+                      const int opacity)
+{
+  graya_merge_span_impl(dst, backdrop, graya_solid_src(src), n, opacity);
+}
+
 } // namespace doc
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (C) 2019  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (c) 2001-2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -16,6 +16,16 @@ namespace doc {
 
 typedef color_t (*BlendFunc)(color_t backdrop, color_t src, int opacity);
 
+// Blends a whole span of n pixels: dst[i] = blend(dst[i], src[i],
+// opacity) for each src[i] != maskColor (the same behavior as
+// BlenderHelper). The result is the same as the BlendFunc for the
+// same blend mode, but it might use SIMD instructions.
+typedef void (*BlendSpanFunc)(color_t* dst,
+                              const color_t* src,
+                              int n,
+                              int opacity,
+                              color_t maskColor);
+
 color_t rgba_blender_src(color_t backdrop, color_t src, int opacity);
 color_t rgba_blender_merge(color_t backdrop, color_t src, int opacity);
 color_t rgba_blender_neg_bw(color_t backdrop, color_t src, int opacity);
@@ -68,6 +78,25 @@ BlendFunc get_rgba_blender(BlendMode blendmode, const bool newBlend);
 BlendFunc get_graya_blender(BlendMode blendmode, const bool newBlend);
 BlendFunc get_indexed_blender(BlendMode blendmode, const bool newBlend);
 
+BlendSpanFunc get_rgba_span_blender(BlendMode blendmode, const bool newBlend);
+
+// Merges a span of n pixels: dst[i] = rgba/graya_blender_merge(
+// backdrop[i], src[i], opacity) (or the same src color for all
+// pixels). The result is exactly the same as the scalar blender, but
+// it might use SIMD instructions. dst can be equal to backdrop.
+void rgba_merge_span(color_t* dst,
+                     const color_t* backdrop,
+                     const color_t* src,
+                     int n,
+                     int opacity);
+void rgba_merge_span(color_t* dst, const color_t* backdrop, color_t src, int n, int opacity);
+void graya_merge_span(uint16_t* dst,
+                      const uint16_t* backdrop,
+                      const uint16_t* src,
+                      int n,
+                      int opacity);
+void graya_merge_span(uint16_t* dst, const uint16_t* backdrop, color_t src, int n, int opacity);
+
 } // namespace doc
 
 #endif
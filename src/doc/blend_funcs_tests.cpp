@@ -0,0 +1,114 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "doc/blend_funcs.h"
+
+#include <random>
+#include <vector>
+
+using namespace doc;
+
+static color_t random_color(std::mt19937& rng)
+{
+  color_t c = rng();
+  switch (rng() % 5) {
+    case 0: c &= rgba_rgb_mask; break; // Transparent
+    case 1: c |= rgba_a_mask; break;   // Opaque
+    case 2: c = 0; break;              // Mask color
+  }
+  return c;
+}
+
+TEST(BlendFuncs, SpanBlendersMatchScalarBlenders)
+{
+  std::mt19937 rng(1);
+
+  for (int mode = int(BlendMode::DST_OVER); mode <= int(BlendMode::DIVIDE); ++mode) {
+    if (mode == int(BlendMode::UNSPECIFIED))
+      continue;
+
+    for (bool newBlend : { false, true }) {
+      const BlendMode blendMode = BlendMode(mode);
+      const BlendFunc blend = get_rgba_blender(blendMode, newBlend);
+      const BlendSpanFunc blendSpan = get_rgba_span_blender(blendMode, newBlend);
+
+      for (int i = 0; i < 2000; ++i) {
+        // Different lengths to test the SIMD and scalar parts of
+        // each span.
+        const int n = 1 + (rng() % 13);
+        const int opacity = (rng() % 4 == 0 ? 255 : rng() % 256);
+        std::vector<color_t> dst(n), src(n), expected(n);
+        for (int x = 0; x < n; ++x) {
+          dst[x] = random_color(rng);
+          src[x] = random_color(rng);
+          if (blendMode == BlendMode::SRC)
+            expected[x] = src[x];
+          else if (src[x] != 0)
+            expected[x] = blend(dst[x], src[x], opacity);
+          else
+            expected[x] = dst[x];
+        }
+
+        blendSpan(dst.data(), src.data(), n, opacity, 0);
+
+        for (int x = 0; x < n; ++x) {
+          ASSERT_EQ(expected[x], dst[x])
+            << "blendMode=" << mode << " newBlend=" << newBlend << " opacity=" << opacity;
+        }
+      }
+    }
+  }
+}
+
+TEST(BlendFuncs, MergeSpansMatchScalarBlenders)
+{
+  std::mt19937 rng(2);
+
+  for (int i = 0; i < 5000; ++i) {
+    const int n = 1 + (rng() % 21);
+    const int opacity = (rng() % 4 == 0 ? 255 : rng() % 256);
+    std::vector<color_t> backdrop(n), src(n), dst(n);
+    std::vector<uint16_t> grayBackdrop(n), graySrc(n), grayDst(n);
+    for (int x = 0; x < n; ++x) {
+      backdrop[x] = random_color(rng);
+      src[x] = random_color(rng);
+      grayBackdrop[x] = uint16_t(graya(rng() % 256, rng() % 3 == 0 ? 0 : rng() % 256));
+      graySrc[x] = uint16_t(graya(rng() % 256, rng() % 3 == 0 ? 0 : rng() % 256));
+    }
+
+    rgba_merge_span(dst.data(), backdrop.data(), src.data(), n, opacity);
+    for (int x = 0; x < n; ++x)
+      ASSERT_EQ(rgba_blender_merge(backdrop[x], src[x], opacity), dst[x]) << "opacity=" << opacity;
+
+    rgba_merge_span(dst.data(), backdrop.data(), src[0], n, opacity);
+    for (int x = 0; x < n; ++x)
+      ASSERT_EQ(rgba_blender_merge(backdrop[x], src[0], opacity), dst[x]) << "opacity=" << opacity;
+
+    graya_merge_span(grayDst.data(), grayBackdrop.data(), graySrc.data(), n, opacity);
+    for (int x = 0; x < n; ++x) {
+      ASSERT_EQ(graya_blender_merge(grayBackdrop[x], graySrc[x], opacity), grayDst[x])
+        << "opacity=" << opacity;
+    }
+
+    graya_merge_span(grayDst.data(), grayBackdrop.data(), graySrc[0], n, opacity);
+    for (int x = 0; x < n; ++x) {
+      ASSERT_EQ(graya_blender_merge(grayBackdrop[x], graySrc[0], opacity), grayDst[x])
+        << "opacity=" << opacity;
+    }
+  }
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2019-2024 Igara Studio S.A.
+// Copyright (c) 2019-2026 Igara Studio S.A.
 // Copyright (c) 2001-2016 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -15,6 +15,7 @@
 #include "doc/image.h"
 #include "doc/layer.h"
 #include "doc/layer_tilemap.h"
+#include "doc/render_plan.h"
 #include "doc/sprite.h"
 #include "doc/tile.h"
 #include "gfx/rect.h"
@@ -40,7 +41,21 @@ Cel::Cel(frame_t frame, const CelDataRef& celData)
 // static
 Cel* Cel::MakeCopy(const frame_t newFrame, const Cel* other)
 {
-  Cel* cel = new Cel(newFrame, ImageRef(Image::createCopy(other->image())));
+  Cel* cel;
+
+  // Unmodified images that weren't decoded yet (or can be decoded
+  // again) are shared with the original file instead of copied.
+  LazyImageRef lazyImage;
+  if (const LazyImageRef& otherLazyImage = other->data()->lazyImage())
+    lazyImage = otherLazyImage->clone();
+
+  if (lazyImage) {
+    cel = new Cel(newFrame, ImageRef(nullptr));
+    cel->data()->setLazyImage(lazyImage, nullptr);
+  }
+  else {
+    cel = new Cel(newFrame, ImageRef(Image::createCopy(other->image())));
+  }
 
   cel->setPosition(other->position());
   cel->setOpacity(other->opacity());
@@ -95,7 +110,10 @@ void Cel::setOpacity(int opacity)
 
 void Cel::setZIndex(int zindex)
 {
-  m_zIndex = zindex;
+  if (m_zIndex != zindex) {
+    m_zIndex = zindex;
+    RenderPlan::incrementStructureVersion();
+  }
 }
 
 Document* Cel::document() const
@@ -174,8 +192,13 @@ void Cel::copyNonsharedPropertiesFrom(const Cel* fromCel)
 
 void Cel::fixupImage()
 {
-  // Change the mask color to the sprite mask color
-  if (m_layer && image()) {
+  // Change the mask color to the sprite mask color (without decoding
+  // lazy images)
+  if (m_layer && m_data && m_data->lazyImage()) {
+    m_data->lazyImage()->setMaskColor(m_layer->sprite()->transparentColor());
+    m_data->adjustBounds(m_layer);
+  }
+  else if (m_layer && image()) {
     image()->setMaskColor(
       (image()->pixelFormat() == IMAGE_TILEMAP) ? notile : m_layer->sprite()->transparentColor());
     ASSERT(m_data);
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2019-2024 Igara Studio S.A.
+// Copyright (c) 2019-2026 Igara Studio S.A.
 // Copyright (c) 2001-2016 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -53,6 +53,10 @@ public:
   Cel* link() const;
   std::size_t links() const;
 
+  // Returns true if the CelData is referenced only by this cel (so
+  // it's not a linked cel and it cannot be visited twice).
+  bool hasUniqueData() const { return m_data.use_count() == 1; }
+
   // You should change the frame only if the cel isn't member of a
   // layer. If the cel is already in a layer, you should use
   // LayerImage::moveCel() member function.
@@ -75,6 +79,10 @@ public:
   void copyNonsharedPropertiesFrom(const Cel* fromCel);
 
 private:
+  // To change the frame of cels that are already in the layer (see
+  // LayerImage::displaceFrames()).
+  friend class LayerImage;
+
   void fixupImage();
 
   LayerImage* m_layer;
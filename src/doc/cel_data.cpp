@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2019-2022 Igara Studio S.A.
+// Copyright (c) 2019-2026 Igara Studio S.A.
 // Copyright (c) 2001-2016 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -32,6 +32,7 @@ CelData::CelData(const ImageRef& image)
 CelData::CelData(const CelData& celData)
   : WithUserData(ObjectType::CelData)
   , m_image(celData.m_image)
+  , m_lazyImage(celData.m_lazyImage)
   , m_opacity(celData.m_opacity)
   , m_bounds(celData.m_bounds)
   , m_boundsF(celData.m_boundsF ? std::make_unique<gfx::RectF>(*celData.m_boundsF) : nullptr)
@@ -47,6 +48,17 @@ void CelData::setImage(const ImageRef& image, Layer* layer)
   ASSERT(image.get());
 
   m_image = image;
+  m_lazyImage.reset();
+  adjustBounds(layer);
+}
+
+void CelData::setLazyImage(const LazyImageRef& lazyImage, Layer* layer)
+{
+  ASSERT(lazyImage.get());
+  ASSERT(lazyImage->pixelFormat() != IMAGE_TILEMAP);
+
+  m_image.reset();
+  m_lazyImage = lazyImage;
   adjustBounds(layer);
 }
 
@@ -59,6 +71,13 @@ void CelData::setPosition(const gfx::Point& pos)
 
 void CelData::adjustBounds(Layer* layer)
 {
+  // Lazy images cannot be tilemaps
+  if (m_lazyImage) {
+    m_bounds.w = m_lazyImage->width();
+    m_bounds.h = m_lazyImage->height();
+    return;
+  }
+
   ASSERT(m_image);
   if (m_image->pixelFormat() == IMAGE_TILEMAP) {
     Tileset* tileset = nullptr;
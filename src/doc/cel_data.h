@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (C) 2019-2022  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2016  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "doc/image_ref.h"
+#include "doc/lazy_image.h"
 #include "doc/object.h"
 #include "doc/with_user_data.h"
 #include "gfx/rect.h"
@@ -30,8 +31,23 @@ public:
   gfx::Point position() const { return m_bounds.origin(); }
   const gfx::Rect& bounds() const { return m_bounds; }
   int opacity() const { return m_opacity; }
-  Image* image() const { return const_cast<Image*>(m_image.get()); };
-  ImageRef imageRef() const { return m_image; }
+  Image* image() const
+  {
+    if (m_lazyImage)
+      return m_lazyImage->image().get();
+    return const_cast<Image*>(m_image.get());
+  };
+  ImageRef imageRef() const
+  {
+    if (m_lazyImage)
+      return m_lazyImage->image();
+    return m_image;
+  }
+
+  // The image of this cel will be decoded from the given lazy image
+  // when it's needed (until a new image is set with setImage()).
+  const LazyImageRef& lazyImage() const { return m_lazyImage; }
+  void setLazyImage(const LazyImageRef& lazyImage, Layer* layer);
 
   // Returns a rectangle with the bounds of the image (width/height
   // of the image) in the position of the cel (useful to compare
@@ -39,6 +55,8 @@ public:
   // bounds).
   gfx::Rect imageBounds() const
   {
+    if (m_lazyImage)
+      return gfx::Rect(m_bounds.x, m_bounds.y, m_lazyImage->width(), m_lazyImage->height());
     return gfx::Rect(m_bounds.x, m_bounds.y, m_image->width(), m_image->height());
   }
 
@@ -81,14 +99,15 @@ public:
 
   virtual int getMemSize() const override
   {
-    ASSERT(m_image);
-    return sizeof(CelData) + m_image->getMemSize();
+    ASSERT(m_image || m_lazyImage);
+    return sizeof(CelData) + image()->getMemSize();
   }
 
   void adjustBounds(Layer* layer);
 
 private:
   ImageRef m_image;
+  LazyImageRef m_lazyImage;
   int m_opacity;
   gfx::Rect m_bounds;
 
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2019-2023 Igara Studio S.A.
+// Copyright (c) 2019-2026 Igara Studio S.A.
 // Copyright (c) 2001-2016 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -56,7 +56,7 @@ CelsRange::iterator::iterator(const Sprite* sprite,
       layer = layer->getNextInWholeHierarchy();
   }
 
-  if (m_cel && flags == CelsRange::UNIQUE)
+  if (m_cel && flags == CelsRange::UNIQUE && !m_cel->hasUniqueData())
     m_visited.insert(m_cel->data()->id());
 }
 
@@ -76,13 +76,11 @@ CelsRange::iterator& CelsRange::iterator::operator++()
       for (; m_frameIterator != endFrame; ++m_frameIterator) {
         m_cel = layer->cel(*m_frameIterator);
         if (m_cel) {
-          if (m_flags == CelsRange::UNIQUE) {
-            if (m_visited.find(m_cel->data()->id()) == m_visited.end()) {
-              m_visited.insert(m_cel->data()->id());
-              break;
-            }
-            else
-              m_cel = nullptr;
+          // Cels with unique data cannot be linked with a visited
+          // cel, so we don't need to check/insert their IDs.
+          if (m_flags == CelsRange::UNIQUE && !m_cel->hasUniqueData() &&
+              !m_visited.insert(m_cel->data()->id()).second) {
+            m_cel = nullptr;
           }
           else
             break;
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2023 Igara Studio S.A.
+// Copyright (c) 2023-2026 Igara Studio S.A.
 // Copyright (c) 2001-2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -14,7 +14,7 @@
 #include "doc/object_id.h"
 #include "doc/selected_frames.h"
 
-#include <set>
+#include <unordered_set>
 
 namespace doc {
 
@@ -56,7 +56,10 @@ public:
     const SelectedFrames& m_selFrames;
     frames::const_iterator m_frameIterator;
     Flags m_flags;
-    std::set<ObjectId> m_visited;
+
+    // IDs of visited CelData that are shared between cels (only used
+    // with the UNIQUE flag).
+    std::unordered_set<ObjectId> m_visited;
   };
 
   iterator begin() { return m_begin; }
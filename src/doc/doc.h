@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (C) 2019-2020  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -33,6 +33,7 @@
 #include "doc/primitives_fast.h"
 #include "doc/remap.h"
 #include "doc/rgbmap.h"
+#include "doc/rgbmap_precomputed.h"
 #include "doc/rgbmap_rgb5a3.h"
 #include "doc/slice.h"
 #include "doc/slices.h"
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2018-2024 Igara Studio S.A.
+// Copyright (c) 2018-2026 Igara Studio S.A.
 // Copyright (c) 2001-2016 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -12,12 +12,15 @@
 #include "doc/image.h"
 
 #include "doc/algo.h"
+#include "doc/algorithm/shrink_bounds.h"
 #include "doc/brush.h"
 #include "doc/image_impl.h"
 #include "doc/palette.h"
 #include "doc/primitives.h"
 #include "doc/rgbmap.h"
 
+#include <algorithm>
+
 namespace doc {
 
 Image::Image(const ImageSpec& spec) : Object(ObjectType::Image), m_spec(spec)
@@ -33,6 +36,34 @@ int Image::getMemSize() const
   return sizeof(Image) + rowBytes() * height();
 }
 
+bool Image::opaqueBounds(gfx::Rect& bounds) const
+{
+  ASSERT(!isTilemap());
+
+  const std::lock_guard lock(m_opaqueBoundsMutex);
+  if (!m_opaqueBounds.valid || m_opaqueBounds.version != version() ||
+      m_opaqueBounds.maskColor != maskColor()) {
+    m_opaqueBounds.empty =
+      !algorithm::shrink_bounds(this, maskColor(), nullptr, m_opaqueBounds.bounds);
+    m_opaqueBounds.version = version();
+    m_opaqueBounds.maskColor = maskColor();
+    m_opaqueBounds.valid = true;
+  }
+  bounds = m_opaqueBounds.bounds;
+  return !m_opaqueBounds.empty;
+}
+
+uint64_t Image::contentHash() const
+{
+  const std::lock_guard lock(m_contentHashMutex);
+  if (!m_contentHash.valid || m_contentHash.version != version()) {
+    m_contentHash.hash = calculate_image_hash64(this, bounds());
+    m_contentHash.version = version();
+    m_contentHash.valid = true;
+  }
+  return m_contentHash.hash;
+}
+
 // static
 Image* Image::create(PixelFormat format, int width, int height, const ImageBufferPtr& buffer)
 {
@@ -56,6 +87,21 @@ Image* Image::create(const ImageSpec& spec, const ImageBufferPtr& buffer)
   return nullptr;
 }
 
+// static
+std::size_t Image::requiredBufferSize(const ImageSpec& spec)
+{
+  const int w = std::max(1, spec.width());
+  const int h = std::max(1, spec.height());
+  switch (spec.colorMode()) {
+    case ColorMode::RGB:       return ImageImpl<RgbTraits>::requiredBufferSize(w, h);
+    case ColorMode::GRAYSCALE: return ImageImpl<GrayscaleTraits>::requiredBufferSize(w, h);
+    case ColorMode::INDEXED:   return ImageImpl<IndexedTraits>::requiredBufferSize(w, h);
+    case ColorMode::BITMAP:    return ImageImpl<BitmapTraits>::requiredBufferSize(w, h);
+    case ColorMode::TILEMAP:   return ImageImpl<TilemapTraits>::requiredBufferSize(w, h);
+  }
+  return 1;
+}
+
 // static
 Image* Image::createCopy(const Image* image, const ImageBufferPtr& buffer)
 {
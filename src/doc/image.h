@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2018-2024 Igara Studio S.A.
+// Copyright (c) 2018-2026 Igara Studio S.A.
 // Copyright (c) 2001-2016 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -20,6 +20,8 @@
 #include "gfx/rect.h"
 #include "gfx/size.h"
 
+#include <mutex>
+
 namespace doc {
 
 template<typename ImageTraits>
@@ -43,6 +45,10 @@ public:
   static Image* create(const ImageSpec& spec, const ImageBufferPtr& buffer = ImageBufferPtr());
   static Image* createCopy(const Image* image, const ImageBufferPtr& buffer = ImageBufferPtr());
 
+  // Size of the ImageBuffer needed to create an image with the given
+  // spec (e.g. to get a buffer from the ImageBufferPool).
+  static std::size_t requiredBufferSize(const ImageSpec& spec);
+
   virtual ~Image();
 
   const ImageSpec& spec() const { return m_spec; }
@@ -74,6 +80,21 @@ public:
 
   virtual int getMemSize() const override;
 
+  // Returns the bounds of the pixels that are different from the mask
+  // color, or false if the whole image is transparent (it cannot be
+  // used with tilemaps, as the tiles are in the tileset). The result
+  // is cached until the version of the image (or its mask color)
+  // changes, so incrementVersion() must be called after modifying
+  // the pixels of an image that was already trimmed. It can be
+  // called from several threads.
+  bool opaqueBounds(gfx::Rect& bounds) const;
+
+  // Returns a 64-bit hash of all the pixels of the image (see
+  // calculate_image_hash64()). As with opaqueBounds(), the hash is
+  // cached until the version of the image changes, and it can be
+  // called from several threads.
+  uint64_t contentHash() const;
+
   template<typename ImageTraits>
   ImageBits<ImageTraits> lockBits(LockType lockType, const gfx::Rect& bounds)
   {
@@ -126,7 +147,25 @@ protected:
   size_t m_rowBytes;
 
 private:
+  struct OpaqueBounds {
+    bool valid = false;
+    ObjectVersion version = 0;
+    color_t maskColor = 0;
+    bool empty = true;
+    gfx::Rect bounds;
+  };
+
+  struct ContentHash {
+    bool valid = false;
+    ObjectVersion version = 0;
+    uint64_t hash = 0;
+  };
+
   ImageSpec m_spec;
+  mutable std::mutex m_opaqueBoundsMutex;
+  mutable OpaqueBounds m_opaqueBounds;
+  mutable std::mutex m_contentHashMutex;
+  mutable ContentHash m_contentHash;
 };
 
 } // namespace doc
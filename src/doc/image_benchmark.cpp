@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2024 Igara Studio S.A.
+// Copyright (c) 2024-2026 Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -11,6 +11,7 @@
 #include "doc/algorithm/random_image.h"
 #include "doc/image.h"
 #include "doc/image_ref.h"
+#include "doc/primitives.h"
 
 #include <benchmark/benchmark.h>
 
@@ -133,6 +134,71 @@ void BM_ReadIterator(benchmark::State& state)
   }
 }
 
+void BM_IsPlainImage(benchmark::State& state)
+{
+  const auto pf = (PixelFormat)state.range(0);
+  const int w = state.range(1);
+  const int h = state.range(2);
+  ImageRef img(Image::create(pf, w, h));
+  clear_image(img.get(), 0);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(is_plain_image(img.get(), 0));
+  }
+}
+
+void BM_CountDiffBetweenImages(benchmark::State& state)
+{
+  const auto pf = (PixelFormat)state.range(0);
+  const int w = state.range(1);
+  const int h = state.range(2);
+  ImageRef a(Image::create(pf, w, h));
+  doc::algorithm::random_image(a.get());
+  ImageRef b(Image::createCopy(a.get()));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(count_diff_between_images(a.get(), b.get()));
+  }
+}
+
+void BM_DiffBoundsBetweenImages(benchmark::State& state)
+{
+  const auto pf = (PixelFormat)state.range(0);
+  const int w = state.range(1);
+  const int h = state.range(2);
+  ImageRef a(Image::create(pf, w, h));
+  doc::algorithm::random_image(a.get());
+  ImageRef b(Image::createCopy(a.get()));
+  put_pixel(b.get(), w / 2, h / 2, get_pixel(a.get(), w / 2, h / 2) ^ 1);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(get_diff_bounds_between_images(a.get(), b.get()));
+  }
+}
+
+void BM_CalculateImageHash(benchmark::State& state)
+{
+  const auto pf = (PixelFormat)state.range(0);
+  const int w = state.range(1);
+  const int h = state.range(2);
+  ImageRef img(Image::create(pf, w, h));
+  doc::algorithm::random_image(img.get());
+  const gfx::Rect bounds(1, 1, w - 2, h - 2);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(calculate_image_hash(img.get(), bounds));
+  }
+}
+
+void BM_CalculateImageHash64(benchmark::State& state)
+{
+  const auto pf = (PixelFormat)state.range(0);
+  const int w = state.range(1);
+  const int h = state.range(2);
+  ImageRef img(Image::create(pf, w, h));
+  doc::algorithm::random_image(img.get());
+  const gfx::Rect bounds(1, 1, w - 2, h - 2);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(calculate_image_hash64(img.get(), bounds));
+  }
+}
+
 #define DEFARGS()                                                                                  \
   ->Args({ IMAGE_RGB, 1024, 1024 })                                                                \
     ->Args({ IMAGE_GRAYSCALE, 1024, 1024 })                                                        \
@@ -167,4 +233,19 @@ DEFARGS()->UseRealTime();
 BENCHMARK(BM_ReadIterator)
 DEFARGS_ADDRESSABLE_ONLY()->UseRealTime();
 
+BENCHMARK(BM_IsPlainImage)
+DEFARGS()->UseRealTime();
+
+BENCHMARK(BM_CountDiffBetweenImages)
+DEFARGS()->UseRealTime();
+
+BENCHMARK(BM_DiffBoundsBetweenImages)
+DEFARGS()->UseRealTime();
+
+BENCHMARK(BM_CalculateImageHash)
+DEFARGS_ADDRESSABLE_ONLY()->UseRealTime();
+
+BENCHMARK(BM_CalculateImageHash64)
+DEFARGS_ADDRESSABLE_ONLY()->UseRealTime();
+
 BENCHMARK_MAIN();
@@ -0,0 +1,211 @@
+// Aseprite Document Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "doc/image_buffer_pool.h"
+
+#include "doc/image.h"
+#include "tracing/metrics.h"
+
+#include <iterator>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace doc {
+
+static tracing::Counter g_allocated("doc.image_buffers.allocated");
+static tracing::Counter g_allocatedBytes("doc.image_buffers.allocated_bytes");
+static tracing::Counter g_reused("doc.image_buffers.reused");
+
+namespace {
+
+// Smallest size class, smaller buffers are not worth to be reused.
+constexpr std::size_t kMinSizeClass = 4096;
+
+// Biggest power of two that is less or equal than the given size
+// (which must be >= kMinSizeClass).
+std::size_t size_class_pow2(const std::size_t size)
+{
+  std::size_t pow2 = kMinSizeClass;
+  while (pow2 <= size / 2)
+    pow2 *= 2;
+  return pow2;
+}
+
+// Biggest size class that is less or equal than the given size (or
+// 0 if the size is smaller than the smallest class).
+std::size_t size_class_floor(const std::size_t size)
+{
+  if (size < kMinSizeClass)
+    return 0;
+
+  const std::size_t step = size_class_pow2(size) / 4;
+  return (size / step) * step;
+}
+
+} // anonymous namespace
+
+class ImageBufferPool::Impl {
+public:
+  explicit Impl(const std::size_t maxBytes) : m_maxBytes(maxBytes) {}
+
+  // Returns an unused buffer of the given size class (or nullptr).
+  ImageBuffer* take(const std::size_t size)
+  {
+    const std::lock_guard lock(m_mutex);
+    auto it = m_unused.find(size);
+    if (it == m_unused.end())
+      return nullptr;
+
+    ImageBuffer* buffer = it->second.release();
+    m_unused.erase(it);
+    m_bytes -= size;
+    return buffer;
+  }
+
+  void release(ImageBuffer* buffer)
+  {
+    // The buffer can be bigger than its original size class (if it
+    // was resized by Image::create()), so we put it in the biggest
+    // size class that it can hold.
+    const std::size_t size = size_class_floor(buffer->size());
+    if (size > 0) {
+      const std::lock_guard lock(m_mutex);
+      if (m_bytes + size <= m_maxBytes) {
+        m_unused.emplace(size, std::unique_ptr<ImageBuffer>(buffer));
+        m_bytes += size;
+        return;
+      }
+    }
+    delete buffer;
+  }
+
+  std::size_t unusedBytes() const
+  {
+    const std::lock_guard lock(m_mutex);
+    return m_bytes;
+  }
+
+  std::size_t maxBytes() const
+  {
+    const std::lock_guard lock(m_mutex);
+    return m_maxBytes;
+  }
+
+  void setMaxBytes(const std::size_t maxBytes)
+  {
+    std::vector<std::unique_ptr<ImageBuffer>> evicted;
+    {
+      const std::lock_guard lock(m_mutex);
+      m_maxBytes = maxBytes;
+
+      // Evict the biggest buffers first until we are in the limit
+      while (m_bytes > m_maxBytes && !m_unused.empty()) {
+        auto it = std::prev(m_unused.end());
+        m_bytes -= it->first;
+        evicted.push_back(std::move(it->second));
+        m_unused.erase(it);
+      }
+    }
+  }
+
+  void clear()
+  {
+    std::multimap<std::size_t, std::unique_ptr<ImageBuffer>> unused;
+    {
+      const std::lock_guard lock(m_mutex);
+      std::swap(unused, m_unused);
+      m_bytes = 0;
+    }
+  }
+
+private:
+  mutable std::mutex m_mutex;
+  std::multimap<std::size_t, std::unique_ptr<ImageBuffer>> m_unused;
+  std::size_t m_bytes = 0;
+  std::size_t m_maxBytes;
+};
+
+ImageBufferPool::ImageBufferPool(const std::size_t maxBytes)
+  : m_impl(std::make_shared<Impl>(maxBytes))
+{
+}
+
+ImageBufferPool::~ImageBufferPool()
+{
+}
+
+// static
+ImageBufferPool* ImageBufferPool::instance()
+{
+  static ImageBufferPool pool;
+  return &pool;
+}
+
+ImageBufferPtr ImageBufferPool::get(const std::size_t size)
+{
+  const std::size_t classSize = sizeClass(size);
+  ImageBuffer* buffer = m_impl->take(classSize);
+  if (buffer) {
+    g_reused.add();
+  }
+  else {
+    buffer = new ImageBuffer(classSize);
+    g_allocated.add();
+    g_allocatedBytes.add(int64_t(classSize));
+  }
+
+  // Buffers that are released after the pool is destroyed (e.g. from
+  // static objects) are just deleted.
+  std::weak_ptr<Impl> weakImpl = m_impl;
+  return ImageBufferPtr(buffer, [weakImpl](ImageBuffer* buffer) {
+    if (auto impl = weakImpl.lock())
+      impl->release(buffer);
+    else
+      delete buffer;
+  });
+}
+
+ImageBufferPtr ImageBufferPool::get(const ImageSpec& spec)
+{
+  return get(Image::requiredBufferSize(spec));
+}
+
+std::size_t ImageBufferPool::unusedBytes() const
+{
+  return m_impl->unusedBytes();
+}
+
+std::size_t ImageBufferPool::maxBytes() const
+{
+  return m_impl->maxBytes();
+}
+
+void ImageBufferPool::setMaxBytes(const std::size_t maxBytes)
+{
+  m_impl->setMaxBytes(maxBytes);
+}
+
+void ImageBufferPool::clear()
+{
+  m_impl->clear();
+}
+
+// static
+std::size_t ImageBufferPool::sizeClass(const std::size_t size)
+{
+  if (size <= kMinSizeClass)
+    return kMinSizeClass;
+
+  const std::size_t step = size_class_pow2(size) / 4;
+  return ((size + step - 1) / step) * step;
+}
+
+} // namespace doc
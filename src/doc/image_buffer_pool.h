@@ -0,0 +1,67 @@
+// Aseprite Document Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef DOC_IMAGE_BUFFER_POOL_H_INCLUDED
+#define DOC_IMAGE_BUFFER_POOL_H_INCLUDED
+#pragma once
+
+#include "doc/image_buffer.h"
+#include "doc/image_spec.h"
+
+#include <cstddef>
+#include <memory>
+
+namespace doc {
+
+// Pool of scratch ImageBuffers grouped by size classes, so temporary
+// images created in each frame/operation (rendering, tool loops,
+// filter previews, etc.) can reuse the same memory instead of
+// allocating new buffers each time.
+//
+// A buffer returns to the pool when the last ImageBufferPtr that
+// references it is destroyed. The pool can be used from any thread.
+class ImageBufferPool {
+public:
+  // Limit of bytes kept in unused buffers.
+  static constexpr std::size_t kDefaultMaxBytes = 256 * 1024 * 1024;
+
+  explicit ImageBufferPool(std::size_t maxBytes = kDefaultMaxBytes);
+  ~ImageBufferPool();
+
+  // Pool shared by all the program.
+  static ImageBufferPool* instance();
+
+  // Returns a buffer with at least the given size in bytes.
+  ImageBufferPtr get(std::size_t size);
+
+  // Returns a buffer to create an image with the given spec using
+  // Image::create(spec, buffer).
+  ImageBufferPtr get(const ImageSpec& spec);
+
+  // Bytes of the unused buffers in the pool.
+  std::size_t unusedBytes() const;
+
+  // Limit of bytes kept in unused buffers. Lowering the limit deletes
+  // unused buffers (the biggest ones first) until the pool fits in it.
+  std::size_t maxBytes() const;
+  void setMaxBytes(std::size_t maxBytes);
+
+  // Deletes all unused buffers.
+  void clear();
+
+  // Rounds up the size to the size class used to allocate buffers
+  // (4 classes for each power of two, so there is up to 25% of
+  // unused memory in each buffer).
+  static std::size_t sizeClass(std::size_t size);
+
+private:
+  class Impl;
+  std::shared_ptr<Impl> m_impl;
+};
+
+} // namespace doc
+
+#endif
@@ -0,0 +1,109 @@
+// Aseprite Document Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "doc/image_buffer_pool.h"
+
+#include "doc/image.h"
+#include "doc/image_ref.h"
+
+#include <memory>
+
+using namespace doc;
+
+TEST(ImageBufferPool, SizeClasses)
+{
+  EXPECT_EQ(4096, ImageBufferPool::sizeClass(1));
+  EXPECT_EQ(4096, ImageBufferPool::sizeClass(4096));
+  EXPECT_EQ(5120, ImageBufferPool::sizeClass(4097));
+  EXPECT_EQ(8192, ImageBufferPool::sizeClass(8000));
+  EXPECT_EQ(10240, ImageBufferPool::sizeClass(8193));
+  EXPECT_EQ(3 * 1024 * 1024, ImageBufferPool::sizeClass(3 * 1024 * 1024 - 5));
+  for (std::size_t size = 1; size < 1000000; size = size * 3 + 1) {
+    const std::size_t sizeClass = ImageBufferPool::sizeClass(size);
+    EXPECT_GE(sizeClass, size);
+    EXPECT_LE(sizeClass, std::max<std::size_t>(4096, size + size / 4 + 1));
+  }
+}
+
+TEST(ImageBufferPool, ReuseBuffers)
+{
+  ImageBufferPool pool;
+  uint8_t* bits;
+  {
+    ImageBufferPtr buffer = pool.get(10000);
+    EXPECT_EQ(ImageBufferPool::sizeClass(10000), buffer->size());
+    bits = buffer->buffer();
+    EXPECT_EQ(0, pool.unusedBytes());
+  }
+  EXPECT_EQ(ImageBufferPool::sizeClass(10000), pool.unusedBytes());
+
+  // Same size class
+  ImageBufferPtr buffer = pool.get(9000);
+  EXPECT_EQ(bits, buffer->buffer());
+  EXPECT_EQ(0, pool.unusedBytes());
+
+  // Other size class
+  ImageBufferPtr buffer2 = pool.get(20000);
+  EXPECT_NE(bits, buffer2->buffer());
+
+  buffer.reset();
+  buffer2.reset();
+  EXPECT_LT(0, pool.unusedBytes());
+  pool.clear();
+  EXPECT_EQ(0, pool.unusedBytes());
+}
+
+TEST(ImageBufferPool, MaxBytes)
+{
+  ImageBufferPool pool(8192);
+  ImageBufferPtr a = pool.get(4096);
+  ImageBufferPtr b = pool.get(4096);
+  ImageBufferPtr c = pool.get(4096);
+  a.reset();
+  b.reset();
+  c.reset();
+  EXPECT_EQ(8192, pool.unusedBytes());
+
+  // Lower the limit evicting unused buffers
+  pool.setMaxBytes(4096);
+  EXPECT_EQ(4096, pool.maxBytes());
+  EXPECT_EQ(4096, pool.unusedBytes());
+
+  pool.setMaxBytes(0);
+  EXPECT_EQ(0, pool.unusedBytes());
+}
+
+TEST(ImageBufferPool, Images)
+{
+  ImageBufferPool pool;
+  const ImageSpec spec(ColorMode::RGB, 300, 200);
+  ImageBufferPtr buffer = pool.get(spec);
+  EXPECT_GE(buffer->size(), Image::requiredBufferSize(spec));
+
+  ImageRef image(Image::create(spec, buffer));
+  EXPECT_EQ(ImageBufferPool::sizeClass(Image::requiredBufferSize(spec)), buffer->size());
+  buffer.reset();
+  EXPECT_EQ(0, pool.unusedBytes());
+
+  // The buffer is released with the image
+  image.reset();
+  EXPECT_LT(0, pool.unusedBytes());
+
+  image.reset(Image::create(spec, pool.get(spec)));
+  EXPECT_EQ(0, pool.unusedBytes());
+}
+
+TEST(ImageBufferPool, BuffersCanOutliveThePool)
+{
+  ImageBufferPtr buffer;
+  {
+    ImageBufferPool pool;
+    buffer = pool.get(100000);
+  }
+  buffer.reset();
+}
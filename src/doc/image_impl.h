@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (C) 2018-2023  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2016  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -58,6 +58,14 @@ public:
     }
   }
 
+  // Bytes of the ImageBuffer for an image of the given size (the
+  // table of rows and the pixels).
+  static std::size_t requiredBufferSize(const int width, const int height)
+  {
+    return doc_align_size(sizeof(address_t) * height) +
+           std::size_t(Traits::rowstride_bytes(width)) * height;
+  }
+
   ImageImpl(const ImageSpec& spec, const ImageBufferPtr& buffer) : Image(spec), m_buffer(buffer)
   {
     ASSERT(Traits::color_mode == spec.colorMode());
@@ -65,8 +73,7 @@ public:
     m_rowBytes = Traits::rowstride_bytes(width());
 
     const std::size_t for_rows = doc_align_size(sizeof(address_t) * height());
-    const std::size_t for_pixels = m_rowBytes * height();
-    const std::size_t required_size = for_pixels + for_rows;
+    const std::size_t required_size = requiredBufferSize(width(), height());
 
     if (!m_buffer)
       m_buffer = std::make_shared<ImageBuffer>(required_size);
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2018-2025 Igara Studio S.A.
+// Copyright (c) 2018-2026 Igara Studio S.A.
 // Copyright (c) 2001-2018 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -152,6 +152,57 @@ TEST(Image, DiffRgbImages)
   ASSERT_FALSE(is_same_image(a.get(), b.get()));
 }
 
+TEST(Image, OpaqueBounds)
+{
+  std::unique_ptr<Image> image(Image::create(IMAGE_RGB, 32, 32));
+  clear_image(image.get(), rgba(0, 0, 0, 0));
+
+  gfx::Rect bounds;
+  EXPECT_FALSE(image->opaqueBounds(bounds));
+
+  // The cached bounds are used until the version changes
+  put_pixel(image.get(), 3, 4, rgba(255, 0, 0, 255));
+  EXPECT_FALSE(image->opaqueBounds(bounds));
+
+  image->incrementVersion();
+  EXPECT_TRUE(image->opaqueBounds(bounds));
+  EXPECT_EQ(gfx::Rect(3, 4, 1, 1), bounds);
+
+  put_pixel(image.get(), 20, 10, rgba(0, 0, 255, 128));
+  image->incrementVersion();
+  EXPECT_TRUE(image->opaqueBounds(bounds));
+  EXPECT_EQ(gfx::Rect(3, 4, 18, 7), bounds);
+
+  // Or the mask color
+  clear_image(image.get(), rgba(255, 0, 0, 255));
+  image->incrementVersion();
+  EXPECT_TRUE(image->opaqueBounds(bounds));
+  image->setMaskColor(rgba(255, 0, 0, 255));
+  EXPECT_FALSE(image->opaqueBounds(bounds));
+}
+
+TEST(Image, ContentHash)
+{
+  std::unique_ptr<Image> a(Image::create(IMAGE_RGB, 32, 32));
+  std::unique_ptr<Image> b(Image::create(IMAGE_RGB, 32, 32));
+  clear_image(a.get(), rgba(0, 0, 0, 0));
+  clear_image(b.get(), rgba(0, 0, 0, 0));
+  EXPECT_EQ(a->contentHash(), b->contentHash());
+
+  // The cached hash is used until the version changes
+  const uint64_t oldHash = a->contentHash();
+  put_pixel(a.get(), 3, 4, rgba(255, 0, 0, 255));
+  EXPECT_EQ(oldHash, a->contentHash());
+
+  a->incrementVersion();
+  EXPECT_NE(oldHash, a->contentHash());
+  EXPECT_EQ(calculate_image_hash64(a.get(), a->bounds()), a->contentHash());
+
+  put_pixel(b.get(), 3, 4, rgba(255, 0, 0, 255));
+  b->incrementVersion();
+  EXPECT_EQ(a->contentHash(), b->contentHash());
+}
+
 TYPED_TEST(ImageAllTypes, DrawHLine)
 {
   using ImageTraits = TypeParam;
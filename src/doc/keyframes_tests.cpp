@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2022 Igara Studio S.A.
+// Copyright (c) 2022-2026 Igara Studio S.A.
 // Copyright (c) 2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -138,6 +138,26 @@ TEST(Keyframes, BugEmptyCount)
   EXPECT_EQ(5, **k.range(8, 9).begin());
 }
 
+TEST(Keyframes, GetIterator)
+{
+  Keyframes<int> k;
+  EXPECT_EQ(k.end(), k.getIterator(0));
+
+  for (int i = 0; i < 100; ++i)
+    k.insert(10 + 3 * i, std::make_unique<int>(i));
+
+  EXPECT_EQ(0, *k.getIterator(-1)->value());
+  EXPECT_EQ(0, *k.getIterator(0)->value());
+  EXPECT_EQ(nullptr, k[9]);
+  for (int i = 0; i < 100; ++i) {
+    for (int j = 0; j < 3; ++j) {
+      EXPECT_EQ(i, *k.getIterator(10 + 3 * i + j)->value());
+      EXPECT_EQ(i, *k[10 + 3 * i + j]);
+    }
+  }
+  EXPECT_EQ(99, *k.getIterator(1000)->value());
+}
+
 int main(int argc, char** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -16,6 +16,7 @@
 #include "doc/image.h"
 #include "doc/layer_tilemap.h"
 #include "doc/primitives.h"
+#include "doc/render_plan.h"
 #include "doc/sprite.h"
 #include "doc/tilesets.h"
 
@@ -40,6 +41,7 @@ Layer::Layer(ObjectType type, Sprite* sprite)
 
 Layer::~Layer()
 {
+  RenderPlan::incrementStructureVersion();
 }
 
 int Layer::getMemSize() const
@@ -47,6 +49,22 @@ int Layer::getMemSize() const
   return sizeof(Layer);
 }
 
+void Layer::setFlags(LayerFlags flags)
+{
+  if (m_flags != flags) {
+    m_flags = flags;
+    RenderPlan::incrementStructureVersion();
+  }
+}
+
+void Layer::switchFlags(LayerFlags flags, bool state)
+{
+  if (state)
+    setFlags(LayerFlags(int(m_flags) | int(flags)));
+  else
+    setFlags(LayerFlags(int(m_flags) & ~int(flags)));
+}
+
 Layer* Layer::getPrevious() const
 {
   if (m_parent) {
@@ -259,6 +277,8 @@ void LayerImage::destroyAllCels()
     delete cel;
   }
   m_cels.clear();
+  m_celFrames.clear();
+  RenderPlan::incrementStructureVersion();
 }
 
 Cel* LayerImage::cel(frame_t frame) const
@@ -295,32 +315,25 @@ CelConstIterator LayerImage::findCelIterator(frame_t frame) const
 
 CelIterator LayerImage::findCelIterator(frame_t frame)
 {
-  auto first = getCelBegin();
-  auto end = getCelEnd();
+  ASSERT(m_cels.size() == m_celFrames.size());
 
   // Here we use a binary search to find the first cel equal to "frame" (or after frame)
-  first = std::lower_bound(first, end, nullptr, [frame](Cel* cel, Cel*) -> bool {
-    return cel->frame() < frame;
-  });
+  auto it = std::lower_bound(m_celFrames.begin(), m_celFrames.end(), frame);
 
   // We return the iterator only if it's an exact match
-  if (first != end && (*first)->frame() == frame)
-    return first;
+  if (it != m_celFrames.end() && *it == frame)
+    return getCelBegin() + (it - m_celFrames.begin());
   else
-    return end;
+    return getCelEnd();
 }
 
 CelIterator LayerImage::findFirstCelIteratorAfter(frame_t firstAfterFrame)
 {
-  auto first = getCelBegin();
-  auto end = getCelEnd();
+  ASSERT(m_cels.size() == m_celFrames.size());
 
   // Here we use a binary search to find the first cel after the given frame
-  first = std::lower_bound(first, end, nullptr, [firstAfterFrame](Cel* cel, Cel*) -> bool {
-    return cel->frame() <= firstAfterFrame;
-  });
-
-  return first;
+  auto it = std::upper_bound(m_celFrames.begin(), m_celFrames.end(), firstAfterFrame);
+  return getCelBegin() + (it - m_celFrames.begin());
 }
 
 void LayerImage::addCel(Cel* cel)
@@ -333,9 +346,11 @@ void LayerImage::addCel(Cel* cel)
          cel->image()->pixelFormat() == IMAGE_TILEMAP);
 
   CelIterator it = findFirstCelIteratorAfter(cel->frame());
+  m_celFrames.insert(m_celFrames.begin() + (it - getCelBegin()), cel->frame());
   m_cels.insert(it, cel);
 
   cel->setParentLayer(this);
+  RenderPlan::incrementStructureVersion();
 }
 
 /**
@@ -350,9 +365,11 @@ void LayerImage::removeCel(Cel* cel)
   CelIterator it = findCelIterator(cel->frame());
   ASSERT(it != m_cels.end());
 
+  m_celFrames.erase(m_celFrames.begin() + (it - getCelBegin()));
   m_cels.erase(it);
 
   cel->setParentLayer(NULL);
+  RenderPlan::incrementStructureVersion();
 }
 
 void LayerImage::moveCel(Cel* cel, frame_t frame)
@@ -383,20 +400,40 @@ void LayerImage::configureAsBackground()
 
 void LayerImage::displaceFrames(frame_t fromThis, frame_t delta)
 {
-  Sprite* sprite = this->sprite();
+  // All cels from "fromThis" are shifted in bulk (they keep the same
+  // order in the list).
+  auto it = std::lower_bound(m_celFrames.begin(), m_celFrames.end(), fromThis);
+  if (it == m_celFrames.end() || delta == 0)
+    return;
 
-  if (delta > 0) {
-    for (frame_t c = sprite->lastFrame(); c >= fromThis; --c) {
-      if (Cel* cel = this->cel(c))
-        moveCel(cel, c + delta);
-    }
+  ASSERT(it == m_celFrames.begin() || *(it - 1) < *it + delta);
+
+  for (std::size_t i = it - m_celFrames.begin(); i < m_cels.size(); ++i) {
+    Cel* cel = m_cels[i];
+    m_celFrames[i] += delta;
+    cel->m_frame = m_celFrames[i];
+    cel->incrementVersion(); // TODO this should be in app::cmd module
   }
-  else {
-    for (frame_t c = fromThis; c <= sprite->lastFrame(); ++c) {
-      if (Cel* cel = this->cel(c))
-        moveCel(cel, c + delta);
+  RenderPlan::incrementStructureVersion();
+}
+
+void LayerImage::remapFrames(const std::vector<frame_t>& newFrames)
+{
+  for (Cel* cel : m_cels) {
+    ASSERT(cel->frame() >= 0 && cel->frame() < frame_t(newFrames.size()));
+    const frame_t newFrame = newFrames[cel->frame()];
+    if (cel->frame() != newFrame) {
+      cel->m_frame = newFrame;
+      cel->incrementVersion(); // TODO this should be in app::cmd module
     }
   }
+
+  std::sort(m_cels.begin(), m_cels.end(), [](const Cel* a, const Cel* b) {
+    return a->frame() < b->frame();
+  });
+  for (std::size_t i = 0; i < m_cels.size(); ++i)
+    m_celFrames[i] = m_cels[i]->frame();
+  RenderPlan::incrementStructureVersion();
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -417,6 +454,7 @@ void LayerGroup::destroyAllLayers()
   for (Layer* layer : m_layers)
     delete layer;
   m_layers.clear();
+  RenderPlan::incrementStructureVersion();
 }
 
 int LayerGroup::getMemSize() const
@@ -546,6 +584,7 @@ void LayerGroup::addLayer(Layer* layer)
 {
   m_layers.push_back(layer);
   layer->setParent(this);
+  RenderPlan::incrementStructureVersion();
 }
 
 void LayerGroup::removeLayer(Layer* layer)
@@ -555,6 +594,7 @@ void LayerGroup::removeLayer(Layer* layer)
   m_layers.erase(it);
 
   layer->setParent(nullptr);
+  RenderPlan::incrementStructureVersion();
 }
 
 void LayerGroup::insertLayer(Layer* layer, Layer* after)
@@ -568,6 +608,7 @@ void LayerGroup::insertLayer(Layer* layer, Layer* after)
   m_layers.insert(after_it, layer);
 
   layer->setParent(this);
+  RenderPlan::incrementStructureVersion();
 }
 
 void LayerGroup::insertLayerBefore(Layer* layer, Layer* before)
@@ -579,6 +620,7 @@ void LayerGroup::insertLayerBefore(Layer* layer, Layer* before)
   m_layers.insert(before_it, layer);
 
   layer->setParent(this);
+  RenderPlan::incrementStructureVersion();
 }
 
 void LayerGroup::stackLayer(Layer* layer, Layer* after)
@@ -597,6 +639,12 @@ void LayerGroup::displaceFrames(frame_t fromThis, frame_t delta)
     layer->displaceFrames(fromThis, delta);
 }
 
+void LayerGroup::remapFrames(const std::vector<frame_t>& newFrames)
+{
+  for (Layer* layer : m_layers)
+    layer->remapFrames(newFrames);
+}
+
 layer_t LayerGroup::getLayerIndex(const Layer* layer, layer_t& index) const
 {
   for (Layer* child : this->layers()) {
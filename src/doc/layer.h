@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -20,6 +20,7 @@
 #include "doc/with_user_data.h"
 
 #include <string>
+#include <vector>
 
 namespace doc {
 
@@ -116,15 +117,8 @@ public:
 
   bool hasFlags(LayerFlags flags) const { return (int(m_flags) & int(flags)) == int(flags); }
 
-  void setFlags(LayerFlags flags) { m_flags = flags; }
-
-  void switchFlags(LayerFlags flags, bool state)
-  {
-    if (state)
-      m_flags = LayerFlags(int(m_flags) | int(flags));
-    else
-      m_flags = LayerFlags(int(m_flags) & ~int(flags));
-  }
+  void setFlags(LayerFlags flags);
+  void switchFlags(LayerFlags flags, bool state);
 
   BlendMode blendMode() const { return m_blendmode; }
   void setBlendMode(BlendMode blendmode) { m_blendmode = blendmode; }
@@ -149,6 +143,10 @@ public:
   virtual void getCels(CelList& cels) const = 0;
   virtual void displaceFrames(frame_t fromThis, frame_t delta) = 0;
 
+  // Moves all cels at once to new frames, "newFrames[frame]" is the
+  // new frame of the cel in "frame" (it must be a permutation).
+  virtual void remapFrames(const std::vector<frame_t>& newFrames) = 0;
+
 private:
   std::string m_name;        // layer name
   Sprite* m_sprite;          // owner of the layer
@@ -181,6 +179,7 @@ public:
   Cel* cel(frame_t frame) const override;
   void getCels(CelList& cels) const override;
   void displaceFrames(frame_t fromThis, frame_t delta) override;
+  void remapFrames(const std::vector<frame_t>& newFrames) override;
 
   Cel* getLastCel() const;
   CelConstIterator findCelIterator(frame_t frame) const;
@@ -199,6 +198,10 @@ private:
   void destroyAllCels();
 
   CelList m_cels; // List of all cels inside this layer used by frames.
+
+  // Frame of each cel in m_cels (in the same order), used to search
+  // cels without dereferencing each Cel* and to shift frames in bulk.
+  std::vector<frame_t> m_celFrames;
 };
 
 //////////////////////////////////////////////////////////////////////
@@ -235,6 +238,7 @@ public:
 
   void getCels(CelList& cels) const override;
   void displaceFrames(frame_t fromThis, frame_t delta) override;
+  void remapFrames(const std::vector<frame_t>& newFrames) override;
 
   bool isBrowsable() const override { return isGroup() && isExpanded() && !m_layers.empty(); }
 
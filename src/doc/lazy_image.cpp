@@ -0,0 +1,156 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "doc/lazy_image.h"
+
+#include "base/debug.h"
+#include "doc/image.h"
+
+#include <vector>
+
+namespace doc {
+
+std::atomic<int> LazyImagesCache::s_noTrimScopes(0);
+
+void LazyImagesCache::pinAll()
+{
+  const std::lock_guard lock(m_mutex);
+  for (LazyImage* lazy : m_all) {
+    if (!lazy->m_pinned) {
+      lazy->decodedImage();
+      lazy->m_pinned = true;
+      lazy->onPinned();
+    }
+  }
+}
+
+void LazyImagesCache::trim()
+{
+  if (s_noTrimScopes > 0)
+    return;
+
+  // The discarded images are destroyed after unlocking the mutex.
+  std::vector<ImageRef> discarded;
+
+  const std::lock_guard lock(m_mutex);
+  auto it = m_lru.end();
+  while (m_decodedBytes > m_maxBytes && it != m_lru.begin()) {
+    --it;
+
+    LazyImage* lazy = *it;
+    if (lazy->m_pinned || lazy->m_image.use_count() > 1 || lazy->isModified())
+      continue;
+
+    m_decodedBytes -= lazy->m_image->getMemSize();
+    discarded.push_back(std::move(lazy->m_image));
+    it = m_lru.erase(it);
+  }
+}
+
+LazyImage::LazyImage(const PixelFormat pixelFormat,
+                     const int width,
+                     const int height,
+                     const LazyImagesCacheRef& cache)
+  : m_pixelFormat(pixelFormat)
+  , m_width(width)
+  , m_height(height)
+  , m_cache(cache)
+{
+  ASSERT(m_cache);
+
+  const std::lock_guard lock(m_cache->m_mutex);
+  m_cache->m_all.push_front(this);
+  m_allIt = m_cache->m_all.begin();
+}
+
+LazyImage::~LazyImage()
+{
+  const std::lock_guard lock(m_cache->m_mutex);
+  m_cache->m_all.erase(m_allIt);
+  if (m_image) {
+    m_cache->m_decodedBytes -= m_image->getMemSize();
+    m_cache->m_lru.erase(m_lruIt);
+  }
+}
+
+ImageRef LazyImage::image()
+{
+  const std::lock_guard lock(m_cache->m_mutex);
+  return decodedImage();
+}
+
+ImageRef LazyImage::decodedImage()
+{
+  auto& lru = m_cache->m_lru;
+
+  if (m_image) {
+    // Move to the front of the LRU list
+    lru.splice(lru.begin(), lru, m_lruIt);
+    return m_image;
+  }
+
+  m_image = onDecode();
+  ASSERT(m_image);
+  ASSERT(m_image->pixelFormat() == m_pixelFormat);
+  ASSERT(m_image->width() == m_width);
+  ASSERT(m_image->height() == m_height);
+  if (m_hasMaskColor)
+    m_image->setMaskColor(m_maskColor);
+  m_decodedVersion = m_image->version();
+
+  lru.push_front(this);
+  m_lruIt = lru.begin();
+  m_cache->m_decodedBytes += m_image->getMemSize();
+  return m_image;
+}
+
+void LazyImage::pin()
+{
+  const std::lock_guard lock(m_cache->m_mutex);
+  if (!m_pinned) {
+    decodedImage();
+    m_pinned = true;
+    onPinned();
+  }
+}
+
+void LazyImage::setMaskColor(const color_t maskColor)
+{
+  const std::lock_guard lock(m_cache->m_mutex);
+  m_maskColor = maskColor;
+  m_hasMaskColor = true;
+  if (m_image)
+    m_image->setMaskColor(maskColor);
+}
+
+LazyImageRef LazyImage::clone()
+{
+  bool hasMaskColor;
+  color_t maskColor;
+  {
+    const std::lock_guard lock(m_cache->m_mutex);
+    if (m_pinned || isModified())
+      return nullptr;
+    hasMaskColor = m_hasMaskColor;
+    maskColor = m_maskColor;
+  }
+
+  LazyImageRef copy = onClone();
+  if (copy && hasMaskColor)
+    copy->setMaskColor(maskColor);
+  return copy;
+}
+
+bool LazyImage::isModified() const
+{
+  return (m_image && m_image->version() != m_decodedVersion);
+}
+
+} // namespace doc
@@ -0,0 +1,166 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef DOC_LAZY_IMAGE_H_INCLUDED
+#define DOC_LAZY_IMAGE_H_INCLUDED
+#pragma once
+
+#include "base/disable_copying.h"
+#include "doc/color.h"
+#include "doc/image_ref.h"
+#include "doc/object_version.h"
+#include "doc/pixel_format.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+
+namespace doc {
+
+class LazyImage;
+
+// Keeps track of the decoded bytes of a set of lazy images (e.g. all
+// the cels of a file), and discards the least recently used ones
+// when trim() is called and the limit is exceeded.
+class LazyImagesCache {
+public:
+  // While an instance of this class exists, trim() doesn't discard
+  // images. It must be used by threads that access images through
+  // raw pointers (e.g. CelData::image()) without locking the
+  // document.
+  class NoTrimScope {
+  public:
+    NoTrimScope() { ++s_noTrimScopes; }
+    ~NoTrimScope() { --s_noTrimScopes; }
+    NoTrimScope(const NoTrimScope&) = delete;
+    NoTrimScope& operator=(const NoTrimScope&) = delete;
+  };
+
+  LazyImagesCache(const std::size_t maxBytes) : m_maxBytes(maxBytes) {}
+
+  std::size_t maxBytes() const { return m_maxBytes; }
+  std::size_t decodedBytes() const { return m_decodedBytes; }
+
+  // Decodes and pins all the images of this cache (e.g. when the
+  // source file is going to be overwritten, all the images decoded
+  // from it must be kept in memory, even the ones that were cloned
+  // for other documents).
+  void pinAll();
+
+  // Discards least recently used images until the decoded bytes are
+  // below the limit. Only unmodified images (with the same version
+  // they had when they were decoded) that aren't referenced from other
+  // places (e.g. undo history) are discarded.
+  //
+  // Images returned by CelData::image() are raw pointers, so this
+  // must be called only when nobody can be using them (e.g. from the
+  // UI thread with all documents locked, and no background task
+  // running).
+  void trim();
+
+private:
+  friend class LazyImage;
+
+  static std::atomic<int> s_noTrimScopes;
+
+  std::mutex m_mutex;
+  std::size_t m_maxBytes;
+  std::size_t m_decodedBytes = 0;
+
+  // All the images of the cache, and the decoded ones (the most
+  // recently used first).
+  std::list<LazyImage*> m_all;
+  std::list<LazyImage*> m_lru;
+
+  DISABLE_COPYING(LazyImagesCache);
+};
+
+using LazyImagesCacheRef = std::shared_ptr<LazyImagesCache>;
+
+// An image that is decoded on demand (see CelData::setLazyImage()),
+// e.g. from a memory-mapped file. The decoded image can be discarded
+// by the cache when it's not used, and decoded again when it's
+// needed.
+class LazyImage {
+public:
+  LazyImage(const PixelFormat pixelFormat,
+            const int width,
+            const int height,
+            const LazyImagesCacheRef& cache);
+  virtual ~LazyImage();
+
+  PixelFormat pixelFormat() const { return m_pixelFormat; }
+  int width() const { return m_width; }
+  int height() const { return m_height; }
+
+  // Returns the image, decoding it if it's necessary. It can be
+  // called from any thread. The decoded image is kept in memory at
+  // least until the next LazyImagesCache::trim() call.
+  ImageRef image();
+
+  // Decodes the image and keeps it in memory forever (e.g. when the
+  // source of the image is going to be overwritten).
+  void pin();
+
+  // Changes the mask color of the image (without decoding it).
+  void setMaskColor(const color_t maskColor);
+
+  // Returns a new lazy image that decodes the same pixels from the
+  // same source, so a copy of a cel doesn't need to decode and copy
+  // the image. Returns nullptr if the image cannot be cloned (it's
+  // pinned or was modified after decoding it).
+  std::shared_ptr<LazyImage> clone();
+
+  const LazyImagesCacheRef& cache() const { return m_cache; }
+
+protected:
+  // Creates the image and decodes its pixels.
+  virtual ImageRef onDecode() = 0;
+
+  // Creates a new lazy image with the same source (or nullptr if
+  // it's not supported).
+  virtual std::shared_ptr<LazyImage> onClone() const { return nullptr; }
+
+  // Called when the image is pinned, the source of the image can be
+  // released because onDecode() will not be called anymore (e.g. to
+  // close the file before overwriting it). It's called with the
+  // cache mutex locked, but onClone() can be called concurrently.
+  virtual void onPinned() {}
+
+private:
+  friend class LazyImagesCache;
+
+  // Same as image() but the cache mutex must be locked.
+  ImageRef decodedImage();
+  bool isModified() const;
+
+  PixelFormat m_pixelFormat;
+  int m_width;
+  int m_height;
+  color_t m_maskColor = 0;
+  bool m_hasMaskColor = false;
+  bool m_pinned = false;
+  LazyImagesCacheRef m_cache;
+
+  // Valid if the image is decoded. Every modification of the image
+  // increments its version, so we compare it with the version after
+  // decoding to know if the image was modified.
+  ImageRef m_image;
+  ObjectVersion m_decodedVersion = 0;
+  std::list<LazyImage*>::iterator m_lruIt;
+  std::list<LazyImage*>::iterator m_allIt;
+
+  DISABLE_COPYING(LazyImage);
+};
+
+using LazyImageRef = std::shared_ptr<LazyImage>;
+
+} // namespace doc
+
+#endif
@@ -0,0 +1,195 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "doc/cel_data.h"
+#include "doc/lazy_image.h"
+#include "doc/primitives.h"
+
+using namespace doc;
+
+namespace {
+
+class TestLazyImage : public LazyImage {
+public:
+  TestLazyImage(const color_t color, const LazyImagesCacheRef& cache)
+    : LazyImage(IMAGE_RGB, 16, 16, cache)
+    , m_color(color)
+  {
+  }
+
+  int decodes() const { return m_decodes; }
+  int pins() const { return m_pins; }
+
+protected:
+  ImageRef onDecode() override
+  {
+    ++m_decodes;
+    ImageRef image(Image::create(IMAGE_RGB, width(), height()));
+    clear_image(image.get(), m_color);
+    return image;
+  }
+
+  LazyImageRef onClone() const override
+  {
+    return std::make_shared<TestLazyImage>(m_color, cache());
+  }
+
+  void onPinned() override { ++m_pins; }
+
+private:
+  color_t m_color;
+  int m_decodes = 0;
+  int m_pins = 0;
+};
+
+} // anonymous namespace
+
+TEST(LazyImage, DecodeOnDemand)
+{
+  auto cache = std::make_shared<LazyImagesCache>(1024 * 1024);
+  auto lazy = std::make_shared<TestLazyImage>(rgba(255, 0, 0, 255), cache);
+
+  CelData celData(ImageRef(nullptr));
+  celData.setLazyImage(lazy, nullptr);
+  EXPECT_EQ(0, lazy->decodes());
+  EXPECT_EQ(gfx::Rect(0, 0, 16, 16), celData.bounds());
+  EXPECT_EQ(0, lazy->decodes());
+
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(celData.image(), 0, 0));
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(celData.image(), 15, 15));
+  EXPECT_EQ(1, lazy->decodes());
+  EXPECT_EQ(celData.image()->getMemSize(), cache->decodedBytes());
+}
+
+TEST(LazyImage, DiscardLeastRecentlyUsed)
+{
+  auto tmp = std::unique_ptr<Image>(Image::create(IMAGE_RGB, 16, 16));
+  auto cache = std::make_shared<LazyImagesCache>(2 * tmp->getMemSize());
+  auto a = std::make_shared<TestLazyImage>(rgba(255, 0, 0, 255), cache);
+  auto b = std::make_shared<TestLazyImage>(rgba(0, 255, 0, 255), cache);
+  auto c = std::make_shared<TestLazyImage>(rgba(0, 0, 255, 255), cache);
+
+  a->image();
+  b->image();
+  a->image(); // Now "b" is the least recently used
+  c->image();
+
+  // Images are discarded only in trim()
+  EXPECT_EQ(3 * tmp->getMemSize(), cache->decodedBytes());
+  cache->trim(); // Discards "b"
+  EXPECT_EQ(2 * tmp->getMemSize(), cache->decodedBytes());
+
+  a->image();
+  c->image();
+  EXPECT_EQ(1, a->decodes());
+  EXPECT_EQ(1, c->decodes());
+
+  EXPECT_EQ(rgba(0, 255, 0, 255), get_pixel(b->image().get(), 0, 0));
+  EXPECT_EQ(2, b->decodes());
+}
+
+TEST(LazyImage, KeepUsedModifiedAndPinnedImages)
+{
+  auto tmp = std::unique_ptr<Image>(Image::create(IMAGE_RGB, 16, 16));
+  auto cache = std::make_shared<LazyImagesCache>(tmp->getMemSize());
+  auto a = std::make_shared<TestLazyImage>(rgba(255, 0, 0, 255), cache);
+  auto b = std::make_shared<TestLazyImage>(rgba(0, 255, 0, 255), cache);
+  auto c = std::make_shared<TestLazyImage>(rgba(0, 0, 255, 255), cache);
+
+  // Referenced
+  ImageRef ref = a->image();
+  b->image();
+  c->image();
+  cache->trim(); // Discards "b" and "c"
+  EXPECT_EQ(tmp->getMemSize(), cache->decodedBytes());
+  EXPECT_EQ(1, a->decodes());
+  ref.reset();
+
+  // Modified (the version of an image is incremented after each
+  // modification)
+  put_pixel(a->image().get(), 0, 0, rgba(0, 0, 0, 255));
+  a->image()->incrementVersion();
+  c->image();
+  b->image();
+  cache->trim(); // Discards "c" and "b"
+  EXPECT_EQ(rgba(0, 0, 0, 255), get_pixel(a->image().get(), 0, 0));
+  EXPECT_EQ(1, a->decodes());
+  EXPECT_EQ(2, b->decodes());
+  EXPECT_EQ(2, c->decodes());
+
+  // Pinned
+  b->pin();
+  b->pin();
+  EXPECT_EQ(1, b->pins());
+  c->image();
+  cache->trim(); // Discards "c"
+  b->image();
+  c->image();
+  EXPECT_EQ(3, b->decodes());
+  EXPECT_EQ(4, c->decodes());
+}
+
+TEST(LazyImage, NoTrimScope)
+{
+  auto tmp = std::unique_ptr<Image>(Image::create(IMAGE_RGB, 16, 16));
+  auto cache = std::make_shared<LazyImagesCache>(tmp->getMemSize());
+  auto a = std::make_shared<TestLazyImage>(rgba(255, 0, 0, 255), cache);
+  auto b = std::make_shared<TestLazyImage>(rgba(0, 255, 0, 255), cache);
+
+  // A raw pointer to a decoded image is valid while other images are
+  // decoded, and while a NoTrimScope exists.
+  const Image* image = a->image().get();
+  b->image();
+  {
+    LazyImagesCache::NoTrimScope noTrim;
+    cache->trim();
+    EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(image, 0, 0));
+  }
+  EXPECT_EQ(2 * tmp->getMemSize(), cache->decodedBytes());
+
+  cache->trim(); // Discards "a"
+  EXPECT_EQ(tmp->getMemSize(), cache->decodedBytes());
+  EXPECT_EQ(1, b->decodes());
+}
+
+TEST(LazyImage, Clone)
+{
+  auto cache = std::make_shared<LazyImagesCache>(1024 * 1024);
+  auto a = std::make_shared<TestLazyImage>(rgba(255, 0, 0, 255), cache);
+
+  auto b = std::static_pointer_cast<TestLazyImage>(a->clone());
+  ASSERT_TRUE(b != nullptr);
+  EXPECT_EQ(0, a->decodes());
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(b->image().get(), 0, 0));
+  EXPECT_EQ(0, a->decodes());
+  EXPECT_EQ(1, b->decodes());
+
+  // Modifying the clone doesn't modify the original image
+  put_pixel(b->image().get(), 0, 0, rgba(0, 0, 0, 255));
+  b->image()->incrementVersion();
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(a->image().get(), 0, 0));
+
+  // Modified or pinned images cannot be cloned
+  EXPECT_EQ(nullptr, b->clone());
+  EXPECT_NE(nullptr, a->clone());
+  cache->pinAll();
+  EXPECT_EQ(nullptr, a->clone());
+  EXPECT_EQ(1, a->decodes());
+  EXPECT_EQ(1, a->pins());
+  EXPECT_EQ(1, b->pins());
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -11,35 +11,205 @@
 
 #include "doc/image.h"
 #include "doc/mask.h"
+#include "doc/mask_runs.h"
+#include "doc/task_group.h"
 #include "gfx/point.h"
+#include "tracing/tracing.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 
+#if defined(__x86_64__) || defined(_WIN64)
+  #include <emmintrin.h>
+  #define DOC_USE_SSE2_MASK_BY_COLOR 1
+#else
+  #define DOC_USE_SSE2_MASK_BY_COLOR 0
+#endif
+
 namespace doc {
 
 namespace {
 
-template<typename Func>
-void for_each_mask_pixel(Mask& a, const Mask& b, Func f)
+// Sets or clears the pixels [x1, x2) of the row y of a 1bpp bitmap.
+void fill_bitmap_span(Image* bitmap, int x1, const int y, const int x2, const bool value)
 {
-  a.reserve(b.bounds());
+  uint8_t* bits = bitmap->getPixelAddress(0, y);
+
+  for (; x1 < x2 && (x1 & 7); ++x1) {
+    if (value)
+      bits[x1 >> 3] |= (1 << (x1 & 7));
+    else
+      bits[x1 >> 3] &= ~(1 << (x1 & 7));
+  }
+  if (x1 + 8 <= x2) {
+    const int n = (x2 - x1) >> 3;
+    std::memset(bits + (x1 >> 3), (value ? 0xff : 0), n);
+    x1 += (n << 3);
+  }
+  for (; x1 < x2; ++x1) {
+    if (value)
+      bits[x1 >> 3] |= (1 << (x1 & 7));
+    else
+      bits[x1 >> 3] &= ~(1 << (x1 & 7));
+  }
+}
 
+// Minimum number of pixels to split the rows of Mask::byColor()
+// between several threads.
+constexpr int kByColorParallelMinArea = 256 * 256;
+
+// Returns true if each channel of c is in the [color-fuzziness,
+// color+fuzziness] range.
+template<typename ImageTraits>
+inline bool similar_color(color_t c, color_t color, int fuzziness);
+
+template<>
+inline bool similar_color<RgbTraits>(color_t c, color_t color, int fuzziness)
+{
+  return (std::abs(int(rgba_getr(c)) - int(rgba_getr(color))) <= fuzziness &&
+          std::abs(int(rgba_getg(c)) - int(rgba_getg(color))) <= fuzziness &&
+          std::abs(int(rgba_getb(c)) - int(rgba_getb(color))) <= fuzziness &&
+          std::abs(int(rgba_geta(c)) - int(rgba_geta(color))) <= fuzziness);
+}
+
+template<>
+inline bool similar_color<GrayscaleTraits>(color_t c, color_t color, int fuzziness)
+{
+  return (std::abs(int(graya_getv(c)) - int(graya_getv(color))) <= fuzziness &&
+          std::abs(int(graya_geta(c)) - int(graya_geta(color))) <= fuzziness);
+}
+
+template<>
+inline bool similar_color<IndexedTraits>(color_t c, color_t color, int fuzziness)
+{
+  return (std::abs(int(c) - int(color)) <= fuzziness);
+}
+
+// Compares 8 pixels at the same time with the SSE2 version of
+// similar_color<ImageTraits>() and returns one bit for each pixel,
+// in the same order used by the bits of a bitmap.
+template<typename ImageTraits>
+class ColorRange {
+public:
+  using pixel_t = typename ImageTraits::pixel_t;
+
+  ColorRange(const color_t color, const int fuzziness)
   {
-    LockImageBits<BitmapTraits> aBits(a.bitmap());
-    auto aIt = aBits.begin();
-
-    auto bounds = a.bounds();
-    for (int y = 0; y < bounds.h; ++y) {
-      for (int x = 0; x < bounds.w; ++x, ++aIt) {
-        color_t aColor = *aIt;
-        color_t bColor = (b.containsPoint(bounds.x + x, bounds.y + y) ? 1 : 0);
-        *aIt = f(aColor, bColor);
+#if DOC_USE_SSE2_MASK_BY_COLOR
+    m_fuzziness = _mm_set1_epi8(char(std::clamp(fuzziness, 0, 255)));
+    switch (ImageTraits::pixel_format) {
+      case IMAGE_RGB:       m_color = _mm_set1_epi32(int(color)); break;
+      case IMAGE_GRAYSCALE: m_color = _mm_set1_epi16(short(color)); break;
+      case IMAGE_INDEXED:   m_color = _mm_set1_epi8(char(color)); break;
+      default:              m_color = _mm_setzero_si128(); break;
+    }
+#endif
+  }
+
+#if DOC_USE_SSE2_MASK_BY_COLOR
+  uint8_t match8(const pixel_t* p) const
+  {
+    const __m128i zero = _mm_setzero_si128();
+
+    switch (ImageTraits::pixel_format) {
+      case IMAGE_RGB: {
+        const __m128i m0 = _mm_cmpeq_epi32(outOfRange(load(p)), zero);
+        const __m128i m1 = _mm_cmpeq_epi32(outOfRange(load(p + 4)), zero);
+        return uint8_t(_mm_movemask_ps(_mm_castsi128_ps(m0)) |
+                       (_mm_movemask_ps(_mm_castsi128_ps(m1)) << 4));
+      }
+      case IMAGE_GRAYSCALE: {
+        const __m128i m = _mm_cmpeq_epi16(outOfRange(load(p)), zero);
+        return uint8_t(_mm_movemask_epi8(_mm_packs_epi16(m, zero)));
+      }
+      case IMAGE_INDEXED: {
+        const __m128i c = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+        return uint8_t(_mm_movemask_epi8(_mm_cmpeq_epi8(outOfRange(c), zero)));
+      }
+      default: return 0;
+    }
+  }
+
+private:
+  static __m128i load(const pixel_t* p)
+  {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+  }
+
+  // Returns how much each channel is outside the range (zero for the
+  // channels inside the range).
+  __m128i outOfRange(const __m128i c) const
+  {
+    return _mm_subs_epu8(_mm_or_si128(_mm_subs_epu8(c, m_color), _mm_subs_epu8(m_color, c)),
+                         m_fuzziness);
+  }
+
+  __m128i m_color;
+  __m128i m_fuzziness;
+#endif
+};
+
+// Writes the bits of the rows [y1, y2) of the "dst" bitmap.
+template<typename ImageTraits>
+void by_color_rows(const Image* src,
+                   Image* dst,
+                   const int y1,
+                   const int y2,
+                   const color_t color,
+                   const int fuzziness)
+{
+  using pixel_t = typename ImageTraits::pixel_t;
+
+  const int w = src->width();
+  const ColorRange<ImageTraits> range(color, fuzziness);
+
+  for (int y = y1; y < y2; ++y) {
+    const pixel_t* srcRow = reinterpret_cast<const pixel_t*>(src->getPixelAddress(0, y));
+    uint8_t* dstRow = dst->getPixelAddress(0, y);
+    int x = 0;
+#if DOC_USE_SSE2_MASK_BY_COLOR
+    for (; x + 8 <= w; x += 8)
+      *(dstRow++) = range.match8(srcRow + x);
+#endif
+    for (; x < w; x += 8) {
+      uint8_t bits = 0;
+      for (int i = 0; i < 8 && x + i < w; ++i) {
+        if (similar_color<ImageTraits>(srcRow[x + i], color, fuzziness))
+          bits |= (1 << i);
       }
+      *(dstRow++) = bits;
     }
   }
+}
+
+template<typename ImageTraits>
+void by_color(const Image* src, Image* dst, const color_t color, const int fuzziness)
+{
+  // Nothing is inside a negative range.
+  if (fuzziness < 0) {
+    clear_image(dst, 0);
+    return;
+  }
+
+  const int h = src->height();
+  const int nthreads = task_threads();
+  if (nthreads < 2 || src->width() * h < kByColorParallelMinArea) {
+    by_color_rows<ImageTraits>(src, dst, 0, h, color, fuzziness);
+    return;
+  }
 
-  a.shrink();
+  // Each task writes different rows of the bitmap.
+  const int rowsPerTask = std::max(1, (h + nthreads * 4 - 1) / (nthreads * 4));
+  TaskGroup tasks;
+  for (int y = 0; y < h; y += rowsPerTask) {
+    const int y2 = std::min(y + rowsPerTask, h);
+    tasks.run([src, dst, y, y2, color, fuzziness] {
+      TRACING_SCOPE("Mask::byColor task");
+      by_color_rows<ImageTraits>(src, dst, y, y2, color, fuzziness);
+    });
+  }
+  tasks.wait();
 }
 
 } // namespace
@@ -217,22 +387,17 @@ void Mask::replace(const gfx::Rect& bounds)
 
 void Mask::add(const doc::Mask& mask)
 {
-  for_each_mask_pixel(*this, mask, [](color_t a, color_t b) -> color_t { return a | b; });
+  add(MaskRuns(mask));
 }
 
 void Mask::subtract(const doc::Mask& mask)
 {
-  for_each_mask_pixel(*this, mask, [](color_t a, color_t b) -> color_t {
-    if (a)
-      return a - b;
-    else
-      return 0;
-  });
+  subtract(MaskRuns(mask));
 }
 
 void Mask::intersect(const doc::Mask& mask)
 {
-  for_each_mask_pixel(*this, mask, [](color_t a, color_t b) -> color_t { return a & b; });
+  intersect(MaskRuns(mask));
 }
 
 void Mask::add(const gfx::Rect& bounds)
@@ -291,107 +456,86 @@ void Mask::intersect(const gfx::Rect& bounds)
   shrink();
 }
 
-void Mask::byColor(const Image* src, int color, int fuzziness)
+void Mask::add(const MaskRuns& runs)
 {
-  replace(src->bounds());
+  if (runs.isEmpty())
+    return;
 
-  Image* dst = m_bitmap.get();
+  reserve(runs.bounds());
 
-  switch (src->pixelFormat()) {
-    case IMAGE_RGB: {
-      const LockImageBits<RgbTraits> srcBits(src);
-      LockImageBits<BitmapTraits> dstBits(dst, Image::WriteLock);
-      LockImageBits<RgbTraits>::const_iterator src_it = srcBits.begin(), src_end = srcBits.end();
-      LockImageBits<BitmapTraits>::iterator dst_it = dstBits.begin();
-#ifdef _DEBUG
-      LockImageBits<BitmapTraits>::iterator dst_end = dstBits.end();
-#endif
-      int src_r, src_g, src_b, src_a;
-      int dst_r, dst_g, dst_b, dst_a;
-      color_t c;
-
-      dst_r = rgba_getr(color);
-      dst_g = rgba_getg(color);
-      dst_b = rgba_getb(color);
-      dst_a = rgba_geta(color);
-
-      for (; src_it != src_end; ++src_it, ++dst_it) {
-        ASSERT(dst_it != dst_end);
-        c = *src_it;
-
-        src_r = rgba_getr(c);
-        src_g = rgba_getg(c);
-        src_b = rgba_getb(c);
-        src_a = rgba_geta(c);
-
-        if (!((src_r >= dst_r - fuzziness) && (src_r <= dst_r + fuzziness) &&
-              (src_g >= dst_g - fuzziness) && (src_g <= dst_g + fuzziness) &&
-              (src_b >= dst_b - fuzziness) && (src_b <= dst_b + fuzziness) &&
-              (src_a >= dst_a - fuzziness) && (src_a <= dst_a + fuzziness)))
-          *dst_it = 0;
-      }
-      ASSERT(dst_it == dst_end);
-      break;
+  const gfx::Rect& bounds = runs.bounds();
+  for (int y = bounds.y; y < bounds.y2(); ++y) {
+    for (const MaskRuns::Run& run : runs.row(y)) {
+      fill_bitmap_span(m_bitmap.get(),
+                       run.x1 - m_bounds.x,
+                       y - m_bounds.y,
+                       run.x2 - m_bounds.x,
+                       true);
     }
+  }
 
-    case IMAGE_GRAYSCALE: {
-      const LockImageBits<GrayscaleTraits> srcBits(src);
-      LockImageBits<BitmapTraits> dstBits(dst, Image::WriteLock);
-      LockImageBits<GrayscaleTraits>::const_iterator src_it = srcBits.begin(),
-                                                     src_end = srcBits.end();
-      LockImageBits<BitmapTraits>::iterator dst_it = dstBits.begin();
-#ifdef _DEBUG
-      LockImageBits<BitmapTraits>::iterator dst_end = dstBits.end();
-#endif
-      int src_k, src_a;
-      int dst_k, dst_a;
-      color_t c;
+  shrink();
+}
 
-      dst_k = graya_getv(color);
-      dst_a = graya_geta(color);
+void Mask::subtract(const MaskRuns& runs)
+{
+  if (!m_bitmap)
+    return;
 
-      for (; src_it != src_end; ++src_it, ++dst_it) {
-        ASSERT(dst_it != dst_end);
-        c = *src_it;
+  const gfx::Rect bounds = m_bounds.createIntersection(runs.bounds());
+  for (int y = bounds.y; y < bounds.y2(); ++y) {
+    for (const MaskRuns::Run& run : runs.row(y)) {
+      const int x1 = std::max(run.x1, m_bounds.x);
+      const int x2 = std::min(run.x2, m_bounds.x2());
+      if (x1 < x2)
+        fill_bitmap_span(m_bitmap.get(), x1 - m_bounds.x, y - m_bounds.y, x2 - m_bounds.x, false);
+    }
+  }
 
-        src_k = graya_getv(c);
-        src_a = graya_geta(c);
+  shrink();
+}
 
-        if (!((src_k >= dst_k - fuzziness) && (src_k <= dst_k + fuzziness) &&
-              (src_a >= dst_a - fuzziness) && (src_a <= dst_a + fuzziness)))
-          *dst_it = 0;
-      }
-      ASSERT(dst_it == dst_end);
-      break;
+void Mask::intersect(const MaskRuns& runs)
+{
+  if (!m_bitmap)
+    return;
+
+  // Clear the gaps between runs of each row of the bitmap.
+  for (int y = m_bounds.y; y < m_bounds.y2(); ++y) {
+    int x1 = m_bounds.x;
+    for (const MaskRuns::Run& run : runs.row(y)) {
+      const int x2 = std::min(run.x1, m_bounds.x2());
+      if (x1 < x2)
+        fill_bitmap_span(m_bitmap.get(), x1 - m_bounds.x, y - m_bounds.y, x2 - m_bounds.x, false);
+      x1 = std::max(x1, run.x2);
     }
+    if (x1 < m_bounds.x2())
+      fill_bitmap_span(m_bitmap.get(), x1 - m_bounds.x, y - m_bounds.y, m_bounds.w, false);
+  }
 
-    case IMAGE_INDEXED: {
-      const LockImageBits<IndexedTraits> srcBits(src);
-      LockImageBits<BitmapTraits> dstBits(dst, Image::WriteLock);
-      LockImageBits<IndexedTraits>::const_iterator src_it = srcBits.begin(),
-                                                   src_end = srcBits.end();
-      LockImageBits<BitmapTraits>::iterator dst_it = dstBits.begin();
-#ifdef _DEBUG
-      LockImageBits<BitmapTraits>::iterator dst_end = dstBits.end();
-#endif
-      color_t c, min, max;
+  shrink();
+}
+
+void Mask::byColor(const Image* src, int color, int fuzziness)
+{
+  const gfx::Rect bounds = src->bounds();
+  if (bounds.isEmpty()) {
+    clear();
+    return;
+  }
 
-      for (; src_it != src_end; ++src_it, ++dst_it) {
-        ASSERT(dst_it != dst_end);
-        c = *src_it;
+  // All the bits of the bitmap are written by by_color_rows(), so
+  // we don't need to clear it.
+  m_bounds = bounds;
+  m_bitmap.reset(Image::create(IMAGE_BITMAP, bounds.w, bounds.h, m_buffer));
 
-        if (color > fuzziness)
-          min = color - fuzziness;
-        else
-          min = 0;
-        max = color + fuzziness;
+  Image* dst = m_bitmap.get();
 
-        if (!((c >= min) && (c <= max)))
-          *dst_it = 0;
-      }
-      ASSERT(dst_it == dst_end);
-      break;
-    }
+  switch (src->pixelFormat()) {
+    case IMAGE_RGB:       by_color<RgbTraits>(src, dst, color, fuzziness); break;
+    case IMAGE_GRAYSCALE: by_color<GrayscaleTraits>(src, dst, color, fuzziness); break;
+    case IMAGE_INDEXED:   by_color<IndexedTraits>(src, dst, color, fuzziness); break;
+    default:              clear_image(dst, 0); break;
   }
 
   shrink();
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2020-2025 Igara Studio S.A.
+// Copyright (c) 2020-2026 Igara Studio S.A.
 // Copyright (c) 2001-2018 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -20,6 +20,8 @@
 
 namespace doc {
 
+class MaskRuns;
+
 // Represents the selection (selected pixels, 0/1, 0=non-selected, 1=selected)
 //
 // TODO rename Mask -> Selection
@@ -92,6 +94,11 @@ public:
   void subtract(const gfx::Rect& bounds);
   void intersect(const gfx::Rect& bounds);
 
+  // Modifies the bitmap only in the rows/spans of the given runs.
+  void add(const MaskRuns& runs);
+  void subtract(const MaskRuns& runs);
+  void intersect(const MaskRuns& runs);
+
   void byColor(const Image* image, int color, int fuzziness);
   void crop(const Image* image);
 
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2025 Igara Studio S.A.
+// Copyright (c) 2025-2026 Igara Studio S.A.
 // Copyright (c) 2001-2015 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -14,25 +14,72 @@
 #include "doc/image.h"
 #include "doc/mask.h"
 
+#include <algorithm>
+
 namespace doc {
 
+namespace {
+
+// Minimum number of segments to create reduced levels of the
+// boundaries (to draw them zoomed out).
+constexpr int kMinSegsForLevels = 4096;
+constexpr int kMaxLevels = 4;
+
+int floor_div(const int a, const int b)
+{
+  return (a >= 0 ? a / b : -((-a + b - 1) / b));
+}
+
+bool same_rows(const MaskRuns& a, const MaskRuns& b, const int y1, const int y2)
+{
+  for (int y = y1; y < y2; ++y) {
+    if (a.row(y) != b.row(y))
+      return false;
+  }
+  return true;
+}
+
+// Returns the runs reduced to the half, a pixel of the result is
+// selected if any of its 2x2 pixels is selected.
+MaskRuns reduce_runs(const MaskRuns& runs)
+{
+  MaskRuns result;
+  const gfx::Rect& bounds = runs.bounds();
+  for (int y = bounds.y; y < bounds.y2(); ++y) {
+    const int v = floor_div(y, 2);
+    for (const MaskRuns::Run& run : runs.row(y)) {
+      const int u1 = floor_div(run.x1, 2);
+      const int u2 = floor_div(run.x2 + 1, 2);
+      result.add(gfx::Rect(u1, v, u2 - u1, 1));
+    }
+  }
+  return result;
+}
+
+} // anonymous namespace
+
 void MaskBoundaries::reset()
 {
   m_segs.clear();
   if (!m_path.isEmpty())
     m_path.rewind();
+
+  m_bands.clear();
+  m_runs.clear();
+  m_levels.clear();
 }
 
 void MaskBoundaries::regen(const Mask* mask)
 {
-  reset();
-
   ASSERT(mask);
-  if (!mask || mask->isEmpty())
+  if (!mask || mask->isEmpty()) {
+    reset();
     return;
+  }
 
-  regen(mask->bitmap());
-  offset(mask->bounds().x, mask->bounds().y);
+  // Runs skip the empty and full bytes of the bitmap, and generate
+  // the segments from the edges of each run.
+  regen(MaskRuns(*mask));
 }
 
 void MaskBoundaries::regen(const Image* bitmap)
@@ -361,12 +408,143 @@ void MaskBoundaries::regen(const Image* bitmap)
   ASSERT(prevIt == bits.end());
 }
 
+void MaskBoundaries::regen(const MaskRuns& runs)
+{
+  if (runs.isEmpty()) {
+    reset();
+    return;
+  }
+
+  const gfx::Rect& bounds = runs.bounds();
+
+  // Align the bands with the previous ones to reuse them. The last
+  // row (bounds.y2()) contains the bottom horizontal segments.
+  const int origin = (m_bands.empty() ? bounds.y : m_bands.front().y);
+  const int y1 = origin + floor_div(bounds.y - origin, kBandRows) * kBandRows;
+  const int y2 = bounds.y2() + 1;
+
+  list_type segs;
+  std::vector<Band> bands;
+  bands.reserve((y2 - y1 + kBandRows - 1) / kBandRows);
+
+  auto oldBand = m_bands.begin();
+  for (int y = y1; y < y2; y += kBandRows) {
+    while (oldBand != m_bands.end() && oldBand->y < y)
+      ++oldBand;
+
+    Band band;
+
+    // The segments of a band depend on its rows and the previous one.
+    if (oldBand != m_bands.end() && oldBand->y == y &&
+        same_rows(m_runs, runs, y - 1, y + kBandRows)) {
+      band = std::move(*oldBand);
+      const auto it = m_segs.begin() + band.firstSeg;
+      band.firstSeg = int(segs.size());
+      segs.insert(segs.end(), it, it + band.nsegs);
+    }
+    else {
+      regenBand(runs, y, segs, band);
+    }
+    bands.push_back(std::move(band));
+  }
+
+  m_segs = std::move(segs);
+  if (!m_path.isEmpty())
+    m_path.rewind();
+
+  m_bands = std::move(bands);
+  m_runs = runs;
+  m_levels.clear();
+}
+
+void MaskBoundaries::regenBand(const MaskRuns& runs,
+                               const int bandY,
+                               list_type& segs,
+                               Band& band)
+{
+  const gfx::Rect& bounds = runs.bounds();
+  const int y1 = std::max(bandY, bounds.y);
+  const int y2 = std::min(bandY + kBandRows, bounds.y2() + 1);
+
+  band.y = bandY;
+  band.firstSeg = int(segs.size());
+
+  // Vertical segment of each X coordinate that can be expanded to
+  // the next row.
+  std::vector<int> vertSegs(bounds.w + 1, -1);
+  MaskRuns::Row edges;
+
+  auto addVertSeg = [&segs, &bounds, &vertSegs](const int x, const int y, const bool open) {
+    int& i = vertSegs[x - bounds.x];
+    if (i >= 0 && segs[i].open() == open && segs[i].bounds().y2() == y) {
+      ++segs[i].m_bounds.h;
+    }
+    else {
+      segs.push_back(Segment(open, gfx::Rect(x, y, 0, 1)));
+      i = int(segs.size() - 1);
+    }
+  };
+
+  for (int y = y1; y < y2; ++y) {
+    const MaskRuns::Row& prevRow = runs.row(y - 1);
+    const MaskRuns::Row& row = runs.row(y);
+
+    // Horizontal segments between the previous row and this one (open
+    // segments have the selected pixels below).
+    MaskRuns::subtractRows(row, prevRow, edges);
+    for (const MaskRuns::Run& run : edges)
+      segs.push_back(Segment(true, gfx::Rect(run.x1, y, run.x2 - run.x1, 0)));
+
+    MaskRuns::subtractRows(prevRow, row, edges);
+    for (const MaskRuns::Run& run : edges)
+      segs.push_back(Segment(false, gfx::Rect(run.x1, y, run.x2 - run.x1, 0)));
+
+    // Vertical segments at both sides of each run (open segments
+    // have the selected pixels at the right side).
+    for (const MaskRuns::Run& run : row) {
+      addVertSeg(run.x1, y, true);
+      addVertSeg(run.x2, y, false);
+    }
+  }
+
+  band.nsegs = int(segs.size()) - band.firstSeg;
+  band.bounds = gfx::Rect();
+  if (band.nsegs > 0) {
+    int bx1 = bounds.x2(), by1 = y2, bx2 = bounds.x, by2 = y1;
+    for (auto it = segs.begin() + band.firstSeg; it != segs.end(); ++it) {
+      const gfx::Rect& rc = it->bounds();
+      bx1 = std::min(bx1, rc.x);
+      by1 = std::min(by1, rc.y);
+      bx2 = std::max(bx2, rc.x2());
+      by2 = std::max(by2, rc.y2());
+    }
+    band.bounds = gfx::Rect(bx1, by1, bx2 - bx1 + 1, by2 - by1 + 1);
+  }
+}
+
 void MaskBoundaries::offset(int x, int y)
 {
   for (Segment& seg : m_segs)
     seg.offset(x, y);
 
   m_path.offset(x, y);
+
+  for (Band& band : m_bands) {
+    band.y += y;
+    band.bounds.offset(x, y);
+    band.path.offset(x, y);
+  }
+  m_runs.offset(x, y);
+
+  // Reduced levels can be moved only if the offset is a multiple of
+  // their factor.
+  for (int i = 0, factor = 2; i < int(m_levels.size()); ++i, factor *= 2) {
+    if ((x % factor) != 0 || (y % factor) != 0) {
+      m_levels.erase(m_levels.begin() + i, m_levels.end());
+      break;
+    }
+    m_levels[i]->offset(x / factor, y / factor);
+  }
 }
 
 void MaskBoundaries::createPathIfNeeeded()
@@ -385,4 +563,40 @@ void MaskBoundaries::createPathIfNeeeded()
   }
 }
 
+void MaskBoundaries::createBandPathIfNeeded(Band& band)
+{
+  if (!band.path.isEmpty())
+    return;
+
+  for (int i = band.firstSeg; i < band.firstSeg + band.nsegs; ++i) {
+    const gfx::Rect& rc = m_segs[i].bounds();
+    band.path.moveTo(rc.x, rc.y);
+
+    if (m_segs[i].vertical())
+      band.path.lineTo(rc.x, rc.y2());
+    else
+      band.path.lineTo(rc.x2(), rc.y);
+  }
+}
+
+MaskBoundaries& MaskBoundaries::levelForScale(const double scale, int& factor)
+{
+  factor = 1;
+  if (m_bands.empty() || int(m_segs.size()) < kMinSegsForLevels)
+    return *this;
+
+  // Use the level where each pixel is one screen pixel or less.
+  MaskBoundaries* level = this;
+  for (int i = 0; i < kMaxLevels && scale * factor * 2 <= 1.0; ++i) {
+    if (i == int(m_levels.size())) {
+      auto reduced = std::make_unique<MaskBoundaries>();
+      reduced->regen(reduce_runs(level->m_runs));
+      m_levels.push_back(std::move(reduced));
+    }
+    level = m_levels[i].get();
+    factor *= 2;
+  }
+  return *level;
+}
+
 } // namespace doc
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2020-2025 Igara Studio S.A.
+// Copyright (c) 2020-2026 Igara Studio S.A.
 // Copyright (c) 2001-2015 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -9,9 +9,11 @@
 #define DOC_MASK_BOUNDARIES_H_INCLUDED
 #pragma once
 
+#include "doc/mask_runs.h"
 #include "gfx/path.h"
 #include "gfx/rect.h"
 
+#include <memory>
 #include <vector>
 
 namespace doc {
@@ -43,11 +45,19 @@ public:
   typedef list_type::iterator iterator;
   typedef list_type::const_iterator const_iterator;
 
+  // Number of rows of each band of segments generated from MaskRuns.
+  static constexpr int kBandRows = 64;
+
   bool isEmpty() const { return m_segs.empty(); }
   void reset();
   void regen(const Mask* mask);
   void regen(const Image* bitmap);
 
+  // Generates the segments by bands of kBandRows rows. If the
+  // previous segments were generated from runs too, only the bands
+  // with rows that are different are generated again.
+  void regen(const MaskRuns& runs);
+
   const_iterator begin() const { return m_segs.begin(); }
   const_iterator end() const { return m_segs.end(); }
   iterator begin() { return m_segs.begin(); }
@@ -58,9 +68,54 @@ public:
 
   void createPathIfNeeeded();
 
+  // Returns the boundaries to draw the selection with the given
+  // scale. For big selections and scale < 0.5 it returns a cached
+  // version of the boundaries generated from the mask reduced
+  // "factor" times (so its coordinates must be scaled by "factor").
+  MaskBoundaries& levelForScale(double scale, int& factor);
+
+  // Calls f(gfx::Path&) with the path of each band that intersects
+  // the given area, or with the whole path if there are no bands.
+  template<typename Func>
+  void forEachPath(const gfx::Rect& area, Func&& f)
+  {
+    if (m_bands.empty()) {
+      createPathIfNeeeded();
+      f(m_path);
+      return;
+    }
+    for (Band& band : m_bands) {
+      if (band.nsegs > 0 && band.bounds.intersects(area)) {
+        createBandPathIfNeeded(band);
+        f(band.path);
+      }
+    }
+  }
+
 private:
+  // Range of m_segs generated from the rows [y, y+kBandRows).
+  struct Band {
+    int y = 0;
+    int firstSeg = 0;
+    int nsegs = 0;
+    gfx::Rect bounds; // Bounds of the segments (including the last pixel)
+    gfx::Path path;
+  };
+
+  void regenBand(const MaskRuns& runs, int bandY, list_type& segs, Band& band);
+  void createBandPathIfNeeded(Band& band);
+
   list_type m_segs;
   gfx::Path m_path;
+
+  // Bands and runs used to generate the segments when they come from
+  // MaskRuns (empty if they were generated from a bitmap).
+  std::vector<Band> m_bands;
+  MaskRuns m_runs;
+
+  // Reduced versions of the boundaries (factor 2, 4, 8...) to draw them
+  // zoomed out, created on demand.
+  std::vector<std::unique_ptr<MaskBoundaries>> m_levels;
 };
 
 } // namespace doc
@@ -0,0 +1,101 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "doc/mask.h"
+#include "doc/mask_boundaries.h"
+#include "doc/mask_runs.h"
+
+#include <random>
+#include <set>
+#include <tuple>
+
+using namespace doc;
+using namespace gfx;
+
+namespace {
+
+// Segments split in edges of one pixel (bands can split a vertical
+// segment in two).
+using Edges = std::set<std::tuple<bool, bool, int, int>>;
+
+Edges pixel_edges(const MaskBoundaries& boundaries)
+{
+  Edges edges;
+  for (const auto& seg : boundaries) {
+    const Rect& rc = seg.bounds();
+    if (seg.vertical()) {
+      for (int y = rc.y; y < rc.y2(); ++y)
+        edges.insert(std::make_tuple(seg.open(), true, rc.x, y));
+    }
+    else {
+      for (int x = rc.x; x < rc.x2(); ++x)
+        edges.insert(std::make_tuple(seg.open(), false, x, rc.y));
+    }
+  }
+  return edges;
+}
+
+} // anonymous namespace
+
+TEST(MaskBoundaries, Incremental)
+{
+  std::mt19937 rng(2026);
+
+  Mask mask;
+  MaskBoundaries boundaries;
+  for (int i = 0; i < 40; ++i) {
+    const Rect rc(rng() % 300, rng() % 300, 1 + rng() % 40, 1 + rng() % 100);
+    if (i % 3 == 2)
+      mask.subtract(rc);
+    else
+      mask.add(rc);
+
+    boundaries.regen(&mask);
+
+    MaskBoundaries fresh;
+    fresh.regen(&mask);
+    EXPECT_EQ(pixel_edges(fresh), pixel_edges(boundaries));
+
+    if (!mask.isEmpty()) {
+      MaskBoundaries fromBitmap;
+      fromBitmap.regen(mask.bitmap());
+      fromBitmap.offset(mask.bounds().x, mask.bounds().y);
+      EXPECT_EQ(pixel_edges(fromBitmap), pixel_edges(boundaries));
+    }
+  }
+
+  mask.clear();
+  boundaries.regen(&mask);
+  EXPECT_TRUE(boundaries.isEmpty());
+}
+
+TEST(MaskBoundaries, Levels)
+{
+  MaskRuns runs;
+  for (int y = 0; y < 600; y += 3)
+    for (int x = 0; x < 600; x += 5)
+      runs.add(Rect(x, y, 2, 1));
+
+  MaskBoundaries boundaries;
+  boundaries.regen(runs);
+
+  int factor;
+  EXPECT_EQ(&boundaries, &boundaries.levelForScale(1.0, factor));
+  EXPECT_EQ(1, factor);
+
+  MaskBoundaries& level = boundaries.levelForScale(0.25, factor);
+  EXPECT_EQ(4, factor);
+  EXPECT_FALSE(level.isEmpty());
+  EXPECT_LT(level.end() - level.begin(), boundaries.end() - boundaries.begin());
+
+  // A 4x4 block of the level is selected if any of its pixels is
+  // selected.
+  MaskBoundaries expected;
+  expected.regen(MaskRuns(Rect(0, 0, 150, 150)));
+  EXPECT_EQ(pixel_edges(expected), pixel_edges(level));
+}
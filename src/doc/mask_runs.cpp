@@ -0,0 +1,331 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "doc/mask_runs.h"
+
+#include "base/debug.h"
+#include "doc/image.h"
+#include "doc/mask.h"
+
+#include <algorithm>
+
+namespace doc {
+
+MaskRuns::MaskRuns(const gfx::Rect& bounds)
+{
+  if (bounds.isEmpty())
+    return;
+
+  m_y = bounds.y;
+  m_rows.resize(bounds.h, Row(1, Run{ bounds.x, bounds.x2() }));
+  m_bounds = bounds;
+}
+
+MaskRuns::MaskRuns(const Mask& mask)
+{
+  if (mask.bitmap())
+    *this = MaskRuns(mask.bitmap(), mask.origin());
+}
+
+MaskRuns::MaskRuns(const Image* bitmap, const gfx::Point& origin)
+{
+  ASSERT(bitmap->pixelFormat() == IMAGE_BITMAP);
+
+  const int w = bitmap->width();
+  const int h = bitmap->height();
+
+  m_y = origin.y;
+  m_rows.resize(h);
+
+  for (int y = 0; y < h; ++y) {
+    const uint8_t* bits = bitmap->getPixelAddress(0, y);
+    Row& row = m_rows[y];
+    int x1 = -1; // Beginning of the current run
+
+    for (int x = 0; x < w;) {
+      const uint8_t byte = bits[x >> 3];
+
+      // Skip 8 pixels at the same time when the whole byte is
+      // selected or unselected.
+      if ((x & 7) == 0 && x + 8 <= w && (byte == 0 || byte == 0xff)) {
+        if (byte == 0 && x1 >= 0) {
+          row.push_back(Run{ origin.x + x1, origin.x + x });
+          x1 = -1;
+        }
+        else if (byte == 0xff && x1 < 0)
+          x1 = x;
+        x += 8;
+        continue;
+      }
+
+      if (byte & (1 << (x & 7))) {
+        if (x1 < 0)
+          x1 = x;
+      }
+      else if (x1 >= 0) {
+        row.push_back(Run{ origin.x + x1, origin.x + x });
+        x1 = -1;
+      }
+      ++x;
+    }
+
+    if (x1 >= 0)
+      row.push_back(Run{ origin.x + x1, origin.x + w });
+  }
+
+  update();
+}
+
+bool MaskRuns::containsPoint(const int x, const int y) const
+{
+  const Row& r = row(y);
+
+  // First run that starts after x
+  auto it = std::upper_bound(r.begin(), r.end(), x, [](int x, const Run& run) {
+    return x < run.x1;
+  });
+  return (it != r.begin() && x < (it - 1)->x2);
+}
+
+int MaskRuns::getMemSize() const
+{
+  int size = sizeof(MaskRuns) + int(m_rows.capacity() * sizeof(Row));
+  for (const Row& r : m_rows)
+    size += int(r.capacity() * sizeof(Run));
+  return size;
+}
+
+const MaskRuns::Row& MaskRuns::row(const int y) const
+{
+  static const Row kEmptyRow;
+  if (y < m_y || y >= m_y + int(m_rows.size()))
+    return kEmptyRow;
+  return m_rows[y - m_y];
+}
+
+void MaskRuns::clear()
+{
+  m_y = 0;
+  m_rows.clear();
+  m_bounds = gfx::Rect();
+}
+
+void MaskRuns::offset(const int dx, const int dy)
+{
+  for (Row& r : m_rows) {
+    for (Run& run : r) {
+      run.x1 += dx;
+      run.x2 += dx;
+    }
+  }
+  m_y += dy;
+  m_bounds.offset(dx, dy);
+}
+
+void MaskRuns::add(const gfx::Rect& bounds)
+{
+  if (bounds.isEmpty())
+    return;
+  if (isEmpty()) {
+    *this = MaskRuns(bounds);
+    return;
+  }
+
+  // Add the run in each row without creating a new list of rows (this
+  // is called for each hline of the selection tools).
+  if (bounds.y < m_y) {
+    m_rows.insert(m_rows.begin(), m_y - bounds.y, Row());
+    m_y = bounds.y;
+  }
+  if (bounds.y2() > m_y + int(m_rows.size()))
+    m_rows.resize(bounds.y2() - m_y);
+
+  for (int y = bounds.y; y < bounds.y2(); ++y) {
+    Row& r = m_rows[y - m_y];
+
+    // Runs that overlap or touch the new one
+    auto first = std::lower_bound(r.begin(), r.end(), bounds.x, [](const Run& run, int x) {
+      return run.x2 < x;
+    });
+    auto last = first;
+    Run run{ bounds.x, bounds.x2() };
+    for (; last != r.end() && last->x1 <= run.x2; ++last) {
+      run.x1 = std::min(run.x1, last->x1);
+      run.x2 = std::max(run.x2, last->x2);
+    }
+    first = r.erase(first, last);
+    r.insert(first, run);
+  }
+
+  m_bounds |= bounds;
+}
+
+void MaskRuns::subtract(const gfx::Rect& bounds)
+{
+  combine(MaskRuns(bounds), Op::Subtract);
+}
+
+void MaskRuns::intersect(const gfx::Rect& bounds)
+{
+  combine(MaskRuns(bounds), Op::Intersect);
+}
+
+void MaskRuns::add(const MaskRuns& other)
+{
+  combine(other, Op::Add);
+}
+
+void MaskRuns::subtract(const MaskRuns& other)
+{
+  combine(other, Op::Subtract);
+}
+
+void MaskRuns::intersect(const MaskRuns& other)
+{
+  combine(other, Op::Intersect);
+}
+
+// static
+void MaskRuns::addRows(const Row& a, const Row& b, Row& result)
+{
+  combineRows(a, b, Op::Add, result);
+}
+
+// static
+void MaskRuns::subtractRows(const Row& a, const Row& b, Row& result)
+{
+  combineRows(a, b, Op::Subtract, result);
+}
+
+// static
+void MaskRuns::intersectRows(const Row& a, const Row& b, Row& result)
+{
+  combineRows(a, b, Op::Intersect, result);
+}
+
+void MaskRuns::combine(const MaskRuns& other, const Op op)
+{
+  if (other.isEmpty()) {
+    if (op == Op::Intersect)
+      clear();
+    return;
+  }
+  if (isEmpty()) {
+    if (op == Op::Add)
+      *this = other;
+    return;
+  }
+
+  // Range of rows of the result
+  const int otherY2 = other.m_y + int(other.m_rows.size());
+  int y1 = m_y;
+  int y2 = m_y + int(m_rows.size());
+  switch (op) {
+    case Op::Add:
+      y1 = std::min(y1, other.m_y);
+      y2 = std::max(y2, otherY2);
+      break;
+    case Op::Subtract: break;
+    case Op::Intersect:
+      y1 = std::max(y1, other.m_y);
+      y2 = std::min(y2, otherY2);
+      break;
+  }
+
+  std::vector<Row> rows(std::max(0, y2 - y1));
+  for (int y = y1; y < y2; ++y)
+    combineRows(row(y), other.row(y), op, rows[y - y1]);
+
+  m_y = y1;
+  m_rows = std::move(rows);
+  update();
+}
+
+// static
+void MaskRuns::combineRows(const Row& a, const Row& b, const Op op, Row& result)
+{
+  result.clear();
+
+  auto ia = a.begin();
+  auto ib = b.begin();
+
+  switch (op) {
+    case Op::Add:
+      // Merge both rows joining overlapping and adjacent runs.
+      while (ia != a.end() || ib != b.end()) {
+        const Run& run = (ib == b.end() || (ia != a.end() && ia->x1 <= ib->x1) ? *ia++ : *ib++);
+        if (!result.empty() && run.x1 <= result.back().x2)
+          result.back().x2 = std::max(result.back().x2, run.x2);
+        else
+          result.push_back(run);
+      }
+      break;
+
+    case Op::Subtract:
+      for (; ia != a.end(); ++ia) {
+        int x1 = ia->x1;
+        const int x2 = ia->x2;
+
+        // Skip the runs of "b" before this run of "a".
+        while (ib != b.end() && ib->x2 <= x1)
+          ++ib;
+
+        for (auto it = ib; it != b.end() && it->x1 < x2; ++it) {
+          if (it->x1 > x1)
+            result.push_back(Run{ x1, it->x1 });
+          x1 = std::max(x1, it->x2);
+        }
+        if (x1 < x2)
+          result.push_back(Run{ x1, x2 });
+      }
+      break;
+
+    case Op::Intersect:
+      while (ia != a.end() && ib != b.end()) {
+        const int x1 = std::max(ia->x1, ib->x1);
+        const int x2 = std::min(ia->x2, ib->x2);
+        if (x1 < x2)
+          result.push_back(Run{ x1, x2 });
+        if (ia->x2 < ib->x2)
+          ++ia;
+        else
+          ++ib;
+      }
+      break;
+  }
+}
+
+void MaskRuns::update()
+{
+  auto first = std::find_if(m_rows.begin(), m_rows.end(), [](const Row& r) { return !r.empty(); });
+  if (first == m_rows.end()) {
+    clear();
+    return;
+  }
+
+  auto last = std::find_if(m_rows.rbegin(), m_rows.rend(), [](const Row& r) {
+                return !r.empty();
+              }).base();
+  m_rows.erase(last, m_rows.end());
+  m_y += int(first - m_rows.begin());
+  m_rows.erase(m_rows.begin(), first);
+
+  int x1 = m_rows.front().front().x1;
+  int x2 = m_rows.front().back().x2;
+  for (const Row& r : m_rows) {
+    if (!r.empty()) {
+      x1 = std::min(x1, r.front().x1);
+      x2 = std::max(x2, r.back().x2);
+    }
+  }
+  m_bounds = gfx::Rect(x1, m_y, x2 - x1, int(m_rows.size()));
+}
+
+} // namespace doc
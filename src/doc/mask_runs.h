@@ -0,0 +1,89 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef DOC_MASK_RUNS_H_INCLUDED
+#define DOC_MASK_RUNS_H_INCLUDED
+#pragma once
+
+#include "gfx/point.h"
+#include "gfx/rect.h"
+
+#include <vector>
+
+namespace doc {
+
+class Image;
+class Mask;
+
+// Run-length representation of a selection: each row contains a
+// sorted list of non-overlapping spans of selected pixels. Its cost
+// depends on the number of spans instead of the area of the bounds,
+// so selection tools can accumulate scattered pixels of a big
+// canvas without a bitmap of the whole sprite.
+class MaskRuns {
+public:
+  // Selected pixels in the [x1, x2) range.
+  struct Run {
+    int x1, x2;
+    bool operator==(const Run& other) const { return x1 == other.x1 && x2 == other.x2; }
+  };
+  using Row = std::vector<Run>;
+
+  MaskRuns() {}
+  explicit MaskRuns(const gfx::Rect& bounds);
+  explicit MaskRuns(const Mask& mask);
+
+  // Creates the runs of the pixels of the bitmap that are equal to
+  // 1. The given origin is the position of the bitmap's (0, 0) pixel.
+  MaskRuns(const Image* bitmap, const gfx::Point& origin);
+
+  bool isEmpty() const { return m_rows.empty(); }
+  const gfx::Rect& bounds() const { return m_bounds; }
+  bool containsPoint(int x, int y) const;
+  int getMemSize() const;
+
+  // Runs of the row "y" (an empty row if y is outside the bounds).
+  const Row& row(int y) const;
+
+  void clear();
+  void offset(int dx, int dy);
+
+  void add(const gfx::Rect& bounds);
+  void subtract(const gfx::Rect& bounds);
+  void intersect(const gfx::Rect& bounds);
+
+  void add(const MaskRuns& other);
+  void subtract(const MaskRuns& other);
+  void intersect(const MaskRuns& other);
+
+  bool operator==(const MaskRuns& other) const
+  {
+    return (m_bounds == other.m_bounds && m_y == other.m_y && m_rows == other.m_rows);
+  }
+  bool operator!=(const MaskRuns& other) const { return !operator==(other); }
+
+  // Operations between two rows (the result cannot be "a" or "b").
+  static void addRows(const Row& a, const Row& b, Row& result);
+  static void subtractRows(const Row& a, const Row& b, Row& result);
+  static void intersectRows(const Row& a, const Row& b, Row& result);
+
+private:
+  enum class Op { Add, Subtract, Intersect };
+
+  void combine(const MaskRuns& other, Op op);
+  static void combineRows(const Row& a, const Row& b, Op op, Row& result);
+
+  // Removes empty rows at the top and bottom, and updates m_bounds.
+  void update();
+
+  int m_y = 0;              // Y coordinate of the first row
+  std::vector<Row> m_rows;  // Rows from m_y to m_y+m_rows.size()-1
+  gfx::Rect m_bounds;       // Bounds of all runs
+};
+
+} // namespace doc
+
+#endif
@@ -0,0 +1,153 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "doc/mask.h"
+#include "doc/mask_boundaries.h"
+#include "doc/mask_runs.h"
+
+#include <algorithm>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace doc;
+using namespace gfx;
+
+namespace {
+
+using Segs = std::vector<std::tuple<bool, int, int, int, int>>;
+
+Segs sorted_segs(const MaskBoundaries& boundaries)
+{
+  Segs segs;
+  for (const auto& seg : boundaries) {
+    const Rect& rc = seg.bounds();
+    segs.push_back(std::make_tuple(seg.open(), rc.x, rc.y, rc.w, rc.h));
+  }
+  std::sort(segs.begin(), segs.end());
+  return segs;
+}
+
+} // anonymous namespace
+
+TEST(MaskRuns, Rects)
+{
+  MaskRuns runs;
+  EXPECT_TRUE(runs.isEmpty());
+
+  runs.add(Rect(2, 1, 3, 2));
+  runs.add(Rect(5, 2, 2, 2));
+  EXPECT_EQ(Rect(2, 1, 5, 3), runs.bounds());
+  EXPECT_EQ(1, int(runs.row(1).size()));
+  ASSERT_EQ(1, int(runs.row(2).size())); // [2, 5) and [5, 7) are joined
+  EXPECT_EQ(2, runs.row(2)[0].x1);
+  EXPECT_EQ(7, runs.row(2)[0].x2);
+  EXPECT_TRUE(runs.row(0).empty());
+
+  EXPECT_TRUE(runs.containsPoint(2, 1));
+  EXPECT_TRUE(runs.containsPoint(6, 3));
+  EXPECT_FALSE(runs.containsPoint(4, 3));
+  EXPECT_FALSE(runs.containsPoint(7, 2));
+
+  runs.subtract(Rect(3, 0, 1, 10));
+  EXPECT_EQ(2, int(runs.row(2).size()));
+  EXPECT_FALSE(runs.containsPoint(3, 2));
+
+  runs.intersect(Rect(5, 0, 10, 10));
+  EXPECT_EQ(Rect(5, 2, 2, 2), runs.bounds());
+
+  runs.offset(-5, -2);
+  EXPECT_EQ(MaskRuns(Rect(0, 0, 2, 2)), runs);
+
+  runs.subtract(Rect(0, 0, 2, 2));
+  EXPECT_TRUE(runs.isEmpty());
+}
+
+TEST(MaskRuns, FromMask)
+{
+  Mask mask;
+  mask.replace(Rect(3, 4, 20, 3));
+  mask.subtract(Rect(9, 5, 9, 1));
+
+  MaskRuns runs(mask);
+  EXPECT_EQ(mask.bounds(), runs.bounds());
+  for (int y = 0; y < 10; ++y)
+    for (int x = 0; x < 30; ++x)
+      EXPECT_EQ(mask.containsPoint(x, y), runs.containsPoint(x, y)) << x << "," << y;
+
+  Mask mask2;
+  mask2.add(runs);
+  EXPECT_EQ(mask.bounds(), mask2.bounds());
+  EXPECT_EQ(runs, MaskRuns(mask2));
+}
+
+TEST(MaskRuns, MaskOperations)
+{
+  std::mt19937 rng(2026);
+
+  for (int i = 0; i < 50; ++i) {
+    Mask a, b;
+    MaskRuns runsA, runsB;
+    for (int j = 0; j < 8; ++j) {
+      const Rect rc(rng() % 40, rng() % 40, 1 + rng() % 20, 1 + rng() % 20);
+      if (j % 2 == 0) {
+        a.add(rc);
+        runsA.add(rc);
+      }
+      else {
+        b.add(rc);
+        runsB.add(rc);
+      }
+    }
+    EXPECT_EQ(runsA, MaskRuns(a));
+    EXPECT_EQ(runsB, MaskRuns(b));
+
+    Mask c;
+    MaskRuns runsC = runsA;
+    switch (i % 3) {
+      case 0:
+        c.copyFrom(&a);
+        c.add(b);
+        runsC.add(runsB);
+        break;
+      case 1:
+        c.copyFrom(&a);
+        c.subtract(b);
+        runsC.subtract(runsB);
+        break;
+      case 2:
+        c.copyFrom(&a);
+        c.intersect(b);
+        runsC.intersect(runsB);
+        break;
+    }
+    EXPECT_EQ(runsC, MaskRuns(c));
+    EXPECT_EQ(runsC.bounds(), c.bounds());
+  }
+}
+
+TEST(MaskRuns, Boundaries)
+{
+  std::mt19937 rng(1);
+
+  for (int i = 0; i < 20; ++i) {
+    Mask mask;
+    mask.replace(Rect(1, 2, 30, 20));
+    for (int j = 0; j < 10; ++j)
+      mask.subtract(Rect(rng() % 32, rng() % 24, 1 + rng() % 8, 1 + rng() % 8));
+
+    MaskBoundaries fromBitmap, fromRuns;
+    if (!mask.isEmpty()) {
+      fromBitmap.regen(mask.bitmap());
+      fromBitmap.offset(mask.bounds().x, mask.bounds().y);
+    }
+    fromRuns.regen(&mask);
+
+    EXPECT_EQ(sorted_segs(fromBitmap), sorted_segs(fromRuns));
+  }
+}
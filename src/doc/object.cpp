@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (C) 2019-2022  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2016  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -13,15 +13,38 @@
 
 #include "base/debug.h"
 
-#include <map>
+#include <array>
+#include <atomic>
 #include <mutex>
+#include <unordered_map>
 
 namespace doc {
 
-static std::mutex g_mutex;
-static ObjectId newId = 0;
-// TODO Profile this and see if an unordered_map is better
-static std::map<ObjectId, Object*> objects;
+namespace {
+
+// The registry of objects is split in several shards (each one with
+// its own mutex), so threads creating/destroying objects at the same
+// time (e.g. loading files, or undoing big operations) don't contend
+// for the same lock.
+struct Shard {
+  std::mutex mutex;
+  std::unordered_map<ObjectId, Object*> objects;
+};
+
+constexpr std::size_t kShards = 64;
+std::array<Shard, kShards> g_shards;
+
+std::atomic<ObjectId> g_newId{ 0 };
+std::atomic<std::size_t> g_liveObjects{ 0 };
+std::atomic<std::size_t> g_lookups{ 0 };
+
+Shard& shard_for(const ObjectId id)
+{
+  // Consecutive IDs go to different shards
+  return g_shards[id % kShards];
+}
+
+} // anonymous namespace
 
 Object::Object(ObjectType type) : m_type(type), m_id(0), m_version(0)
 {
@@ -50,31 +73,38 @@ const ObjectId Object::id() const
   // The first time the ID is request, we store the object in the
   // "objects" hash table.
   if (!m_id) {
-    const std::lock_guard lock(g_mutex);
-    m_id = ++newId;
-    objects.insert(std::make_pair(m_id, const_cast<Object*>(this)));
+    const ObjectId id = ++g_newId;
+    Shard& shard = shard_for(id);
+    const std::lock_guard lock(shard.mutex);
+    m_id = id;
+    shard.objects.insert(std::make_pair(m_id, const_cast<Object*>(this)));
+    ++g_liveObjects;
   }
   return m_id;
 }
 
 void Object::setId(ObjectId id)
 {
-  const std::lock_guard lock(g_mutex);
-
   if (m_id) {
-    auto it = objects.find(m_id);
-    ASSERT(it != objects.end());
+    Shard& shard = shard_for(m_id);
+    const std::lock_guard lock(shard.mutex);
+    auto it = shard.objects.find(m_id);
+    ASSERT(it != shard.objects.end());
     ASSERT(it->second == this);
-    if (it != objects.end())
-      objects.erase(it);
+    if (it != shard.objects.end()) {
+      shard.objects.erase(it);
+      --g_liveObjects;
+    }
   }
 
   m_id = id;
 
   if (m_id) {
+    Shard& shard = shard_for(m_id);
+    const std::lock_guard lock(shard.mutex);
 #ifdef _DEBUG
-    if (objects.find(m_id) != objects.end()) {
-      Object* obj = objects.find(m_id)->second;
+    if (shard.objects.find(m_id) != shard.objects.end()) {
+      Object* obj = shard.objects.find(m_id)->second;
       if (obj) {
         TRACEARGS("ASSERT FAILED: Object with id",
                   m_id,
@@ -88,9 +118,10 @@ void Object::setId(ObjectId id)
         TRACEARGS("ASSERT FAILED: Object with id", m_id, "registered as nullptr should not exist");
       }
     }
-    ASSERT(objects.find(m_id) == objects.end());
+    ASSERT(shard.objects.find(m_id) == shard.objects.end());
 #endif
-    objects.insert(std::make_pair(m_id, this));
+    if (shard.objects.insert(std::make_pair(m_id, this)).second)
+      ++g_liveObjects;
   }
 }
 
@@ -101,12 +132,24 @@ void Object::setVersion(ObjectVersion version)
 
 Object* get_object(ObjectId id)
 {
-  const std::lock_guard lock(g_mutex);
-  auto it = objects.find(id);
-  if (it != objects.end())
+  ++g_lookups;
+
+  Shard& shard = shard_for(id);
+  const std::lock_guard lock(shard.mutex);
+  auto it = shard.objects.find(id);
+  if (it != shard.objects.end())
     return it->second;
   else
     return nullptr;
 }
 
+ObjectsStats get_objects_stats()
+{
+  ObjectsStats stats;
+  stats.liveObjects = g_liveObjects;
+  stats.createdIds = g_newId;
+  stats.lookups = g_lookups;
+  return stats;
+}
+
 } // namespace doc
@@ -1,4 +1,5 @@
 // Aseprite Document Library
+// Copyright (c) 2026  Igara Studio S.A.
 // Copyright (c) 2001-2015 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -12,6 +13,8 @@
 #include "doc/object_type.h"
 #include "doc/object_version.h"
 
+#include <cstddef>
+
 namespace doc {
 
 class Object {
@@ -48,6 +51,15 @@ private:
 
 Object* get_object(ObjectId id);
 
+// Counters of the registry of objects (for debugging/profiling).
+struct ObjectsStats {
+  std::size_t liveObjects = 0; // Objects with an ID right now
+  std::size_t createdIds = 0;  // Last ID assigned by Object::id()
+  std::size_t lookups = 0;     // Number of get_object() calls
+};
+
+ObjectsStats get_objects_stats();
+
 template<typename T>
 inline T* get(ObjectId id)
 {
@@ -0,0 +1,87 @@
+// Aseprite Document Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "doc/object.h"
+
+#include <memory>
+#include <set>
+#include <thread>
+#include <vector>
+
+using namespace doc;
+
+namespace {
+
+class TestObject : public Object {
+public:
+  TestObject() : Object(ObjectType::Image) {}
+};
+
+} // anonymous namespace
+
+TEST(Object, GetObjectById)
+{
+  const ObjectsStats before = get_objects_stats();
+
+  ObjectId id;
+  {
+    TestObject a, b;
+    EXPECT_NE(a.id(), b.id());
+    EXPECT_EQ(&a, get_object(a.id()));
+    EXPECT_EQ(&b, get_object(b.id()));
+    EXPECT_EQ(before.liveObjects + 2, get_objects_stats().liveObjects);
+
+    id = a.id();
+  }
+  EXPECT_EQ(nullptr, get_object(id));
+  EXPECT_EQ(before.liveObjects, get_objects_stats().liveObjects);
+  EXPECT_LT(before.lookups, get_objects_stats().lookups);
+}
+
+TEST(Object, SetId)
+{
+  TestObject a;
+  const ObjectId oldId = a.id();
+  const ObjectId newId = get_objects_stats().createdIds + 1000;
+
+  a.setId(newId);
+  EXPECT_EQ(newId, a.id());
+  EXPECT_EQ(nullptr, get_object(oldId));
+  EXPECT_EQ(&a, get_object(newId));
+
+  a.setId(0);
+  EXPECT_EQ(nullptr, get_object(newId));
+}
+
+TEST(Object, CreateFromThreads)
+{
+  const int kThreads = 8;
+  const int kObjects = 1000;
+
+  std::vector<std::vector<std::unique_ptr<TestObject>>> objects(kThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&objects, i] {
+      for (int j = 0; j < kObjects; ++j) {
+        objects[i].push_back(std::make_unique<TestObject>());
+        objects[i].back()->id();
+      }
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  std::set<ObjectId> ids;
+  for (const auto& objs : objects) {
+    for (const auto& obj : objs) {
+      EXPECT_EQ(obj.get(), get_object(obj->id()));
+      ids.insert(obj->id());
+    }
+  }
+  EXPECT_EQ(std::size_t(kThreads * kObjects), ids.size());
+}
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2018-2023 Igara Studio S.A.
+// Copyright (c) 2018-2026 Igara Studio S.A.
 // Copyright (c) 2001-2016 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -16,6 +16,7 @@
 #include "doc/dispatch.h"
 #include "doc/image.h"
 #include "doc/palette.h"
+#include "doc/primitives_fast.h"
 #include "doc/remap.h"
 #include "doc/rgbmap.h"
 #include "doc/tile.h"
@@ -23,6 +24,8 @@
 
 #include <city.h>
 
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
 #if defined(__x86_64__) || defined(_WIN64)
@@ -387,67 +390,183 @@ bool is_same_image_templ(const Image* i1, const Image* i2)
   return true;
 }
 
+// The SIMD versions of the primitives compare blocks of 16 bytes of
+// two rows (or a row and a plain color), and only the blocks that are
+// not bitwise equal are checked pixel by pixel with same_color() (as
+// two pixels can be different but represent the same color, e.g. RGB
+// pixels with alpha=0).
+
+constexpr int kSimdBlockBytes = 16;
+
 template<typename ImageTraits>
-bool is_same_image_simd_templ(const Image* i1, const Image* i2)
+constexpr int simd_block_pixels()
+{
+  return kSimdBlockBytes / ImageTraits::bytes_per_pixel;
+}
+
+// Returns true if the 16 bytes at "p" and "q" are equal. Loads are
+// unaligned, rows of images don't have to be aligned to 16 bytes.
+inline bool is_same_simd_block(const void* p, const void* q)
+{
+#if defined(__x86_64__) || defined(_WIN64)
+  // Use SSE2
+  const __m128i a = _mm_loadu_si128((const __m128i*)p);
+  const __m128i b = _mm_loadu_si128((const __m128i*)q);
+  return (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) == 0xffff);
+#else
+  // The compiler generates two 64-bit comparisons for this memcmp()
+  return (std::memcmp(p, q, kSimdBlockBytes) == 0);
+#endif
+}
+
+template<typename ImageTraits>
+bool is_plain_image_simd_templ(const Image* img, const color_t color)
+{
+  using pixel_t = typename ImageTraits::pixel_t;
+  constexpr int n = simd_block_pixels<ImageTraits>();
+
+  pixel_t pattern[n];
+  std::fill(pattern, pattern + n, pixel_t(color));
+
+  const int w = img->width();
+  const int h = img->height();
+  for (int y = 0; y < h; ++y) {
+    auto p = (const pixel_t*)img->getPixelAddress(0, y);
+    for (int x = 0; x < w;) {
+      if (x + n <= w && is_same_simd_block(p + x, pattern)) {
+        x += n;
+        continue;
+      }
+      for (const int end = std::min(x + n, w); x < end; ++x) {
+        if (!ImageTraits::same_color(p[x], pixel_t(color)))
+          return false;
+      }
+    }
+  }
+  return true;
+}
+
+template<typename ImageTraits>
+int count_diff_between_images_simd_templ(const Image* i1, const Image* i2)
 {
-  using address_t = typename ImageTraits::address_t;
+  using pixel_t = typename ImageTraits::pixel_t;
+  constexpr int n = simd_block_pixels<ImageTraits>();
+
+  int diff = 0;
   const int w = i1->width();
   const int h = i1->height();
   for (int y = 0; y < h; ++y) {
-    auto p = (const address_t)i1->getPixelAddress(0, y);
-    auto q = (const address_t)i2->getPixelAddress(0, y);
-    int x = 0;
-
-#if DOC_USE_ALIGNED_PIXELS
-  #if defined(__x86_64__) || defined(_WIN64)
-    // Use SSE2
-
-    if constexpr (ImageTraits::bytes_per_pixel == 4) {
-      for (; x + 4 <= w; x += 4, p += 4, q += 4) {
-        __m128i r = _mm_cmpeq_epi32(*(const __m128i*)p, *(const __m128i*)q);
-        if (_mm_movemask_epi8(r) != 0xffff) { // !_mm_test_all_ones(r)
-          if (!ImageTraits::same_color(p[0], q[0]) || !ImageTraits::same_color(p[1], q[1]) ||
-              !ImageTraits::same_color(p[2], q[2]) || !ImageTraits::same_color(p[3], q[3]))
-            return false;
-        }
+    auto p = (const pixel_t*)i1->getPixelAddress(0, y);
+    auto q = (const pixel_t*)i2->getPixelAddress(0, y);
+    for (int x = 0; x < w;) {
+      if (x + n <= w && is_same_simd_block(p + x, q + x)) {
+        x += n;
+        continue;
       }
-    }
-    else if constexpr (ImageTraits::bytes_per_pixel == 2) {
-      for (; x + 8 <= w; x += 8, p += 8, q += 8) {
-        __m128i r = _mm_cmpeq_epi16(*(const __m128i*)p, *(const __m128i*)q);
-        if (_mm_movemask_epi8(r) != 0xffff) { // !_mm_test_all_ones(r)
-          if (!ImageTraits::same_color(p[0], q[0]) || !ImageTraits::same_color(p[1], q[1]) ||
-              !ImageTraits::same_color(p[2], q[2]) || !ImageTraits::same_color(p[3], q[3]) ||
-              !ImageTraits::same_color(p[4], q[4]) || !ImageTraits::same_color(p[5], q[5]) ||
-              !ImageTraits::same_color(p[6], q[6]) || !ImageTraits::same_color(p[7], q[7]))
-            return false;
-        }
+      for (const int end = std::min(x + n, w); x < end; ++x) {
+        if (!ImageTraits::same_color(p[x], q[x]))
+          ++diff;
       }
     }
-    else if constexpr (ImageTraits::bytes_per_pixel == 1) {
-      for (; x + 16 <= w; x += 16, p += 16, q += 16) {
-        __m128i r = _mm_cmpeq_epi8(*(const __m128i*)p, *(const __m128i*)q);
-        if (_mm_movemask_epi8(r) != 0xffff) { // !_mm_test_all_ones(r)
-          return false;
-        }
+  }
+  return diff;
+}
+
+template<typename ImageTraits>
+bool is_same_image_simd_templ(const Image* i1, const Image* i2)
+{
+  using pixel_t = typename ImageTraits::pixel_t;
+  constexpr int n = simd_block_pixels<ImageTraits>();
+
+  const int w = i1->width();
+  const int h = i1->height();
+  for (int y = 0; y < h; ++y) {
+    auto p = (const pixel_t*)i1->getPixelAddress(0, y);
+    auto q = (const pixel_t*)i2->getPixelAddress(0, y);
+    for (int x = 0; x < w;) {
+      if (x + n <= w && is_same_simd_block(p + x, q + x)) {
+        x += n;
+        continue;
       }
-    }
-  #endif
-#endif // DOC_USE_ALIGNED_PIXELS
-    {
-      for (; x + 4 <= w; x += 4, p += 4, q += 4) {
-        if (!ImageTraits::same_color(p[0], q[0]) || !ImageTraits::same_color(p[1], q[1]) ||
-            !ImageTraits::same_color(p[2], q[2]) || !ImageTraits::same_color(p[3], q[3]))
+      for (const int end = std::min(x + n, w); x < end; ++x) {
+        if (!ImageTraits::same_color(p[x], q[x]))
           return false;
       }
     }
+  }
+  return true;
+}
+
+template<typename ImageTraits>
+gfx::Rect get_diff_bounds_between_images_simd_templ(const Image* i1, const Image* i2)
+{
+  using pixel_t = typename ImageTraits::pixel_t;
+  constexpr int n = simd_block_pixels<ImageTraits>();
 
-    for (; x < w; ++x, ++p, ++q) {
-      if (!ImageTraits::same_color(*p, *q))
-        return false;
+  const int w = i1->width();
+  const int h = i1->height();
+  int x1 = w, y1 = h, x2 = -1, y2 = -1;
+  for (int y = 0; y < h; ++y) {
+    auto p = (const pixel_t*)i1->getPixelAddress(0, y);
+    auto q = (const pixel_t*)i2->getPixelAddress(0, y);
+
+    // First different pixel of this row
+    int first = 0;
+    while (first < w) {
+      if (first + n <= w && is_same_simd_block(p + first, q + first))
+        first += n;
+      else if (p[first] == q[first])
+        ++first;
+      else
+        break;
+    }
+    if (first == w)
+      continue;
+
+    // Last different pixel of this row (we only need to look for it
+    // after the current right side of the bounds)
+    int last = w - 1;
+    const int stop = std::max(first, x2);
+    while (last > stop) {
+      if (last + 1 - n >= stop && is_same_simd_block(p + last + 1 - n, q + last + 1 - n))
+        last -= n;
+      else if (p[last] == q[last])
+        --last;
+      else
+        break;
     }
+
+    x1 = std::min(x1, first);
+    x2 = std::max(x2, last);
+    if (y1 == h)
+      y1 = y;
+    y2 = y;
   }
-  return true;
+
+  if (x2 < x1)
+    return gfx::Rect();
+  return gfx::Rect(x1, y1, x2 - x1 + 1, y2 - y1 + 1);
+}
+
+template<typename ImageTraits>
+gfx::Rect get_diff_bounds_between_images_templ(const Image* i1, const Image* i2)
+{
+  const int w = i1->width();
+  const int h = i1->height();
+  int x1 = w, y1 = h, x2 = -1, y2 = -1;
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      if (get_pixel_fast<ImageTraits>(i1, x, y) != get_pixel_fast<ImageTraits>(i2, x, y)) {
+        x1 = std::min(x1, x);
+        x2 = std::max(x2, x);
+        y1 = std::min(y1, y);
+        y2 = y;
+      }
+    }
+  }
+  if (x2 < x1)
+    return gfx::Rect();
+  return gfx::Rect(x1, y1, x2 - x1 + 1, y2 - y1 + 1);
 }
 
 } // anonymous namespace
@@ -455,11 +574,11 @@ bool is_same_image_simd_templ(const Image* i1, const Image* i2)
 bool is_plain_image(const Image* img, color_t c)
 {
   switch (img->pixelFormat()) {
-    case IMAGE_RGB:       return is_plain_image_templ<RgbTraits>(img, c);
-    case IMAGE_GRAYSCALE: return is_plain_image_templ<GrayscaleTraits>(img, c);
-    case IMAGE_INDEXED:   return is_plain_image_templ<IndexedTraits>(img, c);
+    case IMAGE_RGB:       return is_plain_image_simd_templ<RgbTraits>(img, c);
+    case IMAGE_GRAYSCALE: return is_plain_image_simd_templ<GrayscaleTraits>(img, c);
+    case IMAGE_INDEXED:   return is_plain_image_simd_templ<IndexedTraits>(img, c);
     case IMAGE_BITMAP:    return is_plain_image_templ<BitmapTraits>(img, c);
-    case IMAGE_TILEMAP:   return is_plain_image_templ<TilemapTraits>(img, c);
+    case IMAGE_TILEMAP:   return is_plain_image_simd_templ<TilemapTraits>(img, c);
   }
   return false;
 }
@@ -479,17 +598,38 @@ int count_diff_between_images(const Image* i1, const Image* i2)
     return -1;
 
   switch (i1->pixelFormat()) {
-    case IMAGE_RGB:       return count_diff_between_images_templ<RgbTraits>(i1, i2);
-    case IMAGE_GRAYSCALE: return count_diff_between_images_templ<GrayscaleTraits>(i1, i2);
-    case IMAGE_INDEXED:   return count_diff_between_images_templ<IndexedTraits>(i1, i2);
+    case IMAGE_RGB:       return count_diff_between_images_simd_templ<RgbTraits>(i1, i2);
+    case IMAGE_GRAYSCALE: return count_diff_between_images_simd_templ<GrayscaleTraits>(i1, i2);
+    case IMAGE_INDEXED:   return count_diff_between_images_simd_templ<IndexedTraits>(i1, i2);
     case IMAGE_BITMAP:    return count_diff_between_images_templ<BitmapTraits>(i1, i2);
-    case IMAGE_TILEMAP:   return count_diff_between_images_templ<TilemapTraits>(i1, i2);
+    case IMAGE_TILEMAP:   return count_diff_between_images_simd_templ<TilemapTraits>(i1, i2);
   }
 
   ASSERT(false);
   return -1;
 }
 
+gfx::Rect get_diff_bounds_between_images(const Image* i1, const Image* i2)
+{
+  ASSERT(i1->pixelFormat() == i2->pixelFormat());
+  ASSERT(i1->size() == i2->size());
+  if ((i1->pixelFormat() != i2->pixelFormat()) || (i1->width() != i2->width()) ||
+      (i1->height() != i2->height()))
+    return gfx::Rect();
+
+  switch (i1->pixelFormat()) {
+    case IMAGE_RGB:     return get_diff_bounds_between_images_simd_templ<RgbTraits>(i1, i2);
+    case IMAGE_GRAYSCALE:
+      return get_diff_bounds_between_images_simd_templ<GrayscaleTraits>(i1, i2);
+    case IMAGE_INDEXED: return get_diff_bounds_between_images_simd_templ<IndexedTraits>(i1, i2);
+    case IMAGE_BITMAP:  return get_diff_bounds_between_images_templ<BitmapTraits>(i1, i2);
+    case IMAGE_TILEMAP: return get_diff_bounds_between_images_simd_templ<TilemapTraits>(i1, i2);
+  }
+
+  ASSERT(false);
+  return gfx::Rect();
+}
+
 bool is_same_image_slow(const Image* i1, const Image* i2)
 {
   if ((i1->colorMode() != i2->colorMode()) || (i1->width() != i2->width()) ||
@@ -523,15 +663,22 @@ void remap_image(Image* image, const Remap& remap)
   ASSERT(image->pixelFormat() == IMAGE_INDEXED || image->pixelFormat() == IMAGE_TILEMAP);
 
   switch (image->pixelFormat()) {
-    case IMAGE_INDEXED:
-      transform_image<IndexedTraits>(image, [&remap](color_t c) -> color_t {
-        auto to = remap[c];
-        if (to != Remap::kUnused)
-          return to;
-        else
-          return c;
-      });
+    case IMAGE_INDEXED: {
+      // Byte lookup table applied to each row (instead of calling
+      // Remap::operator[] for each pixel)
+      uint8_t lut[256];
+      for (int i = 0; i < 256; ++i) {
+        const int to = remap[i];
+        lut[i] = uint8_t(to != Remap::kUnused ? to : i);
+      }
+      const int w = image->width();
+      for (int y = 0; y < image->height(); ++y) {
+        uint8_t* p = image->getPixelAddress(0, y);
+        for (int x = 0; x < w; ++x)
+          p[x] = lut[p[x]];
+      }
       break;
+    }
     case IMAGE_TILEMAP:
       transform_image<TilemapTraits>(image, [&remap](color_t c) -> color_t {
         auto to = remap[tile_geti(c)];
@@ -588,6 +735,23 @@ uint32_t calculate_image_hash(const Image* img, const gfx::Rect& bounds)
   return 0;
 }
 
+uint64_t calculate_image_hash64(const Image* img, const gfx::Rect& bounds)
+{
+  ASSERT(img->bounds().contains(bounds));
+
+  // Each row is hashed using the hash of the previous rows as seed,
+  // so we don't need to copy the pixels of a sub-rectangle to a
+  // contiguous buffer, and the hash doesn't depend on the row stride
+  // of the image.
+  const std::size_t widthBytes = std::size_t(img->bytesPerPixel()) * bounds.w;
+  uint64_t hash = (uint64_t(bounds.w) << 32) | uint64_t(bounds.h);
+  for (int y = 0; y < bounds.h; ++y) {
+    auto src = (const char*)img->getPixelAddress(bounds.x, bounds.y + y);
+    hash = CityHash64WithSeed(src, widthBytes, hash);
+  }
+  return hash;
+}
+
 void preprocess_transparent_pixels(Image* image)
 {
   switch (image->pixelFormat()) {
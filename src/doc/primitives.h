@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2018-2023 Igara Studio S.A.
+// Copyright (c) 2018-2026 Igara Studio S.A.
 // Copyright (c) 2001-2016 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -71,10 +71,20 @@ int count_diff_between_images(const Image* i1, const Image* i2);
 bool is_same_image(const Image* i1, const Image* i2);
 bool is_same_image_slow(const Image* i1, const Image* i2);
 
+// Returns the bounds of the pixels that are different (bitwise)
+// between two images of the same size and pixel format, or an empty
+// rectangle if both images are equal.
+gfx::Rect get_diff_bounds_between_images(const Image* i1, const Image* i2);
+
 void remap_image(Image* image, const Remap& remap);
 
 uint32_t calculate_image_hash(const Image* image, const gfx::Rect& bounds);
 
+// 64-bit hash of the pixels inside the given bounds. Equal pixels
+// give the same hash even if they are in images with different row
+// strides or positions.
+uint64_t calculate_image_hash64(const Image* image, const gfx::Rect& bounds);
+
 // Sets RGB values to 0 when alpha=0 (to match images with alpha=0
 // in tilesets/calculate_image_hash)
 void preprocess_transparent_pixels(Image* image);
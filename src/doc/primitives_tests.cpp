@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2023-2025  Igara Studio S.A.
+// Copyright (c) 2023-2026  Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -81,6 +81,91 @@ TYPED_TEST(Primitives, IsSameImage)
   }
 }
 
+// Returns two different colors (for index=0 and 1) that are not
+// transparent in the given pixel format
+template<typename ImageTraits>
+static color_t opaque_color(const int index)
+{
+  if constexpr (ImageTraits::pixel_format == IMAGE_RGB)
+    return (index == 0 ? rgba(255, 0, 0, 255) : rgba(0, 0, 255, 255));
+  else if constexpr (ImageTraits::pixel_format == IMAGE_GRAYSCALE)
+    return (index == 0 ? graya(0, 255) : graya(255, 255));
+  else
+    return index;
+}
+
+TYPED_TEST(Primitives, CountDiffAndDiffBounds)
+{
+  using ImageTraits = TypeParam;
+
+  // Widths that are not multiple of the SIMD block size
+  for (int w : { 1, 7, 16, 37 }) {
+    const int h = 5;
+    ImageRef a(Image::create(ImageTraits::pixel_format, w, h));
+    doc::algorithm::random_image(a.get());
+    ImageRef b(Image::createCopy(a.get()));
+
+    EXPECT_EQ(0, count_diff_between_images(a.get(), b.get()));
+    EXPECT_TRUE(get_diff_bounds_between_images(a.get(), b.get()).isEmpty());
+
+    const color_t c1 = opaque_color<ImageTraits>(0);
+    const color_t c2 = opaque_color<ImageTraits>(1);
+    const gfx::Point pts[] = { gfx::Point(w - 1, 1), gfx::Point(w / 2, 3) };
+    for (const gfx::Point& pt : pts) {
+      put_pixel_fast<ImageTraits>(a.get(), pt.x, pt.y, c1);
+      put_pixel_fast<ImageTraits>(b.get(), pt.x, pt.y, c2);
+    }
+
+    EXPECT_EQ(2, count_diff_between_images(a.get(), b.get()));
+    EXPECT_EQ(gfx::Rect(w / 2, 1, w - w / 2, 3),
+              get_diff_bounds_between_images(a.get(), b.get()));
+  }
+}
+
+TYPED_TEST(Primitives, IsPlainImage)
+{
+  using ImageTraits = TypeParam;
+
+  for (int w : { 1, 7, 16, 37 }) {
+    const color_t c1 = opaque_color<ImageTraits>(0);
+    const color_t c2 = opaque_color<ImageTraits>(1);
+
+    ImageRef a(Image::create(ImageTraits::pixel_format, w, 3));
+    clear_image(a.get(), c2);
+    EXPECT_TRUE(is_plain_image(a.get(), c2));
+    EXPECT_FALSE(is_plain_image(a.get(), c1));
+
+    put_pixel_fast<ImageTraits>(a.get(), w - 1, 2, c1);
+    EXPECT_FALSE(is_plain_image(a.get(), c2));
+  }
+}
+
+TEST(Primitives, IsPlainImageWithTransparentPixels)
+{
+  // RGB pixels with alpha=0 are the same color
+  ImageRef a(Image::create(IMAGE_RGB, 20, 2));
+  clear_image(a.get(), rgba(0, 0, 0, 0));
+  put_pixel(a.get(), 3, 1, rgba(255, 0, 0, 0));
+  EXPECT_TRUE(is_empty_image(a.get()));
+  EXPECT_TRUE(is_plain_image(a.get(), rgba(0, 255, 0, 0)));
+}
+
+TEST(Primitives, CalculateImageHash64)
+{
+  ImageRef a(Image::create(IMAGE_RGB, 32, 32));
+  doc::algorithm::random_image(a.get());
+
+  // The hash of a part of the image is the same as the hash of a
+  // copy of that part.
+  const gfx::Rect rc(5, 7, 11, 9);
+  ImageRef b(crop_image(a.get(), rc, 0));
+  EXPECT_EQ(calculate_image_hash64(a.get(), rc), calculate_image_hash64(b.get(), b->bounds()));
+  EXPECT_NE(calculate_image_hash64(a.get(), rc), calculate_image_hash64(a.get(), a->bounds()));
+
+  put_pixel(b.get(), 10, 8, get_pixel(b.get(), 10, 8) ^ 1);
+  EXPECT_NE(calculate_image_hash64(a.get(), rc), calculate_image_hash64(b.get(), b->bounds()));
+}
+
 int main(int argc, char** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
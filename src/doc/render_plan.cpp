@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2023  Igara Studio S.A.
+// Copyright (c) 2023-2026  Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -14,10 +14,17 @@
 #include "doc/layer.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 
 namespace doc {
 
+static std::atomic<uint64_t> g_structureVersion(1);
+
+// Maximum number of plans in a RenderPlanCache (e.g. a plan for each
+// frame of the onion skin).
+static constexpr std::size_t kMaxCachedPlans = 64;
+
 RenderPlan::RenderPlan()
 {
 }
@@ -68,4 +75,49 @@ void RenderPlan::processZIndexes() const
   });
 }
 
+// static
+uint64_t RenderPlan::structureVersion()
+{
+  return g_structureVersion;
+}
+
+// static
+void RenderPlan::incrementStructureVersion()
+{
+  ++g_structureVersion;
+}
+
+std::shared_ptr<const RenderPlan> RenderPlanCache::plan(const Layer* layer,
+                                                        const frame_t frame,
+                                                        const bool composeGroups)
+{
+  const std::lock_guard lock(m_mutex);
+
+  const uint64_t version = RenderPlan::structureVersion();
+  if (m_version != version) {
+    m_version = version;
+    m_plans.clear();
+  }
+
+  const Key key(layer, frame, composeGroups);
+  auto it = m_plans.find(key);
+  if (it != m_plans.end())
+    return it->second;
+
+  auto plan = std::make_shared<RenderPlan>(composeGroups);
+  plan->addLayer(layer, frame);
+  plan->items(); // Sort by z-index before sharing the plan
+
+  if (m_plans.size() >= kMaxCachedPlans)
+    m_plans.clear();
+  m_plans[key] = plan;
+  return plan;
+}
+
+void RenderPlanCache::clear()
+{
+  const std::lock_guard lock(m_mutex);
+  m_plans.clear();
+}
+
 } // namespace doc
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2023  Igara Studio S.A.
+// Copyright (c) 2023-2026  Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -12,6 +12,12 @@
 #include "doc/cel_list.h"
 #include "doc/frame.h"
 
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+
 namespace doc {
 class Layer;
 
@@ -46,6 +52,12 @@ public:
 
   void addLayer(const Layer* layer, const frame_t frame);
 
+  // Number that changes each time something that can modify a plan
+  // is modified: layers added/removed/moved/deleted, layer flags,
+  // cels added/removed/moved, or cel z-indexes.
+  static uint64_t structureVersion();
+  static void incrementStructureVersion();
+
 private:
   void processZIndexes() const;
 
@@ -55,6 +67,29 @@ private:
   bool m_composeGroups = false;
 };
 
+// Cache of RenderPlans to avoid creating the same plans on each
+// render. All plans are discarded when
+// RenderPlan::structureVersion() changes. It can be used from
+// several threads.
+class RenderPlanCache {
+public:
+  // Returns the plan to render the given layer in the given frame.
+  // The returned plan is shared, so its items are already sorted
+  // by z-index.
+  std::shared_ptr<const RenderPlan> plan(const Layer* layer,
+                                         const frame_t frame,
+                                         const bool composeGroups);
+
+  void clear();
+
+private:
+  using Key = std::tuple<const Layer*, frame_t, bool>;
+
+  std::mutex m_mutex;
+  uint64_t m_version = 0;
+  std::map<Key, std::shared_ptr<const RenderPlan>> m_plans;
+};
+
 } // namespace doc
 
 #endif
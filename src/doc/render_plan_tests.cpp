@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2023-2024  Igara Studio S.A.
+// Copyright (c) 2023-2026  Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -193,6 +193,51 @@ TEST(RenderPlan, DontAddChildrenOnComposeGroupFlag)
   EXPECT_PLAN(lay0, group0, group1, lay2);
 }
 
+TEST(RenderPlan, Cache)
+{
+  auto doc = std::make_shared<Document>();
+  ImageSpec spec(ColorMode::INDEXED, 2, 2);
+  Sprite* spr;
+  doc->sprites().add(spr = Sprite::MakeStdSprite(spec));
+
+  LayerImage *lay0 = static_cast<LayerImage*>(spr->root()->firstLayer()),
+             *lay1 = new LayerImage(spr);
+  spr->root()->insertLayer(lay1, lay0);
+
+  Cel *a = lay0->cel(0), *b;
+  lay1->addCel(b = new Cel(0, ImageRef(Image::create(spec))));
+
+  RenderPlanCache cache;
+  auto plan = cache.plan(spr->root(), 0, false);
+  ASSERT_EQ(2u, plan->items().size());
+  EXPECT_EQ(a, plan->items()[0].cel);
+  EXPECT_EQ(b, plan->items()[1].cel);
+
+  // Same plan if nothing changes
+  EXPECT_EQ(plan, cache.plan(spr->root(), 0, false));
+  EXPECT_NE(plan, cache.plan(spr->root(), 1, false));
+  EXPECT_NE(plan, cache.plan(spr->root(), 0, true));
+
+  a->setZIndex(1);
+  auto plan2 = cache.plan(spr->root(), 0, false);
+  EXPECT_NE(plan, plan2);
+  EXPECT_EQ(b, plan2->items()[0].cel);
+  EXPECT_EQ(a, plan2->items()[1].cel);
+
+  lay1->setVisible(false);
+  auto plan3 = cache.plan(spr->root(), 0, false);
+  ASSERT_EQ(1u, plan3->items().size());
+  EXPECT_EQ(a, plan3->items()[0].cel);
+
+  lay1->setVisible(true);
+  lay1->removeCel(b);
+  delete b;
+  auto plan4 = cache.plan(spr->root(), 0, false);
+  ASSERT_EQ(2u, plan4->items().size());
+  EXPECT_EQ(nullptr, plan4->items()[0].cel);
+  EXPECT_EQ(a, plan4->items()[1].cel);
+}
+
 int main(int argc, char** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
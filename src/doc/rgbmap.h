@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2020-2024 Igara Studio S.A.
+// Copyright (c) 2020-2026 Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -9,6 +9,7 @@
 #pragma once
 
 #include "base/debug.h"
+#include "base/ints.h"
 #include "doc/color.h"
 #include "doc/fit_criteria.h"
 #include "doc/rgbmap_algorithm.h"
@@ -31,6 +32,20 @@ public:
   // Should return the best index in a palette that matches the given RGBA values.
   virtual int mapColor(const color_t rgba) const = 0;
 
+  // Maps "n" RGBA values from "src" to palette indexes in "dst"
+  // (e.g. a whole scanline). Implementations with a precomputed
+  // table can do this faster than calling mapColor() for each pixel.
+  virtual void mapColors(const color_t* src, uint8_t* dst, const int n) const
+  {
+    for (int i = 0; i < n; ++i)
+      dst[i] = mapColor(src[i]);
+  }
+
+  // Returns true if mapColor() can be called from several threads
+  // at the same time (i.e. the map doesn't calculate its entries
+  // lazily).
+  virtual bool isThreadSafe() const { return false; }
+
   virtual int maskIndex() const = 0;
 
   virtual RgbMapAlgorithm rgbmapAlgorithm() const = 0;
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2020-2021 Igara Studio S.A.
+// Copyright (c) 2020-2026 Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -14,6 +14,7 @@ enum class RgbMapAlgorithm {
   DEFAULT = 0,
   RGB5A3 = 1,
   OCTREE = 2,
+  PRECOMPUTED = 3,
 };
 
 } // namespace doc
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2024 Igara Studio S.A.
+// Copyright (c) 2024-2026 Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -24,10 +24,9 @@ public:
   FitCriteria fitCriteria() const override { return m_fitCriteria; }
   void fitCriteria(const FitCriteria fitCriteria) override { m_fitCriteria = fitCriteria; }
 
-private:
+protected:
   void rgbToOtherSpace(double& r, double& g, double& b) const;
 
-protected:
   FitCriteria m_fitCriteria;
   const Palette* m_palette = nullptr;
   int m_modifications = 0;
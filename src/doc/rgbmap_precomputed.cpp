@@ -0,0 +1,142 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "doc/rgbmap_precomputed.h"
+
+#include "doc/color_scales.h"
+#include "doc/palette.h"
+#include "doc/task_group.h"
+#include "tracing/tracing.h"
+
+#include <limits>
+
+namespace doc {
+
+#define RSIZE   32
+#define GSIZE   32
+#define BSIZE   32
+#define ASIZE   8
+#define MAPSIZE (RSIZE * GSIZE * BSIZE * ASIZE)
+
+RgbMapPrecomputed::RgbMapPrecomputed() : m_map(MAPSIZE, 0)
+{
+}
+
+void RgbMapPrecomputed::regenerateMap(const Palette* palette,
+                                      const int maskIndex,
+                                      const FitCriteria fitCriteria)
+{
+  ASSERT(palette);
+  if (!palette)
+    return;
+
+  // Skip useless regenerations
+  if (m_palette == palette && m_modifications == palette->getModifications() &&
+      m_maskIndex == maskIndex && m_fitCriteria == fitCriteria)
+    return;
+
+  m_palette = palette;
+  m_fitCriteria = fitCriteria;
+  m_modifications = palette->getModifications();
+  m_maskIndex = maskIndex;
+
+  // Convert the palette to the color space of the fit criteria only
+  // once (RgbMapBase::findBestfit() converts each palette entry on
+  // each call).
+  std::vector<SpaceColor> palColors;
+  if (m_fitCriteria != FitCriteria::DEFAULT) {
+    palColors.resize(palette->size());
+    for (int i = 0; i < palette->size(); ++i) {
+      const color_t c = palette->getEntry(i);
+      SpaceColor& sc = palColors[i];
+      sc.x = rgba_getr(c);
+      sc.y = rgba_getg(c);
+      sc.z = rgba_getb(c);
+      sc.a = rgba_geta(c);
+      rgbToOtherSpace(sc.x, sc.y, sc.z);
+    }
+  }
+
+  // Each task fills the entries for one value of the red component.
+  TaskGroup tasks;
+  for (int r5 = 0; r5 < RSIZE; ++r5) {
+    tasks.run([this, r5, &palColors] {
+      TRACING_SCOPE("RgbMapPrecomputed task");
+      generateEntries(r5, palColors);
+    });
+  }
+  tasks.wait();
+}
+
+void RgbMapPrecomputed::mapColors(const color_t* src, uint8_t* dst, const int n) const
+{
+  const uint16_t* map = m_map.data();
+  for (int i = 0; i < n; ++i)
+    dst[i] = map[tableIndex(src[i])];
+}
+
+void RgbMapPrecomputed::generateEntries(const int r5, const std::vector<SpaceColor>& palColors)
+{
+  const int r = scale_5bits_to_8bits(r5);
+
+  for (int g5 = 0; g5 < GSIZE; ++g5) {
+    const int g = scale_5bits_to_8bits(g5);
+
+    for (int b5 = 0; b5 < BSIZE; ++b5) {
+      const int b = scale_5bits_to_8bits(b5);
+      uint16_t* entry = &m_map[(r5 << 13) | (g5 << 8) | (b5 << 3)];
+
+      if (m_fitCriteria == FitCriteria::DEFAULT) {
+        for (int a3 = 0; a3 < ASIZE; ++a3)
+          entry[a3] = m_palette->findBestfit(r, g, b, scale_3bits_to_8bits(a3), m_maskIndex);
+      }
+      else {
+        double x = r, y = g, z = b;
+        rgbToOtherSpace(x, y, z);
+
+        for (int a3 = 0; a3 < ASIZE; ++a3)
+          entry[a3] = findBestfitInSpace(x, y, z, scale_3bits_to_8bits(a3), palColors);
+      }
+    }
+  }
+}
+
+// Same as RgbMapBase::findBestfit() but with the color and the
+// palette already converted to the fit criteria color space.
+int RgbMapPrecomputed::findBestfitInSpace(const double x,
+                                          const double y,
+                                          const double z,
+                                          const int a,
+                                          const std::vector<SpaceColor>& palColors) const
+{
+  if (a == 0 && m_maskIndex >= 0)
+    return m_maskIndex;
+
+  int bestfit = 0;
+  double lowest = std::numeric_limits<double>::max();
+  const int size = int(palColors.size());
+
+  for (int i = 0; i < size; ++i) {
+    const SpaceColor& sc = palColors[i];
+    const double xDiff = x - sc.x;
+    const double yDiff = y - sc.y;
+    const double zDiff = z - sc.z;
+    const double aDiff = double(a - sc.a) / 128.0;
+
+    const double diff = xDiff * xDiff + yDiff * yDiff + zDiff * zDiff + aDiff * aDiff;
+    if (diff < lowest && i != m_maskIndex) {
+      lowest = diff;
+      bestfit = i;
+    }
+  }
+  return bestfit;
+}
+
+} // namespace doc
@@ -0,0 +1,70 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef DOC_RGBMAP_PRECOMPUTED_H_INCLUDED
+#define DOC_RGBMAP_PRECOMPUTED_H_INCLUDED
+#pragma once
+
+#include "base/disable_copying.h"
+#include "base/ints.h"
+#include "doc/rgbmap_base.h"
+
+#include <vector>
+
+namespace doc {
+
+// Same RGB 5 bits + Alpha 3 bits table as RgbMapRGB5A3, but the
+// whole table is calculated (in parallel) each time the palette
+// changes instead of one entry at a time on each mapColor() call.
+// Lookups are a plain table access without branches, so it's the
+// best option to convert whole images to indexed.
+class RgbMapPrecomputed : public RgbMapBase {
+public:
+  RgbMapPrecomputed();
+
+  // RgbMap impl
+  void regenerateMap(const Palette* palette,
+                     const int maskIndex,
+                     const FitCriteria fitCriteria) override;
+  void regenerateMap(const Palette* palette, const int maskIndex) override
+  {
+    regenerateMap(palette, maskIndex, m_fitCriteria);
+  }
+
+  int mapColor(const color_t rgba) const override { return m_map[tableIndex(rgba)]; }
+  void mapColors(const color_t* src, uint8_t* dst, const int n) const override;
+  bool isThreadSafe() const override { return true; }
+
+  RgbMapAlgorithm rgbmapAlgorithm() const override { return RgbMapAlgorithm::PRECOMPUTED; }
+
+private:
+  struct SpaceColor {
+    double x, y, z;
+    int a;
+  };
+
+  // bits -> bbbbbgggggrrrrraaa
+  static uint32_t tableIndex(const color_t rgba)
+  {
+    return ((rgba_geta(rgba) >> 5) | ((rgba_getb(rgba) >> 3) << 3) |
+            ((rgba_getg(rgba) >> 3) << 8) | ((rgba_getr(rgba) >> 3) << 13));
+  }
+
+  void generateEntries(const int r5, const std::vector<SpaceColor>& palColors);
+  int findBestfitInSpace(double x,
+                         double y,
+                         double z,
+                         int a,
+                         const std::vector<SpaceColor>& palColors) const;
+
+  std::vector<uint16_t> m_map;
+
+  DISABLE_COPYING(RgbMapPrecomputed);
+};
+
+} // namespace doc
+
+#endif
@@ -0,0 +1,102 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "doc/palette.h"
+#include "doc/rgbmap_precomputed.h"
+#include "doc/rgbmap_rgb5a3.h"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace doc;
+
+static Palette make_random_palette(int ncolors)
+{
+  Palette pal(frame_t(0), ncolors);
+  std::srand(ncolors);
+  for (int i = 0; i < ncolors; ++i)
+    pal.setEntry(i,
+                 rgba(std::rand() % 256,
+                      std::rand() % 256,
+                      std::rand() % 256,
+                      (i % 3) == 0 ? std::rand() % 256 : 255));
+  return pal;
+}
+
+static void expect_same_map(const FitCriteria fc, const int maskIndex)
+{
+  const Palette pal = make_random_palette(64);
+  RgbMapRGB5A3 lazy;
+  RgbMapPrecomputed precomputed;
+  lazy.regenerateMap(&pal, maskIndex, fc);
+  precomputed.regenerateMap(&pal, maskIndex, fc);
+
+  // One color for each table entry
+  for (int r = 0; r < 256; r += 8) {
+    for (int g = 0; g < 256; g += 8) {
+      for (int b = 0; b < 256; b += 8) {
+        for (int a = 0; a < 256; a += 32) {
+          const color_t c = rgba(r, g, b, a);
+          ASSERT_EQ(lazy.mapColor(c), precomputed.mapColor(c))
+            << "r=" << r << " g=" << g << " b=" << b << " a=" << a;
+        }
+      }
+    }
+  }
+}
+
+TEST(RgbMap, PrecomputedMatchesRGB5A3)
+{
+  expect_same_map(FitCriteria::DEFAULT, 0);
+  expect_same_map(FitCriteria::DEFAULT, -1);
+}
+
+TEST(RgbMap, PrecomputedMatchesRGB5A3WithFitCriteria)
+{
+  expect_same_map(FitCriteria::RGB, 0);
+  expect_same_map(FitCriteria::CIELAB, 0);
+}
+
+TEST(RgbMap, PrecomputedRegeneratesOnPaletteChange)
+{
+  Palette pal = make_random_palette(16);
+  RgbMapPrecomputed map;
+  map.regenerateMap(&pal, -1, FitCriteria::DEFAULT);
+
+  const color_t c = rgba(255, 0, 255, 255);
+  pal.setEntry(7, c);
+  map.regenerateMap(&pal, -1, FitCriteria::DEFAULT);
+  EXPECT_EQ(7, map.mapColor(c));
+}
+
+TEST(RgbMap, MapColors)
+{
+  const Palette pal = make_random_palette(32);
+  RgbMapPrecomputed map;
+  map.regenerateMap(&pal, 0, FitCriteria::DEFAULT);
+
+  std::vector<color_t> src;
+  for (int i = 0; i < 1000; ++i)
+    src.push_back(rgba((i * 7) & 255, (i * 13) & 255, (i * 29) & 255, (i * 3) & 255));
+
+  std::vector<uint8_t> dst(src.size());
+  map.mapColors(src.data(), dst.data(), int(src.size()));
+  for (int i = 0; i < int(src.size()); ++i)
+    EXPECT_EQ(map.mapColor(src[i]), dst[i]) << " When i=" << i;
+}
+
+int main(int argc, char** argv)
+{
+  Palette::initBestfit();
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
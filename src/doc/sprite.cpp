@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (C) 2018-2024  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -23,8 +23,10 @@
 #include "doc/primitives.h"
 #include "doc/remap.h"
 #include "doc/render_plan.h"
+#include "doc/rgbmap_precomputed.h"
 #include "doc/rgbmap_rgb5a3.h"
 #include "doc/tag.h"
+#include "doc/task_group.h"
 #include "doc/tile_primitives.h"
 #include "doc/tilesets.h"
 
@@ -38,6 +40,9 @@ namespace doc {
 
 static gfx::Rect g_defaultGridBounds(0, 0, 16, 16);
 
+// Minimum number of pixels to remap images from several threads
+static const int kParallelRemapMinPixels = 256 * 256;
+
 // static
 gfx::Rect Sprite::DefaultGridBounds()
 {
@@ -330,20 +335,16 @@ Palette* Sprite::palette(frame_t frame) const
 {
   ASSERT(frame >= 0);
 
-  Palette* found = NULL;
-
-  PalettesList::const_iterator end = m_palettes.end();
-  PalettesList::const_iterator it = m_palettes.begin();
-  for (; it != end; ++it) {
-    Palette* pal = *it;
-    if (frame < pal->frame())
-      break;
-
-    found = pal;
-    if (frame == pal->frame())
-      break;
-  }
+  // Palettes are sorted by frame, so we look for the last palette
+  // that starts in (or before) the given frame.
+  auto it = std::upper_bound(m_palettes.begin(),
+                             m_palettes.end(),
+                             frame,
+                             [](const frame_t frame, const Palette* pal) {
+                               return frame < pal->frame();
+                             });
 
+  Palette* found = (it != m_palettes.begin() ? *(it - 1) : nullptr);
   ASSERT(found != NULL);
   return found;
 }
@@ -439,9 +440,10 @@ RgbMap* Sprite::rgbMap(const frame_t frame,
   if (!m_rgbMap || m_rgbMap->rgbmapAlgorithm() != mapAlgo ||
       m_rgbMap->fitCriteria() != fitCriteria) {
     switch (mapAlgo) {
-      case RgbMapAlgorithm::RGB5A3:  m_rgbMap.reset(new RgbMapRGB5A3); break;
+      case RgbMapAlgorithm::RGB5A3:      m_rgbMap.reset(new RgbMapRGB5A3); break;
+      case RgbMapAlgorithm::PRECOMPUTED: m_rgbMap.reset(new RgbMapPrecomputed); break;
       case RgbMapAlgorithm::DEFAULT:
-      case RgbMapAlgorithm::OCTREE:  m_rgbMap.reset(new OctreeMap); break;
+      case RgbMapAlgorithm::OCTREE:      m_rgbMap.reset(new OctreeMap); break;
       default:
         m_rgbMap.reset(nullptr);
         ASSERT(false);
@@ -492,6 +494,18 @@ void Sprite::setTotalFrames(frame_t frames)
   m_frames = frames;
 }
 
+void Sprite::remapFrames(const std::vector<frame_t>& newFrames)
+{
+  ASSERT(frame_t(newFrames.size()) == m_frames);
+
+  std::vector<int> frlens(m_frlens.size());
+  for (frame_t i = 0; i < m_frames; ++i)
+    frlens[newFrames[i]] = m_frlens[i];
+  std::swap(m_frlens, frlens);
+
+  root()->remapFrames(newFrames);
+}
+
 int Sprite::frameDuration(frame_t frame) const
 {
   if (frame >= 0 && frame < m_frames)
@@ -526,6 +540,25 @@ void Sprite::setDurationForAllFrames(int msecs)
   std::fill(m_frlens.begin(), m_frlens.end(), std::clamp(msecs, 1, 65535));
 }
 
+bool Sprite::hasSameCels(const frame_t frame1, const frame_t frame2) const
+{
+  if (frame1 == frame2)
+    return true;
+
+  for (const Layer* layer : allLayers()) {
+    const Cel* cel1 = layer->cel(frame1);
+    const Cel* cel2 = layer->cel(frame2);
+    if (!cel1 && !cel2)
+      continue;
+
+    // The cel data contains the image, position, and opacity of the
+    // cel (and it's shared between linked cels)
+    if (!cel1 || !cel2 || cel1->dataRef() != cel2->dataRef() || cel1->zIndex() != cel2->zIndex())
+      return false;
+  }
+  return true;
+}
+
 //////////////////////////////////////////////////////////////////////
 // Shared Images and CelData (for linked cels and tilesets)
 
@@ -638,8 +671,45 @@ void Sprite::remapImages(const Remap& remap)
 
   std::vector<ImageRef> images;
   getImages(images);
-  for (ImageRef& image : images)
-    remap_image(image.get(), remap);
+
+  int64_t pixels = 0;
+  for (const ImageRef& image : images)
+    pixels += int64_t(image->width()) * image->height();
+
+  const int nthreads = task_threads();
+  if (nthreads < 2 || images.size() < 2 || pixels < kParallelRemapMinPixels) {
+    for (ImageRef& image : images)
+      remap_image(image.get(), remap);
+    return;
+  }
+
+  // Linked cels are included only once, but the same tile image
+  // could be used in two tilesets, and each image must be remapped
+  // only by one thread.
+  std::sort(images.begin(), images.end(), [](const ImageRef& a, const ImageRef& b) {
+    return a.get() < b.get();
+  });
+  images.erase(std::unique(images.begin(), images.end()), images.end());
+
+  // Remap ranges of images with a similar number of pixels from
+  // different threads.
+  const int64_t pixelsPerTask = std::max<int64_t>(1, pixels / (nthreads * 4));
+  TaskGroup tasks;
+  for (size_t i = 0; i < images.size();) {
+    size_t j = i;
+    int64_t taskPixels = 0;
+    while (j < images.size() && taskPixels < pixelsPerTask) {
+      taskPixels += int64_t(images[j]->width()) * images[j]->height();
+      ++j;
+    }
+
+    tasks.run([&images, &remap, i, j] {
+      for (size_t k = i; k < j; ++k)
+        remap_image(images[k].get(), remap);
+    });
+    i = j;
+  }
+  tasks.wait();
 }
 
 void Sprite::remapTilemaps(const Tileset* tileset, const Remap& remap)
@@ -668,10 +738,8 @@ void Sprite::pickCels(const gfx::PointF& pos,
     if (!cel)
       continue;
 
-    const Image* image = cel->image();
-    if (!image)
-      continue;
-
+    // Check the cel bounds before accessing the image (which could
+    // need to be decoded in case of lazy images)
     gfx::RectF celBounds;
     if (cel->layer()->isReference())
       celBounds = cel->boundsF();
@@ -681,6 +749,10 @@ void Sprite::pickCels(const gfx::PointF& pos,
     if (!celBounds.contains(pos))
       continue;
 
+    const Image* image = cel->image();
+    if (!image)
+      continue;
+
     color_t color = 0;
     if (image->isTilemap()) {
       tile_index ti;
@@ -796,4 +868,41 @@ Tilesets* Sprite::tilesets() const
   return m_tilesets;
 }
 
+//////////////////////////////////////////////////////////////////////
+// FramePalettes
+
+FramePalettes::FramePalettes(const Sprite* sprite)
+  : m_palettes(sprite->getPalettes())
+  , m_next(m_palettes.begin())
+{
+}
+
+Palette* FramePalettes::palette(const frame_t frame)
+{
+  ASSERT(frame >= 0);
+
+  if (frame < m_frame || !m_current)
+    seek(frame);
+  else {
+    // Advance to the palette of this frame
+    while (m_next != m_palettes.end() && (*m_next)->frame() <= frame)
+      m_current = *(m_next++);
+  }
+
+  m_frame = frame;
+  ASSERT(m_current);
+  return m_current;
+}
+
+void FramePalettes::seek(const frame_t frame)
+{
+  m_next = std::upper_bound(m_palettes.begin(),
+                            m_palettes.end(),
+                            frame,
+                            [](const frame_t frame, const Palette* pal) {
+                              return frame < pal->frame();
+                            });
+  m_current = (m_next != m_palettes.begin() ? *(m_next - 1) : nullptr);
+}
+
 } // namespace doc
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -179,12 +179,21 @@ public:
   void removeFrame(frame_t frame);
   void setTotalFrames(frame_t frames);
 
+  // Moves several frames at once (durations and cels), the frame
+  // "i" is moved to "newFrames[i]" (it must be a permutation).
+  void remapFrames(const std::vector<frame_t>& newFrames);
+
   int frameDuration(frame_t frame) const;
   int totalAnimationDuration() const;
   void setFrameDuration(frame_t frame, int msecs);
   void setFrameRangeDuration(frame_t from, frame_t to, int msecs);
   void setDurationForAllFrames(int msecs);
 
+  // Returns true if both frames have exactly the same cel data in
+  // all layers (e.g. a frame with linked cels held for several
+  // frames), so they are rendered as the same image.
+  bool hasSameCels(frame_t frame1, frame_t frame2) const;
+
   const Tags& tags() const { return m_tags; }
   Tags& tags() { return m_tags; }
 
@@ -283,6 +292,25 @@ private:
   DISABLE_COPYING(Sprite);
 };
 
+// Returns the palette of each frame of a sprite without searching the
+// palette list again when the frames are visited in increasing order
+// (e.g. when a file is saved frame by frame). The palettes of the
+// sprite cannot be added/removed while this object is used.
+class FramePalettes {
+public:
+  FramePalettes(const Sprite* sprite);
+
+  Palette* palette(const frame_t frame);
+
+private:
+  void seek(const frame_t frame);
+
+  const PalettesList& m_palettes;
+  PalettesList::const_iterator m_next; // Palette of the next frames
+  Palette* m_current = nullptr;        // Palette of m_frame
+  frame_t m_frame = -1;
+};
+
 } // namespace doc
 
 #endif
@@ -0,0 +1,180 @@
+// Aseprite Document Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "doc/sprite_snapshot.h"
+
+#include "base/debug.h"
+#include "doc/cel.h"
+#include "doc/image.h"
+#include "doc/layer.h"
+#include "doc/layer_tilemap.h"
+#include "doc/palette.h"
+#include "doc/primitives.h"
+#include "doc/slice.h"
+#include "doc/sprite.h"
+#include "doc/tag.h"
+#include "doc/tileset.h"
+#include "doc/tilesets.h"
+
+namespace doc {
+
+SpriteSnapshot::~SpriteSnapshot()
+{
+}
+
+// static
+SpriteSnapshotRef SpriteSnapshot::Make(const Sprite* sprite, const SpriteSnapshotRef& prev)
+{
+  std::shared_ptr<SpriteSnapshot> snapshot(new SpriteSnapshot);
+  Sprite* copy = new Sprite(sprite->spec(), sprite->palette(frame_t(0))->size());
+  snapshot->m_sprite.reset(copy);
+
+  copy->setUserData(sprite->userData());
+  copy->setPixelRatio(sprite->pixelRatio());
+  copy->setGridBounds(sprite->gridBounds());
+  copy->setTotalFrames(sprite->totalFrames());
+  for (frame_t i(0); i < sprite->totalFrames(); ++i)
+    copy->setFrameDuration(i, sprite->frameDuration(i));
+
+  for (const Tag* tag : sprite->tags())
+    copy->tags().add(new Tag(*tag));
+
+  for (const Slice* slice : sprite->slices())
+    copy->slices().add(new Slice(*slice));
+
+  for (const Palette* pal : sprite->getPalettes())
+    copy->setPalette(pal, true);
+
+  // Tilesets must be copied before layers so tilemap cels can
+  // calculate their bounds.
+  if (sprite->hasTilesets()) {
+    for (const Tileset* tileset : *sprite->tilesets()) {
+      Tileset* tilesetCopy = Tileset::MakeCopyWithoutImagesForSprite(tileset, copy);
+      tilesetCopy->setBaseIndex(tileset->baseIndex());
+      tilesetCopy->setMatchFlags(tileset->matchFlags());
+      for (tile_index ti = 0; ti < tileset->size(); ++ti) {
+        tilesetCopy->set(ti, snapshot->copyImage(tileset->get(ti), prev.get()));
+        tilesetCopy->setTileData(ti, tileset->getTileData(ti));
+      }
+      copy->tilesets()->add(tilesetCopy);
+    }
+  }
+
+  snapshot->copyLayer(sprite->root(), copy->root(), prev.get());
+  return snapshot;
+}
+
+ImageRef SpriteSnapshot::copyImage(const ImageRef& image, const SpriteSnapshot* prev)
+{
+  if (!image)
+    return nullptr;
+
+  const ObjectId id = image->id();
+  auto it = m_images.find(id);
+  if (it != m_images.end())
+    return it->second.image;
+
+  ImageCopy imageCopy;
+  imageCopy.version = image->version();
+  if (prev) {
+    auto prevIt = prev->m_images.find(id);
+    if (prevIt != prev->m_images.end() && prevIt->second.version == imageCopy.version) {
+      // Code that modifies pixels in place must increment the version
+      // of the image (as all app::Cmd do), in other case we would
+      // reuse a copy with the old pixels.
+      ASSERT(is_same_image(prevIt->second.image.get(), image.get()));
+      imageCopy.image = prevIt->second.image;
+    }
+  }
+  if (!imageCopy.image)
+    imageCopy.image.reset(Image::createCopy(image.get()));
+
+  m_images[id] = imageCopy;
+  return imageCopy.image;
+}
+
+void SpriteSnapshot::copyLayer(const Layer* src, Layer* dst, const SpriteSnapshot* prev)
+{
+  dst->setName(src->name());
+  dst->setFlags(src->flags());
+  dst->setUserData(src->userData());
+  dst->setBlendMode(src->blendMode());
+  dst->setOpacity(src->opacity());
+
+  if (src->isImage()) {
+    auto srcLayer = static_cast<const LayerImage*>(src);
+    auto dstLayer = static_cast<LayerImage*>(dst);
+
+    // Linked cels are still linked in the snapshot
+    std::map<const CelData*, Cel*> linked;
+
+    for (auto it = srcLayer->getCelBegin(), end = srcLayer->getCelEnd(); it != end; ++it) {
+      const Cel* srcCel = *it;
+      std::unique_ptr<Cel> cel;
+
+      auto linkIt = linked.find(srcCel->data());
+      if (linkIt != linked.end()) {
+        cel.reset(Cel::MakeLink(srcCel->frame(), linkIt->second));
+        cel->copyNonsharedPropertiesFrom(srcCel);
+      }
+      else {
+        const CelData* srcData = srcCel->data();
+        auto data = std::make_shared<CelData>(*srcData);
+        data->setUserData(srcData->userData());
+
+        // Lazy images are not decoded, the clone is decoded from any
+        // thread when it's needed (as in Cel::MakeCopy()).
+        LazyImageRef lazyImage;
+        if (srcData->lazyImage())
+          lazyImage = srcData->lazyImage()->clone();
+        if (lazyImage)
+          data->setLazyImage(lazyImage, dstLayer);
+        else
+          data->setImage(copyImage(srcData->imageRef(), prev), dstLayer);
+
+        // Keep the exact bounds (e.g. reference layers)
+        if (srcData->hasBoundsF())
+          data->setBoundsF(srcData->boundsF());
+        else
+          data->setBounds(srcData->bounds());
+
+        cel = std::make_unique<Cel>(srcCel->frame(), data);
+        cel->copyNonsharedPropertiesFrom(srcCel);
+        linked[srcData] = cel.get();
+      }
+
+      dstLayer->addCel(cel.get());
+      cel.release();
+    }
+  }
+  else if (src->isGroup()) {
+    auto dstGroup = static_cast<LayerGroup*>(dst);
+
+    for (const Layer* srcChild : static_cast<const LayerGroup*>(src)->layers()) {
+      std::unique_ptr<Layer> child;
+      if (srcChild->isTilemap()) {
+        child = std::make_unique<LayerTilemap>(
+          dstGroup->sprite(),
+          static_cast<const LayerTilemap*>(srcChild)->tilesetIndex());
+      }
+      else if (srcChild->isImage())
+        child = std::make_unique<LayerImage>(dstGroup->sprite());
+      else if (srcChild->isGroup())
+        child = std::make_unique<LayerGroup>(dstGroup->sprite());
+      else
+        continue;
+
+      copyLayer(srcChild, child.get(), prev);
+      dstGroup->addLayer(child.release());
+    }
+  }
+}
+
+} // namespace doc
@@ -0,0 +1,73 @@
+// Aseprite Document Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef DOC_SPRITE_SNAPSHOT_H_INCLUDED
+#define DOC_SPRITE_SNAPSHOT_H_INCLUDED
+#pragma once
+
+#include "base/disable_copying.h"
+#include "doc/image_ref.h"
+#include "doc/object_id.h"
+#include "doc/object_version.h"
+
+#include <map>
+#include <memory>
+
+namespace doc {
+
+class Layer;
+class Sprite;
+class SpriteSnapshot;
+
+using SpriteSnapshotRef = std::shared_ptr<const SpriteSnapshot>;
+
+// Read-only copy of a sprite that can be used from background
+// threads (e.g. to render/encode frames) without locking the
+// original document, so workers never block the UI thread and the
+// UI thread never waits for them.
+//
+// The sprite structure (layers, cels, tags, palettes, etc.) is copied
+// each time, but images are copied only when their version changed
+// since the previous snapshot, the unchanged ones are shared between
+// snapshots (and are never modified). So any code that modifies the
+// pixels of an image in place must call Image::incrementVersion().
+//
+// Objects of the snapshot have their own IDs, so it cannot be used
+// where the original IDs are needed (e.g. to write backups).
+class SpriteSnapshot {
+public:
+  ~SpriteSnapshot();
+
+  // Creates a snapshot of the given sprite reusing the images of
+  // "prev" that weren't modified. Must be called from the thread
+  // that modifies the sprite (or with the document read-locked).
+  static SpriteSnapshotRef Make(const Sprite* sprite, const SpriteSnapshotRef& prev = nullptr);
+
+  const Sprite* sprite() const { return m_sprite.get(); }
+
+private:
+  struct ImageCopy {
+    ObjectVersion version;
+    ImageRef image;
+  };
+
+  SpriteSnapshot() = default;
+
+  ImageRef copyImage(const ImageRef& image, const SpriteSnapshot* prev);
+  void copyLayer(const Layer* src, Layer* dst, const SpriteSnapshot* prev);
+
+  std::unique_ptr<Sprite> m_sprite;
+
+  // Copies of the images of the original sprite (key is the ID of
+  // the original image)
+  std::map<ObjectId, ImageCopy> m_images;
+
+  DISABLE_COPYING(SpriteSnapshot);
+};
+
+} // namespace doc
+
+#endif
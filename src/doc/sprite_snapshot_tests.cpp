@@ -0,0 +1,117 @@
+// Aseprite Document Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "doc/sprite_snapshot.h"
+
+#include "doc/cel.h"
+#include "doc/image.h"
+#include "doc/layer.h"
+#include "doc/primitives.h"
+#include "doc/sprite.h"
+
+#include <memory>
+
+using namespace doc;
+
+namespace {
+
+// Sprite with one layer and two frames, the second frame is linked
+// to the first one.
+struct TestSprite {
+  std::unique_ptr<Sprite> sprite;
+  LayerImage* layer;
+
+  TestSprite() : sprite(std::make_unique<Sprite>(ImageSpec(ColorMode::RGB, 4, 4), 256))
+  {
+    sprite->setTotalFrames(3);
+    layer = new LayerImage(sprite.get());
+    layer->setName("Layer");
+    sprite->root()->addLayer(layer);
+
+    ImageRef image(Image::create(IMAGE_RGB, 2, 2));
+    clear_image(image.get(), rgba(255, 0, 0, 255));
+    Cel* cel = new Cel(0, image);
+    cel->setPosition(1, 1);
+    layer->addCel(cel);
+    layer->addCel(Cel::MakeLink(1, cel));
+
+    ImageRef image2(Image::create(IMAGE_RGB, 4, 4));
+    clear_image(image2.get(), rgba(0, 0, 255, 255));
+    layer->addCel(new Cel(2, image2));
+  }
+};
+
+const Image* cel_image(const SpriteSnapshotRef& snapshot, const frame_t frame)
+{
+  return snapshot->sprite()->firstLayer()->cel(frame)->image();
+}
+
+} // anonymous namespace
+
+TEST(SpriteSnapshot, CopySprite)
+{
+  TestSprite test;
+  SpriteSnapshotRef snapshot = SpriteSnapshot::Make(test.sprite.get());
+
+  const Sprite* spr = snapshot->sprite();
+  EXPECT_EQ(3, spr->totalFrames());
+  ASSERT_EQ(1, spr->root()->layersCount());
+  EXPECT_EQ("Layer", spr->firstLayer()->name());
+
+  const Cel* cel = spr->firstLayer()->cel(0);
+  ASSERT_TRUE(cel);
+  EXPECT_EQ(gfx::Rect(1, 1, 2, 2), cel->bounds());
+  EXPECT_NE(test.layer->cel(0)->image(), cel->image());
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(cel->image(), 0, 0));
+
+  // Linked cels
+  EXPECT_EQ(cel->data(), spr->firstLayer()->cel(1)->data());
+  EXPECT_NE(cel->data(), spr->firstLayer()->cel(2)->data());
+}
+
+TEST(SpriteSnapshot, OriginalIsModified)
+{
+  TestSprite test;
+  SpriteSnapshotRef snapshot = SpriteSnapshot::Make(test.sprite.get());
+
+  Image* image = test.layer->cel(0)->image();
+  put_pixel(image, 0, 0, rgba(0, 255, 0, 255));
+  image->incrementVersion();
+  test.layer->cel(2)->setPosition(1, 0);
+
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(cel_image(snapshot, 0), 0, 0));
+  EXPECT_EQ(gfx::Point(0, 0), snapshot->sprite()->firstLayer()->cel(2)->position());
+
+  SpriteSnapshotRef snapshot2 = SpriteSnapshot::Make(test.sprite.get(), snapshot);
+  EXPECT_EQ(rgba(0, 255, 0, 255), get_pixel(cel_image(snapshot2, 0), 0, 0));
+  EXPECT_EQ(gfx::Point(1, 0), snapshot2->sprite()->firstLayer()->cel(2)->position());
+}
+
+TEST(SpriteSnapshot, ShareUnmodifiedImages)
+{
+  TestSprite test;
+  SpriteSnapshotRef snapshot = SpriteSnapshot::Make(test.sprite.get());
+
+  Image* image = test.layer->cel(2)->image();
+  put_pixel(image, 0, 0, rgba(0, 255, 0, 255));
+  image->incrementVersion();
+
+  SpriteSnapshotRef snapshot2 = SpriteSnapshot::Make(test.sprite.get(), snapshot);
+  EXPECT_EQ(cel_image(snapshot, 0), cel_image(snapshot2, 0));
+  EXPECT_NE(cel_image(snapshot, 2), cel_image(snapshot2, 2));
+
+  // The previous snapshot can be destroyed (e.g. in other thread)
+  // and the shared images are still valid.
+  snapshot.reset();
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(cel_image(snapshot2, 0), 1, 1));
+  EXPECT_EQ(rgba(0, 255, 0, 255), get_pixel(cel_image(snapshot2, 2), 0, 0));
+}
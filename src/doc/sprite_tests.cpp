@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2018-2022 Igara Studio S.A.
+// Copyright (c) 2018-2026 Igara Studio S.A.
 // Copyright (c) 2001-2016 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -13,8 +13,11 @@
 
 #include "doc/cel.h"
 #include "doc/cels_range.h"
+#include "doc/image.h"
 #include "doc/layer.h"
+#include "doc/palette.h"
 #include "doc/pixel_format.h"
+#include "doc/remap.h"
 #include "doc/sprite.h"
 
 #include <memory>
@@ -207,6 +210,178 @@ TEST(Sprite, CelsRange)
   EXPECT_EQ(3, i);
 }
 
+TEST(Sprite, RemapFrames)
+{
+  std::shared_ptr<Sprite> sprPtr(std::make_shared<Sprite>(ImageSpec(ColorMode::RGB, 32, 32), 256));
+  Sprite* spr = sprPtr.get();
+  spr->setTotalFrames(4);
+  for (frame_t i = 0; i < 4; ++i)
+    spr->setFrameDuration(i, 100 * (i + 1));
+
+  LayerImage* lay1 = new LayerImage(spr);
+  LayerGroup* grp1 = new LayerGroup(spr);
+  LayerImage* lay2 = new LayerImage(spr);
+  spr->root()->addLayer(lay1);
+  spr->root()->addLayer(grp1);
+  grp1->addLayer(lay2);
+
+  Cel* celA = new Cel(frame_t(0), ImageRef(Image::create(IMAGE_RGB, 32, 32)));
+  Cel* celB = new Cel(frame_t(3), ImageRef(Image::create(IMAGE_RGB, 32, 32)));
+  Cel* celC = new Cel(frame_t(1), ImageRef(Image::create(IMAGE_RGB, 32, 32)));
+  lay1->addCel(celA);
+  lay1->addCel(celB);
+  lay2->addCel(celC);
+
+  // Move frame 0 -> 2, 1 -> 3, 2 -> 0, 3 -> 1
+  spr->remapFrames({ 2, 3, 0, 1 });
+
+  EXPECT_EQ(300, spr->frameDuration(0));
+  EXPECT_EQ(400, spr->frameDuration(1));
+  EXPECT_EQ(100, spr->frameDuration(2));
+  EXPECT_EQ(200, spr->frameDuration(3));
+
+  EXPECT_EQ(celB, lay1->cel(1));
+  EXPECT_EQ(celA, lay1->cel(2));
+  EXPECT_EQ(celC, lay2->cel(3));
+  EXPECT_EQ(nullptr, lay1->cel(0));
+  EXPECT_EQ(celB, *lay1->getCelBegin()); // Cels are sorted by frame
+}
+
+TEST(Sprite, AddAndRemoveFramesDisplaceCels)
+{
+  std::shared_ptr<Sprite> sprPtr(std::make_shared<Sprite>(ImageSpec(ColorMode::RGB, 32, 32), 256));
+  Sprite* spr = sprPtr.get();
+  spr->setTotalFrames(4);
+
+  LayerImage* lay1 = new LayerImage(spr);
+  spr->root()->addLayer(lay1);
+
+  Cel* celA = new Cel(frame_t(0), ImageRef(Image::create(IMAGE_RGB, 32, 32)));
+  Cel* celB = new Cel(frame_t(2), ImageRef(Image::create(IMAGE_RGB, 32, 32)));
+  Cel* celC = new Cel(frame_t(3), ImageRef(Image::create(IMAGE_RGB, 32, 32)));
+  lay1->addCel(celA);
+  lay1->addCel(celB);
+  lay1->addCel(celC);
+
+  spr->addFrame(1);
+  EXPECT_EQ(5, spr->totalFrames());
+  EXPECT_EQ(celA, lay1->cel(0));
+  EXPECT_EQ(nullptr, lay1->cel(1));
+  EXPECT_EQ(nullptr, lay1->cel(2));
+  EXPECT_EQ(celB, lay1->cel(3));
+  EXPECT_EQ(celC, lay1->cel(4));
+  EXPECT_EQ(3, celB->frame());
+  EXPECT_EQ(4, celC->frame());
+
+  spr->removeFrame(1);
+  EXPECT_EQ(4, spr->totalFrames());
+  EXPECT_EQ(celA, lay1->cel(0));
+  EXPECT_EQ(celB, lay1->cel(2));
+  EXPECT_EQ(celC, lay1->cel(3));
+
+  lay1->removeCel(celB);
+  delete celB;
+  EXPECT_EQ(nullptr, lay1->cel(2));
+  EXPECT_EQ(celC, lay1->cel(3));
+  EXPECT_EQ(2, lay1->getCelsCount());
+}
+
+TEST(Sprite, HasSameCels)
+{
+  std::shared_ptr<Sprite> sprPtr(std::make_shared<Sprite>(ImageSpec(ColorMode::RGB, 32, 32), 256));
+  Sprite* spr = sprPtr.get();
+  spr->setTotalFrames(5);
+
+  LayerImage* lay1 = new LayerImage(spr);
+  LayerImage* lay2 = new LayerImage(spr);
+  spr->root()->addLayer(lay1);
+  spr->root()->addLayer(lay2);
+
+  // lay1: A linked in frames 0-2, B in frame 3 (copy of A), nothing in frame 4
+  Cel* celA = new Cel(frame_t(0), ImageRef(Image::create(IMAGE_RGB, 32, 32)));
+  lay1->addCel(celA);
+  lay1->addCel(Cel::MakeLink(1, celA));
+  lay1->addCel(Cel::MakeLink(2, celA));
+  lay1->addCel(Cel::MakeCopy(3, celA));
+
+  // lay2: C linked in frames 0-1, nothing in frames 2-4
+  Cel* celC = new Cel(frame_t(0), ImageRef(Image::create(IMAGE_RGB, 32, 32)));
+  lay2->addCel(celC);
+  lay2->addCel(Cel::MakeLink(1, celC));
+
+  EXPECT_TRUE(spr->hasSameCels(0, 0));
+  EXPECT_TRUE(spr->hasSameCels(0, 1));
+  EXPECT_FALSE(spr->hasSameCels(1, 2)); // Different cels in lay2
+  EXPECT_FALSE(spr->hasSameCels(2, 3)); // Copy of the cel (not linked)
+  EXPECT_FALSE(spr->hasSameCels(3, 4));
+
+  // Different z-index
+  lay1->cel(1)->setZIndex(1);
+  EXPECT_FALSE(spr->hasSameCels(0, 1));
+}
+
+TEST(Sprite, FramePalettes)
+{
+  std::shared_ptr<Sprite> sprPtr(std::make_shared<Sprite>(ImageSpec(ColorMode::RGB, 32, 32), 256));
+  Sprite* spr = sprPtr.get();
+  spr->setTotalFrames(10);
+
+  Palette pal(frame_t(3), 256);
+  spr->setPalette(&pal, true);
+  pal.setFrame(7);
+  spr->setPalette(&pal, true);
+  ASSERT_EQ(3u, spr->getPalettes().size());
+
+  const PalettesList& pals = spr->getPalettes();
+  FramePalettes framePalettes(spr);
+  for (frame_t frame = 0; frame < 10; ++frame) {
+    Palette* expected = (frame < 3 ? pals[0] : frame < 7 ? pals[1] : pals[2]);
+    EXPECT_EQ(expected, spr->palette(frame));
+    EXPECT_EQ(expected, framePalettes.palette(frame));
+  }
+
+  // Going back
+  EXPECT_EQ(pals[1], framePalettes.palette(4));
+  EXPECT_EQ(pals[0], framePalettes.palette(0));
+  EXPECT_EQ(pals[2], framePalettes.palette(9));
+}
+
+TEST(Sprite, RemapImages)
+{
+  std::unique_ptr<Sprite> spr(Sprite::MakeStdSprite(ImageSpec(ColorMode::INDEXED, 256, 256)));
+  LayerImage* lay = static_cast<LayerImage*>(spr->root()->firstLayer());
+  spr->setTotalFrames(8);
+  for (frame_t fr = 1; fr < 8; ++fr) {
+    // Frame 7 is linked with frame 6
+    if (fr == 7)
+      lay->addCel(Cel::MakeLink(fr, lay->cel(6)));
+    else
+      lay->addCel(new Cel(fr, ImageRef(Image::create(IMAGE_INDEXED, 256, 256))));
+  }
+  for (frame_t fr = 0; fr < 7; ++fr) {
+    Image* img = lay->cel(fr)->image();
+    for (int y = 0; y < img->height(); ++y)
+      for (int x = 0; x < img->width(); ++x)
+        img->putPixel(x, y, (x + y + fr) % 4);
+  }
+
+  Remap remap(4);
+  remap.map(0, 0);
+  remap.map(1, 2);
+  remap.map(2, 1);
+  remap.unused(3);
+  spr->remapImages(remap);
+
+  const color_t expected[] = { 0, 2, 1, 3 };
+  for (frame_t fr = 0; fr < 8; ++fr) {
+    const Image* img = lay->cel(fr)->image();
+    const frame_t srcFrame = (fr == 7 ? 6 : fr);
+    for (int y = 0; y < img->height(); ++y)
+      for (int x = 0; x < img->width(); ++x)
+        ASSERT_EQ(expected[(x + y + srcFrame) % 4], img->getPixel(x, y));
+  }
+}
+
 int main(int argc, char** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
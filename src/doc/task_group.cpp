@@ -0,0 +1,142 @@
+// Aseprite Document Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "doc/task_group.h"
+
+#include "base/debug.h"
+#include "base/task.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace doc {
+
+static std::atomic<TaskExecutor*> g_executor(nullptr);
+
+struct TaskGroup::State {
+  TaskPriority priority;
+  const base::task_token* token;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<std::function<void()>> tasks; // Tasks not started yet
+  int pending = 0;                         // Tasks not finished yet
+  std::exception_ptr exception;
+
+  State(const TaskPriority priority, const base::task_token* token)
+    : priority(priority)
+    , token(token)
+  {
+  }
+
+  // Returns false if there are no tasks to start
+  bool runOne()
+  {
+    std::function<void()> func;
+    {
+      const std::lock_guard lock(mutex);
+      if (tasks.empty())
+        return false;
+      func = std::move(tasks.front());
+      tasks.pop_front();
+    }
+
+    if (!token || !token->canceled()) {
+      try {
+        func();
+      }
+      catch (...) {
+        const std::lock_guard lock(mutex);
+        if (!exception)
+          exception = std::current_exception();
+      }
+    }
+
+    const std::lock_guard lock(mutex);
+    ASSERT(pending > 0);
+    if (--pending == 0)
+      cv.notify_all();
+    return true;
+  }
+};
+
+void set_task_executor(TaskExecutor* executor)
+{
+  g_executor = executor;
+}
+
+int task_threads()
+{
+  if (TaskExecutor* executor = g_executor)
+    return executor->threads();
+  return std::max(1, int(std::thread::hardware_concurrency()));
+}
+
+TaskGroup::TaskGroup(const TaskPriority priority, const base::task_token* token)
+  : m_state(std::make_shared<State>(priority, token))
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+  try {
+    wait();
+  }
+  catch (...) {
+    // Ignore exceptions that weren't waited
+  }
+}
+
+void TaskGroup::run(std::function<void()>&& func)
+{
+  {
+    const std::lock_guard lock(m_state->mutex);
+    m_state->tasks.push_back(std::move(func));
+    ++m_state->pending;
+  }
+  // Wake up the thread waiting this group (if the task is added from
+  // other task of the group)
+  m_state->cv.notify_all();
+
+  // One entry for each task (it can be stale if the task was already
+  // executed by the thread waiting the group)
+  if (TaskExecutor* executor = g_executor)
+    executor->schedule(m_state->priority, [state = m_state] { state->runOne(); });
+}
+
+void TaskGroup::wait()
+{
+  State* state = m_state.get();
+  for (;;) {
+    // Execute the tasks that weren't started by the workers yet
+    if (state->runOne())
+      continue;
+
+    std::unique_lock lock(state->mutex);
+    state->cv.wait(lock, [state] { return state->pending == 0 || !state->tasks.empty(); });
+    if (state->pending == 0)
+      break;
+  }
+
+  std::exception_ptr exception;
+  {
+    const std::lock_guard lock(state->mutex);
+    std::swap(exception, state->exception);
+  }
+  if (exception)
+    std::rethrow_exception(exception);
+}
+
+} // namespace doc
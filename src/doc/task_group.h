@@ -0,0 +1,83 @@
+// Aseprite Document Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef DOC_TASK_GROUP_H_INCLUDED
+#define DOC_TASK_GROUP_H_INCLUDED
+#pragma once
+
+#include "base/disable_copying.h"
+
+#include <functional>
+#include <memory>
+
+namespace base {
+class task_token;
+}
+
+namespace doc {
+
+enum class TaskPriority {
+  Critical,    // Blocks the UI (e.g. rendering the editor)
+  Interactive, // The user is waiting the result (e.g. filter preview)
+  Background,  // Nobody is waiting (e.g. thumbnails, fonts list)
+};
+
+// Threads that execute the tasks of the TaskGroups. The program
+// installs its own scheduler with set_task_executor(), this library
+// doesn't create threads.
+class TaskExecutor {
+public:
+  virtual ~TaskExecutor() {}
+
+  // Number of threads that can execute tasks at the same time
+  // (including the thread that waits a group).
+  virtual int threads() const = 0;
+
+  // Calls the given function from a worker thread. The function
+  // executes one pending task of a group (if the thread that waits
+  // the group didn't execute it yet).
+  virtual void schedule(TaskPriority priority, std::function<void()>&& runOne) = 0;
+};
+
+void set_task_executor(TaskExecutor* executor);
+
+// Number of threads that can execute tasks at the same time, used to
+// split the work in tasks. Without an executor it's the number of
+// cores, and the tasks are executed by the thread that waits them.
+int task_threads();
+
+// Set of tasks that can be waited. E.g.
+//
+//   TaskGroup tasks;
+//   for (int y = 0; y < h; y += rows)
+//     tasks.run([y] { ... });
+//   tasks.wait();
+//
+// Idle workers of the executor take tasks in order of priority, and
+// the thread that waits a group executes the pending tasks of that
+// group itself, so a task can wait other tasks (nested groups)
+// without blocking the workers.
+//
+// If a task throws an exception, wait() throws the first one.
+class TaskGroup {
+public:
+  explicit TaskGroup(TaskPriority priority = TaskPriority::Interactive,
+                     const base::task_token* token = nullptr);
+  ~TaskGroup();
+
+  void run(std::function<void()>&& func);
+  void wait();
+
+private:
+  struct State;
+  std::shared_ptr<State> m_state;
+
+  DISABLE_COPYING(TaskGroup);
+};
+
+} // namespace doc
+
+#endif
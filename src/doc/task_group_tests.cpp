@@ -0,0 +1,76 @@
+// Aseprite Document Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "doc/task_group.h"
+
+#include "base/task.h"
+
+#include <atomic>
+#include <stdexcept>
+
+using namespace doc;
+
+TEST(TaskGroup, RunAllTasks)
+{
+  std::atomic<int> sum(0);
+  TaskGroup tasks;
+  for (int i = 1; i <= 100; ++i)
+    tasks.run([&sum, i] { sum += i; });
+  tasks.wait();
+  EXPECT_EQ(5050, sum);
+}
+
+TEST(TaskGroup, NestedGroups)
+{
+  // Without an executor all tasks are executed by the waiting thread
+  const int n = task_threads() * 4;
+  std::atomic<int> count(0);
+  TaskGroup outer(TaskPriority::Background);
+  for (int i = 0; i < n; ++i) {
+    outer.run([&count] {
+      TaskGroup inner;
+      for (int j = 0; j < 10; ++j)
+        inner.run([&count] { ++count; });
+      inner.wait();
+    });
+  }
+  outer.wait();
+  EXPECT_EQ(n * 10, count);
+}
+
+TEST(TaskGroup, CanceledTasks)
+{
+  base::task_token token;
+  token.cancel();
+
+  std::atomic<int> count(0);
+  TaskGroup tasks(TaskPriority::Interactive, &token);
+  for (int i = 0; i < 10; ++i)
+    tasks.run([&count] { ++count; });
+  tasks.wait();
+  EXPECT_EQ(0, count);
+}
+
+TEST(TaskGroup, Exceptions)
+{
+  std::atomic<int> count(0);
+  TaskGroup tasks;
+  for (int i = 0; i < 10; ++i) {
+    tasks.run([&count, i] {
+      ++count;
+      if (i == 5)
+        throw std::runtime_error("error");
+    });
+  }
+  EXPECT_THROW(tasks.wait(), std::runtime_error);
+  EXPECT_EQ(10, count);
+}
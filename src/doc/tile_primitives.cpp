@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2023 Igara Studio S.A.
+// Copyright (c) 2023-2026 Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -14,12 +14,87 @@
 #include "doc/color.h"
 #include "doc/grid.h"
 #include "doc/image.h"
+#include "doc/image_traits.h"
 #include "doc/layer_tilemap.h"
+#include "doc/primitives_fast.h"
+
+#include <algorithm>
 
 #define TILE_TRACE(...) // TRACE(__VA_ARGS__)
 
 namespace doc {
 
+namespace {
+
+// Coordinates of the pixel of "image" that is placed in (x, y) after
+// flipping "image" with "tf" (see is_same_flipped_tile()).
+inline gfx::Point flipped_tile_source(const Image* image,
+                                      const tile_flags tf,
+                                      const int x,
+                                      const int y)
+{
+  gfx::Point pt(x, y);
+  if (tf & tile_f_dflip) {
+    const int d = std::min(image->width(), image->height());
+    if (x < d && y < d)
+      std::swap(pt.x, pt.y);
+  }
+  if (tf & tile_f_yflip)
+    pt.y = image->height() - pt.y - 1;
+  if (tf & tile_f_xflip)
+    pt.x = image->width() - pt.x - 1;
+  return pt;
+}
+
+template<typename ImageTraits>
+uint32_t calculate_tile_flips_hash_templ(const Image* image)
+{
+  const int w = image->width();
+  const int h = image->height();
+  const tile_flags maxFlags = (w == h ? tile_f_mask : tile_f_xflip | tile_f_yflip);
+
+  // The minimum hash of all the flipped versions of the image.
+  uint64_t minHash = ~uint64_t(0);
+  for (tile_flags tf = 0;; tf += tile_f_dflip) {
+    if ((tf & maxFlags) == tf) {
+      uint64_t hash = 0xcbf29ce484222325; // FNV-1a
+      for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+          const gfx::Point pt = flipped_tile_source(image, tf, x, y);
+          color_t c = get_pixel_fast<ImageTraits>(image, pt.x, pt.y);
+          // Transparent pixels are equal to 0 (as in same_color())
+          if (ImageTraits::same_color(c, 0))
+            c = 0;
+          hash = (hash ^ c) * 0x100000001b3;
+        }
+      }
+      minHash = std::min(minHash, hash);
+    }
+    if (tf == tile_f_mask)
+      break;
+  }
+  return uint32_t(minHash ^ (minHash >> 32));
+}
+
+template<typename ImageTraits>
+bool is_same_flipped_tile_templ(const Image* image, const tile_flags tf, const Image* tileImage)
+{
+  if (image->size() != tileImage->size())
+    return false;
+
+  for (int y = 0; y < tileImage->height(); ++y) {
+    for (int x = 0; x < tileImage->width(); ++x) {
+      const gfx::Point pt = flipped_tile_source(image, tf, x, y);
+      if (!ImageTraits::same_color(get_pixel_fast<ImageTraits>(image, pt.x, pt.y),
+                                   get_pixel_fast<ImageTraits>(tileImage, x, y)))
+        return false;
+    }
+  }
+  return true;
+}
+
+} // anonymous namespace
+
 bool get_tile_pixel(
   // Input
   const Image* tilemapImage,
@@ -84,4 +159,29 @@ bool get_tile_pixel(
   return get_tile_pixel(cel->image(), tileset, cel->grid(), canvasPos, ti, tf, tileImageColor);
 }
 
+uint32_t calculate_tile_flips_hash(const Image* image)
+{
+  switch (image->pixelFormat()) {
+    case IMAGE_RGB:       return calculate_tile_flips_hash_templ<RgbTraits>(image);
+    case IMAGE_GRAYSCALE: return calculate_tile_flips_hash_templ<GrayscaleTraits>(image);
+    case IMAGE_INDEXED:   return calculate_tile_flips_hash_templ<IndexedTraits>(image);
+    case IMAGE_BITMAP:    return calculate_tile_flips_hash_templ<BitmapTraits>(image);
+  }
+  ASSERT(false);
+  return 0;
+}
+
+bool is_same_flipped_tile(const Image* image, const tile_flags tf, const Image* tileImage)
+{
+  ASSERT(image->pixelFormat() == tileImage->pixelFormat());
+  switch (image->pixelFormat()) {
+    case IMAGE_RGB:       return is_same_flipped_tile_templ<RgbTraits>(image, tf, tileImage);
+    case IMAGE_GRAYSCALE: return is_same_flipped_tile_templ<GrayscaleTraits>(image, tf, tileImage);
+    case IMAGE_INDEXED:   return is_same_flipped_tile_templ<IndexedTraits>(image, tf, tileImage);
+    case IMAGE_BITMAP:    return is_same_flipped_tile_templ<BitmapTraits>(image, tf, tileImage);
+  }
+  ASSERT(false);
+  return false;
+}
+
 } // namespace doc
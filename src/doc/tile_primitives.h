@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2023 Igara Studio S.A.
+// Copyright (c) 2023-2026 Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -53,6 +53,19 @@ bool get_tile_pixel(
   tile_index& tf,
   color_t& tileImageColor);
 
+// Returns a hash of the pixels of the given tile image that is the
+// same for all its flipped versions (all the combinations of
+// tile_f_xflip and tile_f_yflip, and tile_f_dflip too if the image
+// is square). Tiles indexed by this hash can be matched with a
+// flipped image in just one lookup.
+uint32_t calculate_tile_flips_hash(const Image* image);
+
+// Returns true if "image" flipped with the given "tf" flags is equal
+// to "tileImage". The flips are applied to "image" in the X, Y, and
+// D order (for non-square images the D flip swaps only the pixels of
+// the top-left square, as doc::algorithm::flip_image() does).
+bool is_same_flipped_tile(const Image* image, const tile_flags tf, const Image* tileImage);
+
 } // namespace doc
 
 #endif
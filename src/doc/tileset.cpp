@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2019-2025  Igara Studio S.A.
+// Copyright (c) 2019-2026  Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -16,8 +16,10 @@
 #include "doc/primitives.h"
 #include "doc/remap.h"
 #include "doc/sprite.h"
+#include "doc/tile_primitives.h"
 #include "doc/tilesets.h"
 
+#include <algorithm>
 #include <memory>
 
 #define TS_TRACE(...) // TRACE(__VA_ARGS__)
@@ -146,6 +148,12 @@ void Tileset::resize(const tile_index ntiles)
 {
   int oldSize = m_tiles.size();
   m_tiles.resize(ntiles);
+
+  // Hash tables will be re-created if they're needed
+  m_hash.clear();
+  m_tileHashes.clear();
+  m_flipsTable.clear();
+  m_flipsHash.clear();
   for (tile_index ti = oldSize; ti < ntiles; ++ti)
     m_tiles[ti].image = makeEmptyTile();
 }
@@ -191,12 +199,15 @@ void Tileset::set(const tile_index ti, const ImageRef& image)
 #endif
 
   removeFromHash(ti, false);
+  removeTileFlipsHash(ti);
 
   preprocess_transparent_pixels(image.get());
   m_tiles[ti].image = image;
 
   if (!m_hash.empty())
     hashImage(ti, image);
+  if (!m_flipsHash.empty())
+    hashTileFlips(ti);
 }
 
 tile_index Tileset::add(const ImageRef& image, const UserData& userData)
@@ -211,6 +222,10 @@ tile_index Tileset::add(const ImageRef& image, const UserData& userData)
   const tile_index newIndex = tile_index(m_tiles.size() - 1);
   if (!m_hash.empty())
     hashImage(newIndex, image);
+  if (!m_flipsHash.empty()) {
+    m_flipsHash.push_back(0);
+    hashTileFlips(newIndex);
+  }
   return newIndex;
 }
 
@@ -232,13 +247,18 @@ void Tileset::insert(const tile_index ti, const ImageRef& image, const UserData&
 
   if (!m_hash.empty()) {
     // Fix all indexes in the hash that are greater than "ti"
-    for (auto& it : m_hash)
-      if (it.second >= ti)
-        ++it.second;
+    m_hash.shiftIndexes(ti, 1);
+    m_tileHashes.insert(m_tileHashes.begin() + ti, 0);
 
     // And now we can add the new image with the "ti" index
     hashImage(ti, image);
   }
+
+  if (!m_flipsHash.empty()) {
+    m_flipsTable.shiftIndexes(ti, 1);
+    m_flipsHash.insert(m_flipsHash.begin() + ti, 0);
+    hashTileFlips(ti);
+  }
 }
 
 void Tileset::erase(const tile_index ti)
@@ -275,58 +295,108 @@ bool Tileset::findTileIndex(const ImageRef& tileImage, tile_index& ti)
   auto& h = hashTable(); // Don't use m_hash directly in case that
                          // we've to regenerate the hash table.
 
-  auto it = h.find(tileImage);
-  if (it != h.end()) {
-    ti = it->second;
-    return true;
-  }
-  else {
-    ti = notile;
-    return false;
-  }
+  // The first tile with the same pixels
+  const Image* image = tileImage.get();
+  tile_index found = notile;
+  bool result = false;
+  h.forEachTile(calculate_image_hash(image, image->bounds()), [&](const tile_index i) {
+    const Image* tile = m_tiles[i].image.get();
+    if ((!result || i < found) && tile && is_same_image(image, tile)) {
+      found = i;
+      result = true;
+    }
+  });
+
+  ti = found;
+  return result;
 }
 
-void Tileset::notifyTileContentChange(const tile_index ti)
+bool Tileset::findTileIndex(const ImageRef& tileImage, tile_index& ti, tile_flags& tf)
 {
-#if 0 // TODO Try to do less work
+  tf = 0;
+  if (findTileIndex(tileImage, ti))
+    return true;
 
-  ASSERT(ti >= 0 && ti < size());
+  // In case we don't allow flipped tiles
+  if (m_matchFlags == 0 || !tileImage)
+    return false;
+
+  // Create the flips table if needed
+  if (m_flipsHash.empty()) {
+    m_flipsHash.resize(m_tiles.size());
+    for (tile_index i = 0; i < size(); ++i)
+      hashTileFlips(i);
+  }
+
+  // Tiles that can be equal to a flipped version of the image
+  std::vector<tile_index> candidates;
+  m_flipsTable.forEachTile(calculate_tile_flips_hash(tileImage.get()),
+                           [&candidates](const tile_index i) { candidates.push_back(i); });
+  std::sort(candidates.begin(), candidates.end());
+
+  // Same order used to flip the image in previous versions
+  static constexpr tile_flags kFlips[] = {
+    tile_f_xflip,
+    tile_f_yflip,
+    tile_f_xflip | tile_f_yflip,
+    tile_f_dflip,
+    tile_f_xflip | tile_f_dflip,
+    tile_f_xflip | tile_f_yflip | tile_f_dflip,
+    tile_f_yflip | tile_f_dflip,
+  };
+
+  const Image* image = tileImage.get();
+  const bool square = (image->width() == image->height());
+  for (const tile_flags flags : kFlips) {
+    if ((flags & m_matchFlags) != flags)
+      continue;
+
+    // The hash is not the same for diagonal flips of non-square
+    // tiles, so we have to compare all tiles.
+    if ((flags & tile_f_dflip) && !square) {
+      for (tile_index i = 0; i < size(); ++i) {
+        if (m_tiles[i].image && is_same_flipped_tile(image, flags, m_tiles[i].image.get())) {
+          ti = i;
+          tf = flags;
+          return true;
+        }
+      }
+      continue;
+    }
 
-  // If two or more tiles are exactly the same, they will have the
-  // same hash, so the m_hash table can be smaller than the m_tiles
-  // array.
-  if (m_hash.size() < m_tiles.size()) {
-    // Count how many hash elements are poiting to this tile index
-    int tilesWithSameHash = 0;
-    for (auto item : m_hash)
-      if (item.second == ti)
-        ++tilesWithSameHash;
-
-    // In this case we re-generate the whole hash table because one or
-    // more tiles tile are using the hash of the modified tile.
-    if (tilesWithSameHash >= 2) {
-      rehash();
-      return;
+    for (const tile_index i : candidates) {
+      if (is_same_flipped_tile(image, flags, m_tiles[i].image.get())) {
+        ti = i;
+        tf = flags;
+        return true;
+      }
     }
   }
 
-  // In other case we can do a fast-path, just removing and
-  // re-adding the tile to the hash table.
-  removeFromHash(ti, false);
-  if (!m_hash.empty())
-    hashImage(ti, m_tiles[ti]);
+  ti = notile;
+  return false;
+}
 
-#else // Regenerate the whole hash map (at the moment this is the
-      // only way to make it work correctly)
+void Tileset::notifyTileContentChange(const tile_index ti)
+{
+  if (ti < 0 || ti >= m_tiles.size() || !m_tiles[ti].image) {
+    rehash();
+    return;
+  }
 
-  (void)ti; // unused
+  preprocess_transparent_pixels(m_tiles[ti].image.get());
 
-  if (ti >= 0 && ti < m_tiles.size() && m_tiles[ti].image)
-    preprocess_transparent_pixels(m_tiles[ti].image.get());
+  // Re-hash only the modified tile (each tile has its own entry in
+  // the hash tables, and we know its previous hash).
+  removeFromHash(ti, false);
+  if (!m_hash.empty())
+    hashImage(ti, m_tiles[ti].image);
 
-  rehash();
+  removeTileFlipsHash(ti);
+  if (!m_flipsHash.empty())
+    hashTileFlips(ti);
 
-#endif
+  discardCompressedData();
 }
 
 void Tileset::notifyRegenerateEmptyTile()
@@ -342,17 +412,13 @@ void Tileset::notifyRegenerateEmptyTile()
 
 void Tileset::removeFromHash(const tile_index ti, const bool adjustIndexes)
 {
-  auto end = m_hash.end();
-  for (auto it = m_hash.begin(); it != end;) {
-    if (it->second == ti) {
-      it = m_hash.erase(it);
-      end = m_hash.end();
-    }
-    else {
-      if (adjustIndexes && it->second > ti)
-        --it->second;
-      ++it;
-    }
+  if (ti < 0 || ti >= m_tileHashes.size())
+    return;
+
+  m_hash.erase(m_tileHashes[ti], ti);
+  if (adjustIndexes) {
+    m_hash.shiftIndexes(ti + 1, -1);
+    m_tileHashes.erase(m_tileHashes.begin() + ti);
   }
 }
 
@@ -364,38 +430,51 @@ void Tileset::assertValidHashTable()
   if (m_hash.empty())
     return;
 
-  // If two or more tiles are exactly the same, they will have the
-  // same hash, so the m_hash table can be smaller than the m_tiles
-  // array.
-  if (m_hash.size() < m_tiles.size()) {
-    for (tile_index ti = 0; ti < tile_index(m_tiles.size()); ++ti) {
-      auto it = m_hash.find(m_tiles[ti].image);
-      ASSERT(it != m_hash.end());
-
-      // If the hash doesn't match, it is because other tile is equal
-      // to this one.
-      if (it->second != ti) {
-        ASSERT(is_same_image(it->first.get(), m_tiles[it->second].image.get()));
-      }
-    }
-  }
-  else if (m_hash.size() == m_tiles.size()) {
-    for (tile_index ti = 0; ti < tile_index(m_tiles.size()); ++ti) {
-      auto it = m_hash.find(m_tiles[ti].image);
-      ASSERT(it != m_hash.end());
-      ASSERT(it->second == ti);
-    }
-  }
-  else {
-    ASSERT(false && "The hash table cannot contain more tiles than the tileset");
+  // Each tile has its own entry with the hash of its current pixels.
+  ASSERT(m_hash.size() == m_tiles.size());
+  ASSERT(m_tileHashes.size() == m_tiles.size());
+  for (tile_index ti = 0; ti < tile_index(m_tiles.size()); ++ti) {
+    const Image* image = m_tiles[ti].image.get();
+    ASSERT(image);
+    ASSERT(m_tileHashes[ti] == calculate_image_hash(image, image->bounds()));
+
+    bool found = false;
+    m_hash.forEachTile(m_tileHashes[ti], [ti, &found](const tile_index i) {
+      if (i == ti)
+        found = true;
+    });
+    ASSERT(found);
   }
 }
 #endif
 
 void Tileset::hashImage(const tile_index ti, const ImageRef& tileImage)
 {
-  if (m_hash.find(tileImage) == m_hash.end())
-    m_hash[tileImage] = ti;
+  if (ti >= m_tileHashes.size())
+    m_tileHashes.resize(ti + 1);
+
+  const uint32_t hash = calculate_image_hash(tileImage.get(), tileImage->bounds());
+  m_tileHashes[ti] = hash;
+  m_hash.insert(hash, ti);
+}
+
+void Tileset::hashTileFlips(const tile_index ti)
+{
+  ASSERT(ti >= 0 && ti < int(m_flipsHash.size()));
+  if (!m_tiles[ti].image)
+    return;
+
+  const uint32_t hash = calculate_tile_flips_hash(m_tiles[ti].image.get());
+  m_flipsHash[ti] = hash;
+  m_flipsTable.insert(hash, ti);
+}
+
+void Tileset::removeTileFlipsHash(const tile_index ti)
+{
+  if (ti < 0 || ti >= int(m_flipsHash.size()))
+    return;
+
+  m_flipsTable.erase(m_flipsHash[ti], ti);
 }
 
 void Tileset::rehash()
@@ -403,6 +482,9 @@ void Tileset::rehash()
   // Clear the hash table, we'll lazy-rehash it when
   // hashTable()/findTileIndex() is used.
   m_hash.clear();
+  m_tileHashes.clear();
+  m_flipsTable.clear();
+  m_flipsHash.clear();
 
   // Reset the compressed data (just in case we have cached the data
   // from a loaded .aseprite file or when saving the file).
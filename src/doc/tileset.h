@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2019-2025  Igara Studio S.A.
+// Copyright (c) 2019-2026  Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -124,6 +124,11 @@ public:
   // before calling this function.
   bool findTileIndex(const ImageRef& tileImage, tile_index& ti);
 
+  // Same as findTileIndex() but it can match a flipped version of
+  // the tile too using the current matchFlags(). Returns the flips
+  // that must be applied to "tileImage" to get the tile in "tf".
+  bool findTileIndex(const ImageRef& tileImage, tile_index& ti, tile_flags& tf);
+
   // Must be called when a tile image was modified externally, so
   // the hash elements are re-calculated for that specific tile.
   void notifyTileContentChange(const tile_index ti);
@@ -144,11 +149,23 @@ private:
   void hashImage(const tile_index ti, const ImageRef& tileImage);
   void rehash();
   TilesetHashTable& hashTable();
+  void hashTileFlips(const tile_index ti);
+  void removeTileFlipsHash(const tile_index ti);
 
   Sprite* m_sprite;
   Grid m_grid;
   Tiles m_tiles;
+  // Tiles indexed by the hash of their pixels (m_tileHashes[i] is the
+  // hash of the i-th tile, so a modified tile can be re-hashed
+  // without re-creating the whole table).
   TilesetHashTable m_hash;
+  std::vector<uint32_t> m_tileHashes;
+
+  // Tiles indexed by calculate_tile_flips_hash() to find flipped
+  // tiles (m_flipsHash[i] is the hash of the i-th tile). Created
+  // lazily as m_hash.
+  TilesetHashTable m_flipsTable;
+  std::vector<uint32_t> m_flipsHash;
   std::string m_name;
   int m_baseIndex = 1;
   tile_flags m_matchFlags = 0;
@@ -0,0 +1,102 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "doc/tileset_hash_table.h"
+
+#include "base/debug.h"
+
+namespace doc {
+
+void TilesetHashTable::clear()
+{
+  m_entries.clear();
+  m_size = 0;
+  m_shift = 64;
+}
+
+void TilesetHashTable::insert(const uint32_t hash, const tile_index ti)
+{
+  ASSERT(ti != kEmpty);
+
+  if (2 * (m_size + 1) > int(m_entries.size()))
+    grow();
+
+  const uint32_t mask = uint32_t(m_entries.size() - 1);
+  uint32_t i = homeSlot(hash);
+  while (m_entries[i].ti != kEmpty)
+    i = (i + 1) & mask;
+
+  m_entries[i].hash = hash;
+  m_entries[i].ti = ti;
+  ++m_size;
+}
+
+bool TilesetHashTable::erase(const uint32_t hash, const tile_index ti)
+{
+  if (m_entries.empty())
+    return false;
+
+  const uint32_t mask = uint32_t(m_entries.size() - 1);
+  uint32_t i = homeSlot(hash);
+  for (;; i = (i + 1) & mask) {
+    if (m_entries[i].ti == kEmpty)
+      return false;
+    if (m_entries[i].hash == hash && m_entries[i].ti == ti)
+      break;
+  }
+
+  // Move back the next entries of the cluster that cannot be found
+  // from their home slot after removing the "i" entry (so we don't
+  // need tombstones).
+  for (uint32_t j = (i + 1) & mask; m_entries[j].ti != kEmpty; j = (j + 1) & mask) {
+    const uint32_t home = homeSlot(m_entries[j].hash);
+    if (((j - home) & mask) >= ((j - i) & mask)) {
+      m_entries[i] = m_entries[j];
+      i = j;
+    }
+  }
+
+  m_entries[i] = Entry();
+  --m_size;
+  return true;
+}
+
+void TilesetHashTable::shiftIndexes(const tile_index ti, const int delta)
+{
+  for (Entry& entry : m_entries) {
+    if (entry.ti != kEmpty && entry.ti >= ti)
+      entry.ti += delta;
+  }
+}
+
+int TilesetHashTable::getMemSize() const
+{
+  return sizeof(TilesetHashTable) + int(m_entries.capacity() * sizeof(Entry));
+}
+
+void TilesetHashTable::grow()
+{
+  std::vector<Entry> old;
+  std::swap(old, m_entries);
+
+  const std::size_t capacity = (old.empty() ? 64 : old.size() * 2);
+  m_entries.resize(capacity);
+  m_size = 0;
+  m_shift = 64;
+  for (std::size_t n = capacity; n > 1; n >>= 1)
+    --m_shift;
+
+  for (const Entry& entry : old) {
+    if (entry.ti != kEmpty)
+      insert(entry.hash, entry.ti);
+  }
+}
+
+} // namespace doc
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2019  Igara Studio S.A.
+// Copyright (c) 2019-2026  Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -9,18 +9,77 @@
 #pragma once
 
 #include "doc/image.h"
-#include "doc/image_ref.h"
-#include "doc/images_map.h"
 #include "doc/primitives.h"
 #include "doc/tile.h"
 
-#include <unordered_map>
+#include <cstdint>
+#include <vector>
 
 namespace doc {
 
-// A hash table used to match Image pixels data <-> tileset index
-typedef std::unordered_map<ImageRef, tile_index, details::image_hash, details::image_eq>
-  TilesetHashTable;
+// A hash table used to match Image pixels data <-> tileset index.
+//
+// It's an open-addressing table (with linear probing) that contains
+// only the hash of each tile and its index (one entry for each tile,
+// even if there are several tiles with the same pixels). The hashes
+// are calculated by the user (e.g. with calculate_image_hash()), and
+// the pixels must be compared with the tiles of the tileset too.
+class TilesetHashTable {
+public:
+  bool empty() const { return m_size == 0; }
+  int size() const { return m_size; }
+  void clear();
+
+  void insert(const uint32_t hash, const tile_index ti);
+
+  // Removes the entry of the "ti" tile with the given hash. Returns
+  // false if it wasn't found.
+  bool erase(const uint32_t hash, const tile_index ti);
+
+  // Adds "delta" to all tile indexes greater or equal than "ti".
+  void shiftIndexes(const tile_index ti, const int delta);
+
+  // Calls f(ti) for each tile with the given hash (in any order).
+  template<typename Func>
+  void forEachTile(const uint32_t hash, Func&& f) const
+  {
+    if (m_entries.empty())
+      return;
+
+    const uint32_t mask = uint32_t(m_entries.size() - 1);
+    for (uint32_t i = homeSlot(hash);; i = (i + 1) & mask) {
+      const Entry& entry = m_entries[i];
+      if (entry.ti == kEmpty)
+        break;
+      if (entry.hash == hash)
+        f(entry.ti);
+    }
+  }
+
+  int getMemSize() const;
+
+private:
+  static constexpr tile_index kEmpty = 0xffffffff;
+
+  struct Entry {
+    uint32_t hash = 0;
+    tile_index ti = kEmpty;
+  };
+
+  uint32_t homeSlot(const uint32_t hash) const
+  {
+    // Fibonacci hashing to spread the bits of the hash
+    return uint32_t((hash * uint64_t(0x9e3779b97f4a7c15)) >> m_shift);
+  }
+
+  void grow();
+
+  // The size of this vector is a power of two (or 0), and the table
+  // is grown when it would be filled more than half.
+  std::vector<Entry> m_entries;
+  int m_size = 0;
+  int m_shift = 64;
+};
 
 } // namespace doc
 
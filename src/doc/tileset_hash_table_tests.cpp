@@ -0,0 +1,88 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "doc/tileset_hash_table.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace doc;
+
+namespace {
+
+std::vector<tile_index> tiles_with_hash(const TilesetHashTable& table, const uint32_t hash)
+{
+  std::vector<tile_index> tiles;
+  table.forEachTile(hash, [&tiles](const tile_index ti) { tiles.push_back(ti); });
+  std::sort(tiles.begin(), tiles.end());
+  return tiles;
+}
+
+} // anonymous namespace
+
+TEST(TilesetHashTable, InsertErase)
+{
+  TilesetHashTable table;
+  EXPECT_TRUE(table.empty());
+  EXPECT_TRUE(tiles_with_hash(table, 5).empty());
+
+  table.insert(5, 1);
+  table.insert(5, 3);
+  table.insert(7, 2);
+  EXPECT_EQ(3, table.size());
+  EXPECT_EQ(std::vector<tile_index>({ 1, 3 }), tiles_with_hash(table, 5));
+  EXPECT_EQ(std::vector<tile_index>({ 2 }), tiles_with_hash(table, 7));
+
+  EXPECT_FALSE(table.erase(7, 1));
+  EXPECT_TRUE(table.erase(5, 1));
+  EXPECT_EQ(std::vector<tile_index>({ 3 }), tiles_with_hash(table, 5));
+
+  table.shiftIndexes(3, 2);
+  EXPECT_EQ(std::vector<tile_index>({ 5 }), tiles_with_hash(table, 5));
+  EXPECT_EQ(std::vector<tile_index>({ 2 }), tiles_with_hash(table, 7));
+
+  table.clear();
+  EXPECT_TRUE(table.empty());
+  EXPECT_TRUE(tiles_with_hash(table, 5).empty());
+}
+
+TEST(TilesetHashTable, Random)
+{
+  std::mt19937 rng(2026);
+  TilesetHashTable table;
+  std::multimap<uint32_t, tile_index> expected;
+
+  for (int i = 0; i < 20000; ++i) {
+    // Few different hashes to get long clusters of collisions
+    const uint32_t hash = rng() % 300;
+    if (rng() % 3 == 0 && !expected.empty()) {
+      auto it = expected.lower_bound(hash);
+      if (it == expected.end())
+        it = expected.begin();
+      EXPECT_TRUE(table.erase(it->first, it->second));
+      expected.erase(it);
+    }
+    else {
+      const tile_index ti = i;
+      table.insert(hash, ti);
+      expected.insert(std::make_pair(hash, ti));
+    }
+  }
+
+  EXPECT_EQ(int(expected.size()), table.size());
+  for (uint32_t hash = 0; hash < 300; ++hash) {
+    std::vector<tile_index> tiles;
+    auto range = expected.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+      tiles.push_back(it->second);
+    std::sort(tiles.begin(), tiles.end());
+    EXPECT_EQ(tiles, tiles_with_hash(table, hash)) << hash;
+  }
+}
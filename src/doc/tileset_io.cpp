@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (C) 2019-2023  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -27,7 +27,10 @@ namespace doc {
 using namespace base::serialization;
 using namespace base::serialization::little_endian;
 
-bool write_tileset(std::ostream& os, const Tileset* tileset, CancelIO* cancel)
+bool write_tileset(std::ostream& os,
+                   const Tileset* tileset,
+                   CancelIO* cancel,
+                   int compressionLevel)
 {
   write32(os, tileset->id());
   write32(os, tileset->size());
@@ -37,7 +40,7 @@ bool write_tileset(std::ostream& os, const Tileset* tileset, CancelIO* cancel)
     if (cancel && cancel->isCanceled())
       return false;
 
-    write_image(os, tileset->get(ti).get(), cancel);
+    write_image(os, tileset->get(ti).get(), cancel, compressionLevel);
   }
 
   write8(os, uint8_t(TilesetSerialFormat::LastVer));
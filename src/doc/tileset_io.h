@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (C) 2019-2024  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -38,7 +38,12 @@ class CancelIO;
 class Sprite;
 class Tileset;
 
-bool write_tileset(std::ostream& os, const Tileset* tileset, CancelIO* cancel = nullptr);
+// The tiles are compressed with the given zlib compression level
+// (see write_image()).
+bool write_tileset(std::ostream& os,
+                   const Tileset* tileset,
+                   CancelIO* cancel = nullptr,
+                   int compressionLevel = -1);
 
 Tileset* read_tileset(std::istream& is,
                       Sprite* sprite,
@@ -0,0 +1,143 @@
+// Aseprite Document Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "doc/algorithm/flip_image.h"
+#include "doc/image.h"
+#include "doc/image_ref.h"
+#include "doc/primitives.h"
+#include "doc/sprite.h"
+#include "doc/tile_primitives.h"
+#include "doc/tileset.h"
+
+#include <memory>
+
+using namespace doc;
+using namespace doc::algorithm;
+
+namespace {
+
+// Returns a copy of the tile flipped in the inverse order used by
+// Tileset::findTileIndex() (D, Y, and then X), so that the copy
+// flipped with "tf" matches the original tile.
+ImageRef make_query_image(const ImageRef& tile, const tile_flags tf)
+{
+  ImageRef image(Image::createCopy(tile.get()));
+  if (tf & tile_f_dflip)
+    flip_image(image.get(), image->bounds(), FlipDiagonal);
+  if (tf & tile_f_yflip)
+    flip_image(image.get(), image->bounds(), FlipVertical);
+  if (tf & tile_f_xflip)
+    flip_image(image.get(), image->bounds(), FlipHorizontal);
+  return image;
+}
+
+ImageRef make_tile(const int w, const int h)
+{
+  // All pixels are different, so each flipped version of the tile
+  // matches only itself.
+  ImageRef tile(Image::create(IMAGE_INDEXED, w, h));
+  for (int y = 0; y < h; ++y)
+    for (int x = 0; x < w; ++x)
+      put_pixel(tile.get(), x, y, 1 + x + y * w);
+  return tile;
+}
+
+} // anonymous namespace
+
+TEST(Tileset, FlipsHash)
+{
+  const ImageRef tile = make_tile(4, 4);
+  const uint32_t hash = calculate_tile_flips_hash(tile.get());
+  for (tile_flags tf = tile_f_dflip;; tf += tile_f_dflip) {
+    ImageRef image = make_query_image(tile, tf);
+    EXPECT_EQ(hash, calculate_tile_flips_hash(image.get())) << tf;
+    EXPECT_TRUE(is_same_flipped_tile(image.get(), tf, tile.get())) << tf;
+    EXPECT_FALSE(is_same_flipped_tile(image.get(), 0, tile.get())) << tf;
+    if (tf == tile_f_mask)
+      break;
+  }
+}
+
+TEST(Tileset, FindFlippedTile)
+{
+  auto sprite = std::make_shared<Sprite>(ImageSpec(ColorMode::INDEXED, 32, 32), 256);
+  Tileset tileset(sprite.get(), Grid(gfx::Size(4, 4)), 1);
+  tileset.add(make_tile(4, 4));
+  tileset.setMatchFlags(tile_f_mask);
+
+  tile_index ti;
+  tile_flags tf;
+  for (tile_flags flags = 0;; flags += tile_f_dflip) {
+    ImageRef image = make_query_image(tileset.get(1), flags);
+    EXPECT_TRUE(tileset.findTileIndex(image, ti, tf)) << flags;
+    EXPECT_EQ(1, ti);
+    EXPECT_EQ(flags, tf);
+    if (flags == tile_f_mask)
+      break;
+  }
+
+  // Diagonal flips are not allowed
+  tileset.setMatchFlags(tile_f_xflip | tile_f_yflip);
+  EXPECT_TRUE(tileset.findTileIndex(make_query_image(tileset.get(1), tile_f_yflip), ti, tf));
+  EXPECT_EQ(tile_f_yflip, tf);
+  EXPECT_FALSE(tileset.findTileIndex(make_query_image(tileset.get(1), tile_f_dflip), ti, tf));
+  EXPECT_EQ(notile, ti);
+
+  // New tiles are added to the flips table
+  ImageRef tile2 = make_tile(4, 4);
+  put_pixel(tile2.get(), 0, 0, 100);
+  tileset.add(tile2);
+  EXPECT_TRUE(tileset.findTileIndex(make_query_image(tile2, tile_f_xflip), ti, tf));
+  EXPECT_EQ(2, ti);
+  EXPECT_EQ(tile_f_xflip, tf);
+
+  // And modified tiles too
+  put_pixel(tile2.get(), 0, 0, 101);
+  tileset.set(2, tile2);
+  EXPECT_TRUE(tileset.findTileIndex(make_query_image(tile2, tile_f_xflip), ti, tf));
+  EXPECT_EQ(2, ti);
+
+  tileset.setMatchFlags(0);
+  EXPECT_FALSE(tileset.findTileIndex(make_query_image(tile2, tile_f_xflip), ti, tf));
+}
+
+TEST(Tileset, TileContentChange)
+{
+  auto sprite = std::make_shared<Sprite>(ImageSpec(ColorMode::INDEXED, 32, 32), 256);
+  Tileset tileset(sprite.get(), Grid(gfx::Size(4, 4)), 1);
+  const ImageRef tile1 = make_tile(4, 4);
+  const ImageRef tile2 = make_tile(4, 4);
+  put_pixel(tile2.get(), 1, 1, 100);
+  tileset.add(tile1);
+  tileset.add(tile2);
+
+  tile_index ti;
+  ImageRef query(Image::createCopy(tile2.get()));
+  EXPECT_TRUE(tileset.findTileIndex(query, ti));
+  EXPECT_EQ(2, ti);
+
+  // Modify the first tile to be equal to the second one
+  put_pixel(tile1.get(), 1, 1, 100);
+  tileset.notifyTileContentChange(1);
+  EXPECT_TRUE(tileset.findTileIndex(query, ti));
+  EXPECT_EQ(1, ti);
+
+  ImageRef oldTile1 = make_tile(4, 4);
+  EXPECT_FALSE(tileset.findTileIndex(oldTile1, ti));
+
+  // Tiles after an inserted tile are moved
+  tileset.insert(1, oldTile1);
+  EXPECT_TRUE(tileset.findTileIndex(query, ti));
+  EXPECT_EQ(2, ti);
+  EXPECT_TRUE(tileset.findTileIndex(oldTile1, ti));
+  EXPECT_EQ(1, ti);
+
+#ifdef _DEBUG
+  tileset.assertValidHashTable();
+#endif
+}
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2023-2025  Igara Studio S.A.
+// Copyright (c) 2023-2026  Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -12,8 +12,82 @@
 
 #include "base/debug.h"
 
+#include <mutex>
+
 namespace doc {
 
+// Const member functions decode lazy properties (modifying the
+// mutable maps), and they can be called from several threads at the
+// same time (e.g. with a read lock of the document). Decoding is
+// rare, so one mutex for all user data is enough.
+static std::mutex g_lazyMutex;
+
+UserData::UserData(const UserData& other) : m_text(other.m_text), m_color(other.m_color)
+{
+  const std::lock_guard lock(g_lazyMutex);
+  m_propertiesMaps = other.m_propertiesMaps;
+  m_lazyPropertiesMaps = other.m_lazyPropertiesMaps;
+}
+
+UserData& UserData::operator=(const UserData& other)
+{
+  if (this != &other) {
+    m_text = other.m_text;
+    m_color = other.m_color;
+
+    const std::lock_guard lock(g_lazyMutex);
+    m_propertiesMaps = other.m_propertiesMaps;
+    m_lazyPropertiesMaps = other.m_lazyPropertiesMaps;
+  }
+  return *this;
+}
+
+bool UserData::isEmpty() const
+{
+  if (!m_text.empty() || doc::rgba_geta(m_color))
+    return false;
+
+  const std::lock_guard lock(g_lazyMutex);
+  return m_propertiesMaps.empty() && m_lazyPropertiesMaps.empty();
+}
+
+void UserData::forEachPropertiesMap(
+  const std::function<void(const std::string&, const Properties&)>& decodedFunc,
+  const std::function<void(const std::string&, const LazyProperties&)>& lazyFunc) const
+{
+  const std::lock_guard lock(g_lazyMutex);
+  for (const auto& it : m_propertiesMaps)
+    decodedFunc(it.first, it.second);
+  for (const auto& it : m_lazyPropertiesMaps)
+    lazyFunc(it.first, *it.second);
+}
+
+void UserData::setLazyProperties(const std::string& groupKey, const LazyPropertiesRef& properties)
+{
+  ASSERT(properties);
+  const std::lock_guard lock(g_lazyMutex);
+  m_propertiesMaps.erase(groupKey);
+  m_lazyPropertiesMaps[groupKey] = properties;
+}
+
+void UserData::decodeLazyProperties() const
+{
+  const std::lock_guard lock(g_lazyMutex);
+  for (const auto& it : m_lazyPropertiesMaps)
+    m_propertiesMaps[it.first] = it.second->decode();
+  m_lazyPropertiesMaps.clear();
+}
+
+void UserData::decodeLazyProperties(const std::string& groupKey) const
+{
+  const std::lock_guard lock(g_lazyMutex);
+  auto it = m_lazyPropertiesMaps.find(groupKey);
+  if (it != m_lazyPropertiesMaps.end()) {
+    m_propertiesMaps[groupKey] = it->second->decode();
+    m_lazyPropertiesMaps.erase(it);
+  }
+}
+
 size_t count_nonempty_properties_maps(const UserData::PropertiesMaps& propertiesMaps)
 {
   size_t i = 0;
@@ -23,6 +97,20 @@ size_t count_nonempty_properties_maps(const UserData::PropertiesMaps& properties
   return i;
 }
 
+size_t count_nonempty_properties_maps(const UserData& userData)
+{
+  size_t i = 0;
+  userData.forEachPropertiesMap(
+    [&i](const std::string&, const UserData::Properties& properties) {
+      if (!properties.empty())
+        ++i;
+    },
+    // Lazy properties are never empty (empty maps are not stored as
+    // lazy properties)
+    [&i](const std::string&, const UserData::LazyProperties&) { ++i; });
+  return i;
+}
+
 static bool is_negative(const UserData::Variant& value)
 {
   switch (value.type()) {
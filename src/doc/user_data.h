@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2022-2025 Igara Studio S.A.
+// Copyright (c) 2022-2026 Igara Studio S.A.
 // Copyright (c) 2001-2015 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -17,8 +17,10 @@
 #include "gfx/size.h"
 
 #include <cstddef>
+#include <functional>
 #include <limits>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <variant>
@@ -102,24 +104,74 @@ public:
     const uint16_t type() const { return index(); }
   };
 
+  // A properties map that is decoded on demand, e.g. from the raw
+  // bytes read from a .aseprite file. Files with a lot of properties
+  // are loaded faster and use less memory if the properties aren't
+  // accessed.
+  class LazyProperties {
+  public:
+    LazyProperties(std::vector<uint8_t>&& data) : m_data(std::move(data)) {}
+    virtual ~LazyProperties() {}
+
+    // Raw bytes of the properties (a USER_DATA_PROPERTY_TYPE_PROPERTIES
+    // value in the .aseprite format), so they can be saved again
+    // without decoding them.
+    const std::vector<uint8_t>& data() const { return m_data; }
+
+    virtual Properties decode() const = 0;
+
+  private:
+    std::vector<uint8_t> m_data;
+  };
+  using LazyPropertiesRef = std::shared_ptr<const LazyProperties>;
+  using LazyPropertiesMaps = std::map<std::string, LazyPropertiesRef>;
+
   UserData() : m_color(0) {}
+  UserData(const UserData& other);
+  UserData& operator=(const UserData& other);
 
   size_t size() const { return m_text.size(); }
-  bool isEmpty() const
-  {
-    return m_text.empty() && !doc::rgba_geta(m_color) && m_propertiesMaps.empty();
-  }
+  bool isEmpty() const;
 
   const std::string& text() const { return m_text; }
   color_t color() const { return m_color; }
-  const PropertiesMaps& propertiesMaps() const { return m_propertiesMaps; }
-  PropertiesMaps& propertiesMaps() { return m_propertiesMaps; }
+
+  // Returns all the properties maps (decoding the lazy ones). Lazy
+  // properties can be decoded from any thread (e.g. the data recovery
+  // thread reading a document while the UI thread reads it too).
+  const PropertiesMaps& propertiesMaps() const
+  {
+    decodeLazyProperties();
+    return m_propertiesMaps;
+  }
+  PropertiesMaps& propertiesMaps()
+  {
+    decodeLazyProperties();
+    return m_propertiesMaps;
+  }
   Properties& properties() { return properties(std::string()); }
-  Properties& properties(const std::string& groupKey) { return m_propertiesMaps[groupKey]; }
+  Properties& properties(const std::string& groupKey)
+  {
+    decodeLazyProperties(groupKey);
+    return m_propertiesMaps[groupKey];
+  }
+
+  // Calls the given functions for each decoded properties map and
+  // each lazy one, without decoding anything (e.g. to save the lazy
+  // properties as they are). The functions are called with the lazy
+  // properties mutex locked, so they cannot access the properties
+  // maps of any UserData.
+  void forEachPropertiesMap(
+    const std::function<void(const std::string&, const Properties&)>& decodedFunc,
+    const std::function<void(const std::string&, const LazyProperties&)>& lazyFunc) const;
 
   void setText(const std::string& text) { m_text = text; }
   void setColor(color_t color) { m_color = color; }
 
+  // Replaces the given properties map with lazy properties (which
+  // cannot be an empty map).
+  void setLazyProperties(const std::string& groupKey, const LazyPropertiesRef& properties);
+
   bool operator==(const UserData& other) const
   {
     return (m_text == other.m_text && m_color == other.m_color);
@@ -128,9 +180,13 @@ public:
   bool operator!=(const UserData& other) const { return !operator==(other); }
 
 private:
+  void decodeLazyProperties() const;
+  void decodeLazyProperties(const std::string& groupKey) const;
+
   std::string m_text;
   color_t m_color;
-  PropertiesMaps m_propertiesMaps;
+  mutable PropertiesMaps m_propertiesMaps;
+  mutable LazyPropertiesMaps m_lazyPropertiesMaps;
 };
 
 // macOS 10.9 C++ runtime doesn't support std::get<T>(value)
@@ -170,6 +226,10 @@ inline bool is_reducible_int(const UserData::Variant& variant)
 
 size_t count_nonempty_properties_maps(const UserData::PropertiesMaps& propertiesMaps);
 
+// Same as count_nonempty_properties_maps() but counting the lazy
+// properties maps too (without decoding them).
+size_t count_nonempty_properties_maps(const UserData& userData);
+
 // If all the elements of vector have the same type, returns that type, also
 // if this type is an integer, it tries to reduce it to the minimum int type
 // capable of storing all the vector values.
@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2022 Igara Studio S.A.
+// Copyright (c) 2022-2026 Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -12,6 +12,8 @@
 
 #include "doc/user_data.h"
 
+#include <memory>
+
 using namespace doc;
 using Variant = UserData::Variant;
 using Fixed = UserData::Fixed;
@@ -174,6 +176,75 @@ TEST(ExtensionProperties, SimpleProperties)
   EXPECT_TRUE(data.properties("someExtensionId").size() == 0);
 }
 
+namespace {
+
+size_t count_lazy_maps(const UserData& data)
+{
+  size_t n = 0;
+  data.forEachPropertiesMap([](const std::string&, const UserData::Properties&) {},
+                            [&n](const std::string&, const UserData::LazyProperties&) { ++n; });
+  return n;
+}
+
+size_t count_decoded_maps(const UserData& data)
+{
+  size_t n = 0;
+  data.forEachPropertiesMap([&n](const std::string&, const UserData::Properties&) { ++n; },
+                            [](const std::string&, const UserData::LazyProperties&) {});
+  return n;
+}
+
+} // anonymous namespace
+
+class TestLazyProperties : public UserData::LazyProperties {
+public:
+  TestLazyProperties(int& decoded) : LazyProperties({ 1, 2, 3 }), m_decoded(decoded) {}
+  Properties decode() const override
+  {
+    ++m_decoded;
+    Properties properties;
+    properties["number"] = int32_t(data().size());
+    return properties;
+  }
+
+private:
+  int& m_decoded;
+};
+
+TEST(LazyProperties, DecodeOnDemand)
+{
+  int decoded = 0;
+  UserData data;
+  EXPECT_TRUE(data.isEmpty());
+
+  data.setLazyProperties("ext1", std::make_shared<TestLazyProperties>(decoded));
+  data.setLazyProperties("ext2", std::make_shared<TestLazyProperties>(decoded));
+  EXPECT_FALSE(data.isEmpty());
+  EXPECT_EQ(2u, count_lazy_maps(data));
+  EXPECT_EQ(2u, count_nonempty_properties_maps(data));
+  EXPECT_EQ(0, decoded);
+
+  // Copies don't decode properties
+  UserData copy = data;
+  EXPECT_EQ(2u, count_lazy_maps(copy));
+  EXPECT_EQ(0, decoded);
+
+  // Only the accessed map is decoded
+  EXPECT_EQ(3, get_value<int32_t>(data.properties("ext1")["number"]));
+  EXPECT_EQ(1, decoded);
+  EXPECT_EQ(1u, count_lazy_maps(data));
+  EXPECT_EQ(1u, count_decoded_maps(data));
+  EXPECT_EQ(2u, count_nonempty_properties_maps(data));
+
+  // All maps are decoded
+  EXPECT_EQ(2u, data.propertiesMaps().size());
+  EXPECT_EQ(2, decoded);
+  EXPECT_EQ(0u, count_lazy_maps(data));
+
+  EXPECT_EQ(2u, static_cast<const UserData&>(copy).propertiesMaps().size());
+  EXPECT_EQ(4, decoded);
+}
+
 int main(int argc, char** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2022  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2017  David Capello
 //
 // This program is distributed under the terms of
@@ -42,12 +42,20 @@ void BrightnessContrastFilter::setBrightness(double brightness)
 {
   m_brightness = brightness;
   updateMap();
+  m_cache.clear();
 }
 
 void BrightnessContrastFilter::setContrast(double contrast)
 {
   m_contrast = contrast;
   updateMap();
+  m_cache.clear();
+}
+
+std::unique_ptr<Filter> BrightnessContrastFilter::createThreadCopy() const
+{
+  // Each thread needs its own cache of colors
+  return std::make_unique<BrightnessContrastFilter>(*this);
 }
 
 void BrightnessContrastFilter::applyToRgba(FilterManager* filterMgr)
@@ -56,14 +64,20 @@ void BrightnessContrastFilter::applyToRgba(FilterManager* filterMgr)
   const Palette* pal = fid->getPalette();
   Palette* newPal = (m_usePaletteOnRGB ? fid->getNewPalette() : nullptr);
 
+  // Colors of the new palette are cached (the table is already fast
+  // enough to use it directly)
+  if (newPal)
+    m_cache.update(filterMgr->getTarget(), pal, newPal);
+
   FILTER_LOOP_THROUGH_ROW_BEGIN(uint32_t)
   {
     color_t c = *src_address;
 
     if (newPal) {
-      int i = pal->findExactMatch(rgba_getr(c), rgba_getg(c), rgba_getb(c), rgba_geta(c), -1);
-      if (i >= 0)
-        c = newPal->getEntry(i);
+      c = m_cache.get(c, [pal, newPal](const color_t c) {
+        int i = pal->findExactMatch(rgba_getr(c), rgba_getg(c), rgba_getb(c), rgba_geta(c), -1);
+        return (i >= 0 ? newPal->getEntry(i) : c);
+      });
     }
     else {
       applyFilterToRgb(target, c);
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2017  David Capello
 //
 // This program is distributed under the terms of
@@ -11,6 +11,7 @@
 
 #include "doc/color.h"
 #include "doc/palette_picks.h"
+#include "filters/color_cache.h"
 #include "filters/filter.h"
 #include "filters/target.h"
 
@@ -24,6 +25,7 @@ public:
 
   double brightness() const { return m_brightness; }
   double contrast() const { return m_contrast; }
+  const std::vector<int>& colorMap() const { return m_cmap; }
   void setBrightness(double brightness);
   void setContrast(double contrast);
 
@@ -32,6 +34,8 @@ public:
   void applyToRgba(FilterManager* filterMgr) override;
   void applyToGrayscale(FilterManager* filterMgr) override;
   void applyToIndexed(FilterManager* filterMgr) override;
+  std::unique_ptr<Filter> createThreadCopy() const override;
+  bool isPointwise() const override { return true; }
 
 private:
   void onApplyToPalette(FilterManager* filterMgr, const doc::PalettePicks& picks) override;
@@ -40,6 +44,7 @@ private:
 
   double m_brightness, m_contrast;
   std::vector<int> m_cmap;
+  ColorCache m_cache;
 };
 
 } // namespace filters
@@ -0,0 +1,92 @@
+// Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifndef FILTERS_COLOR_CACHE_H_INCLUDED
+#define FILTERS_COLOR_CACHE_H_INCLUDED
+#pragma once
+
+#include "doc/color.h"
+#include "doc/palette.h"
+#include "filters/target.h"
+
+#include <array>
+#include <cstdint>
+
+namespace filters {
+
+// Results of a pointwise filter for the last RGBA colors found in
+// the image. Images usually have a lot of pixels with the same
+// color, so we can avoid calculating the filter for each pixel
+// (e.g. HSL/HSV conversions or searching the color in the palette).
+//
+// It's a direct-mapped table (each color can be only in one entry
+// given its hash), so it doesn't allocate memory while it's used.
+// The filter must call clear() when its settings are modified.
+class ColorCache {
+public:
+  ColorCache() { clear(); }
+
+  void clear() { m_entries.fill(Entry()); }
+
+  // Clears the cache if the target or the palettes used to calculate
+  // the cached colors are different from the given ones.
+  void update(const Target target, const doc::Palette* pal, const doc::Palette* newPal)
+  {
+    const Key key = { target,
+                      pal,
+                      (pal ? pal->getModifications() : 0),
+                      newPal,
+                      (newPal ? newPal->getModifications() : 0) };
+    if (!(key == m_key)) {
+      clear();
+      m_key = key;
+    }
+  }
+
+  // Returns the result of the filter for the given color, func(color)
+  // is called only if the color is not in the cache.
+  template<typename Func>
+  doc::color_t get(const doc::color_t color, Func&& func)
+  {
+    Entry& entry = m_entries[(color * 2654435761u) >> (32 - kBits)];
+    if (!entry.used || entry.src != color) {
+      entry.src = color;
+      entry.dst = func(color);
+      entry.used = true;
+    }
+    return entry.dst;
+  }
+
+private:
+  static constexpr int kBits = 12;
+
+  struct Entry {
+    doc::color_t src = 0;
+    doc::color_t dst = 0;
+    bool used = false;
+  };
+
+  struct Key {
+    Target target = 0;
+    const doc::Palette* pal = nullptr;
+    int palMods = 0;
+    const doc::Palette* newPal = nullptr;
+    int newPalMods = 0;
+
+    bool operator==(const Key& o) const
+    {
+      return (target == o.target && pal == o.pal && palMods == o.palMods && newPal == o.newPal &&
+              newPalMods == o.newPalMods);
+    }
+  };
+
+  Key m_key;
+  std::array<Entry, 1 << kBits> m_entries;
+};
+
+} // namespace filters
+
+#endif
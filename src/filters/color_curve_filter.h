@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2015  David Capello
 //
 // This program is distributed under the terms of
@@ -22,12 +22,14 @@ public:
 
   void setCurve(const ColorCurve& curve);
   const ColorCurve& getCurve() const { return m_curve; }
+  const std::vector<int>& getColorMap() const { return m_cmap; }
 
   // Filter implementation
   const char* getName();
   void applyToRgba(FilterManager* filterMgr);
   void applyToGrayscale(FilterManager* filterMgr);
   void applyToIndexed(FilterManager* filterMgr);
+  bool isPointwise() const { return true; }
 
 private:
   void generateMap();
@@ -1,4 +1,5 @@
 // Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
 // Copyright (C) 2001-2015  David Capello
 //
 // This program is distributed under the terms of
@@ -10,6 +11,9 @@
 
 #include "filters/convolution_matrix.h"
 
+#include <cstdlib>
+#include <numeric>
+
 namespace filters {
 
 ConvolutionMatrix::ConvolutionMatrix(int width, int height)
@@ -24,4 +28,46 @@ ConvolutionMatrix::ConvolutionMatrix(int width, int height)
 {
 }
 
+bool ConvolutionMatrix::separate(std::vector<int>& rowFactors,
+                                 std::vector<int>& columnFactors) const
+{
+  // Use the first non-zero row divided by the GCD of its values as
+  // the row vector, so each row must be an integer multiple of it.
+  int y0 = 0;
+  int x0 = -1;
+  for (; y0 < m_height && x0 < 0; ++y0) {
+    for (int x = 0; x < m_width; ++x) {
+      if (value(x, y0) != 0) {
+        x0 = x;
+        break;
+      }
+    }
+  }
+  if (x0 < 0)
+    return false;
+  --y0;
+
+  int gcd = 0;
+  for (int x = 0; x < m_width; ++x)
+    gcd = std::gcd(gcd, std::abs(value(x, y0)));
+
+  rowFactors.resize(m_width);
+  for (int x = 0; x < m_width; ++x)
+    rowFactors[x] = value(x, y0) / gcd;
+
+  columnFactors.resize(m_height);
+  for (int y = 0; y < m_height; ++y) {
+    if (value(x0, y) % rowFactors[x0] != 0)
+      return false;
+
+    const int factor = value(x0, y) / rowFactors[x0];
+    for (int x = 0; x < m_width; ++x) {
+      if (value(x, y) != factor * rowFactors[x])
+        return false;
+    }
+    columnFactors[y] = factor;
+  }
+  return true;
+}
+
 } // namespace filters
@@ -1,4 +1,5 @@
 // Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
 // Copyright (C) 2001-2015  David Capello
 //
 // This program is distributed under the terms of
@@ -54,6 +55,13 @@ public:
   int& value(int x, int y) { return m_data[y * m_width + x]; }
   const int& value(int x, int y) const { return m_data[y * m_width + x]; }
 
+  // Returns true if the matrix is the product of a column and a row
+  // vector (e.g. a box or gaussian blur), so it can be applied in two
+  // 1D passes. In that case "rowFactors" (m_width elements) and
+  // "columnFactors" (m_height elements) are filled with integer
+  // factors where value(x, y) == rowFactors[x] * columnFactors[y].
+  bool separate(std::vector<int>& rowFactors, std::vector<int>& columnFactors) const;
+
 private:
   std::string m_name;      // Name
   int m_width, m_height;   // Size of the matrix
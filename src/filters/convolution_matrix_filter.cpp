@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2022  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2016  David Capello
 //
 // This program is distributed under the terms of
@@ -19,6 +19,16 @@
 #include "filters/filter_manager.h"
 #include "filters/neighboring_pixels.h"
 
+#include <algorithm>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_WIN64)
+  #include <emmintrin.h>
+  #define FILTERS_USE_SSE2_CONVOLUTION 1
+#else
+  #define FILTERS_USE_SSE2_CONVOLUTION 0
+#endif
+
 namespace filters {
 
 using namespace doc;
@@ -114,12 +124,328 @@ struct GetPixelsDelegateIndexed : public GetPixelsDelegate {
   }
 };
 
+#if FILTERS_USE_SSE2_CONVOLUTION
+// SSE2 doesn't have _mm_mullo_epi32() (it's from SSE4.1), so we
+// multiply the even and odd 32-bit lanes separately.
+inline __m128i mullo_epi32(const __m128i a, const __m128i b)
+{
+  const __m128i even = _mm_mul_epu32(a, b);
+  const __m128i odd = _mm_mul_epu32(_mm_srli_si128(a, 4), _mm_srli_si128(b, 4));
+  return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                            _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+#endif
+
+// dst[i] += factor * src[i] for each i in [0, n)
+inline void add_weighted(int* dst, const int* src, const int n, const int factor)
+{
+  int i = 0;
+#if FILTERS_USE_SSE2_CONVOLUTION
+  const __m128i f = _mm_set1_epi32(factor);
+  for (; i + 4 <= n; i += 4) {
+    const __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+    const __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+    _mm_storeu_si128((__m128i*)(dst + i), _mm_add_epi32(d, mullo_epi32(s, f)));
+  }
+#endif
+  for (; i < n; ++i)
+    dst[i] += factor * src[i];
+}
+
+// Functions to convert the sums of a delegate into the final pixel.
+
+RgbTraits::pixel_t filtered_rgba(GetPixelsDelegateRgba& delegate,
+                                 const RgbTraits::pixel_t color,
+                                 const Target target,
+                                 const ConvolutionMatrix* matrix)
+{
+  if (delegate.div == 0)
+    return color;
+
+  if (target & TARGET_RED_CHANNEL) {
+    delegate.r = delegate.r / delegate.div + matrix->getBias();
+    delegate.r = std::clamp(delegate.r, 0, 255);
+  }
+  else
+    delegate.r = rgba_getr(color);
+
+  if (target & TARGET_GREEN_CHANNEL) {
+    delegate.g = delegate.g / delegate.div + matrix->getBias();
+    delegate.g = std::clamp(delegate.g, 0, 255);
+  }
+  else
+    delegate.g = rgba_getg(color);
+
+  if (target & TARGET_BLUE_CHANNEL) {
+    delegate.b = delegate.b / delegate.div + matrix->getBias();
+    delegate.b = std::clamp(delegate.b, 0, 255);
+  }
+  else
+    delegate.b = rgba_getb(color);
+
+  if (target & TARGET_ALPHA_CHANNEL) {
+    delegate.a = delegate.a / matrix->getDiv() + matrix->getBias();
+    delegate.a = std::clamp(delegate.a, 0, 255);
+  }
+  else
+    delegate.a = rgba_geta(color);
+
+  return rgba(delegate.r, delegate.g, delegate.b, delegate.a);
+}
+
+GrayscaleTraits::pixel_t filtered_grayscale(GetPixelsDelegateGrayscale& delegate,
+                                            const GrayscaleTraits::pixel_t color,
+                                            const Target target,
+                                            const ConvolutionMatrix* matrix)
+{
+  if (delegate.div == 0)
+    return color;
+
+  if (target & TARGET_GRAY_CHANNEL) {
+    delegate.v = delegate.v / delegate.div + matrix->getBias();
+    delegate.v = std::clamp(delegate.v, 0, 255);
+  }
+  else
+    delegate.v = graya_getv(color);
+
+  if (target & TARGET_ALPHA_CHANNEL) {
+    delegate.a = delegate.a / matrix->getDiv() + matrix->getBias();
+    delegate.a = std::clamp(delegate.a, 0, 255);
+  }
+  else
+    delegate.a = graya_geta(color);
+
+  return graya(delegate.v, delegate.a);
+}
+
+IndexedTraits::pixel_t filtered_indexed(GetPixelsDelegateIndexed& delegate,
+                                        const IndexedTraits::pixel_t index,
+                                        const Target target,
+                                        const ConvolutionMatrix* matrix,
+                                        const RgbMap* rgbmap)
+{
+  if (delegate.div == 0)
+    return index;
+
+  if (target & TARGET_INDEX_CHANNEL) {
+    delegate.index = delegate.index / matrix->getDiv() + matrix->getBias();
+    return std::clamp(delegate.index, 0, 255);
+  }
+
+  const color_t color = delegate.pal->getEntry(index);
+
+  if (target & TARGET_RED_CHANNEL) {
+    delegate.r = delegate.r / delegate.div + matrix->getBias();
+    delegate.r = std::clamp(delegate.r, 0, 255);
+  }
+  else
+    delegate.r = rgba_getr(color);
+
+  if (target & TARGET_GREEN_CHANNEL) {
+    delegate.g = delegate.g / delegate.div + matrix->getBias();
+    delegate.g = std::clamp(delegate.g, 0, 255);
+  }
+  else
+    delegate.g = rgba_getg(color);
+
+  if (target & TARGET_BLUE_CHANNEL) {
+    delegate.b = delegate.b / delegate.div + matrix->getBias();
+    delegate.b = std::clamp(delegate.b, 0, 255);
+  }
+  else
+    delegate.b = rgba_getb(color);
+
+  if (target & TARGET_ALPHA_CHANNEL) {
+    delegate.a = delegate.a / delegate.div + matrix->getBias();
+    delegate.a = std::clamp(delegate.a, 0, 255);
+  }
+  else
+    delegate.a = rgba_geta(color);
+
+  return rgbmap->mapColor(delegate.r, delegate.g, delegate.b, delegate.a);
+}
+
 } // namespace
 
+// Applies the matrix to a whole row at once. The pixels of each
+// source row are converted to planes (one array of ints for each
+// channel) so the matrix can be applied with vectorized loops, and
+// these rows are kept in a cache to reuse them in the next rows.
+//
+// If the matrix is separable (the product of a column and a row
+// vector) the cached rows are already filtered horizontally, so we
+// need "width+height" multiplications for each pixel instead of
+// "width*height".
+class ConvolutionRows {
+public:
+  enum { kMaxPlanes = 6 };
+
+  // Calculates the sums of the planes for each pixel of the current
+  // row of the filterMgr (including pixels that will be skipped),
+  // "getPlanes(pixel, planes)" must fill the "nplanes" values of a
+  // pixel. The results can be accessed with sums().
+  template<typename Traits, typename GetPlanes>
+  void applyToRow(FilterManager* filterMgr,
+                  const ConvolutionMatrix* matrix,
+                  const TiledMode tiledMode,
+                  const int nplanes,
+                  GetPlanes getPlanes)
+  {
+    const Image* src = filterMgr->getSourceImage();
+    if (filterMgr->isFirstRow() || src != m_image || matrix != m_matrix ||
+        filterMgr->x() != m_x || filterMgr->getWidth() != m_width || tiledMode != m_tiledMode ||
+        nplanes != m_nplanes) {
+      reset(src, matrix, filterMgr->x(), filterMgr->getWidth(), tiledMode, nplanes);
+    }
+
+    std::fill(m_sums.begin(), m_sums.end(), 0);
+
+    const int cy = matrix->getCenterY();
+    const bool tiledY = (int(m_tiledMode) & int(TiledMode::Y_AXIS));
+    for (int dy = 0; dy < matrix->getHeight(); ++dy) {
+      if (m_separable && m_columnFactors[dy] == 0)
+        continue;
+
+      const int y = get_neighboring_coord(filterMgr->y() - cy + dy, src->height(), tiledY);
+      const int* row = cachedRow<Traits>(y, getPlanes);
+
+      for (int p = 0; p < m_nplanes; ++p) {
+        int* dst = &m_sums[p * m_width];
+        const int* planeRow = row + p * m_rowLength;
+
+        if (m_separable)
+          add_weighted(dst, planeRow, m_width, m_columnFactors[dy]);
+        else {
+          for (int dx = 0; dx < matrix->getWidth(); ++dx) {
+            if (const int factor = matrix->value(dx, dy))
+              add_weighted(dst, planeRow + dx, m_width, factor);
+          }
+        }
+      }
+    }
+  }
+
+  // Returns the sums of the given plane for each pixel of the row.
+  const int* sums(const int plane) const { return &m_sums[plane * m_width]; }
+
+private:
+  void reset(const Image* src,
+             const ConvolutionMatrix* matrix,
+             const int x,
+             const int width,
+             const TiledMode tiledMode,
+             const int nplanes)
+  {
+    m_image = src;
+    m_matrix = matrix;
+    m_x = x;
+    m_width = width;
+    m_tiledMode = tiledMode;
+    m_nplanes = nplanes;
+    m_separable = matrix->separate(m_rowFactors, m_columnFactors);
+
+    // Length of each plane of a cached row (without the horizontal
+    // pass we need the extra pixels at both sides of the row)
+    const int paddedLength = m_width + matrix->getWidth() - 1;
+    m_rowLength = (m_separable ? m_width : paddedLength);
+    if (m_separable)
+      m_padded.resize(std::size_t(m_nplanes) * paddedLength);
+
+    // We need at most "matrix height" different rows for each
+    // row of the output.
+    const int nslots = std::min(matrix->getHeight(), src->height());
+    m_slots.resize(std::size_t(nslots) * m_nplanes * m_rowLength);
+    m_slotRow.assign(nslots, -1);
+    m_slotUse.assign(nslots, 0);
+    m_rowSlot.assign(src->height(), -1);
+    m_useCounter = 0;
+
+    m_sums.resize(std::size_t(m_nplanes) * m_width);
+  }
+
+  // Returns the planes of the given source row (converting it if
+  // it's not in the cache).
+  template<typename Traits, typename GetPlanes>
+  const int* cachedRow(const int y, GetPlanes& getPlanes)
+  {
+    int slot = m_rowSlot[y];
+    if (slot < 0) {
+      // Replace the least recently used row
+      slot = int(std::min_element(m_slotUse.begin(), m_slotUse.end()) - m_slotUse.begin());
+      if (m_slotRow[slot] >= 0)
+        m_rowSlot[m_slotRow[slot]] = -1;
+      m_slotRow[slot] = y;
+      m_rowSlot[y] = slot;
+
+      int* row = &m_slots[std::size_t(slot) * m_nplanes * m_rowLength];
+      if (m_separable) {
+        convertRow<Traits>(y, getPlanes, &m_padded[0]);
+
+        const int paddedLength = m_width + m_matrix->getWidth() - 1;
+        std::fill(row, row + m_nplanes * m_rowLength, 0);
+        for (int p = 0; p < m_nplanes; ++p) {
+          for (int dx = 0; dx < m_matrix->getWidth(); ++dx) {
+            if (m_rowFactors[dx] != 0)
+              add_weighted(row + p * m_rowLength,
+                           &m_padded[p * paddedLength + dx],
+                           m_width,
+                           m_rowFactors[dx]);
+          }
+        }
+      }
+      else {
+        convertRow<Traits>(y, getPlanes, row);
+      }
+    }
+    m_slotUse[slot] = ++m_useCounter;
+    return &m_slots[std::size_t(slot) * m_nplanes * m_rowLength];
+  }
+
+  // Converts the pixels of the given row that are used by the matrix
+  // to planes (with "width+matrixWidth-1" values in each plane).
+  template<typename Traits, typename GetPlanes>
+  void convertRow(const int y, GetPlanes& getPlanes, int* planes)
+  {
+    const int paddedLength = m_width + m_matrix->getWidth() - 1;
+    const int x0 = m_x - m_matrix->getCenterX();
+    const bool tiledX = (int(m_tiledMode) & int(TiledMode::X_AXIS));
+    int values[kMaxPlanes];
+
+    for (int i = 0; i < paddedLength; ++i) {
+      const int x = get_neighboring_coord(x0 + i, m_image->width(), tiledX);
+      getPlanes(get_pixel_fast<Traits>(m_image, x, y), values);
+      for (int p = 0; p < m_nplanes; ++p)
+        planes[p * paddedLength + i] = values[p];
+    }
+  }
+
+  const Image* m_image = nullptr;
+  const ConvolutionMatrix* m_matrix = nullptr;
+  int m_x = 0;
+  int m_width = 0;
+  TiledMode m_tiledMode = TiledMode::NONE;
+  int m_nplanes = 0;
+  bool m_separable = false;
+  std::vector<int> m_rowFactors;
+  std::vector<int> m_columnFactors;
+  int m_rowLength = 0;
+  std::vector<int> m_padded;
+  // Cached rows, m_slotRow[slot] is the source row in each slot (or
+  // -1), and m_rowSlot[y] is the slot of each source row (or -1).
+  std::vector<int> m_slots;
+  std::vector<int> m_slotRow;
+  std::vector<int> m_rowSlot;
+  std::vector<uint64_t> m_slotUse;
+  uint64_t m_useCounter = 0;
+  std::vector<int> m_sums;
+};
+
 ConvolutionMatrixFilter::ConvolutionMatrixFilter() : m_matrix(NULL), m_tiledMode(TiledMode::NONE)
 {
 }
 
+ConvolutionMatrixFilter::~ConvolutionMatrixFilter() = default;
+
 void ConvolutionMatrixFilter::setMatrix(const std::shared_ptr<ConvolutionMatrix>& matrix)
 {
   m_matrix = matrix;
@@ -135,15 +461,74 @@ const char* ConvolutionMatrixFilter::getName()
   return "Convolution Matrix";
 }
 
+std::unique_ptr<Filter> ConvolutionMatrixFilter::createThreadCopy() const
+{
+  // Each thread needs its own cache of rows
+  auto copy = std::make_unique<ConvolutionMatrixFilter>();
+  copy->setMatrix(m_matrix);
+  copy->setTiledMode(m_tiledMode);
+  return copy;
+}
+
+bool ConvolutionMatrixFilter::useRows(const Image* src) const
+{
+  // get_neighboring_pixels() clamps the right side of matrices wider
+  // than a non-tiled image in a special way, so we use it in this
+  // case.
+  return (m_matrix->getWidth() <= src->width() ||
+          (int(m_tiledMode) & int(TiledMode::X_AXIS)));
+}
+
+ConvolutionRows& ConvolutionMatrixFilter::rows()
+{
+  if (!m_rows)
+    m_rows = std::make_unique<ConvolutionRows>();
+  return *m_rows;
+}
+
 void ConvolutionMatrixFilter::applyToRgba(FilterManager* filterMgr)
 {
   if (!m_matrix)
     return;
 
   const Image* src = filterMgr->getSourceImage();
-  uint32_t color;
   GetPixelsDelegateRgba delegate;
 
+  if (useRows(src)) {
+    ConvolutionRows& rows = this->rows();
+    rows.applyToRow<RgbTraits>(filterMgr,
+                               m_matrix.get(),
+                               m_tiledMode,
+                               5,
+                               [](const RgbTraits::pixel_t color, int* planes) {
+                                 const bool transparent = (rgba_geta(color) == 0);
+                                 planes[0] = (transparent ? 0 : rgba_getr(color));
+                                 planes[1] = (transparent ? 0 : rgba_getg(color));
+                                 planes[2] = (transparent ? 0 : rgba_getb(color));
+                                 planes[3] = rgba_geta(color);
+                                 planes[4] = (transparent ? 1 : 0);
+                               });
+
+    const int* r = rows.sums(0);
+    const int* g = rows.sums(1);
+    const int* b = rows.sums(2);
+    const int* a = rows.sums(3);
+    const int* transparent = rows.sums(4);
+
+    FILTER_LOOP_THROUGH_ROW_BEGIN(uint32_t)
+    {
+      const int i = x - filterMgr->x();
+      delegate.div = m_matrix->getDiv() - transparent[i];
+      delegate.r = r[i];
+      delegate.g = g[i];
+      delegate.b = b[i];
+      delegate.a = a[i];
+      *dst_address = filtered_rgba(delegate, *src_address, target, m_matrix.get());
+    }
+    FILTER_LOOP_THROUGH_ROW_END()
+    return;
+  }
+
   FILTER_LOOP_THROUGH_ROW_BEGIN(uint32_t)
   {
     delegate.reset(m_matrix.get());
@@ -157,41 +542,10 @@ void ConvolutionMatrixFilter::applyToRgba(FilterManager* filterMgr)
                                       m_tiledMode,
                                       delegate);
 
-    color = get_pixel_fast<RgbTraits>(src, x, y);
-    if (delegate.div == 0) {
-      *dst_address = color;
-      continue;
-    }
-
-    if (target & TARGET_RED_CHANNEL) {
-      delegate.r = delegate.r / delegate.div + m_matrix->getBias();
-      delegate.r = std::clamp(delegate.r, 0, 255);
-    }
-    else
-      delegate.r = rgba_getr(color);
-
-    if (target & TARGET_GREEN_CHANNEL) {
-      delegate.g = delegate.g / delegate.div + m_matrix->getBias();
-      delegate.g = std::clamp(delegate.g, 0, 255);
-    }
-    else
-      delegate.g = rgba_getg(color);
-
-    if (target & TARGET_BLUE_CHANNEL) {
-      delegate.b = delegate.b / delegate.div + m_matrix->getBias();
-      delegate.b = std::clamp(delegate.b, 0, 255);
-    }
-    else
-      delegate.b = rgba_getb(color);
-
-    if (target & TARGET_ALPHA_CHANNEL) {
-      delegate.a = delegate.a / m_matrix->getDiv() + m_matrix->getBias();
-      delegate.a = std::clamp(delegate.a, 0, 255);
-    }
-    else
-      delegate.a = rgba_geta(color);
-
-    *dst_address = rgba(delegate.r, delegate.g, delegate.b, delegate.a);
+    *dst_address = filtered_rgba(delegate,
+                                 get_pixel_fast<RgbTraits>(src, x, y),
+                                 target,
+                                 m_matrix.get());
   }
   FILTER_LOOP_THROUGH_ROW_END()
 }
@@ -202,9 +556,37 @@ void ConvolutionMatrixFilter::applyToGrayscale(FilterManager* filterMgr)
     return;
 
   const Image* src = filterMgr->getSourceImage();
-  uint16_t color;
   GetPixelsDelegateGrayscale delegate;
 
+  if (useRows(src)) {
+    ConvolutionRows& rows = this->rows();
+    rows.applyToRow<GrayscaleTraits>(filterMgr,
+                                     m_matrix.get(),
+                                     m_tiledMode,
+                                     3,
+                                     [](const GrayscaleTraits::pixel_t color, int* planes) {
+                                       const bool transparent = (graya_geta(color) == 0);
+                                       planes[0] = (transparent ? 0 : graya_getv(color));
+                                       planes[1] = graya_geta(color);
+                                       planes[2] = (transparent ? 1 : 0);
+                                     });
+
+    const int* v = rows.sums(0);
+    const int* a = rows.sums(1);
+    const int* transparent = rows.sums(2);
+
+    FILTER_LOOP_THROUGH_ROW_BEGIN(uint16_t)
+    {
+      const int i = x - filterMgr->x();
+      delegate.div = m_matrix->getDiv() - transparent[i];
+      delegate.v = v[i];
+      delegate.a = a[i];
+      *dst_address = filtered_grayscale(delegate, *src_address, target, m_matrix.get());
+    }
+    FILTER_LOOP_THROUGH_ROW_END()
+    return;
+  }
+
   FILTER_LOOP_THROUGH_ROW_BEGIN(uint16_t)
   {
     delegate.reset(m_matrix.get());
@@ -218,27 +600,10 @@ void ConvolutionMatrixFilter::applyToGrayscale(FilterManager* filterMgr)
                                             m_tiledMode,
                                             delegate);
 
-    color = get_pixel_fast<GrayscaleTraits>(src, x, y);
-    if (delegate.div == 0) {
-      *dst_address = color;
-      continue;
-    }
-
-    if (target & TARGET_GRAY_CHANNEL) {
-      delegate.v = delegate.v / delegate.div + m_matrix->getBias();
-      delegate.v = std::clamp(delegate.v, 0, 255);
-    }
-    else
-      delegate.v = graya_getv(color);
-
-    if (target & TARGET_ALPHA_CHANNEL) {
-      delegate.a = delegate.a / m_matrix->getDiv() + m_matrix->getBias();
-      delegate.a = std::clamp(delegate.a, 0, 255);
-    }
-    else
-      delegate.a = graya_geta(color);
-
-    *dst_address = graya(delegate.v, delegate.a);
+    *dst_address = filtered_grayscale(delegate,
+                                      get_pixel_fast<GrayscaleTraits>(src, x, y),
+                                      target,
+                                      m_matrix.get());
   }
   FILTER_LOOP_THROUGH_ROW_END()
 }
@@ -251,9 +616,47 @@ void ConvolutionMatrixFilter::applyToIndexed(FilterManager* filterMgr)
   const Image* src = filterMgr->getSourceImage();
   const Palette* pal = filterMgr->getIndexedData()->getPalette();
   const RgbMap* rgbmap = filterMgr->getIndexedData()->getRgbMap();
-  uint8_t color;
   GetPixelsDelegateIndexed delegate(pal);
 
+  if (useRows(src)) {
+    ConvolutionRows& rows = this->rows();
+    rows.applyToRow<IndexedTraits>(filterMgr,
+                                   m_matrix.get(),
+                                   m_tiledMode,
+                                   6,
+                                   [pal](const IndexedTraits::pixel_t index, int* planes) {
+                                     const color_t color = pal->getEntry(index);
+                                     const bool transparent = (rgba_geta(color) == 0);
+                                     planes[0] = (transparent ? 0 : rgba_getr(color));
+                                     planes[1] = (transparent ? 0 : rgba_getg(color));
+                                     planes[2] = (transparent ? 0 : rgba_getb(color));
+                                     planes[3] = rgba_geta(color);
+                                     planes[4] = (transparent ? 1 : 0);
+                                     planes[5] = index;
+                                   });
+
+    const int* r = rows.sums(0);
+    const int* g = rows.sums(1);
+    const int* b = rows.sums(2);
+    const int* a = rows.sums(3);
+    const int* transparent = rows.sums(4);
+    const int* index = rows.sums(5);
+
+    FILTER_LOOP_THROUGH_ROW_BEGIN(uint8_t)
+    {
+      const int i = x - filterMgr->x();
+      delegate.div = m_matrix->getDiv() - transparent[i];
+      delegate.r = r[i];
+      delegate.g = g[i];
+      delegate.b = b[i];
+      delegate.a = a[i];
+      delegate.index = index[i];
+      *dst_address = filtered_indexed(delegate, *src_address, target, m_matrix.get(), rgbmap);
+    }
+    FILTER_LOOP_THROUGH_ROW_END()
+    return;
+  }
+
   FILTER_LOOP_THROUGH_ROW_BEGIN(uint8_t)
   {
     delegate.reset(m_matrix.get());
@@ -267,51 +670,11 @@ void ConvolutionMatrixFilter::applyToIndexed(FilterManager* filterMgr)
                                           m_tiledMode,
                                           delegate);
 
-    color = get_pixel_fast<IndexedTraits>(src, x, y);
-    if (delegate.div == 0) {
-      *dst_address = color;
-      continue;
-    }
-
-    if (target & TARGET_INDEX_CHANNEL) {
-      delegate.index = delegate.index / m_matrix->getDiv() + m_matrix->getBias();
-      delegate.index = std::clamp(delegate.index, 0, 255);
-
-      *dst_address = delegate.index;
-    }
-    else {
-      color = pal->getEntry(color);
-
-      if (target & TARGET_RED_CHANNEL) {
-        delegate.r = delegate.r / delegate.div + m_matrix->getBias();
-        delegate.r = std::clamp(delegate.r, 0, 255);
-      }
-      else
-        delegate.r = rgba_getr(color);
-
-      if (target & TARGET_GREEN_CHANNEL) {
-        delegate.g = delegate.g / delegate.div + m_matrix->getBias();
-        delegate.g = std::clamp(delegate.g, 0, 255);
-      }
-      else
-        delegate.g = rgba_getg(color);
-
-      if (target & TARGET_BLUE_CHANNEL) {
-        delegate.b = delegate.b / delegate.div + m_matrix->getBias();
-        delegate.b = std::clamp(delegate.b, 0, 255);
-      }
-      else
-        delegate.b = rgba_getb(color);
-
-      if (target & TARGET_ALPHA_CHANNEL) {
-        delegate.a = delegate.a / delegate.div + m_matrix->getBias();
-        delegate.a = std::clamp(delegate.a, 0, 255);
-      }
-      else
-        delegate.a = rgba_geta(color);
-
-      *dst_address = rgbmap->mapColor(delegate.r, delegate.g, delegate.b, delegate.a);
-    }
+    *dst_address = filtered_indexed(delegate,
+                                    get_pixel_fast<IndexedTraits>(src, x, y),
+                                    target,
+                                    m_matrix.get(),
+                                    rgbmap);
   }
   FILTER_LOOP_THROUGH_ROW_END()
 }
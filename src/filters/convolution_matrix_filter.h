@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2016  David Capello
 //
 // This program is distributed under the terms of
@@ -14,13 +14,19 @@
 
 #include <memory>
 
+namespace doc {
+class Image;
+}
+
 namespace filters {
 
 class ConvolutionMatrix;
+class ConvolutionRows;
 
 class ConvolutionMatrixFilter : public Filter {
 public:
   ConvolutionMatrixFilter();
+  ~ConvolutionMatrixFilter();
 
   void setMatrix(const std::shared_ptr<ConvolutionMatrix>& matrix);
   void setTiledMode(TiledMode tiledMode);
@@ -33,10 +39,18 @@ public:
   void applyToRgba(FilterManager* filterMgr);
   void applyToGrayscale(FilterManager* filterMgr);
   void applyToIndexed(FilterManager* filterMgr);
+  std::unique_ptr<Filter> createThreadCopy() const;
 
 private:
+  // Returns true if the matrix can be applied to the given image with
+  // ConvolutionRows instead of visiting the neighboring pixels of
+  // each pixel.
+  bool useRows(const doc::Image* src) const;
+  ConvolutionRows& rows();
+
   std::shared_ptr<ConvolutionMatrix> m_matrix;
   TiledMode m_tiledMode;
+  std::unique_ptr<ConvolutionRows> m_rows;
 };
 
 } // namespace filters
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2015  David Capello
 //
 // This program is distributed under the terms of
@@ -9,6 +9,8 @@
 #define FILTERS_FILTER_H_INCLUDED
 #pragma once
 
+#include <memory>
+
 namespace doc {
 class PalettePicks;
 }
@@ -44,6 +46,19 @@ public:
 
   // Applies the filter to the color palette.
   virtual void applyToPalette(FilterManager* filterMgr) {}
+
+  // Returns a copy of the filter (with the same settings) to apply it
+  // to other rows from other thread at the same time. Filters that
+  // don't modify their own state in applyTo*() functions can return
+  // nullptr (the default) so the same instance is used in all
+  // threads.
+  virtual std::unique_ptr<Filter> createThreadCopy() const { return nullptr; }
+
+  // Returns true if the new color of each pixel depends only on its
+  // original color (and not on its position or neighbors). In this
+  // case the filter can be applied once to each different color of
+  // an RGB image, and then the pixels are replaced with the results.
+  virtual bool isPointwise() const { return false; }
 };
 
 // Filter that support applying it only to palette colors.
@@ -52,6 +67,10 @@ public:
   FilterWithPalette();
   void applyToPalette(FilterManager* filterMgr) override;
 
+  // Returns true if the filter was applied to the selected palette
+  // entries and RGB images must use the new palette colors.
+  bool usePaletteOnRGB() const { return m_usePaletteOnRGB; }
+
 protected:
   virtual void onApplyToPalette(FilterManager* filterMgr, const doc::PalettePicks& picks) = 0;
 
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2017-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -44,26 +44,37 @@ HueSaturationFilter::HueSaturationFilter()
 void HueSaturationFilter::setMode(Mode mode)
 {
   m_mode = mode;
+  m_cache.clear();
 }
 
 void HueSaturationFilter::setHue(double h)
 {
   m_h = h;
+  m_cache.clear();
 }
 
 void HueSaturationFilter::setSaturation(double s)
 {
   m_s = s;
+  m_cache.clear();
 }
 
 void HueSaturationFilter::setLightness(double l)
 {
   m_l = l;
+  m_cache.clear();
 }
 
 void HueSaturationFilter::setAlpha(double a)
 {
   m_a = a;
+  m_cache.clear();
+}
+
+std::unique_ptr<Filter> HueSaturationFilter::createThreadCopy() const
+{
+  // Each thread needs its own cache of colors
+  return std::make_unique<HueSaturationFilter>(*this);
 }
 
 void HueSaturationFilter::applyToRgba(FilterManager* filterMgr)
@@ -72,20 +83,21 @@ void HueSaturationFilter::applyToRgba(FilterManager* filterMgr)
   const Palette* pal = fid->getPalette();
   Palette* newPal = (m_usePaletteOnRGB ? fid->getNewPalette() : nullptr);
 
+  m_cache.update(filterMgr->getTarget(), pal, newPal);
+
   FILTER_LOOP_THROUGH_ROW_BEGIN(uint32_t)
   {
-    color_t c = *src_address;
-
-    if (newPal) {
-      int i = pal->findExactMatch(rgba_getr(c), rgba_getg(c), rgba_getb(c), rgba_geta(c), -1);
-      if (i >= 0)
-        c = newPal->getEntry(i);
-    }
-    else {
-      applyFilterToRgb(target, c);
-    }
-
-    *dst_address = c;
+    *dst_address = m_cache.get(*src_address, [this, target, pal, newPal](color_t c) {
+      if (newPal) {
+        int i = pal->findExactMatch(rgba_getr(c), rgba_getg(c), rgba_getb(c), rgba_geta(c), -1);
+        if (i >= 0)
+          c = newPal->getEntry(i);
+      }
+      else {
+        applyFilterToRgb(target, c);
+      }
+      return c;
+    });
   }
   FILTER_LOOP_THROUGH_ROW_END()
 }
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2017-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -10,6 +10,7 @@
 #pragma once
 
 #include "doc/color.h"
+#include "filters/color_cache.h"
 #include "filters/filter.h"
 #include "filters/target.h"
 
@@ -26,6 +27,12 @@ public:
 
   HueSaturationFilter();
 
+  Mode mode() const { return m_mode; }
+  double hue() const { return m_h; }
+  double saturation() const { return m_s; }
+  double lightness() const { return m_l; }
+  double alpha() const { return m_a; }
+
   void setMode(Mode mode);
   void setHue(double h);
   void setSaturation(double s);
@@ -37,6 +44,8 @@ public:
   void applyToRgba(FilterManager* filterMgr) override;
   void applyToGrayscale(FilterManager* filterMgr) override;
   void applyToIndexed(FilterManager* filterMgr) override;
+  std::unique_ptr<Filter> createThreadCopy() const override;
+  bool isPointwise() const override { return true; }
 
 private:
   void onApplyToPalette(FilterManager* filterMgr, const doc::PalettePicks& picks) override;
@@ -47,6 +56,7 @@ private:
 
   Mode m_mode;
   double m_h, m_s, m_l, m_a;
+  ColorCache m_cache;
 };
 
 } // namespace filters
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2020  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2001-2017  David Capello
 //
 // This program is distributed under the terms of
@@ -95,6 +95,227 @@ struct GetPixelsDelegateIndexed {
 };
 }; // namespace
 
+// Minimum number of pixels in the window to use MedianHistograms
+// (for smaller windows sorting the neighboring pixels is faster).
+static const int kMinHistogramsWindow = 25;
+
+// Calculates the median of each pixel in constant time (independent
+// of the window size) as described in S. Perreault and P. Hebert,
+// "Median Filtering in Constant Time", IEEE Transactions on Image
+// Processing, 16(9), pp. 2389-2394 (2007).
+//
+// It keeps a 256-bins histogram of each channel for each column of
+// the image (with the pixels of the "height" rows of the current
+// window), and a histogram of the whole window that is moved through
+// the row adding and removing column histograms. Each histogram has
+// a second level of 16 bins to find the median faster.
+class MedianHistograms {
+public:
+  typedef uint16_t count_t;
+  enum { kBins = 256, kCoarseBins = 16, kMaxChannels = 4 };
+
+  // Maximum number of pixels in the window (so the counters don't
+  // overflow).
+  static constexpr int kMaxWindow = 0xffff;
+
+  // Applies the median filter to the current row of the filterMgr,
+  // "getChannels(pixel, channels)" must fill the channels of a pixel
+  // and "makePixel(pixel, medians)" must return the filtered pixel
+  // (only the active channels have a median).
+  template<typename Traits, typename GetChannels, typename MakePixel>
+  void applyToRow(FilterManager* filterMgr,
+                  const int width,
+                  const int height,
+                  const TiledMode tiledMode,
+                  const int nchannels,
+                  const bool* active,
+                  GetChannels getChannels,
+                  MakePixel makePixel)
+  {
+    const Image* src = filterMgr->getSourceImage();
+    const int row = filterMgr->y();
+
+    // Rows are filtered from top to bottom, so we can reuse the
+    // column histograms of the previous row.
+    if (filterMgr->isFirstRow() || src != m_image || row != m_y + 1 || width != m_width ||
+        height != m_height || tiledMode != m_tiledMode || nchannels != m_nchannels ||
+        !std::equal(active, active + nchannels, m_active)) {
+      m_image = src;
+      m_width = width;
+      m_height = height;
+      m_tiledMode = tiledMode;
+      m_nchannels = nchannels;
+      std::copy(active, active + nchannels, m_active);
+      buildColumns<Traits>(row, getChannels);
+    }
+    else {
+      moveColumns<Traits>(row, getChannels);
+    }
+    m_y = row;
+    m_windowX = -1;
+
+    uint8_t medians[kMaxChannels] = { 0, 0, 0, 0 };
+
+    auto src_address = (const typename Traits::pixel_t*)filterMgr->getSourceAddress();
+    auto dst_address = (typename Traits::pixel_t*)filterMgr->getDestinationAddress();
+    const int x2 = filterMgr->x() + filterMgr->getWidth();
+    auto& token = filterMgr->taskToken();
+    for (int x = filterMgr->x(); x < x2 && !token.canceled(); ++x, ++src_address, ++dst_address) {
+      if (filterMgr->skipPixel())
+        continue;
+
+      moveWindow(x);
+
+      for (int ch = 0; ch < nchannels; ++ch)
+        if (m_active[ch])
+          medians[ch] = median(ch);
+
+      *dst_address = makePixel(*src_address, medians);
+    }
+  }
+
+private:
+  count_t* column(const int ch, const int x)
+  {
+    return &m_columns[(std::size_t(ch) * m_image->width() + x) * kBins];
+  }
+
+  count_t* coarseColumn(const int ch, const int x)
+  {
+    return &m_coarseColumns[(std::size_t(ch) * m_image->width() + x) * kCoarseBins];
+  }
+
+  // Adds (or removes if delta=-1) the pixels of the given row to the
+  // column histograms.
+  template<typename Traits, typename GetChannels>
+  void addRow(const int y, const int delta, GetChannels& getChannels)
+  {
+    const int w = m_image->width();
+    auto address = (typename Traits::const_address_t)m_image->getPixelAddress(0, y);
+    uint8_t channels[kMaxChannels];
+
+    for (int x = 0; x < w; ++x, ++address) {
+      getChannels(*address, channels);
+      for (int ch = 0; ch < m_nchannels; ++ch) {
+        if (m_active[ch]) {
+          column(ch, x)[channels[ch]] += delta;
+          coarseColumn(ch, x)[channels[ch] >> 4] += delta;
+        }
+      }
+    }
+  }
+
+  template<typename Traits, typename GetChannels>
+  void buildColumns(const int row, GetChannels& getChannels)
+  {
+    const int w = m_image->width();
+    m_columns.assign(std::size_t(m_nchannels) * w * kBins, 0);
+    m_coarseColumns.assign(std::size_t(m_nchannels) * w * kCoarseBins, 0);
+
+    const int cy = m_height / 2;
+    const bool tiledY = (int(m_tiledMode) & int(TiledMode::Y_AXIS));
+    for (int dy = 0; dy < m_height; ++dy)
+      addRow<Traits>(get_neighboring_coord(row - cy + dy, m_image->height(), tiledY),
+                     +1,
+                     getChannels);
+  }
+
+  // Moves the column histograms one row down
+  template<typename Traits, typename GetChannels>
+  void moveColumns(const int row, GetChannels& getChannels)
+  {
+    const int cy = m_height / 2;
+    const int h = m_image->height();
+    const bool tiledY = (int(m_tiledMode) & int(TiledMode::Y_AXIS));
+    const int oldY = get_neighboring_coord(row - cy - 1, h, tiledY);
+    const int newY = get_neighboring_coord(row - cy + m_height - 1, h, tiledY);
+    if (oldY != newY) {
+      addRow<Traits>(oldY, -1, getChannels);
+      addRow<Traits>(newY, +1, getChannels);
+    }
+  }
+
+  void addColumnToWindow(const int x, const int delta)
+  {
+    for (int ch = 0; ch < m_nchannels; ++ch) {
+      if (!m_active[ch])
+        continue;
+
+      count_t* dst = &m_window[ch * kBins];
+      const count_t* src = column(ch, x);
+      count_t* coarseDst = &m_coarseWindow[ch * kCoarseBins];
+      const count_t* coarseSrc = coarseColumn(ch, x);
+
+      if (delta > 0) {
+        for (int i = 0; i < kBins; ++i)
+          dst[i] += src[i];
+        for (int i = 0; i < kCoarseBins; ++i)
+          coarseDst[i] += coarseSrc[i];
+      }
+      else {
+        for (int i = 0; i < kBins; ++i)
+          dst[i] -= src[i];
+        for (int i = 0; i < kCoarseBins; ++i)
+          coarseDst[i] -= coarseSrc[i];
+      }
+    }
+  }
+
+  // Moves the window histograms to the given column of the row
+  // (some pixels can be skipped because they aren't selected).
+  void moveWindow(const int x)
+  {
+    const int cx = m_width / 2;
+    const int w = m_image->width();
+    const bool tiledX = (int(m_tiledMode) & int(TiledMode::X_AXIS));
+
+    if (m_windowX >= 0 && x > m_windowX && x - m_windowX < m_width) {
+      for (int wx = m_windowX + 1; wx <= x; ++wx) {
+        addColumnToWindow(get_neighboring_coord(wx - cx - 1, w, tiledX), -1);
+        addColumnToWindow(get_neighboring_coord(wx - cx + m_width - 1, w, tiledX), +1);
+      }
+    }
+    else {
+      std::fill(std::begin(m_window), std::end(m_window), 0);
+      std::fill(std::begin(m_coarseWindow), std::end(m_coarseWindow), 0);
+      for (int dx = 0; dx < m_width; ++dx)
+        addColumnToWindow(get_neighboring_coord(x - cx + dx, w, tiledX), +1);
+    }
+    m_windowX = x;
+  }
+
+  // Returns the value in the middle of the sorted pixels of the
+  // window (the same value we get sorting the neighboring pixels).
+  int median(const int ch) const
+  {
+    int rank = m_width * m_height / 2;
+
+    const count_t* coarse = &m_coarseWindow[ch * kCoarseBins];
+    int i = 0;
+    for (; i < kCoarseBins - 1 && rank >= coarse[i]; ++i)
+      rank -= coarse[i];
+
+    const count_t* fine = &m_window[ch * kBins];
+    int v = i << 4;
+    for (; v < kBins - 1 && rank >= fine[v]; ++v)
+      rank -= fine[v];
+    return v;
+  }
+
+  const Image* m_image = nullptr;
+  int m_y = 0;
+  int m_windowX = -1;
+  int m_width = 0;
+  int m_height = 0;
+  TiledMode m_tiledMode = TiledMode::NONE;
+  int m_nchannels = 0;
+  bool m_active[kMaxChannels] = { false, false, false, false };
+  std::vector<count_t> m_columns;
+  std::vector<count_t> m_coarseColumns;
+  count_t m_window[kMaxChannels * kBins];
+  count_t m_coarseWindow[kMaxChannels * kCoarseBins];
+};
+
 MedianFilter::MedianFilter()
   : m_tiledMode(TiledMode::NONE)
   , m_width(1)
@@ -104,6 +325,8 @@ MedianFilter::MedianFilter()
 {
 }
 
+MedianFilter::~MedianFilter() = default;
+
 void MedianFilter::setTiledMode(TiledMode tiled)
 {
   m_tiledMode = tiled;
@@ -127,9 +350,61 @@ const char* MedianFilter::getName()
   return "Median Blur";
 }
 
+bool MedianFilter::useHistograms(const Image* src) const
+{
+  return (m_ncolors >= kMinHistogramsWindow && m_ncolors <= MedianHistograms::kMaxWindow &&
+          // get_neighboring_pixels() clamps the right side of wider
+          // windows in a special way, so we use it in this case.
+          (m_width <= src->width() || (int(m_tiledMode) & int(TiledMode::X_AXIS))));
+}
+
+std::unique_ptr<Filter> MedianFilter::createThreadCopy() const
+{
+  // Each thread needs its own buffers and histograms
+  auto copy = std::make_unique<MedianFilter>();
+  copy->setTiledMode(m_tiledMode);
+  copy->setSize(m_width, m_height);
+  return copy;
+}
+
+MedianHistograms& MedianFilter::histograms()
+{
+  if (!m_histograms)
+    m_histograms = std::make_unique<MedianHistograms>();
+  return *m_histograms;
+}
+
 void MedianFilter::applyToRgba(FilterManager* filterMgr)
 {
   const Image* src = filterMgr->getSourceImage();
+  if (useHistograms(src)) {
+    const Target target = filterMgr->getTarget();
+    const bool active[4] = { (target & TARGET_RED_CHANNEL) != 0,
+                             (target & TARGET_GREEN_CHANNEL) != 0,
+                             (target & TARGET_BLUE_CHANNEL) != 0,
+                             (target & TARGET_ALPHA_CHANNEL) != 0 };
+    histograms().applyToRow<RgbTraits>(
+      filterMgr,
+      m_width,
+      m_height,
+      m_tiledMode,
+      4,
+      active,
+      [](const color_t color, uint8_t* channels) {
+        channels[0] = rgba_getr(color);
+        channels[1] = rgba_getg(color);
+        channels[2] = rgba_getb(color);
+        channels[3] = rgba_geta(color);
+      },
+      [&active](const color_t color, const uint8_t* medians) {
+        return rgba(active[0] ? medians[0] : rgba_getr(color),
+                    active[1] ? medians[1] : rgba_getg(color),
+                    active[2] ? medians[2] : rgba_getb(color),
+                    active[3] ? medians[3] : rgba_geta(color));
+      });
+    return;
+  }
+
   int color, r, g, b, a;
   GetPixelsDelegateRgba delegate(m_channel);
 
@@ -184,6 +459,28 @@ void MedianFilter::applyToRgba(FilterManager* filterMgr)
 void MedianFilter::applyToGrayscale(FilterManager* filterMgr)
 {
   const Image* src = filterMgr->getSourceImage();
+  if (useHistograms(src)) {
+    const Target target = filterMgr->getTarget();
+    const bool active[2] = { (target & TARGET_GRAY_CHANNEL) != 0,
+                             (target & TARGET_ALPHA_CHANNEL) != 0 };
+    histograms().applyToRow<GrayscaleTraits>(
+      filterMgr,
+      m_width,
+      m_height,
+      m_tiledMode,
+      2,
+      active,
+      [](const color_t color, uint8_t* channels) {
+        channels[0] = graya_getv(color);
+        channels[1] = graya_geta(color);
+      },
+      [&active](const color_t color, const uint8_t* medians) {
+        return graya(active[0] ? medians[0] : graya_getv(color),
+                     active[1] ? medians[1] : graya_geta(color));
+      });
+    return;
+  }
+
   int color, k, a;
   GetPixelsDelegateGrayscale delegate(m_channel);
 
@@ -226,6 +523,51 @@ void MedianFilter::applyToIndexed(FilterManager* filterMgr)
   const Image* src = filterMgr->getSourceImage();
   const Palette* pal = filterMgr->getIndexedData()->getPalette();
   const RgbMap* rgbmap = filterMgr->getIndexedData()->getRgbMap();
+
+  if (useHistograms(src)) {
+    const Target target = filterMgr->getTarget();
+    if (target & TARGET_INDEX_CHANNEL) {
+      const bool active[1] = { true };
+      histograms().applyToRow<IndexedTraits>(
+        filterMgr,
+        m_width,
+        m_height,
+        m_tiledMode,
+        1,
+        active,
+        [](const color_t index, uint8_t* channels) { channels[0] = index; },
+        [](const color_t, const uint8_t* medians) { return medians[0]; });
+    }
+    else {
+      const bool active[4] = { (target & TARGET_RED_CHANNEL) != 0,
+                               (target & TARGET_GREEN_CHANNEL) != 0,
+                               (target & TARGET_BLUE_CHANNEL) != 0,
+                               (target & TARGET_ALPHA_CHANNEL) != 0 };
+      histograms().applyToRow<IndexedTraits>(
+        filterMgr,
+        m_width,
+        m_height,
+        m_tiledMode,
+        4,
+        active,
+        [pal](const color_t index, uint8_t* channels) {
+          const color_t color = pal->getEntry(index);
+          channels[0] = rgba_getr(color);
+          channels[1] = rgba_getg(color);
+          channels[2] = rgba_getb(color);
+          channels[3] = rgba_geta(color);
+        },
+        [pal, rgbmap, &active](const color_t index, const uint8_t* medians) {
+          const color_t color = pal->getEntry(index);
+          return uint8_t(rgbmap->mapColor(active[0] ? medians[0] : rgba_getr(color),
+                                          active[1] ? medians[1] : rgba_getg(color),
+                                          active[2] ? medians[2] : rgba_getb(color),
+                                          active[3] ? medians[3] : rgba_geta(color)));
+        });
+    }
+    return;
+  }
+
   int color, r, g, b, a;
   GetPixelsDelegateIndexed delegate(pal, m_channel, filterMgr->getTarget());
 
@@ -1,4 +1,5 @@
 // Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
 // Copyright (C) 2001-2016  David Capello
 //
 // This program is distributed under the terms of
@@ -12,13 +13,21 @@
 #include "filters/filter.h"
 #include "filters/tiled_mode.h"
 
+#include <memory>
 #include <vector>
 
+namespace doc {
+class Image;
+}
+
 namespace filters {
 
+class MedianHistograms;
+
 class MedianFilter : public Filter {
 public:
   MedianFilter();
+  ~MedianFilter();
 
   void setTiledMode(TiledMode tiled);
   void setSize(int width, int height);
@@ -32,13 +41,21 @@ public:
   void applyToRgba(FilterManager* filterMgr);
   void applyToGrayscale(FilterManager* filterMgr);
   void applyToIndexed(FilterManager* filterMgr);
+  std::unique_ptr<Filter> createThreadCopy() const;
 
 private:
+  // Returns true if the median of each pixel of the given image can
+  // be calculated with MedianHistograms instead of sorting the
+  // neighboring pixels.
+  bool useHistograms(const doc::Image* src) const;
+  MedianHistograms& histograms();
+
   TiledMode m_tiledMode;
   int m_width;
   int m_height;
   int m_ncolors;
   std::vector<std::vector<uint8_t>> m_channel;
+  std::unique_ptr<MedianHistograms> m_histograms;
 };
 
 } // namespace filters
@@ -1,4 +1,5 @@
 // Aseprite
+// Copyright (C) 2026  Igara Studio S.A.
 // Copyright (C) 2001-2015  David Capello
 //
 // This program is distributed under the terms of
@@ -12,11 +13,23 @@
 #include "doc/image_traits.h"
 #include "filters/tiled_mode.h"
 
+#include <algorithm>
 #include <vector>
 
 namespace filters {
 using namespace doc;
 
+// Returns the coordinate of the image that is used by
+// get_neighboring_pixels() for the given "c" coordinate (which can be
+// outside the image). It's the same logic of get_neighboring_pixels()
+// except for matrices wider than a non-tiled image.
+inline int get_neighboring_coord(const int c, const int size, const bool tiled)
+{
+  if (tiled)
+    return ((c % size) + size) % size;
+  return std::clamp(c, 0, size - 1);
+}
+
 // Calls the specified "delegate" for all neighboring pixels in a 2D
 // (width*height) matrix located in (x,y) where its center is the
 // (centerX,centerY) element of the matrix.
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -18,6 +18,7 @@
 #include "filters/neighboring_pixels.h"
 
 #include <algorithm>
+#include <limits>
 
 namespace filters {
 
@@ -83,14 +84,175 @@ struct GetPixelsDelegateIndexed : public GetPixelsDelegate {
   }
 };
 
+// Calculates the distance from each element of a sequence of "n"
+// elements (separated by "stride") to the nearest zero element. The
+// elements must be 0 or "maxDist" (distances are limited to it).
+void distance_1d(int* dist, const int n, const int stride, const int maxDist)
+{
+  int d = maxDist;
+  for (int i = 0; i < n; ++i, dist += stride) {
+    d = (*dist == 0 ? 0 : std::min(d + 1, maxDist));
+    *dist = d;
+  }
+  d = maxDist;
+  for (int i = 0; i < n; ++i) {
+    dist -= stride;
+    d = (*dist == 0 ? 0 : std::min(d + 1, maxDist));
+    *dist = std::min(*dist, d);
+  }
+}
+
+// Squared euclidean distance transform of one dimension using the
+// lower envelope of parabolas from "Distance Transforms of Sampled
+// Functions" (Felzenszwalb & Huttenlocher), it's linear in the
+// number of elements of "f".
+void squared_distance_1d(const std::vector<double>& f,
+                         std::vector<double>& d,
+                         std::vector<int>& v,
+                         std::vector<double>& z)
+{
+  const double inf = std::numeric_limits<double>::infinity();
+  const int n = int(f.size());
+  int k = 0;
+  v[0] = 0;
+  z[0] = -inf;
+  z[1] = inf;
+  for (int q = 1; q < n; ++q) {
+    double s;
+    for (;;) {
+      const int p = v[k];
+      s = ((f[q] + double(q) * q) - (f[p] + double(p) * p)) / (2.0 * (q - p));
+      if (s > z[k])
+        break;
+      --k;
+    }
+    ++k;
+    v[k] = q;
+    z[k] = s;
+    z[k + 1] = inf;
+  }
+  k = 0;
+  for (int q = 0; q < n; ++q) {
+    while (z[k + 1] < q)
+      ++k;
+    d[q] = double(q - v[k]) * (q - v[k]) + f[v[k]];
+  }
+}
+
+// Marks in "nearPixels" the pixels of "src" which are at a distance
+// less or equal than "thickness" from a pixel where isFeature() is
+// true. The distance is measured depending on the outline matrix.
+// Pixels outside the image are not features (the 3x3 matrix repeats
+// the pixels of the edges, which are nearer anyway) except in tiled
+// mode.
+template<typename Traits, typename IsFeature>
+void calc_near_pixels(const Image* src,
+                      const OutlineFilter::Matrix matrix,
+                      const int thickness,
+                      const TiledMode tiledMode,
+                      IsFeature isFeature,
+                      std::vector<uint8_t>& nearPixels)
+{
+  const bool tiledX = (int(tiledMode) & int(TiledMode::X_AXIS));
+  const bool tiledY = (int(tiledMode) & int(TiledMode::Y_AXIS));
+  const int w = src->width();
+  const int h = src->height();
+  const int padX = (tiledX ? thickness : 0);
+  const int padY = (tiledY ? thickness : 0);
+  const int dw = w + 2 * padX;
+  const int dh = h + 2 * padY;
+  const int maxDist = thickness + 1;
+
+  std::vector<int> dist(std::size_t(dw) * dh);
+  for (int y = 0; y < dh; ++y) {
+    auto srcAddress = reinterpret_cast<typename Traits::const_address_t>(
+      src->getPixelAddress(0, get_neighboring_coord(y - padY, h, tiledY)));
+    int* row = &dist[std::size_t(y) * dw];
+    for (int x = 0; x < dw; ++x)
+      row[x] = (isFeature(srcAddress[get_neighboring_coord(x - padX, w, tiledX)]) ? 0 : maxDist);
+  }
+
+  nearPixels.resize(std::size_t(w) * h);
+  auto nearIt = nearPixels.begin();
+
+  switch (matrix) {
+    case OutlineFilter::Matrix::Horizontal:
+    case OutlineFilter::Matrix::Vertical: {
+      if (matrix == OutlineFilter::Matrix::Horizontal) {
+        for (int y = 0; y < dh; ++y)
+          distance_1d(&dist[std::size_t(y) * dw], dw, 1, maxDist);
+      }
+      else {
+        for (int x = 0; x < dw; ++x)
+          distance_1d(&dist[x], dh, dw, maxDist);
+      }
+      for (int y = 0; y < h; ++y) {
+        const int* row = &dist[std::size_t(y + padY) * dw + padX];
+        for (int x = 0; x < w; ++x, ++nearIt)
+          *nearIt = (row[x] <= thickness);
+      }
+      break;
+    }
+
+    // Chebyshev distance: a pixel is near if there is a row (in the
+    // "thickness" rows above/below) with a feature at a horizontal
+    // distance less or equal than "thickness"
+    case OutlineFilter::Matrix::Square: {
+      for (int y = 0; y < dh; ++y)
+        distance_1d(&dist[std::size_t(y) * dw], dw, 1, maxDist);
+
+      std::vector<int> rows(dh + 1);
+      for (int x = 0; x < w; ++x) {
+        rows[0] = 0;
+        for (int y = 0; y < dh; ++y)
+          rows[y + 1] = rows[y] + (dist[std::size_t(y) * dw + x + padX] <= thickness ? 1 : 0);
+
+        for (int y = 0; y < h; ++y) {
+          const int y1 = std::max(0, y + padY - thickness);
+          const int y2 = std::min(dh, y + padY + thickness + 1);
+          nearPixels[std::size_t(y) * w + x] = (rows[y2] - rows[y1] > 0);
+        }
+      }
+      break;
+    }
+
+    // Euclidean distance: squared distance transform of each column
+    // using the squared horizontal distances
+    case OutlineFilter::Matrix::Circle: {
+      for (int y = 0; y < dh; ++y)
+        distance_1d(&dist[std::size_t(y) * dw], dw, 1, maxDist);
+
+      std::vector<double> f(dh), d(dh), z(dh + 1);
+      std::vector<int> v(dh);
+      const double maxSquaredDist = double(thickness) * thickness;
+      for (int x = 0; x < w; ++x) {
+        for (int y = 0; y < dh; ++y) {
+          const double dx = dist[std::size_t(y) * dw + x + padX];
+          f[y] = dx * dx;
+        }
+        squared_distance_1d(f, d, v, z);
+
+        for (int y = 0; y < h; ++y)
+          nearPixels[std::size_t(y) * w + x] = (d[y + padY] <= maxSquaredDist);
+      }
+      break;
+    }
+
+    default: ASSERT(false); break;
+  }
+}
+
 } // namespace
 
 OutlineFilter::OutlineFilter()
   : m_place(Place::Outside)
   , m_matrix(Matrix::Circle)
+  , m_thickness(1)
   , m_tiledMode(TiledMode::NONE)
   , m_color(0)
   , m_bgColor(0)
+  , m_nearImage(nullptr)
+  , m_nearFirstY(0)
 {
 }
 
@@ -99,6 +261,57 @@ const char* OutlineFilter::getName()
   return "Outline";
 }
 
+std::unique_ptr<Filter> OutlineFilter::createThreadCopy() const
+{
+  if (!useDistances())
+    return nullptr;
+
+  // Each thread calculates its own distances
+  auto copy = std::make_unique<OutlineFilter>(*this);
+  copy->m_nearPixels.clear();
+  copy->m_nearImage = nullptr;
+  return copy;
+}
+
+bool OutlineFilter::useDistances() const
+{
+  return (m_thickness > 1 &&
+          (m_matrix == Matrix::Circle || m_matrix == Matrix::Square ||
+           m_matrix == Matrix::Horizontal || m_matrix == Matrix::Vertical));
+}
+
+template<typename Traits, typename IsTransparent>
+void OutlineFilter::updateNearPixels(FilterManager* filterMgr, IsTransparent isTransparent)
+{
+  const Image* src = filterMgr->getSourceImage();
+  const int y = filterMgr->y();
+
+  // We have to calculate the distances again if the source image is
+  // different, or when we start filtering the image again from the
+  // first row (the same Image pointer could be used for a different
+  // image). Rows filtered from other threads start from other rows
+  // (isFirstRow() is true in each group of rows), but they don't
+  // start before the first row that we've already used.
+  if (src == m_nearImage && !(filterMgr->isFirstRow() && y <= m_nearFirstY))
+    return;
+
+  const bool outside = (m_place == Place::Outside);
+  calc_near_pixels<Traits>(
+    src,
+    m_matrix,
+    m_thickness,
+    m_tiledMode,
+    [outside, &isTransparent](const typename Traits::pixel_t color) {
+      // Opaque pixels generate the outside outline, and transparent
+      // pixels the inside one
+      return (isTransparent(color) != outside);
+    },
+    m_nearPixels);
+
+  m_nearImage = src;
+  m_nearFirstY = y;
+}
+
 void OutlineFilter::applyToRgba(FilterManager* filterMgr)
 {
   const Image* src = filterMgr->getSourceImage();
@@ -109,13 +322,25 @@ void OutlineFilter::applyToRgba(FilterManager* filterMgr)
   GetPixelsDelegateRgba delegate;
   delegate.init(m_bgColor, m_matrix);
 
+  const bool distances = useDistances();
+  if (distances) {
+    updateNearPixels<RgbTraits>(filterMgr, [this](const color_t c) {
+      return (rgba_geta(c) == 0 || c == m_bgColor);
+    });
+  }
+
   FILTER_LOOP_THROUGH_ROW_BEGIN(uint32_t)
   {
-    delegate.reset();
-    get_neighboring_pixels<RgbTraits>(src, x, y, 3, 3, 1, 1, m_tiledMode, delegate);
+    if (distances) {
+      n = m_nearPixels[std::size_t(y) * src->width() + x];
+    }
+    else {
+      delegate.reset();
+      get_neighboring_pixels<RgbTraits>(src, x, y, 3, 3, 1, 1, m_tiledMode, delegate);
+      n = (m_place == Place::Outside ? delegate.opaque : delegate.transparent);
+    }
 
     c = *src_address;
-    n = (m_place == Place::Outside ? delegate.opaque : delegate.transparent);
     isTransparent = (rgba_geta(c) == 0 || c == m_bgColor);
 
     if ((n >= 1) && ((m_place == Place::Outside && isTransparent) ||
@@ -142,13 +367,25 @@ void OutlineFilter::applyToGrayscale(FilterManager* filterMgr)
   GetPixelsDelegateGrayscale delegate;
   delegate.init(m_bgColor, m_matrix);
 
+  const bool distances = useDistances();
+  if (distances) {
+    updateNearPixels<GrayscaleTraits>(filterMgr, [this](const color_t c) {
+      return (graya_geta(c) == 0 || c == m_bgColor);
+    });
+  }
+
   FILTER_LOOP_THROUGH_ROW_BEGIN(uint16_t)
   {
-    delegate.reset();
-    get_neighboring_pixels<GrayscaleTraits>(src, x, y, 3, 3, 1, 1, m_tiledMode, delegate);
+    if (distances) {
+      n = m_nearPixels[std::size_t(y) * src->width() + x];
+    }
+    else {
+      delegate.reset();
+      get_neighboring_pixels<GrayscaleTraits>(src, x, y, 3, 3, 1, 1, m_tiledMode, delegate);
+      n = (m_place == Place::Outside ? delegate.opaque : delegate.transparent);
+    }
 
     c = *src_address;
-    n = (m_place == Place::Outside ? delegate.opaque : delegate.transparent);
     isTransparent = (graya_geta(c) == 0 || c == m_bgColor);
 
     if ((n >= 1) && ((m_place == Place::Outside && isTransparent) ||
@@ -175,13 +412,25 @@ void OutlineFilter::applyToIndexed(FilterManager* filterMgr)
   GetPixelsDelegateIndexed delegate(pal);
   delegate.init(m_bgColor, m_matrix);
 
+  const bool distances = useDistances();
+  if (distances) {
+    updateNearPixels<IndexedTraits>(filterMgr, [this, pal](const color_t c) {
+      return (rgba_geta(pal->getEntry(c)) == 0 || c == m_bgColor);
+    });
+  }
+
   FILTER_LOOP_THROUGH_ROW_BEGIN(uint8_t)
   {
-    delegate.reset();
-    get_neighboring_pixels<IndexedTraits>(src, x, y, 3, 3, 1, 1, m_tiledMode, delegate);
+    if (distances) {
+      n = m_nearPixels[std::size_t(y) * src->width() + x];
+    }
+    else {
+      delegate.reset();
+      get_neighboring_pixels<IndexedTraits>(src, x, y, 3, 3, 1, 1, m_tiledMode, delegate);
+      n = (m_place == Place::Outside ? delegate.opaque : delegate.transparent);
+    }
 
     c = *src_address;
-    n = (m_place == Place::Outside ? delegate.opaque : delegate.transparent);
 
     if (target & TARGET_INDEX_CHANNEL) {
       isTransparent = (c == m_bgColor);
@@ -1,5 +1,5 @@
 // Aseprite
-// Copyright (C) 2019  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 //
 // This program is distributed under the terms of
 // the End-User License Agreement for Aseprite.
@@ -12,6 +12,13 @@
 #include "filters/filter.h"
 #include "filters/tiled_mode.h"
 
+#include <cstdint>
+#include <vector>
+
+namespace doc {
+class Image;
+}
+
 namespace filters {
 
 class OutlineFilter : public Filter {
@@ -27,14 +34,36 @@ public:
 
   OutlineFilter();
 
-  void place(const Place place) { m_place = place; }
-  void matrix(const Matrix matrix) { m_matrix = matrix; }
-  void tiledMode(const TiledMode tiledMode) { m_tiledMode = tiledMode; }
+  void place(const Place place)
+  {
+    m_place = place;
+    m_nearImage = nullptr;
+  }
+  void matrix(const Matrix matrix)
+  {
+    m_matrix = matrix;
+    m_nearImage = nullptr;
+  }
+  void thickness(const int thickness)
+  {
+    m_thickness = thickness;
+    m_nearImage = nullptr;
+  }
+  void tiledMode(const TiledMode tiledMode)
+  {
+    m_tiledMode = tiledMode;
+    m_nearImage = nullptr;
+  }
   void color(const doc::color_t color) { m_color = color; }
-  void bgColor(const doc::color_t color) { m_bgColor = color; }
+  void bgColor(const doc::color_t color)
+  {
+    m_bgColor = color;
+    m_nearImage = nullptr;
+  }
 
   Place place() const { return m_place; }
   Matrix matrix() const { return m_matrix; }
+  int thickness() const { return m_thickness; }
   TiledMode tiledMode() const { return m_tiledMode; }
   doc::color_t color() const { return m_color; }
   doc::color_t bgColor() const { return m_bgColor; }
@@ -44,13 +73,32 @@ public:
   void applyToRgba(FilterManager* filterMgr);
   void applyToGrayscale(FilterManager* filterMgr);
   void applyToIndexed(FilterManager* filterMgr);
+  std::unique_ptr<Filter> createThreadCopy() const;
 
 private:
+  // Outlines thicker than one pixel are calculated with a distance
+  // transform of the whole source image (instead of checking the 3x3
+  // matrix in each pixel). Only the Circle (euclidean distance),
+  // Square, Horizontal, and Vertical matrices support a thickness,
+  // custom matrices are always applied with a thickness of 1.
+  bool useDistances() const;
+  template<typename Traits, typename IsTransparent>
+  void updateNearPixels(FilterManager* filterMgr, IsTransparent isTransparent);
+
   Place m_place;
   Matrix m_matrix;
+  int m_thickness;
   TiledMode m_tiledMode;
   doc::color_t m_color;
   doc::color_t m_bgColor;
+
+  // For each pixel of the source image, 1 if it's near (at a distance
+  // less or equal than m_thickness) to the pixels that generate the
+  // outline (opaque pixels for Place::Outside, or transparent pixels
+  // for Place::Inside).
+  std::vector<uint8_t> m_nearPixels;
+  const doc::Image* m_nearImage;
+  int m_nearFirstY;
 };
 
 } // namespace filters
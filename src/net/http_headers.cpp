@@ -1,4 +1,5 @@
 // Aseprite Network Library
+// Copyright (c) 2026 Igara Studio S.A.
 // Copyright (c) 2001-2015 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -17,4 +18,12 @@ void HttpHeaders::setHeader(const std::string& name, const std::string& value)
   m_map[name] = value;
 }
 
+std::string HttpHeaders::header(const std::string& name) const
+{
+  auto it = m_map.find(name);
+  if (it != m_map.end())
+    return it->second;
+  return std::string();
+}
+
 } // namespace net
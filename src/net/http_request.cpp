@@ -1,4 +1,5 @@
 // Aseprite Network Library
+// Copyright (c) 2026 Igara Studio S.A.
 // Copyright (c) 2001-2016 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -11,6 +12,7 @@
 #include "net/http_request.h"
 
 #include "base/debug.h"
+#include "base/string.h"
 #include "net/http_headers.h"
 #include "net/http_response.h"
 
@@ -27,6 +29,8 @@ public:
   {
     curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, this);
     curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, &HttpRequestImpl::writeBodyCallback);
+    curl_easy_setopt(m_curl, CURLOPT_HEADERDATA, this);
+    curl_easy_setopt(m_curl, CURLOPT_HEADERFUNCTION, &HttpRequestImpl::writeHeaderCallback);
     curl_easy_setopt(m_curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(m_curl, CURLOPT_NOSIGNAL, 1);
   }
@@ -85,6 +89,35 @@ private:
     return bytes;
   }
 
+  std::size_t writeHeader(char* ptr, std::size_t bytes)
+  {
+    ASSERT(m_response != NULL);
+
+    // Each call receives one "Name: value\r\n" line (the status line
+    // and the last empty line don't have a colon)
+    const std::string line(ptr, bytes);
+    const std::size_t colon = line.find(':');
+    if (colon != std::string::npos) {
+      std::size_t i = colon + 1;
+      std::size_t j = line.size();
+      while (i < j && (line[i] == ' ' || line[i] == '\t'))
+        ++i;
+      while (j > i && (line[j - 1] == '\r' || line[j - 1] == '\n' || line[j - 1] == ' '))
+        --j;
+      m_response->setHeader(base::string_to_lower(line.substr(0, colon)), line.substr(i, j - i));
+    }
+    return bytes;
+  }
+
+  static std::size_t writeHeaderCallback(char* ptr,
+                                         std::size_t size,
+                                         std::size_t nmemb,
+                                         void* userdata)
+  {
+    HttpRequestImpl* req = reinterpret_cast<HttpRequestImpl*>(userdata);
+    return req->writeHeader(ptr, size * nmemb);
+  }
+
   static std::size_t writeBodyCallback(char* ptr,
                                        std::size_t size,
                                        std::size_t nmemb,
@@ -1,4 +1,5 @@
 // Aseprite Network Library
+// Copyright (c) 2026 Igara Studio S.A.
 // Copyright (c) 2001-2015 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -9,9 +10,11 @@
 #pragma once
 
 #include "base/disable_copying.h"
+#include "net/http_headers.h"
 
 #include <cstddef>
 #include <iosfwd>
+#include <string>
 
 namespace net {
 
@@ -25,12 +28,21 @@ public:
   int status() const { return m_status; }
   void setStatus(int status) { m_status = status; }
 
+  // Returns the headers received in the response (with the names in
+  // lower case, e.g. "etag" or "last-modified").
+  const HttpHeaders& headers() const { return m_headers; }
+  void setHeader(const std::string& name, const std::string& value)
+  {
+    m_headers.setHeader(name, value);
+  }
+
   // Writes data in the stream.
   void write(const char* data, std::size_t length);
 
 private:
   int m_status;
   std::ostream* m_stream;
+  HttpHeaders m_headers;
 
   DISABLE_COPYING(HttpResponse);
 };
@@ -1,5 +1,5 @@
 // Aseprite Render Library
-// Copyright (c)      2020 Igara Studio S.A.
+// Copyright (c) 2020-2026 Igara Studio S.A.
 // Copyright (c) 2001-2015 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -9,6 +9,8 @@
 #define RENDER_COLOR_HISTOGRAM_H_INCLUDED
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <limits>
 #include <vector>
 
@@ -38,13 +40,16 @@ public:
 
   ColorHistogram()
     : m_histogram(RElements * GElements * BElements * AElements, 0)
+    , m_exactTable(kExactTableSize, -1)
     , m_useHighPrecision(true)
   {
   }
 
   // Returns the number of points in the specified histogram
   // entry. Each rgba-index is in the range of the histogram, e.g.
-  // r=[0,RElements), g=[0,GElements), etc.
+  // r=[0,RElements), g=[0,GElements), etc. The samples of the
+  // high-precision colors are added to the histogram only when they
+  // are needed (see createOptimizedPalette()).
   std::size_t at(int r, int g, int b, int a) const
   {
     return m_histogram[histogramIndex(r, g, b, a)];
@@ -54,40 +59,97 @@ public:
   // specified value in "count".
   void addSamples(doc::color_t color, std::size_t count = 1)
   {
-    int i = histogramIndex(color);
-
-    if (m_histogram[i] < std::numeric_limits<std::size_t>::max() - count) // Avoid overflow
-      m_histogram[i] += count;
-    else
-      m_histogram[i] = std::numeric_limits<std::size_t>::max();
-
-    // Accurate colors are used only for less than 256 colors.  If the
-    // image has more than 256 colors the m_histogram is used
-    // instead.
+    // Accurate colors are used only for less than 256 colors, they
+    // are counted in a small hash table. If the image has more than
+    // 256 colors the m_histogram is used instead.
     if (m_useHighPrecision) {
-      std::vector<doc::color_t>::iterator it =
-        std::find(m_highPrecision.begin(), m_highPrecision.end(), color);
+      int16_t& entry = exactEntry(color);
+      if (entry >= 0) {
+        addCount(m_highPrecisionCounts[entry], count);
+        return;
+      }
 
       // The color is not in the high-precision table
-      if (it == m_highPrecision.end()) {
-        if (m_highPrecision.size() < 256) {
-          m_highPrecision.push_back(color);
-        }
-        else {
-          // In this case we reach the limit for the high-precision histogram.
-          m_useHighPrecision = false;
-        }
+      if (m_highPrecision.size() < kMaxExactColors) {
+        entry = int16_t(m_highPrecision.size());
+        m_highPrecision.push_back(color);
+        m_highPrecisionCounts.push_back(count);
+        return;
       }
+
+      // In this case we reach the limit for the high-precision histogram.
+      m_useHighPrecision = false;
+      flushHighPrecisionCounts();
+    }
+
+    addCount(m_histogram[histogramIndex(color)], count);
+  }
+
+  // Adds all the samples of the given histogram (e.g. a partial
+  // histogram filled in other thread) without its high-precision
+  // colors (see mergeHighPrecision()).
+  void mergeSamples(const ColorHistogram& other)
+  {
+    const std::size_t n = m_histogram.size();
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::size_t count = other.m_histogram[i];
+      if (count != 0)
+        addCount(m_histogram[i], count);
+    }
+
+    // Samples of the other high-precision colors
+    for (std::size_t i = 0; i < other.m_highPrecision.size(); ++i) {
+      const std::size_t count = other.m_highPrecisionCounts[i];
+      if (count != 0)
+        addCount(m_histogram[histogramIndex(other.m_highPrecision[i])], count);
+    }
+  }
+
+  // Adds the high-precision colors of the given histogram as if
+  // they were added after the colors of this histogram (so merging
+  // partial histograms in order gives the same result as adding all
+  // samples to one histogram).
+  void mergeHighPrecision(const ColorHistogram& other)
+  {
+    if (!m_useHighPrecision)
+      return;
+
+    if (!other.m_useHighPrecision) {
+      m_useHighPrecision = false;
+      flushHighPrecisionCounts();
+      return;
+    }
+
+    // Only the colors are added here, the samples are added with
+    // mergeSamples().
+    for (doc::color_t color : other.m_highPrecision) {
+      addSamples(color, 0);
+      if (!m_useHighPrecision)
+        return;
     }
   }
 
+  // Removes all high-precision colors (without touching the samples)
+  // and enables/disables them for the next samples.
+  void resetHighPrecision(const bool useHighPrecision)
+  {
+    flushHighPrecisionCounts();
+    m_highPrecision.clear();
+    m_highPrecisionCounts.clear();
+    std::fill(m_exactTable.begin(), m_exactTable.end(), -1);
+    m_useHighPrecision = useHighPrecision;
+  }
+
   // Creates a set of entries for the given palette in the given range
   // with the more important colors in the histogram. Returns the
   // number of used entries in the palette (maybe the range [from,to]
-  // is more than necessary).
-  int createOptimizedPalette(Palette* palette)
+  // is more than necessary). The "parallelFor" is used by the
+  // median-cut algorithm (see median_cut()).
+  template<class ParallelFor = SerialFor>
+  int createOptimizedPalette(Palette* palette, const ParallelFor& parallelFor = ParallelFor())
   {
-    // Can we use the high-precision table?
+    // Can we use the high-precision table? In this case we have the
+    // exact colors of the image (no need to quantize anything).
     if (m_useHighPrecision && int(m_highPrecision.size()) <= palette->size()) {
       for (int i = 0; i < (int)m_highPrecision.size(); ++i)
         palette->setEntry(i, m_highPrecision[i]);
@@ -97,8 +159,10 @@ public:
     // OK, we have to use the histogram and some algorithm (like
     // median-cut) to quantize "optimal" colors.
     else {
+      flushHighPrecisionCounts();
+
       std::vector<doc::color_t> result;
-      median_cut(*this, palette->size(), result);
+      median_cut(*this, palette->size(), result, parallelFor);
 
       for (int i = 0; i < (int)result.size(); ++i)
         palette->setEntry(i, result[i]);
@@ -127,12 +191,52 @@ private:
     return r | (g << RBits) | (b << (RBits + GBits)) | (a << (RBits + GBits + BBits));
   }
 
+  // Returns the entry of the hash table for the given color (the
+  // index of the color in m_highPrecision, or -1 if the color isn't
+  // in the table, so the entry can be used to add it).
+  int16_t& exactEntry(doc::color_t color)
+  {
+    std::size_t i = (uint32_t(color) * 0x9E3779B1u) >> (32 - kExactTableBits);
+    while (m_exactTable[i] >= 0 && m_highPrecision[m_exactTable[i]] != color)
+      i = (i + 1) & (kExactTableSize - 1);
+    return m_exactTable[i];
+  }
+
+  // Adds the samples of the high-precision colors to the histogram.
+  void flushHighPrecisionCounts()
+  {
+    for (std::size_t i = 0; i < m_highPrecision.size(); ++i) {
+      if (m_highPrecisionCounts[i] != 0) {
+        addCount(m_histogram[histogramIndex(m_highPrecision[i])], m_highPrecisionCounts[i]);
+        m_highPrecisionCounts[i] = 0;
+      }
+    }
+  }
+
+  static void addCount(std::size_t& value, const std::size_t count)
+  {
+    if (value < std::numeric_limits<std::size_t>::max() - count) // Avoid overflow
+      value += count;
+    else
+      value = std::numeric_limits<std::size_t>::max();
+  }
+
+  static constexpr std::size_t kMaxExactColors = 256;
+  static constexpr int kExactTableBits = 9;
+  static constexpr std::size_t kExactTableSize = std::size_t(1) << kExactTableBits;
+
   // 3D histogram (the index in the histogram is calculated through histogramIndex() function).
   std::vector<std::size_t> m_histogram;
 
   // High precision histogram to create an accurate palette if RGB
-  // source images contains less than 256 colors.
+  // source images contains less than 256 colors. The colors are
+  // sorted by appearance, and their samples are counted in
+  // m_highPrecisionCounts until they are added to m_histogram.
   std::vector<doc::color_t> m_highPrecision;
+  std::vector<std::size_t> m_highPrecisionCounts;
+
+  // Hash table (open addressing) with indexes of m_highPrecision.
+  std::vector<int16_t> m_exactTable;
 
   // True if we can use m_highPrecision still (it means that the
   // number of different samples is less than 256 colors still).
@@ -1,5 +1,5 @@
 // Aseprite Render Library
-// Copyright (c) 2019 Igara Studio S.A.
+// Copyright (c) 2019-2026 Igara Studio S.A.
 // Copyright (c) 2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -18,10 +18,12 @@ class Dithering {
 public:
   Dithering(DitheringAlgorithm algorithm = DitheringAlgorithm::None,
             const DitheringMatrix& matrix = DitheringMatrix(),
-            double factor = 1.0)
+            double factor = 1.0,
+            bool serpentine = true)
     : m_algorithm(algorithm)
     , m_matrix(matrix)
     , m_factor(factor)
+    , m_serpentine(serpentine)
   {
   }
 
@@ -29,14 +31,21 @@ public:
   DitheringMatrix matrix() const { return m_matrix; }
   double factor() const { return m_factor; }
 
+  // Order of rows in error diffusion: serpentine (odd rows from
+  // right-to-left) or all rows from left-to-right, which is faster
+  // for big images (see ErrorDiffusionDither).
+  bool serpentine() const { return m_serpentine; }
+
   void algorithm(const DitheringAlgorithm algorithm) { m_algorithm = algorithm; }
   void matrix(const DitheringMatrix& matrix) { m_matrix = matrix; }
   void factor(const double factor) { m_factor = factor; }
+  void serpentine(const bool serpentine) { m_serpentine = serpentine; }
 
 private:
   DitheringAlgorithm m_algorithm;
   DitheringMatrix m_matrix;
   double m_factor;
+  bool m_serpentine;
 };
 
 } // namespace render
@@ -1,5 +1,5 @@
 // Aseprite Render Library
-// Copyright (c) 2020-2025 Igara Studio S.A.
+// Copyright (c) 2020-2026 Igara Studio S.A.
 // Copyright (c) 2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -40,6 +40,10 @@ public:
 
   int& operator()(int i, int j) { return m_matrix[(i % m_rows) * m_cols + (j % m_cols)]; }
 
+  // Returns the values of the i-th row (cols() values), useful to
+  // avoid the modulo operations of operator() for each pixel.
+  const int* row(int i) const { return &m_matrix[(i % m_rows) * m_cols]; }
+
 private:
   int m_rows, m_cols;
   std::vector<int> m_matrix;
@@ -1,5 +1,5 @@
 // Aseprite Render Library
-// Copyright (c) 2019-2022  Igara Studio S.A
+// Copyright (c) 2019-2026  Igara Studio S.A
 // Copyright (c) 2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -11,15 +11,46 @@
 
 #include "render/error_diffusion.h"
 
+#include "doc/task_group.h"
 #include "gfx/hsl.h"
 #include "gfx/rgb.h"
 
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 namespace render {
 
-ErrorDiffusionDither::ErrorDiffusionDither(int transparentIndex)
+namespace {
+
+// Minimum number of pixels of an image to dither it from several
+// threads, and number of pixels processed between each
+// synchronization with the row below.
+const int kParallelDitherPixels = 256 * 256;
+const int kWavefrontChunk = 64;
+
+// Distributes the quantization error "q" of a pixel with the
+// Floyd-Steinberg matrix (same values for the serial and parallel
+// versions so both give the same result).
+struct FloydSteinberg {
+  int next, belowPrev, below, belowNext;
+
+  FloydSteinberg(const int q)
+    : next(q * 7 / 16)
+    , belowPrev(q * 3 / 16)
+    , below(q * 5 / 16)
+    , belowNext(q * 1 / 16)
+  {
+  }
+};
+
+} // anonymous namespace
+
+ErrorDiffusionDither::ErrorDiffusionDither(int transparentIndex, bool zigZag)
   : m_transparentIndex(transparentIndex)
+  , m_zigZag(zigZag)
 {
 }
 
@@ -55,18 +86,167 @@ doc::color_t ErrorDiffusionDither::ditherRgbToIndex2D(const int x,
     m_lastY = y;
   }
 
-  doc::color_t color = doc::get_pixel_fast<doc::RgbTraits>(m_srcImage, x, y);
+  const doc::color_t color = doc::get_pixel_fast<doc::RgbTraits>(m_srcImage, x, y);
 
   // Get RGB values + quatization error
-  int v[kChannels] = { doc::rgba_getr(color),
-                       doc::rgba_getg(color),
-                       doc::rgba_getb(color),
-                       doc::rgba_geta(color) };
+  int v[kChannels];
+  for (int i = 0; i < kChannels; ++i)
+    v[i] = m_err[i][x + 1];
+
+  int quantError[kChannels];
+  const doc::color_t index = quantize(color, v, rgbmap, palette, quantError);
+
+  // TODO using Floyd-Steinberg matrix here but it should be configurable
   for (int i = 0; i < kChannels; ++i) {
-    v[i] += m_err[i][x + 1];
-    v[i] = std::clamp(v[i], 0, 255);
+    int* err = &m_err[i][x];
+    const FloydSteinberg fs(quantError[i] * m_factor / 100);
+
+    if (m_zigZag && (y & 1)) {
+      err[0] += fs.next;
+      err[m_width + 2] += fs.belowPrev;
+      err[m_width + 1] += fs.below;
+      err[m_width] += fs.belowNext;
+    }
+    else {
+      err[+2] += fs.next;
+      err[m_width] += fs.belowPrev;
+      err[m_width + 1] += fs.below;
+      err[m_width + 2] += fs.belowNext;
+    }
   }
 
+  return index;
+}
+
+bool ErrorDiffusionDither::ditherInParallel(const doc::Image* srcImage,
+                                            doc::Image* dstImage,
+                                            const doc::RgbMap* rgbmap,
+                                            const doc::Palette* palette,
+                                            TaskDelegate* delegate)
+{
+  const int w = srcImage->width();
+  const int h = srcImage->height();
+  const int nthreads = std::min(doc::task_threads(), h);
+  if (m_zigZag || nthreads < 2 || w * h < kParallelDitherPixels ||
+      (rgbmap && !rgbmap->isThreadSafe())) {
+    return false;
+  }
+
+  // The thread "t" dithers the rows t, t+nthreads, t+2*nthreads,
+  // etc. Each row has its own buffer with the error diffused from the
+  // previous row, so we need a ring of nthreads+1 buffers (the buffer
+  // of a row is cleared when the same thread starts the row above it,
+  // when it's not used anymore). The error diffused to the next pixel
+  // of the same row is kept in a local variable.
+  const int nbuffers = nthreads + 1;
+  const int rowSize = w + 2;
+  std::vector<int> errBuffers(std::size_t(nbuffers) * kChannels * rowSize, 0);
+  auto errRow = [&errBuffers, nbuffers, rowSize](const int y, const int channel) {
+    return &errBuffers[(std::size_t(y % nbuffers) * kChannels + channel) * rowSize];
+  };
+
+  // Progress of each row (number of dithered pixels) encoded as
+  // y*(w+1)+pixels, so the values are always increasing even when
+  // the same slot is re-used for other row.
+  auto progress = std::make_unique<std::atomic<int64_t>[]>(nbuffers);
+  for (int i = 0; i < nbuffers; ++i)
+    progress[i] = -1;
+
+  std::atomic<bool> canceled(false);
+  std::mutex delegateMutex;
+  int rowsDone = 0;
+
+  // Waits until "pixels" pixels of row "y" are dithered.
+  auto waitRow = [&progress, &canceled, nbuffers, w](const int y, const int pixels) {
+    const int64_t target = int64_t(y) * (w + 1) + pixels;
+    while (progress[y % nbuffers].load(std::memory_order_acquire) < target) {
+      if (canceled)
+        return false;
+      std::this_thread::yield();
+    }
+    return true;
+  };
+
+  auto ditherRows = [&](const int t) {
+    for (int y = t; y < h && !canceled; y += nthreads) {
+      int* cur[kChannels];
+      int* below[kChannels];
+      for (int i = 0; i < kChannels; ++i) {
+        cur[i] = errRow(y, i);
+        below[i] = errRow(y + 1, i);
+        std::fill(below[i], below[i] + rowSize, 0);
+      }
+
+      int carry[kChannels] = { 0, 0, 0, 0 };
+      auto dstIt = doc::get_pixel_address_fast<doc::IndexedTraits>(dstImage, 0, y);
+
+      for (int x1 = 0; x1 < w; x1 += kWavefrontChunk) {
+        const int x2 = std::min(x1 + kWavefrontChunk, w);
+
+        // The pixel x needs the error from the pixels x-1, x, and x+1
+        // of the previous row.
+        if (y > 0 && !waitRow(y - 1, std::min(x2 + 1, w)))
+          return;
+
+        for (int x = x1; x < x2; ++x, ++dstIt) {
+          const doc::color_t color = doc::get_pixel_fast<doc::RgbTraits>(srcImage, x, y);
+
+          int v[kChannels];
+          for (int i = 0; i < kChannels; ++i)
+            v[i] = cur[i][x + 1] + carry[i];
+
+          int quantError[kChannels];
+          *dstIt = quantize(color, v, rgbmap, palette, quantError);
+
+          for (int i = 0; i < kChannels; ++i) {
+            const FloydSteinberg fs(quantError[i] * m_factor / 100);
+            carry[i] = fs.next;
+            below[i][x] += fs.belowPrev;
+            below[i][x + 1] += fs.below;
+            below[i][x + 2] += fs.belowNext;
+          }
+        }
+
+        progress[y % nbuffers].store(int64_t(y) * (w + 1) + x2, std::memory_order_release);
+      }
+
+      if (delegate) {
+        const std::lock_guard lock(delegateMutex);
+        if (!delegate->continueTask())
+          canceled = true;
+        else
+          delegate->notifyTaskProgress(double(++rowsDone) / double(h));
+      }
+    }
+  };
+
+  // We use our own threads instead of doc::TaskGroup because all of
+  // them must run at the same time (each one waits the rows of the
+  // previous one), but the number of threads is the same as the
+  // threads of the task scheduler.
+  std::vector<std::thread> threads;
+  for (int t = 1; t < nthreads; ++t)
+    threads.emplace_back(ditherRows, t);
+  ditherRows(0);
+  for (auto& thread : threads)
+    thread.join();
+
+  return true;
+}
+
+doc::color_t ErrorDiffusionDither::quantize(const doc::color_t color,
+                                            int v[kChannels],
+                                            const doc::RgbMap* rgbmap,
+                                            const doc::Palette* palette,
+                                            int quantError[kChannels]) const
+{
+  v[0] += doc::rgba_getr(color);
+  v[1] += doc::rgba_getg(color);
+  v[2] += doc::rgba_getb(color);
+  v[3] += doc::rgba_geta(color);
+  for (int i = 0; i < kChannels; ++i)
+    v[i] = std::clamp(v[i], 0, 255);
+
   const doc::color_t index = (rgbmap ?
                                 rgbmap->mapColor(v[0], v[1], v[2], v[3]) :
                                 palette->findBestfit(v[0], v[1], v[2], v[3], m_transparentIndex));
@@ -77,34 +257,10 @@ doc::color_t ErrorDiffusionDither::ditherRgbToIndex2D(const int x,
     palColor = (color & doc::rgba_rgb_mask);
   }
 
-  const int quantError[kChannels] = { v[0] - doc::rgba_getr(palColor),
-                                      v[1] - doc::rgba_getg(palColor),
-                                      v[2] - doc::rgba_getb(palColor),
-                                      v[3] - doc::rgba_geta(palColor) };
-
-  // TODO using Floyd-Steinberg matrix here but it should be configurable
-  for (int i = 0; i < kChannels; ++i) {
-    int* err = &m_err[i][x];
-    const int q = quantError[i] * m_factor / 100;
-    const int a = q * 7 / 16;
-    const int b = q * 3 / 16;
-    const int c = q * 5 / 16;
-    const int d = q * 1 / 16;
-
-    if (y & 1) {
-      err[0] += a;
-      err[m_width + 2] += b;
-      err[m_width + 1] += c;
-      err[m_width] += d;
-    }
-    else {
-      err[+2] += a;
-      err[m_width] += b;
-      err[m_width + 1] += c;
-      err[m_width + 2] += d;
-    }
-  }
-
+  quantError[0] = v[0] - doc::rgba_getr(palColor);
+  quantError[1] = v[1] - doc::rgba_getg(palColor);
+  quantError[2] = v[2] - doc::rgba_getb(palColor);
+  quantError[3] = v[3] - doc::rgba_geta(palColor);
   return index;
 }
 
@@ -1,5 +1,5 @@
 // Aseprite Render Library
-// Copyright (c) 2019 Igara Studio S.A
+// Copyright (c) 2019-2026 Igara Studio S.A
 // Copyright (c) 2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -16,23 +16,48 @@
 
 namespace render {
 
+// Floyd-Steinberg error diffusion. By default odd rows are processed
+// from right-to-left (zig-zag or serpentine order), which gives
+// better results, but each row depends on the whole previous row.
+// Without zig-zag (all rows from left-to-right), each row depends
+// only on the first pixels of the previous row, so big images are
+// dithered from several threads in a wavefront (each row trailing
+// the previous one), with the same result as the serial order. The
+// order is selected with Dithering::serpentine() (e.g. from the
+// Color Mode dialog or with --dithering-rows in the CLI).
 class ErrorDiffusionDither : public DitheringAlgorithmBase {
 public:
-  ErrorDiffusionDither(int transparentIndex = -1);
+  ErrorDiffusionDither(int transparentIndex = -1, bool zigZag = true);
   int dimensions() const override { return 2; }
-  bool zigZag() const override { return true; }
+  bool zigZag() const override { return m_zigZag; }
   void start(const doc::Image* srcImage, doc::Image* dstImage, const double factor) override;
   void finish() override;
   doc::color_t ditherRgbToIndex2D(const int x,
                                   const int y,
                                   const doc::RgbMap* rgbmap,
                                   const doc::Palette* palette) override;
+  bool ditherInParallel(const doc::Image* srcImage,
+                        doc::Image* dstImage,
+                        const doc::RgbMap* rgbmap,
+                        const doc::Palette* palette,
+                        TaskDelegate* delegate) override;
 
 private:
+  static const int kChannels = 4;
+
+  // Returns the palette index for the given source color plus the
+  // diffused error "v" (which is clamped), and the error that must
+  // be diffused to the next pixels.
+  doc::color_t quantize(const doc::color_t color,
+                        int v[kChannels],
+                        const doc::RgbMap* rgbmap,
+                        const doc::Palette* palette,
+                        int quantError[kChannels]) const;
+
   int m_transparentIndex;
+  bool m_zigZag;
   const doc::Image* m_srcImage;
   int m_width, m_lastY;
-  static const int kChannels = 4;
   std::vector<int> m_err[kChannels];
   int m_factor;
 };
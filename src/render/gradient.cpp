@@ -1,5 +1,5 @@
 // Aseprite Render Library
-// Copyright (c) 2019-2020 Igara Studio S.A.
+// Copyright (c) 2019-2026 Igara Studio S.A.
 // Copyright (c) 2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -13,10 +13,135 @@
 
 #include "base/vector2d.h"
 #include "doc/image.h"
+#include "doc/primitives_fast.h"
+#include "doc/task_group.h"
 #include "render/dithering_matrix.h"
 
+#include <algorithm>
+#include <cmath>
+
 namespace render {
 
+namespace {
+
+// Minimum number of pixels to render a gradient from several
+// threads (the gradient tool renders the whole image on each mouse
+// movement).
+const int kParallelGradientPixels = 256 * 256;
+
+// Calls func(y1, y2) for bands of rows of an image of the given
+// size. Big images are divided in several bands rendered in
+// parallel tasks.
+template<typename Func>
+void for_each_rows_band(const int width, const int height, Func&& func)
+{
+  const int nthreads = doc::task_threads();
+  if (nthreads < 2 || width * height < kParallelGradientPixels || height < 2) {
+    func(0, height);
+    return;
+  }
+
+  const int bands = std::min(height, nthreads * 2);
+  doc::TaskGroup tasks;
+  for (int i = 0; i < bands; ++i) {
+    const int y1 = height * i / bands;
+    const int y2 = height * (i + 1) / bands;
+    tasks.run([&func, y1, y2] { func(y1, y2); });
+  }
+  tasks.wait();
+}
+
+// Colors of both stops of a gradient.
+class GradientStops {
+public:
+  GradientStops(doc::color_t c0, doc::color_t c1)
+  {
+    // As we use non-premultiplied RGB values, we need correct RGB
+    // values on each stop. So in case that one color has alpha=0
+    // (complete transparent), use the RGB values of the
+    // non-transparent color in the other stop point.
+    if (doc::rgba_geta(c0) == 0 && doc::rgba_geta(c1) != 0) {
+      c0 = (c1 & doc::rgba_rgb_mask);
+    }
+    else if (doc::rgba_geta(c0) != 0 && doc::rgba_geta(c1) == 0) {
+      c1 = (c0 & doc::rgba_rgb_mask);
+    }
+
+    m_c0 = c0;
+    m_c1 = c1;
+    m_r0 = doc::rgba_getr(c0);
+    m_g0 = doc::rgba_getg(c0);
+    m_b0 = doc::rgba_getb(c0);
+    m_a0 = doc::rgba_geta(c0);
+    m_dr = doc::rgba_getr(c1) - m_r0;
+    m_dg = doc::rgba_getg(c1) - m_g0;
+    m_db = doc::rgba_getb(c1) - m_b0;
+    m_da = doc::rgba_geta(c1) - m_a0;
+  }
+
+  doc::color_t c0() const { return m_c0; }
+  doc::color_t c1() const { return m_c1; }
+
+  // Returns the color in the position "f" of the gradient. Clamping
+  // "f" to [0,1] gives exactly c0 and c1 outside the gradient
+  // without branches (so the compiler can vectorize the rows).
+  doc::color_t at(double f) const
+  {
+    f = std::clamp(f, 0.0, 1.0);
+    return doc::rgba(int(m_r0 + f * m_dr + 1e-7),
+                     int(m_g0 + f * m_dg + 1e-7),
+                     int(m_b0 + f * m_db + 1e-7),
+                     int(m_a0 + f * m_da + 1e-7));
+  }
+
+private:
+  doc::color_t m_c0, m_c1;
+  int m_r0, m_g0, m_b0, m_a0;
+  int m_dr, m_dg, m_db, m_da;
+};
+
+// Renders the gradient in "img" where gradientPos(x, y) returns the
+// position in the gradient of each pixel (0=c0, 1=c1).
+template<typename PosFunc>
+void render_gradient_rows(doc::Image* img,
+                          const GradientStops& stops,
+                          const render::DitheringMatrix& matrix,
+                          PosFunc&& gradientPos)
+{
+  const int width = img->width();
+  const int height = img->height();
+
+  if (matrix.rows() == 1 && matrix.cols() == 1) {
+    for_each_rows_band(width, height, [&](const int y1, const int y2) {
+      for (int y = y1; y < y2; ++y) {
+        auto dst = doc::get_pixel_address_fast<doc::RgbTraits>(img, 0, y);
+        for (int x = 0; x < width; ++x)
+          dst[x] = stops.at(gradientPos(x, y));
+      }
+    });
+  }
+  else {
+    const doc::color_t c0 = stops.c0();
+    const doc::color_t c1 = stops.c1();
+    const int cols = matrix.cols();
+    const double k = matrix.maxValue() + 2;
+
+    for_each_rows_band(width, height, [&](const int y1, const int y2) {
+      for (int y = y1; y < y2; ++y) {
+        auto dst = doc::get_pixel_address_fast<doc::RgbTraits>(img, 0, y);
+        const int* thresholds = matrix.row(y);
+        for (int x = 0, j = 0; x < width; ++x) {
+          dst[x] = (gradientPos(x, y) * k < thresholds[j] + 1 ? c0 : c1);
+          if (++j == cols)
+            j = 0;
+        }
+      }
+    });
+  }
+}
+
+} // anonymous namespace
+
 void render_rgba_gradient(doc::Image* img,
                           const gfx::Point imgPos,
                           const gfx::Point p0,
@@ -61,66 +186,11 @@ void render_rgba_linear_gradient(doc::Image* img,
   const double wmag = w.magnitude();
   w = w.normalize();
 
-  // As we use non-premultiplied RGB values, we need correct RGB
-  // values on each stop. So in case that one color has alpha=0
-  // (complete transparent), use the RGB values of the
-  // non-transparent color in the other stop point.
-  if (doc::rgba_geta(c0) == 0 && doc::rgba_geta(c1) != 0) {
-    c0 = (c1 & doc::rgba_rgb_mask);
-  }
-  else if (doc::rgba_geta(c0) != 0 && doc::rgba_geta(c1) == 0) {
-    c1 = (c0 & doc::rgba_rgb_mask);
-  }
-
-  const uint8_t r0 = doc::rgba_getr(c0);
-  const uint8_t g0 = doc::rgba_getg(c0);
-  const uint8_t b0 = doc::rgba_getb(c0);
-  const uint8_t a0 = doc::rgba_geta(c0);
-
-  const uint8_t r1 = doc::rgba_getr(c1);
-  const uint8_t g1 = doc::rgba_getg(c1);
-  const uint8_t b1 = doc::rgba_getb(c1);
-  const uint8_t a1 = doc::rgba_geta(c1);
-
-  doc::LockImageBits<doc::RgbTraits> bits(img);
-  auto it = bits.begin();
-  const int width = img->width();
-  const int height = img->height();
-
-  if (matrix.rows() == 1 && matrix.cols() == 1) {
-    for (int y = 0; y < height; ++y) {
-      for (int x = 0; x < width; ++x, ++it) {
-        base::Vector2d<double> q(imgPos.x + x, imgPos.y + y);
-        q -= u;
-        double f = (q * w) / wmag;
-
-        doc::color_t c;
-        if (f < 0.0)
-          c = c0;
-        else if (f > 1.0)
-          c = c1;
-        else {
-          c = doc::rgba(int(r0 + f * (r1 - r0) + 1e-7),
-                        int(g0 + f * (g1 - g0) + 1e-7),
-                        int(b0 + f * (b1 - b0) + 1e-7),
-                        int(a0 + f * (a1 - a0) + 1e-7));
-        }
-
-        *it = c;
-      }
-    }
-  }
-  else {
-    for (int y = 0; y < height; ++y) {
-      for (int x = 0; x < width; ++x, ++it) {
-        base::Vector2d<double> q(imgPos.x + x, imgPos.y + y);
-        q -= u;
-        double f = (q * w) / wmag;
-
-        *it = (f * (matrix.maxValue() + 2) < matrix(y, x) + 1 ? c0 : c1);
-      }
-    }
-  }
+  render_gradient_rows(img, GradientStops(c0, c1), matrix, [&](const int x, const int y) {
+    const double qx = double(imgPos.x + x) - u.x;
+    const double qy = double(imgPos.y + y) - u.y;
+    return (qx * w.x + qy * w.y) / wmag;
+  });
 }
 
 void render_rgba_radial_gradient(doc::Image* img,
@@ -146,70 +216,15 @@ void render_rgba_radial_gradient(doc::Image* img,
     return;
   }
 
-  // As we use non-premultiplied RGB values, we need correct RGB
-  // values on each stop. So in case that one color has alpha=0
-  // (complete transparent), use the RGB values of the
-  // non-transparent color in the other stop point.
-  if (doc::rgba_geta(c0) == 0 && doc::rgba_geta(c1) != 0) {
-    c0 = (c1 & doc::rgba_rgb_mask);
-  }
-  else if (doc::rgba_geta(c0) != 0 && doc::rgba_geta(c1) == 0) {
-    c1 = (c0 & doc::rgba_rgb_mask);
-  }
-
-  const uint8_t r0 = doc::rgba_getr(c0);
-  const uint8_t g0 = doc::rgba_getg(c0);
-  const uint8_t b0 = doc::rgba_getb(c0);
-  const uint8_t a0 = doc::rgba_geta(c0);
+  const base::Vector2d<double> center = (u + v) / 2;
+  const double wx = std::fabs(w.x);
+  const double wy = std::fabs(w.y);
 
-  const uint8_t r1 = doc::rgba_getr(c1);
-  const uint8_t g1 = doc::rgba_getg(c1);
-  const uint8_t b1 = doc::rgba_getb(c1);
-  const uint8_t a1 = doc::rgba_geta(c1);
-
-  doc::LockImageBits<doc::RgbTraits> bits(img);
-  auto it = bits.begin();
-  const int width = img->width();
-  const int height = img->height();
-
-  if (matrix.rows() == 1 && matrix.cols() == 1) {
-    for (int y = 0; y < height; ++y) {
-      for (int x = 0; x < width; ++x, ++it) {
-        base::Vector2d<double> q(imgPos.x + x, imgPos.y + y);
-        q -= (u + v) / 2;
-        q.x /= std::fabs(w.x);
-        q.y /= std::fabs(w.y);
-        double f = std::sqrt(q.x * q.x + q.y * q.y);
-
-        doc::color_t c;
-        if (f < 0.0)
-          c = c0;
-        else if (f > 1.0)
-          c = c1;
-        else {
-          c = doc::rgba(int(r0 + f * (r1 - r0) + 1e-7),
-                        int(g0 + f * (g1 - g0) + 1e-7),
-                        int(b0 + f * (b1 - b0) + 1e-7),
-                        int(a0 + f * (a1 - a0) + 1e-7));
-        }
-
-        *it = c;
-      }
-    }
-  }
-  else {
-    for (int y = 0; y < height; ++y) {
-      for (int x = 0; x < width; ++x, ++it) {
-        base::Vector2d<double> q(imgPos.x + x, imgPos.y + y);
-        q -= (u + v) / 2;
-        q.x /= std::fabs(w.x);
-        q.y /= std::fabs(w.y);
-        double f = std::sqrt(q.x * q.x + q.y * q.y);
-
-        *it = (f * (matrix.maxValue() + 2) < matrix(y, x) + 1 ? c0 : c1);
-      }
-    }
-  }
+  render_gradient_rows(img, GradientStops(c0, c1), matrix, [&](const int x, const int y) {
+    const double qx = (double(imgPos.x + x) - center.x) / wx;
+    const double qy = (double(imgPos.y + y) - center.y) / wy;
+    return std::sqrt(qx * qx + qy * qy);
+  });
 }
 
 template<typename ImageTraits>
@@ -1,4 +1,5 @@
 // Aseprite Render Library
+// Copyright (c)      2026 Igara Studio S.A.
 // Copyright (c) 2001-2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -12,9 +13,22 @@
 
 #include <list>
 #include <queue>
+#include <vector>
 
 namespace render {
 
+// Default "parallel for" used by median_cut(), it calls f(i) for each
+// i in [0, n) in the current thread. Other implementations can call
+// f() from several threads at the same time.
+struct SerialFor {
+  template<typename F>
+  void operator()(const int n, F&& f) const
+  {
+    for (int i = 0; i < n; ++i)
+      f(i);
+  }
+};
+
 template<class Histogram>
 class Box {
   // These classes are used as parameters for some Box's generic
@@ -89,6 +103,12 @@ class Box {
   };
 
 public:
+  // Number of points inside each plane of the box along each axis
+  // (indexed by the position of the plane in the histogram).
+  struct Planes {
+    std::vector<std::size_t> r, g, b, a;
+  };
+
   Box(int r1, int g1, int b1, int a1, int r2, int g2, int b2, int a2)
     : r1(r1)
     , g1(g1)
@@ -120,6 +140,29 @@ public:
     volume = calculateVolume();
   }
 
+  // Same as shrink() but counting the points of all planes in one
+  // pass over the box (which can be done in parallel), so it's
+  // faster for big boxes. The result is exactly the same, and
+  // "planes" can be used later to split the box.
+  template<class ParallelFor>
+  void shrink(const Histogram& histogram, const ParallelFor& parallelFor, Planes& planes)
+  {
+    countPlanes(histogram, parallelFor, planes);
+
+    // A plane of one axis without points is empty for any range of
+    // the other axes, so we can shrink each axis independently.
+    planesShrink(planes.r, r1, r2);
+    planesShrink(planes.g, g1, g2);
+    planesShrink(planes.b, b1, b2);
+    planesShrink(planes.a, a1, a2);
+
+    points = 0;
+    for (int i = r1; i <= r2; ++i)
+      points += planes.r[i];
+
+    volume = calculateVolume();
+  }
+
   bool split(const Histogram& histogram, std::priority_queue<Box>& boxes) const
   {
     // Split along the largest dimension of the box.
@@ -142,6 +185,27 @@ public:
                           AAxisSplitter>(histogram, boxes, a1, a2, r1, r2, g1, g2, b1, b2);
   }
 
+  // Same as split() using the planes calculated by shrink().
+  bool split(const Planes& planes, std::priority_queue<Box>& boxes) const
+  {
+    auto planePoints = [](const std::vector<std::size_t>& axis) {
+      return [&axis](int i) { return axis[i]; };
+    };
+
+    if ((r2 - r1) >= (g2 - g1) && (r2 - r1) >= (b2 - b1) && (r2 - r1) >= (a2 - a1))
+      return splitAlongAxisWith<RAxisSplitter>(planePoints(planes.r), boxes, r1, r2);
+
+    if ((g2 - g1) >= (r2 - r1) && (g2 - g1) >= (b2 - b1) && (g2 - g1) >= (a2 - a1))
+      return splitAlongAxisWith<GAxisSplitter>(planePoints(planes.g), boxes, g1, g2);
+
+    if ((b2 - b1) >= (r2 - r1) && (b2 - b1) >= (g2 - g1) && (b2 - b1) >= (a2 - a1))
+      return splitAlongAxisWith<BAxisSplitter>(planePoints(planes.b), boxes, b1, b2);
+
+    return splitAlongAxisWith<AAxisSplitter>(planePoints(planes.a), boxes, a1, a2);
+  }
+
+  int volumeSize() const { return volume; }
+
   // Returns the color enclosed by the box calculating the mean of
   // all histogram's points inside the box.
   uint32_t meanColor(const Histogram& histogram) const
@@ -211,6 +275,65 @@ private:
     return count;
   }
 
+  // Counts the points of each plane of the box. The work is divided
+  // in rows of the r/g axes, each row has its own partial counters
+  // for the b/a axes, so they can be processed in parallel.
+  template<class ParallelFor>
+  void countPlanes(const Histogram& histogram,
+                   const ParallelFor& parallelFor,
+                   Planes& planes) const
+  {
+    const int gn = g2 - g1 + 1;
+    const int bn = b2 - b1 + 1;
+    const int an = a2 - a1 + 1;
+    const int rows = (r2 - r1 + 1) * gn;
+
+    std::vector<std::size_t> rowPoints(rows, 0);
+    std::vector<std::size_t> bPoints(std::size_t(rows) * bn, 0);
+    std::vector<std::size_t> aPoints(std::size_t(rows) * an, 0);
+
+    parallelFor(rows, [&](const int row) {
+      const int i = r1 + row / gn;
+      const int j = g1 + row % gn;
+      std::size_t* bRow = &bPoints[std::size_t(row) * bn];
+      std::size_t* aRow = &aPoints[std::size_t(row) * an];
+      std::size_t count = 0;
+
+      for (int k = b1; k <= b2; ++k)
+        for (int l = a1; l <= a2; ++l) {
+          const std::size_t c = histogram.at(i, j, k, l);
+          count += c;
+          bRow[k - b1] += c;
+          aRow[l - a1] += c;
+        }
+
+      rowPoints[row] = count;
+    });
+
+    planes.r.assign(Histogram::RElements, 0);
+    planes.g.assign(Histogram::GElements, 0);
+    planes.b.assign(Histogram::BElements, 0);
+    planes.a.assign(Histogram::AElements, 0);
+
+    for (int row = 0; row < rows; ++row) {
+      planes.r[r1 + row / gn] += rowPoints[row];
+      planes.g[g1 + row % gn] += rowPoints[row];
+      for (int k = 0; k < bn; ++k)
+        planes.b[b1 + k] += bPoints[std::size_t(row) * bn + k];
+      for (int l = 0; l < an; ++l)
+        planes.a[a1 + l] += aPoints[std::size_t(row) * an + l];
+    }
+  }
+
+  // Same as axisShrink() but using the points of each plane.
+  static void planesShrink(const std::vector<std::size_t>& axis, int& i1, int& i2)
+  {
+    for (; i1 < i2 && axis[i1] == 0; ++i1)
+      ;
+    for (; i2 > i1 && axis[i2] == 0; --i2)
+      ;
+  }
+
   // Reduces the specified side of the box (i1/i2) along the
   // specified axis (if AxisGetter is RAxisGetter, then i1=r1,
   // i2=r2; if AxisGetter is GAxisGetter, then i1=g1, i2=g2).
@@ -271,30 +394,48 @@ private:
                       const int& k2,
                       const int& l1,
                       const int& l2) const
+  {
+    return splitAlongAxisWith<AxisSplitter>(
+      [&](int i) {
+        std::size_t planePoints = 0;
+
+        // We count all points in "i" plane.
+        for (int j = j1; j <= j2; ++j)
+          for (int k = k1; k <= k2; ++k)
+            for (int l = l1; l <= l2; ++l)
+              planePoints += AxisGetter::at(histogram, i, j, k, l);
+
+        return planePoints;
+      },
+      boxes,
+      i1,
+      i2);
+  }
+
+  // Splits the box along the "i" axis, "planePoints(i)" must return
+  // the number of points in the "i" plane of the box.
+  template<class AxisSplitter, class PlanePoints>
+  bool splitAlongAxisWith(const PlanePoints& planePoints,
+                          std::priority_queue<Box>& boxes,
+                          const int& i1,
+                          const int& i2) const
   {
     // These two variables will be used to count how many points are
     // in each side of the box if we split it in "i" position.
     std::size_t totalPoints1 = 0;
     std::size_t totalPoints2 = this->points;
-    int i, j, k, l;
 
     // We will try to split the box along the "i" axis. Imagine a
     // plane which its normal vector is "i" axis, so we will try to
     // move this plane from "i1" to "i2" to find the median, where
     // the number of points in both sides of the plane are
     // approximated the same.
-    for (i = i1; i <= i2; ++i) {
-      std::size_t planePoints = 0;
-
-      // We count all points in "i" plane.
-      for (j = j1; j <= j2; ++j)
-        for (k = k1; k <= k2; ++k)
-          for (l = l1; l <= l2; ++l)
-            planePoints += AxisGetter::at(histogram, i, j, k, l);
+    for (int i = i1; i <= i2; ++i) {
+      const std::size_t plane = planePoints(i);
 
       // As we move the plane to split through "i" axis One side is getting more points,
-      totalPoints1 += planePoints;
-      totalPoints2 -= planePoints;
+      totalPoints1 += plane;
+      totalPoints2 -= plane;
 
       if (totalPoints1 > totalPoints2) {
         if (totalPoints2 > 0) {
@@ -306,11 +447,11 @@ private:
           boxes.push(box2);
           return true;
         }
-        else if (totalPoints1 - planePoints > 0) {
+        else if (totalPoints1 - plane > 0) {
           Box box1(AxisSplitter::box1(*this, i - 1));
           Box box2(AxisSplitter::box2(*this, i));
-          box1.points = totalPoints1 - planePoints;
-          box2.points = totalPoints2 + planePoints;
+          box1.points = totalPoints1 - plane;
+          box2.points = totalPoints2 + plane;
           boxes.push(box1);
           boxes.push(box2);
           return true;
@@ -328,14 +469,26 @@ private:
   int volume;
 }; // end of class Box
 
+// Minimum volume of a box to count the points of all its planes in
+// one pass (see Box::shrink() with a ParallelFor).
+constexpr int kMedianCutPlanesVolume = (1 << 14);
+
 // Median Cut Algorithm as described in P. Heckbert, "Color image
 // quantization for frame buffer display,", Computer Graphics,
 // 16(3), pp. 297-307 (1982)
-template<class Histogram>
-void median_cut(const Histogram& histogram, std::size_t maxBoxes, std::vector<uint32_t>& result)
+//
+// The "parallelFor" is used to process big boxes and to calculate
+// the final colors in parallel (the result is the same as the
+// serial version).
+template<class Histogram, class ParallelFor = SerialFor>
+void median_cut(const Histogram& histogram,
+                std::size_t maxBoxes,
+                std::vector<uint32_t>& result,
+                const ParallelFor& parallelFor = ParallelFor())
 {
   // We need a priority queue to split bigger boxes first (see Box::operator<).
   std::priority_queue<Box<Histogram>> boxes;
+  typename Box<Histogram>::Planes planes;
 
   // First we start with one big box containing all histogram's samples.
   boxes.push(Box<Histogram>(0,
@@ -355,11 +508,19 @@ void median_cut(const Histogram& histogram, std::size_t maxBoxes, std::vector<ui
     boxes.pop();
 
     // Shrink the box to the minimum, to enclose the same points in
-    // the histogram.
-    box.shrink(histogram);
+    // the histogram, and try to split the box along the largest
+    // axis.
+    bool wasSplit;
+    if (box.volumeSize() >= kMedianCutPlanesVolume) {
+      box.shrink(histogram, parallelFor, planes);
+      wasSplit = box.split(planes, boxes);
+    }
+    else {
+      box.shrink(histogram);
+      wasSplit = box.split(histogram, boxes);
+    }
 
-    // Try to split the box along the largest axis.
-    if (!box.split(histogram, boxes)) {
+    if (!wasSplit) {
       // If we were not able to split the box (maybe because it is
       // too small or there are not enough points to split it), then
       // we add the box's color to the "result" vector directly (the
@@ -373,12 +534,16 @@ void median_cut(const Histogram& histogram, std::size_t maxBoxes, std::vector<ui
 
   // When we reach the maximum number of boxes, we convert each box
   // to a color for the "result" vector.
-  while (!boxes.empty() && result.size() < maxBoxes) {
-    const Box<Histogram>& box(boxes.top());
-    doc::color_t color = box.meanColor(histogram);
-    result.push_back(color);
+  std::vector<Box<Histogram>> remaining;
+  while (!boxes.empty() && result.size() + remaining.size() < maxBoxes) {
+    remaining.push_back(boxes.top());
     boxes.pop();
   }
+
+  const std::size_t first = result.size();
+  result.resize(first + remaining.size());
+  parallelFor(int(remaining.size()),
+              [&](const int i) { result[first + i] = remaining[i].meanColor(histogram); });
 }
 
 } // namespace render
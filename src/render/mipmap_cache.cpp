@@ -0,0 +1,225 @@
+// Aseprite Render Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "render/mipmap_cache.h"
+
+#include "base/debug.h"
+#include "doc/image.h"
+#include "doc/image_impl.h"
+#include "tracing/metrics.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace render {
+
+using namespace doc;
+
+static tracing::Counter g_hits("render.mipmap_cache.hits");
+static tracing::Counter g_misses("render.mipmap_cache.misses");
+
+namespace {
+
+// Sums of the alpha-weighted components of the pixels in a block
+// (so transparent pixels don't darken the averaged color).
+struct Sum {
+  uint32_t c[3] = { 0, 0, 0 };
+  uint32_t a = 0;
+};
+
+void add_pixel(Sum& sum, const RgbTraits::pixel_t c)
+{
+  const uint32_t a = rgba_geta(c);
+  sum.c[0] += rgba_getr(c) * a;
+  sum.c[1] += rgba_getg(c) * a;
+  sum.c[2] += rgba_getb(c) * a;
+  sum.a += a;
+}
+
+void add_pixel(Sum& sum, const GrayscaleTraits::pixel_t c)
+{
+  const uint32_t a = graya_geta(c);
+  sum.c[0] += graya_getv(c) * a;
+  sum.a += a;
+}
+
+void get_average(const Sum& sum, const int n, RgbTraits::pixel_t& c)
+{
+  if (sum.a == 0) {
+    c = 0;
+    return;
+  }
+  c = rgba(sum.c[0] / sum.a, sum.c[1] / sum.a, sum.c[2] / sum.a, sum.a / n);
+}
+
+void get_average(const Sum& sum, const int n, GrayscaleTraits::pixel_t& c)
+{
+  if (sum.a == 0) {
+    c = 0;
+    return;
+  }
+  c = graya(sum.c[0] / sum.a, sum.a / n);
+}
+
+template<typename ImageTraits>
+void reduce_image(const Image* src, Image* dst, const int factor)
+{
+  using pixel_t = typename ImageTraits::pixel_t;
+
+  const int srcW = src->width();
+  const int srcH = src->height();
+  std::vector<Sum> sums(dst->width());
+
+  for (int v = 0; v < dst->height(); ++v) {
+    std::fill(sums.begin(), sums.end(), Sum());
+
+    const int y1 = v * factor;
+    const int y2 = std::min(y1 + factor, srcH);
+    for (int y = y1; y < y2; ++y) {
+      auto srcRow = (const pixel_t*)src->getPixelAddress(0, y);
+      for (int x = 0; x < srcW; ++x)
+        add_pixel(sums[x / factor], srcRow[x]);
+    }
+
+    auto dstRow = (pixel_t*)dst->getPixelAddress(0, v);
+    for (int u = 0; u < dst->width(); ++u) {
+      const int w = std::min(factor, srcW - u * factor);
+      get_average(sums[u], w * (y2 - y1), dstRow[u]);
+    }
+  }
+}
+
+} // anonymous namespace
+
+MipmapCache::MipmapCache(const std::size_t maxBytes) : m_maxBytes(maxBytes)
+{
+}
+
+// static
+MipmapCache* MipmapCache::instance()
+{
+  static MipmapCache cache;
+  return &cache;
+}
+
+// static
+int MipmapCache::levelForScale(const double scale)
+{
+  int level = 0;
+  if (scale > 0.0) {
+    while (level < 16 && double(1 << (level + 1)) * scale <= 1.0)
+      ++level;
+  }
+  return level;
+}
+
+ImageRef MipmapCache::getLevel(const Image* image, const int level)
+{
+  ASSERT(level >= 1);
+  if (level < 1 || (image->pixelFormat() != IMAGE_RGB && image->pixelFormat() != IMAGE_GRAYSCALE))
+    return nullptr;
+
+  const Key key(image->id(), level);
+  const ObjectVersion version = image->version();
+
+  // Levels are created with the mutex locked, so if several threads
+  // render the same image at the same time, the level is created
+  // just once.
+  const std::lock_guard lock(m_mutex);
+
+  auto it = m_entries.find(key);
+  if (it != m_entries.end()) {
+    Entry& entry = it->second;
+    if (entry.version == version && entry.image->width() == ((image->width() - 1) >> level) + 1 &&
+        entry.image->height() == ((image->height() - 1) >> level) + 1) {
+      m_lru.splice(m_lru.begin(), m_lru, entry.lru);
+      g_hits.add();
+      return entry.image;
+    }
+
+    // Outdated level
+    m_bytes -= entry.bytes;
+    m_lru.erase(entry.lru);
+    m_entries.erase(it);
+  }
+
+  // Don't create levels that would use a big part of the cache, it's
+  // better to sample the original image than creating a big level
+  // on each render.
+  const std::size_t bytes = std::size_t(((image->width() - 1) >> level) + 1) *
+                            (((image->height() - 1) >> level) + 1) * image->bytesPerPixel();
+  if (bytes > m_maxBytes / 4)
+    return nullptr;
+
+  g_misses.add();
+  ImageRef levelImage = createLevel(image, level);
+  if (!levelImage)
+    return nullptr;
+
+  m_lru.push_front(key);
+  m_entries[key] = Entry{ version, levelImage, bytes, m_lru.begin() };
+  m_bytes += bytes;
+  evict();
+  return levelImage;
+}
+
+// static
+ImageRef MipmapCache::createLevel(const Image* image, const int level)
+{
+  ASSERT(level >= 1);
+  const int factor = (1 << level);
+  const int w = (image->width() + factor - 1) / factor;
+  const int h = (image->height() + factor - 1) / factor;
+
+  switch (image->pixelFormat()) {
+    case IMAGE_RGB: {
+      ImageRef dst(Image::create(IMAGE_RGB, w, h));
+      reduce_image<RgbTraits>(image, dst.get(), factor);
+      return dst;
+    }
+    case IMAGE_GRAYSCALE: {
+      ImageRef dst(Image::create(IMAGE_GRAYSCALE, w, h));
+      reduce_image<GrayscaleTraits>(image, dst.get(), factor);
+      return dst;
+    }
+    default:
+      // Indexed images cannot be averaged (the result would need
+      // colors that aren't in the palette)
+      return nullptr;
+  }
+}
+
+std::size_t MipmapCache::bytes() const
+{
+  const std::lock_guard lock(m_mutex);
+  return m_bytes;
+}
+
+void MipmapCache::clear()
+{
+  const std::lock_guard lock(m_mutex);
+  m_entries.clear();
+  m_lru.clear();
+  m_bytes = 0;
+}
+
+void MipmapCache::evict()
+{
+  // Remove the least recently used levels (but not the new one)
+  while (m_bytes > m_maxBytes && m_lru.size() > 1) {
+    auto it = m_entries.find(m_lru.back());
+    ASSERT(it != m_entries.end());
+    m_bytes -= it->second.bytes;
+    m_entries.erase(it);
+    m_lru.pop_back();
+  }
+}
+
+} // namespace render
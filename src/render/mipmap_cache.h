@@ -0,0 +1,83 @@
+// Aseprite Render Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef RENDER_MIPMAP_CACHE_H_INCLUDED
+#define RENDER_MIPMAP_CACHE_H_INCLUDED
+#pragma once
+
+#include "doc/image_ref.h"
+#include "doc/object_id.h"
+#include "doc/object_version.h"
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <mutex>
+#include <utility>
+
+namespace doc {
+class Image;
+}
+
+namespace render {
+
+// Cache of reduced versions of images (mip levels) to render sprites
+// zoomed out. The level N of an image is 2^N times smaller (rounding
+// up), and each pixel is the average of the 2^N x 2^N block of
+// pixels in the original image (instead of one sampled pixel, so
+// the result doesn't alias).
+//
+// Levels are created lazily when they are requested, and they are
+// created again when the version of the image changes. The cache
+// can be used from several threads (e.g. parallel rendering).
+class MipmapCache {
+public:
+  // Limit of bytes of all cached levels.
+  static constexpr std::size_t kDefaultMaxBytes = 256 * 1024 * 1024;
+
+  explicit MipmapCache(std::size_t maxBytes = kDefaultMaxBytes);
+
+  // Cache shared by all the program.
+  static MipmapCache* instance();
+
+  // Returns the best level to render an image with the given scale
+  // (the biggest level that is not smaller than the scaled image),
+  // or 0 if the original image should be used.
+  static int levelForScale(double scale);
+
+  // Returns the given level (>= 1) of the image, or nullptr if
+  // the image cannot be reduced (e.g. indexed images, or if the
+  // level is too big for the cache).
+  doc::ImageRef getLevel(const doc::Image* image, int level);
+
+  // Creates the given level (>= 1) of the image (without caching
+  // it). Returns nullptr for pixel formats that cannot be averaged.
+  static doc::ImageRef createLevel(const doc::Image* image, int level);
+
+  std::size_t bytes() const;
+  void clear();
+
+private:
+  using Key = std::pair<doc::ObjectId, int>;
+  struct Entry {
+    doc::ObjectVersion version;
+    doc::ImageRef image;
+    std::size_t bytes;
+    std::list<Key>::iterator lru;
+  };
+
+  void evict();
+
+  mutable std::mutex m_mutex;
+  std::map<Key, Entry> m_entries;
+  std::list<Key> m_lru; // Most recently used keys at the front
+  std::size_t m_bytes = 0;
+  std::size_t m_maxBytes;
+};
+
+} // namespace render
+
+#endif
@@ -0,0 +1,114 @@
+// Aseprite Render Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "render/mipmap_cache.h"
+
+#include "doc/image.h"
+#include "doc/primitives.h"
+
+#include <vector>
+
+using namespace doc;
+using namespace render;
+
+TEST(MipmapCache, LevelForScale)
+{
+  EXPECT_EQ(0, MipmapCache::levelForScale(2.0));
+  EXPECT_EQ(0, MipmapCache::levelForScale(1.0));
+  EXPECT_EQ(0, MipmapCache::levelForScale(0.75));
+  EXPECT_EQ(1, MipmapCache::levelForScale(0.5));
+  EXPECT_EQ(1, MipmapCache::levelForScale(0.3));
+  EXPECT_EQ(2, MipmapCache::levelForScale(0.25));
+  EXPECT_EQ(3, MipmapCache::levelForScale(0.125));
+}
+
+TEST(MipmapCache, AverageRgb)
+{
+  ImageRef image(Image::create(IMAGE_RGB, 3, 2));
+  clear_image(image.get(), 0);
+  put_pixel(image.get(), 0, 0, rgba(255, 0, 0, 255));
+  put_pixel(image.get(), 1, 0, rgba(0, 0, 255, 255));
+  put_pixel(image.get(), 2, 0, rgba(0, 255, 0, 255));
+
+  ImageRef level = MipmapCache::createLevel(image.get(), 1);
+  ASSERT_TRUE(level);
+  EXPECT_EQ(2, level->width());
+  EXPECT_EQ(1, level->height());
+  // Transparent pixels don't change the color, only the alpha
+  EXPECT_EQ(rgba(127, 0, 127, 127), get_pixel(level.get(), 0, 0));
+  EXPECT_EQ(rgba(0, 255, 0, 127), get_pixel(level.get(), 1, 0));
+}
+
+TEST(MipmapCache, IndexedImagesAreNotReduced)
+{
+  ImageRef image(Image::create(IMAGE_INDEXED, 4, 4));
+  clear_image(image.get(), 1);
+
+  MipmapCache cache;
+  EXPECT_FALSE(MipmapCache::createLevel(image.get(), 1));
+  EXPECT_FALSE(cache.getLevel(image.get(), 1));
+}
+
+TEST(MipmapCache, InvalidateByVersion)
+{
+  ImageRef image(Image::create(IMAGE_GRAYSCALE, 4, 4));
+  clear_image(image.get(), graya(200, 255));
+
+  MipmapCache cache;
+  ImageRef level = cache.getLevel(image.get(), 2);
+  ASSERT_TRUE(level);
+  EXPECT_EQ(graya(200, 255), get_pixel(level.get(), 0, 0));
+  EXPECT_EQ(level, cache.getLevel(image.get(), 2));
+  EXPECT_EQ(1u, cache.bytes() / level->bytesPerPixel());
+
+  clear_image(image.get(), graya(100, 255));
+  image->incrementVersion();
+  ImageRef level2 = cache.getLevel(image.get(), 2);
+  ASSERT_TRUE(level2);
+  EXPECT_NE(level, level2);
+  EXPECT_EQ(graya(100, 255), get_pixel(level2.get(), 0, 0));
+
+  cache.clear();
+  EXPECT_EQ(0u, cache.bytes());
+}
+
+TEST(MipmapCache, Limit)
+{
+  std::vector<ImageRef> images;
+  for (int i = 0; i < 5; ++i) {
+    images.emplace_back(Image::create(IMAGE_RGB, 8, 8));
+    clear_image(images.back().get(), 0);
+  }
+
+  // Each level 1 uses 4x4x4 = 64 bytes
+  MipmapCache cache(64 * 4);
+  ImageRef first = cache.getLevel(images[0].get(), 1);
+  for (int i = 1; i < 4; ++i)
+    EXPECT_TRUE(cache.getLevel(images[i].get(), 1));
+  EXPECT_EQ(64u * 4, cache.bytes());
+  EXPECT_EQ(first, cache.getLevel(images[0].get(), 1));
+
+  // The least recently used level (images[1]) is removed
+  EXPECT_TRUE(cache.getLevel(images[4].get(), 1));
+  EXPECT_EQ(64u * 4, cache.bytes());
+  EXPECT_EQ(first, cache.getLevel(images[0].get(), 1));
+
+  // Levels that use more than 1/4 of the cache are not created
+  ImageRef big(Image::create(IMAGE_RGB, 32, 32));
+  EXPECT_FALSE(cache.getLevel(big.get(), 1));
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
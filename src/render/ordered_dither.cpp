@@ -1,5 +1,5 @@
 // Aseprite Render Library
-// Copyright (c) 2019-2022  Igara Studio S.A.
+// Copyright (c) 2019-2026  Igara Studio S.A.
 // Copyright (c) 2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -11,15 +11,51 @@
 
 #include "render/ordered_dither.h"
 
+#include "doc/task_group.h"
 #include "render/dithering.h"
 #include "render/dithering_matrix.h"
 
 #include <algorithm>
+#include <atomic>
 #include <limits>
+#include <mutex>
 #include <vector>
 
 namespace render {
 
+namespace {
+
+// Minimum number of pixels of an image to dither its rows from
+// several threads, and minimum number of rows for each thread.
+const int kParallelDitherPixels = 256 * 256;
+const int kParallelDitherRows = 16;
+
+// Dithers the rows [y1, y2) of the image with a 1D algorithm (where
+// each pixel depends only on its source color and position).
+// Returns false if the task was canceled.
+template<typename PixelFunc, typename RowFunc>
+bool dither_rows(const doc::Image* srcImage,
+                 doc::Image* dstImage,
+                 const int y1,
+                 const int y2,
+                 PixelFunc&& ditherPixel,
+                 RowFunc&& rowDone)
+{
+  const int w = srcImage->width();
+  for (int y = y1; y < y2; ++y) {
+    auto srcIt = doc::get_pixel_address_fast<doc::RgbTraits>(srcImage, 0, y);
+    auto dstIt = doc::get_pixel_address_fast<doc::IndexedTraits>(dstImage, 0, y);
+    for (int x = 0; x < w; ++x, ++srcIt, ++dstIt)
+      *dstIt = ditherPixel(*srcIt, x, y);
+
+    if (!rowDone(y))
+      return false;
+  }
+  return true;
+}
+
+} // anonymous namespace
+
 // Base 2x2 dither matrix, called D(2):
 int BayerMatrix::D2[4] = { 0, 2, 3, 1 };
 
@@ -230,29 +266,65 @@ void dither_rgb_image_to_indexed(DitheringAlgorithmBase& algorithm,
   algorithm.start(srcImage, dstImage, dithering.factor());
 
   if (algorithm.dimensions() == 1) {
-    const doc::LockImageBits<doc::RgbTraits> srcBits(srcImage);
-    doc::LockImageBits<doc::IndexedTraits> dstBits(dstImage);
-    auto srcIt = srcBits.begin();
-    auto dstIt = dstBits.begin();
-
-    for (int y = 0; y < h; ++y) {
-      for (int x = 0; x < w; ++x, ++srcIt, ++dstIt) {
-        ASSERT(srcIt != srcBits.end());
-        ASSERT(dstIt != dstBits.end());
-        *dstIt = algorithm.ditherRgbPixelToIndex(dithering.matrix(), *srcIt, x, y, rgbmap, palette);
-
+    const DitheringMatrix& matrix = dithering.matrix();
+    auto ditherPixel = [&algorithm, &matrix, rgbmap, palette](const doc::color_t c,
+                                                               const int x,
+                                                               const int y) {
+      return algorithm.ditherRgbPixelToIndex(matrix, c, x, y, rgbmap, palette);
+    };
+
+    // 1D algorithms (ordered dithering) don't depend on other pixels,
+    // so big images are divided in bands of rows that are dithered
+    // from several threads (only if the RgbMap can be used from
+    // several threads).
+    const int nthreads = doc::task_threads();
+    const int bands = (rgbmap && rgbmap->isThreadSafe() && w * h >= kParallelDitherPixels ?
+                         std::min(nthreads, h / kParallelDitherRows) :
+                         1);
+
+    if (bands < 2) {
+      if (!dither_rows(srcImage, dstImage, 0, h, ditherPixel, [delegate, h](const int y) {
+            if (delegate) {
+              if (!delegate->continueTask())
+                return false;
+              delegate->notifyTaskProgress(double(y + 1) / double(h));
+            }
+            return true;
+          }))
+        return;
+    }
+    else {
+      std::mutex mutex;
+      int rowsDone = 0;
+      std::atomic<bool> canceled(false);
+
+      // The delegate is called from one thread at a time
+      auto rowDone = [delegate, h, &mutex, &rowsDone, &canceled](const int) {
+        if (canceled)
+          return false;
         if (delegate) {
-          if (!delegate->continueTask())
-            return;
+          const std::lock_guard lock(mutex);
+          if (!delegate->continueTask()) {
+            canceled = true;
+            return false;
+          }
+          delegate->notifyTaskProgress(double(++rowsDone) / double(h));
         }
+        return true;
+      };
+
+      doc::TaskGroup tasks;
+      for (int band = 0; band < bands; ++band) {
+        const int y1 = int(int64_t(h) * band / bands);
+        const int y2 = int(int64_t(h) * (band + 1) / bands);
+        tasks.run([&, y1, y2] { dither_rows(srcImage, dstImage, y1, y2, ditherPixel, rowDone); });
       }
-
-      if (delegate) {
-        delegate->notifyTaskProgress(double(y + 1) / double(h));
-      }
+      tasks.wait();
+      if (canceled)
+        return;
     }
   }
-  else {
+  else if (!algorithm.ditherInParallel(srcImage, dstImage, rgbmap, palette, delegate)) {
     auto dstIt = doc::get_pixel_address_fast<doc::IndexedTraits>(dstImage, 0, 0);
     const bool zigZag = algorithm.zigZag();
 
@@ -1,5 +1,5 @@
 // Aseprite Render Library
-// Copyright (c) 2019 Igara Studio S.A.
+// Copyright (c) 2019-2026 Igara Studio S.A.
 // Copyright (c) 2001-2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -50,6 +50,19 @@ public:
   {
     return 0;
   }
+
+  // Dithers the whole image from several threads (called after
+  // start()). Returns false if the algorithm cannot do it for this
+  // image, so dither_rgb_image_to_indexed() calls
+  // ditherRgbToIndex2D() for each pixel.
+  virtual bool ditherInParallel(const doc::Image* srcImage,
+                                doc::Image* dstImage,
+                                const doc::RgbMap* rgbmap,
+                                const doc::Palette* palette,
+                                TaskDelegate* delegate)
+  {
+    return false;
+  }
 };
 
 class OrderedDither : public DitheringAlgorithmBase {
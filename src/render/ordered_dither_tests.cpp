@@ -1,5 +1,5 @@
 // Aseprite Render Library
-// Copyright (c) 2019 Igara Studio S.A.
+// Copyright (c) 2019-2026 Igara Studio S.A.
 // Copyright (c) 2001-2017 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -11,8 +11,15 @@
 
 #include <gtest/gtest.h>
 
+#include "doc/image_ref.h"
+#include "doc/palette.h"
+#include "doc/primitives.h"
+#include "doc/rgbmap_precomputed.h"
+#include "render/dithering.h"
 #include "render/dithering_matrix.h"
+#include "render/error_diffusion.h"
 #include "render/ordered_dither.h"
+#include "render/quantization.h"
 
 using namespace doc;
 using namespace render;
@@ -51,6 +58,103 @@ TEST(BayerMatrix, CheckD8)
       EXPECT_EQ(expected[c++], matrix(i, j));
 }
 
+TEST(OrderedDither, ParallelRows)
+{
+  // Big enough image to be dithered from several threads
+  const int w = 300, h = 400;
+  ImageRef src(Image::create(IMAGE_RGB, w, h));
+  for (int y = 0; y < h; ++y)
+    for (int x = 0; x < w; ++x)
+      put_pixel(src.get(), x, y, rgba(x * 255 / w, y * 255 / h, (x + y) & 255, 255));
+
+  Palette palette(0, 16);
+  for (int i = 0; i < 16; ++i)
+    palette.setEntry(i, rgba(i * 17, 255 - i * 17, (i * 64) & 255, 255));
+
+  RgbMapPrecomputed rgbmap;
+  rgbmap.regenerateMap(&palette, -1);
+  EXPECT_TRUE(rgbmap.isThreadSafe());
+
+  const Dithering dithering(DitheringAlgorithm::Ordered, BayerMatrix::make(8));
+  OrderedDither2 dither;
+  ImageRef dst(Image::create(IMAGE_INDEXED, w, h));
+  dither_rgb_image_to_indexed(dither, dithering, src.get(), dst.get(), &rgbmap, &palette);
+
+  const DitheringMatrix matrix = dithering.matrix();
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      const color_t expected =
+        dither.ditherRgbPixelToIndex(matrix, get_pixel(src.get(), x, y), x, y, &rgbmap, &palette);
+      ASSERT_EQ(expected, get_pixel(dst.get(), x, y));
+    }
+  }
+}
+
+TEST(ErrorDiffusionDither, WavefrontSameAsSerial)
+{
+  const int w = 300, h = 400;
+  ImageRef src(Image::create(IMAGE_RGB, w, h));
+  for (int y = 0; y < h; ++y)
+    for (int x = 0; x < w; ++x)
+      put_pixel(src.get(), x, y, rgba(x * 255 / w, y * 255 / h, (x * y) & 255, 255));
+
+  Palette palette(0, 8);
+  for (int i = 0; i < 8; ++i)
+    palette.setEntry(i, rgba((i & 1) * 255, (i & 2) * 127, (i & 4) * 63, 255));
+
+  RgbMapPrecomputed rgbmap;
+  rgbmap.regenerateMap(&palette, -1);
+
+  // Dithered from several threads (without zig-zag)
+  const Dithering dithering(DitheringAlgorithm::ErrorDiffusion);
+  ErrorDiffusionDither parallelDither(-1, false);
+  ImageRef dst(Image::create(IMAGE_INDEXED, w, h));
+  dither_rgb_image_to_indexed(parallelDither, dithering, src.get(), dst.get(), &rgbmap, &palette);
+
+  // Serial order
+  ErrorDiffusionDither serialDither(-1, false);
+  serialDither.start(src.get(), nullptr, dithering.factor());
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      const color_t expected = serialDither.ditherRgbToIndex2D(x, y, &rgbmap, &palette);
+      ASSERT_EQ(expected, get_pixel(dst.get(), x, y));
+    }
+  }
+}
+
+TEST(ErrorDiffusionDither, LeftToRightRowOrder)
+{
+  const int w = 300, h = 400;
+  ImageRef src(Image::create(IMAGE_RGB, w, h));
+  for (int y = 0; y < h; ++y)
+    for (int x = 0; x < w; ++x)
+      put_pixel(src.get(), x, y, rgba(x * 255 / w, y * 255 / h, (x + y) & 255, 255));
+
+  Palette palette(0, 8);
+  for (int i = 0; i < 8; ++i)
+    palette.setEntry(i, rgba((i & 1) * 255, (i & 2) * 127, (i & 4) * 63, 255));
+
+  RgbMapPrecomputed rgbmap;
+  rgbmap.regenerateMap(&palette, -1);
+
+  // Converting an image with the left-to-right order must give the
+  // same result as the error diffusion without zig-zag (which is
+  // dithered from several threads for big images).
+  Dithering dithering(DitheringAlgorithm::ErrorDiffusion);
+  dithering.serpentine(false);
+  ImageRef dst(
+    convert_pixel_format(src.get(), nullptr, IMAGE_INDEXED, dithering, &rgbmap, &palette, true, 0));
+
+  ErrorDiffusionDither serialDither(-1, false);
+  serialDither.start(src.get(), nullptr, dithering.factor());
+  for (int y = 0; y < h; ++y) {
+    for (int x = 0; x < w; ++x) {
+      const color_t expected = serialDither.ditherRgbToIndex2D(x, y, &rgbmap, &palette);
+      ASSERT_EQ(expected, get_pixel(dst.get(), x, y));
+    }
+  }
+}
+
 int main(int argc, char** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
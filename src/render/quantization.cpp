@@ -1,5 +1,5 @@
 // Aseprite Render Library
-// Copyright (c) 2019-2022  Igara Studio S.A.
+// Copyright (c) 2019-2026  Igara Studio S.A.
 // Copyright (c) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -18,6 +18,7 @@
 #include "doc/primitives.h"
 #include "doc/remap.h"
 #include "doc/sprite.h"
+#include "doc/task_group.h"
 #include "render/dithering.h"
 #include "render/error_diffusion.h"
 #include "render/ordered_dither.h"
@@ -76,13 +77,17 @@ Palette* create_palette_from_sprite(const Sprite* sprite,
 
   render::Render render;
   render.setNewBlend(newBlend);
+  render.setParallelRender(true);
 
   // Feed the optimizer with all rendered frames
   for (frame_t frame = fromFrame; frame <= toFrame; ++frame) {
     render.renderSprite(flat_image.get(), sprite, frame);
 
     switch (mapAlgo) {
-      case RgbMapAlgorithm::RGB5A3: optimizer.feedWithImage(flat_image.get(), withAlpha); break;
+      case RgbMapAlgorithm::RGB5A3:
+      case RgbMapAlgorithm::PRECOMPUTED:
+        optimizer.feedWithImage(flat_image.get(), withAlpha);
+        break;
       case RgbMapAlgorithm::OCTREE:
         octreemap.feedWithImage(flat_image.get(), withAlpha, maskColor);
         break;
@@ -98,7 +103,8 @@ Palette* create_palette_from_sprite(const Sprite* sprite,
   }
 
   switch (mapAlgo) {
-    case RgbMapAlgorithm::RGB5A3: {
+    case RgbMapAlgorithm::RGB5A3:
+    case RgbMapAlgorithm::PRECOMPUTED: {
       // Generate an optimized palette
       optimizer.calculate(palette, maskIndex);
       break;
@@ -160,7 +166,8 @@ Image* convert_pixel_format(const Image* image,
         dither.reset(new OrderedDither(is_background ? -1 : new_mask_color));
         break;
       case DitheringAlgorithm::ErrorDiffusion:
-        dither.reset(new ErrorDiffusionDither(is_background ? -1 : new_mask_color));
+        dither.reset(
+          new ErrorDiffusionDither(is_background ? -1 : new_mask_color, dithering.serpentine()));
         break;
     }
     if (dither)
@@ -205,6 +212,22 @@ Image* convert_pixel_format(const Image* image,
 
         // RGB -> Indexed
         case IMAGE_INDEXED: {
+          // Map whole scanlines at once (faster with precomputed maps)
+          if (rgbmap) {
+            ASSERT(image->bounds() == new_image->bounds());
+            const int w = image->width();
+            for (int y = 0; y < image->height(); ++y) {
+              auto src = (const RgbTraits::pixel_t*)image->getPixelAddress(0, y);
+              auto dst = (IndexedTraits::pixel_t*)new_image->getPixelAddress(0, y);
+              rgbmap->mapColors(src, dst, w);
+              for (int x = 0; x < w; ++x) {
+                if (rgba_geta(src[x]) == 0)
+                  dst[x] = new_mask_color0;
+              }
+            }
+            break;
+          }
+
           LockImageBits<IndexedTraits> dstBits(new_image, Image::WriteLock);
           auto dst_it = dstBits.begin();
 #ifdef _DEBUG
@@ -222,8 +245,6 @@ Image* convert_pixel_format(const Image* image,
 
             if (a == 0)
               *dst_it = new_mask_color0;
-            else if (rgbmap)
-              *dst_it = rgbmap->mapColor(c);
             else
               *dst_it = palette->findBestfit(r, g, b, a, new_mask_color);
           }
@@ -382,25 +403,91 @@ Image* convert_pixel_format(const Image* image,
 // Creation of optimized palette for RGB images
 // by David Capello
 
-void PaletteOptimizer::feedWithImage(const Image* image, const bool withAlpha)
+namespace {
+
+// Minimum number of pixels of an image to feed the palette optimizer
+// in parallel, and minimum number of rows for each thread.
+const int kParallelFeedPixels = 256 * 256;
+const int kParallelFeedRows = 16;
+
+int quantization_threads()
 {
-  feedWithImage(image, image->bounds(), withAlpha);
+  return doc::task_threads();
 }
 
-void PaletteOptimizer::feedWithImage(const Image* image,
-                                     const gfx::Rect& bounds,
-                                     const bool withAlpha)
+// Calls f(i) for each i in [0, n) dividing the range in one chunk
+// for each thread of the task scheduler. It waits all calls to
+// finish.
+struct ParallelFor {
+  template<typename F>
+  void operator()(const int n, F&& f) const
+  {
+    const int chunks = std::min(n, quantization_threads());
+    if (chunks < 2) {
+      for (int i = 0; i < n; ++i)
+        f(i);
+      return;
+    }
+
+    doc::TaskGroup tasks;
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+      const int begin = int(int64_t(n) * chunk / chunks);
+      const int end = int(int64_t(n) * (chunk + 1) / chunks);
+      tasks.run([&f, begin, end] {
+        for (int i = begin; i < end; ++i)
+          f(i);
+      });
+    }
+    tasks.wait();
+  }
+};
+
+// Adds consecutive samples of the same color to the histogram at
+// once (images usually have big areas of the same color).
+template<typename Histogram>
+class RunsFeeder {
+public:
+  RunsFeeder(Histogram& histogram) : m_histogram(histogram) {}
+  ~RunsFeeder() { flush(); }
+
+  void add(const color_t color)
+  {
+    if (m_count > 0 && color == m_color) {
+      ++m_count;
+    }
+    else {
+      flush();
+      m_color = color;
+      m_count = 1;
+    }
+  }
+
+private:
+  void flush()
+  {
+    if (m_count > 0)
+      m_histogram.addSamples(m_color, m_count);
+  }
+
+  Histogram& m_histogram;
+  color_t m_color = 0;
+  std::size_t m_count = 0;
+};
+
+template<typename Histogram>
+void feed_histogram(Histogram& histogram,
+                    const Image* image,
+                    const gfx::Rect& bounds,
+                    const bool withAlpha)
 {
   uint32_t color;
 
-  if (withAlpha)
-    m_withAlpha = true;
-
   ASSERT(image);
   switch (image->pixelFormat()) {
     case IMAGE_RGB: {
       const LockImageBits<RgbTraits> bits(image, bounds);
       auto it = bits.begin(), end = bits.end();
+      RunsFeeder feeder(histogram);
 
       for (; it != end; ++it) {
         color = *it;
@@ -408,7 +495,7 @@ void PaletteOptimizer::feedWithImage(const Image* image,
           if (!withAlpha)
             color |= rgba(0, 0, 0, 255);
 
-          m_histogram.addSamples(color, 1);
+          feeder.add(color);
         }
       }
     } break;
@@ -416,6 +503,7 @@ void PaletteOptimizer::feedWithImage(const Image* image,
     case IMAGE_GRAYSCALE: {
       const LockImageBits<GrayscaleTraits> bits(image, bounds);
       auto it = bits.begin(), end = bits.end();
+      RunsFeeder feeder(histogram);
 
       for (; it != end; ++it) {
         color = *it;
@@ -424,9 +512,8 @@ void PaletteOptimizer::feedWithImage(const Image* image,
           if (!withAlpha)
             color = graya(graya_getv(color), 255);
 
-          m_histogram.addSamples(
-            rgba(graya_getv(color), graya_getv(color), graya_getv(color), graya_geta(color)),
-            1);
+          feeder.add(
+            rgba(graya_getv(color), graya_getv(color), graya_getv(color), graya_geta(color)));
         }
       }
     } break;
@@ -435,6 +522,57 @@ void PaletteOptimizer::feedWithImage(const Image* image,
   }
 }
 
+} // anonymous namespace
+
+void PaletteOptimizer::feedWithImage(const Image* image, const bool withAlpha)
+{
+  feedWithImage(image, image->bounds(), withAlpha);
+}
+
+void PaletteOptimizer::feedWithImage(const Image* image,
+                                     const gfx::Rect& bounds,
+                                     const bool withAlpha)
+{
+  if (withAlpha)
+    m_withAlpha = true;
+
+  if (bounds.w * bounds.h >= kParallelFeedPixels && bounds.h >= 2 * kParallelFeedRows &&
+      quantization_threads() > 1) {
+    feedInParallel(image, bounds, withAlpha);
+  }
+  else {
+    feed_histogram(m_histogram, image, bounds, withAlpha);
+  }
+}
+
+void PaletteOptimizer::feedInParallel(const Image* image,
+                                      const gfx::Rect& bounds,
+                                      const bool withAlpha)
+{
+  const int bands = std::min(quantization_threads(), bounds.h / kParallelFeedRows);
+  while (int(m_partials.size()) < bands)
+    m_partials.push_back(std::make_unique<Histogram>());
+
+  // Each partial histogram collects the high-precision colors of its
+  // band only (and only if we still need them).
+  for (int i = 0; i < bands; ++i)
+    m_partials[i]->resetHighPrecision(m_histogram.isHighPrecision());
+
+  ParallelFor()(bands, [this, image, &bounds, withAlpha, bands](const int i) {
+    const int y1 = bounds.y + bounds.h * i / bands;
+    const int y2 = bounds.y + bounds.h * (i + 1) / bands;
+    feed_histogram(*m_partials[i],
+                   image,
+                   gfx::Rect(bounds.x, y1, bounds.w, y2 - y1),
+                   withAlpha);
+  });
+
+  // Merge the high-precision colors in the same order as the rows
+  // of the image, so the palette doesn't depend on the threads.
+  for (int i = 0; i < bands; ++i)
+    m_histogram.mergeHighPrecision(*m_partials[i]);
+}
+
 void PaletteOptimizer::feedWithRgbaColor(color_t color)
 {
   m_histogram.addSamples(color, 1);
@@ -455,7 +593,11 @@ void PaletteOptimizer::calculate(Palette* palette, int maskIndex)
   // used, in other case the 0 indexed will be the mask color, so it
   // will not be used later in the color conversion (from RGB to
   // Indexed).
-  int usedColors = m_histogram.createOptimizedPalette(palette);
+  for (auto& partial : m_partials)
+    m_histogram.mergeSamples(*partial);
+  m_partials.clear();
+
+  int usedColors = m_histogram.createOptimizedPalette(palette, ParallelFor());
 
   if (addMask) {
     palette->resize(usedColors + 1);
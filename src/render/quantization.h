@@ -1,5 +1,5 @@
 // Aseprite Rener Library
-// Copyright (c) 2019-2021  Igara Studio S.A.
+// Copyright (c) 2019-2026  Igara Studio S.A.
 // Copyright (c) 2001-2017  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -14,6 +14,7 @@
 #include "doc/rgbmap_algorithm.h"
 #include "render/color_histogram.h"
 
+#include <memory>
 #include <vector>
 
 namespace doc {
@@ -29,6 +30,10 @@ class TaskDelegate;
 
 class PaletteOptimizer {
 public:
+  // Big images are fed in parallel (each thread fills a partial
+  // histogram with a band of rows) and the median-cut algorithm
+  // processes big boxes in parallel too. The result is the same as
+  // feeding all pixels in order in one thread.
   void feedWithImage(const doc::Image* image, const bool withAlpha);
   void feedWithImage(const doc::Image* image, const gfx::Rect& bounds, const bool withAlpha);
   void feedWithRgbaColor(doc::color_t color);
@@ -37,7 +42,14 @@ public:
   int highPrecisionSize() { return m_histogram.highPrecisionSize(); }
 
 private:
-  render::ColorHistogram<5, 6, 5, 5> m_histogram;
+  typedef render::ColorHistogram<5, 6, 5, 5> Histogram;
+
+  void feedInParallel(const doc::Image* image, const gfx::Rect& bounds, const bool withAlpha);
+
+  Histogram m_histogram;
+  // Partial histograms used by feedInParallel() (one for each band
+  // of rows), their samples are merged in calculate().
+  std::vector<std::unique_ptr<Histogram>> m_partials;
   bool m_withAlpha = false;
 };
 
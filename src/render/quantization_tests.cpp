@@ -0,0 +1,112 @@
+// Aseprite Render Library
+// Copyright (c) 2026 Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "doc/image.h"
+#include "doc/image_ref.h"
+#include "doc/palette.h"
+#include "doc/primitives.h"
+#include "render/quantization.h"
+
+#include <algorithm>
+#include <random>
+
+using namespace doc;
+using namespace render;
+
+namespace {
+
+ImageRef create_random_image(const int w, const int h, const int ncolors)
+{
+  std::mt19937 rng(w * h + ncolors);
+  std::vector<color_t> colors(ncolors);
+  for (auto& color : colors)
+    color = rgba(rng() % 256, rng() % 256, rng() % 256, 255);
+
+  ImageRef image(Image::create(IMAGE_RGB, w, h));
+  for (int y = 0; y < h; ++y)
+    for (int x = 0; x < w; ++x)
+      put_pixel(image.get(), x, y, colors[rng() % ncolors]);
+  return image;
+}
+
+// Compares the palette generated feeding the whole image (in
+// parallel) with the one generated feeding one row at a time.
+void expect_same_palette(const Image* image)
+{
+  PaletteOptimizer a, b;
+  a.feedWithImage(image, false);
+  for (int y = 0; y < image->height(); ++y)
+    b.feedWithImage(image, gfx::Rect(0, y, image->width(), 1), false);
+
+  EXPECT_EQ(a.isHighPrecision(), b.isHighPrecision());
+  EXPECT_EQ(a.highPrecisionSize(), b.highPrecisionSize());
+
+  Palette palA(0, 256), palB(0, 256);
+  a.calculate(&palA, 0);
+  b.calculate(&palB, 0);
+
+  ASSERT_EQ(palA.size(), palB.size());
+  for (int i = 0; i < palA.size(); ++i)
+    EXPECT_EQ(palA.getEntry(i), palB.getEntry(i)) << "Entry " << i;
+}
+
+} // anonymous namespace
+
+TEST(PaletteOptimizer, ParallelFeedHighPrecision)
+{
+  ImageRef image = create_random_image(512, 512, 200);
+  expect_same_palette(image.get());
+}
+
+TEST(PaletteOptimizer, ParallelFeedMedianCut)
+{
+  ImageRef image = create_random_image(512, 512, 5000);
+  expect_same_palette(image.get());
+}
+
+TEST(PaletteOptimizer, ExactColors)
+{
+  ImageRef image = create_random_image(64, 64, 256);
+
+  // Colors in order of appearance
+  std::vector<color_t> colors;
+  for (int y = 0; y < image->height(); ++y) {
+    for (int x = 0; x < image->width(); ++x) {
+      const color_t c = get_pixel(image.get(), x, y);
+      if (std::find(colors.begin(), colors.end(), c) == colors.end())
+        colors.push_back(c);
+    }
+  }
+
+  ASSERT_EQ(256u, colors.size());
+
+  PaletteOptimizer optimizer;
+  optimizer.feedWithImage(image.get(), false);
+  EXPECT_TRUE(optimizer.isHighPrecision());
+  EXPECT_EQ(int(colors.size()), optimizer.highPrecisionSize());
+
+  Palette palette(0, 256);
+  optimizer.calculate(&palette, -1);
+  ASSERT_EQ(int(colors.size()), palette.size());
+  for (int i = 0; i < palette.size(); ++i)
+    EXPECT_EQ(colors[i], palette.getEntry(i)) << "Entry " << i;
+
+  // One more color than the high-precision table
+  optimizer.feedWithRgbaColor(rgba(1, 2, 3, 255));
+  EXPECT_FALSE(optimizer.isHighPrecision());
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
@@ -1,5 +1,5 @@
 // Aseprite Render Library
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -16,20 +16,33 @@
 #include "doc/blend_mode.h"
 #include "doc/doc.h"
 #include "doc/image.h"
+#include "doc/image_buffer_pool.h"
 #include "doc/layer_tilemap.h"
 #include "doc/playback.h"
 #include "doc/render_plan.h"
+#include "doc/task_group.h"
 #include "doc/tileset.h"
 #include "doc/tilesets.h"
 #include "gfx/clip.h"
 #include "gfx/region.h"
+#include "render/mipmap_cache.h"
+#include "render/tilemap_cache.h"
+#include "tracing/metrics.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <vector>
 
 #define TRACE_RENDER_CEL(...) // TRACE
 
 namespace render {
 
+static tracing::Histogram g_spriteTime("render.sprite_us");
+static tracing::Counter g_belowLayersCacheHits("render.below_layers_cache.hits");
+static tracing::Counter g_belowLayersCacheMisses("render.below_layers_cache.misses");
+
 namespace {
 
 //////////////////////////////////////////////////////////////////////
@@ -64,6 +77,22 @@ void composite_image_without_scale(Image* dst,
 
   ASSERT(!srcBounds.isEmpty());
 
+  // RGBA -> RGBA can blend whole scanlines with the span blenders
+  if constexpr (std::is_same_v<DstTraits, RgbTraits> && std::is_same_v<SrcTraits, RgbTraits>) {
+    const BlendSpanFunc blendSpan = get_rgba_span_blender(blendMode, newBlend);
+    const color_t maskColor = src->maskColor();
+    const int w = std::min(srcBounds.w, dstBounds.w);
+    const int h = std::min(srcBounds.h, dstBounds.h);
+    for (int y = 0; y < h; ++y) {
+      blendSpan((RgbTraits::address_t)dst->getPixelAddress(dstBounds.x, dstBounds.y + y),
+                (RgbTraits::const_address_t)src->getPixelAddress(srcBounds.x, srcBounds.y + y),
+                w,
+                opacity,
+                maskColor);
+    }
+    return;
+  }
+
   // Lock all necessary bits
   const LockImageBits<SrcTraits> srcBits(src, srcBounds);
   LockImageBits<DstTraits> dstBits(dst, dstBounds);
@@ -487,6 +516,29 @@ void composite_image_general_with_tile_flags(Image* dst,
   }
 }
 
+// Composition function for images of the mipmap cache (only RGB and
+// grayscale images are reduced).
+CompositeImageFunc get_general_composition(const PixelFormat dstFormat,
+                                           const PixelFormat srcFormat)
+{
+  if (srcFormat == IMAGE_RGB) {
+    switch (dstFormat) {
+      case IMAGE_RGB:       return composite_image_general<RgbTraits, RgbTraits>;
+      case IMAGE_GRAYSCALE: return composite_image_general<GrayscaleTraits, RgbTraits>;
+      case IMAGE_INDEXED:   return composite_image_general<IndexedTraits, RgbTraits>;
+    }
+  }
+  else if (srcFormat == IMAGE_GRAYSCALE) {
+    switch (dstFormat) {
+      case IMAGE_RGB:       return composite_image_general<RgbTraits, GrayscaleTraits>;
+      case IMAGE_GRAYSCALE: return composite_image_general<GrayscaleTraits, GrayscaleTraits>;
+      case IMAGE_INDEXED:   return composite_image_general<IndexedTraits, GrayscaleTraits>;
+    }
+  }
+  ASSERT(false && "Invalid pixel formats");
+  return nullptr;
+}
+
 template<class DstTraits, class SrcTraits>
 CompositeImageFunc get_fastest_composition_path(const Projection& proj,
                                                 const bool finegrain,
@@ -528,6 +580,52 @@ bool has_visible_reference_layers(const LayerGroup* group)
   return false;
 }
 
+bool is_integral_clip(const gfx::ClipF& area)
+{
+  return (area.dst.x == std::floor(area.dst.x) && area.dst.y == std::floor(area.dst.y) &&
+          area.src.x == std::floor(area.src.x) && area.src.y == std::floor(area.src.y) &&
+          area.size.w == std::floor(area.size.w) && area.size.h == std::floor(area.size.h));
+}
+
+uint64_t double_key(const double value)
+{
+  uint64_t key;
+  std::memcpy(&key, &value, sizeof(key));
+  return key;
+}
+
+// Adds to the key everything that can modify the result of
+// rendering the given item of a RenderPlan.
+void add_plan_item_key(std::vector<uint64_t>& key, const RenderPlan::Item& item, const frame_t frame)
+{
+  const Layer* layer = item.layer;
+  key.insert(key.end(),
+             { uint64_t(uintptr_t(layer)),
+               uint64_t(layer->version()),
+               uint64_t(layer->opacity()),
+               uint64_t(layer->blendMode()),
+               uint64_t(layer->flags()) });
+
+  const Cel* cel = (item.cel ? item.cel : layer->cel(frame));
+  if (cel) {
+    const Image* celImage = cel->image();
+    key.insert(key.end(),
+               { uint64_t(uintptr_t(cel)),
+                 uint64_t(cel->version()),
+                 uint64_t(uint32_t(cel->position().x)),
+                 uint64_t(uint32_t(cel->position().y)),
+                 uint64_t(cel->opacity()),
+                 uint64_t(uint32_t(cel->zIndex())),
+                 uint64_t(uintptr_t(celImage)),
+                 uint64_t(celImage ? celImage->version() : 0) });
+  }
+  if (layer->isTilemap()) {
+    const Tileset* tileset = static_cast<const LayerTilemap*>(layer)->tileset();
+    key.insert(key.end(),
+               { uint64_t(uintptr_t(tileset)), uint64_t(tileset ? tileset->version() : 0) });
+  }
+}
+
 } // anonymous namespace
 
 Render::Render()
@@ -589,6 +687,12 @@ void Render::setSelectedLayer(const Layer* layer)
   m_selectedLayerForOpacity = layer;
 }
 
+void Render::setParallelRender(const bool state, const int tileSize)
+{
+  ASSERT(!state || tileSize > 0);
+  m_parallelTileSize = (state ? std::max(1, tileSize) : 0);
+}
+
 void Render::setPreviewImage(const Layer* layer,
                              const frame_t frame,
                              const Image* image,
@@ -623,6 +727,24 @@ void Render::removePreviewImage()
 {
   m_previewImage = nullptr;
   m_previewTileset = nullptr;
+  m_belowLayersCache.reset();
+}
+
+void Render::setMipmaps(const bool state)
+{
+  m_useMipmaps = state;
+}
+
+void Render::setTilemapCache(const bool state)
+{
+  m_useTilemapCache = state;
+}
+
+void Render::setBelowLayersCache(const bool state)
+{
+  m_useBelowLayersCache = state;
+  if (!state)
+    m_belowLayersCache.reset();
 }
 
 void Render::removeExtraImage()
@@ -668,15 +790,27 @@ void Render::renderLayer(Image* dstImage,
 
   m_globalOpacity = 255;
 
-  doc::RenderPlan plan(m_composeGroups);
-  plan.addLayer(layer, frame);
-  renderPlan(plan, dstImage, area, frame, compositeImage, true, true, blendMode);
+  const auto plan = m_renderPlans->plan(layer, frame, m_composeGroups);
+  renderPlan(*plan, dstImage, area, frame, compositeImage, true, true, blendMode);
 }
 
 void Render::renderSprite(Image* dstImage,
                           const Sprite* sprite,
                           frame_t frame,
                           const gfx::ClipF& area)
+{
+  const tracing::Histogram::Timer timer(g_spriteTime);
+
+  if (m_parallelTileSize > 0 && renderSpriteInParallel(dstImage, sprite, frame, area))
+    return;
+
+  renderSpriteArea(dstImage, sprite, frame, area);
+}
+
+void Render::renderSpriteArea(Image* dstImage,
+                              const Sprite* sprite,
+                              frame_t frame,
+                              const gfx::ClipF& area)
 {
   m_sprite = sprite;
 
@@ -706,15 +840,14 @@ void Render::renderSprite(Image* dstImage,
     fill_rect(dstImage, area.dstBounds(), bg_color);
 
     // Draw the Background layer - Onion skin behind the sprite - Transparent Layers
-    renderSpriteLayers(dstImage, area, frame, compositeImage);
+    renderSpriteLayers(dstImage, area, frame, compositeImage, bg_color);
 
     // In case that we need a special background (e.g. like the
     // checkered pattern), we can draw the background in a temporal
     // image and then merge this temporal image with the dstImage.
     if (!isSolidBackground(bgLayer, bg_color)) {
-      if (!m_tmpBuf)
-        m_tmpBuf.reset(new doc::ImageBuffer);
-      ImageRef tmpBackground(Image::create(dstImage->spec(), m_tmpBuf));
+      ImageRef tmpBackground(
+        Image::create(dstImage->spec(), ImageBufferPool::instance()->get(dstImage->spec())));
       renderBackground(tmpBackground.get(), bgLayer, bg_color, area);
 
       // Draws dstImage over the background on each pixel of dstImage
@@ -731,7 +864,7 @@ void Render::renderSprite(Image* dstImage,
   // Old Blending Method:
   else {
     renderBackground(dstImage, bgLayer, bg_color, area);
-    renderSpriteLayers(dstImage, area, frame, compositeImage);
+    renderSpriteLayers(dstImage, area, frame, compositeImage, bg_color);
   }
 
   // Draw onion skin in front of the sprite.
@@ -752,17 +885,99 @@ void Render::renderSprite(Image* dstImage,
   }
 }
 
+bool Render::renderSpriteInParallel(Image* dstImage,
+                                    const Sprite* sprite,
+                                    frame_t frame,
+                                    const gfx::ClipF& area)
+{
+  // Fractional areas are rendered in one pass, splitting them could
+  // change the rounding of each pixel.
+  if (!is_integral_clip(area))
+    return false;
+
+  // Only the part of the area that is inside the destination image.
+  const gfx::Clip clip(area);
+  const gfx::Rect dstBounds = clip.dstBounds().createIntersection(dstImage->bounds());
+  if (dstBounds.isEmpty())
+    return true;
+
+  // The checkered pattern is aligned to the origin of the
+  // destination image, so we cannot move the tiles to the origin of
+  // their own images when the area is displaced.
+  if (m_bg.type == BgType::CHECKERED && (clip.dst.x != 0 || clip.dst.y != 0))
+    return false;
+
+  const int tileSize = m_parallelTileSize;
+  if (doc::task_threads() < 2 || (dstBounds.w <= tileSize && dstBounds.h <= tileSize))
+    return false;
+
+  std::vector<gfx::Rect> tiles;
+  for (int y = dstBounds.y; y < dstBounds.y2(); y += tileSize) {
+    for (int x = dstBounds.x; x < dstBounds.x2(); x += tileSize) {
+      tiles.push_back(gfx::Rect(x, y, tileSize, tileSize).createIntersection(dstBounds));
+    }
+  }
+
+  // The tiles share the cache of the layers below the edited one (it
+  // must be created here, or each copy would create its own cache).
+  // Areas bigger than the maximum cached image are not cached, or
+  // each tile would discard the image created by the previous one.
+  const gfx::Rect srcBounds(dstBounds.origin() - clip.dst + clip.src, dstBounds.size());
+  const bool useBelowLayersCache = (m_useBelowLayersCache &&
+                                    srcBounds.w * srcBounds.h <= BelowLayersCache::kMaxPixels);
+  if (useBelowLayersCache && !m_belowLayersCache)
+    m_belowLayersCache = std::make_shared<BelowLayersCache>();
+
+  // The user is waiting the rendered image (e.g. the editor)
+  doc::TaskGroup tasks(doc::TaskPriority::Critical);
+  for (const gfx::Rect& tile : tiles) {
+    tasks.run([this, tile, clip, srcBounds, useBelowLayersCache, dstImage, sprite, frame]() {
+      // Each tile uses its own copy of the Render state (the render
+      // process modifies some members like m_globalOpacity).
+      Render tileRender(*this);
+      tileRender.m_parallelTileSize = 0;
+      tileRender.m_useBelowLayersCache = useBelowLayersCache;
+      tileRender.m_belowLayersParallelArea = srcBounds;
+
+      // Each tile is rendered in its own image so the background
+      // composition (which works with the whole image) doesn't touch
+      // pixels of other tiles.
+      const ImageSpec tileSpec(dstImage->colorMode(), tile.w, tile.h);
+      ImageRef tileImage(Image::create(tileSpec, ImageBufferPool::instance()->get(tileSpec)));
+      tileImage->setMaskColor(dstImage->maskColor());
+      tileRender.renderSpriteArea(tileImage.get(),
+                                  sprite,
+                                  frame,
+                                  gfx::ClipF(gfx::Clip(0,
+                                                       0,
+                                                       clip.src.x + tile.x - clip.dst.x,
+                                                       clip.src.y + tile.y - clip.dst.y,
+                                                       tile.w,
+                                                       tile.h)));
+      copy_image(dstImage, tileImage.get(), tile.x, tile.y);
+    });
+  }
+  tasks.wait();
+
+  m_sprite = sprite;
+  return true;
+}
+
 void Render::renderSpriteLayers(Image* dstImage,
                                 const gfx::ClipF& area,
                                 frame_t frame,
-                                CompositeImageFunc compositeImage)
+                                CompositeImageFunc compositeImage,
+                                const color_t bg_color)
 {
-  doc::RenderPlan plan(m_composeGroups);
-  plan.addLayer(m_sprite->root(), frame);
+  const auto plan = m_renderPlans->plan(m_sprite->root(), frame, m_composeGroups);
+
+  if (m_useBelowLayersCache &&
+      renderSpriteLayersWithCache(*plan, dstImage, area, frame, compositeImage, bg_color))
+    return;
 
   // Draw the background layer.
   m_globalOpacity = 255;
-  renderPlan(plan, dstImage, area, frame, compositeImage, true, false, BlendMode::UNSPECIFIED);
+  renderPlan(*plan, dstImage, area, frame, compositeImage, true, false, BlendMode::UNSPECIFIED);
 
   // Draw onion skin behind the sprite.
   if (m_onionskin.position() == OnionskinPosition::BEHIND)
@@ -770,7 +985,172 @@ void Render::renderSpriteLayers(Image* dstImage,
 
   // Draw the transparent layers.
   m_globalOpacity = 255;
-  renderPlan(plan, dstImage, area, frame, compositeImage, false, true, BlendMode::UNSPECIFIED);
+  renderPlan(*plan, dstImage, area, frame, compositeImage, false, true, BlendMode::UNSPECIFIED);
+}
+
+bool Render::renderSpriteLayersWithCache(const RenderPlan& plan,
+                                         Image* dstImage,
+                                         const gfx::ClipF& area,
+                                         frame_t frame,
+                                         CompositeImageFunc compositeImage,
+                                         const color_t bg_color)
+{
+  // The cache is used only while we are editing a layer (there is a
+  // preview image) with the new blending method, and when the plan
+  // can be split in two parts without changing the rendering order.
+  if (!m_previewImage || !m_selectedLayer || m_selectedFrame != frame || !m_newBlendMethod ||
+      m_composeGroups || !is_integral_clip(area) ||
+      (m_onionskin.type() != OnionskinType::NONE &&
+       m_onionskin.position() != OnionskinPosition::BEHIND))
+    return false;
+
+  const RenderPlan::Items& items = plan.items();
+  auto editedIt = std::find_if(items.begin(), items.end(), [this](const RenderPlan::Item& item) {
+    return item.layer == m_selectedLayer;
+  });
+  if (editedIt == items.begin() || editedIt == items.end())
+    return false;
+
+  // Key of the cached image, it must contain everything that can
+  // modify the result of rendering the layers below the edited one.
+  std::vector<uint64_t> key;
+  const Palette* pal = m_sprite->palette(frame);
+  key.insert(key.end(),
+             { uint64_t(uintptr_t(m_sprite)),
+               uint64_t(m_sprite->version()),
+               uint64_t(uintptr_t(m_selectedLayer)),
+               uint64_t(frame),
+               uint64_t(dstImage->pixelFormat()),
+               uint64_t(bg_color),
+               uint64_t(uintptr_t(pal)),
+               uint64_t(pal->version()),
+               double_key(m_proj.scaleX()),
+               double_key(m_proj.scaleY()),
+               uint64_t(m_flags),
+               uint64_t(m_nonactiveLayersOpacity),
+               uint64_t(uintptr_t(m_selectedLayerForOpacity)) });
+
+  for (auto it = items.begin(); it != items.end(); ++it) {
+    const Layer* layer = it->layer;
+
+    // The extra cel is drawn in the middle of the plan, and a
+    // background layer above the edited one would be drawn in the
+    // first pass (before the layers below).
+    if (m_extraCel && m_extraImage && layer == m_currentLayer && it < editedIt)
+      return false;
+    if (layer->isBackground() && it >= editedIt)
+      return false;
+    if (it >= editedIt)
+      continue;
+
+    add_plan_item_key(key, *it, frame);
+  }
+
+  // The onion skin behind the sprite is drawn between the background
+  // layer and the transparent layers, so it can be cached with the
+  // layers below the edited one (the other frames don't change while
+  // we edit the current one).
+  const bool cacheOnionskin = (m_onionskin.type() != OnionskinType::NONE);
+  if (cacheOnionskin && !addOnionskinKey(key, frame))
+    return false;
+
+  // Area to render (in "area.src" coordinates) clipped to the
+  // destination image.
+  const gfx::Clip clip(area);
+  const gfx::Rect dstBounds = clip.dstBounds().createIntersection(dstImage->bounds());
+  if (dstBounds.isEmpty())
+    return true;
+  const gfx::Rect srcBounds(dstBounds.origin() - clip.dst + clip.src, dstBounds.size());
+
+  if (!m_belowLayersCache)
+    m_belowLayersCache = std::make_shared<BelowLayersCache>();
+  BelowLayersCache& cache = *m_belowLayersCache;
+
+  // Tiles of a parallel render update the cache one at a time, the
+  // pixels of the cache are copied to "dstImage" outside the lock (each
+  // tile reads a different part of the image, and the image is kept
+  // alive by our reference even if another tile replaces it).
+  std::unique_lock lock(cache.mutex);
+
+  if (cache.key != key || !cache.image || !cache.bounds.contains(srcBounds) ||
+      cache.image->pixelFormat() != dstImage->pixelFormat()) {
+    gfx::Rect bounds = srcBounds;
+    if (!m_belowLayersParallelArea.isEmpty())
+      bounds |= m_belowLayersParallelArea;
+    if (cache.key == key && cache.image) {
+      const gfx::Rect unionBounds = bounds | cache.bounds;
+      if (unionBounds.w * unionBounds.h <= BelowLayersCache::kMaxPixels)
+        bounds = unionBounds;
+    }
+    if (bounds.w * bounds.h > BelowLayersCache::kMaxPixels)
+      return false;
+
+    cache.key = std::move(key);
+    cache.image.reset(Image::create(dstImage->pixelFormat(), bounds.w, bounds.h));
+    cache.bounds = bounds;
+    cache.valid.clear();
+  }
+
+  // Render the layers below the edited one in the parts of the
+  // cached image that weren't rendered yet.
+  gfx::Region missing(srcBounds);
+  missing -= cache.valid;
+  if (missing.isEmpty())
+    g_belowLayersCacheHits.add();
+  else
+    g_belowLayersCacheMisses.add();
+  for (const gfx::Rect& rc : missing) {
+    const gfx::Clip rcClip(rc.x - cache.bounds.x, rc.y - cache.bounds.y, rc);
+    fill_rect(cache.image.get(), rcClip.dstBounds(), bg_color);
+
+    m_globalOpacity = 255;
+    renderPlanItems(items.begin(),
+                    editedIt,
+                    cache.image.get(),
+                    rcClip,
+                    frame,
+                    compositeImage,
+                    true,
+                    false,
+                    BlendMode::UNSPECIFIED);
+
+    if (cacheOnionskin) {
+      renderOnionskin(cache.image.get(), rcClip, frame, compositeImage);
+      m_globalOpacity = 255;
+    }
+
+    renderPlanItems(items.begin(),
+                    editedIt,
+                    cache.image.get(),
+                    rcClip,
+                    frame,
+                    compositeImage,
+                    false,
+                    true,
+                    BlendMode::UNSPECIFIED);
+  }
+  cache.valid |= missing;
+
+  const ImageRef cachedImage = cache.image;
+  const gfx::Point cachedOrigin = cache.bounds.origin();
+  lock.unlock();
+
+  // Copy the cached layers and draw the edited layer and the ones
+  // above it.
+  dstImage->copy(cachedImage.get(),
+                 gfx::Clip(dstBounds.origin(), gfx::Rect(srcBounds).offset(-cachedOrigin)));
+
+  m_globalOpacity = 255;
+  renderPlanItems(editedIt,
+                  items.end(),
+                  dstImage,
+                  clip,
+                  frame,
+                  compositeImage,
+                  false,
+                  true,
+                  BlendMode::UNSPECIFIED);
+  return true;
 }
 
 void Render::renderBackground(Image* image,
@@ -822,63 +1202,109 @@ void Render::renderOnionskin(Image* dstImage,
 {
   // Onion-skin feature: Draw previous/next frames with different
   // opacity (<255)
-  if (m_onionskin.type() != OnionskinType::NONE) {
-    Tag* loop = m_onionskin.loopTag();
-    Layer* onionLayer = (m_onionskin.layer() ? m_onionskin.layer() : m_sprite->root());
-    Playback play(m_sprite,
-                  TagsList(), // TODO add an onionskin option to iterate subtags
-                  frame,
-                  loop ? Playback::PlayInLoop : Playback::PlayAll,
-                  loop);
-    frame_t prevFrames = (loop ? m_onionskin.prevFrames() :
-                                 std::min(frame, m_onionskin.prevFrames()));
-    play.nextFrame(-prevFrames);
-
-    for (frame_t frameOut = frame - prevFrames; frameOut <= frame + m_onionskin.nextFrames();
-         ++frameOut, play.nextFrame()) {
-      const frame_t frameIn = play.frame();
-
-      if (frameIn == frame || frameIn < 0 || frameIn > m_sprite->lastFrame()) {
-        continue;
-      }
+  Layer* onionLayer = (m_onionskin.layer() ? m_onionskin.layer() : m_sprite->root());
+  forEachOnionskinFrame(frame, [&](const frame_t frameIn, const frame_t frameOut) {
+    if (frameOut < frame) {
+      m_globalOpacity = m_onionskin.opacityBase() -
+                        m_onionskin.opacityStep() * ((frame - frameOut) - 1);
+    }
+    else {
+      m_globalOpacity = m_onionskin.opacityBase() -
+                        m_onionskin.opacityStep() * ((frameOut - frame) - 1);
+    }
 
-      if (frameOut < frame) {
-        m_globalOpacity = m_onionskin.opacityBase() -
-                          m_onionskin.opacityStep() * ((frame - frameOut) - 1);
-      }
-      else {
-        m_globalOpacity = m_onionskin.opacityBase() -
-                          m_onionskin.opacityStep() * ((frameOut - frame) - 1);
-      }
+    m_globalOpacity = std::clamp(m_globalOpacity, 0, 255);
+    if (m_globalOpacity > 0) {
+      BlendMode blendMode = BlendMode::UNSPECIFIED;
+      if (m_onionskin.type() == OnionskinType::MERGE)
+        blendMode = BlendMode::NORMAL;
+      else if (m_onionskin.type() == OnionskinType::RED_BLUE_TINT)
+        blendMode = (frameOut < frame ? BlendMode::RED_TINT : BlendMode::BLUE_TINT);
+
+      const auto plan = m_renderPlans->plan(onionLayer, frameIn, m_composeGroups);
+      renderPlan(*plan,
+                 dstImage,
+                 area,
+                 frameIn,
+                 compositeImage,
+                 // Render background only for "in-front" onion skinning and
+                 // when opacity is < 255
+                 (m_globalOpacity < 255 && m_onionskin.position() == OnionskinPosition::INFRONT),
+                 true,
+                 blendMode);
+    }
+  });
+}
 
-      m_globalOpacity = std::clamp(m_globalOpacity, 0, 255);
-      if (m_globalOpacity > 0) {
-        BlendMode blendMode = BlendMode::UNSPECIFIED;
-        if (m_onionskin.type() == OnionskinType::MERGE)
-          blendMode = BlendMode::NORMAL;
-        else if (m_onionskin.type() == OnionskinType::RED_BLUE_TINT)
-          blendMode = (frameOut < frame ? BlendMode::RED_TINT : BlendMode::BLUE_TINT);
-
-        doc::RenderPlan plan(m_composeGroups);
-        plan.addLayer(onionLayer, frameIn);
-        renderPlan(plan,
-                   dstImage,
-                   area,
-                   frameIn,
-                   compositeImage,
-                   // Render background only for "in-front" onion skinning and
-                   // when opacity is < 255
-                   (m_globalOpacity < 255 && m_onionskin.position() == OnionskinPosition::INFRONT),
-                   true,
-                   blendMode);
+template<typename Func>
+void Render::forEachOnionskinFrame(const frame_t frame, Func&& func) const
+{
+  if (m_onionskin.type() == OnionskinType::NONE)
+    return;
+
+  Tag* loop = m_onionskin.loopTag();
+  Playback play(m_sprite,
+                TagsList(), // TODO add an onionskin option to iterate subtags
+                frame,
+                loop ? Playback::PlayInLoop : Playback::PlayAll,
+                loop);
+  frame_t prevFrames = (loop ? m_onionskin.prevFrames() :
+                               std::min(frame, m_onionskin.prevFrames()));
+  play.nextFrame(-prevFrames);
+
+  for (frame_t frameOut = frame - prevFrames; frameOut <= frame + m_onionskin.nextFrames();
+       ++frameOut, play.nextFrame()) {
+    const frame_t frameIn = play.frame();
+    if (frameIn == frame || frameIn < 0 || frameIn > m_sprite->lastFrame())
+      continue;
+
+    func(frameIn, frameOut);
+  }
+}
+
+bool Render::addOnionskinKey(std::vector<uint64_t>& key, const frame_t frame) const
+{
+  const Layer* onionLayer = (m_onionskin.layer() ? m_onionskin.layer() : m_sprite->root());
+  key.insert(key.end(),
+             { uint64_t(m_onionskin.type()),
+               uint64_t(m_onionskin.position()),
+               uint64_t(m_onionskin.opacityBase()),
+               uint64_t(m_onionskin.opacityStep()),
+               uint64_t(uintptr_t(onionLayer)) });
+
+  bool result = true;
+  forEachOnionskinFrame(frame, [&](const frame_t frameIn, const frame_t frameOut) {
+    const Palette* pal = m_sprite->palette(frameIn);
+    key.insert(key.end(),
+               { uint64_t(frameIn),
+                 uint64_t(frameOut),
+                 uint64_t(uintptr_t(pal)),
+                 uint64_t(pal->version()) });
+
+    const auto plan = m_renderPlans->plan(onionLayer, frameIn, m_composeGroups);
+    for (const RenderPlan::Item& item : plan->items()) {
+      // Cels linked to the edited one (or to the extra cel) show the
+      // preview image, so they change while we are editing.
+      const Cel* cel = (item.cel ? item.cel : item.layer->cel(frameIn));
+      if (cel) {
+        const Cel* editedCel =
+          (item.layer == m_selectedLayer ? item.layer->cel(m_selectedFrame) : nullptr);
+        const Cel* extraCel = (m_extraCel && m_extraImage && item.layer == m_currentLayer ?
+                                 item.layer->cel(m_extraCel->frame()) :
+                                 nullptr);
+        if ((editedCel && editedCel->data() == cel->data()) ||
+            (extraCel && extraCel->data() == cel->data())) {
+          result = false;
+        }
       }
+      add_plan_item_key(key, item, frameIn);
     }
-  }
+  });
+  return result;
 }
 
 void Render::renderCheckeredBackground(Image* image, const gfx::Clip& area)
 {
-  int x, y, u, v;
   int tile_w = m_bg.stripeSize.w;
   int tile_h = m_bg.stripeSize.h;
 
@@ -894,14 +1320,16 @@ void Render::renderCheckeredBackground(Image* image, const gfx::Clip& area)
     tile_h = 1;
 
   // Tile position (u,v) is the number of tile we start in "area.src" coordinate
-  u = (area.src.x / tile_w);
-  v = (area.src.y / tile_h);
+  const int u = (area.src.x / tile_w);
+  const int v = (area.src.y / tile_h);
 
   // Position where we start drawing the first tile in "image"
-  int x_start = -(area.src.x % tile_w);
-  int y_start = -(area.src.y % tile_h);
+  const int x_start = -(area.src.x % tile_w);
+  const int y_start = -(area.src.y % tile_h);
 
-  gfx::Rect dstBounds = area.dstBounds();
+  const gfx::Rect dstBounds = area.dstBounds().createIntersection(image->bounds());
+  if (dstBounds.isEmpty())
+    return;
 
   // Fix background colors (make them opaque)
   ASSERT(m_bg.colorPixelFormat == image->pixelFormat());
@@ -916,22 +1344,48 @@ void Render::renderCheckeredBackground(Image* image, const gfx::Clip& area)
       break;
   }
 
-  // Draw checkered background (tile by tile)
-  int u_start = u;
-  for (y = y_start - tile_h; y < image->height() + tile_h; y += tile_h) {
-    for (x = x_start - tile_w; x < image->width() + tile_w; x += tile_w) {
-      gfx::Rect fillRc = dstBounds.createIntersection(gfx::Rect(x, y, tile_w, tile_h));
-      if (!fillRc.isEmpty())
-        fill_rect(image,
-                  fillRc.x,
-                  fillRc.y,
-                  fillRc.x + fillRc.w - 1,
-                  fillRc.y + fillRc.h - 1,
-                  (((u + v)) & 1) ? m_bg.color2 : m_bg.color1);
-      ++u;
+  // Number of the tile (in the row or column) where the given
+  // pixel of the image is (the first tile is drawn one tile before
+  // x_start/y_start).
+  auto tileIndex = [](const int pos, const int start, const int index, const int size) {
+    const int d = pos - start + size;
+    return index + (d >= 0 ? d / size : -((size - 1 - d) / size));
+  };
+
+  // The two kind of rows of the pattern (starting with color1 or
+  // color2) are cached, so each row of the image is just a copy of
+  // one of them.
+  const int parity = (tileIndex(dstBounds.x, x_start, u, tile_w) & 1);
+  const int phase = ((dstBounds.x - x_start) % tile_w + tile_w) % tile_w;
+  CheckeredRows& cache = m_checkeredRows;
+  if (!cache.image || cache.image->pixelFormat() != image->pixelFormat() ||
+      cache.image->width() != dstBounds.w || cache.color1 != m_bg.color1 ||
+      cache.color2 != m_bg.color2 || cache.tileWidth != tile_w || cache.phase != phase ||
+      cache.parity != parity) {
+    // Create a new image (instead of modifying the old one) because
+    // render copies used in parallel tiles share the cached image.
+    ImageRef rows(Image::create(image->pixelFormat(), dstBounds.w, 2));
+    for (int row = 0; row < 2; ++row) {
+      for (int x = 0; x < dstBounds.w; ++x) {
+        const int col = parity + (phase + x) / tile_w;
+        put_pixel(rows.get(), x, row, ((col + row) & 1) ? m_bg.color2 : m_bg.color1);
+      }
     }
-    u = u_start;
-    ++v;
+    cache.image = rows;
+    cache.color1 = m_bg.color1;
+    cache.color2 = m_bg.color2;
+    cache.tileWidth = tile_w;
+    cache.phase = phase;
+    cache.parity = parity;
+  }
+
+  // Draw checkered background (row by row)
+  const std::size_t rowBytes = std::size_t(dstBounds.w) * image->bytesPerPixel();
+  for (int y = dstBounds.y; y < dstBounds.y2(); ++y) {
+    const int row = (tileIndex(y, y_start, v, tile_h) & 1);
+    std::memcpy(image->getPixelAddress(dstBounds.x, y),
+                cache.image->getPixelAddress(0, row),
+                rowBytes);
   }
 }
 
@@ -963,7 +1417,7 @@ void Render::renderImage(Image* dst_image,
     tileFlags);
 }
 
-void Render::renderPlan(RenderPlan& plan,
+void Render::renderPlan(const RenderPlan& plan,
                         Image* image,
                         const gfx::Clip& area,
                         const frame_t frame,
@@ -972,7 +1426,30 @@ void Render::renderPlan(RenderPlan& plan,
                         const bool render_transparent,
                         const BlendMode blendMode)
 {
-  for (const auto& item : plan.items()) {
+  const RenderPlan::Items& items = plan.items();
+  renderPlanItems(items.begin(),
+                  items.end(),
+                  image,
+                  area,
+                  frame,
+                  compositeImage,
+                  render_background,
+                  render_transparent,
+                  blendMode);
+}
+
+void Render::renderPlanItems(RenderPlan::Items::const_iterator begin,
+                             RenderPlan::Items::const_iterator end,
+                             Image* image,
+                             const gfx::Clip& area,
+                             const frame_t frame,
+                             const CompositeImageFunc compositeImage,
+                             const bool render_background,
+                             const bool render_transparent,
+                             const BlendMode blendMode)
+{
+  for (auto it = begin; it != end; ++it) {
+    const RenderPlan::Item& item = *it;
     const Cel* cel = item.cel;
     const Layer* layer = item.layer;
 
@@ -1049,6 +1526,12 @@ void Render::renderPlan(RenderPlan& plan,
           }
           // If not, we use the original cel-image from the images' stock
           else {
+            // Skip cels outside the rendered area without accessing
+            // their images
+            if (!layer->isReference() &&
+                !m_proj.apply(cel->bounds()).enlarge(1).intersects(area.srcBounds()))
+              break;
+
             celImage = cel->image();
             if (layer->isReference())
               celBounds = cel->boundsF();
@@ -1264,6 +1747,27 @@ void Render::renderCel(Image* dst_image,
         return;
     }
 
+    // Tilemaps of the sprite are rendered as one rasterized image
+    // (which is updated only when tiles are modified).
+    if (m_useTilemapCache && cel && cel_image == cel->image() &&
+        tileset == tilemapLayer->tileset() && dst_image->pixelFormat() != IMAGE_TILEMAP) {
+      if (ImageRef image = TilemapCache::instance()->getImage(cel_image, tileset)) {
+        const gfx::RectF imageBounds(grid.tileToCanvas(cel_image->bounds()));
+        if (!m_useMipmaps ||
+            !renderMipmap(dst_image, image.get(), pal, imageBounds, area, opacity, blendMode)) {
+          renderImage(dst_image,
+                      image.get(),
+                      pal,
+                      imageBounds,
+                      area,
+                      compositeImage,
+                      opacity,
+                      blendMode);
+        }
+        return;
+      }
+    }
+
     gfx::Rect tilesToDraw = grid.canvasToTile(m_proj.remove(gfx::Rect(area.src, area.size)));
 
     int yPixelsPerTile = m_proj.applyY(grid.tileSize().h);
@@ -1329,10 +1833,49 @@ void Render::renderCel(Image* dst_image,
     }
   }
   else {
+    // Use a reduced version of the cel image when the sprite is zoomed
+    // out (only for images of the sprite, not preview/extra images).
+    if (m_useMipmaps && cel && cel_image == cel->image() &&
+        renderMipmap(dst_image, cel_image, pal, celBounds, area, opacity, blendMode)) {
+      return;
+    }
+
     renderImage(dst_image, cel_image, pal, celBounds, area, compositeImage, opacity, blendMode);
   }
 }
 
+bool Render::renderMipmap(Image* dst_image,
+                          const Image* image,
+                          const Palette* pal,
+                          const gfx::RectF& imageBounds,
+                          const gfx::Clip& area,
+                          const int opacity,
+                          const BlendMode blendMode)
+{
+  const double scale = std::max(m_proj.scaleX() * imageBounds.w / double(image->width()),
+                                m_proj.scaleY() * imageBounds.h / double(image->height()));
+  const int level = MipmapCache::levelForScale(scale);
+  if (level < 1)
+    return false;
+
+  ImageRef mipmap = MipmapCache::instance()->getLevel(image, level);
+  if (!mipmap)
+    return false;
+
+  // The scale of the reduced image is not a simple zoom level (e.g.
+  // if the size of the image is odd), so we use the general
+  // composition function.
+  renderImage(dst_image,
+              mipmap.get(),
+              pal,
+              imageBounds,
+              area,
+              get_general_composition(dst_image->pixelFormat(), mipmap->pixelFormat()),
+              opacity,
+              blendMode);
+  return true;
+}
+
 void Render::renderImage(Image* dst_image,
                          const Image* cel_image,
                          const Palette* pal,
@@ -1,5 +1,5 @@
 // Aseprite Render Library
-// Copyright (c) 2019-2023 Igara Studio S.A.
+// Copyright (c) 2019-2026 Igara Studio S.A.
 // Copyright (c) 2001-2018 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -14,22 +14,29 @@
 #include "doc/color.h"
 #include "doc/doc.h"
 #include "doc/frame.h"
+#include "doc/image_ref.h"
 #include "doc/pixel_format.h"
+#include "doc/render_plan.h"
 #include "doc/tile.h"
 #include "gfx/clip.h"
 #include "gfx/point.h"
+#include "gfx/region.h"
 #include "gfx/size.h"
 #include "render/bg_options.h"
 #include "render/extra_type.h"
 #include "render/onionskin_options.h"
 #include "render/projection.h"
 
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace doc {
 class Cel;
 class Image;
 class Layer;
 class Palette;
-class RenderPlan;
 class Sprite;
 class Tileset;
 } // namespace doc
@@ -54,6 +61,8 @@ class Render {
   };
 
 public:
+  static constexpr int kDefaultParallelTileSize = 256;
+
   Render();
 
   void setRefLayersVisiblity(const bool visible);
@@ -64,6 +73,34 @@ public:
   void setBgOptions(const BgOptions& bg);
   void setSelectedLayer(const Layer* layer);
 
+  // Enables the tile-parallel mode for renderSprite(). The
+  // destination area is split in square tiles of the given size,
+  // each tile is composited independently in a shared thread pool,
+  // and the result is the same (pixel-exact) as rendering the whole
+  // area in the calling thread.
+  void setParallelRender(const bool state, const int tileSize = kDefaultParallelTileSize);
+  bool parallelRender() const { return m_parallelTileSize > 0; }
+
+  // Enables the usage of reduced images (see MipmapCache) to render
+  // cels when the sprite is zoomed out, so each pixel on the screen
+  // is the average of all the pixels it covers.
+  void setMipmaps(const bool state);
+
+  // Enables the usage of rasterized tilemaps (see TilemapCache) to
+  // render tilemap cels as regular images instead of compositing
+  // each tile.
+  void setTilemapCache(const bool state);
+
+  // Enables a cache of the composited layers below the layer of the
+  // preview image (the layer that is being edited). While the
+  // preview image is set (e.g. in a tool loop), each renderSprite()
+  // re-blends only the cached image plus the layers from the edited
+  // one to the top, instead of every visible layer. The onion skin
+  // behind the sprite is cached too, so the other frames are not
+  // rendered again. The cache is shared by the tiles of a parallel
+  // render, and it's discarded when the preview image is removed.
+  void setBelowLayersCache(const bool state);
+
   // Sets the preview image. This preview image is an alternative
   // image to be used for the given layer/frame.
   void setPreviewImage(const Layer* layer,
@@ -125,10 +162,29 @@ public:
                  const BlendMode blendMode);
 
 private:
+  // Renders the sprite in the calling thread (used by each tile of
+  // the parallel mode).
+  void renderSpriteArea(Image* dstImage,
+                        const Sprite* sprite,
+                        frame_t frame,
+                        const gfx::ClipF& area);
+  bool renderSpriteInParallel(Image* dstImage,
+                              const Sprite* sprite,
+                              frame_t frame,
+                              const gfx::ClipF& area);
+
   void renderSpriteLayers(Image* dstImage,
                           const gfx::ClipF& area,
                           frame_t frame,
-                          CompositeImageFunc compositeImage);
+                          CompositeImageFunc compositeImage,
+                          const color_t bg_color);
+
+  bool renderSpriteLayersWithCache(const doc::RenderPlan& plan,
+                                   Image* dstImage,
+                                   const gfx::ClipF& area,
+                                   frame_t frame,
+                                   CompositeImageFunc compositeImage,
+                                   const color_t bg_color);
 
   void renderBackground(Image* image,
                         const Layer* bgLayer,
@@ -142,7 +198,17 @@ private:
                        const frame_t frame,
                        const CompositeImageFunc compositeImage);
 
-  void renderPlan(doc::RenderPlan& plan,
+  // Calls func(frameIn, frameOut) for each frame of the onion skin
+  // around the given frame (frameIn is the frame to render, frameOut
+  // is its position relative to the given frame).
+  template<typename Func>
+  void forEachOnionskinFrame(const frame_t frame, Func&& func) const;
+
+  // Adds to the key of the below layers cache the frames of the onion
+  // skin, returns false if the onion skin cannot be cached.
+  bool addOnionskinKey(std::vector<uint64_t>& key, const frame_t frame) const;
+
+  void renderPlan(const doc::RenderPlan& plan,
                   Image* image,
                   const gfx::Clip& area,
                   const frame_t frame,
@@ -151,6 +217,17 @@ private:
                   const bool render_transparent,
                   const BlendMode blendMode);
 
+  // Renders only the items in [begin, end) of a RenderPlan.
+  void renderPlanItems(doc::RenderPlan::Items::const_iterator begin,
+                       doc::RenderPlan::Items::const_iterator end,
+                       Image* image,
+                       const gfx::Clip& area,
+                       const frame_t frame,
+                       const CompositeImageFunc compositeImage,
+                       const bool render_background,
+                       const bool render_transparent,
+                       const BlendMode blendMode);
+
   void renderCel(Image* dst_image,
                  const Cel* cel,
                  const Image* cel_image,
@@ -172,6 +249,16 @@ private:
                    const BlendMode blendMode,
                    const tile_flags tileFlags = notile);
 
+  // Renders a reduced version of the image (see setMipmaps()),
+  // returns false if the image must be rendered as it is.
+  bool renderMipmap(Image* dst_image,
+                    const Image* image,
+                    const Palette* pal,
+                    const gfx::RectF& imageBounds,
+                    const gfx::Clip& area,
+                    const int opacity,
+                    const BlendMode blendMode);
+
   CompositeImageFunc getImageComposition(const PixelFormat dstFormat,
                                          const PixelFormat srcFormat,
                                          const Layer* layer,
@@ -200,8 +287,45 @@ private:
   gfx::Point m_previewPos;
   BlendMode m_previewBlendMode;
   OnionskinOptions m_onionskin;
-  ImageBufferPtr m_tmpBuf;
   bool m_composeGroups = false;
+  int m_parallelTileSize = 0;
+  // Shared with the copies used to render parallel tiles
+  std::shared_ptr<doc::RenderPlanCache> m_renderPlans = std::make_shared<doc::RenderPlanCache>();
+  bool m_useMipmaps = false;
+  bool m_useTilemapCache = false;
+
+  // Composited layers below the edited layer (see setBelowLayersCache()).
+  // Shared with the copies used to render parallel tiles, so it's
+  // guarded by a mutex.
+  struct BelowLayersCache {
+    // Maximum number of pixels of the cached image
+    static constexpr int kMaxPixels = 2048 * 2048;
+
+    std::mutex mutex;
+    std::vector<uint64_t> key;
+    ImageRef image;
+    gfx::Rect bounds;  // Bounds of the image in "area.src" coordinates
+    gfx::Region valid; // Already rendered parts of the image
+  };
+  bool m_useBelowLayersCache = false;
+  std::shared_ptr<BelowLayersCache> m_belowLayersCache;
+  // Whole area (in "area.src" coordinates) of the parallel render
+  // that the copy of a tile belongs to, so the first tile creates
+  // a cached image big enough for all tiles.
+  gfx::Rect m_belowLayersParallelArea;
+
+  // The two rows of the checkered background (one starting with
+  // color1 and the other with color2) used in the last
+  // renderCheckeredBackground() call.
+  struct CheckeredRows {
+    ImageRef image;
+    color_t color1 = 0;
+    color_t color2 = 0;
+    int tileWidth = 0;
+    int phase = 0;
+    int parity = 0;
+  };
+  CheckeredRows m_checkeredRows;
 };
 
 void composite_image(Image* dst,
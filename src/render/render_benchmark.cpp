@@ -1,5 +1,5 @@
 // Aseprite Document Library
-// Copyright (c) 2019-2024 Igara Studio S.A.
+// Copyright (c) 2019-2026 Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -13,12 +13,20 @@
 #include "doc/cel.h"
 #include "doc/image.h"
 #include "doc/layer.h"
+#include "doc/layer_tilemap.h"
 #include "doc/palette.h"
 #include "doc/primitives.h"
 #include "doc/sprite.h"
+#include "doc/tile.h"
+#include "doc/tileset.h"
+#include "doc/tilesets.h"
+#include "render/onionskin_options.h"
+#include "render/projection.h"
 
 #include <benchmark/benchmark.h>
 
+#include <string>
+
 using namespace doc;
 using namespace render;
 
@@ -54,10 +62,13 @@ static void Bm_Render(benchmark::State& state)
   std::unique_ptr<Image> dst(Image::create(spr->pixelFormat(), w, h));
   clear_image(dst.get(), 0);
 
+  const bool parallel = (state.range(2) != 0);
+
   for (auto _ : state) {
     clear_image(dst.get(), 0);
 
     Render render;
+    render.setParallelRender(parallel);
     BgOptions bg;
     bg.type = BgType::CHECKERED;
     bg.zoom = true;
@@ -70,11 +81,187 @@ static void Bm_Render(benchmark::State& state)
 }
 
 BENCHMARK(Bm_Render)
-  ->Args({ 256, 256 })
-  ->Args({ 1024, 256 })
-  ->Args({ 256, 1024 })
-  ->Args({ 1024, 1024 })
-  ->Args({ 4096, 4096 })
+  ->Args({ 256, 256, 0 })
+  ->Args({ 1024, 256, 0 })
+  ->Args({ 256, 1024, 0 })
+  ->Args({ 1024, 1024, 0 })
+  ->Args({ 4096, 4096, 0 })
+  ->Args({ 1024, 1024, 1 })
+  ->Args({ 4096, 4096, 1 })
+  ->Unit(benchmark::kMicrosecond);
+
+// Name of the CompositeImageFunc that Render::getImageComposition()
+// uses for the given projection (with a zoomed background), so the
+// results can be grouped by composition path (e.g. running the
+// benchmark with --benchmark_format=json or --benchmark_out=file.json
+// to track the "label" field of each result).
+static const char* composition_path(const Projection& proj, const bool tileFlags)
+{
+  if (tileFlags)
+    return "general_with_tile_flags";
+  if (!proj.zoom().isSimpleZoomLevel())
+    return "general";
+  if (proj.scaleX() == 1.0 && proj.scaleY() == 1.0)
+    return "without_scale";
+  if (proj.isSimpleScaleUpCase())
+    return "scale_up";
+  if (proj.isSimpleScaleDownCase())
+    return "scale_down";
+  return "general";
+}
+
+static color_t make_color(const ColorMode colorMode, int r, int g, int b, int a)
+{
+  switch (colorMode) {
+    case ColorMode::GRAYSCALE: return graya((r + g + b) / 3, a);
+    case ColorMode::INDEXED:   return color_t(1 + ((r + g + b) % 255));
+    default:                   return rgba(r, g, b, a);
+  }
+}
+
+static void Bm_RenderMatrix(benchmark::State& state)
+{
+  const ColorMode colorMode = ColorMode(state.range(0));
+  const Zoom zoom(state.range(1), state.range(2));
+  const BlendMode blendMode = BlendMode(state.range(3));
+  const int nlayers = state.range(4);
+  const bool onionskin = (state.range(5) != 0);
+  const int tilemap = state.range(6); // 0=no tilemap, 1=tiles, 2=tiles with flags
+  const int w = 512;
+  const int h = 512;
+  const frame_t nframes = (onionskin ? 3 : 1);
+  const frame_t frame = (onionskin ? 1 : 0);
+
+  std::unique_ptr<Sprite> spr(Sprite::MakeStdSprite(ImageSpec(colorMode, w, h)));
+  spr->setTotalFrames(nframes);
+
+  for (int i = 0; i < nlayers; ++i) {
+    LayerImage* lay = (i == 0 ? static_cast<LayerImage*>(spr->root()->firstLayer()) :
+                                new LayerImage(spr.get()));
+    if (i > 0) {
+      lay->setBlendMode(blendMode);
+      spr->root()->addLayer(lay);
+    }
+    for (frame_t fr = 0; fr < nframes; ++fr) {
+      Image* img = lay->cel(fr) ? lay->cel(fr)->image() : nullptr;
+      if (!img) {
+        img = Image::create(spr->pixelFormat(), w, h);
+        lay->addCel(new Cel(fr, ImageRef(img)));
+      }
+      clear_image(img, spr->transparentColor());
+      fill_rect(img,
+                16 * (i + fr),
+                16 * (i + fr),
+                w - 64,
+                h - 64,
+                make_color(colorMode, 32 * i, 128 + 16 * fr, 255 - 32 * i, 128));
+    }
+  }
+
+  if (tilemap) {
+    const int tileSize = 16;
+    auto* tileset = new Tileset(spr.get(), Grid(gfx::Size(tileSize, tileSize)), 5);
+    for (tile_index ti = 1; ti < tileset->size(); ++ti) {
+      Image* tileImg = tileset->get(ti).get();
+      clear_image(tileImg, spr->transparentColor());
+      fill_rect(tileImg,
+                0,
+                0,
+                tileSize / 2 + int(ti),
+                tileSize / 4 + int(ti),
+                make_color(colorMode, 60 * ti, 200, 32, 200));
+    }
+    const tileset_index tsi = spr->tilesets()->add(tileset);
+
+    auto* lay = new LayerTilemap(spr.get(), tsi);
+    spr->root()->addLayer(lay);
+
+    const tile_flags kFlags[] = { 0, tile_f_xflip, tile_f_yflip, tile_f_dflip };
+    for (frame_t fr = 0; fr < nframes; ++fr) {
+      ImageRef img(Image::create(IMAGE_TILEMAP, w / tileSize, h / tileSize));
+      for (int v = 0; v < img->height(); ++v)
+        for (int u = 0; u < img->width(); ++u)
+          img->putPixel(u,
+                        v,
+                        tile(1 + (u + v + fr) % 4, (tilemap == 2 ? kFlags[(u * 3 + v) % 4] : 0)));
+      lay->addCel(new Cel(fr, img));
+    }
+  }
+
+  Projection proj;
+  proj.setZoom(zoom);
+  const int dw = proj.applyX(w);
+  const int dh = proj.applyY(h);
+  std::unique_ptr<Image> dst(Image::create(IMAGE_RGB, dw, dh));
+
+  Render render;
+  render.setProjection(proj);
+  BgOptions bg;
+  bg.type = BgType::CHECKERED;
+  bg.zoom = true;
+  bg.color1 = rgba(100, 100, 100, 255);
+  bg.color2 = rgba(200, 200, 200, 255);
+  bg.stripeSize = gfx::Size(16, 16);
+  render.setBgOptions(bg);
+  if (onionskin) {
+    OnionskinOptions opts(OnionskinType::MERGE);
+    opts.prevFrames(1);
+    opts.nextFrames(1);
+    opts.opacityBase(68);
+    opts.opacityStep(28);
+    render.setOnionskin(opts);
+  }
+
+  for (auto _ : state) {
+    clear_image(dst.get(), 0);
+    render.renderSprite(dst.get(), spr.get(), frame, gfx::Clip(0, 0, 0, 0, dw, dh));
+  }
+
+  static const char* kColorModeNames[] = { "rgb", "gray", "indexed" };
+  state.SetLabel(std::string(kColorModeNames[int(colorMode)]) + " " +
+                 composition_path(proj, tilemap == 2));
+  state.SetItemsProcessed(state.iterations() * dw * dh);
+}
+
+// Each color mode with zoom levels below, at, and above 1 (3:2 isn't
+// a simple zoom level so it uses the general composition), then
+// blend modes, number of layers, onion skin, and tilemaps at 100%.
+static void MatrixArguments(benchmark::internal::Benchmark* b)
+{
+  const int kNormal = int(BlendMode::NORMAL);
+  const int kZooms[][2] = {
+    { 1, 4 },
+    { 1, 2 },
+    { 1, 1 },
+    { 2, 1 },
+    { 4, 1 },
+    { 3, 2 }
+  };
+  const BlendMode kBlendModes[] = { BlendMode::MULTIPLY,
+                                    BlendMode::OVERLAY,
+                                    BlendMode::DIFFERENCE,
+                                    BlendMode::HSL_HUE };
+
+  for (const ColorMode colorMode : { ColorMode::RGB, ColorMode::GRAYSCALE, ColorMode::INDEXED }) {
+    const int mode = int(colorMode);
+    for (const auto& z : kZooms)
+      b->Args({ mode, z[0], z[1], kNormal, 3, 0, 0 });
+    for (const BlendMode blendMode : kBlendModes)
+      b->Args({ mode, 1, 1, int(blendMode), 3, 0, 0 });
+    for (const int nlayers : { 1, 8 })
+      b->Args({ mode, 1, 1, kNormal, nlayers, 0, 0 });
+    b->Args({ mode, 1, 1, kNormal, 3, 1, 0 });
+    b->Args({ mode, 2, 1, kNormal, 3, 1, 0 });
+    for (const int tilemap : { 1, 2 }) {
+      b->Args({ mode, 1, 1, kNormal, 1, 0, tilemap });
+      b->Args({ mode, 2, 1, kNormal, 1, 0, tilemap });
+    }
+  }
+}
+
+BENCHMARK(Bm_RenderMatrix)
+  ->ArgNames({ "mode", "num", "den", "blend", "layers", "onion", "tilemap" })
+  ->Apply(MatrixArguments)
   ->Unit(benchmark::kMicrosecond);
 
 BENCHMARK_MAIN();
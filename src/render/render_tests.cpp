@@ -1,5 +1,5 @@
 // Aseprite Render Library
-// Copyright (c) 2019-2023 Igara Studio S.A.
+// Copyright (c) 2019-2026 Igara Studio S.A.
 // Copyright (c) 2001-2018 David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -19,7 +19,9 @@
 #include "doc/layer.h"
 #include "doc/palette.h"
 #include "doc/primitives.h"
+#include "tracing/metrics.h"
 
+#include <cstring>
 #include <memory>
 
 using namespace doc;
@@ -169,6 +171,54 @@ TEST(Render, CheckeredBackground)
   EXPECT_4X4_PIXELS(dst.get(), 1, 1, 2, 2, 1, 1, 2, 2, 2, 2, 1, 1, 2, 2, 1, 1);
 }
 
+TEST(Render, CheckeredBackgroundCachedRows)
+{
+  BgOptions bg;
+  bg.type = BgType::CHECKERED;
+  bg.zoom = false;
+  bg.colorPixelFormat = IMAGE_INDEXED;
+  bg.color1 = 1;
+  bg.color2 = 2;
+  bg.stripeSize = gfx::Size(3, 2);
+
+  std::unique_ptr<Image> expected(Image::create(IMAGE_INDEXED, 8, 8));
+  std::unique_ptr<Image> result(Image::create(IMAGE_INDEXED, 8, 8));
+
+  // The same Render is used with different areas (so the cached rows
+  // of the pattern must be updated)
+  Render render;
+  render.setBgOptions(bg);
+  const gfx::Clip clips[] = { gfx::Clip(0, 0, 0, 0, 8, 8),
+                              gfx::Clip(1, 2, 5, 3, 6, 4),
+                              gfx::Clip(0, 0, 7, 1, 8, 8),
+                              gfx::Clip(2, 0, 2, 0, 3, 8) };
+  for (const gfx::Clip& clip : clips) {
+    clear_image(expected.get(), 0);
+    clear_image(result.get(), 0);
+
+    Render fresh;
+    fresh.setBgOptions(bg);
+    fresh.renderCheckeredBackground(expected.get(), clip);
+    render.renderCheckeredBackground(result.get(), clip);
+
+    for (int y = 0; y < 8; ++y) {
+      for (int x = 0; x < 8; ++x) {
+        ASSERT_EQ(get_pixel(expected.get(), x, y), get_pixel(result.get(), x, y))
+          << " x=" << x << " y=" << y;
+      }
+    }
+  }
+
+  // Expected pattern with an offset area
+  clear_image(result.get(), 0);
+  render.setBgOptions(bg);
+  render.renderCheckeredBackground(result.get(), gfx::Clip(0, 0, 1, 0, 4, 1));
+  EXPECT_EQ(1, get_pixel(result.get(), 0, 0));
+  EXPECT_EQ(1, get_pixel(result.get(), 1, 0));
+  EXPECT_EQ(2, get_pixel(result.get(), 2, 0));
+  EXPECT_EQ(2, get_pixel(result.get(), 3, 0));
+}
+
 TEST(Render, ZoomAndDstBounds)
 {
   // Create this image:
@@ -251,6 +301,253 @@ TEST(Render, BugWithMultiplesOf3ZoomFactors)
   }
 }
 
+TEST(Render, ParallelRenderIsPixelExact)
+{
+  std::shared_ptr<Document> doc = std::make_shared<Document>();
+  doc->sprites().add(Sprite::MakeStdSprite(ImageSpec(ColorMode::RGB, 37, 29)));
+  Sprite* spr = doc->sprite();
+  Image* src = spr->root()->firstLayer()->cel(0)->image();
+  clear_image(src, 0);
+  fill_rect(src, 3, 2, 30, 20, rgba(32, 128, 255, 128));
+  draw_line(src, 0, 0, 36, 28, rgba(255, 0, 0, 255));
+
+  LayerImage* lay2 = new LayerImage(spr);
+  spr->root()->addLayer(lay2);
+  ImageRef img2(Image::create(IMAGE_RGB, 37, 29));
+  clear_image(img2.get(), 0);
+  fill_rect(img2.get(), 10, 5, 36, 28, rgba(200, 64, 80, 100));
+  lay2->addCel(new Cel(frame_t(0), img2));
+
+  BgOptions bg;
+  bg.type = BgType::CHECKERED;
+  bg.colorPixelFormat = IMAGE_RGB;
+  bg.color1 = rgba(128, 128, 128, 255);
+  bg.color2 = rgba(64, 64, 64, 255);
+  bg.stripeSize = gfx::Size(3, 3);
+
+  for (int zoom : { 1, 2, 3 }) {
+    const int w = 37 * zoom;
+    const int h = 29 * zoom;
+    std::unique_ptr<Image> expected(Image::create(IMAGE_RGB, w, h));
+    std::unique_ptr<Image> result(Image::create(IMAGE_RGB, w, h));
+    clear_image(expected.get(), 0);
+    clear_image(result.get(), 0);
+
+    Render render;
+    render.setBgOptions(bg);
+    render.setProjection(Projection(PixelRatio(1, 1), Zoom(zoom, 1)));
+    render.renderSprite(expected.get(), spr, frame_t(0), gfx::Clip(0, 0, 0, 0, w, h));
+
+    render.setParallelRender(true, 8);
+    render.renderSprite(result.get(), spr, frame_t(0), gfx::Clip(0, 0, 0, 0, w, h));
+
+    for (int y = 0; y < h; ++y) {
+      for (int x = 0; x < w; ++x) {
+        ASSERT_EQ(get_pixel(expected.get(), x, y), get_pixel(result.get(), x, y))
+          << " zoom=" << zoom << " x=" << x << " y=" << y;
+      }
+    }
+  }
+}
+
+TEST(Render, BelowLayersCacheIsPixelExact)
+{
+  std::shared_ptr<Document> doc = std::make_shared<Document>();
+  doc->sprites().add(Sprite::MakeStdSprite(ImageSpec(ColorMode::RGB, 16, 16)));
+  Sprite* spr = doc->sprite();
+  Image* img1 = spr->root()->firstLayer()->cel(0)->image();
+  clear_image(img1, 0);
+  fill_rect(img1, 1, 1, 12, 12, rgba(32, 128, 255, 128));
+
+  LayerImage* lay2 = new LayerImage(spr);
+  LayerImage* lay3 = new LayerImage(spr);
+  spr->root()->addLayer(lay2);
+  spr->root()->addLayer(lay3);
+  ImageRef img2(Image::create(IMAGE_RGB, 16, 16));
+  ImageRef img3(Image::create(IMAGE_RGB, 16, 16));
+  clear_image(img2.get(), 0);
+  clear_image(img3.get(), 0);
+  fill_rect(img2.get(), 4, 4, 15, 15, rgba(200, 64, 80, 100));
+  fill_rect(img3.get(), 0, 6, 15, 9, rgba(0, 255, 0, 64));
+  lay2->addCel(new Cel(frame_t(0), img2));
+  lay3->addCel(new Cel(frame_t(0), img3));
+
+  // The preview image is the image of the layer being edited
+  ImageRef preview(Image::createCopy(img2.get()));
+  draw_line(preview.get(), 0, 0, 15, 15, rgba(255, 255, 0, 255));
+
+  std::unique_ptr<Image> expected(Image::create(IMAGE_RGB, 16, 16));
+  std::unique_ptr<Image> result(Image::create(IMAGE_RGB, 16, 16));
+
+  Render render;
+  Render cachedRender;
+  cachedRender.setBelowLayersCache(true);
+  for (Render* r : { &render, &cachedRender }) {
+    r->setPreviewImage(lay2, frame_t(0), preview.get(), nullptr, gfx::Point(0, 0), BlendMode::NORMAL);
+  }
+
+  const gfx::Rect areas[] = { gfx::Rect(0, 0, 4, 4),
+                              gfx::Rect(2, 2, 8, 8),
+                              gfx::Rect(8, 8, 8, 8),
+                              gfx::Rect(0, 0, 16, 16) };
+  for (const gfx::Rect& rc : areas) {
+    clear_image(expected.get(), 0);
+    clear_image(result.get(), 0);
+    render.renderSprite(expected.get(), spr, frame_t(0), gfx::Clip(rc.origin(), rc));
+    cachedRender.renderSprite(result.get(), spr, frame_t(0), gfx::Clip(rc.origin(), rc));
+
+    // Change the preview between renders (as a tool loop does)
+    draw_line(preview.get(), 15, 0, 0, 15, rgba(255, 0, 255, 200));
+
+    for (int y = 0; y < 16; ++y) {
+      for (int x = 0; x < 16; ++x) {
+        ASSERT_EQ(get_pixel(expected.get(), x, y), get_pixel(result.get(), x, y))
+          << " area=" << rc.x << "," << rc.y << " x=" << x << " y=" << y;
+      }
+    }
+  }
+}
+
+TEST(Render, BelowLayersCacheWithOnionskin)
+{
+  std::shared_ptr<Document> doc = std::make_shared<Document>();
+  doc->sprites().add(Sprite::MakeStdSprite(ImageSpec(ColorMode::RGB, 16, 16)));
+  Sprite* spr = doc->sprite();
+  spr->setTotalFrames(frame_t(3));
+
+  LayerImage* lay1 = static_cast<LayerImage*>(spr->root()->firstLayer());
+  LayerImage* lay2 = new LayerImage(spr);
+  spr->root()->addLayer(lay2);
+  clear_image(lay1->cel(0)->image(), 0);
+  for (frame_t f = 0; f < 3; ++f) {
+    ImageRef img1(Image::create(IMAGE_RGB, 16, 16));
+    ImageRef img2(Image::create(IMAGE_RGB, 16, 16));
+    clear_image(img1.get(), 0);
+    clear_image(img2.get(), 0);
+    fill_rect(img1.get(), 2 * f, 0, 2 * f + 6, 15, rgba(255, 0, 0, 200));
+    fill_rect(img2.get(), 0, 3 * f, 15, 3 * f + 4, rgba(0, 0, 255, 160));
+    if (f > 0)
+      lay1->addCel(new Cel(f, img1));
+    lay2->addCel(new Cel(f, img2));
+  }
+
+  ImageRef preview(Image::createCopy(lay2->cel(1)->image()));
+  draw_line(preview.get(), 0, 0, 15, 15, rgba(255, 255, 0, 255));
+
+  OnionskinOptions onionskin(OnionskinType::RED_BLUE_TINT);
+  onionskin.prevFrames(1);
+  onionskin.nextFrames(1);
+  onionskin.opacityBase(128);
+  onionskin.opacityStep(32);
+
+  std::unique_ptr<Image> expected(Image::create(IMAGE_RGB, 16, 16));
+  std::unique_ptr<Image> result(Image::create(IMAGE_RGB, 16, 16));
+
+  Render render;
+  Render cachedRender;
+  cachedRender.setBelowLayersCache(true);
+  for (Render* r : { &render, &cachedRender }) {
+    r->setOnionskin(onionskin);
+    r->setPreviewImage(lay2, frame_t(1), preview.get(), nullptr, gfx::Point(0, 0), BlendMode::NORMAL);
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    clear_image(expected.get(), 0);
+    clear_image(result.get(), 0);
+    render.renderSprite(expected.get(), spr, frame_t(1), gfx::Clip(0, 0, 0, 0, 16, 16));
+    cachedRender.renderSprite(result.get(), spr, frame_t(1), gfx::Clip(0, 0, 0, 0, 16, 16));
+
+    draw_line(preview.get(), 15 - i, 0, 0, 15, rgba(255, 0, 255, 200));
+
+    for (int y = 0; y < 16; ++y) {
+      for (int x = 0; x < 16; ++x) {
+        ASSERT_EQ(get_pixel(expected.get(), x, y), get_pixel(result.get(), x, y))
+          << " i=" << i << " x=" << x << " y=" << y;
+      }
+    }
+  }
+}
+
+static int64_t counter_value(const char* name)
+{
+  int64_t value = 0;
+  tracing::for_each_metric([name, &value](const tracing::Metric& metric) {
+    if (std::strcmp(metric.name(), name) == 0)
+      value = static_cast<const tracing::Counter&>(metric).value();
+  });
+  return value;
+}
+
+TEST(Render, ParallelRenderUsesBelowLayersCache)
+{
+  std::shared_ptr<Document> doc = std::make_shared<Document>();
+  doc->sprites().add(Sprite::MakeStdSprite(ImageSpec(ColorMode::RGB, 37, 29)));
+  Sprite* spr = doc->sprite();
+  Image* img1 = spr->root()->firstLayer()->cel(0)->image();
+  clear_image(img1, 0);
+  fill_rect(img1, 3, 2, 30, 20, rgba(32, 128, 255, 128));
+
+  LayerImage* lay2 = new LayerImage(spr);
+  LayerImage* lay3 = new LayerImage(spr);
+  spr->root()->addLayer(lay2);
+  spr->root()->addLayer(lay3);
+  ImageRef img2(Image::create(IMAGE_RGB, 37, 29));
+  ImageRef img3(Image::create(IMAGE_RGB, 37, 29));
+  clear_image(img2.get(), 0);
+  clear_image(img3.get(), 0);
+  fill_rect(img2.get(), 10, 5, 36, 28, rgba(200, 64, 80, 100));
+  draw_line(img3.get(), 0, 28, 36, 0, rgba(0, 255, 0, 160));
+  lay2->addCel(new Cel(frame_t(0), img2));
+  lay3->addCel(new Cel(frame_t(0), img3));
+
+  ImageRef preview(Image::createCopy(img2.get()));
+  draw_line(preview.get(), 0, 0, 36, 28, rgba(255, 255, 0, 255));
+
+  BgOptions bg;
+  bg.type = BgType::CHECKERED;
+  bg.colorPixelFormat = IMAGE_RGB;
+  bg.color1 = rgba(128, 128, 128, 255);
+  bg.color2 = rgba(64, 64, 64, 255);
+  bg.stripeSize = gfx::Size(3, 3);
+
+  const int w = 37 * 2;
+  const int h = 29 * 2;
+  std::unique_ptr<Image> expected(Image::create(IMAGE_RGB, w, h));
+  std::unique_ptr<Image> result(Image::create(IMAGE_RGB, w, h));
+
+  Render render;
+  Render cachedRender;
+  cachedRender.setBelowLayersCache(true);
+  cachedRender.setParallelRender(true, 8);
+  for (Render* r : { &render, &cachedRender }) {
+    r->setBgOptions(bg);
+    r->setProjection(Projection(PixelRatio(1, 1), Zoom(2, 1)));
+    r->setPreviewImage(lay2, frame_t(0), preview.get(), nullptr, gfx::Point(0, 0), BlendMode::NORMAL);
+  }
+
+  for (int i = 0; i < 3; ++i) {
+    clear_image(expected.get(), 0);
+    clear_image(result.get(), 0);
+    render.renderSprite(expected.get(), spr, frame_t(0), gfx::Clip(0, 0, 0, 0, w, h));
+
+    const int64_t misses = counter_value("render.below_layers_cache.misses");
+    cachedRender.renderSprite(result.get(), spr, frame_t(0), gfx::Clip(0, 0, 0, 0, w, h));
+
+    // The tiles consult the cache filled by the first render
+    if (i > 0)
+      EXPECT_EQ(misses, counter_value("render.below_layers_cache.misses"));
+
+    draw_line(preview.get(), 36 - i, 0, 0, 28, rgba(255, 0, 255, 200));
+
+    for (int y = 0; y < h; ++y) {
+      for (int x = 0; x < w; ++x) {
+        ASSERT_EQ(get_pixel(expected.get(), x, y), get_pixel(result.get(), x, y))
+          << " i=" << i << " x=" << x << " y=" << y;
+      }
+    }
+  }
+}
+
 int main(int argc, char** argv)
 {
   ::testing::InitGoogleTest(&argc, argv);
@@ -0,0 +1,238 @@
+// Aseprite Render Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "render/tilemap_cache.h"
+
+#include "base/debug.h"
+#include "doc/image.h"
+#include "doc/image_impl.h"
+#include "doc/primitives.h"
+#include "doc/primitives_fast.h"
+#include "doc/sprite.h"
+#include "doc/tileset.h"
+#include "tracing/metrics.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace render {
+
+using namespace doc;
+
+static tracing::Counter g_hits("render.tilemap_cache.hits");
+static tracing::Counter g_misses("render.tilemap_cache.misses");
+
+namespace {
+
+// Copies the tile image in the given position of "dst" applying the
+// flips (with the same logic as composite_image_general_with_tile_flags()).
+template<typename ImageTraits>
+void copy_tile_with_flags(Image* dst,
+                          const Image* tile,
+                          const gfx::Rect& bounds,
+                          const tile_flags flags)
+{
+  using pixel_t = typename ImageTraits::pixel_t;
+
+  const gfx::Size minSize = ((flags & tile_f_dflip) ?
+                               gfx::Size(std::min(tile->width(), tile->height()),
+                                         std::min(tile->width(), tile->height())) :
+                               tile->size());
+  const pixel_t mask = pixel_t(dst->maskColor());
+
+  for (int y = 0; y < bounds.h; ++y) {
+    auto dstPtr = (pixel_t*)dst->getPixelAddress(bounds.x, bounds.y + y);
+    for (int x = 0; x < bounds.w; ++x, ++dstPtr) {
+      int srcX = ((flags & tile_f_xflip) ? bounds.w - 1 - x : x);
+      int srcY = ((flags & tile_f_yflip) ? bounds.h - 1 - y : y);
+      if (flags & tile_f_dflip)
+        std::swap(srcX, srcY);
+
+      if (srcX >= 0 && srcX < minSize.w && srcY >= 0 && srcY < minSize.h)
+        *dstPtr = get_pixel_fast<ImageTraits>(tile, srcX, srcY);
+      else
+        *dstPtr = mask;
+    }
+  }
+}
+
+void draw_tile(Image* dst, const Image* tile, const gfx::Rect& bounds, const tile_flags flags)
+{
+  if (!tile) {
+    fill_rect(dst, bounds, dst->maskColor());
+    return;
+  }
+
+  if (!flags) {
+    // Clear pixels that are not covered by the tile image
+    if (tile->width() < bounds.w || tile->height() < bounds.h)
+      fill_rect(dst, bounds, dst->maskColor());
+    dst->copy(tile, gfx::Clip(bounds.x, bounds.y, 0, 0, bounds.w, bounds.h));
+    return;
+  }
+
+  switch (dst->pixelFormat()) {
+    case IMAGE_RGB:       copy_tile_with_flags<RgbTraits>(dst, tile, bounds, flags); break;
+    case IMAGE_GRAYSCALE: copy_tile_with_flags<GrayscaleTraits>(dst, tile, bounds, flags); break;
+    case IMAGE_INDEXED:   copy_tile_with_flags<IndexedTraits>(dst, tile, bounds, flags); break;
+    default:              ASSERT(false); break;
+  }
+}
+
+} // anonymous namespace
+
+TilemapCache::TilemapCache(const std::size_t maxBytes) : m_maxBytes(maxBytes)
+{
+}
+
+// static
+TilemapCache* TilemapCache::instance()
+{
+  static TilemapCache cache;
+  return &cache;
+}
+
+ImageRef TilemapCache::getImage(const Image* tilemap, const Tileset* tileset)
+{
+  ASSERT(tilemap->pixelFormat() == IMAGE_TILEMAP);
+  if (tilemap->pixelFormat() != IMAGE_TILEMAP || !tileset || !tileset->sprite())
+    return nullptr;
+
+  const gfx::Size tileSize = tileset->grid().tileSize();
+  ImageSpec spec = tileset->sprite()->spec();
+  spec.setSize(tilemap->width() * tileSize.w, tilemap->height() * tileSize.h);
+  if (spec.width() < 1 || spec.height() < 1 || spec.colorMode() == ColorMode::TILEMAP)
+    return nullptr;
+
+  // Don't rasterize tilemaps that would use a big part of the cache,
+  // in that case it's better to composite each visible tile.
+  const std::size_t bytes = std::size_t(spec.width()) * spec.height() *
+                            bytes_per_pixel_for_colormode(spec.colorMode());
+  if (bytes > m_maxBytes / 4)
+    return nullptr;
+
+  // Images are rasterized with the mutex locked, so if several
+  // threads render the same tilemap at the same time, it's updated
+  // just once.
+  const std::lock_guard lock(m_mutex);
+
+  auto it = m_entries.find(tilemap->id());
+  if (it != m_entries.end()) {
+    Entry& entry = it->second;
+    const Image* image = entry.image.get();
+    if (entry.tilesetId == tileset->id() && image->colorMode() == spec.colorMode() &&
+        image->size() == spec.size() && image->maskColor() == spec.maskColor()) {
+      m_lru.splice(m_lru.begin(), m_lru, entry.lru);
+
+      if (entry.tilemapVersion != tilemap->version() ||
+          entry.tilesetVersion != tileset->version()) {
+        // Other renderers can be using the image, so we update a copy
+        if (entry.image.use_count() > 1)
+          entry.image.reset(Image::createCopy(entry.image.get()));
+
+        updateTiles(entry, tilemap, tileset);
+      }
+      g_hits.add();
+      return entry.image;
+    }
+
+    // Other tileset, tile size, or transparent color
+    m_bytes -= entry.bytes;
+    m_lru.erase(entry.lru);
+    m_entries.erase(it);
+  }
+
+  g_misses.add();
+  Entry entry;
+  entry.tilesetId = tileset->id();
+  entry.image.reset(Image::create(spec));
+  entry.tiles.resize(std::size_t(tilemap->width()) * tilemap->height(),
+                     TileState{ notile, NullId, 0 });
+  entry.bytes = bytes;
+  entry.image->clear(entry.image->maskColor());
+  updateTiles(entry, tilemap, tileset);
+
+  m_lru.push_front(tilemap->id());
+  entry.lru = m_lru.begin();
+  ImageRef image = entry.image;
+  m_entries[tilemap->id()] = std::move(entry);
+  m_bytes += bytes;
+  evict();
+  return image;
+}
+
+// static
+void TilemapCache::updateTiles(Entry& entry, const Image* tilemap, const Tileset* tileset)
+{
+  const gfx::Size tileSize = tileset->grid().tileSize();
+  bool modified = false;
+
+  for (int v = 0; v < tilemap->height(); ++v) {
+    auto tilemapPtr = (const TilemapTraits::pixel_t*)tilemap->getPixelAddress(0, v);
+    for (int u = 0; u < tilemap->width(); ++u, ++tilemapPtr) {
+      const tile_t t = *tilemapPtr;
+      ImageRef tile;
+      if (t != notile)
+        tile = tileset->get(tile_geti(t));
+
+      TileState& state = entry.tiles[std::size_t(v) * tilemap->width() + u];
+      const TileState newState = { t,
+                                   (tile ? tile->id() : NullId),
+                                   (tile ? tile->version() : 0) };
+      if (state.tile == newState.tile && state.imageId == newState.imageId &&
+          state.imageVersion == newState.imageVersion) {
+        continue;
+      }
+
+      draw_tile(entry.image.get(),
+                tile.get(),
+                gfx::Rect(u * tileSize.w, v * tileSize.h, tileSize.w, tileSize.h),
+                tile_getf(t));
+      state = newState;
+      modified = true;
+    }
+  }
+
+  // The version of the rasterized image is used by other caches
+  // (e.g. MipmapCache)
+  if (modified)
+    entry.image->incrementVersion();
+
+  entry.tilemapVersion = tilemap->version();
+  entry.tilesetVersion = tileset->version();
+}
+
+std::size_t TilemapCache::bytes() const
+{
+  const std::lock_guard lock(m_mutex);
+  return m_bytes;
+}
+
+void TilemapCache::clear()
+{
+  const std::lock_guard lock(m_mutex);
+  m_entries.clear();
+  m_lru.clear();
+  m_bytes = 0;
+}
+
+void TilemapCache::evict()
+{
+  // Remove the least recently used images (but not the new one)
+  while (m_bytes > m_maxBytes && m_lru.size() > 1) {
+    auto it = m_entries.find(m_lru.back());
+    ASSERT(it != m_entries.end());
+    m_bytes -= it->second.bytes;
+    m_entries.erase(it);
+    m_lru.pop_back();
+  }
+}
+
+} // namespace render
@@ -0,0 +1,85 @@
+// Aseprite Render Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef RENDER_TILEMAP_CACHE_H_INCLUDED
+#define RENDER_TILEMAP_CACHE_H_INCLUDED
+#pragma once
+
+#include "doc/image_ref.h"
+#include "doc/object_id.h"
+#include "doc/object_version.h"
+#include "doc/tile.h"
+
+#include <cstddef>
+#include <list>
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace doc {
+class Image;
+class Tileset;
+} // namespace doc
+
+namespace render {
+
+// Cache of rasterized tilemaps, i.e. images with the pixels of each
+// tile of a tilemap image (with its flips applied), so static
+// tilemap layers can be rendered as regular images instead of
+// compositing each tile on each render.
+//
+// The rasterized image is updated when the version of the tilemap
+// or the tileset changes, and only the tiles that are different
+// (other tile/flags, or a modified tile image) are drawn again. The
+// cache can be used from several threads (e.g. parallel rendering).
+class TilemapCache {
+public:
+  // Limit of bytes of all cached images.
+  static constexpr std::size_t kDefaultMaxBytes = 256 * 1024 * 1024;
+
+  explicit TilemapCache(std::size_t maxBytes = kDefaultMaxBytes);
+
+  // Cache shared by all the program.
+  static TilemapCache* instance();
+
+  // Returns the given tilemap rasterized with the tiles of the
+  // tileset (one pixel of the tilemap is one tile of the result), or
+  // nullptr if the result is too big for the cache.
+  doc::ImageRef getImage(const doc::Image* tilemap, const doc::Tileset* tileset);
+
+  std::size_t bytes() const;
+  void clear();
+
+private:
+  // What was drawn in each tile of the rasterized image.
+  struct TileState {
+    doc::tile_t tile;
+    doc::ObjectId imageId;
+    doc::ObjectVersion imageVersion;
+  };
+  struct Entry {
+    doc::ObjectId tilesetId;
+    doc::ObjectVersion tilemapVersion;
+    doc::ObjectVersion tilesetVersion;
+    doc::ImageRef image;
+    std::vector<TileState> tiles;
+    std::size_t bytes;
+    std::list<doc::ObjectId>::iterator lru;
+  };
+
+  static void updateTiles(Entry& entry, const doc::Image* tilemap, const doc::Tileset* tileset);
+  void evict();
+
+  mutable std::mutex m_mutex;
+  std::map<doc::ObjectId, Entry> m_entries;
+  std::list<doc::ObjectId> m_lru; // Most recently used tilemaps at the front
+  std::size_t m_bytes = 0;
+  std::size_t m_maxBytes;
+};
+
+} // namespace render
+
+#endif
@@ -0,0 +1,122 @@
+// Aseprite Render Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "render/tilemap_cache.h"
+
+#include "doc/grid.h"
+#include "doc/image.h"
+#include "doc/primitives.h"
+#include "doc/sprite.h"
+#include "doc/tileset.h"
+
+#include <memory>
+
+using namespace doc;
+using namespace render;
+
+namespace {
+
+// Tileset with 2x2 tiles where tile 1 has a different color in
+// each pixel.
+struct TestTileset {
+  Sprite sprite;
+  std::unique_ptr<Tileset> tileset;
+
+  TestTileset() : sprite(ImageSpec(ColorMode::RGB, 4, 2), 256)
+  {
+    tileset = std::make_unique<Tileset>(&sprite, Grid(gfx::Size(2, 2)), 2);
+    ImageRef tile(Image::create(IMAGE_RGB, 2, 2));
+    put_pixel(tile.get(), 0, 0, rgba(255, 0, 0, 255));
+    put_pixel(tile.get(), 1, 0, rgba(0, 255, 0, 255));
+    put_pixel(tile.get(), 0, 1, rgba(0, 0, 255, 255));
+    put_pixel(tile.get(), 1, 1, rgba(255, 255, 255, 255));
+    tileset->set(1, tile);
+  }
+};
+
+} // anonymous namespace
+
+TEST(TilemapCache, RasterizeTiles)
+{
+  TestTileset ts;
+  ImageRef tilemap(Image::create(IMAGE_TILEMAP, 3, 1));
+  put_pixel(tilemap.get(), 0, 0, tile(1, 0));
+  put_pixel(tilemap.get(), 1, 0, tile(1, tile_f_xflip));
+  put_pixel(tilemap.get(), 2, 0, notile);
+
+  TilemapCache cache;
+  ImageRef image = cache.getImage(tilemap.get(), ts.tileset.get());
+  ASSERT_TRUE(image);
+  EXPECT_EQ(6, image->width());
+  EXPECT_EQ(2, image->height());
+
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(image.get(), 0, 0));
+  EXPECT_EQ(rgba(0, 255, 0, 255), get_pixel(image.get(), 1, 0));
+  EXPECT_EQ(rgba(0, 255, 0, 255), get_pixel(image.get(), 2, 0));
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(image.get(), 3, 0));
+  EXPECT_EQ(rgba(255, 255, 255, 255), get_pixel(image.get(), 2, 1));
+  EXPECT_EQ(rgba(0, 0, 255, 255), get_pixel(image.get(), 3, 1));
+  EXPECT_EQ(0, get_pixel(image.get(), 4, 0));
+  EXPECT_EQ(0, get_pixel(image.get(), 5, 1));
+
+  // Same versions, same image
+  EXPECT_EQ(image, cache.getImage(tilemap.get(), ts.tileset.get()));
+}
+
+TEST(TilemapCache, UpdateModifiedTiles)
+{
+  TestTileset ts;
+  ImageRef tilemap(Image::create(IMAGE_TILEMAP, 2, 1));
+  put_pixel(tilemap.get(), 0, 0, tile(1, 0));
+  put_pixel(tilemap.get(), 1, 0, notile);
+
+  TilemapCache cache;
+  ImageRef image = cache.getImage(tilemap.get(), ts.tileset.get());
+  ASSERT_TRUE(image);
+
+  // New tile in the tilemap
+  put_pixel(tilemap.get(), 1, 0, tile(1, tile_f_yflip));
+  tilemap->incrementVersion();
+
+  ImageRef image2 = cache.getImage(tilemap.get(), ts.tileset.get());
+  ASSERT_TRUE(image2);
+  EXPECT_EQ(rgba(0, 0, 255, 255), get_pixel(image2.get(), 2, 0));
+  EXPECT_EQ(rgba(255, 0, 0, 255), get_pixel(image2.get(), 2, 1));
+
+  // The image that was in use is not modified
+  EXPECT_NE(image, image2);
+  EXPECT_EQ(0, get_pixel(image.get(), 2, 0));
+  image.reset();
+
+  // Modified tile in the tileset
+  ImageRef tileImage = ts.tileset->get(1);
+  put_pixel(tileImage.get(), 0, 0, rgba(0, 0, 0, 255));
+  tileImage->incrementVersion();
+  ts.tileset->incrementVersion();
+
+  image = cache.getImage(tilemap.get(), ts.tileset.get());
+  ASSERT_TRUE(image);
+  EXPECT_EQ(rgba(0, 0, 0, 255), get_pixel(image.get(), 0, 0));
+  EXPECT_EQ(rgba(0, 0, 0, 255), get_pixel(image.get(), 2, 1));
+}
+
+TEST(TilemapCache, BigTilemapsAreNotCached)
+{
+  TestTileset ts;
+  ImageRef tilemap(Image::create(IMAGE_TILEMAP, 64, 64));
+  clear_image(tilemap.get(), tile(1, 0));
+
+  // 128x128 RGB pixels don't fit in a quarter of the cache
+  TilemapCache cache(128 * 128 * 4);
+  EXPECT_FALSE(cache.getImage(tilemap.get(), ts.tileset.get()));
+  EXPECT_EQ(0u, cache.bytes());
+}
@@ -0,0 +1,195 @@
+// Aseprite Tracing Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "tracing/metrics.h"
+
+#include "base/file_handle.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace tracing {
+
+namespace {
+
+// The registry is created the first time a metric is registered, so
+// it is destroyed after all the static metrics.
+struct Registry {
+  std::mutex mutex;
+  std::vector<Metric*> metrics;
+};
+
+Registry& registry()
+{
+  static Registry registry;
+  return registry;
+}
+
+int bucket_index(int64_t value)
+{
+  int i = 0;
+  while (value > 0 && i < Histogram::kBuckets - 1) {
+    value >>= 1;
+    ++i;
+  }
+  return i;
+}
+
+} // anonymous namespace
+
+Metric::Metric(const char* name, const Type type) : m_name(name), m_type(type)
+{
+  Registry& reg = registry();
+  const std::lock_guard lock(reg.mutex);
+  reg.metrics.push_back(this);
+}
+
+Metric::~Metric()
+{
+  Registry& reg = registry();
+  const std::lock_guard lock(reg.mutex);
+  auto it = std::find(reg.metrics.begin(), reg.metrics.end(), this);
+  if (it != reg.metrics.end())
+    reg.metrics.erase(it);
+}
+
+void Histogram::add(const int64_t value)
+{
+  m_count.fetch_add(1, std::memory_order_relaxed);
+  m_sum.fetch_add(value, std::memory_order_relaxed);
+  m_buckets[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+
+  int64_t max = m_max.load(std::memory_order_relaxed);
+  while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+    // Try again with the new max value
+  }
+}
+
+int64_t Histogram::percentile(const double fraction) const
+{
+  // Samples can be added while we iterate the buckets, so we count
+  // the samples of the buckets instead of using m_count.
+  int64_t total = 0;
+  for (const auto& bucket : m_buckets)
+    total += bucket.load(std::memory_order_relaxed);
+  if (total == 0)
+    return 0;
+
+  const int64_t n = std::max<int64_t>(1, int64_t(fraction * double(total) + 0.5));
+  int64_t accum = 0;
+  for (int i = 0; i < kBuckets; ++i) {
+    accum += m_buckets[i].load(std::memory_order_relaxed);
+    if (accum >= n)
+      return std::min((i == 0 ? 0 : (int64_t(1) << i) - 1), max());
+  }
+  return max();
+}
+
+void Histogram::reset()
+{
+  m_count.store(0, std::memory_order_relaxed);
+  m_sum.store(0, std::memory_order_relaxed);
+  m_max.store(0, std::memory_order_relaxed);
+  for (auto& bucket : m_buckets)
+    bucket.store(0, std::memory_order_relaxed);
+}
+
+void for_each_metric(const std::function<void(const Metric&)>& func)
+{
+  Registry& reg = registry();
+  const std::lock_guard lock(reg.mutex);
+
+  std::vector<Metric*> metrics = reg.metrics;
+  std::sort(metrics.begin(), metrics.end(), [](const Metric* a, const Metric* b) {
+    return std::strcmp(a->name(), b->name()) < 0;
+  });
+  for (const Metric* metric : metrics)
+    func(*metric);
+}
+
+void reset_metrics()
+{
+  Registry& reg = registry();
+  const std::lock_guard lock(reg.mutex);
+  for (Metric* metric : reg.metrics)
+    metric->reset();
+}
+
+std::string metrics_to_text()
+{
+  std::string text;
+  for_each_metric([&text](const Metric& metric) {
+    char buf[256];
+    if (metric.type() == Metric::Type::Counter) {
+      const auto& counter = static_cast<const Counter&>(metric);
+      if (counter.value() == 0)
+        return;
+      std::snprintf(buf, sizeof(buf), "%s: %" PRId64 "\n", metric.name(), counter.value());
+    }
+    else {
+      const auto& histogram = static_cast<const Histogram&>(metric);
+      const int64_t count = histogram.count();
+      if (count == 0)
+        return;
+      std::snprintf(buf,
+                    sizeof(buf),
+                    "%s: count=%" PRId64 " avg=%" PRId64 " p50=%" PRId64 " p99=%" PRId64
+                    " max=%" PRId64 "\n",
+                    metric.name(),
+                    count,
+                    histogram.sum() / count,
+                    histogram.percentile(0.5),
+                    histogram.percentile(0.99),
+                    histogram.max());
+    }
+    text += buf;
+  });
+  return text;
+}
+
+bool save_metrics(const std::string& filename)
+{
+  base::FileHandle handle(base::open_file(filename, "wb"));
+  FILE* f = handle.get();
+  if (!f)
+    return false;
+
+  // Metric names are identifiers (e.g. "render.sprite_us") so they
+  // don't need to be escaped.
+  std::fputs("{", f);
+  bool first = true;
+  for_each_metric([f, &first](const Metric& metric) {
+    std::fprintf(f, "%s\n  \"%s\": ", (first ? "" : ","), metric.name());
+    if (metric.type() == Metric::Type::Counter) {
+      std::fprintf(f, "%" PRId64, static_cast<const Counter&>(metric).value());
+    }
+    else {
+      const auto& histogram = static_cast<const Histogram&>(metric);
+      std::fprintf(f,
+                   "{\"count\":%" PRId64 ",\"sum\":%" PRId64 ",\"max\":%" PRId64
+                   ",\"p50\":%" PRId64 ",\"p90\":%" PRId64 ",\"p99\":%" PRId64 "}",
+                   histogram.count(),
+                   histogram.sum(),
+                   histogram.max(),
+                   histogram.percentile(0.5),
+                   histogram.percentile(0.9),
+                   histogram.percentile(0.99));
+    }
+    first = false;
+  });
+  std::fputs("\n}\n", f);
+  return (std::ferror(f) == 0);
+}
+
+} // namespace tracing
@@ -0,0 +1,140 @@
+// Aseprite Tracing Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef TRACING_METRICS_H_INCLUDED
+#define TRACING_METRICS_H_INCLUDED
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// Counters and histograms of the program (cache hits, decoded bytes,
+// render times, etc.) that can be inspected at any time (from the
+// developer console, scripts, or saved with --perf-counters). E.g.
+//
+//   static tracing::Counter g_hits("render.cache.hits");
+//   g_hits.add();
+//
+//   static tracing::Histogram g_time("render.sprite_us");
+//   {
+//     tracing::Histogram::Timer timer(g_time);
+//     ...
+//   }
+//
+// Metrics are always enabled, updating one is just a couple of
+// relaxed atomic operations. They must be static objects (they are
+// registered while they exist), and the names are not copied, so
+// they must be string literals.
+
+namespace tracing {
+
+class Metric {
+public:
+  enum class Type { Counter, Histogram };
+
+  const char* name() const { return m_name; }
+  Type type() const { return m_type; }
+
+  virtual void reset() = 0;
+
+protected:
+  Metric(const char* name, Type type);
+  virtual ~Metric();
+
+  Metric(const Metric&) = delete;
+  Metric& operator=(const Metric&) = delete;
+
+private:
+  const char* m_name;
+  Type m_type;
+};
+
+// A value that can be incremented (e.g. number of cache hits) or set
+// (e.g. current size of a queue).
+class Counter : public Metric {
+public:
+  explicit Counter(const char* name) : Metric(name, Type::Counter) {}
+
+  void add(const int64_t n = 1) { m_value.fetch_add(n, std::memory_order_relaxed); }
+  void set(const int64_t value) { m_value.store(value, std::memory_order_relaxed); }
+  int64_t value() const { return m_value.load(std::memory_order_relaxed); }
+
+  void reset() override { set(0); }
+
+private:
+  std::atomic<int64_t> m_value{ 0 };
+};
+
+// Distribution of values (e.g. durations in microseconds) in buckets
+// of powers of 2, so percentiles are approximated.
+class Histogram : public Metric {
+public:
+  // Bucket i contains values in [2^(i-1), 2^i), bucket 0 contains 0.
+  static constexpr int kBuckets = 40;
+
+  // Adds the time elapsed in its scope (in microseconds).
+  class Timer {
+  public:
+    explicit Timer(Histogram& histogram)
+      : m_histogram(histogram)
+      , m_start(std::chrono::steady_clock::now())
+    {
+    }
+    ~Timer()
+    {
+      m_histogram.add(std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - m_start)
+                        .count());
+    }
+
+    Timer(const Timer&) = delete;
+    Timer& operator=(const Timer&) = delete;
+
+  private:
+    Histogram& m_histogram;
+    std::chrono::steady_clock::time_point m_start;
+  };
+
+  explicit Histogram(const char* name) : Metric(name, Type::Histogram) {}
+
+  void add(int64_t value);
+
+  int64_t count() const { return m_count.load(std::memory_order_relaxed); }
+  int64_t sum() const { return m_sum.load(std::memory_order_relaxed); }
+  int64_t max() const { return m_max.load(std::memory_order_relaxed); }
+
+  // Returns an upper bound of the value below which the given
+  // fraction of samples are (e.g. 0.99 for the 99th percentile).
+  int64_t percentile(double fraction) const;
+
+  void reset() override;
+
+private:
+  std::atomic<int64_t> m_count{ 0 };
+  std::atomic<int64_t> m_sum{ 0 };
+  std::atomic<int64_t> m_max{ 0 };
+  std::atomic<int64_t> m_buckets[kBuckets] = {};
+};
+
+// Calls the function for each existing metric (sorted by name).
+void for_each_metric(const std::function<void(const Metric&)>& func);
+
+// Resets all metrics to zero (e.g. before measuring an operation).
+void reset_metrics();
+
+// Returns one line for each metric with a non-zero value.
+std::string metrics_to_text();
+
+// Saves all the metrics in a JSON file. Returns false if the file
+// couldn't be written.
+bool save_metrics(const std::string& filename);
+
+} // namespace tracing
+
+#endif
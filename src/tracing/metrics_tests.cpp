@@ -0,0 +1,80 @@
+// Aseprite Tracing Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "tracing/metrics.h"
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tracing;
+
+TEST(Metrics, Counter)
+{
+  Counter counter("tests.counter");
+  counter.add();
+  counter.add(4);
+  EXPECT_EQ(5, counter.value());
+  counter.set(2);
+  EXPECT_EQ(2, counter.value());
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; ++i)
+    threads.emplace_back([&counter] {
+      for (int j = 0; j < 1000; ++j)
+        counter.add();
+    });
+  for (auto& thread : threads)
+    thread.join();
+  EXPECT_EQ(4002, counter.value());
+
+  reset_metrics();
+  EXPECT_EQ(0, counter.value());
+}
+
+TEST(Metrics, Histogram)
+{
+  Histogram histogram("tests.histogram");
+  for (int i = 1; i <= 100; ++i)
+    histogram.add(i);
+  EXPECT_EQ(100, histogram.count());
+  EXPECT_EQ(5050, histogram.sum());
+  EXPECT_EQ(100, histogram.max());
+
+  // Upper bounds of the buckets: 50 is in [32, 64), 99 in [64, 128)
+  EXPECT_EQ(63, histogram.percentile(0.5));
+  EXPECT_EQ(100, histogram.percentile(0.99));
+
+  histogram.reset();
+  EXPECT_EQ(0, histogram.count());
+  EXPECT_EQ(0, histogram.percentile(0.5));
+}
+
+TEST(Metrics, Registry)
+{
+  std::string names;
+  {
+    Counter b("tests.b");
+    Histogram a("tests.a");
+    b.add(3);
+    a.add(10);
+
+    for_each_metric([&names](const Metric& metric) {
+      if (std::string(metric.name()).find("tests.") == 0)
+        names += std::string(metric.name()) + " ";
+    });
+
+    const std::string text = metrics_to_text();
+    EXPECT_NE(std::string::npos, text.find("tests.b: 3\n"));
+    EXPECT_NE(std::string::npos, text.find("tests.a: count=1 avg=10 p50=10 p99=10 max=10\n"));
+  }
+  EXPECT_EQ("tests.a tests.b ", names);
+
+  // Destroyed metrics are unregistered
+  EXPECT_EQ(std::string::npos, metrics_to_text().find("tests.b"));
+}
@@ -0,0 +1,171 @@
+// Aseprite Tracing Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "tracing/tracing.h"
+
+#include "base/file_handle.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tracing {
+
+namespace details {
+std::atomic<bool> g_enabled(false);
+}
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Limit of events recorded in each thread (about 24MB), new events
+// are discarded when this limit is reached.
+constexpr std::size_t kMaxEventsPerThread = 1024 * 1024;
+
+struct Event {
+  const char* name;
+  double start;
+  double duration;
+};
+
+// Events recorded by one thread. Each thread has its own list (that
+// is never deleted) so recording events doesn't lock a global mutex.
+struct ThreadEvents {
+  int tid = 0;
+  std::string name;
+  std::mutex mutex;
+  std::vector<Event> events;
+  std::size_t discarded = 0;
+};
+
+std::mutex g_mutex;
+std::vector<std::unique_ptr<ThreadEvents>> g_threads;
+std::string g_filename;
+Clock::time_point g_startTime;
+
+ThreadEvents* current_thread_events()
+{
+  thread_local ThreadEvents* current = nullptr;
+  if (!current) {
+    const std::lock_guard lock(g_mutex);
+    g_threads.push_back(std::make_unique<ThreadEvents>());
+    current = g_threads.back().get();
+    current->tid = int(g_threads.size());
+  }
+  return current;
+}
+
+void write_json_string(FILE* f, const char* s)
+{
+  std::fputc('"', f);
+  for (; *s; ++s) {
+    if (*s == '"' || *s == '\\')
+      std::fputc('\\', f);
+    if (*s >= 0 && *s < 32)
+      std::fputc(' ', f);
+    else
+      std::fputc(*s, f);
+  }
+  std::fputc('"', f);
+}
+
+} // anonymous namespace
+
+void start(const std::string& filename)
+{
+  const std::lock_guard lock(g_mutex);
+  for (auto& thread : g_threads) {
+    const std::lock_guard threadLock(thread->mutex);
+    thread->events.clear();
+    thread->discarded = 0;
+  }
+  g_filename = filename;
+  g_startTime = Clock::now();
+  details::g_enabled.store(true, std::memory_order_release);
+}
+
+bool stop()
+{
+  if (!details::g_enabled.exchange(false))
+    return false;
+
+  const std::lock_guard lock(g_mutex);
+  base::FileHandle handle(base::open_file(g_filename, "wb"));
+  FILE* f = handle.get();
+  if (!f)
+    return false;
+
+  std::fputs("{\"traceEvents\":[\n", f);
+  bool first = true;
+  for (auto& thread : g_threads) {
+    const std::lock_guard threadLock(thread->mutex);
+    if (!thread->name.empty()) {
+      std::fprintf(f,
+                   "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,"
+                   "\"args\":{\"name\":",
+                   (first ? "" : ",\n"),
+                   thread->tid);
+      write_json_string(f, thread->name.c_str());
+      std::fputs("}}", f);
+      first = false;
+    }
+    for (const Event& event : thread->events) {
+      std::fputs(first ? "{\"name\":" : ",\n{\"name\":", f);
+      write_json_string(f, event.name);
+      std::fprintf(f,
+                   ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%d}",
+                   event.start,
+                   event.duration,
+                   thread->tid);
+      first = false;
+    }
+    if (thread->discarded > 0) {
+      std::fprintf(f,
+                   "%s{\"name\":\"Discarded %zu events\",\"ph\":\"i\",\"s\":\"t\","
+                   "\"ts\":%.3f,\"pid\":1,\"tid\":%d}",
+                   (first ? "" : ",\n"),
+                   thread->discarded,
+                   (thread->events.empty() ? 0.0 : thread->events.back().start),
+                   thread->tid);
+      first = false;
+    }
+    thread->events.clear();
+    thread->discarded = 0;
+  }
+  std::fputs("\n]}\n", f);
+  return (std::ferror(f) == 0);
+}
+
+void set_thread_name(const char* name)
+{
+  ThreadEvents* thread = current_thread_events();
+  const std::lock_guard lock(thread->mutex);
+  thread->name = name;
+}
+
+double now()
+{
+  return std::chrono::duration<double, std::micro>(Clock::now() - g_startTime).count();
+}
+
+void add_event(const char* name, const double start, const double duration)
+{
+  ThreadEvents* thread = current_thread_events();
+  const std::lock_guard lock(thread->mutex);
+  if (thread->events.size() < kMaxEventsPerThread)
+    thread->events.push_back(Event{ name, start, duration });
+  else
+    ++thread->discarded;
+}
+
+} // namespace tracing
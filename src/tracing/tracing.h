@@ -0,0 +1,81 @@
+// Aseprite Tracing Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef TRACING_TRACING_H_INCLUDED
+#define TRACING_TRACING_H_INCLUDED
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Records the duration of scoped events (in each thread) to be saved
+// in the Chrome trace event format (a JSON file that can be opened
+// with chrome://tracing or https://ui.perfetto.dev).
+//
+// When the tracing is not started, a TRACING_SCOPE() costs just one
+// load of an atomic flag.
+//
+// Event names are not copied, so they must be string literals (or
+// strings that live until tracing::stop() is called). A nullptr name
+// can be used to skip the event.
+
+namespace tracing {
+
+namespace details {
+extern std::atomic<bool> g_enabled;
+}
+
+inline bool is_enabled()
+{
+  return details::g_enabled.load(std::memory_order_acquire);
+}
+
+// Starts recording events, they will be saved in the given file
+// when stop() is called.
+void start(const std::string& filename);
+
+// Stops recording events and writes the trace file. Returns false if
+// the tracing wasn't started or the file couldn't be written.
+bool stop();
+
+// Name of the current thread in the trace file (e.g. "UI").
+void set_thread_name(const char* name);
+
+// Microseconds since start() was called.
+double now();
+
+void add_event(const char* name, double start, double duration);
+
+class Scope {
+public:
+  explicit Scope(const char* name)
+    : m_name(is_enabled() ? name : nullptr)
+    , m_start(m_name ? now() : 0.0)
+  {
+  }
+
+  ~Scope()
+  {
+    if (m_name)
+      add_event(m_name, m_start, now() - m_start);
+  }
+
+  Scope(const Scope&) = delete;
+  Scope& operator=(const Scope&) = delete;
+
+private:
+  const char* m_name;
+  double m_start;
+};
+
+} // namespace tracing
+
+#define TRACING_CONCAT_IMPL(a, b) a##b
+#define TRACING_CONCAT(a, b)      TRACING_CONCAT_IMPL(a, b)
+#define TRACING_SCOPE(name)       tracing::Scope TRACING_CONCAT(tracing_scope_, __LINE__)(name)
+
+#endif
@@ -0,0 +1,73 @@
+// Aseprite Tracing Library
+// Copyright (c) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#include "gtest/gtest.h"
+
+#include "tracing/tracing.h"
+
+#include "base/file_content.h"
+#include "base/fs.h"
+
+#include <string>
+#include <thread>
+
+using namespace tracing;
+
+namespace {
+
+std::string read_trace(const std::string& fn)
+{
+  const auto buf = base::read_file_content(fn);
+  return std::string((const char*)buf.data(), buf.size());
+}
+
+} // anonymous namespace
+
+TEST(Tracing, Disabled)
+{
+  EXPECT_FALSE(is_enabled());
+  {
+    TRACING_SCOPE("Not recorded");
+  }
+  EXPECT_FALSE(stop());
+}
+
+TEST(Tracing, WriteEvents)
+{
+  const std::string fn = base::join_path(base::get_temp_path(), "aseprite-tracing-tests.json");
+
+  start(fn);
+  EXPECT_TRUE(is_enabled());
+  set_thread_name("Main \"thread\"");
+  {
+    TRACING_SCOPE("Outer");
+    {
+      TRACING_SCOPE("Inner");
+    }
+  }
+  std::thread thread([] { TRACING_SCOPE("Task"); });
+  thread.join();
+  ASSERT_TRUE(stop());
+  EXPECT_FALSE(is_enabled());
+
+  {
+    TRACING_SCOPE("After stop");
+  }
+
+  const std::string json = read_trace(fn);
+  base::delete_file(fn);
+
+  EXPECT_EQ(0, json.find("{\"traceEvents\":["));
+  EXPECT_NE(std::string::npos, json.find("\"args\":{\"name\":\"Main \\\"thread\\\"\"}"));
+  EXPECT_NE(std::string::npos, json.find("{\"name\":\"Outer\",\"ph\":\"X\""));
+  EXPECT_NE(std::string::npos, json.find("{\"name\":\"Inner\",\"ph\":\"X\""));
+  EXPECT_NE(std::string::npos, json.find("{\"name\":\"Task\",\"ph\":\"X\""));
+  EXPECT_EQ(std::string::npos, json.find("Not recorded"));
+  EXPECT_EQ(std::string::npos, json.find("After stop"));
+
+  // Inner events are recorded first (when their scope ends)
+  EXPECT_LT(json.find("\"Inner\""), json.find("\"Outer\""));
+}
@@ -1,5 +1,5 @@
 // Aseprite UI Library
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -21,7 +21,6 @@
 
 #include "ui/manager.h"
 
-#include "base/concurrent_queue.h"
 #include "base/contains.h"
 #include "base/remove_from_container.h"
 #include "base/scoped_value.h"
@@ -34,9 +33,12 @@
 #include "os/system.h"
 #include "os/window.h"
 #include "os/window_spec.h"
+#include "tracing/metrics.h"
+#include "tracing/tracing.h"
 #include "ui/base.h"
 #include "ui/drag_event.h"
 #include "ui/intern.h"
+#include "ui/message_queue.h"
 #include "ui/ui.h"
 
 #include <algorithm>
@@ -80,7 +82,6 @@ struct Filter {
   Filter(int message, Widget* widget) : message(message), widget(widget) {}
 };
 
-typedef std::list<Message*> Messages;
 typedef std::list<Filter*> Filters;
 
 Manager* Manager::m_defaultManager = nullptr;
@@ -88,12 +89,18 @@ Manager* Manager::m_defaultManager = nullptr;
 static std::thread::id manager_thread;
 
 static WidgetsList mouse_widgets_list; // List of widgets to send mouse events
-static Messages msg_queue;             // Messages queue
-static Messages used_msg_queue;        // Messages queue
-static base::concurrent_queue<Message*> concurrent_msg_queue;
+static WidgetsList deferred_layouts;   // Widgets to layout before the next paint
+static MessageQueue msg_queue;                   // Messages queue
+static std::vector<Message*> used_msg_queue;     // Messages being dispatched
+static ConcurrentMessages concurrent_msg_queue;  // Messages from other threads
 static Filters msg_filters[NFILTERS]; // Filters for every enqueued message
 static int filter_locks = 0;
 
+// Performance counters
+static tracing::Histogram g_paintTime("ui.paint_us");
+static tracing::Histogram g_queueDepth("ui.message_queue_depth");
+static tracing::Counter g_messages("ui.messages");
+
 // Current display with the mouse, used to avoid processing a
 // os::Event::MouseLeave of the non-current display/window as when we
 // move the mouse between two windows we can receive:
@@ -354,11 +361,8 @@ bool Manager::generateMessages()
     return false;
 
   // Generate messages from other threads
-  if (!concurrent_msg_queue.empty()) {
-    Message* msg = nullptr;
-    while (concurrent_msg_queue.try_pop(msg))
-      msg_queue.push_back(msg);
-  }
+  if (!concurrent_msg_queue.empty())
+    concurrent_msg_queue.popAll(msg_queue);
 
   // Generate messages from OS input
   generateMessagesFromOSEvents();
@@ -628,6 +632,22 @@ void Manager::handleMouseMove(Display* display,
 
   // Send the mouse movement message
   Widget* dst = (capture_widget ? capture_widget : mouse_widget);
+
+  // Coalesce consecutive mouse movements for the same widget that
+  // weren't dispatched yet (we keep only the last position, the
+  // previous ones are available in MouseMessage::history()).
+  if (Message* last = msg_queue.back()) {
+    if (last->type() == kMouseMoveMessage && last->recipient() == dst &&
+        last->display() == display) {
+      auto* mouseMsg = static_cast<MouseMessage*>(last);
+      if (mouseMsg->pointerType() == pointerType && mouseMsg->button() == m_mouseButton &&
+          mouseMsg->modifiers() == modifiers) {
+        mouseMsg->_coalesceMovement(mousePos, pressure);
+        return;
+      }
+    }
+  }
+
   enqueueMessage(newMouseMessage(kMouseMoveMessage,
                                  display,
                                  dst,
@@ -872,11 +892,19 @@ void Manager::dispatchMessages()
         redrawState = RedrawState::Normal;
 
       // Generate and send just kPaintMessages with the latest UI state.
-      flushRedraw();
-      pumpQueue();
+      {
+        TRACING_SCOPE("Manager::paint");
+        const tracing::Histogram::Timer timer(g_paintTime);
+        layoutDeferredWidgets();
+        flushRedraw();
+        pumpQueue();
+      }
 
       // Flip back-buffers to real displays.
-      flipAllDisplays();
+      {
+        TRACING_SCOPE("Manager::flipAllDisplays");
+        flipAllDisplays();
+      }
     }
   }
 }
@@ -888,6 +916,40 @@ void Manager::flushMessages() const
   m_eventQueue->queueEvent(evt);
 }
 
+void Manager::deferLayout(Widget* widget)
+{
+  ASSERT(manager_thread == std::this_thread::get_id());
+
+  if (std::find(deferred_layouts.begin(), deferred_layouts.end(), widget) ==
+      deferred_layouts.end()) {
+    deferred_layouts.push_back(widget);
+  }
+}
+
+// static
+void Manager::cancelDeferredLayout(Widget* widget)
+{
+  base::remove_from_container(deferred_layouts, widget);
+}
+
+void Manager::layoutDeferredWidgets()
+{
+  if (deferred_layouts.empty())
+    return;
+
+  WidgetsList widgets;
+  std::swap(widgets, deferred_layouts);
+
+  for (Widget* widget : widgets) {
+    // Skip widgets that are laid out by an ancestor in the same list
+    const bool byAncestor = std::any_of(widgets.begin(), widgets.end(), [widget](Widget* other) {
+      return (other != widget && widget->hasAncestor(other));
+    });
+    if (!byAncestor)
+      widget->layout();
+  }
+}
+
 void Manager::addToGarbage(Widget* widget)
 {
   ASSERT(widget);
@@ -899,7 +961,7 @@ void Manager::enqueueMessage(Message* msg)
   ASSERT(msg);
 
   if (is_ui_thread())
-    msg_queue.push_back(msg);
+    msg_queue.push(msg);
   else
     concurrent_msg_queue.push(msg);
 }
@@ -1171,8 +1233,7 @@ void Manager::removeMessagesFor(Widget* widget)
 {
   ASSERT(manager_thread == std::this_thread::get_id());
 
-  for (Message* msg : msg_queue)
-    msg->removeRecipient(widget);
+  msg_queue.removeRecipient(widget);
 
   for (Message* msg : used_msg_queue)
     msg->removeRecipient(widget);
@@ -1182,9 +1243,10 @@ void Manager::removeMessagesFor(Widget* widget, MessageType type)
 {
   ASSERT(manager_thread == std::this_thread::get_id());
 
-  for (Message* msg : msg_queue)
+  msg_queue.forEachFor(widget, [widget, type](Message* msg) {
     if (msg->type() == type)
       msg->removeRecipient(widget);
+  });
 
   for (Message* msg : used_msg_queue)
     if (msg->type() == type)
@@ -1195,12 +1257,12 @@ void Manager::removeMessagesForTimer(Timer* timer)
 {
   ASSERT(manager_thread == std::this_thread::get_id());
 
-  for (Message* msg : msg_queue) {
-    if (msg->type() == kTimerMessage && static_cast<TimerMessage*>(msg)->timer() == timer) {
+  msg_queue.forEachOfType(kTimerMessage, [timer](Message* msg) {
+    if (static_cast<TimerMessage*>(msg)->timer() == timer) {
       msg->removeRecipient(msg->recipient());
       static_cast<TimerMessage*>(msg)->_resetTimer();
     }
-  }
+  });
 
   for (Message* msg : used_msg_queue) {
     if (msg->type() == kTimerMessage && static_cast<TimerMessage*>(msg)->timer() == timer) {
@@ -1214,12 +1276,12 @@ void Manager::removeMessagesForDisplay(Display* display)
 {
   ASSERT(manager_thread == std::this_thread::get_id());
 
-  for (Message* msg : msg_queue) {
+  msg_queue.forEach([display](Message* msg) {
     if (msg->display() == display) {
       msg->removeRecipient(msg->recipient());
       msg->setDisplay(nullptr);
     }
-  }
+  });
 
   for (Message* msg : used_msg_queue) {
     if (msg->display() == display) {
@@ -1233,15 +1295,20 @@ void Manager::removePaintMessagesForDisplay(Display* display)
 {
   ASSERT(manager_thread == std::this_thread::get_id());
 
-  for (auto it = msg_queue.begin(); it != msg_queue.end();) {
-    Message* msg = *it;
-    if (msg->type() == kPaintMessage && msg->display() == display) {
-      delete msg;
-      it = msg_queue.erase(it);
+  msg_queue.eraseIf(kPaintMessage, [display](Message* msg) { return msg->display() == display; });
+}
+
+void Manager::takePaintMessagesFor(Widget* widget, Display* display, gfx::Region& region)
+{
+  ASSERT(manager_thread == std::this_thread::get_id());
+
+  msg_queue.eraseIfFor(widget, [widget, display, &region](Message* msg) {
+    if (msg->type() == kPaintMessage && msg->recipient() == widget && msg->display() == display) {
+      region |= gfx::Region(static_cast<PaintMessage*>(msg)->rect());
+      return true;
     }
-    else
-      ++it;
-  }
+    return false;
+  });
 }
 
 void Manager::addMessageFilter(int message, Widget* widget)
@@ -1878,6 +1945,10 @@ int Manager::pumpQueue()
   base::tick_t t = base::current_tick();
 #endif
 
+  TRACING_SCOPE(msg_queue.empty() ? nullptr : "Manager::pumpQueue");
+  if (!msg_queue.empty())
+    g_queueDepth.add(int64_t(msg_queue.size()));
+
   int count = 0; // Number of processed messages
   while (!msg_queue.empty()) {
 #if LIMIT_DISPATCH_TIME
@@ -1885,14 +1956,10 @@ int Manager::pumpQueue()
       break;
 #endif
 
-    // The message to process
-    auto it = msg_queue.begin();
-    Message* msg = *it;
+    // Move the message to process from msg_queue to used_msg_queue
+    Message* msg = msg_queue.pop();
     ASSERT(msg);
-
-    // Move the message from msg_queue to used_msg_queue
-    msg_queue.erase(it);
-    auto eraseIt = used_msg_queue.insert(used_msg_queue.end(), msg);
+    used_msg_queue.push_back(msg);
 
     // Call Timer::tick() if this is a tick message.
     if (msg->type() == kTimerMessage) {
@@ -1930,14 +1997,19 @@ int Manager::pumpQueue()
         done = sendMessageToWidget(msg, widget);
     }
 
-    // Remove the message from the used_msg_queue
-    used_msg_queue.erase(eraseIt);
+    // Remove the message from the used_msg_queue (messages
+    // dispatched in nested pumpQueue() calls were already removed, so
+    // this should be the last one)
+    ASSERT(!used_msg_queue.empty() && used_msg_queue.back() == msg);
+    base::remove_from_container(used_msg_queue, msg);
 
     // Destroy the message
     delete msg;
     ++count;
   }
 
+  if (count > 0)
+    g_messages.add(count);
   return count;
 }
 
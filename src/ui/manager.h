@@ -1,5 +1,5 @@
 // Aseprite UI Library
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2017  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -77,6 +77,12 @@ public:
   void addToGarbage(Widget* widget);
   void collectGarbage();
 
+  // Widgets to be laid out before the next paint (see
+  // Widget::deferLayout()).
+  void deferLayout(Widget* widget);
+  void layoutDeferredWidgets();
+  static void cancelDeferredLayout(Widget* widget);
+
   Window* getTopWindow() const;
   Window* getDesktopWindow() const;
   Window* getForegroundWindow() const;
@@ -101,6 +107,11 @@ public:
   void removeMessagesForDisplay(Display* display);
   void removePaintMessagesForDisplay(Display* display);
 
+  // Removes the kPaintMessage messages of the widget that weren't
+  // dispatched yet adding their areas to the given region (so we can
+  // generate just one chain of paint messages for the whole region).
+  void takePaintMessagesFor(Widget* widget, Display* display, gfx::Region& region);
+
   void addMessageFilter(int message, Widget* widget);
   void removeMessageFilter(int message, Widget* widget);
   void removeMessageFilterFor(Widget* widget);
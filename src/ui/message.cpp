@@ -1,5 +1,5 @@
 // Aseprite UI Library
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -14,12 +14,89 @@
 #include "base/memory.h"
 #include "os/system.h"
 #include "ui/display.h"
+#include "ui/system.h"
 #include "ui/widget.h"
 
 #include <cstring>
 
 namespace ui {
 
+namespace {
+
+// Memory blocks of deleted messages grouped by size (in steps of
+// kBlockStep bytes). Blocks are always allocated with the rounded
+// size so a block can be reused for any message of the same group.
+// Only the UI thread uses the free lists, messages created/deleted
+// from other threads use the default allocator directly.
+constexpr std::size_t kBlockStep = 16;
+constexpr std::size_t kMaxBlockSize = 256;
+constexpr std::size_t kMaxFreeBlocks = 256;
+constexpr std::size_t kBlockGroups = kMaxBlockSize / kBlockStep;
+
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct MessagePool {
+  FreeBlock* freeBlocks[kBlockGroups] = {};
+  std::size_t count[kBlockGroups] = {};
+
+  ~MessagePool()
+  {
+    for (std::size_t i = 0; i < kBlockGroups; ++i) {
+      while (FreeBlock* block = freeBlocks[i]) {
+        freeBlocks[i] = block->next;
+        ::operator delete(block);
+      }
+      // Don't reuse blocks from now on
+      count[i] = kMaxFreeBlocks;
+    }
+  }
+};
+
+MessagePool g_pool;
+
+std::size_t block_group(const std::size_t size)
+{
+  return (size + kBlockStep - 1) / kBlockStep - 1;
+}
+
+} // anonymous namespace
+
+void* Message::operator new(const std::size_t size)
+{
+  if (size > kMaxBlockSize)
+    return ::operator new(size);
+
+  const std::size_t group = block_group(size);
+  if (is_ui_thread()) {
+    if (FreeBlock* block = g_pool.freeBlocks[group]) {
+      g_pool.freeBlocks[group] = block->next;
+      --g_pool.count[group];
+      return block;
+    }
+  }
+  return ::operator new((group + 1) * kBlockStep);
+}
+
+void Message::operator delete(void* ptr, const std::size_t size)
+{
+  if (!ptr)
+    return;
+
+  if (size <= kMaxBlockSize && is_ui_thread()) {
+    const std::size_t group = block_group(size);
+    if (g_pool.count[group] < kMaxFreeBlocks) {
+      auto* block = static_cast<FreeBlock*>(ptr);
+      block->next = g_pool.freeBlocks[group];
+      g_pool.freeBlocks[group] = block;
+      ++g_pool.count[group];
+      return;
+    }
+  }
+  ::operator delete(ptr);
+}
+
 Message::Message(MessageType type, KeyModifiers modifiers)
   : m_type(type)
   , m_flags(0)
@@ -1,5 +1,5 @@
 // Aseprite UI Library
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -20,7 +20,9 @@
 #include "ui/mouse_button.h"
 #include "ui/pointer_type.h"
 
+#include <cstddef>
 #include <functional>
+#include <vector>
 
 namespace ui {
 
@@ -39,6 +41,12 @@ public:
   Message(MessageType type, KeyModifiers modifiers = kKeyUninitializedModifier);
   virtual ~Message();
 
+  // Messages are created and deleted all the time (e.g. mouse
+  // movement or paint messages), so the memory of messages deleted
+  // in the UI thread is reused for new messages.
+  static void* operator new(std::size_t size);
+  static void operator delete(void* ptr, std::size_t size);
+
   MessageType type() const { return m_type; }
   Display* display() const { return m_display; }
   Widget* recipient() const { return m_recipient; }
@@ -213,6 +221,26 @@ public:
   // Absolute position of this message on the screen.
   gfx::Point screenPosition() const;
 
+  // Previous positions of kMouseMoveMessage messages coalesced in
+  // this one (from older to newer, the current position() is not
+  // included). Useful for freehand tools that need all the movement.
+  struct Sample {
+    gfx::Point position;
+    float pressure;
+  };
+  using Samples = std::vector<Sample>;
+  const Samples& history() const { return m_history; }
+
+  // Used by the Manager to coalesce a new mouse movement in this
+  // message when it wasn't dispatched yet (the current position is
+  // moved to the history).
+  void _coalesceMovement(const gfx::Point& pos, const float pressure)
+  {
+    m_history.push_back(Sample{ m_pos, m_pressure });
+    m_pos = pos;
+    m_pressure = pressure;
+  }
+
 private:
   PointerType m_pointerType;
   MouseButton m_button;    // Pressed button
@@ -220,6 +248,7 @@ private:
   gfx::Point m_wheelDelta; // Wheel axis variation
   bool m_preciseWheel;
   float m_pressure;
+  Samples m_history;
 };
 
 class TouchMessage : public Message {
@@ -0,0 +1,174 @@
+// Aseprite UI Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "ui/message_queue.h"
+
+namespace ui {
+
+MessageQueue::~MessageQueue()
+{
+  clear();
+}
+
+void MessageQueue::push(Message* msg)
+{
+  ASSERT(msg);
+
+  const uint64_t seq = m_firstSeq + m_entries.size();
+  Widget* recipient = msg->recipient();
+  m_entries.push_back(Entry{ msg, recipient });
+  ++m_size;
+
+  if (recipient)
+    m_byRecipient[recipient].push_back(seq);
+  if (msg->type() < kFirstRegisteredMessage)
+    m_byType[msg->type()].push_back(seq);
+}
+
+Message* MessageQueue::pop()
+{
+  while (!m_entries.empty()) {
+    const Entry entry = m_entries.front();
+    const uint64_t seq = m_firstSeq;
+    m_entries.pop_front();
+    ++m_firstSeq;
+
+    if (entry.msg) {
+      --m_size;
+      unindex(entry, seq);
+      return entry.msg;
+    }
+  }
+  return nullptr;
+}
+
+Message* MessageQueue::back() const
+{
+  for (auto it = m_entries.rbegin(); it != m_entries.rend(); ++it) {
+    if (it->msg)
+      return it->msg;
+  }
+  return nullptr;
+}
+
+void MessageQueue::removeRecipient(Widget* widget)
+{
+  auto it = m_byRecipient.find(widget);
+  if (it == m_byRecipient.end())
+    return;
+
+  for (uint64_t seq : it->second) {
+    if (Message* msg = messageAt(seq))
+      msg->removeRecipient(widget);
+  }
+  m_byRecipient.erase(it);
+}
+
+void MessageQueue::eraseAt(uint64_t seq)
+{
+  Entry& entry = m_entries[std::size_t(seq - m_firstSeq)];
+  ASSERT(entry.msg);
+  delete entry.msg;
+  entry.msg = nullptr;
+  --m_size;
+
+  // The erased entry is kept as a hole in the queue and in the
+  // indexes (removed in pop()) because we can be iterating them.
+}
+
+void MessageQueue::unindex(const Entry& entry, const uint64_t seq)
+{
+  // Messages are popped in order, so the index of this message (and
+  // the holes of erased messages before it) are at the beginning of
+  // each index.
+  if (entry.msg->type() < kFirstRegisteredMessage) {
+    auto& seqs = m_byType[entry.msg->type()];
+    while (!seqs.empty() && seqs.front() <= seq)
+      seqs.pop_front();
+  }
+
+  if (entry.recipient) {
+    auto it = m_byRecipient.find(entry.recipient);
+    if (it != m_byRecipient.end()) {
+      Seqs& seqs = it->second;
+      auto end = seqs.begin();
+      while (end != seqs.end() && *end <= seq)
+        ++end;
+      seqs.erase(seqs.begin(), end);
+      if (seqs.empty())
+        m_byRecipient.erase(it);
+    }
+  }
+
+  // Remove holes of erased messages at the beginning of the queue
+  // and reset the indexes when the queue is empty.
+  if (m_size == 0)
+    clear();
+}
+
+void MessageQueue::clear()
+{
+  for (Entry& entry : m_entries)
+    delete entry.msg;
+
+  m_firstSeq += m_entries.size();
+  m_entries.clear();
+  m_size = 0;
+  m_byRecipient.clear();
+  for (auto& seqs : m_byType)
+    seqs.clear();
+}
+
+ConcurrentMessages::~ConcurrentMessages()
+{
+  Node* node = m_head.exchange(nullptr);
+  while (node) {
+    Node* next = node->next;
+    delete node->msg;
+    delete node;
+    node = next;
+  }
+}
+
+void ConcurrentMessages::push(Message* msg)
+{
+  ASSERT(msg);
+
+  Node* node = new Node{ msg, m_head.load(std::memory_order_relaxed) };
+  while (!m_head.compare_exchange_weak(node->next,
+                                       node,
+                                       std::memory_order_release,
+                                       std::memory_order_relaxed)) {
+    // node->next was updated with the current head, try again
+  }
+}
+
+void ConcurrentMessages::popAll(MessageQueue& queue)
+{
+  Node* node = m_head.exchange(nullptr, std::memory_order_acquire);
+
+  // Reverse the list to get the messages in the pushed order
+  Node* first = nullptr;
+  while (node) {
+    Node* next = node->next;
+    node->next = first;
+    first = node;
+    node = next;
+  }
+
+  while (first) {
+    Node* next = first->next;
+    queue.push(first->msg);
+    delete first;
+    first = next;
+  }
+}
+
+} // namespace ui
@@ -0,0 +1,183 @@
+// Aseprite UI Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef UI_MESSAGE_QUEUE_H_INCLUDED
+#define UI_MESSAGE_QUEUE_H_INCLUDED
+#pragma once
+
+#include "base/debug.h"
+#include "ui/message.h"
+#include "ui/message_type.h"
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+namespace ui {
+
+class Widget;
+
+// Queue of messages indexed by recipient and by type, so we can find
+// the messages of a widget (or the kPaintMessage/kTimerMessage
+// messages) without iterating the whole queue. Messages in the queue
+// are owned by the queue until they are popped. It must be used only
+// from the UI thread.
+class MessageQueue {
+public:
+  MessageQueue() = default;
+  MessageQueue(const MessageQueue&) = delete;
+  MessageQueue& operator=(const MessageQueue&) = delete;
+  ~MessageQueue();
+
+  bool empty() const { return m_size == 0; }
+  std::size_t size() const { return m_size; }
+
+  void push(Message* msg);
+
+  // Removes the first message of the queue and returns it (the caller
+  // is the new owner of the message), or nullptr if the queue is
+  // empty.
+  Message* pop();
+
+  // Returns the last message of the queue (or nullptr if the queue is
+  // empty).
+  Message* back() const;
+
+  // Calls func(msg) for each message in the queue.
+  template<typename Func>
+  void forEach(Func&& func)
+  {
+    for (const Entry& entry : m_entries) {
+      if (entry.msg)
+        func(entry.msg);
+    }
+  }
+
+  // Calls func(msg) for each message that had the given widget as
+  // recipient when it was pushed.
+  template<typename Func>
+  void forEachFor(Widget* widget, Func&& func)
+  {
+    auto it = m_byRecipient.find(widget);
+    if (it == m_byRecipient.end())
+      return;
+    for (uint64_t seq : it->second) {
+      if (Message* msg = messageAt(seq))
+        func(msg);
+    }
+  }
+
+  // Calls func(msg) for each message of the given type.
+  template<typename Func>
+  void forEachOfType(MessageType type, Func&& func)
+  {
+    if (type >= kFirstRegisteredMessage) {
+      forEach([type, &func](Message* msg) {
+        if (msg->type() == type)
+          func(msg);
+      });
+      return;
+    }
+    for (uint64_t seq : m_byType[type]) {
+      if (Message* msg = messageAt(seq))
+        func(msg);
+    }
+  }
+
+  // Removes (and deletes) the messages of the given type that match
+  // the predicate.
+  template<typename Pred>
+  void eraseIf(MessageType type, Pred&& pred)
+  {
+    ASSERT(type < kFirstRegisteredMessage);
+    for (uint64_t seq : m_byType[type]) {
+      if (Message* msg = messageAt(seq)) {
+        if (pred(msg))
+          eraseAt(seq);
+      }
+    }
+  }
+
+  // Removes (and deletes) the messages that had the given widget as
+  // recipient when they were pushed and match the predicate.
+  template<typename Pred>
+  void eraseIfFor(Widget* widget, Pred&& pred)
+  {
+    auto it = m_byRecipient.find(widget);
+    if (it == m_byRecipient.end())
+      return;
+    for (uint64_t seq : it->second) {
+      if (Message* msg = messageAt(seq)) {
+        if (pred(msg))
+          eraseAt(seq);
+      }
+    }
+  }
+
+  // Removes the given widget as recipient of all its messages (the
+  // messages are kept in the queue) and forgets its index.
+  void removeRecipient(Widget* widget);
+
+private:
+  struct Entry {
+    Message* msg;      // nullptr if the message was erased
+    Widget* recipient; // Recipient when the message was pushed
+  };
+  using Seqs = std::vector<uint64_t>;
+
+  Message* messageAt(uint64_t seq) const
+  {
+    if (seq < m_firstSeq || seq - m_firstSeq >= m_entries.size())
+      return nullptr;
+    return m_entries[std::size_t(seq - m_firstSeq)].msg;
+  }
+  void eraseAt(uint64_t seq);
+  void unindex(const Entry& entry, uint64_t seq);
+  void clear();
+
+  // Entries in the same order they were pushed, the first one has
+  // the m_firstSeq sequence number. Indexes reference messages by
+  // sequence number, erased/popped messages are removed from indexes
+  // lazily.
+  std::deque<Entry> m_entries;
+  uint64_t m_firstSeq = 0;
+  std::size_t m_size = 0;
+  std::unordered_map<Widget*, Seqs> m_byRecipient;
+  std::deque<uint64_t> m_byType[kFirstRegisteredMessage];
+};
+
+// List of messages to be enqueued from other threads. push() is
+// lock-free (multiple producers can push messages at the same time)
+// and the UI thread takes all messages at once with popAll(), so
+// there is no ABA problem.
+class ConcurrentMessages {
+public:
+  ConcurrentMessages() = default;
+  ConcurrentMessages(const ConcurrentMessages&) = delete;
+  ConcurrentMessages& operator=(const ConcurrentMessages&) = delete;
+  ~ConcurrentMessages();
+
+  bool empty() const { return m_head.load(std::memory_order_relaxed) == nullptr; }
+
+  void push(Message* msg);
+
+  // Moves all messages to the given queue (in the same order they
+  // were pushed).
+  void popAll(MessageQueue& queue);
+
+private:
+  struct Node {
+    Message* msg;
+    Node* next;
+  };
+  std::atomic<Node*> m_head{ nullptr };
+};
+
+} // namespace ui
+
+#endif
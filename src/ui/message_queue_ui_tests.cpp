@@ -0,0 +1,165 @@
+// Aseprite UI Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#define TEST_GUI
+#include "tests/app_test.h"
+
+#include "ui/message_queue.h"
+
+#include <thread>
+#include <vector>
+
+using namespace ui;
+
+static Message* new_message(MessageType type, Widget* recipient)
+{
+  Message* msg = new Message(type);
+  if (recipient)
+    msg->setRecipient(recipient);
+  return msg;
+}
+
+TEST(MessageQueue, Order)
+{
+  Widget a, b;
+  MessageQueue queue;
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(nullptr, queue.pop());
+
+  Message* m1 = new_message(kPaintMessage, &a);
+  Message* m2 = new_message(kTimerMessage, &b);
+  Message* m3 = new_message(kPaintMessage, &b);
+  queue.push(m1);
+  queue.push(m2);
+  queue.push(m3);
+  EXPECT_EQ(3u, queue.size());
+
+  EXPECT_EQ(m1, queue.pop());
+  EXPECT_EQ(m2, queue.pop());
+  EXPECT_EQ(m3, queue.pop());
+  EXPECT_TRUE(queue.empty());
+  delete m1;
+  delete m2;
+  delete m3;
+}
+
+TEST(MessageQueue, Indexes)
+{
+  Widget a, b;
+  MessageQueue queue;
+  Message* m1 = new_message(kPaintMessage, &a);
+  Message* m2 = new_message(kTimerMessage, &b);
+  Message* m3 = new_message(kPaintMessage, &b);
+  Message* m4 = new_message(kMouseMoveMessage, &a);
+  queue.push(m1);
+  queue.push(m2);
+  queue.push(m3);
+  queue.push(m4);
+
+  std::vector<Message*> msgs;
+  queue.forEachFor(&b, [&msgs](Message* msg) { msgs.push_back(msg); });
+  EXPECT_EQ((std::vector<Message*>{ m2, m3 }), msgs);
+
+  msgs.clear();
+  queue.forEachOfType(kPaintMessage, [&msgs](Message* msg) { msgs.push_back(msg); });
+  EXPECT_EQ((std::vector<Message*>{ m1, m3 }), msgs);
+
+  // Erase a message in the middle of the queue
+  queue.eraseIf(kPaintMessage, [m3](Message* msg) { return msg == m3; });
+  EXPECT_EQ(3u, queue.size());
+
+  msgs.clear();
+  queue.forEachFor(&b, [&msgs](Message* msg) { msgs.push_back(msg); });
+  EXPECT_EQ((std::vector<Message*>{ m2 }), msgs);
+
+  queue.removeRecipient(&a);
+  EXPECT_EQ(nullptr, m1->recipient());
+  EXPECT_EQ(nullptr, m4->recipient());
+  EXPECT_EQ(&b, m2->recipient());
+
+  EXPECT_EQ(m1, queue.pop());
+  EXPECT_EQ(m2, queue.pop());
+  EXPECT_EQ(m4, queue.pop());
+  EXPECT_EQ(nullptr, queue.pop());
+  delete m1;
+  delete m2;
+  delete m4;
+}
+
+TEST(MessageQueue, ConcurrentMessages)
+{
+  ConcurrentMessages concurrent;
+  EXPECT_TRUE(concurrent.empty());
+
+  const int kThreads = 4;
+  const int kMessages = 100;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.emplace_back([&concurrent] {
+      for (int j = 0; j < kMessages; ++j)
+        concurrent.push(new Message(kCallbackMessage));
+    });
+  }
+  for (auto& thread : threads)
+    thread.join();
+
+  MessageQueue queue;
+  concurrent.popAll(queue);
+  EXPECT_TRUE(concurrent.empty());
+  EXPECT_EQ(std::size_t(kThreads * kMessages), queue.size());
+
+  while (Message* msg = queue.pop())
+    delete msg;
+}
+
+TEST(MessageQueue, BackAndEraseForWidget)
+{
+  Widget a, b;
+  MessageQueue queue;
+  EXPECT_EQ(nullptr, queue.back());
+
+  Message* m1 = new PaintMessage(0, gfx::Rect(0, 0, 4, 4));
+  Message* m2 = new PaintMessage(0, gfx::Rect(2, 2, 4, 4));
+  Message* m3 = new_message(kPaintMessage, &b);
+  m1->setRecipient(&a);
+  m2->setRecipient(&a);
+  queue.push(m1);
+  queue.push(m3);
+  queue.push(m2);
+  EXPECT_EQ(m2, queue.back());
+
+  gfx::Region region;
+  queue.eraseIfFor(&a, [&region](Message* msg) {
+    region |= gfx::Region(static_cast<PaintMessage*>(msg)->rect());
+    return true;
+  });
+  EXPECT_EQ(gfx::Rect(0, 0, 6, 6), region.bounds());
+  EXPECT_EQ(1u, queue.size());
+  EXPECT_EQ(m3, queue.back());
+
+  EXPECT_EQ(m3, queue.pop());
+  EXPECT_TRUE(queue.empty());
+  delete m3;
+}
+
+TEST(MessageQueue, CoalescedMouseMovement)
+{
+  MouseMessage msg(kMouseMoveMessage,
+                   PointerType::Mouse,
+                   kButtonLeft,
+                   kKeyNoneModifier,
+                   gfx::Point(1, 2));
+  EXPECT_TRUE(msg.history().empty());
+
+  msg._coalesceMovement(gfx::Point(3, 4), 0.5f);
+  msg._coalesceMovement(gfx::Point(5, 6), 1.0f);
+  EXPECT_EQ(gfx::Point(5, 6), msg.position());
+  EXPECT_EQ(1.0f, msg.pressure());
+  ASSERT_EQ(2u, msg.history().size());
+  EXPECT_EQ(gfx::Point(1, 2), msg.history()[0].position);
+  EXPECT_EQ(gfx::Point(3, 4), msg.history()[1].position);
+  EXPECT_EQ(0.5f, msg.history()[1].pressure);
+}
@@ -0,0 +1,136 @@
+// Aseprite UI Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "ui/text_blob_cache.h"
+
+#include "text/draw_text.h"
+#include "text/font.h"
+#include "text/text_blob.h"
+#include "ui/scale.h"
+
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace ui {
+
+namespace {
+
+// Maximum number of strings in the cache.
+constexpr std::size_t kMaxEntries = 4096;
+
+struct Key {
+  const text::Font* font;
+  int scale;
+  std::string str;
+
+  bool operator==(const Key& other) const
+  {
+    return font == other.font && scale == other.scale && str == other.str;
+  }
+};
+
+struct KeyHash {
+  std::size_t operator()(const Key& key) const
+  {
+    std::size_t h = std::hash<std::string>()(key.str);
+    h ^= std::hash<const void*>()(key.font) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    h ^= std::hash<int>()(key.scale) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    return h;
+  }
+};
+
+struct Entry {
+  Key key;
+  // Reference to the font so it's not deleted (and its address is
+  // not reused by other font) while it's used as a key.
+  text::FontRef font;
+  text::TextBlobRef blob;
+  bool hasSize = false;
+  gfx::Size size;
+};
+
+using Entries = std::list<Entry>; // Most recently used first
+
+class TextBlobCache {
+public:
+  // Returns the entry for the given font/string creating it if
+  // needed (the entry is moved to the front of the LRU list).
+  Entry& get(const text::FontMgrRef& fontMgr, const text::FontRef& font, const std::string& str)
+  {
+    Key key{ font.get(), guiscale(), str };
+    auto it = m_map.find(key);
+    if (it != m_map.end()) {
+      m_entries.splice(m_entries.begin(), m_entries, it->second);
+      return *it->second;
+    }
+
+    if (m_entries.size() >= kMaxEntries) {
+      m_map.erase(m_entries.back().key);
+      m_entries.pop_back();
+    }
+
+    Entry entry;
+    entry.key = key;
+    entry.font = font;
+    entry.blob = text::TextBlob::MakeWithShaper(fontMgr, font, str);
+    m_entries.push_front(std::move(entry));
+    m_map[std::move(key)] = m_entries.begin();
+    return m_entries.front();
+  }
+
+  void clear()
+  {
+    m_map.clear();
+    m_entries.clear();
+  }
+
+  std::mutex& mutex() { return m_mutex; }
+
+private:
+  std::mutex m_mutex;
+  Entries m_entries;
+  std::unordered_map<Key, Entries::iterator, KeyHash> m_map;
+};
+
+TextBlobCache g_cache;
+
+} // anonymous namespace
+
+text::TextBlobRef get_cached_text_blob(const text::FontMgrRef& fontMgr,
+                                       const text::FontRef& font,
+                                       const std::string& str)
+{
+  std::lock_guard lock(g_cache.mutex());
+  return g_cache.get(fontMgr, font, str).blob;
+}
+
+gfx::Size get_cached_text_size(const text::FontMgrRef& fontMgr,
+                               const text::FontRef& font,
+                               const std::string& str)
+{
+  std::lock_guard lock(g_cache.mutex());
+  Entry& entry = g_cache.get(fontMgr, font, str);
+  if (!entry.hasSize) {
+    entry.size =
+      text::draw_text(nullptr, fontMgr, font, str.c_str(), 0, 0, 0, 0, nullptr).size();
+    entry.hasSize = true;
+  }
+  return entry.size;
+}
+
+void clear_text_blob_cache()
+{
+  std::lock_guard lock(g_cache.mutex());
+  g_cache.clear();
+}
+
+} // namespace ui
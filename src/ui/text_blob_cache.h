@@ -0,0 +1,38 @@
+// Aseprite UI Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef UI_TEXT_BLOB_CACHE_H_INCLUDED
+#define UI_TEXT_BLOB_CACHE_H_INCLUDED
+#pragma once
+
+#include "gfx/size.h"
+#include "text/fwd.h"
+
+#include <string>
+
+namespace ui {
+
+// Returns the shaped text blob for the given string and font. The
+// blobs of the most recently used strings are kept in a global LRU
+// cache (keyed by string, font and UI scale), so we don't shape the
+// same text again on each paint.
+text::TextBlobRef get_cached_text_blob(const text::FontMgrRef& fontMgr,
+                                       const text::FontRef& font,
+                                       const std::string& str);
+
+// Returns the size of the given string as
+// text::draw_text(nullptr, fontMgr, font, str, ...).size() but using
+// the same cache as get_cached_text_blob().
+gfx::Size get_cached_text_size(const text::FontMgrRef& fontMgr,
+                               const text::FontRef& font,
+                               const std::string& str);
+
+// Removes all the cached text blobs (e.g. when the theme changes).
+void clear_text_blob_cache();
+
+} // namespace ui
+
+#endif
@@ -1,5 +1,5 @@
 // Aseprite UI Library
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -25,6 +25,7 @@
 #include "ui/size_hint_event.h"
 #include "ui/style.h"
 #include "ui/system.h"
+#include "ui/text_blob_cache.h"
 #include "ui/view.h"
 #include "ui/widget.h"
 #include "ui/window.h"
@@ -523,7 +524,7 @@ void Theme::paintLayer(Graphics* g,
         }
         else {
           if (!textBlob || style->font() != nullptr)
-            textBlob = text::TextBlob::MakeWithShaper(m_fontMgr, g->font(), text);
+            textBlob = get_cached_text_blob(m_fontMgr, g->font(), text);
 
           if (textBlob) {
             const gfx::RectF blobSize = textBlob->bounds();
@@ -833,6 +834,9 @@ void set_theme(Theme* theme, const int uiscale)
   current_ui_scale = uiscale;
   current_theme = theme;
 
+  // Fonts can change with the new theme
+  clear_text_blob_cache();
+
   if (theme)
     theme->regenerateTheme();
 
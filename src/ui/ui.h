@@ -1,5 +1,5 @@
 // Aseprite UI Library
-// Copyright (C) 2019-2025  Igara Studio S.A.
+// Copyright (C) 2019-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -72,6 +72,7 @@
 #include "ui/translation_delegate.h"
 #include "ui/view.h"
 #include "ui/viewport.h"
+#include "ui/virtual_listbox.h"
 #include "ui/widget.h"
 #include "ui/widget_type.h"
 #include "ui/widgets_list.h"
@@ -1,5 +1,5 @@
 // Aseprite UI Library
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2017  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -142,6 +142,10 @@ void View::setViewScroll(const Point& pt)
 // manually.
 void View::updateView(const bool restoreScrollPos)
 {
+  // The size of the viewed widget is generally different when the
+  // view is updated.
+  invalidateSizeHint();
+
   Widget* vw = UI_FIRST_WIDGET(m_viewport.children());
   Point scroll = viewScroll();
 
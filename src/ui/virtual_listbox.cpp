@@ -0,0 +1,317 @@
+// Aseprite UI Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include "ui/virtual_listbox.h"
+
+#include "os/window.h"
+#include "ui/display.h"
+#include "ui/listitem.h"
+#include "ui/message.h"
+#include "ui/resize_event.h"
+#include "ui/size_hint_event.h"
+#include "ui/theme.h"
+#include "ui/view.h"
+
+#include <algorithm>
+
+namespace ui {
+
+using namespace gfx;
+
+VirtualListBox::VirtualListBox(ListModel* model) : Widget(kListBoxWidget), m_model(model)
+{
+  setFocusStop(true);
+  initTheme();
+}
+
+void VirtualListBox::setModel(ListModel* model)
+{
+  m_model = model;
+  modelChanged();
+}
+
+void VirtualListBox::modelChanged()
+{
+  const int count = getItemsCount();
+  if (m_selected >= count)
+    m_selected = -1;
+
+  // Update all rows
+  for (Row& row : m_rows)
+    row.index = -1;
+
+  if (View* view = View::getView(this))
+    view->updateView();
+  updateRows();
+  invalidate();
+}
+
+int VirtualListBox::getItemsCount() const
+{
+  return (m_model ? m_model->size() : 0);
+}
+
+void VirtualListBox::selectIndex(int index)
+{
+  if (index < -1 || index >= getItemsCount())
+    return;
+
+  if (m_selected != index) {
+    const int old = m_selected;
+    m_selected = index;
+
+    if (Widget* widget = getItemWidget(old))
+      widget->setSelected(false);
+    if (Widget* widget = getItemWidget(index))
+      widget->setSelected(true);
+
+    onChange();
+  }
+
+  if (index >= 0)
+    makeIndexVisible(index);
+}
+
+void VirtualListBox::makeIndexVisible(int index)
+{
+  View* view = View::getView(this);
+  if (!view || index < 0)
+    return;
+
+  const int h = rowHeight();
+  const int y = border().top() + index * h;
+  const gfx::Rect vp = view->viewportBounds();
+  gfx::Point scroll = view->viewScroll();
+
+  if (y < scroll.y)
+    scroll.y = y;
+  else if (y + h > scroll.y + vp.h)
+    scroll.y = y + h - vp.h;
+
+  view->setViewScroll(scroll);
+}
+
+Widget* VirtualListBox::getItemWidget(int index) const
+{
+  if (index < 0)
+    return nullptr;
+  for (const Row& row : m_rows) {
+    if (row.index == index)
+      return row.widget;
+  }
+  return nullptr;
+}
+
+bool VirtualListBox::onProcessMessage(Message* msg)
+{
+  switch (msg->type()) {
+    case kOpenMessage: makeIndexVisible(m_selected); break;
+
+    case kMouseDownMessage: captureMouse(); [[fallthrough]];
+
+    case kMouseMoveMessage:
+      if (hasCapture()) {
+        const gfx::Point screenPos = msg->display()->nativeWindow()->pointToScreen(
+          static_cast<MouseMessage*>(msg)->position());
+        const gfx::Point mousePos = display()->nativeWindow()->pointFromScreen(screenPos);
+        const int index = indexFromPosition(mousePos);
+        if (index >= 0)
+          selectIndex(index);
+      }
+      return true;
+
+    case kMouseUpMessage:
+      if (hasCapture())
+        releaseMouse();
+      return true;
+
+    case kMouseWheelMessage: View::scrollByMessage(this, msg); break;
+
+    case kKeyDownMessage:
+      if (hasFocus() && getItemsCount() > 0) {
+        const int bottom = getItemsCount() - 1;
+        const int page = std::max(1, (View::getView(this) ?
+                                        View::getView(this)->viewportBounds().h / rowHeight() :
+                                        1));
+        int select = m_selected;
+
+        switch (static_cast<KeyMessage*>(msg)->scancode()) {
+          case kKeyUp:       select = (select > 0 ? select - 1 : bottom); break;
+          case kKeyDown:     select = (select < bottom ? select + 1 : 0); break;
+          case kKeyHome:     select = 0; break;
+          case kKeyEnd:      select = bottom; break;
+          case kKeyPageUp:   select -= page; break;
+          case kKeyPageDown: select += page; break;
+          default:           return Widget::onProcessMessage(msg);
+        }
+
+        selectIndex(std::clamp(select, 0, bottom));
+        return true;
+      }
+      break;
+
+    case kDoubleClickMessage: onDoubleClickItem(); return true;
+  }
+
+  return Widget::onProcessMessage(msg);
+}
+
+void VirtualListBox::onPaint(PaintEvent& ev)
+{
+  theme()->paintListBox(ev);
+}
+
+void VirtualListBox::onResize(ResizeEvent& ev)
+{
+  // This is called each time the view is scrolled too, so we can
+  // update the rows that are visible now.
+  setBoundsQuietly(ev.bounds());
+  updateRows();
+}
+
+void VirtualListBox::onSizeHint(SizeHintEvent& ev)
+{
+  // We cannot measure all items, so we use the width of the rows that
+  // are visible (the view will give us all its width anyway).
+  int w = 0;
+  for (const Row& row : m_rows) {
+    if (row.index >= 0)
+      w = std::max(w, row.widget->sizeHint().w);
+  }
+
+  ev.setSizeHint(
+    Size(w + border().width(), getItemsCount() * rowHeight() + border().height()));
+}
+
+void VirtualListBox::onInitTheme(InitThemeEvent& ev)
+{
+  Widget::onInitTheme(ev);
+  m_rowHeight = 0;
+}
+
+void VirtualListBox::onChange()
+{
+  Change();
+}
+
+void VirtualListBox::onDoubleClickItem()
+{
+  DoubleClickItem();
+}
+
+Widget* VirtualListBox::onCreateItemWidget()
+{
+  return new ListItem;
+}
+
+void VirtualListBox::onUpdateItemWidget(Widget* widget, int index)
+{
+  widget->setText(m_model->text(index));
+}
+
+int VirtualListBox::rowHeight()
+{
+  if (m_rowHeight <= 0) {
+    if (m_rows.empty()) {
+      Widget* widget = onCreateItemWidget();
+      widget->setVisible(false);
+      addChild(widget);
+      m_rows.push_back(Row{ widget, -1 });
+    }
+    // Rows can be empty (without text), so we use at least the
+    // height of one line of text
+    Widget* widget = m_rows.front().widget;
+    m_rowHeight = std::max({ 1,
+                             widget->sizeHint().h,
+                             widget->textHeight() + widget->border().height() });
+  }
+  return m_rowHeight;
+}
+
+int VirtualListBox::indexFromPosition(const gfx::Point& pos)
+{
+  const int count = getItemsCount();
+  if (count == 0)
+    return -1;
+
+  // Select the previous/next item when the mouse is outside the
+  // viewport (so the list is scrolled while the mouse is captured)
+  if (View* view = View::getView(this)) {
+    const gfx::Rect vp = view->viewportBounds();
+    if (m_selected >= 0 && pos.y < vp.y)
+      return std::max(0, m_selected - 1);
+    if (m_selected >= 0 && pos.y >= vp.y2())
+      return std::min(count - 1, m_selected + 1);
+  }
+
+  const int y = pos.y - childrenBounds().y;
+  return (y < 0 ? 0 : std::min(count - 1, y / rowHeight()));
+}
+
+void VirtualListBox::updateRows()
+{
+  const int count = getItemsCount();
+  const int h = rowHeight();
+  const gfx::Rect rc = childrenBounds();
+
+  // Range of visible items
+  gfx::Rect visible = rc;
+  if (View* view = View::getView(this))
+    visible &= view->viewportBounds();
+
+  int first = 0, last = -1;
+  if (!visible.isEmpty() && count > 0) {
+    first = std::clamp((visible.y - rc.y) / h, 0, count - 1);
+    last = std::clamp((visible.y2() - 1 - rc.y) / h, 0, count - 1);
+  }
+  const int needed = last - first + 1;
+
+  // Create the missing rows
+  while (int(m_rows.size()) < needed) {
+    Widget* widget = onCreateItemWidget();
+    addChild(widget);
+    m_rows.push_back(Row{ widget, -1 });
+  }
+
+  // Release rows that show items outside the visible range
+  for (Row& row : m_rows) {
+    if (row.index < first || row.index > last)
+      row.index = -1;
+  }
+
+  // Assign free rows to the visible items that don't have a row yet
+  auto freeRow = m_rows.begin();
+  for (int i = first; i <= last; ++i) {
+    if (getItemWidget(i))
+      continue;
+
+    while (freeRow != m_rows.end() && freeRow->index >= 0)
+      ++freeRow;
+    ASSERT(freeRow != m_rows.end());
+    if (freeRow == m_rows.end())
+      break;
+
+    freeRow->index = i;
+    onUpdateItemWidget(freeRow->widget, i);
+    freeRow->widget->setSelected(i == m_selected);
+  }
+
+  // Hide unused rows and place the others
+  for (Row& row : m_rows) {
+    if (row.index < 0) {
+      row.widget->setVisible(false);
+      continue;
+    }
+    row.widget->setVisible(true);
+    row.widget->setBounds(gfx::Rect(rc.x, rc.y + row.index * h, rc.w, h));
+  }
+}
+
+} // namespace ui
@@ -0,0 +1,86 @@
+// Aseprite UI Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#ifndef UI_VIRTUAL_LISTBOX_H_INCLUDED
+#define UI_VIRTUAL_LISTBOX_H_INCLUDED
+#pragma once
+
+#include "obs/signal.h"
+#include "ui/widget.h"
+
+#include <string>
+#include <vector>
+
+namespace ui {
+
+// Items to be shown in a VirtualListBox.
+class ListModel {
+public:
+  virtual ~ListModel() {}
+  virtual int size() const = 0;
+  virtual std::string text(int index) const = 0;
+};
+
+// A list box for a big number of items where only the visible rows
+// are created as widgets (ListItem by default). These widgets are
+// reused for other items when the list is scrolled. All rows have
+// the same height, and the list must be inside a View.
+class VirtualListBox : public Widget {
+public:
+  VirtualListBox(ListModel* model = nullptr);
+
+  ListModel* model() const { return m_model; }
+  void setModel(ListModel* model);
+
+  // Must be called when items of the model are added, removed, or
+  // modified.
+  void modelChanged();
+
+  int getItemsCount() const;
+  int getSelectedIndex() const { return m_selected; }
+  void selectIndex(int index);
+  void makeIndexVisible(int index);
+
+  // Returns the widget that is showing the given item (or nullptr if
+  // the item is not visible).
+  Widget* getItemWidget(int index) const;
+
+  obs::signal<void()> Change;
+  obs::signal<void()> DoubleClickItem;
+
+protected:
+  bool onProcessMessage(Message* msg) override;
+  void onPaint(PaintEvent& ev) override;
+  void onResize(ResizeEvent& ev) override;
+  void onSizeHint(SizeHintEvent& ev) override;
+  void onInitTheme(InitThemeEvent& ev) override;
+  virtual void onChange();
+  virtual void onDoubleClickItem();
+
+  // Creates a new widget to show rows, and updates a row widget to
+  // show the given item index.
+  virtual Widget* onCreateItemWidget();
+  virtual void onUpdateItemWidget(Widget* widget, int index);
+
+private:
+  struct Row {
+    Widget* widget;
+    int index; // Item shown in this row (-1 if it's not used)
+  };
+
+  int rowHeight();
+  int indexFromPosition(const gfx::Point& pos);
+  void updateRows();
+
+  ListModel* m_model;
+  int m_selected = -1;
+  int m_rowHeight = 0;
+  std::vector<Row> m_rows;
+};
+
+} // namespace ui
+
+#endif
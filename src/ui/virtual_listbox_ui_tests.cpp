@@ -0,0 +1,77 @@
+// Aseprite UI Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This file is released under the terms of the MIT license.
+// Read LICENSE.txt for more information.
+
+#define TEST_GUI
+#include "tests/app_test.h"
+
+#include "ui/virtual_listbox.h"
+
+#include <string>
+
+using namespace ui;
+
+namespace {
+
+class NumbersModel : public ListModel {
+public:
+  NumbersModel(int size) : m_size(size) {}
+  int size() const override { return m_size; }
+  std::string text(int index) const override { return std::to_string(index); }
+  void setSize(int size) { m_size = size; }
+
+private:
+  int m_size;
+};
+
+} // anonymous namespace
+
+TEST(VirtualListBox, OnlyVisibleRowsAreWidgets)
+{
+  NumbersModel model(100000);
+  View view;
+  VirtualListBox list(&model);
+  view.attachToView(&list);
+  view.setBounds(gfx::Rect(0, 0, 100, 100));
+
+  EXPECT_EQ(100000, list.getItemsCount());
+  EXPECT_LT(list.children().size(), 100u);
+
+  Widget* first = list.getItemWidget(0);
+  ASSERT_NE(nullptr, first);
+  EXPECT_EQ("0", first->text());
+  EXPECT_EQ(nullptr, list.getItemWidget(50000));
+
+  // Select an item far away, the rows are reused to show it
+  const std::size_t nrows = list.children().size();
+  list.selectIndex(50000);
+  EXPECT_EQ(50000, list.getSelectedIndex());
+  Widget* item = list.getItemWidget(50000);
+  ASSERT_NE(nullptr, item);
+  EXPECT_EQ("50000", item->text());
+  EXPECT_TRUE(item->isSelected());
+  EXPECT_EQ(nullptr, list.getItemWidget(0));
+  EXPECT_EQ(nrows, list.children().size());
+}
+
+TEST(VirtualListBox, ModelChanged)
+{
+  NumbersModel model(10);
+  View view;
+  VirtualListBox list(&model);
+  view.attachToView(&list);
+  view.setBounds(gfx::Rect(0, 0, 100, 1000));
+
+  list.selectIndex(9);
+  ASSERT_NE(nullptr, list.getItemWidget(9));
+
+  model.setSize(5);
+  list.modelChanged();
+  EXPECT_EQ(5, list.getItemsCount());
+  EXPECT_EQ(-1, list.getSelectedIndex());
+  EXPECT_EQ(nullptr, list.getItemWidget(9));
+  ASSERT_NE(nullptr, list.getItemWidget(4));
+  EXPECT_EQ("4", list.getItemWidget(4)->text());
+}
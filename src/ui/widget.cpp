@@ -1,5 +1,5 @@
 // Aseprite UI Library
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -16,6 +16,7 @@
 
 #include "base/log.h"
 #include "base/memory.h"
+#include "base/scoped_value.h"
 #include "base/string.h"
 #include "base/utf8_decode.h"
 #include "os/surface.h"
@@ -60,6 +61,22 @@ namespace ui {
 
 using namespace gfx;
 
+namespace {
+
+// Number of nested Widget::setBounds() calls. Size hints are cached
+// only while a layout is being done (layout depth > 0), as parents
+// ask for the size hint of the same children several times (e.g.
+// Box asks for it in its onSizeHint() and again in its onResize(),
+// and then each child does the same with its own children).
+int g_layoutDepth = 0;
+
+// Cached size hints are valid only if they were calculated in the
+// current generation. This is incremented when a new layout starts
+// and when something that can modify a size hint is changed.
+uint32_t g_sizeHintGeneration = 1;
+
+} // anonymous namespace
+
 WidgetType register_widget_type()
 {
   static int type = (int)kFirstUserWidget;
@@ -113,6 +130,10 @@ Widget::~Widget()
   // Delete fixed size hint if it isn't nullptr
   delete m_sizeHint;
 
+  // The widget could be destroyed outside the manager hierarchy with
+  // a pending deferLayout()
+  Manager::cancelDeferredLayout(this);
+
   // Low level free
   details::removeWidget(this);
 }
@@ -134,6 +155,7 @@ void Widget::initTheme()
 
   InitThemeEvent ev(this, m_theme);
   onInitTheme(ev);
+  invalidateSizeHint();
 }
 
 int Widget::textInt() const
@@ -180,6 +202,7 @@ void Widget::setTextQuiet(const std::string& text)
 
   m_text = text;
   enableFlags(HAS_TEXT);
+  invalidateSizeHint();
 }
 
 const text::FontRef& Widget::font() const
@@ -194,6 +217,7 @@ void Widget::setFont(const text::FontRef& font)
   if (m_font != font) {
     m_font = font;
     m_blob.reset();
+    invalidateSizeHint();
     onSetFont();
   }
 }
@@ -221,6 +245,7 @@ void Widget::setTheme(Theme* theme)
 
   m_theme = theme;
   m_font = nullptr;
+  invalidateSizeHint();
 
   for (auto child : children())
     child->setTheme(theme);
@@ -239,6 +264,7 @@ void Widget::setStyle(Style* style)
   m_maxSize = m_theme->calcMaxSize(this, style);
   if (style->font())
     m_font = style->font();
+  invalidateSizeHint();
 }
 
 // ===============================================================
@@ -253,6 +279,7 @@ void Widget::setVisible(bool state)
     if (hasFlags(HIDDEN)) {
       disableFlags(HIDDEN);
       invalidate();
+      invalidateSizeHint();
 
       onVisible(true);
     }
@@ -262,6 +289,7 @@ void Widget::setVisible(bool state)
       if (auto man = manager())
         man->freeWidget(this); // Free from manager
       enableFlags(HIDDEN);
+      invalidateSizeHint();
 
       // As this widget was hidden we need to invalidate the area it was
       // occupying
@@ -306,6 +334,7 @@ void Widget::setSelected(bool state)
     if (!hasFlags(SELECTED)) {
       enableFlags(SELECTED);
       invalidate();
+      invalidateSizeHint();
 
       onSelect(true);
     }
@@ -314,6 +343,7 @@ void Widget::setSelected(bool state)
     if (hasFlags(SELECTED)) {
       disableFlags(SELECTED);
       invalidate();
+      invalidateSizeHint();
 
       onSelect(false);
     }
@@ -596,6 +626,7 @@ void Widget::addChild(Widget* child)
   m_children.push_back(child);
   child->m_parent = this;
   child->m_parentIndex = i;
+  invalidateSizeHint();
 }
 
 void Widget::removeChild(const WidgetsList::iterator& it)
@@ -627,6 +658,7 @@ void Widget::removeChild(const WidgetsList::iterator& it)
 
   child->m_parent = nullptr;
   child->m_parentIndex = -1;
+  invalidateSizeHint();
 }
 
 void Widget::removeChild(Widget* child)
@@ -672,6 +704,7 @@ void Widget::replaceChild(Widget* oldChild, Widget* newChild)
 
   newChild->m_parent = this;
   newChild->m_parentIndex = index;
+  invalidateSizeHint();
 }
 
 void Widget::insertChild(int index, Widget* child)
@@ -689,6 +722,7 @@ void Widget::insertChild(int index, Widget* child)
 
   child->m_parent = this;
   child->m_parentIndex = index;
+  invalidateSizeHint();
 }
 
 void Widget::moveChildTo(Widget* thisChild, Widget* toThisPosition)
@@ -710,6 +744,8 @@ void Widget::moveChildTo(Widget* thisChild, Widget* toThisPosition)
   thisChild->m_parentIndex = to;
   for (++it, end = m_children.end(); it != end; ++it)
     ++(*it)->m_parentIndex;
+
+  invalidateSizeHint();
 }
 
 // ===============================================================
@@ -722,6 +758,14 @@ void Widget::layout()
   invalidate();
 }
 
+void Widget::deferLayout()
+{
+  if (Manager* man = manager(); man && man != this)
+    man->deferLayout(this);
+  else
+    layout();
+}
+
 void Widget::loadLayout()
 {
   if (!m_id.empty()) {
@@ -803,6 +847,11 @@ void Widget::setBounds(const Rect& rc)
   if (is_app_state_closing())
     return;
 
+  // Start a new generation of cached size hints for this layout
+  if (g_layoutDepth == 0)
+    invalidateSizeHint();
+
+  base::ScopedValue layoutDepth(g_layoutDepth, g_layoutDepth + 1);
   ResizeEvent ev(this, rc);
   onResize(ev);
 }
@@ -826,6 +875,7 @@ void Widget::setBoundsQuietly(const gfx::Rect& rc)
 void Widget::setBorder(const Border& br)
 {
   m_border = br;
+  invalidateSizeHint();
 
 #ifdef _DEBUG
   if (m_style) {
@@ -840,6 +890,7 @@ void Widget::setBorder(const Border& br)
 void Widget::setChildSpacing(int childSpacing)
 {
   m_childSpacing = childSpacing;
+  invalidateSizeHint();
 
 #ifdef _DEBUG
   if (m_style) {
@@ -855,6 +906,7 @@ void Widget::noBorderNoChildSpacing()
 {
   m_border = gfx::Border(0, 0, 0, 0);
   m_childSpacing = 0;
+  invalidateSizeHint();
 
 #ifdef _DEBUG
   if (m_style) {
@@ -1094,6 +1146,7 @@ void Widget::setMinSize(const gfx::Size& sz)
   ASSERT(sz.w <= m_maxSize.w);
   ASSERT(sz.h <= m_maxSize.h);
   m_minSize = sz;
+  invalidateSizeHint();
 }
 
 void Widget::setMaxSize(const gfx::Size& sz)
@@ -1101,6 +1154,7 @@ void Widget::setMaxSize(const gfx::Size& sz)
   ASSERT(sz.w >= m_minSize.w);
   ASSERT(sz.h >= m_minSize.h);
   m_maxSize = sz;
+  invalidateSizeHint();
 }
 
 void Widget::setMinMaxSize(const gfx::Size& minSz, const gfx::Size& maxSz)
@@ -1109,16 +1163,19 @@ void Widget::setMinMaxSize(const gfx::Size& minSz, const gfx::Size& maxSz)
   ASSERT(minSz.h <= maxSz.h);
   m_minSize = minSz;
   m_maxSize = maxSz;
+  invalidateSizeHint();
 }
 
 void Widget::resetMinSize()
 {
   m_minSize = gfx::Size(0, 0);
+  invalidateSizeHint();
 }
 
 void Widget::resetMaxSize()
 {
   m_maxSize = gfx::Size(std::numeric_limits<int>::max(), std::numeric_limits<int>::max());
+  invalidateSizeHint();
 }
 
 void Widget::flushRedraw()
@@ -1161,11 +1218,15 @@ void Widget::flushRedraw()
         widget->m_updateRegion &= drawable;
       }
 
+      // Join the areas of the paint messages of this widget that
+      // weren't dispatched yet, so we paint them just one time.
+      Display* display = widget->display();
+      manager->takePaintMessagesFor(widget, display, widget->m_updateRegion);
+
       std::size_t c, nrects = widget->m_updateRegion.size();
       Region::const_iterator it = widget->m_updateRegion.begin();
 
       // Draw the widget
-      Display* display = widget->display();
       int count = nrects - 1;
       for (c = 0; c < nrects; ++c, ++it, --count) {
         // Create the draw message
@@ -1446,22 +1507,7 @@ void Widget::broadcastMouseMessage(const gfx::Point& screenPos, WidgetsList& tar
 */
 Size Widget::sizeHint()
 {
-  if (m_sizeHint)
-    return *m_sizeHint;
-
-  SizeHintEvent ev(this, Size(0, 0));
-
-  // Call onSizeHint() only when the theme is set, as generally
-  // onSizeHint() will require some theme/font information to
-  // calculate the best size. The theme can be nullptr only in extreme
-  // cases, i.e. when we're closing a unit test.
-  if (m_theme)
-    onSizeHint(ev);
-
-  Size sz(ev.sizeHint());
-  sz.w = std::clamp(sz.w, m_minSize.w, m_maxSize.w);
-  sz.h = std::clamp(sz.h, m_minSize.h, m_maxSize.h);
-  return sz;
+  return sizeHint(Size(0, 0));
 }
 
 /**
@@ -1483,13 +1529,32 @@ Size Widget::sizeHint(const Size& fitIn)
   if (m_sizeHint)
     return *m_sizeHint;
 
+  // Use the size hint calculated before in this same layout
+  CachedSizeHint& cached = m_cachedSizeHint[fitIn.w == 0 && fitIn.h == 0 ? 0 : 1];
+  const uint32_t generation = g_sizeHintGeneration;
+  if (g_layoutDepth > 0 && cached.generation == generation && cached.fitIn == fitIn)
+    return cached.size;
+
   SizeHintEvent ev(this, fitIn);
+
+  // Call onSizeHint() only when the theme is set, as generally
+  // onSizeHint() will require some theme/font information to
+  // calculate the best size. The theme can be nullptr only in extreme
+  // cases, i.e. when we're closing a unit test.
   if (m_theme)
     onSizeHint(ev);
 
   Size sz(ev.sizeHint());
   sz.w = std::clamp(sz.w, m_minSize.w, m_maxSize.w);
   sz.h = std::clamp(sz.h, m_minSize.h, m_maxSize.h);
+
+  // Don't cache the size if something was modified while we were
+  // calculating it.
+  if (g_layoutDepth > 0 && generation == g_sizeHintGeneration) {
+    cached.generation = generation;
+    cached.fitIn = fitIn;
+    cached.size = sz;
+  }
   return sz;
 }
 
@@ -1501,6 +1566,7 @@ void Widget::setSizeHint(const Size& fixedSize)
 {
   delete m_sizeHint;
   m_sizeHint = new Size(fixedSize);
+  invalidateSizeHint();
 }
 
 void Widget::setSizeHint(int fixedWidth, int fixedHeight)
@@ -1513,9 +1579,17 @@ void Widget::resetSizeHint()
   if (m_sizeHint) {
     delete m_sizeHint;
     m_sizeHint = nullptr;
+    invalidateSizeHint();
   }
 }
 
+void Widget::invalidateSizeHint()
+{
+  // We don't know which ancestors depend on this size hint, so we
+  // discard all cached size hints.
+  ++g_sizeHintGeneration;
+}
+
 // ===============================================================
 // FOCUS & MOUSE
 // ===============================================================
@@ -1,5 +1,5 @@
 // Aseprite UI Library
-// Copyright (C) 2018-2025  Igara Studio S.A.
+// Copyright (C) 2018-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This file is released under the terms of the MIT license.
@@ -24,6 +24,7 @@
 #include "ui/widget_type.h"
 #include "ui/widgets_list.h"
 
+#include <cstdint>
 #include <string>
 
 #define ASSERT_VALID_WIDGET(widget) ASSERT((widget) != nullptr)
@@ -73,7 +74,11 @@ public:
   void disableFlags(int flags) { m_flags &= ~flags; }
 
   int align() const { return (m_flags & ALIGN_MASK); }
-  void setAlign(int align) { m_flags = ((m_flags & PROPERTIES_MASK) | (align & ALIGN_MASK)); }
+  void setAlign(int align)
+  {
+    m_flags = ((m_flags & PROPERTIES_MASK) | (align & ALIGN_MASK));
+    invalidateSizeHint();
+  }
 
   // Text property.
 
@@ -218,6 +223,11 @@ public:
   // ===============================================================
 
   void layout();
+
+  // Lays out the widget before the next paint. Several calls in the
+  // same iteration of the event loop generate just one layout.
+  void deferLayout();
+
   void loadLayout();
   void saveLayout();
 
@@ -338,6 +348,13 @@ public:
   void setSizeHint(int fixedWidth, int fixedHeight);
   void resetSizeHint();
 
+  // Size hints are cached while a layout is done (i.e. inside the
+  // outermost setBounds() call). Common changes (text, visibility,
+  // children, style, etc.) discard the cache automatically, but if
+  // an onSizeHint() implementation depends on some other state that
+  // can change in the middle of a layout, this must be called.
+  void invalidateSizeHint();
+
   // ===============================================================
   // MOUSE, FOCUS & KEYBOARD
   // ===============================================================
@@ -472,6 +489,15 @@ private:
   int m_parentIndex; // Location/index of this widget in the parent's Widget::m_children vector
   gfx::Size* m_sizeHint;
 
+  // Size hints calculated in the current layout, [0] for an empty
+  // fitIn size, and [1] for the last non-empty fitIn size.
+  struct CachedSizeHint {
+    uint32_t generation = 0;
+    gfx::Size fitIn;
+    gfx::Size size;
+  };
+  CachedSizeHint m_cachedSizeHint[2];
+
   // Keyboard shortcut to access this widget like Alt+mnemonic.  If
   // kMnemonicModifiersMask bit is zero, it means that the mnemonic
   // can be used without Alt or Command key modifiers (useful for
@@ -1,5 +1,5 @@
 // Aseprite UI Library
-// Copyright (C) 2022  Igara Studio S.A.
+// Copyright (C) 2022-2026  Igara Studio S.A.
 //
 // This file is released under the terms of the MIT license.
 // Read LICENSE.txt for more information.
@@ -7,8 +7,46 @@
 #define TEST_GUI
 #include "tests/app_test.h"
 
+#include <vector>
+
 using namespace ui;
 
+namespace {
+
+class SizeHintCounter : public Widget {
+public:
+  int calls = 0;
+  gfx::Size size = gfx::Size(10, 10);
+
+protected:
+  void onSizeHint(SizeHintEvent& ev) override
+  {
+    ++calls;
+    ev.setSizeHint(size);
+  }
+};
+
+// Asks the size hint of its children several times in each layout
+// (as Box, Grid, etc. do).
+class SizeHintAsker : public Widget {
+public:
+  std::vector<gfx::Size> sizes;
+
+protected:
+  void onResize(ResizeEvent& ev) override
+  {
+    Widget::onResize(ev);
+    for (auto child : children()) {
+      sizes.push_back(child->sizeHint());
+      sizes.push_back(child->sizeHint());
+      sizes.push_back(child->sizeHint(gfx::Size(5, 0)));
+      sizes.push_back(child->sizeHint(gfx::Size(5, 0)));
+    }
+  }
+};
+
+} // anonymous namespace
+
 TEST(Widget, ParentIndex)
 {
   Widget a, b, c, d, e;
@@ -55,3 +93,49 @@ TEST(Widget, ParentIndex)
   EXPECT_EQ(2, d.parentIndex());
   EXPECT_EQ(3, c.parentIndex());
 }
+
+TEST(Widget, SizeHintCachedInLayout)
+{
+  SizeHintAsker parent;
+  SizeHintCounter child;
+  parent.addChild(&child);
+
+  // Outside a layout the size hint is calculated each time
+  child.sizeHint();
+  child.sizeHint();
+  EXPECT_EQ(2, child.calls);
+
+  // In a layout it's calculated once for each fitIn size
+  child.calls = 0;
+  parent.setBounds(gfx::Rect(0, 0, 32, 32));
+  EXPECT_EQ(2, child.calls);
+  ASSERT_EQ(4u, parent.sizes.size());
+  EXPECT_EQ(gfx::Size(10, 10), parent.sizes[3]);
+
+  // Each new layout calculates the size hint again
+  child.calls = 0;
+  child.size = gfx::Size(20, 20);
+  parent.sizes.clear();
+  parent.setBounds(gfx::Rect(0, 0, 32, 32));
+  EXPECT_EQ(2, child.calls);
+  EXPECT_EQ(gfx::Size(20, 20), parent.sizes[0]);
+}
+
+TEST(Widget, DeferLayout)
+{
+  SizeHintAsker parent;
+  SizeHintCounter child;
+  parent.addChild(&child);
+  parent.deferLayout();
+  parent.deferLayout();
+
+  // Without manager the layout is done immediately in each call
+  if (Manager* manager = parent.manager()) {
+    EXPECT_TRUE(parent.sizes.empty());
+    manager->layoutDeferredWidgets();
+    EXPECT_EQ(4u, parent.sizes.size());
+  }
+  else {
+    EXPECT_EQ(8u, parent.sizes.size());
+  }
+}
@@ -1,5 +1,5 @@
 // Aseprite View Library
-// Copyright (C) 2020-2023  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -219,6 +219,101 @@ bool Range::read(std::istream& is)
   return is.good();
 }
 
+void Range::save(RangeSnapshot& snapshot) const
+{
+  snapshot.clear();
+  snapshot.m_saved = true;
+  snapshot.m_type = m_type;
+  snapshot.m_flags = m_flags;
+  snapshot.m_selectingFromLayer = (m_selectingFromLayer ? m_selectingFromLayer->id() : NullId);
+  snapshot.m_selectingFromFrame = m_selectingFromFrame;
+
+  for (const Layer* layer : m_selectedLayers)
+    snapshot.addLayer(layer->id());
+
+  // Join consecutive frames in ranges
+  frame_t fromFrame = -1, toFrame = -1;
+  for (const frame_t frame : m_selectedFrames) {
+    if (fromFrame >= 0 && frame == toFrame + 1) {
+      toFrame = frame;
+      continue;
+    }
+    if (fromFrame >= 0)
+      snapshot.addFrames(fromFrame, toFrame);
+    fromFrame = toFrame = frame;
+  }
+  if (fromFrame >= 0)
+    snapshot.addFrames(fromFrame, toFrame);
+}
+
+bool Range::restore(const RangeSnapshot& snapshot)
+{
+  clearRange();
+  if (!snapshot.m_saved)
+    return false;
+
+  m_type = snapshot.m_type;
+  m_flags = snapshot.m_flags;
+
+  // Like in SelectedLayers::read(), layers that don't exist are
+  // ignored.
+  auto it = snapshot.m_extra.begin();
+  for (int i = 0; i < snapshot.m_nlayers; ++i) {
+    const ObjectId id = (i == 0 ? snapshot.m_layer : *(it++));
+    if (Layer* layer = doc::get<Layer>(id))
+      m_selectedLayers.insert(layer);
+  }
+
+  for (int i = 0; i < snapshot.m_nframeRanges; ++i) {
+    if (i == 0)
+      m_selectedFrames.insert(snapshot.m_fromFrame, snapshot.m_toFrame);
+    else {
+      const frame_t fromFrame = frame_t(*(it++));
+      const frame_t toFrame = frame_t(*(it++));
+      m_selectedFrames.insert(fromFrame, toFrame);
+    }
+  }
+
+  m_selectingFromLayer = doc::get<Layer>(snapshot.m_selectingFromLayer);
+  m_selectingFromFrame = snapshot.m_selectingFromFrame;
+  return true;
+}
+
+void RangeSnapshot::clear()
+{
+  m_saved = false;
+  m_type = Range::kNone;
+  m_flags = 0;
+  m_selectingFromLayer = NullId;
+  m_selectingFromFrame = -1;
+  m_nlayers = 0;
+  m_nframeRanges = 0;
+  m_extra.clear();
+}
+
+void RangeSnapshot::addLayer(const ObjectId id)
+{
+  // Layers must be added before frames
+  ASSERT(m_nframeRanges == 0);
+
+  if (m_nlayers++ == 0)
+    m_layer = id;
+  else
+    m_extra.push_back(id);
+}
+
+void RangeSnapshot::addFrames(const frame_t fromFrame, const frame_t toFrame)
+{
+  if (m_nframeRanges++ == 0) {
+    m_fromFrame = fromFrame;
+    m_toFrame = toFrame;
+  }
+  else {
+    m_extra.push_back(uint32_t(fromFrame));
+    m_extra.push_back(uint32_t(toFrame));
+  }
+}
+
 void Range::selectLayerRange(Layer* fromLayer, Layer* toLayer)
 {
   ASSERT(fromLayer);
@@ -1,5 +1,5 @@
 // Aseprite View Library
-// Copyright (C) 2020-2023  Igara Studio S.A.
+// Copyright (C) 2020-2026  Igara Studio S.A.
 // Copyright (C) 2001-2018  David Capello
 //
 // This program is distributed under the terms of
@@ -11,10 +11,13 @@
 
 #include "doc/cel_list.h"
 #include "doc/frame.h"
+#include "doc/object_id.h"
 #include "doc/selected_frames.h"
 #include "doc/selected_layers.h"
 
+#include <cstdint>
 #include <iosfwd>
+#include <vector>
 
 namespace doc {
 class Cel;
@@ -23,6 +26,8 @@ class Sprite;
 
 namespace view {
 
+class RangeSnapshot;
+
 class Range {
 public:
   enum Type { kNone = 0, kCels = 1, kFrames = 2, kLayers = 4 };
@@ -76,6 +81,11 @@ public:
   bool write(std::ostream& os) const;
   bool read(std::istream& is);
 
+  // Same as write()/read() but using a compact snapshot in memory
+  // (used to restore the range after undo/redo).
+  void save(RangeSnapshot& snapshot) const;
+  bool restore(const RangeSnapshot& snapshot);
+
 private:
   void selectLayerRange(doc::Layer* fromLayer, doc::Layer* toLayer);
   void selectFrameRange(doc::frame_t fromFrame, doc::frame_t toFrame);
@@ -88,6 +98,42 @@ private:
   doc::frame_t m_selectingFromFrame;
 };
 
+// Copy of a Range that can be restored later, even when the selected
+// layers were deleted and re-created (layers are saved by ID). A
+// range of one layer and one range of frames (the most common case)
+// doesn't allocate memory.
+class RangeSnapshot {
+public:
+  // Returns true if a range was saved in this snapshot.
+  bool saved() const { return m_saved; }
+
+  // Bytes allocated by this snapshot (without the snapshot itself).
+  std::size_t memSize() const { return m_extra.capacity() * sizeof(uint32_t); }
+
+private:
+  void clear();
+  void addLayer(doc::ObjectId id);
+  void addFrames(doc::frame_t fromFrame, doc::frame_t toFrame);
+
+  bool m_saved = false;
+  Range::Type m_type = Range::kNone;
+  int m_flags = 0;
+  doc::ObjectId m_selectingFromLayer = doc::NullId;
+  doc::frame_t m_selectingFromFrame = -1;
+
+  // First layer and first range of frames are stored here, the rest
+  // of the layer IDs and pairs of frames go to m_extra (layers
+  // first).
+  int m_nlayers = 0;
+  int m_nframeRanges = 0;
+  doc::ObjectId m_layer = doc::NullId;
+  doc::frame_t m_fromFrame = 0;
+  doc::frame_t m_toFrame = 0;
+  std::vector<uint32_t> m_extra;
+
+  friend class Range;
+};
+
 // TODO We should make these types strongly-typed and not just aliases.
 // E.g.
 //   using VirtualRange = RangeT<col_t>;
@@ -0,0 +1,97 @@
+// Aseprite View Library
+// Copyright (C) 2026  Igara Studio S.A.
+//
+// This program is distributed under the terms of
+// the End-User License Agreement for Aseprite.
+
+#ifdef HAVE_CONFIG_H
+  #include "config.h"
+#endif
+
+#include <gtest/gtest.h>
+
+#include "doc/layer.h"
+#include "doc/sprite.h"
+#include "view/range.h"
+
+#include <memory>
+
+using namespace doc;
+using namespace view;
+
+TEST(Range, SnapshotOneLayer)
+{
+  std::unique_ptr<Sprite> spr(new Sprite(ImageSpec(ColorMode::RGB, 32, 32), 256));
+  spr->setTotalFrames(10);
+  Layer* layer = new LayerImage(spr.get());
+  spr->root()->addLayer(layer);
+
+  Range range;
+  range.startRange(layer, 2, Range::kCels);
+  range.endRange(layer, 5);
+
+  RangeSnapshot snapshot;
+  EXPECT_FALSE(snapshot.saved());
+  range.save(snapshot);
+  EXPECT_TRUE(snapshot.saved());
+  EXPECT_EQ(0u, snapshot.memSize());
+
+  Range restored;
+  EXPECT_TRUE(restored.restore(snapshot));
+  EXPECT_EQ(range, restored);
+}
+
+TEST(Range, SnapshotSeveralLayersAndFrames)
+{
+  std::unique_ptr<Sprite> spr(new Sprite(ImageSpec(ColorMode::RGB, 32, 32), 256));
+  spr->setTotalFrames(20);
+  Layer* layer1 = new LayerImage(spr.get());
+  Layer* layer2 = new LayerImage(spr.get());
+  Layer* layer3 = new LayerImage(spr.get());
+  spr->root()->addLayer(layer1);
+  spr->root()->addLayer(layer2);
+  spr->root()->addLayer(layer3);
+
+  SelectedLayers layers;
+  layers.insert(layer1);
+  layers.insert(layer3);
+  SelectedFrames frames;
+  frames.insert(1, 3);
+  frames.insert(7);
+  frames.insert(10, 15);
+
+  Range range;
+  range.setType(Range::kCels);
+  range.setSelectedLayers(layers);
+  range.setSelectedFrames(frames);
+
+  RangeSnapshot snapshot;
+  range.save(snapshot);
+
+  Range restored;
+  EXPECT_TRUE(restored.restore(snapshot));
+  EXPECT_EQ(range, restored);
+  EXPECT_EQ(2, restored.layers());
+  EXPECT_EQ(10, restored.frames());
+
+  // Deleted layers are ignored
+  spr->root()->removeLayer(layer3);
+  delete layer3;
+  EXPECT_TRUE(restored.restore(snapshot));
+  EXPECT_EQ(1, restored.layers());
+  EXPECT_TRUE(restored.contains(layer1));
+}
+
+TEST(Range, EmptySnapshot)
+{
+  RangeSnapshot snapshot;
+  Range range;
+  EXPECT_FALSE(range.restore(snapshot));
+  EXPECT_FALSE(range.enabled());
+}
+
+int main(int argc, char** argv)
+{
+  ::testing::InitGoogleTest(&argc, argv);
+  return RUN_ALL_TESTS();
+}
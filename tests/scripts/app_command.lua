@@ -1,4 +1,4 @@
--- Copyright (C) 2019-2025  Igara Studio S.A.
+-- Copyright (C) 2019-2026  Igara Studio S.A.
 -- Copyright (C) 2018  David Capello
 --
 -- This file is released under the terms of the MIT license.
@@ -416,6 +416,36 @@ do -- Outline
                b, r, r, b,
                b, b, b, b })
 
+  -- Test "thickness" param
+
+  s = Sprite(5, 5)
+  cel = app.activeCel
+  app.useTool{ brush=Brush(1), color=red, points={Point(2,2)} }
+  expect_eq(cel.bounds, Rectangle(2, 2, 1, 1))
+
+  app.command.Outline{ color=blue, matrix='circle', thickness=2 }
+  expect_eq(cel.bounds, Rectangle(0, 0, 5, 5))
+  expect_img(cel.image,
+             { 0, 0, b, 0, 0,
+               0, b, b, b, 0,
+               b, b, r, b, b,
+               0, b, b, b, 0,
+               0, 0, b, 0, 0 })
+  app.undo()
+
+  app.command.Outline{ color=blue, matrix='square', thickness=2 }
+  expect_eq(cel.bounds, Rectangle(0, 0, 5, 5))
+  expect_img(cel.image,
+             { b, b, b, b, b,
+               b, b, b, b, b,
+               b, b, r, b, b,
+               b, b, b, b, b,
+               b, b, b, b, b })
+  app.undo()
+
+  app.command.Outline{ color=blue, matrix='horizontal', thickness=2 }
+  expect_eq(cel.bounds, Rectangle(0, 2, 5, 1))
+  expect_img(cel.image, { b, b, r, b, b })
 end
 
 do -- BrightnessContrast
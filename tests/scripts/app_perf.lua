@@ -0,0 +1,19 @@
+-- Copyright (C) 2026  Igara Studio S.A.
+--
+-- This file is released under the terms of the MIT license.
+-- Read LICENSE.txt for more information.
+
+local perf = app.perf
+assert(type(perf) == "table")
+
+local saves = 0
+if perf["file.save_us"] then saves = perf["file.save_us"].count end
+local savedBytes = perf["file.saved_bytes"] or 0
+
+local spr = Sprite(32, 32)
+spr:saveAs("_test_perf.png")
+
+perf = app.perf
+assert(perf["file.save_us"].count == saves + 1)
+assert(perf["file.save_us"].max >= perf["file.save_us"].p50)
+assert(perf["file.saved_bytes"] > savedBytes)
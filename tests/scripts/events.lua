@@ -240,6 +240,44 @@ do
   expect_eq(2, eventCount)
 end
 
+-- Notifications are collapsed inside app.batch()
+do
+  local sprite = Sprite(32, 32)
+  local layer = sprite.layers[1]
+  local nameCount = 0
+  local opacityCount = 0
+  local changeCount = 0
+  function onLayerName() nameCount = nameCount + 1 end
+  function onLayerOpacity() opacityCount = opacityCount + 1 end
+  function onChange() changeCount = changeCount + 1 end
+
+  sprite.events:on('layername', onLayerName)
+  sprite.events:on('layeropacity', onLayerOpacity)
+  sprite.events:on('change', onChange)
+  app.batch(function()
+    for i=1,100 do
+      layer.name = "Name " .. i
+      layer.opacity = i
+      expect_eq(0, nameCount)
+      expect_eq(0, opacityCount)
+    end
+  end)
+  expect_eq(1, nameCount)
+  expect_eq(1, opacityCount)
+  expect_eq(1, changeCount)
+  expect_eq("Name 100", layer.name)
+  expect_eq(100, layer.opacity)
+
+  -- One undo step for the whole batch
+  app.undo()
+  expect_eq("Layer 1", layer.name)
+  expect_eq(255, layer.opacity)
+
+  sprite.events:off(onLayerName)
+  sprite.events:off(onLayerOpacity)
+  sprite.events:off(onChange)
+end
+
 -- Visibility
 do
   local sprite = Sprite(32, 32)
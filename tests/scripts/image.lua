@@ -751,3 +751,128 @@ do
     end
   end
 end
+
+----------------------------------------------------------------------
+-- Tests for bulk pixel operations (mapColors, applyLut, fill,
+-- histogram, countColor)
+
+function test_image_bulk_ops(img)
+  local r = Color(255, 0, 0).rgbaPixel
+  local g = Color(0, 255, 0).rgbaPixel
+  local b = Color(0, 0, 255).rgbaPixel
+  img:clear(0)
+  img:drawPixel(0, 0, r)
+  img:drawPixel(1, 1, r)
+  img:drawPixel(2, 2, g)
+
+  expect_eq(2, img:mapColors({ [r]=b }))
+  expect_img(img, { b, 0, 0,
+                    0, b, 0,
+                    0, 0, g })
+  expect_eq(1, img:mapColors({ [b]=Color(0, 255, 0) }, Rectangle(0, 0, 1, 1)))
+  expect_img(img, { g, 0, 0,
+                    0, b, 0,
+                    0, 0, g })
+
+  local h = img:histogram()
+  expect_eq(2, h[g])
+  expect_eq(1, h[b])
+  expect_eq(6, h[0])
+  expect_eq(2, img:countColor(g))
+  expect_eq(1, img:countColor(g, Rectangle(0, 0, 2, 2)))
+
+  img:applyLut{ red=function(v) return 255-v end,
+                blue={} }
+  local c = rgba(255, 255, 0, 255)
+  local d = rgba(255, 0, 255, 255)
+  local e = rgba(255, 0, 0, 0)
+  expect_img(img, { c, e, e,
+                    e, d, e,
+                    e, e, c })
+
+  local mask = Image(2, 2, ColorMode.GRAY)
+  mask:drawPixel(1, 0, Color{ gray=255 })
+  expect_eq(1, img:fill(b, mask, Point(1, 0)))
+  expect_img(img, { c, e, b,
+                    e, d, e,
+                    e, e, c })
+
+  -- Without sprite, don't test undo
+  if not app.sprite then return end
+
+  app.undo()
+  expect_img(img, { c, e, e,
+                    e, d, e,
+                    e, e, c })
+
+  app.sprite.selection:select(Rectangle(0, 1, 3, 1))
+  expect_eq(3, img:fill(0, app.sprite.selection))
+  expect_img(img, { c, e, e,
+                    0, 0, 0,
+                    e, e, c })
+end
+
+local spr = Sprite(3, 3)   -- Test with sprite (with transactions & undo/redo)
+test_image_bulk_ops(app.image)
+app.sprite = nil           -- Test without sprite (without transactions)
+test_image_bulk_ops(Image(3, 3))
+
+-- Draw a region of the source image with Image:drawImage()
+do
+  local r = Color(255, 0, 0).rgbaPixel
+  local src = Image(3, 3)
+  src:clear(0)
+  src:drawPixel(1, 1, r)
+  src:drawPixel(2, 1, r)
+
+  local dst = Image(3, 3)
+  dst:clear(0)
+  dst:drawImage(src, Point(0, 2), 255, BlendMode.NORMAL, Rectangle(1, 1, 2, 1))
+  expect_img(dst, { 0, 0, 0,
+                    0, 0, 0,
+                    r, r, 0 })
+end
+
+-- Image views
+do
+  local r = Color(255, 0, 0).rgbaPixel
+  local g = Color(0, 255, 0).rgbaPixel
+  local img = Image(3, 2)
+  img:clear(0)
+
+  local v = img:view()
+  assert(v.width == 3)
+  assert(v.height == 2)
+  assert(#v == 6)
+  assert(v.rowStride == img.rowStride)
+  assert(v.bytesPerPixel == 4)
+  assert(v.image == img)
+
+  v[1] = r
+  v[6] = g
+  expect_img(img, { r, 0, 0,
+                    0, 0, g })
+  assert(v[1] == r)
+  assert(v:get(2, 1) == g)
+
+  -- View of a region
+  local w = img:view(Rectangle(1, 1, 2, 1))
+  assert(#w == 2)
+  assert(w.bounds == Rectangle(1, 1, 2, 1))
+  w[1] = r
+  w:set(1, 0, r)
+  expect_img(img, { r, 0, 0,
+                    0, r, r })
+  assert(not pcall(function() return w[3] end))
+  assert(not pcall(function() w:set(2, 0, r) end))
+
+  -- Draw a view
+  local dst = Image(2, 1)
+  dst:clear(0)
+  dst:drawImage(w, Point(0, 0))
+  expect_img(dst, { r, r })
+
+  -- Views are invalidated when the image is resized
+  img:resize(4, 4)
+  assert(not pcall(function() return v[1] end))
+end
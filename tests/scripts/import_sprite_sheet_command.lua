@@ -1,4 +1,4 @@
--- Copyright (C) 2021  Igara Studio S.A.
+-- Copyright (C) 2021-2026  Igara Studio S.A.
 --
 -- This file is released under the terms of the MIT license.
 -- Read LICENSE.txt for more information.
@@ -73,3 +73,26 @@ do
                3, 2 })
 
 end
+
+-- Tiles with the same pixels are imported as linked cels
+do
+  local s = Sprite(6, 2, ColorMode.INDEXED)
+  local i = s.cels[1].image
+  array_to_pixels({ 1, 2, 3, 4, 1, 2,
+                    3, 4, 1, 2, 3, 4 }, i)
+
+  app.command.ImportSpriteSheet{
+    ui=false,
+    type=SpriteSheetType.ROWS,
+    frameBounds=Rectangle(0, 0, 2, 2)
+  }
+  assert(#s.cels == 3)
+  expect_img(s.cels[1].image, { 1, 2,
+                                3, 4 })
+  expect_img(s.cels[2].image, { 3, 4,
+                                1, 2 })
+  expect_img(s.cels[3].image, { 1, 2,
+                                3, 4 })
+  assert(s.cels[1].image.id ~= s.cels[2].image.id)
+  assert(s.cels[1].image.id == s.cels[3].image.id)
+end
@@ -119,3 +119,38 @@ do
   assert(b.bounds == Rectangle(2, 4, 4, 4))
   assert(b.bounds == Rectangle(2, 4, 4, 4))
 end
+
+-- Geometry queries
+do
+  local a = Selection()
+  assert(a.pixelCount == 0)
+  assert(#a:spans() == 0)
+  assert(#a:components() == 0)
+  assert(#a:polygons() == 0)
+
+  a:select(0, 0, 4, 2)
+  a:add(Rectangle(6, 0, 1, 1))
+  a:subtract(Rectangle(1, 1, 2, 1))
+  assert(a.pixelCount == 4*2 - 2 + 1)
+
+  local spans = a:spans()
+  assert(#spans == 4)
+  assert(spans[1] == Rectangle(0, 0, 4, 1))
+  assert(spans[2] == Rectangle(6, 0, 1, 1))
+  assert(spans[3] == Rectangle(0, 1, 1, 1))
+  assert(spans[4] == Rectangle(3, 1, 1, 1))
+
+  local components = a:components()
+  assert(#components == 2)
+  assert(components[1].bounds == Rectangle(0, 0, 4, 2))
+  assert(components[1].pixelCount == 6)
+  assert(components[2].bounds == Rectangle(6, 0, 1, 1))
+
+  local polygons = a:polygons()
+  assert(#polygons == 2)
+  local corners = 0
+  for _,polygon in ipairs(polygons) do
+    corners = corners + #polygon
+  end
+  assert(corners == 8 + 4)
+end
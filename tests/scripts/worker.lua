@@ -0,0 +1,111 @@
+-- Copyright (C) 2026  Igara Studio S.A.
+--
+-- This file is released under the terms of the MIT license.
+-- Read LICENSE.txt for more information.
+
+dofile('./test_utils.lua')
+
+local rgba = app.pixelColor.rgba
+
+-- Basic values
+do
+  local w = Worker{
+    run=function(a, b, t)
+      return a + b, t.name .. "!", { x=t.list[2] }
+    end,
+    args={ 1, 2, { name="hi", list={ 10, 20 } } }
+  }
+  assert(not w.isRunning)
+  w:start()
+  local sum, str, tbl = w:wait()
+  expect_eq(3, sum)
+  expect_eq("hi!", str)
+  expect_eq(20, tbl.x)
+  assert(not w.isRunning)
+end
+
+-- Code as a string
+do
+  local w = Worker{ run="local a = ... ; return a * 2", args={ 21 } }
+  w:start()
+  expect_eq(42, w:wait())
+end
+
+-- Images are copied to/from the worker
+do
+  local img = Image(2, 2)
+  img:clear(rgba(255, 0, 0))
+
+  local w = Worker{
+    run=function(img)
+      img:drawPixel(0, 0, app.pixelColor.rgba(0, 255, 0))
+      return img, Image(3, 4, ColorMode.INDEXED)
+    end,
+    args={ img }
+  }
+  w:start()
+  local result, other = w:wait()
+
+  -- Original image wasn't modified
+  expect_eq(rgba(255, 0, 0), img:getPixel(0, 0))
+  expect_eq(rgba(0, 255, 0), result:getPixel(0, 0))
+  expect_eq(rgba(255, 0, 0), result:getPixel(1, 1))
+  expect_eq(3, other.width)
+  expect_eq(4, other.height)
+  expect_eq(ColorMode.INDEXED, other.colorMode)
+end
+
+-- Several workers in parallel
+do
+  local workers = {}
+  for i=1,8 do
+    local w = Worker{
+      run=function(n)
+        local s = 0
+        for j=1,n do s = s + j end
+        return s
+      end,
+      args={ 1000 * i }
+    }
+    w:start()
+    workers[i] = w
+  end
+  for i,w in ipairs(workers) do
+    local n = 1000 * i
+    expect_eq(n*(n+1)//2, w:wait())
+  end
+end
+
+-- Errors
+do
+  local w = Worker{ run=function() error("worker error") end }
+  w:start()
+  local ok, msg = pcall(function() return w:wait() end)
+  assert(not ok)
+  assert(msg:find("worker error"))
+
+  -- Local variables of the script cannot be used from the worker
+  local a = 1
+  ok = pcall(function() Worker{ run=function() return a end } end)
+  assert(not ok)
+
+  -- Files cannot be accessed from workers
+  w = Worker{ run=function() return io end }
+  w:start()
+  expect_eq(nil, w:wait())
+
+  w = Worker{ run=function() return Image{ fromFile="sprite.png" } end }
+  w:start()
+  ok = pcall(function() return w:wait() end)
+  assert(not ok)
+end
+
+-- Cancel a worker
+do
+  local w = Worker{ run=function() while true do end end }
+  w:start()
+  w:cancel()
+  local ok, msg = pcall(function() return w:wait() end)
+  assert(not ok)
+  assert(msg:find("canceled"))
+end